@@ -22,6 +22,12 @@
 #define NMD_SCRIPT_DIR_PRE_UP   NMD_SCRIPT_DIR_DEFAULT "/pre-up.d"
 #define NMD_SCRIPT_DIR_PRE_DOWN NMD_SCRIPT_DIR_DEFAULT "/pre-down.d"
 #define NMD_SCRIPT_DIR_NO_WAIT  NMD_SCRIPT_DIR_DEFAULT "/no-wait.d"
+#define NMD_SCRIPT_DIR_NO_SUPERSEDE NMD_SCRIPT_DIR_DEFAULT "/no-supersede.d"
+
+/* in-process hooks, see nm-dispatcher-plugin.h. Their results are
+ * reported with the name NMD_PLUGIN_RESULT_PREFIX + plugin name. */
+#define NMD_PLUGIN_DIR              NMPLUGINDIR "/dispatcher"
+#define NMD_PLUGIN_RESULT_PREFIX    "plugin:"
 
 #define NM_DISPATCHER_DBUS_SERVICE   "org.freedesktop.nm_dispatcher"
 #define NM_DISPATCHER_DBUS_INTERFACE "org.freedesktop.nm_dispatcher"
@@ -56,5 +62,6 @@ typedef enum {
 	DISPATCH_RESULT_EXEC_FAILED = 2,
 	DISPATCH_RESULT_FAILED = 3,
 	DISPATCH_RESULT_TIMEOUT = 4,
+	DISPATCH_RESULT_SUPERSEDED = 5,
 } DispatchResult;
 
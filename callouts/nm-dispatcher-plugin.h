@@ -0,0 +1,91 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_DISPATCHER_PLUGIN_H__
+#define __NM_DISPATCHER_PLUGIN_H__
+
+/* In-process dispatcher hooks.
+ *
+ * nm-dispatcher loads every shared object in NMD_PLUGIN_DIR at startup and
+ * looks up the symbol nm_dispatcher_plugin_get(), which returns the
+ * description of the plugin. For each event whose action the plugin is
+ * interested in, the dispatcher calls its dispatch() function from the main
+ * loop, before running the scripts of the event. No environment is built and
+ * no process is spawned; the plugin gets the variants as they were received
+ * over D-Bus.
+ *
+ * dispatch() must not block. It reports the result by calling @done exactly
+ * once, either from within dispatch() or later from the main loop. If that
+ * doesn't happen within the timeout of the plugin, the event continues
+ * without it and the late @done call is ignored.
+ */
+
+#include <gio/gio.h>
+
+#define NM_DISPATCHER_PLUGIN_API_VERSION 1
+
+/* default of NMDispatcherPlugin.timeout_ms */
+#define NM_DISPATCHER_PLUGIN_TIMEOUT_MS  5000
+
+typedef struct {
+	const char *action;
+	/* the interface of the event, or %NULL */
+	const char *iface;
+
+	/* the arguments of the org.freedesktop.nm_dispatcher.Action call */
+	GVariant *connection_dict;
+	GVariant *connection_props;
+	GVariant *device_props;
+	GVariant *device_ip4_props;
+	GVariant *device_ip6_props;
+	GVariant *device_dhcp4_props;
+	GVariant *device_dhcp6_props;
+	const char *vpn_ip_iface;
+	GVariant *vpn_ip4_props;
+	GVariant *vpn_ip6_props;
+} NMDispatcherPluginEvent;
+
+typedef void (*NMDispatcherPluginDoneFunc) (gpointer done_data, GError *error);
+
+typedef struct {
+	/* NM_DISPATCHER_PLUGIN_API_VERSION */
+	guint api_version;
+	const char *name;
+
+	/* %NULL-terminated list of the actions to be called for, or %NULL
+	 * for all actions */
+	const char *const *actions;
+
+	/* 0 for NM_DISPATCHER_PLUGIN_TIMEOUT_MS */
+	guint timeout_ms;
+
+	/* optional; called once after loading. A plugin that fails is not used. */
+	gboolean (*init) (GError **error);
+
+	void (*dispatch) (const NMDispatcherPluginEvent *event,
+	                  NMDispatcherPluginDoneFunc done,
+	                  gpointer done_data);
+} NMDispatcherPlugin;
+
+typedef const NMDispatcherPlugin *(*NMDispatcherPluginGetFunc) (void);
+
+const NMDispatcherPlugin *nm_dispatcher_plugin_get (void);
+
+#endif /* __NM_DISPATCHER_PLUGIN_H__ */
@@ -318,6 +318,93 @@ construct_device_dhcp6_items (GSList *items, GVariant *dhcp6_config)
 	return items;
 }
 
+/*****************************************************************************/
+
+/* The dispatcher sees the same IP configs and DHCP options again and
+ * again, e.g. for "up", "dhcp4-change" and "connectivity-change" of a
+ * device. The environment items built from them are cached, keyed by the
+ * serialized variant. The caches only grow to ENVP_FRAGMENT_CACHE_MAX
+ * entries and are dropped when full. */
+
+typedef enum {
+	ENVP_FRAGMENT_IP4,
+	ENVP_FRAGMENT_IP6,
+	ENVP_FRAGMENT_VPN_IP4,
+	ENVP_FRAGMENT_VPN_IP6,
+	ENVP_FRAGMENT_DHCP4,
+	ENVP_FRAGMENT_DHCP6,
+	_ENVP_FRAGMENT_NUM,
+} EnvpFragmentType;
+
+#define ENVP_FRAGMENT_CACHE_MAX 64
+
+static GHashTable *envp_fragment_cache[_ENVP_FRAGMENT_NUM];
+
+static GSList *
+construct_fragment (EnvpFragmentType type, GVariant *props)
+{
+	switch (type) {
+	case ENVP_FRAGMENT_IP4:
+		return construct_ip4_items (NULL, props, NULL);
+	case ENVP_FRAGMENT_IP6:
+		return construct_ip6_items (NULL, props, NULL);
+	case ENVP_FRAGMENT_VPN_IP4:
+		return construct_ip4_items (NULL, props, "VPN_");
+	case ENVP_FRAGMENT_VPN_IP6:
+		return construct_ip6_items (NULL, props, "VPN_");
+	case ENVP_FRAGMENT_DHCP4:
+		return construct_device_dhcp4_items (NULL, props);
+	case ENVP_FRAGMENT_DHCP6:
+		return construct_device_dhcp6_items (NULL, props);
+	default:
+		g_return_val_if_reached (NULL);
+	}
+}
+
+static GSList *
+add_fragment_items (GSList *items, EnvpFragmentType type, GVariant *props)
+{
+	GHashTable *cache;
+	gs_unref_bytes GBytes *key = NULL;
+	char **fragment;
+	guint i;
+
+	if (!props)
+		return items;
+
+	cache = envp_fragment_cache[type];
+	if (!cache) {
+		cache = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+		                               (GDestroyNotify) g_bytes_unref,
+		                               (GDestroyNotify) g_strfreev);
+		envp_fragment_cache[type] = cache;
+	}
+
+	key = g_bytes_new (g_variant_get_data (props), g_variant_get_size (props));
+	fragment = g_hash_table_lookup (cache, key);
+	if (!fragment) {
+		GSList *list, *iter;
+
+		list = construct_fragment (type, props);
+		fragment = g_new (char *, g_slist_length (list) + 1);
+		for (iter = list, i = 0; iter; iter = g_slist_next (iter), i++)
+			fragment[i] = iter->data;
+		fragment[i] = NULL;
+		g_slist_free (list);
+
+		if (g_hash_table_size (cache) >= ENVP_FRAGMENT_CACHE_MAX)
+			g_hash_table_remove_all (cache);
+		g_hash_table_insert (cache, g_bytes_ref (key), fragment);
+	}
+
+	/* the fragment is in list order, prepend from its tail. */
+	for (i = g_strv_length (fragment); i > 0; i--)
+		items = g_slist_prepend (items, g_strdup (fragment[i - 1]));
+	return items;
+}
+
+/*****************************************************************************/
+
 char **
 nm_dispatcher_utils_construct_envp (const char *action,
                                     GVariant *connection_dict,
@@ -440,16 +527,16 @@ nm_dispatcher_utils_construct_envp (const char *action,
 
 	/* Device it's aren't valid if the device isn't activated */
 	if (iface && (dev_state == NM_DEVICE_STATE_ACTIVATED)) {
-		items = construct_ip4_items (items, device_ip4_props, NULL);
-		items = construct_ip6_items (items, device_ip6_props, NULL);
-		items = construct_device_dhcp4_items (items, device_dhcp4_props);
-		items = construct_device_dhcp6_items (items, device_dhcp6_props);
+		items = add_fragment_items (items, ENVP_FRAGMENT_IP4, device_ip4_props);
+		items = add_fragment_items (items, ENVP_FRAGMENT_IP6, device_ip6_props);
+		items = add_fragment_items (items, ENVP_FRAGMENT_DHCP4, device_dhcp4_props);
+		items = add_fragment_items (items, ENVP_FRAGMENT_DHCP6, device_dhcp6_props);
 	}
 
 	if (vpn_ip_iface) {
 		items = g_slist_prepend (items, g_strdup_printf ("VPN_IP_IFACE=%s", vpn_ip_iface));
-		items = construct_ip4_items (items, vpn_ip4_props, "VPN_");
-		items = construct_ip6_items (items, vpn_ip6_props, "VPN_");
+		items = add_fragment_items (items, ENVP_FRAGMENT_VPN_IP4, vpn_ip4_props);
+		items = add_fragment_items (items, ENVP_FRAGMENT_VPN_IP6, vpn_ip6_props);
 	}
 
 	/* Backwards compat: 'iface' is set in this order:
@@ -32,8 +32,10 @@
 #include <errno.h>
 #include <arpa/inet.h>
 #include <glib-unix.h>
+#include <gmodule.h>
 
 #include "nm-dispatcher-api.h"
+#include "nm-dispatcher-plugin.h"
 #include "nm-dispatcher-utils.h"
 
 #include "nmdbus-dispatcher.h"
@@ -43,17 +45,45 @@ static gboolean debug = FALSE;
 static gboolean persist = FALSE;
 static guint quit_id;
 static guint request_id_counter = 0;
+static gint max_parallel = 4;
+static guint num_requests_superseded = 0;
+
+/* Sends the D-Bus reply of a request. The unit tests have no bus and
+ * collect the results instead. */
+static void (*return_value_func) (GDBusMethodInvocation *context, GVariant *parameters) = g_dbus_method_invocation_return_value;
+
+typedef struct {
+	char *path;
+	char *result_name;
+	const NMDispatcherPlugin *info;
+} Plugin;
+
+/* list of Plugin, in the order of their file names */
+static GPtrArray *plugins = NULL;
 
 typedef struct Request Request;
 
+/* Requests with "wait" scripts are run in order per interface. Each
+ * interface (hostname requests use the empty interface name) has a
+ * lane with the request currently running and the ones waiting behind
+ * it. At most @max_parallel lanes run at the same time; lanes waiting
+ * for a free slot are queued in @lanes_pending, in order. */
+typedef struct {
+	char *iface;
+	Request *current_request;
+	GQueue *requests_waiting;
+	gboolean pending;
+} Lane;
+
 typedef struct {
 	GObject parent;
 
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
-	GQueue *requests_waiting;
+	GHashTable *lanes;
+	GQueue *lanes_pending;
+	guint num_lanes_running;
 	gint num_requests_pending;
 } Handler;
 
@@ -89,7 +119,8 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 static void
 handler_init (Handler *h)
 {
-	h->requests_waiting = g_queue_new ();
+	h->lanes = g_hash_table_new (g_str_hash, g_str_equal);
+	h->lanes_pending = g_queue_new ();
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -102,10 +133,15 @@ handler_class_init (HandlerClass *h_class)
 
 static gboolean dispatch_one_script (Request *request);
 
+typedef struct _PluginCall PluginCall;
+
 typedef struct {
 	Request *request;
 
+	/* for a plugin, NMD_PLUGIN_RESULT_PREFIX and its name */
 	char *script;
+	const Plugin *plugin;
+	PluginCall *call;
 	GPid pid;
 	DispatchResult result;
 	char *error;
@@ -113,10 +149,20 @@ typedef struct {
 	gboolean dispatched;
 	guint watch_id;
 	guint timeout_id;
+	gint64 start_time;
 } ScriptInfo;
 
+/* The done_data of a plugin's dispatch() call. It outlives the ScriptInfo
+ * when the plugin times out and only reports the result later. */
+struct _PluginCall {
+	ScriptInfo *script;
+	gboolean in_dispatch;
+	gboolean done;
+};
+
 struct Request {
 	Handler *handler;
+	Lane *lane;
 
 	guint request_id;
 
@@ -126,7 +172,12 @@ struct Request {
 	char **envp;
 	gboolean debug;
 
+	/* passed to the plugins; only set if there are any for the action */
+	NMDispatcherPluginEvent event;
+	char *vpn_ip_iface;
+
 	GPtrArray *scripts;  /* list of ScriptInfo */
+	gboolean no_supersede;
 	guint idx;
 	gint num_scripts_done;
 	gint num_scripts_nowait;
@@ -204,6 +255,17 @@ request_free (Request *request)
 	g_strfreev (request->envp);
 	g_ptr_array_free (request->scripts, TRUE);
 
+	g_clear_pointer (&request->event.connection_dict, g_variant_unref);
+	g_clear_pointer (&request->event.connection_props, g_variant_unref);
+	g_clear_pointer (&request->event.device_props, g_variant_unref);
+	g_clear_pointer (&request->event.device_ip4_props, g_variant_unref);
+	g_clear_pointer (&request->event.device_ip6_props, g_variant_unref);
+	g_clear_pointer (&request->event.device_dhcp4_props, g_variant_unref);
+	g_clear_pointer (&request->event.device_dhcp6_props, g_variant_unref);
+	g_clear_pointer (&request->event.vpn_ip4_props, g_variant_unref);
+	g_clear_pointer (&request->event.vpn_ip6_props, g_variant_unref);
+	g_free (request->vpn_ip_iface);
+
 	g_slice_free (Request, request);
 }
 
@@ -223,45 +285,181 @@ quit_timeout_reschedule (void)
 	}
 }
 
+static void
+lane_free (Lane *lane)
+{
+	nm_assert (!lane->current_request && g_queue_is_empty (lane->requests_waiting));
+
+	g_queue_free (lane->requests_waiting);
+	g_free (lane->iface);
+	g_slice_free (Lane, lane);
+}
+
+static void complete_request (Request *request);
+
+static gboolean
+request_supersedes (Request *request, Request *old)
+{
+	/* an "up" is obsolete once the interface went down again */
+	if (   !strcmp (request->action, NMD_ACTION_DOWN)
+	    && !strcmp (old->action, NMD_ACTION_UP))
+		return TRUE;
+
+	/* only the latest DHCP lease matters */
+	if (   (   !strcmp (request->action, NMD_ACTION_DHCP4_CHANGE)
+	        || !strcmp (request->action, NMD_ACTION_DHCP6_CHANGE))
+	    && !strcmp (request->action, old->action))
+		return TRUE;
+
+	return FALSE;
+}
+
 /**
- * next_request:
+ * supersede_requests:
+ * @lane: the lane @request is going to be added to
+ * @request: the new request
  *
+ * Drops the requests waiting in @lane that are made obsolete by @request,
+ * unless they have a script in the no-supersede.d directory. Their "wait"
+ * scripts are reported as %DISPATCH_RESULT_SUPERSEDED; "no-wait" scripts
+ * have been started already and are waited for as usual.
+ */
+static void
+supersede_requests (Lane *lane, Request *request)
+{
+	GList *iter, *next;
+	guint i;
+
+	for (iter = lane->requests_waiting->head; iter; iter = next) {
+		Request *old = iter->data;
+
+		next = iter->next;
+		if (old->no_supersede || !request_supersedes (request, old))
+			continue;
+
+		g_queue_delete_link (lane->requests_waiting, iter);
+		old->lane = NULL;
+
+		for (i = 0; i < old->scripts->len; i++) {
+			ScriptInfo *script = g_ptr_array_index (old->scripts, i);
+
+			if (script->dispatched)
+				continue;
+			script->dispatched = TRUE;
+			script->result = DISPATCH_RESULT_SUPERSEDED;
+			script->error = g_strdup_printf ("Script '%s' skipped, superseded by request %u.",
+			                                 script->script, request->request_id);
+			old->num_scripts_done++;
+		}
+		old->idx = old->scripts->len;
+
+		num_requests_superseded++;
+		_LOG_R_I (old, "dropped: superseded by req:%u '%s' (%u requests dropped so far)",
+		          request->request_id, request->action, num_requests_superseded);
+
+		complete_request (old);
+	}
+}
+
+/**
+ * enqueue_request:
  * @h: the handler
- * @request: (allow-none): the request to set as next. If %NULL, dequeue the next
- * waiting request. Otherwise, try to set the given request.
+ * @request: a request with at least one "wait" script
  *
- * Sets the currently active request (@current_request). The current request
- * is a request that has at least on "wait" script, because requests that only
- * consist of "no-wait" scripts are handled right away and not enqueued to
- * @requests_waiting nor set as @current_request.
+ * Adds @request to the lane of its interface. Requests that only consist
+ * of "no-wait" scripts are handled right away and never enqueued. The
+ * request is started by schedule_requests().
+ */
+static void
+enqueue_request (Handler *h, Request *request)
+{
+	const char *key = request->iface ? request->iface : "";
+	Lane *lane;
+	guint depth;
+
+	lane = g_hash_table_lookup (h->lanes, key);
+	if (!lane) {
+		lane = g_slice_new0 (Lane);
+		lane->iface = g_strdup (key);
+		lane->requests_waiting = g_queue_new ();
+		g_hash_table_insert (h->lanes, lane->iface, lane);
+	}
+
+	supersede_requests (lane, request);
+
+	request->lane = lane;
+	g_queue_push_tail (lane->requests_waiting, request);
+	if (!lane->current_request && !lane->pending) {
+		g_queue_push_tail (h->lanes_pending, lane);
+		lane->pending = TRUE;
+	}
+
+	depth = g_queue_get_length (lane->requests_waiting) - 1 + (lane->current_request ? 1 : 0);
+	if (depth > 0)
+		_LOG_R_I (request, "queued behind %u requests for the same interface", depth);
+	else if (lane->pending && h->num_lanes_running >= (guint) max_parallel)
+		_LOG_R_I (request, "queued, all %u workers are busy", h->num_lanes_running);
+}
+
+/**
+ * release_lane:
+ * @h: the handler
+ * @request: the current request of its lane, just completed
  *
- * Returns: %TRUE, if there was currently not request in process and it set
- * a new request as current.
+ * Frees the worker slot of the lane. If more requests are waiting for the
+ * same interface, the lane is queued again behind the other pending lanes.
  */
-static gboolean
-next_request (Handler *h, Request *request)
+static void
+release_lane (Handler *h, Request *request)
 {
-	if (request) {
-		if (h->current_request) {
-			g_queue_push_tail (h->requests_waiting, request);
-			return FALSE;
-		}
-	} else {
-		/* when calling next_request() without explicit @request, we always
-		 * forcefully clear @current_request. That one is certainly
-		 * handled already. */
-		h->current_request = NULL;
+	Lane *lane = request->lane;
 
-		request = g_queue_pop_head (h->requests_waiting);
-		if (!request)
-			return FALSE;
+	nm_assert (lane && lane->current_request == request);
+
+	lane->current_request = NULL;
+	g_assert_cmpuint (h->num_lanes_running, >, 0);
+	h->num_lanes_running--;
+
+	if (!g_queue_is_empty (lane->requests_waiting)) {
+		g_queue_push_tail (h->lanes_pending, lane);
+		lane->pending = TRUE;
+	} else {
+		g_hash_table_remove (h->lanes, lane->iface);
+		lane_free (lane);
 	}
+}
 
-	_LOG_R_I (request, "start running ordered scripts...");
+/**
+ * schedule_requests:
+ * @h: the handler
+ *
+ * Starts the next waiting request of each pending lane, as long as there
+ * are free worker slots.
+ */
+static void
+schedule_requests (Handler *h)
+{
+	Request *request;
+	Lane *lane;
 
-	h->current_request = request;
+	while (   h->num_lanes_running < (guint) max_parallel
+	       && (lane = g_queue_pop_head (h->lanes_pending))) {
+		lane->pending = FALSE;
+		request = g_queue_pop_head (lane->requests_waiting);
+		nm_assert (request && !lane->current_request);
 
-	return TRUE;
+		lane->current_request = request;
+		h->num_lanes_running++;
+
+		_LOG_R_I (request, "start running ordered scripts...");
+
+		if (dispatch_one_script (request))
+			continue;
+
+		/* Try to complete the request. It will be either completed
+		 * now, or when all pending "no-wait" scripts return. */
+		complete_request (request);
+	}
 }
 
 /**
@@ -298,18 +496,18 @@ complete_request (Request *request)
 	}
 
 	ret = g_variant_new ("(a(sus))", &results);
-	g_dbus_method_invocation_return_value (request->context, ret);
+	return_value_func (request->context, ret);
 
 	_LOG_R_D (request, "completed (%u scripts)", request->scripts->len);
 
-	if (handler->current_request == request)
-		handler->current_request = NULL;
+	if (request->lane && request->lane->current_request == request)
+		release_lane (handler, request);
 
 	request_free (request);
 
 	g_assert_cmpuint (handler->num_requests_pending, >, 0);
 	if (--handler->num_requests_pending <= 0) {
-		nm_assert (!handler->current_request && !g_queue_peek_head (handler->requests_waiting));
+		nm_assert (!handler->num_lanes_running && g_queue_is_empty (handler->lanes_pending));
 		quit_timeout_reschedule ();
 	}
 }
@@ -319,6 +517,7 @@ complete_script (ScriptInfo *script)
 {
 	Handler *handler;
 	Request *request;
+	Lane *lane;
 	gboolean wait = script->wait;
 
 	request = script->request;
@@ -331,56 +530,26 @@ complete_script (ScriptInfo *script)
 	}
 
 	handler = request->handler;
+	lane = request->lane;
 
-	nm_assert (!wait || handler->current_request == request);
-
-	/* Try to complete the request. @request will be possibly free'd,
-	 * making @script and @request a dangling pointer. */
-	complete_request (request);
-
-	if (!wait) {
-		/* this was a "no-wait" script. We either completed the request,
-		 * or there is nothing to do. Especially, there is no need to
-		 * queue the next_request() -- because no-wait scripts don't block
-		 * requests. However, if this was the last "no-wait" script and
-		 * there are "wait" scripts ready to run, launch them.
-		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
-
-			if (dispatch_one_script (handler->current_request))
-				return;
-
-			complete_request (handler->current_request);
-		} else
-			return;
-	} else {
-		/* if the script is a "wait" script, we already tried above to
-		 * dispatch the next script. As we didn't do that, it means we
-		 * just completed the last script of @request and we can continue
-		 * with the next request...
-		 *
-		 * Also, it cannot be that there is another request currently being
-		 * processed because only requests with "wait" scripts can become
-		 * @current_request. As there can only be one "wait" script running
-		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
-	}
-
-	while (next_request (handler, NULL)) {
-		request = handler->current_request;
+	nm_assert (!wait || lane->current_request == request);
 
+	if (   !wait
+	    && lane
+	    && lane->current_request == request
+	    && request->num_scripts_nowait == 0) {
+		/* this was the last "no-wait" script of a request that is running
+		 * in its lane. If there are "wait" scripts ready to run, launch them. */
 		if (dispatch_one_script (request))
 			return;
+	}
 
-		/* Try to complete the request. It will be either completed
-		 * now, or when all pending "no-wait" scripts return. */
-		complete_request (request);
+	/* Try to complete the request. @request will be possibly free'd,
+	 * making @script and @request a dangling pointer. If it was the
+	 * current request of a lane, that frees a worker slot. */
+	complete_request (request);
 
-		/* We can immediately start next_request(), because our current
-		 * @request has obviously no more "wait" scripts either.
-		 * Repeat... */
-	}
+	schedule_requests (handler);
 }
 
 static void
@@ -388,12 +557,14 @@ script_watch_cb (GPid pid, gint status, gpointer user_data)
 {
 	ScriptInfo *script = user_data;
 	guint err;
+	gint64 duration;
 
 	g_assert (pid == script->pid);
 
 	script->watch_id = 0;
 	nm_clear_g_source (&script->timeout_id);
 	script->request->num_scripts_done++;
+	duration = (g_get_monotonic_time () - script->start_time) / 1000;
 	if (!script->wait)
 		script->request->num_scripts_nowait--;
 
@@ -417,10 +588,10 @@ script_watch_cb (GPid pid, gint status, gpointer user_data)
 	}
 
 	if (script->result == DISPATCH_RESULT_SUCCESS) {
-		_LOG_S_D (script, "complete");
+		_LOG_S_D (script, "complete (%"G_GINT64_FORMAT" ms)", duration);
 	} else {
 		script->result = DISPATCH_RESULT_FAILED;
-		_LOG_S_W (script, "complete: failed with %s", script->error);
+		_LOG_S_W (script, "complete: failed with %s (%"G_GINT64_FORMAT" ms)", script->error, duration);
 	}
 
 	g_spawn_close_pid (script->pid);
@@ -458,6 +629,94 @@ again:
 	return FALSE;
 }
 
+static void
+plugin_done_cb (gpointer done_data, GError *error)
+{
+	PluginCall *call = done_data;
+	ScriptInfo *script = call->script;
+	gint64 duration;
+
+	g_return_if_fail (!call->done);
+	call->done = TRUE;
+
+	if (!script) {
+		/* the call timed out already and the request went on without it. */
+		g_slice_free (PluginCall, call);
+		return;
+	}
+
+	script->call = NULL;
+	nm_clear_g_source (&script->timeout_id);
+	script->request->num_scripts_done++;
+	duration = (g_get_monotonic_time () - script->start_time) / 1000;
+
+	if (!error) {
+		script->result = DISPATCH_RESULT_SUCCESS;
+		_LOG_S_D (script, "complete (%"G_GINT64_FORMAT" ms)", duration);
+	} else {
+		script->result = DISPATCH_RESULT_FAILED;
+		script->error = g_strdup_printf ("Plugin '%s' failed: %s",
+		                                 script->plugin->info->name, error->message);
+		_LOG_S_W (script, "complete: failed with %s (%"G_GINT64_FORMAT" ms)", error->message, duration);
+	}
+
+	if (call->in_dispatch) {
+		/* script_dispatch() sees that the plugin is done. */
+		return;
+	}
+
+	g_slice_free (PluginCall, call);
+	complete_script (script);
+}
+
+static gboolean
+plugin_timeout_cb (gpointer user_data)
+{
+	ScriptInfo *script = user_data;
+
+	script->timeout_id = 0;
+	script->call->script = NULL;
+	script->call = NULL;
+	script->request->num_scripts_done++;
+
+	_LOG_S_W (script, "complete: timeout (the plugin result is ignored)");
+
+	script->error = g_strdup_printf ("Plugin '%s' timed out.", script->plugin->info->name);
+	script->result = DISPATCH_RESULT_TIMEOUT;
+
+	complete_script (script);
+
+	return FALSE;
+}
+
+static gboolean
+plugin_dispatch (ScriptInfo *script)
+{
+	const NMDispatcherPlugin *info = script->plugin->info;
+	PluginCall *call;
+
+	_LOG_S_D (script, "call plugin");
+
+	call = g_slice_new0 (PluginCall);
+	call->script = script;
+	call->in_dispatch = TRUE;
+	script->call = call;
+	script->start_time = g_get_monotonic_time ();
+
+	info->dispatch (&script->request->event, plugin_done_cb, call);
+
+	call->in_dispatch = FALSE;
+	if (call->done) {
+		/* completed synchronously, the result is already set. */
+		g_slice_free (PluginCall, call);
+		return FALSE;
+	}
+
+	script->timeout_id = g_timeout_add (info->timeout_ms ? info->timeout_ms : NM_DISPATCHER_PLUGIN_TIMEOUT_MS,
+	                                    plugin_timeout_cb, script);
+	return TRUE;
+}
+
 static inline gboolean
 check_permissions (struct stat *s, const char **out_error_msg)
 {
@@ -533,6 +792,9 @@ script_dispatch (ScriptInfo *script)
 
 	script->dispatched = TRUE;
 
+	if (script->plugin)
+		return plugin_dispatch (script);
+
 	argv[0] = script->script;
 	argv[1] = request->iface
 	          ? request->iface
@@ -542,6 +804,7 @@ script_dispatch (ScriptInfo *script)
 
 	_LOG_S_D (script, "run script%s", script->wait ? "" : " (no-wait)");
 
+	script->start_time = g_get_monotonic_time ();
 	if (g_spawn_async ("/", argv, request->envp, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &script->pid, &error)) {
 		script->watch_id = g_child_watch_add (script->pid, (GChildWatchFunc) script_watch_cb, script);
 		script->timeout_id = g_timeout_add_seconds (SCRIPT_TIMEOUT, script_timeout_cb, script);
@@ -629,8 +892,9 @@ find_scripts (const char *str_action)
 	return sorted;
 }
 
+/* Whether @path is a symlink to a script in the directory @dirname */
 static gboolean
-script_must_wait (const char *path)
+script_links_into (const char *path, const char *dirname)
 {
 	gs_free char *link = NULL;
 	gs_free char *dir = NULL;
@@ -650,11 +914,124 @@ script_must_wait (const char *path)
 		dir = g_path_get_dirname (link);
 		real = realpath (dir, NULL);
 
-		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
-			return FALSE;
+		if (real && !strcmp (real, dirname))
+			return TRUE;
 	}
 
-	return TRUE;
+	return FALSE;
+}
+
+static gboolean
+plugin_wants_action (const Plugin *plugin, const char *str_action)
+{
+	const char *const *iter;
+
+	if (!plugin->info->actions)
+		return TRUE;
+	for (iter = plugin->info->actions; *iter; iter++) {
+		if (!strcmp (*iter, str_action))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+load_plugin (const char *path)
+{
+	GModule *module;
+	NMDispatcherPluginGetFunc get_func;
+	const NMDispatcherPlugin *info;
+	Plugin *plugin;
+	struct stat st;
+	GError *error = NULL;
+
+	if (stat (path, &st) != 0) {
+		g_warning ("load-plugins: Failed to stat '%s': %s", path, strerror (errno));
+		return;
+	}
+	if (!S_ISREG (st.st_mode))
+		return;
+	if (st.st_uid != 0 || (st.st_mode & (S_IWGRP | S_IWOTH | S_ISUID))) {
+		g_warning ("load-plugins: Skip '%s': must be owned by root and not writable by group or other", path);
+		return;
+	}
+
+	module = g_module_open (path, G_MODULE_BIND_LOCAL);
+	if (!module) {
+		g_warning ("load-plugins: Failed to load '%s': %s", path, g_module_error ());
+		return;
+	}
+
+	if (!g_module_symbol (module, "nm_dispatcher_plugin_get", (gpointer) &get_func)) {
+		g_warning ("load-plugins: Skip '%s': %s", path, g_module_error ());
+		g_module_close (module);
+		return;
+	}
+
+	info = get_func ();
+	if (   !info
+	    || info->api_version != NM_DISPATCHER_PLUGIN_API_VERSION
+	    || !info->name
+	    || !info->dispatch) {
+		g_warning ("load-plugins: Skip '%s': unsupported plugin API version", path);
+		g_module_close (module);
+		return;
+	}
+
+	if (info->init && !info->init (&error)) {
+		g_warning ("load-plugins: Plugin '%s' failed to initialize: %s",
+		           info->name, error ? error->message : "unknown error");
+		g_clear_error (&error);
+		g_module_close (module);
+		return;
+	}
+
+	/* the plugin may have hooked into the main loop; never unload it. */
+	g_module_make_resident (module);
+
+	plugin = g_slice_new0 (Plugin);
+	plugin->path = g_strdup (path);
+	plugin->result_name = g_strdup_printf (NMD_PLUGIN_RESULT_PREFIX "%s", info->name);
+	plugin->info = info;
+	g_ptr_array_add (plugins, plugin);
+
+	g_info ("load-plugins: Loaded plugin '%s' from '%s'", info->name, path);
+}
+
+static void
+load_plugins (void)
+{
+	GDir *dir;
+	const char *filename;
+	GSList *sorted = NULL, *iter;
+	GError *error = NULL;
+
+	plugins = g_ptr_array_new ();
+
+	if (!g_module_supported ())
+		return;
+
+	if (!(dir = g_dir_open (NMD_PLUGIN_DIR, 0, &error))) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			g_message ("load-plugins: Failed to open plugin directory '%s': %s",
+			           NMD_PLUGIN_DIR, error->message);
+		}
+		g_error_free (error);
+		return;
+	}
+
+	while ((filename = g_dir_read_name (dir))) {
+		if (!check_filename (filename) || !g_str_has_suffix (filename, ".so"))
+			continue;
+		sorted = g_slist_insert_sorted (sorted,
+		                                g_build_filename (NMD_PLUGIN_DIR, filename, NULL),
+		                                (GCompareFunc) g_strcmp0);
+	}
+	g_dir_close (dir);
+
+	for (iter = sorted; iter; iter = iter->next)
+		load_plugin (iter->data);
+	g_slist_free_full (sorted, g_free);
 }
 
 static gboolean
@@ -706,13 +1083,48 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	                                                    &error_message);
 
 	request->scripts = g_ptr_array_new_full (5, script_info_free);
+
+	/* plugins run first, in-process and in order with the "wait" scripts */
+	for (i = 0; !error_message && i < plugins->len; i++) {
+		const Plugin *plugin = g_ptr_array_index (plugins, i);
+		ScriptInfo *s;
+
+		if (!plugin_wants_action (plugin, str_action))
+			continue;
+
+		s = g_slice_new0 (ScriptInfo);
+		s->request = request;
+		s->script = g_strdup (plugin->result_name);
+		s->plugin = plugin;
+		s->wait = TRUE;
+		g_ptr_array_add (request->scripts, s);
+	}
+
+	if (request->scripts->len > 0) {
+		request->vpn_ip_iface = g_strdup (vpn_ip_iface);
+		request->event.action = request->action;
+		request->event.iface = request->iface;
+		request->event.connection_dict = g_variant_ref (connection_dict);
+		request->event.connection_props = g_variant_ref (connection_props);
+		request->event.device_props = g_variant_ref (device_props);
+		request->event.device_ip4_props = g_variant_ref (device_ip4_props);
+		request->event.device_ip6_props = g_variant_ref (device_ip6_props);
+		request->event.device_dhcp4_props = g_variant_ref (device_dhcp4_props);
+		request->event.device_dhcp6_props = g_variant_ref (device_dhcp6_props);
+		request->event.vpn_ip_iface = request->vpn_ip_iface;
+		request->event.vpn_ip4_props = g_variant_ref (vpn_ip4_props);
+		request->event.vpn_ip6_props = g_variant_ref (vpn_ip6_props);
+	}
+
 	for (iter = sorted_scripts; iter; iter = g_slist_next (iter)) {
 		ScriptInfo *s;
 
 		s = g_slice_new0 (ScriptInfo);
 		s->request = request;
 		s->script = iter->data;
-		s->wait = script_must_wait (s->script);
+		s->wait = !script_links_into (s->script, NMD_SCRIPT_DIR_NO_WAIT);
+		if (s->wait && script_links_into (s->script, NMD_SCRIPT_DIR_NO_SUPERSEDE))
+			request->no_supersede = TRUE;
 		g_ptr_array_add (request->scripts, s);
 	}
 	g_slist_free (sorted_scripts);
@@ -733,7 +1145,7 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 			_LOG_R_I (request, "completed: no scripts");
 
 		results = g_variant_new_array (G_VARIANT_TYPE ("(sus)"), NULL, 0);
-		g_dbus_method_invocation_return_value (context, g_variant_new ("(@a(sus))", results));
+		return_value_func (context, g_variant_new ("(@a(sus))", results));
 		request->num_scripts_done = request->scripts->len;
 		request_free (request);
 		return TRUE;
@@ -753,35 +1165,18 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 
 	if (num_nowait < request->scripts->len) {
-		/* The request has at least one wait script.
-		 * Try next_request() to schedule the request for
-		 * execution. This either enqueues the request or
-		 * sets it as h->current_request. */
-		if (next_request (h, request)) {
-			/* @request is now @current_request. Go ahead and
-			 * schedule the first wait script. */
-			if (!dispatch_one_script (request)) {
-				/* If that fails, we might be already finished with the
-				 * request. Try complete_request(). */
-				complete_request (request);
-
-				if (next_request (h, NULL)) {
-					/* As @request was successfully scheduled as next_request(), there is no
-					 * other request in queue that can be scheduled afterwards. Assert against
-					 * that, but call next_request() to clear current_request. */
-					g_assert_not_reached ();
-				}
-			}
-		}
+		/* The request has at least one wait script. Enqueue it to the
+		 * lane of its interface and start it when it is its turn and
+		 * a worker is free. */
+		enqueue_request (h, request);
+		schedule_requests (h);
 	} else {
 		/* The request contains only no-wait scripts. Try to complete
 		 * the request right away (we might have failed to schedule any
 		 * of the scripts). It will be either completed now, or later
 		 * when the pending scripts return.
-		 * We don't enqueue it to h->requests_waiting.
-		 * There is no need to handle next_request(), because @request is
-		 * not the current request anyway and does not interfere with requests
-		 * that have any "wait" scripts. */
+		 * We don't enqueue it to a lane, it does not interfere with
+		 * requests that have any "wait" scripts. */
 		complete_request (request);
 	}
 
@@ -892,6 +1287,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "max-parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Number of interfaces whose scripts may run at the same time (default: 4)", "N" },
 		{ NULL }
 	};
 
@@ -907,6 +1303,11 @@ main (int argc, char **argv)
 
 	g_option_context_free (opt_ctx);
 
+	if (max_parallel < 1) {
+		g_warning ("Invalid --max-parallel value %d", max_parallel);
+		return 1;
+	}
+
 	nm_g_type_init ();
 
 	g_unix_signal_add (SIGTERM, signal_handler, GINT_TO_POINTER (SIGTERM));
@@ -924,6 +1325,8 @@ main (int argc, char **argv)
 	} else
 		logging_setup ();
 
+	load_plugins ();
+
 	loop = g_main_loop_new (NULL, FALSE);
 
 	bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
@@ -957,7 +1360,8 @@ main (int argc, char **argv)
 
 	g_main_loop_run (loop);
 
-	g_queue_free (handler->requests_waiting);
+	g_queue_free (handler->lanes_pending);
+	g_hash_table_unref (handler->lanes);
 	g_object_unref (handler);
 
 	if (!debug)
@@ -0,0 +1,226 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager dispatcher environment benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Builds the arguments of a dispatcher "up" event with a configurable
+ * number of addresses, routes and DHCP options and measures the
+ * construction of the script environment from them.
+ */
+
+#include "nm-default.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+
+#include "nm-core-internal.h"
+#include "nm-dispatcher-utils.h"
+#include "nm-dispatcher-api.h"
+
+#include "nm-test-utils.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int iterations;
+	int items;
+} global_opt = {
+	.iterations = 10000,
+	.items = 20,
+};
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &global_opt.iterations, "Number of environments to construct", "N" },
+		{ "items", 'm', 0, G_OPTION_ARG_INT, &global_opt.items, "Number of addresses, routes and DHCP options of the event", "M" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark the construction of the dispatcher script environment.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.iterations <= 0
+	    || global_opt.items < 0
+	    || global_opt.items > 0xFFFF) {
+		g_warning ("Invalid arguments: iterations must be positive and items within 0..65535");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static GVariant *
+create_connection_dict (void)
+{
+	gs_unref_object NMConnection *connection = NULL;
+
+	connection = nmtst_create_minimal_connection ("bench", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	return g_variant_ref_sink (nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_NO_SECRETS));
+}
+
+static GVariant *
+create_connection_props (void)
+{
+	GVariantBuilder props;
+
+	g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&props, "{sv}",
+	                       NMD_CONNECTION_PROPS_PATH,
+	                       g_variant_new_object_path ("/org/freedesktop/NetworkManager/Settings/1"));
+	g_variant_builder_add (&props, "{sv}",
+	                       NMD_CONNECTION_PROPS_FILENAME,
+	                       g_variant_new_string ("/etc/NetworkManager/system-connections/bench"));
+	return g_variant_ref_sink (g_variant_builder_end (&props));
+}
+
+static GVariant *
+create_device_props (void)
+{
+	GVariantBuilder props;
+
+	g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&props, "{sv}", NMD_DEVICE_PROPS_INTERFACE, g_variant_new_string ("eth0"));
+	g_variant_builder_add (&props, "{sv}", NMD_DEVICE_PROPS_IP_INTERFACE, g_variant_new_string ("eth0"));
+	g_variant_builder_add (&props, "{sv}", NMD_DEVICE_PROPS_TYPE, g_variant_new_uint32 (NM_DEVICE_TYPE_ETHERNET));
+	g_variant_builder_add (&props, "{sv}", NMD_DEVICE_PROPS_STATE, g_variant_new_uint32 (NM_DEVICE_STATE_ACTIVATED));
+	g_variant_builder_add (&props, "{sv}",
+	                       NMD_DEVICE_PROPS_PATH,
+	                       g_variant_new_object_path ("/org/freedesktop/NetworkManager/Devices/1"));
+	return g_variant_ref_sink (g_variant_builder_end (&props));
+}
+
+static GVariant *
+create_ip4_props (void)
+{
+	GVariantBuilder props, addresses, routes, nameservers, domains;
+	int i;
+
+	g_variant_builder_init (&addresses, G_VARIANT_TYPE ("aau"));
+	g_variant_builder_init (&routes, G_VARIANT_TYPE ("aau"));
+	g_variant_builder_init (&nameservers, G_VARIANT_TYPE ("au"));
+	g_variant_builder_init (&domains, G_VARIANT_TYPE ("as"));
+	for (i = 0; i < global_opt.items; i++) {
+		char domain[64];
+		guint32 address[3] = {
+			htonl (0x0A000000u + (i << 8) + 2),
+			24,
+			htonl (0x0A000000u + (i << 8) + 1),
+		};
+		guint32 route[4] = {
+			htonl (0xAC100000u + (i << 8)),
+			24,
+			htonl (0x0A000001u),
+			100 + i,
+		};
+
+		g_variant_builder_add (&addresses, "@au",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, address, 3, sizeof (guint32)));
+		g_variant_builder_add (&routes, "@au",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, route, 4, sizeof (guint32)));
+		g_variant_builder_add (&nameservers, "u", htonl (0xC0A80001u + i));
+		nm_sprintf_buf (domain, "bench%d.example.com", i);
+		g_variant_builder_add (&domains, "s", domain);
+	}
+
+	g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&props, "{sv}", "addresses", g_variant_builder_end (&addresses));
+	g_variant_builder_add (&props, "{sv}", "routes", g_variant_builder_end (&routes));
+	g_variant_builder_add (&props, "{sv}", "nameservers", g_variant_builder_end (&nameservers));
+	g_variant_builder_add (&props, "{sv}", "domains", g_variant_builder_end (&domains));
+	return g_variant_ref_sink (g_variant_builder_end (&props));
+}
+
+static GVariant *
+create_dhcp4_props (void)
+{
+	GVariantBuilder props;
+	int i;
+
+	g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+	for (i = 0; i < global_opt.items; i++) {
+		char key[32], value[64];
+
+		nm_sprintf_buf (key, "option_%d", i);
+		nm_sprintf_buf (value, "value of option %d", i);
+		g_variant_builder_add (&props, "{sv}", key, g_variant_new_string (value));
+	}
+	return g_variant_ref_sink (g_variant_builder_end (&props));
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	gs_unref_variant GVariant *con_dict = NULL;
+	gs_unref_variant GVariant *con_props = NULL;
+	gs_unref_variant GVariant *device_props = NULL;
+	gs_unref_variant GVariant *ip4_props = NULL;
+	gs_unref_variant GVariant *dhcp4_props = NULL;
+	NMBenchTimer timer;
+	int i;
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	g_print ("# iterations=%d items=%d\n", global_opt.iterations, global_opt.items);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	con_dict = create_connection_dict ();
+	con_props = create_connection_props ();
+	device_props = create_device_props ();
+	ip4_props = create_ip4_props ();
+	dhcp4_props = create_dhcp4_props ();
+
+	nm_bench_timer_start (&timer, "construct-envp");
+	for (i = 0; i < global_opt.iterations; i++) {
+		gs_free char *iface = NULL;
+		const char *error_message = NULL;
+		char **envp;
+
+		envp = nm_dispatcher_utils_construct_envp (NMD_ACTION_UP,
+		                                           con_dict,
+		                                           con_props,
+		                                           device_props,
+		                                           ip4_props,
+		                                           NULL,
+		                                           dhcp4_props,
+		                                           NULL,
+		                                           NULL,
+		                                           NULL,
+		                                           NULL,
+		                                           &iface,
+		                                           &error_message);
+		g_assert (envp && !error_message);
+		g_strfreev (envp);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	return EXIT_SUCCESS;
+}
@@ -610,6 +610,17 @@ test_up_empty_vpn_iface (void)
 	test_generic ("dispatcher-up", "");
 }
 
+static void
+test_up_cached (void)
+{
+	/* The second event is built from the cached environment fragments
+	 * of the first one and must not differ. */
+	test_generic ("dispatcher-up", NULL);
+	test_generic ("dispatcher-up", NULL);
+	test_generic ("dispatcher-vpn-up", NULL);
+	test_generic ("dispatcher-vpn-up", NULL);
+}
+
 /*******************************************/
 
 NMTST_DEFINE ();
@@ -626,6 +637,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/dispatcher/external", test_external);
 
 	g_test_add_func ("/dispatcher/up_empty_vpn_iface", test_up_empty_vpn_iface);
+	g_test_add_func ("/dispatcher/up_cached", test_up_cached);
 
 	return g_test_run ();
 }
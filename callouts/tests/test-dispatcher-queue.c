@@ -0,0 +1,496 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+
+/* The request queue of the dispatcher is not a library; pull in the
+ * program and drive it through handle_action(). The scripts directories
+ * do not exist (see Makefile.am), so the requests only consist of the
+ * test plugin. */
+#define main nm_dispatcher_main
+int nm_dispatcher_main (int argc, char **argv);
+#include "nm-dispatcher.c"
+#undef main
+
+#include "nm-test-utils.h"
+
+/*****************************************************************************/
+
+typedef struct {
+	NMDispatcherPluginDoneFunc done;
+	gpointer done_data;
+	char *event;
+} PendingCall;
+
+static struct {
+	Handler *h;
+
+	/* "<action>:<iface>" of every plugin call, in order */
+	GString *dispatched;
+
+	/* "<request>:<result>,..." of every D-Bus reply, in order */
+	GString *returned;
+	char *last_error;
+
+	GPtrArray *pending;
+
+	/* whether the plugin reports its result from within dispatch() */
+	gboolean sync;
+	const char *fail;
+} gl;
+
+static void _plugin_dispatch (const NMDispatcherPluginEvent *event,
+                              NMDispatcherPluginDoneFunc done,
+                              gpointer done_data);
+
+static const char *plugin_actions_down[] = { NMD_ACTION_DOWN, NULL };
+
+static NMDispatcherPlugin test_plugin_info = {
+	.api_version = NM_DISPATCHER_PLUGIN_API_VERSION,
+	.name = "test",
+	.dispatch = _plugin_dispatch,
+};
+
+static Plugin test_plugin = {
+	.path = "/test-plugin.so",
+	.result_name = NMD_PLUGIN_RESULT_PREFIX "test",
+	.info = &test_plugin_info,
+};
+
+static void
+_plugin_report (NMDispatcherPluginDoneFunc done, gpointer done_data, const char *fail)
+{
+	GError *error = NULL;
+
+	if (fail)
+		error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED, fail);
+	done (done_data, error);
+	g_clear_error (&error);
+}
+
+static void
+_plugin_dispatch (const NMDispatcherPluginEvent *event,
+                  NMDispatcherPluginDoneFunc done,
+                  gpointer done_data)
+{
+	PendingCall *call;
+	char *desc;
+
+	desc = g_strdup_printf ("%s:%s", event->action, event->iface ? event->iface : "");
+	g_string_append_printf (gl.dispatched, "%s%s", gl.dispatched->len ? " " : "", desc);
+
+	if (gl.sync) {
+		g_free (desc);
+		_plugin_report (done, done_data, gl.fail);
+		return;
+	}
+
+	call = g_slice_new0 (PendingCall);
+	call->done = done;
+	call->done_data = done_data;
+	call->event = desc;
+	g_ptr_array_add (gl.pending, call);
+}
+
+/* reports the result of the outstanding plugin call for @event */
+static void
+_plugin_complete (const char *event, const char *fail)
+{
+	PendingCall *call = NULL;
+	guint i;
+
+	for (i = 0; i < gl.pending->len; i++) {
+		call = g_ptr_array_index (gl.pending, i);
+		if (nm_streq (call->event, event))
+			break;
+	}
+	g_assert_cmpuint (i, <, gl.pending->len);
+	g_ptr_array_remove_index (gl.pending, i);
+
+	_plugin_report (call->done, call->done_data, fail);
+
+	g_free (call->event);
+	g_slice_free (PendingCall, call);
+}
+
+static const char *
+_result_to_string (guint32 result)
+{
+	switch (result) {
+	case DISPATCH_RESULT_SUCCESS:
+		return "success";
+	case DISPATCH_RESULT_FAILED:
+		return "failed";
+	case DISPATCH_RESULT_TIMEOUT:
+		return "timeout";
+	case DISPATCH_RESULT_SUPERSEDED:
+		return "superseded";
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+static void
+_return_value (GDBusMethodInvocation *context, GVariant *parameters)
+{
+	GVariantIter *iter;
+	const char *script, *error;
+	guint32 result;
+	gboolean first = TRUE;
+
+	g_variant_ref_sink (parameters);
+	g_assert (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a(sus))")));
+
+	g_string_append_printf (gl.returned, "%s%u:",
+	                        gl.returned->len ? " " : "",
+	                        GPOINTER_TO_UINT (context));
+
+	g_variant_get (parameters, "(a(sus))", &iter);
+	while (g_variant_iter_next (iter, "(&su&s)", &script, &result, &error)) {
+		g_assert_cmpstr (script, ==, test_plugin.result_name);
+		g_string_append_printf (gl.returned, "%s%s", first ? "" : ",", _result_to_string (result));
+		g_free (gl.last_error);
+		gl.last_error = g_strdup (error);
+		first = FALSE;
+	}
+	g_variant_iter_free (iter);
+	g_variant_unref (parameters);
+
+	if (loop)
+		g_main_loop_quit (loop);
+}
+
+/* Sends the request @action for @iface as if it came over D-Bus. The
+ * reply is recorded in gl.returned with @id as the request number. */
+static void
+_action (guint id, const char *action, const char *iface)
+{
+	GVariant *con_dict, *con_props, *dev_props, *empty;
+
+	if (iface) {
+		con_dict = g_variant_new_parsed ("{'connection': {'uuid': <'a1b8e3a4-2b6b-4c31-9d32-6d4e6c7e70f1'>, 'id': <%s>}}",
+		                                 iface);
+		con_props = g_variant_new_parsed ("{'path': <objectpath '/org/freedesktop/NetworkManager/Settings/1'>}");
+		dev_props = g_variant_new_parsed ("{'interface': <%s>, 'type': <uint32 1>, 'state': <uint32 30>, "
+		                                  "'path': <objectpath '/org/freedesktop/NetworkManager/Devices/1'>}",
+		                                  iface);
+	} else {
+		con_dict = g_variant_new_parsed ("@a{sa{sv}} {}");
+		con_props = g_variant_new_parsed ("@a{sv} {}");
+		dev_props = g_variant_new_parsed ("@a{sv} {}");
+	}
+	empty = g_variant_new_parsed ("@a{sv} {}");
+
+	g_variant_ref_sink (con_dict);
+	g_variant_ref_sink (con_props);
+	g_variant_ref_sink (dev_props);
+	g_variant_ref_sink (empty);
+
+	handle_action (gl.h->dbus_dispatcher,
+	               GUINT_TO_POINTER (id),
+	               action,
+	               con_dict,
+	               con_props,
+	               dev_props,
+	               empty,
+	               empty,
+	               empty,
+	               empty,
+	               "",
+	               empty,
+	               empty,
+	               FALSE,
+	               gl.h);
+
+	g_variant_unref (con_dict);
+	g_variant_unref (con_props);
+	g_variant_unref (dev_props);
+	g_variant_unref (empty);
+}
+
+static void
+_setup (gint parallel)
+{
+	persist = TRUE;
+	max_parallel = parallel;
+	num_requests_superseded = 0;
+	request_id_counter = 0;
+	return_value_func = _return_value;
+
+	test_plugin_info.actions = NULL;
+	test_plugin_info.timeout_ms = 0;
+	plugins = g_ptr_array_new ();
+	g_ptr_array_add (plugins, &test_plugin);
+
+	gl.h = g_object_new (HANDLER_TYPE, NULL);
+	gl.dispatched = g_string_new (NULL);
+	gl.returned = g_string_new (NULL);
+	gl.pending = g_ptr_array_new ();
+	gl.sync = FALSE;
+	gl.fail = NULL;
+}
+
+static void
+_teardown (void)
+{
+	g_assert_cmpuint (gl.pending->len, ==, 0);
+	g_assert_cmpint (gl.h->num_requests_pending, ==, 0);
+	g_assert_cmpuint (gl.h->num_lanes_running, ==, 0);
+	g_assert_cmpuint (g_hash_table_size (gl.h->lanes), ==, 0);
+	g_assert (g_queue_is_empty (gl.h->lanes_pending));
+
+	g_queue_free (gl.h->lanes_pending);
+	g_hash_table_unref (gl.h->lanes);
+	g_clear_object (&gl.h);
+
+	g_ptr_array_unref (gl.pending);
+	g_string_free (gl.dispatched, TRUE);
+	g_string_free (gl.returned, TRUE);
+	g_clear_pointer (&gl.last_error, g_free);
+	g_clear_pointer (&plugins, g_ptr_array_unref);
+}
+
+/*****************************************************************************/
+
+static void
+test_lanes_order (void)
+{
+	_setup (2);
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	_action (2, NMD_ACTION_PRE_DOWN, "eth0");
+	_action (3, NMD_ACTION_UP, "eth1");
+	_action (4, NMD_ACTION_UP, "eth2");
+
+	/* one request per interface, and only two interfaces at a time */
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth1");
+	g_assert_cmpstr (gl.returned->str, ==, "");
+
+	/* eth2 waited for a slot longer than the second request of eth0 */
+	_plugin_complete ("up:eth0", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:success");
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth1 up:eth2");
+
+	_plugin_complete ("up:eth1", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:success 3:success");
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth1 up:eth2 pre-down:eth0");
+
+	_plugin_complete ("pre-down:eth0", NULL);
+	_plugin_complete ("up:eth2", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:success 3:success 2:success 4:success");
+
+	_teardown ();
+}
+
+static void
+test_lanes_hostname (void)
+{
+	_setup (1);
+
+	/* requests without an interface share the lane of the empty name */
+	_action (1, NMD_ACTION_HOSTNAME, NULL);
+	_action (2, NMD_ACTION_HOSTNAME, NULL);
+	g_assert_cmpstr (gl.dispatched->str, ==, "hostname:");
+
+	_plugin_complete ("hostname:", NULL);
+	g_assert_cmpstr (gl.dispatched->str, ==, "hostname: hostname:");
+	_plugin_complete ("hostname:", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:success 2:success");
+
+	_teardown ();
+}
+
+static void
+test_supersede (void)
+{
+	_setup (1);
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	_action (2, NMD_ACTION_UP, "eth0");
+	_action (3, NMD_ACTION_UP, "eth1");
+	_action (4, NMD_ACTION_DHCP4_CHANGE, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "");
+
+	/* only the latest lease is dispatched */
+	_action (5, NMD_ACTION_DHCP4_CHANGE, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "4:superseded");
+	g_assert_cmpstr (gl.last_error, ==, "Script 'plugin:test' skipped, superseded by request 5.");
+
+	/* "down" drops the waiting "up", but neither the running one nor
+	 * the one of another interface */
+	_action (6, NMD_ACTION_DOWN, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "4:superseded 2:superseded");
+	g_assert_cmpuint (num_requests_superseded, ==, 2);
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0");
+
+	_plugin_complete ("up:eth0", NULL);
+	_plugin_complete ("up:eth1", NULL);
+	_plugin_complete ("dhcp4-change:eth0", NULL);
+	_plugin_complete ("down:eth0", NULL);
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth1 dhcp4-change:eth0 down:eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "4:superseded 2:superseded 1:success 3:success 5:success 6:success");
+
+	_teardown ();
+}
+
+static void
+test_supersede_no_supersede (void)
+{
+	Lane *lane;
+	Request *request;
+
+	_setup (1);
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	_action (2, NMD_ACTION_UP, "eth0");
+
+	/* as if the request had a script in no-supersede.d */
+	lane = g_hash_table_lookup (gl.h->lanes, "eth0");
+	g_assert (lane);
+	request = g_queue_peek_tail (lane->requests_waiting);
+	g_assert (request);
+	request->no_supersede = TRUE;
+
+	_action (3, NMD_ACTION_DOWN, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "");
+	g_assert_cmpuint (num_requests_superseded, ==, 0);
+
+	_plugin_complete ("up:eth0", NULL);
+	_plugin_complete ("up:eth0", NULL);
+	_plugin_complete ("down:eth0", NULL);
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth0 down:eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "1:success 2:success 3:success");
+
+	_teardown ();
+}
+
+static void
+test_plugin_sync (void)
+{
+	_setup (4);
+
+	gl.sync = TRUE;
+	_action (1, NMD_ACTION_UP, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "1:success");
+	g_assert_cmpstr (gl.last_error, ==, "");
+
+	gl.fail = "boom";
+	g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*complete: failed with boom*");
+	_action (2, NMD_ACTION_UP, "eth0");
+	g_test_assert_expected_messages ();
+	g_assert_cmpstr (gl.returned->str, ==, "1:success 2:failed");
+	g_assert_cmpstr (gl.last_error, ==, "Plugin 'test' failed: boom");
+
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 up:eth0");
+
+	_teardown ();
+}
+
+static void
+test_plugin_async (void)
+{
+	_setup (4);
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "");
+
+	g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*complete: failed with bang*");
+	_plugin_complete ("up:eth0", "bang");
+	g_test_assert_expected_messages ();
+	g_assert_cmpstr (gl.returned->str, ==, "1:failed");
+	g_assert_cmpstr (gl.last_error, ==, "Plugin 'test' failed: bang");
+
+	_teardown ();
+}
+
+static void
+test_plugin_actions (void)
+{
+	_setup (4);
+
+	/* a plugin only gets the actions it asked for */
+	test_plugin_info.actions = plugin_actions_down;
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	g_assert_cmpstr (gl.returned->str, ==, "1:");
+
+	_action (2, NMD_ACTION_DOWN, "eth0");
+	_plugin_complete ("down:eth0", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1: 2:success");
+	g_assert_cmpstr (gl.dispatched->str, ==, "down:eth0");
+
+	_teardown ();
+}
+
+static void
+test_plugin_timeout (void)
+{
+	_setup (4);
+
+	test_plugin_info.timeout_ms = 50;
+	loop = g_main_loop_new (NULL, FALSE);
+
+	_action (1, NMD_ACTION_UP, "eth0");
+	_action (2, NMD_ACTION_DOWN, "eth0");
+
+	g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*complete: timeout*");
+	if (!nmtst_main_loop_run (loop, 5000))
+		g_assert_not_reached ();
+	g_test_assert_expected_messages ();
+
+	/* the lane goes on without the plugin */
+	g_assert_cmpstr (gl.returned->str, ==, "1:timeout");
+	g_assert_cmpstr (gl.last_error, ==, "Plugin 'test' timed out.");
+	g_assert_cmpstr (gl.dispatched->str, ==, "up:eth0 down:eth0");
+
+	/* and ignores its late result */
+	_plugin_complete ("up:eth0", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:timeout");
+
+	_plugin_complete ("down:eth0", NULL);
+	g_assert_cmpstr (gl.returned->str, ==, "1:timeout 2:success");
+
+	g_clear_pointer (&loop, g_main_loop_unref);
+
+	_teardown ();
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init (&argc, &argv, FALSE);
+
+	g_test_add_func ("/dispatcher/queue/lanes/order", test_lanes_order);
+	g_test_add_func ("/dispatcher/queue/lanes/hostname", test_lanes_hostname);
+	g_test_add_func ("/dispatcher/queue/supersede", test_supersede);
+	g_test_add_func ("/dispatcher/queue/supersede/no-supersede", test_supersede_no_supersede);
+	g_test_add_func ("/dispatcher/queue/plugin/sync", test_plugin_sync);
+	g_test_add_func ("/dispatcher/queue/plugin/async", test_plugin_async);
+	g_test_add_func ("/dispatcher/queue/plugin/actions", test_plugin_actions);
+	g_test_add_func ("/dispatcher/queue/plugin/timeout", test_plugin_timeout);
+
+	return g_test_run ();
+}
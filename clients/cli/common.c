@@ -861,6 +861,115 @@ nmc_team_check_config (const char *config, char **out_config, GError **error)
 	return TRUE;
 }
 
+/*
+ * Lookup tables over the connections of nm_cli.client, used by
+ * nmc_find_connection() and nmc_unique_connection_name() instead of
+ * comparing against every connection. The values are the position in the
+ * array plus one, the first connection wins for duplicate keys. The tables
+ * are dropped whenever a connection is added, removed or changed, and are
+ * rebuilt by the next lookup.
+ */
+static struct {
+	NMClient *client;
+	GPtrArray *indexed;
+	GHashTable *by_id;
+	GHashTable *by_uuid;
+	GHashTable *by_path;
+	GHashTable *by_path_num;
+} con_index;
+
+static void
+con_index_invalidate (void)
+{
+	if (!con_index.indexed)
+		return;
+
+	g_clear_pointer (&con_index.by_id, g_hash_table_unref);
+	g_clear_pointer (&con_index.by_uuid, g_hash_table_unref);
+	g_clear_pointer (&con_index.by_path, g_hash_table_unref);
+	g_clear_pointer (&con_index.by_path_num, g_hash_table_unref);
+	g_clear_pointer (&con_index.indexed, g_ptr_array_unref);
+}
+
+static void
+con_index_changed_cb (NMConnection *connection, gpointer user_data)
+{
+	con_index_invalidate ();
+}
+
+static void
+con_index_client_changed_cb (NMClient *client, NMRemoteConnection *connection, gpointer user_data)
+{
+	con_index_invalidate ();
+}
+
+static void
+con_index_unwatch (gpointer data)
+{
+	g_signal_handlers_disconnect_by_func (data, con_index_changed_cb, NULL);
+	g_object_unref (data);
+}
+
+static void
+con_index_add (GHashTable *table, const char *key, guint pos)
+{
+	if (key && !g_hash_table_contains (table, key))
+		g_hash_table_insert (table, g_strdup (key), GUINT_TO_POINTER (pos + 1));
+}
+
+static gboolean
+con_index_ensure (const GPtrArray *connections)
+{
+	guint i;
+
+	/* Only the connection list of the NMClient can be kept up to date */
+	if (   !nm_cli.client
+	    || connections != nm_client_get_connections (nm_cli.client))
+		return FALSE;
+
+	if (con_index.client != nm_cli.client) {
+		con_index_invalidate ();
+		con_index.client = nm_cli.client;
+		g_signal_connect (nm_cli.client, NM_CLIENT_CONNECTION_ADDED,
+		                  G_CALLBACK (con_index_client_changed_cb), NULL);
+		g_signal_connect (nm_cli.client, NM_CLIENT_CONNECTION_REMOVED,
+		                  G_CALLBACK (con_index_client_changed_cb), NULL);
+	}
+
+	if (con_index.indexed)
+		return TRUE;
+
+	con_index.indexed = g_ptr_array_new_full (connections->len, con_index_unwatch);
+	con_index.by_id = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	con_index.by_uuid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	con_index.by_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	con_index.by_path_num = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (i = 0; i < connections->len; i++) {
+		NMConnection *connection = NM_CONNECTION (connections->pdata[i]);
+		const char *path = nm_connection_get_path (connection);
+
+		con_index_add (con_index.by_id, nm_connection_get_id (connection), i);
+		con_index_add (con_index.by_uuid, nm_connection_get_uuid (connection), i);
+		con_index_add (con_index.by_path, path, i);
+		if (path)
+			con_index_add (con_index.by_path_num, strrchr (path, '/') + 1, i);
+
+		g_signal_connect (connection, NM_CONNECTION_CHANGED,
+		                  G_CALLBACK (con_index_changed_cb), NULL);
+		g_ptr_array_add (con_index.indexed, g_object_ref (connection));
+	}
+	return TRUE;
+}
+
+static guint
+con_index_lookup (GHashTable *table, const char *key, guint best)
+{
+	guint pos = GPOINTER_TO_UINT (g_hash_table_lookup (table, key));
+
+	return pos && (!best || pos < best) ? pos : best;
+}
+
 /*
  * nmc_find_connection:
  * @connections: array of NMConnections to search in
@@ -890,6 +999,21 @@ nmc_find_connection (const GPtrArray *connections,
 	const char *uuid;
 	const char *path, *path_num;
 
+	if (!start && con_index_ensure (connections)) {
+		guint pos = 0;
+
+		if (!filter_type || strcmp (filter_type, "id") == 0)
+			pos = con_index_lookup (con_index.by_id, filter_val, pos);
+		if (!filter_type || strcmp (filter_type, "uuid") == 0)
+			pos = con_index_lookup (con_index.by_uuid, filter_val, pos);
+		if (!filter_type || strcmp (filter_type, "path") == 0) {
+			pos = con_index_lookup (con_index.by_path, filter_val, pos);
+			if (filter_type)
+				pos = con_index_lookup (con_index.by_path_num, filter_val, pos);
+		}
+		return pos ? NM_CONNECTION (connections->pdata[pos - 1]) : NULL;
+	}
+
 	for (i = start ? *start : 0; i < connections->len; i++) {
 		connection = NM_CONNECTION (connections->pdata[i]);
 
@@ -1120,6 +1244,14 @@ nmc_unique_connection_name (const GPtrArray *connections, const char *try_name)
 	int i = 0;
 
 	new_name = g_strdup (try_name);
+	if (con_index_ensure (connections)) {
+		while (g_hash_table_contains (con_index.by_id, new_name)) {
+			g_free (new_name);
+			new_name = g_strdup_printf ("%s-%d", try_name, num++);
+		}
+		return new_name;
+	}
+
 	while (i < connections->len) {
 		connection = NM_CONNECTION (connections->pdata[i]);
 
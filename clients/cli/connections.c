@@ -36,6 +36,7 @@
 #include "nm-secret-agent-simple.h"
 #include "polkit-agent.h"
 #include "nm-vpn-helpers.h"
+#include "nm-dbus-compat.h"
 
 /* define some prompts for connection editor */
 #define EDITOR_PROMPT_SETTING  _("Setting name? ")
@@ -255,7 +256,8 @@ usage (void)
 	              "COMMAND := { show | up | down | add | modify | edit | delete | monitor | reload | load }\n\n"
 	              "  show [--active] [--order <order spec>]\n"
 	              "  show [--active] [id | uuid | path | apath] <ID> ...\n\n"
-	              "  up [[id | uuid | path] <ID>] [ifname <ifname>] [ap <BSSID>] [passwd-file <file with passwords>]\n\n"
+	              "  up [[id | uuid | path] <ID>] [id | uuid | path <ID>] ... [ifname <ifname>] [ap <BSSID>] [passwd-file <file with passwords>]\n"
+	              "     [from-file <file with IDs>] [max-parallel <num>]\n\n"
 	              "  down [id | uuid | path | apath] <ID> ...\n\n"
 	              "  add COMMON_OPTIONS TYPE_SPECIFIC_OPTIONS SLAVE_OPTIONS IP_OPTIONS [-- ([+|-]<setting>.<property> <value>)+]\n\n"
 	              "  modify [--temporary] [id | uuid | path] <ID> ([+|-]<setting>.<property> <value>)+\n\n"
@@ -301,6 +303,14 @@ usage_connection_up (void)
 	              "Activate a connection on a device. The profile to activate is identified by its\n"
 	              "name, UUID or D-Bus path.\n"
 	              "\n"
+	              "ARGUMENTS := [id | uuid | path] <ID> [id | uuid | path <ID>] ... [from-file <file with IDs>] [max-parallel <num>] [passwd-file <file with passwords>]\n"
+	              "\n"
+	              "Activate several connections at once. The profiles are given on the command\n"
+	              "line and/or in a file, one per line. On the command line, all but the first\n"
+	              "one need the 'id', 'uuid' or 'path' keyword. At most <num> activations (16\n"
+	              "by default) run at the same time, and each is reported separately. 'ifname',\n"
+	              "'ap' and 'nsp' can't be used with several connections.\n"
+	              "\n"
 	              "ARGUMENTS := ifname <ifname> [ap <BSSID>] [nsp <name>] [passwd-file <file with passwords>]\n"
 	              "\n"
 	              "Activate a device with a connection. The connection profile is selected\n"
@@ -309,7 +319,9 @@ usage_connection_up (void)
 	              "ifname      - specifies the device to active the connection on\n"
 	              "ap          - specifies AP to connect to (only valid for Wi-Fi)\n"
 	              "nsp         - specifies NSP to connect to (only valid for WiMAX)\n"
-	              "passwd-file - file with password(s) required to activate the connection\n\n"));
+	              "passwd-file - file with password(s) required to activate the connection\n"
+	              "from-file   - file with the connections to activate\n"
+	              "max-parallel - number of connections activated at the same time\n\n"));
 }
 
 static void
@@ -854,96 +866,149 @@ find_active_connection (const GPtrArray *active_cons,
 	return found;
 }
 
+/* One line of 'nmcli connection show': a connection profile, possibly
+ * with its active connection, or an active connection whose profile isn't
+ * visible to us. Filled from the NMClient objects or, by
+ * do_connections_show_fast(), straight from D-Bus.
+ */
+typedef struct {
+	char *path;
+	char *id;
+	char *uuid;
+	char *type;
+	guint64 timestamp;
+	gboolean autoconnect;
+	gint32 autoconnect_priority;
+	gboolean read_only;
+
+	gboolean active;
+	NMActiveConnectionState ac_state;
+	char *ac_path;
+	char *ac_dev;
+} ConShowRow;
+
 static void
-fill_output_connection (NMConnection *connection, NmCli *nmc, gboolean active_only)
+con_show_row_free (gpointer data)
+{
+	ConShowRow *row = data;
+
+	g_free (row->path);
+	g_free (row->id);
+	g_free (row->uuid);
+	g_free (row->type);
+	g_free (row->ac_path);
+	g_free (row->ac_dev);
+	g_slice_free (ConShowRow, row);
+}
+
+static void
+con_show_row_set_active (ConShowRow *row, NMActiveConnection *ac)
+{
+	row->active = TRUE;
+	row->ac_state = nm_active_connection_get_state (ac);
+	row->ac_path = g_strdup (nm_object_get_path (NM_OBJECT (ac)));
+	row->ac_dev = get_ac_device_string (ac);
+}
+
+static ConShowRow *
+con_show_row_new_for_active (NMActiveConnection *ac)
+{
+	ConShowRow *row;
+
+	row = g_slice_new0 (ConShowRow);
+	row->id = g_strdup (nm_active_connection_get_id (ac));
+	row->uuid = g_strdup (nm_active_connection_get_uuid (ac));
+	row->type = g_strdup (nm_active_connection_get_connection_type (ac));
+	con_show_row_set_active (row, ac);
+	return row;
+}
+
+static ConShowRow *
+con_show_row_new (NMConnection *connection, const GPtrArray *active_cons)
 {
 	NMSettingConnection *s_con;
-	guint64 timestamp;
-	time_t timestamp_real;
-	char *timestamp_str;
-	char *timestamp_real_str = "";
-	char *prio_str;
-	NmcOutputField *arr;
-	NMActiveConnection *ac = NULL;
-	const char *ac_path = NULL;
-	const char *ac_state = NULL;
-	NMActiveConnectionState ac_state_int = NM_ACTIVE_CONNECTION_STATE_UNKNOWN;
-	char *ac_dev = NULL;
+	NMActiveConnection *ac;
+	ConShowRow *row;
 
 	s_con = nm_connection_get_setting_connection (connection);
 	g_assert (s_con);
 
-	ac = get_ac_for_connection (nm_client_get_active_connections (nmc->client), connection);
-	if (active_only && !ac)
-		return;
+	row = g_slice_new0 (ConShowRow);
+	row->path = g_strdup (nm_connection_get_path (connection));
+	row->id = g_strdup (nm_setting_connection_get_id (s_con));
+	row->uuid = g_strdup (nm_setting_connection_get_uuid (s_con));
+	row->type = g_strdup (nm_setting_connection_get_connection_type (s_con));
+	row->timestamp = nm_setting_connection_get_timestamp (s_con);
+	row->autoconnect = nm_setting_connection_get_autoconnect (s_con);
+	row->autoconnect_priority = nm_setting_connection_get_autoconnect_priority (s_con);
+	row->read_only = nm_setting_connection_get_read_only (s_con);
+
+	ac = get_ac_for_connection (active_cons, connection);
+	if (ac)
+		con_show_row_set_active (row, ac);
+	return row;
+}
 
-	if (ac) {
-		ac_path = nm_object_get_path (NM_OBJECT (ac));
-		ac_state_int = nm_active_connection_get_state (ac);
-		ac_state = active_connection_state_to_string (ac_state_int);
-		ac_dev = get_ac_device_string (ac);
-	}
+static void
+fill_output_connection (const ConShowRow *row, NmCli *nmc)
+{
+	time_t timestamp_real;
+	char *timestamp_str;
+	char *timestamp_real_str = "";
+	char *prio_str;
+	NmcOutputField *arr;
 
 	/* Obtain field values */
-	timestamp = nm_setting_connection_get_timestamp (s_con);
-	timestamp_str = g_strdup_printf ("%" G_GUINT64_FORMAT, timestamp);
-	if (timestamp) {
-		timestamp_real = timestamp;
+	timestamp_str = g_strdup_printf ("%" G_GUINT64_FORMAT, row->timestamp);
+	if (row->timestamp) {
+		timestamp_real = row->timestamp;
 		timestamp_real_str = g_malloc0 (64);
 		strftime (timestamp_real_str, 64, "%c", localtime (&timestamp_real));
 	}
-	prio_str = g_strdup_printf ("%u", nm_setting_connection_get_autoconnect_priority (s_con));
+	prio_str = g_strdup_printf ("%u", (guint) row->autoconnect_priority);
 
 	arr = nmc_dup_fields_array (nmc_fields_con_show,
 	                            sizeof (nmc_fields_con_show),
 	                            0);
 	/* Show active connections in color */
-	if (ac) {
-		if (ac_state_int == NM_ACTIVE_CONNECTION_STATE_ACTIVATING)
+	if (row->active) {
+		if (row->ac_state == NM_ACTIVE_CONNECTION_STATE_ACTIVATING)
 			set_val_color_all (arr, NMC_TERM_COLOR_YELLOW);
-		else if (ac_state_int == NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
+		else if (row->ac_state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
 			set_val_color_all (arr, NMC_TERM_COLOR_GREEN);
-		else if (ac_state_int > NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
+		else if (row->ac_state > NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
 			set_val_color_all (arr, NMC_TERM_COLOR_RED);
 	}
 
-	set_val_strc (arr, 0, nm_setting_connection_get_id (s_con));
-	set_val_strc (arr, 1, nm_setting_connection_get_uuid (s_con));
-	set_val_strc (arr, 2, nm_setting_connection_get_connection_type (s_con));
+	set_val_str  (arr, 0, g_strdup (row->id));
+	set_val_str  (arr, 1, g_strdup (row->uuid));
+	set_val_str  (arr, 2, g_strdup (row->type));
 	set_val_str  (arr, 3, timestamp_str);
-	set_val_str  (arr, 4, timestamp ? timestamp_real_str : g_strdup (_("never")));
-	set_val_strc (arr, 5, nm_setting_connection_get_autoconnect (s_con) ? _("yes") : _("no"));
+	set_val_str  (arr, 4, row->timestamp ? timestamp_real_str : g_strdup (_("never")));
+	set_val_strc (arr, 5, row->autoconnect ? _("yes") : _("no"));
 	set_val_str  (arr, 6, prio_str);
-	set_val_strc (arr, 7, nm_setting_connection_get_read_only (s_con) ? _("yes") : _("no"));
-	set_val_strc (arr, 8, nm_connection_get_path (connection));
-	set_val_strc (arr, 9, ac ? _("yes") : _("no"));
-	set_val_str  (arr, 10, ac_dev);
-	set_val_strc (arr, 11, ac_state);
-	set_val_strc (arr, 12, ac_path);
+	set_val_strc (arr, 7, row->read_only ? _("yes") : _("no"));
+	set_val_str  (arr, 8, g_strdup (row->path));
+	set_val_strc (arr, 9, row->active ? _("yes") : _("no"));
+	set_val_str  (arr, 10, g_strdup (row->ac_dev));
+	set_val_strc (arr, 11, row->active ? active_connection_state_to_string (row->ac_state) : NULL);
+	set_val_str  (arr, 12, g_strdup (row->ac_path));
 
-	g_ptr_array_add (nmc->output_data, arr);
+	print_data_row (nmc, arr);
 }
 
 static void
-fill_output_connection_for_invisible (NMActiveConnection *ac, NmCli *nmc)
+fill_output_connection_for_invisible (const ConShowRow *row, NmCli *nmc)
 {
 	NmcOutputField *arr;
-	const char *ac_path = NULL;
-	const char *ac_state = NULL;
-	char *name, *ac_dev = NULL;
-
-	name = g_strdup_printf ("<invisible> %s", nm_active_connection_get_id (ac));
-	ac_path = nm_object_get_path (NM_OBJECT (ac));
-	ac_state = active_connection_state_to_string (nm_active_connection_get_state (ac));
-	ac_dev = get_ac_device_string (ac);
 
 	arr = nmc_dup_fields_array (nmc_fields_con_show,
 	                            sizeof (nmc_fields_con_show),
 	                            0);
 
-	set_val_str  (arr, 0, name);
-	set_val_strc (arr, 1, nm_active_connection_get_uuid (ac));
-	set_val_strc (arr, 2, nm_active_connection_get_connection_type (ac));
+	set_val_str  (arr, 0, g_strdup_printf ("<invisible> %s", row->id));
+	set_val_str  (arr, 1, g_strdup (row->uuid));
+	set_val_str  (arr, 2, g_strdup (row->type));
 	set_val_strc (arr, 3, NULL);
 	set_val_strc (arr, 4, NULL);
 	set_val_strc (arr, 5, NULL);
@@ -951,13 +1016,13 @@ fill_output_connection_for_invisible (NMActiveConnection *ac, NmCli *nmc)
 	set_val_strc (arr, 7, NULL);
 	set_val_strc (arr, 8, NULL);
 	set_val_strc (arr, 9, _("yes"));
-	set_val_str  (arr, 10, ac_dev);
-	set_val_strc (arr, 11, ac_state);
-	set_val_strc (arr, 12, ac_path);
+	set_val_str  (arr, 10, g_strdup (row->ac_dev));
+	set_val_strc (arr, 11, active_connection_state_to_string (row->ac_state));
+	set_val_str  (arr, 12, g_strdup (row->ac_path));
 
 	set_val_color_fmt_all (arr, NMC_TERM_FORMAT_DIM);
 
-	g_ptr_array_add (nmc->output_data, arr);
+	print_data_row (nmc, arr);
 }
 
 static void
@@ -1427,18 +1492,12 @@ typedef enum {
 	NMC_SORT_PATH_INV   = -4,
 } NmcSortOrder;
 
-typedef struct {
-	NmCli *nmc;
-	const GArray *order;
-} NmcSortInfo;
-
 static int
 compare_connections (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-	NMConnection *ca = *(NMConnection **)a;
-	NMConnection *cb = *(NMConnection **)b;
-	NMActiveConnection *aca, *acb;
-	NmcSortInfo *info = (NmcSortInfo *) user_data;
+	const ConShowRow *ca = *(const ConShowRow **)a;
+	const ConShowRow *cb = *(const ConShowRow **)b;
+	const GArray *info_order = user_data;
 	GArray *default_order = NULL;
 	const GArray *order;
 	NmcSortOrder item;
@@ -1446,8 +1505,8 @@ compare_connections (gconstpointer a, gconstpointer b, gpointer user_data)
 	const char *tmp1, *tmp2;
 	unsigned long tmp1_int, tmp2_int;
 
-	if (info->order )
-		order = info->order;
+	if (info_order)
+		order = info_order;
 	else {
 		NmcSortOrder def[] = { NMC_SORT_ACTIVE, NMC_SORT_NAME, NMC_SORT_PATH };
 		int num = G_N_ELEMENTS (def);
@@ -1461,30 +1520,26 @@ compare_connections (gconstpointer a, gconstpointer b, gpointer user_data)
 		switch (item) {
 		case NMC_SORT_ACTIVE:
 		case NMC_SORT_ACTIVE_INV:
-			aca = get_ac_for_connection (nm_client_get_active_connections (info->nmc->client), ca);
-			acb = get_ac_for_connection (nm_client_get_active_connections (info->nmc->client), cb);
-			cmp = (aca && !acb) ? -1 : (!aca && acb) ? 1 : 0;
+			cmp = (ca->active && !cb->active) ? -1 : (!ca->active && cb->active) ? 1 : 0;
 			if (item == NMC_SORT_ACTIVE_INV)
 				cmp = -(cmp);
 			break;
 		case NMC_SORT_TYPE:
 		case NMC_SORT_TYPE_INV:
-			cmp = g_strcmp0 (nm_connection_get_connection_type (ca),
-			                 nm_connection_get_connection_type (cb));
+			cmp = g_strcmp0 (ca->type, cb->type);
 			if (item == NMC_SORT_TYPE_INV)
 				cmp = -(cmp);
 			break;
 		case NMC_SORT_NAME:
 		case NMC_SORT_NAME_INV:
-			cmp = g_strcmp0 (nm_connection_get_id (ca),
-			                 nm_connection_get_id (cb));
+			cmp = g_strcmp0 (ca->id, cb->id);
 			if (item == NMC_SORT_NAME_INV)
 				cmp = -(cmp);
 			break;
 		case NMC_SORT_PATH:
 		case NMC_SORT_PATH_INV:
-			tmp1 = nm_connection_get_path (ca);
-			tmp2 = nm_connection_get_path (cb);
+			tmp1 = ca->path;
+			tmp2 = cb->path;
 			tmp1 = tmp1 ? strrchr (tmp1, '/') : "0";
 			tmp2 = tmp2 ? strrchr (tmp2, '/') : "0";
 			nmc_string_to_uint (tmp1 ? tmp1+1 : "0", FALSE, 0, 0, &tmp1_int);
@@ -1506,45 +1561,49 @@ end:
 	return cmp;
 }
 
+/* Returns the rows of the connections in @cons (only the active ones if
+ * @active_only), sorted according to @order. */
 static GPtrArray *
-sort_connections (const GPtrArray *cons, NmCli *nmc, const GArray *order)
+sort_connections (const GPtrArray *cons, NmCli *nmc, const GArray *order, gboolean active_only)
 {
+	const GPtrArray *active_cons;
 	GPtrArray *sorted;
 	int i;
-	NmcSortInfo compare_info;
 
 	if (!cons)
 		return NULL;
 
-	compare_info.nmc = nmc;
-	compare_info.order = order;
+	active_cons = nm_client_get_active_connections (nmc->client);
+	sorted = g_ptr_array_new_full (cons->len, con_show_row_free);
+	for (i = 0; i < cons->len; i++) {
+		ConShowRow *row = con_show_row_new (cons->pdata[i], active_cons);
 
-	sorted = g_ptr_array_sized_new (cons->len);
-	for (i = 0; i < cons->len; i++)
-		g_ptr_array_add (sorted, cons->pdata[i]);
-	g_ptr_array_sort_with_data (sorted, compare_connections, &compare_info);
+		if (active_only && !row->active)
+			con_show_row_free (row);
+		else
+			g_ptr_array_add (sorted, row);
+	}
+	g_ptr_array_sort_with_data (sorted, compare_connections, (gpointer) order);
 	return sorted;
 }
 
 static int
 compare_ac_connections (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-	NMActiveConnection *ca = *(NMActiveConnection **)a;
-	NMActiveConnection *cb = *(NMActiveConnection **)b;
+	const ConShowRow *ca = *(const ConShowRow **)a;
+	const ConShowRow *cb = *(const ConShowRow **)b;
 	int cmp;
 
 	/* Sort states first */
-	cmp = nm_active_connection_get_state (cb) - nm_active_connection_get_state (ca);
+	cmp = (int) cb->ac_state - (int) ca->ac_state;
 	if (cmp != 0)
 		return cmp;
 
-	cmp = g_strcmp0 (nm_active_connection_get_id (ca),
-	                 nm_active_connection_get_id (cb));
+	cmp = g_strcmp0 (ca->id, cb->id);
 	if (cmp != 0)
 		return cmp;
 
-	return g_strcmp0 (nm_active_connection_get_connection_type (ca),
-	                  nm_active_connection_get_connection_type (cb));
+	return g_strcmp0 (ca->type, cb->type);
 }
 
 static GPtrArray *
@@ -1556,7 +1615,7 @@ get_invisible_active_connections (NmCli *nmc)
 
 	g_return_val_if_fail (nmc != NULL, NULL);
 
-	invisibles = g_ptr_array_new ();
+	invisibles = g_ptr_array_new_with_free_func (con_show_row_free);
 	acons = nm_client_get_active_connections (nmc->client);
 	for (a = 0; a < acons->len; a++) {
 		gboolean found = FALSE;
@@ -1574,12 +1633,44 @@ get_invisible_active_connections (NmCli *nmc)
 		}
 		/* Active connection is not in connections array, add it to  */
 		if (!found)
-			g_ptr_array_add (invisibles, acon);
+			g_ptr_array_add (invisibles, con_show_row_new_for_active (acon));
 	}
 	g_ptr_array_sort_with_data (invisibles, compare_ac_connections, NULL);
 	return invisibles;
 }
 
+static gboolean
+con_show_add_header (NmCli *nmc, gboolean active_only, GError **error)
+{
+	char *fields_str;
+	char *fields_all =    NMC_FIELDS_CON_SHOW_ALL;
+	char *fields_common = NMC_FIELDS_CON_SHOW_COMMON;
+	NmcOutputField *tmpl, *arr;
+	size_t tmpl_len;
+
+	if (!nmc->required_fields || strcasecmp (nmc->required_fields, "common") == 0)
+		fields_str = fields_common;
+	else if (!nmc->required_fields || strcasecmp (nmc->required_fields, "all") == 0)
+		fields_str = fields_all;
+	else
+		fields_str = nmc->required_fields;
+
+	tmpl = nmc_fields_con_show;
+	tmpl_len = sizeof (nmc_fields_con_show);
+	nmc->print_fields.indices = parse_output_fields (fields_str, tmpl, FALSE, NULL, error);
+	if (error && *error)
+		return FALSE;
+	if (!nmc_terse_option_check (nmc->print_output, nmc->required_fields, error))
+		return FALSE;
+
+	/* Add headers */
+	nmc->print_fields.header_name = active_only ? _("NetworkManager active profiles") :
+	                                              _("NetworkManager connection profiles");
+	arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
+	g_ptr_array_add (nmc->output_data, arr);
+	return TRUE;
+}
+
 static NMCResultCode
 do_connections_show (NmCli *nmc, gboolean active_only, gboolean show_secrets,
                      const GArray *order, int argc, char **argv)
@@ -1589,47 +1680,23 @@ do_connections_show (NmCli *nmc, gboolean active_only, gboolean show_secrets,
 	GPtrArray *invisibles, *sorted_cons;
 
 	if (argc == 0) {
-		char *fields_str;
-		char *fields_all =    NMC_FIELDS_CON_SHOW_ALL;
-		char *fields_common = NMC_FIELDS_CON_SHOW_COMMON;
-		NmcOutputField *tmpl, *arr;
-		size_t tmpl_len;
 		int i;
 
-		if (!nmc->required_fields || strcasecmp (nmc->required_fields, "common") == 0)
-			fields_str = fields_common;
-		else if (!nmc->required_fields || strcasecmp (nmc->required_fields, "all") == 0)
-			fields_str = fields_all;
-		else
-			fields_str = nmc->required_fields;
-
-		tmpl = nmc_fields_con_show;
-		tmpl_len = sizeof (nmc_fields_con_show);
-		nmc->print_fields.indices = parse_output_fields (fields_str, tmpl, FALSE, NULL, &err);
-		if (err) {
-			goto finish;
-		}
-		if (!nmc_terse_option_check (nmc->print_output, nmc->required_fields, &err))
+		if (!con_show_add_header (nmc, active_only, &err))
 			goto finish;
 
-		/* Add headers */
-		nmc->print_fields.header_name = active_only ? _("NetworkManager active profiles") :
-		                                              _("NetworkManager connection profiles");
-		arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-		g_ptr_array_add (nmc->output_data, arr);
-
 		/* There might be active connections not present in connection list
 		 * (e.g. private connections of a different user). Show them as well. */
 		invisibles = get_invisible_active_connections (nmc);
 		for (i = 0; i < invisibles->len; i++)
 			fill_output_connection_for_invisible (invisibles->pdata[i], nmc);
-		g_ptr_array_free (invisibles, TRUE);
+		g_ptr_array_unref (invisibles);
 
 		/* Sort the connections and fill the output data */
-		sorted_cons = sort_connections (nmc->connections, nmc, order);
+		sorted_cons = sort_connections (nmc->connections, nmc, order, active_only);
 		for (i = 0; i < sorted_cons->len; i++)
-			fill_output_connection (sorted_cons->pdata[i], nmc, active_only);
-		g_ptr_array_free (sorted_cons, TRUE);
+			fill_output_connection (sorted_cons->pdata[i], nmc);
+		g_ptr_array_unref (sorted_cons);
 
 		print_data (nmc);  /* Print all data */
 	} else {
@@ -2343,17 +2410,302 @@ nmc_activate_connection (NmCli *nmc,
 	return TRUE;
 }
 
+/* Activation of several connections at once, e.g.
+ * 'nmcli connection up uuid <UUID1> uuid <UUID2> ...' or 'from-file <file>'.
+ * At most max_parallel activations are in progress at any time; each one is
+ * waited for separately and reported on its own line.
+ */
+
+#define BULK_ACTIVATE_MAX_PARALLEL 16
+
+typedef struct {
+	NmCli *nmc;
+	GPtrArray *connections;
+	guint next;
+	guint running;
+	guint max_parallel;
+	guint failed;
+} BulkActivateInfo;
+
+typedef struct {
+	BulkActivateInfo *bulk;
+	NMConnection *connection;
+	NMActiveConnection *active;
+	NMDevice *device;
+	guint timeout_id;
+} BulkActivateItem;
+
+static void bulk_activate_start_next (BulkActivateInfo *bulk);
+static void bulk_activate_check_state (BulkActivateItem *item);
+
+static void
+bulk_activate_state_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	bulk_activate_check_state (user_data);
+}
+
+static void
+bulk_activate_item_done (BulkActivateItem *item, gboolean failed)
+{
+	BulkActivateInfo *bulk = item->bulk;
+
+	if (failed)
+		bulk->failed++;
+
+	nm_clear_g_source (&item->timeout_id);
+	if (item->device) {
+		g_signal_handlers_disconnect_by_func (item->device, bulk_activate_state_cb, item);
+		g_object_unref (item->device);
+	}
+	if (item->active) {
+		g_signal_handlers_disconnect_by_func (item->active, bulk_activate_state_cb, item);
+		g_object_unref (item->active);
+	}
+	g_object_unref (item->connection);
+	g_slice_free (BulkActivateItem, item);
+
+	bulk->running--;
+	bulk_activate_start_next (bulk);
+}
+
+static void
+bulk_activate_check_state (BulkActivateItem *item)
+{
+	NMActiveConnectionState state;
+	NMDeviceState dev_state;
+
+	state = nm_active_connection_get_state (item->active);
+	dev_state = item->device ? nm_device_get_state (item->device) : NM_DEVICE_STATE_UNKNOWN;
+
+	if (state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED) {
+		g_print (_("Connection '%s' successfully activated (D-Bus active path: %s)\n"),
+		         nm_connection_get_id (item->connection),
+		         nm_object_get_path (NM_OBJECT (item->active)));
+		bulk_activate_item_done (item, FALSE);
+	} else if (state == NM_ACTIVE_CONNECTION_STATE_DEACTIVATED) {
+		g_printerr (_("Error: Connection '%s' activation failed.\n"),
+		            nm_connection_get_id (item->connection));
+		bulk_activate_item_done (item, TRUE);
+	} else if (state == NM_ACTIVE_CONNECTION_STATE_ACTIVATING && item->device) {
+		/* Masters don't progress beyond ACTIVATING without slaves, see
+		 * active_connection_state_cb(). */
+		if (   dev_state >= NM_DEVICE_STATE_IP_CONFIG
+		    && dev_state <= NM_DEVICE_STATE_ACTIVATED) {
+			g_print (_("Connection '%s' successfully activated (master waiting for slaves) (D-Bus active path: %s)\n"),
+			         nm_connection_get_id (item->connection),
+			         nm_object_get_path (NM_OBJECT (item->active)));
+			bulk_activate_item_done (item, FALSE);
+		} else if (dev_state == NM_DEVICE_STATE_FAILED) {
+			g_printerr (_("Error: Connection '%s' activation failed.\n"),
+			            nm_connection_get_id (item->connection));
+			bulk_activate_item_done (item, TRUE);
+		}
+	}
+}
+
+static gboolean
+bulk_activate_timeout_cb (gpointer user_data)
+{
+	BulkActivateItem *item = user_data;
+
+	item->timeout_id = 0;
+	g_printerr (_("Error: Connection '%s' activation timed out after %d sec.\n"),
+	            nm_connection_get_id (item->connection), item->bulk->nmc->timeout);
+	bulk_activate_item_done (item, TRUE);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+bulk_activate_cb (GObject *client, GAsyncResult *result, gpointer user_data)
+{
+	BulkActivateItem *item = user_data;
+	NmCli *nmc = item->bulk->nmc;
+	NMActiveConnection *active;
+	const GPtrArray *ac_devs;
+	NMDevice *device;
+	GError *error = NULL;
+
+	active = nm_client_activate_connection_finish (NM_CLIENT (client), result, &error);
+	if (!active) {
+		g_printerr (_("Error: Connection '%s' activation failed: %s\n"),
+		            nm_connection_get_id (item->connection), error->message);
+		g_error_free (error);
+		bulk_activate_item_done (item, TRUE);
+		return;
+	}
+	item->active = active;
+
+	if (nmc->nowait_flag) {
+		/* User doesn't want to wait */
+		if (nm_active_connection_get_state (active) == NM_ACTIVE_CONNECTION_STATE_ACTIVATED) {
+			g_print (_("Connection '%s' successfully activated (D-Bus active path: %s)\n"),
+			         nm_connection_get_id (item->connection),
+			         nm_object_get_path (NM_OBJECT (active)));
+		}
+		bulk_activate_item_done (item, FALSE);
+		return;
+	}
+
+	ac_devs = nm_active_connection_get_devices (active);
+	device = ac_devs->len > 0 ? g_ptr_array_index (ac_devs, 0) : NULL;
+	if (   device
+	    && (   NM_IS_DEVICE_BOND (device)
+	        || NM_IS_DEVICE_TEAM (device)
+	        || NM_IS_DEVICE_BRIDGE (device))) {
+		item->device = g_object_ref (device);
+		g_signal_connect (device, "notify::" NM_DEVICE_STATE, G_CALLBACK (bulk_activate_state_cb), item);
+	}
+	g_signal_connect (active, "notify::" NM_ACTIVE_CONNECTION_STATE, G_CALLBACK (bulk_activate_state_cb), item);
+
+	/* Don't wait forever when signals are not emitted */
+	item->timeout_id = g_timeout_add_seconds (nmc->timeout, bulk_activate_timeout_cb, item);
+
+	bulk_activate_check_state (item);
+}
+
+static void
+bulk_activate_start_next (BulkActivateInfo *bulk)
+{
+	NmCli *nmc = bulk->nmc;
+
+	while (   bulk->running < bulk->max_parallel
+	       && bulk->next < bulk->connections->len) {
+		BulkActivateItem *item;
+
+		item = g_slice_new0 (BulkActivateItem);
+		item->bulk = bulk;
+		item->connection = g_object_ref (bulk->connections->pdata[bulk->next++]);
+		bulk->running++;
+
+		nm_client_activate_connection_async (nmc->client,
+		                                     item->connection,
+		                                     NULL,
+		                                     NULL,
+		                                     NULL,
+		                                     bulk_activate_cb,
+		                                     item);
+	}
+
+	if (bulk->running > 0 || bulk->next < bulk->connections->len)
+		return;
+
+	/* All activations are done */
+	if (bulk->failed) {
+		g_string_printf (nmc->return_text, _("Error: %u of %u connections failed to activate."),
+		                 bulk->failed, bulk->connections->len);
+		nmc->return_value = NMC_RESULT_ERROR_CON_ACTIVATION;
+	}
+	g_ptr_array_unref (bulk->connections);
+	g_slice_free (BulkActivateInfo, bulk);
+	quit ();
+}
+
+static gboolean
+nmc_activate_connections (NmCli *nmc,
+                          GPtrArray *connections,
+                          guint max_parallel,
+                          const char *pwds,
+                          GError **error)
+{
+	BulkActivateInfo *bulk;
+	GHashTable *pwds_hash;
+	GError *local = NULL;
+
+	/* Parse passwords given in passwords file */
+	pwds_hash = parse_passwords (pwds, &local);
+	if (local) {
+		g_propagate_error (error, local);
+		return FALSE;
+	}
+	if (nmc->pwds_hash)
+		g_hash_table_destroy (nmc->pwds_hash);
+	nmc->pwds_hash = pwds_hash;
+
+	/* Create secret agent, serving requests for all the connections */
+	nmc->secret_agent = nm_secret_agent_simple_new ("nmcli-connect");
+	if (nmc->secret_agent) {
+		g_signal_connect (nmc->secret_agent, "request-secrets", G_CALLBACK (nmc_secrets_requested), nmc);
+		nm_secret_agent_simple_enable (NM_SECRET_AGENT_SIMPLE (nmc->secret_agent), NULL);
+	}
+
+	bulk = g_slice_new0 (BulkActivateInfo);
+	bulk->nmc = nmc;
+	bulk->connections = g_ptr_array_ref (connections);
+	bulk->max_parallel = max_parallel;
+	bulk_activate_start_next (bulk);
+	return TRUE;
+}
+
+static gboolean
+add_connection_to_activate (NmCli *nmc,
+                            GPtrArray *connections,
+                            const char *selector,
+                            const char *name)
+{
+	NMConnection *connection;
+	guint i;
+
+	connection = nmc_find_connection (nmc->connections, selector, name, NULL);
+	if (!connection) {
+		g_string_printf (nmc->return_text, _("Error: Connection '%s' does not exist."), name);
+		nmc->return_value = NMC_RESULT_ERROR_NOT_FOUND;
+		return FALSE;
+	}
+	/* Activating the same connection repeatedly would only keep the last one */
+	for (i = 0; i < connections->len; i++) {
+		if (connections->pdata[i] == connection)
+			return TRUE;
+	}
+	g_ptr_array_add (connections, g_object_ref (connection));
+	return TRUE;
+}
+
+static gboolean
+add_connections_from_file (NmCli *nmc, GPtrArray *connections, const char *filename)
+{
+	char *contents = NULL;
+	char **lines, **iter;
+	GError *error = NULL;
+	gboolean success = TRUE;
+
+	if (!g_file_get_contents (filename, &contents, NULL, &error)) {
+		g_string_printf (nmc->return_text, _("Error: failed to read '%s': %s."),
+		                 filename, error->message);
+		nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+		g_error_free (error);
+		return FALSE;
+	}
+
+	/* One connection ID, UUID or D-Bus path per line */
+	lines = nmc_strsplit_set (contents, "\r\n", -1);
+	for (iter = lines; *iter; iter++) {
+		g_strstrip (*iter);
+		if (!**iter || **iter == '#')
+			continue;
+		if (!add_connection_to_activate (nmc, connections, NULL, *iter)) {
+			success = FALSE;
+			break;
+		}
+	}
+	g_strfreev (lines);
+	g_free (contents);
+	return success;
+}
+
 static NMCResultCode
 do_connection_up (NmCli *nmc, int argc, char **argv)
 {
 	NMConnection *connection = NULL;
+	GPtrArray *connections;
 	const char *ifname = NULL;
 	const char *ap = NULL;
 	const char *nsp = NULL;
 	const char *pwds = NULL;
+	const char *from_file = NULL;
+	unsigned long max_parallel = BULK_ACTIVATE_MAX_PARALLEL;
 	GError *error = NULL;
 	const char *selector = NULL;
-	const char *name = NULL;
+	const char *name;
 	char *line = NULL;
 
 	/*
@@ -2363,10 +2715,14 @@ do_connection_up (NmCli *nmc, int argc, char **argv)
 	if (nmc->timeout == -1)
 		nmc->timeout = 90;
 
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+
 	if (argc == 0) {
 		if (nmc->ask) {
 			line = nmc_readline (PROMPT_CONNECTION);
 			name = line ? line : "";
+			if (!add_connection_to_activate (nmc, connections, NULL, name))
+				goto error;
 		}
 	} else if (strcmp (*argv, "ifname") != 0) {
 		if (   strcmp (*argv, "id") == 0
@@ -2379,19 +2735,10 @@ do_connection_up (NmCli *nmc, int argc, char **argv)
 				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
 				goto error;
 			}
-			name = *argv;
 		}
-		name = *argv;
-		next_arg (&argc, &argv);
-	}
-
-	if (name) {
-		connection = nmc_find_connection (nmc->connections, selector, name, NULL);
-		if (!connection) {
-			g_string_printf (nmc->return_text, _("Error: Connection '%s' does not exist."), name);
-			nmc->return_value = NMC_RESULT_ERROR_NOT_FOUND;
+		if (!add_connection_to_activate (nmc, connections, selector, *argv))
 			goto error;
-		}
+		next_arg (&argc, &argv);
 	}
 
 	while (argc > 0) {
@@ -2422,6 +2769,54 @@ do_connection_up (NmCli *nmc, int argc, char **argv)
 
 			pwds = *argv;
 		}
+		else if (strcmp (*argv, "from-file") == 0) {
+			if (next_arg (&argc, &argv) != 0) {
+				g_string_printf (nmc->return_text, _("Error: %s argument is missing."), *(argv-1));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto error;
+			}
+
+			from_file = *argv;
+			if (!add_connections_from_file (nmc, connections, from_file))
+				goto error;
+		}
+		else if (strcmp (*argv, "max-parallel") == 0) {
+			if (next_arg (&argc, &argv) != 0) {
+				g_string_printf (nmc->return_text, _("Error: %s argument is missing."), *(argv-1));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto error;
+			}
+
+			if (!nmc_string_to_uint (*argv, TRUE, 1, G_MAXUINT, &max_parallel)) {
+				g_string_printf (nmc->return_text, _("Error: '%s' is not a valid 'max-parallel' value."), *argv);
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto error;
+			}
+		}
+		else if (strcmp (*argv, "nsp") == 0) {
+			if (next_arg (&argc, &argv) != 0) {
+				g_string_printf (nmc->return_text, _("Error: %s argument is missing."), *(argv-1));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto error;
+			}
+
+			nsp = *argv;
+		}
+		else if (   strcmp (*argv, "id") == 0
+		         || strcmp (*argv, "uuid") == 0
+		         || strcmp (*argv, "path") == 0) {
+			/* Further connections to activate; unlike the first one,
+			 * these always need the selector, so that a mistyped
+			 * parameter isn't taken for a connection name. */
+			selector = *argv;
+			if (next_arg (&argc, &argv) != 0) {
+				g_string_printf (nmc->return_text, _("Error: %s argument is missing."), selector);
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto error;
+			}
+			if (!add_connection_to_activate (nmc, connections, selector, *argv))
+				goto error;
+		}
 		else {
 			g_printerr (_("Unknown parameter: %s\n"), *argv);
 		}
@@ -2435,6 +2830,33 @@ do_connection_up (NmCli *nmc, int argc, char **argv)
 	 * and we can follow activation progress.
 	 */
 	nmc->nowait_flag = (nmc->timeout == 0);
+
+	if (connections->len > 1 || from_file) {
+		if (ifname || ap || nsp) {
+			g_string_printf (nmc->return_text, _("Error: 'ifname', 'ap' and 'nsp' can't be used when activating multiple connections."));
+			nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+			goto error;
+		}
+		if (connections->len == 0) {
+			g_string_printf (nmc->return_text, _("Error: No connection specified."));
+			nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+			goto error;
+		}
+
+		nmc->should_wait++;
+		if (!nmc_activate_connections (nmc, connections, max_parallel, pwds, &error)) {
+			g_string_printf (nmc->return_text, _("Error: %s."),
+			                 error->message);
+			nmc->return_value = error->code;
+			g_clear_error (&error);
+			nmc->should_wait--;
+		}
+		goto error;
+	}
+
+	if (connections->len == 1)
+		connection = connections->pdata[0];
+
 	nmc->should_wait++;
 
 	if (!nmc_activate_connection (nmc, connection, ifname, ap, nsp, pwds, activate_connection_cb, &error)) {
@@ -2451,6 +2873,7 @@ do_connection_up (NmCli *nmc, int argc, char **argv)
 		progress_id = g_timeout_add (120, progress_cb, _("preparing"));
 
 error:
+	g_ptr_array_unref (connections);
 	g_free (line);
 	return nmc->return_value;
 }
@@ -11016,6 +11439,281 @@ parse_preferred_connection_order (const char *order, GError **error)
 	return order_arr;
 }
 
+/*****************************************************************************/
+
+/* 'nmcli connection show' without arguments only needs a handful of
+ * properties. Fetch them with a few direct D-Bus calls instead of building
+ * the whole NMClient object graph, which costs several calls per device,
+ * access point, IP configuration and connection.
+ */
+
+typedef struct {
+	char *con_path;
+	ConShowRow *row;
+} FastActive;
+
+static void
+fast_active_free (gpointer data)
+{
+	FastActive *ac = data;
+
+	g_free (ac->con_path);
+	if (ac->row)
+		con_show_row_free (ac->row);
+	g_slice_free (FastActive, ac);
+}
+
+static GVariant *
+fast_get_property (GDBusConnection *bus, const char *path,
+                   const char *interface, const char *property)
+{
+	GVariant *ret, *value;
+
+	ret = g_dbus_connection_call_sync (bus,
+	                                   NM_DBUS_SERVICE,
+	                                   path,
+	                                   DBUS_INTERFACE_PROPERTIES,
+	                                   "Get",
+	                                   g_variant_new ("(ss)", interface, property),
+	                                   G_VARIANT_TYPE ("(v)"),
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1, NULL, NULL);
+	if (!ret)
+		return NULL;
+	g_variant_get (ret, "(v)", &value);
+	g_variant_unref (ret);
+	return value;
+}
+
+static char *
+fast_get_devices_string (GDBusConnection *bus, GVariant *devices, GHashTable *ifaces)
+{
+	GString *dev_str;
+	GVariantIter iter;
+	const char *dev_path;
+
+	dev_str = g_string_new (NULL);
+	g_variant_iter_init (&iter, devices);
+	while (g_variant_iter_next (&iter, "&o", &dev_path)) {
+		char *iface;
+
+		if (!g_hash_table_lookup_extended (ifaces, dev_path, NULL, (gpointer *) &iface)) {
+			GVariant *value;
+
+			value = fast_get_property (bus, dev_path, NM_DBUS_INTERFACE_DEVICE, "Interface");
+			iface = NULL;
+			if (value && g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
+				iface = g_variant_dup_string (value, NULL);
+			if (value)
+				g_variant_unref (value);
+			g_hash_table_insert (ifaces, g_strdup (dev_path), iface);
+		}
+		if (iface) {
+			g_string_append (dev_str, iface);
+			g_string_append_c (dev_str, ',');
+		}
+	}
+	if (dev_str->len > 0)
+		g_string_truncate (dev_str, dev_str->len - 1);  /* Cut off last ',' */
+
+	return g_string_free (dev_str, FALSE);
+}
+
+static GPtrArray *
+fast_get_active_connections (GDBusConnection *bus)
+{
+	GPtrArray *active;
+	GVariant *paths;
+	GVariantIter iter;
+	const char *ac_path;
+	GHashTable *ifaces;
+
+	paths = fast_get_property (bus, NM_DBUS_PATH, NM_DBUS_INTERFACE, "ActiveConnections");
+	if (!paths)
+		return NULL;
+	if (!g_variant_is_of_type (paths, G_VARIANT_TYPE_OBJECT_PATH_ARRAY)) {
+		g_variant_unref (paths);
+		return NULL;
+	}
+
+	active = g_ptr_array_new_with_free_func (fast_active_free);
+	ifaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	g_variant_iter_init (&iter, paths);
+	while (g_variant_iter_next (&iter, "&o", &ac_path)) {
+		GVariant *ret, *props, *devices;
+		FastActive *ac;
+		guint32 state = NM_ACTIVE_CONNECTION_STATE_UNKNOWN;
+
+		ret = g_dbus_connection_call_sync (bus,
+		                                   NM_DBUS_SERVICE,
+		                                   ac_path,
+		                                   DBUS_INTERFACE_PROPERTIES,
+		                                   "GetAll",
+		                                   g_variant_new ("(s)", NM_DBUS_INTERFACE_ACTIVE_CONNECTION),
+		                                   G_VARIANT_TYPE ("(a{sv})"),
+		                                   G_DBUS_CALL_FLAGS_NONE,
+		                                   -1, NULL, NULL);
+		/* The active connection may have gone away in the meantime */
+		if (!ret)
+			continue;
+		props = g_variant_get_child_value (ret, 0);
+
+		ac = g_slice_new0 (FastActive);
+		ac->row = g_slice_new0 (ConShowRow);
+		ac->row->active = TRUE;
+		ac->row->ac_path = g_strdup (ac_path);
+		g_variant_lookup (props, "Connection", "o", &ac->con_path);
+		g_variant_lookup (props, "Id", "s", &ac->row->id);
+		g_variant_lookup (props, "Uuid", "s", &ac->row->uuid);
+		g_variant_lookup (props, "Type", "s", &ac->row->type);
+		g_variant_lookup (props, "State", "u", &state);
+		ac->row->ac_state = state;
+		devices = g_variant_lookup_value (props, "Devices", G_VARIANT_TYPE_OBJECT_PATH_ARRAY);
+		if (devices) {
+			ac->row->ac_dev = fast_get_devices_string (bus, devices, ifaces);
+			g_variant_unref (devices);
+		} else
+			ac->row->ac_dev = g_strdup ("");
+		g_ptr_array_add (active, ac);
+
+		g_variant_unref (props);
+		g_variant_unref (ret);
+	}
+
+	g_hash_table_unref (ifaces);
+	g_variant_unref (paths);
+	return active;
+}
+
+/*
+ * Print the connection list like do_connections_show() does without
+ * arguments. Returns FALSE without printing anything when the data can't
+ * be obtained this way (NetworkManager not running, a daemon without
+ * GetAllSettings, ...); the caller then takes the regular path, which also
+ * reports the error.
+ */
+static gboolean
+do_connections_show_fast (NmCli *nmc)
+{
+	GDBusConnection *bus;
+	GVariant *ret = NULL, *all, *settings;
+	GPtrArray *active = NULL, *cons = NULL, *invisibles = NULL;
+	GVariantIter iter;
+	const char *con_path;
+	GError *error = NULL;
+	gboolean success = FALSE;
+	int i, j;
+
+	bus = g_bus_get_sync (g_getenv ("LIBNM_USE_SESSION_BUS") ? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM,
+	                      NULL, NULL);
+	if (!bus)
+		return FALSE;
+
+	active = fast_get_active_connections (bus);
+	if (!active)
+		goto out;
+
+	ret = g_dbus_connection_call_sync (bus,
+	                                   NM_DBUS_SERVICE,
+	                                   NM_DBUS_PATH_SETTINGS,
+	                                   NM_DBUS_INTERFACE_SETTINGS,
+	                                   "GetAllSettings",
+	                                   g_variant_new ("(a{sv}u)", NULL, (guint32) 0),
+	                                   G_VARIANT_TYPE ("(a(oa{sa{sv}})u)"),
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1, NULL, NULL);
+	if (!ret)
+		goto out;
+
+	cons = g_ptr_array_new_with_free_func (con_show_row_free);
+	all = g_variant_get_child_value (ret, 0);
+	g_variant_iter_init (&iter, all);
+	while (g_variant_iter_next (&iter, "(&o@a{sa{sv}})", &con_path, &settings)) {
+		GVariant *s_con;
+		ConShowRow *con;
+
+		s_con = g_variant_lookup_value (settings, NM_SETTING_CONNECTION_SETTING_NAME, NM_VARIANT_TYPE_SETTING);
+		g_variant_unref (settings);
+		if (!s_con)
+			continue;
+
+		con = g_slice_new0 (ConShowRow);
+		con->path = g_strdup (con_path);
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_ID, "s", &con->id);
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_UUID, "s", &con->uuid);
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_TYPE, "s", &con->type);
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_TIMESTAMP, "t", &con->timestamp);
+		if (!g_variant_lookup (s_con, NM_SETTING_CONNECTION_AUTOCONNECT, "b", &con->autoconnect))
+			con->autoconnect = TRUE;
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, "i", &con->autoconnect_priority);
+		g_variant_lookup (s_con, NM_SETTING_CONNECTION_READ_ONLY, "b", &con->read_only);
+		g_variant_unref (s_con);
+
+		for (j = 0; j < active->len; j++) {
+			FastActive *ac = active->pdata[j];
+
+			if (g_strcmp0 (ac->con_path, con->path) == 0) {
+				con->active = TRUE;
+				con->ac_state = ac->row->ac_state;
+				con->ac_path = g_strdup (ac->row->ac_path);
+				con->ac_dev = g_strdup (ac->row->ac_dev);
+				break;
+			}
+		}
+		g_ptr_array_add (cons, con);
+	}
+	g_variant_unref (all);
+
+	success = TRUE;
+	if (!con_show_add_header (nmc, FALSE, &error)) {
+		g_string_printf (nmc->return_text, _("Error: %s."), error->message);
+		nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+		g_error_free (error);
+		goto out;
+	}
+
+	/* There might be active connections not present in connection list
+	 * (e.g. private connections of a different user). Show them as well. */
+	invisibles = g_ptr_array_new_with_free_func (con_show_row_free);
+	for (i = 0; i < active->len; i++) {
+		FastActive *ac = active->pdata[i];
+
+		for (j = 0; j < cons->len; j++) {
+			ConShowRow *con = cons->pdata[j];
+
+			if (g_strcmp0 (ac->row->uuid, con->uuid) == 0)
+				break;
+		}
+		if (j == cons->len) {
+			g_ptr_array_add (invisibles, ac->row);
+			ac->row = NULL;
+		}
+	}
+	g_ptr_array_sort_with_data (invisibles, compare_ac_connections, NULL);
+	for (i = 0; i < invisibles->len; i++)
+		fill_output_connection_for_invisible (invisibles->pdata[i], nmc);
+
+	/* Sort the connections and fill the output data */
+	g_ptr_array_sort_with_data (cons, compare_connections, NULL);
+	for (i = 0; i < cons->len; i++)
+		fill_output_connection (cons->pdata[i], nmc);
+
+	print_data (nmc);  /* Print all data */
+
+out:
+	if (invisibles)
+		g_ptr_array_unref (invisibles);
+	if (cons)
+		g_ptr_array_unref (cons);
+	if (active)
+		g_ptr_array_unref (active);
+	if (ret)
+		g_variant_unref (ret);
+	g_object_unref (bus);
+	return success;
+}
+
 /* Entry point function for connections-related commands: 'nmcli connection' */
 NMCResultCode
 do_connections (NmCli *nmc, int argc, char **argv)
@@ -11038,6 +11736,11 @@ do_connections (NmCli *nmc, int argc, char **argv)
 			return nmc->return_value;
 	}
 
+	/* Listing the profiles doesn't need the NMClient object graph */
+	if (   (argc == 0 || (argc == 1 && matches (*argv, "show") == 0))
+	    && do_connections_show_fast (nmc))
+		return nmc->return_value;
+
 	/* Get NMClient object early */
 	nmc->get_client (nmc);
 
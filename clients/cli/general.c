@@ -22,6 +22,7 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "nm-dbus-compat.h"
 #include "polkit-agent.h"
 #include "utils.h"
 #include "general.h"
@@ -74,6 +75,16 @@ static NmcOutputField nmc_fields_nm_logging[] = {
 #define NMC_FIELDS_NM_LOGGING_ALL     "LEVEL,DOMAINS"
 #define NMC_FIELDS_NM_LOGGING_COMMON  "LEVEL,DOMAINS"
 
+/* Available fields for 'general memory' */
+static NmcOutputField nmc_fields_nm_memory[] = {
+	{"SUBSYSTEM", N_("SUBSYSTEM")},  /* 0 */
+	{"OBJECTS",   N_("OBJECTS")},    /* 1 */
+	{"BYTES",     N_("BYTES")},      /* 2 */
+	{NULL, NULL}
+};
+#define NMC_FIELDS_NM_MEMORY_ALL     "SUBSYSTEM,OBJECTS,BYTES"
+#define NMC_FIELDS_NM_MEMORY_COMMON  "SUBSYSTEM,OBJECTS,BYTES"
+
 
 /* glib main loop variable - defined in nmcli.c */
 extern GMainLoop *loop;
@@ -83,11 +94,12 @@ static void
 usage_general (void)
 {
 	g_printerr (_("Usage: nmcli general { COMMAND | help }\n\n"
-	              "COMMAND := { status | hostname | permissions | logging }\n\n"
+	              "COMMAND := { status | hostname | permissions | logging | memory }\n\n"
 	              "  status\n\n"
 	              "  hostname [<hostname>]\n\n"
 	              "  permissions\n\n"
-	              "  logging [level <log level>] [domains <log domains>]\n\n"));
+	              "  logging [level <log level>] [domains <log domains>]\n\n"
+	              "  memory\n\n"));
 }
 
 static void
@@ -132,6 +144,15 @@ usage_general_logging (void)
 	              "for the list of possible logging domains.\n\n"));
 }
 
+static void
+usage_general_memory (void)
+{
+	g_printerr (_("Usage: nmcli general memory { help }\n"
+	              "\n"
+	              "Show the number and size of the objects NetworkManager keeps,\n"
+	              "by subsystem.\n\n"));
+}
+
 static void
 usage_networking (void)
 {
@@ -212,10 +233,14 @@ usage_radio_wwan (void)
 static void
 usage_monitor (void)
 {
-	g_printerr (_("Usage: nmcli monitor\n"
+	g_printerr (_("Usage: nmcli monitor [--stats [<seconds>]]\n"
 	              "\n"
 	              "Monitor NetworkManager changes.\n"
-	              "Prints a line whenever a change occurs in NetworkManager\n\n"));
+	              "Prints a line whenever a change occurs in NetworkManager\n"
+	              "\n"
+	              "With --stats, prints every second the rate of the D-Bus signals\n"
+	              "NetworkManager emitted in the last <seconds> (10 by default), and the\n"
+	              "interfaces, objects and properties emitting most of them.\n\n"));
 }
 
 /* quit main loop */
@@ -553,6 +578,87 @@ show_general_logging (NmCli *nmc)
 	return TRUE;
 }
 
+static gboolean
+show_general_memory (NmCli *nmc)
+{
+	GError *error = NULL;
+	const char *fields_str;
+	const char *fields_all =    NMC_FIELDS_NM_MEMORY_ALL;
+	const char *fields_common = NMC_FIELDS_NM_MEMORY_COMMON;
+	NmcOutputField *tmpl, *arr;
+	size_t tmpl_len;
+	GDBusConnection *bus;
+	GVariant *ret;
+	GVariantIter *iter;
+	const char *name;
+	guint64 objects, bytes;
+
+	if (!nmc->required_fields || strcasecmp (nmc->required_fields, "common") == 0)
+		fields_str = fields_common;
+	else if (!nmc->required_fields || strcasecmp (nmc->required_fields, "all") == 0)
+		fields_str = fields_all;
+	else
+		fields_str = nmc->required_fields;
+
+	tmpl = nmc_fields_nm_memory;
+	tmpl_len = sizeof (nmc_fields_nm_memory);
+	nmc->print_fields.indices = parse_output_fields (fields_str, tmpl, FALSE, NULL, &error);
+
+	if (error) {
+		g_string_printf (nmc->return_text, _("Error: 'general memory': %s"), error->message);
+		g_error_free (error);
+		nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+		return FALSE;
+	}
+
+	/* libnm has no API for the statistics interface, call it directly. */
+	bus = g_bus_get_sync (g_getenv ("LIBNM_USE_SESSION_BUS") ? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM,
+	                      NULL, &error);
+	if (!bus) {
+		g_string_printf (nmc->return_text, _("Error: could not connect to D-Bus: %s."), error->message);
+		nmc->return_value = NMC_RESULT_ERROR_UNKNOWN;
+		g_error_free (error);
+		return FALSE;
+	}
+
+	ret = g_dbus_connection_call_sync (bus,
+	                                   NM_DBUS_SERVICE,
+	                                   NM_DBUS_PATH_STATISTICS,
+	                                   NM_DBUS_INTERFACE_STATISTICS,
+	                                   "GetMemory",
+	                                   NULL,
+	                                   G_VARIANT_TYPE ("(a{s(tt)})"),
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1, NULL, &error);
+	g_object_unref (bus);
+	if (!ret) {
+		g_dbus_error_strip_remote_error (error);
+		g_string_printf (nmc->return_text, _("Error: %s."), error->message);
+		nmc->return_value = NMC_RESULT_ERROR_UNKNOWN;
+		g_error_free (error);
+		return FALSE;
+	}
+
+	nmc->print_fields.header_name = _("NetworkManager memory");
+	arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
+	g_ptr_array_add (nmc->output_data, arr);
+
+	g_variant_get (ret, "(a{s(tt)})", &iter);
+	while (g_variant_iter_next (iter, "{&s(tt)}", &name, &objects, &bytes)) {
+		arr = nmc_dup_fields_array (tmpl, tmpl_len, 0);
+		set_val_str (arr, 0, g_strdup (name));
+		set_val_str (arr, 1, g_strdup_printf ("%" G_GUINT64_FORMAT, objects));
+		set_val_str (arr, 2, g_strdup_printf ("%" G_GUINT64_FORMAT, bytes));
+		g_ptr_array_add (nmc->output_data, arr);
+	}
+	g_variant_iter_free (iter);
+
+	print_data (nmc);  /* Print all data */
+
+	g_variant_unref (ret);
+	return TRUE;
+}
+
 static void
 save_hostname_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -681,6 +787,18 @@ do_general (NmCli *nmc, int argc, char **argv)
 				}
 			}
 		}
+		else if (matches (*argv, "memory") == 0) {
+			if (nmc_arg_is_help (*(argv+1))) {
+				usage_general_memory ();
+				goto finish;
+			}
+			if (!nmc_terse_option_check (nmc->print_output, nmc->required_fields, &error)) {
+				g_string_printf (nmc->return_text, _("Error: %s."), error->message);
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				goto finish;
+			}
+			show_general_memory (nmc);
+		}
 		else {
 			usage_general ();
 			g_string_printf (nmc->return_text, _("Error: 'general' command '%s' is not valid."), *argv);
@@ -973,9 +1091,238 @@ client_state (NMClient *client, GParamSpec *param, NmCli *nmc)
 	g_free (str);
 }
 
+/*****************************************************************************/
+
+/* 'nmcli monitor --stats': count the signals NetworkManager emits, per
+ * interface, per object and per property, over a sliding window of
+ * MonitorStats.window seconds. All signals are received through one
+ * subscription (a single match rule on the sender) rather than through
+ * NMClient objects.
+ */
+
+#define MONITOR_STATS_WINDOW_DEFAULT 10
+#define MONITOR_STATS_TOP            5
+
+typedef struct {
+	guint total;
+	guint buckets[];
+} MonitorStatsCounter;
+
+typedef struct {
+	guint window;
+	guint bucket;
+	guint seconds;
+	MonitorStatsCounter *events;
+	GHashTable *interfaces;
+	GHashTable *objects;
+	GHashTable *properties;
+} MonitorStats;
+
+static MonitorStatsCounter *
+monitor_stats_counter_new (MonitorStats *stats)
+{
+	return g_malloc0 (sizeof (MonitorStatsCounter) + stats->window * sizeof (guint));
+}
+
+static void
+monitor_stats_count (MonitorStats *stats, GHashTable *table, const char *name)
+{
+	MonitorStatsCounter *counter;
+
+	counter = g_hash_table_lookup (table, name);
+	if (!counter) {
+		counter = monitor_stats_counter_new (stats);
+		g_hash_table_insert (table, g_strdup (name), counter);
+	}
+	counter->buckets[stats->bucket]++;
+	counter->total++;
+}
+
+static void
+monitor_stats_count_properties (MonitorStats *stats, const char *interface, GVariant *props)
+{
+	GVariantIter iter;
+	const char *name;
+
+	g_variant_iter_init (&iter, props);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, NULL)) {
+		char *key = g_strdup_printf ("%s.%s", interface, name);
+
+		monitor_stats_count (stats, stats->properties, key);
+		g_free (key);
+	}
+}
+
+static void
+monitor_stats_signal_cb (GDBusConnection *connection,
+                         const char *sender_name,
+                         const char *object_path,
+                         const char *interface_name,
+                         const char *signal_name,
+                         GVariant *parameters,
+                         gpointer user_data)
+{
+	MonitorStats *stats = user_data;
+	const char *interface = interface_name;
+	GVariant *props = NULL;
+
+	/* Account property changes to the interface that owns the properties */
+	if (strcmp (signal_name, "PropertiesChanged") == 0) {
+		if (   strcmp (interface_name, DBUS_INTERFACE_PROPERTIES) == 0
+		    && g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+			g_variant_get (parameters, "(&s@a{sv}as)", &interface, &props, NULL);
+		else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+			g_variant_get (parameters, "(@a{sv})", &props);
+	}
+
+	stats->events->buckets[stats->bucket]++;
+	stats->events->total++;
+	monitor_stats_count (stats, stats->interfaces, interface);
+	monitor_stats_count (stats, stats->objects, object_path);
+	if (props) {
+		monitor_stats_count_properties (stats, interface, props);
+		g_variant_unref (props);
+	}
+}
+
+static gint
+monitor_stats_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	GHashTable *table = user_data;
+	const MonitorStatsCounter *ca = g_hash_table_lookup (table, *(const char **) a);
+	const MonitorStatsCounter *cb = g_hash_table_lookup (table, *(const char **) b);
+
+	if (ca->total != cb->total)
+		return ca->total < cb->total ? 1 : -1;
+	return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static void
+monitor_stats_print_top (MonitorStats *stats, GHashTable *table, const char *title, guint seconds)
+{
+	GPtrArray *names;
+	GHashTableIter iter;
+	const char *name;
+	MonitorStatsCounter *counter;
+	guint i;
+
+	names = g_ptr_array_new ();
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &counter)) {
+		if (counter->total)
+			g_ptr_array_add (names, (gpointer) name);
+	}
+	g_ptr_array_sort_with_data (names, monitor_stats_compare, table);
+
+	g_print ("%s\n", title);
+	for (i = 0; i < names->len && i < MONITOR_STATS_TOP; i++) {
+		counter = g_hash_table_lookup (table, names->pdata[i]);
+		g_print ("  %8.1f/s  %s\n", (double) counter->total / seconds, (const char *) names->pdata[i]);
+	}
+	if (!names->len)
+		g_print ("  --\n");
+	g_ptr_array_free (names, TRUE);
+}
+
+static void
+monitor_stats_advance (MonitorStats *stats, GHashTable *table)
+{
+	GHashTableIter iter;
+	MonitorStatsCounter *counter;
+
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &counter)) {
+		counter->total -= counter->buckets[stats->bucket];
+		counter->buckets[stats->bucket] = 0;
+		/* Forget objects that went quiet for a whole window */
+		if (!counter->total)
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+static gboolean
+monitor_stats_timeout_cb (gpointer user_data)
+{
+	MonitorStats *stats = user_data;
+	guint seconds;
+
+	if (stats->seconds < stats->window)
+		stats->seconds++;
+	seconds = stats->seconds;
+
+	g_print (_("Signals in the last %u s: %u (%.1f/s)\n"),
+	         seconds, stats->events->total, (double) stats->events->total / seconds);
+	monitor_stats_print_top (stats, stats->interfaces, _("Top interfaces:"), seconds);
+	monitor_stats_print_top (stats, stats->objects, _("Top objects:"), seconds);
+	monitor_stats_print_top (stats, stats->properties, _("Top properties:"), seconds);
+	g_print ("\n");
+
+	/* Start the next second, dropping the one that leaves the window */
+	stats->bucket = (stats->bucket + 1) % stats->window;
+	stats->events->total -= stats->events->buckets[stats->bucket];
+	stats->events->buckets[stats->bucket] = 0;
+	monitor_stats_advance (stats, stats->interfaces);
+	monitor_stats_advance (stats, stats->objects);
+	monitor_stats_advance (stats, stats->properties);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static NMCResultCode
+do_monitor_stats (NmCli *nmc, int argc, char **argv)
+{
+	MonitorStats *stats;
+	GDBusConnection *bus;
+	unsigned long window = MONITOR_STATS_WINDOW_DEFAULT;
+	GError *error = NULL;
+
+	if (argc > 0) {
+		if (!nmc_string_to_uint (*argv, TRUE, 1, 3600, &window) || argc > 1) {
+			g_string_printf (nmc->return_text, _("Error: invalid window '%s', expected a number of seconds (1-3600)."), *argv);
+			nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+			return nmc->return_value;
+		}
+	}
+
+	bus = g_bus_get_sync (g_getenv ("LIBNM_USE_SESSION_BUS") ? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM,
+	                      NULL, &error);
+	if (!bus) {
+		g_string_printf (nmc->return_text, _("Error: could not connect to D-Bus: %s."), error->message);
+		nmc->return_value = NMC_RESULT_ERROR_UNKNOWN;
+		g_error_free (error);
+		return nmc->return_value;
+	}
+
+	/* Lives until nmcli is terminated */
+	stats = g_new0 (MonitorStats, 1);
+	stats->window = window;
+	stats->events = monitor_stats_counter_new (stats);
+	stats->interfaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	stats->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	stats->properties = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	g_dbus_connection_signal_subscribe (bus,
+	                                    NM_DBUS_SERVICE,
+	                                    NULL,
+	                                    NULL,
+	                                    NULL,
+	                                    NULL,
+	                                    G_DBUS_SIGNAL_FLAGS_NONE,
+	                                    monitor_stats_signal_cb,
+	                                    stats,
+	                                    NULL);
+	g_timeout_add_seconds (1, monitor_stats_timeout_cb, stats);
+
+	nmc->should_wait++;
+	return NMC_RESULT_SUCCESS;
+}
+
 NMCResultCode
 do_monitor (NmCli *nmc, int argc, char **argv)
 {
+	if (argc > 0 && nmc_arg_is_option (*argv, "stats"))
+		return do_monitor_stats (nmc, argc - 1, argv + 1);
+
 	if (argc > 0) {
 		if (!nmc_arg_is_help (*argv)) {
 			g_string_printf (nmc->return_text, _("Error: 'monitor' command '%s' is not valid."), *argv);
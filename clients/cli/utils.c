@@ -1235,18 +1235,26 @@ print_required_fields (NmCli *nmc, const NmcOutputField field_values[])
 	g_string_free (str, TRUE);
 }
 
+static gboolean
+output_is_aligned (NmCli *nmc)
+{
+	return    !nmc->multiline_output
+	       && nmc->print_output != NMC_PRINT_TERSE;
+}
+
 /*
  * Print nmc->output_data
  *
  * It first finds out maximal string length in columns and fill the value to
  * 'width' member of NmcOutputField, so that columns in tabular output are
- * properly aligned. Then each object (row in tabular) is printed using
+ * properly aligned. That is skipped in terse and multiline mode, where the
+ * widths are not used. Then each object (row in tabular) is printed using
  * print_required_fields() function.
  */
 void
 print_data (NmCli *nmc)
 {
-	int i, j;
+	int i, j, k;
 	size_t len;
 	NmcOutputField *row;
 	int num_fields = 0;
@@ -1254,6 +1262,10 @@ print_data (NmCli *nmc)
 	if (!nmc->output_data || nmc->output_data->len < 1)
 		return;
 
+	/* Column widths are only used for the aligned tabular output */
+	if (!output_is_aligned (nmc))
+		goto print;
+
 	/* How many fields? */
 	row = g_ptr_array_index (nmc->output_data, 0);
 	while (row->name) {
@@ -1261,9 +1273,13 @@ print_data (NmCli *nmc)
 		row++;
 	}
 
-	/* Find out maximal string lengths */
-	for (i = 0; i < num_fields; i++) {
+	/* Find out maximal string lengths of the printed fields */
+	for (k = 0; k < nmc->print_fields.indices->len; k++) {
 		size_t max_width = 0;
+
+		i = g_array_index (nmc->print_fields.indices, int, k);
+		if (i < 0 || i >= num_fields)
+			continue;
 		for (j = 0; j < nmc->output_data->len; j++) {
 			gboolean field_names, dealloc;
 			char *value;
@@ -1281,6 +1297,7 @@ print_data (NmCli *nmc)
 		}
 	}
 
+print:
 	/* Now we can print the data. */
 	for (i = 0; i < nmc->output_data->len; i++) {
 		row = g_ptr_array_index (nmc->output_data, i);
@@ -1288,3 +1305,36 @@ print_data (NmCli *nmc)
 	}
 }
 
+/*
+ * Add a row to nmc->output_data for print_data().
+ *
+ * When the columns don't need to be aligned (terse and multiline output)
+ * the row is printed right away and freed instead, together with the rows
+ * queued before it. That keeps the memory use of long listings bounded.
+ * Takes ownership of @row.
+ */
+void
+print_data_row (NmCli *nmc, NmcOutputField *row)
+{
+	int i;
+
+	if (output_is_aligned (nmc)) {
+		g_ptr_array_add (nmc->output_data, row);
+		return;
+	}
+
+	/* Keep the order, e.g. with the main header queued before */
+	for (i = 0; i < nmc->output_data->len; i++) {
+		NmcOutputField *queued = g_ptr_array_index (nmc->output_data, i);
+
+		print_required_fields (nmc, queued);
+		nmc_free_output_field_values (queued);
+	}
+	if (nmc->output_data->len > 0)
+		g_ptr_array_remove_range (nmc->output_data, 0, nmc->output_data->len);
+
+	print_required_fields (nmc, row);
+	nmc_free_output_field_values (row);
+	g_free (row);
+}
+
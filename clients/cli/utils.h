@@ -102,5 +102,6 @@ NmcOutputField *nmc_dup_fields_array (NmcOutputField fields[], size_t size, guin
 void nmc_empty_output_fields (NmCli *nmc);
 void print_required_fields (NmCli *nmc, const NmcOutputField field_values[]);
 void print_data (NmCli *nmc);
+void print_data_row (NmCli *nmc, NmcOutputField *row);
 
 #endif /* NMC_UTILS_H */
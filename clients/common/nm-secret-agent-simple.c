@@ -619,6 +619,9 @@ nm_secret_agent_simple_get_secrets (NMSecretAgentOld                 *agent,
  * #NMSecretAgentSimpleSecrets (freeing any initial values they had), and
  * pass the array to nm_secret_agent_simple_response(). If the user
  * cancelled the request, @secrets should be NULL.
+ *
+ * If NetworkManager canceled the request in the meantime, the response
+ * is ignored.
  */
 void
 nm_secret_agent_simple_response (NMSecretAgentSimple *self,
@@ -635,7 +638,10 @@ nm_secret_agent_simple_response (NMSecretAgentSimple *self,
 
 	priv = NM_SECRET_AGENT_SIMPLE_GET_PRIVATE (self);
 	request = g_hash_table_lookup (priv->requests, request_id);
-	g_return_if_fail (request != NULL);
+	if (!request) {
+		/* NetworkManager canceled the request meanwhile */
+		return;
+	}
 
 	if (secrets) {
 		GVariantBuilder conn_builder, *setting_builder;
@@ -699,7 +705,22 @@ nm_secret_agent_simple_cancel_get_secrets (NMSecretAgentOld *agent,
                                            const gchar      *connection_path,
                                            const gchar      *setting_name)
 {
-	/* We don't support cancellation. Sorry! */
+	NMSecretAgentSimplePrivate *priv = NM_SECRET_AGENT_SIMPLE_GET_PRIVATE (agent);
+	NMSecretAgentSimpleRequest *request;
+	gs_free char *request_id = NULL;
+	GError *error;
+
+	request_id = g_strdup_printf ("%s/%s", connection_path, setting_name);
+	request = g_hash_table_lookup (priv->requests, request_id);
+	if (!request)
+		return;
+
+	/* The UI may still show the prompt; its response is ignored. */
+	error = g_error_new (NM_SECRET_AGENT_ERROR, NM_SECRET_AGENT_ERROR_AGENT_CANCELED,
+	                     "Request for %s secrets was canceled", request_id);
+	request->callback (agent, request->connection, NULL, error, request->callback_data);
+	g_hash_table_remove (priv->requests, request_id);
+	g_error_free (error);
 }
 
 static void
@@ -755,7 +776,7 @@ nm_secret_agent_simple_enable (NMSecretAgentSimple *self, const char *path)
 	for (iter = requests; iter; iter = g_list_next (iter)) {
 		NMSecretAgentSimpleRequest *request = iter->data;
 
-		if (g_str_has_prefix (request->request_id, priv->path)) {
+		if (!priv->path || g_str_has_prefix (request->request_id, priv->path)) {
 			request_secrets_from_ui (request);
 		} else {
 			/* We only handle requests for connection with @path if set. */
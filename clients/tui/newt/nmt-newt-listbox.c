@@ -29,6 +29,12 @@
  *
  * The listbox will emit #NmtNewtWidget::activate when the user
  * presses Return on a selection.
+ *
+ * Long lists are virtualized: only a window of rows around the
+ * selection is handed to newt, which copies each row and appends it
+ * in linear time, and the window is moved when the selection gets
+ * close to its edge. nmt_newt_listbox_update() replaces the rows,
+ * rebuilding the newt component only if rows in the window changed.
  */
 
 #include "nm-default.h"
@@ -37,6 +43,11 @@
 #include "nmt-newt-form.h"
 #include "nmt-newt-utils.h"
 
+/* the rows newt has are WINDOW_PAGES pages around the active row. The
+ * window is moved once the active row is within a page of its edge. */
+#define WINDOW_PAGES 3
+#define WINDOW_PAGE_MIN 20
+
 G_DEFINE_TYPE (NmtNewtListbox, nmt_newt_listbox, NMT_TYPE_NEWT_COMPONENT)
 
 #define NMT_NEWT_LISTBOX_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NMT_TYPE_NEWT_LISTBOX, NmtNewtListboxPrivate))
@@ -53,6 +64,10 @@ typedef struct {
 	gpointer active_key;
 	gboolean skip_null_keys;
 
+	/* the rows in the newt component */
+	int window_start, window_len;
+	gboolean windowed;
+
 } NmtNewtListboxPrivate;
 
 enum {
@@ -133,6 +148,143 @@ nmt_newt_listbox_clear (NmtNewtListbox *listbox)
 	nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
 }
 
+static gboolean
+row_equal (NmtNewtListboxPrivate *priv,
+           int                    old_row,
+           GPtrArray             *entries,
+           GPtrArray             *keys,
+           int                    new_row)
+{
+	return    !priv->keys->pdata[old_row] == !keys->pdata[new_row]
+	       && !strcmp (priv->entries->pdata[old_row], entries->pdata[new_row]);
+}
+
+static int
+find_selectable (NmtNewtListboxPrivate *priv,
+                 int                    row)
+{
+	int i;
+
+	if (!priv->keys->len)
+		return -1;
+	row = CLAMP (row, 0, (int) priv->keys->len - 1);
+	if (!priv->skip_null_keys)
+		return row;
+
+	for (i = row; i < priv->keys->len; i++) {
+		if (priv->keys->pdata[i])
+			return i;
+	}
+	for (i = row - 1; i >= 0; i--) {
+		if (priv->keys->pdata[i])
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * nmt_newt_listbox_update:
+ * @listbox: an #NmtNewtListbox
+ * @entries: (element-type utf8): the texts of the rows
+ * @keys: the keys associated with @entries
+ *
+ * Replaces the rows of @listbox. The rows at the start and at the end
+ * with the same texts as before are kept and get the new keys; only
+ * the ones in between are replaced. This makes updating a long list
+ * cheap when few of its rows changed.
+ *
+ * The selected row stays the same if it was kept, else the row with
+ * the previously selected key is selected, if there is one.
+ */
+void
+nmt_newt_listbox_update (NmtNewtListbox *listbox,
+                         GPtrArray      *entries,
+                         GPtrArray      *keys)
+{
+	NmtNewtListboxPrivate *priv = NMT_NEWT_LISTBOX_GET_PRIVATE (listbox);
+	GPtrArray *new_entries, *new_keys;
+	int n_old, n_new, prefix, suffix, i;
+	int old_active, new_active;
+	gpointer old_active_key;
+
+	g_return_if_fail (entries->len == keys->len);
+
+	new_entries = g_ptr_array_new_full (entries->len, g_free);
+	for (i = 0; i < entries->len; i++)
+		g_ptr_array_add (new_entries, nmt_newt_locale_from_utf8 (entries->pdata[i]));
+
+	n_old = priv->entries->len;
+	n_new = entries->len;
+	for (prefix = 0;
+	     prefix < MIN (n_old, n_new) && row_equal (priv, prefix, new_entries, keys, prefix);
+	     prefix++)
+		;
+	for (suffix = 0;
+	     suffix < MIN (n_old, n_new) - prefix && row_equal (priv, n_old - 1 - suffix, new_entries, keys, n_new - 1 - suffix);
+	     suffix++)
+		;
+
+	/* the kept rows get their new keys, and their texts are taken over */
+	for (i = 0; i < prefix; i++) {
+		g_free (new_entries->pdata[i]);
+		new_entries->pdata[i] = priv->entries->pdata[i];
+		priv->entries->pdata[i] = NULL;
+	}
+	for (i = 0; i < suffix; i++) {
+		g_free (new_entries->pdata[n_new - 1 - i]);
+		new_entries->pdata[n_new - 1 - i] = priv->entries->pdata[n_old - 1 - i];
+		priv->entries->pdata[n_old - 1 - i] = NULL;
+	}
+	new_keys = g_ptr_array_sized_new (n_new);
+	for (i = 0; i < n_new; i++)
+		g_ptr_array_add (new_keys, keys->pdata[i]);
+
+	g_ptr_array_unref (priv->entries);
+	g_ptr_array_unref (priv->keys);
+	priv->entries = new_entries;
+	priv->keys = new_keys;
+
+	old_active = priv->active;
+	old_active_key = priv->active_key;
+	if (old_active < 0)
+		new_active = -1;
+	else if (old_active < prefix)
+		new_active = old_active;
+	else if (old_active >= n_old - suffix)
+		new_active = old_active + (n_new - n_old);
+	else {
+		new_active = -1;
+		if (old_active_key) {
+			for (i = prefix; i < n_new - suffix; i++) {
+				if (new_keys->pdata[i] == old_active_key) {
+					new_active = i;
+					break;
+				}
+			}
+		}
+		if (new_active == -1)
+			new_active = find_selectable (priv, old_active);
+	}
+	priv->active = new_active;
+	priv->active_key = new_active >= 0 ? new_keys->pdata[new_active] : NULL;
+
+	/* The newt component only has to be rebuilt if rows in its window
+	 * changed. Rows that changed before the window move it. */
+	if (prefix == n_old && prefix == n_new)
+		;
+	else if (!priv->windowed)
+		nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
+	else if (n_old - suffix <= priv->window_start)
+		priv->window_start += n_new - n_old;
+	else if (prefix < priv->window_start + priv->window_len)
+		nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
+
+	if (priv->active != old_active)
+		g_object_notify (G_OBJECT (listbox), "active");
+	if (priv->active_key != old_active_key)
+		g_object_notify (G_OBJECT (listbox), "active-key");
+}
+
 /**
  * nmt_newt_listbox_set_active:
  * @listbox: an #NmtNewtListbox
@@ -156,6 +308,10 @@ nmt_newt_listbox_set_active (NmtNewtListbox *listbox,
 	priv->active = active;
 	priv->active_key = priv->keys->pdata[active];
 
+	if (   priv->windowed
+	    && (active < priv->window_start || active >= priv->window_start + priv->window_len))
+		nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
+
 	g_object_notify (G_OBJECT (listbox), "active");
 	g_object_notify (G_OBJECT (listbox), "active-key");
 }
@@ -185,6 +341,10 @@ nmt_newt_listbox_set_active_key (NmtNewtListbox *listbox,
 			priv->active = i;
 			priv->active_key = active_key;
 
+			if (   priv->windowed
+			    && (i < priv->window_start || i >= priv->window_start + priv->window_len))
+				nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
+
 			g_object_notify (G_OBJECT (listbox), "active");
 			g_object_notify (G_OBJECT (listbox), "active-key");
 			return;
@@ -346,11 +506,22 @@ selection_changed_callback (newtComponent  co,
 	NmtNewtListboxPrivate *priv = NMT_NEWT_LISTBOX_GET_PRIVATE (listbox);
 	int new_active;
 
-	new_active = GPOINTER_TO_UINT (newtListboxGetCurrent (co));
+	new_active = priv->window_start + GPOINTER_TO_UINT (newtListboxGetCurrent (co));
 	update_active_internal (listbox, new_active);
 
 	if (priv->active != new_active)
-		newtListboxSetCurrent (co, priv->active);
+		newtListboxSetCurrent (co, priv->active - priv->window_start);
+
+	/* move the window before the selection reaches its edge */
+	if (priv->windowed) {
+		int page = priv->window_len / WINDOW_PAGES;
+
+		if (   (   priv->window_start > 0
+		        && priv->active - priv->window_start < page)
+		    || (   priv->window_start + priv->window_len < priv->entries->len
+		        && priv->window_start + priv->window_len - priv->active <= page))
+			nmt_newt_widget_needs_rebuild (NMT_NEWT_WIDGET (listbox));
+	}
 }
 
 static guint
@@ -378,17 +549,34 @@ nmt_newt_listbox_build_component (NmtNewtComponent *component,
 		update_active_internal (NMT_NEWT_LISTBOX (component), 0);
 	active = priv->active;
 
+	if (active == -1) {
+		for (i = 0; i < priv->entries->len; i++) {
+			if (priv->keys->pdata[i] == priv->active_key) {
+				active = i;
+				break;
+			}
+		}
+	}
+
+	priv->window_len = MAX (priv->height, WINDOW_PAGE_MIN) * WINDOW_PAGES;
+	priv->windowed = priv->entries->len > priv->window_len;
+	if (priv->windowed) {
+		priv->window_start = CLAMP (MAX (active, 0) - priv->window_len / 2,
+		                            0, (int) priv->entries->len - priv->window_len);
+	} else {
+		priv->window_start = 0;
+		priv->window_len = priv->entries->len;
+	}
+
 	co = newtListbox (-1, -1, priv->height, convert_flags (priv->flags));
 	newtComponentAddCallback (co, selection_changed_callback, component);
 
-	for (i = 0; i < priv->entries->len; i++) {
-		newtListboxAppendEntry (co, priv->entries->pdata[i], GUINT_TO_POINTER (i));
-		if (active == -1 && priv->keys->pdata[i] == priv->active_key)
-			active = i;
-	}
+	/* the keys of the newt rows are their positions in the window */
+	for (i = 0; i < priv->window_len; i++)
+		newtListboxAppendEntry (co, priv->entries->pdata[priv->window_start + i], GUINT_TO_POINTER (i));
 
 	if (active != -1)
-		newtListboxSetCurrent (co, active);
+		newtListboxSetCurrent (co, active - priv->window_start);
 
 	return co;
 }
@@ -397,9 +585,11 @@ static void
 nmt_newt_listbox_activated (NmtNewtWidget *widget)
 {
 	NmtNewtListbox *listbox = NMT_NEWT_LISTBOX (widget);
+	NmtNewtListboxPrivate *priv = NMT_NEWT_LISTBOX_GET_PRIVATE (widget);
 	newtComponent co = nmt_newt_component_get_component (NMT_NEWT_COMPONENT (widget));
 
-	nmt_newt_listbox_set_active (listbox, GPOINTER_TO_UINT (newtListboxGetCurrent (co)));
+	nmt_newt_listbox_set_active (listbox,
+	                             priv->window_start + GPOINTER_TO_UINT (newtListboxGetCurrent (co)));
 
 	NMT_NEWT_WIDGET_CLASS (nmt_newt_listbox_parent_class)->activated (widget);
 }
@@ -57,6 +57,9 @@ void           nmt_newt_listbox_append         (NmtNewtListbox      *listbox,
                                                 const char          *entry,
                                                 gpointer             key);
 void           nmt_newt_listbox_clear          (NmtNewtListbox      *listbox);
+void           nmt_newt_listbox_update         (NmtNewtListbox      *listbox,
+                                                GPtrArray           *entries,
+                                                GPtrArray           *keys);
 
 void           nmt_newt_listbox_set_active     (NmtNewtListbox      *listbox,
                                                 int                  active);
@@ -58,6 +58,8 @@ typedef struct {
 
 typedef struct {
 	GSList *nmt_devices;
+
+	guint rebuild_id;
 } NmtConnectConnectionListPrivate;
 
 /**
@@ -358,6 +360,7 @@ append_nmt_devices_for_virtual_devices (GSList          *nmt_devices,
 	NMConnection *conn;
 	NmtConnectConnection *nmtconn;
 	int sort_order;
+	GSList *iter;
 
 	devices_by_name = g_hash_table_new (g_str_hash, g_str_equal);
 
@@ -385,10 +388,16 @@ append_nmt_devices_for_virtual_devices (GSList          *nmt_devices,
 		nmtconn->name = nm_connection_get_id (conn);
 		nmtconn->conn = g_object_ref (conn);
 
-		nmtdev->conns = g_slist_insert_sorted (nmtdev->conns, nmtconn, sort_connections);
+		nmtdev->conns = g_slist_prepend (nmtdev->conns, nmtconn);
 	}
 
 	g_hash_table_destroy (devices_by_name);
+
+	for (iter = nmt_devices; iter; iter = iter->next) {
+		nmtdev = iter->data;
+		if (!nmtdev->device)
+			nmtdev->conns = g_slist_sort (nmtdev->conns, sort_connections);
+	}
 	return nmt_devices;
 }
 
@@ -414,8 +423,9 @@ append_nmt_devices_for_vpns (GSList          *nmt_devices,
 		nmtconn->name = nm_connection_get_id (conn);
 		nmtconn->conn = g_object_ref (conn);
 
-		nmtdev->conns = g_slist_insert_sorted (nmtdev->conns, nmtconn, sort_connections);
+		nmtdev->conns = g_slist_prepend (nmtdev->conns, nmtconn);
 	}
+	nmtdev->conns = g_slist_sort (nmtdev->conns, sort_connections);
 
 	if (nmtdev->conns)
 		nmt_devices = g_slist_prepend (nmt_devices, nmtdev);
@@ -438,23 +448,25 @@ sort_nmt_devices (gconstpointer  a,
 	return strcmp (nmta->name, nmtb->name);
 }
 
-static NMActiveConnection *
-connection_find_ac (NMConnection    *conn,
-                    const GPtrArray *acs)
+static GHashTable *
+connections_to_acs (const GPtrArray *acs)
 {
+	GHashTable *hash;
 	NMActiveConnection *ac;
 	NMRemoteConnection *ac_conn;
 	int i;
 
-	for (i = 0; i < acs->len; i++) {
+	hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (i = acs->len - 1; i >= 0; i--) {
 		ac = acs->pdata[i];
 		ac_conn = nm_active_connection_get_connection (ac);
 
-		if (conn == NM_CONNECTION (ac_conn))
-			return ac;
+		/* the first active connection wins */
+		if (ac_conn)
+			g_hash_table_insert (hash, NM_CONNECTION (ac_conn), ac);
 	}
 
-	return NULL;
+	return hash;
 }
 
 static void
@@ -463,6 +475,8 @@ nmt_connect_connection_list_rebuild (NmtConnectConnectionList *list)
 	NmtConnectConnectionListPrivate *priv = NMT_CONNECT_CONNECTION_LIST_GET_PRIVATE (list);
 	NmtNewtListbox *listbox = NMT_NEWT_LISTBOX (list);
 	const GPtrArray *devices, *acs, *connections;
+	GHashTable *acs_by_connection;
+	GPtrArray *entries, *keys;
 	int max_width;
 	char **names, *row, active_col;
 	const char *strength_col;
@@ -470,9 +484,7 @@ nmt_connect_connection_list_rebuild (NmtConnectConnectionList *list)
 	NmtConnectDevice *nmtdev;
 	NmtConnectConnection *nmtconn;
 
-	g_slist_free_full (priv->nmt_devices, (GDestroyNotify) nmt_connect_device_free);
-	priv->nmt_devices = NULL;
-	nmt_newt_listbox_clear (listbox);
+	nm_clear_g_source (&priv->rebuild_id);
 
 	devices = nm_client_get_devices (nm_client);
 	acs = nm_client_get_active_connections (nm_client);
@@ -499,20 +511,27 @@ nmt_connect_connection_list_rebuild (NmtConnectConnectionList *list)
 		}
 	}
 
+	acs_by_connection = connections_to_acs (acs);
+	entries = g_ptr_array_new_with_free_func (g_free);
+	keys = g_ptr_array_new ();
+
 	for (diter = nmt_devices; diter; diter = diter->next) {
 		nmtdev = diter->data;
 
 		if (nmtdev->conns) {
-			if (diter != nmt_devices)
-				nmt_newt_listbox_append (listbox, "", NULL);
-			nmt_newt_listbox_append (listbox, nmtdev->name, NULL);
+			if (diter != nmt_devices) {
+				g_ptr_array_add (entries, g_strdup (""));
+				g_ptr_array_add (keys, NULL);
+			}
+			g_ptr_array_add (entries, g_strdup (nmtdev->name));
+			g_ptr_array_add (keys, NULL);
 		}
 
 		for (citer = nmtdev->conns; citer; citer = citer->next) {
 			nmtconn = citer->data;
 
 			if (nmtconn->conn)
-				nmtconn->active = connection_find_ac (nmtconn->conn, acs);
+				nmtconn->active = g_hash_table_lookup (acs_by_connection, nmtconn->conn);
 			if (nmtconn->active) {
 				g_object_ref (nmtconn->active);
 				active_col = '*';
@@ -533,23 +552,46 @@ nmt_connect_connection_list_rebuild (NmtConnectConnectionList *list)
 			                       strength_col ? " " : "",
 			                       strength_col ? strength_col : "");
 
-			nmt_newt_listbox_append (listbox, row, nmtconn);
-			g_free (row);
+			g_ptr_array_add (entries, row);
+			g_ptr_array_add (keys, nmtconn);
 		}
 	}
+	g_hash_table_unref (acs_by_connection);
 
+	/* only the rows that changed are replaced; the others take the
+	 * new keys. The old keys aren't used anymore after that. */
+	nmt_newt_listbox_update (listbox, entries, keys);
+	g_ptr_array_unref (entries);
+	g_ptr_array_unref (keys);
+
+	g_slist_free_full (priv->nmt_devices, (GDestroyNotify) nmt_connect_device_free);
 	priv->nmt_devices = nmt_devices;
 
 	g_object_notify (G_OBJECT (listbox), "active");
 	g_object_notify (G_OBJECT (listbox), "active-key");
 }
 
+static gboolean
+rebuild_cb (gpointer list)
+{
+	NmtConnectConnectionListPrivate *priv = NMT_CONNECT_CONNECTION_LIST_GET_PRIVATE (list);
+
+	priv->rebuild_id = 0;
+	nmt_connect_connection_list_rebuild (list);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 rebuild_on_property_changed (GObject    *object,
                              GParamSpec *spec,
                              gpointer    list)
 {
-	nmt_connect_connection_list_rebuild (list);
+	NmtConnectConnectionListPrivate *priv = NMT_CONNECT_CONNECTION_LIST_GET_PRIVATE (list);
+
+	/* NMClient changes come in bursts, eg when the connections are
+	 * loaded. Rebuild once, after the burst. */
+	if (!priv->rebuild_id)
+		priv->rebuild_id = g_idle_add (rebuild_cb, list);
 }
 
 static void
@@ -575,6 +617,7 @@ nmt_connect_connection_list_finalize (GObject *object)
 	NmtConnectConnectionListPrivate *priv = NMT_CONNECT_CONNECTION_LIST_GET_PRIVATE (object);
 
 	g_slist_free_full (priv->nmt_devices, (GDestroyNotify) nmt_connect_device_free);
+	nm_clear_g_source (&priv->rebuild_id);
 
 	g_signal_handlers_disconnect_by_func (nm_client, G_CALLBACK (rebuild_on_property_changed), object);
 
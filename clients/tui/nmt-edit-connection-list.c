@@ -51,6 +51,8 @@ typedef struct {
 	NmtNewtWidget *edit;
 	NmtNewtWidget *delete;
 	NmtNewtWidget *extra;
+
+	guint rebuild_id;
 } NmtEditConnectionListPrivate;
 
 enum {
@@ -135,11 +137,32 @@ sort_by_timestamp (gconstpointer  a,
 
 static void nmt_edit_connection_list_rebuild (NmtEditConnectionList *list);
 
+static gboolean
+rebuild_cb (gpointer list)
+{
+	NmtEditConnectionListPrivate *priv = NMT_EDIT_CONNECTION_LIST_GET_PRIVATE (list);
+
+	priv->rebuild_id = 0;
+	nmt_edit_connection_list_rebuild (list);
+	return G_SOURCE_REMOVE;
+}
+
+/* Changes come in bursts, eg when the connections are loaded, so the
+ * list is rebuilt once, after the burst. */
+static void
+queue_rebuild (NmtEditConnectionList *list)
+{
+	NmtEditConnectionListPrivate *priv = NMT_EDIT_CONNECTION_LIST_GET_PRIVATE (list);
+
+	if (!priv->rebuild_id)
+		priv->rebuild_id = g_idle_add (rebuild_cb, list);
+}
+
 static void
 rebuild_on_connection_changed (NMRemoteConnection *connection,
                                gpointer            list)
 {
-	nmt_edit_connection_list_rebuild (list);
+	queue_rebuild (list);
 }
 
 static void
@@ -167,11 +190,11 @@ nmt_edit_connection_list_rebuild (NmtEditConnectionList *list)
 	GSList *iter;
 	gboolean did_header = FALSE, did_vpn = FALSE;
 	NMEditorConnectionTypeData **types;
-	NMConnection *conn, *selected_conn;
-	int i, row, selected_row;
+	NMConnection *conn;
+	GPtrArray *entries, *keys;
+	int i;
 
-	selected_row = nmt_newt_listbox_get_active (priv->listbox);
-	selected_conn = nmt_newt_listbox_get_active_key (priv->listbox);
+	nm_clear_g_source (&priv->rebuild_id);
 
 	free_connections (list);
 	connections = nm_client_get_connections (nm_client);
@@ -195,25 +218,24 @@ nmt_edit_connection_list_rebuild (NmtEditConnectionList *list)
 	nmt_newt_component_set_sensitive (NMT_NEWT_COMPONENT (priv->delete),
 	                                  priv->connections != NULL);
 
-	nmt_newt_listbox_clear (priv->listbox);
+	/* The rows are replaced by nmt_newt_listbox_update(), which only
+	 * touches the ones that changed and keeps the selection on the same
+	 * connection. */
+	entries = g_ptr_array_new_with_free_func (g_free);
+	keys = g_ptr_array_new ();
 
 	if (!priv->grouped) {
 		/* Just add the connections in order */
-		for (iter = priv->connections, row = 0; iter; iter = iter->next, row++) {
+		for (iter = priv->connections; iter; iter = iter->next) {
 			conn = iter->data;
-			nmt_newt_listbox_append (priv->listbox, nm_connection_get_id (conn), conn);
-			if (conn == selected_conn)
-				selected_row = row;
+			g_ptr_array_add (entries, g_strdup (nm_connection_get_id (conn)));
+			g_ptr_array_add (keys, conn);
 		}
-		if (selected_row >= row)
-			selected_row = row - 1;
-		nmt_newt_listbox_set_active (priv->listbox, selected_row);
-
-		return;
+		goto out;
 	}
 
 	types = nm_editor_utils_get_connection_type_list ();
-	for (i = row = 0; types[i]; i++) {
+	for (i = 0; types[i]; i++) {
 		if (types[i]->setting_type == NM_TYPE_SETTING_VPN) {
 			if (did_vpn)
 				continue;
@@ -224,7 +246,6 @@ nmt_edit_connection_list_rebuild (NmtEditConnectionList *list)
 
 		for (iter = priv->connections; iter; iter = iter->next) {
 			NMSetting *setting;
-			char *indented;
 
 			conn = iter->data;
 			setting = nm_connection_get_setting (conn, types[i]->setting_type);
@@ -234,26 +255,20 @@ nmt_edit_connection_list_rebuild (NmtEditConnectionList *list)
 				continue;
 
 			if (!did_header) {
-				nmt_newt_listbox_append (priv->listbox, types[i]->name, NULL);
-				if (row == selected_row)
-					selected_row++;
-				row++;
+				g_ptr_array_add (entries, g_strdup (types[i]->name));
+				g_ptr_array_add (keys, NULL);
 				did_header = TRUE;
 			}
 
-			indented = g_strdup_printf ("  %s", nm_connection_get_id (conn));
-			nmt_newt_listbox_append (priv->listbox, indented, conn);
-			g_free (indented);
-
-			if (conn == selected_conn)
-				selected_row = row;
-			row++;
+			g_ptr_array_add (entries, g_strdup_printf ("  %s", nm_connection_get_id (conn)));
+			g_ptr_array_add (keys, conn);
 		}
 	}
 
-	if (selected_row >= row)
-		selected_row = row - 1;
-	nmt_newt_listbox_set_active (priv->listbox, selected_row);
+out:
+	nmt_newt_listbox_update (priv->listbox, entries, keys);
+	g_ptr_array_unref (entries);
+	g_ptr_array_unref (keys);
 }
 
 static void
@@ -261,7 +276,7 @@ rebuild_on_connections_changed (GObject    *object,
                                 GParamSpec *pspec,
                                 gpointer    list)
 {
-	nmt_edit_connection_list_rebuild (list);
+	queue_rebuild (list);
 }
 
 static void
@@ -326,6 +341,7 @@ nmt_edit_connection_list_finalize (GObject *object)
 
 	free_connections (NMT_EDIT_CONNECTION_LIST (object));
 	g_clear_object (&priv->extra);
+	nm_clear_g_source (&priv->rebuild_id);
 
 	G_OBJECT_CLASS (nmt_edit_connection_list_parent_class)->finalize (object);
 }
@@ -450,6 +450,8 @@ mkdir -p %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d
 mkdir -p %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/pre-up.d
 mkdir -p %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/pre-down.d
 mkdir -p %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/no-wait.d
+mkdir -p %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/no-supersede.d
+mkdir -p %{buildroot}%{_libdir}/%{name}/dispatcher
 cp examples/dispatcher/10-ifcfg-rh-routes.sh %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/
 ln -s ../no-wait.d/10-ifcfg-rh-routes.sh %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/pre-up.d/
 ln -s ../10-ifcfg-rh-routes.sh %{buildroot}%{_sysconfdir}/%{name}/dispatcher.d/no-wait.d/
@@ -521,6 +523,8 @@ fi
 %dir %{_sysconfdir}/%{name}/dispatcher.d/pre-down.d
 %dir %{_sysconfdir}/%{name}/dispatcher.d/pre-up.d
 %dir %{_sysconfdir}/%{name}/dispatcher.d/no-wait.d
+%dir %{_sysconfdir}/%{name}/dispatcher.d/no-supersede.d
+%dir %{_libdir}/%{name}/dispatcher
 %dir %{_sysconfdir}/%{name}/dnsmasq.d
 %dir %{_sysconfdir}/%{name}/dnsmasq-shared.d
 %dir %{_sysconfdir}/%{name}/VPN
@@ -602,6 +606,7 @@ fi
 %{_includedir}/libnm-glib/*.h
 %{_includedir}/%{name}/%{name}.h
 %{_includedir}/%{name}/NetworkManagerVPN.h
+%{_includedir}/%{name}/nm-dispatcher-plugin.h
 %{_includedir}/%{name}/nm-setting*.h
 %{_includedir}/%{name}/nm-connection.h
 %{_includedir}/%{name}/nm-utils-enum-types.h
@@ -27,6 +27,7 @@
 #include <strings.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 #include "crypto.h"
 #include "nm-errors.h"
@@ -319,6 +320,129 @@ file_to_g_byte_array (const char *filename, GError **error)
 	return array;
 }
 
+/*****************************************************************************/
+
+/* A process-wide cache of the formats detected for certificate and key
+ * files. Certificates are parsed on every verification of an 802.1x
+ * setting, which is expensive for large CA bundles. An entry is valid as
+ * long as the device, inode, size and modification time of the file are
+ * unchanged. Only successful results that don't depend on a password are
+ * cached; errors are recomputed to get the error message. */
+
+#define FILE_CACHE_MAX_ENTRIES 64
+
+typedef struct {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	gint64 mtime_nsec;
+} FileCacheKey;
+
+typedef struct {
+	FileCacheKey key;
+	NMCryptoFileFormat cert_format;
+	NMCryptoFileFormat key_format;
+	bool has_is_pkcs12:1;
+	bool is_pkcs12:1;
+	bool key_is_encrypted:1;
+} FileCacheEntry;
+
+G_LOCK_DEFINE_STATIC (file_cache);
+
+/* path -> FileCacheEntry */
+static GHashTable *file_cache;
+
+static gboolean
+_file_cache_key_get (const char *filename, FileCacheKey *out_key)
+{
+	struct stat st;
+
+	if (stat (filename, &st) != 0 || !S_ISREG (st.st_mode))
+		return FALSE;
+
+	memset (out_key, 0, sizeof (*out_key));
+	out_key->dev = st.st_dev;
+	out_key->ino = st.st_ino;
+	out_key->size = st.st_size;
+	out_key->mtime_nsec = ((gint64) st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	return TRUE;
+}
+
+static gboolean
+_file_cache_key_equal (const FileCacheKey *a, const FileCacheKey *b)
+{
+	return    a->dev == b->dev
+	       && a->ino == b->ino
+	       && a->size == b->size
+	       && a->mtime_nsec == b->mtime_nsec;
+}
+
+/* Returns a copy of the cached entry of @filename in @out_entry, if it
+ * matches @key. Otherwise, @out_entry is returned empty. */
+static gboolean
+_file_cache_lookup (const char *filename, const FileCacheKey *key, FileCacheEntry *out_entry)
+{
+	FileCacheEntry *entry;
+	gboolean found = FALSE;
+
+	memset (out_entry, 0, sizeof (*out_entry));
+	out_entry->key = *key;
+
+	G_LOCK (file_cache);
+	entry = file_cache ? g_hash_table_lookup (file_cache, filename) : NULL;
+	if (entry && _file_cache_key_equal (&entry->key, key)) {
+		*out_entry = *entry;
+		found = TRUE;
+	}
+	G_UNLOCK (file_cache);
+	return found;
+}
+
+/* Stores @new_entry for @filename, unless the file changed since
+ * @new_entry->key was taken. */
+static void
+_file_cache_store (const char *filename, const FileCacheEntry *new_entry)
+{
+	FileCacheKey key;
+	FileCacheEntry *entry;
+
+	if (   !_file_cache_key_get (filename, &key)
+	    || !_file_cache_key_equal (&key, &new_entry->key))
+		return;
+
+	G_LOCK (file_cache);
+	if (G_UNLIKELY (!file_cache))
+		file_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	entry = g_hash_table_lookup (file_cache, filename);
+	if (!entry) {
+		/* simply start over, instead of bothering with the eviction
+		 * of the least recently used entry. */
+		if (g_hash_table_size (file_cache) >= FILE_CACHE_MAX_ENTRIES)
+			g_hash_table_remove_all (file_cache);
+		entry = g_new (FileCacheEntry, 1);
+		g_hash_table_insert (file_cache, g_strdup (filename), entry);
+	}
+	*entry = *new_entry;
+	G_UNLOCK (file_cache);
+}
+
+/**
+ * crypto_file_cache_clear:
+ *
+ * Drops the cached file formats.
+ */
+void
+crypto_file_cache_clear (void)
+{
+	G_LOCK (file_cache);
+	if (file_cache)
+		g_hash_table_remove_all (file_cache);
+	G_UNLOCK (file_cache);
+}
+
+/*****************************************************************************/
+
 /*
  * Convert a hex string into bytes.
  */
@@ -593,6 +717,9 @@ crypto_load_and_verify_certificate (const char *file,
                                     GError **error)
 {
 	GByteArray *array, *contents;
+	FileCacheKey key;
+	FileCacheEntry entry;
+	gboolean cacheable;
 
 	g_return_val_if_fail (file != NULL, NULL);
 	g_return_val_if_fail (out_file_format != NULL, NULL);
@@ -601,14 +728,23 @@ crypto_load_and_verify_certificate (const char *file,
 	if (!crypto_init (error))
 		return NULL;
 
+	cacheable = _file_cache_key_get (file, &key);
+
 	contents = file_to_g_byte_array (file, error);
 	if (!contents)
 		return NULL;
 
+	if (   cacheable
+	    && _file_cache_lookup (file, &key, &entry)
+	    && entry.cert_format != NM_CRYPTO_FILE_FORMAT_UNKNOWN) {
+		*out_file_format = entry.cert_format;
+		return contents;
+	}
+
 	/* Check for PKCS#12 */
 	if (crypto_is_pkcs12_data (contents->data, contents->len, NULL)) {
 		*out_file_format = NM_CRYPTO_FILE_FORMAT_PKCS12;
-		return contents;
+		goto out;
 	}
 
 	/* Check for plain DER format */
@@ -627,9 +763,14 @@ crypto_load_and_verify_certificate (const char *file,
 
 	if (*out_file_format != NM_CRYPTO_FILE_FORMAT_X509) {
 		g_byte_array_free (contents, TRUE);
-		contents = NULL;
+		return NULL;
 	}
 
+out:
+	if (cacheable) {
+		entry.cert_format = *out_file_format;
+		_file_cache_store (file, &entry);
+	}
 	return contents;
 }
 
@@ -668,17 +809,33 @@ crypto_is_pkcs12_file (const char *file, GError **error)
 {
 	GByteArray *contents;
 	gboolean success = FALSE;
+	FileCacheKey key;
+	FileCacheEntry entry;
+	gboolean cacheable;
 
 	g_return_val_if_fail (file != NULL, FALSE);
 
 	if (!crypto_init (error))
 		return FALSE;
 
+	cacheable = _file_cache_key_get (file, &key);
+	if (   cacheable
+	    && _file_cache_lookup (file, &key, &entry)
+	    && entry.has_is_pkcs12
+	    && entry.is_pkcs12)
+		return TRUE;
+
 	contents = file_to_g_byte_array (file, error);
 	if (contents) {
 		success = crypto_is_pkcs12_data (contents->data, contents->len, error);
 		g_byte_array_free (contents, TRUE);
 	}
+
+	if (success && cacheable) {
+		entry.has_is_pkcs12 = TRUE;
+		entry.is_pkcs12 = TRUE;
+		_file_cache_store (file, &entry);
+	}
 	return success;
 }
 
@@ -748,17 +905,39 @@ crypto_verify_private_key (const char *filename,
 {
 	GByteArray *contents;
 	NMCryptoFileFormat format = NM_CRYPTO_FILE_FORMAT_UNKNOWN;
+	gboolean is_encrypted = FALSE;
+	FileCacheKey key;
+	FileCacheEntry entry;
+	gboolean cacheable;
 
 	g_return_val_if_fail (filename != NULL, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
+	g_return_val_if_fail (out_is_encrypted == NULL || *out_is_encrypted == FALSE, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
 
 	if (!crypto_init (error))
 		return NM_CRYPTO_FILE_FORMAT_UNKNOWN;
 
+	/* Whether a password decrypts the key is not cached. */
+	cacheable = !password && _file_cache_key_get (filename, &key);
+	if (   cacheable
+	    && _file_cache_lookup (filename, &key, &entry)
+	    && entry.key_format != NM_CRYPTO_FILE_FORMAT_UNKNOWN) {
+		NM_SET_OUT (out_is_encrypted, entry.key_is_encrypted);
+		return entry.key_format;
+	}
+
 	contents = file_to_g_byte_array (filename, error);
 	if (contents) {
-		format = crypto_verify_private_key_data (contents->data, contents->len, password, out_is_encrypted, error);
+		format = crypto_verify_private_key_data (contents->data, contents->len, password, &is_encrypted, error);
 		g_byte_array_free (contents, TRUE);
 	}
+
+	if (cacheable && format != NM_CRYPTO_FILE_FORMAT_UNKNOWN) {
+		entry.key_format = format;
+		entry.key_is_encrypted = is_encrypted;
+		_file_cache_store (filename, &entry);
+	}
+
+	NM_SET_OUT (out_is_encrypted, is_encrypted);
 	return format;
 }
 
@@ -56,6 +56,14 @@ typedef struct {
 
 	/* D-Bus path of the connection, if any */
 	char *path;
+
+	/* Bumped on every modification of the connection or of one of
+	 * its settings. verify_generation records the value at which
+	 * verify_result/verify_error were computed. */
+	guint64 generation;
+	guint64 verify_generation;
+	NMSettingVerifyResult verify_result;
+	GError *verify_error;
 } NMConnectionPrivate;
 
 static NMConnectionPrivate *nm_connection_get_private (NMConnection *connection);
@@ -78,11 +86,18 @@ static NMSettingVerifyResult _nm_connection_verify (NMConnection *connection, GE
 
 /*************************************************************/
 
+static void
+_generation_bump (NMConnection *connection)
+{
+	NM_CONNECTION_GET_PRIVATE (connection)->generation++;
+}
+
 static void
 setting_changed_cb (NMSetting *setting,
                     GParamSpec *pspec,
                     NMConnection *self)
 {
+	_generation_bump (self);
 	g_signal_emit (self, signals[CHANGED], 0);
 }
 
@@ -103,6 +118,7 @@ _nm_connection_add_setting (NMConnection *connection, NMSetting *setting)
 	if ((s_old = g_hash_table_lookup (priv->settings, (gpointer) name)))
 		g_signal_handlers_disconnect_by_func (s_old, setting_changed_cb, connection);
 	g_hash_table_insert (priv->settings, (gpointer) name, setting);
+	priv->generation++;
 	/* Listen for property changes so we can emit the 'changed' signal */
 	g_signal_connect (setting, "notify", (GCallback) setting_changed_cb, connection);
 }
@@ -151,6 +167,7 @@ nm_connection_remove_setting (NMConnection *connection, GType setting_type)
 	if (setting) {
 		g_signal_handlers_disconnect_by_func (setting, setting_changed_cb, connection);
 		g_hash_table_remove (priv->settings, setting_name);
+		priv->generation++;
 		g_signal_emit (connection, signals[CHANGED], 0);
 	}
 }
@@ -330,6 +347,7 @@ _nm_connection_replace_settings (NMConnection *connection,
 
 	if (g_hash_table_size (priv->settings) > 0) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release, connection);
+		priv->generation++;
 		changed = TRUE;
 	} else
 		changed = (settings != NULL);
@@ -413,8 +431,10 @@ nm_connection_replace_settings_from_connection (NMConnection *connection,
 	priv = NM_CONNECTION_GET_PRIVATE (connection);
 	new_priv = NM_CONNECTION_GET_PRIVATE (new_connection);
 
-	if ((changed = g_hash_table_size (priv->settings) > 0))
+	if ((changed = g_hash_table_size (priv->settings) > 0)) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release, connection);
+		priv->generation++;
+	}
 
 	if (g_hash_table_size (new_priv->settings)) {
 		g_hash_table_iter_init (&iter, new_priv->settings);
@@ -444,6 +464,7 @@ nm_connection_clear_settings (NMConnection *connection)
 
 	if (g_hash_table_size (priv->settings) > 0) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release, connection);
+		priv->generation++;
 		g_signal_emit (connection, signals[CHANGED], 0);
 	}
 }
@@ -860,7 +881,7 @@ nm_connection_verify (NMConnection *connection, GError **error)
 }
 
 static NMSettingVerifyResult
-_nm_connection_verify (NMConnection *connection, GError **error)
+_nm_connection_verify_uncached (NMConnection *connection, GError **error)
 {
 	NMConnectionPrivate *priv;
 	NMSettingConnection *s_con;
@@ -979,6 +1000,31 @@ EXIT:
 	return success;
 }
 
+static NMSettingVerifyResult
+_nm_connection_verify (NMConnection *connection, GError **error)
+{
+	NMConnectionPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NM_SETTING_VERIFY_ERROR);
+	g_return_val_if_fail (!error || !*error, NM_SETTING_VERIFY_ERROR);
+
+	priv = NM_CONNECTION_GET_PRIVATE (connection);
+
+	/* The result only depends on the content of the settings, so it stays
+	 * valid until the connection is modified again. This relies on every
+	 * modification being notified: mutating a boxed value returned by a
+	 * getter (e.g. an NMIPAddress) in place is not noticed. */
+	if (priv->verify_generation != priv->generation) {
+		g_clear_error (&priv->verify_error);
+		priv->verify_result = _nm_connection_verify_uncached (connection, &priv->verify_error);
+		priv->verify_generation = priv->generation;
+	}
+
+	if (error && priv->verify_error)
+		*error = g_error_copy (priv->verify_error);
+	return priv->verify_result;
+}
+
 /**
  * nm_connection_verify_secrets:
  * @connection: the #NMConnection to verify in
@@ -1167,6 +1213,7 @@ nm_connection_update_secrets (NMConnection *connection,
 		                                             setting_dict ? setting_dict : secrets,
 		                                             error);
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
+		_generation_bump (connection);
 
 		g_clear_pointer (&setting_dict, g_variant_unref);
 
@@ -1197,6 +1244,7 @@ nm_connection_update_secrets (NMConnection *connection,
 			g_signal_handlers_block_by_func (setting, (GCallback) setting_changed_cb, connection);
 			success_detail = _nm_setting_update_secrets (setting, setting_dict, error);
 			g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
+			_generation_bump (connection);
 
 			g_variant_unref (setting_dict);
 
@@ -1299,6 +1347,7 @@ nm_connection_clear_secrets (NMConnection *connection)
 		g_signal_handlers_block_by_func (setting, (GCallback) setting_changed_cb, connection);
 		changed |= _nm_setting_clear_secrets (setting);
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
+		_generation_bump (connection);
 	}
 
 	g_signal_emit (connection, signals[SECRETS_CLEARED], 0);
@@ -1331,6 +1380,7 @@ nm_connection_clear_secrets_with_flags (NMConnection *connection,
 		g_signal_handlers_block_by_func (setting, (GCallback) setting_changed_cb, connection);
 		changed |= _nm_setting_clear_secrets_with_flags (setting, func, user_data);
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
+		_generation_bump (connection);
 	}
 
 	g_signal_emit (connection, signals[SECRETS_CLEARED], 0);
@@ -1882,6 +1932,24 @@ nm_connection_get_setting_dcb (NMConnection *connection)
 	return (NMSettingDcb *) nm_connection_get_setting (connection, NM_TYPE_SETTING_DCB);
 }
 
+/**
+ * nm_connection_get_setting_ethtool:
+ * @connection: the #NMConnection
+ *
+ * A shortcut to return any #NMSettingEthtool the connection might contain.
+ *
+ * Returns: (transfer none): an #NMSettingEthtool if the connection contains one, otherwise %NULL
+ *
+ * Since: 1.4
+ **/
+NMSettingEthtool *
+nm_connection_get_setting_ethtool (NMConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+
+	return (NMSettingEthtool *) nm_connection_get_setting (connection, NM_TYPE_SETTING_ETHTOOL);
+}
+
 /**
  * nm_connection_get_setting_generic:
  * @connection: the #NMConnection
@@ -2072,6 +2140,42 @@ nm_connection_get_setting_serial (NMConnection *connection)
 	return (NMSettingSerial *) nm_connection_get_setting (connection, NM_TYPE_SETTING_SERIAL);
 }
 
+/**
+ * nm_connection_get_setting_sriov:
+ * @connection: the #NMConnection
+ *
+ * A shortcut to return any #NMSettingSriov the connection might contain.
+ *
+ * Returns: (transfer none): an #NMSettingSriov if the connection contains one, otherwise %NULL
+ *
+ * Since: 1.4
+ **/
+NMSettingSriov *
+nm_connection_get_setting_sriov (NMConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+
+	return (NMSettingSriov *) nm_connection_get_setting (connection, NM_TYPE_SETTING_SRIOV);
+}
+
+/**
+ * nm_connection_get_setting_tc_config:
+ * @connection: the #NMConnection
+ *
+ * A shortcut to return any #NMSettingTCConfig the connection might contain.
+ *
+ * Returns: (transfer none): an #NMSettingTCConfig if the connection contains one, otherwise %NULL
+ *
+ * Since: 1.4
+ **/
+NMSettingTCConfig *
+nm_connection_get_setting_tc_config (NMConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+
+	return (NMSettingTCConfig *) nm_connection_get_setting (connection, NM_TYPE_SETTING_TC_CONFIG);
+}
+
 /**
  * nm_connection_get_setting_tun:
  * @connection: the #NMConnection
@@ -2246,6 +2350,7 @@ nm_connection_private_free (NMConnectionPrivate *priv)
 	g_hash_table_foreach_remove (priv->settings, _setting_release, self);
 	g_hash_table_destroy (priv->settings);
 	g_free (priv->path);
+	g_clear_error (&priv->verify_error);
 
 	g_slice_free (NMConnectionPrivate, priv);
 }
@@ -2269,6 +2374,7 @@ nm_connection_get_private (NMConnection *connection)
 
 		priv->self = connection;
 		priv->settings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+		priv->generation = 1;
 	}
 
 	return priv;
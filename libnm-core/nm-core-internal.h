@@ -46,6 +46,7 @@
 #include "nm-setting-cdma.h"
 #include "nm-setting-connection.h"
 #include "nm-setting-dcb.h"
+#include "nm-setting-ethtool.h"
 #include "nm-setting-generic.h"
 #include "nm-setting-gsm.h"
 #include "nm-setting-infiniband.h"
@@ -57,6 +58,8 @@
 #include "nm-setting-ppp.h"
 #include "nm-setting-pppoe.h"
 #include "nm-setting-serial.h"
+#include "nm-setting-sriov.h"
+#include "nm-setting-tc-config.h"
 #include "nm-setting-team-port.h"
 #include "nm-setting-team.h"
 #include "nm-setting-tun.h"
@@ -166,6 +169,18 @@ GPtrArray * _nm_utils_strv_to_ptrarray (char **strv);
 char **     _nm_utils_ptrarray_to_strv (GPtrArray *ptrarray);
 gboolean    _nm_utils_strv_equal (char **strv1, char **strv2);
 
+/* A hardware address in binary form, kept next to its string form where
+ * addresses are compared often. A zero @len means no (valid) address. */
+typedef struct {
+	guint8 len;
+	guint8 addr[NM_UTILS_HWADDR_LEN_MAX];
+} NMHwAddr;
+
+gboolean    _nm_hwaddr_from_str (NMHwAddr *hwaddr, const char *asc);
+void        _nm_hwaddr_from_bin (NMHwAddr *hwaddr, gconstpointer addr, gsize len);
+gboolean    _nm_hwaddr_equal (const NMHwAddr *hwaddr1, const NMHwAddr *hwaddr2);
+gboolean    _nm_hwaddr_matches_str (const NMHwAddr *hwaddr, const char *asc);
+
 gboolean _nm_utils_check_file (const char *filename,
                                gint64 check_owner,
                                NMUtilsCheckFilePredicate check_file,
@@ -277,6 +292,8 @@ gboolean _nm_setting_vlan_set_priorities (NMSettingVlan *setting,
                                           NMVlanPriorityMap map,
                                           const NMVlanQosMapping *qos_map,
                                           guint n_qos_map);
+const NMHwAddr *_nm_setting_wired_get_mac_address_bin (NMSettingWired *setting);
+
 void     _nm_setting_vlan_get_priorities (NMSettingVlan *setting,
                                           NMVlanPriorityMap map,
                                           NMVlanQosMapping **out_qos_map,
@@ -284,6 +301,10 @@ void     _nm_setting_vlan_get_priorities (NMSettingVlan *setting,
 
 /***********************************************************/
 
+const GVariantType *_nm_ip_route_attribute_get_type (const char *name);
+
+/***********************************************************/
+
 typedef enum {
 	NM_BOND_OPTION_TYPE_INT,
 	NM_BOND_OPTION_TYPE_STRING,
@@ -296,4 +317,21 @@ typedef enum {
 NMBondOptionType
 _nm_setting_bond_get_option_type (NMSettingBond *setting, const char *name);
 
+gboolean _nm_setting_bond_option_to_uint (const char *name, const char *value, guint *out_value);
+
+/***********************************************************/
+
+typedef struct {
+	guint index;
+	gboolean has_mac;
+	guint8 mac[ETH_ALEN];
+	/* -1 if not set */
+	int vlan;
+	guint qos;
+	int spoof_check;
+	int trust;
+} NMSriovVFConfig;
+
+gboolean _nm_setting_sriov_parse_vf (const char *str, NMSriovVFConfig *out_vf, GError **error);
+
 #endif
@@ -68,6 +68,7 @@
 #define NM_DBUS_INTERFACE_DEVICE_VXLAN      NM_DBUS_INTERFACE_DEVICE ".Vxlan"
 #define NM_DBUS_INTERFACE_DEVICE_GRE        NM_DBUS_INTERFACE_DEVICE ".Gre"
 #define NM_DBUS_INTERFACE_DEVICE_IP_TUNNEL  NM_DBUS_INTERFACE_DEVICE ".IPTunnel"
+#define NM_DBUS_INTERFACE_DEVICE_STATISTICS NM_DBUS_INTERFACE_DEVICE ".Statistics"
 
 #define NM_DBUS_INTERFACE_SETTINGS        "org.freedesktop.NetworkManager.Settings"
 #define NM_DBUS_PATH_SETTINGS             "/org/freedesktop/NetworkManager/Settings"
@@ -79,6 +80,9 @@
 #define NM_DBUS_INTERFACE_AGENT_MANAGER   NM_DBUS_INTERFACE ".AgentManager"
 #define NM_DBUS_PATH_AGENT_MANAGER        "/org/freedesktop/NetworkManager/AgentManager"
 
+#define NM_DBUS_INTERFACE_STATISTICS      NM_DBUS_INTERFACE ".Statistics"
+#define NM_DBUS_PATH_STATISTICS           "/org/freedesktop/NetworkManager/Statistics"
+
 #define NM_DBUS_INTERFACE_SECRET_AGENT    NM_DBUS_INTERFACE ".SecretAgent"
 #define NM_DBUS_PATH_SECRET_AGENT         "/org/freedesktop/NetworkManager/SecretAgent"
 
@@ -605,6 +609,8 @@ typedef enum {
  *   the D-Bus API.
  * @NM_SECRET_AGENT_GET_SECRETS_FLAG_NO_ERRORS: Internal flag, not part of
  *   the D-Bus API.
+ * @NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED: Internal flag, not part of
+ *   the D-Bus API.
  *
  * #NMSecretAgentGetSecretsFlags values modify the behavior of a GetSecrets request.
  */
@@ -617,6 +623,7 @@ typedef enum { /*< flags >*/
 	/* Internal to NM; not part of the D-Bus API */
 	NM_SECRET_AGENT_GET_SECRETS_FLAG_ONLY_SYSTEM = 0x80000000,
 	NM_SECRET_AGENT_GET_SECRETS_FLAG_NO_ERRORS = 0x40000000,
+	NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED = 0x20000000,
 } NMSecretAgentGetSecretsFlags;
 
 /**
@@ -636,6 +643,20 @@ typedef enum /*< flags >*/ {
 	NM_SECRET_AGENT_CAPABILITY_LAST = NM_SECRET_AGENT_CAPABILITY_VPN_HINTS
 } NMSecretAgentCapabilities;
 
+/**
+ * NMSettingsAddConnectionsFlags:
+ * @NM_SETTINGS_ADD_CONNECTIONS_FLAG_NONE: no special behavior; the
+ *   connections are saved to disk.
+ * @NM_SETTINGS_ADD_CONNECTIONS_FLAG_UNSAVED: don't save the connections
+ *   to disk, like AddConnectionUnsaved().
+ *
+ * Flags for the AddConnections() method of the Settings interface.
+ */
+typedef enum /*< flags >*/ {
+	NM_SETTINGS_ADD_CONNECTIONS_FLAG_NONE = 0x0,
+	NM_SETTINGS_ADD_CONNECTIONS_FLAG_UNSAVED = 0x1,
+} NMSettingsAddConnectionsFlags;
+
 #ifndef NM_VERSION_H
 #undef NM_AVAILABLE_IN_1_2
 #endif
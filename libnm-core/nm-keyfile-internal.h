@@ -95,6 +95,14 @@ NMConnection *nm_keyfile_read (GKeyFile *keyfile,
                                void *user_data,
                                GError **error);
 
+NMConnection *nm_keyfile_read_data (const char *data,
+                                    gsize length,
+                                    const char *keyfile_name,
+                                    const char *base_dir,
+                                    NMKeyfileReadHandler handler,
+                                    void *user_data,
+                                    GError **error);
+
 /*********************************************************/
 
 typedef enum {
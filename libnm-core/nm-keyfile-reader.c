@@ -422,6 +422,66 @@ read_one_ip_address_or_route (KeyfileReaderInfo *info,
 	return result;
 }
 
+/* Reads the attributes of a route from "routeN_options", for example
+ * "initcwnd=10,lock-mtu=true,congctl=cubic". */
+static void
+read_route_options (KeyfileReaderInfo *info,
+                    const char *property_name,
+                    const char *setting_name,
+                    const char *key_name,
+                    NMIPRoute *route)
+{
+	gs_free char *options_key = NULL;
+	gs_free char *value = NULL;
+	gs_strfreev char **options = NULL;
+	char **iter;
+
+	options_key = g_strdup_printf ("%s_options", key_name);
+	value = nm_keyfile_plugin_kf_get_string (info->keyfile, setting_name, options_key, NULL);
+	if (!value || !value[0])
+		return;
+
+	options = g_strsplit_set (value, ",;", 0);
+	for (iter = options; *iter; iter++) {
+		const GVariantType *type;
+		GVariant *variant = NULL;
+		char *name = g_strstrip (*iter);
+		char *val;
+
+		if (!name[0])
+			continue;
+
+		val = strchr (name, '=');
+		if (val)
+			*(val++) = '\0';
+		type = _nm_ip_route_attribute_get_type (name);
+
+		if (!type || !val)
+			;
+		else if (g_variant_type_equal (type, G_VARIANT_TYPE_UINT32)) {
+			gint64 num = _nm_utils_ascii_str_to_int64 (val, 10, 0, G_MAXUINT32, -1);
+
+			if (num != -1)
+				variant = g_variant_new_uint32 (num);
+		} else if (g_variant_type_equal (type, G_VARIANT_TYPE_BOOLEAN)) {
+			if (NM_IN_STRSET (val, "true", "yes", "1"))
+				variant = g_variant_new_boolean (TRUE);
+			else if (NM_IN_STRSET (val, "false", "no", "0"))
+				variant = g_variant_new_boolean (FALSE);
+		} else if (val[0])
+			variant = g_variant_new_string (val);
+
+		if (!variant) {
+			if (!handle_warn (info, property_name, NM_KEYFILE_WARN_SEVERITY_WARN,
+			                  _("ignoring invalid route option '%s' in %s"),
+			                  name, options_key))
+				return;
+			continue;
+		}
+		nm_ip_route_set_attribute (route, name, variant);
+	}
+}
+
 static void
 ip_address_or_route_parser (KeyfileReaderInfo *info, NMSetting *setting, const char *key)
 {
@@ -457,6 +517,8 @@ ip_address_or_route_parser (KeyfileReaderInfo *info, NMSetting *setting, const c
 
 			item = read_one_ip_address_or_route (info, key, setting_name, key_name, ipv6, routes,
 			                                     gateway ? NULL : &gateway, setting);
+			if (item && routes && !info->error)
+				read_route_options (info, key, setting_name, key_name, item);
 			g_free (key_name);
 
 			if (info->error) {
@@ -1273,6 +1335,18 @@ static KeyParser key_parsers[] = {
 	{ NULL, NULL, FALSE }
 };
 
+static const KeyParser *
+_key_parser_find (const char *setting_name, const char *key)
+{
+	const KeyParser *parser;
+
+	for (parser = key_parsers; parser->setting_name; parser++) {
+		if (!strcmp (parser->setting_name, setting_name) && !strcmp (parser->key, key))
+			return parser;
+	}
+	return NULL;
+}
+
 static void
 set_default_for_missing_key (NMSetting *setting, const char *property)
 {
@@ -1298,7 +1372,7 @@ read_one_setting_value (NMSetting *setting,
 	GType type;
 	gs_free_error GError *err = NULL;
 	gboolean check_for_key = TRUE;
-	KeyParser *parser = &key_parsers[0];
+	const KeyParser *parser;
 
 	if (info->error)
 		return;
@@ -1319,13 +1393,9 @@ read_one_setting_value (NMSetting *setting,
 	setting_name = nm_setting_get_name (setting);
 
 	/* Look through the list of handlers for non-standard format key values */
-	while (parser->setting_name) {
-		if (!strcmp (parser->setting_name, setting_name) && !strcmp (parser->key, key)) {
-			check_for_key = parser->check_for_key;
-			break;
-		}
-		parser++;
-	}
+	parser = _key_parser_find (setting_name, key);
+	if (parser)
+		check_for_key = parser->check_for_key;
 
 	/* VPN properties don't have the exact key name */
 	if (NM_IS_SETTING_VPN (setting))
@@ -1357,7 +1427,7 @@ read_one_setting_value (NMSetting *setting,
 	/* If there's a custom parser for this key, handle that before the generic
 	 * parsers below.
 	 */
-	if (parser->setting_name) {
+	if (parser) {
 		(*parser->parser) (info, setting, key);
 		return;
 	}
@@ -1547,6 +1617,87 @@ read_vpn_secrets (KeyfileReaderInfo *info, NMSettingVpn *s_vpn)
 	g_strfreev (keys);
 }
 
+static const char *
+_get_base_dir (const char *keyfile_name, const char *base_dir, char **base_dir_free)
+{
+	if (base_dir)
+		return base_dir;
+
+	/* basedir is not given. Prefer it from the keyfile_name */
+	if (keyfile_name && keyfile_name[0] == '/')
+		return (*base_dir_free = g_path_get_dirname (keyfile_name));
+
+	/* if keyfile is not given or not an absolute path, fallback
+	 * to current working directory. */
+	return (*base_dir_free = g_get_current_dir ());
+}
+
+/* Fills in what the settings read from info->keyfile don't provide. */
+static gboolean
+_read_connection_finish (KeyfileReaderInfo *info, const char *keyfile_name, gboolean vpn_secrets)
+{
+	NMConnection *connection = info->connection;
+	NMSettingConnection *s_con;
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (!s_con) {
+		s_con = NM_SETTING_CONNECTION (nm_setting_connection_new ());
+		nm_connection_add_setting (connection, NM_SETTING (s_con));
+	}
+
+	/* Make sure that we have 'id' even if not explictly specified in the keyfile */
+	if (   keyfile_name
+	    && !nm_setting_connection_get_id (s_con)) {
+		char *base_name;
+
+		base_name = g_path_get_basename (keyfile_name);
+		g_object_set (s_con, NM_SETTING_CONNECTION_ID, base_name, NULL);
+		g_free (base_name);
+	}
+
+	/* Make sure that we have 'uuid' even if not explictly specified in the keyfile */
+	if (   keyfile_name
+	    && !nm_setting_connection_get_uuid (s_con)) {
+		char *hashed_uuid;
+
+		hashed_uuid = _nm_utils_uuid_generate_from_strings ("keyfile", keyfile_name, NULL);
+		g_object_set (s_con, NM_SETTING_CONNECTION_UUID, hashed_uuid, NULL);
+		g_free (hashed_uuid);
+	}
+
+	/* Make sure that we have 'interface-name' even if it was specified in the
+	 * "wrong" (ie, deprecated) group.
+	 */
+	if (   info->keyfile
+	    && !nm_setting_connection_get_interface_name (s_con)
+	    && nm_setting_connection_get_connection_type (s_con)) {
+		char *interface_name;
+
+		interface_name = g_key_file_get_string (info->keyfile,
+		                                        nm_setting_connection_get_connection_type (s_con),
+		                                        "interface-name",
+		                                        NULL);
+		if (interface_name) {
+			g_object_set (s_con, NM_SETTING_CONNECTION_INTERFACE_NAME, interface_name, NULL);
+			g_free (interface_name);
+		}
+	}
+
+	/* Handle vpn secrets after the 'vpn' setting was read */
+	if (vpn_secrets) {
+		NMSettingVpn *s_vpn;
+
+		s_vpn = nm_connection_get_setting_vpn (connection);
+		if (s_vpn) {
+			read_vpn_secrets (info, s_vpn);
+			if (info->error)
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 /**
  * nm_keyfile_read:
  * @keyfile: the keyfile from which to create the connection
@@ -1579,7 +1730,6 @@ nm_keyfile_read (GKeyFile *keyfile,
                  GError **error)
 {
 	NMConnection *connection = NULL;
-	NMSettingConnection *s_con;
 	NMSetting *setting;
 	gchar **groups;
 	gsize length;
@@ -1591,17 +1741,7 @@ nm_keyfile_read (GKeyFile *keyfile,
 	g_return_val_if_fail (keyfile, NULL);
 	g_return_val_if_fail (!error || !*error, NULL);
 
-	if (!base_dir) {
-		/* basedir is not given. Prefer it from the keyfile_name */
-		if (keyfile_name && keyfile_name[0] == '/') {
-			base_dir = base_dir_free = g_path_get_dirname (keyfile_name);
-		} else {
-			/* if keyfile is not given or not an absolute path, fallback
-			 * to current working directory. */
-			base_dir = base_dir_free = g_get_current_dir ();
-		}
-	} else
-		g_return_val_if_fail ("/", NULL);
+	base_dir = _get_base_dir (keyfile_name, base_dir, &base_dir_free);
 
 	connection = nm_simple_connection_new ();
 
@@ -1631,64 +1771,490 @@ nm_keyfile_read (GKeyFile *keyfile,
 	}
 	g_strfreev (groups);
 
-	s_con = nm_connection_get_setting_connection (connection);
-	if (!s_con) {
-		s_con = NM_SETTING_CONNECTION (nm_setting_connection_new ());
-		nm_connection_add_setting (connection, NM_SETTING (s_con));
+	if (!_read_connection_finish (&info, keyfile_name, vpn_secrets))
+		goto out_error;
+
+	return connection;
+out_error:
+	g_propagate_error (error, info.error);
+	g_free (connection);
+	return NULL;
+}
+
+/*****************************************************************************/
+
+/* Longer keys are left to GKeyFile. */
+#define KF_KEY_MAX 127
+
+/* A part of the buffer given to nm_keyfile_read_data(), not NUL terminated. */
+typedef struct {
+	const char *str;
+	gsize len;
+} KfView;
+
+typedef struct {
+	KfView key;
+	KfView value;
+} KfEntry;
+
+typedef struct {
+	KfView name;
+	guint entries_start;
+	guint entries_len;
+} KfGroup;
+
+static gboolean
+_kf_view_equal (const KfView *view, const char *str)
+{
+	return    view->len == strlen (str)
+	       && !memcmp (view->str, str, view->len);
+}
+
+static gboolean
+_kf_view_to_uint64 (const KfView *view, guint64 *out)
+{
+	guint64 v = 0;
+	gsize i;
+
+	/* only plain numbers that GKeyFile reads the same for every type and
+	 * glib version, 19 digits always fit. */
+	if (!view->len || view->len > 19)
+		return FALSE;
+	for (i = 0; i < view->len; i++) {
+		if (!g_ascii_isdigit (view->str[i]))
+			return FALSE;
+		v = v * 10 + (view->str[i] - '0');
 	}
+	*out = v;
+	return TRUE;
+}
 
-	/* Make sure that we have 'id' even if not explictly specified in the keyfile */
-	if (   keyfile_name
-	    && !nm_setting_connection_get_id (s_con)) {
-		char *base_name;
+static gboolean
+_kf_view_to_int64 (const KfView *view, gint64 *out)
+{
+	KfView digits = *view;
+	guint64 v;
 
-		base_name = g_path_get_basename (keyfile_name);
-		g_object_set (s_con, NM_SETTING_CONNECTION_ID, base_name, NULL);
-		g_free (base_name);
+	if (digits.len && digits.str[0] == '-') {
+		digits.str++;
+		digits.len--;
 	}
+	if (digits.len > 18 || !_kf_view_to_uint64 (&digits, &v))
+		return FALSE;
+	*out = digits.len != view->len ? -((gint64) v) : (gint64) v;
+	return TRUE;
+}
 
-	/* Make sure that we have 'uuid' even if not explictly specified in the keyfile */
-	if (   keyfile_name
-	    && !nm_setting_connection_get_uuid (s_con)) {
-		char *hashed_uuid;
+static gboolean
+_kf_name_is_plain (const char *str, gsize len, gboolean is_key)
+{
+	gsize i;
 
-		hashed_uuid = _nm_utils_uuid_generate_from_strings ("keyfile", keyfile_name, NULL);
-		g_object_set (s_con, NM_SETTING_CONNECTION_UUID, hashed_uuid, NULL);
-		g_free (hashed_uuid);
+	if (!len)
+		return FALSE;
+	for (i = 0; i < len; i++) {
+		char ch = str[i];
+
+		if (is_key) {
+			if (!g_ascii_isalnum (ch) && !NM_IN_SET (ch, '-', '_', '.'))
+				return FALSE;
+		} else if ((guchar) ch < 0x20 || NM_IN_SET (ch, '[', ']'))
+			return FALSE;
 	}
+	return TRUE;
+}
 
-	/* Make sure that we have 'interface-name' even if it was specified in the
-	 * "wrong" (ie, deprecated) group.
-	 */
-	if (   !nm_setting_connection_get_interface_name (s_con)
-	    && nm_setting_connection_get_connection_type (s_con)) {
-		char *interface_name;
+/* Splits @data into groups and key-value pairs in a single pass without
+ * copying anything. Whitespace is handled like GKeyFile does: lines and
+ * values are chugged, keys are chomped.
+ *
+ * Returns %FALSE for everything the fast path doesn't read exactly like
+ * GKeyFile: syntax errors, invalid UTF-8, carriage returns, empty or
+ * repeated groups, locale or otherwise unusual key names, ... */
+static gboolean
+_kf_tokenize (const char *data, gsize length, GArray *groups, GArray *entries)
+{
+	const char *p = data;
+	const char *end = data + length;
+	KfGroup *group = NULL;
+	guint i;
+
+	if (   length
+	    && (   memchr (data, '\0', length)
+	        || !g_utf8_validate (data, length, NULL)))
+		return FALSE;
 
-		interface_name = g_key_file_get_string (keyfile,
-		                                        nm_setting_connection_get_connection_type (s_con),
-		                                        "interface-name",
-		                                        NULL);
-		if (interface_name) {
-			g_object_set (s_con, NM_SETTING_CONNECTION_INTERFACE_NAME, interface_name, NULL);
-			g_free (interface_name);
+	while (p < end) {
+		const char *line = p;
+		const char *line_end;
+		const char *eq, *key_end, *value;
+		KfEntry *entry;
+
+		line_end = memchr (p, '\n', end - p);
+		if (!line_end)
+			line_end = end;
+		p = line_end < end ? line_end + 1 : end;
+
+		while (line < line_end && g_ascii_isspace (*line))
+			line++;
+		if (line == line_end || *line == '#')
+			continue;
+		if (memchr (line, '\r', line_end - line))
+			return FALSE;
+
+		if (*line == '[') {
+			KfGroup g = { .entries_start = entries->len };
+
+			/* GKeyFile has no API for adding an empty group to
+			 * info->keyfile */
+			if (group && !group->entries_len)
+				return FALSE;
+
+			if (   line_end[-1] != ']'
+			    || !_kf_name_is_plain (line + 1, line_end - line - 2, FALSE))
+				return FALSE;
+			g.name.str = line + 1;
+			g.name.len = line_end - line - 2;
+
+			for (i = 0; i < groups->len; i++) {
+				const KfGroup *other = &g_array_index (groups, KfGroup, i);
+
+				if (   other->name.len == g.name.len
+				    && !memcmp (other->name.str, g.name.str, g.name.len))
+					return FALSE;
+			}
+			g_array_append_val (groups, g);
+			group = &g_array_index (groups, KfGroup, groups->len - 1);
+			continue;
 		}
+
+		/* GKeyFile rejects keys outside of a group */
+		if (!group)
+			return FALSE;
+
+		eq = memchr (line, '=', line_end - line);
+		if (!eq)
+			return FALSE;
+		key_end = eq;
+		while (key_end > line && g_ascii_isspace (key_end[-1]))
+			key_end--;
+		if (   key_end - line > KF_KEY_MAX
+		    || !_kf_name_is_plain (line, key_end - line, TRUE))
+			return FALSE;
+		value = eq + 1;
+		while (value < line_end && g_ascii_isspace (*value))
+			value++;
+
+		g_array_set_size (entries, entries->len + 1);
+		entry = &g_array_index (entries, KfEntry, entries->len - 1);
+		entry->key.str = line;
+		entry->key.len = key_end - line;
+		entry->value.str = value;
+		entry->value.len = line_end - value;
+		group->entries_len++;
 	}
 
-	/* Handle vpn secrets after the 'vpn' setting was read */
-	if (vpn_secrets) {
-		NMSettingVpn *s_vpn;
+	return !group || group->entries_len > 0;
+}
 
-		s_vpn = nm_connection_get_setting_vpn (connection);
-		if (s_vpn) {
-			read_vpn_secrets (&info, s_vpn);
-			if (info.error)
-				goto out_error;
+static void
+_kf_set_value (KeyfileReaderInfo *info, const char *key, const KfView *value)
+{
+	gs_free char *str = NULL;
+
+	if (!info->keyfile)
+		info->keyfile = g_key_file_new ();
+	str = g_strndup (value->str, value->len);
+	g_key_file_set_value (info->keyfile, info->group, key, str);
+}
+
+static void
+_kf_key_to_buf (char *buf, const KfView *key)
+{
+	memcpy (buf, key->str, key->len);
+	buf[key->len] = '\0';
+}
+
+/* Settings that read keys other than their properties or do something
+ * for missing keys. They are read from a GKeyFile. */
+static gboolean
+_setting_needs_keyfile (GType type, const char *setting_name)
+{
+	const KeyParser *parser;
+
+	if (   g_type_is_a (type, NM_TYPE_SETTING_VPN)
+	    || g_type_is_a (type, NM_TYPE_SETTING_BOND)
+	    || g_type_is_a (type, NM_TYPE_SETTING_WIRELESS))
+		return TRUE;
+
+	for (parser = key_parsers; parser->setting_name; parser++) {
+		if (   !parser->check_for_key
+		    && !strcmp (parser->setting_name, setting_name))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Sets the property from @value if it is of a simple type and the value
+ * reads the same as with GKeyFile. Otherwise, it returns %FALSE and
+ * read_one_setting_value() must handle it, including the warnings. */
+static gboolean
+_read_one_setting_value_fast (NMSetting *setting, const char *key, GType type, const KfView *value)
+{
+	gint64 v;
+
+	if (type == G_TYPE_STRING) {
+		gs_free char *str = NULL;
+
+		if (memchr (value->str, '\\', value->len))
+			return FALSE;
+		str = g_strndup (value->str, value->len);
+		g_object_set (setting, key, str, NULL);
+		return TRUE;
+	}
+
+	if (type == G_TYPE_BOOLEAN) {
+		gboolean bool_val;
+
+		if (_kf_view_equal (value, "true") || _kf_view_equal (value, "1"))
+			bool_val = TRUE;
+		else if (_kf_view_equal (value, "false") || _kf_view_equal (value, "0"))
+			bool_val = FALSE;
+		else
+			return FALSE;
+		g_object_set (setting, key, bool_val, NULL);
+		return TRUE;
+	}
+
+	if (type == G_TYPE_UINT64) {
+		guint64 uint_val;
+
+		if (!_kf_view_to_uint64 (value, &uint_val))
+			return FALSE;
+		g_object_set (setting, key, uint_val, NULL);
+		return TRUE;
+	}
+
+	if (!_kf_view_to_int64 (value, &v))
+		return FALSE;
+
+	if (type == G_TYPE_INT64)
+		g_object_set (setting, key, v, NULL);
+	else if (type == G_TYPE_INT || G_TYPE_IS_ENUM (type)) {
+		if (v < G_MININT32 || v > G_MAXINT32)
+			return FALSE;
+		g_object_set (setting, key, (gint) v, NULL);
+	} else if (type == G_TYPE_UINT) {
+		if (v < 0 || v > G_MAXINT32)
+			return FALSE;
+		g_object_set (setting, key, (gint) v, NULL);
+	} else if (type == G_TYPE_CHAR) {
+		if (v < G_MININT8 || v > G_MAXINT8)
+			return FALSE;
+		g_object_set (setting, key, (gint) v, NULL);
+	} else if (G_TYPE_IS_FLAGS (type)) {
+		if (v < 0 || v > G_MAXUINT)
+			return FALSE;
+		g_object_set (setting, key, (guint) v, NULL);
+	} else
+		return FALSE;
+	return TRUE;
+}
+
+/* Like read_setting(), but only visits the keys that are present. The
+ * values of simple properties are set directly from the buffer, all
+ * other keys are copied to info->keyfile and read from there. */
+static NMSetting *
+_read_setting_from_entries (KeyfileReaderInfo *info, const KfEntry *entries, guint n_entries)
+{
+	const char *alias;
+	const char *setting_name;
+	GType type;
+	NMSetting *setting;
+	GObjectClass *klass;
+	char key[KF_KEY_MAX + 1];
+	guint i;
+
+	alias = nm_keyfile_plugin_get_setting_name_for_alias (info->group);
+	if (!alias)
+		alias = info->group;
+
+	type = nm_setting_lookup_type (alias);
+	if (!type || _setting_needs_keyfile (type, alias)) {
+		for (i = 0; i < n_entries; i++) {
+			_kf_key_to_buf (key, &entries[i].key);
+			_kf_set_value (info, key, &entries[i].value);
+		}
+		return read_setting (info);
+	}
+
+	setting = g_object_new (type, NULL);
+	setting_name = nm_setting_get_name (setting);
+	klass = G_OBJECT_GET_CLASS (setting);
+
+	info->setting = setting;
+	for (i = 0; i < n_entries && !info->error; i++) {
+		GValue value = G_VALUE_INIT;
+		GParamSpec *pspec;
+
+		_kf_key_to_buf (key, &entries[i].key);
+
+		pspec = g_object_class_find_property (klass, key);
+		if (!pspec) {
+			/* not read for the setting, but maybe for the connection,
+			 * like a deprecated 'interface-name'. */
+			_kf_set_value (info, key, &entries[i].value);
+			continue;
+		}
+
+		/* the same properties that read_one_setting_value() skips */
+		if (   !(pspec->flags & G_PARAM_WRITABLE)
+		    || !strcmp (key, NM_SETTING_NAME)
+		    || (   NM_IS_SETTING_CONNECTION (setting)
+		        && !strcmp (key, NM_SETTING_CONNECTION_READ_ONLY)))
+			continue;
+
+		if (   !_key_parser_find (setting_name, key)
+		    && _read_one_setting_value_fast (setting, key, G_PARAM_SPEC_VALUE_TYPE (pspec), &entries[i].value))
+			continue;
+
+		_kf_set_value (info, key, &entries[i].value);
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+		read_one_setting_value (setting, key, &value, pspec->flags, info);
+		g_value_unset (&value);
+	}
+	info->setting = NULL;
+
+	if (info->error) {
+		g_object_unref (setting);
+		return NULL;
+	}
+	return setting;
+}
+
+/**
+ * nm_keyfile_read_data:
+ * @data: the content of the keyfile
+ * @length: the length of @data
+ * @keyfile_name: see nm_keyfile_read()
+ * @base_dir: see nm_keyfile_read()
+ * @handler: read handler
+ * @user_data: user data for read handler
+ * @error: error
+ *
+ * Like nm_keyfile_read(), but parses @data in a single pass without
+ * building a #GKeyFile first. The values of simple properties are set
+ * right from @data, only the keys that need one of the special parsers
+ * are copied to a #GKeyFile. Keyfiles that the tokenizer doesn't handle
+ * exactly like GKeyFile are loaded with g_key_file_load_from_data() and
+ * read by nm_keyfile_read().
+ *
+ * The @keyfile argument of @handler only contains the keys that are
+ * read from a #GKeyFile.
+ *
+ * Returns: (transfer full): on success, returns the created connection.
+ */
+NMConnection *
+nm_keyfile_read_data (const char *data,
+                      gsize length,
+                      const char *keyfile_name,
+                      const char *base_dir,
+                      NMKeyfileReadHandler handler,
+                      void *user_data,
+                      GError **error)
+{
+	gs_unref_array GArray *groups = NULL;
+	gs_unref_array GArray *entries = NULL;
+	NMConnection *connection;
+	NMSetting *setting;
+	gboolean vpn_secrets = FALSE;
+	KeyfileReaderInfo info = { 0 };
+	gs_free char *base_dir_free = NULL;
+	gs_strfreev char **names = NULL;
+	guint i, j;
+
+	g_return_val_if_fail (data || !length, NULL);
+	g_return_val_if_fail (!error || !*error, NULL);
+
+	groups = g_array_new (FALSE, FALSE, sizeof (KfGroup));
+	entries = g_array_new (FALSE, FALSE, sizeof (KfEntry));
+
+	if (_kf_tokenize (data, length, groups, entries)) {
+		names = g_new0 (char *, groups->len + 1);
+		for (i = 0; i < groups->len; i++) {
+			const KfGroup *group = &g_array_index (groups, KfGroup, i);
+
+			names[i] = g_strndup (group->name.str, group->name.len);
 		}
+		/* the GKeyFile readers may look at another group for an alias */
+		for (i = 0; names && i < groups->len; i++) {
+			const char *a = nm_keyfile_plugin_get_setting_name_for_alias (names[i]) ?: names[i];
+
+			for (j = i + 1; j < groups->len; j++) {
+				if (!strcmp (a, nm_keyfile_plugin_get_setting_name_for_alias (names[j]) ?: names[j])) {
+					g_strfreev (names);
+					names = NULL;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!names) {
+		gs_unref_keyfile GKeyFile *keyfile = NULL;
+
+		keyfile = g_key_file_new ();
+		if (!g_key_file_load_from_data (keyfile, data, length, G_KEY_FILE_NONE, error))
+			return NULL;
+		return nm_keyfile_read (keyfile, keyfile_name, base_dir, handler, user_data, error);
 	}
 
+	base_dir = _get_base_dir (keyfile_name, base_dir, &base_dir_free);
+
+	connection = nm_simple_connection_new ();
+
+	info.connection = connection;
+	info.base_dir = base_dir;
+	info.handler = handler;
+	info.user_data = user_data;
+
+	for (i = 0; i < groups->len; i++) {
+		const KfGroup *group = &g_array_index (groups, KfGroup, i);
+		const KfEntry *group_entries = &g_array_index (entries, KfEntry, group->entries_start);
+
+		info.group = names[i];
+
+		/* Only read out secrets when needed */
+		if (!strcmp (names[i], NM_KEYFILE_GROUP_VPN_SECRETS)) {
+			char key[KF_KEY_MAX + 1];
+
+			for (j = 0; j < group->entries_len; j++) {
+				_kf_key_to_buf (key, &group_entries[j].key);
+				_kf_set_value (&info, key, &group_entries[j].value);
+			}
+			info.group = NULL;
+			vpn_secrets = TRUE;
+			continue;
+		}
+
+		setting = _read_setting_from_entries (&info, group_entries, group->entries_len);
+		info.group = NULL;
+		if (info.error)
+			goto out_error;
+		if (setting)
+			nm_connection_add_setting (connection, setting);
+	}
+
+	if (!_read_connection_finish (&info, keyfile_name, vpn_secrets))
+		goto out_error;
+
+	if (info.keyfile)
+		g_key_file_unref (info.keyfile);
 	return connection;
 out_error:
 	g_propagate_error (error, info.error);
-	g_free (connection);
+	if (info.keyfile)
+		g_key_file_unref (info.keyfile);
+	g_object_unref (connection);
 	return NULL;
 }
@@ -121,6 +121,58 @@ ip6_addr_gen_mode_writer (KeyfileWriterInfo *info,
 	                                 str);
 }
 
+static int
+sort_hash_keys (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	return g_strcmp0 (*((const char **) a), *((const char **) b));
+}
+
+/* Writes the route attributes that NetworkManager applies to the
+ * route as "routeN_options=name=value,...". */
+static void
+write_route_options (GKeyFile *file,
+                     const char *setting_name,
+                     const char *key_name,
+                     NMIPRoute *route)
+{
+	gs_strfreev char **names = NULL;
+	gs_free char *options_key = NULL;
+	GString *str = NULL;
+	guint i;
+
+	names = nm_ip_route_get_attribute_names (route);
+	if (!names[0])
+		return;
+	g_qsort_with_data (names, g_strv_length (names), sizeof (char *), sort_hash_keys, NULL);
+
+	for (i = 0; names[i]; i++) {
+		const GVariantType *type = _nm_ip_route_attribute_get_type (names[i]);
+		GVariant *value = nm_ip_route_get_attribute (route, names[i]);
+
+		/* other attributes are only kept on D-Bus */
+		if (!type || !g_variant_is_of_type (value, type))
+			continue;
+
+		if (!str)
+			str = g_string_new (NULL);
+		else
+			g_string_append_c (str, ',');
+		g_string_append_printf (str, "%s=", names[i]);
+		if (g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32))
+			g_string_append_printf (str, "%u", (guint) g_variant_get_uint32 (value));
+		else if (g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN))
+			g_string_append (str, g_variant_get_boolean (value) ? "true" : "false");
+		else
+			g_string_append (str, g_variant_get_string (value, NULL));
+	}
+	if (!str)
+		return;
+
+	options_key = g_strdup_printf ("%s_options", key_name);
+	nm_keyfile_plugin_kf_set_string (file, setting_name, options_key, str->str);
+	g_string_free (str, TRUE);
+}
+
 static void
 write_ip_values (GKeyFile *file,
                  const char *setting_name,
@@ -182,6 +234,9 @@ write_ip_values (GKeyFile *file,
 
 		sprintf (key_name_idx, "%d", i + 1);
 		nm_keyfile_plugin_kf_set_string (file, setting_name, key_name, output->str);
+
+		if (is_route)
+			write_route_options (file, setting_name, key_name, array->pdata[i]);
 	}
 	g_string_free (output, TRUE);
 }
@@ -233,12 +288,6 @@ route_writer (KeyfileWriterInfo *info,
 		write_ip_values (info->keyfile, setting_name, array, NULL, TRUE);
 }
 
-static int
-sort_hash_keys (gconstpointer a, gconstpointer b, gpointer user_data)
-{
-	return g_strcmp0 (*((const char **) a), *((const char **) b));
-}
-
 static void
 write_hash_of_string (GKeyFile *file,
                       NMSetting *setting,
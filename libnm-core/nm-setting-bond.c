@@ -463,6 +463,54 @@ _nm_setting_bond_get_option_type (NMSettingBond *setting, const char *name)
 	g_assert_not_reached ();
 }
 
+/**
+ * _nm_setting_bond_option_to_uint:
+ * @name: the name of an integer bond option, or of one that accepts either
+ *   an integer or a name
+ * @value: the value of the option
+ * @out_value: (out): the numeric value, as the kernel expects it
+ *
+ * Returns: %TRUE if @value is valid for @name and was converted.
+ **/
+gboolean
+_nm_setting_bond_option_to_uint (const char *name, const char *value, guint *out_value)
+{
+	guint i, j;
+	gint64 v;
+
+	g_return_val_if_fail (name, FALSE);
+	g_return_val_if_fail (out_value, FALSE);
+
+	if (!value || !value[0])
+		return FALSE;
+
+	for (i = 0; i < G_N_ELEMENTS (defaults); i++) {
+		if (nm_streq (defaults[i].opt, name))
+			break;
+	}
+	if (i == G_N_ELEMENTS (defaults))
+		return FALSE;
+
+	if (!NM_IN_SET (defaults[i].opt_type, NM_BOND_OPTION_TYPE_INT, NM_BOND_OPTION_TYPE_BOTH))
+		return FALSE;
+
+	v = _nm_utils_ascii_str_to_int64 (value, 10, defaults[i].min, defaults[i].max, -1);
+	if (v != -1) {
+		*out_value = v;
+		return TRUE;
+	}
+
+	if (defaults[i].opt_type == NM_BOND_OPTION_TYPE_BOTH) {
+		for (j = 0; defaults[i].list[j]; j++) {
+			if (nm_streq (defaults[i].list[j], value)) {
+				*out_value = j;
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
 static gboolean
 verify (NMSetting *setting, NMConnection *connection, GError **error)
 {
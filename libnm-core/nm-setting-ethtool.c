@@ -0,0 +1,867 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-setting-ethtool.h"
+#include "nm-setting-private.h"
+
+/**
+ * SECTION:nm-setting-ethtool
+ * @short_description: Describes the offload, ring, interrupt coalescing
+ *   and queue steering settings of a device
+ *
+ * The #NMSettingEthtool object is a #NMSetting subclass that describes
+ * hardware properties of the device that are configured with the ethtool
+ * ioctls when the connection is activated. Properties that are left at
+ * their default are not changed.
+ *
+ * The receive and transmit packet steering properties are written to the
+ * queues of the device in sysfs and apply to all device types.
+ **/
+
+G_DEFINE_TYPE_WITH_CODE (NMSettingEthtool, nm_setting_ethtool, NM_TYPE_SETTING,
+                         _nm_register_setting (ETHTOOL, 2))
+NM_SETTING_REGISTER_TYPE (NM_TYPE_SETTING_ETHTOOL)
+
+#define NM_SETTING_ETHTOOL_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_SETTING_ETHTOOL, NMSettingEthtoolPrivate))
+
+typedef struct {
+	int feature_gro;
+	int feature_gso;
+	int feature_tso;
+	int feature_lro;
+	guint32 ring_rx;
+	guint32 ring_rx_mini;
+	guint32 ring_rx_jumbo;
+	guint32 ring_tx;
+	int coalesce_rx_usecs;
+	int coalesce_rx_frames;
+	int coalesce_tx_usecs;
+	int coalesce_tx_frames;
+	int coalesce_adaptive_rx;
+	int coalesce_adaptive_tx;
+	char *rps_cpus;
+	int rps_flow_cnt;
+	char *xps_cpus;
+} NMSettingEthtoolPrivate;
+
+enum {
+	PROP_0,
+	PROP_FEATURE_GRO,
+	PROP_FEATURE_GSO,
+	PROP_FEATURE_TSO,
+	PROP_FEATURE_LRO,
+	PROP_RING_RX,
+	PROP_RING_RX_MINI,
+	PROP_RING_RX_JUMBO,
+	PROP_RING_TX,
+	PROP_COALESCE_RX_USECS,
+	PROP_COALESCE_RX_FRAMES,
+	PROP_COALESCE_TX_USECS,
+	PROP_COALESCE_TX_FRAMES,
+	PROP_COALESCE_ADAPTIVE_RX,
+	PROP_COALESCE_ADAPTIVE_TX,
+	PROP_RPS_CPUS,
+	PROP_RPS_FLOW_CNT,
+	PROP_XPS_CPUS,
+
+	LAST_PROP
+};
+
+/**
+ * nm_setting_ethtool_new:
+ *
+ * Creates a new #NMSettingEthtool object with default values.
+ *
+ * Returns: (transfer full): the new empty #NMSettingEthtool object
+ *
+ * Since: 1.4
+ **/
+NMSetting *
+nm_setting_ethtool_new (void)
+{
+	return (NMSetting *) g_object_new (NM_TYPE_SETTING_ETHTOOL, NULL);
+}
+
+/**
+ * nm_setting_ethtool_get_feature_gro:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:feature-gro property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_feature_gro (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->feature_gro;
+}
+
+/**
+ * nm_setting_ethtool_get_feature_gso:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:feature-gso property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_feature_gso (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->feature_gso;
+}
+
+/**
+ * nm_setting_ethtool_get_feature_tso:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:feature-tso property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_feature_tso (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->feature_tso;
+}
+
+/**
+ * nm_setting_ethtool_get_feature_lro:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:feature-lro property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_feature_lro (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->feature_lro;
+}
+
+/**
+ * nm_setting_ethtool_get_ring_rx:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:ring-rx property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_ethtool_get_ring_rx (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), 0);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->ring_rx;
+}
+
+/**
+ * nm_setting_ethtool_get_ring_rx_mini:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:ring-rx-mini property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_ethtool_get_ring_rx_mini (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), 0);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->ring_rx_mini;
+}
+
+/**
+ * nm_setting_ethtool_get_ring_rx_jumbo:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:ring-rx-jumbo property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_ethtool_get_ring_rx_jumbo (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), 0);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->ring_rx_jumbo;
+}
+
+/**
+ * nm_setting_ethtool_get_ring_tx:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:ring-tx property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_ethtool_get_ring_tx (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), 0);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->ring_tx;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_rx_usecs:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-rx-usecs property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_rx_usecs (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_rx_usecs;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_rx_frames:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-rx-frames property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_rx_frames (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_rx_frames;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_tx_usecs:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-tx-usecs property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_tx_usecs (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_tx_usecs;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_tx_frames:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-tx-frames property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_tx_frames (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_tx_frames;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_adaptive_rx:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-adaptive-rx property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_adaptive_rx (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_adaptive_rx;
+}
+
+/**
+ * nm_setting_ethtool_get_coalesce_adaptive_tx:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:coalesce-adaptive-tx property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_coalesce_adaptive_tx (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->coalesce_adaptive_tx;
+}
+
+/**
+ * nm_setting_ethtool_get_rps_cpus:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:rps-cpus property of the setting
+ *
+ * Since: 1.4
+ **/
+const char *
+nm_setting_ethtool_get_rps_cpus (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), NULL);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->rps_cpus;
+}
+
+/**
+ * nm_setting_ethtool_get_rps_flow_cnt:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:rps-flow-cnt property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_ethtool_get_rps_flow_cnt (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), -1);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->rps_flow_cnt;
+}
+
+/**
+ * nm_setting_ethtool_get_xps_cpus:
+ * @setting: the #NMSettingEthtool
+ *
+ * Returns: the #NMSettingEthtool:xps-cpus property of the setting
+ *
+ * Since: 1.4
+ **/
+const char *
+nm_setting_ethtool_get_xps_cpus (NMSettingEthtool *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_ETHTOOL (setting), NULL);
+
+	return NM_SETTING_ETHTOOL_GET_PRIVATE (setting)->xps_cpus;
+}
+
+/* A CPU mask in the format of the sysfs cpumask files: comma separated
+ * groups of up to 8 hex digits, like "ff" or "00000001,00000000". */
+static gboolean
+_queue_cpus_valid (const char *str)
+{
+	const char *s;
+	guint digits = 0;
+
+	if (NM_IN_STRSET (str,
+	                  NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL,
+	                  NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD))
+		return TRUE;
+
+	if (!str[0] || str[0] == ',')
+		return FALSE;
+	for (s = str; *s; s++) {
+		if (*s == ',') {
+			if (s[1] == ',' || !s[1])
+				return FALSE;
+			digits = 0;
+		} else if (!g_ascii_isxdigit (*s) || ++digits > 8)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+verify (NMSetting *setting, NMConnection *connection, GError **error)
+{
+	NMSettingEthtoolPrivate *priv = NM_SETTING_ETHTOOL_GET_PRIVATE (setting);
+
+	if (priv->rps_cpus && !_queue_cpus_valid (priv->rps_cpus)) {
+		g_set_error (error,
+		             NM_CONNECTION_ERROR,
+		             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		             _("'%s' is neither a CPU mask nor '%s' or '%s'"),
+		             priv->rps_cpus,
+		             NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL,
+		             NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD);
+		g_prefix_error (error, "%s.%s: ", NM_SETTING_ETHTOOL_SETTING_NAME, NM_SETTING_ETHTOOL_RPS_CPUS);
+		return FALSE;
+	}
+
+	if (priv->xps_cpus && !_queue_cpus_valid (priv->xps_cpus)) {
+		g_set_error (error,
+		             NM_CONNECTION_ERROR,
+		             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		             _("'%s' is neither a CPU mask nor '%s' or '%s'"),
+		             priv->xps_cpus,
+		             NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL,
+		             NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD);
+		g_prefix_error (error, "%s.%s: ", NM_SETTING_ETHTOOL_SETTING_NAME, NM_SETTING_ETHTOOL_XPS_CPUS);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+nm_setting_ethtool_init (NMSettingEthtool *setting)
+{
+}
+
+static void
+finalize (GObject *object)
+{
+	NMSettingEthtoolPrivate *priv = NM_SETTING_ETHTOOL_GET_PRIVATE (object);
+
+	g_free (priv->rps_cpus);
+	g_free (priv->xps_cpus);
+
+	G_OBJECT_CLASS (nm_setting_ethtool_parent_class)->finalize (object);
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMSettingEthtoolPrivate *priv = NM_SETTING_ETHTOOL_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_FEATURE_GRO:
+		priv->feature_gro = g_value_get_int (value);
+		break;
+	case PROP_FEATURE_GSO:
+		priv->feature_gso = g_value_get_int (value);
+		break;
+	case PROP_FEATURE_TSO:
+		priv->feature_tso = g_value_get_int (value);
+		break;
+	case PROP_FEATURE_LRO:
+		priv->feature_lro = g_value_get_int (value);
+		break;
+	case PROP_RING_RX:
+		priv->ring_rx = g_value_get_uint (value);
+		break;
+	case PROP_RING_RX_MINI:
+		priv->ring_rx_mini = g_value_get_uint (value);
+		break;
+	case PROP_RING_RX_JUMBO:
+		priv->ring_rx_jumbo = g_value_get_uint (value);
+		break;
+	case PROP_RING_TX:
+		priv->ring_tx = g_value_get_uint (value);
+		break;
+	case PROP_COALESCE_RX_USECS:
+		priv->coalesce_rx_usecs = g_value_get_int (value);
+		break;
+	case PROP_COALESCE_RX_FRAMES:
+		priv->coalesce_rx_frames = g_value_get_int (value);
+		break;
+	case PROP_COALESCE_TX_USECS:
+		priv->coalesce_tx_usecs = g_value_get_int (value);
+		break;
+	case PROP_COALESCE_TX_FRAMES:
+		priv->coalesce_tx_frames = g_value_get_int (value);
+		break;
+	case PROP_COALESCE_ADAPTIVE_RX:
+		priv->coalesce_adaptive_rx = g_value_get_int (value);
+		break;
+	case PROP_COALESCE_ADAPTIVE_TX:
+		priv->coalesce_adaptive_tx = g_value_get_int (value);
+		break;
+	case PROP_RPS_CPUS:
+		g_free (priv->rps_cpus);
+		priv->rps_cpus = g_value_dup_string (value);
+		break;
+	case PROP_RPS_FLOW_CNT:
+		priv->rps_flow_cnt = g_value_get_int (value);
+		break;
+	case PROP_XPS_CPUS:
+		g_free (priv->xps_cpus);
+		priv->xps_cpus = g_value_dup_string (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	NMSettingEthtoolPrivate *priv = NM_SETTING_ETHTOOL_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_FEATURE_GRO:
+		g_value_set_int (value, priv->feature_gro);
+		break;
+	case PROP_FEATURE_GSO:
+		g_value_set_int (value, priv->feature_gso);
+		break;
+	case PROP_FEATURE_TSO:
+		g_value_set_int (value, priv->feature_tso);
+		break;
+	case PROP_FEATURE_LRO:
+		g_value_set_int (value, priv->feature_lro);
+		break;
+	case PROP_RING_RX:
+		g_value_set_uint (value, priv->ring_rx);
+		break;
+	case PROP_RING_RX_MINI:
+		g_value_set_uint (value, priv->ring_rx_mini);
+		break;
+	case PROP_RING_RX_JUMBO:
+		g_value_set_uint (value, priv->ring_rx_jumbo);
+		break;
+	case PROP_RING_TX:
+		g_value_set_uint (value, priv->ring_tx);
+		break;
+	case PROP_COALESCE_RX_USECS:
+		g_value_set_int (value, priv->coalesce_rx_usecs);
+		break;
+	case PROP_COALESCE_RX_FRAMES:
+		g_value_set_int (value, priv->coalesce_rx_frames);
+		break;
+	case PROP_COALESCE_TX_USECS:
+		g_value_set_int (value, priv->coalesce_tx_usecs);
+		break;
+	case PROP_COALESCE_TX_FRAMES:
+		g_value_set_int (value, priv->coalesce_tx_frames);
+		break;
+	case PROP_COALESCE_ADAPTIVE_RX:
+		g_value_set_int (value, priv->coalesce_adaptive_rx);
+		break;
+	case PROP_COALESCE_ADAPTIVE_TX:
+		g_value_set_int (value, priv->coalesce_adaptive_tx);
+		break;
+	case PROP_RPS_CPUS:
+		g_value_set_string (value, priv->rps_cpus);
+		break;
+	case PROP_RPS_FLOW_CNT:
+		g_value_set_int (value, priv->rps_flow_cnt);
+		break;
+	case PROP_XPS_CPUS:
+		g_value_set_string (value, priv->xps_cpus);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+nm_setting_ethtool_class_init (NMSettingEthtoolClass *setting_class)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (setting_class);
+	NMSettingClass *parent_class = NM_SETTING_CLASS (setting_class);
+
+	g_type_class_add_private (setting_class, sizeof (NMSettingEthtoolPrivate));
+
+	/* virtual methods */
+	object_class->set_property = set_property;
+	object_class->get_property = get_property;
+	object_class->finalize     = finalize;
+	parent_class->verify       = verify;
+
+	/* Properties */
+	/**
+	 * NMSettingEthtool:feature-gro:
+	 *
+	 * Whether to enable generic receive offload (GRO). 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FEATURE_GRO,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_FEATURE_GRO, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:feature-gso:
+	 *
+	 * Whether to enable generic segmentation offload (GSO). 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FEATURE_GSO,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_FEATURE_GSO, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:feature-tso:
+	 *
+	 * Whether to enable TCP segmentation offload (TSO). 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FEATURE_TSO,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_FEATURE_TSO, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:feature-lro:
+	 *
+	 * Whether to enable large receive offload (LRO). 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FEATURE_LRO,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_FEATURE_LRO, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:ring-rx:
+	 *
+	 * The number of entries of the RX ring. 0 leaves the size unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RING_RX,
+		 g_param_spec_uint (NM_SETTING_ETHTOOL_RING_RX, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:ring-rx-mini:
+	 *
+	 * The number of entries of the RX mini ring. 0 leaves the size
+	 * unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RING_RX_MINI,
+		 g_param_spec_uint (NM_SETTING_ETHTOOL_RING_RX_MINI, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:ring-rx-jumbo:
+	 *
+	 * The number of entries of the RX jumbo ring. 0 leaves the size
+	 * unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RING_RX_JUMBO,
+		 g_param_spec_uint (NM_SETTING_ETHTOOL_RING_RX_JUMBO, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:ring-tx:
+	 *
+	 * The number of entries of the TX ring. 0 leaves the size unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RING_TX,
+		 g_param_spec_uint (NM_SETTING_ETHTOOL_RING_TX, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-rx-usecs:
+	 *
+	 * How many microseconds to delay an RX interrupt after a packet arrives.
+	 * -1 leaves the value unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_RX_USECS,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_RX_USECS, "", "",
+		                   -1, G_MAXINT32, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-rx-frames:
+	 *
+	 * The maximum number of packets to receive before an RX interrupt. -1
+	 * leaves the value unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_RX_FRAMES,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_RX_FRAMES, "", "",
+		                   -1, G_MAXINT32, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-tx-usecs:
+	 *
+	 * How many microseconds to delay a TX interrupt after a packet is sent.
+	 * -1 leaves the value unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_TX_USECS,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_TX_USECS, "", "",
+		                   -1, G_MAXINT32, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-tx-frames:
+	 *
+	 * The maximum number of packets to send before a TX interrupt. -1 leaves
+	 * the value unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_TX_FRAMES,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_TX_FRAMES, "", "",
+		                   -1, G_MAXINT32, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-adaptive-rx:
+	 *
+	 * Whether to enable adaptive RX interrupt coalescing. 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_ADAPTIVE_RX,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_RX, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:coalesce-adaptive-tx:
+	 *
+	 * Whether to enable adaptive TX interrupt coalescing. 1 enables it, 0
+	 * disables it and -1 leaves the setting of the device unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_COALESCE_ADAPTIVE_TX,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_TX, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:rps-cpus:
+	 *
+	 * The CPUs that process the packets of each receive queue with receive
+	 * packet steering (RPS). Either a hex CPU mask like "0f" that is used
+	 * for all queues, "numa-local" for the CPUs local to the device, or
+	 * "spread" to assign one of the local CPUs to each queue in turn.
+	 * %NULL leaves the queues unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RPS_CPUS,
+		 g_param_spec_string (NM_SETTING_ETHTOOL_RPS_CPUS, "", "",
+		                      NULL,
+		                      G_PARAM_READWRITE |
+		                      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:rps-flow-cnt:
+	 *
+	 * The number of entries of the flow table of each receive queue for
+	 * receive flow steering (RFS). -1 leaves the value unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_RPS_FLOW_CNT,
+		 g_param_spec_int (NM_SETTING_ETHTOOL_RPS_FLOW_CNT, "", "",
+		                   -1, G_MAXINT32, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingEthtool:xps-cpus:
+	 *
+	 * The CPUs that use each transmit queue with transmit packet steering
+	 * (XPS). Takes the same values as #NMSettingEthtool:rps-cpus. %NULL
+	 * leaves the queues unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_XPS_CPUS,
+		 g_param_spec_string (NM_SETTING_ETHTOOL_XPS_CPUS, "", "",
+		                      NULL,
+		                      G_PARAM_READWRITE |
+		                      G_PARAM_STATIC_STRINGS));
+}
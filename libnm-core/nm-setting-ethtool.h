@@ -0,0 +1,123 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_SETTING_ETHTOOL_H__
+#define __NM_SETTING_ETHTOOL_H__
+
+#if !defined (__NETWORKMANAGER_H_INSIDE__) && !defined (NETWORKMANAGER_COMPILATION)
+#error "Only <NetworkManager.h> can be included directly."
+#endif
+
+#include "nm-setting.h"
+
+G_BEGIN_DECLS
+
+#define NM_TYPE_SETTING_ETHTOOL            (nm_setting_ethtool_get_type ())
+#define NM_SETTING_ETHTOOL(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_SETTING_ETHTOOL, NMSettingEthtool))
+#define NM_SETTING_ETHTOOL_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_SETTING_ETHTOOL, NMSettingEthtoolClass))
+#define NM_IS_SETTING_ETHTOOL(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_SETTING_ETHTOOL))
+#define NM_IS_SETTING_ETHTOOL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_SETTING_ETHTOOL))
+#define NM_SETTING_ETHTOOL_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_SETTING_ETHTOOL, NMSettingEthtoolClass))
+
+#define NM_SETTING_ETHTOOL_SETTING_NAME         "ethtool"
+
+#define NM_SETTING_ETHTOOL_FEATURE_GRO           "feature-gro"
+#define NM_SETTING_ETHTOOL_FEATURE_GSO           "feature-gso"
+#define NM_SETTING_ETHTOOL_FEATURE_TSO           "feature-tso"
+#define NM_SETTING_ETHTOOL_FEATURE_LRO           "feature-lro"
+#define NM_SETTING_ETHTOOL_RING_RX               "ring-rx"
+#define NM_SETTING_ETHTOOL_RING_RX_MINI          "ring-rx-mini"
+#define NM_SETTING_ETHTOOL_RING_RX_JUMBO         "ring-rx-jumbo"
+#define NM_SETTING_ETHTOOL_RING_TX               "ring-tx"
+#define NM_SETTING_ETHTOOL_COALESCE_RX_USECS     "coalesce-rx-usecs"
+#define NM_SETTING_ETHTOOL_COALESCE_RX_FRAMES    "coalesce-rx-frames"
+#define NM_SETTING_ETHTOOL_COALESCE_TX_USECS     "coalesce-tx-usecs"
+#define NM_SETTING_ETHTOOL_COALESCE_TX_FRAMES    "coalesce-tx-frames"
+#define NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_RX  "coalesce-adaptive-rx"
+#define NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_TX  "coalesce-adaptive-tx"
+#define NM_SETTING_ETHTOOL_RPS_CPUS              "rps-cpus"
+#define NM_SETTING_ETHTOOL_RPS_FLOW_CNT          "rps-flow-cnt"
+#define NM_SETTING_ETHTOOL_XPS_CPUS              "xps-cpus"
+
+/* Special values of the #NMSettingEthtool:rps-cpus and
+ * #NMSettingEthtool:xps-cpus properties. */
+#define NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL "numa-local"
+#define NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD     "spread"
+
+/**
+ * NMSettingEthtool:
+ *
+ * Ethtool Settings
+ */
+struct _NMSettingEthtool {
+	NMSetting parent;
+};
+
+typedef struct {
+	NMSettingClass parent;
+
+	/*< private >*/
+	gpointer padding[4];
+} NMSettingEthtoolClass;
+
+NM_AVAILABLE_IN_1_4
+GType nm_setting_ethtool_get_type (void);
+NM_AVAILABLE_IN_1_4
+NMSetting *nm_setting_ethtool_new (void);
+
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_feature_gro          (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_feature_gso          (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_feature_tso          (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_feature_lro          (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+guint32 nm_setting_ethtool_get_ring_rx              (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+guint32 nm_setting_ethtool_get_ring_rx_mini         (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+guint32 nm_setting_ethtool_get_ring_rx_jumbo        (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+guint32 nm_setting_ethtool_get_ring_tx              (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_rx_usecs    (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_rx_frames   (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_tx_usecs    (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_tx_frames   (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_adaptive_rx (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_coalesce_adaptive_tx (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+const char *nm_setting_ethtool_get_rps_cpus         (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+int     nm_setting_ethtool_get_rps_flow_cnt         (NMSettingEthtool *setting);
+NM_AVAILABLE_IN_1_4
+const char *nm_setting_ethtool_get_xps_cpus         (NMSettingEthtool *setting);
+
+G_END_DECLS
+
+#endif /* __NM_SETTING_ETHTOOL_H__ */
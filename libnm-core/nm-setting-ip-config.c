@@ -1109,6 +1109,38 @@ nm_ip_route_set_attribute (NMIPRoute *route, const char *name, GVariant *value)
 		g_hash_table_remove (route->attributes, name);
 }
 
+static const struct {
+	const char *name;
+	const char *type;
+} ip_route_attribute_types[] = {
+	{ NM_IP_ROUTE_ATTRIBUTE_WINDOW,   "u" },
+	{ NM_IP_ROUTE_ATTRIBUTE_INITCWND, "u" },
+	{ NM_IP_ROUTE_ATTRIBUTE_INITRWND, "u" },
+	{ NM_IP_ROUTE_ATTRIBUTE_RTT,      "u" },
+	{ NM_IP_ROUTE_ATTRIBUTE_MTU,      "u" },
+	{ NM_IP_ROUTE_ATTRIBUTE_LOCK_MTU, "b" },
+	{ NM_IP_ROUTE_ATTRIBUTE_CONGCTL,  "s" },
+};
+
+/**
+ * _nm_ip_route_attribute_get_type:
+ * @name: the name of a route attribute
+ *
+ * Returns: the type of the attribute, if it is one of the attributes
+ *   that NetworkManager applies to the route, or %NULL.
+ */
+const GVariantType *
+_nm_ip_route_attribute_get_type (const char *name)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (ip_route_attribute_types); i++) {
+		if (nm_streq (name, ip_route_attribute_types[i].name))
+			return G_VARIANT_TYPE (ip_route_attribute_types[i].type);
+	}
+	return NULL;
+}
+
 /*****************************************************************************/
 
 G_DEFINE_ABSTRACT_TYPE (NMSettingIPConfig, nm_setting_ip_config, NM_TYPE_SETTING)
@@ -2290,6 +2322,26 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 			g_prefix_error (error, "%s.%s: ", nm_setting_get_name (setting), NM_SETTING_IP_CONFIG_ROUTES);
 			return FALSE;
 		}
+		if (route->attributes) {
+			GHashTableIter iter;
+			const char *name;
+			GVariant *value;
+
+			g_hash_table_iter_init (&iter, route->attributes);
+			while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value)) {
+				const GVariantType *type = _nm_ip_route_attribute_get_type (name);
+
+				if (type && !g_variant_is_of_type (value, type)) {
+					g_set_error (error,
+					             NM_CONNECTION_ERROR,
+					             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+					             _("%d. route has invalid type for attribute '%s'"),
+					             i+1, name);
+					g_prefix_error (error, "%s.%s: ", nm_setting_get_name (setting), NM_SETTING_IP_CONFIG_ROUTES);
+					return FALSE;
+				}
+			}
+		}
 	}
 
 	if (priv->gateway && priv->never_default) {
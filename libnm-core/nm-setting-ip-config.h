@@ -122,6 +122,19 @@ void         nm_ip_route_set_attribute       (NMIPRoute   *route,
                                               const char  *name,
                                               GVariant    *value);
 
+/* Route attributes that NetworkManager applies to the kernel route
+ * (RTA_METRICS). All are of type "u", except where noted. */
+#define NM_IP_ROUTE_ATTRIBUTE_WINDOW    "window"
+#define NM_IP_ROUTE_ATTRIBUTE_INITCWND  "initcwnd"
+#define NM_IP_ROUTE_ATTRIBUTE_INITRWND  "initrwnd"
+/* the initial RTT estimate, in milliseconds */
+#define NM_IP_ROUTE_ATTRIBUTE_RTT       "rtt"
+#define NM_IP_ROUTE_ATTRIBUTE_MTU       "mtu"
+/* "b": whether path MTU discovery may not change the MTU */
+#define NM_IP_ROUTE_ATTRIBUTE_LOCK_MTU  "lock-mtu"
+/* "s": the TCP congestion control algorithm */
+#define NM_IP_ROUTE_ATTRIBUTE_CONGCTL   "congctl"
+
 
 #define NM_TYPE_SETTING_IP_CONFIG            (nm_setting_ip_config_get_type ())
 #define NM_SETTING_IP_CONFIG(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_SETTING_IP_CONFIG, NMSettingIPConfig))
@@ -59,12 +59,14 @@ NM_SETTING_REGISTER_TYPE (NM_TYPE_SETTING_IP4_CONFIG)
 typedef struct {
 	char *dhcp_client_id;
 	char *dhcp_fqdn;
+	guint multipath_weight;
 } NMSettingIP4ConfigPrivate;
 
 enum {
 	PROP_0,
 	PROP_DHCP_CLIENT_ID,
 	PROP_DHCP_FQDN,
+	PROP_MULTIPATH_WEIGHT,
 
 	LAST_PROP
 };
@@ -119,6 +121,26 @@ nm_setting_ip4_config_get_dhcp_fqdn (NMSettingIP4Config *setting)
 	return NM_SETTING_IP4_CONFIG_GET_PRIVATE (setting)->dhcp_fqdn;
 }
 
+/**
+ * nm_setting_ip4_config_get_multipath_weight:
+ * @setting: the #NMSettingIP4Config
+ *
+ * Returns the value contained in the #NMSettingIP4Config:multipath-weight
+ * property.
+ *
+ * Returns: the weight of the connection's gateway in a shared multipath
+ * default route, or 0 if the connection doesn't share its default route.
+ *
+ * Since: 1.4
+ **/
+guint
+nm_setting_ip4_config_get_multipath_weight (NMSettingIP4Config *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_IP4_CONFIG (setting), 0);
+
+	return NM_SETTING_IP4_CONFIG_GET_PRIVATE (setting)->multipath_weight;
+}
+
 static gboolean
 verify (NMSetting *setting, NMConnection *connection, GError **error)
 {
@@ -259,6 +281,9 @@ set_property (GObject *object, guint prop_id,
 		g_free (priv->dhcp_fqdn);
 		priv->dhcp_fqdn = g_value_dup_string (value);
 		break;
+	case PROP_MULTIPATH_WEIGHT:
+		priv->multipath_weight = g_value_get_uint (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -278,6 +303,9 @@ get_property (GObject *object, guint prop_id,
 	case PROP_DHCP_FQDN:
 		g_value_set_string (value, nm_setting_ip4_config_get_dhcp_fqdn (s_ip4));
 		break;
+	case PROP_MULTIPATH_WEIGHT:
+		g_value_set_uint (value, nm_setting_ip4_config_get_multipath_weight (s_ip4));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -728,6 +756,26 @@ nm_setting_ip4_config_class_init (NMSettingIP4ConfigClass *ip4_class)
 		                      G_PARAM_READWRITE |
 		                      G_PARAM_STATIC_STRINGS));
 
+	/**
+	 * NMSettingIP4Config:multipath-weight:
+	 *
+	 * If non-zero, the default route of the connection is shared with the
+	 * other active connections that set this property and have the same
+	 * default route metric: instead of preferring one of them, a single
+	 * multipath (ECMP) default route is installed that spreads the traffic
+	 * over all their gateways. The value, between 1 and 256, is the relative
+	 * weight of this connection's gateway in that route.
+	 *
+	 * Since: 1.4
+	 */
+	g_object_class_install_property
+		(object_class, PROP_MULTIPATH_WEIGHT,
+		 g_param_spec_uint (NM_SETTING_IP4_CONFIG_MULTIPATH_WEIGHT, "", "",
+		                    0, 256, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
 	/* IP4-specific property overrides */
 
 	/* ---dbus---
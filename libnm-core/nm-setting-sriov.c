@@ -0,0 +1,357 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-setting-sriov.h"
+
+#include <string.h>
+#include <net/ethernet.h>
+
+#include "nm-utils.h"
+#include "nm-setting-private.h"
+#include "nm-core-internal.h"
+
+/**
+ * SECTION:nm-setting-sriov
+ * @short_description: Describes the SR-IOV virtual functions of a device
+ *
+ * The #NMSettingSriov object is a #NMSetting subclass that describes the
+ * SR-IOV virtual functions (VFs) that are created on a physical function
+ * when the connection is activated, and the MAC address, VLAN, spoof
+ * checking and trust of each of them.
+ **/
+
+G_DEFINE_TYPE_WITH_CODE (NMSettingSriov, nm_setting_sriov, NM_TYPE_SETTING,
+                         _nm_register_setting (SRIOV, 2))
+NM_SETTING_REGISTER_TYPE (NM_TYPE_SETTING_SRIOV)
+
+#define NM_SETTING_SRIOV_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_SETTING_SRIOV, NMSettingSriovPrivate))
+
+typedef struct {
+	guint total_vfs;
+	char **vfs;
+} NMSettingSriovPrivate;
+
+enum {
+	PROP_0,
+	PROP_TOTAL_VFS,
+	PROP_VFS,
+
+	LAST_PROP
+};
+
+/**
+ * nm_setting_sriov_new:
+ *
+ * Creates a new #NMSettingSriov object with default values.
+ *
+ * Returns: (transfer full): the new empty #NMSettingSriov object
+ *
+ * Since: 1.4
+ **/
+NMSetting *
+nm_setting_sriov_new (void)
+{
+	return (NMSetting *) g_object_new (NM_TYPE_SETTING_SRIOV, NULL);
+}
+
+/**
+ * nm_setting_sriov_get_total_vfs:
+ * @setting: the #NMSettingSriov
+ *
+ * Returns: the #NMSettingSriov:total-vfs property of the setting
+ *
+ * Since: 1.4
+ **/
+guint
+nm_setting_sriov_get_total_vfs (NMSettingSriov *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_SRIOV (setting), 0);
+
+	return NM_SETTING_SRIOV_GET_PRIVATE (setting)->total_vfs;
+}
+
+/**
+ * nm_setting_sriov_get_vfs:
+ * @setting: the #NMSettingSriov
+ *
+ * Returns: (transfer none): the #NMSettingSriov:vfs property of the
+ *   setting, or %NULL
+ *
+ * Since: 1.4
+ **/
+const char *const *
+nm_setting_sriov_get_vfs (NMSettingSriov *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_SRIOV (setting), NULL);
+
+	return (const char *const *) NM_SETTING_SRIOV_GET_PRIVATE (setting)->vfs;
+}
+
+/**
+ * _nm_setting_sriov_parse_vf:
+ * @str: one entry of #NMSettingSriov:vfs
+ * @out_vf: (out): the parsed configuration
+ * @error: location for an error
+ *
+ * Parses "INDEX [mac=ADDRESS] [vlan=ID[.QOS]] [spoof-check=BOOL] [trust=BOOL]".
+ *
+ * Returns: %TRUE if @str is valid
+ **/
+gboolean
+_nm_setting_sriov_parse_vf (const char *str, NMSriovVFConfig *out_vf, GError **error)
+{
+	gs_strfreev char **tokens = NULL;
+	gboolean have_index = FALSE;
+	guint i;
+
+	g_return_val_if_fail (str, FALSE);
+	g_return_val_if_fail (out_vf, FALSE);
+
+	memset (out_vf, 0, sizeof (*out_vf));
+	out_vf->vlan = -1;
+	out_vf->spoof_check = -1;
+	out_vf->trust = -1;
+
+	tokens = g_strsplit_set (str, " \t", 0);
+	for (i = 0; tokens[i]; i++) {
+		const char *token = tokens[i];
+		const char *value;
+		gint64 v;
+
+		if (!token[0])
+			continue;
+
+		if (!have_index) {
+			v = _nm_utils_ascii_str_to_int64 (token, 10, 0, G_MAXUINT16, -1);
+			if (v < 0) {
+				g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
+				             _("'%s' is not a valid VF index"), token);
+				return FALSE;
+			}
+			out_vf->index = v;
+			have_index = TRUE;
+			continue;
+		}
+
+		value = strchr (token, '=');
+		if (!value || !value[1]) {
+			g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("'%s' is not an attribute of the form name=value"), token);
+			return FALSE;
+		}
+		value++;
+
+		if (g_str_has_prefix (token, "mac=")) {
+			if (!nm_utils_hwaddr_aton (value, out_vf->mac, ETH_ALEN))
+				goto invalid_value;
+			out_vf->has_mac = TRUE;
+		} else if (g_str_has_prefix (token, "vlan=")) {
+			gs_free char *id = g_strdup (value);
+			char *qos;
+
+			qos = strchr (id, '.');
+			if (qos)
+				*qos++ = '\0';
+			v = _nm_utils_ascii_str_to_int64 (id, 10, 0, 4095, -1);
+			if (v < 0)
+				goto invalid_value;
+			out_vf->vlan = v;
+			if (qos) {
+				v = _nm_utils_ascii_str_to_int64 (qos, 10, 0, 7, -1);
+				if (v < 0)
+					goto invalid_value;
+				out_vf->qos = v;
+			}
+		} else if (g_str_has_prefix (token, "spoof-check=")) {
+			out_vf->spoof_check = _nm_utils_ascii_str_to_bool (value, -1);
+			if (out_vf->spoof_check == -1)
+				goto invalid_value;
+		} else if (g_str_has_prefix (token, "trust=")) {
+			out_vf->trust = _nm_utils_ascii_str_to_bool (value, -1);
+			if (out_vf->trust == -1)
+				goto invalid_value;
+		} else {
+			g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("unknown VF attribute '%s'"), token);
+			return FALSE;
+		}
+		continue;
+
+invalid_value:
+		g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		             _("invalid value in '%s'"), token);
+		return FALSE;
+	}
+
+	if (!have_index) {
+		g_set_error_literal (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		                     _("missing VF index"));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+verify (NMSetting *setting, NMConnection *connection, GError **error)
+{
+	NMSettingSriovPrivate *priv = NM_SETTING_SRIOV_GET_PRIVATE (setting);
+	gs_free gboolean *seen = NULL;
+	guint i;
+
+	if (!priv->vfs)
+		return TRUE;
+
+	seen = g_new0 (gboolean, priv->total_vfs + 1);
+	for (i = 0; priv->vfs[i]; i++) {
+		NMSriovVFConfig vf;
+
+		if (!_nm_setting_sriov_parse_vf (priv->vfs[i], &vf, error)) {
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_SRIOV_SETTING_NAME, NM_SETTING_SRIOV_VFS);
+			return FALSE;
+		}
+		if (vf.index >= priv->total_vfs) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("VF %u does not exist with %u VFs"),
+			             vf.index, priv->total_vfs);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_SRIOV_SETTING_NAME, NM_SETTING_SRIOV_VFS);
+			return FALSE;
+		}
+		if (seen[vf.index]) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("VF %u is configured more than once"),
+			             vf.index);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_SRIOV_SETTING_NAME, NM_SETTING_SRIOV_VFS);
+			return FALSE;
+		}
+		seen[vf.index] = TRUE;
+	}
+
+	return TRUE;
+}
+
+static void
+nm_setting_sriov_init (NMSettingSriov *setting)
+{
+}
+
+static void
+finalize (GObject *object)
+{
+	NMSettingSriovPrivate *priv = NM_SETTING_SRIOV_GET_PRIVATE (object);
+
+	g_strfreev (priv->vfs);
+
+	G_OBJECT_CLASS (nm_setting_sriov_parent_class)->finalize (object);
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMSettingSriovPrivate *priv = NM_SETTING_SRIOV_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_TOTAL_VFS:
+		priv->total_vfs = g_value_get_uint (value);
+		break;
+	case PROP_VFS:
+		g_strfreev (priv->vfs);
+		priv->vfs = g_value_dup_boxed (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	NMSettingSriovPrivate *priv = NM_SETTING_SRIOV_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_TOTAL_VFS:
+		g_value_set_uint (value, priv->total_vfs);
+		break;
+	case PROP_VFS:
+		g_value_set_boxed (value, priv->vfs);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+nm_setting_sriov_class_init (NMSettingSriovClass *setting_class)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (setting_class);
+	NMSettingClass *parent_class = NM_SETTING_CLASS (setting_class);
+
+	g_type_class_add_private (setting_class, sizeof (NMSettingSriovPrivate));
+
+	/* virtual methods */
+	object_class->set_property = set_property;
+	object_class->get_property = get_property;
+	object_class->finalize     = finalize;
+	parent_class->verify       = verify;
+
+	/* Properties */
+	/**
+	 * NMSettingSriov:total-vfs:
+	 *
+	 * The number of virtual functions to create on the device. 0 removes
+	 * the VFs of the device.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_TOTAL_VFS,
+		 g_param_spec_uint (NM_SETTING_SRIOV_TOTAL_VFS, "", "",
+		                    0, G_MAXUINT16, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingSriov:vfs:
+	 *
+	 * The configuration of single VFs, each of the form "INDEX
+	 * [mac=ADDRESS] [vlan=ID[.QOS]] [spoof-check=BOOL] [trust=BOOL]", for
+	 * example "0 mac=52:54:00:12:34:56 vlan=100 trust=true". Attributes
+	 * that are not given are left as the driver sets them.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_VFS,
+		 g_param_spec_boxed (NM_SETTING_SRIOV_VFS, "", "",
+		                     G_TYPE_STRV,
+		                     G_PARAM_READWRITE |
+		                     G_PARAM_STATIC_STRINGS));
+}
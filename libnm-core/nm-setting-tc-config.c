@@ -0,0 +1,403 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-setting-tc-config.h"
+#include "nm-setting-private.h"
+
+/**
+ * SECTION:nm-setting-tc-config
+ * @short_description: Describes the queueing discipline of a device
+ *
+ * The #NMSettingTCConfig object is a #NMSetting subclass that describes
+ * the root queueing discipline (qdisc) that is set on the device when the
+ * connection is activated, for example to reduce the latency of uplinks
+ * with fq_codel or cake. Without a qdisc the device keeps the one that
+ * the kernel chose.
+ **/
+
+G_DEFINE_TYPE_WITH_CODE (NMSettingTCConfig, nm_setting_tc_config, NM_TYPE_SETTING,
+                         _nm_register_setting (TC_CONFIG, 2))
+NM_SETTING_REGISTER_TYPE (NM_TYPE_SETTING_TC_CONFIG)
+
+#define NM_SETTING_TC_CONFIG_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_SETTING_TC_CONFIG, NMSettingTCConfigPrivate))
+
+typedef struct {
+	char *qdisc;
+	guint32 qdisc_limit;
+	guint32 qdisc_target;
+	guint32 qdisc_interval;
+	int qdisc_ecn;
+	guint32 qdisc_rate;
+} NMSettingTCConfigPrivate;
+
+enum {
+	PROP_0,
+	PROP_QDISC,
+	PROP_QDISC_LIMIT,
+	PROP_QDISC_TARGET,
+	PROP_QDISC_INTERVAL,
+	PROP_QDISC_ECN,
+	PROP_QDISC_RATE,
+
+	LAST_PROP
+};
+
+/**
+ * nm_setting_tc_config_new:
+ *
+ * Creates a new #NMSettingTCConfig object with default values.
+ *
+ * Returns: (transfer full): the new empty #NMSettingTCConfig object
+ *
+ * Since: 1.4
+ **/
+NMSetting *
+nm_setting_tc_config_new (void)
+{
+	return (NMSetting *) g_object_new (NM_TYPE_SETTING_TC_CONFIG, NULL);
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc property of the setting
+ *
+ * Since: 1.4
+ **/
+const char *
+nm_setting_tc_config_get_qdisc (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), NULL);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc;
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc_limit:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc-limit property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_tc_config_get_qdisc_limit (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), 0);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc_limit;
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc_target:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc-target property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_tc_config_get_qdisc_target (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), 0);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc_target;
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc_interval:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc-interval property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_tc_config_get_qdisc_interval (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), 0);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc_interval;
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc_ecn:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc-ecn property of the setting
+ *
+ * Since: 1.4
+ **/
+int
+nm_setting_tc_config_get_qdisc_ecn (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), -1);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc_ecn;
+}
+
+/**
+ * nm_setting_tc_config_get_qdisc_rate:
+ * @setting: the #NMSettingTCConfig
+ *
+ * Returns: the #NMSettingTCConfig:qdisc-rate property of the setting
+ *
+ * Since: 1.4
+ **/
+guint32
+nm_setting_tc_config_get_qdisc_rate (NMSettingTCConfig *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_TC_CONFIG (setting), 0);
+
+	return NM_SETTING_TC_CONFIG_GET_PRIVATE (setting)->qdisc_rate;
+}
+
+static gboolean
+verify (NMSetting *setting, NMConnection *connection, GError **error)
+{
+	NMSettingTCConfigPrivate *priv = NM_SETTING_TC_CONFIG_GET_PRIVATE (setting);
+	const char *s;
+
+	if (priv->qdisc) {
+		/* the kind is a TCA_KIND string, at most IFNAMSIZ long */
+		for (s = priv->qdisc; *s; s++) {
+			if (!g_ascii_isalnum (*s) && *s != '_' && *s != '-')
+				break;
+		}
+		if (!priv->qdisc[0] || *s || s - priv->qdisc >= 16) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("'%s' is not a valid qdisc"),
+			             priv->qdisc);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_TC_CONFIG_SETTING_NAME, NM_SETTING_TC_CONFIG_QDISC);
+			return FALSE;
+		}
+	} else if (   priv->qdisc_limit
+	           || priv->qdisc_target
+	           || priv->qdisc_interval
+	           || priv->qdisc_ecn != -1
+	           || priv->qdisc_rate) {
+		g_set_error_literal (error,
+		                     NM_CONNECTION_ERROR,
+		                     NM_CONNECTION_ERROR_MISSING_PROPERTY,
+		                     _("the qdisc options require a qdisc"));
+		g_prefix_error (error, "%s.%s: ", NM_SETTING_TC_CONFIG_SETTING_NAME, NM_SETTING_TC_CONFIG_QDISC);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+nm_setting_tc_config_init (NMSettingTCConfig *setting)
+{
+}
+
+static void
+finalize (GObject *object)
+{
+	NMSettingTCConfigPrivate *priv = NM_SETTING_TC_CONFIG_GET_PRIVATE (object);
+
+	g_free (priv->qdisc);
+
+	G_OBJECT_CLASS (nm_setting_tc_config_parent_class)->finalize (object);
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMSettingTCConfigPrivate *priv = NM_SETTING_TC_CONFIG_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_QDISC:
+		g_free (priv->qdisc);
+		priv->qdisc = g_value_dup_string (value);
+		break;
+	case PROP_QDISC_LIMIT:
+		priv->qdisc_limit = g_value_get_uint (value);
+		break;
+	case PROP_QDISC_TARGET:
+		priv->qdisc_target = g_value_get_uint (value);
+		break;
+	case PROP_QDISC_INTERVAL:
+		priv->qdisc_interval = g_value_get_uint (value);
+		break;
+	case PROP_QDISC_ECN:
+		priv->qdisc_ecn = g_value_get_int (value);
+		break;
+	case PROP_QDISC_RATE:
+		priv->qdisc_rate = g_value_get_uint (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	NMSettingTCConfigPrivate *priv = NM_SETTING_TC_CONFIG_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_QDISC:
+		g_value_set_string (value, priv->qdisc);
+		break;
+	case PROP_QDISC_LIMIT:
+		g_value_set_uint (value, priv->qdisc_limit);
+		break;
+	case PROP_QDISC_TARGET:
+		g_value_set_uint (value, priv->qdisc_target);
+		break;
+	case PROP_QDISC_INTERVAL:
+		g_value_set_uint (value, priv->qdisc_interval);
+		break;
+	case PROP_QDISC_ECN:
+		g_value_set_int (value, priv->qdisc_ecn);
+		break;
+	case PROP_QDISC_RATE:
+		g_value_set_uint (value, priv->qdisc_rate);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+nm_setting_tc_config_class_init (NMSettingTCConfigClass *setting_class)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (setting_class);
+	NMSettingClass *parent_class = NM_SETTING_CLASS (setting_class);
+
+	g_type_class_add_private (setting_class, sizeof (NMSettingTCConfigPrivate));
+
+	/* virtual methods */
+	object_class->set_property = set_property;
+	object_class->get_property = get_property;
+	object_class->finalize     = finalize;
+	parent_class->verify       = verify;
+
+	/* Properties */
+	/**
+	 * NMSettingTCConfig:qdisc:
+	 *
+	 * The kind of the root queueing discipline of the device, like
+	 * "fq_codel", "fq" or "cake". %NULL leaves the qdisc of the device
+	 * unchanged.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC,
+		 g_param_spec_string (NM_SETTING_TC_CONFIG_QDISC, "", "",
+		                      NULL,
+		                      G_PARAM_READWRITE |
+		                      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingTCConfig:qdisc-limit:
+	 *
+	 * The maximum number of packets in the queue of a "fq_codel" or "fq"
+	 * qdisc. 0 uses the default of the kernel.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC_LIMIT,
+		 g_param_spec_uint (NM_SETTING_TC_CONFIG_QDISC_LIMIT, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingTCConfig:qdisc-target:
+	 *
+	 * The acceptable queueing delay of a "fq_codel" or "cake" qdisc, in
+	 * microseconds. 0 uses the default of the kernel.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC_TARGET,
+		 g_param_spec_uint (NM_SETTING_TC_CONFIG_QDISC_TARGET, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingTCConfig:qdisc-interval:
+	 *
+	 * The interval of a "fq_codel" qdisc, or the round trip time of a
+	 * "cake" qdisc, in microseconds. 0 uses the default of the kernel.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC_INTERVAL,
+		 g_param_spec_uint (NM_SETTING_TC_CONFIG_QDISC_INTERVAL, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingTCConfig:qdisc-ecn:
+	 *
+	 * Whether a "fq_codel" qdisc marks packets with ECN instead of
+	 * dropping them. 1 enables it, 0 disables it and -1 uses the default
+	 * of the kernel.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC_ECN,
+		 g_param_spec_int (NM_SETTING_TC_CONFIG_QDISC_ECN, "", "",
+		                   -1, 1, -1,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_CONSTRUCT |
+		                   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingTCConfig:qdisc-rate:
+	 *
+	 * The rate in kbit/s: the bandwidth that a "cake" qdisc shapes to, or
+	 * the maximum rate at which a "fq" qdisc paces each flow. 0 means
+	 * unlimited.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_QDISC_RATE,
+		 g_param_spec_uint (NM_SETTING_TC_CONFIG_QDISC_RATE, "", "",
+		                    0, G_MAXUINT32, 0,
+		                    G_PARAM_READWRITE |
+		                    G_PARAM_CONSTRUCT |
+		                    G_PARAM_STATIC_STRINGS));
+}
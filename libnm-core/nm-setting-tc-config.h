@@ -0,0 +1,85 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_SETTING_TC_CONFIG_H__
+#define __NM_SETTING_TC_CONFIG_H__
+
+#if !defined (__NETWORKMANAGER_H_INSIDE__) && !defined (NETWORKMANAGER_COMPILATION)
+#error "Only <NetworkManager.h> can be included directly."
+#endif
+
+#include "nm-setting.h"
+
+G_BEGIN_DECLS
+
+#define NM_TYPE_SETTING_TC_CONFIG            (nm_setting_tc_config_get_type ())
+#define NM_SETTING_TC_CONFIG(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_SETTING_TC_CONFIG, NMSettingTCConfig))
+#define NM_SETTING_TC_CONFIG_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_SETTING_TC_CONFIG, NMSettingTCConfigClass))
+#define NM_IS_SETTING_TC_CONFIG(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_SETTING_TC_CONFIG))
+#define NM_IS_SETTING_TC_CONFIG_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_SETTING_TC_CONFIG))
+#define NM_SETTING_TC_CONFIG_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_SETTING_TC_CONFIG, NMSettingTCConfigClass))
+
+#define NM_SETTING_TC_CONFIG_SETTING_NAME "tc"
+
+#define NM_SETTING_TC_CONFIG_QDISC          "qdisc"
+#define NM_SETTING_TC_CONFIG_QDISC_LIMIT    "qdisc-limit"
+#define NM_SETTING_TC_CONFIG_QDISC_TARGET   "qdisc-target"
+#define NM_SETTING_TC_CONFIG_QDISC_INTERVAL "qdisc-interval"
+#define NM_SETTING_TC_CONFIG_QDISC_ECN      "qdisc-ecn"
+#define NM_SETTING_TC_CONFIG_QDISC_RATE     "qdisc-rate"
+
+/**
+ * NMSettingTCConfig:
+ *
+ * Linux Traffic Control Settings
+ */
+struct _NMSettingTCConfig {
+	NMSetting parent;
+};
+
+typedef struct {
+	NMSettingClass parent;
+
+	/*< private >*/
+	gpointer padding[4];
+} NMSettingTCConfigClass;
+
+NM_AVAILABLE_IN_1_4
+GType nm_setting_tc_config_get_type (void);
+NM_AVAILABLE_IN_1_4
+NMSetting *nm_setting_tc_config_new (void);
+
+NM_AVAILABLE_IN_1_4
+const char *nm_setting_tc_config_get_qdisc          (NMSettingTCConfig *setting);
+NM_AVAILABLE_IN_1_4
+guint32     nm_setting_tc_config_get_qdisc_limit    (NMSettingTCConfig *setting);
+NM_AVAILABLE_IN_1_4
+guint32     nm_setting_tc_config_get_qdisc_target   (NMSettingTCConfig *setting);
+NM_AVAILABLE_IN_1_4
+guint32     nm_setting_tc_config_get_qdisc_interval (NMSettingTCConfig *setting);
+NM_AVAILABLE_IN_1_4
+int         nm_setting_tc_config_get_qdisc_ecn      (NMSettingTCConfig *setting);
+NM_AVAILABLE_IN_1_4
+guint32     nm_setting_tc_config_get_qdisc_rate     (NMSettingTCConfig *setting);
+
+G_END_DECLS
+
+#endif /* __NM_SETTING_TC_CONFIG_H__ */
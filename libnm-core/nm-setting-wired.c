@@ -51,6 +51,7 @@ typedef struct {
 	char *duplex;
 	gboolean auto_negotiate;
 	char *device_mac_address;
+	NMHwAddr device_mac_address_bin;
 	char *cloned_mac_address;
 	GArray *mac_address_blacklist;
 	guint32 mtu;
@@ -173,6 +174,16 @@ nm_setting_wired_get_mac_address (NMSettingWired *setting)
 	return NM_SETTING_WIRED_GET_PRIVATE (setting)->device_mac_address;
 }
 
+/* The #NMSettingWired:mac-address property in binary form. Unset if the
+ * property is unset or invalid. */
+const NMHwAddr *
+_nm_setting_wired_get_mac_address_bin (NMSettingWired *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRED (setting), NULL);
+
+	return &NM_SETTING_WIRED_GET_PRIVATE (setting)->device_mac_address_bin;
+}
+
 /**
  * nm_setting_wired_get_cloned_mac_address:
  * @setting: the #NMSettingWired
@@ -801,6 +812,9 @@ set_property (GObject *object, guint prop_id,
 		g_free (priv->device_mac_address);
 		priv->device_mac_address = _nm_utils_hwaddr_canonical_or_invalid (g_value_get_string (value),
 		                                                                  ETH_ALEN);
+		if (   !_nm_hwaddr_from_str (&priv->device_mac_address_bin, priv->device_mac_address)
+		    || priv->device_mac_address_bin.len != ETH_ALEN)
+			priv->device_mac_address_bin.len = 0;
 		break;
 	case PROP_CLONED_MAC_ADDRESS:
 		g_free (priv->cloned_mac_address);
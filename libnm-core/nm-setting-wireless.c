@@ -60,6 +60,8 @@ typedef struct {
 	gboolean hidden;
 	guint32 powersave;
 	NMSettingMacRandomization mac_address_randomization;
+	gboolean fast_transition;
+	char *bgscan;
 } NMSettingWirelessPrivate;
 
 enum {
@@ -79,6 +81,8 @@ enum {
 	PROP_HIDDEN,
 	PROP_POWERSAVE,
 	PROP_MAC_ADDRESS_RANDOMIZATION,
+	PROP_FAST_TRANSITION,
+	PROP_BGSCAN,
 
 	LAST_PROP
 };
@@ -636,6 +640,38 @@ nm_setting_wireless_get_mac_address_randomization (NMSettingWireless *setting)
 	return NM_SETTING_WIRELESS_GET_PRIVATE (setting)->mac_address_randomization;
 }
 
+/**
+ * nm_setting_wireless_get_fast_transition:
+ * @setting: the #NMSettingWireless
+ *
+ * Returns: the #NMSettingWireless:fast-transition property of the setting
+ *
+ * Since: 1.4
+ **/
+gboolean
+nm_setting_wireless_get_fast_transition (NMSettingWireless *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRELESS (setting), FALSE);
+
+	return NM_SETTING_WIRELESS_GET_PRIVATE (setting)->fast_transition;
+}
+
+/**
+ * nm_setting_wireless_get_bgscan:
+ * @setting: the #NMSettingWireless
+ *
+ * Returns: the #NMSettingWireless:bgscan property of the setting
+ *
+ * Since: 1.4
+ **/
+const char *
+nm_setting_wireless_get_bgscan (NMSettingWireless *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRELESS (setting), NULL);
+
+	return NM_SETTING_WIRELESS_GET_PRIVATE (setting)->bgscan;
+}
+
 /**
  * nm_setting_wireless_add_seen_bssid:
  * @setting: the #NMSettingWireless
@@ -836,6 +872,25 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		}
 	}
 
+	if (priv->bgscan) {
+		const char *valid_modules[] = { "simple", "learn", NULL };
+		gs_free char *module = NULL;
+		const char *colon;
+
+		colon = strchr (priv->bgscan, ':');
+		module = colon ? g_strndup (priv->bgscan, colon - priv->bgscan) : g_strdup (priv->bgscan);
+		if (   !_nm_utils_string_in_list (module, valid_modules)
+		    || strpbrk (priv->bgscan, "\"\n")) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("'%s' is not a valid background scan configuration"),
+			             priv->bgscan);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_WIRELESS_SETTING_NAME, NM_SETTING_WIRELESS_BGSCAN);
+			return FALSE;
+		}
+	}
+
 	return TRUE;
 }
 
@@ -881,6 +936,7 @@ finalize (GObject *object)
 	g_free (priv->cloned_mac_address);
 	g_array_unref (priv->mac_address_blacklist);
 	g_slist_free_full (priv->seen_bssids, g_free);
+	g_free (priv->bgscan);
 
 	G_OBJECT_CLASS (nm_setting_wireless_parent_class)->finalize (object);
 }
@@ -957,6 +1013,13 @@ set_property (GObject *object, guint prop_id,
 	case PROP_MAC_ADDRESS_RANDOMIZATION:
 		priv->mac_address_randomization = g_value_get_uint (value);
 		break;
+	case PROP_FAST_TRANSITION:
+		priv->fast_transition = g_value_get_boolean (value);
+		break;
+	case PROP_BGSCAN:
+		g_free (priv->bgscan);
+		priv->bgscan = g_value_dup_string (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1016,6 +1079,12 @@ get_property (GObject *object, guint prop_id,
 	case PROP_MAC_ADDRESS_RANDOMIZATION:
 		g_value_set_uint (value, nm_setting_wireless_get_mac_address_randomization (setting));
 		break;
+	case PROP_FAST_TRANSITION:
+		g_value_set_boolean (value, nm_setting_wireless_get_fast_transition (setting));
+		break;
+	case PROP_BGSCAN:
+		g_value_set_string (value, nm_setting_wireless_get_bgscan (setting));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1414,6 +1483,41 @@ nm_setting_wireless_class_init (NMSettingWirelessClass *setting_class)
 		                    G_PARAM_READWRITE |
 		                    G_PARAM_STATIC_STRINGS));
 
+	/**
+	 * NMSettingWireless:fast-transition:
+	 *
+	 * If %TRUE, also allow IEEE 802.11r Fast BSS Transition for WPA-PSK and
+	 * WPA-Enterprise networks, so that roaming between access points of the
+	 * same mobility domain skips the full authentication.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FAST_TRANSITION,
+		 g_param_spec_boolean (NM_SETTING_WIRELESS_FAST_TRANSITION, "", "",
+		                       FALSE,
+		                       G_PARAM_READWRITE |
+		                       G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMSettingWireless:bgscan:
+	 *
+	 * Background scan configuration passed to wpa_supplicant while
+	 * connected, in the form "module:parameters", for example
+	 * "simple:30:-70:86400" to scan every 30 seconds when the signal is
+	 * below -70 dBm and every 86400 seconds otherwise. Supported modules
+	 * are "simple" and "learn". If unset, WPA-Enterprise networks use
+	 * "simple:30:-65:300" and other networks the supplicant's default.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_BGSCAN,
+		 g_param_spec_string (NM_SETTING_WIRELESS_BGSCAN, "", "",
+		                      NULL,
+		                      G_PARAM_READWRITE |
+		                      G_PARAM_STATIC_STRINGS));
+
 	/* Compatibility for deprecated property */
 	/* ---ifcfg-rh---
 	 * property: security
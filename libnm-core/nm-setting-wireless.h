@@ -56,6 +56,8 @@ G_BEGIN_DECLS
 #define NM_SETTING_WIRELESS_HIDDEN      "hidden"
 #define NM_SETTING_WIRELESS_POWERSAVE   "powersave"
 #define NM_SETTING_WIRELESS_MAC_ADDRESS_RANDOMIZATION   "mac-address-randomization"
+#define NM_SETTING_WIRELESS_FAST_TRANSITION "fast-transition"
+#define NM_SETTING_WIRELESS_BGSCAN          "bgscan"
 
 /**
  * NM_SETTING_WIRELESS_MODE_ADHOC:
@@ -146,6 +148,11 @@ guint32           nm_setting_wireless_get_powersave          (NMSettingWireless
 NM_AVAILABLE_IN_1_2
 NMSettingMacRandomization nm_setting_wireless_get_mac_address_randomization (NMSettingWireless *setting);
 
+NM_AVAILABLE_IN_1_4
+gboolean          nm_setting_wireless_get_fast_transition    (NMSettingWireless *setting);
+NM_AVAILABLE_IN_1_4
+const char       *nm_setting_wireless_get_bgscan             (NMSettingWireless *setting);
+
 gboolean          nm_setting_wireless_add_seen_bssid         (NMSettingWireless *setting,
                                                               const char *bssid);
 
@@ -302,10 +302,16 @@ typedef struct {
 
 	NMSettingPropertyTransformToFunc to_dbus;
 	NMSettingPropertyTransformFromFunc from_dbus;
+
+	/* Whether compare_property() may compare the GValues of the property
+	 * directly instead of going through their D-Bus representation. */
+	gboolean compare_direct;
 } NMSettingProperty;
 
 static GQuark setting_property_overrides_quark;
 static GQuark setting_properties_quark;
+static GQuark setting_properties_index_quark;
+static GQuark setting_duplicate_quark;
 
 static NMSettingProperty *
 find_property (GArray *properties, const char *name)
@@ -521,12 +527,47 @@ _nm_setting_use_legacy_property (NMSetting *setting,
 		return FALSE;
 }
 
+static gboolean
+property_can_compare_direct (const NMSettingProperty *property)
+{
+	GType type;
+
+	/* Properties with a custom D-Bus representation may map different
+	 * GValues to the same variant (or the other way around), so only the
+	 * plain ones are eligible. */
+	if (   !property->param_spec
+	    || property->get_func
+	    || property->to_dbus
+	    || property->dbus_type)
+		return FALSE;
+
+	type = property->param_spec->value_type;
+	switch (G_TYPE_FUNDAMENTAL (type)) {
+	case G_TYPE_BOOLEAN:
+	case G_TYPE_UCHAR:
+	case G_TYPE_INT:
+	case G_TYPE_UINT:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT64:
+	case G_TYPE_DOUBLE:
+	case G_TYPE_ENUM:
+	case G_TYPE_FLAGS:
+	case G_TYPE_STRING:
+		return TRUE;
+	case G_TYPE_BOXED:
+		return type == G_TYPE_STRV || type == G_TYPE_BYTES;
+	default:
+		return FALSE;
+	}
+}
+
 static GArray *
 nm_setting_class_ensure_properties (NMSettingClass *setting_class)
 {
 	GType type = G_TYPE_FROM_CLASS (setting_class), otype;
 	NMSettingProperty property, *override;
 	GArray *overrides, *type_overrides, *properties;
+	GHashTable *prop_index;
 	GParamSpec **property_specs;
 	guint n_property_specs, i;
 
@@ -556,6 +597,7 @@ nm_setting_class_ensure_properties (NMSettingClass *setting_class)
 			property.name = property_specs[i]->name;
 			property.param_spec = property_specs[i];
 		}
+		property.compare_direct = property_can_compare_direct (&property);
 		g_array_append_val (properties, property);
 	}
 	g_free (property_specs);
@@ -568,6 +610,15 @@ nm_setting_class_ensure_properties (NMSettingClass *setting_class)
 	}
 	g_array_unref (overrides);
 
+	/* The array is never modified after this point, so the index can
+	 * point into it. */
+	prop_index = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < properties->len; i++) {
+		override = &g_array_index (properties, NMSettingProperty, i);
+		g_hash_table_insert (prop_index, (gpointer) override->name, override);
+	}
+
+	g_type_set_qdata (type, setting_properties_index_quark, prop_index);
 	g_type_set_qdata (type, setting_properties_quark, properties);
 	return properties;
 }
@@ -586,10 +637,9 @@ nm_setting_class_get_properties (NMSettingClass *setting_class, guint *n_propert
 static const NMSettingProperty *
 nm_setting_class_find_property (NMSettingClass *setting_class, const char *property_name)
 {
-	GArray *properties;
-
-	properties = nm_setting_class_ensure_properties (setting_class);
-	return find_property (properties, property_name);
+	nm_setting_class_ensure_properties (setting_class);
+	return g_hash_table_lookup (g_type_get_qdata (G_TYPE_FROM_CLASS (setting_class), setting_properties_index_quark),
+	                            property_name);
 }
 
 /*************************************************************/
@@ -795,9 +845,12 @@ _nm_setting_new_from_dbus (GType setting_type,
                            GError **error)
 {
 	gs_unref_object NMSetting *setting = NULL;
-	gs_unref_hashtable GHashTable *keys = NULL;
+	gs_unref_hashtable GHashTable *values = NULL;
 	const NMSettingProperty *properties;
 	guint i, n_properties;
+	GVariantIter iter;
+	const char *key;
+	GVariant *entry_value;
 
 	g_return_val_if_fail (G_TYPE_IS_INSTANTIATABLE (setting_type), NULL);
 	g_return_val_if_fail (g_variant_is_of_type (setting_dict, NM_VARIANT_TYPE_SETTING), NULL);
@@ -818,27 +871,23 @@ _nm_setting_new_from_dbus (GType setting_type,
 	 */
 	setting = (NMSetting *) g_object_new (setting_type, NULL);
 
-	if (NM_FLAGS_HAS (parse_flags, NM_SETTING_PARSE_FLAGS_STRICT)) {
-		GVariantIter iter;
-		GVariant *entry, *entry_key;
-		char *key;
-
-		keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-
-		g_variant_iter_init (&iter, setting_dict);
-		while ((entry = g_variant_iter_next_value (&iter))) {
-			entry_key = g_variant_get_child_value (entry, 0);
-			key = g_strdup (g_variant_get_string (entry_key, NULL));
-			g_variant_unref (entry_key);
-			g_variant_unref (entry);
-
-			if (!nm_g_hash_table_add (keys, key)) {
+	/* Index the dictionary once instead of searching it for every property
+	 * of the class. As with g_variant_lookup_value(), the first of duplicate
+	 * keys wins. The keys point into @setting_dict. */
+	values = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_variant_unref);
+	g_variant_iter_init (&iter, setting_dict);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &entry_value)) {
+		if (g_hash_table_contains (values, key)) {
+			g_variant_unref (entry_value);
+			if (NM_FLAGS_HAS (parse_flags, NM_SETTING_PARSE_FLAGS_STRICT)) {
 				g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_SETTING,
 				             _("duplicate property"));
 				g_prefix_error (error, "%s.%s: ", nm_setting_get_name (setting), key);
 				return NULL;
 			}
+			continue;
 		}
+		g_hash_table_insert (values, (gpointer) key, entry_value);
 	}
 
 	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (setting), &n_properties);
@@ -850,10 +899,13 @@ _nm_setting_new_from_dbus (GType setting_type,
 		if (property->param_spec && !(property->param_spec->flags & G_PARAM_WRITABLE))
 			continue;
 
-		value = g_variant_lookup_value (setting_dict, property->name, NULL);
-
-		if (value && keys)
-			g_hash_table_remove (keys, property->name);
+		value = g_hash_table_lookup (values, property->name);
+		if (value) {
+			g_variant_ref (value);
+			/* in strict mode, whatever remains at the end is unknown */
+			if (NM_FLAGS_HAS (parse_flags, NM_SETTING_PARSE_FLAGS_STRICT))
+				g_hash_table_remove (values, property->name);
+		}
 
 		if (value && property->set_func) {
 
@@ -932,12 +984,11 @@ _nm_setting_new_from_dbus (GType setting_type,
 	}
 
 	if (   NM_FLAGS_HAS (parse_flags, NM_SETTING_PARSE_FLAGS_STRICT)
-	    && g_hash_table_size (keys) > 0) {
-		GHashTableIter iter;
-		const char *key;
+	    && g_hash_table_size (values) > 0) {
+		GHashTableIter h_iter;
 
-		g_hash_table_iter_init (&iter, keys);
-		if (g_hash_table_iter_next (&iter, (gpointer *) &key, NULL)) {
+		g_hash_table_iter_init (&h_iter, values);
+		if (g_hash_table_iter_next (&h_iter, (gpointer *) &key, NULL)) {
 			g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY,
 			             _("unknown property"));
 			g_prefix_error (error, "%s.%s: ", nm_setting_get_name (setting), key);
@@ -997,15 +1048,55 @@ _nm_setting_get_property (NMSetting *setting, const char *property_name, GValue
 	return TRUE;
 }
 
-static void
-duplicate_setting (NMSetting *setting,
-                   const char *name,
-                   const GValue *value,
-                   GParamFlags flags,
-                   gpointer user_data)
+typedef struct {
+	GParamSpec *param_spec;
+
+	/* whether a newly created instance has the default value of
+	 * @param_spec, so that copying a default value can be skipped. */
+	gboolean init_is_default;
+} DuplicateProperty;
+
+static int _enumerate_values_sort (GParamSpec **p_a, GParamSpec **p_b, GType *p_type);
+
+/* Returns the properties nm_setting_duplicate() has to copy, in the order
+ * of nm_setting_enumerate_values(). The list is built once per class from
+ * the first new instance @fresh. */
+static GArray *
+_duplicate_properties_ensure (NMSetting *fresh)
 {
-	if ((flags & (G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY)) == G_PARAM_WRITABLE)
-		g_object_set_property (G_OBJECT (user_data), name, value);
+	GType type = G_OBJECT_TYPE (fresh);
+	GArray *properties;
+	GParamSpec **property_specs;
+	guint n_property_specs, i;
+
+	properties = g_type_get_qdata (type, setting_duplicate_quark);
+	if (properties)
+		return properties;
+
+	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (fresh), &n_property_specs);
+	g_qsort_with_data (property_specs, n_property_specs, sizeof (gpointer),
+	                   (GCompareDataFunc) _enumerate_values_sort, &type);
+
+	properties = g_array_new (FALSE, FALSE, sizeof (DuplicateProperty));
+	for (i = 0; i < n_property_specs; i++) {
+		GParamSpec *prop_spec = property_specs[i];
+		nm_auto_unset_gvalue GValue value = G_VALUE_INIT;
+		DuplicateProperty property;
+
+		if ((prop_spec->flags & (G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY)) != (G_PARAM_READABLE | G_PARAM_WRITABLE))
+			continue;
+
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (prop_spec));
+		g_object_get_property (G_OBJECT (fresh), prop_spec->name, &value);
+
+		property.param_spec = prop_spec;
+		property.init_is_default = g_param_value_defaults (prop_spec, &value);
+		g_array_append_val (properties, property);
+	}
+	g_free (property_specs);
+
+	g_type_set_qdata (type, setting_duplicate_quark, properties);
+	return properties;
 }
 
 /**
@@ -1021,13 +1112,29 @@ NMSetting *
 nm_setting_duplicate (NMSetting *setting)
 {
 	GObject *dup;
+	GArray *properties;
+	guint i;
 
 	g_return_val_if_fail (NM_IS_SETTING (setting), NULL);
 
 	dup = g_object_new (G_OBJECT_TYPE (setting), NULL);
+	properties = _duplicate_properties_ensure (NM_SETTING (dup));
 
 	g_object_freeze_notify (dup);
-	nm_setting_enumerate_values (setting, duplicate_setting, dup);
+	for (i = 0; i < properties->len; i++) {
+		const DuplicateProperty *property = &g_array_index (properties, DuplicateProperty, i);
+		nm_auto_unset_gvalue GValue value = G_VALUE_INIT;
+
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (property->param_spec));
+		g_object_get_property (G_OBJECT (setting), property->param_spec->name, &value);
+
+		/* the new instance has that value already */
+		if (   property->init_is_default
+		    && g_param_value_defaults (property->param_spec, &value))
+			continue;
+
+		g_object_set_property (dup, property->param_spec->name, &value);
+	}
 	g_object_thaw_notify (dup);
 
 	return NM_SETTING (dup);
@@ -1138,6 +1245,91 @@ _nm_setting_verify_secret_string (const char *str,
 	return TRUE;
 }
 
+/* Compares two values of a property for which property_can_compare_direct()
+ * holds. The result is the same as comparing the values returned by
+ * get_property_for_dbus() with ignore_default: a value that equals the
+ * default is only equal to another default value, and a %NULL strv or
+ * #GBytes differs from an empty one. */
+static gboolean
+compare_property_direct (NMSetting *setting,
+                         NMSetting *other,
+                         const GParamSpec *prop_spec)
+{
+	GValue value1 = G_VALUE_INIT;
+	GValue value2 = G_VALUE_INIT;
+	gboolean same;
+
+	g_value_init (&value1, prop_spec->value_type);
+	g_value_init (&value2, prop_spec->value_type);
+	g_object_get_property (G_OBJECT (setting), prop_spec->name, &value1);
+	g_object_get_property (G_OBJECT (other), prop_spec->name, &value2);
+
+	switch (G_TYPE_FUNDAMENTAL (prop_spec->value_type)) {
+	case G_TYPE_BOOLEAN:
+		same = !g_value_get_boolean (&value1) == !g_value_get_boolean (&value2);
+		break;
+	case G_TYPE_UCHAR:
+		same = g_value_get_uchar (&value1) == g_value_get_uchar (&value2);
+		break;
+	case G_TYPE_INT:
+		same = g_value_get_int (&value1) == g_value_get_int (&value2);
+		break;
+	case G_TYPE_UINT:
+		same = g_value_get_uint (&value1) == g_value_get_uint (&value2);
+		break;
+	case G_TYPE_INT64:
+		same = g_value_get_int64 (&value1) == g_value_get_int64 (&value2);
+		break;
+	case G_TYPE_UINT64:
+		same = g_value_get_uint64 (&value1) == g_value_get_uint64 (&value2);
+		break;
+	case G_TYPE_DOUBLE:
+		same = g_value_get_double (&value1) == g_value_get_double (&value2);
+		break;
+	case G_TYPE_ENUM:
+		same = g_value_get_enum (&value1) == g_value_get_enum (&value2);
+		break;
+	case G_TYPE_FLAGS:
+		same = g_value_get_flags (&value1) == g_value_get_flags (&value2);
+		break;
+	case G_TYPE_STRING:
+		same = g_strcmp0 (g_value_get_string (&value1), g_value_get_string (&value2)) == 0;
+		break;
+	default:
+		if (prop_spec->value_type == G_TYPE_STRV) {
+			const char *const*strv1 = g_value_get_boxed (&value1);
+			const char *const*strv2 = g_value_get_boxed (&value2);
+
+			if (!strv1 || !strv2)
+				same = (strv1 == strv2);
+			else {
+				guint i;
+
+				for (i = 0; strv1[i] && strv2[i]; i++) {
+					if (strcmp (strv1[i], strv2[i]) != 0)
+						break;
+				}
+				same = !strv1[i] && !strv2[i];
+			}
+		} else {
+			GBytes *bytes1 = g_value_get_boxed (&value1);
+			GBytes *bytes2 = g_value_get_boxed (&value2);
+
+			nm_assert (prop_spec->value_type == G_TYPE_BYTES);
+
+			if (!bytes1 || !bytes2)
+				same = (bytes1 == bytes2);
+			else
+				same = g_bytes_equal (bytes1, bytes2);
+		}
+		break;
+	}
+
+	g_value_unset (&value1);
+	g_value_unset (&value2);
+	return same;
+}
+
 static gboolean
 compare_property (NMSetting *setting,
                   NMSetting *other,
@@ -1179,6 +1371,9 @@ compare_property (NMSetting *setting,
 	property = nm_setting_class_find_property (NM_SETTING_GET_CLASS (setting), prop_spec->name);
 	g_return_val_if_fail (property != NULL, FALSE);
 
+	if (property->compare_direct)
+		return compare_property_direct (setting, other, prop_spec);
+
 	value1 = get_property_for_dbus (setting, property, TRUE);
 	value2 = get_property_for_dbus (other, property, TRUE);
 
@@ -1209,8 +1404,8 @@ nm_setting_compare (NMSetting *a,
                     NMSetting *b,
                     NMSettingCompareFlags flags)
 {
-	GParamSpec **property_specs;
-	guint n_property_specs;
+	const NMSettingProperty *properties;
+	guint n_properties;
 	gint same = TRUE;
 	guint i;
 
@@ -1222,9 +1417,13 @@ nm_setting_compare (NMSetting *a,
 		return FALSE;
 
 	/* And now all properties */
-	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
-	for (i = 0; i < n_property_specs && same; i++) {
-		GParamSpec *prop_spec = property_specs[i];
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (a), &n_properties);
+	for (i = 0; i < n_properties && same; i++) {
+		GParamSpec *prop_spec = properties[i].param_spec;
+
+		/* D-Bus only properties have no GObject counterpart */
+		if (!prop_spec)
+			continue;
 
 		/* Fuzzy compare ignores secrets and properties defined with the FUZZY_IGNORE flag */
 		if (   NM_FLAGS_HAS (flags, NM_SETTING_COMPARE_FLAG_FUZZY)
@@ -1245,7 +1444,6 @@ nm_setting_compare (NMSetting *a,
 
 		same = NM_SETTING_GET_CLASS (a)->compare_property (a, b, prop_spec, flags);
 	}
-	g_free (property_specs);
 
 	return same;
 }
@@ -1334,8 +1532,8 @@ nm_setting_diff (NMSetting *a,
                  gboolean invert_results,
                  GHashTable **results)
 {
-	GParamSpec **property_specs;
-	guint n_property_specs;
+	const NMSettingProperty *properties;
+	guint n_properties;
 	guint i;
 	NMSettingDiffResult a_result = NM_SETTING_DIFF_RESULT_IN_A;
 	NMSettingDiffResult b_result = NM_SETTING_DIFF_RESULT_IN_B;
@@ -1378,12 +1576,15 @@ nm_setting_diff (NMSetting *a,
 	}
 
 	/* And now all properties */
-	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (a), &n_properties);
 
-	for (i = 0; i < n_property_specs; i++) {
-		GParamSpec *prop_spec = property_specs[i];
+	for (i = 0; i < n_properties; i++) {
+		GParamSpec *prop_spec = properties[i].param_spec;
 		NMSettingDiffResult r = NM_SETTING_DIFF_RESULT_UNKNOWN;
 
+		if (!prop_spec)
+			continue;
+
 		/* Handle compare flags */
 		if (!should_compare_prop (a, prop_spec->name, flags, prop_spec->flags))
 			continue;
@@ -1445,7 +1646,6 @@ nm_setting_diff (NMSetting *a,
 				g_hash_table_insert (*results, g_strdup (prop_spec->name), GUINT_TO_POINTER (r));
 		}
 	}
-	g_free (property_specs);
 
 	/* Don't return an empty hash table */
 	if (results_created && !g_hash_table_size (*results)) {
@@ -1999,6 +2199,10 @@ nm_setting_class_init (NMSettingClass *setting_class)
 		setting_property_overrides_quark = g_quark_from_static_string ("nm-setting-property-overrides");
 	if (!setting_properties_quark)
 		setting_properties_quark = g_quark_from_static_string ("nm-setting-properties");
+	if (!setting_properties_index_quark)
+		setting_properties_index_quark = g_quark_from_static_string ("nm-setting-properties-index");
+	if (!setting_duplicate_quark)
+		setting_duplicate_quark = g_quark_from_static_string ("nm-setting-duplicate");
 
 	g_type_class_add_private (setting_class, sizeof (NMSettingPrivate));
 
@@ -1307,12 +1307,13 @@ nm_utils_ip4_dns_from_variant (GVariant *value)
 GVariant *
 nm_utils_ip4_addresses_to_variant (GPtrArray *addresses, const char *gateway)
 {
-	GVariantBuilder builder;
-	int i;
-
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aau"));
+	gs_free GVariant **children = NULL;
+	guint i, n = 0;
 
-	if (addresses) {
+	/* the children are collected and the array created at once, which is much
+	 * cheaper than a GVariantBuilder for large arrays. */
+	if (addresses && addresses->len) {
+		children = g_new (GVariant *, addresses->len);
 		for (i = 0; i < addresses->len; i++) {
 			NMIPAddress *addr = addresses->pdata[i];
 			guint32 array[3];
@@ -1327,13 +1328,12 @@ nm_utils_ip4_addresses_to_variant (GPtrArray *addresses, const char *gateway)
 			else
 				array[2] = 0;
 
-			g_variant_builder_add (&builder, "@au",
-			                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
-			                                                  array, 3, sizeof (guint32)));
+			children[n++] = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+			                                           array, 3, sizeof (guint32));
 		}
 	}
 
-	return g_variant_builder_end (&builder);
+	return g_variant_new_array (G_VARIANT_TYPE ("au"), children, n);
 }
 
 /**
@@ -1363,9 +1363,9 @@ nm_utils_ip4_addresses_from_variant (GVariant *value, char **out_gateway)
 		*out_gateway = NULL;
 
 	g_variant_iter_init (&iter, value);
-	addresses = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_address_unref);
+	addresses = g_ptr_array_new_full (g_variant_n_children (value), (GDestroyNotify) nm_ip_address_unref);
 
-	while (g_variant_iter_next (&iter, "@au", &addr_var)) {
+	while ((addr_var = g_variant_iter_next_value (&iter))) {
 		const guint32 *addr_array;
 		gsize length;
 		NMIPAddress *addr;
@@ -1409,12 +1409,11 @@ nm_utils_ip4_addresses_from_variant (GVariant *value, char **out_gateway)
 GVariant *
 nm_utils_ip4_routes_to_variant (GPtrArray *routes)
 {
-	GVariantBuilder builder;
-	int i;
-
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aau"));
+	gs_free GVariant **children = NULL;
+	guint i, n = 0;
 
-	if (routes) {
+	if (routes && routes->len) {
+		children = g_new (GVariant *, routes->len);
 		for (i = 0; i < routes->len; i++) {
 			NMIPRoute *route = routes->pdata[i];
 			guint32 array[4];
@@ -1428,13 +1427,12 @@ nm_utils_ip4_routes_to_variant (GPtrArray *routes)
 			/* The old routes format uses "0" for default, not "-1" */
 			array[3] = MAX (0, nm_ip_route_get_metric (route));
 
-			g_variant_builder_add (&builder, "@au",
-			                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
-			                                                  array, 4, sizeof (guint32)));
+			children[n++] = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+			                                           array, 4, sizeof (guint32));
 		}
 	}
 
-	return g_variant_builder_end (&builder);
+	return g_variant_new_array (G_VARIANT_TYPE ("au"), children, n);
 }
 
 /**
@@ -1458,9 +1456,9 @@ nm_utils_ip4_routes_from_variant (GVariant *value)
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("aau")), NULL);
 
 	g_variant_iter_init (&iter, value);
-	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_route_unref);
+	routes = g_ptr_array_new_full (g_variant_n_children (value), (GDestroyNotify) nm_ip_route_unref);
 
-	while (g_variant_iter_next (&iter, "@au", &route_var)) {
+	while ((route_var = g_variant_iter_next_value (&iter))) {
 		const guint32 *route_array;
 		gsize length;
 		NMIPRoute *route;
@@ -2067,30 +2065,54 @@ nm_utils_ip_routes_from_variant (GVariant *value,
 	GVariantIter iter, attrs_iter;
 	GVariant *route_var;
 	const char *dest, *next_hop;
-	guint32 prefix, metric32;
+	guint32 prefix;
 	gint64 metric;
 	const char *attr_name;
 	GVariant *attr_val;
 	NMIPRoute *route;
 	GError *error = NULL;
+	gboolean has_prefix, has_attrs;
 
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("aa{sv}")), NULL);
 
 	g_variant_iter_init (&iter, value);
-	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_route_unref);
+	routes = g_ptr_array_new_full (g_variant_n_children (value), (GDestroyNotify) nm_ip_route_unref);
+
+	while ((route_var = g_variant_iter_next_value (&iter))) {
+		/* Read the well-known keys in one pass over the dictionary instead
+		 * of a g_variant_lookup() for each of them. As with the lookup, the
+		 * first occurrence of a key wins. */
+		dest = NULL;
+		next_hop = NULL;
+		metric = -1;
+		has_prefix = FALSE;
+		has_attrs = FALSE;
+		g_variant_iter_init (&attrs_iter, route_var);
+		while (g_variant_iter_next (&attrs_iter, "{&sv}", &attr_name, &attr_val)) {
+			if (nm_streq (attr_name, "dest")) {
+				if (!dest && g_variant_is_of_type (attr_val, G_VARIANT_TYPE_STRING))
+					dest = g_variant_get_string (attr_val, NULL);
+			} else if (nm_streq (attr_name, "prefix")) {
+				if (!has_prefix && g_variant_is_of_type (attr_val, G_VARIANT_TYPE_UINT32)) {
+					prefix = g_variant_get_uint32 (attr_val);
+					has_prefix = TRUE;
+				}
+			} else if (nm_streq (attr_name, "next-hop")) {
+				if (!next_hop && g_variant_is_of_type (attr_val, G_VARIANT_TYPE_STRING))
+					next_hop = g_variant_get_string (attr_val, NULL);
+			} else if (nm_streq (attr_name, "metric")) {
+				if (metric == -1 && g_variant_is_of_type (attr_val, G_VARIANT_TYPE_UINT32))
+					metric = g_variant_get_uint32 (attr_val);
+			} else
+				has_attrs = TRUE;
+			/* the strings point into @route_var, which stays alive. */
+			g_variant_unref (attr_val);
+		}
 
-	while (g_variant_iter_next (&iter, "@a{sv}", &route_var)) {
-		if (   !g_variant_lookup (route_var, "dest", "&s", &dest)
-		    || !g_variant_lookup (route_var, "prefix", "u", &prefix)) {
+		if (!dest || !has_prefix) {
 			g_warning ("Ignoring invalid address");
 			goto next;
 		}
-		if (!g_variant_lookup (route_var, "next-hop", "&s", &next_hop))
-			next_hop = NULL;
-		if (g_variant_lookup (route_var, "metric", "u", &metric32))
-			metric = metric32;
-		else
-			metric = -1;
 
 		route = nm_ip_route_new (family, dest, prefix, next_hop, metric, &error);
 		if (!route) {
@@ -2099,6 +2121,9 @@ nm_utils_ip_routes_from_variant (GVariant *value,
 			goto next;
 		}
 
+		if (!has_attrs)
+			goto add;
+
 		g_variant_iter_init (&attrs_iter, route_var);
 		while (g_variant_iter_next (&attrs_iter, "{&sv}", &attr_name, &attr_val)) {
 			if (   strcmp (attr_name, "dest") != 0
@@ -2109,6 +2134,7 @@ nm_utils_ip_routes_from_variant (GVariant *value,
 			g_variant_unref (attr_val);
 		}
 
+add:
 		g_ptr_array_add (routes, route);
 next:
 		g_variant_unref (route_var);
@@ -2980,7 +3006,13 @@ nm_utils_hwaddr_len (int type)
 	g_assert_not_reached ();
 }
 
-#define HEXVAL(c) ((c) <= '9' ? (c) - '0' : ((c) & 0x4F) - 'A' + 10)
+/* the value of a hex digit plus one, zero for other characters */
+static const guint8 hexval_plus1[256] = {
+	['0'] =  1, ['1'] =  2, ['2'] =  3, ['3'] =  4, ['4'] =  5,
+	['5'] =  6, ['6'] =  7, ['7'] =  8, ['8'] =  9, ['9'] = 10,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
 
 /**
  * nm_utils_hwaddr_atoba:
@@ -3036,18 +3068,19 @@ nm_utils_hwaddr_aton (const char *asc, gpointer buffer, gsize length)
 	g_return_val_if_fail (length > 0 && length <= NM_UTILS_HWADDR_LEN_MAX, NULL);
 
 	while (length && *in) {
-		guint8 d1 = in[0], d2 = in[1];
+		guint8 d1 = hexval_plus1[(guint8) in[0]], d2;
 
-		if (!g_ascii_isxdigit (d1))
+		if (!d1)
 			return NULL;
 
 		/* If there's no leading zero (ie "aa:b:cc") then fake it */
-		if (d2 && g_ascii_isxdigit (d2)) {
-			*out++ = (HEXVAL (d1) << 4) + HEXVAL (d2);
+		d2 = hexval_plus1[(guint8) in[1]];
+		if (d2) {
+			*out++ = ((d1 - 1) << 4) + (d2 - 1);
 			in += 2;
 		} else {
 			/* Fake leading zero */
-			*out++ = (HEXVAL ('0') << 4) + HEXVAL (d1);
+			*out++ = d1 - 1;
 			in += 1;
 		}
 
@@ -3292,6 +3325,97 @@ nm_utils_hwaddr_matches (gconstpointer hwaddr1,
 	return !memcmp (hwaddr1, hwaddr2, hwaddr1_len);
 }
 
+/**
+ * _nm_hwaddr_from_str:
+ * @hwaddr: the #NMHwAddr to set
+ * @asc: (allow-none): the ASCII representation of a hardware address
+ *
+ * Sets @hwaddr to the parsed @asc, or to no address if @asc is %NULL or
+ * can't be parsed.
+ *
+ * Return value: %TRUE if @asc was a valid hardware address.
+ */
+gboolean
+_nm_hwaddr_from_str (NMHwAddr *hwaddr, const char *asc)
+{
+	int len;
+
+	g_return_val_if_fail (hwaddr != NULL, FALSE);
+
+	hwaddr->len = 0;
+	if (!asc)
+		return FALSE;
+
+	len = hwaddr_binary_len (asc);
+	if (len == 0 || len > NM_UTILS_HWADDR_LEN_MAX)
+		return FALSE;
+	if (!nm_utils_hwaddr_aton (asc, hwaddr->addr, len))
+		return FALSE;
+
+	hwaddr->len = len;
+	return TRUE;
+}
+
+void
+_nm_hwaddr_from_bin (NMHwAddr *hwaddr, gconstpointer addr, gsize len)
+{
+	g_return_if_fail (hwaddr != NULL);
+	g_return_if_fail (len <= NM_UTILS_HWADDR_LEN_MAX);
+
+	hwaddr->len = addr ? len : 0;
+	if (hwaddr->len)
+		memcpy (hwaddr->addr, addr, len);
+}
+
+/**
+ * _nm_hwaddr_equal:
+ * @hwaddr1: a #NMHwAddr
+ * @hwaddr2: a #NMHwAddr
+ *
+ * Like nm_utils_hwaddr_matches() for binary addresses, without
+ * parsing anything. Unset addresses equal nothing.
+ *
+ * Return value: %TRUE if @hwaddr1 and @hwaddr2 are equivalent.
+ */
+gboolean
+_nm_hwaddr_equal (const NMHwAddr *hwaddr1, const NMHwAddr *hwaddr2)
+{
+	g_return_val_if_fail (hwaddr1 && hwaddr2, FALSE);
+
+	if (!hwaddr1->len || hwaddr1->len != hwaddr2->len)
+		return FALSE;
+
+	if (hwaddr1->len == INFINIBAND_ALEN) {
+		return !memcmp (&hwaddr1->addr[INFINIBAND_ALEN - 8],
+		                &hwaddr2->addr[INFINIBAND_ALEN - 8],
+		                8);
+	}
+	return !memcmp (hwaddr1->addr, hwaddr2->addr, hwaddr1->len);
+}
+
+/**
+ * _nm_hwaddr_matches_str:
+ * @hwaddr: a #NMHwAddr
+ * @asc: (allow-none): the ASCII representation of a hardware address
+ *
+ * Return value: %TRUE if @asc is a valid hardware address equivalent
+ *   to @hwaddr. Only @asc is parsed.
+ */
+gboolean
+_nm_hwaddr_matches_str (const NMHwAddr *hwaddr, const char *asc)
+{
+	NMHwAddr other;
+
+	g_return_val_if_fail (hwaddr != NULL, FALSE);
+
+	if (!hwaddr->len || !asc)
+		return FALSE;
+	if (!nm_utils_hwaddr_aton (asc, other.addr, hwaddr->len))
+		return FALSE;
+	other.len = hwaddr->len;
+	return _nm_hwaddr_equal (hwaddr, &other);
+}
+
 GVariant *
 _nm_utils_hwaddr_to_dbus (const GValue *prop_value)
 {
@@ -0,0 +1,304 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager setting serialization benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Builds large 802.1x, team and VPN connections and measures their D-Bus
+ * serialization and deserialization, comparison and cloning.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+
+#include "nm-core-internal.h"
+#include "nm-setting-8021x.h"
+#include "nm-setting-connection.h"
+#include "nm-setting-ip4-config.h"
+#include "nm-setting-ip6-config.h"
+#include "nm-setting-team.h"
+#include "nm-setting-vpn.h"
+#include "nm-setting-wired.h"
+#include "nm-simple-connection.h"
+
+#include "nm-test-utils.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int iterations;
+	int items;
+} global_opt = {
+	.iterations = 1000,
+	.items = 100,
+};
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &global_opt.iterations, "Number of times each operation is repeated", "N" },
+		{ "items", 'm', 0, G_OPTION_ARG_INT, &global_opt.items, "Number of VPN data items, addresses and subject matches per connection", "M" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark the D-Bus (de)serialization of large connections.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.iterations <= 0
+	    || global_opt.items < 0
+	    || global_opt.items > 0xFFFF) {
+		g_warning ("Invalid arguments: iterations must be positive and items within 0..65535");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+_add_ip_settings (NMConnection *connection)
+{
+	NMSettingIPConfig *s_ip4;
+	NMSettingIPConfig *s_ip6;
+	int i;
+
+	s_ip4 = (NMSettingIPConfig *) nm_setting_ip4_config_new ();
+	g_object_set (s_ip4,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL,
+	              NULL);
+	for (i = 0; i < global_opt.items; i++) {
+		char addr[NM_UTILS_INET_ADDRSTRLEN];
+		NMIPAddress *address;
+		NMIPRoute *route;
+
+		nm_sprintf_buf (addr, "10.%d.%d.1", i / 256, i % 256);
+		address = nm_ip_address_new (AF_INET, addr, 24, NULL);
+		g_assert (address);
+		nm_setting_ip_config_add_address (s_ip4, address);
+		nm_ip_address_unref (address);
+
+		nm_sprintf_buf (addr, "172.16.%d.0", i % 256);
+		route = nm_ip_route_new (AF_INET, addr, 24, NULL, 100 + i, NULL);
+		g_assert (route);
+		nm_setting_ip_config_add_route (s_ip4, route);
+		nm_ip_route_unref (route);
+	}
+	nm_connection_add_setting (connection, NM_SETTING (s_ip4));
+
+	s_ip6 = (NMSettingIPConfig *) nm_setting_ip6_config_new ();
+	g_object_set (s_ip6,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_AUTO,
+	              NULL);
+	nm_connection_add_setting (connection, NM_SETTING (s_ip6));
+}
+
+static NMConnection *
+_create_connection (const char *type, NMSetting **out_s_base)
+{
+	NMConnection *connection;
+	NMSetting *s_base;
+
+	connection = nmtst_create_minimal_connection (type, NULL, type, NULL);
+	s_base = nm_connection_get_setting_by_name (connection, type);
+	g_assert (s_base);
+	_add_ip_settings (connection);
+
+	*out_s_base = s_base;
+	return connection;
+}
+
+static NMConnection *
+create_8021x (void)
+{
+	NMConnection *connection;
+	NMSetting *s_wired;
+	NMSetting8021x *s_8021x;
+	int i;
+
+	connection = _create_connection (NM_SETTING_WIRED_SETTING_NAME, &s_wired);
+
+	s_8021x = (NMSetting8021x *) nm_setting_802_1x_new ();
+	g_object_set (s_8021x,
+	              NM_SETTING_802_1X_IDENTITY, "bench@example.com",
+	              NM_SETTING_802_1X_ANONYMOUS_IDENTITY, "anonymous@example.com",
+	              NM_SETTING_802_1X_DOMAIN_SUFFIX_MATCH, "example.com",
+	              NM_SETTING_802_1X_PHASE2_AUTH, "mschapv2",
+	              NM_SETTING_802_1X_CA_PATH, "/etc/pki/tls/certs",
+	              NM_SETTING_802_1X_PASSWORD, "password",
+	              NULL);
+	nm_setting_802_1x_add_eap_method (s_8021x, "peap");
+	nm_setting_802_1x_add_eap_method (s_8021x, "ttls");
+	for (i = 0; i < global_opt.items; i++) {
+		char match[64];
+
+		nm_sprintf_buf (match, "DNS:radius%d.example.com", i);
+		nm_setting_802_1x_add_altsubject_match (s_8021x, match);
+		nm_setting_802_1x_add_phase2_altsubject_match (s_8021x, match);
+	}
+	nm_connection_add_setting (connection, NM_SETTING (s_8021x));
+
+	return connection;
+}
+
+static NMConnection *
+create_team (void)
+{
+	NMConnection *connection;
+	NMSetting *s_team;
+	GString *config;
+	int i;
+
+	connection = _create_connection (NM_SETTING_TEAM_SETTING_NAME, &s_team);
+
+	config = g_string_new ("{ \"runner\": { \"name\": \"lacp\", \"tx_hash\": [ \"eth\", \"ipv4\", \"ipv6\" ] }, \"ports\": {");
+	for (i = 0; i < global_opt.items; i++) {
+		g_string_append_printf (config, "%s \"eth%d\": { \"prio\": %d, \"sticky\": %s }",
+		                        i ? "," : "", i, i, (i % 2) ? "true" : "false");
+	}
+	g_string_append (config, " } }");
+	g_object_set (s_team,
+	              NM_SETTING_TEAM_CONFIG, config->str,
+	              NULL);
+	g_string_free (config, TRUE);
+
+	return connection;
+}
+
+static NMConnection *
+create_vpn (void)
+{
+	NMConnection *connection;
+	NMSetting *s_vpn;
+	int i;
+
+	connection = _create_connection (NM_SETTING_VPN_SETTING_NAME, &s_vpn);
+
+	g_object_set (s_vpn,
+	              NM_SETTING_VPN_SERVICE_TYPE, "org.freedesktop.NetworkManager.bench",
+	              NM_SETTING_VPN_USER_NAME, "bench",
+	              NULL);
+	for (i = 0; i < global_opt.items; i++) {
+		char key[32], value[64];
+
+		nm_sprintf_buf (key, "option-%d", i);
+		nm_sprintf_buf (value, "value of option %d", i);
+		nm_setting_vpn_add_data_item ((NMSettingVpn *) s_vpn, key, value);
+
+		nm_sprintf_buf (key, "secret-%d", i);
+		nm_setting_vpn_add_secret ((NMSettingVpn *) s_vpn, key, value);
+	}
+
+	return connection;
+}
+
+/*****************************************************************************/
+
+static void
+bench_connection (const char *kind, NMConnection *connection)
+{
+	gs_unref_variant GVariant *dict = NULL;
+	gs_free char *phase_to = g_strdup_printf ("%s-to-dbus", kind);
+	gs_free char *phase_from = g_strdup_printf ("%s-from-dbus", kind);
+	gs_free char *phase_strict = g_strdup_printf ("%s-from-dbus-strict", kind);
+	gs_free char *phase_compare = g_strdup_printf ("%s-compare", kind);
+	gs_free char *phase_clone = g_strdup_printf ("%s-clone", kind);
+	gs_unref_object NMConnection *clone = NULL;
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, phase_to);
+	for (i = 0; i < global_opt.iterations; i++) {
+		g_clear_pointer (&dict, g_variant_unref);
+		dict = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+		g_variant_ref_sink (dict);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, phase_from);
+	for (i = 0; i < global_opt.iterations; i++) {
+		GError *error = NULL;
+
+		g_clear_object (&clone);
+		clone = _nm_simple_connection_new_from_dbus (dict, NM_SETTING_PARSE_FLAGS_NONE, &error);
+		g_assert_no_error (error);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, phase_strict);
+	for (i = 0; i < global_opt.iterations; i++) {
+		GError *error = NULL;
+
+		g_clear_object (&clone);
+		clone = _nm_simple_connection_new_from_dbus (dict, NM_SETTING_PARSE_FLAGS_STRICT, &error);
+		g_assert_no_error (error);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, phase_compare);
+	for (i = 0; i < global_opt.iterations; i++) {
+		g_assert (nm_connection_compare (connection, clone, NM_SETTING_COMPARE_FLAG_EXACT));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, phase_clone);
+	for (i = 0; i < global_opt.iterations; i++) {
+		g_clear_object (&clone);
+		clone = nm_simple_connection_new_clone (connection);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+	g_assert (nm_connection_compare (connection, clone, NM_SETTING_COMPARE_FLAG_EXACT));
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	gs_unref_object NMConnection *con_8021x = NULL;
+	gs_unref_object NMConnection *con_team = NULL;
+	gs_unref_object NMConnection *con_vpn = NULL;
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	g_print ("# iterations=%d items=%d\n", global_opt.iterations, global_opt.items);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	con_8021x = create_8021x ();
+	con_team = create_team ();
+	con_vpn = create_vpn ();
+
+	bench_connection ("8021x", con_8021x);
+	bench_connection ("team", con_team);
+	bench_connection ("vpn", con_vpn);
+
+	return EXIT_SUCCESS;
+}
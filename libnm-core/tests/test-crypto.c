@@ -112,6 +112,59 @@ test_cert (gconstpointer test_data)
 	g_assert (nm_utils_file_is_certificate (path));
 }
 
+static void
+test_cert_cache (void)
+{
+	gs_free char *src = NULL;
+	gs_free char *contents = NULL;
+	gsize len;
+	char tmpl[] = "/tmp/nm-test-crypto-cert-XXXXXX";
+	GByteArray *array;
+	NMCryptoFileFormat format;
+	GError *error = NULL;
+	int fd;
+
+	src = g_build_filename (TEST_CERT_DIR, "test_ca_cert.der", NULL);
+	if (!g_file_get_contents (src, &contents, &len, NULL))
+		g_assert_not_reached ();
+
+	fd = g_mkstemp (tmpl);
+	g_assert (fd >= 0);
+	close (fd);
+
+	crypto_file_cache_clear ();
+
+	if (!g_file_set_contents (tmpl, contents, len, NULL))
+		g_assert_not_reached ();
+
+	/* the second load is answered from the cache */
+	format = NM_CRYPTO_FILE_FORMAT_UNKNOWN;
+	array = crypto_load_and_verify_certificate (tmpl, &format, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_X509);
+	g_byte_array_free (array, TRUE);
+
+	format = NM_CRYPTO_FILE_FORMAT_UNKNOWN;
+	array = crypto_load_and_verify_certificate (tmpl, &format, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_X509);
+	g_assert_cmpint (array->len, ==, len);
+	g_byte_array_free (array, TRUE);
+
+	/* a changed file is parsed again */
+	if (!g_file_set_contents (tmpl, "not a certificate", -1, NULL))
+		g_assert_not_reached ();
+
+	format = NM_CRYPTO_FILE_FORMAT_UNKNOWN;
+	array = crypto_load_and_verify_certificate (tmpl, &format, &error);
+	g_assert (error);
+	g_assert (!array);
+	g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
+	g_clear_error (&error);
+
+	unlink (tmpl);
+}
+
 static GByteArray *
 file_to_byte_array (const char *filename)
 {
@@ -465,6 +518,7 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/libnm/crypto/cert/pem-combined-2",
 	                      "test2_key_and_cert.pem",
 	                      test_cert);
+	g_test_add_func ("/libnm/crypto/cert/cache", test_cert_cache);
 
 	g_test_add_data_func ("/libnm/crypto/key/padding-6",
 	                      "test_key_and_cert.pem, test, test-key-only-decrypted.der",
@@ -642,6 +642,87 @@ test_setting_ip4_config_address_data (void)
 	g_object_unref (conn);
 }
 
+static void
+test_ip_routes_variant (void)
+{
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	gs_unref_ptrarray GPtrArray *routes2 = NULL;
+	gs_unref_variant GVariant *value = NULL;
+	NMIPRoute *route;
+	GVariant *attr;
+	GError *error = NULL;
+
+	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_route_unref);
+
+	route = nm_ip_route_new (AF_INET, "1.2.3.0", 24, "1.2.3.1", 100, &error);
+	g_assert_no_error (error);
+	g_ptr_array_add (routes, route);
+
+	route = nm_ip_route_new (AF_INET, "4.5.0.0", 16, NULL, -1, &error);
+	g_assert_no_error (error);
+	nm_ip_route_set_attribute (route, "one", g_variant_new_string ("foo"));
+	g_ptr_array_add (routes, route);
+
+	/* new-style */
+	value = g_variant_ref_sink (nm_utils_ip_routes_to_variant (routes));
+	routes2 = nm_utils_ip_routes_from_variant (value, AF_INET);
+	g_assert_cmpint (routes2->len, ==, 2);
+
+	route = routes2->pdata[0];
+	g_assert_cmpstr (nm_ip_route_get_dest (route), ==, "1.2.3.0");
+	g_assert_cmpint (nm_ip_route_get_prefix (route), ==, 24);
+	g_assert_cmpstr (nm_ip_route_get_next_hop (route), ==, "1.2.3.1");
+	g_assert_cmpint (nm_ip_route_get_metric (route), ==, 100);
+	g_assert (!nm_ip_route_get_attribute (route, "one"));
+
+	route = routes2->pdata[1];
+	g_assert_cmpstr (nm_ip_route_get_dest (route), ==, "4.5.0.0");
+	g_assert_cmpint (nm_ip_route_get_prefix (route), ==, 16);
+	g_assert_cmpstr (nm_ip_route_get_next_hop (route), ==, NULL);
+	g_assert_cmpint (nm_ip_route_get_metric (route), ==, -1);
+	attr = nm_ip_route_get_attribute (route, "one");
+	g_assert (attr);
+	g_assert_cmpstr (g_variant_get_string (attr, NULL), ==, "foo");
+
+	g_clear_pointer (&routes2, g_ptr_array_unref);
+	g_clear_pointer (&value, g_variant_unref);
+
+	/* a route without prefix is ignored */
+	value = g_variant_ref_sink (g_variant_new_parsed ("[{'dest': <'1.2.3.0'>}, {'dest': <'1.2.4.0'>, 'prefix': <uint32 24>, 'metric': <uint32 5>}]"));
+	g_test_expect_message ("libnm", G_LOG_LEVEL_WARNING, "*Ignoring invalid*");
+	routes2 = nm_utils_ip_routes_from_variant (value, AF_INET);
+	g_test_assert_expected_messages ();
+	g_assert_cmpint (routes2->len, ==, 1);
+	route = routes2->pdata[0];
+	g_assert_cmpstr (nm_ip_route_get_dest (route), ==, "1.2.4.0");
+	g_assert_cmpint (nm_ip_route_get_metric (route), ==, 5);
+
+	g_clear_pointer (&routes2, g_ptr_array_unref);
+	g_clear_pointer (&value, g_variant_unref);
+
+	/* legacy format */
+	value = g_variant_ref_sink (nm_utils_ip4_routes_to_variant (routes));
+	g_assert_cmpint (g_variant_n_children (value), ==, 2);
+	routes2 = nm_utils_ip4_routes_from_variant (value);
+	g_assert_cmpint (routes2->len, ==, 2);
+
+	route = routes2->pdata[0];
+	g_assert_cmpstr (nm_ip_route_get_dest (route), ==, "1.2.3.0");
+	g_assert_cmpstr (nm_ip_route_get_next_hop (route), ==, "1.2.3.1");
+	g_assert_cmpint (nm_ip_route_get_metric (route), ==, 100);
+
+	route = routes2->pdata[1];
+	g_assert_cmpstr (nm_ip_route_get_dest (route), ==, "4.5.0.0");
+	g_assert_cmpint (nm_ip_route_get_metric (route), ==, -1);
+
+	g_clear_pointer (&value, g_variant_unref);
+
+	/* empty */
+	value = g_variant_ref_sink (nm_utils_ip4_routes_to_variant (NULL));
+	g_assert (g_variant_is_of_type (value, G_VARIANT_TYPE ("aau")));
+	g_assert_cmpint (g_variant_n_children (value), ==, 0);
+}
+
 static void
 test_setting_gsm_apn_spaces (void)
 {
@@ -2409,6 +2490,74 @@ test_setting_compare_timestamp (void)
 	g_assert (success);
 }
 
+static gboolean
+_duplicate_notify_hook (GSignalInvocationHint *ihint,
+                        guint n_param_values,
+                        const GValue *param_values,
+                        gpointer user_data)
+{
+	GObject *object = g_value_get_object (&param_values[0]);
+	GParamSpec *pspec = g_value_get_param (&param_values[1]);
+	GHashTable *set = user_data;
+
+	if (NM_IS_SETTING_CONNECTION (object))
+		g_hash_table_add (set, (gpointer) pspec->name);
+	return TRUE;
+}
+
+static void
+test_setting_duplicate_skips_defaults (void)
+{
+	gs_unref_object NMSetting *old = NULL, *new = NULL;
+	gs_unref_hashtable GHashTable *set = NULL;
+	guint notify_id;
+	gulong hook_id;
+
+	old = nm_setting_connection_new ();
+	g_object_set (old,
+	              NM_SETTING_CONNECTION_ID, "duplicate me",
+	              NM_SETTING_CONNECTION_UUID, "4e80a56d-c99f-4aad-a6dd-b449bc398c57",
+	              NM_SETTING_CONNECTION_AUTOCONNECT, FALSE,
+	              NM_SETTING_CONNECTION_MASTER, "bond0",
+	              NULL);
+	/* back to the default */
+	g_object_set (old, NM_SETTING_CONNECTION_MASTER, NULL, NULL);
+
+	/* the notifications of the new setting tell which properties were set */
+	set = g_hash_table_new (g_str_hash, g_str_equal);
+	notify_id = g_signal_lookup ("notify", G_TYPE_OBJECT);
+	hook_id = g_signal_add_emission_hook (notify_id, 0, _duplicate_notify_hook, set, NULL);
+	new = nm_setting_duplicate (old);
+	g_signal_remove_emission_hook (notify_id, hook_id);
+
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert_cmpstr (nm_setting_connection_get_master (NM_SETTING_CONNECTION (new)), ==, NULL);
+	g_assert (!nm_setting_connection_get_autoconnect (NM_SETTING_CONNECTION (new)));
+
+	/* values that differ from the default are copied... */
+	g_assert (g_hash_table_contains (set, NM_SETTING_CONNECTION_ID));
+	g_assert (g_hash_table_contains (set, NM_SETTING_CONNECTION_UUID));
+	g_assert (g_hash_table_contains (set, NM_SETTING_CONNECTION_AUTOCONNECT));
+
+	/* ... default values that the new setting already has are not. Only
+	 * check properties that are not G_PARAM_CONSTRUCT, g_object_new() may
+	 * notify those. */
+	g_assert (!g_hash_table_contains (set, NM_SETTING_CONNECTION_MASTER));
+	g_assert (!g_hash_table_contains (set, NM_SETTING_CONNECTION_SLAVE_TYPE));
+	g_assert (!g_hash_table_contains (set, NM_SETTING_CONNECTION_INTERFACE_NAME));
+
+	/* a second duplicate uses the cached property list */
+	g_object_unref (new);
+	g_hash_table_remove_all (set);
+	hook_id = g_signal_add_emission_hook (notify_id, 0, _duplicate_notify_hook, set, NULL);
+	new = nm_setting_duplicate (old);
+	g_signal_remove_emission_hook (notify_id, hook_id);
+
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (g_hash_table_contains (set, NM_SETTING_CONNECTION_ID));
+	g_assert (!g_hash_table_contains (set, NM_SETTING_CONNECTION_MASTER));
+}
+
 typedef struct {
 	NMSettingSecretFlags secret_flags;
 	NMSettingCompareFlags comp_flags;
@@ -2595,6 +2744,42 @@ test_hwaddr_equal (void)
 	g_assert (nm_utils_hwaddr_matches (null_binary, sizeof (null_binary), NULL, ETH_ALEN));
 }
 
+static void
+test_hwaddr_bin (void)
+{
+	const guint8 binary[ETH_ALEN] = { 0x00, 0x1A, 0x2B, 0x03, 0x44, 0x05 };
+	const char *ib1 = "80:00:00:48:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65";
+	const char *ib2 = "80:00:02:08:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65";
+	NMHwAddr a, b;
+
+	g_assert (_nm_hwaddr_from_str (&a, "0:1a:2B:3:44:5"));
+	g_assert_cmpint (a.len, ==, ETH_ALEN);
+	g_assert (!memcmp (a.addr, binary, ETH_ALEN));
+
+	_nm_hwaddr_from_bin (&b, binary, sizeof (binary));
+	g_assert (_nm_hwaddr_equal (&a, &b));
+	g_assert (_nm_hwaddr_matches_str (&a, "00-1A-2B-03-44-05"));
+	g_assert (!_nm_hwaddr_matches_str (&a, "00:1a:2b:03:44:06"));
+	g_assert (!_nm_hwaddr_matches_str (&a, "00:1a:2b:03:44:05:06"));
+	g_assert (!_nm_hwaddr_matches_str (&a, NULL));
+
+	g_assert (_nm_hwaddr_from_str (&b, "00:1a:2b:03:44:05:06:07"));
+	g_assert (!_nm_hwaddr_equal (&a, &b));
+
+	g_assert (!_nm_hwaddr_from_str (&b, "00:1a:2b:03:44:0g"));
+	g_assert_cmpint (b.len, ==, 0);
+	g_assert (!_nm_hwaddr_equal (&b, &b));
+	g_assert (!_nm_hwaddr_from_str (&b, NULL));
+
+	/* InfiniBand addresses only compare their last 8 bytes */
+	g_assert (_nm_hwaddr_from_str (&a, ib1));
+	g_assert (_nm_hwaddr_from_str (&b, ib2));
+	g_assert_cmpint (a.len, ==, INFINIBAND_ALEN);
+	g_assert (_nm_hwaddr_equal (&a, &b));
+	g_assert (_nm_hwaddr_matches_str (&a, ib2));
+	g_assert (nm_utils_hwaddr_matches (ib1, -1, ib2, -1));
+}
+
 static void
 test_hwaddr_canonical (void)
 {
@@ -3149,6 +3334,44 @@ test_setting_802_1x_changed_signal (void)
 	g_object_unref (connection);
 }
 
+static void
+test_connection_verify_cached (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	NMSettingConnection *s_con;
+	GError *error = NULL;
+	int i;
+
+	con = nmtst_create_minimal_connection ("verify cache", NULL, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+	nm_connection_normalize (con, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	for (i = 0; i < 2; i++)
+		nmtst_assert_connection_verifies_without_normalization (con);
+
+	/* property changes invalidate the cached result */
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, NULL, NULL);
+	for (i = 0; i < 2; i++) {
+		g_assert (!nm_connection_verify (con, &error));
+		g_assert_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_MISSING_PROPERTY);
+		g_clear_error (&error);
+	}
+	g_assert (!nm_connection_verify (con, NULL));
+
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "verify cache", NULL);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	/* ... and so does adding or removing settings */
+	nm_connection_remove_setting (con, NM_TYPE_SETTING_WIRED);
+	g_assert (!nm_connection_verify (con, NULL));
+
+	nm_connection_add_setting (con, nm_setting_wired_new ());
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	nm_connection_clear_settings (con);
+	g_assert (!nm_connection_verify (con, NULL));
+}
+
 static void
 test_setting_old_uuid (void)
 {
@@ -4038,6 +4261,52 @@ test_setting_compare_default_strv (void)
 	out_settings = NULL;
 }
 
+static void
+test_setting_compare_direct (void)
+{
+	gs_unref_object NMSetting *s1 = NULL, *s2 = NULL;
+	gs_unref_bytes GBytes *ssid1 = NULL, *ssid2 = NULL, *ssid_empty = NULL;
+	const char *bssids1[] = { "00:11:22:33:44:55", NULL };
+	const char *bssids2[] = { "00:11:22:33:44:55", "00:11:22:33:44:66", NULL };
+
+	ssid1 = g_bytes_new_static ("ssid", 4);
+	ssid2 = g_bytes_new_static ("ssid2", 5);
+	ssid_empty = g_bytes_new_static ("", 0);
+
+	s1 = nm_setting_wireless_new ();
+	s2 = nm_setting_wireless_new ();
+	g_assert (nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* GBytes */
+	g_object_set (s1, NM_SETTING_WIRELESS_SSID, ssid1, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_SSID, ssid2, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_SSID, ssid_empty, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_SSID, ssid1, NULL);
+	g_assert (nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* integers and booleans */
+	g_object_set (s1, NM_SETTING_WIRELESS_MTU, 1400, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_MTU, 1400, NULL);
+	g_assert (nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_object_set (s1, NM_SETTING_WIRELESS_HIDDEN, TRUE, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_HIDDEN, TRUE, NULL);
+	g_assert (nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* strv, where a prefix must not be mistaken for equality */
+	g_object_set (s1, NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST, bssids1, NULL);
+	g_object_set (s2, NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST, bssids2, NULL);
+	g_assert (!nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (!nm_setting_compare (s2, s1, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s2, NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST, bssids1, NULL);
+	g_assert (nm_setting_compare (s1, s2, NM_SETTING_COMPARE_FLAG_EXACT));
+}
+
 static void
 test_hexstr2bin (void)
 {
@@ -4302,6 +4571,48 @@ test_nm_utils_ascii_str_to_int64 (void)
 
 /******************************************************************************/
 
+static void
+test_nm_intern_str (void)
+{
+	char buf[32];
+	const char *a, *b, *c;
+	guint n_before = nm_intern_str_get_count ();
+
+	g_assert (!nm_intern_str_ref (NULL));
+	g_assert (!nm_intern_str_lookup ("test-intern-str-eth0"));
+
+	a = nm_intern_str_ref ("test-intern-str-eth0");
+	g_assert_cmpstr (a, ==, "test-intern-str-eth0");
+	g_assert_cmpint (nm_intern_str_get_count (), ==, n_before + 1);
+
+	/* an equal string at another address gives the same pointer */
+	g_strlcpy (buf, "test-intern-str-eth0", sizeof (buf));
+	b = nm_intern_str_ref (buf);
+	g_assert (a == b);
+	g_assert (nm_intern_str_lookup (buf) == a);
+	g_assert (nm_intern_str_ref_interned (a) == a);
+	g_assert_cmpint (nm_intern_str_get_count (), ==, n_before + 1);
+
+	c = NULL;
+	g_assert (nm_intern_str_set (&c, "test-intern-str-eth1"));
+	g_assert (c != a);
+	g_assert (!nm_intern_str_set (&c, "test-intern-str-eth1"));
+	g_assert (nm_intern_str_set (&c, buf));
+	g_assert (c == a);
+	g_assert_cmpint (nm_intern_str_get_count (), ==, n_before + 1);
+
+	nm_intern_str_unref (a);
+	nm_intern_str_unref (b);
+	nm_intern_str_unref (a);
+	g_assert (nm_intern_str_lookup (buf) == c);
+	nm_intern_str_set (&c, NULL);
+	g_assert (!c);
+	g_assert (!nm_intern_str_lookup (buf));
+	g_assert_cmpint (nm_intern_str_get_count (), ==, n_before);
+}
+
+/******************************************************************************/
+
 static void
 test_nm_utils_strstrdictkey (void)
 {
@@ -5124,6 +5435,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_vpn_modify_during_foreach", test_setting_vpn_modify_during_foreach);
 	g_test_add_func ("/core/general/test_setting_ip4_config_labels", test_setting_ip4_config_labels);
 	g_test_add_func ("/core/general/test_setting_ip4_config_address_data", test_setting_ip4_config_address_data);
+	g_test_add_func ("/core/general/test_ip_routes_variant", test_ip_routes_variant);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_spaces", test_setting_gsm_apn_spaces);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_bad_chars", test_setting_gsm_apn_bad_chars);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_underscore", test_setting_gsm_apn_underscore);
@@ -5136,6 +5448,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_to_dbus_enum", test_setting_to_dbus_enum);
 	g_test_add_func ("/core/general/test_setting_compare_id", test_setting_compare_id);
 	g_test_add_func ("/core/general/test_setting_compare_timestamp", test_setting_compare_timestamp);
+	g_test_add_func ("/core/general/test_setting_duplicate_skips_defaults", test_setting_duplicate_skips_defaults);
 #define ADD_FUNC(name, func, secret_flags, comp_flags, remove_secret) \
 	g_test_add_data_func_full ("/core/general/" G_STRINGIFY (func) "_" name, \
 	                           test_data_compare_secrets_new (secret_flags, comp_flags, remove_secret), \
@@ -5190,6 +5503,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_hwaddr_aton_no_leading_zeros", test_hwaddr_aton_no_leading_zeros);
 	g_test_add_func ("/core/general/test_hwaddr_aton_malformed", test_hwaddr_aton_malformed);
 	g_test_add_func ("/core/general/test_hwaddr_equal", test_hwaddr_equal);
+	g_test_add_func ("/core/general/test_hwaddr_bin", test_hwaddr_bin);
 	g_test_add_func ("/core/general/test_hwaddr_canonical", test_hwaddr_canonical);
 
 	g_test_add_func ("/core/general/test_ip4_prefix_to_netmask", test_ip4_prefix_to_netmask);
@@ -5206,15 +5520,18 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_wireless_changed_signal", test_setting_wireless_changed_signal);
 	g_test_add_func ("/core/general/test_setting_wireless_security_changed_signal", test_setting_wireless_security_changed_signal);
 	g_test_add_func ("/core/general/test_setting_802_1x_changed_signal", test_setting_802_1x_changed_signal);
+	g_test_add_func ("/core/general/test_connection_verify_cached", test_connection_verify_cached);
 	g_test_add_func ("/core/general/test_setting_ip4_gateway", test_setting_ip4_gateway);
 	g_test_add_func ("/core/general/test_setting_ip6_gateway", test_setting_ip6_gateway);
 	g_test_add_func ("/core/general/test_setting_compare_default_strv", test_setting_compare_default_strv);
+	g_test_add_func ("/core/general/test_setting_compare_direct", test_setting_compare_direct);
 
 	g_test_add_func ("/core/general/hexstr2bin", test_hexstr2bin);
 	g_test_add_func ("/core/general/test_nm_utils_uuid_generate_from_string", test_nm_utils_uuid_generate_from_string);
 	g_test_add_func ("/core/general/_nm_utils_uuid_generate_from_strings", test_nm_utils_uuid_generate_from_strings);
 
 	g_test_add_func ("/core/general/_nm_utils_ascii_str_to_int64", test_nm_utils_ascii_str_to_int64);
+	g_test_add_func ("/core/general/nm_intern_str", test_nm_intern_str);
 	g_test_add_func ("/core/general/nm_utils_is_power_of_two", test_nm_utils_is_power_of_two);
 	g_test_add_func ("/core/general/_glib_compat_g_ptr_array_insert", test_g_ptr_array_insert);
 	g_test_add_func ("/core/general/_glib_compat_g_hash_table_get_keys_as_array", test_g_hash_table_get_keys_as_array);
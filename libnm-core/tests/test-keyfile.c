@@ -520,6 +520,289 @@ test_8021x_cert_read (void)
 
 /******************************************************************************/
 
+static void
+_test_read_data_check (const char *data)
+{
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con_data = NULL;
+	GError *error = NULL;
+
+	/* nm_keyfile_read_data() must read the same as nm_keyfile_read(),
+	 * regardless of whether it takes its fast path. */
+	keyfile = _keyfile_load_from_data (data);
+	con = nm_keyfile_read (keyfile, "/test_read_data/test", NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (NM_IS_CONNECTION (con));
+	nmtst_connection_normalize (con);
+
+	con_data = nm_keyfile_read_data (data, strlen (data), "/test_read_data/test", NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (NM_IS_CONNECTION (con_data));
+	nmtst_connection_normalize (con_data);
+
+	nmtst_assert_connection_equals (con, FALSE, con_data, FALSE);
+}
+
+static void
+test_read_data (void)
+{
+	GError *error = NULL;
+	NMConnection *con;
+
+	_test_read_data_check ("[connection]\n"
+	                       "type=ethernet\n"
+	                       "id = bench 1\n"
+	                       "uuid=8a8ed7d4-2ac3-4a3b-a4e4-f2a6e7aba3ab\n"
+	                       "autoconnect=false\n"
+	                       "autoconnect-priority=-5\n"
+	                       "timestamp=1466499999\n"
+	                       "\n"
+	                       "# a comment\n"
+	                       "[ethernet]\n"
+	                       "mac-address=02:00:00:00:00:01\n"
+	                       "mtu=1400\n"
+	                       "interface-name=eth0\n"
+	                       "\n"
+	                       "[ipv4]\n"
+	                       "method=manual\n"
+	                       "address1=100.64.0.1/24,100.64.0.254\n"
+	                       "dns=192.168.0.1;\n"
+	                       "dns-search=example.com;\n"
+	                       "\n"
+	                       "[ipv6]\n"
+	                       "method=auto\n");
+
+	/* values that need GKeyFile: escapes, invalid numbers */
+	_test_read_data_check ("[connection]\n"
+	                       "type=802-3-ethernet\n"
+	                       "id=a\\sb\\tc\n"
+	                       "autoconnect=yes\n"
+	                       "autoconnect-priority=+5\n"
+	                       "[802-3-ethernet]\n"
+	                       "mtu=0x10\n");
+
+	/* keyfiles that the tokenizer leaves to GKeyFile */
+	_test_read_data_check ("[connection]\r\n"
+	                       "type=ethernet\r\n"
+	                       "id=crlf\r\n");
+	_test_read_data_check ("[connection]\n"
+	                       "type=ethernet\n"
+	                       "id=x\n"
+	                       "id[de]=y\n");
+	_test_read_data_check ("[connection]\n"
+	                       "type=ethernet\n"
+	                       "id=x\n"
+	                       "[ethernet]\n"
+	                       "[connection]\n"
+	                       "id=y\n");
+
+	con = nm_keyfile_read_data ("type=ethernet\n", NM_STRLEN ("type=ethernet\n"),
+	                            "/test_read_data/test", NULL, NULL, NULL, &error);
+	g_assert_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_GROUP_NOT_FOUND);
+	g_assert (!con);
+	g_clear_error (&error);
+}
+
+/******************************************************************************/
+
+static void
+test_route_options (void)
+{
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	gs_unref_keyfile GKeyFile *keyfile2 = NULL;
+	gs_unref_object NMConnection *con = NULL;
+	gs_free char *str = NULL;
+	NMSettingIPConfig *s_ip4;
+	NMIPRoute *route;
+	GVariant *variant;
+
+	keyfile = _keyfile_load_from_data ("[connection]\n"
+	                                   "type=ethernet\n"
+	                                   "id=route-options\n"
+	                                   "uuid=8a8ed7d4-2ac3-4a3b-a4e4-f2a6e7aba3ab\n"
+	                                   "[ipv4]\n"
+	                                   "method=manual\n"
+	                                   "address1=192.168.1.5/24\n"
+	                                   "route1=10.0.0.0/8,192.168.1.1,100\n"
+	                                   "route1_options=initcwnd=20, lock-mtu=true,mtu=1400,congctl=cubic\n");
+	con = _nm_keyfile_read (keyfile, "/test_route_options", NULL, NULL, NULL, TRUE);
+
+	s_ip4 = nm_connection_get_setting_ip4_config (con);
+	g_assert_cmpint (nm_setting_ip_config_get_num_routes (s_ip4), ==, 1);
+	route = nm_setting_ip_config_get_route (s_ip4, 0);
+
+	variant = nm_ip_route_get_attribute (route, NM_IP_ROUTE_ATTRIBUTE_INITCWND);
+	g_assert (variant && g_variant_is_of_type (variant, G_VARIANT_TYPE_UINT32));
+	g_assert_cmpint (g_variant_get_uint32 (variant), ==, 20);
+	variant = nm_ip_route_get_attribute (route, NM_IP_ROUTE_ATTRIBUTE_LOCK_MTU);
+	g_assert (variant && g_variant_get_boolean (variant));
+	variant = nm_ip_route_get_attribute (route, NM_IP_ROUTE_ATTRIBUTE_CONGCTL);
+	g_assert_cmpstr (g_variant_get_string (variant, NULL), ==, "cubic");
+	g_assert (!nm_ip_route_get_attribute (route, NM_IP_ROUTE_ATTRIBUTE_WINDOW));
+
+	/* attributes of the wrong type don't verify */
+	nm_ip_route_set_attribute (route, NM_IP_ROUTE_ATTRIBUTE_WINDOW, g_variant_new_string ("1"));
+	g_assert (!nm_setting_verify (NM_SETTING (s_ip4), con, NULL));
+	nm_ip_route_set_attribute (route, NM_IP_ROUTE_ATTRIBUTE_WINDOW, NULL);
+
+	/* unknown attributes are not written */
+	nm_ip_route_set_attribute (route, "foo", g_variant_new_uint32 (1));
+
+	keyfile2 = _nm_keyfile_write (con, NULL, NULL);
+	str = g_key_file_get_string (keyfile2, "ipv4", "route1_options", NULL);
+	g_assert_cmpstr (str, ==, "congctl=cubic,initcwnd=20,lock-mtu=true,mtu=1400");
+}
+
+/******************************************************************************/
+
+static void
+test_ethtool (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	NMSettingEthtool *s_ethtool;
+
+	con = nmtst_create_minimal_connection ("ethtool", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	s_ethtool = (NMSettingEthtool *) nm_setting_ethtool_new ();
+	g_assert_cmpint (nm_setting_ethtool_get_feature_gro (s_ethtool), ==, -1);
+	g_assert_cmpint (nm_setting_ethtool_get_ring_rx (s_ethtool), ==, 0);
+	g_assert_cmpint (nm_setting_ethtool_get_coalesce_rx_usecs (s_ethtool), ==, -1);
+	g_object_set (s_ethtool,
+	              NM_SETTING_ETHTOOL_FEATURE_GRO, 0,
+	              NM_SETTING_ETHTOOL_RING_RX, (guint) 4096,
+	              NM_SETTING_ETHTOOL_COALESCE_RX_USECS, 0,
+	              NM_SETTING_ETHTOOL_RPS_CPUS, "00000001,0000000f",
+	              NULL);
+	nm_connection_add_setting (con, NM_SETTING (s_ethtool));
+
+	g_object_set (s_ethtool, NM_SETTING_ETHTOOL_XPS_CPUS, "1,,2", NULL);
+	g_assert (!nm_setting_verify (NM_SETTING (s_ethtool), con, NULL));
+	g_object_set (s_ethtool, NM_SETTING_ETHTOOL_XPS_CPUS, "100000000", NULL);
+	g_assert (!nm_setting_verify (NM_SETTING (s_ethtool), con, NULL));
+	g_object_set (s_ethtool, NM_SETTING_ETHTOOL_XPS_CPUS, NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD, NULL);
+	nmtst_connection_normalize (con);
+
+	keyfile = _nm_keyfile_write (con, NULL, NULL);
+	g_assert_cmpint (g_key_file_get_integer (keyfile, "ethtool", "ring-rx", NULL), ==, 4096);
+	g_assert (!g_key_file_has_key (keyfile, "ethtool", "feature-tso", NULL));
+
+	con2 = _nm_keyfile_read (keyfile, "/test_ethtool", NULL, NULL, NULL, FALSE);
+	s_ethtool = nm_connection_get_setting_ethtool (con2);
+	g_assert (s_ethtool);
+	g_assert_cmpint (nm_setting_ethtool_get_feature_gro (s_ethtool), ==, 0);
+	g_assert_cmpint (nm_setting_ethtool_get_feature_tso (s_ethtool), ==, -1);
+	g_assert_cmpint (nm_setting_ethtool_get_ring_rx (s_ethtool), ==, 4096);
+	g_assert_cmpint (nm_setting_ethtool_get_coalesce_rx_usecs (s_ethtool), ==, 0);
+	g_assert_cmpint (nm_setting_ethtool_get_coalesce_tx_usecs (s_ethtool), ==, -1);
+	g_assert_cmpstr (nm_setting_ethtool_get_rps_cpus (s_ethtool), ==, "00000001,0000000f");
+	g_assert_cmpint (nm_setting_ethtool_get_rps_flow_cnt (s_ethtool), ==, -1);
+	g_assert_cmpstr (nm_setting_ethtool_get_xps_cpus (s_ethtool), ==, NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD);
+}
+
+/******************************************************************************/
+
+static void
+test_tc_config (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	NMSettingTCConfig *s_tc;
+
+	con = nmtst_create_minimal_connection ("tc", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	s_tc = (NMSettingTCConfig *) nm_setting_tc_config_new ();
+	g_object_set (s_tc,
+	              NM_SETTING_TC_CONFIG_QDISC_TARGET, (guint) 5000,
+	              NULL);
+	nm_connection_add_setting (con, NM_SETTING (s_tc));
+
+	/* options without a qdisc */
+	g_assert (!nm_setting_verify (NM_SETTING (s_tc), con, NULL));
+	g_object_set (s_tc, NM_SETTING_TC_CONFIG_QDISC, "fq codel", NULL);
+	g_assert (!nm_setting_verify (NM_SETTING (s_tc), con, NULL));
+
+	g_object_set (s_tc,
+	              NM_SETTING_TC_CONFIG_QDISC, "fq_codel",
+	              NM_SETTING_TC_CONFIG_QDISC_ECN, 1,
+	              NULL);
+	nmtst_connection_normalize (con);
+
+	keyfile = _nm_keyfile_write (con, NULL, NULL);
+	g_assert (!g_key_file_has_key (keyfile, "tc", "qdisc-limit", NULL));
+
+	con2 = _nm_keyfile_read (keyfile, "/test_tc_config", NULL, NULL, NULL, FALSE);
+	s_tc = nm_connection_get_setting_tc_config (con2);
+	g_assert (s_tc);
+	g_assert_cmpstr (nm_setting_tc_config_get_qdisc (s_tc), ==, "fq_codel");
+	g_assert_cmpint (nm_setting_tc_config_get_qdisc_target (s_tc), ==, 5000);
+	g_assert_cmpint (nm_setting_tc_config_get_qdisc_ecn (s_tc), ==, 1);
+	g_assert_cmpint (nm_setting_tc_config_get_qdisc_limit (s_tc), ==, 0);
+}
+
+/******************************************************************************/
+
+static void
+test_sriov (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	NMSettingSriov *s_sriov;
+	NMSriovVFConfig vf;
+	const char *const *vfs;
+	const char *const vfs_in[] = { "0 mac=52:54:00:12:34:56 vlan=100.3 trust=true",
+	                               "3  spoof-check=off",
+	                               NULL };
+
+	g_assert (_nm_setting_sriov_parse_vf (vfs_in[0], &vf, NULL));
+	g_assert_cmpint (vf.index, ==, 0);
+	g_assert (vf.has_mac);
+	g_assert_cmpint (vf.mac[5], ==, 0x56);
+	g_assert_cmpint (vf.vlan, ==, 100);
+	g_assert_cmpint (vf.qos, ==, 3);
+	g_assert_cmpint (vf.spoof_check, ==, -1);
+	g_assert_cmpint (vf.trust, ==, TRUE);
+
+	g_assert (_nm_setting_sriov_parse_vf (vfs_in[1], &vf, NULL));
+	g_assert_cmpint (vf.index, ==, 3);
+	g_assert (!vf.has_mac);
+	g_assert_cmpint (vf.vlan, ==, -1);
+	g_assert_cmpint (vf.spoof_check, ==, FALSE);
+
+	g_assert (!_nm_setting_sriov_parse_vf ("mac=52:54:00:12:34:56", &vf, NULL));
+	g_assert (!_nm_setting_sriov_parse_vf ("1 vlan=4096", &vf, NULL));
+	g_assert (!_nm_setting_sriov_parse_vf ("1 rate=100", &vf, NULL));
+
+	con = nmtst_create_minimal_connection ("sriov", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	s_sriov = (NMSettingSriov *) nm_setting_sriov_new ();
+	g_object_set (s_sriov,
+	              NM_SETTING_SRIOV_TOTAL_VFS, (guint) 3,
+	              NM_SETTING_SRIOV_VFS, vfs_in,
+	              NULL);
+	nm_connection_add_setting (con, NM_SETTING (s_sriov));
+
+	/* VF 3 doesn't exist */
+	g_assert (!nm_setting_verify (NM_SETTING (s_sriov), con, NULL));
+
+	g_object_set (s_sriov, NM_SETTING_SRIOV_TOTAL_VFS, (guint) 8, NULL);
+	nmtst_connection_normalize (con);
+
+	keyfile = _nm_keyfile_write (con, NULL, NULL);
+	con2 = _nm_keyfile_read (keyfile, "/test_sriov", NULL, NULL, NULL, FALSE);
+	s_sriov = nm_connection_get_setting_sriov (con2);
+	g_assert (s_sriov);
+	g_assert_cmpint (nm_setting_sriov_get_total_vfs (s_sriov), ==, 8);
+	vfs = nm_setting_sriov_get_vfs (s_sriov);
+	g_assert (vfs);
+	g_assert_cmpstr (vfs[0], ==, vfs_in[0]);
+	g_assert_cmpstr (vfs[1], ==, vfs_in[1]);
+	g_assert (!vfs[2]);
+}
+
+/******************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -528,6 +811,11 @@ int main (int argc, char **argv)
 
 	g_test_add_func ("/core/keyfile/test_8021x_cert", test_8021x_cert);
 	g_test_add_func ("/core/keyfile/test_8021x_cert_read", test_8021x_cert_read);
+	g_test_add_func ("/core/keyfile/test_read_data", test_read_data);
+	g_test_add_func ("/core/keyfile/test_route_options", test_route_options);
+	g_test_add_func ("/core/keyfile/test_ethtool", test_ethtool);
+	g_test_add_func ("/core/keyfile/test_tc_config", test_tc_config);
+	g_test_add_func ("/core/keyfile/test_sriov", test_sriov);
 
 	return g_test_run ();
 }
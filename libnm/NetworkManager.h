@@ -57,6 +57,7 @@
 #include <nm-setting-cdma.h>
 #include <nm-setting-connection.h>
 #include <nm-setting-dcb.h>
+#include <nm-setting-ethtool.h>
 #include <nm-setting-generic.h>
 #include <nm-setting-gsm.h>
 #include <nm-setting-infiniband.h>
@@ -69,6 +70,8 @@
 #include <nm-setting-ppp.h>
 #include <nm-setting-pppoe.h>
 #include <nm-setting-serial.h>
+#include <nm-setting-sriov.h>
+#include <nm-setting-tc-config.h>
 #include <nm-setting-team-port.h>
 #include <nm-setting-team.h>
 #include <nm-setting-tun.h>
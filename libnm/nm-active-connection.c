@@ -253,6 +253,7 @@ nm_active_connection_get_ip4_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_IP4_CONFIG);
 	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->ip4_config;
 }
 
@@ -272,6 +273,7 @@ nm_active_connection_get_dhcp4_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_DHCP4_CONFIG);
 	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->dhcp4_config;
 }
 
@@ -306,6 +308,7 @@ nm_active_connection_get_ip6_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_IP6_CONFIG);
 	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->ip6_config;
 }
 
@@ -325,6 +328,7 @@ nm_active_connection_get_dhcp6_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_DHCP6_CONFIG);
 	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->dhcp6_config;
 }
 
@@ -489,11 +493,11 @@ init_dbus (NMObject *object)
 		{ NM_ACTIVE_CONNECTION_DEVICES,              &priv->devices, NULL, NM_TYPE_DEVICE },
 		{ NM_ACTIVE_CONNECTION_STATE,                &priv->state },
 		{ NM_ACTIVE_CONNECTION_DEFAULT,              &priv->is_default },
-		{ NM_ACTIVE_CONNECTION_IP4_CONFIG,           &priv->ip4_config, NULL, NM_TYPE_IP4_CONFIG },
-		{ NM_ACTIVE_CONNECTION_DHCP4_CONFIG,         &priv->dhcp4_config, NULL, NM_TYPE_DHCP4_CONFIG },
+		{ NM_ACTIVE_CONNECTION_IP4_CONFIG,           &priv->ip4_config, NULL, NM_TYPE_IP4_CONFIG, NULL, TRUE },
+		{ NM_ACTIVE_CONNECTION_DHCP4_CONFIG,         &priv->dhcp4_config, NULL, NM_TYPE_DHCP4_CONFIG, NULL, TRUE },
 		{ NM_ACTIVE_CONNECTION_DEFAULT6,             &priv->is_default6 },
-		{ NM_ACTIVE_CONNECTION_IP6_CONFIG,           &priv->ip6_config, NULL, NM_TYPE_IP6_CONFIG },
-		{ NM_ACTIVE_CONNECTION_DHCP6_CONFIG,         &priv->dhcp6_config, NULL, NM_TYPE_DHCP6_CONFIG },
+		{ NM_ACTIVE_CONNECTION_IP6_CONFIG,           &priv->ip6_config, NULL, NM_TYPE_IP6_CONFIG, NULL, TRUE },
+		{ NM_ACTIVE_CONNECTION_DHCP6_CONFIG,         &priv->dhcp6_config, NULL, NM_TYPE_DHCP6_CONFIG, NULL, TRUE },
 		{ NM_ACTIVE_CONNECTION_VPN,                  &priv->is_vpn },
 		{ NM_ACTIVE_CONNECTION_MASTER,               &priv->master, NULL, NM_TYPE_DEVICE },
 
@@ -35,6 +35,7 @@
 #include "nm-vpn-connection.h"
 #include "nm-remote-connection.h"
 #include "nm-object-cache.h"
+#include "nm-object-private.h"
 #include "nm-dbus-helpers.h"
 
 void _nm_device_wifi_set_wireless_enabled (NMDeviceWifi *device, gboolean enabled);
@@ -52,6 +53,8 @@ G_DEFINE_TYPE_WITH_CODE (NMClient, nm_client, G_TYPE_OBJECT,
 typedef struct {
 	NMManager *manager;
 	NMRemoteSettings *settings;
+	NMClientFlags flags;
+	gboolean batch_done_registered;
 } NMClientPrivate;
 
 enum {
@@ -77,6 +80,7 @@ enum {
 	PROP_HOSTNAME,
 	PROP_CAN_MODIFY,
 	PROP_METERED,
+	PROP_FLAGS,
 
 	LAST_PROP
 };
@@ -89,6 +93,7 @@ enum {
 	PERMISSION_CHANGED,
 	CONNECTION_ADDED,
 	CONNECTION_REMOVED,
+	BATCH_DONE,
 
 	LAST_SIGNAL
 };
@@ -1751,6 +1756,12 @@ settings_connection_removed (NMRemoteSettings *manager,
 	g_signal_emit (client, signals[CONNECTION_REMOVED], 0, connection);
 }
 
+static void
+notify_batch_done (gpointer user_data)
+{
+	g_signal_emit (user_data, signals[BATCH_DONE], 0);
+}
+
 static void
 constructed (GObject *object)
 {
@@ -1759,6 +1770,7 @@ constructed (GObject *object)
 
 	priv->manager = g_object_new (NM_TYPE_MANAGER,
 	                              NM_OBJECT_PATH, NM_DBUS_PATH,
+	                              NM_OBJECT_LAZY, NM_FLAGS_HAS (priv->flags, NM_CLIENT_FLAGS_LAZY),
 	                              NULL);
 	g_signal_connect (priv->manager, "notify",
 	                  G_CALLBACK (subobject_notify), client);
@@ -1775,6 +1787,7 @@ constructed (GObject *object)
 
 	priv->settings = g_object_new (NM_TYPE_REMOTE_SETTINGS,
 	                               NM_OBJECT_PATH, NM_DBUS_PATH_SETTINGS,
+	                               NM_OBJECT_LAZY, NM_FLAGS_HAS (priv->flags, NM_CLIENT_FLAGS_LAZY),
 	                               NULL);
 	g_signal_connect (priv->settings, "notify",
 	                  G_CALLBACK (subobject_notify), client);
@@ -1783,6 +1796,9 @@ constructed (GObject *object)
 	g_signal_connect (priv->settings, "connection-removed",
 	                  G_CALLBACK (settings_connection_removed), client);
 
+	_nm_object_notify_batch_done_add (notify_batch_done, client);
+	priv->batch_done_registered = TRUE;
+
 	G_OBJECT_CLASS (nm_client_parent_class)->constructed (object);
 }
 
@@ -1791,19 +1807,34 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 {
 	NMClient *client = NM_CLIENT (initable);
 	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (client);
+	GDBusConnection *connection;
+	gboolean success = FALSE;
 
-	if (!g_initable_init (G_INITABLE (priv->manager), cancellable, error))
+	connection = _nm_dbus_new_connection (cancellable, error);
+	if (!connection)
 		return FALSE;
+
+	/* Load the properties of all objects with a single call instead of
+	 * asking each object for its own. */
+	_nm_object_prefetch_begin (connection, cancellable);
+
+	if (!g_initable_init (G_INITABLE (priv->manager), cancellable, error))
+		goto out;
 	if (!g_initable_init (G_INITABLE (priv->settings), cancellable, error))
-		return FALSE;
+		goto out;
 
-	return TRUE;
+	success = TRUE;
+out:
+	_nm_object_prefetch_end (connection);
+	g_object_unref (connection);
+	return success;
 }
 
 typedef struct {
 	NMClient *client;
 	GCancellable *cancellable;
 	GSimpleAsyncResult *result;
+	GDBusConnection *connection;
 	gboolean manager_inited;
 	gboolean settings_inited;
 } NMClientInitData;
@@ -1811,6 +1842,10 @@ typedef struct {
 static void
 init_async_complete (NMClientInitData *init_data)
 {
+	if (init_data->connection) {
+		_nm_object_prefetch_end (init_data->connection);
+		g_object_unref (init_data->connection);
+	}
 	g_simple_async_result_complete (init_data->result);
 	g_object_unref (init_data->result);
 	g_clear_object (&init_data->cancellable);
@@ -1845,12 +1880,44 @@ init_async_inited_settings (GObject *object, GAsyncResult *result, gpointer user
 		init_async_complete (init_data);
 }
 
+static void
+init_async_prefetched (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (init_data->client);
+
+	_nm_object_prefetch_begin_finish (result);
+
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_manager, init_data);
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_settings, init_data);
+}
+
+static void
+init_async_got_bus (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+	GError *error = NULL;
+
+	init_data->connection = _nm_dbus_new_connection_finish (result, &error);
+	if (!init_data->connection) {
+		g_simple_async_result_take_error (init_data->result, error);
+		init_async_complete (init_data);
+		return;
+	}
+
+	_nm_object_prefetch_begin_async (init_data->connection, init_data->cancellable,
+	                                 init_async_prefetched, init_data);
+}
+
 static void
 init_async (GAsyncInitable *initable, int io_priority,
             GCancellable *cancellable, GAsyncReadyCallback callback,
             gpointer user_data)
 {
-	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (initable);
 	NMClientInitData *init_data;
 
 	init_data = g_slice_new0 (NMClientInitData);
@@ -1860,12 +1927,7 @@ init_async (GAsyncInitable *initable, int io_priority,
 	                                               user_data, init_async);
 	g_simple_async_result_set_op_res_gboolean (init_data->result, TRUE);
 
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_manager, init_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_settings, init_data);
+	_nm_dbus_new_connection_async (init_data->cancellable, init_async_got_bus, init_data);
 }
 
 static gboolean
@@ -1884,6 +1946,11 @@ dispose (GObject *object)
 {
 	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (object);
 
+	if (priv->batch_done_registered) {
+		_nm_object_notify_batch_done_remove (notify_batch_done, object);
+		priv->batch_done_registered = FALSE;
+	}
+
 	if (priv->manager) {
 		g_signal_handlers_disconnect_by_data (priv->manager, object);
 		g_clear_object (&priv->manager);
@@ -1908,6 +1975,10 @@ set_property (GObject *object, guint prop_id,
 		g_object_set_property (G_OBJECT (NM_CLIENT_GET_PRIVATE (object)->manager),
 		                       pspec->name, value);
 		break;
+	case PROP_FLAGS:
+		/* construct-only */
+		NM_CLIENT_GET_PRIVATE (object)->flags = g_value_get_flags (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1946,6 +2017,9 @@ get_property (GObject *object, guint prop_id,
 		g_object_get_property (G_OBJECT (NM_CLIENT_GET_PRIVATE (object)->settings),
 		                       pspec->name, value);
 		break;
+	case PROP_FLAGS:
+		g_value_set_flags (value, NM_CLIENT_GET_PRIVATE (object)->flags);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -2238,6 +2312,24 @@ nm_client_class_init (NMClientClass *client_class)
 		                    G_PARAM_READABLE |
 		                    G_PARAM_STATIC_STRINGS));
 
+	/**
+	 * NMClient:flags:
+	 *
+	 * #NMClientFlags controlling how the client loads objects. Pass it to
+	 * g_initable_new() or g_async_initable_new_async() when creating the
+	 * client.
+	 *
+	 * Since: 1.4
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_FLAGS,
+		 g_param_spec_flags (NM_CLIENT_FLAGS, "", "",
+		                     NM_TYPE_CLIENT_FLAGS,
+		                     NM_CLIENT_FLAGS_NONE,
+		                     G_PARAM_READWRITE |
+		                     G_PARAM_CONSTRUCT_ONLY |
+		                     G_PARAM_STATIC_STRINGS));
+
 	/* signals */
 
 	/**
@@ -2353,6 +2445,24 @@ nm_client_class_init (NMClientClass *client_class)
 		              NULL, NULL, NULL,
 		              G_TYPE_NONE, 1,
 		              NM_TYPE_REMOTE_CONNECTION);
+
+	/**
+	 * NMClient::batch-done:
+	 * @client: the client that received the signal
+	 *
+	 * Emitted after a batch of changes reported by NetworkManager has been
+	 * delivered: all property notifications and added/removed signals that
+	 * were pending on any object were emitted. Clients that update their
+	 * user interface on each notification can instead do it once here.
+	 *
+	 * Since: 1.4
+	 **/
+	signals[BATCH_DONE] =
+		g_signal_new (NM_CLIENT_BATCH_DONE,
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_FIRST,
+		              0, NULL, NULL, NULL,
+		              G_TYPE_NONE, 0);
 }
 
 static void
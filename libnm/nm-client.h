@@ -58,6 +58,7 @@ G_BEGIN_DECLS
 #define NM_CLIENT_HOSTNAME "hostname"
 #define NM_CLIENT_CAN_MODIFY "can-modify"
 #define NM_CLIENT_METERED "metered"
+#define NM_CLIENT_FLAGS "flags"
 
 #define NM_CLIENT_DEVICE_ADDED "device-added"
 #define NM_CLIENT_DEVICE_REMOVED "device-removed"
@@ -66,6 +67,27 @@ G_BEGIN_DECLS
 #define NM_CLIENT_PERMISSION_CHANGED "permission-changed"
 #define NM_CLIENT_CONNECTION_ADDED "connection-added"
 #define NM_CLIENT_CONNECTION_REMOVED "connection-removed"
+#define NM_CLIENT_BATCH_DONE "batch-done"
+
+/**
+ * NMClientFlags:
+ * @NM_CLIENT_FLAGS_NONE: no flags
+ * @NM_CLIENT_FLAGS_LAZY: only create access points, IP configurations and
+ *  DHCP configurations when they are first requested. A client that is only
+ *  interested in global state then never loads them. The first call to a
+ *  getter of such a property does not block: it starts loading the objects
+ *  and returns %NULL or an empty array; the property is notified once the
+ *  objects are ready. Signals announcing added and removed access points
+ *  are emitted only once the access points of the device were requested.
+ *
+ * Flags to pass as #NMClient:flags when creating an #NMClient.
+ *
+ * Since: 1.4
+ **/
+typedef enum { /*< flags >*/
+	NM_CLIENT_FLAGS_NONE = 0,
+	NM_CLIENT_FLAGS_LAZY = 0x1,
+} NMClientFlags;
 
 /**
  * NMClientPermission:
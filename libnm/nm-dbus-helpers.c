@@ -23,6 +23,7 @@
 #include "nm-dbus-helpers.h"
 
 #include <string.h>
+#include <unistd.h>
 
 #include "nm-dbus-interface.h"
 
@@ -43,12 +44,103 @@ _nm_dbus_bus_type (void)
 	return nm_bus;
 }
 
+/* The private socket of NetworkManager for root clients, see PRIV_SOCK_PATH
+ * in src/nm-manager.c. */
+#define PRIVATE_SOCKET_PATH NMRUNDIR "/private"
+
+/* Root clients talk to NetworkManager directly over its private socket
+ * instead of going through the bus daemon, if NM_CLIENT_PRIVATE_SOCKET
+ * is set. A value starting with '/' is the path of the socket.
+ *
+ * Returns: the address to connect to, or %NULL to use the bus */
+static const char *
+_nm_dbus_private_address (void)
+{
+	static gsize init_value = 0;
+	static char *address = NULL;
+
+	if (g_once_init_enter (&init_value)) {
+		const char *env = g_getenv ("NM_CLIENT_PRIVATE_SOCKET");
+
+		if (   env
+		    && env[0]
+		    && geteuid () == 0
+		    && _nm_dbus_bus_type () == G_BUS_TYPE_SYSTEM)
+			address = g_strdup_printf ("unix:path=%s", env[0] == '/' ? env : PRIVATE_SOCKET_PATH);
+
+		g_once_init_leave (&init_value, 1);
+	}
+
+	return address;
+}
+
+/* Unlike for the bus, GIO doesn't share peer connections. All objects
+ * of libnm must see the same connection, thus we do it ourselves. */
+G_LOCK_DEFINE_STATIC (private_connection);
+static GDBusConnection *private_connection;
+
+static GDBusConnection *
+_private_connection_ref (void)
+{
+	GDBusConnection *connection = NULL;
+
+	G_LOCK (private_connection);
+	if (private_connection) {
+		if (g_dbus_connection_is_closed (private_connection))
+			g_clear_object (&private_connection);
+		else
+			connection = g_object_ref (private_connection);
+	}
+	G_UNLOCK (private_connection);
+
+	return connection;
+}
+
+static GDBusConnection *
+_private_connection_set (GDBusConnection *connection)
+{
+	G_LOCK (private_connection);
+	if (private_connection && !g_dbus_connection_is_closed (private_connection)) {
+		/* somebody else was faster. */
+		g_object_unref (connection);
+		connection = g_object_ref (private_connection);
+	} else {
+		g_clear_object (&private_connection);
+		private_connection = g_object_ref (connection);
+	}
+	G_UNLOCK (private_connection);
+
+	return connection;
+}
+
 GDBusConnection *
 _nm_dbus_new_connection (GCancellable *cancellable, GError **error)
 {
+	const char *address;
+	GDBusConnection *connection;
+
+	address = _nm_dbus_private_address ();
+	if (address) {
+		connection = _private_connection_ref ();
+		if (connection)
+			return connection;
+
+		/* if NetworkManager isn't listening, fall back to the bus */
+		connection = g_dbus_connection_new_for_address_sync (address,
+		                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+		                                                     NULL, cancellable, NULL);
+		if (connection)
+			return _private_connection_set (connection);
+	}
+
 	return g_bus_get_sync (_nm_dbus_bus_type (), cancellable, error);
 }
 
+typedef struct {
+	GSimpleAsyncResult *simple;
+	GCancellable *cancellable;
+} NewConnectionData;
+
 static void
 new_connection_async_got_system (GObject *source, GAsyncResult *result, gpointer user_data)
 {
@@ -66,15 +158,63 @@ new_connection_async_got_system (GObject *source, GAsyncResult *result, gpointer
 	g_object_unref (simple);
 }
 
+static void
+new_connection_async_got_private (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	NewConnectionData *data = user_data;
+	GDBusConnection *connection;
+
+	connection = g_dbus_connection_new_for_address_finish (result, NULL);
+	if (connection) {
+		g_simple_async_result_set_op_res_gpointer (data->simple,
+		                                           _private_connection_set (connection),
+		                                           g_object_unref);
+		g_simple_async_result_complete (data->simple);
+		g_object_unref (data->simple);
+	} else {
+		/* if NetworkManager isn't listening, fall back to the bus */
+		g_bus_get (_nm_dbus_bus_type (),
+		           data->cancellable,
+		           new_connection_async_got_system, data->simple);
+	}
+
+	g_clear_object (&data->cancellable);
+	g_slice_free (NewConnectionData, data);
+}
+
 void
 _nm_dbus_new_connection_async (GCancellable *cancellable,
                                GAsyncReadyCallback callback,
                                gpointer user_data)
 {
 	GSimpleAsyncResult *simple;
+	const char *address;
 
 	simple = g_simple_async_result_new (NULL, callback, user_data, _nm_dbus_new_connection_async);
 
+	address = _nm_dbus_private_address ();
+	if (address) {
+		GDBusConnection *connection;
+		NewConnectionData *data;
+
+		connection = _private_connection_ref ();
+		if (connection) {
+			g_simple_async_result_set_op_res_gpointer (simple, connection, g_object_unref);
+			g_simple_async_result_complete_in_idle (simple);
+			g_object_unref (simple);
+			return;
+		}
+
+		data = g_slice_new (NewConnectionData);
+		data->simple = simple;
+		data->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+		g_dbus_connection_new_for_address (address,
+		                                   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+		                                   NULL, cancellable,
+		                                   new_connection_async_got_private, data);
+		return;
+	}
+
 	g_bus_get (_nm_dbus_bus_type (),
 	           cancellable,
 	           new_connection_async_got_system, simple);
@@ -213,6 +213,7 @@ nm_device_wifi_get_active_access_point (NMDeviceWifi *device)
 		break;
 	}
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_WIFI_ACTIVE_ACCESS_POINT);
 	return NM_DEVICE_WIFI_GET_PRIVATE (device)->active_ap;
 }
 
@@ -231,6 +232,7 @@ nm_device_wifi_get_access_points (NMDeviceWifi *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE_WIFI (device), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_WIFI_ACCESS_POINTS);
 	return NM_DEVICE_WIFI_GET_PRIVATE (device)->aps;
 }
 
@@ -744,9 +746,9 @@ init_dbus (NMObject *object)
 		{ NM_DEVICE_WIFI_PERMANENT_HW_ADDRESS, &priv->perm_hw_address },
 		{ NM_DEVICE_WIFI_MODE,                 &priv->mode },
 		{ NM_DEVICE_WIFI_BITRATE,              &priv->rate },
-		{ NM_DEVICE_WIFI_ACTIVE_ACCESS_POINT,  &priv->active_ap, NULL, NM_TYPE_ACCESS_POINT },
+		{ NM_DEVICE_WIFI_ACTIVE_ACCESS_POINT,  &priv->active_ap, NULL, NM_TYPE_ACCESS_POINT, NULL, TRUE },
 		{ NM_DEVICE_WIFI_CAPABILITIES,         &priv->wireless_caps },
-		{ NM_DEVICE_WIFI_ACCESS_POINTS,        &priv->aps, NULL, NM_TYPE_ACCESS_POINT, "access-point" },
+		{ NM_DEVICE_WIFI_ACCESS_POINTS,        &priv->aps, NULL, NM_TYPE_ACCESS_POINT, "access-point", TRUE },
 		{ NULL },
 	};
 
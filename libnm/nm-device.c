@@ -236,10 +236,10 @@ init_dbus (NMObject *object)
 		{ NM_DEVICE_AUTOCONNECT,       &priv->autoconnect },
 		{ NM_DEVICE_FIRMWARE_MISSING,  &priv->firmware_missing },
 		{ NM_DEVICE_NM_PLUGIN_MISSING, &priv->nm_plugin_missing },
-		{ NM_DEVICE_IP4_CONFIG,        &priv->ip4_config, NULL, NM_TYPE_IP4_CONFIG },
-		{ NM_DEVICE_DHCP4_CONFIG,      &priv->dhcp4_config, NULL, NM_TYPE_DHCP4_CONFIG },
-		{ NM_DEVICE_IP6_CONFIG,        &priv->ip6_config, NULL, NM_TYPE_IP6_CONFIG },
-		{ NM_DEVICE_DHCP6_CONFIG,      &priv->dhcp6_config, NULL, NM_TYPE_DHCP6_CONFIG },
+		{ NM_DEVICE_IP4_CONFIG,        &priv->ip4_config, NULL, NM_TYPE_IP4_CONFIG, NULL, TRUE },
+		{ NM_DEVICE_DHCP4_CONFIG,      &priv->dhcp4_config, NULL, NM_TYPE_DHCP4_CONFIG, NULL, TRUE },
+		{ NM_DEVICE_IP6_CONFIG,        &priv->ip6_config, NULL, NM_TYPE_IP6_CONFIG, NULL, TRUE },
+		{ NM_DEVICE_DHCP6_CONFIG,      &priv->dhcp6_config, NULL, NM_TYPE_DHCP6_CONFIG, NULL, TRUE },
 		{ NM_DEVICE_STATE,             &priv->state },
 		{ NM_DEVICE_STATE_REASON,      &priv->reason, demarshal_state_reason },
 		{ NM_DEVICE_ACTIVE_CONNECTION, &priv->active_connection, NULL, NM_TYPE_ACTIVE_CONNECTION },
@@ -1305,6 +1305,7 @@ nm_device_get_ip4_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_IP4_CONFIG);
 	return NM_DEVICE_GET_PRIVATE (device)->ip4_config;
 }
 
@@ -1325,6 +1326,7 @@ nm_device_get_dhcp4_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_DHCP4_CONFIG);
 	return NM_DEVICE_GET_PRIVATE (device)->dhcp4_config;
 }
 
@@ -1344,6 +1346,7 @@ nm_device_get_ip6_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_IP6_CONFIG);
 	return NM_DEVICE_GET_PRIVATE (device)->ip6_config;
 }
 
@@ -1364,6 +1367,7 @@ nm_device_get_dhcp6_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
+	_nm_object_ensure_lazy_property (NM_OBJECT (device), NM_DEVICE_DHCP6_CONFIG);
 	return NM_DEVICE_GET_PRIVATE (device)->dhcp6_config;
 }
 
@@ -40,6 +40,9 @@ typedef struct {
 	char *gateway;
 	GPtrArray *addresses;
 	GPtrArray *routes;
+	/* the routes are only parsed on demand, see nm_ip_config_get_routes() */
+	GVariant *routes_variant;
+	gboolean routes_variant_new_style;
 	char **nameservers;
 	char **domains;
 	char **searches;
@@ -136,11 +139,10 @@ demarshal_ip_routes (NMObject *object, GParamSpec *pspec, GVariant *value, gpoin
 	if (priv->new_style_data)
 		return TRUE;
 
-	g_ptr_array_unref (priv->routes);
-	if (NM_IS_IP4_CONFIG (object))
-		priv->routes = nm_utils_ip4_routes_from_variant (value);
-	else
-		priv->routes = nm_utils_ip6_routes_from_variant (value);
+	g_variant_ref (value);
+	nm_clear_g_variant (&priv->routes_variant);
+	priv->routes_variant = value;
+	priv->routes_variant_new_style = FALSE;
 	_nm_object_queue_notify (object, NM_IP_CONFIG_ROUTES);
 
 	return TRUE;
@@ -153,11 +155,10 @@ demarshal_ip_route_data (NMObject *object, GParamSpec *pspec, GVariant *value, g
 
 	priv->new_style_data = TRUE;
 
-	g_ptr_array_unref (priv->routes);
-	if (NM_IS_IP4_CONFIG (object))
-		priv->routes = nm_utils_ip_routes_from_variant (value, AF_INET);
-	else
-		priv->routes = nm_utils_ip_routes_from_variant (value, AF_INET6);
+	g_variant_ref (value);
+	nm_clear_g_variant (&priv->routes_variant);
+	priv->routes_variant = value;
+	priv->routes_variant_new_style = TRUE;
 	_nm_object_queue_notify (object, NM_IP_CONFIG_ROUTES);
 
 	return TRUE;
@@ -198,6 +199,7 @@ finalize (GObject *object)
 
 	g_ptr_array_unref (priv->addresses);
 	g_ptr_array_unref (priv->routes);
+	nm_clear_g_variant (&priv->routes_variant);
 
 	g_strfreev (priv->nameservers);
 	g_strfreev (priv->domains);
@@ -499,7 +501,28 @@ nm_ip_config_get_wins_servers (NMIPConfig *config)
 GPtrArray *
 nm_ip_config_get_routes (NMIPConfig *config)
 {
+	NMIPConfigPrivate *priv;
+	int family;
+
 	g_return_val_if_fail (NM_IS_IP_CONFIG (config), NULL);
 
-	return NM_IP_CONFIG_GET_PRIVATE (config)->routes;
+	priv = NM_IP_CONFIG_GET_PRIVATE (config);
+
+	/* Large route tables are common but few clients look at them, so the
+	 * #NMIPRoute objects are only created on the first access after a
+	 * change. */
+	if (priv->routes_variant) {
+		family = NM_IS_IP4_CONFIG (config) ? AF_INET : AF_INET6;
+
+		g_ptr_array_unref (priv->routes);
+		if (priv->routes_variant_new_style)
+			priv->routes = nm_utils_ip_routes_from_variant (priv->routes_variant, family);
+		else if (family == AF_INET)
+			priv->routes = nm_utils_ip4_routes_from_variant (priv->routes_variant);
+		else
+			priv->routes = nm_utils_ip6_routes_from_variant (priv->routes_variant);
+		nm_clear_g_variant (&priv->routes_variant);
+	}
+
+	return priv->routes;
 }
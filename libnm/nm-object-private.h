@@ -34,6 +34,9 @@ typedef struct {
 	PropertyMarshalFunc func;
 	GType object_type;
 	const char *signal_prefix;
+	/* only create the object(s) when the getter is called, if the object
+	 * is #NM_OBJECT_LAZY. The getter must call _nm_object_ensure_lazy_property(). */
+	gboolean lazy;
 } NMPropertiesInfo;
 
 void _nm_object_register_properties (NMObject *object,
@@ -50,6 +53,11 @@ gboolean _nm_object_reload_properties_finish (NMObject *object,
 
 void _nm_object_queue_notify (NMObject *object, const char *property);
 
+typedef void (*NMObjectNotifyBatchDoneFunc) (gpointer user_data);
+
+void _nm_object_notify_batch_done_add    (NMObjectNotifyBatchDoneFunc func, gpointer user_data);
+void _nm_object_notify_batch_done_remove (NMObjectNotifyBatchDoneFunc func, gpointer user_data);
+
 void _nm_object_suppress_property_updates (NMObject *object, gboolean suppress);
 
 /* DBus property accessors */
@@ -72,9 +80,22 @@ void _nm_object_register_type_func (GType base_type,
                                     const char *interface,
                                     const char *property);
 
+/* bulk loading of the initial object properties */
+void _nm_object_prefetch_begin        (GDBusConnection *connection,
+                                       GCancellable *cancellable);
+void _nm_object_prefetch_begin_async  (GDBusConnection *connection,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data);
+void _nm_object_prefetch_begin_finish (GAsyncResult *result);
+void _nm_object_prefetch_end          (GDBusConnection *connection);
+
 #define NM_OBJECT_NM_RUNNING "nm-running-internal"
 gboolean _nm_object_get_nm_running (NMObject *self);
 
+#define NM_OBJECT_LAZY "lazy-internal"
+void _nm_object_ensure_lazy_property (NMObject *object, const char *property);
+
 void _nm_object_class_add_interface (NMObjectClass *object_class,
                                      const char    *interface);
 GDBusProxy *_nm_object_get_proxy (NMObject   *object,
@@ -69,6 +69,10 @@ typedef struct {
 	GType object_type;
 	gpointer field;
 	const char *signal_prefix;
+
+	/* the object path(s) of a lazy property not created yet */
+	gboolean lazy;
+	GVariant *lazy_value;
 } PropertyInfo;
 
 static void reload_complete (NMObject *object, gboolean emit_now);
@@ -77,6 +81,7 @@ static gboolean demarshal_generic (NMObject *object, GParamSpec *pspec, GVariant
 typedef struct {
 	GDBusConnection *connection;
 	gboolean nm_running;
+	gboolean lazy;
 
 	char *path;
 	GHashTable *proxies;
@@ -90,7 +95,7 @@ typedef struct {
 	                         * to defer their notifications by adding themselves here. */
 
 	GSList *notify_items;
-	guint32 notify_id;
+	GList *notify_link;     /* our entry in notify_queue */
 
 	GSList *reload_results;
 	guint reload_remaining;
@@ -102,6 +107,7 @@ enum {
 	PROP_PATH,
 	PROP_DBUS_CONNECTION,
 	PROP_NM_RUNNING,
+	PROP_LAZY,
 
 	LAST_PROP
 };
@@ -191,19 +197,27 @@ notify_item_free (NotifyItem *item)
 	g_slice_free (NotifyItem, item);
 }
 
+/* Pending notifications of all objects are emitted together from a single
+ * idle handler, in the order the objects queued them. */
+static GQueue notify_queue = G_QUEUE_INIT;
+static guint notify_queue_id;
+
+typedef struct {
+	NMObjectNotifyBatchDoneFunc func;
+	gpointer user_data;
+} NotifyBatchDoneData;
+
+static GSList *notify_batch_done_funcs;
+
 static gboolean
-deferred_notify_cb (gpointer data)
+emit_notifications (NMObject *object)
 {
-	NMObject *object = NM_OBJECT (data);
 	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
 	NMObjectClass *object_class = NM_OBJECT_GET_CLASS (object);
 	GSList *props, *iter;
 
-	priv->notify_id = 0;
-
-	/* Wait until all reloads are done before notifying */
-	if (priv->reload_remaining)
-		return G_SOURCE_REMOVE;
+	if (!priv->notify_items)
+		return FALSE;
 
 	/* Clear priv->notify_items early so that an NMObject subclass that
 	 * listens to property changes can queue up other property changes
@@ -255,16 +269,104 @@ deferred_notify_cb (gpointer data)
 	g_object_unref (object);
 
 	g_slist_free_full (props, (GDestroyNotify) notify_item_free);
+	return TRUE;
+}
+
+static void
+notify_queue_unlink (NMObject *object)
+{
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
+
+	if (priv->notify_link) {
+		g_queue_delete_link (&notify_queue, priv->notify_link);
+		priv->notify_link = NULL;
+	}
+}
+
+static gboolean
+notify_queue_dispatch (gpointer user_data)
+{
+	gboolean emitted = FALSE;
+	guint n;
+	GSList *iter, *next;
+
+	notify_queue_id = 0;
+
+	/* Objects queued while emitting go into the next batch. */
+	for (n = g_queue_get_length (&notify_queue); n > 0 && !g_queue_is_empty (&notify_queue); n--) {
+		NMObject *object = g_queue_pop_head (&notify_queue);
+		NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
+
+		priv->notify_link = NULL;
+
+		/* Wait until all reloads are done before notifying; reload_complete()
+		 * queues the object again. */
+		if (priv->reload_remaining)
+			continue;
+
+		if (emit_notifications (object))
+			emitted = TRUE;
+	}
+
+	if (emitted) {
+		for (iter = notify_batch_done_funcs; iter; iter = next) {
+			NotifyBatchDoneData *data = iter->data;
+
+			next = iter->next;
+			data->func (data->user_data);
+		}
+	}
+
 	return G_SOURCE_REMOVE;
 }
 
+/**
+ * _nm_object_notify_batch_done_add:
+ * @func: function to call
+ * @user_data: data for @func
+ *
+ * Registers @func to be called each time after the pending notifications
+ * and added/removed signals of all objects were emitted.
+ */
+void
+_nm_object_notify_batch_done_add (NMObjectNotifyBatchDoneFunc func, gpointer user_data)
+{
+	NotifyBatchDoneData *data;
+
+	data = g_slice_new (NotifyBatchDoneData);
+	data->func = func;
+	data->user_data = user_data;
+	notify_batch_done_funcs = g_slist_append (notify_batch_done_funcs, data);
+}
+
+void
+_nm_object_notify_batch_done_remove (NMObjectNotifyBatchDoneFunc func, gpointer user_data)
+{
+	GSList *iter;
+
+	for (iter = notify_batch_done_funcs; iter; iter = iter->next) {
+		NotifyBatchDoneData *data = iter->data;
+
+		if (data->func == func && data->user_data == user_data) {
+			notify_batch_done_funcs = g_slist_delete_link (notify_batch_done_funcs, iter);
+			g_slice_free (NotifyBatchDoneData, data);
+			return;
+		}
+	}
+	g_return_if_reached ();
+}
+
 static void
 _nm_object_defer_notify (NMObject *object)
 {
 	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
 
-	if (!priv->notify_id)
-		priv->notify_id = g_idle_add_full (G_PRIORITY_LOW, deferred_notify_cb, object, NULL);
+	if (!priv->notify_link) {
+		g_queue_push_tail (&notify_queue, object);
+		priv->notify_link = notify_queue.tail;
+	}
+	if (!notify_queue_id)
+		notify_queue_id = g_idle_add_full (G_PRIORITY_LOW, notify_queue_dispatch, NULL, NULL);
 }
 
 static void
@@ -371,17 +473,360 @@ _nm_object_register_type_func (GType base_type,
 	                     type_data);
 }
 
+/**************************************************************/
+
+#define PREFETCH_OBJECT_MANAGER_PATH  "/org/freedesktop"
+#define PREFETCH_IFACE_OBJECT_MANAGER "org.freedesktop.DBus.ObjectManager"
+
+/* While a client is initializing, the properties of all objects are fetched
+ * with one GetManagedObjects call and kept up to date from the signals of
+ * NetworkManager, so that creating objects does not need a GetAll (or a Get
+ * to decide their type) per object.
+ *
+ * Maps object path -> interface name -> property name -> GVariant. */
+static struct {
+	guint refcount;
+	GDBusConnection *connection;
+	GHashTable *objects;
+	guint signal_id;
+} prefetch;
+
+static GHashTable *
+_prefetch_get_interface (const char *path, const char *interface, gboolean create)
+{
+	GHashTable *interfaces, *props;
+
+	interfaces = g_hash_table_lookup (prefetch.objects, path);
+	if (!interfaces) {
+		if (!create)
+			return NULL;
+		interfaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                                    (GDestroyNotify) g_hash_table_unref);
+		g_hash_table_insert (prefetch.objects, g_strdup (path), interfaces);
+	}
+
+	props = g_hash_table_lookup (interfaces, interface);
+	if (!props && create) {
+		props = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                               (GDestroyNotify) g_variant_unref);
+		g_hash_table_insert (interfaces, g_strdup (interface), props);
+	}
+	return props;
+}
+
+static void
+_prefetch_merge (const char *path, const char *interface, GVariant *properties, gboolean create)
+{
+	GHashTable *props;
+	GVariantIter iter;
+	const char *name;
+	GVariant *value;
+
+	props = _prefetch_get_interface (path, interface, create);
+	if (!props)
+		return;
+
+	g_variant_iter_init (&iter, properties);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value))
+		g_hash_table_insert (props, g_strdup (name), value);
+}
+
+static void
+_prefetch_add_interfaces (const char *path, GVariant *interfaces)
+{
+	GVariantIter iter;
+	const char *interface;
+	GVariant *properties;
+
+	g_variant_iter_init (&iter, interfaces);
+	while (g_variant_iter_next (&iter, "{&s@a{sv}}", &interface, &properties)) {
+		_prefetch_merge (path, interface, properties, TRUE);
+		g_variant_unref (properties);
+	}
+}
+
+static void
+_prefetch_signal_cb (GDBusConnection *connection,
+                     const char *sender_name,
+                     const char *object_path,
+                     const char *interface_name,
+                     const char *signal_name,
+                     GVariant *parameters,
+                     gpointer user_data)
+{
+	const char *path, *interface;
+	GVariant *variant;
+
+	if (!prefetch.objects)
+		return;
+
+	if (!strcmp (interface_name, PREFETCH_IFACE_OBJECT_MANAGER)) {
+		if (   !strcmp (signal_name, "InterfacesAdded")
+		    && g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oa{sa{sv}})"))) {
+			g_variant_get (parameters, "(&o@a{sa{sv}})", &path, &variant);
+			_prefetch_add_interfaces (path, variant);
+			g_variant_unref (variant);
+		} else if (   !strcmp (signal_name, "InterfacesRemoved")
+		           && g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oas)"))) {
+			GHashTable *interfaces;
+			GVariantIter *iter;
+
+			g_variant_get (parameters, "(&oas)", &path, &iter);
+			interfaces = g_hash_table_lookup (prefetch.objects, path);
+			while (g_variant_iter_next (iter, "&s", &interface)) {
+				if (interfaces)
+					g_hash_table_remove (interfaces, interface);
+			}
+			g_variant_iter_free (iter);
+			if (interfaces && !g_hash_table_size (interfaces))
+				g_hash_table_remove (prefetch.objects, path);
+		}
+		return;
+	}
+
+	if (strcmp (signal_name, "PropertiesChanged"))
+		return;
+
+	/* Only properties of already known interfaces are updated; anything else
+	 * is fetched with GetAll once the object is created. */
+	if (!strcmp (interface_name, DBUS_INTERFACE_PROPERTIES)) {
+		if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)"))) {
+			g_variant_get (parameters, "(&s@a{sv}as)", &interface, &variant, NULL);
+			_prefetch_merge (object_path, interface, variant, FALSE);
+			g_variant_unref (variant);
+		}
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})"))) {
+		/* NetworkManager's own per-interface PropertiesChanged signal */
+		g_variant_get (parameters, "(@a{sv})", &variant);
+		_prefetch_merge (object_path, interface_name, variant, FALSE);
+		g_variant_unref (variant);
+	}
+}
+
+static gboolean
+_prefetch_start (GDBusConnection *connection)
+{
+	if (prefetch.refcount++ > 0)
+		return FALSE;
+
+	prefetch.connection = g_object_ref (connection);
+	prefetch.objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                          (GDestroyNotify) g_hash_table_unref);
+
+	/* Subscribe before asking for the objects, so that no change between the
+	 * reply and the creation of the objects is lost. A single match rule
+	 * covers all signals of NetworkManager. */
+	prefetch.signal_id = g_dbus_connection_signal_subscribe (connection,
+	                                                         NM_DBUS_SERVICE,
+	                                                         NULL, NULL, NULL, NULL,
+	                                                         G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                         _prefetch_signal_cb,
+	                                                         NULL, NULL);
+	return TRUE;
+}
+
+static void
+_prefetch_got_objects (GVariant *ret, GError *error)
+{
+	GVariantIter *iter;
+	const char *path;
+	GVariant *interfaces;
+
+	if (!ret) {
+		/* Not fatal, the objects are just loaded one by one. */
+		dbgmsg ("Could not fetch managed objects: %s", error->message);
+		return;
+	}
+
+	if (!prefetch.objects)
+		return;
+
+	g_variant_get (ret, "(a{oa{sa{sv}}})", &iter);
+	while (g_variant_iter_next (iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+		_prefetch_add_interfaces (path, interfaces);
+		g_variant_unref (interfaces);
+	}
+	g_variant_iter_free (iter);
+}
+
+/**
+ * _nm_object_prefetch_begin:
+ * @connection: the #GDBusConnection the objects will be created on
+ * @cancellable: a #GCancellable, or %NULL
+ *
+ * Fetches the properties of all objects of NetworkManager at once. Objects
+ * created on @connection until the matching _nm_object_prefetch_end() take
+ * their initial properties from there instead of asking for them. Failing
+ * to fetch them is not an error.
+ */
+void
+_nm_object_prefetch_begin (GDBusConnection *connection, GCancellable *cancellable)
+{
+	GVariant *ret;
+	GError *error = NULL;
+
+	if (_nm_dbus_is_connection_private (connection))
+		return;
+	if (!_prefetch_start (connection))
+		return;
+
+	ret = g_dbus_connection_call_sync (connection,
+	                                   NM_DBUS_SERVICE,
+	                                   PREFETCH_OBJECT_MANAGER_PATH,
+	                                   PREFETCH_IFACE_OBJECT_MANAGER,
+	                                   "GetManagedObjects",
+	                                   NULL,
+	                                   G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                                   G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+	                                   cancellable, &error);
+	_prefetch_got_objects (ret, error);
+	if (ret)
+		g_variant_unref (ret);
+	g_clear_error (&error);
+}
+
+static void
+prefetch_got_objects_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GSimpleAsyncResult *simple = user_data;
+	GVariant *ret;
+	GError *error = NULL;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	_prefetch_got_objects (ret, error);
+	if (ret)
+		g_variant_unref (ret);
+	g_clear_error (&error);
+
+	g_simple_async_result_complete (simple);
+	g_object_unref (simple);
+}
+
+void
+_nm_object_prefetch_begin_async (GDBusConnection *connection,
+                                 GCancellable *cancellable,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data)
+{
+	GSimpleAsyncResult *simple;
+
+	simple = g_simple_async_result_new (NULL, callback, user_data, _nm_object_prefetch_begin_async);
+
+	if (   _nm_dbus_is_connection_private (connection)
+	    || !_prefetch_start (connection)) {
+		g_simple_async_result_complete_in_idle (simple);
+		g_object_unref (simple);
+		return;
+	}
+
+	g_dbus_connection_call (connection,
+	                        NM_DBUS_SERVICE,
+	                        PREFETCH_OBJECT_MANAGER_PATH,
+	                        PREFETCH_IFACE_OBJECT_MANAGER,
+	                        "GetManagedObjects",
+	                        NULL,
+	                        G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                        G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+	                        cancellable,
+	                        prefetch_got_objects_cb, simple);
+}
+
+void
+_nm_object_prefetch_begin_finish (GAsyncResult *result)
+{
+	g_return_if_fail (g_simple_async_result_is_valid (result, NULL, _nm_object_prefetch_begin_async));
+}
+
+/**
+ * _nm_object_prefetch_end:
+ * @connection: the #GDBusConnection passed to _nm_object_prefetch_begin()
+ *
+ * Drops the properties fetched by _nm_object_prefetch_begin() once the
+ * last initialization using them is done.
+ */
+void
+_nm_object_prefetch_end (GDBusConnection *connection)
+{
+	if (_nm_dbus_is_connection_private (connection))
+		return;
+
+	g_return_if_fail (prefetch.refcount > 0);
+
+	if (--prefetch.refcount > 0)
+		return;
+
+	g_dbus_connection_signal_unsubscribe (prefetch.connection, prefetch.signal_id);
+	prefetch.signal_id = 0;
+	g_clear_pointer (&prefetch.objects, g_hash_table_unref);
+	g_clear_object (&prefetch.connection);
+}
+
+static GVariant *
+_prefetch_peek (GDBusConnection *connection, const char *path,
+                const char *interface, const char *property)
+{
+	GHashTable *props;
+
+	if (!prefetch.objects || prefetch.connection != connection)
+		return NULL;
+
+	props = _prefetch_get_interface (path, interface, FALSE);
+	return props ? g_hash_table_lookup (props, property) : NULL;
+}
+
+/* Returns the prefetched properties of @interface as a{sv} and forgets them;
+ * they are only good for the initial load of the object, afterwards the
+ * object tracks changes itself. */
+static GVariant *
+_prefetch_take (GDBusConnection *connection, const char *path, const char *interface)
+{
+	GHashTable *interfaces, *props;
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	const char *name;
+	GVariant *value;
+
+	if (!prefetch.objects || prefetch.connection != connection)
+		return NULL;
+
+	interfaces = g_hash_table_lookup (prefetch.objects, path);
+	if (!interfaces)
+		return NULL;
+	props = g_hash_table_lookup (interfaces, interface);
+	if (!props)
+		return NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_hash_table_iter_init (&iter, props);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value))
+		g_variant_builder_add (&builder, "{sv}", name, value);
+
+	g_hash_table_remove (interfaces, interface);
+	if (!g_hash_table_size (interfaces))
+		g_hash_table_remove (prefetch.objects, path);
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+/**************************************************************/
+
 static GObject *
-_nm_object_create (GType type, GDBusConnection *connection, const char *path)
+_nm_object_create (GType type, GDBusConnection *connection, const char *path, gboolean lazy)
 {
 	NMObjectTypeFuncData *type_data;
+	GVariant *value = NULL;
 	GObject *object;
 	GError *error = NULL;
 
 	type_data = g_hash_table_lookup (type_funcs, GSIZE_TO_POINTER (type));
-	if (type_data) {
+	if (type_data)
+		value = _prefetch_peek (connection, path, type_data->interface, type_data->property);
+
+	if (value)
+		type = type_data->type_func (value);
+	else if (type_data) {
 		GDBusProxy *proxy;
-		GVariant *ret, *value;
+		GVariant *ret;
 
 		proxy = _nm_dbus_new_proxy_for_connection (connection, path,
 		                                           DBUS_INTERFACE_PROPERTIES,
@@ -421,6 +866,7 @@ _nm_object_create (GType type, GDBusConnection *connection, const char *path)
 	object = g_object_new (type,
 	                       NM_OBJECT_PATH, path,
 	                       NM_OBJECT_DBUS_CONNECTION, connection,
+	                       NM_OBJECT_LAZY, lazy,
 	                       NULL);
 	/* Cache the object before initializing it (and in particular, loading its
 	 * property values); this is necessary to make circular references work (eg,
@@ -473,6 +919,7 @@ typedef struct {
 	gpointer user_data;
 	NMObjectTypeFuncData *type_data;
 	GDBusConnection *connection;
+	gboolean lazy;
 } NMObjectTypeAsyncData;
 
 static void
@@ -541,6 +988,7 @@ create_async_got_type (NMObjectTypeAsyncData *async_data, GType type)
 	object = g_object_new (type,
 	                       NM_OBJECT_PATH, async_data->path,
 	                       NM_OBJECT_DBUS_CONNECTION, async_data->connection,
+	                       NM_OBJECT_LAZY, async_data->lazy,
 	                       NULL);
 	_nm_object_cache_add (NM_OBJECT (object));
 	g_async_initable_init_async (G_ASYNC_INITABLE (object), G_PRIORITY_DEFAULT,
@@ -600,7 +1048,7 @@ create_async_got_proxy (GObject *object, GAsyncResult *result, gpointer user_dat
 }
 
 static void
-_nm_object_create_async (GType type, GDBusConnection *connection, const char *path,
+_nm_object_create_async (GType type, GDBusConnection *connection, const char *path, gboolean lazy,
                          NMObjectCreateCallbackFunc callback, gpointer user_data)
 {
 	NMObjectTypeAsyncData *async_data;
@@ -610,9 +1058,20 @@ _nm_object_create_async (GType type, GDBusConnection *connection, const char *pa
 	async_data->callback = callback;
 	async_data->user_data = user_data;
 	async_data->connection = g_object_ref (connection);
+	async_data->lazy = lazy;
 
 	async_data->type_data = g_hash_table_lookup (type_funcs, GSIZE_TO_POINTER (type));
 	if (async_data->type_data) {
+		GVariant *value;
+
+		value = _prefetch_peek (connection, path,
+		                        async_data->type_data->interface,
+		                        async_data->type_data->property);
+		if (value) {
+			create_async_got_type (async_data, async_data->type_data->type_func (value));
+			return;
+		}
+
 		_nm_dbus_new_proxy_for_connection_async (connection, path,
 		                                         DBUS_INTERFACE_PROPERTIES,
 		                                         NULL,
@@ -866,11 +1325,11 @@ handle_object_property (NMObject *self, const char *property_name, GVariant *val
 		object_created (obj, path, odata);
 		return TRUE;
 	} else if (synchronously) {
-		obj = _nm_object_create (pi->object_type, priv->connection, path);
+		obj = _nm_object_create (pi->object_type, priv->connection, path, priv->lazy);
 		object_created (obj, path, odata);
 		return obj != NULL;
 	} else {
-		_nm_object_create_async (pi->object_type, priv->connection, path,
+		_nm_object_create_async (pi->object_type, priv->connection, path, priv->lazy,
 		                         object_created, odata);
 		/* Assume success */
 		return TRUE;
@@ -922,10 +1381,10 @@ handle_object_array_property (NMObject *self, const char *property_name, GVarian
 		if (obj) {
 			object_created (obj, path, odata);
 		} else if (synchronously) {
-			obj = _nm_object_create (pi->object_type, priv->connection, path);
+			obj = _nm_object_create (pi->object_type, priv->connection, path, priv->lazy);
 			object_created (obj, path, odata);
 		} else {
-			_nm_object_create_async (pi->object_type, priv->connection, path,
+			_nm_object_create_async (pi->object_type, priv->connection, path, priv->lazy,
 			                         object_created, odata);
 		}
 	}
@@ -938,6 +1397,86 @@ handle_object_array_property (NMObject *self, const char *property_name, GVarian
 	return *array && ((*array)->len == npaths);
 }
 
+/* Remembers the path(s) of a lazy object-valued property instead of creating
+ * the objects; _nm_object_ensure_lazy_property() creates them on access.
+ * Returns %FALSE if the property should be handled right away. */
+static gboolean
+defer_object_property (NMObject *self, const char *property_name, GVariant *value,
+                       PropertyInfo *pi)
+{
+	g_clear_pointer (&pi->lazy_value, g_variant_unref);
+
+	if (g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH)) {
+		const char *path = g_variant_get_string (value, NULL);
+		GObject **obj_p = pi->field;
+		NMObject *obj;
+
+		/* Nothing to save if there is no object or it already exists */
+		if (!strcmp (path, "/"))
+			return FALSE;
+		obj = _nm_object_cache_get (path);
+		if (obj) {
+			g_object_unref (obj);
+			return FALSE;
+		}
+
+		/* Drop the previous object, so that it is freed if nobody else
+		 * uses it. */
+		g_clear_object (obj_p);
+	} else if (!g_variant_is_of_type (value, G_VARIANT_TYPE ("ao")))
+		return FALSE;
+
+	pi->lazy_value = g_variant_ref (value);
+	_nm_object_queue_notify (self, property_name);
+	return TRUE;
+}
+
+/**
+ * _nm_object_ensure_lazy_property:
+ * @object: an #NMObject
+ * @property: the name of an object-valued property of @object
+ *
+ * Starts creating the objects of @property if their creation was deferred
+ * because @object was created with #NM_OBJECT_LAZY. Getters of lazy properties
+ * call this before returning the value. Objects that are not cached yet are
+ * created asynchronously, so that the getter never blocks on D-Bus; the getter
+ * returns what is already known and @property is notified once the objects
+ * are ready. Once created, arrays of objects are kept up to date like other
+ * properties, so that their added and removed signals work; single objects
+ * are dropped again when the property changes.
+ */
+void
+_nm_object_ensure_lazy_property (NMObject *object, const char *property)
+{
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
+	PropertyInfo *pi = NULL;
+	GParamSpec *pspec;
+	GVariant *value;
+	GSList *iter;
+
+	if (!priv->lazy)
+		return;
+
+	for (iter = priv->property_tables; iter && !pi; iter = iter->next)
+		pi = g_hash_table_lookup ((GHashTable *) iter->data, property);
+	if (!pi || !pi->lazy_value)
+		return;
+
+	pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), property);
+	g_return_if_fail (pspec);
+
+	value = pi->lazy_value;
+	pi->lazy_value = NULL;
+
+	if (g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH))
+		handle_object_property (object, pspec->name, value, pi, FALSE);
+	else {
+		pi->lazy = FALSE;
+		handle_object_array_property (object, pspec->name, value, pi, FALSE);
+	}
+	g_variant_unref (value);
+}
+
 static void
 handle_property_changed (NMObject *self, const char *dbus_name,
                          GVariant *value, gboolean synchronously)
@@ -993,7 +1532,9 @@ handle_property_changed (NMObject *self, const char *dbus_name,
 	}
 
 	if (pspec && pi->object_type) {
-		if (g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH))
+		if (priv->lazy && pi->lazy && defer_object_property (self, pspec->name, value, pi))
+			success = TRUE;
+		else if (g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH))
 			success = handle_object_property (self, pspec->name, value, pi, synchronously);
 		else if (g_variant_is_of_type (value, G_VARIANT_TYPE ("ao")))
 			success = handle_object_array_property (self, pspec->name, value, pi, synchronously);
@@ -1195,6 +1736,14 @@ done:
 	return success;
 }
 
+static void
+property_info_free (PropertyInfo *pi)
+{
+	if (pi->lazy_value)
+		g_variant_unref (pi->lazy_value);
+	g_free (pi);
+}
+
 void
 _nm_object_register_properties (NMObject *object,
                                 const char *interface,
@@ -1224,7 +1773,7 @@ _nm_object_register_properties (NMObject *object,
 	_nm_dbus_signal_connect (proxy, "PropertiesChanged", G_VARIANT_TYPE ("(a{sv})"),
 	                         G_CALLBACK (properties_changed), object);
 
-	instance = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	instance = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) property_info_free);
 	priv->property_tables = g_slist_prepend (priv->property_tables, instance);
 
 	for (tmp = (NMPropertiesInfo *) info; tmp->name; tmp++) {
@@ -1240,6 +1789,7 @@ _nm_object_register_properties (NMObject *object,
 		pi->object_type = tmp->object_type;
 		pi->field = tmp->field;
 		pi->signal_prefix = tmp->signal_prefix;
+		pi->lazy = tmp->lazy;
 		g_hash_table_insert (instance, g_strdup (tmp->name), pi);
 	}
 }
@@ -1260,6 +1810,13 @@ _nm_object_reload_properties (NMObject *object, GError **error)
 
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
+		props = _prefetch_take (priv->connection, priv->path, interface);
+		if (props) {
+			process_properties_changed (object, props, TRUE);
+			g_variant_unref (props);
+			continue;
+		}
+
 		ret = _nm_dbus_proxy_call_sync (priv->properties_proxy,
 		                                "GetAll",
 		                                g_variant_new ("(s)", interface),
@@ -1372,8 +1929,8 @@ reload_complete (NMObject *object, gboolean emit_now)
 	GError *error;
 
 	if (emit_now) {
-		nm_clear_g_source (&priv->notify_id);
-		deferred_notify_cb (object);
+		notify_queue_unlink (object);
+		emit_notifications (object);
 	} else
 		_nm_object_defer_notify (object);
 
@@ -1457,8 +2014,21 @@ _nm_object_reload_properties_async (NMObject *object,
 	if (priv->reload_results->next)
 		return;
 
+	/* Hold off completion while processing prefetched properties, which
+	 * may finish synchronously. */
+	priv->reload_remaining++;
+
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
+		GVariant *props;
+
+		props = _prefetch_take (priv->connection, priv->path, interface);
+		if (props) {
+			process_properties_changed (object, props, FALSE);
+			g_variant_unref (props);
+			continue;
+		}
+
 		priv->reload_remaining++;
 		g_dbus_proxy_call (priv->properties_proxy,
 		                   "GetAll",
@@ -1467,6 +2037,9 @@ _nm_object_reload_properties_async (NMObject *object,
 		                   cancellable,
 		                   reload_got_properties, object);
 	}
+
+	if (--priv->reload_remaining == 0)
+		reload_complete (object, FALSE);
 }
 
 gboolean
@@ -1749,6 +2322,10 @@ set_property (GObject *object, guint prop_id,
 		/* Construct only */
 		priv->connection = g_value_dup_object (value);
 		break;
+	case PROP_LAZY:
+		/* Construct only */
+		priv->lazy = g_value_get_boolean (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1771,6 +2348,9 @@ get_property (GObject *object, guint prop_id,
 	case PROP_NM_RUNNING:
 		g_value_set_boolean (value, priv->nm_running);
 		break;
+	case PROP_LAZY:
+		g_value_set_boolean (value, priv->lazy);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1782,7 +2362,7 @@ dispose (GObject *object)
 {
 	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
 
-	nm_clear_g_source (&priv->notify_id);
+	notify_queue_unlink (NM_OBJECT (object));
 
 	g_slist_free_full (priv->notify_items, (GDestroyNotify) notify_item_free);
 	priv->notify_items = NULL;
@@ -1861,5 +2441,18 @@ nm_object_class_init (NMObjectClass *nm_object_class)
 		                       FALSE,
 		                       G_PARAM_READABLE |
 		                       G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * NMObject:lazy: (skip)
+	 *
+	 * Internal use only.
+	 */
+	g_object_class_install_property
+		(object_class, PROP_LAZY,
+		 g_param_spec_boolean (NM_OBJECT_LAZY, "", "",
+		                       FALSE,
+		                       G_PARAM_READWRITE |
+		                       G_PARAM_CONSTRUCT_ONLY |
+		                       G_PARAM_STATIC_STRINGS));
 }
 
@@ -52,8 +52,13 @@ typedef struct {
 	NMDBusAgentManager *manager_proxy;
 	NMDBusSecretAgent *dbus_secret_agent;
 
-	/* GetSecretsInfo structs of in-flight GetSecrets requests */
-	GSList *pending_gets;
+	/* GetSecretsInfo structs of in-flight GetSecrets requests, that
+	 * weren't canceled. The set is indexed by the request itself, so
+	 * a repeated GetSecrets joins the pending one. */
+	GHashTable *pending_gets;
+
+	/* the unique name of NetworkManager once its UID was checked */
+	char *verified_sender;
 
 	char *identifier;
 	gboolean auto_register;
@@ -88,20 +93,45 @@ _internal_unregister (NMSecretAgentOld *self)
 typedef struct {
 	char *path;
 	char *setting_name;
-	GDBusMethodInvocation *context;
+	char **hints;
+	NMSecretAgentGetSecretsFlags flags;
+	/* the GetSecrets calls waiting for the result. The subclass is asked
+	 * only once for any number of identical calls. */
+	GSList *contexts;
+	/* canceled requests are no longer in pending_gets; they are freed
+	 * when the subclass calls back. */
+	gboolean canceled;
 } GetSecretsInfo;
 
-static void
-get_secrets_info_finalize (NMSecretAgentOld *self, GetSecretsInfo *info)
+static guint
+get_secrets_info_hash (gconstpointer v)
 {
-	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
+	const GetSecretsInfo *info = v;
 
-	g_return_if_fail (info != NULL);
+	return g_str_hash (info->path) ^ g_str_hash (info->setting_name) ^ info->flags;
+}
 
-	priv->pending_gets = g_slist_remove (priv->pending_gets, info);
+static gboolean
+get_secrets_info_equal (gconstpointer a, gconstpointer b)
+{
+	const GetSecretsInfo *info_a = a;
+	const GetSecretsInfo *info_b = b;
+
+	return    info_a->flags == info_b->flags
+	       && strcmp (info_a->path, info_b->path) == 0
+	       && strcmp (info_a->setting_name, info_b->setting_name) == 0
+	       && _nm_utils_strv_equal (info_a->hints, info_b->hints);
+}
+
+static void
+get_secrets_info_free (GetSecretsInfo *info)
+{
+	g_return_if_fail (info != NULL);
 
 	g_free (info->path);
 	g_free (info->setting_name);
+	g_strfreev (info->hints);
+	g_slist_free (info->contexts);
 	memset (info, 0, sizeof (*info));
 	g_free (info);
 }
@@ -124,25 +154,37 @@ name_owner_changed (GObject *proxy,
 {
 	NMSecretAgentOld *self = NM_SECRET_AGENT_OLD (user_data);
 	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
-	GSList *iter;
 	char *owner;
 
+	g_clear_pointer (&priv->verified_sender, g_free);
+
 	owner = g_dbus_proxy_get_name_owner (G_DBUS_PROXY (proxy));
 	if (owner != NULL) {
 		if (should_auto_register (self))
 			nm_secret_agent_old_register_async (self, NULL, NULL, NULL);
 		g_free (owner);
 	} else {
-		/* Cancel any pending secrets requests */
-		for (iter = priv->pending_gets; iter; iter = g_slist_next (iter)) {
-			GetSecretsInfo *info = iter->data;
-
+		GHashTableIter iter;
+		GetSecretsInfo *info;
+		GPtrArray *canceled;
+		guint i;
+
+		/* Cancel any pending secrets requests. The subclass may call back
+		 * right away, so take them out of the set first. */
+		canceled = g_ptr_array_new_with_free_func (g_free);
+		g_hash_table_iter_init (&iter, priv->pending_gets);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &info, NULL)) {
+			info->canceled = TRUE;
+			g_ptr_array_add (canceled, g_strdup (info->path));
+			g_ptr_array_add (canceled, g_strdup (info->setting_name));
+			g_hash_table_iter_remove (&iter);
+		}
+		for (i = 0; i < canceled->len; i += 2) {
 			NM_SECRET_AGENT_OLD_GET_CLASS (self)->cancel_get_secrets (self,
-			                                                      info->path,
-			                                                      info->setting_name);
+			                                                      canceled->pdata[i],
+			                                                      canceled->pdata[i + 1]);
 		}
-		g_slist_free (priv->pending_gets);
-		priv->pending_gets = NULL;
+		g_ptr_array_unref (canceled);
 
 		_internal_unregister (self);
 	}
@@ -206,6 +248,12 @@ verify_sender (NMSecretAgentOld *self,
 	if (priv->session_bus)
 		return TRUE;
 
+	/* A unique name always belongs to the same process, so its UID is only
+	 * asked for once instead of in a blocking call for every request.
+	 */
+	if (g_strcmp0 (sender, priv->verified_sender) == 0)
+		return TRUE;
+
 	/* Check the UID of the sender */
 	ret = g_dbus_connection_call_sync (priv->bus,
 	                                   DBUS_SERVICE_DBUS,
@@ -242,6 +290,8 @@ verify_sender (NMSecretAgentOld *self,
 		return FALSE;
 	}
 
+	g_free (priv->verified_sender);
+	priv->verified_sender = g_strdup (sender);
 	return TRUE;
 }
 
@@ -289,6 +339,13 @@ verify_request (NMSecretAgentOld *self,
 	return !!connection;
 }
 
+static void
+return_get_secrets (GDBusMethodInvocation *context, GVariant *secrets)
+{
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(@a{sa{sv}})", secrets));
+}
+
 static void
 get_secrets_cb (NMSecretAgentOld *self,
                 NMConnection *connection,
@@ -296,18 +353,24 @@ get_secrets_cb (NMSecretAgentOld *self,
                 GError *error,
                 gpointer user_data)
 {
+	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
 	GetSecretsInfo *info = user_data;
+	GSList *iter;
 
-	if (error)
-		g_dbus_method_invocation_return_gerror (info->context, error);
-	else {
+	/* Remove the request from internal tracking */
+	if (!info->canceled)
+		g_hash_table_remove (priv->pending_gets, info);
+
+	if (!error)
 		g_variant_take_ref (secrets);
-		g_dbus_method_invocation_return_value (info->context,
-		                                       g_variant_new ("(@a{sa{sv}})", secrets));
+	for (iter = info->contexts; iter; iter = iter->next) {
+		if (error)
+			g_dbus_method_invocation_return_gerror (iter->data, error);
+		else
+			return_get_secrets (iter->data, secrets);
 	}
 
-	/* Remove the request from internal tracking */
-	get_secrets_info_finalize (self, info);
+	get_secrets_info_free (info);
 }
 
 static void
@@ -321,9 +384,10 @@ impl_secret_agent_old_get_secrets (NMSecretAgentOld *self,
                                    gpointer user_data)
 {
 	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
+	NMSecretAgentOldClass *klass = NM_SECRET_AGENT_OLD_GET_CLASS (self);
 	GError *error = NULL;
 	NMConnection *connection = NULL;
-	GetSecretsInfo *info;
+	GetSecretsInfo *info, lookup;
 
 	/* Make sure the request comes from NetworkManager and is valid */
 	if (!verify_request (self, context, connection_dict, connection_path, &connection, &error)) {
@@ -331,31 +395,67 @@ impl_secret_agent_old_get_secrets (NMSecretAgentOld *self,
 		return;
 	}
 
+	/* Let the subclass answer from what it already knows, unless new
+	 * secrets are asked for.
+	 */
+	if (   klass->get_cached_secrets
+	    && !NM_FLAGS_HAS (flags, NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW)) {
+		GVariant *secrets;
+
+		secrets = klass->get_cached_secrets (self,
+		                                     connection,
+		                                     connection_path,
+		                                     setting_name,
+		                                     (const char **) hints,
+		                                     flags);
+		if (secrets) {
+			g_variant_take_ref (secrets);
+			return_get_secrets (context, secrets);
+			g_variant_unref (secrets);
+			g_object_unref (connection);
+			return;
+		}
+	}
+
+	/* The same request is in flight already: wait for its result */
+	lookup.path = (char *) connection_path;
+	lookup.setting_name = (char *) setting_name;
+	lookup.hints = (char **) hints;
+	lookup.flags = flags;
+	info = g_hash_table_lookup (priv->pending_gets, &lookup);
+	if (info) {
+		info->contexts = g_slist_append (info->contexts, context);
+		g_object_unref (connection);
+		return;
+	}
+
 	info = g_malloc0 (sizeof (GetSecretsInfo));
 	info->path = g_strdup (connection_path);
 	info->setting_name = g_strdup (setting_name);
-	info->context = context;
-	priv->pending_gets = g_slist_append (priv->pending_gets, info);
-
-	NM_SECRET_AGENT_OLD_GET_CLASS (self)->get_secrets (self,
-	                                               connection,
-	                                               connection_path,
-	                                               setting_name,
-	                                               (const char **) hints,
-	                                               flags,
-	                                               get_secrets_cb,
-	                                               info);
+	info->hints = g_strdupv ((char **) hints);
+	info->flags = flags;
+	info->contexts = g_slist_append (NULL, context);
+	g_hash_table_add (priv->pending_gets, info);
+
+	klass->get_secrets (self,
+	                    connection,
+	                    connection_path,
+	                    setting_name,
+	                    (const char **) hints,
+	                    flags,
+	                    get_secrets_cb,
+	                    info);
 	g_object_unref (connection);
 }
 
 static GetSecretsInfo *
-find_get_secrets_info (GSList *list, const char *path, const char *setting_name)
+find_get_secrets_info (GHashTable *pending_gets, const char *path, const char *setting_name)
 {
-	GSList *iter;
-
-	for (iter = list; iter; iter = g_slist_next (iter)) {
-		GetSecretsInfo *candidate = iter->data;
+	GHashTableIter iter;
+	GetSecretsInfo *candidate;
 
+	g_hash_table_iter_init (&iter, pending_gets);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &candidate, NULL)) {
 		if (   g_strcmp0 (path, candidate->path) == 0
 		    && g_strcmp0 (setting_name, candidate->setting_name) == 0)
 			return candidate;
@@ -373,6 +473,8 @@ impl_secret_agent_old_cancel_get_secrets (NMSecretAgentOld *self,
 	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
 	GError *error = NULL;
 	GetSecretsInfo *info;
+	gs_free char *path = NULL;
+	gs_free char *name = NULL;
 
 	/* Make sure the request comes from NetworkManager and is valid */
 	if (!verify_request (self, context, NULL, NULL, NULL, &error)) {
@@ -389,10 +491,27 @@ impl_secret_agent_old_cancel_get_secrets (NMSecretAgentOld *self,
 		return;
 	}
 
-	/* Send the cancel request up to the subclass and finalize it */
-	NM_SECRET_AGENT_OLD_GET_CLASS (self)->cancel_get_secrets (self,
-	                                                      info->path,
-	                                                      info->setting_name);
+	if (info->contexts->next) {
+		/* Others still wait for the request; only drop the oldest call */
+		GDBusMethodInvocation *canceled = info->contexts->data;
+
+		info->contexts = g_slist_delete_link (info->contexts, info->contexts);
+		g_dbus_method_invocation_return_error (canceled,
+		                                       NM_SECRET_AGENT_ERROR,
+		                                       NM_SECRET_AGENT_ERROR_AGENT_CANCELED,
+		                                       "Canceled by NetworkManager.");
+		g_dbus_method_invocation_return_value (context, NULL);
+		return;
+	}
+
+	/* Send the cancel request up to the subclass and finalize it. The
+	 * request may be freed by the callback.
+	 */
+	info->canceled = TRUE;
+	g_hash_table_remove (priv->pending_gets, info);
+	path = g_strdup (info->path);
+	name = g_strdup (info->setting_name);
+	NM_SECRET_AGENT_OLD_GET_CLASS (self)->cancel_get_secrets (self, path, name);
 	g_dbus_method_invocation_return_value (context, NULL);
 }
 
@@ -1017,6 +1136,7 @@ nm_secret_agent_old_init (NMSecretAgentOld *self)
 {
 	NMSecretAgentOldPrivate *priv = NM_SECRET_AGENT_OLD_GET_PRIVATE (self);
 
+	priv->pending_gets = g_hash_table_new (get_secrets_info_hash, get_secrets_info_equal);
 	priv->dbus_secret_agent = nmdbus_secret_agent_skeleton_new ();
 	_nm_dbus_bind_properties (self, priv->dbus_secret_agent);
 	_nm_dbus_bind_methods (self, priv->dbus_secret_agent,
@@ -1242,8 +1362,18 @@ dispose (GObject *object)
 
 	g_clear_pointer (&priv->identifier, g_free);
 
-	while (priv->pending_gets)
-		get_secrets_info_finalize (self, priv->pending_gets->data);
+	if (priv->pending_gets) {
+		GHashTableIter iter;
+		GetSecretsInfo *info;
+
+		g_hash_table_iter_init (&iter, priv->pending_gets);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &info, NULL)) {
+			g_hash_table_iter_remove (&iter);
+			get_secrets_info_free (info);
+		}
+		g_clear_pointer (&priv->pending_gets, g_hash_table_unref);
+	}
+	g_clear_pointer (&priv->verified_sender, g_free);
 
 	g_signal_handlers_disconnect_matched (priv->dbus_secret_agent, G_SIGNAL_MATCH_DATA,
 	                                      0, 0, NULL, NULL, self);
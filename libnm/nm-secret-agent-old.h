@@ -143,7 +143,9 @@ typedef struct {
 	 * this method, as the arguments will freed (except for 'self', 'callback',
 	 * and 'user_data' of course).  If the request is canceled, the callback
 	 * should still be called, but with the
-	 * NM_SECRET_AGENT_OLD_ERROR_AGENT_CANCELED error.
+	 * NM_SECRET_AGENT_OLD_ERROR_AGENT_CANCELED error.  Identical requests
+	 * that arrive while one is in flight are not passed on again, they get
+	 * the result of the first one.
 	 */
 	void (*get_secrets) (NMSecretAgentOld *self,
 	                     NMConnection *connection,
@@ -188,8 +190,22 @@ typedef struct {
 	                        NMSecretAgentOldDeleteSecretsFunc callback,
 	                        gpointer user_data);
 
+	/* Optional.  Called before get_secrets(), unless the request has
+	 * NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW set.  If the subclass
+	 * can answer the request from memory, without prompting or I/O, it
+	 * returns the secrets like they would be passed to the get_secrets()
+	 * callback, as a full or floating reference.  Otherwise it returns
+	 * %NULL, and get_secrets() is called.
+	 */
+	GVariant * (*get_cached_secrets) (NMSecretAgentOld *self,
+	                                  NMConnection *connection,
+	                                  const char *connection_path,
+	                                  const char *setting_name,
+	                                  const char **hints,
+	                                  NMSecretAgentGetSecretsFlags flags);
+
 	/*< private >*/
-	gpointer padding[8];
+	gpointer padding[7];
 } NMSecretAgentOldClass;
 
 GType nm_secret_agent_old_get_type (void);
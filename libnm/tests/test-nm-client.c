@@ -1570,6 +1570,278 @@ test_connection_invalid (void)
 
 /*******************************************************************/
 
+typedef struct {
+	const char *device_path;
+	volatile gint get_managed_objects;
+	volatile gint get_all;
+	volatile gint get;
+	volatile gint other;
+} InitCallsInfo;
+
+static GDBusMessage *
+init_calls_filter (GDBusConnection *connection,
+                   GDBusMessage *message,
+                   gboolean incoming,
+                   gpointer user_data)
+{
+	InitCallsInfo *info = user_data;
+	const char *member, *path;
+
+	/* Runs in the GDBus worker thread */
+	if (incoming || g_dbus_message_get_message_type (message) != G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+		return message;
+	if (g_strcmp0 (g_dbus_message_get_destination (message), NM_DBUS_SERVICE))
+		return message;
+
+	member = g_dbus_message_get_member (message);
+	path = g_dbus_message_get_path (message);
+	if (!strcmp (member, "GetManagedObjects"))
+		g_atomic_int_inc (&info->get_managed_objects);
+	else if (   !strcmp (member, "GetAll")
+	         && (   !strcmp (path, NM_DBUS_PATH)
+	             || !strcmp (path, info->device_path)))
+		g_atomic_int_inc (&info->get_all);
+	else if (   !strcmp (member, "Get")
+	         && !strcmp (path, info->device_path))
+		g_atomic_int_inc (&info->get);
+	else
+		g_atomic_int_inc (&info->other);
+
+	return message;
+}
+
+static void
+init_calls_new_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClient **client = user_data;
+	GError *error = NULL;
+
+	*client = nm_client_new_finish (result, &error);
+	g_assert_no_error (error);
+	g_assert (*client);
+}
+
+static void
+test_client_init_calls (void)
+{
+	NMClient *client = NULL;
+	GDBusConnection *connection;
+	InitCallsInfo info = { 0 };
+	const GPtrArray *devices;
+	GVariant *ret;
+	char *device_path;
+	GError *error = NULL;
+	guint filter_id;
+	int async;
+
+	sinfo = nmtstc_service_init ();
+
+	ret = g_dbus_proxy_call_sync (sinfo->proxy,
+	                              "AddWiredDevice",
+	                              g_variant_new ("(ssas)", "eth0", "52:54:00:12:34:56", NULL),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_variant_get (ret, "(o)", &device_path);
+	g_variant_unref (ret);
+	info.device_path = device_path;
+
+	connection = g_dbus_proxy_get_connection (sinfo->proxy);
+
+	for (async = 0; async <= 1; async++) {
+		g_atomic_int_set (&info.get_managed_objects, 0);
+		g_atomic_int_set (&info.get_all, 0);
+		g_atomic_int_set (&info.get, 0);
+		g_atomic_int_set (&info.other, 0);
+
+		filter_id = g_dbus_connection_add_filter (connection, init_calls_filter, &info, NULL);
+		if (async) {
+			nm_client_new_async (NULL, init_calls_new_cb, &client);
+			while (!client)
+				g_main_context_iteration (NULL, TRUE);
+		} else {
+			client = nm_client_new (NULL, &error);
+			g_assert_no_error (error);
+		}
+		g_dbus_connection_remove_filter (connection, filter_id);
+
+		devices = nm_client_get_devices (client);
+		g_assert_cmpint (devices->len, ==, 1);
+		g_assert_cmpstr (nm_device_get_iface (devices->pdata[0]), ==, "eth0");
+
+		g_test_message ("%s init: %d GetManagedObjects, %d GetAll, %d Get, %d other calls",
+		                async ? "async" : "sync",
+		                g_atomic_int_get (&info.get_managed_objects),
+		                g_atomic_int_get (&info.get_all),
+		                g_atomic_int_get (&info.get),
+		                g_atomic_int_get (&info.other));
+
+		/* The manager and the device are loaded from GetManagedObjects alone */
+		g_assert_cmpint (g_atomic_int_get (&info.get_managed_objects), ==, 1);
+		g_assert_cmpint (g_atomic_int_get (&info.get_all), ==, 0);
+		g_assert_cmpint (g_atomic_int_get (&info.get), ==, 0);
+
+		g_clear_object (&client);
+	}
+
+	g_free (device_path);
+	g_clear_pointer (&sinfo, nmtstc_service_cleanup);
+}
+
+/*******************************************************************/
+
+static GDBusMessage *
+lazy_ap_calls_filter (GDBusConnection *connection,
+                      GDBusMessage *message,
+                      gboolean incoming,
+                      gpointer user_data)
+{
+	volatile gint *get_all = user_data;
+
+	if (   !incoming
+	    && g_dbus_message_get_message_type (message) == G_DBUS_MESSAGE_TYPE_METHOD_CALL
+	    && !g_strcmp0 (g_dbus_message_get_member (message), "GetAll")
+	    && g_str_has_prefix (g_dbus_message_get_path (message), NM_DBUS_PATH_ACCESS_POINT "/"))
+		g_atomic_int_inc (get_all);
+
+	return message;
+}
+
+static void
+lazy_aps_notify_cb (NMDeviceWifi *wifi, GParamSpec *pspec, gpointer user_data)
+{
+	if (nm_device_wifi_get_access_points (wifi)->len)
+		g_main_loop_quit (loop);
+}
+
+static void
+test_client_lazy (void)
+{
+	NMClient *client;
+	GDBusConnection *connection;
+	const GPtrArray *devices, *aps;
+	NMDeviceWifi *wifi;
+	GVariant *ret;
+	GError *error = NULL;
+	volatile gint get_all = 0;
+	guint filter_id, quit_id;
+
+	sinfo = nmtstc_service_init ();
+
+	ret = g_dbus_proxy_call_sync (sinfo->proxy,
+	                              "AddWifiDevice",
+	                              g_variant_new ("(s)", "wlan0"),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_variant_unref (ret);
+
+	ret = g_dbus_proxy_call_sync (sinfo->proxy,
+	                              "AddWifiAp",
+	                              g_variant_new ("(sss)", "wlan0", "test-ap", expected_bssid),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_variant_unref (ret);
+
+	client = g_initable_new (NM_TYPE_CLIENT, NULL, &error,
+	                         NM_CLIENT_FLAGS, NM_CLIENT_FLAGS_LAZY,
+	                         NULL);
+	g_assert_no_error (error);
+	g_assert (client);
+
+	devices = nm_client_get_devices (client);
+	g_assert_cmpint (devices->len, ==, 1);
+	g_assert (NM_IS_DEVICE_WIFI (devices->pdata[0]));
+	wifi = devices->pdata[0];
+
+	/* The access point is only loaded now, since nobody asked for it during
+	 * initialization. The getter does not wait for it. */
+	connection = g_dbus_proxy_get_connection (sinfo->proxy);
+	filter_id = g_dbus_connection_add_filter (connection, lazy_ap_calls_filter, (gpointer) &get_all, NULL);
+	g_signal_connect (wifi, "notify::" NM_DEVICE_WIFI_ACCESS_POINTS,
+	                  G_CALLBACK (lazy_aps_notify_cb), NULL);
+	aps = nm_device_wifi_get_access_points (wifi);
+	g_assert_cmpint (aps->len, ==, 0);
+
+	quit_id = g_timeout_add_seconds (5, loop_quit, loop);
+	g_main_loop_run (loop);
+	g_source_remove (quit_id);
+	g_signal_handlers_disconnect_by_func (wifi, lazy_aps_notify_cb, NULL);
+	g_dbus_connection_remove_filter (connection, filter_id);
+
+	g_assert_cmpint (g_atomic_int_get (&get_all), ==, 1);
+	aps = nm_device_wifi_get_access_points (wifi);
+	g_assert_cmpint (aps->len, ==, 1);
+	g_assert_cmpstr (nm_access_point_get_bssid (aps->pdata[0]), ==, expected_bssid);
+
+	/* Loaded objects are kept */
+	g_assert (nm_device_wifi_get_access_points (wifi) == aps);
+
+	g_object_unref (client);
+	g_clear_pointer (&sinfo, nmtstc_service_cleanup);
+}
+
+/*******************************************************************/
+
+typedef struct {
+	guint notified;
+	guint batch_done;
+	guint notified_at_batch_done;
+} BatchDoneInfo;
+
+static void
+batch_done_devices_notify_cb (NMClient *client, GParamSpec *pspec, BatchDoneInfo *info)
+{
+	info->notified++;
+}
+
+static void
+batch_done_cb (NMClient *client, BatchDoneInfo *info)
+{
+	info->batch_done++;
+	info->notified_at_batch_done = info->notified;
+}
+
+static void
+test_client_batch_done (void)
+{
+	NMClient *client;
+	BatchDoneInfo info = { 0 };
+	GError *error = NULL;
+
+	sinfo = nmtstc_service_init ();
+	client = nm_client_new (NULL, &error);
+	g_assert_no_error (error);
+
+	g_signal_connect (client, "notify::" NM_CLIENT_DEVICES,
+	                  G_CALLBACK (batch_done_devices_notify_cb), &info);
+	g_signal_connect (client, NM_CLIENT_BATCH_DONE,
+	                  G_CALLBACK (batch_done_cb), &info);
+
+	nmtstc_service_add_device (sinfo, client, "AddWiredDevice", "eth0");
+
+	/* coverity[loop_condition] */
+	while (!info.notified_at_batch_done)
+		g_main_context_iteration (NULL, TRUE);
+
+	/* The batch ends after the notification that belongs to it */
+	g_assert_cmpint (info.notified, >=, 1);
+	g_assert_cmpint (info.batch_done, >=, 1);
+
+	g_signal_handlers_disconnect_by_data (client, &info);
+	g_object_unref (client);
+	g_clear_pointer (&sinfo, nmtstc_service_cleanup);
+}
+
+/*******************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1592,6 +1864,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/libnm/activate-failed", test_activate_failed);
 	g_test_add_func ("/libnm/device-connection-compatibility", test_device_connection_compatibility);
 	g_test_add_func ("/libnm/connection/invalid", test_connection_invalid);
+	g_test_add_func ("/libnm/client-init-calls", test_client_init_calls);
+	g_test_add_func ("/libnm/client-lazy", test_client_lazy);
+	g_test_add_func ("/libnm/client-batch-done", test_client_batch_done);
 
 	return g_test_run ();
 }
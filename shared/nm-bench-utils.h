@@ -0,0 +1,84 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_BENCH_UTILS_H__
+#define __NM_BENCH_UTILS_H__
+
+/*******************************************************************************
+ * Helpers for the bench-* programs ('make bench', tools/run-benchmarks.sh).
+ *
+ * Each benchmark times a number of phases and prints one tab separated
+ * line per phase:
+ *
+ *   <phase> <operations> <total usec> <nsec per operation>
+ *
+ * so that runs can be compared by scripts.
+ *******************************************************************************/
+
+typedef struct {
+	const char *phase;
+	gint64 start;
+	guint ops;
+} NMBenchTimer;
+
+inline static void
+nm_bench_timer_start (NMBenchTimer *timer, const char *phase)
+{
+	timer->phase = phase;
+	timer->ops = 0;
+	timer->start = g_get_monotonic_time ();
+}
+
+inline static void
+nm_bench_timer_stop (NMBenchTimer *timer)
+{
+	gint64 usec = g_get_monotonic_time () - timer->start;
+
+	g_print ("%s\t%u\t%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\n",
+	         timer->phase,
+	         timer->ops,
+	         usec,
+	         timer->ops ? (usec * 1000) / timer->ops : (gint64) 0);
+}
+
+/* Parses the benchmark's command line @options; the caller checks the
+ * values afterwards. */
+inline static gboolean
+nm_bench_parse_options (int *argc, char ***argv, const char *summary, const GOptionEntry *options)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gboolean success;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, summary);
+	g_option_context_add_main_entries (context, options, NULL);
+
+	success = g_option_context_parse (context, argc, argv, &error);
+	if (!success) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_option_context_free (context);
+	return success;
+}
+
+#endif /* __NM_BENCH_UTILS_H__ */
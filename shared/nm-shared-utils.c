@@ -24,6 +24,7 @@
 #include "nm-shared-utils.h"
 
 #include <errno.h>
+#include <string.h>
 
 /*****************************************************************************/
 
@@ -237,3 +238,164 @@ nm_g_object_set_property (GObject *object,
 }
 
 /*****************************************************************************/
+
+/* Interned strings
+ *
+ * Interface names, UUIDs and D-Bus paths are held by many objects at once.
+ * An interned string exists only once and is shared by reference count.
+ * Two interned strings are equal if and only if their pointers are equal.
+ *
+ * The reference count is kept in front of the characters, so an interned
+ * string is a plain "const char *" that can be passed to any function
+ * expecting a string. It must never be freed with g_free(); release it
+ * with nm_intern_str_unref(). */
+
+typedef struct {
+	gint ref_count;
+	char str[1];
+} InternStr;
+
+#define _intern_str_from_str(s) ((InternStr *) (((char *) (s)) - G_STRUCT_OFFSET (InternStr, str)))
+
+G_LOCK_DEFINE_STATIC (intern_str);
+
+/* The set of all interned strings, the InternStr.str member
+ * being both key and value. */
+static GHashTable *intern_str_table;
+
+/**
+ * nm_intern_str_ref:
+ * @str: (allow-none): the string to intern
+ *
+ * Returns: (transfer full): the interned string equal to @str, or %NULL
+ *   if @str is %NULL. Release it with nm_intern_str_unref().
+ */
+const char *
+nm_intern_str_ref (const char *str)
+{
+	InternStr *s;
+	const char *interned;
+	gsize len;
+
+	if (!str)
+		return NULL;
+
+	G_LOCK (intern_str);
+
+	if (G_UNLIKELY (!intern_str_table))
+		intern_str_table = g_hash_table_new (g_str_hash, g_str_equal);
+
+	interned = g_hash_table_lookup (intern_str_table, str);
+	if (interned)
+		_intern_str_from_str (interned)->ref_count++;
+	else {
+		len = strlen (str);
+		s = g_malloc (G_STRUCT_OFFSET (InternStr, str) + len + 1);
+		s->ref_count = 1;
+		memcpy (s->str, str, len + 1);
+		g_hash_table_add (intern_str_table, s->str);
+		interned = s->str;
+	}
+
+	G_UNLOCK (intern_str);
+	return interned;
+}
+
+/**
+ * nm_intern_str_ref_interned:
+ * @interned: (allow-none): an interned string
+ *
+ * Like nm_intern_str_ref(), but for a string that is known to be
+ * interned already. That saves the hash lookup.
+ *
+ * Returns: @interned
+ */
+const char *
+nm_intern_str_ref_interned (const char *interned)
+{
+	if (interned) {
+		G_LOCK (intern_str);
+		nm_assert (_intern_str_from_str (interned)->ref_count > 0);
+		_intern_str_from_str (interned)->ref_count++;
+		G_UNLOCK (intern_str);
+	}
+	return interned;
+}
+
+void
+nm_intern_str_unref (const char *interned)
+{
+	InternStr *s;
+
+	if (!interned)
+		return;
+
+	s = _intern_str_from_str (interned);
+
+	G_LOCK (intern_str);
+	nm_assert (s->ref_count > 0);
+	if (--s->ref_count == 0) {
+		g_hash_table_remove (intern_str_table, s->str);
+		g_free (s);
+	}
+	G_UNLOCK (intern_str);
+}
+
+/**
+ * nm_intern_str_lookup:
+ * @str: (allow-none): a string
+ *
+ * Returns: (transfer none): the interned string equal to @str, or %NULL
+ *   if there is none. In the latter case, no object holds a string equal
+ *   to @str. Otherwise, the result can be compared by pointer.
+ */
+const char *
+nm_intern_str_lookup (const char *str)
+{
+	const char *interned = NULL;
+
+	if (!str)
+		return NULL;
+
+	G_LOCK (intern_str);
+	if (intern_str_table)
+		interned = g_hash_table_lookup (intern_str_table, str);
+	G_UNLOCK (intern_str);
+	return interned;
+}
+
+/**
+ * nm_intern_str_set:
+ * @p_interned: location of an interned string or %NULL
+ * @str: (allow-none): the new value, interned or not
+ *
+ * Replaces the interned string at @p_interned by @str.
+ *
+ * Returns: %TRUE if the value changed.
+ */
+gboolean
+nm_intern_str_set (const char **p_interned, const char *str)
+{
+	const char *old = *p_interned;
+
+	if (old == str)
+		return FALSE;
+
+	*p_interned = nm_intern_str_ref (str);
+	nm_intern_str_unref (old);
+	return *p_interned != old;
+}
+
+/* Returns: the number of distinct interned strings */
+guint
+nm_intern_str_get_count (void)
+{
+	guint n;
+
+	G_LOCK (intern_str);
+	n = intern_str_table ? g_hash_table_size (intern_str_table) : 0;
+	G_UNLOCK (intern_str);
+	return n;
+}
+
+/*****************************************************************************/
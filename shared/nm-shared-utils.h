@@ -63,4 +63,13 @@ gboolean nm_g_object_set_property (GObject *object,
 
 /******************************************************************************/
 
+const char *nm_intern_str_ref (const char *str);
+const char *nm_intern_str_ref_interned (const char *interned);
+void nm_intern_str_unref (const char *interned);
+const char *nm_intern_str_lookup (const char *str);
+gboolean nm_intern_str_set (const char **p_interned, const char *str);
+guint nm_intern_str_get_count (void);
+
+/******************************************************************************/
+
 #endif /* __NM_SHARED_UTILS_H__ */
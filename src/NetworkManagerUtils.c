@@ -645,6 +645,116 @@ check_possible_match (NMConnection *orig,
 		return NULL;
 }
 
+/*****************************************************************************/
+
+/* A few inferrable properties summarized, which let nm_utils_match_connection()
+ * reject most candidates without computing the full diff. The prefilter must
+ * only reject candidates which check_possible_match() would reject too, so
+ * it honors the same exceptions: a missing interface-name or MAC address
+ * matches anything, and the accepted IP method combinations are allowed. */
+typedef struct {
+	const char *type;
+	const char *ifname;
+	const char *mac;
+	const char *ip4_method;
+	const char *ip6_method;
+	guint ip4_addresses_hash;
+	guint ip6_addresses_hash;
+	bool has_ip4:1;
+	bool has_ip6:1;
+} MatchFingerprint;
+
+static guint
+_addresses_hash (NMSettingIPConfig *s_ip)
+{
+	guint i, num, hash;
+
+	/* order-independent, only the properties nm_ip_address_equal() compares */
+	num = nm_setting_ip_config_get_num_addresses (s_ip);
+	hash = num;
+	for (i = 0; i < num; i++) {
+		NMIPAddress *address = nm_setting_ip_config_get_address (s_ip, i);
+
+		hash += g_str_hash (nm_ip_address_get_address (address))
+		        ^ (nm_ip_address_get_prefix (address) << 24);
+	}
+	return hash;
+}
+
+static void
+_match_fingerprint_init (MatchFingerprint *fp, NMConnection *connection)
+{
+	NMSettingConnection *s_con;
+	NMSettingWired *s_wired;
+	NMSettingIPConfig *s_ip;
+
+	memset (fp, 0, sizeof (*fp));
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (s_con) {
+		fp->type = nm_setting_connection_get_connection_type (s_con);
+		fp->ifname = nm_setting_connection_get_interface_name (s_con);
+	}
+
+	s_wired = nm_connection_get_setting_wired (connection);
+	if (s_wired)
+		fp->mac = nm_setting_wired_get_mac_address (s_wired);
+
+	s_ip = nm_connection_get_setting_ip4_config (connection);
+	if (s_ip) {
+		fp->has_ip4 = TRUE;
+		fp->ip4_method = nm_setting_ip_config_get_method (s_ip);
+		fp->ip4_addresses_hash = _addresses_hash (s_ip);
+	}
+
+	s_ip = nm_connection_get_setting_ip6_config (connection);
+	if (s_ip) {
+		fp->has_ip6 = TRUE;
+		fp->ip6_method = nm_setting_ip_config_get_method (s_ip);
+		fp->ip6_addresses_hash = _addresses_hash (s_ip);
+	}
+}
+
+static gboolean
+_match_fingerprint_compatible (const MatchFingerprint *orig, const MatchFingerprint *cand)
+{
+	if (g_strcmp0 (orig->type, cand->type) != 0)
+		return FALSE;
+
+	if (   orig->ifname && cand->ifname
+	    && strcmp (orig->ifname, cand->ifname) != 0)
+		return FALSE;
+
+	if (   orig->mac && cand->mac
+	    && !nm_utils_hwaddr_matches (orig->mac, -1, cand->mac, -1))
+		return FALSE;
+
+	if (orig->has_ip4 && cand->has_ip4) {
+		if (orig->ip4_addresses_hash != cand->ip4_addresses_hash)
+			return FALSE;
+		/* see check_ip4_method() */
+		if (   g_strcmp0 (orig->ip4_method, cand->ip4_method) != 0
+		    && !(   nm_streq0 (orig->ip4_method, NM_SETTING_IP4_CONFIG_METHOD_DISABLED)
+		         && nm_streq0 (cand->ip4_method, NM_SETTING_IP4_CONFIG_METHOD_AUTO)))
+			return FALSE;
+	}
+
+	if (orig->has_ip6 && cand->has_ip6) {
+		if (orig->ip6_addresses_hash != cand->ip6_addresses_hash)
+			return FALSE;
+		/* see check_ip6_method() */
+		if (   g_strcmp0 (orig->ip6_method, cand->ip6_method) != 0
+		    && !(   nm_streq0 (orig->ip6_method, NM_SETTING_IP6_CONFIG_METHOD_LINK_LOCAL)
+		         && nm_streq0 (cand->ip6_method, NM_SETTING_IP6_CONFIG_METHOD_AUTO))
+		    && !(   (   nm_streq0 (orig->ip6_method, NM_SETTING_IP6_CONFIG_METHOD_LINK_LOCAL)
+		             || nm_streq0 (orig->ip6_method, NM_SETTING_IP6_CONFIG_METHOD_AUTO))
+		         && nm_streq0 (cand->ip6_method, NM_SETTING_IP6_CONFIG_METHOD_IGNORE)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 /**
  * nm_utils_match_connection:
  * @connections: a (optionally pre-sorted) list of connections from which to
@@ -676,8 +786,11 @@ nm_utils_match_connection (GSList *connections,
                            gpointer match_filter_data)
 {
 	NMConnection *best_match = NULL;
+	MatchFingerprint orig_fp, cand_fp;
 	GSList *iter;
 
+	_match_fingerprint_init (&orig_fp, original);
+
 	for (iter = connections; iter; iter = iter->next) {
 		NMConnection *candidate = NM_CONNECTION (iter->data);
 		GHashTable *diffs = NULL;
@@ -687,6 +800,10 @@ nm_utils_match_connection (GSList *connections,
 				continue;
 		}
 
+		_match_fingerprint_init (&cand_fp, candidate);
+		if (!_match_fingerprint_compatible (&orig_fp, &cand_fp))
+			continue;
+
 		if (!nm_connection_diff (original, candidate, NM_SETTING_COMPARE_FLAG_INFERRABLE, &diffs)) {
 			if (!best_match) {
 				best_match = check_possible_match (original, candidate, diffs, device_has_carrier,
@@ -787,4 +904,49 @@ nm_utils_g_value_set_object_path_array (GValue *value,
 	g_value_take_boxed (value, paths);
 }
 
+static guint32
+_route_attribute_get_uint32 (NMIPRoute *s_route, const char *name)
+{
+	GVariant *variant;
+
+	variant = nm_ip_route_get_attribute (s_route, name);
+	if (variant && g_variant_is_of_type (variant, G_VARIANT_TYPE_UINT32))
+		return g_variant_get_uint32 (variant);
+	return 0;
+}
+
+/**
+ * nm_utils_ip_route_attributes_to_platform:
+ * @s_route: the route of the setting
+ * @route: the platform route to update
+ *
+ * Copies the TCP tuning attributes of @s_route (NM_IP_ROUTE_ATTRIBUTE_*)
+ * to @route.
+ */
+void
+nm_utils_ip_route_attributes_to_platform (NMIPRoute *s_route,
+                                          NMPlatformIPRoute *route)
+{
+	GVariant *variant;
+
+	route->window = _route_attribute_get_uint32 (s_route, NM_IP_ROUTE_ATTRIBUTE_WINDOW);
+	route->initcwnd = _route_attribute_get_uint32 (s_route, NM_IP_ROUTE_ATTRIBUTE_INITCWND);
+	route->initrwnd = _route_attribute_get_uint32 (s_route, NM_IP_ROUTE_ATTRIBUTE_INITRWND);
+	route->rtt = _route_attribute_get_uint32 (s_route, NM_IP_ROUTE_ATTRIBUTE_RTT);
+	route->mtu = _route_attribute_get_uint32 (s_route, NM_IP_ROUTE_ATTRIBUTE_MTU);
+
+	variant = nm_ip_route_get_attribute (s_route, NM_IP_ROUTE_ATTRIBUTE_LOCK_MTU);
+	route->lock_mtu =    variant
+	                  && g_variant_is_of_type (variant, G_VARIANT_TYPE_BOOLEAN)
+	                  && g_variant_get_boolean (variant);
+
+	variant = nm_ip_route_get_attribute (s_route, NM_IP_ROUTE_ATTRIBUTE_CONGCTL);
+	if (   variant
+	    && g_variant_is_of_type (variant, G_VARIANT_TYPE_STRING)
+	    && g_variant_get_string (variant, NULL)[0])
+		route->congctl = g_intern_string (g_variant_get_string (variant, NULL));
+	else
+		route->congctl = NULL;
+}
+
 /******************************************************************************/
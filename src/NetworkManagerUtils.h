@@ -23,6 +23,7 @@
 #define __NETWORKMANAGER_UTILS_H__
 
 #include "nm-core-utils.h"
+#include "nm-platform.h"
 
 /*****************************************************************************/
 
@@ -63,6 +64,9 @@ void nm_utils_g_value_set_object_path_array (GValue *value,
                                              NMUtilsObjectFunc filter_func,
                                              gpointer user_data);
 
+void nm_utils_ip_route_attributes_to_platform (NMIPRoute *s_route,
+                                               NMPlatformIPRoute *route);
+
 /*****************************************************************************/
 
 #endif /* __NETWORKMANAGER_UTILS_H__ */
@@ -16,15 +16,24 @@
 
 #include "nm-default.h"
 
+#include <errno.h>
 #include <netinet/in.h>
-#include <sys/types.h>
-#include <sys/wait.h>
+#include <netinet/if_ether.h>
+#include <net/if_arp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
 
 #include "nm-arping-manager.h"
 #include "nm-platform.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
 
+/* Number of probes sent for each address. They are spread evenly
+ * over the DAD timeout. */
+#define PROBE_NUM 3
+
 typedef enum {
 	STATE_INIT,
 	STATE_PROBING,
@@ -34,19 +43,20 @@ typedef enum {
 
 typedef struct {
 	int            ifindex;
+	guint8         hwaddr[ETH_ALEN];
 	State          state;
 	GHashTable    *addresses;
-	guint          completed;
+	int            fd;
+	GIOChannel    *channel;
+	guint          channel_id;
 	guint          timer;
+	guint          timer_ticks;
 	guint          round2_id;
 } NMArpingManagerPrivate;
 
 typedef struct {
 	in_addr_t address;
-	GPid pid;
-	guint watch;
 	gboolean duplicate;
-	NMArpingManager *manager;
 } AddressInfo;
 
 enum {
@@ -74,6 +84,140 @@ G_DEFINE_TYPE (NMArpingManager, nm_arping_manager, G_TYPE_OBJECT)
                 _NM_UTILS_MACRO_REST (__VA_ARGS__)); \
     } G_STMT_END
 
+/*****************************************************************************/
+
+static int
+arp_socket_open (int ifindex, const guint8 *hwaddr)
+{
+	const guint32 sha_hi = (hwaddr[0] << 24) | (hwaddr[1] << 16) | (hwaddr[2] << 8) | hwaddr[3];
+	const guint32 sha_lo = (hwaddr[4] << 8) | hwaddr[5];
+	struct sock_filter filter[] = {
+		BPF_STMT (BPF_LD + BPF_W + BPF_LEN, 0),                                          /* A <- packet length */
+		BPF_JUMP (BPF_JMP + BPF_JGE + BPF_K, sizeof (struct ether_arp), 1, 0),           /* packet >= arp packet ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore */
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hrd)), /* A <- header */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPHRD_ETHER, 1, 0),                        /* header == ethernet ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore */
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pro)), /* A <- protocol */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETHERTYPE_IP, 1, 0),                        /* protocol == IP ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore */
+		BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hln)), /* A <- hardware address length */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETH_ALEN, 1, 0),                            /* length == ETH_ALEN ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore */
+		BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pln)), /* A <- protocol address length */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sizeof (in_addr_t), 1, 0),                  /* length == sizeof (in_addr_t) ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore */
+		BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ether_arp, arp_sha)),       /* A <- first 4 bytes of SHA */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sha_hi, 0, 3),                              /* SHA == our MAC ? */
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, arp_sha) + 4),   /* A <- remainder of SHA */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sha_lo, 0, 1),                              /* SHA == our MAC ? */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                                   /* ignore our own packets */
+		BPF_STMT (BPF_RET + BPF_K, sizeof (struct ether_arp)),                           /* accept */
+	};
+	struct sock_fprog fprog = {
+		.len = G_N_ELEMENTS (filter),
+		.filter = filter,
+	};
+	struct sockaddr_ll link = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = ifindex,
+	};
+	int fd, errsv;
+
+	fd = socket (PF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (   setsockopt (fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog)) < 0
+	    || bind (fd, (struct sockaddr *) &link, sizeof (link)) < 0) {
+		errsv = errno;
+		close (fd);
+		return -errsv;
+	}
+
+	return fd;
+}
+
+static gboolean
+arp_send (NMArpingManager *self, in_addr_t address, guint16 op, gboolean announce)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	struct sockaddr_ll link = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+		.sll_halen = ETH_ALEN,
+		.sll_addr = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	};
+	struct ether_arp arp = {
+		.ea_hdr.ar_hrd = htons (ARPHRD_ETHER),
+		.ea_hdr.ar_pro = htons (ETHERTYPE_IP),
+		.ea_hdr.ar_hln = ETH_ALEN,
+		.ea_hdr.ar_pln = sizeof (in_addr_t),
+		.ea_hdr.ar_op = htons (op),
+	};
+
+	memcpy (arp.arp_sha, priv->hwaddr, ETH_ALEN);
+	memcpy (arp.arp_tpa, &address, sizeof (address));
+	/* Probes carry a zero sender address, announcements our own. */
+	if (announce)
+		memcpy (arp.arp_spa, &address, sizeof (address));
+
+	if (sendto (priv->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &link, sizeof (link)) < 0) {
+		_LOGD ("could not send ARP for address %s: %s",
+		       nm_utils_inet4_ntop (address, NULL), g_strerror (errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+arp_socket_ensure (NMArpingManager *self, GError **error)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	const guint8 *hwaddr;
+	size_t hwaddr_len = 0;
+	int fd;
+
+	if (priv->fd >= 0)
+		return TRUE;
+
+	hwaddr = nm_platform_link_get_address (NM_PLATFORM_GET, priv->ifindex, &hwaddr_len);
+	if (!hwaddr || hwaddr_len != ETH_ALEN) {
+		/* The device was probably just removed. */
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't find an Ethernet address for ifindex %d", priv->ifindex);
+		return FALSE;
+	}
+	memcpy (priv->hwaddr, hwaddr, ETH_ALEN);
+
+	fd = arp_socket_open (priv->ifindex, priv->hwaddr);
+	if (fd < 0) {
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't open ARP socket: %s", g_strerror (-fd));
+		return FALSE;
+	}
+
+	priv->fd = fd;
+	return TRUE;
+}
+
+static void
+arp_socket_close (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->channel_id);
+	g_clear_pointer (&priv->channel, g_io_channel_unref);
+	if (priv->fd >= 0) {
+		close (priv->fd);
+		priv->fd = -1;
+	}
+}
+
+/*****************************************************************************/
+
 /**
  * nm_arping_manager_add_address:
  * @self: a #NMArpingManager
@@ -100,7 +244,6 @@ nm_arping_manager_add_address (NMArpingManager *self, in_addr_t address)
 
 	info = g_slice_new0 (AddressInfo);
 	info->address = address;
-	info->manager = self;
 
 	g_hash_table_insert (priv->addresses, GUINT_TO_POINTER (address), info);
 
@@ -108,32 +251,93 @@ nm_arping_manager_add_address (NMArpingManager *self, in_addr_t address)
 }
 
 static void
-arping_watch_cb (GPid pid, gint status, gpointer user_data)
+probe_done (NMArpingManager *self)
 {
-	AddressInfo *info = user_data;
-	NMArpingManager *self = info->manager;
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *addr;
 
-	info->pid = 0;
-	info->watch = 0;
-	addr = nm_utils_inet4_ntop (info->address, NULL);
+	nm_clear_g_source (&priv->timer);
+	arp_socket_close (self);
+	priv->state = STATE_PROBE_DONE;
+	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+}
+
+static gboolean
+arp_receive_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMArpingManager *self = user_data;
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	struct ether_arp arp;
+	AddressInfo *info;
+	in_addr_t spa, tpa;
+	gboolean all_duplicate;
+	GHashTableIter iter;
+	ssize_t n;
+
+	if (NM_FLAGS_ANY (condition, G_IO_ERR | G_IO_HUP)) {
+		/* most likely the interface went away. Stop listening, otherwise
+		 * the watch fires again right away; the timer still ends the probe. */
+		_LOGD ("error on the ARP socket, stop receiving");
+		priv->channel_id = 0;
+		g_clear_pointer (&priv->channel, g_io_channel_unref);
+		return G_SOURCE_REMOVE;
+	}
+
+	for (;;) {
+		n = recv (priv->fd, &arp, sizeof (arp), 0);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if ((size_t) n < sizeof (arp))
+			continue;
+
+		memcpy (&spa, arp.arp_spa, sizeof (spa));
+		memcpy (&tpa, arp.arp_tpa, sizeof (tpa));
 
-	if (WIFEXITED (status)) {
-		if (WEXITSTATUS (status) != 0) {
+		/* Somebody else uses the address, or is probing for it at the
+		 * same time as we do. */
+		info = spa ? g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (spa)) : NULL;
+		if (!info && !spa && ntohs (arp.ea_hdr.ar_op) == ARPOP_REQUEST)
+			info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (tpa));
+		if (info && !info->duplicate) {
 			_LOGD ("%s already used in the %s network",
-			       addr, nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
+			       nm_utils_inet4_ntop (info->address, NULL),
+			       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
 			info->duplicate = TRUE;
-		} else
-			_LOGD ("DAD succeeded for %s", addr);
-	} else {
-		_LOGD ("stopped unexpectedly with status %d for %s", status, addr);
+		}
+	}
+
+	all_duplicate = TRUE;
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		if (!info->duplicate) {
+			all_duplicate = FALSE;
+			break;
+		}
 	}
 
-	if (++priv->completed == g_hash_table_size (priv->addresses)) {
-		priv->state = STATE_PROBE_DONE;
-		nm_clear_g_source (&priv->timer);
-		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	if (all_duplicate) {
+		/* nothing left to probe for. */
+		priv->channel_id = 0;
+		probe_done (self);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+send_probes (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	AddressInfo *info;
+
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		if (!info->duplicate)
+			arp_send (self, info->address, ARPOP_REQUEST, FALSE);
 	}
 }
 
@@ -145,23 +349,19 @@ arping_timeout_cb (gpointer user_data)
 	GHashTableIter iter;
 	AddressInfo *info;
 
-	priv->timer = 0;
+	if (++priv->timer_ticks < PROBE_NUM) {
+		send_probes (self);
+		return G_SOURCE_CONTINUE;
+	}
 
 	g_hash_table_iter_init (&iter, priv->addresses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		nm_clear_g_source (&info->watch);
-		if (info->pid) {
-			_LOGD ("DAD timed out for %s",
-			       nm_utils_inet4_ntop (info->address, NULL));
-			nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4,
-			                           "arping", 1000, NULL, NULL);
-			info->pid = 0;
-		}
+		if (!info->duplicate)
+			_LOGD ("DAD succeeded for %s", nm_utils_inet4_ntop (info->address, NULL));
 	}
 
-	priv->state = STATE_PROBE_DONE;
-	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
-
+	priv->timer = 0;
+	probe_done (self);
 	return G_SOURCE_REMOVE;
 }
 
@@ -172,18 +372,15 @@ arping_timeout_cb (gpointer user_data)
  * @error: location to store error, or %NULL
  *
  * Start probing IP addresses for duplicates; when the probe terminates a
- * PROBE_TERMINATED signal is emitted.
+ * PROBE_TERMINATED signal is emitted. All addresses are probed over a
+ * single ARP socket, and the probe terminates after @timeout at the latest.
  *
  * Returns: %TRUE on success, %FALSE on failure
  */
 gboolean
 nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **error)
 {
-	const char *argv[] = { NULL, "-D", "-q", "-I", NULL, "-c", NULL, "-w", NULL, NULL, NULL };
 	NMArpingManagerPrivate *priv;
-	GHashTableIter iter;
-	AddressInfo *info;
-	gs_free char *timeout_str = NULL;
 
 	g_return_val_if_fail (NM_IS_ARPING_MANAGER (self), FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
@@ -192,46 +389,17 @@ nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **er
 	priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		             "can't find a name for ifindex %d", priv->ifindex);
+	if (!arp_socket_ensure (self, error))
 		return FALSE;
-	}
-
-	priv->completed = 0;
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "arping could not be found");
-		return FALSE;
-	}
 
-	timeout_str = g_strdup_printf ("%u", timeout / 1000 + 2);
-	argv[6] = timeout_str;
-	argv[8] = timeout_str;
+	priv->channel = g_io_channel_unix_new (priv->fd);
+	priv->channel_id = g_io_add_watch (priv->channel, G_IO_IN | G_IO_ERR | G_IO_HUP, arp_receive_cb, self);
 
-	g_hash_table_iter_init (&iter, priv->addresses);
-
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
-
-		argv[9] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL |
-		                         G_SPAWN_DO_NOT_REAP_CHILD,
-		                         NULL, NULL, &info->pid, NULL);
-
-		info->watch = g_child_watch_add (info->pid, arping_watch_cb, info);
-	}
+	_LOGD ("probe %u addresses for %u ms", g_hash_table_size (priv->addresses), timeout);
+	send_probes (self);
 
-	priv->timer = g_timeout_add (timeout, arping_timeout_cb, self);
+	priv->timer_ticks = 0;
+	priv->timer = g_timeout_add (MAX (timeout / PROBE_NUM, 1), arping_timeout_cb, self);
 	priv->state = STATE_PROBING;
 
 	return TRUE;
@@ -253,6 +421,7 @@ nm_arping_manager_reset (NMArpingManager *self)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	arp_socket_close (self);
 	g_hash_table_remove_all (priv->addresses);
 
 	priv->state = STATE_INIT;
@@ -301,49 +470,23 @@ nm_arping_manager_check_address (NMArpingManager *self, in_addr_t address)
 }
 
 static void
-send_announcements (NMArpingManager *self, const char *mode_arg)
+send_announcements (NMArpingManager *self, guint16 op)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *argv[] = { NULL, mode_arg, "-q", "-I", NULL, "-c", "1", NULL, NULL };
-	int ip_arg = G_N_ELEMENTS (argv) - 2;
 	GError *error = NULL;
 	GHashTableIter iter;
 	AddressInfo *info;
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		_LOGW ("can't find a name for ifindex %d", priv->ifindex);
-		return;
-	}
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		_LOGW ("arping could not be found; no ARPs will be sent");
+	if (!arp_socket_ensure (self, &error)) {
+		_LOGW ("no ARPs will be sent: %s", error->message);
+		g_clear_error (&error);
 		return;
 	}
 
 	g_hash_table_iter_init (&iter, priv->addresses);
-
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
-
-		if (info->duplicate)
-			continue;
-
-		argv[ip_arg] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL,
-		                         NULL, NULL, NULL, &error);
-		if (!success) {
-			_LOGW ("could not send ARP for address %s: %s", argv[ip_arg],
-			       error->message);
-			g_clear_error (&error);
-		}
+		if (!info->duplicate)
+			arp_send (self, info->address, op, TRUE);
 	}
 }
 
@@ -353,7 +496,8 @@ arp_announce_round2 (gpointer self)
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 
 	priv->round2_id = 0;
-	send_announcements (self, "-U");
+	send_announcements (self, ARPOP_REQUEST);
+	arp_socket_close (self);
 	priv->state = STATE_INIT;
 	g_hash_table_remove_all (priv->addresses);
 
@@ -374,7 +518,7 @@ nm_arping_manager_announce_addresses (NMArpingManager *self)
 	g_return_if_fail (   priv->state == STATE_INIT
 	                  || priv->state == STATE_PROBE_DONE);
 
-	send_announcements (self, "-A");
+	send_announcements (self, ARPOP_REPLY);
 	nm_clear_g_source (&priv->round2_id);
 	priv->round2_id = g_timeout_add_seconds (2, arp_announce_round2, self);
 	priv->state = STATE_ANNOUNCING;
@@ -383,16 +527,7 @@ nm_arping_manager_announce_addresses (NMArpingManager *self)
 static void
 destroy_address_info (gpointer data)
 {
-	AddressInfo *info = (AddressInfo *) data;
-
-	nm_clear_g_source (&info->watch);
-
-	if (info->pid) {
-		nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4, "arping",
-		                           1000, NULL, NULL);
-	}
-
-	g_slice_free (AddressInfo, info);
+	g_slice_free (AddressInfo, (AddressInfo *) data);
 }
 
 static void
@@ -403,6 +538,7 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	arp_socket_close (self);
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_arping_manager_parent_class)->dispose (object);
@@ -416,6 +552,7 @@ nm_arping_manager_init (NMArpingManager *self)
 	priv->addresses = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 	                                         NULL, destroy_address_info);
 	priv->state = STATE_INIT;
+	priv->fd = -1;
 }
 
 NMArpingManager *
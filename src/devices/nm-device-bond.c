@@ -22,6 +22,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <arpa/inet.h>
 
 #include "nm-device-bond.h"
 #include "NetworkManagerUtils.h"
@@ -199,6 +200,153 @@ master_update_slave_connection (NMDevice *self,
 	return TRUE;
 }
 
+typedef struct {
+	const char *attr;
+	const char *value;
+} BondOption;
+
+static const struct {
+	const char *attr;
+	NMPlatformBondOpt opt;
+} bond_opt_map[] = {
+	{ "mode",              NM_PLATFORM_BOND_OPT_MODE },
+	{ "active_slave",      NM_PLATFORM_BOND_OPT_ACTIVE_SLAVE },
+	{ "miimon",            NM_PLATFORM_BOND_OPT_MIIMON },
+	{ "updelay",           NM_PLATFORM_BOND_OPT_UPDELAY },
+	{ "downdelay",         NM_PLATFORM_BOND_OPT_DOWNDELAY },
+	{ "use_carrier",       NM_PLATFORM_BOND_OPT_USE_CARRIER },
+	{ "arp_interval",      NM_PLATFORM_BOND_OPT_ARP_INTERVAL },
+	{ "arp_validate",      NM_PLATFORM_BOND_OPT_ARP_VALIDATE },
+	{ "arp_all_targets",   NM_PLATFORM_BOND_OPT_ARP_ALL_TARGETS },
+	{ "primary",           NM_PLATFORM_BOND_OPT_PRIMARY },
+	{ "primary_reselect",  NM_PLATFORM_BOND_OPT_PRIMARY_RESELECT },
+	{ "fail_over_mac",     NM_PLATFORM_BOND_OPT_FAIL_OVER_MAC },
+	{ "xmit_hash_policy",  NM_PLATFORM_BOND_OPT_XMIT_HASH_POLICY },
+	{ "resend_igmp",       NM_PLATFORM_BOND_OPT_RESEND_IGMP },
+	{ "num_grat_arp",      NM_PLATFORM_BOND_OPT_NUM_PEER_NOTIF },
+	{ "num_unsol_na",      NM_PLATFORM_BOND_OPT_NUM_PEER_NOTIF },
+	{ "all_slaves_active", NM_PLATFORM_BOND_OPT_ALL_SLAVES_ACTIVE },
+	{ "min_links",         NM_PLATFORM_BOND_OPT_MIN_LINKS },
+	{ "lp_interval",       NM_PLATFORM_BOND_OPT_LP_INTERVAL },
+	{ "packets_per_slave", NM_PLATFORM_BOND_OPT_PACKETS_PER_SLAVE },
+	{ "lacp_rate",         NM_PLATFORM_BOND_OPT_AD_LACP_RATE },
+	{ "ad_select",         NM_PLATFORM_BOND_OPT_AD_SELECT },
+	{ "ad_actor_sys_prio", NM_PLATFORM_BOND_OPT_AD_ACTOR_SYS_PRIO },
+	{ "ad_user_port_key",  NM_PLATFORM_BOND_OPT_AD_USER_PORT_KEY },
+	{ "ad_actor_system",   NM_PLATFORM_BOND_OPT_AD_ACTOR_SYSTEM },
+	{ "tlb_dynamic_lb",    NM_PLATFORM_BOND_OPT_TLB_DYNAMIC_LB },
+};
+
+static void
+add_option (GArray *options, const char *attr, const char *value)
+{
+	BondOption *opt;
+
+	g_array_set_size (options, options->len + 1);
+	opt = &g_array_index (options, BondOption, options->len - 1);
+	opt->attr = attr;
+	opt->value = value;
+}
+
+static void
+add_simple_option (GArray *options,
+                   const char *attr,
+                   NMSettingBond *s_bond,
+                   const char *opt)
+{
+	const char *value;
+
+	value = nm_setting_bond_get_option_by_name (s_bond, opt);
+	if (!value)
+		value = nm_setting_bond_get_option_default (s_bond, opt);
+	add_option (options, attr, value);
+}
+
+/* Converts one option to its netlink representation. Returns FALSE
+ * for options the kernel would reject in a netlink request, where a
+ * single rejected attribute fails the whole request. These options
+ * are written over sysfs instead. */
+static gboolean
+option_to_change (int mode, const BondOption *option, NMPlatformBondChange *change)
+{
+	NMPlatformBondOpt opt;
+	guint i, v;
+	int ifindex;
+
+	for (i = 0; i < G_N_ELEMENTS (bond_opt_map); i++) {
+		if (nm_streq (bond_opt_map[i].attr, option->attr))
+			break;
+	}
+	if (i == G_N_ELEMENTS (bond_opt_map))
+		return FALSE;
+	opt = bond_opt_map[i].opt;
+
+	switch (opt) {
+	case NM_PLATFORM_BOND_OPT_ACTIVE_SLAVE:
+		/* only the active-backup, balance-tlb and balance-alb modes support
+		 * it, and the slaves are not enslaved yet. */
+		if (   !NM_IN_SET (mode, 1, 5, 6)
+		    || (option->value && option->value[0]))
+			return FALSE;
+		v = 0;
+		break;
+	case NM_PLATFORM_BOND_OPT_PRIMARY:
+		v = 0;
+		if (option->value && option->value[0]) {
+			ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, option->value);
+			if (ifindex <= 0)
+				return FALSE;
+			v = ifindex;
+		}
+		break;
+	case NM_PLATFORM_BOND_OPT_ARP_VALIDATE:
+		/* not supported by the 802.3ad, balance-tlb and balance-alb modes */
+		if (   NM_IN_SET (mode, 4, 5, 6)
+		    || !_nm_setting_bond_option_to_uint (option->attr, option->value, &v))
+			return FALSE;
+		break;
+	case NM_PLATFORM_BOND_OPT_AD_ACTOR_SYSTEM:
+		if (   !option->value
+		    || !nm_utils_hwaddr_aton (option->value, change->ad_actor_system, ETH_ALEN))
+			return FALSE;
+		v = 0;
+		break;
+	default:
+		if (!_nm_setting_bond_option_to_uint (option->attr, option->value, &v))
+			return FALSE;
+		break;
+	}
+
+	change->values[opt] = v;
+	change->set |= (1u << opt);
+	return TRUE;
+}
+
+static gboolean
+arp_targets_to_change (const char *value, NMPlatformBondChange *change)
+{
+	gs_strfreev char **items = NULL;
+	char **iter;
+
+	change->n_arp_ip_targets = 0;
+	change->set |= (1u << NM_PLATFORM_BOND_OPT_ARP_IP_TARGET);
+
+	if (!value || !*value)
+		return TRUE;
+
+	items = g_strsplit_set (value, ",", 0);
+	for (iter = items; *iter; iter++) {
+		if (!*iter[0])
+			continue;
+		if (change->n_arp_ip_targets >= NM_PLATFORM_BOND_MAX_ARP_TARGETS)
+			return FALSE;
+		if (inet_pton (AF_INET, *iter, &change->arp_ip_targets[change->n_arp_ip_targets]) != 1)
+			return FALSE;
+		change->n_arp_ip_targets++;
+	}
+	return TRUE;
+}
+
 static void
 set_arp_targets (NMDevice *device,
                  const char *value,
@@ -222,33 +370,98 @@ set_arp_targets (NMDevice *device,
 }
 
 static void
-set_simple_option (NMDevice *device,
-                   const char *attr,
-                   NMSettingBond *s_bond,
-                   const char *opt)
+apply_options_sysfs (NMDevice *device, GArray *options, const char *arp_ip_target)
 {
-	const char *value;
+	int ifindex = nm_device_get_ifindex (device);
+	char *contents;
+	guint i;
 
-	value = nm_setting_bond_get_option_by_name (s_bond, opt);
-	if (!value)
-		value = nm_setting_bond_get_option_default (s_bond, opt);
-	set_bond_attr (device, attr, value);
+	for (i = 0; i < options->len; i++) {
+		const BondOption *opt = &g_array_index (options, BondOption, i);
+
+		set_bond_attr (device, opt->attr, opt->value);
+	}
+
+	/* Clear ARP targets */
+	contents = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, "arp_ip_target");
+	set_arp_targets (device, contents, " \n", "-");
+	g_free (contents);
+
+	/* Add new ARP targets */
+	set_arp_targets (device, arp_ip_target, ",", "+");
 }
 
-static NMActStageReturn
-apply_bonding_config (NMDevice *device)
+/* Programs all options that can be expressed with IFLA_BOND_* attributes
+ * with a single netlink request, instead of one sysfs write per option.
+ * The remaining options are then written to sysfs. */
+static gboolean
+options_to_change (const char *mode,
+                   GArray *options,
+                   const char *arp_ip_target,
+                   NMPlatformBondChange *change,
+                   GArray **out_remaining)
+{
+	GArray *remaining;
+	int mode_int;
+	guint i;
+
+	mode_int = nm_utils_bond_mode_string_to_int (mode);
+	if (mode_int < 0)
+		return FALSE;
+
+	/* the kernel rejects IFLA_BOND_ARP_IP_TARGET, like the other ARP
+	 * monitoring options, in the 802.3ad, balance-tlb and balance-alb modes. */
+	if (   !NM_IN_SET (mode_int, 4, 5, 6)
+	    && !arp_targets_to_change (arp_ip_target, change))
+		return FALSE;
+
+	remaining = g_array_new (FALSE, FALSE, sizeof (BondOption));
+	for (i = 0; i < options->len; i++) {
+		const BondOption *opt = &g_array_index (options, BondOption, i);
+
+		if (!option_to_change (mode_int, opt, change))
+			g_array_append_val (remaining, *opt);
+	}
+	*out_remaining = remaining;
+	return TRUE;
+}
+
+static gboolean
+apply_options_netlink (NMDevice *device, const char *mode, GArray *options, const char *arp_ip_target)
+{
+	NMDeviceBond *self = NM_DEVICE_BOND (device);
+	NMPlatformBondChange change = { 0 };
+	gs_unref_array GArray *remaining = NULL;
+	guint i;
+
+	if (!options_to_change (mode, options, arp_ip_target, &change, &remaining))
+		return FALSE;
+
+	if (!nm_platform_link_bond_change (NM_PLATFORM_GET, nm_device_get_ifindex (device), &change)) {
+		_LOGD (LOGD_HW, "failed to set bonding options via netlink, falling back to sysfs");
+		return FALSE;
+	}
+
+	for (i = 0; i < remaining->len; i++) {
+		const BondOption *opt = &g_array_index (remaining, BondOption, i);
+
+		set_bond_attr (device, opt->attr, opt->value);
+	}
+	return TRUE;
+}
+
+static GArray *
+build_options (NMSettingBond *s_bond, const char **out_mode, const char **out_arp_ip_target)
 {
-	NMConnection *connection;
-	NMSettingBond *s_bond;
-	int ifindex = nm_device_get_ifindex (device);
 	const char *mode, *value;
-	char *contents;
-	gboolean set_arp_interval = TRUE;
+	GArray *options;
+	gboolean arp_supported;
+	gboolean set_arp_interval;
 
 	/* Option restrictions:
 	 *
 	 * arp_interval conflicts miimon > 0
-	 * arp_interval conflicts [ alb, tlb ]
+	 * arp_interval, arp_validate, arp_ip_target conflict [ 802.3ad, alb, tlb ]
 	 * arp_validate needs [ active-backup ]
 	 * downdelay needs miimon
 	 * updelay needs miimon
@@ -258,24 +471,28 @@ apply_bonding_config (NMDevice *device)
 	 *     arp_interval doesn't require miimon to be 0
 	 */
 
-	connection = nm_device_get_applied_connection (device);
-	g_assert (connection);
-	s_bond = nm_connection_get_setting_bond (connection);
-	g_assert (s_bond);
+	options = g_array_sized_new (FALSE, FALSE, sizeof (BondOption), 32);
 
 	mode = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_MODE);
 	if (mode == NULL)
 		mode = "balance-rr";
 
+	/* The kernel rejects every ARP monitoring option in the 802.3ad,
+	 * balance-tlb and balance-alb modes, and already disables the ARP
+	 * monitor when switching to one of them. */
+	arp_supported = !NM_IN_STRSET (mode, "802.3ad", "balance-alb", "balance-tlb");
+	set_arp_interval = arp_supported;
+
 	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_MIIMON);
 	if (value && atoi (value)) {
 		/* clear arp interval */
-		set_bond_attr (device, "arp_interval", "0");
+		if (arp_supported)
+			add_option (options, "arp_interval", "0");
 		set_arp_interval = FALSE;
 
-		set_bond_attr (device, "miimon", value);
-		set_simple_option (device, "updelay", s_bond, NM_SETTING_BOND_OPTION_UPDELAY);
-		set_simple_option (device, "downdelay", s_bond, NM_SETTING_BOND_OPTION_DOWNDELAY);
+		add_option (options, "miimon", value);
+		add_simple_option (options, "updelay", s_bond, NM_SETTING_BOND_OPTION_UPDELAY);
+		add_simple_option (options, "downdelay", s_bond, NM_SETTING_BOND_OPTION_DOWNDELAY);
 	} else if (!value) {
 		/* If not given, and arp_interval is not given, default to 100 */
 		long int val_int;
@@ -285,76 +502,110 @@ apply_bonding_config (NMDevice *device)
 		errno = 0;
 		val_int = strtol (value ? value : "0", &end, 10);
 		if (!value || (val_int == 0 && errno == 0 && *end == '\0'))
-			set_bond_attr (device, "miimon", "100");
+			add_option (options, "miimon", "100");
 	}
 
 	/* The stuff after 'mode' requires the given mode or doesn't care */
-	set_bond_attr (device, "mode", mode);
-
-	/* arp_interval not compatible with ALB, TLB */
-	if (NM_IN_STRSET (mode, "balance-alb", "balance-tlb"))
-		set_arp_interval = FALSE;
+	add_option (options, "mode", mode);
 
 	if (set_arp_interval) {
-		set_simple_option (device, "arp_interval", s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL);
+		add_simple_option (options, "arp_interval", s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL);
 
 		/* Just let miimon get cleared automatically; even setting miimon to
 		 * 0 (disabled) clears arp_interval.
 		 */
 	}
 
-	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_VALIDATE);
-	/* arp_validate > 0 only valid in active-backup mode */
-	if (   value
-	    && !nm_streq (value, "0")
-	    && !nm_streq (value, "none")
-	    && nm_streq (mode, "active-backup"))
-		set_bond_attr (device, "arp_validate", value);
-	else
-		set_bond_attr (device, "arp_validate", "0");
+	if (arp_supported) {
+		value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_VALIDATE);
+		/* arp_validate > 0 only valid in active-backup mode */
+		if (   value
+		    && !nm_streq (value, "0")
+		    && !nm_streq (value, "none")
+		    && nm_streq (mode, "active-backup"))
+			add_option (options, "arp_validate", value);
+		else
+			add_option (options, "arp_validate", "0");
+	}
 
 	if (NM_IN_STRSET (mode, "active-backup", "balance-alb", "balance-tlb")) {
 		value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_PRIMARY);
-		set_bond_attr (device, "primary", value ? value : "");
-		set_simple_option (device, "lp_internal", s_bond, NM_SETTING_BOND_OPTION_LP_INTERVAL);
+		add_option (options, "primary", value ? value : "");
+		add_simple_option (options, "lp_interval", s_bond, NM_SETTING_BOND_OPTION_LP_INTERVAL);
 	}
 
-	/* Clear ARP targets */
-	contents = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, "arp_ip_target");
-	set_arp_targets (device, contents, " \n", "-");
-	g_free (contents);
-
-	/* Add new ARP targets */
-	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_IP_TARGET);
-	set_arp_targets (device, value, ",", "+");
-
-	set_simple_option (device, "primary_reselect", s_bond, NM_SETTING_BOND_OPTION_PRIMARY_RESELECT);
-	set_simple_option (device, "fail_over_mac", s_bond, NM_SETTING_BOND_OPTION_FAIL_OVER_MAC);
-	set_simple_option (device, "use_carrier", s_bond, NM_SETTING_BOND_OPTION_USE_CARRIER);
-	set_simple_option (device, "ad_select", s_bond, NM_SETTING_BOND_OPTION_AD_SELECT);
-	set_simple_option (device, "xmit_hash_policy", s_bond, NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY);
-	set_simple_option (device, "resend_igmp", s_bond, NM_SETTING_BOND_OPTION_RESEND_IGMP);
-	set_simple_option (device, "active_slave", s_bond, NM_SETTING_BOND_OPTION_ACTIVE_SLAVE);
-	set_simple_option (device, "all_slaves_active", s_bond, NM_SETTING_BOND_OPTION_ALL_SLAVES_ACTIVE);
-	set_simple_option (device, "num_grat_arp", s_bond, NM_SETTING_BOND_OPTION_NUM_GRAT_ARP);
-	set_simple_option (device, "num_unsol_na", s_bond, NM_SETTING_BOND_OPTION_NUM_UNSOL_NA);
+	*out_arp_ip_target =   arp_supported
+	                     ? nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_IP_TARGET)
+	                     : NULL;
+
+	add_simple_option (options, "primary_reselect", s_bond, NM_SETTING_BOND_OPTION_PRIMARY_RESELECT);
+	add_simple_option (options, "fail_over_mac", s_bond, NM_SETTING_BOND_OPTION_FAIL_OVER_MAC);
+	add_simple_option (options, "use_carrier", s_bond, NM_SETTING_BOND_OPTION_USE_CARRIER);
+	add_simple_option (options, "ad_select", s_bond, NM_SETTING_BOND_OPTION_AD_SELECT);
+	add_simple_option (options, "xmit_hash_policy", s_bond, NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY);
+	add_simple_option (options, "resend_igmp", s_bond, NM_SETTING_BOND_OPTION_RESEND_IGMP);
+	add_simple_option (options, "active_slave", s_bond, NM_SETTING_BOND_OPTION_ACTIVE_SLAVE);
+	add_simple_option (options, "all_slaves_active", s_bond, NM_SETTING_BOND_OPTION_ALL_SLAVES_ACTIVE);
+	add_simple_option (options, "num_grat_arp", s_bond, NM_SETTING_BOND_OPTION_NUM_GRAT_ARP);
+	add_simple_option (options, "num_unsol_na", s_bond, NM_SETTING_BOND_OPTION_NUM_UNSOL_NA);
 
 	if (nm_streq (mode, "802.3ad")) {
-		set_simple_option (device, "lacp_rate", s_bond, NM_SETTING_BOND_OPTION_LACP_RATE);
-		set_simple_option (device, "ad_actor_sys_prio", s_bond, NM_SETTING_BOND_OPTION_AD_ACTOR_SYS_PRIO);
-		set_simple_option (device, "ad_actor_system", s_bond, NM_SETTING_BOND_OPTION_AD_ACTOR_SYSTEM);
-		set_simple_option (device, "ad_user_port_key", s_bond, NM_SETTING_BOND_OPTION_AD_USER_PORT_KEY);
-		set_simple_option (device, "min_links", s_bond, NM_SETTING_BOND_OPTION_MIN_LINKS);
+		add_simple_option (options, "lacp_rate", s_bond, NM_SETTING_BOND_OPTION_LACP_RATE);
+		add_simple_option (options, "ad_actor_sys_prio", s_bond, NM_SETTING_BOND_OPTION_AD_ACTOR_SYS_PRIO);
+		add_simple_option (options, "ad_actor_system", s_bond, NM_SETTING_BOND_OPTION_AD_ACTOR_SYSTEM);
+		add_simple_option (options, "ad_user_port_key", s_bond, NM_SETTING_BOND_OPTION_AD_USER_PORT_KEY);
+		add_simple_option (options, "min_links", s_bond, NM_SETTING_BOND_OPTION_MIN_LINKS);
 	}
 
 	if (nm_streq (mode, "active-backup"))
-		set_simple_option (device, "arp_all_targets", s_bond, NM_SETTING_BOND_OPTION_ARP_ALL_TARGETS);
+		add_simple_option (options, "arp_all_targets", s_bond, NM_SETTING_BOND_OPTION_ARP_ALL_TARGETS);
 
 	if (nm_streq (mode, "balance-rr"))
-		set_simple_option (device, "packets_per_slave", s_bond, NM_SETTING_BOND_OPTION_PACKETS_PER_SLAVE);
+		add_simple_option (options, "packets_per_slave", s_bond, NM_SETTING_BOND_OPTION_PACKETS_PER_SLAVE);
 
 	if (nm_streq (mode, "balance-tlb"))
-		set_simple_option (device, "tlb_dynamic_lb", s_bond, NM_SETTING_BOND_OPTION_TLB_DYNAMIC_LB);
+		add_simple_option (options, "tlb_dynamic_lb", s_bond, NM_SETTING_BOND_OPTION_TLB_DYNAMIC_LB);
+
+	*out_mode = mode;
+	return options;
+}
+
+gboolean
+_nm_device_bond_config_to_change (NMSettingBond *s_bond,
+                                  NMPlatformBondChange *change,
+                                  GPtrArray **out_sysfs_attrs)
+{
+	gs_unref_array GArray *options = NULL;
+	gs_unref_array GArray *remaining = NULL;
+	const char *mode, *arp_ip_target;
+	guint i;
+
+	options = build_options (s_bond, &mode, &arp_ip_target);
+	if (!options_to_change (mode, options, arp_ip_target, change, &remaining))
+		return FALSE;
+
+	*out_sysfs_attrs = g_ptr_array_new ();
+	for (i = 0; i < remaining->len; i++)
+		g_ptr_array_add (*out_sysfs_attrs, (gpointer) g_array_index (remaining, BondOption, i).attr);
+	return TRUE;
+}
+
+static NMActStageReturn
+apply_bonding_config (NMDevice *device)
+{
+	NMConnection *connection;
+	NMSettingBond *s_bond;
+	const char *mode, *arp_ip_target;
+	gs_unref_array GArray *options = NULL;
+
+	connection = nm_device_get_applied_connection (device);
+	g_assert (connection);
+	s_bond = nm_connection_get_setting_bond (connection);
+	g_assert (s_bond);
+
+	options = build_options (s_bond, &mode, &arp_ip_target);
+	if (!apply_options_netlink (device, mode, options, arp_ip_target))
+		apply_options_sysfs (device, options, arp_ip_target);
 
 	return NM_ACT_STAGE_RETURN_SUCCESS;
 }
@@ -411,10 +662,7 @@ enslave_slave (NMDevice *device,
 	nm_device_master_check_slave_physical_port (device, slave, LOGD_BOND);
 
 	if (configure) {
-		nm_device_take_down (slave, TRUE);
-		success = nm_platform_link_enslave (NM_PLATFORM_GET,
-		                                    nm_device_get_ip_ifindex (device),
-		                                    nm_device_get_ip_ifindex (slave));
+		success = nm_device_master_enslave_link (device, slave);
 		nm_device_bring_up (slave, TRUE, &no_firmware);
 
 		if (!success)
@@ -22,6 +22,7 @@
 #define __NETWORKMANAGER_DEVICE_BOND_H__
 
 #include "nm-device.h"
+#include "nm-platform.h"
 
 G_BEGIN_DECLS
 
@@ -37,6 +38,11 @@ typedef NMDeviceClass NMDeviceBondClass;
 
 GType nm_device_bond_get_type (void);
 
+/* exposed for the unit tests */
+gboolean _nm_device_bond_config_to_change (NMSettingBond *s_bond,
+                                           NMPlatformBondChange *change,
+                                           GPtrArray **out_sysfs_attrs);
+
 G_END_DECLS
 
 #endif	/* NM_DEVICE_BOND_H */
@@ -148,14 +148,12 @@ static const Option slave_options[] = {
 	{ NULL, NULL }
 };
 
-static void
-commit_option (NMDevice *device, NMSetting *setting, const Option *option, gboolean slave)
+static guint32
+option_get_value (NMSetting *setting, const Option *option)
 {
-	int ifindex = nm_device_get_ifindex (device);
 	GParamSpec *pspec;
 	GValue val = G_VALUE_INIT;
 	guint32 uval = 0;
-	gs_free char *value = NULL;
 
 	g_assert (setting);
 
@@ -191,7 +189,16 @@ commit_option (NMDevice *device, NMSetting *setting, const Option *option, gbool
 		g_assert_not_reached ();
 	g_value_unset (&val);
 
-	value = g_strdup_printf ("%u", uval);
+	return uval;
+}
+
+static void
+commit_option (NMDevice *device, NMSetting *setting, const Option *option, gboolean slave)
+{
+	int ifindex = nm_device_get_ifindex (device);
+	char value[32];
+
+	nm_sprintf_buf (value, "%u", option_get_value (setting, option));
 	if (slave)
 		nm_platform_sysctl_slave_set_option (NM_PLATFORM_GET, ifindex, option->sysname, value);
 	else
@@ -203,6 +210,32 @@ commit_master_options (NMDevice *device, NMSettingBridge *setting)
 {
 	const Option *option;
 	NMSetting *s = NM_SETTING (setting);
+	NMPlatformBridgeChange change = { 0 };
+
+	/* Set all options with one netlink request, and only fall back to
+	 * one sysfs write per option if the kernel doesn't support it. */
+	for (option = master_options; option->name; option++) {
+		guint32 uval = option_get_value (s, option);
+
+		if (nm_streq (option->sysname, "stp_state"))
+			change.stp_state = uval;
+		else if (nm_streq (option->sysname, "priority"))
+			change.priority = uval;
+		else if (nm_streq (option->sysname, "forward_delay"))
+			change.forward_delay = uval;
+		else if (nm_streq (option->sysname, "hello_time"))
+			change.hello_time = uval;
+		else if (nm_streq (option->sysname, "max_age"))
+			change.max_age = uval;
+		else if (nm_streq (option->sysname, "ageing_time"))
+			change.ageing_time = uval;
+		else if (nm_streq (option->sysname, "multicast_snooping"))
+			change.mcast_snooping = !!uval;
+		else
+			g_assert_not_reached ();
+	}
+	if (nm_platform_link_bridge_change (NM_PLATFORM_GET, nm_device_get_ifindex (device), &change))
+		return;
 
 	for (option = master_options; option->name; option++)
 		commit_option (device, s, option, FALSE);
@@ -213,14 +246,29 @@ commit_slave_options (NMDevice *device, NMSettingBridgePort *setting)
 {
 	const Option *option;
 	NMSetting *s, *s_clear = NULL;
+	NMPlatformBridgePortChange change = { 0 };
 
 	if (setting)
 		s = NM_SETTING (setting);
 	else
 		s = s_clear = nm_setting_bridge_port_new ();
 
-	for (option = slave_options; option->name; option++)
-		commit_option (device, s, option, TRUE);
+	for (option = slave_options; option->name; option++) {
+		guint32 uval = option_get_value (s, option);
+
+		if (nm_streq (option->sysname, "priority"))
+			change.priority = uval;
+		else if (nm_streq (option->sysname, "path_cost"))
+			change.path_cost = uval;
+		else if (nm_streq (option->sysname, "hairpin_mode"))
+			change.hairpin_mode = !!uval;
+		else
+			g_assert_not_reached ();
+	}
+	if (!nm_platform_link_bridge_port_change (NM_PLATFORM_GET, nm_device_get_ifindex (device), &change)) {
+		for (option = slave_options; option->name; option++)
+			commit_option (device, s, option, TRUE);
+	}
 
 	g_clear_object (&s_clear);
 }
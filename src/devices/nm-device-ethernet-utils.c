@@ -27,22 +27,26 @@
 char *
 nm_device_ethernet_utils_get_default_wired_name (NMConnection *const *connections)
 {
+	gs_unref_hashtable GHashTable *ids = NULL;
 	char *temp;
 	guint j;
 	int i;
 
+	/* index the IDs once instead of scanning all connections per name */
+	ids = g_hash_table_new (g_str_hash, g_str_equal);
+	for (j = 0; connections[j]; j++) {
+		const char *id = nm_connection_get_id (connections[j]);
+
+		if (id)
+			g_hash_table_add (ids, (gpointer) id);
+	}
+
 	/* Find the next available unique connection name */
 	for (i = 1; i <= 10000; i++) {
 		temp = g_strdup_printf (_("Wired connection %d"), i);
-		for (j = 0; connections[j]; j++) {
-			if (nm_streq0 (nm_connection_get_id (connections[j]), temp)) {
-				g_free (temp);
-				goto next;
-			}
-		}
-		return temp;
-next:
-		;
+		if (!g_hash_table_contains (ids, temp))
+			return temp;
+		g_free (temp);
 	}
 
 	return NULL;
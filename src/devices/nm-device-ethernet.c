@@ -400,7 +400,8 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 		return FALSE;
 
 	if (s_wired) {
-		const char *mac, *perm_hw_addr;
+		const char *mac;
+		const NMHwAddr *perm_hw_addr;
 		gboolean try_mac = TRUE;
 		const char * const *mac_blacklist;
 		int i;
@@ -408,10 +409,12 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 		if (!match_subchans (self, s_wired, &try_mac))
 			return FALSE;
 
-		perm_hw_addr = nm_device_get_permanent_hw_address (device);
+		perm_hw_addr = nm_device_get_permanent_hw_address_bin (device);
 		mac = nm_setting_wired_get_mac_address (s_wired);
 		if (perm_hw_addr) {
-			if (try_mac && mac && !nm_utils_hwaddr_matches (mac, -1, perm_hw_addr, -1))
+			if (   try_mac
+			    && mac
+			    && !_nm_hwaddr_equal (_nm_setting_wired_get_mac_address_bin (s_wired), perm_hw_addr))
 				return FALSE;
 
 			/* Check for MAC address blacklist */
@@ -422,7 +425,7 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 					return FALSE;
 				}
 
-				if (nm_utils_hwaddr_matches (mac_blacklist[i], -1, perm_hw_addr, -1))
+				if (_nm_hwaddr_matches_str (perm_hw_addr, mac_blacklist[i]))
 					return FALSE;
 			}
 		} else if (mac)
@@ -1198,6 +1201,143 @@ found:
 
 /****************************************************************/
 
+static void
+ethtool_apply (NMDevice *device)
+{
+	NMDeviceEthernet *self = NM_DEVICE_ETHERNET (device);
+	NMPlatform *platform = NM_PLATFORM_GET;
+	const char *iface = nm_device_get_iface (device);
+	NMSettingEthtool *s_ethtool;
+	NMPlatformEthtoolRing ring;
+	NMPlatformEthtoolCoalesce coalesce;
+	gboolean success;
+	guint i;
+	int v;
+	struct {
+		NMPlatformEthtoolFeature feature;
+		int value;
+	} features[4];
+
+	s_ethtool = (NMSettingEthtool *) nm_device_get_applied_setting (device, NM_TYPE_SETTING_ETHTOOL);
+	if (!s_ethtool)
+		return;
+
+	features[0].feature = NM_PLATFORM_ETHTOOL_FEATURE_GRO;
+	features[0].value = nm_setting_ethtool_get_feature_gro (s_ethtool);
+	features[1].feature = NM_PLATFORM_ETHTOOL_FEATURE_GSO;
+	features[1].value = nm_setting_ethtool_get_feature_gso (s_ethtool);
+	features[2].feature = NM_PLATFORM_ETHTOOL_FEATURE_TSO;
+	features[2].value = nm_setting_ethtool_get_feature_tso (s_ethtool);
+	features[3].feature = NM_PLATFORM_ETHTOOL_FEATURE_LRO;
+	features[3].value = nm_setting_ethtool_get_feature_lro (s_ethtool);
+	for (i = 0; i < G_N_ELEMENTS (features); i++) {
+		if (features[i].value == -1)
+			continue;
+		if (!nm_platform_ethtool_set_feature (platform, iface, features[i].feature, features[i].value))
+			_LOGW (LOGD_HW, "ethtool: failed to set offload feature %d", (int) features[i].feature);
+	}
+
+	if (   nm_setting_ethtool_get_ring_rx (s_ethtool)
+	    || nm_setting_ethtool_get_ring_rx_mini (s_ethtool)
+	    || nm_setting_ethtool_get_ring_rx_jumbo (s_ethtool)
+	    || nm_setting_ethtool_get_ring_tx (s_ethtool)) {
+		success = nm_platform_ethtool_get_ring (platform, iface, &ring);
+		if (success) {
+			if (nm_setting_ethtool_get_ring_rx (s_ethtool))
+				ring.rx = nm_setting_ethtool_get_ring_rx (s_ethtool);
+			if (nm_setting_ethtool_get_ring_rx_mini (s_ethtool))
+				ring.rx_mini = nm_setting_ethtool_get_ring_rx_mini (s_ethtool);
+			if (nm_setting_ethtool_get_ring_rx_jumbo (s_ethtool))
+				ring.rx_jumbo = nm_setting_ethtool_get_ring_rx_jumbo (s_ethtool);
+			if (nm_setting_ethtool_get_ring_tx (s_ethtool))
+				ring.tx = nm_setting_ethtool_get_ring_tx (s_ethtool);
+			success = nm_platform_ethtool_set_ring (platform, iface, &ring);
+		}
+		if (!success)
+			_LOGW (LOGD_HW, "ethtool: failed to set the ring sizes");
+	}
+
+	if (   nm_setting_ethtool_get_coalesce_rx_usecs (s_ethtool) != -1
+	    || nm_setting_ethtool_get_coalesce_rx_frames (s_ethtool) != -1
+	    || nm_setting_ethtool_get_coalesce_tx_usecs (s_ethtool) != -1
+	    || nm_setting_ethtool_get_coalesce_tx_frames (s_ethtool) != -1
+	    || nm_setting_ethtool_get_coalesce_adaptive_rx (s_ethtool) != -1
+	    || nm_setting_ethtool_get_coalesce_adaptive_tx (s_ethtool) != -1) {
+		success = nm_platform_ethtool_get_coalesce (platform, iface, &coalesce);
+		if (success) {
+			if ((v = nm_setting_ethtool_get_coalesce_rx_usecs (s_ethtool)) != -1)
+				coalesce.rx_usecs = v;
+			if ((v = nm_setting_ethtool_get_coalesce_rx_frames (s_ethtool)) != -1)
+				coalesce.rx_frames = v;
+			if ((v = nm_setting_ethtool_get_coalesce_tx_usecs (s_ethtool)) != -1)
+				coalesce.tx_usecs = v;
+			if ((v = nm_setting_ethtool_get_coalesce_tx_frames (s_ethtool)) != -1)
+				coalesce.tx_frames = v;
+			if ((v = nm_setting_ethtool_get_coalesce_adaptive_rx (s_ethtool)) != -1)
+				coalesce.adaptive_rx = v;
+			if ((v = nm_setting_ethtool_get_coalesce_adaptive_tx (s_ethtool)) != -1)
+				coalesce.adaptive_tx = v;
+			success = nm_platform_ethtool_set_coalesce (platform, iface, &coalesce);
+		}
+		if (!success)
+			_LOGW (LOGD_HW, "ethtool: failed to set the interrupt coalescing");
+	}
+}
+
+/* Records the current offload, ring and coalescing settings of the
+ * device in the generated connection. The properties are not inferrable,
+ * so they don't affect which profile gets assumed. */
+static void
+ethtool_update_connection (NMDevice *device, NMConnection *connection)
+{
+	NMPlatform *platform = NM_PLATFORM_GET;
+	const char *iface = nm_device_get_iface (device);
+	NMSetting *s_ethtool;
+	NMPlatformEthtoolRing ring;
+	NMPlatformEthtoolCoalesce coalesce;
+	gboolean enabled;
+
+	if (nm_connection_get_setting_ethtool (connection))
+		return;
+
+	s_ethtool = nm_setting_ethtool_new ();
+
+#define _set_feature(feature, prop) \
+	G_STMT_START { \
+		if (nm_platform_ethtool_get_feature (platform, iface, feature, &enabled)) \
+			g_object_set (s_ethtool, prop, enabled ? 1 : 0, NULL); \
+	} G_STMT_END
+	_set_feature (NM_PLATFORM_ETHTOOL_FEATURE_GRO, NM_SETTING_ETHTOOL_FEATURE_GRO);
+	_set_feature (NM_PLATFORM_ETHTOOL_FEATURE_GSO, NM_SETTING_ETHTOOL_FEATURE_GSO);
+	_set_feature (NM_PLATFORM_ETHTOOL_FEATURE_TSO, NM_SETTING_ETHTOOL_FEATURE_TSO);
+	_set_feature (NM_PLATFORM_ETHTOOL_FEATURE_LRO, NM_SETTING_ETHTOOL_FEATURE_LRO);
+#undef _set_feature
+
+	if (nm_platform_ethtool_get_ring (platform, iface, &ring)) {
+		g_object_set (s_ethtool,
+		              NM_SETTING_ETHTOOL_RING_RX, (guint) ring.rx,
+		              NM_SETTING_ETHTOOL_RING_RX_MINI, (guint) ring.rx_mini,
+		              NM_SETTING_ETHTOOL_RING_RX_JUMBO, (guint) ring.rx_jumbo,
+		              NM_SETTING_ETHTOOL_RING_TX, (guint) ring.tx,
+		              NULL);
+	}
+
+	if (nm_platform_ethtool_get_coalesce (platform, iface, &coalesce)) {
+		g_object_set (s_ethtool,
+		              NM_SETTING_ETHTOOL_COALESCE_RX_USECS, (int) MIN (coalesce.rx_usecs, G_MAXINT32),
+		              NM_SETTING_ETHTOOL_COALESCE_RX_FRAMES, (int) MIN (coalesce.rx_frames, G_MAXINT32),
+		              NM_SETTING_ETHTOOL_COALESCE_TX_USECS, (int) MIN (coalesce.tx_usecs, G_MAXINT32),
+		              NM_SETTING_ETHTOOL_COALESCE_TX_FRAMES, (int) MIN (coalesce.tx_frames, G_MAXINT32),
+		              NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_RX, coalesce.adaptive_rx ? 1 : 0,
+		              NM_SETTING_ETHTOOL_COALESCE_ADAPTIVE_TX, coalesce.adaptive_tx ? 1 : 0,
+		              NULL);
+	}
+
+	nm_connection_add_setting (connection, s_ethtool);
+}
+
+/****************************************************************/
+
 static NMActStageReturn
 act_stage2_config (NMDevice *device, NMDeviceStateReason *reason)
 {
@@ -1233,6 +1373,7 @@ act_stage2_config (NMDevice *device, NMDeviceStateReason *reason)
 	}
 
 	wake_on_lan_enable (device);
+	ethtool_apply (device);
 
 	/* DCB and FCoE setup */
 	s_dcb = (NMSettingDcb *) nm_device_get_applied_setting (device, NM_TYPE_SETTING_DCB);
@@ -1501,6 +1642,12 @@ spec_match_list (NMDevice *device, const GSList *specs)
 	return matched;
 }
 
+static const char *
+get_s390_subchannels (NMDevice *device)
+{
+	return NM_DEVICE_ETHERNET_GET_PRIVATE (device)->subchannels;
+}
+
 static void
 update_connection (NMDevice *device, NMConnection *connection)
 {
@@ -1548,6 +1695,7 @@ update_connection (NMDevice *device, NMConnection *connection)
 		nm_setting_wired_add_s390_option (s_wired, (const char *) key, (const char *) value);
 	}
 
+	ethtool_update_connection (device, connection);
 }
 
 static void
@@ -1718,6 +1866,7 @@ nm_device_ethernet_class_init (NMDeviceEthernetClass *klass)
 	parent_class->ip4_config_pre_commit = ip4_config_pre_commit;
 	parent_class->deactivate = deactivate;
 	parent_class->spec_match_list = spec_match_list;
+	parent_class->get_s390_subchannels = get_s390_subchannels;
 	parent_class->update_connection = update_connection;
 	parent_class->carrier_changed = carrier_changed;
 	parent_class->link_changed = link_changed;
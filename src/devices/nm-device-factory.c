@@ -28,6 +28,8 @@
 #include "nm-device-factory.h"
 #include "nm-platform.h"
 #include "nm-utils.h"
+#include "nm-core-internal.h"
+#include "nm-config.h"
 
 const NMLinkType _nm_device_factory_no_default_links[] = { NM_LINK_TYPE_NONE };
 const char *_nm_device_factory_no_default_settings[] = { NULL };
@@ -240,6 +242,15 @@ static GSList *internal_types = NULL;
 static GHashTable *factories_by_link = NULL;
 static GHashTable *factories_by_setting = NULL;
 
+/* Plugins that are not loaded until a link or connection of their type
+ * shows up, see _load_plugin_on_demand(). */
+static GSList *pending_plugins = NULL;
+static NMDeviceFactoryManagerFactoryFunc factory_added_func = NULL;
+static gpointer factory_added_data = NULL;
+
+static gboolean _load_pending_plugin (const NMLinkType *needle_link_types,
+                                      const char **needle_setting_types);
+
 void
 _nm_device_factory_internal_register_type (GType factory_type)
 {
@@ -253,11 +264,13 @@ _cleanup (void)
 	g_clear_pointer (&internal_types, g_slist_free);
 	g_clear_pointer (&factories_by_link, g_hash_table_unref);
 	g_clear_pointer (&factories_by_setting, g_hash_table_unref);
+	g_slist_free_full (pending_plugins, g_free);
+	pending_plugins = NULL;
 }
 
 static NMDeviceFactory *
-find_factory (const NMLinkType *needle_link_types,
-              const char **needle_setting_types)
+find_loaded_factory (const NMLinkType *needle_link_types,
+                     const char **needle_setting_types)
 {
 	NMDeviceFactory *found;
 	guint i;
@@ -282,6 +295,19 @@ find_factory (const NMLinkType *needle_link_types,
 	return NULL;
 }
 
+static NMDeviceFactory *
+find_factory (const NMLinkType *needle_link_types,
+              const char **needle_setting_types)
+{
+	NMDeviceFactory *found;
+
+	found = find_loaded_factory (needle_link_types, needle_setting_types);
+	if (   !found
+	    && _load_pending_plugin (needle_link_types, needle_setting_types))
+		found = find_loaded_factory (needle_link_types, needle_setting_types);
+	return found;
+}
+
 NMDeviceFactory *
 nm_device_factory_manager_find_factory_for_link_type (NMLinkType link_type)
 {
@@ -441,7 +467,7 @@ _add_factory (NMDeviceFactory *factory,
 
 	nm_device_factory_get_supported_types (factory, &link_types, &setting_types);
 	if (check_duplicates) {
-		found = find_factory (link_types, setting_types);
+		found = find_loaded_factory (link_types, setting_types);
 		if (found) {
 			nm_log_warn (LOGD_HW, "Loading device plugin failed: multiple plugins "
 			             "for same type (using '%s' instead of '%s')",
@@ -463,13 +489,174 @@ _add_factory (NMDeviceFactory *factory,
 	return TRUE;
 }
 
+/* The types of the plugins that are built with NetworkManager. A plugin
+ * named here can be loaded on demand, when the first link or connection of
+ * one of these types appears. The factory still registers the types it
+ * actually supports once loaded. */
+typedef struct {
+	const char *name;
+	NMLinkType link_types[3];
+	const char *setting_types[3];
+} PluginTypes;
+
+static const PluginTypes plugin_types[] = {
+	{ "adsl",      { NM_LINK_TYPE_NONE },
+	               { NM_SETTING_ADSL_SETTING_NAME } },
+	{ "bluetooth", { NM_LINK_TYPE_BNEP, NM_LINK_TYPE_NONE },
+	               { NM_SETTING_BLUETOOTH_SETTING_NAME } },
+	{ "team",      { NM_LINK_TYPE_TEAM, NM_LINK_TYPE_NONE },
+	               { NM_SETTING_TEAM_SETTING_NAME } },
+	{ "wifi",      { NM_LINK_TYPE_WIFI, NM_LINK_TYPE_OLPC_MESH, NM_LINK_TYPE_NONE },
+	               { NM_SETTING_WIRELESS_SETTING_NAME, NM_SETTING_OLPC_MESH_SETTING_NAME } },
+	{ "wwan",      { NM_LINK_TYPE_WWAN_ETHERNET, NM_LINK_TYPE_NONE },
+	               { NM_SETTING_GSM_SETTING_NAME, NM_SETTING_CDMA_SETTING_NAME } },
+};
+
+/* Devices of these plugins only appear as links, so loading them late
+ * changes nothing. The others find their devices by themselves (modems,
+ * paired phones, ATM cards) and are only loaded on demand when configured. */
+#define PLUGINS_ON_DEMAND_DEFAULT "team,wifi"
+
+static const PluginTypes *
+_plugin_types_find (const char *path)
+{
+	gs_free char *name = NULL;
+	const char *base;
+	char *dot;
+	guint i;
+
+	base = strrchr (path, '/');
+	base = base ? base + 1 : path;
+	if (!g_str_has_prefix (base, PLUGIN_PREFIX))
+		return NULL;
+
+	name = g_strdup (&base[NM_STRLEN (PLUGIN_PREFIX)]);
+	dot = strchr (name, '.');
+	if (dot)
+		*dot = '\0';
+
+	for (i = 0; i < G_N_ELEMENTS (plugin_types); i++) {
+		if (nm_streq (plugin_types[i].name, name))
+			return &plugin_types[i];
+	}
+	return NULL;
+}
+
+static gboolean
+_plugin_is_on_demand (const PluginTypes *types)
+{
+	gs_strfreev char **names = NULL;
+	const char *value;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_DEVICE_PLUGINS_ON_DEMAND,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	names = _nm_utils_strsplit_set (value ? value : PLUGINS_ON_DEMAND_DEFAULT, ", \t", 0);
+	return _nm_utils_strv_find_first (names, -1, types->name) >= 0;
+}
+
+static gboolean
+_plugin_types_match (const PluginTypes *types,
+                     const NMLinkType *needle_link_types,
+                     const char **needle_setting_types)
+{
+	guint i, j;
+
+	for (i = 0; needle_link_types && needle_link_types[i] > NM_LINK_TYPE_UNKNOWN; i++) {
+		for (j = 0; types->link_types[j] > NM_LINK_TYPE_UNKNOWN; j++) {
+			if (types->link_types[j] == needle_link_types[i])
+				return TRUE;
+		}
+	}
+	for (i = 0; needle_setting_types && needle_setting_types[i]; i++) {
+		for (j = 0; types->setting_types[j]; j++) {
+			if (nm_streq (types->setting_types[j], needle_setting_types[i]))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static NMDeviceFactory *
+_load_plugin (const char *path)
+{
+	GModule *plugin;
+	NMDeviceFactoryCreateFunc create_func;
+	NMDeviceFactory *factory;
+	GError *error = NULL;
+	const char *item;
+	gboolean added;
+
+	item = strrchr (path, '/');
+	g_assert (item);
+
+	plugin = g_module_open (path, G_MODULE_BIND_LOCAL);
+
+	if (!plugin) {
+		nm_log_warn (LOGD_HW, "(%s): failed to load plugin: %s", item, g_module_error ());
+		return NULL;
+	}
+
+	if (!g_module_symbol (plugin, "nm_device_factory_create", (gpointer) &create_func)) {
+		nm_log_warn (LOGD_HW, "(%s): failed to find device factory creator: %s", item, g_module_error ());
+		g_module_close (plugin);
+		return NULL;
+	}
+
+	/* after loading glib types from the plugin, we cannot unload the library anymore.
+	 * Make it resident. */
+	g_module_make_resident (plugin);
+
+	factory = create_func (&error);
+	if (!factory) {
+		nm_log_warn (LOGD_HW, "(%s): failed to initialize device factory: %s",
+		             item, NM_G_ERROR_MSG (error));
+		g_clear_error (&error);
+		return NULL;
+	}
+	g_clear_error (&error);
+
+	added = _add_factory (factory, TRUE, g_module_name (plugin), factory_added_func, factory_added_data);
+
+	g_object_unref (factory);
+	return added ? factory : NULL;
+}
+
+static gboolean
+_load_pending_plugin (const NMLinkType *needle_link_types,
+                      const char **needle_setting_types)
+{
+	GSList *iter;
+
+	for (iter = pending_plugins; iter; iter = iter->next) {
+		char *path = iter->data;
+		NMDeviceFactory *factory;
+
+		if (!_plugin_types_match (_plugin_types_find (path), needle_link_types, needle_setting_types))
+			continue;
+
+		pending_plugins = g_slist_delete_link (pending_plugins, iter);
+
+		nm_log_dbg (LOGD_HW, "device plugin: load %s on demand", path);
+		factory = _load_plugin (path);
+		g_free (path);
+		if (!factory)
+			return FALSE;
+
+		/* the factories loaded at startup are started by the manager */
+		nm_device_factory_start (factory);
+		return TRUE;
+	}
+	return FALSE;
+}
+
 void
 nm_device_factory_manager_load_factories (NMDeviceFactoryManagerFactoryFunc callback,
                                           gpointer user_data)
 {
 	NMDeviceFactory *factory;
 	const GSList *iter;
-	GError *error = NULL;
 	char **path, **paths;
 
 	g_return_if_fail (factories_by_link == NULL);
@@ -478,6 +665,9 @@ nm_device_factory_manager_load_factories (NMDeviceFactoryManagerFactoryFunc call
 	factories_by_link = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
 	factories_by_setting = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
 
+	factory_added_func = callback;
+	factory_added_data = user_data;
+
 	/* Register internal factories first */
 	for (iter = internal_types; iter; iter = iter->next) {
 		GType ftype = (GType) GPOINTER_TO_SIZE (iter->data);
@@ -492,43 +682,18 @@ nm_device_factory_manager_load_factories (NMDeviceFactoryManagerFactoryFunc call
 		return;
 
 	for (path = paths; *path; path++) {
-		GModule *plugin;
-		NMDeviceFactoryCreateFunc create_func;
-		const char *item;
-
-		item = strrchr (*path, '/');
-		g_assert (item);
+		const PluginTypes *types;
 
-		plugin = g_module_open (*path, G_MODULE_BIND_LOCAL);
-
-		if (!plugin) {
-			nm_log_warn (LOGD_HW, "(%s): failed to load plugin: %s", item, g_module_error ());
-			continue;
-		}
-
-		if (!g_module_symbol (plugin, "nm_device_factory_create", (gpointer) &create_func)) {
-			nm_log_warn (LOGD_HW, "(%s): failed to find device factory creator: %s", item, g_module_error ());
-			g_module_close (plugin);
+		types = _plugin_types_find (*path);
+		if (types && _plugin_is_on_demand (types)) {
+			nm_log_dbg (LOGD_HW, "device plugin: defer loading %s until needed", *path);
+			pending_plugins = g_slist_append (pending_plugins, *path);
 			continue;
 		}
 
-		/* after loading glib types from the plugin, we cannot unload the library anymore.
-		 * Make it resident. */
-		g_module_make_resident (plugin);
-
-		factory = create_func (&error);
-		if (!factory) {
-			nm_log_warn (LOGD_HW, "(%s): failed to initialize device factory: %s",
-			             item, NM_G_ERROR_MSG (error));
-			g_clear_error (&error);
-			continue;
-		}
-		g_clear_error (&error);
-
-		_add_factory (factory, TRUE, g_module_name (plugin), callback, user_data);
-
-		g_object_unref (factory);
+		_load_plugin (*path);
+		g_free (*path);
 	}
-	g_strfreev (paths);
+	/* the paths of the pending plugins are owned by pending_plugins */
+	g_free (paths);
 }
-
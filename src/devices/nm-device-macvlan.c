@@ -209,16 +209,13 @@ link_changed (NMDevice *device, NMPlatformLink *info)
 }
 
 static gboolean
-create_and_realize (NMDevice *device,
-                    NMConnection *connection,
-                    NMDevice *parent,
-                    const NMPlatformLink **out_plink,
-                    GError **error)
+create_link_request (NMDevice *device,
+                     NMConnection *connection,
+                     NMDevice *parent,
+                     NMPlatformLinkAddRequest *request,
+                     GError **error)
 {
-	const char *iface = nm_device_get_iface (device);
-	NMPlatformError plerr;
 	NMSettingMacvlan *s_macvlan;
-	NMPlatformLnkMacvlan lnk = { };
 	int parent_ifindex;
 
 	s_macvlan = nm_connection_get_setting_macvlan (connection);
@@ -233,23 +230,43 @@ create_and_realize (NMDevice *device,
 	parent_ifindex = nm_device_get_ifindex (parent);
 	g_warn_if_fail (parent_ifindex > 0);
 
-	lnk.mode = setting_mode_to_platform (nm_setting_macvlan_get_mode (s_macvlan));
-	if (!lnk.mode) {
+	memset (&request->macvlan, 0, sizeof (request->macvlan));
+	request->macvlan.mode = setting_mode_to_platform (nm_setting_macvlan_get_mode (s_macvlan));
+	if (!request->macvlan.mode) {
 		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
 		             "unsupported MACVLAN mode %u in connection %s",
 		             nm_setting_macvlan_get_mode (s_macvlan),
 		             nm_connection_get_uuid (connection));
 		return FALSE;
 	}
-	lnk.no_promisc = !nm_setting_macvlan_get_promiscuous (s_macvlan);
-	lnk.tap = nm_setting_macvlan_get_tap (s_macvlan);
+	request->macvlan.no_promisc = !nm_setting_macvlan_get_promiscuous (s_macvlan);
+	request->macvlan.tap = nm_setting_macvlan_get_tap (s_macvlan);
+
+	request->type = request->macvlan.tap ? NM_LINK_TYPE_MACVTAP : NM_LINK_TYPE_MACVLAN;
+	request->name = nm_device_get_iface (device);
+	request->parent = parent_ifindex;
+	return TRUE;
+}
+
+static gboolean
+create_and_realize (NMDevice *device,
+                    NMConnection *connection,
+                    NMDevice *parent,
+                    const NMPlatformLink **out_plink,
+                    GError **error)
+{
+	NMPlatformLinkAddRequest request = { 0 };
+	NMPlatformError plerr;
+
+	if (!create_link_request (device, connection, parent, &request, error))
+		return FALSE;
 
-	plerr = nm_platform_link_macvlan_add (NM_PLATFORM_GET, iface, parent_ifindex, &lnk, out_plink);
+	plerr = nm_platform_link_macvlan_add (NM_PLATFORM_GET, request.name, request.parent, &request.macvlan, out_plink);
 	if (plerr != NM_PLATFORM_ERROR_SUCCESS) {
 		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_CREATION_FAILED,
 		             "Failed to create %s interface '%s' for '%s': %s",
-		             lnk.tap ? "macvtap" : "macvlan",
-		             iface,
+		             request.macvlan.tap ? "macvtap" : "macvlan",
+		             request.name,
 		             nm_connection_get_id (connection),
 		             nm_platform_error_to_string (plerr));
 		return FALSE;
@@ -639,6 +656,7 @@ nm_device_macvlan_class_init (NMDeviceMacvlanClass *klass)
 	device_class->complete_connection = complete_connection;
 	device_class->connection_type = NM_SETTING_MACVLAN_SETTING_NAME;
 	device_class->create_and_realize = create_and_realize;
+	device_class->create_link_request = create_link_request;
 	device_class->deactivate = deactivate;
 	device_class->get_generic_capabilities = get_generic_capabilities;
 	device_class->ip4_config_pre_commit = ip4_config_pre_commit;
@@ -207,18 +207,14 @@ realize_start_notify (NMDevice *device, const NMPlatformLink *plink)
 }
 
 static gboolean
-create_and_realize (NMDevice *device,
-                    NMConnection *connection,
-                    NMDevice *parent,
-                    const NMPlatformLink **out_plink,
-                    GError **error)
+create_link_request (NMDevice *device,
+                     NMConnection *connection,
+                     NMDevice *parent,
+                     NMPlatformLinkAddRequest *request,
+                     GError **error)
 {
-	NMDeviceVlanPrivate *priv = NM_DEVICE_VLAN_GET_PRIVATE (device);
-	const char *iface = nm_device_get_iface (device);
 	NMSettingVlan *s_vlan;
 	int parent_ifindex;
-	guint vlan_id;
-	NMPlatformError plerr;
 
 	s_vlan = nm_connection_get_setting_vlan (connection);
 	g_assert (s_vlan);
@@ -240,30 +236,61 @@ create_and_realize (NMDevice *device,
 	parent_ifindex = nm_device_get_ifindex (parent);
 	g_warn_if_fail (parent_ifindex > 0);
 
-	vlan_id = nm_setting_vlan_get_id (s_vlan);
+	request->type = NM_LINK_TYPE_VLAN;
+	request->name = nm_device_get_iface (device);
+	request->parent = parent_ifindex;
+	request->vlan.id = nm_setting_vlan_get_id (s_vlan);
+	request->vlan.flags = nm_setting_vlan_get_flags (s_vlan);
+	return TRUE;
+}
+
+static void
+create_link_finish (NMDevice *device,
+                    NMConnection *connection,
+                    NMDevice *parent)
+{
+	NMDeviceVlanPrivate *priv = NM_DEVICE_VLAN_GET_PRIVATE (device);
+	guint vlan_id;
+
+	vlan_id = nm_setting_vlan_get_id (nm_connection_get_setting_vlan (connection));
+
+	g_warn_if_fail (priv->parent == NULL);
+	nm_device_vlan_set_parent (NM_DEVICE_VLAN (device), parent);
+	if (vlan_id != priv->vlan_id) {
+		priv->vlan_id = vlan_id;
+		g_object_notify ((GObject *) device, NM_DEVICE_VLAN_ID);
+	}
+}
+
+static gboolean
+create_and_realize (NMDevice *device,
+                    NMConnection *connection,
+                    NMDevice *parent,
+                    const NMPlatformLink **out_plink,
+                    GError **error)
+{
+	NMPlatformLinkAddRequest request = { 0 };
+	NMPlatformError plerr;
+
+	if (!create_link_request (device, connection, parent, &request, error))
+		return FALSE;
 
 	plerr = nm_platform_link_vlan_add (NM_PLATFORM_GET,
-	                                   iface,
-	                                   parent_ifindex,
-	                                   vlan_id,
-	                                   nm_setting_vlan_get_flags (s_vlan),
+	                                   request.name,
+	                                   request.parent,
+	                                   request.vlan.id,
+	                                   request.vlan.flags,
 	                                   out_plink);
 	if (plerr != NM_PLATFORM_ERROR_SUCCESS) {
 		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_CREATION_FAILED,
 		             "Failed to create VLAN interface '%s' for '%s': %s",
-		             iface,
+		             request.name,
 		             nm_connection_get_id (connection),
 		             nm_platform_error_to_string (plerr));
 		return FALSE;
 	}
 
-	g_warn_if_fail (priv->parent == NULL);
-	nm_device_vlan_set_parent (NM_DEVICE_VLAN (device), parent);
-	if (vlan_id != priv->vlan_id) {
-		priv->vlan_id = vlan_id;
-		g_object_notify ((GObject *) device, NM_DEVICE_VLAN_ID);
-	}
-
+	create_link_finish (device, connection, parent);
 	return TRUE;
 }
 
@@ -684,6 +711,8 @@ nm_device_vlan_class_init (NMDeviceVlanClass *klass)
 	object_class->dispose = dispose;
 
 	parent_class->create_and_realize = create_and_realize;
+	parent_class->create_link_request = create_link_request;
+	parent_class->create_link_finish = create_link_finish;
 	parent_class->realize_start_notify = realize_start_notify;
 	parent_class->unrealize_notify = unrealize_notify;
 	parent_class->get_generic_capabilities = get_generic_capabilities;
@@ -42,6 +42,8 @@
 #include "nm-platform.h"
 #include "nm-rdisc.h"
 #include "nm-lndp-rdisc.h"
+#include "nm-fake-platform.h"
+#include "nm-fake-rdisc.h"
 #include "nm-dhcp-manager.h"
 #include "nm-activation-request.h"
 #include "nm-ip4-config.h"
@@ -65,11 +67,17 @@
 #include "sd-ipv4ll.h"
 #include "nm-audit-manager.h"
 #include "nm-arping-manager.h"
+#include "nm-activation-scheduler.h"
+#include "nm-loop-sched.h"
+#include "nm-connectivity.h"
+#include "nm-statistics.h"
+#include "nm-probes.h"
 
 #include "nm-device-logging.h"
 _LOG_DECLARE_SELF (NMDevice);
 
 #include "nmdbus-device.h"
+#include "nmdbus-device-statistics.h"
 
 G_DEFINE_ABSTRACT_TYPE (NMDevice, nm_device, NM_TYPE_EXPORTED_OBJECT)
 
@@ -134,8 +142,17 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMDevice,
 	PROP_HAS_PENDING_ACTION,
 	PROP_METERED,
 	PROP_LLDP_NEIGHBORS,
+	PROP_CARRIER_FLAPS,
+	PROP_CARRIER_FLAPS_SUPPRESSED,
+	PROP_CONNECTIVITY,
+	PROP_CONNECTIVITY_LATENCY,
 	PROP_REAL,
 	PROP_SLAVES,
+	PROP_STATISTICS_REFRESH_RATE_MS,
+	PROP_STATISTICS_TX_BYTES,
+	PROP_STATISTICS_RX_BYTES,
+	PROP_STATISTICS_TX_PACKETS,
+	PROP_STATISTICS_RX_PACKETS,
 );
 
 #define DEFAULT_AUTOCONNECT TRUE
@@ -146,6 +163,15 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMDevice,
 #define PENDING_ACTION_DHCP6 "dhcp6"
 #define PENDING_ACTION_AUTOCONF6 "autoconf6"
 
+/* sources that changed since the last merge-and-apply, see
+ * ip_config_merge_and_apply_schedule(). */
+typedef enum {
+	IP_CONFIG_DIRTY_NONE    = 0,
+	IP_CONFIG_DIRTY_LINK_UP = (1LL << 0),
+	IP_CONFIG_DIRTY_VPN     = (1LL << 1),
+	IP_CONFIG_DIRTY_WWAN    = (1LL << 2),
+} IPConfigDirtyFlags;
+
 #define DHCP_RESTART_TIMEOUT   120
 #define DHCP_NUM_TRIES_MAX     3
 
@@ -176,6 +202,36 @@ typedef struct {
 	guint id;
 } QueuedState;
 
+/* more route changes than that and the external configuration
+ * is captured anew instead of updated. */
+#define EXT_ROUTE_CHANGES_MAX 256
+
+typedef struct {
+	NMPlatformSignalChangeType change_type;
+	NMPlatformIPXRoute route;
+} ExtRouteChange;
+
+/* the same for the IPv6 temporary addresses */
+#define EXT_TEMP_ADDRESS_CHANGES_MAX 64
+
+typedef struct {
+	NMPlatformSignalChangeType change_type;
+	NMPlatformIP6Address address;
+} ExtTempAddressChange;
+
+/* The platform changes since the external configuration was computed,
+ * see update_ip4_config(). Only route changes and, for IPv6, changes of
+ * temporary addresses are applied incrementally. */
+typedef struct {
+	GArray *route_changes;
+	GArray *temp_address_changes;
+	/* the platform changed in a way that requires a new capture */
+	bool recapture;
+	/* the internal configurations were changed, ext_ipX_config must be
+	 * subtracted anew */
+	bool internal_changed;
+} ExtIPConfigUpdate;
+
 typedef struct {
 	NMDevice *slave;
 	gulong watch_id;
@@ -216,16 +272,27 @@ typedef struct _NMDevicePrivate {
 	NMDeviceState state;
 	NMDeviceStateReason state_reason;
 	QueuedState   queued_state;
+
+	/* monotonic timestamps (usec) of the last state change and of
+	 * entering PREPARE, for the activation statistics */
+	gint64        state_timestamp_us;
+	gint64        activation_timestamp_us;
 	guint queued_ip4_config_id;
 	guint queued_ip6_config_id;
+	struct {
+		guint               idle_id;
+		IPConfigDirtyFlags  v4;
+		IPConfigDirtyFlags  v6;
+	}             ip_config_dirty;
 	GSList *pending_actions;
 	GSList *dad6_failed_addrs;
 
 	char *        udi;
-	char *        iface;   /* may change, could be renamed by user */
+	/* interned, see nm_intern_str_ref() */
+	const char *  iface;   /* may change, could be renamed by user */
 	int           ifindex;
 	bool          real;
-	char *        ip_iface;
+	const char *  ip_iface;
 	int           ip_ifindex;
 	NMDeviceType  type;
 	char *        type_desc;
@@ -243,6 +310,9 @@ typedef struct _NMDevicePrivate {
 	guint         hw_addr_len;
 	char *        perm_hw_addr;
 	char *        initial_hw_addr;
+	/* hw_addr and perm_hw_addr in binary form, for comparisons */
+	NMHwAddr      hw_addr_bin;
+	NMHwAddr      perm_hw_addr_bin;
 	char *        physical_port_id;
 	guint         dev_id;
 
@@ -277,6 +347,16 @@ typedef struct _NMDevicePrivate {
 	guint           link_disconnected_id;
 	guint           carrier_defer_id;
 	bool            carrier;
+	struct {
+		gint32          last_loss;   /* monotonic timestamp in seconds */
+		guint           backoff;     /* exponent of the disconnect delay */
+		guint32         count;
+		guint32         suppressed;
+	}               carrier_flap;
+	struct {
+		NMConnectivityState state;
+		guint32         latency;     /* of the last successful probe, in msec */
+	}               connectivity;
 	guint           carrier_wait_id;
 	bool            ignore_carrier;
 	gulong          ignore_carrier_id;
@@ -293,6 +373,8 @@ typedef struct _NMDevicePrivate {
 	NMIP4Config *   con_ip4_config; /* config from the setting */
 	NMIP4Config *   dev_ip4_config; /* Config from DHCP, PPP, LLv4, etc */
 	NMIP4Config *   ext_ip4_config; /* Stuff added outside NM */
+	NMIP4Config *   ext_ip4_config_captured; /* Configuration captured from platform. */
+	ExtIPConfigUpdate ext_ip4_update;
 	NMIP4Config *   wwan_ip4_config; /* WWAN configuration */
 	GSList *        vpn4_configs;   /* VPNs which use this device */
 	struct {
@@ -314,6 +396,7 @@ typedef struct _NMDevicePrivate {
 		NMDhcp4Config * config;
 		guint           restart_id;
 		guint           num_tries_left;
+		char *          last_address;
 	} dhcp4;
 
 	PingInfo        gw_ping;
@@ -343,10 +426,13 @@ typedef struct _NMDevicePrivate {
 	NMIP6Config *  wwan_ip6_config;
 	NMIP6Config *  ext_ip6_config; /* Stuff added outside NM */
 	NMIP6Config *  ext_ip6_config_captured; /* Configuration captured from platform. */
+	ExtIPConfigUpdate ext_ip6_update;
 	GSList *       vpn6_configs;   /* VPNs which use this device */
 	bool           nm_ipv6ll; /* TRUE if NM handles the device's IPv6LL address */
 	guint32        ip6_mtu;
 	NMIP6Config *  dad6_ip6_config;
+	GHashTable *   dad6_pending;   /* addresses of dad6_ip6_config still tentative */
+	guint          ip6_addr_ready_id;
 
 	NMRDisc *      rdisc;
 	gulong         rdisc_changed_id;
@@ -357,6 +443,7 @@ typedef struct _NMDevicePrivate {
 
 	guint          linklocal6_timeout_id;
 	guint8         linklocal6_dad_counter;
+	bool           linklocal6_ready;
 
 	GHashTable *   ip6_saved_properties;
 
@@ -393,6 +480,12 @@ typedef struct _NMDevicePrivate {
 	NMLldpListener *lldp_listener;
 
 	guint check_delete_unrealized_id;
+
+	struct {
+		guint refresh_rate_ms;
+		guint subscription_id;
+		NMPlatformLinkStatistics counters;
+	} stats;
 } NMDevicePrivate;
 
 static gboolean nm_device_set_ip4_config (NMDevice *self,
@@ -415,6 +508,10 @@ static gboolean ip6_config_merge_and_apply (NMDevice *self,
                                             gboolean commit,
                                             NMDeviceStateReason *out_reason);
 
+static void ip_config_merge_and_apply_schedule (NMDevice *self,
+                                                int family,
+                                                IPConfigDirtyFlags dirty);
+
 static void nm_device_master_add_slave (NMDevice *self, NMDevice *slave, gboolean configure);
 static void nm_device_slave_notify_enslave (NMDevice *self, gboolean success);
 static void nm_device_slave_notify_release (NMDevice *self, NMDeviceStateReason reason);
@@ -441,8 +538,12 @@ static gboolean dhcp6_start (NMDevice *self, gboolean wait_for_ll, NMDeviceState
 static void nm_device_start_ip_check (NMDevice *self);
 static void realize_start_setup (NMDevice *self, const NMPlatformLink *plink);
 static void nm_device_set_mtu (NMDevice *self, guint32 mtu);
+static gboolean bring_up (NMDevice *self, gboolean *no_firmware);
+static gboolean take_down (NMDevice *self);
 
 static void dhcp_schedule_restart (NMDevice *self, int family, const char *reason);
+static void master_ip_config_retry (NMDevice *self);
+static void activation_scheduler_release_if_waiting (NMDevice *self);
 
 /***********************************************************/
 
@@ -590,6 +691,33 @@ nm_device_ipv6_sysctl_set (NMDevice *self, const char *property, const char *val
 	return nm_platform_sysctl_set (NM_PLATFORM_GET, nm_utils_ip6_property_path (nm_device_get_ip_iface (self), property), value);
 }
 
+/* Sets several IPv6 sysctls of the device with one platform call. The
+ * arguments are pairs of property name and value, terminated by %NULL. */
+static gboolean
+nm_device_ipv6_sysctl_set_many (NMDevice *self, const char *property, ...)
+{
+	NMPlatformSysctlSetEntry entries[8];
+	const char *ifname = nm_device_get_ip_iface (self);
+	gboolean success;
+	va_list ap;
+	guint i, n = 0;
+
+	va_start (ap, property);
+	for (; property; property = va_arg (ap, const char *)) {
+		g_assert (n < G_N_ELEMENTS (entries));
+		entries[n].path = g_strdup (nm_utils_ip6_property_path (ifname, property));
+		entries[n].value = va_arg (ap, const char *);
+		n++;
+	}
+	va_end (ap);
+
+	success = nm_platform_sysctl_set_many (NM_PLATFORM_GET, entries, n);
+
+	for (i = 0; i < n; i++)
+		g_free ((char *) entries[i].path);
+	return success;
+}
+
 static guint32
 nm_device_ipv6_sysctl_get_int32 (NMDevice *self, const char *property, gint32 fallback)
 {
@@ -696,18 +824,15 @@ void
 nm_device_set_ip_iface (NMDevice *self, const char *iface)
 {
 	NMDevicePrivate *priv;
-	char *old_ip_iface;
 
 	g_return_if_fail (NM_IS_DEVICE (self));
 
 	priv = NM_DEVICE_GET_PRIVATE (self);
-	if (!g_strcmp0 (iface, priv->ip_iface))
+	if (!nm_intern_str_set (&priv->ip_iface, iface))
 		return;
 
-	old_ip_iface = priv->ip_iface;
 	priv->ip_ifindex = 0;
 
-	priv->ip_iface = g_strdup (iface);
 	if (priv->ip_iface) {
 		priv->ip_ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, priv->ip_iface);
 		if (priv->ip_ifindex > 0) {
@@ -726,9 +851,7 @@ nm_device_set_ip_iface (NMDevice *self, const char *iface)
 	g_hash_table_remove_all (priv->ip6_saved_properties);
 
 	/* Emit change notification */
-	if (g_strcmp0 (old_ip_iface, priv->ip_iface))
-		_notify (self, PROP_IP_IFACE);
-	g_free (old_ip_iface);
+	_notify (self, PROP_IP_IFACE);
 }
 
 static gboolean
@@ -818,6 +941,100 @@ nm_device_get_metered (NMDevice *self)
 	return NM_DEVICE_GET_PRIVATE (self)->metered;
 }
 
+/**
+ * nm_device_set_connectivity:
+ * @self: the #NMDevice
+ * @state: the result of the connectivity probe of the device
+ * @latency_msec: the time the probe took, or 0 if it failed
+ *
+ * Updates the per-device connectivity properties. The probes are run
+ * by #NMManager.
+ */
+void
+nm_device_set_connectivity (NMDevice *self, NMConnectivityState state, guint latency_msec)
+{
+	NMDevicePrivate *priv;
+
+	g_return_if_fail (NM_IS_DEVICE (self));
+
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (priv->connectivity.state != state) {
+		_LOGD (LOGD_CONCHECK, "connectivity changed from %s to %s",
+		       nm_connectivity_state_to_string (priv->connectivity.state),
+		       nm_connectivity_state_to_string (state));
+		priv->connectivity.state = state;
+		_notify (self, PROP_CONNECTIVITY);
+	}
+	if (priv->connectivity.latency != latency_msec) {
+		priv->connectivity.latency = latency_msec;
+		_notify (self, PROP_CONNECTIVITY_LATENCY);
+	}
+}
+
+/*****************************************************************************/
+
+static void
+_stats_update_counters (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMPlatformLinkStatistics counters;
+	GObject *object = G_OBJECT (self);
+	int ifindex;
+
+	ifindex = nm_device_get_ip_ifindex (self);
+	if (   ifindex <= 0
+	    || !nm_platform_link_get_statistics (NM_PLATFORM_GET, ifindex, &counters))
+		return;
+
+	g_object_freeze_notify (object);
+	if (priv->stats.counters.tx_bytes != counters.tx_bytes)
+		_notify (self, PROP_STATISTICS_TX_BYTES);
+	if (priv->stats.counters.rx_bytes != counters.rx_bytes)
+		_notify (self, PROP_STATISTICS_RX_BYTES);
+	if (priv->stats.counters.tx_packets != counters.tx_packets)
+		_notify (self, PROP_STATISTICS_TX_PACKETS);
+	if (priv->stats.counters.rx_packets != counters.rx_packets)
+		_notify (self, PROP_STATISTICS_RX_PACKETS);
+	priv->stats.counters = counters;
+	g_object_thaw_notify (object);
+}
+
+static void
+_stats_refreshed_cb (NMPlatform *platform, gpointer user_data)
+{
+	_stats_update_counters (user_data);
+}
+
+/* The platform refreshes the counters of all links together. It calls
+ * us back no more often than every @refresh_rate_ms. */
+static void
+_stats_set_refresh_rate (NMDevice *self, guint refresh_rate_ms)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (priv->stats.refresh_rate_ms == refresh_rate_ms)
+		return;
+
+	_LOGD (LOGD_DEVICE, "statistics: refresh rate %u msec", refresh_rate_ms);
+	priv->stats.refresh_rate_ms = refresh_rate_ms;
+
+	if (priv->stats.subscription_id) {
+		nm_platform_link_statistics_unsubscribe (NM_PLATFORM_GET, priv->stats.subscription_id);
+		priv->stats.subscription_id = 0;
+	}
+
+	if (refresh_rate_ms) {
+		priv->stats.subscription_id = nm_platform_link_statistics_subscribe (NM_PLATFORM_GET,
+		                                                                     refresh_rate_ms,
+		                                                                     _stats_refreshed_cb,
+		                                                                     self);
+		_stats_update_counters (self);
+	}
+}
+
+/*****************************************************************************/
+
 /**
  * nm_device_get_priority():
  * @self: the #NMDevice
@@ -1247,13 +1464,8 @@ nm_device_master_enslave_slave (NMDevice *self, NMDevice *slave, NMConnection *c
 	 * after updating the hardware address as IP config may need the
 	 * new address.
 	 */
-	if (success) {
-		if (NM_DEVICE_GET_PRIVATE (self)->ip4_state == IP_WAIT)
-			nm_device_activate_stage3_ip4_start (self);
-
-		if (NM_DEVICE_GET_PRIVATE (self)->ip6_state == IP_WAIT)
-			nm_device_activate_stage3_ip6_start (self);
-	}
+	if (success)
+		master_ip_config_retry (self);
 
 	/* Since slave devices don't have their own IP configuration,
 	 * set the MTU here.
@@ -1417,8 +1629,12 @@ nm_device_update_dynamic_ip_setup (NMDevice *self)
 	if (priv->rdisc) {
 		/* FIXME: todo */
 	}
-	if (priv->dnsmasq_manager) {
-		/* FIXME: todo */
+	if (priv->dnsmasq_manager && priv->dnsmasq_state_id) {
+		/* Only restarts dnsmasq if its configuration changed */
+		if (!nm_dnsmasq_manager_start (priv->dnsmasq_manager, priv->ip4_config, &error)) {
+			_LOGW (LOGD_SHARING, "share: failed to update dnsmasq: %s", error->message);
+			g_clear_error (&error);
+		}
 	}
 
 	if (priv->lldp_listener && nm_lldp_listener_is_running (priv->lldp_listener)) {
@@ -1455,11 +1671,7 @@ carrier_changed (NMDevice *self, gboolean carrier)
 		if (!carrier)
 			return;
 
-		if (nm_device_activate_ip4_state_in_wait (self))
-			nm_device_activate_stage3_ip4_start (self);
-		if (nm_device_activate_ip6_state_in_wait (self))
-			nm_device_activate_stage3_ip6_start (self);
-
+		master_ip_config_retry (self);
 		return;
 	} else if (nm_device_get_enslaved (self) && !carrier) {
 		/* Slaves don't deactivate when they lose carrier; for
@@ -1500,6 +1712,12 @@ carrier_changed (NMDevice *self, gboolean carrier)
 
 #define LINK_DISCONNECT_DELAY 4
 
+/* Carrier losses less than this many seconds apart are considered
+ * flapping and increase the disconnect delay. */
+#define CARRIER_FLAP_INTERVAL 60
+#define CARRIER_FLAP_BACKOFF_MAX 10
+#define CARRIER_FLAP_MAX_DELAY_DEFAULT 32
+
 static gboolean
 link_disconnect_action_cb (gpointer user_data)
 {
@@ -1529,6 +1747,43 @@ link_disconnect_action_cancel (NMDevice *self)
 	}
 }
 
+static guint
+carrier_flap_get_max_delay (void)
+{
+	const char *value;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_CARRIER_FLAP_MAX_DELAY,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	return _nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXINT32,
+	                                     CARRIER_FLAP_MAX_DELAY_DEFAULT);
+}
+
+/* Account a carrier loss and return the number of seconds to wait
+ * before acting on it. */
+static guint
+carrier_flap_register_loss (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	guint max_delay, delay;
+
+	if (   priv->carrier_flap.count
+	    && now - priv->carrier_flap.last_loss < CARRIER_FLAP_INTERVAL) {
+		if (priv->carrier_flap.backoff < CARRIER_FLAP_BACKOFF_MAX)
+			priv->carrier_flap.backoff++;
+	} else
+		priv->carrier_flap.backoff = 0;
+	priv->carrier_flap.last_loss = now;
+	priv->carrier_flap.count++;
+	_notify (self, PROP_CARRIER_FLAPS);
+
+	max_delay = MAX (carrier_flap_get_max_delay (), LINK_DISCONNECT_DELAY);
+	delay = LINK_DISCONNECT_DELAY << priv->carrier_flap.backoff;
+	return MIN (delay, max_delay);
+}
+
 void
 nm_device_set_carrier (NMDevice *self, gboolean carrier)
 {
@@ -1544,22 +1799,31 @@ nm_device_set_carrier (NMDevice *self, gboolean carrier)
 
 	if (priv->carrier) {
 		_LOGI (LOGD_DEVICE, "link connected");
-		link_disconnect_action_cancel (self);
+		if (priv->carrier_defer_id) {
+			priv->carrier_flap.suppressed++;
+			_notify (self, PROP_CARRIER_FLAPS_SUPPRESSED);
+			link_disconnect_action_cancel (self);
+		}
 		klass->carrier_changed (self, TRUE);
 
 		if (nm_clear_g_source (&priv->carrier_wait_id)) {
 			nm_device_remove_pending_action (self, "carrier wait", TRUE);
 			_carrier_wait_check_queued_act_request (self);
 		}
-	} else if (state <= NM_DEVICE_STATE_DISCONNECTED) {
-		_LOGI (LOGD_DEVICE, "link disconnected");
-		klass->carrier_changed (self, FALSE);
 	} else {
-		_LOGI (LOGD_DEVICE, "link disconnected (deferring action for %d seconds)", LINK_DISCONNECT_DELAY);
-		priv->carrier_defer_id = g_timeout_add_seconds (LINK_DISCONNECT_DELAY,
-		                                                link_disconnect_action_cb, self);
-		_LOGD (LOGD_DEVICE, "link disconnected (deferring action for %d seconds) (id=%u)",
-		       LINK_DISCONNECT_DELAY, priv->carrier_defer_id);
+		guint delay;
+
+		delay = carrier_flap_register_loss (self);
+		if (state <= NM_DEVICE_STATE_DISCONNECTED) {
+			_LOGI (LOGD_DEVICE, "link disconnected");
+			klass->carrier_changed (self, FALSE);
+		} else {
+			_LOGI (LOGD_DEVICE, "link disconnected (deferring action for %u seconds)", delay);
+			priv->carrier_defer_id = g_timeout_add_seconds (delay,
+			                                                link_disconnect_action_cb, self);
+			_LOGD (LOGD_DEVICE, "link disconnected (deferring action for %u seconds) (id=%u, backoff=%u)",
+			       delay, priv->carrier_defer_id, (guint) priv->carrier_flap.backoff);
+		}
 	}
 }
 
@@ -1654,8 +1918,7 @@ device_link_changed (NMDevice *self)
 	if (info.name[0] && strcmp (priv->iface, info.name) != 0) {
 		_LOGI (LOGD_DEVICE, "interface index %d renamed iface from '%s' to '%s'",
 		       priv->ifindex, priv->iface, info.name);
-		g_free (priv->iface);
-		priv->iface = g_strdup (info.name);
+		nm_intern_str_set (&priv->iface, info.name);
 
 		/* If the device has no explicit ip_iface, then changing iface changes ip_iface too. */
 		ip_ifname_changed = !priv->ip_iface;
@@ -1728,14 +1991,8 @@ device_link_changed (NMDevice *self)
 	if (priv->up && !was_up) {
 		/* the link was down and just came up. That happens for example, while changing MTU.
 		 * We must restore IP configuration. */
-		if (priv->ip4_state == IP_DONE) {
-			if (!ip4_config_merge_and_apply (self, NULL, TRUE, NULL))
-				_LOGW (LOGD_IP4, "failed applying IP4 config after link comes up again");
-		}
-		if (priv->ip6_state == IP_DONE) {
-			if (!ip6_config_merge_and_apply (self, TRUE, NULL))
-				_LOGW (LOGD_IP6, "failed applying IP6 config after link comes up again");
-		}
+		ip_config_merge_and_apply_schedule (self, AF_INET, IP_CONFIG_DIRTY_LINK_UP);
+		ip_config_merge_and_apply_schedule (self, AF_INET6, IP_CONFIG_DIRTY_LINK_UP);
 	}
 
 	if (update_unmanaged_specs)
@@ -1763,8 +2020,7 @@ device_ip_link_changed (NMDevice *self)
 		_LOGI (LOGD_DEVICE, "interface index %d renamed ip_iface (%d) from '%s' to '%s'",
 		       priv->ifindex, nm_device_get_ip_ifindex (self),
 		       priv->ip_iface, pllink->name);
-		g_free (priv->ip_iface);
-		priv->ip_iface = g_strdup (pllink->name);
+		nm_intern_str_set (&priv->ip_iface, pllink->name);
 
 		_notify (self, PROP_IP_IFACE);
 		nm_device_update_dynamic_ip_setup (self);
@@ -1893,6 +2149,19 @@ nm_device_realize_start (NMDevice *self,
 	return TRUE;
 }
 
+static void
+create_and_realize_finish (NMDevice *self, const NMPlatformLink *plink)
+{
+	realize_start_setup (self, plink);
+	nm_device_realize_finish (self, plink);
+
+	if (nm_device_get_managed (self, FALSE)) {
+		nm_device_state_changed (self,
+		                         NM_DEVICE_STATE_UNAVAILABLE,
+		                         NM_DEVICE_STATE_REASON_NOW_MANAGED);
+	}
+}
+
 /**
  * nm_device_create_and_realize():
  * @self: the #NMDevice
@@ -1928,15 +2197,100 @@ nm_device_create_and_realize (NMDevice *self,
 		plink = &plink_copy;
 	}
 
-	realize_start_setup (self, plink);
-	nm_device_realize_finish (self, plink);
+	create_and_realize_finish (self, plink);
+	return TRUE;
+}
 
-	if (nm_device_get_managed (self, FALSE)) {
-		nm_device_state_changed (self,
-		                         NM_DEVICE_STATE_UNAVAILABLE,
-		                         NM_DEVICE_STATE_REASON_NOW_MANAGED);
+gboolean
+nm_device_can_create_batched (NMDevice *self)
+{
+	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+
+	return !!NM_DEVICE_GET_CLASS (self)->create_link_request;
+}
+
+/**
+ * nm_device_create_and_realize_many:
+ * @data: the devices to create
+ * @len: the number of @data entries
+ *
+ * Like nm_device_create_and_realize() for each entry of @data, but creates
+ * the kernel links of all devices that support create_link_request() with
+ * a single nm_platform_link_add_batch() call, and only then realizes the
+ * devices. On failure, the @error field of the entry is set. An entry for
+ * a device that is already realized, for example by an earlier entry for
+ * the same device, is skipped and succeeds.
+ */
+void
+nm_device_create_and_realize_many (NMDeviceCreateData *data, guint len)
+{
+	gs_free NMPlatformLinkAddRequest *requests = NULL;
+	gs_free guint *idx = NULL;
+	guint i, n = 0;
+
+	requests = g_new0 (NMPlatformLinkAddRequest, len);
+	idx = g_new (guint, len);
+
+	for (i = 0; i < len; i++) {
+		NMDevice *self = data[i].device;
+		NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+		guint j;
+
+		if (priv->real)
+			continue;
+		for (j = 0; j < i; j++) {
+			if (data[j].device == self)
+				break;
+		}
+		if (j < i) {
+			_LOGD (LOGD_DEVICE, "create: already queued in this batch");
+			continue;
+		}
+
+		if (!NM_DEVICE_GET_CLASS (self)->create_link_request) {
+			nm_device_create_and_realize (self, data[i].connection, data[i].parent, &data[i].error);
+			continue;
+		}
+
+		/* Must be set before device is realized */
+		priv->is_nm_owned = !nm_platform_link_get_by_ifname (NM_PLATFORM_GET, priv->iface);
+
+		_LOGD (LOGD_DEVICE, "create (is %snm-owned, batched)", priv->is_nm_owned ? "" : "not ");
+
+		if (!NM_DEVICE_GET_CLASS (self)->create_link_request (self,
+		                                                      data[i].connection,
+		                                                      data[i].parent,
+		                                                      &requests[n],
+		                                                      &data[i].error))
+			continue;
+		idx[n++] = i;
+	}
+
+	nm_platform_link_add_batch (NM_PLATFORM_GET, requests, n);
+
+	for (i = 0; i < n; i++) {
+		NMDeviceCreateData *d = &data[idx[i]];
+		const NMPlatformLink *plink = NULL;
+		NMPlatformLink plink_copy;
+
+		if (requests[i].result == NM_PLATFORM_ERROR_SUCCESS)
+			plink = nm_platform_link_get (NM_PLATFORM_GET, requests[i].ifindex);
+		if (!plink) {
+			g_set_error (&d->error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_CREATION_FAILED,
+			             "Failed to create %s interface '%s' for '%s': %s",
+			             nm_link_type_to_string (requests[i].type),
+			             requests[i].name,
+			             nm_connection_get_id (d->connection),
+			             nm_platform_error_to_string (requests[i].result));
+			continue;
+		}
+		plink_copy = *plink;
+
+		if (NM_DEVICE_GET_CLASS (d->device)->create_link_finish)
+			NM_DEVICE_GET_CLASS (d->device)->create_link_finish (d->device, d->connection, d->parent);
+
+		create_and_realize_finish (d->device, &plink_copy);
 	}
-	return TRUE;
 }
 
 static void
@@ -1955,8 +2309,7 @@ update_device_from_platform_link (NMDevice *self, const NMPlatformLink *plink)
 	}
 
 	if (!g_strcmp0 (plink->name, priv->iface)) {
-		g_free (priv->iface);
-		priv->iface = g_strdup (plink->name);
+		nm_intern_str_set (&priv->iface, plink->name);
 		_notify (self, PROP_IFACE);
 	}
 
@@ -1980,6 +2333,9 @@ config_changed_update_ignore_carrier (NMConfig *config,
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
+	if (!NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_IGNORE_CARRIER))
+		return;
+
 	if (   priv->state <= NM_DEVICE_STATE_DISCONNECTED
 	    || priv->state > NM_DEVICE_STATE_ACTIVATED)
 		priv->ignore_carrier = nm_config_data_get_ignore_carrier (config_data, self);
@@ -2258,7 +2614,7 @@ nm_device_unrealize (NMDevice *self, gboolean remove_resources, GError **error)
 	}
 	priv->ip_ifindex = 0;
 	if (priv->ip_iface) {
-		g_clear_pointer (&priv->ip_iface, g_free);
+		nm_intern_str_set (&priv->ip_iface, NULL);
 		_notify (self, PROP_IP_IFACE);
 	}
 	if (priv->driver_version) {
@@ -2277,12 +2633,14 @@ nm_device_unrealize (NMDevice *self, gboolean remove_resources, GError **error)
 		g_clear_pointer (&priv->hw_addr, g_free);
 		_notify (self, PROP_HW_ADDRESS);
 	}
+	priv->hw_addr_bin.len = 0;
 	if (priv->physical_port_id) {
 		g_clear_pointer (&priv->physical_port_id, g_free);
 		_notify (self, PROP_PHYSICAL_PORT_ID);
 	}
 
 	g_clear_pointer (&priv->perm_hw_addr, g_free);
+	priv->perm_hw_addr_bin.len = 0;
 	g_clear_pointer (&priv->initial_hw_addr, g_free);
 
 	priv->capabilities = NM_DEVICE_CAP_NM_SUPPORTED;
@@ -2582,6 +2940,39 @@ nm_device_master_check_slave_physical_port (NMDevice *self, NMDevice *slave,
 	}
 }
 
+/**
+ * nm_device_master_enslave_link:
+ * @self: the master device
+ * @slave: the slave device
+ *
+ * Takes the link of @slave down and enslaves it to @self, with one
+ * request to the platform. Like nm_device_take_down(), this doesn't
+ * bring @slave up again.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_device_master_enslave_link (NMDevice *self, NMDevice *slave)
+{
+	NMPlatformLinkChangeAttrs attrs = {
+		.change = NM_PLATFORM_LINK_CHANGE_MASTER,
+		.master = nm_device_get_ip_ifindex (self),
+	};
+	int ifindex = nm_device_get_ip_ifindex (slave);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	if (NM_DEVICE_GET_CLASS (slave)->take_down == take_down) {
+		/* kernel changes the flags before the master */
+		attrs.change |= NM_PLATFORM_LINK_CHANGE_FLAGS;
+		attrs.flags_mask = IFF_UP;
+		attrs.flags_set = 0;
+	} else
+		nm_device_take_down (slave, TRUE);
+
+	return nm_platform_link_change_attrs (NM_PLATFORM_GET, ifindex, &attrs, NULL);
+}
+
 /* release all slaves */
 static void
 nm_device_master_release_slaves (NMDevice *self)
@@ -3048,6 +3439,32 @@ nm_device_master_update_slave_connection (NMDevice *self,
 	return FALSE;
 }
 
+/* Adds the root qdisc to a generated connection, unless it is one that
+ * kernel sets up by itself. */
+static void
+tc_config_update_connection (NMDevice *self, NMConnection *connection)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMPlatformQdisc qdisc;
+	gs_free char *default_qdisc = NULL;
+	NMSetting *s_tc;
+
+	if (priv->ifindex <= 0)
+		return;
+	if (!nm_platform_qdisc_get_root (NM_PLATFORM_GET, priv->ifindex, &qdisc))
+		return;
+
+	if (NM_IN_STRSET (qdisc.kind, "noqueue", "pfifo_fast", "mq", "pfifo"))
+		return;
+	default_qdisc = nm_platform_sysctl_get (NM_PLATFORM_GET, "/proc/sys/net/core/default_qdisc");
+	if (nm_streq0 (default_qdisc, qdisc.kind))
+		return;
+
+	s_tc = nm_setting_tc_config_new ();
+	g_object_set (s_tc, NM_SETTING_TC_CONFIG_QDISC, qdisc.kind, NULL);
+	nm_connection_add_setting (connection, s_tc);
+}
+
 NMConnection *
 nm_device_generate_connection (NMDevice *self, NMDevice *master)
 {
@@ -3110,6 +3527,7 @@ nm_device_generate_connection (NMDevice *self, NMDevice *master)
 	}
 
 	klass->update_connection (self, connection);
+	tc_config_update_connection (self, connection);
 
 	/* Check the connection in case of update_connection() bug. */
 	if (!nm_connection_verify (connection, &error)) {
@@ -3422,6 +3840,31 @@ dnsmasq_state_changed_cb (NMDnsMasqManager *manager, guint32 status, gpointer us
 
 /*****************************************************************************/
 
+static void
+_timeline_add (NMDevice *self, const char *event, const char *detail)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (priv->act_request)
+		nm_active_connection_timeline_add (NM_ACTIVE_CONNECTION (priv->act_request), event, detail);
+}
+
+static void
+_timeline_finish (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	gs_free char *str = NULL;
+
+	if (   !priv->act_request
+	    || !nm_active_connection_timeline_finish (NM_ACTIVE_CONNECTION (priv->act_request)))
+		return;
+
+	str = nm_active_connection_timeline_to_string (NM_ACTIVE_CONNECTION (priv->act_request));
+	_LOGI (LOGD_DEVICE, "Activation: timeline (msec): %s", str);
+}
+
+/*****************************************************************************/
+
 static gboolean
 activation_source_handle_cb4 (gpointer user_data)
 {
@@ -3463,7 +3906,7 @@ activation_source_clear (NMDevice *self, int family)
 	if (act_data->id) {
 		_LOGD (LOGD_DEVICE, "activation-stage: clear %s,%d (id %u)",
 		       _activation_func_to_string (act_data->func), family, act_data->id);
-		nm_clear_g_source (&act_data->id);
+		nm_clear_loop_sched (&act_data->id);
 		act_data->func = NULL;
 	}
 }
@@ -3488,6 +3931,7 @@ activation_source_handle_cb (NMDevice *self, int family)
 	_LOGD (LOGD_DEVICE, "activation-stage: invoke %s,%d (id %u)",
 	       _activation_func_to_string (a.func), family, a.id);
 
+	_timeline_add (self, "stage", _activation_func_to_string (a.func));
 	a.func (self);
 
 	_LOGD (LOGD_DEVICE, "activation-stage: complete %s,%d (id %u)",
@@ -3514,14 +3958,14 @@ activation_source_schedule (NMDevice *self, ActivationHandleFunc func, int famil
 		return;
 	}
 
-	new_id = g_idle_add (source_func, self);
+	new_id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, source_func, self);
 
 	if (act_data->id) {
 		_LOGW (LOGD_DEVICE, "activation-stage: schedule %s,%d which replaces %s,%d (id %u -> %u)",
 		       _activation_func_to_string (func), family,
 		       _activation_func_to_string (act_data->func), family,
 		       act_data->id, new_id);
-		nm_clear_g_source (&act_data->id);
+		nm_clear_loop_sched (&act_data->id);
 	} else {
 		_LOGD (LOGD_DEVICE, "activation-stage: schedule %s,%d (id %u)",
 		       _activation_func_to_string (func), family, new_id);
@@ -3717,53 +4161,292 @@ act_stage2_config (NMDevice *self, NMDeviceStateReason *reason)
 	return NM_ACT_STAGE_RETURN_SUCCESS;
 }
 
-/*
- * activate_stage2_device_config
- *
- * Determine device parameters and set those on the device, ie
- * for wireless devices, set SSID, keys, etc.
- *
- */
-static void
-activate_stage2_device_config (NMDevice *self)
+/* Returns the CPUs set in @str, a cpumask in the format of sysfs
+ * ("00000001,000000ff"), or %NULL if @str is not valid. */
+static GArray *
+_cpu_mask_parse (const char *str)
 {
-	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
-	NMActStageReturn ret;
-	NMDeviceStateReason reason = NM_DEVICE_STATE_REASON_NONE;
-	gboolean no_firmware = FALSE;
-	NMActiveConnection *active = NM_ACTIVE_CONNECTION (priv->act_request);
-	GSList *iter;
-
-	nm_device_state_changed (self, NM_DEVICE_STATE_CONFIG, NM_DEVICE_STATE_REASON_NONE);
+	gs_strfreev char **groups = NULL;
+	GArray *cpus;
+	guint n, i, bit, cpu;
+	gint64 v;
 
-	/* Assumed connections were already set up outside NetworkManager */
-	if (!nm_active_connection_get_assumed (active)) {
-		if (!nm_device_bring_up (self, FALSE, &no_firmware)) {
-			if (no_firmware)
-				nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, NM_DEVICE_STATE_REASON_FIRMWARE_MISSING);
-			else
-				nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, NM_DEVICE_STATE_REASON_CONFIG_FAILED);
-			return;
+	groups = g_strsplit (str, ",", -1);
+	n = g_strv_length (groups);
+	cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (i = 0; i < n; i++) {
+		/* the last group holds the lowest CPUs */
+		v = _nm_utils_ascii_str_to_int64 (groups[n - i - 1], 16, 0, G_MAXUINT32, -1);
+		if (v < 0) {
+			g_array_unref (cpus);
+			return NULL;
 		}
-
-		ret = NM_DEVICE_GET_CLASS (self)->act_stage2_config (self, &reason);
-		if (ret == NM_ACT_STAGE_RETURN_POSTPONE)
-			return;
-		else if (ret == NM_ACT_STAGE_RETURN_FAILURE) {
-			nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, reason);
-			return;
+		for (bit = 0; bit < 32; bit++) {
+			if (v & (((gint64) 1) << bit)) {
+				cpu = i * 32 + bit;
+				g_array_append_val (cpus, cpu);
+			}
 		}
-		g_assert (ret == NM_ACT_STAGE_RETURN_SUCCESS);
 	}
+	return cpus;
+}
 
-	/* If we have slaves that aren't yet enslaved, do that now */
-	for (iter = priv->slaves; iter; iter = g_slist_next (iter)) {
-		SlaveInfo *info = iter->data;
-		NMDeviceState slave_state = nm_device_get_state (info->slave);
+static char *
+_cpu_mask_format (const guint *cpus, guint n_cpus)
+{
+	gs_free guint32 *words = NULL;
+	GString *str;
+	guint n_words = 1;
+	guint i;
 
-		if (slave_state == NM_DEVICE_STATE_IP_CONFIG)
-			nm_device_master_enslave_slave (self, info->slave, nm_device_get_applied_connection (info->slave));
-		else if (   nm_device_uses_generated_assumed_connection (self)
+	for (i = 0; i < n_cpus; i++)
+		n_words = MAX (n_words, cpus[i] / 32 + 1);
+	words = g_new0 (guint32, n_words);
+	for (i = 0; i < n_cpus; i++)
+		words[cpus[i] / 32] |= ((guint32) 1) << (cpus[i] % 32);
+
+	str = g_string_sized_new (n_words * 9);
+	for (i = n_words; i > 0; i--)
+		g_string_append_printf (str, i < n_words ? ",%08x" : "%08x", words[i - 1]);
+	return g_string_free (str, FALSE);
+}
+
+/* The CPUs local to the NUMA node of the device. Virtual devices
+ * have none, for them all online CPUs are used. */
+static GArray *
+_queue_cpus_get_local (const char *ifname)
+{
+	gs_free char *value = NULL;
+	GArray *cpus = NULL;
+	long n_cpus;
+	guint cpu;
+
+	value = nm_platform_sysctl_get (NM_PLATFORM_GET,
+	                                nm_sprintf_bufa (100, "/sys/class/net/%s/device/local_cpus", ifname));
+	if (value)
+		cpus = _cpu_mask_parse (value);
+	if (cpus && cpus->len)
+		return cpus;
+
+	if (!cpus)
+		cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+	n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	for (cpu = 0; cpu < MAX (n_cpus, 1); cpu++)
+		g_array_append_val (cpus, cpu);
+	return cpus;
+}
+
+/* The value to write to the rps_cpus or xps_cpus file of @queue. */
+static char *
+_queue_cpus_resolve (const char *value, GArray *local_cpus, guint queue)
+{
+	if (nm_streq (value, NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL))
+		return _cpu_mask_format ((guint *) local_cpus->data, local_cpus->len);
+	if (nm_streq (value, NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD))
+		return _cpu_mask_format (&g_array_index (local_cpus, guint, queue % local_cpus->len), 1);
+	return g_strdup (value);
+}
+
+static void
+_queue_steering_add (GArray *entries, char *path, char *value)
+{
+	NMPlatformSysctlSetEntry entry = {
+		.path = path,
+		.value = value,
+	};
+
+	g_array_append_val (entries, entry);
+}
+
+/* Configures receive and transmit packet steering on the queues of the
+ * device as requested by the ethtool setting. Unlike the other ethtool
+ * properties this works through sysfs and for all device types. */
+static void
+queue_steering_apply (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMSettingEthtool *s_ethtool;
+	const NMPlatformLink *plink;
+	const char *ifname, *rps_cpus, *xps_cpus;
+	gs_unref_array GArray *local_cpus = NULL;
+	GArray *entries;
+	guint num_rx_queues, num_tx_queues;
+	int rps_flow_cnt;
+	guint i;
+
+	s_ethtool = (NMSettingEthtool *) nm_device_get_applied_setting (self, NM_TYPE_SETTING_ETHTOOL);
+	if (!s_ethtool)
+		return;
+
+	rps_cpus = nm_setting_ethtool_get_rps_cpus (s_ethtool);
+	rps_flow_cnt = nm_setting_ethtool_get_rps_flow_cnt (s_ethtool);
+	xps_cpus = nm_setting_ethtool_get_xps_cpus (s_ethtool);
+	if (!rps_cpus && rps_flow_cnt < 0 && !xps_cpus)
+		return;
+
+	plink = nm_platform_link_get (NM_PLATFORM_GET, priv->ifindex);
+	if (!plink)
+		return;
+	num_rx_queues = plink->num_rx_queues;
+	num_tx_queues = plink->num_tx_queues;
+	ifname = nm_device_get_iface (self);
+
+	if (   NM_IN_STRSET (rps_cpus, NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL, NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD)
+	    || NM_IN_STRSET (xps_cpus, NM_SETTING_ETHTOOL_QUEUE_CPUS_NUMA_LOCAL, NM_SETTING_ETHTOOL_QUEUE_CPUS_SPREAD))
+		local_cpus = _queue_cpus_get_local (ifname);
+
+	entries = g_array_new (FALSE, FALSE, sizeof (NMPlatformSysctlSetEntry));
+	for (i = 0; i < num_rx_queues; i++) {
+		if (rps_cpus) {
+			_queue_steering_add (entries,
+			                     g_strdup_printf ("/sys/class/net/%s/queues/rx-%u/rps_cpus", ifname, i),
+			                     _queue_cpus_resolve (rps_cpus, local_cpus, i));
+		}
+		if (rps_flow_cnt >= 0) {
+			_queue_steering_add (entries,
+			                     g_strdup_printf ("/sys/class/net/%s/queues/rx-%u/rps_flow_cnt", ifname, i),
+			                     g_strdup_printf ("%d", rps_flow_cnt));
+		}
+	}
+	for (i = 0; xps_cpus && i < num_tx_queues; i++) {
+		_queue_steering_add (entries,
+		                     g_strdup_printf ("/sys/class/net/%s/queues/tx-%u/xps_cpus", ifname, i),
+		                     _queue_cpus_resolve (xps_cpus, local_cpus, i));
+	}
+
+	if (   entries->len
+	    && !nm_platform_sysctl_set_many (NM_PLATFORM_GET, (NMPlatformSysctlSetEntry *) entries->data, entries->len))
+		_LOGW (LOGD_DEVICE, "failed to configure the packet steering of some queues");
+
+	for (i = 0; i < entries->len; i++) {
+		NMPlatformSysctlSetEntry *entry = &g_array_index (entries, NMPlatformSysctlSetEntry, i);
+
+		g_free ((char *) entry->path);
+		g_free ((char *) entry->value);
+	}
+	g_array_unref (entries);
+}
+
+/* Sets the root qdisc of the tc setting, for example to reduce the
+ * latency of an uplink with fq_codel or cake. */
+static void
+tc_config_apply (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMSettingTCConfig *s_tc;
+	NMPlatformQdisc qdisc = { };
+	const char *kind;
+
+	s_tc = (NMSettingTCConfig *) nm_device_get_applied_setting (self, NM_TYPE_SETTING_TC_CONFIG);
+	if (!s_tc)
+		return;
+
+	kind = nm_setting_tc_config_get_qdisc (s_tc);
+	if (!kind)
+		return;
+
+	g_strlcpy (qdisc.kind, kind, sizeof (qdisc.kind));
+	qdisc.limit = nm_setting_tc_config_get_qdisc_limit (s_tc);
+	qdisc.target_us = nm_setting_tc_config_get_qdisc_target (s_tc);
+	qdisc.interval_us = nm_setting_tc_config_get_qdisc_interval (s_tc);
+	qdisc.ecn = nm_setting_tc_config_get_qdisc_ecn (s_tc);
+	/* kbit/s to bytes per second */
+	qdisc.rate = ((guint64) nm_setting_tc_config_get_qdisc_rate (s_tc)) * 1000 / 8;
+
+	if (!nm_platform_qdisc_set_root (NM_PLATFORM_GET, priv->ifindex, &qdisc))
+		_LOGW (LOGD_DEVICE, "failed to set the root qdisc to %s", kind);
+}
+
+static void
+sriov_apply (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMSettingSriov *s_sriov;
+	gs_unref_array GArray *vfs = NULL;
+	const char *const *strv;
+	guint total_vfs;
+
+	s_sriov = (NMSettingSriov *) nm_device_get_applied_setting (self, NM_TYPE_SETTING_SRIOV);
+	if (!s_sriov)
+		return;
+
+	total_vfs = nm_setting_sriov_get_total_vfs (s_sriov);
+	vfs = g_array_new (FALSE, FALSE, sizeof (NMPlatformSriovVF));
+	for (strv = nm_setting_sriov_get_vfs (s_sriov); strv && *strv; strv++) {
+		NMSriovVFConfig config;
+		NMPlatformSriovVF vf = { };
+
+		if (!_nm_setting_sriov_parse_vf (*strv, &config, NULL))
+			continue;
+
+		vf.index = config.index;
+		vf.has_mac = config.has_mac;
+		memcpy (vf.mac, config.mac, sizeof (vf.mac));
+		vf.vlan = config.vlan;
+		vf.qos = config.qos;
+		vf.spoof_check = config.spoof_check;
+		vf.trust = config.trust;
+		g_array_append_val (vfs, vf);
+	}
+
+	/* The netdevs of the new VFs show up asynchronously, NMManager picks
+	 * them up together with the other link additions. */
+	if (!nm_platform_link_set_sriov (NM_PLATFORM_GET, priv->ifindex, total_vfs,
+	                                 (const NMPlatformSriovVF *) vfs->data, vfs->len))
+		_LOGW (LOGD_DEVICE, "failed to set up %u SR-IOV VFs", total_vfs);
+}
+
+/*
+ * activate_stage2_device_config
+ *
+ * Determine device parameters and set those on the device, ie
+ * for wireless devices, set SSID, keys, etc.
+ *
+ */
+static void
+activate_stage2_device_config (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMActStageReturn ret;
+	NMDeviceStateReason reason = NM_DEVICE_STATE_REASON_NONE;
+	gboolean no_firmware = FALSE;
+	NMActiveConnection *active = NM_ACTIVE_CONNECTION (priv->act_request);
+	GSList *iter;
+
+	nm_device_state_changed (self, NM_DEVICE_STATE_CONFIG, NM_DEVICE_STATE_REASON_NONE);
+
+	/* Assumed connections were already set up outside NetworkManager */
+	if (!nm_active_connection_get_assumed (active)) {
+		if (!nm_device_bring_up (self, FALSE, &no_firmware)) {
+			if (no_firmware)
+				nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, NM_DEVICE_STATE_REASON_FIRMWARE_MISSING);
+			else
+				nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, NM_DEVICE_STATE_REASON_CONFIG_FAILED);
+			return;
+		}
+
+		ret = NM_DEVICE_GET_CLASS (self)->act_stage2_config (self, &reason);
+		if (ret == NM_ACT_STAGE_RETURN_POSTPONE)
+			return;
+		else if (ret == NM_ACT_STAGE_RETURN_FAILURE) {
+			nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, reason);
+			return;
+		}
+		g_assert (ret == NM_ACT_STAGE_RETURN_SUCCESS);
+
+		sriov_apply (self);
+		queue_steering_apply (self);
+		tc_config_apply (self);
+	}
+
+	/* If we have slaves that aren't yet enslaved, do that now */
+	for (iter = priv->slaves; iter; iter = g_slist_next (iter)) {
+		SlaveInfo *info = iter->data;
+		NMDeviceState slave_state = nm_device_get_state (info->slave);
+
+		if (slave_state == NM_DEVICE_STATE_IP_CONFIG)
+			nm_device_master_enslave_slave (self, info->slave, nm_device_get_applied_connection (info->slave));
+		else if (   nm_device_uses_generated_assumed_connection (self)
 		         && slave_state <= NM_DEVICE_STATE_DISCONNECTED)
 			nm_device_queue_recheck_assume (info->slave);
 	}
@@ -4006,6 +4689,7 @@ arping_manager_probe_terminated (NMArpingManager *arping_manager, ArpingData *da
 		}
 	}
 
+	_timeline_add (self, "ipv4-dad", success ? "done" : "duplicate");
 	data->callback (self, data->configs, success);
 
 	priv->arping.dad_list = g_slist_remove (priv->arping.dad_list, arping_manager);
@@ -4090,6 +4774,8 @@ ipv4_dad_start (NMDevice *self, NMIP4Config **configs, ArpingCallback cb)
 	                       G_CALLBACK (arping_manager_probe_terminated), data,
 	                       arping_data_destroy, 0);
 
+	_timeline_add (self, "ipv4-dad", "start");
+
 	ret = nm_arping_manager_start_probe (arping_manager, timeout, &error);
 
 	if (!ret) {
@@ -4451,6 +5137,12 @@ ip4_config_merge_and_apply (NMDevice *self,
 	gboolean ignore_auto_dns = FALSE;
 	gboolean auto_method = FALSE;
 
+	/* a commit covers all pending changes. */
+	if (commit)
+		priv->ip_config_dirty.v4 = IP_CONFIG_DIRTY_NONE;
+
+	priv->ext_ip4_update.internal_changed = TRUE;
+
 	/* Merge all the configs into the composite config */
 	if (config) {
 		g_clear_object (&priv->dev_ip4_config);
@@ -4746,6 +5438,7 @@ dhcp4_state_changed (NMDhcpClient *client,
 			break;
 		}
 
+		_timeline_add (self, "dhcp4", "lease");
 		nm_dhcp4_config_set_options (priv->dhcp4.config, options);
 		_notify (self, PROP_DHCP4_CONFIG);
 		priv->dhcp4.num_tries_left = DHCP_NUM_TRIES_MAX;
@@ -4847,7 +5540,8 @@ dhcp4_start (NMDevice *self,
 	                                                nm_setting_ip4_config_get_dhcp_client_id (NM_SETTING_IP4_CONFIG (s_ip4)),
 	                                                dhcp4_get_timeout (self, NM_SETTING_IP4_CONFIG (s_ip4)),
 	                                                priv->dhcp_anycast_address,
-	                                                NULL);
+	                                                priv->dhcp4.last_address);
+	g_clear_pointer (&priv->dhcp4.last_address, g_free);
 
 	if (tmp)
 		g_byte_array_free (tmp, TRUE);
@@ -4863,6 +5557,7 @@ dhcp4_start (NMDevice *self,
 	                                            self);
 
 	nm_device_add_pending_action (self, PENDING_ACTION_DHCP4, TRUE);
+	_timeline_add (self, "dhcp4", "start");
 
 	/* DHCP devices will be notified by the DHCP manager when stuff happens */
 	return NM_ACT_STAGE_RETURN_POSTPONE;
@@ -5195,6 +5890,12 @@ ip6_config_merge_and_apply (NMDevice *self,
 	gboolean ignore_auto_dns = FALSE;
 	gboolean auto_method = FALSE;
 
+	/* a commit covers all pending changes. */
+	if (commit)
+		priv->ip_config_dirty.v6 = IP_CONFIG_DIRTY_NONE;
+
+	priv->ext_ip6_update.internal_changed = TRUE;
+
 	/* Apply ignore-auto-routes and ignore-auto-dns settings */
 	connection = nm_device_get_applied_connection (self);
 	if (connection) {
@@ -5366,6 +6067,58 @@ END_ADD_DEFAULT_ROUTE:
 	return success;
 }
 
+static gboolean
+ip_config_merge_and_apply_cb (gpointer user_data)
+{
+	NMDevice *self = user_data;
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	IPConfigDirtyFlags dirty;
+
+	priv->ip_config_dirty.idle_id = 0;
+
+	/* A restored link only needs configuration that was already
+	 * applied, the other sources are applied in any state. */
+	dirty = priv->ip_config_dirty.v4;
+	if (   NM_FLAGS_ANY (dirty, ~IP_CONFIG_DIRTY_LINK_UP)
+	    || (dirty && priv->ip4_state == IP_DONE)) {
+		_LOGD (LOGD_IP4, "ip4-config: apply pending changes (0x%x)", (guint) dirty);
+		if (!ip4_config_merge_and_apply (self, NULL, TRUE, NULL))
+			_LOGW (LOGD_IP4, "failed to apply IPv4 configuration");
+	}
+	priv->ip_config_dirty.v4 = IP_CONFIG_DIRTY_NONE;
+
+	dirty = priv->ip_config_dirty.v6;
+	if (   NM_FLAGS_ANY (dirty, ~IP_CONFIG_DIRTY_LINK_UP)
+	    || (dirty && priv->ip6_state == IP_DONE)) {
+		_LOGD (LOGD_IP6, "ip6-config: apply pending changes (0x%x)", (guint) dirty);
+		if (!ip6_config_merge_and_apply (self, TRUE, NULL))
+			_LOGW (LOGD_IP6, "failed to apply IPv6 configuration");
+	}
+	priv->ip_config_dirty.v6 = IP_CONFIG_DIRTY_NONE;
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Record that @dirty changed for @family and merge-and-apply the
+ * configuration once, from an idle handler. This way a burst of changes
+ * results in a single commit to platform. A synchronous merge-and-apply
+ * in the meantime takes care of the pending changes too. */
+static void
+ip_config_merge_and_apply_schedule (NMDevice *self, int family, IPConfigDirtyFlags dirty)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	nm_assert (NM_IN_SET (family, AF_INET, AF_INET6));
+
+	if (family == AF_INET)
+		priv->ip_config_dirty.v4 |= dirty;
+	else
+		priv->ip_config_dirty.v6 |= dirty;
+
+	if (!priv->ip_config_dirty.idle_id)
+		priv->ip_config_dirty.idle_id = g_idle_add (ip_config_merge_and_apply_cb, self);
+}
+
 static gboolean
 dhcp6_lease_change (NMDevice *self)
 {
@@ -5423,7 +6176,7 @@ dhcp_schedule_restart (NMDevice *self, int family, const char *reason)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	gboolean inet4;
-	guint tries_left;
+	guint tries_left, delay_ms;
 	gs_free char *tries_str = NULL;
 
 	g_return_if_fail (family == AF_INET || family == AF_INET6);
@@ -5433,20 +6186,21 @@ dhcp_schedule_restart (NMDevice *self, int family, const char *reason)
 	if (tries_left != DHCP_NUM_TRIES_MAX)
 		tries_str = g_strdup_printf (", %u tries left", tries_left + 1);
 
+	/* spread the restarts of devices that failed at the same time */
+	delay_ms = nm_dhcp_manager_get_restart_delay (nm_dhcp_manager_get (),
+	                                              DHCP_RESTART_TIMEOUT * 1000);
+
 	_LOGI (inet4 ? LOGD_DHCP4 : LOGD_DHCP6,
 	       "scheduling DHCPv%c restart in %u seconds%s%s%s%s",
 	       inet4 ? '4' : '6',
-	       DHCP_RESTART_TIMEOUT,
+	       delay_ms / 1000,
 	       tries_str ? tries_str : "",
 	       NM_PRINT_FMT_QUOTED (reason, " (reason: ", reason, ")", ""));
 
-	if (inet4) {
-		priv->dhcp4.restart_id = g_timeout_add_seconds (DHCP_RESTART_TIMEOUT,
-		                                                dhcp4_restart_cb, self);
-	} else {
-		priv->dhcp6.restart_id = g_timeout_add_seconds (DHCP_RESTART_TIMEOUT,
-		                                                dhcp6_restart_cb, self);
-	}
+	if (inet4)
+		priv->dhcp4.restart_id = g_timeout_add (delay_ms, dhcp4_restart_cb, self);
+	else
+		priv->dhcp6.restart_id = g_timeout_add (delay_ms, dhcp6_restart_cb, self);
 }
 
 static void
@@ -5534,6 +6288,7 @@ dhcp6_state_changed (NMDhcpClient *client,
 
 	switch (state) {
 	case NM_DHCP_STATE_BOUND:
+		_timeline_add (self, "dhcp6", "lease");
 		/* If the server sends multiple IPv6 addresses, we receive a state
 		 * changed event for each of them. Use the event ID to merge IPv6
 		 * addresses from the same transaction into a single configuration.
@@ -5639,6 +6394,7 @@ dhcp6_start_with_link_ready (NMDevice *self, NMConnection *connection)
 		                                            NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
 		                                            G_CALLBACK (dhcp6_state_changed),
 		                                            self);
+		_timeline_add (self, "dhcp6", "start");
 	}
 
 	return !!priv->dhcp6.client;
@@ -5711,6 +6467,7 @@ linklocal6_cleanup (NMDevice *self)
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
 	nm_clear_g_source (&priv->linklocal6_timeout_id);
+	priv->linklocal6_ready = FALSE;
 }
 
 static void
@@ -5737,8 +6494,9 @@ linklocal6_complete (NMDevice *self)
 	NMConnection *connection;
 	const char *method;
 
+	/* priv->ip6_config might not yet contain the address, as we are
+	 * called as soon as the platform reports it. */
 	g_assert (priv->linklocal6_timeout_id);
-	g_assert (nm_ip6_config_get_address_first_nontentative (priv->ip6_config, TRUE));
 
 	linklocal6_cleanup (self);
 
@@ -6124,10 +6882,12 @@ addrconf6_start_with_link_ready (NMDevice *self)
 	if (!ip6_config_merge_and_apply (self, TRUE, NULL))
 		_LOGW (LOGD_IP6, "failed to apply manual IPv6 configuration");
 
-	nm_device_ipv6_sysctl_set (self, "accept_ra", "1");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_defrtr", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_pinfo", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_rtr_pref", "0");
+	nm_device_ipv6_sysctl_set_many (self,
+	                                "accept_ra", "1",
+	                                "accept_ra_defrtr", "0",
+	                                "accept_ra_pinfo", "0",
+	                                "accept_ra_rtr_pref", "0",
+	                                NULL);
 
 	priv->rdisc_changed_id = g_signal_connect (priv->rdisc,
 	                                           NM_RDISC_CONFIG_CHANGED,
@@ -6163,12 +6923,18 @@ addrconf6_start (NMDevice *self, NMSettingIP6ConfigPrivacy use_tempaddr)
 	s_ip6 = NM_SETTING_IP6_CONFIG (nm_connection_get_setting_ip6_config (connection));
 	g_assert (s_ip6);
 
-	priv->rdisc = nm_lndp_rdisc_new (NM_PLATFORM_GET,
-	                                 nm_device_get_ip_ifindex (self),
-	                                 nm_device_get_ip_iface (self),
-	                                 nm_connection_get_uuid (connection),
-	                                 nm_setting_ip6_config_get_addr_gen_mode (s_ip6),
-	                                 &error);
+	if (NM_IS_FAKE_PLATFORM (NM_PLATFORM_GET)) {
+		/* a simulation, see nm_fake_platform_setup_simulation() */
+		priv->rdisc = nm_fake_rdisc_new (nm_device_get_ip_ifindex (self),
+		                                 nm_device_get_ip_iface (self));
+	} else {
+		priv->rdisc = nm_lndp_rdisc_new (NM_PLATFORM_GET,
+		                                 nm_device_get_ip_ifindex (self),
+		                                 nm_device_get_ip_iface (self),
+		                                 nm_connection_get_uuid (connection),
+		                                 nm_setting_ip6_config_get_addr_gen_mode (s_ip6),
+		                                 &error);
+	}
 	if (!priv->rdisc) {
 		_LOGE (LOGD_IP6, "addrconf6: failed to start router discovery: %s", error->message);
 		g_error_free (error);
@@ -6212,6 +6978,36 @@ addrconf6_cleanup (NMDevice *self)
 	g_clear_object (&priv->rdisc);
 }
 
+static gboolean
+addrconf6_kernel_ra_enabled (NMDevice *self)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_connection_default (NM_CONFIG_GET_DATA,
+	                                               "ipv6.kernel-ra", self);
+	return nm_config_parse_boolean (value, FALSE);
+}
+
+/* Lets the kernel handle router advertisements, including SLAAC and the
+ * default route. NetworkManager doesn't run router discovery and picks up
+ * the result like any external change, through the platform cache. */
+static NMActStageReturn
+addrconf6_start_kernel (NMDevice *self, NMIP6Config **out_config)
+{
+	_LOGD (LOGD_IP6, "addrconf6: leaving router advertisements to the kernel");
+
+	nm_device_ipv6_sysctl_set_many (self,
+	                                "accept_ra", "2",
+	                                "accept_ra_defrtr", "1",
+	                                "accept_ra_pinfo", "1",
+	                                "accept_ra_rtr_pref", "1",
+	                                "autoconf", "1",
+	                                NULL);
+
+	*out_config = nm_ip6_config_new (nm_device_get_ip_ifindex (self));
+	return NM_ACT_STAGE_RETURN_SUCCESS;
+}
+
 /******************************************/
 
 static const char *ip6_properties_to_save[] = {
@@ -6219,6 +7015,7 @@ static const char *ip6_properties_to_save[] = {
 	"accept_ra_defrtr",
 	"accept_ra_pinfo",
 	"accept_ra_rtr_pref",
+	"autoconf",
 	"disable_ipv6",
 	"hop_limit",
 	"use_tempaddr",
@@ -6248,16 +7045,27 @@ static void
 restore_ip6_properties (NMDevice *self)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMPlatformSysctlSetEntry entries[G_N_ELEMENTS (ip6_properties_to_save)];
+	const char *ifname = nm_device_get_ip_iface (self);
 	GHashTableIter iter;
 	gpointer key, value;
+	guint i, n = 0;
 
 	g_hash_table_iter_init (&iter, priv->ip6_saved_properties);
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
 		/* Don't touch "disable_ipv6" if we're doing userland IPv6LL */
 		if (priv->nm_ipv6ll && strcmp (key, "disable_ipv6") == 0)
 			continue;
-		nm_device_ipv6_sysctl_set (self, key, value);
+		g_assert (n < G_N_ELEMENTS (entries));
+		entries[n].path = g_strdup (nm_utils_ip6_property_path (ifname, key));
+		entries[n].value = value;
+		n++;
 	}
+
+	nm_platform_sysctl_set_many (NM_PLATFORM_GET, entries, n);
+
+	for (i = 0; i < n; i++)
+		g_free ((char *) entries[i].path);
 }
 
 static inline void
@@ -6390,6 +7198,7 @@ act_stage3_ip6_config_start (NMDevice *self,
 	const char *ip6_privacy_str = "0\n";
 	GSList *slaves;
 	gboolean ready_slaves;
+	gboolean kernel_ra;
 
 	g_return_val_if_fail (reason != NULL, NM_ACT_STAGE_RETURN_FAILURE);
 
@@ -6447,19 +7256,33 @@ act_stage3_ip6_config_start (NMDevice *self,
 	if (!nm_device_uses_assumed_connection (self))
 		nm_device_ipv6_set_mtu (self, priv->ip6_mtu);
 
+	kernel_ra =    strcmp (method, NM_SETTING_IP6_CONFIG_METHOD_AUTO) == 0
+	            && addrconf6_kernel_ra_enabled (self);
+
 	/* Any method past this point requires an IPv6LL address. Use NM-controlled
 	 * IPv6LL if this is not an assumed connection, since assumed connections
-	 * will already have IPv6 set up.
+	 * will already have IPv6 set up. When the kernel does SLAAC, it also
+	 * creates the IPv6LL address.
 	 */
-	if (!nm_device_uses_assumed_connection (self))
-		set_nm_ipv6ll (self, TRUE);
+	if (!nm_device_uses_assumed_connection (self)) {
+		if (kernel_ra) {
+			gboolean old_nm_ipv6ll = priv->nm_ipv6ll;
+
+			set_nm_ipv6ll (self, FALSE);
+			if (old_nm_ipv6ll == TRUE)
+				nm_device_ipv6_sysctl_set (self, "disable_ipv6", "1");
+		} else
+			set_nm_ipv6ll (self, TRUE);
+	}
 
 	/* Re-enable IPv6 on the interface */
 	set_disable_ipv6 (self, "0");
 
 	ip6_privacy = _ip6_privacy_get (self);
 
-	if (strcmp (method, NM_SETTING_IP6_CONFIG_METHOD_AUTO) == 0) {
+	if (kernel_ra)
+		ret = addrconf6_start_kernel (self, out_config);
+	else if (strcmp (method, NM_SETTING_IP6_CONFIG_METHOD_AUTO) == 0) {
 		if (!addrconf6_start (self, ip6_privacy)) {
 			/* IPv6 might be disabled; allow IPv4 to proceed */
 			ret = NM_ACT_STAGE_RETURN_STOP;
@@ -6636,6 +7459,7 @@ activate_stage3_ip_config_start (NMDevice *self)
 		return;
 
 	check_ip_failed (self, TRUE);
+	activation_scheduler_release_if_waiting (self);
 }
 
 static gboolean
@@ -6671,6 +7495,7 @@ fw_change_zone_cb_stage2 (NMFirewallManager *firewall_manager,
 
 	priv = NM_DEVICE_GET_PRIVATE (self);
 	priv->fw_ready = TRUE;
+	_timeline_add (self, "firewall", "zone-done");
 
 	nm_device_activate_schedule_stage3_ip_config_start (self);
 }
@@ -6690,6 +7515,81 @@ fw_change_zone_cb_ip_check (NMFirewallManager *firewall_manager,
 	nm_device_start_ip_check (self);
 }
 
+static void
+activation_scheduler_start_cb (NMDevice *self)
+{
+	activation_source_schedule (self, activate_stage3_ip_config_start, AF_INET);
+}
+
+static int
+activation_scheduler_get_priority (NMConnection *connection)
+{
+	NMDefaultRouteManager *manager = nm_default_route_manager_get ();
+	int priority;
+
+	/* Order by autoconnect-priority first. Among equal priorities, prefer
+	 * connections that are going to provide a default route. */
+	priority = nm_setting_connection_get_autoconnect_priority (nm_connection_get_setting_connection (connection)) * 2;
+	if (   nm_default_route_manager_ip4_connection_has_default_route (manager, connection, NULL)
+	    || nm_default_route_manager_ip6_connection_has_default_route (manager, connection, NULL))
+		priority++;
+	return priority;
+}
+
+/* A master whose IPv4 and IPv6 both wait for slaves or carrier has nothing
+ * running. Holding the slot could block the devices it waits for, so it
+ * gives the slot up until master_ip_config_retry(). */
+static void
+activation_scheduler_release_if_waiting (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (   priv->is_master
+	    && priv->state == NM_DEVICE_STATE_IP_CONFIG
+	    && priv->ip4_state == IP_WAIT
+	    && priv->ip6_state == IP_WAIT) {
+		_LOGD (LOGD_DEVICE, "Activation: release the activation slot while waiting for slaves");
+		nm_activation_scheduler_release (nm_activation_scheduler_get (), self);
+	}
+}
+
+static void
+activation_scheduler_retry_cb (NMDevice *self)
+{
+	if (   nm_device_activate_ip4_state_in_wait (self)
+	    && !nm_device_activate_stage3_ip4_start (self))
+		return;
+	if (   nm_device_activate_ip6_state_in_wait (self)
+	    && !nm_device_activate_stage3_ip6_start (self))
+		return;
+	activation_scheduler_release_if_waiting (self);
+}
+
+/* Retries the IP configuration of a master that waits for slaves or
+ * carrier, after taking a slot again. */
+static void
+master_ip_config_retry (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (   !nm_device_activate_ip4_state_in_wait (self)
+	    && !nm_device_activate_ip6_state_in_wait (self))
+		return;
+
+	/* the same exceptions as in nm_device_activate_schedule_stage3_ip_config_start() */
+	if (   priv->state != NM_DEVICE_STATE_IP_CONFIG
+	    || nm_device_uses_assumed_connection (self)
+	    || nm_active_connection_get_master (NM_ACTIVE_CONNECTION (priv->act_request))) {
+		activation_scheduler_retry_cb (self);
+		return;
+	}
+
+	nm_activation_scheduler_request (nm_activation_scheduler_get (),
+	                                 self,
+	                                 activation_scheduler_get_priority (nm_device_get_applied_connection (self)),
+	                                 activation_scheduler_retry_cb);
+}
+
 /*
  * nm_device_activate_schedule_stage3_ip_config_start
  *
@@ -6727,12 +7627,24 @@ nm_device_activate_schedule_stage3_ip_config_start (NMDevice *self)
 				                                                        FALSE,
 				                                                        fw_change_zone_cb_stage2,
 				                                                        self);
+				_timeline_add (self, "firewall", "zone-start");
 			}
 			return;
 		}
 	}
 
-	activation_source_schedule (self, activate_stage3_ip_config_start, AF_INET);
+	/* Assumed connections don't start anything new, and slaves only wait
+	 * for their master in stage 3; holding a slot would block the master. */
+	if (   nm_device_uses_assumed_connection (self)
+	    || nm_active_connection_get_master (NM_ACTIVE_CONNECTION (priv->act_request))) {
+		activation_source_schedule (self, activate_stage3_ip_config_start, AF_INET);
+		return;
+	}
+
+	nm_activation_scheduler_request (nm_activation_scheduler_get (),
+	                                 self,
+	                                 activation_scheduler_get_priority (connection),
+	                                 activation_scheduler_start_cb);
 }
 
 static NMActStageReturn
@@ -7111,39 +8023,119 @@ nm_device_activate_ip4_state_done (NMDevice *self)
 	return NM_DEVICE_GET_PRIVATE (self)->ip4_state == IP_DONE;
 }
 
-/*
- * Returns a NMIP6Config containing NM-configured addresses which
- * have the tentative flag, or NULL if none is present.
- */
-static NMIP6Config *
-dad6_get_pending_addresses (NMDevice *self)
+static guint
+_in6_addr_hash (gconstpointer ptr)
+{
+	return (guint) nm_utils_digest_mem (NM_UTILS_DIGEST_INIT, ptr, sizeof (struct in6_addr));
+}
+
+static gboolean
+_in6_addr_equal (gconstpointer a, gconstpointer b)
+{
+	return IN6_ARE_ADDR_EQUAL ((const struct in6_addr *) a, (const struct in6_addr *) b);
+}
+
+static void
+dad6_cleanup (NMDevice *self)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
-	NMIP6Config *confs[] = { priv->ac_ip6_config,
-	                         priv->dhcp6.ip6_config,
-	                         priv->con_ip6_config,
-	                         priv->wwan_ip6_config };
-	const NMPlatformIP6Address *addr, *pl_addr;
-	NMIP6Config *dad6_config = NULL;
-	guint i, j, num;
-	int ifindex;
 
-	ifindex = nm_device_get_ip_ifindex (self);
-	g_return_val_if_fail (ifindex > 0, NULL);
+	g_clear_object (&priv->dad6_ip6_config);
+	g_clear_pointer (&priv->dad6_pending, g_hash_table_unref);
+}
 
-	/* We are interested only in addresses that we have explicitly configured,
-	 * not in externally added ones.
-	 */
-	for (i = 0; i < G_N_ELEMENTS (confs); i++) {
-		if (confs[i]) {
-			num = nm_ip6_config_get_num_addresses (confs[i]);
-			for (j = 0; j < num; j++) {
-				addr = nm_ip6_config_get_address (confs[i], j);
-				pl_addr = nm_platform_ip6_address_get (NM_PLATFORM_GET,
-				                                       ifindex,
-				                                       addr->address,
-				                                       addr->plen);
-				if (   pl_addr
+static gboolean
+ip6_addr_ready_cb (gpointer user_data)
+{
+	NMDevice *self = user_data;
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	/* Wait for any queued state changes */
+	if (priv->queued_state.id)
+		return G_SOURCE_CONTINUE;
+
+	priv->ip6_addr_ready_id = 0;
+
+	if (priv->linklocal6_timeout_id && priv->linklocal6_ready)
+		linklocal6_complete (self);
+
+	if (   priv->ip6_state == IP_CONF
+	    && priv->dad6_pending
+	    && !g_hash_table_size (priv->dad6_pending)) {
+		_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD terminated");
+		dad6_cleanup (self);
+		priv->ip6_state = IP_DONE;
+		check_ip_done (self);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Track the DAD state of the addresses we wait for, as reported by the
+ * platform. Each wait completes exactly once, from an idle handler, as
+ * soon as the kernel is done with the last address. */
+static void
+ip6_addr_track (NMDevice *self,
+                const NMPlatformIP6Address *addr,
+                NMPlatformSignalChangeType change_type)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	gboolean ready = FALSE;
+
+	if (   priv->linklocal6_timeout_id
+	    && !priv->linklocal6_ready
+	    && change_type != NM_PLATFORM_SIGNAL_REMOVED
+	    && IN6_IS_ADDR_LINKLOCAL (&addr->address)
+	    && !NM_FLAGS_HAS (addr->n_ifa_flags, IFA_F_TENTATIVE)) {
+		priv->linklocal6_ready = TRUE;
+		ready = TRUE;
+	}
+
+	if (   priv->dad6_pending
+	    && (   change_type == NM_PLATFORM_SIGNAL_REMOVED
+	        || !NM_FLAGS_HAS (addr->n_ifa_flags, IFA_F_TENTATIVE)
+	        || NM_FLAGS_ANY (addr->n_ifa_flags, IFA_F_DADFAILED | IFA_F_OPTIMISTIC))
+	    && g_hash_table_remove (priv->dad6_pending, &addr->address)
+	    && !g_hash_table_size (priv->dad6_pending))
+		ready = TRUE;
+
+	if (ready && !priv->ip6_addr_ready_id)
+		priv->ip6_addr_ready_id = g_idle_add (ip6_addr_ready_cb, self);
+}
+
+/*
+ * Returns a NMIP6Config containing NM-configured addresses which
+ * have the tentative flag, or NULL if none is present.
+ */
+static NMIP6Config *
+dad6_get_pending_addresses (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMIP6Config *confs[] = { priv->ac_ip6_config,
+	                         priv->dhcp6.ip6_config,
+	                         priv->con_ip6_config,
+	                         priv->wwan_ip6_config };
+	const NMPlatformIP6Address *addr, *pl_addr;
+	NMIP6Config *dad6_config = NULL;
+	guint i, j, num;
+	int ifindex;
+
+	ifindex = nm_device_get_ip_ifindex (self);
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	/* We are interested only in addresses that we have explicitly configured,
+	 * not in externally added ones.
+	 */
+	for (i = 0; i < G_N_ELEMENTS (confs); i++) {
+		if (confs[i]) {
+			num = nm_ip6_config_get_num_addresses (confs[i]);
+			for (j = 0; j < num; j++) {
+				addr = nm_ip6_config_get_address (confs[i], j);
+				pl_addr = nm_platform_ip6_address_get (NM_PLATFORM_GET,
+				                                       ifindex,
+				                                       addr->address,
+				                                       addr->plen);
+				if (   pl_addr
 				    && NM_FLAGS_HAS (pl_addr->n_ifa_flags, IFA_F_TENTATIVE)
 				    && !NM_FLAGS_HAS (pl_addr->n_ifa_flags, IFA_F_DADFAILED)
 				    && !NM_FLAGS_HAS (pl_addr->n_ifa_flags, IFA_F_OPTIMISTIC)) {
@@ -7210,6 +8202,15 @@ activate_stage5_ip6_config_commit (NMDevice *self)
 		if (priv->ip6_state == IP_CONF && !priv->dad6_ip6_config) {
 			priv->dad6_ip6_config = dad6_get_pending_addresses (self);
 			if (priv->dad6_ip6_config) {
+				guint i, n;
+
+				n = nm_ip6_config_get_num_addresses (priv->dad6_ip6_config);
+				priv->dad6_pending = g_hash_table_new_full (_in6_addr_hash, _in6_addr_equal, g_free, NULL);
+				for (i = 0; i < n; i++) {
+					nm_g_hash_table_add (priv->dad6_pending,
+					                     g_memdup (&nm_ip6_config_get_address (priv->dad6_ip6_config, i)->address,
+					                               sizeof (struct in6_addr)));
+				}
 				_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD: waiting termination");
 			} else {
 				/* No tentative addresses, proceed right away */
@@ -7424,7 +8425,8 @@ _cleanup_ip6_pre (NMDevice *self, CleanupType cleanup_type)
 	if (nm_clear_g_source (&priv->queued_ip6_config_id))
 		_LOGD (LOGD_DEVICE, "clearing queued IP6 config change");
 
-	g_clear_object (&priv->dad6_ip6_config);
+	nm_clear_g_source (&priv->ip6_addr_ready_id);
+	dad6_cleanup (self);
 	dhcp6_cleanup (self, cleanup_type, FALSE);
 	linklocal6_cleanup (self);
 	addrconf6_cleanup (self);
@@ -8195,6 +9197,7 @@ nm_device_set_ip4_config (NMDevice *self,
 	NMDevicePrivate *priv;
 	NMIP4Config *old_config = NULL;
 	gboolean has_changes = FALSE;
+	NMIPConfigChangeFlags changes = NM_IP_CONFIG_CHANGE_ALL;
 	gboolean success = TRUE;
 	NMDeviceStateReason reason_local = NM_DEVICE_STATE_REASON_NONE;
 	int ip_ifindex, config_ifindex;
@@ -8235,7 +9238,7 @@ nm_device_set_ip4_config (NMDevice *self,
 		if (old_config) {
 			/* has_changes is set only on relevant changes, because when the configuration changes,
 			 * this causes a re-read and reset. This should only happen for relevant changes */
-			nm_ip4_config_replace (old_config, new_config, &has_changes);
+			nm_ip4_config_replace (old_config, new_config, &has_changes, &changes);
 			if (has_changes) {
 				_LOGD (LOGD_IP4, "ip4-config: update IP4Config instance (%s)",
 				       nm_exported_object_get_path (NM_EXPORTED_OBJECT (old_config)));
@@ -8266,7 +9269,7 @@ nm_device_set_ip4_config (NMDevice *self,
 
 		if (old_config != priv->ip4_config)
 			_notify (self, PROP_IP4_CONFIG);
-		g_signal_emit (self, signals[IP4_CONFIG_CHANGED], 0, priv->ip4_config, old_config);
+		g_signal_emit (self, signals[IP4_CONFIG_CHANGED], 0, priv->ip4_config, old_config, (guint) changes);
 
 		if (old_config != priv->ip4_config)
 			nm_exported_object_clear_and_unexport (&old_config);
@@ -8334,9 +9337,7 @@ nm_device_replace_vpn4_config (NMDevice *self, NMIP4Config *old, NMIP4Config *co
 	if (!_replace_vpn_config_in_list (&priv->vpn4_configs, (GObject *) old, (GObject *) config))
 		return;
 
-	/* NULL to use existing configs */
-	if (!ip4_config_merge_and_apply (self, NULL, TRUE, NULL))
-		_LOGW (LOGD_IP4, "failed to set VPN routes for device");
+	ip_config_merge_and_apply_schedule (self, AF_INET, IP_CONFIG_DIRTY_VPN);
 }
 
 void
@@ -8351,9 +9352,7 @@ nm_device_set_wwan_ip4_config (NMDevice *self, NMIP4Config *config)
 	if (config)
 		priv->wwan_ip4_config = g_object_ref (config);
 
-	/* NULL to use existing configs */
-	if (!ip4_config_merge_and_apply (self, NULL, TRUE, NULL))
-		_LOGW (LOGD_IP4, "failed to set WWAN IPv4 configuration");
+	ip_config_merge_and_apply_schedule (self, AF_INET, IP_CONFIG_DIRTY_WWAN);
 }
 
 static gboolean
@@ -8366,6 +9365,7 @@ nm_device_set_ip6_config (NMDevice *self,
 	NMDevicePrivate *priv;
 	NMIP6Config *old_config = NULL;
 	gboolean has_changes = FALSE;
+	NMIPConfigChangeFlags changes = NM_IP_CONFIG_CHANGE_ALL;
 	gboolean success = TRUE;
 	NMDeviceStateReason reason_local = NM_DEVICE_STATE_REASON_NONE;
 	int ip_ifindex, config_ifindex;
@@ -8400,7 +9400,7 @@ nm_device_set_ip6_config (NMDevice *self,
 		if (old_config) {
 			/* has_changes is set only on relevant changes, because when the configuration changes,
 			 * this causes a re-read and reset. This should only happen for relevant changes */
-			nm_ip6_config_replace (old_config, new_config, &has_changes);
+			nm_ip6_config_replace (old_config, new_config, &has_changes, &changes);
 			if (has_changes) {
 				_LOGD (LOGD_IP6, "ip6-config: update IP6Config instance (%s)",
 				       nm_exported_object_get_path (NM_EXPORTED_OBJECT (old_config)));
@@ -8427,7 +9427,7 @@ nm_device_set_ip6_config (NMDevice *self,
 	if (has_changes) {
 		if (old_config != priv->ip6_config)
 			_notify (self, PROP_IP6_CONFIG);
-		g_signal_emit (self, signals[IP6_CONFIG_CHANGED], 0, priv->ip6_config, old_config);
+		g_signal_emit (self, signals[IP6_CONFIG_CHANGED], 0, priv->ip6_config, old_config, (guint) changes);
 
 		if (old_config != priv->ip6_config)
 			nm_exported_object_clear_and_unexport (&old_config);
@@ -8462,9 +9462,7 @@ nm_device_replace_vpn6_config (NMDevice *self, NMIP6Config *old, NMIP6Config *co
 	if (!_replace_vpn_config_in_list (&priv->vpn6_configs, (GObject *) old, (GObject *) config))
 		return;
 
-	/* NULL to use existing configs */
-	if (!ip6_config_merge_and_apply (self, TRUE, NULL))
-		_LOGW (LOGD_IP6, "failed to set VPN routes for device");
+	ip_config_merge_and_apply_schedule (self, AF_INET6, IP_CONFIG_DIRTY_VPN);
 }
 
 void
@@ -8479,9 +9477,7 @@ nm_device_set_wwan_ip6_config (NMDevice *self, NMIP6Config *config)
 	if (config)
 		priv->wwan_ip6_config = g_object_ref (config);
 
-	/* NULL to use existing configs */
-	if (!ip6_config_merge_and_apply (self, TRUE, NULL))
-		_LOGW (LOGD_IP6, "failed to set WWAN IPv6 configuration");
+	ip_config_merge_and_apply_schedule (self, AF_INET6, IP_CONFIG_DIRTY_WWAN);
 }
 
 NMDhcp6Config *
@@ -8524,6 +9520,8 @@ dispatcher_complete_proceed_state (guint call_id, gpointer user_data)
 	g_return_if_fail (call_id == priv->dispatcher.call_id);
 
 	priv->dispatcher.call_id = 0;
+	if (priv->dispatcher.post_state == NM_DEVICE_STATE_SECONDARIES)
+		_timeline_add (self, "dispatcher", "pre-up-done");
 	nm_device_queue_state (self, priv->dispatcher.post_state,
 	                       priv->dispatcher.post_state_reason);
 	priv->dispatcher.post_state = NM_DEVICE_STATE_UNKNOWN;
@@ -8544,6 +9542,7 @@ ip_check_pre_up (NMDevice *self)
 
 	priv->dispatcher.post_state = NM_DEVICE_STATE_SECONDARIES;
 	priv->dispatcher.post_state_reason = NM_DEVICE_STATE_REASON_NONE;
+	_timeline_add (self, "dispatcher", "pre-up-start");
 	if (!nm_dispatcher_call (DISPATCHER_ACTION_PRE_UP,
 	                         nm_device_get_settings_connection (self),
 	                         nm_device_get_applied_connection (self),
@@ -8870,6 +9869,13 @@ bring_up (NMDevice *self, gboolean *no_firmware)
 		return TRUE;
 	}
 
+	/* e.g. set up together with the new MAC address, see nm_device_set_hw_addr() */
+	if (nm_platform_link_is_up (NM_PLATFORM_GET, ifindex)) {
+		if (no_firmware)
+			*no_firmware = FALSE;
+		return TRUE;
+	}
+
 	result = nm_platform_link_set_up (NM_PLATFORM_GET, ifindex, no_firmware);
 
 	return result;
@@ -9082,6 +10088,175 @@ _ip4_config_subtract (gpointer value, gpointer user_data)
 	nm_ip4_config_subtract (dst, src);
 }
 
+static void
+_ext_ip_config_update_reset (ExtIPConfigUpdate *update)
+{
+	if (update->route_changes)
+		g_array_set_size (update->route_changes, 0);
+	if (update->temp_address_changes)
+		g_array_set_size (update->temp_address_changes, 0);
+	update->recapture = FALSE;
+}
+
+static void
+_ext_ip_config_update_clear (ExtIPConfigUpdate *update)
+{
+	if (update->route_changes) {
+		g_array_unref (update->route_changes);
+		update->route_changes = NULL;
+	}
+	if (update->temp_address_changes) {
+		g_array_unref (update->temp_address_changes);
+		update->temp_address_changes = NULL;
+	}
+	update->recapture = FALSE;
+	update->internal_changed = FALSE;
+}
+
+static void
+_ext_ip_config_update_route_changed (ExtIPConfigUpdate *update,
+                                     const NMPlatformIPXRoute *route,
+                                     gsize route_size,
+                                     NMPlatformSignalChangeType change_type)
+{
+	ExtRouteChange *change;
+
+	if (update->recapture)
+		return;
+
+	/* default routes make up the gateway and the route metric. */
+	if (   NM_PLATFORM_IP_ROUTE_IS_DEFAULT (&route->rx)
+	    || (update->route_changes && update->route_changes->len >= EXT_ROUTE_CHANGES_MAX)) {
+		update->recapture = TRUE;
+		return;
+	}
+
+	if (!update->route_changes)
+		update->route_changes = g_array_new (FALSE, FALSE, sizeof (ExtRouteChange));
+	g_array_set_size (update->route_changes, update->route_changes->len + 1);
+	change = &g_array_index (update->route_changes, ExtRouteChange, update->route_changes->len - 1);
+	change->change_type = change_type;
+	memset (&change->route, 0, sizeof (change->route));
+	memcpy (&change->route, route, route_size);
+}
+
+static void
+_ext_ip_config_update_ip6_address_changed (ExtIPConfigUpdate *update,
+                                           const NMPlatformIP6Address *address,
+                                           NMPlatformSignalChangeType change_type)
+{
+	ExtTempAddressChange *change;
+
+	if (update->recapture)
+		return;
+
+	/* DAD results are handled by queued_ip6_config_change() and
+	 * need a full update. */
+	if (   !NM_FLAGS_HAS (address->n_ifa_flags, IFA_F_TEMPORARY)
+	    || NM_FLAGS_HAS (address->n_ifa_flags, IFA_F_DADFAILED)
+	    || (   change_type == NM_PLATFORM_SIGNAL_REMOVED
+	        && NM_FLAGS_HAS (address->n_ifa_flags, IFA_F_TENTATIVE))
+	    || (   update->temp_address_changes
+	        && update->temp_address_changes->len >= EXT_TEMP_ADDRESS_CHANGES_MAX)) {
+		update->recapture = TRUE;
+		return;
+	}
+
+	if (!update->temp_address_changes)
+		update->temp_address_changes = g_array_new (FALSE, FALSE, sizeof (ExtTempAddressChange));
+	g_array_set_size (update->temp_address_changes, update->temp_address_changes->len + 1);
+	change = &g_array_index (update->temp_address_changes, ExtTempAddressChange, update->temp_address_changes->len - 1);
+	change->change_type = change_type;
+	change->address = *address;
+}
+
+static gboolean
+_ip4_route_is_internal (NMDevice *self, const NMPlatformIP4Route *route)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	GSList *iter;
+
+	if (priv->con_ip4_config && nm_ip4_config_lookup_route (priv->con_ip4_config, route))
+		return TRUE;
+	if (priv->dev_ip4_config && nm_ip4_config_lookup_route (priv->dev_ip4_config, route))
+		return TRUE;
+	if (priv->wwan_ip4_config && nm_ip4_config_lookup_route (priv->wwan_ip4_config, route))
+		return TRUE;
+	for (iter = priv->vpn4_configs; iter; iter = iter->next) {
+		if (nm_ip4_config_lookup_route (iter->data, route))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Applies the queued route changes to ext_ip4_config and does to the
+ * internal configurations what the intersect and subtract steps of
+ * update_ip4_config() would do. Returns %FALSE if the configuration
+ * must be captured anew; it may be partially updated then. */
+static gboolean
+_ext_ip4_config_update_incrementally (NMDevice *self, int ifindex)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	ExtIPConfigUpdate *update = &priv->ext_ip4_update;
+	NMIP4Config *captured = priv->ext_ip4_config_captured;
+	GSList *iter;
+	guint i;
+
+	if (   update->recapture
+	    || update->internal_changed
+	    || !priv->ext_ip4_config
+	    || !captured
+	    || nm_ip4_config_get_ifindex (captured) != ifindex)
+		return FALSE;
+
+	for (i = 0; update->route_changes && i < update->route_changes->len; i++) {
+		const ExtRouteChange *change = &g_array_index (update->route_changes, ExtRouteChange, i);
+		const NMPlatformIP4Route *route = &change->route.r4;
+		const NMPlatformIP4Route *existing;
+
+		/* like nm_ip4_config_capture(), ignore the host route to the gateway */
+		if (   nm_ip4_config_has_gateway (captured)
+		    && route->plen == 32
+		    && route->network == nm_ip4_config_get_gateway (captured)
+		    && route->gateway == 0)
+			continue;
+
+		existing = nm_ip4_config_lookup_route (captured, route);
+
+		if (change->change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+			if (!existing)
+				continue;
+			nm_ip4_config_remove_route (captured, route, TRUE);
+			nm_ip4_config_remove_route (priv->ext_ip4_config, route, TRUE);
+
+			/* another route to the destination with a different metric remains. */
+			if (nm_ip4_config_lookup_route (captured, route))
+				continue;
+
+			if (priv->con_ip4_config)
+				nm_ip4_config_remove_route (priv->con_ip4_config, route, FALSE);
+			if (priv->dev_ip4_config)
+				nm_ip4_config_remove_route (priv->dev_ip4_config, route, FALSE);
+			if (priv->wwan_ip4_config)
+				nm_ip4_config_remove_route (priv->wwan_ip4_config, route, FALSE);
+			for (iter = priv->vpn4_configs; iter; iter = iter->next)
+				nm_ip4_config_remove_route (iter->data, route, FALSE);
+		} else {
+			/* the capture keeps all routes to a destination, while adding
+			 * a route replaces the one with the same destination. */
+			if (existing && existing->metric != route->metric)
+				return FALSE;
+
+			nm_ip4_config_add_route (captured, route);
+			if (!_ip4_route_is_internal (self, route))
+				nm_ip4_config_add_route (priv->ext_ip4_config, route);
+		}
+	}
+
+	_ext_ip_config_update_reset (update);
+	return TRUE;
+}
+
 static void
 update_ip4_config (NMDevice *self, gboolean initial)
 {
@@ -9106,13 +10281,26 @@ update_ip4_config (NMDevice *self, gboolean initial)
 	if (!ifindex)
 		return;
 
+	/* With routing daemons, most changes are single routes. Don't capture
+	 * all addresses and routes for them. */
+	if (   !initial
+	    && _ext_ip4_config_update_incrementally (self, ifindex)) {
+		ip4_config_merge_and_apply (self, NULL, FALSE, NULL);
+		priv->ext_ip4_update.internal_changed = FALSE;
+		return;
+	}
+
 	capture_resolv_conf =    initial
 	                      && nm_dns_manager_get_resolv_conf_explicit (nm_dns_manager_get ());
 
 	/* IPv4 */
+	_ext_ip_config_update_reset (&priv->ext_ip4_update);
 	g_clear_object (&priv->ext_ip4_config);
-	priv->ext_ip4_config = nm_ip4_config_capture (ifindex, capture_resolv_conf);
-	if (priv->ext_ip4_config) {
+	g_clear_object (&priv->ext_ip4_config_captured);
+	priv->ext_ip4_config_captured = nm_ip4_config_capture (ifindex, capture_resolv_conf);
+	if (priv->ext_ip4_config_captured) {
+		priv->ext_ip4_config = nm_ip4_config_new_cloned (priv->ext_ip4_config_captured);
+
 		if (initial) {
 			g_clear_object (&priv->dev_ip4_config);
 			capture_lease_config (self, priv->ext_ip4_config, &priv->dev_ip4_config, NULL, NULL);
@@ -9151,6 +10339,7 @@ update_ip4_config (NMDevice *self, gboolean initial)
 			nm_ip4_config_subtract (priv->ext_ip4_config, priv->wwan_ip4_config);
 
 		ip4_config_merge_and_apply (self, NULL, FALSE, NULL);
+		priv->ext_ip4_update.internal_changed = FALSE;
 	}
 }
 
@@ -9172,12 +10361,203 @@ _ip6_config_subtract (gpointer value, gpointer user_data)
 	nm_ip6_config_subtract (dst, src);
 }
 
+static gboolean
+_ip6_route_is_internal (NMDevice *self, const NMPlatformIP6Route *route)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	GSList *iter;
+
+	if (priv->con_ip6_config && nm_ip6_config_lookup_route (priv->con_ip6_config, route))
+		return TRUE;
+	if (priv->ac_ip6_config && nm_ip6_config_lookup_route (priv->ac_ip6_config, route))
+		return TRUE;
+	if (priv->dhcp6.ip6_config && nm_ip6_config_lookup_route (priv->dhcp6.ip6_config, route))
+		return TRUE;
+	if (priv->wwan_ip6_config && nm_ip6_config_lookup_route (priv->wwan_ip6_config, route))
+		return TRUE;
+	for (iter = priv->vpn6_configs; iter; iter = iter->next) {
+		if (nm_ip6_config_lookup_route (iter->data, route))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+_ip6_address_is_internal (NMDevice *self, const NMPlatformIP6Address *address)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	GSList *iter;
+
+	if (priv->con_ip6_config && nm_ip6_config_address_exists (priv->con_ip6_config, address))
+		return TRUE;
+	if (priv->ac_ip6_config && nm_ip6_config_address_exists (priv->ac_ip6_config, address))
+		return TRUE;
+	if (priv->dhcp6.ip6_config && nm_ip6_config_address_exists (priv->dhcp6.ip6_config, address))
+		return TRUE;
+	if (priv->wwan_ip6_config && nm_ip6_config_address_exists (priv->wwan_ip6_config, address))
+		return TRUE;
+	for (iter = priv->vpn6_configs; iter; iter = iter->next) {
+		if (nm_ip6_config_address_exists (iter->data, address))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Whether the configuration already has a dynamic address besides the
+ * temporary ones. In that case temporary addresses don't change the
+ * setting nm_ip6_config_create_setting() generates from it. */
+static gboolean
+_ip6_config_has_dynamic_address (NMIP6Config *config)
+{
+	guint i, n;
+
+	n = nm_ip6_config_get_num_addresses (config);
+	for (i = 0; i < n; i++) {
+		const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
+
+		if (   !IN6_IS_ADDR_LINKLOCAL (&address->address)
+		    && address->lifetime != NM_PLATFORM_LIFETIME_PERMANENT
+		    && !NM_FLAGS_HAS (address->n_ifa_flags, IFA_F_TEMPORARY))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* The kernel creates and expires temporary addresses on its own, they
+ * are never part of the internal configurations and don't matter for
+ * routing, DNS or the generated connection. When only they changed,
+ * patch them into the exported configuration instead of merging the
+ * configuration anew and emitting IP6_CONFIG_CHANGED. */
+static gboolean
+_ip6_config_update_temporary_addresses (NMDevice *self, GArray *changes)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	guint i;
+
+	if (   !priv->ip6_config
+	    || !_ip6_config_has_dynamic_address (priv->ip6_config))
+		return FALSE;
+
+	_LOGD (LOGD_IP6, "ip6-config: update %u temporary address(es) of IP6Config instance (%s)",
+	       changes->len, nm_exported_object_get_path (NM_EXPORTED_OBJECT (priv->ip6_config)));
+
+	for (i = 0; i < changes->len; i++) {
+		const ExtTempAddressChange *change = &g_array_index (changes, ExtTempAddressChange, i);
+
+		if (change->change_type == NM_PLATFORM_SIGNAL_REMOVED)
+			nm_ip6_config_remove_address (priv->ip6_config, &change->address);
+		else
+			nm_ip6_config_add_address (priv->ip6_config, &change->address);
+	}
+	nm_ip6_config_addresses_sort (priv->ip6_config,
+	    priv->rdisc ? priv->rdisc_use_tempaddr : NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN);
+	return TRUE;
+}
+
+/* see _ext_ip4_config_update_incrementally(). @out_applied is set
+ * when only temporary addresses changed and they were already
+ * patched into the exported configuration. */
+static gboolean
+_ext_ip6_config_update_incrementally (NMDevice *self, int ifindex, gboolean *out_applied)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	ExtIPConfigUpdate *update = &priv->ext_ip6_update;
+	NMIP6Config *captured = priv->ext_ip6_config_captured;
+	GSList *iter;
+	guint i;
+
+	*out_applied = FALSE;
+
+	if (   update->recapture
+	    || update->internal_changed
+	    || !priv->ext_ip6_config
+	    || !captured
+	    || nm_ip6_config_get_ifindex (captured) != ifindex)
+		return FALSE;
+
+	for (i = 0; update->route_changes && i < update->route_changes->len; i++) {
+		const ExtRouteChange *change = &g_array_index (update->route_changes, ExtRouteChange, i);
+		const NMPlatformIP6Route *route = &change->route.r6;
+		const NMPlatformIP6Route *existing;
+		const struct in6_addr *gateway;
+
+		/* like nm_ip6_config_capture(), ignore the host route to the gateway */
+		gateway = nm_ip6_config_get_gateway (captured);
+		if (   gateway
+		    && route->plen == 128
+		    && IN6_ARE_ADDR_EQUAL (&route->network, gateway)
+		    && IN6_IS_ADDR_UNSPECIFIED (&route->gateway))
+			continue;
+
+		existing = nm_ip6_config_lookup_route (captured, route);
+
+		if (change->change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+			if (!existing)
+				continue;
+			nm_ip6_config_remove_route (captured, route, TRUE);
+			nm_ip6_config_remove_route (priv->ext_ip6_config, route, TRUE);
+
+			/* another route to the destination with a different metric remains. */
+			if (nm_ip6_config_lookup_route (captured, route))
+				continue;
+
+			if (priv->con_ip6_config)
+				nm_ip6_config_remove_route (priv->con_ip6_config, route, FALSE);
+			if (priv->ac_ip6_config)
+				nm_ip6_config_remove_route (priv->ac_ip6_config, route, FALSE);
+			if (priv->dhcp6.ip6_config)
+				nm_ip6_config_remove_route (priv->dhcp6.ip6_config, route, FALSE);
+			if (priv->wwan_ip6_config)
+				nm_ip6_config_remove_route (priv->wwan_ip6_config, route, FALSE);
+			for (iter = priv->vpn6_configs; iter; iter = iter->next)
+				nm_ip6_config_remove_route (iter->data, route, FALSE);
+		} else {
+			if (   existing
+			    &&    nm_utils_ip6_route_metric_normalize (existing->metric)
+			       != nm_utils_ip6_route_metric_normalize (route->metric))
+				return FALSE;
+
+			nm_ip6_config_add_route (captured, route);
+			if (!_ip6_route_is_internal (self, route))
+				nm_ip6_config_add_route (priv->ext_ip6_config, route);
+		}
+	}
+
+	if (update->temp_address_changes && update->temp_address_changes->len) {
+		for (i = 0; i < update->temp_address_changes->len; i++) {
+			const ExtTempAddressChange *change = &g_array_index (update->temp_address_changes, ExtTempAddressChange, i);
+
+			if (_ip6_address_is_internal (self, &change->address))
+				return FALSE;
+
+			if (change->change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+				nm_ip6_config_remove_address (captured, &change->address);
+				nm_ip6_config_remove_address (priv->ext_ip6_config, &change->address);
+			} else {
+				nm_ip6_config_add_address (captured, &change->address);
+				nm_ip6_config_add_address (priv->ext_ip6_config, &change->address);
+			}
+		}
+		/* keep the order of nm_ip6_config_capture() */
+		nm_ip6_config_addresses_sort (captured, NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN);
+		nm_ip6_config_addresses_sort (priv->ext_ip6_config, NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN);
+
+		if (   (!update->route_changes || !update->route_changes->len)
+		    && _ip6_config_update_temporary_addresses (self, update->temp_address_changes))
+			*out_applied = TRUE;
+	}
+
+	_ext_ip_config_update_reset (update);
+	return TRUE;
+}
+
 static void
 update_ip6_config (NMDevice *self, gboolean initial)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	int ifindex;
 	gboolean capture_resolv_conf;
+	gboolean applied;
 
 	/* If a commit is scheduled, this function would potentially interfere with
 	 * it changing IP configurations before they are applied. Postpone the
@@ -9196,10 +10576,20 @@ update_ip6_config (NMDevice *self, gboolean initial)
 	if (!ifindex)
 		return;
 
+	if (   !initial
+	    && _ext_ip6_config_update_incrementally (self, ifindex, &applied)) {
+		if (!applied) {
+			ip6_config_merge_and_apply (self, FALSE, NULL);
+			priv->ext_ip6_update.internal_changed = FALSE;
+		}
+		goto check_linklocal6;
+	}
+
 	capture_resolv_conf =    initial
 	                      && nm_dns_manager_get_resolv_conf_explicit (nm_dns_manager_get ());
 
 	/* IPv6 */
+	_ext_ip_config_update_reset (&priv->ext_ip6_update);
 	g_clear_object (&priv->ext_ip6_config);
 	g_clear_object (&priv->ext_ip6_config_captured);
 	priv->ext_ip6_config_captured = nm_ip6_config_capture (ifindex, capture_resolv_conf, NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN);
@@ -9235,8 +10625,10 @@ update_ip6_config (NMDevice *self, gboolean initial)
 		g_slist_foreach (priv->vpn6_configs, _ip6_config_subtract, priv->ext_ip6_config);
 
 		ip6_config_merge_and_apply (self, FALSE, NULL);
+		priv->ext_ip6_update.internal_changed = FALSE;
 	}
 
+check_linklocal6:
 	if (   priv->linklocal6_timeout_id
 	    && priv->ext_ip6_config_captured
 	    && nm_ip6_config_get_address_first_nontentative (priv->ext_ip6_config_captured, TRUE)) {
@@ -9335,7 +10727,7 @@ queued_ip6_config_change (gpointer user_data)
 		if (!nm_ip6_config_has_any_dad_pending (priv->ext_ip6_config_captured,
 		                                        priv->dad6_ip6_config)) {
 			_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD terminated");
-			g_clear_object (&priv->dad6_ip6_config);
+			dad6_cleanup (self);
 			priv->ip6_state = IP_DONE;
 			check_ip_done (self);
 		}
@@ -9365,6 +10757,11 @@ device_ipx_changed (NMPlatform *platform,
 	switch (obj_type) {
 	case NMP_OBJECT_TYPE_IP4_ADDRESS:
 	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (obj_type == NMP_OBJECT_TYPE_IP4_ROUTE) {
+			_ext_ip_config_update_route_changed (&priv->ext_ip4_update, platform_object,
+			                                     sizeof (NMPlatformIP4Route), change_type);
+		} else
+			priv->ext_ip4_update.recapture = TRUE;
 		if (!priv->queued_ip4_config_id) {
 			priv->queued_ip4_config_id = g_idle_add (queued_ip4_config_change, self);
 			_LOGD (LOGD_DEVICE, "queued IP4 config change");
@@ -9380,8 +10777,14 @@ device_ipx_changed (NMPlatform *platform,
 			priv->dad6_failed_addrs = g_slist_append (priv->dad6_failed_addrs,
 			                                          g_memdup (addr, sizeof (NMPlatformIP6Address)));
 		}
+		ip6_addr_track (self, addr, change_type);
+		_ext_ip_config_update_ip6_address_changed (&priv->ext_ip6_update, addr, change_type);
 		/* fallthrough */
 	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (obj_type == NMP_OBJECT_TYPE_IP6_ROUTE) {
+			_ext_ip_config_update_route_changed (&priv->ext_ip6_update, platform_object,
+			                                     sizeof (NMPlatformIP6Route), change_type);
+		}
 		if (!priv->queued_ip6_config_id) {
 			priv->queued_ip6_config_id = g_idle_add (queued_ip6_config_change, self);
 			_LOGD (LOGD_DEVICE, "queued IP6 config change");
@@ -9803,6 +11206,28 @@ nm_device_set_dhcp_timeout (NMDevice *self, guint32 timeout)
 	NM_DEVICE_GET_PRIVATE (self)->dhcp_timeout = timeout;
 }
 
+/**
+ * nm_device_set_dhcp4_last_address:
+ * @self: the #NMDevice
+ * @address: (allow-none): an IPv4 address in text form
+ *
+ * Makes the next DHCPv4 client started on @self ask for @address again, so
+ * that a lease that is still valid is confirmed in the INIT-REBOOT state
+ * instead of going through discovery. The hint is used once.
+ */
+void
+nm_device_set_dhcp4_last_address (NMDevice *self, const char *address)
+{
+	NMDevicePrivate *priv;
+
+	g_return_if_fail (NM_IS_DEVICE (self));
+
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	g_free (priv->dhcp4.last_address);
+	priv->dhcp4.last_address = g_strdup (address);
+}
+
 void
 nm_device_set_dhcp_anycast_address (NMDevice *self, const char *addr)
 {
@@ -10090,7 +11515,7 @@ void
 nm_device_recheck_available_connections (NMDevice *self)
 {
 	NMDevicePrivate *priv;
-	NMSettingsConnection *const*connections;
+	gs_free NMSettingsConnection **connections = NULL;
 	gboolean changed = FALSE;
 	GHashTableIter h_iter;
 	NMConnection *connection;
@@ -10108,7 +11533,9 @@ nm_device_recheck_available_connections (NMDevice *self)
 			g_hash_table_add (prune_list, connection);
 	}
 
-	connections = nm_settings_get_connections (priv->settings, NULL);
+	/* Connections bound to another interface name are never compatible,
+	 * only check the candidates for this device. */
+	connections = nm_settings_get_connections_for_iface (priv->settings, nm_device_get_iface (self), NULL);
 	for (i = 0; connections[i]; i++) {
 		connection = (NMConnection *) connections[i];
 
@@ -10192,14 +11619,20 @@ static void
 cp_connection_added_or_updated (NMDevice *self, NMConnection *connection)
 {
 	gboolean changed;
+	const char *iface;
 
 	g_return_if_fail (NM_IS_DEVICE (self));
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 
-	if (nm_device_check_connection_available (self,
-	                                          connection,
-	                                          _NM_DEVICE_CHECK_CON_AVAILABLE_FOR_USER_REQUEST,
-	                                          NULL))
+	/* Every device sees every change. Skip the full check for connections
+	 * that are bound to another interface, they can't be compatible. */
+	iface = nm_connection_get_interface_name (connection);
+	if (iface && g_strcmp0 (iface, nm_device_get_iface (self)))
+		changed = available_connections_del (self, connection);
+	else if (nm_device_check_connection_available (self,
+	                                               connection,
+	                                               _NM_DEVICE_CHECK_CON_AVAILABLE_FOR_USER_REQUEST,
+	                                               NULL))
 		changed = available_connections_add (self, connection);
 	else
 		changed = available_connections_del (self, connection);
@@ -10421,15 +11854,18 @@ _cleanup_generic_post (NMDevice *self, CleanupType cleanup_type)
 	g_clear_object (&priv->con_ip4_config);
 	g_clear_object (&priv->dev_ip4_config);
 	g_clear_object (&priv->ext_ip4_config);
+	g_clear_object (&priv->ext_ip4_config_captured);
 	g_clear_object (&priv->wwan_ip4_config);
 	g_clear_object (&priv->ip4_config);
 	g_clear_object (&priv->con_ip6_config);
 	g_clear_object (&priv->ac_ip6_config);
 	g_clear_object (&priv->ext_ip6_config);
 	g_clear_object (&priv->ext_ip6_config_captured);
+	_ext_ip_config_update_clear (&priv->ext_ip4_update);
+	_ext_ip_config_update_clear (&priv->ext_ip6_update);
 	g_clear_object (&priv->wwan_ip6_config);
 	g_clear_object (&priv->ip6_config);
-	g_clear_object (&priv->dad6_ip6_config);
+	dad6_cleanup (self);
 
 	g_slist_free_full (priv->vpn4_configs, g_object_unref);
 	priv->vpn4_configs = NULL;
@@ -10485,8 +11921,10 @@ nm_device_cleanup (NMDevice *self, NMDeviceStateReason reason, CleanupType clean
 	/* Turn off kernel IPv6 */
 	if (cleanup_type == CLEANUP_TYPE_DECONFIGURE) {
 		set_disable_ipv6 (self, "1");
-		nm_device_ipv6_sysctl_set (self, "accept_ra", "0");
-		nm_device_ipv6_sysctl_set (self, "use_tempaddr", "0");
+		nm_device_ipv6_sysctl_set_many (self,
+		                                "accept_ra", "0",
+		                                "use_tempaddr", "0",
+		                                NULL);
 	}
 
 	/* Call device type-specific deactivation */
@@ -10720,10 +12158,12 @@ ip6_managed_setup (NMDevice *self)
 {
 	set_nm_ipv6ll (self, TRUE);
 	set_disable_ipv6 (self, "1");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_defrtr", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_pinfo", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_rtr_pref", "0");
-	nm_device_ipv6_sysctl_set (self, "use_tempaddr", "0");
+	nm_device_ipv6_sysctl_set_many (self,
+	                                "accept_ra_defrtr", "0",
+	                                "accept_ra_pinfo", "0",
+	                                "accept_ra_rtr_pref", "0",
+	                                "use_tempaddr", "0",
+	                                NULL);
 }
 
 static void
@@ -10788,6 +12228,53 @@ deactivate_dispatcher_complete (guint call_id, gpointer user_data)
 		nm_device_queue_state (self, NM_DEVICE_STATE_DISCONNECTED, reason);
 }
 
+static void
+_record_state_statistics (NMDevice *self, NMDeviceState old_state, NMDeviceState state)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMStatisticsHistogram histogram;
+	gint64 now = g_get_monotonic_time ();
+
+	switch (old_state) {
+	case NM_DEVICE_STATE_PREPARE:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_PREPARE;
+		break;
+	case NM_DEVICE_STATE_CONFIG:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_CONFIG;
+		break;
+	case NM_DEVICE_STATE_NEED_AUTH:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_NEED_AUTH;
+		break;
+	case NM_DEVICE_STATE_IP_CONFIG:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CONFIG;
+		break;
+	case NM_DEVICE_STATE_IP_CHECK:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CHECK;
+		break;
+	case NM_DEVICE_STATE_SECONDARIES:
+		histogram = NM_STATISTICS_HISTOGRAM_ACTIVATION_SECONDARIES;
+		break;
+	default:
+		histogram = _NM_STATISTICS_HISTOGRAM_NUM;
+		break;
+	}
+	if (histogram != _NM_STATISTICS_HISTOGRAM_NUM && priv->state_timestamp_us)
+		nm_statistics_record (histogram, now - priv->state_timestamp_us);
+	priv->state_timestamp_us = now;
+
+	if (state == NM_DEVICE_STATE_PREPARE)
+		priv->activation_timestamp_us = now;
+	else if (state == NM_DEVICE_STATE_ACTIVATED) {
+		if (priv->activation_timestamp_us) {
+			nm_statistics_record (NM_STATISTICS_HISTOGRAM_ACTIVATION_TOTAL,
+			                      now - priv->activation_timestamp_us);
+		}
+		priv->activation_timestamp_us = 0;
+	} else if (   state < NM_DEVICE_STATE_PREPARE
+	           || state > NM_DEVICE_STATE_ACTIVATED)
+		priv->activation_timestamp_us = 0;
+}
+
 static void
 _set_state_full (NMDevice *self,
                  NMDeviceState state,
@@ -10836,14 +12323,30 @@ _set_state_full (NMDevice *self,
 	       state,
 	       reason);
 
+	NM_PROBE4 (device__state__change, priv->ifindex, (int) old_state, (int) state, (int) reason);
+
 	priv->in_state_changed = TRUE;
 
 	priv->state = state;
 	priv->state_reason = reason;
 
+	_record_state_statistics (self, old_state, state);
+
+	_timeline_add (self, "state", state_to_string (state));
+	if (   state == NM_DEVICE_STATE_ACTIVATED
+	    || state == NM_DEVICE_STATE_FAILED
+	    || state == NM_DEVICE_STATE_DEACTIVATING)
+		_timeline_finish (self);
+
 	/* Clear any queued transitions */
 	nm_device_queued_state_clear (self);
 
+	/* The activation slot is held from the request at the end of stage 2
+	 * until IP configuration finishes or the activation is aborted. */
+	if (   state < NM_DEVICE_STATE_PREPARE
+	    || state > NM_DEVICE_STATE_IP_CONFIG)
+		nm_activation_scheduler_release (nm_activation_scheduler_get (), self);
+
 	dispatcher_cleanup (self);
 	if (priv->deactivating_cancellable)
 		g_cancellable_cancel (priv->deactivating_cancellable);
@@ -11189,7 +12692,7 @@ nm_device_queue_state (NMDevice *self,
 
 	priv->queued_state.state = state;
 	priv->queued_state.reason = reason;
-	priv->queued_state.id = g_idle_add (queued_set_state, self);
+	priv->queued_state.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, queued_set_state, self);
 
 	_LOGD (LOGD_DEVICE, "queued state change to %s due to %s (id %d)",
 	       state_to_string (state), reason_to_string (reason),
@@ -11216,7 +12719,7 @@ nm_device_queued_state_clear (NMDevice *self)
 	if (priv->queued_state.id) {
 		_LOGD (LOGD_DEVICE, "clearing queued state transition (id %d)",
 		       priv->queued_state.id);
-		nm_clear_g_source (&priv->queued_state.id);
+		nm_clear_loop_sched (&priv->queued_state.id);
 		nm_device_remove_pending_action (self, queued_state_to_string (priv->queued_state.state), TRUE);
 	}
 	memset (&priv->queued_state, 0, sizeof (priv->queued_state));
@@ -11244,6 +12747,18 @@ nm_device_get_hw_address (NMDevice *self)
 	return priv->hw_addr_len ? priv->hw_addr : NULL;
 }
 
+/* nm_device_get_hw_address() in binary form */
+const NMHwAddr *
+nm_device_get_hw_address_bin (NMDevice *self)
+{
+	NMDevicePrivate *priv;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	return priv->hw_addr_len && priv->hw_addr_bin.len ? &priv->hw_addr_bin : NULL;
+}
+
 void
 nm_device_update_hw_address (NMDevice *self)
 {
@@ -11262,10 +12777,16 @@ nm_device_update_hw_address (NMDevice *self)
 		hwaddrlen = 0;
 
 	if (hwaddrlen) {
+		NMHwAddr new_addr;
+
 		priv->hw_addr_len = hwaddrlen;
-		if (!priv->hw_addr || !nm_utils_hwaddr_matches (priv->hw_addr, -1, hwaddr, hwaddrlen)) {
+		_nm_hwaddr_from_bin (&new_addr, hwaddr, hwaddrlen);
+		if (   !priv->hw_addr
+		    || new_addr.len != priv->hw_addr_bin.len
+		    || memcmp (new_addr.addr, priv->hw_addr_bin.addr, new_addr.len)) {
 			g_free (priv->hw_addr);
 			priv->hw_addr = nm_utils_hwaddr_ntoa (hwaddr, hwaddrlen);
+			priv->hw_addr_bin = new_addr;
 
 			_LOGD (LOGD_HW | LOGD_DEVICE, "hardware address now %s", priv->hw_addr);
 			_notify (self, PROP_HW_ADDRESS);
@@ -11275,6 +12796,7 @@ nm_device_update_hw_address (NMDevice *self)
 		if (priv->hw_addr_len != 0) {
 			g_clear_pointer (&priv->hw_addr, g_free);
 			priv->hw_addr_len = 0;
+			priv->hw_addr_bin.len = 0;
 			_LOGD (LOGD_HW | LOGD_DEVICE,
 			       "previous hardware address is no longer valid");
 			_notify (self, PROP_HW_ADDRESS);
@@ -11298,12 +12820,14 @@ nm_device_update_initial_hw_address (NMDevice *self)
 			if (nm_platform_link_get_permanent_address (NM_PLATFORM_GET, priv->ifindex, buf, &len)) {
 				g_warn_if_fail (len == priv->hw_addr_len);
 				priv->perm_hw_addr = nm_utils_hwaddr_ntoa (buf, priv->hw_addr_len);
+				_nm_hwaddr_from_bin (&priv->perm_hw_addr_bin, buf, priv->hw_addr_len);
 				_LOGD (LOGD_DEVICE | LOGD_HW, "read permanent MAC address %s",
 				       priv->perm_hw_addr);
 			} else {
 				/* Fall back to current address */
 				_LOGD (LOGD_HW | LOGD_ETHER, "unable to read permanent MAC address");
 				priv->perm_hw_addr = g_strdup (priv->hw_addr);
+				_nm_hwaddr_from_str (&priv->perm_hw_addr_bin, priv->perm_hw_addr);
 			}
 		}
 	}
@@ -11337,7 +12861,20 @@ nm_device_set_hw_addr (NMDevice *self, const char *addr,
 	/* Can't change MAC address while device is up */
 	nm_device_take_down (self, FALSE);
 
-	success = nm_platform_link_set_address (NM_PLATFORM_GET, nm_device_get_ip_ifindex (self), addr_bytes, priv->hw_addr_len);
+	if (NM_DEVICE_GET_CLASS (self)->bring_up == bring_up) {
+		NMPlatformLinkChangeAttrs attrs = {
+			.change = NM_PLATFORM_LINK_CHANGE_ADDRESS | NM_PLATFORM_LINK_CHANGE_FLAGS,
+			.address = addr_bytes,
+			.address_len = priv->hw_addr_len,
+			.flags_mask = IFF_UP,
+			.flags_set = IFF_UP,
+		};
+
+		/* kernel sets the address before the flags, so the link can
+		 * be brought up again with the same request. */
+		success = nm_platform_link_change_attrs (NM_PLATFORM_GET, nm_device_get_ip_ifindex (self), &attrs, NULL);
+	} else
+		success = nm_platform_link_set_address (NM_PLATFORM_GET, nm_device_get_ip_ifindex (self), addr_bytes, priv->hw_addr_len);
 	if (success) {
 		/* MAC address succesfully changed; update the current MAC to match */
 		nm_device_update_hw_address (self);
@@ -11367,6 +12904,18 @@ nm_device_get_permanent_hw_address (NMDevice *self)
 	return NM_DEVICE_GET_PRIVATE (self)->perm_hw_addr;
 }
 
+/* nm_device_get_permanent_hw_address() in binary form */
+const NMHwAddr *
+nm_device_get_permanent_hw_address_bin (NMDevice *self)
+{
+	NMDevicePrivate *priv;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	return priv->perm_hw_addr && priv->perm_hw_addr_bin.len ? &priv->perm_hw_addr_bin : NULL;
+}
+
 const char *
 nm_device_get_initial_hw_address (NMDevice *self)
 {
@@ -11435,6 +12984,37 @@ spec_match_list (NMDevice *self, const GSList *specs)
 	return matched;
 }
 
+/**
+ * nm_device_spec_match_compiled:
+ * @self: an #NMDevice
+ * @compiled: (allow-none): device specs compiled with nm_match_spec_compile()
+ *
+ * Like nm_device_spec_match_list(), but for a precompiled list of specs.
+ *
+ * Returns: #TRUE if @self matches @compiled
+ */
+gboolean
+nm_device_spec_match_compiled (NMDevice *self, NMMatchSpecCompiled *compiled)
+{
+	NMDevicePrivate *priv;
+	NMDeviceClass *klass;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+
+	if (!compiled)
+		return FALSE;
+
+	priv = NM_DEVICE_GET_PRIVATE (self);
+	klass = NM_DEVICE_GET_CLASS (self);
+
+	return nm_match_spec_compiled_match (compiled,
+	                                     nm_device_get_iface (self),
+	                                     priv->hw_addr_len ? priv->hw_addr : NULL,
+	                                     nm_device_get_type_description (self),
+	                                     klass->get_s390_subchannels ? klass->get_s390_subchannels (self) : NULL)
+	       == NM_MATCH_SPEC_MATCH;
+}
+
 /***********************************************************/
 
 static const char *
@@ -11568,6 +13148,8 @@ dispose (GObject *object)
 	g_signal_handlers_disconnect_by_func (platform, G_CALLBACK (device_ipx_changed), self);
 	g_signal_handlers_disconnect_by_func (platform, G_CALLBACK (link_changed_cb), self);
 
+	_stats_set_refresh_rate (self, 0);
+
 	g_slist_free_full (priv->arping.dad_list, (GDestroyNotify) nm_arping_manager_destroy);
 	priv->arping.dad_list = NULL;
 
@@ -11593,6 +13175,7 @@ dispose (GObject *object)
 	nm_clear_g_source (&priv->recheck_available.call_id);
 
 	nm_clear_g_source (&priv->check_delete_unrealized_id);
+	nm_clear_g_source (&priv->ip_config_dirty.idle_id);
 
 	link_disconnect_action_cancel (self);
 
@@ -11621,7 +13204,7 @@ dispose (GObject *object)
 
 	G_OBJECT_CLASS (nm_device_parent_class)->dispose (object);
 
-	if (nm_clear_g_source (&priv->queued_state.id)) {
+	if (nm_clear_loop_sched (&priv->queued_state.id)) {
 		/* FIXME: we'd expect the queud_state to be alredy cleared and this statement
 		 * not being necessary. Add this check here to hopefully investigate crash
 		 * rh#1270247. */
@@ -11644,14 +13227,15 @@ finalize (GObject *object)
 	g_slist_free_full (priv->dad6_failed_addrs, g_free);
 	g_clear_pointer (&priv->physical_port_id, g_free);
 	g_free (priv->udi);
-	g_free (priv->iface);
-	g_free (priv->ip_iface);
+	nm_intern_str_unref (priv->iface);
+	nm_intern_str_unref (priv->ip_iface);
 	g_free (priv->driver);
 	g_free (priv->driver_version);
 	g_free (priv->firmware_version);
 	g_free (priv->type_desc);
 	g_free (priv->type_description);
 	g_free (priv->dhcp_anycast_address);
+	g_free (priv->dhcp4.last_address);
 
 	g_hash_table_unref (priv->ip6_saved_properties);
 	g_hash_table_unref (priv->available_connections);
@@ -11683,7 +13267,7 @@ set_property (GObject *object, guint prop_id,
 	case PROP_IFACE:
 		/* construct only */
 		g_return_if_fail (!priv->iface);
-		priv->iface = g_value_dup_string (value);
+		priv->iface = nm_intern_str_ref (g_value_get_string (value));
 		break;
 	case PROP_DRIVER:
 		if (g_value_get_string (value)) {
@@ -11749,6 +13333,9 @@ set_property (GObject *object, guint prop_id,
 	case PROP_IS_MASTER:
 		priv->is_master = g_value_get_boolean (value);
 		break;
+	case PROP_STATISTICS_REFRESH_RATE_MS:
+		_stats_set_refresh_rate (self, g_value_get_uint (value));
+		break;
 	case PROP_HW_ADDRESS:
 		/* construct only */
 		p = hw_addr = g_value_get_string (value);
@@ -11769,11 +13356,13 @@ set_property (GObject *object, guint prop_id,
 
 		priv->hw_addr_len = count;
 		g_free (priv->hw_addr);
-		if (nm_utils_hwaddr_valid (hw_addr, priv->hw_addr_len))
+		if (   _nm_hwaddr_from_str (&priv->hw_addr_bin, hw_addr)
+		    && priv->hw_addr_bin.len == priv->hw_addr_len)
 			priv->hw_addr = g_strdup (hw_addr);
 		else {
 			_LOGW (LOGD_DEVICE, "could not parse hw-address '%s'", hw_addr);
 			priv->hw_addr = NULL;
+			priv->hw_addr_bin.len = 0;
 		}
 		break;
 	default:
@@ -11903,6 +13492,33 @@ get_property (GObject *object, guint prop_id,
 	case PROP_METERED:
 		g_value_set_uint (value, priv->metered);
 		break;
+	case PROP_CARRIER_FLAPS:
+		g_value_set_uint (value, priv->carrier_flap.count);
+		break;
+	case PROP_CARRIER_FLAPS_SUPPRESSED:
+		g_value_set_uint (value, priv->carrier_flap.suppressed);
+		break;
+	case PROP_CONNECTIVITY:
+		g_value_set_uint (value, priv->connectivity.state);
+		break;
+	case PROP_CONNECTIVITY_LATENCY:
+		g_value_set_uint (value, priv->connectivity.latency);
+		break;
+	case PROP_STATISTICS_REFRESH_RATE_MS:
+		g_value_set_uint (value, priv->stats.refresh_rate_ms);
+		break;
+	case PROP_STATISTICS_TX_BYTES:
+		g_value_set_uint64 (value, priv->stats.counters.tx_bytes);
+		break;
+	case PROP_STATISTICS_RX_BYTES:
+		g_value_set_uint64 (value, priv->stats.counters.rx_bytes);
+		break;
+	case PROP_STATISTICS_TX_PACKETS:
+		g_value_set_uint64 (value, priv->stats.counters.tx_packets);
+		break;
+	case PROP_STATISTICS_RX_PACKETS:
+		g_value_set_uint64 (value, priv->stats.counters.rx_packets);
+		break;
 	case PROP_LLDP_NEIGHBORS:
 		if (priv->lldp_listener)
 			g_value_set_variant (value, nm_lldp_listener_get_neighbors (priv->lldp_listener));
@@ -12166,6 +13782,26 @@ nm_device_class_init (NMDeviceClass *klass)
 	                          NULL,
 	                          G_PARAM_READABLE |
 	                          G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_CARRIER_FLAPS] =
+	    g_param_spec_uint (NM_DEVICE_CARRIER_FLAPS, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_CARRIER_FLAPS_SUPPRESSED] =
+	    g_param_spec_uint (NM_DEVICE_CARRIER_FLAPS_SUPPRESSED, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_CONNECTIVITY] =
+	    g_param_spec_uint (NM_DEVICE_CONNECTIVITY, "", "",
+	                       NM_CONNECTIVITY_UNKNOWN, NM_CONNECTIVITY_FULL, NM_CONNECTIVITY_UNKNOWN,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_CONNECTIVITY_LATENCY] =
+	    g_param_spec_uint (NM_DEVICE_CONNECTIVITY_LATENCY, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
 	obj_properties[PROP_REAL] =
 	    g_param_spec_boolean (NM_DEVICE_REAL, "", "",
 	                          FALSE,
@@ -12176,6 +13812,31 @@ nm_device_class_init (NMDeviceClass *klass)
 	                        G_TYPE_STRV,
 	                        G_PARAM_READABLE |
 	                        G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_STATISTICS_REFRESH_RATE_MS] =
+	    g_param_spec_uint (NM_DEVICE_STATISTICS_REFRESH_RATE_MS, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READWRITE |
+	                       G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_STATISTICS_TX_BYTES] =
+	    g_param_spec_uint64 (NM_DEVICE_STATISTICS_TX_BYTES, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_STATISTICS_RX_BYTES] =
+	    g_param_spec_uint64 (NM_DEVICE_STATISTICS_RX_BYTES, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_STATISTICS_TX_PACKETS] =
+	    g_param_spec_uint64 (NM_DEVICE_STATISTICS_TX_PACKETS, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
+	obj_properties[PROP_STATISTICS_RX_PACKETS] =
+	    g_param_spec_uint64 (NM_DEVICE_STATISTICS_RX_PACKETS, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
 
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
@@ -12210,14 +13871,14 @@ nm_device_class_init (NMDeviceClass *klass)
 	                  G_OBJECT_CLASS_TYPE (object_class),
 	                  G_SIGNAL_RUN_FIRST,
 	                  0, NULL, NULL, NULL,
-	                  G_TYPE_NONE, 2, G_TYPE_OBJECT, G_TYPE_OBJECT);
+	                  G_TYPE_NONE, 3, G_TYPE_OBJECT, G_TYPE_OBJECT, G_TYPE_UINT);
 
 	signals[IP6_CONFIG_CHANGED] =
 	    g_signal_new (NM_DEVICE_IP6_CONFIG_CHANGED,
 	                  G_OBJECT_CLASS_TYPE (object_class),
 	                  G_SIGNAL_RUN_FIRST,
 	                  0, NULL, NULL, NULL,
-	                  G_TYPE_NONE, 2, G_TYPE_OBJECT, G_TYPE_OBJECT);
+	                  G_TYPE_NONE, 3, G_TYPE_OBJECT, G_TYPE_OBJECT, G_TYPE_UINT);
 
 	signals[REMOVED] =
 	    g_signal_new (NM_DEVICE_REMOVED,
@@ -12247,4 +13908,8 @@ nm_device_class_init (NMDeviceClass *klass)
 	                                        "Disconnect", impl_device_disconnect,
 	                                        "Delete", impl_device_delete,
 	                                        NULL);
+
+	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (klass),
+	                                        NMDBUS_TYPE_DEVICE_STATISTICS_SKELETON,
+	                                        NULL);
 }
@@ -27,6 +27,7 @@
 #include "nm-exported-object.h"
 #include "nm-dbus-interface.h"
 #include "nm-connection.h"
+#include "nm-core-internal.h"
 #include "nm-rfkill-manager.h"
 #include "NetworkManagerUtils.h"
 
@@ -59,8 +60,18 @@
 #define NM_DEVICE_HW_ADDRESS       "hw-address"
 #define NM_DEVICE_METERED          "metered"
 #define NM_DEVICE_LLDP_NEIGHBORS  "lldp-neighbors"
+#define NM_DEVICE_CARRIER_FLAPS    "carrier-flaps"
+#define NM_DEVICE_CARRIER_FLAPS_SUPPRESSED "carrier-flaps-suppressed"
+#define NM_DEVICE_CONNECTIVITY     "connectivity"
+#define NM_DEVICE_CONNECTIVITY_LATENCY "connectivity-latency"
 #define NM_DEVICE_REAL             "real"
 
+#define NM_DEVICE_STATISTICS_REFRESH_RATE_MS "refresh-rate-ms"
+#define NM_DEVICE_STATISTICS_TX_BYTES        "tx-bytes"
+#define NM_DEVICE_STATISTICS_RX_BYTES        "rx-bytes"
+#define NM_DEVICE_STATISTICS_TX_PACKETS      "tx-packets"
+#define NM_DEVICE_STATISTICS_RX_PACKETS      "rx-packets"
+
 /* the "slaves" property is internal in the parent class, but exposed
  * by the derived classes NMDeviceBond, NMDeviceBridge and NMDeviceTeam.
  * It is thus important that the property name matches. */
@@ -168,6 +179,30 @@ typedef struct {
 	                                       const NMPlatformLink **out_plink,
 	                                       GError **error);
 
+	/**
+	 * create_link_request():
+	 * @self: the #NMDevice
+	 * @connection: the #NMConnection being activated
+	 * @parent: the parent #NMDevice, if any
+	 * @request: the platform link to create
+	 * @error: location to store error, or %NULL
+	 *
+	 * Like create_and_realize(), but only describes the kernel link in
+	 * @request instead of creating it, so that the links of several devices
+	 * can be created with one nm_platform_link_add_batch() call. Once the
+	 * link exists, create_link_finish() is called.
+	 *
+	 * Returns: %TRUE on success, %FALSE on error
+	 */
+	gboolean        (*create_link_request) (NMDevice *self,
+	                                        NMConnection *connection,
+	                                        NMDevice *parent,
+	                                        NMPlatformLinkAddRequest *request,
+	                                        GError **error);
+	void            (*create_link_finish)  (NMDevice *self,
+	                                        NMConnection *connection,
+	                                        NMDevice *parent);
+
 	/**
 	 * realize_start_notify():
 	 * @self: the #NMDevice
@@ -281,6 +316,9 @@ typedef struct {
 
 	NMMatchSpecMatchType (* spec_match_list)   (NMDevice *self, const GSList *specs);
 
+	/* the s390 subchannels matched by "s390-subchannels:" specs, or %NULL */
+	const char *(*get_s390_subchannels) (NMDevice *self);
+
 	/* Update the connection with currently configured L2 settings */
 	void            (* update_connection) (NMDevice *device, NMConnection *connection);
 
@@ -347,6 +385,9 @@ const char *    nm_device_get_type_description  (NMDevice *dev);
 NMDeviceType    nm_device_get_device_type       (NMDevice *dev);
 NMLinkType      nm_device_get_link_type         (NMDevice *dev);
 NMMetered       nm_device_get_metered           (NMDevice *dev);
+void            nm_device_set_connectivity      (NMDevice *dev,
+                                                 NMConnectivityState state,
+                                                 guint latency_msec);
 
 int             nm_device_get_priority          (NMDevice *dev);
 guint32         nm_device_get_ip4_route_metric  (NMDevice *dev);
@@ -355,6 +396,8 @@ guint32         nm_device_get_ip6_route_metric  (NMDevice *dev);
 const char *    nm_device_get_hw_address        (NMDevice *dev);
 const char *    nm_device_get_permanent_hw_address (NMDevice *dev);
 const char *    nm_device_get_initial_hw_address (NMDevice *dev);
+const NMHwAddr *nm_device_get_hw_address_bin    (NMDevice *dev);
+const NMHwAddr *nm_device_get_permanent_hw_address_bin (NMDevice *dev);
 
 NMDhcp4Config * nm_device_get_dhcp4_config      (NMDevice *dev);
 NMDhcp6Config * nm_device_get_dhcp6_config      (NMDevice *dev);
@@ -414,6 +457,7 @@ gboolean nm_device_uses_assumed_connection (NMDevice *device);
 gboolean nm_device_can_assume_active_connection (NMDevice *device);
 
 gboolean nm_device_spec_match_list (NMDevice *device, const GSList *specs);
+gboolean nm_device_spec_match_compiled (NMDevice *device, NMMatchSpecCompiled *compiled);
 
 gboolean nm_device_is_activating (NMDevice *dev);
 gboolean nm_device_autoconnect_allowed (NMDevice *self);
@@ -510,6 +554,16 @@ gboolean nm_device_create_and_realize (NMDevice *self,
                                        NMConnection *connection,
                                        NMDevice *parent,
                                        GError **error);
+
+typedef struct {
+	NMDevice *device;
+	NMConnection *connection;
+	NMDevice *parent;
+	GError *error;
+} NMDeviceCreateData;
+
+gboolean nm_device_can_create_batched (NMDevice *self);
+void     nm_device_create_and_realize_many (NMDeviceCreateData *data, guint len);
 gboolean nm_device_unrealize          (NMDevice *device,
                                        gboolean remove_resources,
                                        GError **error);
@@ -577,6 +631,8 @@ void nm_device_update_hw_address (NMDevice *self);
 void nm_device_update_initial_hw_address (NMDevice *self);
 void nm_device_update_dynamic_ip_setup (NMDevice *self);
 
+void nm_device_set_dhcp4_last_address (NMDevice *self, const char *address);
+
 G_END_DECLS
 
 #endif /* NM_DEVICE_H */
@@ -27,6 +27,7 @@
 
 #include "nm-platform.h"
 #include "nm-utils.h"
+#include "nm-statistics.h"
 
 #include "sd-lldp.h"
 
@@ -72,6 +73,10 @@ typedef struct {
 	sd_lldp      *lldp_handle;
 	GHashTable   *lldp_neighbors;
 
+	/* index of lldp_neighbors by the digest of the raw frame. It lets us
+	 * drop refreshed neighbors without parsing them again. */
+	GHashTable   *lldp_neighbors_by_raw;
+
 	/* the timestamp in nsec until which we delay updates. */
 	gint64        ratelimit_next;
 	guint         ratelimit_id;
@@ -99,6 +104,10 @@ typedef struct {
 
 	LldpAttrData attrs[_LLDP_PROP_ID_COUNT];
 
+	/* the neighbor as received, and the digest of its raw frame. */
+	sd_lldp_neighbor *neighbor_sd;
+	guint64 raw_digest;
+
 	GVariant *variant;
 } LldpNeighbor;
 
@@ -110,7 +119,7 @@ typedef struct {
     G_STMT_START { \
         const NMLogLevel _level = (level); \
         \
-        if (nm_logging_enabled (_level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (_level, _NMLOG_DOMAIN)) { \
             char _sbuf[64]; \
             int _ifindex = (self) ? NM_LLDP_LISTENER_GET_PRIVATE (self)->ifindex : 0; \
             \
@@ -303,7 +312,9 @@ lldp_neighbor_free (LldpNeighbor *neighbor)
 				g_free (neighbor->attrs[attr_id].v_string);
 		}
 		g_clear_pointer (&neighbor->variant, g_variant_unref);
+		sd_lldp_neighbor_unref (neighbor->neighbor_sd);
 		g_slice_free (LldpNeighbor, neighbor);
+		nm_statistics_memory_remove (NM_STATISTICS_MEMORY_LLDP_NEIGHBORS, sizeof (LldpNeighbor));
 	}
 }
 
@@ -323,7 +334,7 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 
 	if (   a->chassis_id_type != b->chassis_id_type
 	    || a->port_id_type != b->port_id_type
-	    || ether_addr_equal (&a->destination_address, &b->destination_address)
+	    || !ether_addr_equal (&a->destination_address, &b->destination_address)
 	    || !nm_streq0 (a->chassis_id, b->chassis_id)
 	    || !nm_streq0 (a->port_id, b->port_id))
 		return FALSE;
@@ -349,6 +360,32 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 	return TRUE;
 }
 
+static guint64
+lldp_neighbor_raw_digest (sd_lldp_neighbor *neighbor_sd)
+{
+	const void *raw;
+	size_t raw_len;
+
+	if (sd_lldp_neighbor_get_raw (neighbor_sd, &raw, &raw_len) < 0)
+		return NM_UTILS_DIGEST_INIT;
+	return nm_utils_digest_mem (NM_UTILS_DIGEST_INIT, raw, raw_len);
+}
+
+static gboolean
+lldp_neighbor_raw_equal (const LldpNeighbor *neigh, sd_lldp_neighbor *neighbor_sd)
+{
+	const void *raw_a, *raw_b;
+	size_t len_a, len_b;
+
+	if (neigh->neighbor_sd == neighbor_sd)
+		return TRUE;
+	if (   sd_lldp_neighbor_get_raw (neigh->neighbor_sd, &raw_a, &len_a) < 0
+	    || sd_lldp_neighbor_get_raw (neighbor_sd, &raw_b, &len_b) < 0)
+		return FALSE;
+	return    len_a == len_b
+	       && memcmp (raw_a, raw_b, len_a) == 0;
+}
+
 static LldpNeighbor *
 lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 {
@@ -388,8 +425,11 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 	}
 
 	neigh = g_slice_new0 (LldpNeighbor);
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_LLDP_NEIGHBORS, sizeof (LldpNeighbor));
 	neigh->chassis_id_type = chassis_id_type;
 	neigh->port_id_type = port_id_type;
+	neigh->neighbor_sd = sd_lldp_neighbor_ref (neighbor_sd);
+	neigh->raw_digest = lldp_neighbor_raw_digest (neighbor_sd);
 
 	r = sd_lldp_neighbor_get_destination_address (neighbor_sd, &neigh->destination_address);
 	if (r < 0) {
@@ -636,6 +676,24 @@ data_changed_schedule (NMLldpListener *self)
 		priv->ratelimit_id = g_timeout_add (NM_UTILS_NS_TO_MSEC_CEIL (priv->ratelimit_next - now), data_changed_timeout, self);
 }
 
+static void
+lldp_neighbor_remove (NMLldpListenerPrivate *priv, LldpNeighbor *neigh)
+{
+	if (g_hash_table_lookup (priv->lldp_neighbors_by_raw, &neigh->raw_digest) == neigh)
+		g_hash_table_remove (priv->lldp_neighbors_by_raw, &neigh->raw_digest);
+	g_hash_table_remove (priv->lldp_neighbors, neigh);
+}
+
+static void
+lldp_neighbor_add (NMLldpListenerPrivate *priv, LldpNeighbor *neigh)
+{
+	g_hash_table_add (priv->lldp_neighbors, neigh);
+
+	/* on a digest collision, the second neighbor is just not indexed. */
+	if (!g_hash_table_contains (priv->lldp_neighbors_by_raw, &neigh->raw_digest))
+		g_hash_table_insert (priv->lldp_neighbors_by_raw, &neigh->raw_digest, neigh);
+}
+
 static void
 process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboolean neighbor_valid)
 {
@@ -645,6 +703,7 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	gs_free_error GError *parse_error = NULL;
 	GError **p_parse_error;
 	gboolean changed = FALSE;
+	guint64 raw_digest;
 
 	g_return_if_fail (NM_IS_LLDP_LISTENER (self));
 
@@ -653,6 +712,21 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	g_return_if_fail (priv->lldp_handle);
 	g_return_if_fail (neighbor_sd);
 
+	/* Most frames are periodic refreshes of a neighbor we already know.
+	 * Recognize them by the raw frame before doing any parsing. */
+	raw_digest = lldp_neighbor_raw_digest (neighbor_sd);
+	neigh_old = g_hash_table_lookup (priv->lldp_neighbors_by_raw, &raw_digest);
+	if (neigh_old && lldp_neighbor_raw_equal (neigh_old, neighbor_sd)) {
+		if (neighbor_valid)
+			return;
+
+		_LOGT ("process: %s neigh: "LOG_NEIGH_FMT,
+		       "remove", LOG_NEIGH_ARG (neigh_old));
+		lldp_neighbor_remove (priv, neigh_old);
+		data_changed_schedule (self);
+		return;
+	}
+
 	p_parse_error = _LOGT_ENABLED () ? &parse_error : NULL;
 
 	neigh = lldp_neighbor_new (neighbor_sd, p_parse_error);
@@ -671,11 +745,21 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 			       "remove", LOG_NEIGH_ARG (neigh),
 			       NM_PRINT_FMT_QUOTED (parse_error, " (failed to parse: ", parse_error->message, ")", ""));
 
-			g_hash_table_remove (priv->lldp_neighbors, neigh_old);
+			lldp_neighbor_remove (priv, neigh_old);
 			changed = TRUE;
 			goto done;
-		} else if (lldp_neighbor_equal (neigh_old, neigh))
+		} else if (lldp_neighbor_equal (neigh_old, neigh)) {
+			/* only unknown TLVs changed. Keep the old neighbor but
+			 * index the new frame, so that its refreshes are cheap. */
+			if (g_hash_table_lookup (priv->lldp_neighbors_by_raw, &neigh_old->raw_digest) == neigh_old)
+				g_hash_table_remove (priv->lldp_neighbors_by_raw, &neigh_old->raw_digest);
+			sd_lldp_neighbor_unref (neigh_old->neighbor_sd);
+			neigh_old->neighbor_sd = sd_lldp_neighbor_ref (neighbor_sd);
+			neigh_old->raw_digest = neigh->raw_digest;
+			if (!g_hash_table_contains (priv->lldp_neighbors_by_raw, &neigh_old->raw_digest))
+				g_hash_table_insert (priv->lldp_neighbors_by_raw, &neigh_old->raw_digest, neigh_old);
 			return;
+		}
 	} else if (!neighbor_valid) {
 		if (parse_error)
 			_LOGT ("process: failed to parse neighbor: %s", parse_error->message);
@@ -694,7 +778,9 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	        LOG_NEIGH_ARG (neigh));
 
 	changed = TRUE;
-	g_hash_table_add (priv->lldp_neighbors, g_steal_pointer (&neigh));
+	if (neigh_old)
+		lldp_neighbor_remove (priv, neigh_old);
+	lldp_neighbor_add (priv, g_steal_pointer (&neigh));
 
 done:
 	if (changed)
@@ -786,6 +872,7 @@ nm_lldp_listener_stop (NMLldpListener *self)
 		priv->lldp_handle = NULL;
 
 		size = g_hash_table_size (priv->lldp_neighbors);
+		g_hash_table_remove_all (priv->lldp_neighbors_by_raw);
 		g_hash_table_remove_all (priv->lldp_neighbors);
 		if (size || priv->ratelimit_id)
 			changed = TRUE;
@@ -857,6 +944,7 @@ nm_lldp_listener_init (NMLldpListener *self)
 	priv->lldp_neighbors = g_hash_table_new_full (lldp_neighbor_id_hash,
 	                                              lldp_neighbor_id_equal,
 	                                              (GDestroyNotify) lldp_neighbor_free, NULL);
+	priv->lldp_neighbors_by_raw = g_hash_table_new (g_int64_hash, g_int64_equal);
 
 	_LOGT ("lldp listener created");
 }
@@ -882,6 +970,7 @@ finalize (GObject *object)
 	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
 	nm_lldp_listener_stop (self);
+	g_hash_table_unref (priv->lldp_neighbors_by_raw);
 	g_hash_table_unref (priv->lldp_neighbors);
 
 	nm_clear_g_variant (&priv->variant);
@@ -57,6 +57,11 @@ typedef struct {
 	guint teamd_dbus_watch;
 	gboolean teamd_dbus_name_owned;
 	char *config;
+
+	/* port configs read from teamd over priv->tdc, by the iface (not
+	 * the ip_iface) of the port. Dropped whenever the control connection
+	 * goes away. */
+	GHashTable *port_configs;
 } NMDeviceTeamPrivate;
 
 static gboolean teamd_start (NMDevice *device, NMSettingTeam *s_team);
@@ -143,7 +148,16 @@ ensure_teamd_connection (NMDevice *device)
 
 	priv->tdc = teamdctl_alloc ();
 	g_assert (priv->tdc);
-	err = teamdctl_connect (priv->tdc, nm_device_get_iface (device), NULL, NULL);
+
+	/* Prefer teamd's unix control socket (we start teamd with -U). The
+	 * connection is kept for the life time of teamd, so every following
+	 * config and port request is a single round trip on that socket,
+	 * instead of a D-Bus method call routed through the bus daemon. */
+	err = teamdctl_connect (priv->tdc, nm_device_get_iface (device), NULL, "usock");
+	if (err != 0) {
+		_LOGD (LOGD_TEAM, "failed to connect to teamd control socket (err=%d), trying other methods", err);
+		err = teamdctl_connect (priv->tdc, nm_device_get_iface (device), NULL, NULL);
+	}
 	if (err != 0) {
 		_LOGE (LOGD_TEAM, "failed to connect to teamd (err=%d)", err);
 		teamdctl_free (priv->tdc);
@@ -187,7 +201,9 @@ update_connection (NMDevice *device, NMConnection *connection)
 	}
 
 	/* Read the configuration only if not already set */
-	if (!priv->config && ensure_teamd_connection (device))
+	if (priv->config)
+		_LOGD (LOGD_TEAM, "using the cached teamd config");
+	else if (ensure_teamd_connection (device))
 		teamd_read_config (device);
 
 	g_object_set (G_OBJECT (s_team), NM_SETTING_TEAM_CONFIG, priv->config, NULL);
@@ -196,52 +212,45 @@ update_connection (NMDevice *device, NMConnection *connection)
 /******************************************************************/
 
 static gboolean
-master_update_slave_connection (NMDevice *self,
-                                   NMDevice *slave,
-                                   NMConnection *connection,
-                                   GError **error)
+master_update_slave_connection (NMDevice *device,
+                                NMDevice *slave,
+                                NMConnection *connection,
+                                GError **error)
 {
+	NMDeviceTeam *self = NM_DEVICE_TEAM (device);
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
 	NMSettingTeamPort *s_port;
-	char *port_config = NULL;
+	const char *port_config;
 	int err = 0;
-	struct teamdctl *tdc;
-	const char *team_port_config = NULL;
-	const char *iface = nm_device_get_iface (self);
+	const char *iface = nm_device_get_iface (device);
 	const char *iface_slave = nm_device_get_iface (slave);
 
-	tdc = teamdctl_alloc ();
-	if (!tdc) {
+	if (!ensure_teamd_connection (device)) {
 		g_set_error (error,
 		             NM_DEVICE_ERROR,
 		             NM_DEVICE_ERROR_FAILED,
-		             "update slave connection for slave '%s' failed to connect to teamd for master %s (out of memory?)",
+		             "update slave connection for slave '%s' failed to connect to teamd for master %s",
 		             iface_slave, iface);
-		g_return_val_if_reached (FALSE);
-	}
-
-	err = teamdctl_connect (tdc, iface, NULL, NULL);
-	if (err) {
-		teamdctl_free (tdc);
-		g_set_error (error,
-		             NM_DEVICE_ERROR,
-		             NM_DEVICE_ERROR_FAILED,
-		             "update slave connection for slave '%s' failed to connect to teamd for master %s (err=%d)",
-		             iface_slave, iface, err);
 		return FALSE;
 	}
 
-	err = teamdctl_port_config_get_raw_direct (tdc, iface_slave, (char **)&team_port_config);
-	port_config = g_strdup (team_port_config);
-	teamdctl_disconnect (tdc);
-	teamdctl_free (tdc);
-	if (err) {
-		g_set_error (error,
-		             NM_DEVICE_ERROR,
-		             NM_DEVICE_ERROR_FAILED,
-		             "update slave connection for slave '%s' failed to get configuration from teamd master %s (err=%d)",
-		             iface_slave, iface, err);
-		g_free (port_config);
-		return FALSE;
+	port_config = g_hash_table_lookup (priv->port_configs, iface_slave);
+	if (port_config)
+		_LOGD (LOGD_TEAM, "using the cached config of team port %s", iface_slave);
+	else {
+		char *team_port_config = NULL;
+
+		err = teamdctl_port_config_get_raw_direct (priv->tdc, iface_slave, &team_port_config);
+		if (err) {
+			g_set_error (error,
+			             NM_DEVICE_ERROR,
+			             NM_DEVICE_ERROR_FAILED,
+			             "update slave connection for slave '%s' failed to get configuration from teamd master %s (err=%d)",
+			             iface_slave, iface, err);
+			return FALSE;
+		}
+		port_config = g_strdup (team_port_config ?: "");
+		g_hash_table_insert (priv->port_configs, g_strdup (iface_slave), (char *) port_config);
 	}
 
 	s_port = nm_connection_get_setting_team_port (connection);
@@ -250,8 +259,7 @@ master_update_slave_connection (NMDevice *self,
 		nm_connection_add_setting (connection, NM_SETTING (s_port));
 	}
 
-	g_object_set (G_OBJECT (s_port), NM_SETTING_TEAM_PORT_CONFIG, port_config, NULL);
-	g_free (port_config);
+	g_object_set (G_OBJECT (s_port), NM_SETTING_TEAM_PORT_CONFIG, port_config[0] ? port_config : NULL, NULL);
 
 	g_object_set (nm_connection_get_setting_connection (connection),
 	              NM_SETTING_CONNECTION_MASTER, iface,
@@ -279,6 +287,7 @@ teamd_cleanup (NMDevice *device, gboolean free_tdc)
 		teamdctl_disconnect (priv->tdc);
 		teamdctl_free (priv->tdc);
 		priv->tdc = NULL;
+		g_hash_table_remove_all (priv->port_configs);
 	}
 }
 
@@ -614,8 +623,6 @@ enslave_slave (NMDevice *device,
 	nm_device_master_check_slave_physical_port (device, slave, LOGD_TEAM);
 
 	if (configure) {
-		nm_device_take_down (slave, TRUE);
-
 		s_team_port = nm_connection_get_setting_team_port (connection);
 		if (s_team_port) {
 			const char *config = nm_setting_team_port_get_config (s_team_port);
@@ -631,6 +638,7 @@ enslave_slave (NMDevice *device,
 					sanitized_config = g_strdelimit (g_strdup (config), "\r\n", ' ');
 					err = teamdctl_port_config_update_raw (priv->tdc, slave_iface, sanitized_config);
 					g_free (sanitized_config);
+					g_hash_table_remove (priv->port_configs, nm_device_get_iface (slave));
 					if (err != 0) {
 						_LOGE (LOGD_TEAM, "failed to update config for port %s (err=%d)",
 						       slave_iface, err);
@@ -639,9 +647,7 @@ enslave_slave (NMDevice *device,
 				}
 			}
 		}
-		success = nm_platform_link_enslave (NM_PLATFORM_GET,
-		                                    nm_device_get_ip_ifindex (device),
-		                                    nm_device_get_ip_ifindex (slave));
+		success = nm_device_master_enslave_link (device, slave);
 		nm_device_bring_up (slave, TRUE, &no_firmware);
 
 		if (!success)
@@ -660,8 +666,11 @@ release_slave (NMDevice *device,
                gboolean configure)
 {
 	NMDeviceTeam *self = NM_DEVICE_TEAM (device);
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
 	gboolean success, no_firmware = FALSE;
 
+	g_hash_table_remove (priv->port_configs, nm_device_get_iface (slave));
+
 	if (configure) {
 		success = nm_platform_link_release (NM_PLATFORM_GET,
 		                                    nm_device_get_ip_ifindex (device),
@@ -741,6 +750,9 @@ get_property (GObject *object, guint prop_id,
 static void
 nm_device_team_init (NMDeviceTeam * self)
 {
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
+
+	priv->port_configs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
 
 static void
@@ -777,6 +789,7 @@ dispose (GObject *object)
 
 	teamd_cleanup (device, TRUE);
 	g_clear_pointer (&priv->config, g_free);
+	g_clear_pointer (&priv->port_configs, g_hash_table_unref);
 
 	G_OBJECT_CLASS (nm_device_team_parent_class)->dispose (object);
 }
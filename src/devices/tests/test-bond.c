@@ -0,0 +1,97 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-device-bond.h"
+#include "test-common.h"
+
+#define IFACE_BOND "nm-test-bond0"
+
+#define ARP_OPTIONS_MASK (  (1u << NM_PLATFORM_BOND_OPT_ARP_INTERVAL) \
+                          | (1u << NM_PLATFORM_BOND_OPT_ARP_VALIDATE) \
+                          | (1u << NM_PLATFORM_BOND_OPT_ARP_IP_TARGET))
+
+static void
+test_miimon_mode (gconstpointer user_data)
+{
+	const char *mode = user_data;
+	gs_unref_object NMSettingBond *s_bond = NULL;
+	gs_unref_ptrarray GPtrArray *sysfs_attrs = NULL;
+	NMPlatformBondChange change = { 0 };
+	const NMPlatformLink *link;
+	gboolean arp_supported;
+	guint i;
+
+	arp_supported = !NM_IN_STRSET (mode, "802.3ad", "balance-alb", "balance-tlb");
+
+	s_bond = (NMSettingBond *) nm_setting_bond_new ();
+	g_assert (nm_setting_bond_add_option (s_bond, NM_SETTING_BOND_OPTION_MODE, mode));
+	g_assert (nm_setting_bond_add_option (s_bond, NM_SETTING_BOND_OPTION_MIIMON, "100"));
+	g_assert (nm_setting_bond_add_option (s_bond, NM_SETTING_BOND_OPTION_ARP_IP_TARGET, "192.0.2.1"));
+
+	g_assert (_nm_device_bond_config_to_change (s_bond, &change, &sysfs_attrs));
+
+	g_assert (NM_FLAGS_HAS (change.set, 1u << NM_PLATFORM_BOND_OPT_MIIMON));
+	g_assert_cmpint (change.values[NM_PLATFORM_BOND_OPT_MIIMON], ==, 100);
+	if (arp_supported) {
+		g_assert (NM_FLAGS_HAS (change.set, 1u << NM_PLATFORM_BOND_OPT_ARP_INTERVAL));
+		g_assert_cmpint (change.values[NM_PLATFORM_BOND_OPT_ARP_INTERVAL], ==, 0);
+		g_assert (NM_FLAGS_HAS (change.set, 1u << NM_PLATFORM_BOND_OPT_ARP_IP_TARGET));
+		g_assert_cmpint (change.n_arp_ip_targets, ==, 1);
+	} else {
+		g_assert_cmpint (change.set & ARP_OPTIONS_MASK, ==, 0);
+		for (i = 0; i < sysfs_attrs->len; i++)
+			g_assert (!g_str_has_prefix (sysfs_attrs->pdata[i], "arp_"));
+	}
+
+	/* the kernel must accept the whole request, otherwise the options
+	 * end up partially applied and NM falls back to sysfs. */
+	g_assert_cmpint (nm_platform_link_bond_add (NM_PLATFORM_GET, IFACE_BOND, &link), ==, NM_PLATFORM_ERROR_SUCCESS);
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, link->ifindex, &change));
+	nmtstp_link_del (NULL, -1, link->ifindex, IFACE_BOND);
+}
+
+void
+_nmtstp_init_tests (int *argc, char ***argv)
+{
+	nmtst_init_with_logging (argc, argv, NULL, "ALL");
+}
+
+void
+_nmtstp_setup_tests (void)
+{
+	static const char *const modes[] = {
+		"balance-rr",
+		"active-backup",
+		"balance-xor",
+		"broadcast",
+		"802.3ad",
+		"balance-tlb",
+		"balance-alb",
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (modes); i++) {
+		gs_free char *path = g_strdup_printf ("/bond/miimon/%s", modes[i]);
+
+		g_test_add_data_func (path, modes[i], test_miimon_mode);
+	}
+}
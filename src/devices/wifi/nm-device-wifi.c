@@ -61,6 +61,15 @@ _LOG_DECLARE_SELF(NMDeviceWifi);
 #define SCAN_INTERVAL_STEP 20
 #define SCAN_INTERVAL_MAX 120
 
+/* While connected, periodic scans only probe the channels where known
+ * networks were seen, with a full scan after every SCAN_PARTIAL_PER_FULL
+ * of those partial scans. A weak or dropping signal of the current AP
+ * keeps the scans frequent, to find a better AP to roam to. */
+#define SCAN_PARTIAL_PER_FULL 4
+#define SCAN_PARTIAL_INTERVAL_MAX 60
+#define SCAN_STRENGTH_WEAK 40
+#define SCAN_STRENGTH_DROP 10
+
 #define WIRELESS_SECRETS_TRIES "wireless-secrets-tries"
 
 G_DEFINE_TYPE (NMDeviceWifi, nm_device_wifi, NM_TYPE_DEVICE)
@@ -95,6 +104,8 @@ struct _NMDeviceWifiPrivate {
 	gint8             invalid_strength_counter;
 
 	GHashTable *      aps;
+	GHashTable *      aps_by_supplicant_path;
+	GPtrArray *       aps_sorted; /* the APs in @aps by ascending ID */
 	NMAccessPoint *   current_ap;
 	guint32           rate;
 	gboolean          enabled; /* rfkilled or not */
@@ -106,6 +117,20 @@ struct _NMDeviceWifiPrivate {
 	guint             ap_dump_id;
 	bool              requested_scan;
 
+	GArray *          scan_freqs; /* guint32 MHz of channels with known networks */
+	/* the SSIDs and the seen BSSIDs of the infrastructure connections.
+	 * Rebuilt by update_scan_freqs() after the connections changed. */
+	GHashTable *      scan_known_ssids;
+	GHashTable *      scan_known_bssids;
+	bool              scan_known_valid;
+	guint8            scan_partial_count;
+	gint8             scan_last_strength;
+
+	/* re-associations while activated, which keep the IP configuration */
+	gint64            roam_start_ms;
+	guint             roam_count;
+	gint64            roam_total_ms;
+
 	NMSupplicantManager   *sup_mgr;
 	NMSupplicantInterface *sup_iface;
 	guint                  sup_timeout_id; /* supplicant association timeout */
@@ -169,6 +194,15 @@ static void ap_add_remove (NMDeviceWifi *self,
 
 static void remove_supplicant_interface_error_handler (NMDeviceWifi *self);
 
+static void scan_known_connection_changed (NMSettings *settings,
+                                           NMSettingsConnection *connection,
+                                           NMDeviceWifi *self);
+
+static void scan_known_connection_updated (NMSettings *settings,
+                                           NMSettingsConnection *connection,
+                                           gboolean by_user,
+                                           NMDeviceWifi *self);
+
 /*****************************************************************/
 
 static void
@@ -184,6 +218,19 @@ constructed (GObject *object)
 
 	/* Connect to the supplicant manager */
 	priv->sup_mgr = g_object_ref (nm_supplicant_manager_get ());
+
+	g_signal_connect (nm_device_get_settings ((NMDevice *) self),
+	                  NM_SETTINGS_SIGNAL_CONNECTION_ADDED,
+	                  G_CALLBACK (scan_known_connection_changed),
+	                  self);
+	g_signal_connect (nm_device_get_settings ((NMDevice *) self),
+	                  NM_SETTINGS_SIGNAL_CONNECTION_UPDATED,
+	                  G_CALLBACK (scan_known_connection_updated),
+	                  self);
+	g_signal_connect (nm_device_get_settings ((NMDevice *) self),
+	                  NM_SETTINGS_SIGNAL_CONNECTION_REMOVED,
+	                  G_CALLBACK (scan_known_connection_changed),
+	                  self);
 }
 
 static gboolean
@@ -277,17 +324,8 @@ get_ap_by_path (NMDeviceWifi *self, const char *path)
 static NMAccessPoint *
 get_ap_by_supplicant_path (NMDeviceWifi *self, const char *path)
 {
-	GHashTableIter iter;
-	NMAccessPoint *ap;
-
 	g_return_val_if_fail (path != NULL, NULL);
-
-	g_hash_table_iter_init (&iter, NM_DEVICE_WIFI_GET_PRIVATE (self)->aps);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ap)) {
-		if (g_strcmp0 (path, nm_ap_get_supplicant_path (ap)) == 0)
-			return ap;
-	}
-	return NULL;
+	return g_hash_table_lookup (NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_by_supplicant_path, path);
 }
 
 static void
@@ -304,8 +342,13 @@ update_seen_bssids_cache (NMDeviceWifi *self, NMAccessPoint *ap)
 
 	if (   nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_ACTIVATED
 	    && nm_device_has_unmodified_applied_connection (NM_DEVICE (self), NM_SETTING_COMPARE_FLAG_NONE)) {
+		NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
 		nm_settings_connection_add_seen_bssid (nm_device_get_settings_connection (NM_DEVICE (self)),
 		                                       nm_ap_get_address (ap));
+		/* adding a seen BSSID doesn't signal a connection update. */
+		if (priv->scan_known_valid && nm_ap_get_address (ap))
+			g_hash_table_add (priv->scan_known_bssids, g_ascii_strdown (nm_ap_get_address (ap), -1));
 	}
 }
 
@@ -323,6 +366,8 @@ set_current_ap (NMDeviceWifi *self, NMAccessPoint *new_ap, gboolean recheck_avai
 	if (old_ap == new_ap)
 		return;
 
+	priv->scan_last_strength = new_ap ? nm_ap_get_strength (new_ap) : 0;
+
 	if (new_ap) {
 		priv->current_ap = g_object_ref (new_ap);
 
@@ -425,15 +470,33 @@ ap_add_remove (NMDeviceWifi *self,
 	nm_assert (NM_IN_SET (signum, ACCESS_POINT_ADDED, ACCESS_POINT_REMOVED));
 
 	if (signum == ACCESS_POINT_ADDED) {
+		const char *supplicant_path;
+
 		g_hash_table_insert (priv->aps,
 		                     (gpointer) nm_exported_object_export ((NMExportedObject *) ap),
 		                     g_object_ref (ap));
+
+		/* export IDs only ever grow, so appending keeps the list sorted. */
+		nm_assert (   !priv->aps_sorted->len
+		           || nm_ap_get_id (priv->aps_sorted->pdata[priv->aps_sorted->len - 1]) < nm_ap_get_id (ap));
+		g_ptr_array_add (priv->aps_sorted, ap);
+
+		supplicant_path = nm_ap_get_supplicant_path (ap);
+		if (supplicant_path)
+			g_hash_table_insert (priv->aps_by_supplicant_path, (gpointer) supplicant_path, ap);
 	}
 
 	g_signal_emit (self, signals[signum], 0, ap);
 	g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_ACCESS_POINTS);
 
 	if (signum == ACCESS_POINT_REMOVED) {
+		const char *supplicant_path;
+
+		supplicant_path = nm_ap_get_supplicant_path (ap);
+		if (   supplicant_path
+		    && g_hash_table_lookup (priv->aps_by_supplicant_path, supplicant_path) == ap)
+			g_hash_table_remove (priv->aps_by_supplicant_path, supplicant_path);
+		g_ptr_array_remove (priv->aps_sorted, ap);
 		g_hash_table_remove (priv->aps, nm_exported_object_get_path ((NMExportedObject *) ap));
 		nm_exported_object_unexport ((NMExportedObject *) ap);
 		g_object_unref (ap);
@@ -448,19 +511,17 @@ static void
 remove_all_aps (NMDeviceWifi *self)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	GHashTableIter iter;
-	NMAccessPoint *ap;
 
-	if (!g_hash_table_size (priv->aps))
+	if (!priv->aps_sorted->len)
 		return;
 
 	set_current_ap (self, NULL, FALSE);
 
-again:
-	g_hash_table_iter_init (&iter, priv->aps);
-	if (g_hash_table_iter_next (&iter, NULL, (gpointer) &ap)) {
-		ap_add_remove (self, ACCESS_POINT_REMOVED, ap, FALSE);
-		goto again;
+	/* removing from the end of the list avoids moving the remaining entries. */
+	while (priv->aps_sorted->len) {
+		ap_add_remove (self, ACCESS_POINT_REMOVED,
+		               priv->aps_sorted->pdata[priv->aps_sorted->len - 1],
+		               FALSE);
 	}
 
 	nm_device_recheck_available_connections (NM_DEVICE (self));
@@ -478,6 +539,10 @@ deactivate (NMDevice *device)
 
 	cleanup_association_attempt (self, TRUE);
 
+	priv->roam_start_ms = 0;
+	priv->roam_count = 0;
+	priv->roam_total_ms = 0;
+
 	priv->rate = 0;
 
 	set_current_ap (self, NULL, TRUE);
@@ -611,27 +676,77 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 	return TRUE;
 }
 
+/* The band that APs are preferred on, from the "wifi.band-preference"
+ * connection default: 5 for "a", 2 for "bg", otherwise 0. */
+static guint
+get_band_preference (NMDeviceWifi *self)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_connection_default (NM_CONFIG_GET_DATA,
+	                                               "wifi.band-preference",
+	                                               NM_DEVICE (self));
+	if (nm_streq0 (value, "a"))
+		return 5;
+	if (nm_streq0 (value, "bg"))
+		return 2;
+	return 0;
+}
+
+/* How much throughput the AP promises. An AP in the preferred band
+ * counts double, so that it wins unless the other is much better. */
+static guint64
+ap_get_score (NMAccessPoint *ap, guint band_preference)
+{
+	guint64 score;
+
+	score = nm_ap_get_throughput_estimate (ap);
+	if (band_preference && nm_ap_get_band (ap) == band_preference)
+		score *= 2;
+	return score;
+}
+
 static NMAccessPoint *
 find_first_compatible_ap (NMDeviceWifi *self,
                           NMConnection *connection,
                           gboolean allow_unstable_order)
 {
-	GHashTableIter iter;
-	NMAccessPoint *ap;
-	NMAccessPoint *cand_ap = NULL;
+	GPtrArray *aps_sorted = NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_sorted;
+	NMAccessPoint *best_ap = NULL;
+	guint64 best_score = 0, score;
+	guint band_preference;
+	guint i;
 
 	g_return_val_if_fail (connection != NULL, NULL);
 
-	g_hash_table_iter_init (&iter, NM_DEVICE_WIFI_GET_PRIVATE (self)->aps);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ap)) {
+	if (allow_unstable_order) {
+		/* walking the sorted list backwards finds the AP with the highest ID
+		 * first, which is as cheap as any unstable order. */
+		for (i = aps_sorted->len; i > 0; i--) {
+			NMAccessPoint *ap = aps_sorted->pdata[i - 1];
+
+			if (nm_ap_check_compatible (ap, connection))
+				return ap;
+		}
+		return NULL;
+	}
+
+	/* pick the compatible AP with the highest estimated throughput.
+	 * On a tie, the AP with the highest ID wins. */
+	band_preference = get_band_preference (self);
+	for (i = aps_sorted->len; i > 0; i--) {
+		NMAccessPoint *ap = aps_sorted->pdata[i - 1];
+
 		if (!nm_ap_check_compatible (ap, connection))
 			continue;
-		if (allow_unstable_order)
-			return ap;
-		if (!cand_ap || (nm_ap_get_id (cand_ap) < nm_ap_get_id (ap)))
-			cand_ap = ap;
+
+		score = ap_get_score (ap, band_preference);
+		if (!best_ap || score > best_score) {
+			best_ap = ap;
+			best_score = score;
+		}
 	}
-	return cand_ap;
+	return best_ap;
 }
 
 static gboolean
@@ -959,66 +1074,43 @@ can_auto_connect (NMDevice *device,
 	return FALSE;
 }
 
-static gint
-ap_id_compare (NMAccessPoint *a, NMAccessPoint *b)
+static const char **
+get_sorted_ap_paths (NMDeviceWifi *self, gboolean with_ssid_only)
 {
-	guint32 a_id = nm_ap_get_id (a);
-	guint32 b_id = nm_ap_get_id (b);
+	GPtrArray *aps_sorted = NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_sorted;
+	const char **paths;
+	guint i, n;
 
-	return a_id < b_id ? -1 : (a_id == b_id ? 0 : 1);
-}
+	paths = g_new (const char *, aps_sorted->len + 1);
+	for (i = 0, n = 0; i < aps_sorted->len; i++) {
+		NMAccessPoint *ap = aps_sorted->pdata[i];
 
-static GSList *
-get_sorted_ap_list (NMDeviceWifi *self)
-{
-	GSList *sorted = NULL;
-	GHashTableIter iter;
-	NMAccessPoint *ap;
-
-	g_hash_table_iter_init (&iter, NM_DEVICE_WIFI_GET_PRIVATE (self)->aps);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ap))
-		sorted = g_slist_prepend (sorted, ap);
-	return g_slist_sort (sorted, (GCompareFunc) ap_id_compare);
+		if (with_ssid_only && !nm_ap_get_ssid (ap))
+			continue;
+		paths[n++] = nm_exported_object_get_path (NM_EXPORTED_OBJECT (ap));
+	}
+	paths[n] = NULL;
+	return paths;
 }
 
 static void
 impl_device_wifi_get_access_points (NMDeviceWifi *self,
                                     GDBusMethodInvocation *context)
 {
-	GSList *sorted, *iter;
-	GPtrArray *paths;
-
-	paths = g_ptr_array_new ();
-	sorted = get_sorted_ap_list (self);
-	for (iter = sorted; iter; iter = iter->next) {
-		NMAccessPoint *ap = NM_AP (iter->data);
-
-		if (nm_ap_get_ssid (ap))
-			g_ptr_array_add (paths, g_strdup (nm_exported_object_get_path (NM_EXPORTED_OBJECT (ap))));
-	}
-	g_ptr_array_add (paths, NULL);
-	g_slist_free (sorted);
+	gs_free const char **paths = NULL;
 
-	g_dbus_method_invocation_return_value (context, g_variant_new ("(^ao)", (char **) paths->pdata));
-	g_ptr_array_unref (paths);
+	paths = get_sorted_ap_paths (self, TRUE);
+	g_dbus_method_invocation_return_value (context, g_variant_new ("(^ao)", (char **) paths));
 }
 
 static void
 impl_device_wifi_get_all_access_points (NMDeviceWifi *self,
                                         GDBusMethodInvocation *context)
 {
-	GSList *sorted, *iter;
-	GPtrArray *paths;
+	gs_free const char **paths = NULL;
 
-	paths = g_ptr_array_new ();
-	sorted = get_sorted_ap_list (self);
-	for (iter = sorted; iter; iter = iter->next)
-		g_ptr_array_add (paths, g_strdup (nm_exported_object_get_path (NM_EXPORTED_OBJECT (iter->data))));
-	g_ptr_array_add (paths, NULL);
-	g_slist_free (sorted);
-
-	g_dbus_method_invocation_return_value (context, g_variant_new ("(^ao)", (char **) paths->pdata));
-	g_ptr_array_unref (paths);
+	paths = get_sorted_ap_paths (self, FALSE);
+	g_dbus_method_invocation_return_value (context, g_variant_new ("(^ao)", (char **) paths));
 }
 
 static void
@@ -1198,17 +1290,6 @@ check_scanning_allowed (NMDeviceWifi *self)
 	return g_value_get_boolean (&retval);
 }
 
-static gboolean
-hidden_filter_func (NMSettings *settings,
-                    NMConnection *connection,
-                    gpointer user_data)
-{
-	NMSettingWireless *s_wifi;
-
-	s_wifi = (NMSettingWireless *) nm_connection_get_setting_wireless (connection);
-	return s_wifi ? nm_setting_wireless_get_hidden (s_wifi) : FALSE;
-}
-
 static GPtrArray *
 build_hidden_probe_list (NMDeviceWifi *self)
 {
@@ -1226,12 +1307,8 @@ build_hidden_probe_list (NMDeviceWifi *self)
 	if (G_UNLIKELY (nullssid == NULL))
 		nullssid = g_byte_array_new ();
 
-	connections = nm_settings_get_best_connections (nm_device_get_settings ((NMDevice *) self),
-	                                                max_scan_ssids - 1,
-	                                                NM_SETTING_WIRELESS_SETTING_NAME,
-	                                                NULL,
-	                                                hidden_filter_func,
-	                                                NULL);
+	connections = nm_settings_get_hidden_wifi_connections (nm_device_get_settings ((NMDevice *) self),
+	                                                       max_scan_ssids - 1);
 	if (connections && connections->data) {
 		ssids = g_ptr_array_new_full (max_scan_ssids - 1, (GDestroyNotify) g_byte_array_unref);
 		g_ptr_array_add (ssids, g_byte_array_ref (nullssid));  /* Add wildcard SSID */
@@ -1282,12 +1359,127 @@ ssids_options_to_ptrarray (GVariant *value)
 	return ssids;
 }
 
+static void
+scan_known_connection_changed (NMSettings *settings,
+                               NMSettingsConnection *connection,
+                               NMDeviceWifi *self)
+{
+	NM_DEVICE_WIFI_GET_PRIVATE (self)->scan_known_valid = FALSE;
+}
+
+static void
+scan_known_connection_updated (NMSettings *settings,
+                               NMSettingsConnection *connection,
+                               gboolean by_user,
+                               NMDeviceWifi *self)
+{
+	scan_known_connection_changed (settings, connection, self);
+}
+
+static void
+scan_known_update (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMSettingsConnection *const*connections;
+	guint i;
+
+	if (priv->scan_known_valid)
+		return;
+	priv->scan_known_valid = TRUE;
+
+	g_hash_table_remove_all (priv->scan_known_ssids);
+	g_hash_table_remove_all (priv->scan_known_bssids);
+
+	connections = nm_settings_get_connections (nm_device_get_settings ((NMDevice *) self), NULL);
+	for (i = 0; connections[i]; i++) {
+		NMSettingWireless *s_wifi;
+		GBytes *ssid;
+		const char *mode;
+		char **seen, **iter;
+
+		s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (connections[i]));
+		if (!s_wifi)
+			continue;
+		mode = nm_setting_wireless_get_mode (s_wifi);
+		if (mode && strcmp (mode, NM_SETTING_WIRELESS_MODE_INFRA) != 0)
+			continue;
+
+		ssid = nm_setting_wireless_get_ssid (s_wifi);
+		if (ssid)
+			g_hash_table_add (priv->scan_known_ssids, g_bytes_ref (ssid));
+
+		seen = nm_settings_connection_get_seen_bssids (connections[i]);
+		for (iter = seen; iter && *iter; iter++)
+			g_hash_table_add (priv->scan_known_bssids, g_ascii_strdown (*iter, -1));
+		g_free (seen);
+	}
+}
+
+static void
+update_scan_freqs (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *freqs = NULL;
+	guint i;
+
+	g_array_set_size (priv->scan_freqs, 0);
+
+	scan_known_update (self);
+
+	freqs = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < priv->aps_sorted->len; i++) {
+		NMAccessPoint *ap = priv->aps_sorted->pdata[i];
+		const GByteArray *ssid = nm_ap_get_ssid (ap);
+		const char *address = nm_ap_get_address (ap);
+		guint32 freq = nm_ap_get_freq (ap);
+		gboolean known = FALSE;
+
+		if (!freq || g_hash_table_contains (freqs, GUINT_TO_POINTER (freq)))
+			continue;
+
+		if (ap == priv->current_ap)
+			known = TRUE;
+		if (!known && ssid) {
+			gs_unref_bytes GBytes *bytes = g_bytes_new_static (ssid->data, ssid->len);
+
+			known = g_hash_table_contains (priv->scan_known_ssids, bytes);
+		}
+		if (!known && address) {
+			gs_free char *address_down = g_ascii_strdown (address, -1);
+
+			known = g_hash_table_contains (priv->scan_known_bssids, address_down);
+		}
+
+		if (known) {
+			g_hash_table_add (freqs, GUINT_TO_POINTER (freq));
+			g_array_append_val (priv->scan_freqs, freq);
+		}
+	}
+}
+
+static const GArray *
+get_partial_scan_freqs (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (   nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_ACTIVATED
+	    && priv->scan_freqs->len
+	    && priv->scan_partial_count < SCAN_PARTIAL_PER_FULL) {
+		priv->scan_partial_count++;
+		return priv->scan_freqs;
+	}
+
+	priv->scan_partial_count = 0;
+	return NULL;
+}
+
 static void
 request_wireless_scan (NMDeviceWifi *self, GVariant *scan_options)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	gboolean backoff = FALSE;
 	GPtrArray *ssids = NULL;
+	const GArray *freqs = NULL;
 
 	if (priv->requested_scan) {
 		/* There's already a scan in progress */
@@ -1311,6 +1503,10 @@ request_wireless_scan (NMDeviceWifi *self, GVariant *scan_options)
 		if (!ssids)
 			ssids = build_hidden_probe_list (self);
 
+		/* scans requested by clients always cover all channels */
+		if (!scan_options)
+			freqs = get_partial_scan_freqs (self);
+
 		if (nm_logging_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN)) {
 			if (ssids) {
 				const GByteArray *ssid;
@@ -1330,7 +1526,10 @@ request_wireless_scan (NMDeviceWifi *self, GVariant *scan_options)
 				_LOGD (LOGD_WIFI_SCAN, "no SSIDs to probe scan");
 		}
 
-		if (nm_supplicant_interface_request_scan (priv->sup_iface, ssids)) {
+		if (freqs)
+			_LOGD (LOGD_WIFI_SCAN, "partial scan of %u channels", freqs->len);
+
+		if (nm_supplicant_interface_request_scan (priv->sup_iface, ssids, freqs)) {
 			/* success */
 			backoff = TRUE;
 			priv->requested_scan = TRUE;
@@ -1368,6 +1567,19 @@ schedule_scan (NMDeviceWifi *self, gboolean backoff)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
 
+	if (   priv->current_ap
+	    && nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_ACTIVATED) {
+		gint8 strength = nm_ap_get_strength (priv->current_ap);
+
+		if (   strength < SCAN_STRENGTH_WEAK
+		    || strength + SCAN_STRENGTH_DROP <= priv->scan_last_strength) {
+			priv->scan_interval = MIN (priv->scan_interval, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
+			backoff = FALSE;
+		} else if (priv->scan_freqs->len)
+			priv->scan_interval = MIN (priv->scan_interval, SCAN_PARTIAL_INTERVAL_MAX);
+		priv->scan_last_strength = strength;
+	}
+
 	/* Cancel the pending scan if it would happen later than (now + the scan_interval) */
 	if (priv->pending_scan_id) {
 		if (now + priv->scan_interval < priv->scheduled_scan_time)
@@ -1414,6 +1626,8 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 	_LOGD (LOGD_WIFI_SCAN, "scan %s", success ? "successful" : "failed");
 
 	priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
+	if (success)
+		update_scan_freqs (self);
 	schedule_scan (self, success);
 
 	if (priv->requested_scan) {
@@ -1432,17 +1646,15 @@ ap_list_dump (gpointer user_data)
 {
 	NMDeviceWifi *self = NM_DEVICE_WIFI (user_data);
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	GSList *sorted, *iter;
+	guint i;
 
 	priv->ap_dump_id = 0;
 	_LOGD (LOGD_WIFI_SCAN, "APs: [now:%u last:%u next:%u]",
 	       nm_utils_get_monotonic_timestamp_s (),
 	       priv->last_scan,
 	       priv->scheduled_scan_time);
-	sorted = get_sorted_ap_list (self);
-	for (iter = sorted; iter; iter = iter->next)
-		nm_ap_dump (NM_AP (iter->data), "dump    ", nm_device_get_iface (NM_DEVICE (self)));
-	g_slist_free (sorted);
+	for (i = 0; i < priv->aps_sorted->len; i++)
+		nm_ap_dump (priv->aps_sorted->pdata[i], "dump    ", nm_device_get_iface (NM_DEVICE (self)));
 	return G_SOURCE_REMOVE;
 }
 
@@ -1872,6 +2084,16 @@ supplicant_iface_state_cb (NMSupplicantInterface *iface,
 	    && new_state <= NM_SUPPLICANT_INTERFACE_STATE_COMPLETED)
 		priv->ssid_found = TRUE;
 
+	/* The supplicant re-associating while we are connected is a roam
+	 * within the ESS; time it until the supplicant completes again. */
+	if (   devstate == NM_DEVICE_STATE_ACTIVATED
+	    && old_state == NM_SUPPLICANT_INTERFACE_STATE_COMPLETED
+	    && new_state >= NM_SUPPLICANT_INTERFACE_STATE_AUTHENTICATING
+	    && new_state < NM_SUPPLICANT_INTERFACE_STATE_COMPLETED)
+		priv->roam_start_ms = nm_utils_get_monotonic_timestamp_ms ();
+	else if (new_state < NM_SUPPLICANT_INTERFACE_STATE_AUTHENTICATING)
+		priv->roam_start_ms = 0;
+
 	switch (new_state) {
 	case NM_SUPPLICANT_INTERFACE_STATE_READY:
 		_LOGD (LOGD_WIFI_SCAN, "supplicant ready");
@@ -1908,8 +2130,18 @@ supplicant_iface_state_cb (NMSupplicantInterface *iface,
 			       ssid ? nm_utils_escape_ssid (g_bytes_get_data (ssid, NULL),
 			                                    g_bytes_get_size (ssid)) : "(none)");
 			nm_device_activate_schedule_stage3_ip_config_start (device);
-		} else if (devstate == NM_DEVICE_STATE_ACTIVATED)
+		} else if (devstate == NM_DEVICE_STATE_ACTIVATED) {
+			if (priv->roam_start_ms) {
+				gint64 elapsed = nm_utils_get_monotonic_timestamp_ms () - priv->roam_start_ms;
+
+				priv->roam_start_ms = 0;
+				priv->roam_count++;
+				priv->roam_total_ms += elapsed;
+				_LOGI (LOGD_WIFI, "roaming completed in %"G_GINT64_FORMAT" ms (%u roams, %"G_GINT64_FORMAT" ms on average)",
+				       elapsed, priv->roam_count, priv->roam_total_ms / priv->roam_count);
+			}
 			periodic_update (self);
+		}
 		break;
 	case NM_SUPPLICANT_INTERFACE_STATE_DISCONNECTED:
 		if ((devstate == NM_DEVICE_STATE_ACTIVATED) || nm_device_is_activating (device)) {
@@ -2096,6 +2328,10 @@ handle_auth_or_fail (NMDeviceWifi *self,
 
 		if (new_secrets)
 			flags |= NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW;
+		else {
+			/* the secrets the agent just gave us are likely still good */
+			flags |= NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED;
+		}
 		nm_act_request_get_secrets (req, setting_name, flags, NULL, wifi_secrets_cb, self);
 
 		g_object_set_data (G_OBJECT (applied_connection), WIRELESS_SECRETS_TRIES, GUINT_TO_POINTER (++tries));
@@ -2930,6 +3166,11 @@ nm_device_wifi_init (NMDeviceWifi *self)
 
 	priv->mode = NM_802_11_MODE_INFRA;
 	priv->aps = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->aps_by_supplicant_path = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->aps_sorted = g_ptr_array_new ();
+	priv->scan_freqs = g_array_new (FALSE, FALSE, sizeof (guint32));
+	priv->scan_known_ssids = g_hash_table_new_full (g_bytes_hash, g_bytes_equal, (GDestroyNotify) g_bytes_unref, NULL);
+	priv->scan_known_bssids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 static void
@@ -2940,6 +3181,11 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->periodic_source_id);
 
+	if (nm_device_get_settings ((NMDevice *) self)) {
+		g_signal_handlers_disconnect_by_func (nm_device_get_settings ((NMDevice *) self), scan_known_connection_changed, self);
+		g_signal_handlers_disconnect_by_func (nm_device_get_settings ((NMDevice *) self), scan_known_connection_updated, self);
+	}
+
 	cleanup_association_attempt (self, TRUE);
 	supplicant_interface_release (self);
 	cleanup_supplicant_failures (self);
@@ -2958,8 +3204,14 @@ finalize (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_assert (g_hash_table_size (priv->aps) == 0);
+	nm_assert (priv->aps_sorted->len == 0);
 
 	g_hash_table_unref (priv->aps);
+	g_hash_table_unref (priv->aps_by_supplicant_path);
+	g_ptr_array_unref (priv->aps_sorted);
+	g_array_unref (priv->scan_freqs);
+	g_hash_table_unref (priv->scan_known_ssids);
+	g_hash_table_unref (priv->scan_known_bssids);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
@@ -2970,9 +3222,8 @@ get_property (GObject *object, guint prop_id,
 {
 	NMDeviceWifi *device = NM_DEVICE_WIFI (object);
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (device);
-	GHashTableIter iter;
-	const char *dbus_path;
 	GPtrArray *array;
+	guint i;
 
 	switch (prop_id) {
 	case PROP_PERM_HW_ADDRESS:
@@ -2988,10 +3239,9 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_uint (value, priv->capabilities);
 		break;
 	case PROP_ACCESS_POINTS:
-		array = g_ptr_array_sized_new (g_hash_table_size (priv->aps) + 1);
-		g_hash_table_iter_init (&iter, priv->aps);
-		while (g_hash_table_iter_next (&iter, (gpointer) &dbus_path, NULL))
-			g_ptr_array_add (array, g_strdup (dbus_path));
+		array = g_ptr_array_sized_new (priv->aps_sorted->len + 1);
+		for (i = 0; i < priv->aps_sorted->len; i++)
+			g_ptr_array_add (array, g_strdup (nm_exported_object_get_path (priv->aps_sorted->pdata[i])));
 		g_ptr_array_add (array, NULL);
 		g_value_take_boxed (value, (char **) g_ptr_array_free (array, FALSE));
 		break;
@@ -783,3 +783,170 @@ nm_ap_utils_level_to_quality (gint val)
 	return (guint32) val;
 }
 
+/*****************************************************************************/
+
+#define WLAN_EID_HT_CAPABILITY  45
+#define WLAN_EID_HT_OPERATION   61
+#define WLAN_EID_VHT_CAPABILITY 191
+#define WLAN_EID_VHT_OPERATION  192
+
+/* the rate of one spatial stream at the highest MCS (7 for HT; 7, 8
+ * or 9 for VHT) with the long guard interval, in Kbit/s. Indexed by
+ * the channel width: 20, 40, 80 and 160 MHz. */
+static const guint32 ht_rates[2] = { 65000, 135000 };
+static const guint32 vht_rates[3][4] = {
+	{  65000, 135000, 292500, 585000 },
+	{  78000, 162000, 351000, 702000 },
+	{  86700, 180000, 390000, 780000 },
+};
+
+static guint
+_width_index (guint16 width)
+{
+	switch (width) {
+	case 160:
+		return 3;
+	case 80:
+		return 2;
+	case 40:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * nm_ap_utils_parse_ies:
+ * @ies: the information elements of a BSS, the "IEs" property of the
+ *   supplicant BSS.
+ * @len: length of @ies
+ * @out_info: (out): the HT and VHT capabilities of the BSS
+ *
+ * Finds the channel width, the number of spatial streams and the highest
+ * rate that the BSS supports. The short guard interval is taken into
+ * account if the BSS supports it for the width in use.
+ */
+void
+nm_ap_utils_parse_ies (const guint8 *ies, gsize len, NMApUtilsPhyInfo *out_info)
+{
+	const guint8 *ht_cap = NULL, *ht_op = NULL, *vht_cap = NULL, *vht_op = NULL;
+	guint16 ht_cap_info = 0;
+	guint32 vht_cap_info = 0;
+	guint16 vht_mcs_map;
+	guint i, mcs, vht_mcs = 0;
+	gboolean sgi = FALSE;
+
+	memset (out_info, 0, sizeof (*out_info));
+	out_info->width = 20;
+	out_info->streams = 1;
+
+	while (len >= 2) {
+		guint8 id = ies[0];
+		guint8 elen = ies[1];
+
+		if ((gsize) elen + 2 > len)
+			break;
+		if (id == WLAN_EID_HT_CAPABILITY && elen >= 26)
+			ht_cap = &ies[2];
+		else if (id == WLAN_EID_HT_OPERATION && elen >= 22)
+			ht_op = &ies[2];
+		else if (id == WLAN_EID_VHT_CAPABILITY && elen >= 12)
+			vht_cap = &ies[2];
+		else if (id == WLAN_EID_VHT_OPERATION && elen >= 5)
+			vht_op = &ies[2];
+
+		ies += elen + 2;
+		len -= elen + 2;
+	}
+
+	if (!ht_cap)
+		return;
+
+	out_info->ht = TRUE;
+	ht_cap_info = ht_cap[0] | (ht_cap[1] << 8);
+
+	/* the receive MCS bitmask of the first four streams */
+	out_info->streams = 0;
+	for (i = 0; i < 4; i++) {
+		if (ht_cap[3 + i])
+			out_info->streams = i + 1;
+	}
+	out_info->streams = MAX (out_info->streams, 1);
+
+	/* a secondary channel above or below, and 40 MHz allowed */
+	if (   ht_op
+	    && (ht_cap_info & 0x0002)
+	    && (ht_op[1] & 0x03)
+	    && (ht_op[1] & 0x04))
+		out_info->width = 40;
+
+	if (vht_cap) {
+		out_info->vht = TRUE;
+		vht_cap_info = vht_cap[0] | (vht_cap[1] << 8) | (vht_cap[2] << 16) | ((guint32) vht_cap[3] << 24);
+
+		/* the receive MCS map has two bits for each of 8 streams: 0, 1
+		 * or 2 for a highest MCS of 7, 8 or 9, and 3 when the stream is
+		 * unsupported. */
+		vht_mcs_map = vht_cap[4] | (vht_cap[5] << 8);
+		out_info->streams = 0;
+		for (i = 0; i < 8; i++) {
+			mcs = (vht_mcs_map >> (2 * i)) & 0x03;
+			if (mcs == 3)
+				break;
+			vht_mcs = MAX (vht_mcs, mcs);
+			out_info->streams = i + 1;
+		}
+		out_info->streams = MAX (out_info->streams, 1);
+
+		if (vht_op) {
+			/* width 1 is 80 MHz, or 160 MHz when the second segment
+			 * is set. 2 and 3 are the deprecated 160 and 80+80 MHz. */
+			if (vht_op[0] == 1)
+				out_info->width = vht_op[2] ? 160 : 80;
+			else if (vht_op[0] == 2 || vht_op[0] == 3)
+				out_info->width = 160;
+		}
+	}
+
+	switch (out_info->width) {
+	case 20:
+		sgi = !!(ht_cap_info & 0x0020);
+		break;
+	case 40:
+		sgi = !!(ht_cap_info & 0x0040);
+		break;
+	case 80:
+		sgi = !!(vht_cap_info & 0x00000020);
+		break;
+	case 160:
+		sgi = !!(vht_cap_info & 0x00000040);
+		break;
+	}
+
+	if (out_info->vht)
+		out_info->max_rate = vht_rates[vht_mcs][_width_index (out_info->width)];
+	else
+		out_info->max_rate = ht_rates[_width_index (out_info->width)];
+	out_info->max_rate *= out_info->streams;
+	if (sgi)
+		out_info->max_rate = out_info->max_rate / 9 * 10;
+}
+
+/**
+ * nm_ap_utils_estimate_throughput:
+ * @max_bitrate: the highest rate of the AP, in Kbit/s
+ * @quality: the signal quality in percent
+ *
+ * A rough estimate of the throughput that a client would get from the AP,
+ * in Kbit/s. The highest rate is reached above a quality of 70%, below that
+ * the rate of the modulation that the signal allows falls about linearly.
+ *
+ * Returns: the estimated throughput
+ */
+guint32
+nm_ap_utils_estimate_throughput (guint32 max_bitrate, guint32 quality)
+{
+	quality = CLAMP (quality, 20, 70);
+	return ((guint64) max_bitrate) * (quality - 15) / 55;
+}
+
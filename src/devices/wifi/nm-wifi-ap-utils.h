@@ -40,5 +40,19 @@ gboolean nm_ap_utils_complete_connection (const GByteArray *ssid,
 
 guint32 nm_ap_utils_level_to_quality (gint val);
 
+typedef struct {
+	/* the highest PHY rate of HT or VHT in Kbit/s, 0 for legacy APs */
+	guint32 max_rate;
+	/* the channel width in MHz */
+	guint16 width;
+	guint8 streams;
+	bool ht:1;
+	bool vht:1;
+} NMApUtilsPhyInfo;
+
+void nm_ap_utils_parse_ies (const guint8 *ies, gsize len, NMApUtilsPhyInfo *out_info);
+
+guint32 nm_ap_utils_estimate_throughput (guint32 max_bitrate, guint32 quality);
+
 #endif  /* NM_WIFI_AP_UTILS_H */
 
@@ -29,6 +29,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-utils.h"
 #include "nm-core-internal.h"
+#include "nm-statistics.h"
 
 #include "nm-setting-wireless.h"
 
@@ -42,12 +43,15 @@ typedef struct
 	char *supplicant_path;   /* D-Bus object path of this AP from wpa_supplicant */
 
 	/* Scanned or cached values */
-	GByteArray *       ssid;
+	GByteArray *       ssid;        /* interned, see _ssid_intern() */
 	char *             address;
 	NM80211Mode        mode;
 	guint8             strength;
 	guint32            freq;        /* Frequency in MHz; ie 2412 (== 2.412 GHz) */
 	guint32            max_bitrate; /* Maximum bitrate of the AP in Kbit/s (ie 54000 Kb/s == 54Mbit/s) */
+	guint32            legacy_bitrate; /* the highest of the "Rates", in Kbit/s */
+	guint32            phy_bitrate; /* the highest HT/VHT rate from the IEs, in Kbit/s */
+	guint16            width;       /* channel width in MHz */
 
 	NM80211ApFlags         flags;      /* General flags */
 	NM80211ApSecurityFlags wpa_flags;  /* WPA-related flags */
@@ -98,6 +102,71 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMAccessPoint,
 
 /*****************************************************************/
 
+/* In dense environments many BSSes announce the same few SSIDs, so APs
+ * share one copy of each SSID. The table maps the interned SSID to its
+ * number of users. */
+static GHashTable *ssid_intern_table;
+
+static guint
+_ssid_hash (gconstpointer key)
+{
+	const GByteArray *ssid = key;
+	guint h = 5381;
+	guint i;
+
+	for (i = 0; i < ssid->len; i++)
+		h = (h << 5) + h + ssid->data[i];
+	return h;
+}
+
+static gboolean
+_ssid_equal (gconstpointer a, gconstpointer b)
+{
+	const GByteArray *ssid_a = a;
+	const GByteArray *ssid_b = b;
+
+	return    ssid_a->len == ssid_b->len
+	       && !memcmp (ssid_a->data, ssid_b->data, ssid_a->len);
+}
+
+static GByteArray *
+_ssid_intern (const guint8 *ssid, gsize len)
+{
+	GByteArray lookup = { .data = (guint8 *) ssid, .len = len };
+	gpointer interned, users;
+
+	if (G_UNLIKELY (!ssid_intern_table))
+		ssid_intern_table = g_hash_table_new (_ssid_hash, _ssid_equal);
+
+	if (g_hash_table_lookup_extended (ssid_intern_table, &lookup, &interned, &users)) {
+		g_hash_table_insert (ssid_intern_table, interned, GUINT_TO_POINTER (GPOINTER_TO_UINT (users) + 1));
+		return interned;
+	}
+
+	interned = g_byte_array_sized_new (len);
+	g_byte_array_append (interned, ssid, len);
+	g_hash_table_insert (ssid_intern_table, interned, GUINT_TO_POINTER (1));
+	return interned;
+}
+
+static void
+_ssid_unintern (GByteArray *ssid)
+{
+	guint users;
+
+	users = GPOINTER_TO_UINT (g_hash_table_lookup (ssid_intern_table, ssid));
+	nm_assert (users > 0);
+
+	if (users > 1)
+		g_hash_table_insert (ssid_intern_table, ssid, GUINT_TO_POINTER (users - 1));
+	else {
+		g_hash_table_remove (ssid_intern_table, ssid);
+		g_byte_array_free (ssid, TRUE);
+	}
+}
+
+/*****************************************************************/
+
 const char *
 nm_ap_get_supplicant_path (NMAccessPoint *ap)
 {
@@ -139,14 +208,12 @@ nm_ap_set_ssid (NMAccessPoint *ap, const guint8 *ssid, gsize len)
 	}
 
 	if (priv->ssid) {
-		g_byte_array_free (priv->ssid, TRUE);
+		_ssid_unintern (priv->ssid);
 		priv->ssid = NULL;
 	}
 
-	if (ssid) {
-		priv->ssid = g_byte_array_new ();
-		g_byte_array_append (priv->ssid, ssid, len);
-	}
+	if (ssid)
+		priv->ssid = _ssid_intern (ssid, len);
 
 	_notify (ap, PROP_SSID);
 }
@@ -309,6 +376,51 @@ nm_ap_get_max_bitrate (NMAccessPoint *ap)
 	return NM_AP_GET_PRIVATE (ap)->max_bitrate;
 }
 
+static guint
+freq_to_band (guint32 freq)
+{
+	if (freq >= 4915 && freq <= 5825)
+		return 5;
+	else if (freq >= 2412 && freq <= 2484)
+		return 2;
+	return 0;
+}
+
+/**
+ * nm_ap_get_throughput_estimate:
+ * @ap: the #NMAccessPoint
+ *
+ * Returns: the throughput that a client may get from @ap in Kbit/s,
+ *   estimated from the highest rate of the AP and its current strength.
+ */
+guint32
+nm_ap_get_throughput_estimate (NMAccessPoint *ap)
+{
+	NMAccessPointPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_AP (ap), 0);
+
+	priv = NM_AP_GET_PRIVATE (ap);
+	return nm_ap_utils_estimate_throughput (priv->max_bitrate, priv->strength);
+}
+
+guint16
+nm_ap_get_width (NMAccessPoint *ap)
+{
+	g_return_val_if_fail (NM_IS_AP (ap), 0);
+
+	return NM_AP_GET_PRIVATE (ap)->width ?: 20;
+}
+
+/* the 802.11 band of @ap: 5 (GHz), 2 (.4 GHz) or 0 if unknown. */
+guint
+nm_ap_get_band (NMAccessPoint *ap)
+{
+	g_return_val_if_fail (NM_IS_AP (ap), 0);
+
+	return freq_to_band (NM_AP_GET_PRIVATE (ap)->freq);
+}
+
 void
 nm_ap_set_max_bitrate (NMAccessPoint *ap, guint32 bitrate)
 {
@@ -464,15 +576,28 @@ nm_ap_update_from_properties (NMAccessPoint *ap,
 		int i;
 
 		/* Find the max AP rate */
-		for (i = 0; i < len; i++) {
-			if (rates[i] > maxrate) {
-				maxrate = rates[i];
-				nm_ap_set_max_bitrate (ap, rates[i] / 1000);
-			}
-		}
+		for (i = 0; i < len; i++)
+			maxrate = MAX (maxrate, rates[i]);
+		priv->legacy_bitrate = maxrate / 1000;
+		g_variant_unref (v);
+	}
+
+	/* "Rates" only has the legacy rates, the HT and VHT rates follow
+	 * from the capabilities in the IEs. */
+	v = g_variant_lookup_value (properties, "IEs", G_VARIANT_TYPE_BYTESTRING);
+	if (v) {
+		NMApUtilsPhyInfo info;
+
+		bytes = g_variant_get_fixed_array (v, &len, 1);
+		nm_ap_utils_parse_ies (bytes, len, &info);
+		priv->phy_bitrate = info.max_rate;
+		priv->width = info.width;
 		g_variant_unref (v);
 	}
 
+	if (priv->legacy_bitrate || priv->phy_bitrate)
+		nm_ap_set_max_bitrate (ap, MAX (priv->legacy_bitrate, priv->phy_bitrate));
+
 	v = g_variant_lookup_value (properties, "WPA", G_VARIANT_TYPE_VARDICT);
 	if (v) {
 		nm_ap_set_wpa_flags (ap, priv->wpa_flags | security_from_vardict (v));
@@ -773,16 +898,6 @@ nm_ap_dump (NMAccessPoint *self,
 	            supplicant_id);
 }
 
-static guint
-freq_to_band (guint32 freq)
-{
-	if (freq >= 4915 && freq <= 5825)
-		return 5;
-	else if (freq >= 2412 && freq <= 2484)
-		return 2;
-	return 0;
-}
-
 gboolean
 nm_ap_check_compatible (NMAccessPoint *self,
                         NMConnection *connection)
@@ -892,6 +1007,9 @@ nm_ap_init (NMAccessPoint *ap)
 	priv->wpa_flags = NM_802_11_AP_SEC_NONE;
 	priv->rsn_flags = NM_802_11_AP_SEC_NONE;
 	priv->last_seen = -1;
+
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_WIFI_APS,
+	                          sizeof (NMAccessPoint) + sizeof (NMAccessPointPrivate));
 }
 
 static void
@@ -899,9 +1017,12 @@ finalize (GObject *object)
 {
 	NMAccessPointPrivate *priv = NM_AP_GET_PRIVATE ((NMAccessPoint *) object);
 
+	nm_statistics_memory_remove (NM_STATISTICS_MEMORY_WIFI_APS,
+	                             sizeof (NMAccessPoint) + sizeof (NMAccessPointPrivate));
+
 	g_free (priv->supplicant_path);
 	if (priv->ssid)
-		g_byte_array_free (priv->ssid, TRUE);
+		_ssid_unintern (priv->ssid);
 	g_free (priv->address);
 
 	G_OBJECT_CLASS (nm_ap_parent_class)->finalize (object);
@@ -85,6 +85,9 @@ void              nm_ap_set_freq                 (NMAccessPoint *ap,
 guint32           nm_ap_get_max_bitrate          (NMAccessPoint *ap);
 void              nm_ap_set_max_bitrate          (NMAccessPoint *ap,
                                                   guint32 bitrate);
+guint32           nm_ap_get_throughput_estimate  (NMAccessPoint *ap);
+guint16           nm_ap_get_width                (NMAccessPoint *ap);
+guint             nm_ap_get_band                 (NMAccessPoint *ap);
 gboolean          nm_ap_get_fake                 (const NMAccessPoint *ap);
 void              nm_ap_set_fake                 (NMAccessPoint *ap,
                                                   gboolean fake);
@@ -1336,6 +1336,62 @@ test_strength_wext (void)
 
 /*******************************************/
 
+#define HT_CAP_2SS_40MHZ_SGI \
+	45, 26, 0x62, 0x00, 0x00, \
+	0xff, 0xff, 0x00, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, \
+	0, 0, 0, 0, 0, 0, 0
+#define HT_OP_40MHZ \
+	61, 22, 36, 0x05, \
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+
+static void
+test_phy_info (void)
+{
+	/* SSID "a" and supported rates, no HT */
+	static const guint8 legacy[] = { 0, 1, 'a', 1, 2, 0x8c, 0x12 };
+	static const guint8 ht[] = { 0, 1, 'a', HT_CAP_2SS_40MHZ_SGI, HT_OP_40MHZ };
+	static const guint8 vht[] = {
+		HT_CAP_2SS_40MHZ_SGI, HT_OP_40MHZ,
+		/* VHT: SGI at 80 MHz, two streams with MCS 0-9 */
+		191, 12, 0x20, 0x00, 0x00, 0x00, 0xfa, 0xff, 0, 0, 0xfa, 0xff, 0, 0,
+		192, 5, 1, 42, 0, 0xfc, 0xff,
+	};
+	/* the HT capabilities claim more than the element has */
+	static const guint8 truncated[] = { 45, 26, 0x62, 0x00 };
+	NMApUtilsPhyInfo info;
+
+	nm_ap_utils_parse_ies (legacy, sizeof (legacy), &info);
+	g_assert (!info.ht);
+	g_assert_cmpint (info.max_rate, ==, 0);
+	g_assert_cmpint (info.width, ==, 20);
+
+	nm_ap_utils_parse_ies (ht, sizeof (ht), &info);
+	g_assert (info.ht);
+	g_assert (!info.vht);
+	g_assert_cmpint (info.width, ==, 40);
+	g_assert_cmpint (info.streams, ==, 2);
+	g_assert_cmpint (info.max_rate, ==, 300000);
+
+	nm_ap_utils_parse_ies (vht, sizeof (vht), &info);
+	g_assert (info.vht);
+	g_assert_cmpint (info.width, ==, 80);
+	g_assert_cmpint (info.streams, ==, 2);
+	g_assert_cmpint (info.max_rate, ==, 866660);
+
+	nm_ap_utils_parse_ies (truncated, sizeof (truncated), &info);
+	g_assert (!info.ht);
+
+	g_assert_cmpint (nm_ap_utils_estimate_throughput (300000, 100), ==, 300000);
+	g_assert_cmpint (nm_ap_utils_estimate_throughput (300000, 70), ==, 300000);
+	g_assert_cmpint (nm_ap_utils_estimate_throughput (300000, 42), ==, 147272);
+	g_assert_cmpint (nm_ap_utils_estimate_throughput (300000, 0), ==, 27272);
+
+	/* a strong 2.4 GHz HT20 AP loses against a weaker VHT80 one */
+	g_assert_cmpint (nm_ap_utils_estimate_throughput (72200, 90), <, nm_ap_utils_estimate_throughput (866660, 50));
+}
+
+/*******************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1498,5 +1554,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/wifi/strength/wext",
 	                 test_strength_wext);
 
+	g_test_add_func ("/wifi/phy-info", test_phy_info);
+
 	return g_test_run ();
 }
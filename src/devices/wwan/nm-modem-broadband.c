@@ -62,6 +62,7 @@ struct _NMModemBroadbandPrivate {
 	MMModem *modem_iface;
 	MMModemSimple *simple_iface;
 	MMSim *sim_iface;
+	GCancellable *sim_cancellable;
 
 	/* Connection setup */
 	ConnectContext *ctx;
@@ -95,7 +96,7 @@ enum {
     G_STMT_START { \
         const NMLogLevel _level = (level); \
         \
-        if (nm_logging_enabled (_level, (_NMLOG_DOMAIN))) { \
+        if (_nm_logging_wanted (_level, (_NMLOG_DOMAIN))) { \
             NMModemBroadband *const __self = (self); \
             char __prefix_name[128]; \
             const char *__uid; \
@@ -1265,6 +1266,15 @@ get_sim_ready (MMModem *modem,
 
 
 	new_sim = mm_modem_get_sim_finish (modem, res, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		/* superseded by a newer request, or disposing */
+		g_error_free (error);
+		g_object_unref (self);
+		return;
+	}
+
+	g_clear_object (&self->priv->sim_cancellable);
+
 	if (new_sim != self->priv->sim_iface) {
 		g_clear_object (&self->priv->sim_iface);
 		self->priv->sim_iface = new_sim;
@@ -1293,18 +1303,39 @@ sim_changed (MMModem *modem, GParamSpec *pspec, gpointer user_data)
 {
 	NMModemBroadband *self = NM_MODEM_BROADBAND (user_data);
 
+	const char *sim_path;
+
 	g_return_if_fail (modem == self->priv->modem_iface);
 
-	if (mm_modem_get_sim_path (self->priv->modem_iface)) {
+	sim_path = mm_modem_get_sim_path (self->priv->modem_iface);
+
+	/* The modem object comes from the ModemManager object manager and its
+	 * properties are up to date; only the SIM needs a proxy of its own.
+	 * Don't create (and fetch all properties of) a new one when the SIM
+	 * didn't actually change.
+	 */
+	if (   sim_path
+	    && self->priv->sim_iface
+	    && !g_strcmp0 (mm_sim_get_path (self->priv->sim_iface), sim_path)) {
+		nm_clear_g_cancellable (&self->priv->sim_cancellable);
+		return;
+	}
+
+	nm_clear_g_cancellable (&self->priv->sim_cancellable);
+
+	if (sim_path) {
+		self->priv->sim_cancellable = g_cancellable_new ();
 		mm_modem_get_sim (self->priv->modem_iface,
-		                  NULL,  /* cancellable */
+		                  self->priv->sim_cancellable,
 		                  (GAsyncReadyCallback) get_sim_ready,
 		                  g_object_ref (self));
-	} else
+	} else {
+		g_clear_object (&self->priv->sim_iface);
 		g_object_set (G_OBJECT (self),
 		              NM_MODEM_SIM_ID, NULL,
 		              NM_MODEM_SIM_OPERATOR_ID, NULL,
 		              NULL);
+	}
 }
 
 static void
@@ -1394,6 +1425,7 @@ dispose (GObject *object)
 	g_clear_object (&self->priv->bearer);
 	g_clear_object (&self->priv->modem_iface);
 	g_clear_object (&self->priv->simple_iface);
+	nm_clear_g_cancellable (&self->priv->sim_cancellable);
 	g_clear_object (&self->priv->sim_iface);
 	g_clear_object (&self->priv->modem_object);
 
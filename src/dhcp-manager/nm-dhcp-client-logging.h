@@ -36,7 +36,7 @@
          * Same for the _NMLOG_ENABLED() macro. Probably it would be more
          * expensive to determine the correct value then what we could
          * safe. */ \
-        if (nm_logging_enabled (_level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (_level, _NMLOG_DOMAIN)) { \
             NMDhcpClient *_self = (NMDhcpClient *) (self); \
             const char *__ifname = _self ? nm_dhcp_client_get_iface (_self) : NULL; \
             const NMLogDomain _domain = !_self \
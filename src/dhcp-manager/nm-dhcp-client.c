@@ -34,6 +34,7 @@
 #include "nm-utils.h"
 #include "nm-dhcp-utils.h"
 #include "nm-platform.h"
+#include "nm-statistics.h"
 
 #include "nm-dhcp-client-logging.h"
 
@@ -789,6 +790,9 @@ static void
 nm_dhcp_client_init (NMDhcpClient *self)
 {
 	NM_DHCP_CLIENT_GET_PRIVATE (self)->pid = -1;
+
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_DHCP_CLIENTS,
+	                          sizeof (NMDhcpClient) + sizeof (NMDhcpClientPrivate));
 }
 
 static void
@@ -897,6 +901,15 @@ dispose (GObject *object)
 	G_OBJECT_CLASS (nm_dhcp_client_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+	nm_statistics_memory_remove (NM_STATISTICS_MEMORY_DHCP_CLIENTS,
+	                             sizeof (NMDhcpClient) + sizeof (NMDhcpClientPrivate));
+
+	G_OBJECT_CLASS (nm_dhcp_client_parent_class)->finalize (object);
+}
+
 static void
 nm_dhcp_client_class_init (NMDhcpClientClass *client_class)
 {
@@ -906,6 +919,7 @@ nm_dhcp_client_class_init (NMDhcpClientClass *client_class)
 
 	/* virtual methods */
 	object_class->dispose = dispose;
+	object_class->finalize = finalize;
 	object_class->get_property = get_property;
 	object_class->set_property = set_property;
 
@@ -577,37 +577,30 @@ lease_validity_span (const char *str_expire, GDateTime *now)
 }
 
 /**
- * nm_dhcp_dhclient_read_lease_ip_configs:
- * @iface: the interface name to match leases with
- * @ifindex: interface index of @iface
+ * nm_dhcp_dhclient_parse_leases:
  * @contents: the contents of a dhclient leasefile
- * @ipv6: whether to read IPv4 or IPv6 leases
- * @now: the current UTC date/time; pass %NULL to automatically use current
- *  UTC time.  Testcases may need a different value for 'now'
  *
- * Reads dhclient leases from @contents and parses them into either
- * #NMIP4Config or #NMIP6Config objects depending on the value of @ipv6.
+ * Splits @contents into its leases without interpreting them, so that the
+ * result can be kept and turned into IP configurations repeatedly with
+ * nm_dhcp_dhclient_leases_to_ip_configs().
  *
- * Returns: a #GSList of #NMIP4Config objects (if @ipv6 is %FALSE) or a list of
- * #NMIP6Config objects (if @ipv6 is %TRUE) containing the lease data.
+ * Returns: (transfer full): a #GPtrArray of #GHashTable, one per well-formed
+ * lease, mapping the lease options to their values.
  */
-GSList *
-nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
-                                        int ifindex,
-                                        const char *contents,
-                                        gboolean ipv6,
-                                        GDateTime *now)
+GPtrArray *
+nm_dhcp_dhclient_parse_leases (const char *contents)
 {
-	GSList *parsed = NULL, *iter, *leases = NULL;
+	GPtrArray *parsed;
 	char **line, **split = NULL;
 	GHashTable *hash = NULL;
-	gint32 now_monotonic_ts;
 
 	g_return_val_if_fail (contents != NULL, NULL);
 
+	parsed = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_destroy);
+
 	split = g_strsplit_set (contents, "\n\r", -1);
 	if (!split)
-		return NULL;
+		return parsed;
 
 	for (line = split; line && *line; line++) {
 		*line = g_strstrip (*line);
@@ -616,7 +609,8 @@ nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
 			/* Comment */
 		} else if (!strcmp (*line, "}")) {
 			/* Lease ends */
-			parsed = g_slist_append (parsed, hash);
+			if (hash)
+				g_ptr_array_add (parsed, hash);
 			hash = NULL;
 		} else if (!strcmp (*line, "lease {")) {
 			/* Beginning of a new lease */
@@ -635,24 +629,50 @@ nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
 	if (hash) {
 		/* Ignore malformed lease that doesn't end before new one starts */
 		g_hash_table_destroy (hash);
-		hash = NULL;
 	}
 
+	return parsed;
+}
+
+/**
+ * nm_dhcp_dhclient_leases_to_ip_configs:
+ * @parsed: leases as returned by nm_dhcp_dhclient_parse_leases()
+ * @iface: the interface name to match leases with
+ * @ifindex: interface index of @iface
+ * @ipv6: whether to read IPv4 or IPv6 leases
+ * @now: the current UTC date/time; pass %NULL to automatically use current
+ *  UTC time.  Testcases may need a different value for 'now'
+ *
+ * Returns: a #GSList of #NMIP4Config objects (if @ipv6 is %FALSE) or a list of
+ * #NMIP6Config objects (if @ipv6 is %TRUE) containing the lease data.
+ */
+GSList *
+nm_dhcp_dhclient_leases_to_ip_configs (GPtrArray *parsed,
+                                       const char *iface,
+                                       int ifindex,
+                                       gboolean ipv6,
+                                       GDateTime *now)
+{
+	GSList *leases = NULL;
+	gint32 now_monotonic_ts;
+	guint i;
+
+	g_return_val_if_fail (parsed != NULL, NULL);
+
 	if (now)
 		g_date_time_ref (now);
 	else
 		now = g_date_time_new_now_utc ();
 	now_monotonic_ts = nm_utils_get_monotonic_timestamp_s ();
 
-	for (iter = parsed; iter; iter = g_slist_next (iter)) {
+	for (i = 0; i < parsed->len; i++) {
+		GHashTable *hash = parsed->pdata[i];
 		NMIP4Config *ip4;
 		NMPlatformIP4Address address;
 		const char *value;
 		GTimeSpan expiry;
 		guint32 tmp, gw = 0;
 
-		hash = iter->data;
-
 		/* Make sure this lease is for the interface we want */
 		value = g_hash_table_lookup (hash, "interface");
 		if (!value || strcmp (value, iface))
@@ -729,7 +749,39 @@ nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
 	}
 
 	g_date_time_unref (now);
-	g_slist_free_full (parsed, (GDestroyNotify) g_hash_table_destroy);
+	return leases;
+}
+
+/**
+ * nm_dhcp_dhclient_read_lease_ip_configs:
+ * @iface: the interface name to match leases with
+ * @ifindex: interface index of @iface
+ * @contents: the contents of a dhclient leasefile
+ * @ipv6: whether to read IPv4 or IPv6 leases
+ * @now: the current UTC date/time; pass %NULL to automatically use current
+ *  UTC time.  Testcases may need a different value for 'now'
+ *
+ * Reads dhclient leases from @contents and parses them into either
+ * #NMIP4Config or #NMIP6Config objects depending on the value of @ipv6.
+ *
+ * Returns: a #GSList of #NMIP4Config objects (if @ipv6 is %FALSE) or a list of
+ * #NMIP6Config objects (if @ipv6 is %TRUE) containing the lease data.
+ */
+GSList *
+nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
+                                        int ifindex,
+                                        const char *contents,
+                                        gboolean ipv6,
+                                        GDateTime *now)
+{
+	GPtrArray *parsed;
+	GSList *leases;
+
+	g_return_val_if_fail (contents != NULL, NULL);
+
+	parsed = nm_dhcp_dhclient_parse_leases (contents);
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, iface, ifindex, ipv6, now);
+	g_ptr_array_unref (parsed);
 	return leases;
 }
 
@@ -44,6 +44,14 @@ gboolean nm_dhcp_dhclient_save_duid (const char *leasefile,
                                      const char *escaped_duid,
                                      GError **error);
 
+GPtrArray *nm_dhcp_dhclient_parse_leases (const char *contents);
+
+GSList *nm_dhcp_dhclient_leases_to_ip_configs (GPtrArray *parsed,
+                                               const char *iface,
+                                               int ifindex,
+                                               gboolean ipv6,
+                                               GDateTime *now);
+
 GSList *nm_dhcp_dhclient_read_lease_ip_configs (const char *iface,
                                                 int ifindex,
                                                 const char *contents,
@@ -35,6 +35,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include "nm-dhcp-dhclient.h"
 #include "nm-utils.h"
@@ -122,6 +123,80 @@ get_dhclient_leasefile (const char *iface,
 	return NULL;
 }
 
+/* Leasefiles are parsed once and kept until they change on disk, so that
+ * assuming many devices at startup or checking a device again doesn't
+ * read and parse the same file over and over. */
+typedef struct {
+	struct timespec mtime;
+	struct timespec ctime;
+	ino_t ino;
+	off_t size;
+
+	/* as returned by nm_dhcp_dhclient_parse_leases() */
+	GPtrArray *parsed;
+} LeaseCacheEntry;
+
+static GHashTable *lease_cache;
+
+static void
+lease_cache_entry_free (gpointer data)
+{
+	LeaseCacheEntry *entry = data;
+
+	g_ptr_array_unref (entry->parsed);
+	g_slice_free (LeaseCacheEntry, entry);
+}
+
+static gboolean
+timespec_equal (const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+static GPtrArray *
+lease_cache_get (const char *leasefile)
+{
+	LeaseCacheEntry *entry;
+	struct stat st;
+	gs_free char *contents = NULL;
+
+	if (G_UNLIKELY (!lease_cache))
+		lease_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, lease_cache_entry_free);
+
+	/* stat() before reading; if the file changes in between, the next
+	 * lookup sees a different stat() and reads it again. */
+	if (stat (leasefile, &st) != 0) {
+		g_hash_table_remove (lease_cache, leasefile);
+		return NULL;
+	}
+
+	entry = g_hash_table_lookup (lease_cache, leasefile);
+	if (   entry
+	    && timespec_equal (&entry->mtime, &st.st_mtim)
+	    && timespec_equal (&entry->ctime, &st.st_ctim)
+	    && entry->ino == st.st_ino
+	    && entry->size == st.st_size)
+		return g_ptr_array_ref (entry->parsed);
+
+	if (   !g_file_get_contents (leasefile, &contents, NULL, NULL)
+	    || !contents[0]) {
+		g_hash_table_remove (lease_cache, leasefile);
+		return NULL;
+	}
+
+	entry = g_slice_new (LeaseCacheEntry);
+	entry->mtime = st.st_mtim;
+	entry->ctime = st.st_ctim;
+	entry->ino = st.st_ino;
+	entry->size = st.st_size;
+	entry->parsed = nm_dhcp_dhclient_parse_leases (contents);
+	g_hash_table_insert (lease_cache, g_strdup (leasefile), entry);
+
+	nm_log_dbg (LOGD_DHCP, "dhclient: parsed %u leases from %s", entry->parsed->len, leasefile);
+
+	return g_ptr_array_ref (entry->parsed);
+}
+
 static GSList *
 nm_dhcp_dhclient_get_lease_ip_configs (const char *iface,
                                        int ifindex,
@@ -129,22 +204,20 @@ nm_dhcp_dhclient_get_lease_ip_configs (const char *iface,
                                        gboolean ipv6,
                                        guint32 default_route_metric)
 {
-	char *contents = NULL;
-	char *leasefile;
-	GSList *leases = NULL;
+	gs_free char *leasefile = NULL;
+	GPtrArray *parsed;
+	GSList *leases;
 
 	leasefile = get_dhclient_leasefile (iface, uuid, FALSE, NULL);
 	if (!leasefile)
 		return NULL;
 
-	if (   g_file_test (leasefile, G_FILE_TEST_EXISTS)
-	    && g_file_get_contents (leasefile, &contents, NULL, NULL)
-	    && contents
-	    && contents[0])
-		leases = nm_dhcp_dhclient_read_lease_ip_configs (iface, ifindex, contents, ipv6, NULL);
+	parsed = lease_cache_get (leasefile);
+	if (!parsed)
+		return NULL;
 
-	g_free (leasefile);
-	g_free (contents);
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, iface, ifindex, ipv6, NULL);
+	g_ptr_array_unref (parsed);
 
 	return leases;
 }
@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_DHCP_HELPER_API_H__
+#define __NM_DHCP_HELPER_API_H__
+
+/* Shared between nm-dhcp-helper and NMDhcpListener. */
+
+#define NM_DHCP_CLIENT_DBUS_IFACE             "org.freedesktop.nm_dhcp_client"
+
+#define NM_DHCP_HELPER_SERVER_DBUS_ADDRESS    "unix:path=" NMRUNDIR "/private-dhcp"
+
+/* The helper first tries to send the event as a single datagram to this
+ * socket and only falls back to the private D-Bus server if that fails. */
+#define NM_DHCP_HELPER_EVENT_SOCKET_PATH      NMRUNDIR "/private-dhcp-event"
+
+#define NM_DHCP_HELPER_EVENT_MAGIC            0x484e4d44u /* "DMNH" */
+#define NM_DHCP_HELPER_EVENT_VERSION          1
+#define NM_DHCP_HELPER_EVENT_MAX_SIZE         (64 * 1024)
+
+/* A datagram is a NMDhcpHelperEventHeader followed by @n_options records,
+ * each a NMDhcpHelperEventOption followed by the option name and value
+ * bytes (neither NUL terminated). Everything is in host byte order and
+ * records are not aligned. */
+typedef struct {
+	guint32 magic;
+	guint16 version;
+	guint16 n_options;
+
+	/* g_get_monotonic_time() of the helper when the event was built */
+	gint64 timestamp;
+} NMDhcpHelperEventHeader;
+
+typedef struct {
+	guint16 name_len;
+	guint16 value_len;
+} NMDhcpHelperEventOption;
+
+#endif /* __NM_DHCP_HELPER_API_H__ */
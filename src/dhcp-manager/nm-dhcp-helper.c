@@ -24,11 +24,35 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
-#define NM_DHCP_CLIENT_DBUS_IFACE   "org.freedesktop.nm_dhcp_client"
+#include "nm-dhcp-helper-api.h"
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+static gboolean
+split_env (const char *item, gsize *out_name_len, const char **out_val)
+{
+	const char *val, **p;
+
+	/* Split on the = */
+	val = strchr (item, '=');
+	if (!val || val == item)
+		return FALSE;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (item, *p, strlen (*p)) == 0)
+			return FALSE;
+	}
+
+	*out_name_len = val - item;
+	*out_val = val + 1;
+	return TRUE;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -39,20 +63,13 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
+		const char *val;
+		char *name;
+		gsize name_len;
 
-		/* Split on the = */
-		name = g_strdup (*item);
-		val = strchr (name, '=');
-		if (!val || val == name)
-			goto next;
-		*val++ = '\0';
-
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		if (!split_env (*item, &name_len, &val))
+			continue;
+		name = g_strndup (*item, name_len);
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -65,14 +82,98 @@ build_signal_parameters (void)
 		                       name,
 		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
 		                                                  val, strlen (val), 1));
-
-	next:
 		g_free (name);
 	}
 
 	return g_variant_new ("(a{sv})", &builder);
 }
 
+static GByteArray *
+build_event_datagram (void)
+{
+	NMDhcpHelperEventHeader header = {
+		.magic = NM_DHCP_HELPER_EVENT_MAGIC,
+		.version = NM_DHCP_HELPER_EVENT_VERSION,
+	};
+	GByteArray *buf;
+	char **item;
+	guint n_options = 0;
+
+	buf = g_byte_array_sized_new (4096);
+	g_byte_array_append (buf, (const guint8 *) &header, sizeof (header));
+
+	for (item = environ; *item; item++) {
+		NMDhcpHelperEventOption option;
+		const char *val;
+		gsize name_len, val_len;
+
+		if (!split_env (*item, &name_len, &val))
+			continue;
+
+		val_len = strlen (val);
+		if (   name_len > G_MAXUINT16
+		    || val_len > G_MAXUINT16
+		    || n_options == G_MAXUINT16)
+			goto fail;
+
+		option.name_len = name_len;
+		option.value_len = val_len;
+		g_byte_array_append (buf, (const guint8 *) &option, sizeof (option));
+		g_byte_array_append (buf, (const guint8 *) *item, name_len);
+		g_byte_array_append (buf, (const guint8 *) val, val_len);
+		n_options++;
+
+		if (buf->len > NM_DHCP_HELPER_EVENT_MAX_SIZE)
+			goto fail;
+	}
+
+	header.n_options = n_options;
+	header.timestamp = g_get_monotonic_time ();
+	memcpy (buf->data, &header, sizeof (header));
+	return buf;
+
+fail:
+	/* too large for a datagram, use D-Bus */
+	g_byte_array_unref (buf);
+	return NULL;
+}
+
+static gboolean
+send_event_datagram (void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX, };
+	GByteArray *buf;
+	gssize sent;
+	int fd, errsv;
+
+	buf = build_event_datagram ();
+	if (!buf)
+		return FALSE;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH) <= sizeof (addr.sun_path));
+	memcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH));
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		g_byte_array_unref (buf);
+		return FALSE;
+	}
+
+	do {
+		sent = sendto (fd, buf->data, buf->len, 0, (struct sockaddr *) &addr, sizeof (addr));
+		errsv = errno;
+	} while (sent < 0 && errsv == EINTR);
+
+	/* ENOENT and ECONNREFUSED mean that NetworkManager doesn't listen
+	 * on the socket (for example, because it is an older version). */
+	if (sent < 0 && errsv != ENOENT && errsv != ECONNREFUSED)
+		g_printerr ("Warning: could not send DHCP event datagram: %s\n", g_strerror (errsv));
+
+	close (fd);
+	g_byte_array_unref (buf);
+	return sent >= 0;
+}
+
 static void
 fatal_error (void)
 {
@@ -97,7 +198,10 @@ main (int argc, char *argv[])
 
 	nm_g_type_init ();
 
-	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NMRUNDIR "/private-dhcp",
+	if (send_event_datagram ())
+		return 0;
+
+	connection = g_dbus_connection_new_for_address_sync (NM_DHCP_HELPER_SERVER_DBUS_ADDRESS,
 	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
 	                                                     NULL, NULL, &error);
 	if (!connection) {
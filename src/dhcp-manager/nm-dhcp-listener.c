@@ -20,6 +20,8 @@
 #include "nm-default.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -28,19 +30,29 @@
 #include <unistd.h>
 
 #include "nm-dhcp-listener.h"
+#include "nm-dhcp-helper-api.h"
 #include "nm-core-internal.h"
 #include "nm-bus-manager.h"
 #include "NetworkManagerUtils.h"
 
-#define NM_DHCP_CLIENT_DBUS_IFACE "org.freedesktop.nm_dhcp_client"
 #define PRIV_SOCK_PATH            NMRUNDIR "/private-dhcp"
 #define PRIV_SOCK_TAG             "dhcp"
 
+/* maximum number of datagrams handled per main loop iteration */
+#define EVENT_BATCH_MAX           32
+
 typedef struct {
 	NMBusManager *      dbus_mgr;
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        signal_handlers;
+
+	int                 event_fd;
+	GIOChannel *        event_channel;
+	guint               event_id;
+	guint8 *            event_buf;
+
+	NMDhcpListenerStats stats;
 } NMDhcpListenerPrivate;
 
 #define NM_DHCP_LISTENER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_LISTENER, NMDhcpListenerPrivate))
@@ -56,18 +68,11 @@ static guint signals[LAST_SIGNAL] = { 0 };
 /***************************************************/
 
 static char *
-get_option (GVariant *options, const char *key)
+convert_option (const guchar *bytes, gsize len)
 {
-	GVariant *value;
-	const guchar *bytes, *s;
-	gsize len;
+	const guchar *s;
 	char *converted, *d;
 
-	if (!g_variant_lookup (options, key, "@ay", &value))
-		return NULL;
-
-	bytes = g_variant_get_fixed_array (value, &len, 1);
-
 	/* Since the DHCP options come through environment variables, they should
 	 * already be UTF-8 safe, but just make sure.
 	 */
@@ -82,53 +87,79 @@ get_option (GVariant *options, const char *key)
 			*d = *s;
 	}
 	*d = '\0';
+
+	return converted;
+}
+
+static char *
+get_option (GVariant *options, const char *key)
+{
+	GVariant *value;
+	const guchar *bytes;
+	gsize len;
+	char *converted;
+
+	if (!g_variant_lookup (options, key, "@ay", &value))
+		return NULL;
+
+	bytes = g_variant_get_fixed_array (value, &len, 1);
+	converted = convert_option (bytes, len);
 	g_variant_unref (value);
 
 	return converted;
 }
 
 static void
-handle_event (GDBusConnection  *connection,
-              const char       *sender_name,
-              const char       *object_path,
-              const char       *interface_name,
-              const char       *signal_name,
-              GVariant         *parameters,
-              gpointer          user_data)
+emit_event (NMDhcpListener *self,
+            const char *transport,
+            gint64 sent_usec,
+            const char *iface,
+            const char *pid_str,
+            const char *reason,
+            GVariant *options)
 {
-	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
-	char *iface = NULL;
-	char *pid_str = NULL;
-	char *reason = NULL;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
 	gint pid;
 	gboolean handled = FALSE;
-	GVariant *options;
-
-	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
-		return;
-
-	g_variant_get (parameters, "(@a{sv})", &options);
+	gint64 start, latency = -1, handling;
 
-	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		nm_log_warn (LOGD_DHCP, "DHCP event: didn't have associated interface.");
-		goto out;
+		priv->stats.events_invalid++;
+		return;
 	}
 
-	pid_str = get_option (options, "pid");
 	pid = _nm_utils_ascii_str_to_int64 (pid_str, 10, 0, G_MAXINT32, -1);
 	if (pid == -1) {
 		nm_log_warn (LOGD_DHCP, "DHCP event: couldn't convert PID '%s' to an integer", pid_str ? pid_str : "(null)");
-		goto out;
+		priv->stats.events_invalid++;
+		return;
 	}
 
-	reason = get_option (options, "reason");
 	if (reason == NULL) {
 		nm_log_warn (LOGD_DHCP, "(pid %d) DHCP event didn't have a reason", pid);
-		goto out;
+		priv->stats.events_invalid++;
+		return;
+	}
+
+	start = g_get_monotonic_time ();
+	if (sent_usec > 0 && start >= sent_usec) {
+		latency = start - sent_usec;
+		priv->stats.latency_usec_total += latency;
+		priv->stats.latency_usec_max = MAX (priv->stats.latency_usec_max, (guint64) latency);
 	}
 
 	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
+
+	handling = g_get_monotonic_time () - start;
+	priv->stats.handling_usec_total += handling;
+	priv->stats.handling_usec_max = MAX (priv->stats.handling_usec_max, (guint64) handling);
+
+	nm_log_dbg (LOGD_DHCP, "(pid %d) %s DHCP event for %s via %s: latency %s%"G_GINT64_FORMAT" usec, handled in %"G_GINT64_FORMAT" usec",
+	            pid, reason, iface, transport,
+	            latency < 0 ? "unknown " : "", MAX (latency, 0),
+	            handling);
+
 	if (!handled) {
 		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
 			/* Ignore event when the dhcp client gets killed and we receive its last message */
@@ -136,14 +167,301 @@ handle_event (GDBusConnection  *connection,
 		} else
 			nm_log_warn (LOGD_DHCP, "(pid %d) unhandled DHCP event for interface %s", pid, iface);
 	}
+}
+
+static void
+handle_event (GDBusConnection  *connection,
+              const char       *sender_name,
+              const char       *object_path,
+              const char       *interface_name,
+              const char       *signal_name,
+              GVariant         *parameters,
+              gpointer          user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	gs_free char *iface = NULL;
+	gs_free char *pid_str = NULL;
+	gs_free char *reason = NULL;
+	GVariant *options;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+		return;
+
+	priv->stats.events_dbus++;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+
+	iface = get_option (options, "interface");
+	pid_str = get_option (options, "pid");
+	reason = get_option (options, "reason");
+
+	emit_event (self, "D-Bus", 0, iface, pid_str, reason, options);
 
-out:
-	g_free (iface);
-	g_free (pid_str);
-	g_free (reason);
 	g_variant_unref (options);
 }
 
+/***************************************************/
+
+#define OPTION_IS(name, name_len, str) \
+	((name_len) == NM_STRLEN (str) && memcmp ((name), str, NM_STRLEN (str)) == 0)
+
+/**
+ * _nm_dhcp_listener_decode_datagram:
+ * @buf: the datagram sent by nm-dhcp-helper
+ * @len: the length of @buf
+ * @out_timestamp: (out): the time the helper built the event
+ * @out_iface: (out): the "interface" option, or %NULL
+ * @out_pid: (out): the "pid" option, or %NULL
+ * @out_reason: (out): the "reason" option, or %NULL
+ *
+ * Returns: (transfer full): the options of the event as a{sv} with byte
+ *   array values, like the helper sends them over D-Bus, or %NULL if the
+ *   datagram is malformed.
+ */
+GVariant *
+_nm_dhcp_listener_decode_datagram (const guint8 *buf,
+                                   gsize len,
+                                   gint64 *out_timestamp,
+                                   char **out_iface,
+                                   char **out_pid,
+                                   char **out_reason)
+{
+	NMDhcpHelperEventHeader header;
+	GVariantBuilder builder;
+	gs_free char *iface = NULL;
+	gs_free char *pid_str = NULL;
+	gs_free char *reason = NULL;
+	gsize pos;
+	guint i;
+
+	if (len < sizeof (header))
+		return NULL;
+	memcpy (&header, buf, sizeof (header));
+	if (   header.magic != NM_DHCP_HELPER_EVENT_MAGIC
+	    || header.version != NM_DHCP_HELPER_EVENT_VERSION)
+		return NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	pos = sizeof (header);
+	for (i = 0; i < header.n_options; i++) {
+		NMDhcpHelperEventOption option;
+		const char *name;
+		const guint8 *value;
+		char *name_str;
+
+		if (len - pos < sizeof (option))
+			goto fail;
+		memcpy (&option, &buf[pos], sizeof (option));
+		pos += sizeof (option);
+
+		if (   option.name_len == 0
+		    || len - pos < (gsize) option.name_len + option.value_len)
+			goto fail;
+		name = (const char *) &buf[pos];
+		value = &buf[pos + option.name_len];
+		pos += option.name_len + option.value_len;
+
+		if (!g_utf8_validate (name, option.name_len, NULL))
+			goto fail;
+
+		/* pick up the options we need while decoding, like g_variant_lookup()
+		 * the first occurrence wins. */
+		if (!iface && OPTION_IS (name, option.name_len, "interface"))
+			iface = convert_option (value, option.value_len);
+		else if (!pid_str && OPTION_IS (name, option.name_len, "pid"))
+			pid_str = convert_option (value, option.value_len);
+		else if (!reason && OPTION_IS (name, option.name_len, "reason"))
+			reason = convert_option (value, option.value_len);
+
+		name_str = g_strndup (name, option.name_len);
+		g_variant_builder_add (&builder, "{sv}",
+		                       name_str,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  value, option.value_len, 1));
+		g_free (name_str);
+	}
+
+	if (pos != len)
+		goto fail;
+
+	*out_timestamp = header.timestamp;
+	*out_iface = g_steal_pointer (&iface);
+	*out_pid = g_steal_pointer (&pid_str);
+	*out_reason = g_steal_pointer (&reason);
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+
+fail:
+	g_variant_builder_clear (&builder);
+	return NULL;
+}
+
+static gboolean
+handle_datagram (NMDhcpListener *self, const guint8 *buf, gsize len)
+{
+	gs_unref_variant GVariant *options = NULL;
+	gs_free char *iface = NULL;
+	gs_free char *pid_str = NULL;
+	gs_free char *reason = NULL;
+	gint64 timestamp;
+
+	options = _nm_dhcp_listener_decode_datagram (buf, len, &timestamp, &iface, &pid_str, &reason);
+	if (!options)
+		return FALSE;
+
+	emit_event (self, "socket", timestamp, iface, pid_str, reason, options);
+	return TRUE;
+}
+
+static const struct ucred *
+_get_creds (struct msghdr *msg)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR (msg); cmsg; cmsg = CMSG_NXTHDR (msg, cmsg)) {
+		if (   cmsg->cmsg_level == SOL_SOCKET
+		    && cmsg->cmsg_type == SCM_CREDENTIALS
+		    && cmsg->cmsg_len >= CMSG_LEN (sizeof (struct ucred)))
+			return (const struct ucred *) CMSG_DATA (cmsg);
+	}
+	return NULL;
+}
+
+static gboolean
+event_socket_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	guint n;
+
+	for (n = 0; n < EVENT_BATCH_MAX; n++) {
+		union {
+			struct cmsghdr cmsghdr;
+			char buf[CMSG_SPACE (sizeof (struct ucred))];
+		} control;
+		struct iovec iov = {
+			.iov_base = priv->event_buf,
+			.iov_len = NM_DHCP_HELPER_EVENT_MAX_SIZE,
+		};
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = &control,
+			.msg_controllen = sizeof (control),
+		};
+		const struct ucred *creds;
+		gssize len;
+
+		len = recvmsg (priv->event_fd, &msg, MSG_DONTWAIT | MSG_TRUNC);
+		if (len < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+			if (errsv != EAGAIN && errsv != EWOULDBLOCK)
+				nm_log_warn (LOGD_DHCP, "DHCP event socket: receive failed: %s", g_strerror (errsv));
+			break;
+		}
+
+		/* like the private D-Bus server, only accept events from root */
+		creds = _get_creds (&msg);
+		if (!creds || creds->uid != 0) {
+			nm_log_warn (LOGD_DHCP, "DHCP event socket: ignore datagram from unprivileged sender");
+			priv->stats.events_invalid++;
+			continue;
+		}
+
+		priv->stats.events_socket++;
+		if (   (msg.msg_flags & MSG_TRUNC)
+		    || len > NM_DHCP_HELPER_EVENT_MAX_SIZE
+		    || !handle_datagram (self, priv->event_buf, len)) {
+			nm_log_warn (LOGD_DHCP, "DHCP event socket: ignore malformed datagram of %zd bytes", len);
+			priv->stats.events_invalid++;
+		}
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+event_socket_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = { .sun_family = AF_UNIX, };
+	const int one = 1;
+	mode_t old_umask;
+	int fd, r, errsv;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH) <= sizeof (addr.sun_path));
+	memcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH));
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	if (setsockopt (fd, SOL_SOCKET, SO_PASSCRED, &one, sizeof (one)) < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	old_umask = umask (0077);
+	r = bind (fd, (struct sockaddr *) &addr, sizeof (addr));
+	errsv = errno;
+	umask (old_umask);
+	if (r < 0)
+		goto fail;
+
+	priv->event_fd = fd;
+	priv->event_buf = g_malloc (NM_DHCP_HELPER_EVENT_MAX_SIZE);
+	priv->event_channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, event_socket_cb, self);
+	return;
+
+fail:
+	/* not fatal, the helper falls back to D-Bus */
+	nm_log_warn (LOGD_DHCP, "DHCP event socket: cannot listen on %s: %s",
+	             NM_DHCP_HELPER_EVENT_SOCKET_PATH, g_strerror (errsv));
+	if (fd >= 0)
+		close (fd);
+}
+
+static void
+event_socket_close (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	if (priv->event_fd < 0)
+		return;
+
+	nm_clear_g_source (&priv->event_id);
+	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+	close (priv->event_fd);
+	priv->event_fd = -1;
+	g_clear_pointer (&priv->event_buf, g_free);
+	unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+}
+
+/**
+ * nm_dhcp_listener_get_stats:
+ * @self: the #NMDhcpListener
+ * @stats: (out): location to store the counters
+ *
+ * Returns the number of events received over each transport together with
+ * their delivery latency and the time spent handling them.
+ */
+void
+nm_dhcp_listener_get_stats (NMDhcpListener *self, NMDhcpListenerStats *stats)
+{
+	g_return_if_fail (NM_IS_DHCP_LISTENER (self));
+	g_return_if_fail (stats);
+
+	*stats = NM_DHCP_LISTENER_GET_PRIVATE (self)->stats;
+}
+
 static void
 new_connection_cb (NMBusManager *mgr,
                    GDBusConnection *connection,
@@ -191,10 +509,13 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps GDBusConnection :: GDBusProxy */
 	priv->signal_handlers = g_hash_table_new (NULL, NULL);
 
+	priv->event_fd = -1;
+	event_socket_open (self);
+
 	priv->dbus_mgr = nm_bus_manager_get ();
 
 	/* Register the socket our DHCP clients will return lease info on */
-	nm_bus_manager_private_server_register (priv->dbus_mgr, PRIV_SOCK_PATH, PRIV_SOCK_TAG);
+	nm_bus_manager_private_server_register (priv->dbus_mgr, PRIV_SOCK_PATH, PRIV_SOCK_TAG, FALSE);
 	priv->new_conn_id = g_signal_connect (priv->dbus_mgr,
 	                                      NM_BUS_MANAGER_PRIVATE_CONNECTION_NEW "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (new_connection_cb),
@@ -210,6 +531,8 @@ dispose (GObject *object)
 {
 	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (object);
 
+	event_socket_close ((NMDhcpListener *) object);
+
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->new_conn_id);
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->dis_conn_id);
 	priv->dbus_mgr = NULL;
@@ -31,8 +31,33 @@
 typedef GObject NMDhcpListener;
 typedef GObjectClass NMDhcpListenerClass;
 
+typedef struct {
+	guint64 events_socket;
+	guint64 events_dbus;
+	guint64 events_invalid;
+
+	/* time from the helper building the event until it is dispatched;
+	 * only known for events received over the socket */
+	guint64 latency_usec_total;
+	guint64 latency_usec_max;
+
+	/* time spent by the DHCP clients handling the events */
+	guint64 handling_usec_total;
+	guint64 handling_usec_max;
+} NMDhcpListenerStats;
+
 GType nm_dhcp_listener_get_type (void);
 
 NMDhcpListener *nm_dhcp_listener_get (void);
 
+void nm_dhcp_listener_get_stats (NMDhcpListener *self, NMDhcpListenerStats *stats);
+
+/* exposed for the unit tests */
+GVariant *_nm_dhcp_listener_decode_datagram (const guint8 *buf,
+                                             gsize len,
+                                             gint64 *out_timestamp,
+                                             char **out_iface,
+                                             char **out_pid,
+                                             char **out_reason);
+
 #endif /* __NETWORKMANAGER_DHCP_LISTENER_H__ */
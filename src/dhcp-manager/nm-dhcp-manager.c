@@ -50,6 +50,9 @@ typedef struct {
 	GType               client_type;
 	GHashTable *        clients;
 	char *              default_hostname;
+
+	/* earliest time for the next restart, in milliseconds */
+	gint64              restart_next_slot;
 } NMDhcpManagerPrivate;
 
 #define NM_DHCP_MANAGER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_MANAGER, NMDhcpManagerPrivate))
@@ -356,6 +359,70 @@ nm_dhcp_manager_get_lease_ip_configs (NMDhcpManager *self,
 	return NULL;
 }
 
+static gint64
+get_config_int (const char *key, gint64 max, gint64 fallback)
+{
+	const char *value;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         key,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	return _nm_utils_ascii_str_to_int64 (value, 10, 0, max, fallback);
+}
+
+/**
+ * nm_dhcp_manager_get_renewal_jitter:
+ * @self: the #NMDhcpManager
+ *
+ * Returns: by how many percent of the remaining window the DHCP clients
+ * should randomly delay their T1 and T2 timeouts, so that devices which
+ * got their leases at the same time don't all renew at once.
+ */
+guint
+nm_dhcp_manager_get_renewal_jitter (NMDhcpManager *self)
+{
+	g_return_val_if_fail (NM_IS_DHCP_MANAGER (self), 0);
+
+	return get_config_int (NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_RENEWAL_JITTER,
+	                       NM_DHCP_MANAGER_RENEWAL_JITTER_MAX,
+	                       NM_DHCP_MANAGER_RENEWAL_JITTER_DEFAULT);
+}
+
+/**
+ * nm_dhcp_manager_get_restart_delay:
+ * @self: the #NMDhcpManager
+ * @delay_ms: the nominal restart delay in milliseconds
+ *
+ * Computes when a device should restart DHCP after a failure. The nominal
+ * @delay_ms gets up to 10% of random jitter, and restarts of all devices
+ * are spaced to at most main.dhcp-restart-rate per second.
+ *
+ * Returns: the delay in milliseconds
+ */
+guint
+nm_dhcp_manager_get_restart_delay (NMDhcpManager *self, guint delay_ms)
+{
+	NMDhcpManagerPrivate *priv;
+	gint64 now, when, rate;
+
+	g_return_val_if_fail (NM_IS_DHCP_MANAGER (self), delay_ms);
+
+	priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
+	now = nm_utils_get_monotonic_timestamp_ms ();
+	when = now + delay_ms + g_random_int_range (0, delay_ms / 10 + 1);
+
+	rate = get_config_int (NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_RESTART_RATE, 1000, 0);
+	if (rate > 0) {
+		if (when < priv->restart_next_slot)
+			when = priv->restart_next_slot;
+		priv->restart_next_slot = when + 1000 / rate;
+	}
+
+	return MIN (when - now, (gint64) G_MAXUINT);
+}
+
 /***************************************************/
 
 NM_DEFINE_SINGLETON_GETTER (NMDhcpManager, nm_dhcp_manager_get, NM_TYPE_DHCP_MANAGER);
@@ -85,6 +85,15 @@ GSList *       nm_dhcp_manager_get_lease_ip_configs (NMDhcpManager *self,
                                                      gboolean ipv6,
                                                      guint32 default_route_metric);
 
+/* limits for the main.dhcp-renewal-jitter configuration option */
+#define NM_DHCP_MANAGER_RENEWAL_JITTER_DEFAULT 0
+#define NM_DHCP_MANAGER_RENEWAL_JITTER_MAX     50
+
+guint          nm_dhcp_manager_get_renewal_jitter (NMDhcpManager *self);
+
+guint          nm_dhcp_manager_get_restart_delay (NMDhcpManager *self,
+                                                  guint delay_ms);
+
 /* For testing only */
 extern const char* nm_dhcp_helper_path;
 
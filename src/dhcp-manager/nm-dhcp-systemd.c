@@ -27,12 +27,15 @@
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <net/if_arp.h>
+#include <sys/stat.h>
 
 #include "nm-dhcp-systemd.h"
 #include "nm-utils.h"
 #include "nm-dhcp-utils.h"
+#include "nm-dhcp-manager.h"
 #include "NetworkManagerUtils.h"
 #include "nm-platform.h"
+#include "nm-config.h"
 #include "nm-dhcp-client-logging.h"
 
 #include "sd-dhcp-client.h"
@@ -50,6 +53,11 @@ typedef struct {
 	sd_dhcp6_client *client6;
 	char *lease_file;
 
+	/* the stored lease applied before the server confirmed it */
+	sd_dhcp_lease *optimistic_lease;
+	time_t optimistic_expiry;
+	guint optimistic_id;
+
 	guint request_count;
 
 	gboolean privacy;
@@ -456,6 +464,118 @@ _save_client_id (NMDhcpSystemd *self,
 	}
 }
 
+/* a stored lease that expires sooner is not worth applying */
+#define OPTIMISTIC_MIN_REMAINING_SEC   60
+/* how long the server has to confirm an optimistically applied lease */
+#define OPTIMISTIC_CONFIRM_TIMEOUT_SEC 30
+
+static void
+optimistic_clear (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->optimistic_id);
+	if (priv->optimistic_lease)
+		priv->optimistic_lease = sd_dhcp_lease_unref (priv->optimistic_lease);
+}
+
+static gboolean
+optimistic_timeout_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self = NM_DHCP_SYSTEMD (user_data);
+
+	NM_DHCP_SYSTEMD_GET_PRIVATE (self)->optimistic_id = 0;
+	_LOGW ("stored lease was not confirmed by the server");
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_EXPIRE, NULL, NULL);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+optimistic_apply_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self = NM_DHCP_SYSTEMD (user_data);
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+	GHashTable *options;
+	NMPlatformIP4Address address;
+	GError *error = NULL;
+	gint64 remaining;
+
+	priv->optimistic_id = 0;
+
+	remaining = (gint64) priv->optimistic_expiry - time (NULL);
+	if (remaining < OPTIMISTIC_MIN_REMAINING_SEC) {
+		optimistic_clear (self);
+		return G_SOURCE_REMOVE;
+	}
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	ip4_config = lease_to_ip4_config (nm_dhcp_client_get_iface (NM_DHCP_CLIENT (self)),
+	                                  nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (self)),
+	                                  priv->optimistic_lease,
+	                                  options,
+	                                  nm_dhcp_client_get_priority (NM_DHCP_CLIENT (self)),
+	                                  FALSE,
+	                                  &error);
+	optimistic_clear (self);
+	if (!ip4_config || !nm_ip4_config_get_num_addresses (ip4_config)) {
+		_LOGD ("stored lease not usable: %s", error ? error->message : "no address");
+		g_clear_error (&error);
+		g_hash_table_destroy (options);
+		return G_SOURCE_REMOVE;
+	}
+
+	/* the lease was granted a while ago; only use what is left of it */
+	address = *nm_ip4_config_get_address (ip4_config, 0);
+	address.lifetime = address.preferred = remaining;
+	nm_ip4_config_add_address (ip4_config, &address);
+	add_option_u64 (options,
+	                dhcp4_requests,
+	                SD_DHCP_OPTION_IP_ADDRESS_LEASE_TIME,
+	                priv->optimistic_expiry);
+	add_requests_to_options (options, dhcp4_requests);
+
+	_LOGI ("applying stored lease for %s while confirming it",
+	       nm_utils_inet4_ntop (address.address, NULL));
+
+	priv->optimistic_id = g_timeout_add_seconds (MIN (remaining, OPTIMISTIC_CONFIRM_TIMEOUT_SEC),
+	                                             optimistic_timeout_cb,
+	                                             self);
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self),
+	                          NM_DHCP_STATE_BOUND,
+	                          G_OBJECT (ip4_config),
+	                          options);
+	g_hash_table_destroy (options);
+	return G_SOURCE_REMOVE;
+}
+
+/* Applies @lease right away, before the server confirmed it with an ACK
+ * to the INIT-REBOOT REQUEST that sd-dhcp-client sends for its address. */
+static void
+optimistic_schedule (NMDhcpSystemd *self, sd_dhcp_lease *lease)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	struct stat st;
+	uint32_t lifetime = 0;
+
+	if (!nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA,
+	                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                       NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_OPTIMISTIC_LEASE,
+	                                       FALSE))
+		return;
+
+	/* the lease file is written when the lease is granted */
+	if (   stat (priv->lease_file, &st) != 0
+	    || sd_dhcp_lease_get_lifetime (lease, &lifetime) < 0
+	    || (gint64) st.st_mtime + lifetime - time (NULL) < OPTIMISTIC_MIN_REMAINING_SEC)
+		return;
+
+	optimistic_clear (self);
+	priv->optimistic_lease = sd_dhcp_lease_ref (lease);
+	priv->optimistic_expiry = st.st_mtime + lifetime;
+	priv->optimistic_id = g_idle_add (optimistic_apply_cb, self);
+}
+
 static void
 bound4_handle (NMDhcpSystemd *self)
 {
@@ -467,6 +587,9 @@ bound4_handle (NMDhcpSystemd *self)
 	GError *error = NULL;
 	int r;
 
+	/* any answer from the server supersedes the stored lease */
+	optimistic_clear (self);
+
 	r = sd_dhcp_client_get_lease (priv->client4, &lease);
 	if (r < 0 || !lease) {
 		_LOGW ("no lease!");
@@ -622,6 +745,24 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 		goto error;
 	}
 
+	r = sd_dhcp_client_set_renewal_jitter (priv->client4,
+	                                       nm_dhcp_manager_get_renewal_jitter (nm_dhcp_manager_get ()));
+	if (r < 0) {
+		_LOGW ("failed to set renewal jitter (%d)", r);
+		goto error;
+	}
+
+	if (nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA,
+	                                      NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                      NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_SHARED_SOCKET,
+	                                      FALSE)) {
+		r = sd_dhcp_client_set_shared_raw_socket (priv->client4, true);
+		if (r < 0) {
+			_LOGW ("failed to enable the shared packet socket (%d)", r);
+			goto error;
+		}
+	}
+
 	dhcp_lease_load (&lease, priv->lease_file);
 
 	if (last_ip4_address)
@@ -702,6 +843,11 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 
 	nm_dhcp_client_start_timeout (client);
 
+	/* The client starts in INIT-REBOOT, requesting the stored address. An
+	 * address given by the caller is already configured on the device. */
+	if (lease && !last_ip4_address)
+		optimistic_schedule (self, lease);
+
 	success = TRUE;
 
 error:
@@ -981,6 +1127,8 @@ stop (NMDhcpClient *client, gboolean release, const GByteArray *duid)
 	       priv->client4 ? '4' : '6',
 	       priv->client4 ? (gpointer) priv->client4 : (gpointer) priv->client6);
 
+	optimistic_clear (self);
+
 	if (priv->client4) {
 		sd_dhcp_client_set_callback (priv->client4, NULL, NULL);
 		r = sd_dhcp_client_stop (priv->client4);
@@ -1005,6 +1153,7 @@ dispose (GObject *object)
 {
 	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (object);
 
+	optimistic_clear (NM_DHCP_SYSTEMD (object));
 	g_clear_pointer (&priv->lease_file, g_free);
 
 	if (priv->client4) {
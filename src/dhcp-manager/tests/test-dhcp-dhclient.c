@@ -765,6 +765,48 @@ test_read_lease_ip4_config_expired (void)
 	g_free (contents);
 }
 
+static void
+test_read_lease_ip4_config_parsed_reuse (void)
+{
+	GError *error = NULL;
+	char *contents = NULL;
+	gboolean success;
+	const char *path = TESTDIR "/leases/basic.leases";
+	GPtrArray *parsed;
+	GSList *leases;
+	GDateTime *now;
+
+	success = g_file_get_contents (path, &contents, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+
+	parsed = nm_dhcp_dhclient_parse_leases (contents);
+	g_assert_cmpint (parsed->len, ==, 2);
+
+	/* The parsed leases can be converted repeatedly, with different
+	 * interfaces and dates */
+	now = g_date_time_new_utc (2013, 11, 1, 19, 55, 32);
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, "wlan0", -1, FALSE, now);
+	g_assert_cmpint (g_slist_length (leases), ==, 2);
+	g_slist_free_full (leases, g_object_unref);
+
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, "wlan0", -1, FALSE, now);
+	g_assert_cmpint (g_slist_length (leases), ==, 2);
+	g_slist_free_full (leases, g_object_unref);
+
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, "eth0", -1, FALSE, now);
+	g_assert (leases == NULL);
+	g_date_time_unref (now);
+
+	now = g_date_time_new_utc (2013, 12, 1, 19, 55, 32);
+	leases = nm_dhcp_dhclient_leases_to_ip_configs (parsed, "wlan0", -1, FALSE, now);
+	g_assert (leases == NULL);
+	g_date_time_unref (now);
+
+	g_ptr_array_unref (parsed);
+	g_free (contents);
+}
+
 static void
 test_read_lease_ip4_config_expect_failure (gconstpointer user_data)
 {
@@ -820,6 +862,7 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/dhcp/dhclient/leases/ip4-config/basic", test_read_lease_ip4_config_basic);
 	g_test_add_func ("/dhcp/dhclient/leases/ip4-config/expired", test_read_lease_ip4_config_expired);
+	g_test_add_func ("/dhcp/dhclient/leases/ip4-config/parsed-reuse", test_read_lease_ip4_config_parsed_reuse);
 	g_test_add_data_func ("/dhcp/dhclient/leases/ip4-config/missing-address",
 	                      TESTDIR "/leases/malformed1.leases",
 	                      test_read_lease_ip4_config_expect_failure);
@@ -0,0 +1,251 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+
+#include "nm-dhcp-listener.h"
+#include "nm-dhcp-helper-api.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static GByteArray *
+datagram_new (guint16 n_options, gint64 timestamp)
+{
+	NMDhcpHelperEventHeader header = {
+		.magic = NM_DHCP_HELPER_EVENT_MAGIC,
+		.version = NM_DHCP_HELPER_EVENT_VERSION,
+		.n_options = n_options,
+		.timestamp = timestamp,
+	};
+	GByteArray *buf;
+
+	buf = g_byte_array_new ();
+	g_byte_array_append (buf, (const guint8 *) &header, sizeof (header));
+	return buf;
+}
+
+static void
+datagram_add (GByteArray *buf, const char *name, const char *value, gsize value_len)
+{
+	NMDhcpHelperEventOption option = {
+		.name_len = strlen (name),
+		.value_len = value_len,
+	};
+
+	g_byte_array_append (buf, (const guint8 *) &option, sizeof (option));
+	g_byte_array_append (buf, (const guint8 *) name, option.name_len);
+	g_byte_array_append (buf, (const guint8 *) value, value_len);
+}
+
+static GVariant *
+decode (GByteArray *buf, gint64 *timestamp, char **iface, char **pid, char **reason)
+{
+	*iface = *pid = *reason = NULL;
+	*timestamp = 0;
+	return _nm_dhcp_listener_decode_datagram (buf->data, buf->len, timestamp, iface, pid, reason);
+}
+
+static void
+assert_option (GVariant *options, const char *name, const char *expected, gsize expected_len)
+{
+	gs_unref_variant GVariant *value = NULL;
+	const guint8 *bytes;
+	gsize len;
+
+	g_assert (g_variant_lookup (options, name, "@ay", &value));
+	bytes = g_variant_get_fixed_array (value, &len, 1);
+	g_assert_cmpint (len, ==, expected_len);
+	g_assert (memcmp (bytes, expected, len) == 0);
+}
+
+/*****************************************************************************/
+
+static void
+test_decode_event (void)
+{
+	gs_unref_variant GVariant *options = NULL;
+	gs_free char *iface = NULL;
+	gs_free char *pid = NULL;
+	gs_free char *reason = NULL;
+	GByteArray *buf;
+	gint64 timestamp;
+
+	buf = datagram_new (5, 4711);
+	datagram_add (buf, "interface", "eth0", 4);
+	datagram_add (buf, "pid", "1234", 4);
+	datagram_add (buf, "reason", "BOUND", 5);
+	datagram_add (buf, "new_domain_name", "a\0b\xe4", 4);
+	datagram_add (buf, "interface", "eth1", 4);
+
+	options = decode (buf, &timestamp, &iface, &pid, &reason);
+	g_assert (options);
+	g_assert (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (timestamp, ==, 4711);
+
+	/* the first occurrence wins, like with g_variant_lookup() */
+	g_assert_cmpstr (iface, ==, "eth0");
+	g_assert_cmpstr (pid, ==, "1234");
+	g_assert_cmpstr (reason, ==, "BOUND");
+
+	/* values are passed on unchanged, as over D-Bus */
+	assert_option (options, "interface", "eth0", 4);
+	assert_option (options, "reason", "BOUND", 5);
+	assert_option (options, "new_domain_name", "a\0b\xe4", 4);
+
+	g_byte_array_unref (buf);
+}
+
+static void
+test_decode_converts_options (void)
+{
+	gs_unref_variant GVariant *options = NULL;
+	gs_free char *iface = NULL;
+	gs_free char *pid = NULL;
+	gs_free char *reason = NULL;
+	GByteArray *buf;
+	gint64 timestamp;
+
+	buf = datagram_new (3, 1);
+	datagram_add (buf, "interface", "et\0h\xe4", 5);
+	datagram_add (buf, "reason", "", 0);
+	datagram_add (buf, "new_ip_address", "192.168.1.2", 11);
+
+	options = decode (buf, &timestamp, &iface, &pid, &reason);
+	g_assert (options);
+	g_assert_cmpstr (iface, ==, "et h?");
+	g_assert_cmpstr (reason, ==, "");
+	g_assert (!pid);
+	assert_option (options, "new_ip_address", "192.168.1.2", 11);
+
+	g_byte_array_unref (buf);
+}
+
+static void
+test_decode_no_options (void)
+{
+	gs_unref_variant GVariant *options = NULL;
+	gs_free char *iface = NULL;
+	gs_free char *pid = NULL;
+	gs_free char *reason = NULL;
+	GByteArray *buf;
+	gint64 timestamp;
+
+	buf = datagram_new (0, 2);
+	options = decode (buf, &timestamp, &iface, &pid, &reason);
+	g_assert (options);
+	g_assert_cmpint (g_variant_n_children (options), ==, 0);
+	g_assert (!iface);
+	g_assert (!pid);
+	g_assert (!reason);
+
+	g_byte_array_unref (buf);
+}
+
+static void
+assert_malformed (GByteArray *buf, gsize len)
+{
+	char *iface, *pid, *reason;
+	gint64 timestamp;
+
+	iface = pid = reason = NULL;
+	g_assert (!_nm_dhcp_listener_decode_datagram (buf->data, len, &timestamp, &iface, &pid, &reason));
+	g_assert (!iface);
+	g_assert (!pid);
+	g_assert (!reason);
+}
+
+static void
+test_decode_malformed (void)
+{
+	NMDhcpHelperEventHeader *header;
+	GByteArray *buf;
+	gsize full;
+
+	buf = datagram_new (2, 3);
+	datagram_add (buf, "interface", "eth0", 4);
+	datagram_add (buf, "reason", "BOUND", 5);
+	full = buf->len;
+
+	/* shorter than the header */
+	assert_malformed (buf, sizeof (NMDhcpHelperEventHeader) - 1);
+
+	/* truncated inside the header of the last option, and inside its value */
+	assert_malformed (buf, full - 5 - 6 - sizeof (NMDhcpHelperEventOption) + 1);
+	assert_malformed (buf, full - 1);
+
+	/* trailing bytes after the announced options */
+	g_byte_array_append (buf, (const guint8 *) "x", 1);
+	assert_malformed (buf, buf->len);
+	g_byte_array_set_size (buf, full);
+
+	/* more options announced than present */
+	header = (NMDhcpHelperEventHeader *) buf->data;
+	header->n_options = 3;
+	assert_malformed (buf, buf->len);
+	header->n_options = 2;
+
+	/* wrong magic or version */
+	header->magic = ~NM_DHCP_HELPER_EVENT_MAGIC;
+	assert_malformed (buf, buf->len);
+	header->magic = NM_DHCP_HELPER_EVENT_MAGIC;
+	header->version = NM_DHCP_HELPER_EVENT_VERSION + 1;
+	assert_malformed (buf, buf->len);
+
+	g_byte_array_unref (buf);
+}
+
+static void
+test_decode_invalid_name (void)
+{
+	GByteArray *buf;
+
+	/* empty option name */
+	buf = datagram_new (1, 4);
+	datagram_add (buf, "", "eth0", 4);
+	assert_malformed (buf, buf->len);
+	g_byte_array_unref (buf);
+
+	/* option name that is not UTF-8 */
+	buf = datagram_new (1, 4);
+	datagram_add (buf, "inter\xff", "eth0", 4);
+	assert_malformed (buf, buf->len);
+	g_byte_array_unref (buf);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/listener/decode/event", test_decode_event);
+	g_test_add_func ("/dhcp/listener/decode/converts-options", test_decode_converts_options);
+	g_test_add_func ("/dhcp/listener/decode/no-options", test_decode_no_options);
+	g_test_add_func ("/dhcp/listener/decode/malformed", test_decode_malformed);
+	g_test_add_func ("/dhcp/listener/decode/invalid-name", test_decode_invalid_name);
+
+	return g_test_run ();
+}
@@ -52,7 +52,19 @@ typedef struct {
 	GCancellable *update_cancellable;
 	gboolean running;
 
+	/* arguments of the next SetServersEx call, if any */
 	GVariant *set_server_ex_args;
+
+	/* arguments of the last SetServersEx call sent to the running
+	 * dnsmasq, used to suppress updates that change nothing. */
+	GVariant *last_args;
+
+	/* whether the cache must be cleared once the pending update is done */
+	gboolean clear_cache_pending;
+
+	guint num_pushes;
+	guint num_suppressed;
+	guint num_cache_clears;
 } NMDnsDnsmasqPrivate;
 
 /*****************************************************************************/
@@ -301,8 +313,10 @@ dnsmasq_clear_cache_done (GDBusProxy *proxy, GAsyncResult *res, gpointer user_da
 
 	if (!response)
 		_LOGW ("dnsmasq cache clear failed: %s", error->message);
-	else
+	else {
+		NM_DNS_DNSMASQ_GET_PRIVATE (self)->num_cache_clears++;
 		_LOGD ("dnsmasq update successful, cache cleared");
+	}
 }
 
 static void
@@ -320,9 +334,14 @@ dnsmasq_update_done (GDBusProxy *proxy, GAsyncResult *res, gpointer user_data)
 	self = NM_DNS_DNSMASQ (user_data);
 	priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
 
-	if (!response)
+	if (!response) {
 		_LOGW ("dnsmasq update failed: %s", error->message);
+		/* we don't know what dnsmasq uses now; don't suppress the next update */
+		g_clear_pointer (&priv->last_args, g_variant_unref);
+	} else if (!priv->clear_cache_pending)
+		_LOGD ("dnsmasq update successful");
 	else {
+		priv->clear_cache_pending = FALSE;
 		g_dbus_proxy_call (priv->dnsmasq,
 		                   "ClearCache",
 		                   NULL,
@@ -343,7 +362,16 @@ send_dnsmasq_update (NMDnsDnsmasq *self)
 		return;
 
 	if (priv->running) {
-		_LOGD ("trying to update dnsmasq nameservers");
+		/* The cached answers came from the old servers and may be wrong
+		 * with any other set of servers: a VPN starting to serve a domain
+		 * the default servers answered with NXDOMAIN, but also a VPN going
+		 * away, whose answers must not outlive it. Unchanged updates are
+		 * suppressed before getting here, so always clear the cache. */
+		priv->clear_cache_pending = TRUE;
+
+		priv->num_pushes++;
+		_LOGD ("trying to update dnsmasq nameservers and clear the cache (%u updates sent, %u suppressed, %u cache clears)",
+		       priv->num_pushes, priv->num_suppressed, priv->num_cache_clears);
 
 		nm_clear_g_cancellable (&priv->update_cancellable);
 		priv->update_cancellable = g_cancellable_new ();
@@ -356,7 +384,9 @@ send_dnsmasq_update (NMDnsDnsmasq *self)
 		                   priv->update_cancellable,
 		                   (GAsyncReadyCallback) dnsmasq_update_done,
 		                   self);
-		g_clear_pointer (&priv->set_server_ex_args, g_variant_unref);
+		g_clear_pointer (&priv->last_args, g_variant_unref);
+		priv->last_args = priv->set_server_ex_args;
+		priv->set_server_ex_args = NULL;
 	} else
 		_LOGD ("dnsmasq not found on the bus. The nameserver update will be sent when dnsmasq appears");
 }
@@ -378,6 +408,7 @@ name_owner_changed (GObject    *object,
 	} else {
 		_LOGI ("dnsmasq disappeared");
 		priv->running = FALSE;
+		g_clear_pointer (&priv->last_args, g_variant_unref);
 		g_signal_emit_by_name (self, NM_DNS_PLUGIN_FAILED);
 	}
 }
@@ -494,6 +525,7 @@ update (NMDnsPlugin *plugin,
 	NMDnsDnsmasq *self = NM_DNS_DNSMASQ (plugin);
 	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
 	GVariantBuilder servers;
+	GVariant *args;
 
 	start_dnsmasq (self);
 
@@ -508,8 +540,19 @@ update (NMDnsPlugin *plugin,
 		}
 	}
 
+	args = g_variant_ref_sink (g_variant_new ("(aas)", &servers));
+
 	g_clear_pointer (&priv->set_server_ex_args, g_variant_unref);
-	priv->set_server_ex_args = g_variant_ref_sink (g_variant_new ("(aas)", &servers));
+	if (   priv->running
+	    && priv->last_args
+	    && g_variant_equal (priv->last_args, args)) {
+		/* dnsmasq already has (or is about to get) this configuration */
+		priv->num_suppressed++;
+		_LOGD ("dnsmasq nameservers unchanged, skipping update");
+		g_variant_unref (args);
+		return TRUE;
+	}
+	priv->set_server_ex_args = args;
 
 	send_dnsmasq_update (self);
 
@@ -525,6 +568,8 @@ child_quit (NMDnsPlugin *plugin, gint status)
 	gboolean failed = TRUE;
 	int err;
 
+	g_clear_pointer (&NM_DNS_DNSMASQ_GET_PRIVATE (self)->last_args, g_variant_unref);
+
 	if (WIFEXITED (status)) {
 		err = WEXITSTATUS (status);
 		if (err) {
@@ -581,6 +626,7 @@ dispose (GObject *object)
 	g_clear_object (&priv->dnsmasq);
 
 	g_clear_pointer (&priv->set_server_ex_args, g_variant_unref);
+	g_clear_pointer (&priv->last_args, g_variant_unref);
 
 	G_OBJECT_CLASS (nm_dns_dnsmasq_parent_class)->dispose (object);
 }
@@ -42,10 +42,13 @@
 #include "nm-ip6-config.h"
 #include "NetworkManagerUtils.h"
 #include "nm-config.h"
+#include "nm-executor.h"
+#include "nm-statistics.h"
 
 #include "nm-dns-plugin.h"
 #include "nm-dns-dnsmasq.h"
 #include "nm-dns-unbound.h"
+#include "nm-dns-stub.h"
 
 #if WITH_LIBSOUP
 #include <libsoup/soup.h>
@@ -89,7 +92,7 @@ NM_DEFINE_SINGLETON_INSTANCE (NMDnsManager);
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             char __prefix[20]; \
             const NMDnsManager *const __self = (self); \
             \
@@ -113,8 +116,8 @@ typedef struct _NMDnsManagerPrivate {
 	char *hostname;
 	guint updates_queue;
 
-	guint8 hash[HASH_LEN];  /* SHA1 hash of current DNS config */
-	guint8 prev_hash[HASH_LEN];  /* Hash when begin_updates() was called */
+	guint64 hash;  /* digest of current DNS config */
+	guint64 prev_hash;  /* digest when begin_updates() was called */
 
 	NMDnsManagerResolvConfManager rc_manager;
 	NMDnsPlugin *plugin;
@@ -123,6 +126,18 @@ typedef struct _NMDnsManagerPrivate {
 
 	gboolean dns_touched;
 
+	/* what was last handed to netconfig or resolvconf successfully,
+	 * prefixed by the tool's name */
+	char *last_dispatch;
+
+	/* changes waiting for the deferred update_dns() */
+	struct {
+		guint timeout_id;
+		guint triggers;
+		/* when the first of them was made (or its batch began) */
+		gint64 first_ts;
+	} deferred;
+
 	struct {
 		guint64 ts;
 		guint num_restarts;
@@ -151,8 +166,30 @@ typedef struct {
 	GPtrArray *options;
 	const char *nis_domain;
 	GPtrArray *nis_servers;
+
+	/* the items in the arrays, for skipping duplicates. The options are
+	 * indexed by their name. */
+	GHashTable *nameservers_idx;
+	GHashTable *searches_idx;
+	GHashTable *options_idx;
+	GHashTable *nis_servers_idx;
 } NMResolvConfData;
 
+/* What one IP config adds to resolv.conf, in order and not yet
+ * deduplicated. It is kept in NMDnsIPConfigData and only recomputed
+ * when the digest of the config changes, so that an update with many
+ * configs only formats the entries of the configs that changed. */
+typedef struct {
+	guint64 digest;
+	GPtrArray *nameservers;
+	GPtrArray *searches;
+	GPtrArray *options;
+	/* the names of @options, %NULL for invalid options */
+	GPtrArray *option_names;
+	GPtrArray *nis_servers;
+	char *nis_domain;
+} NMDnsConfigContribution;
+
 NM_UTILS_LOOKUP_STR_DEFINE_STATIC (_rc_manager_to_string, NMDnsManagerResolvConfManager,
 	NM_UTILS_LOOKUP_DEFAULT_WARN (NULL),
 	NM_UTILS_LOOKUP_STR_ITEM (NM_DNS_MANAGER_RESOLV_CONF_MAN_UNKNOWN,        "unknown"),
@@ -194,6 +231,7 @@ ip_config_data_destroy (gpointer ptr)
 
 	g_object_unref (data->config);
 	g_free (data->iface);
+	contribution_free (data->contribution);
 	g_slice_free (NMDnsIPConfigData, data);
 }
 
@@ -238,41 +276,100 @@ ip_config_data_ptr_compare (gconstpointer a, gconstpointer b)
 }
 
 static void
-add_string_item (GPtrArray *array, const char *str)
+add_string_item (GPtrArray *array, GHashTable *idx, const char *str)
 {
-	int i;
+	char *item;
 
 	g_return_if_fail (array != NULL);
 	g_return_if_fail (str != NULL);
 
-	/* Check for dupes before adding */
-	for (i = 0; i < array->len; i++) {
-		const char *candidate = g_ptr_array_index (array, i);
+	if (g_hash_table_contains (idx, str))
+		return;
 
-		if (candidate && !strcmp (candidate, str))
+	/* No dupes, add the new item */
+	item = g_strdup (str);
+	g_ptr_array_add (array, item);
+	g_hash_table_add (idx, item);
+}
+
+static void
+add_dns_option_item (NMResolvConfData *rc, const char *option, const char *name)
+{
+	/* invalid options are passed on as they are */
+	if (name) {
+		if (g_hash_table_contains (rc->options_idx, name))
 			return;
+		g_hash_table_add (rc->options_idx, (char *) name);
 	}
+	g_ptr_array_add (rc->options, g_strdup (option));
+}
 
-	/* No dupes, add the new item */
-	g_ptr_array_add (array, g_strdup (str));
+static void
+resolv_conf_data_init (NMResolvConfData *rc)
+{
+	memset (rc, 0, sizeof (*rc));
+	rc->nameservers = g_ptr_array_new ();
+	rc->searches = g_ptr_array_new ();
+	rc->options = g_ptr_array_new ();
+	rc->nis_servers = g_ptr_array_new ();
+	rc->nameservers_idx = g_hash_table_new (g_str_hash, g_str_equal);
+	rc->searches_idx = g_hash_table_new (g_str_hash, g_str_equal);
+	rc->options_idx = g_hash_table_new (g_str_hash, g_str_equal);
+	rc->nis_servers_idx = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+/*********************************************************************************************/
+
+static NMDnsConfigContribution *
+contribution_new (guint64 digest)
+{
+	NMDnsConfigContribution *c;
+
+	c = g_slice_new0 (NMDnsConfigContribution);
+	c->digest = digest;
+	c->nameservers = g_ptr_array_new_with_free_func (g_free);
+	c->searches = g_ptr_array_new_with_free_func (g_free);
+	c->options = g_ptr_array_new_with_free_func (g_free);
+	c->option_names = g_ptr_array_new_with_free_func (g_free);
+	c->nis_servers = g_ptr_array_new_with_free_func (g_free);
+	return c;
 }
 
 static void
-add_dns_option_item (GPtrArray *array, const char *str, gboolean ipv6)
+contribution_free (NMDnsConfigContribution *c)
 {
-	if (_nm_utils_dns_option_find_idx (array, str) < 0)
-		g_ptr_array_add (array, g_strdup (str));
+	if (!c)
+		return;
+
+	g_ptr_array_unref (c->nameservers);
+	g_ptr_array_unref (c->searches);
+	g_ptr_array_unref (c->options);
+	g_ptr_array_unref (c->option_names);
+	g_ptr_array_unref (c->nis_servers);
+	g_free (c->nis_domain);
+	g_slice_free (NMDnsConfigContribution, c);
 }
 
 static void
-merge_one_ip4_config (NMResolvConfData *rc, NMIP4Config *src)
+contribution_add_option (NMDnsConfigContribution *c, const char *option)
+{
+	char *name = NULL;
+
+	if (!_nm_utils_dns_option_validate (option, &name, NULL, FALSE, NULL))
+		name = NULL;
+	g_ptr_array_add (c->options, g_strdup (option));
+	g_ptr_array_add (c->option_names, name);
+}
+
+static void
+contribution_fill_ip4 (NMDnsConfigContribution *c, NMIP4Config *src)
 {
 	guint32 num, num_domains, num_searches, i;
 
 	num = nm_ip4_config_get_num_nameservers (src);
 	for (i = 0; i < num; i++) {
-		add_string_item (rc->nameservers,
-		                 nm_utils_inet4_ntop (nm_ip4_config_get_nameserver (src, i), NULL));
+		g_ptr_array_add (c->nameservers,
+		                 g_strdup (nm_utils_inet4_ntop (nm_ip4_config_get_nameserver (src, i), NULL)));
 	}
 
 	num_domains = nm_ip4_config_get_num_domains (src);
@@ -284,7 +381,7 @@ merge_one_ip4_config (NMResolvConfData *rc, NMIP4Config *src)
 		search = nm_ip4_config_get_search (src, i);
 		if (!DOMAIN_IS_VALID (search))
 			continue;
-		add_string_item (rc->searches, search);
+		g_ptr_array_add (c->searches, g_strdup (search));
 	}
 
 	if (num_domains > 1 || !num_searches) {
@@ -294,34 +391,26 @@ merge_one_ip4_config (NMResolvConfData *rc, NMIP4Config *src)
 			domain = nm_ip4_config_get_domain (src, i);
 			if (!DOMAIN_IS_VALID (domain))
 				continue;
-			add_string_item (rc->searches, domain);
+			g_ptr_array_add (c->searches, g_strdup (domain));
 		}
 	}
 
 	num = nm_ip4_config_get_num_dns_options (src);
-	for (i = 0; i < num; i++) {
-		const char *option;
-
-		option = nm_ip4_config_get_dns_option (src, i);
-		add_dns_option_item (rc->options, option, FALSE);
-	}
+	for (i = 0; i < num; i++)
+		contribution_add_option (c, nm_ip4_config_get_dns_option (src, i));
 
 	/* NIS stuff */
 	num = nm_ip4_config_get_num_nis_servers (src);
 	for (i = 0; i < num; i++) {
-		add_string_item (rc->nis_servers,
-		                 nm_utils_inet4_ntop (nm_ip4_config_get_nis_server (src, i), NULL));
+		g_ptr_array_add (c->nis_servers,
+		                 g_strdup (nm_utils_inet4_ntop (nm_ip4_config_get_nis_server (src, i), NULL)));
 	}
 
-	if (nm_ip4_config_get_nis_domain (src)) {
-		/* FIXME: handle multiple domains */
-		if (!rc->nis_domain)
-			rc->nis_domain = nm_ip4_config_get_nis_domain (src);
-	}
+	c->nis_domain = g_strdup (nm_ip4_config_get_nis_domain (src));
 }
 
 static void
-merge_one_ip6_config (NMResolvConfData *rc, NMIP6Config *src, const char *iface)
+contribution_fill_ip6 (NMDnsConfigContribution *c, NMIP6Config *src, const char *iface)
 {
 	guint32 num, num_domains, num_searches, i;
 
@@ -342,7 +431,7 @@ merge_one_ip6_config (NMResolvConfData *rc, NMIP6Config *src, const char *iface)
 				g_strlcat (buf, iface, sizeof (buf));
 			}
 		}
-		add_string_item (rc->nameservers, buf);
+		g_ptr_array_add (c->nameservers, g_strdup (buf));
 	}
 
 	num_domains = nm_ip6_config_get_num_domains (src);
@@ -354,7 +443,7 @@ merge_one_ip6_config (NMResolvConfData *rc, NMIP6Config *src, const char *iface)
 		search = nm_ip6_config_get_search (src, i);
 		if (!DOMAIN_IS_VALID (search))
 			continue;
-		add_string_item (rc->searches, search);
+		g_ptr_array_add (c->searches, g_strdup (search));
 	}
 
 	if (num_domains > 1 || !num_searches) {
@@ -364,17 +453,38 @@ merge_one_ip6_config (NMResolvConfData *rc, NMIP6Config *src, const char *iface)
 			domain = nm_ip6_config_get_domain (src, i);
 			if (!DOMAIN_IS_VALID (domain))
 				continue;
-			add_string_item (rc->searches, domain);
+			g_ptr_array_add (c->searches, g_strdup (domain));
 		}
 	}
 
 	num = nm_ip6_config_get_num_dns_options (src);
-	for (i = 0; i < num; i++) {
-		const char *option;
+	for (i = 0; i < num; i++)
+		contribution_add_option (c, nm_ip6_config_get_dns_option (src, i));
+}
 
-		option = nm_ip6_config_get_dns_option (src, i);
-		add_dns_option_item (rc->options, option, TRUE);
-	}
+static const NMDnsConfigContribution *
+ip_config_data_get_contribution (NMDnsIPConfigData *data)
+{
+	NMDnsConfigContribution *c = data->contribution;
+	guint64 digest;
+
+	/* The DNS digest of IPv4 doesn't cover NIS, use the full one. */
+	if (NM_IS_IP4_CONFIG (data->config))
+		digest = nm_ip4_config_get_digest ((NMIP4Config *) data->config, FALSE);
+	else
+		digest = nm_ip6_config_get_digest ((NMIP6Config *) data->config, TRUE);
+
+	if (c && c->digest == digest)
+		return c;
+
+	contribution_free (c);
+	c = contribution_new (digest);
+	if (NM_IS_IP4_CONFIG (data->config))
+		contribution_fill_ip4 (c, (NMIP4Config *) data->config);
+	else
+		contribution_fill_ip6 (c, (NMIP6Config *) data->config, data->iface);
+	data->contribution = c;
+	return c;
 }
 
 static void
@@ -382,12 +492,27 @@ merge_one_ip_config_data (NMDnsManager *self,
                           NMResolvConfData *rc,
                           NMDnsIPConfigData *data)
 {
-	if (NM_IS_IP4_CONFIG (data->config))
-		merge_one_ip4_config (rc, (NMIP4Config *) data->config);
-	else if (NM_IS_IP6_CONFIG (data->config))
-		merge_one_ip6_config (rc, (NMIP6Config *) data->config, data->iface);
-	else
-		g_return_if_reached ();
+	const NMDnsConfigContribution *c;
+	guint i;
+
+	g_return_if_fail (NM_IS_IP4_CONFIG (data->config) || NM_IS_IP6_CONFIG (data->config));
+
+	c = ip_config_data_get_contribution (data);
+
+	for (i = 0; i < c->nameservers->len; i++)
+		add_string_item (rc->nameservers, rc->nameservers_idx, c->nameservers->pdata[i]);
+	for (i = 0; i < c->searches->len; i++)
+		add_string_item (rc->searches, rc->searches_idx, c->searches->pdata[i]);
+	for (i = 0; i < c->options->len; i++)
+		add_dns_option_item (rc, c->options->pdata[i], c->option_names->pdata[i]);
+	for (i = 0; i < c->nis_servers->len; i++)
+		add_string_item (rc->nis_servers, rc->nis_servers_idx, c->nis_servers->pdata[i]);
+
+	if (c->nis_domain) {
+		/* FIXME: handle multiple domains */
+		if (!rc->nis_domain)
+			rc->nis_domain = c->nis_domain;
+	}
 }
 
 static GPid
@@ -414,15 +539,40 @@ run_netconfig (NMDnsManager *self, GError **error, gint *stdin_fd)
 }
 
 static void
-write_to_netconfig (NMDnsManager *self, gint fd, const char *key, const char *value)
+append_netconfig (NMDnsManager *self, GString *str, const char *key, const char *value)
 {
-	char *str;
-	int x;
+	_LOGD ("writing to netconfig: %s='%s'", key, value);
+	g_string_append_printf (str, "%s='%s'\n", key, value);
+}
+
+/* Whether @payload for @tool is what the tool got last time. Spawning the
+ * helper is by far the most expensive part of an update, and most updates
+ * (e.g. on roaming) don't change the DNS information at all. */
+static gboolean
+dispatch_unchanged (NMDnsManager *self, const char *tool, const char *payload)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	gsize l = strlen (tool);
 
-	str = g_strdup_printf ("%s='%s'\n", key, value);
-	_LOGD ("writing to netconfig: %s", str);
-	x = write (fd, str, strlen (str));
-	g_free (str);
+	if (   !priv->last_dispatch
+	    || strncmp (priv->last_dispatch, tool, l) != 0
+	    || priv->last_dispatch[l] != '\n'
+	    || strcmp (&priv->last_dispatch[l + 1], payload) != 0)
+		return FALSE;
+
+	_LOGD ("DNS information unchanged, not running %s", tool);
+	return TRUE;
+}
+
+static void
+dispatch_done (NMDnsManager *self, const char *tool, const char *payload, SpawnResult result)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	g_free (priv->last_dispatch);
+	priv->last_dispatch =   result == SR_SUCCESS
+	                      ? g_strdup_printf ("%s\n%s", tool, payload)
+	                      : NULL;
 }
 
 static SpawnResult
@@ -433,41 +583,54 @@ dispatch_netconfig (NMDnsManager *self,
                     char **nis_servers,
                     GError **error)
 {
+	GString *payload;
 	char *str;
 	GPid pid;
 	gint fd;
 	int status;
-
-	pid = run_netconfig (self, error, &fd);
-	if (pid <= 0)
-		return SR_NOTFOUND;
+	SpawnResult result;
 
 	/* NM is writing already-merged DNS information to netconfig, so it
 	 * does not apply to a specific network interface.
 	 */
-	write_to_netconfig (self, fd, "INTERFACE", "NetworkManager");
+	payload = g_string_new (NULL);
+	append_netconfig (self, payload, "INTERFACE", "NetworkManager");
 
 	if (searches) {
 		str = g_strjoinv (" ", searches);
-		write_to_netconfig (self, fd, "DNSSEARCH", str);
+		append_netconfig (self, payload, "DNSSEARCH", str);
 		g_free (str);
 	}
 
 	if (nameservers) {
 		str = g_strjoinv (" ", nameservers);
-		write_to_netconfig (self, fd, "DNSSERVERS", str);
+		append_netconfig (self, payload, "DNSSERVERS", str);
 		g_free (str);
 	}
 
 	if (nis_domain)
-		write_to_netconfig (self, fd, "NISDOMAIN", nis_domain);
+		append_netconfig (self, payload, "NISDOMAIN", nis_domain);
 
 	if (nis_servers) {
 		str = g_strjoinv (" ", nis_servers);
-		write_to_netconfig (self, fd, "NISSERVERS", str);
+		append_netconfig (self, payload, "NISSERVERS", str);
 		g_free (str);
 	}
 
+	if (dispatch_unchanged (self, "netconfig", payload->str)) {
+		g_string_free (payload, TRUE);
+		return SR_SUCCESS;
+	}
+
+	pid = run_netconfig (self, error, &fd);
+	if (pid <= 0) {
+		dispatch_done (self, "netconfig", NULL, SR_NOTFOUND);
+		g_string_free (payload, TRUE);
+		return SR_NOTFOUND;
+	}
+
+	if (write (fd, payload->str, payload->len) != (gssize) payload->len)
+		_LOGD ("short write to netconfig");
 	close (fd);
 
 	/* Wait until the process exits */
@@ -477,16 +640,19 @@ dispatch_netconfig (NMDnsManager *self,
 		g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
 		             "Error waiting for netconfig to exit: %s",
 		             strerror (errsv));
-		return SR_ERROR;
-	}
-	if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS) {
+		result = SR_ERROR;
+	} else if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS) {
 		g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
 		             "Error calling netconfig: %s %d",
 		             WIFEXITED (status) ? "exited with status" : (WIFSIGNALED (status) ? "exited with signal" : "exited with unknown reason"),
 		             WIFEXITED (status) ? WEXITSTATUS (status) : (WIFSIGNALED (status) ? WTERMSIG (status) : status));
-		return SR_ERROR;
-	}
-	return SR_SUCCESS;
+		result = SR_ERROR;
+	} else
+		result = SR_SUCCESS;
+
+	dispatch_done (self, "netconfig", payload->str, result);
+	g_string_free (payload, TRUE);
+	return result;
 }
 
 static char *
@@ -560,19 +726,6 @@ write_resolv_conf_contents (FILE *f,
 	return TRUE;
 }
 
-static gboolean
-write_resolv_conf (FILE *f,
-                   char **searches,
-                   char **nameservers,
-                   char **options,
-                   GError **error)
-{
-	gs_free char *content = NULL;
-
-	content = create_resolv_conf (searches, nameservers, options);
-	return write_resolv_conf_contents (f, content, error);
-}
-
 static SpawnResult
 dispatch_resolvconf (NMDnsManager *self,
                      char **searches,
@@ -581,6 +734,7 @@ dispatch_resolvconf (NMDnsManager *self,
                      GError **error)
 {
 	gs_free char *cmd = NULL;
+	gs_free char *content = NULL;
 	FILE *f;
 	gboolean success = FALSE;
 	int errnosv, err;
@@ -590,19 +744,31 @@ dispatch_resolvconf (NMDnsManager *self,
 		                     NM_MANAGER_ERROR,
 		                     NM_MANAGER_ERROR_FAILED,
 		                     RESOLVCONF_PATH " is not executable");
+		dispatch_done (self, "resolvconf", NULL, SR_NOTFOUND);
 		return SR_NOTFOUND;
 	}
 
 	if (!searches && !nameservers) {
+		/* the empty payload stands for "removed" */
+		if (dispatch_unchanged (self, "resolvconf", ""))
+			return SR_SUCCESS;
+
 		_LOGI ("Removing DNS information from %s", RESOLVCONF_PATH);
 
 		cmd = g_strconcat (RESOLVCONF_PATH, " -d ", "NetworkManager", NULL);
-		if (nm_spawn_process (cmd, error) != 0)
+		if (nm_spawn_process (cmd, error) != 0) {
+			dispatch_done (self, "resolvconf", NULL, SR_ERROR);
 			return SR_ERROR;
+		}
 
+		dispatch_done (self, "resolvconf", "", SR_SUCCESS);
 		return SR_SUCCESS;
 	}
 
+	content = create_resolv_conf (searches, nameservers, options);
+	if (dispatch_unchanged (self, "resolvconf", content))
+		return SR_SUCCESS;
+
 	_LOGI ("Writing DNS information to %s", RESOLVCONF_PATH);
 
 	cmd = g_strconcat (RESOLVCONF_PATH, " -a ", "NetworkManager", NULL);
@@ -613,25 +779,27 @@ dispatch_resolvconf (NMDnsManager *self,
 		             "Could not write to %s: %s",
 		             RESOLVCONF_PATH,
 		             g_strerror (errno));
+		dispatch_done (self, "resolvconf", NULL, SR_ERROR);
 		return SR_ERROR;
 	}
 
-	success = write_resolv_conf (f, searches, nameservers, options, error);
+	success = write_resolv_conf_contents (f, content, error);
 	err = pclose (f);
 	if (err < 0) {
 		errnosv = errno;
 		g_clear_error (error);
 		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errnosv),
 		             "Failed to close pipe to resolvconf: %d", errnosv);
-		return SR_ERROR;
+		success = FALSE;
 	} else if (err > 0) {
 		_LOGW ("resolvconf failed with status %d", err);
 		g_clear_error (error);
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 		             "resolvconf failed with status %d", err);
-		return SR_ERROR;
+		success = FALSE;
 	}
 
+	dispatch_done (self, "resolvconf", content, success ? SR_SUCCESS : SR_ERROR);
 	return success ? SR_SUCCESS : SR_ERROR;
 }
 
@@ -639,6 +807,46 @@ dispatch_resolvconf (NMDnsManager *self,
 #define MY_RESOLV_CONF_TMP MY_RESOLV_CONF ".tmp"
 #define RESOLV_CONF_TMP "/etc/.resolv.conf.NetworkManager"
 
+static void
+update_private_resolv_conf_done (GError *error, gpointer user_data)
+{
+	NMDnsManager *self = user_data;
+
+	if (error) {
+		_LOGT ("update-resolv-conf: write internal file %s failed (%s)",
+		       MY_RESOLV_CONF, error->message);
+	} else
+		_LOGT ("update-resolv-conf: write internal file %s succeeded", MY_RESOLV_CONF);
+	g_object_unref (self);
+}
+
+/* Only updates MY_RESOLV_CONF, when /etc/resolv.conf is not managed by us.
+ * Nobody waits for the result, so the file is written by the executor. */
+static void
+update_private_resolv_conf (NMDnsManager *self,
+                            char **searches,
+                            char **nameservers,
+                            char **options)
+{
+	gs_free char *path = NULL;
+
+	/* If /etc/resolv.conf points to MY_RESOLV_CONF, don't write the private
+	 * DNS configuration to MY_RESOLV_CONF otherwise we would overwrite the
+	 * changes done by some external application. */
+	path = g_file_read_link (_PATH_RESCONF, NULL);
+	if (g_strcmp0 (path, MY_RESOLV_CONF) == 0) {
+		_LOGD ("update-resolv-conf: not updating " _PATH_RESCONF
+		       " since it points to " MY_RESOLV_CONF);
+		return;
+	}
+
+	nm_executor_write_file (MY_RESOLV_CONF,
+	                        create_resolv_conf (searches, nameservers, options),
+	                        -1,
+	                        update_private_resolv_conf_done,
+	                        g_object_ref (self));
+}
+
 static SpawnResult
 update_resolv_conf (NMDnsManager *self,
                     char **searches,
@@ -654,22 +862,9 @@ update_resolv_conf (NMDnsManager *self,
 	SpawnResult write_file_result = SR_SUCCESS;
 	int errsv;
 
-	/* If we are not managing /etc/resolv.conf and it points to
-	 * MY_RESOLV_CONF, don't write the private DNS configuration to
-	 * MY_RESOLV_CONF otherwise we would overwrite the changes done by
-	 * some external application.
-	 *
-	 * This is the only situation, where we don't try to update our
-	 * internal resolv.conf file. */
-	if (rc_manager == NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED) {
-		gs_free char *path = g_file_read_link (_PATH_RESCONF, NULL);
-
-		if (g_strcmp0 (path, MY_RESOLV_CONF) == 0) {
-			_LOGD ("update-resolv-conf: not updating " _PATH_RESCONF
-			       " since it points to " MY_RESOLV_CONF);
-			return SR_SUCCESS;
-		}
-	}
+	/* unmanaged resolv.conf is handled by update_private_resolv_conf() */
+	nm_assert (NM_IN_SET (rc_manager, NM_DNS_MANAGER_RESOLV_CONF_MAN_SYMLINK,
+	                                  NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE));
 
 	content = create_resolv_conf (searches, nameservers, options);
 
@@ -853,32 +1048,39 @@ update_resolv_conf (NMDnsManager *self,
 	return SR_SUCCESS;
 }
 
-static void
-compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer[HASH_LEN])
+static guint64
+compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global)
 {
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
-	GChecksum *sum;
-	gsize len = HASH_LEN;
+	guint64 h = NM_UTILS_DIGEST_INIT;
 	guint i;
 
-	sum = g_checksum_new (G_CHECKSUM_SHA1);
-	g_assert (len == g_checksum_type_get_length (G_CHECKSUM_SHA1));
+	if (global) {
+		GChecksum *sum;
+		guint8 buffer[HASH_LEN];
+		gsize len = HASH_LEN;
 
-	if (global)
+		/* the global configuration has no cached digest and rarely changes. */
+		sum = g_checksum_new (G_CHECKSUM_SHA1);
+		g_assert (len == g_checksum_type_get_length (G_CHECKSUM_SHA1));
 		nm_global_dns_config_update_checksum (global, sum);
-	else {
-		for (i = 0; i < priv->configs->len; i++) {
-			NMDnsIPConfigData *data = priv->configs->pdata[i];
+		g_checksum_get_digest (sum, buffer, &len);
+		g_checksum_free (sum);
+		return nm_utils_digest_mem (h, buffer, len);
+	}
 
-			if (NM_IS_IP4_CONFIG (data->config))
-				nm_ip4_config_hash ((NMIP4Config *) data->config, sum, TRUE);
-			else if (NM_IS_IP6_CONFIG (data->config))
-				nm_ip6_config_hash ((NMIP6Config *) data->config, sum, TRUE);
+	for (i = 0; i < priv->configs->len; i++) {
+		NMDnsIPConfigData *data = priv->configs->pdata[i];
+
+		if (NM_IS_IP4_CONFIG (data->config)) {
+			h = nm_utils_digest_u32 (h, AF_INET);
+			h = nm_utils_digest_u64 (h, nm_ip4_config_get_digest ((NMIP4Config *) data->config, TRUE));
+		} else if (NM_IS_IP6_CONFIG (data->config)) {
+			h = nm_utils_digest_u32 (h, AF_INET6);
+			h = nm_utils_digest_u64 (h, nm_ip6_config_get_digest ((NMIP6Config *) data->config, TRUE));
 		}
 	}
-
-	g_checksum_get_digest (sum, buffer, &len);
-	g_checksum_free (sum);
+	return h;
 }
 
 static gboolean
@@ -898,25 +1100,26 @@ merge_global_dns_config (NMResolvConfData *rc, NMGlobalDnsConfig *global_conf)
 
 	for (i = 0; searches && searches[i]; i++) {
 		if (DOMAIN_IS_VALID (searches[i]))
-			add_string_item (rc->searches, searches[i]);
+			add_string_item (rc->searches, rc->searches_idx, searches[i]);
 	}
 
+	/* unlike the options of IP configs, these are matched as a whole */
 	for (i = 0; options && options[i]; i++)
-		add_string_item (rc->options, options[i]);
+		add_string_item (rc->options, rc->options_idx, options[i]);
 
 	default_domain = nm_global_dns_config_lookup_domain (global_conf, "*");
 	g_assert (default_domain);
 	servers = nm_global_dns_domain_get_servers (default_domain);
 	for (i = 0; servers && servers[i]; i++)
-		add_string_item (rc->nameservers, servers[i]);
+		add_string_item (rc->nameservers, rc->nameservers_idx, servers[i]);
 
 	return TRUE;
 }
 
 static gboolean
-update_dns (NMDnsManager *self,
-            gboolean no_caching,
-            GError **error)
+_update_dns (NMDnsManager *self,
+             gboolean no_caching,
+             GError **error)
 {
 	NMDnsManagerPrivate *priv;
 	NMResolvConfData rc;
@@ -938,6 +1141,11 @@ update_dns (NMDnsManager *self,
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	nm_clear_g_source (&priv->plugin_ratelimit.timer);
 
+	/* this update also covers the deferred one */
+	nm_clear_g_source (&priv->deferred.timeout_id);
+	priv->deferred.triggers = 0;
+	priv->deferred.first_ts = 0;
+
 	if (NM_IN_SET (priv->rc_manager, NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED,
 	                                 NM_DNS_MANAGER_RESOLV_CONF_MAN_IMMUTABLE)) {
 		update = FALSE;
@@ -956,13 +1164,9 @@ update_dns (NMDnsManager *self,
 	}
 
 	/* Update hash with config we're applying */
-	compute_hash (self, global_config, priv->hash);
+	priv->hash = compute_hash (self, global_config);
 
-	rc.nameservers = g_ptr_array_new ();
-	rc.searches = g_ptr_array_new ();
-	rc.options = g_ptr_array_new ();
-	rc.nis_domain = NULL;
-	rc.nis_servers = g_ptr_array_new ();
+	resolv_conf_data_init (&rc);
 
 	if (global_config)
 		merge_global_dns_config (&rc, global_config);
@@ -1017,12 +1221,17 @@ update_dns (NMDnsManager *self,
 		    && !nm_utils_ipaddr_valid (AF_UNSPEC, priv->hostname)) {
 			hostdomain++;
 			if (DOMAIN_IS_VALID (hostdomain))
-				add_string_item (rc.searches, hostdomain);
+				add_string_item (rc.searches, rc.searches_idx, hostdomain);
 			else if (DOMAIN_IS_VALID (priv->hostname))
-				add_string_item (rc.searches, priv->hostname);
+				add_string_item (rc.searches, rc.searches_idx, priv->hostname);
 		}
 	}
 
+	g_hash_table_destroy (rc.nameservers_idx);
+	g_hash_table_destroy (rc.searches_idx);
+	g_hash_table_destroy (rc.options_idx);
+	g_hash_table_destroy (rc.nis_servers_idx);
+
 	/* Per 'man resolv.conf', the search list is limited to 6 domains
 	 * totalling 256 characters.
 	 */
@@ -1130,7 +1339,7 @@ update_dns (NMDnsManager *self,
 	/* Unless we've already done it, update private resolv.conf in NMRUNDIR
 	   ignoring any errors */
 	if (!resolv_conf_updated)
-		update_resolv_conf (self, searches, nameservers, options, NULL, NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED);
+		update_private_resolv_conf (self, searches, nameservers, options);
 
 	/* signal that resolv.conf was changed */
 	if (update && result == SR_SUCCESS)
@@ -1148,6 +1357,118 @@ update_dns (NMDnsManager *self,
 	return !update || result == SR_SUCCESS;
 }
 
+static gboolean
+update_dns (NMDnsManager *self,
+            gboolean no_caching,
+            GError **error)
+{
+	gint64 start = g_get_monotonic_time ();
+	gboolean success;
+
+	success = _update_dns (self, no_caching, error);
+	nm_statistics_record (NM_STATISTICS_HISTOGRAM_DNS_UPDATE,
+	                      g_get_monotonic_time () - start);
+	return success;
+}
+
+#define DNS_UPDATE_MAX_LATENCY_DEFAULT 20
+
+static guint
+update_dns_get_max_latency (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	const char *value;
+
+	value = nm_config_data_get_value_cached (nm_config_get_data (priv->config),
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_DNS_UPDATE_MAX_LATENCY,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	return _nm_utils_ascii_str_to_int64 (value, 10, 0, 10000,
+	                                     DNS_UPDATE_MAX_LATENCY_DEFAULT);
+}
+
+static void
+update_dns_flush (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	GError *error = NULL;
+
+	if (priv->deferred.triggers > 1)
+		_LOGD ("update-dns: committing %u merged changes", priv->deferred.triggers);
+
+	if (!update_dns (self, FALSE, &error)) {
+		_LOGW ("could not commit DNS changes: %s", error->message);
+		g_clear_error (&error);
+	}
+}
+
+static gboolean
+update_dns_timeout_cb (gpointer user_data)
+{
+	NMDnsManager *self = user_data;
+
+	NM_DNS_MANAGER_GET_PRIVATE (self)->deferred.timeout_id = 0;
+	update_dns_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * _nm_dns_manager_update_delay:
+ * @first_ts: when the first uncommitted change was made, in milliseconds
+ * @now: the current time, in milliseconds
+ * @max_latency: main.dns-update-max-latency
+ *
+ * Returns: how many milliseconds to wait before committing, 0 for right
+ *   away. The window counts from @first_ts, so time a caller spent in a
+ *   batch it opened before the change (see nm_dns_manager_begin_updates())
+ *   is not waited for a second time.
+ */
+gint64
+_nm_dns_manager_update_delay (gint64 first_ts, gint64 now, guint max_latency)
+{
+	gint64 delay;
+
+	if (!max_latency)
+		return 0;
+	delay = first_ts + max_latency - now;
+	return CLAMP (delay, 0, (gint64) max_latency);
+}
+
+/*
+ * update_dns_schedule:
+ * @self: the #NMDnsManager
+ *
+ * Commits the DNS configuration at most main.dns-update-max-latency
+ * milliseconds after the window opened: when the first batch since the
+ * last commit began (see nm_dns_manager_begin_updates()), or with the first
+ * change if it was made outside of a batch. Batches that end without
+ * a change close the window again. Changes within the window, even from
+ * separate batches, result in a single update_dns(). Later changes don't
+ * restart the timeout.
+ */
+static void
+update_dns_schedule (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	gint64 now, delay;
+
+	priv->deferred.triggers++;
+
+	if (priv->deferred.timeout_id)
+		return;
+
+	now = nm_utils_get_monotonic_timestamp_ms ();
+	if (!priv->deferred.first_ts)
+		priv->deferred.first_ts = now;
+
+	delay = _nm_dns_manager_update_delay (priv->deferred.first_ts, now,
+	                                      update_dns_get_max_latency (self));
+	if (!delay)
+		update_dns_flush (self);
+	else
+		priv->deferred.timeout_id = g_timeout_add (delay, update_dns_timeout_cb, self);
+}
+
 static void
 plugin_failed (NMDnsPlugin *plugin, gpointer user_data)
 {
@@ -1236,7 +1557,6 @@ nm_dns_manager_add_ip_config (NMDnsManager *self,
                               NMDnsIPConfigType cfg_type)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 	NMDnsIPConfigData *data;
 	gboolean v4 = NM_IS_IP4_CONFIG (config);
 	guint i;
@@ -1283,10 +1603,8 @@ nm_dns_manager_add_ip_config (NMDnsManager *self,
 		}
 	}
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		update_dns_schedule (self);
 
 	return TRUE;
 }
@@ -1313,7 +1631,6 @@ static gboolean
 nm_dns_manager_remove_ip_config (NMDnsManager *self, gpointer config)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 	NMDnsIPConfigData *data;
 	guint i;
 
@@ -1329,10 +1646,8 @@ nm_dns_manager_remove_ip_config (NMDnsManager *self, gpointer config)
 			forget_data (self, data);
 			g_ptr_array_remove_index (priv->configs, i);
 
-			if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-				_LOGW ("could not commit DNS changes: %s", error->message);
-				g_clear_error (&error);
-			}
+			if (!priv->updates_queue)
+				update_dns_schedule (self);
 
 			return TRUE;
 		}
@@ -1366,7 +1681,6 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
                              const char *hostname)
 {
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
-	GError *error = NULL;
 	const char *filtered = NULL;
 
 	/* Certain hostnames we don't want to include in resolv.conf 'searches' */
@@ -1384,10 +1698,8 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
 	g_free (priv->hostname);
 	priv->hostname = g_strdup (filtered);
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		update_dns_schedule (self);
 }
 
 gboolean
@@ -1416,8 +1728,14 @@ nm_dns_manager_begin_updates (NMDnsManager *self, const char *func)
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
 	/* Save current hash when starting a new batch */
-	if (priv->updates_queue == 0)
-		memcpy (priv->prev_hash, priv->hash, sizeof (priv->hash));
+	if (priv->updates_queue == 0) {
+		priv->prev_hash = priv->hash;
+		/* The batch's changes count as made now; whoever keeps it
+		 * open already delayed them (like NMPolicy does for
+		 * main.routing-dns-max-latency). */
+		if (!priv->deferred.first_ts)
+			priv->deferred.first_ts = nm_utils_get_monotonic_timestamp_ms ();
+	}
 
 	priv->updates_queue++;
 
@@ -1428,9 +1746,8 @@ void
 nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 	gboolean changed;
-	guint8 new[HASH_LEN];
+	guint64 new;
 
 	g_return_if_fail (self != NULL);
 
@@ -1442,24 +1759,23 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 		priv->need_sort = FALSE;
 	}
 
-	compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)), new);
-	changed = (memcmp (new, priv->prev_hash, sizeof (new)) != 0) ? TRUE : FALSE;
+	new = compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)));
+	changed = (new != priv->prev_hash);
 	_LOGD ("(%s): DNS configuration %s", func, changed ? "changed" : "did not change");
 
 	priv->updates_queue--;
 	if ((priv->updates_queue > 0) || (changed == FALSE)) {
 		_LOGD ("(%s): no DNS changes to commit (%d)", func, priv->updates_queue);
+		if (priv->updates_queue == 0 && !priv->deferred.timeout_id)
+			priv->deferred.first_ts = 0;
 		return;
 	}
 
 	/* Commit all the outstanding changes */
 	_LOGD ("(%s): committing DNS changes (%d)", func, priv->updates_queue);
-	if (!update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	update_dns_schedule (self);
 
-	memset (priv->prev_hash, 0, sizeof (priv->prev_hash));
+	priv->prev_hash = 0;
 }
 
 /******************************************************************/
@@ -1552,6 +1868,12 @@ again:
 			priv->plugin = nm_dns_unbound_new ();
 			plugin_changed = TRUE;
 		}
+	} else if (nm_streq0 (mode, "stub")) {
+		if (!NM_IS_DNS_STUB (priv->plugin)) {
+			_clear_plugin (self);
+			priv->plugin = nm_dns_stub_new ();
+			plugin_changed = TRUE;
+		}
 	} else {
 		if (!NM_IN_STRSET (mode, NULL, "none", "default")) {
 			_LOGW ("init: unknown dns mode '%s'", mode);
@@ -1592,6 +1914,10 @@ config_changed_cb (NMConfig *config,
 		 * is immutable, thus, without the configuration changing, we always want to
 		 * re-configure the mode. */
 		init_resolv_conf_mode (self);
+
+		/* SIGHUP also hands the DNS information to netconfig or resolvconf
+		 * again, in case they lost it. */
+		g_clear_pointer (&NM_DNS_MANAGER_GET_PRIVATE (self)->last_dispatch, g_free);
 	}
 
 	if (NM_FLAGS_ANY (changes, NM_CONFIG_CHANGE_SIGHUP |
@@ -1619,7 +1945,7 @@ nm_dns_manager_init (NMDnsManager *self)
 	priv->configs = g_ptr_array_new_full (8, ip_config_data_destroy);
 
 	/* Set the initial hash */
-	compute_hash (self, NULL, NM_DNS_MANAGER_GET_PRIVATE (self)->hash);
+	NM_DNS_MANAGER_GET_PRIVATE (self)->hash = compute_hash (self, NULL);
 
 	g_signal_connect (G_OBJECT (priv->config),
 	                  NM_CONFIG_SIGNAL_CONFIG_CHANGED,
@@ -1635,10 +1961,14 @@ dispose (GObject *object)
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	NMDnsIPConfigData *data;
 	GError *error = NULL;
+	gboolean pending = FALSE;
 	guint i;
 
 	_LOGT ("disposing");
 
+	if (nm_clear_g_source (&priv->deferred.timeout_id))
+		pending = TRUE;
+
 	_clear_plugin (self);
 
 	/* If we're quitting, leave a valid resolv.conf in place, not one
@@ -1646,7 +1976,7 @@ dispose (GObject *object)
 	 * DNS after disposing of all plugins.  But if we haven't done any
 	 * DNS updates yet, there's no reason to touch resolv.conf on shutdown.
 	 */
-	if (priv->dns_touched && !update_dns (self, TRUE, &error)) {
+	if ((priv->dns_touched || pending) && !update_dns (self, TRUE, &error)) {
 		_LOGW ("could not commit DNS changes on shutdown: %s", error->message);
 		g_clear_error (&error);
 		priv->dns_touched = FALSE;
@@ -1676,6 +2006,7 @@ finalize (GObject *object)
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
 	g_free (priv->hostname);
+	g_free (priv->last_dispatch);
 
 	G_OBJECT_CLASS (nm_dns_manager_parent_class)->finalize (object);
 }
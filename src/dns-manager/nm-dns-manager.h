@@ -45,6 +45,8 @@ typedef struct {
 	gpointer config;
 	NMDnsIPConfigType type;
 	char *iface;
+	/* private to NMDnsManager: the cached resolv.conf entries of @config */
+	gpointer contribution;
 } NMDnsIPConfigData;
 
 #define NM_TYPE_DNS_MANAGER (nm_dns_manager_get_type ())
@@ -129,6 +131,9 @@ typedef enum {
 
 gboolean nm_dns_manager_get_resolv_conf_explicit (NMDnsManager *self);
 
+/* exposed for the unit tests */
+gint64 _nm_dns_manager_update_delay (gint64 first_ts, gint64 now, guint max_latency);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_DNS_MANAGER_H__ */
@@ -56,7 +56,7 @@ static guint signals[LAST_SIGNAL] = { 0 };
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             char __prefix[20]; \
             const NMDnsPlugin *const __self = (self); \
             \
@@ -0,0 +1,1745 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* A small caching DNS forwarder running inside NetworkManager. It listens
+ * on 127.0.0.1 port 53 (UDP and TCP) and forwards each query to the
+ * nameservers of the connection that serves the longest matching domain,
+ * using the same "split DNS" rules as the dnsmasq plugin. Answers are
+ * cached for their TTL, until the nameservers change. Truncated upstream
+ * answers are refetched over TCP.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "nm-dns-stub.h"
+#include "nm-utils.h"
+#include "nm-ip4-config.h"
+#include "nm-ip6-config.h"
+#include "nm-dns-utils.h"
+#include "nm-platform.h"
+#include "NetworkManagerUtils.h"
+
+G_DEFINE_TYPE (NMDnsStub, nm_dns_stub, NM_TYPE_DNS_PLUGIN)
+
+#define NM_DNS_STUB_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DNS_STUB, NMDnsStubPrivate))
+
+#define DNS_PORT                  53
+
+#define DNS_HEADER_SIZE           12
+#define DNS_MAX_SIZE              65535
+#define DNS_UDP_DEFAULT_SIZE      512
+
+#define DNS_FLAG_QR               0x8000
+#define DNS_FLAG_TC               0x0200
+#define DNS_FLAG_RD               0x0100
+#define DNS_FLAG_RA               0x0080
+#define DNS_OPCODE_MASK           0x7800
+#define DNS_RCODE_MASK            0x000F
+
+#define DNS_RCODE_NOERROR         0
+#define DNS_RCODE_FORMERR         1
+#define DNS_RCODE_SERVFAIL        2
+#define DNS_RCODE_NXDOMAIN        3
+
+#define DNS_TYPE_SOA              6
+#define DNS_TYPE_OPT              41
+#define DNS_EDNS_FLAG_DO          0x8000
+
+/* how long to wait for an answer before trying the next server */
+#define UPSTREAM_UDP_TIMEOUT_MSEC 2000
+#define UPSTREAM_TCP_TIMEOUT_MSEC 5000
+
+#define CACHE_MAX_ENTRIES         1024
+#define CACHE_MAX_TTL             (24 * 3600)
+#define CACHE_NEGATIVE_MAX_TTL    300
+
+#define TCP_MAX_CLIENTS           64
+
+typedef struct {
+	GInetSocketAddress *address;
+
+	/* lower case, without trailing dot; NULL for the default servers */
+	char *domain;
+} StubServer;
+
+typedef struct {
+	guint8 *data;
+	gsize len;
+	gint32 stored;
+	gint32 expires;
+} CacheEntry;
+
+typedef struct {
+	int ref_count;
+
+	/* NULL once the connection is closed */
+	NMDnsStub *self;
+
+	GSocketConnection *connection;
+	GCancellable *cancellable;
+
+	/* responses (GBytes) waiting to be written */
+	GQueue writes;
+	gboolean writing;
+} StubTcpClient;
+
+typedef struct {
+	NMDnsStub *self;
+
+	/* where to send the answer: either a UDP client or a TCP connection */
+	GSocketAddress *client;
+	StubTcpClient *tcp_client;
+	gsize max_udp_size;
+
+	/* the query as sent upstream, with our own ID */
+	guint8 *msg;
+	gsize len;
+	gsize question_end;
+	guint16 client_id;
+	guint16 upstream_id;
+
+	char *cache_key;
+
+	/* candidate servers (GInetSocketAddress) and the one in use */
+	GPtrArray *servers;
+	guint server_idx;
+
+	/* a socket of its own for each query, so that each one is sent
+	 * from another source port (RFC 5452, 4.5) */
+	GSocket *socket;
+	GSource *socket_source;
+
+	guint timeout_id;
+	gint64 start_usec;
+
+	/* set while the query is being retried over TCP */
+	GCancellable *tcp_cancellable;
+	GSocketConnection *tcp_connection;
+} StubQuery;
+
+typedef struct {
+	GSocket *listen_udp;
+	GSource *listen_udp_source;
+	GSocketService *listen_tcp;
+	GSList *tcp_clients;
+
+	/* StubServer, in priority order */
+	GPtrArray *servers;
+
+	/* upstream ID -> StubQuery */
+	GHashTable *queries;
+
+	/* cache key -> CacheEntry */
+	GHashTable *cache;
+
+	guint8 *buf;
+
+	NMDnsStubStats stats;
+} NMDnsStubPrivate;
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN         LOGD_DNS
+#define _NMLOG_PREFIX_NAME    "dns-stub"
+#define _NMLOG(level, ...) \
+    G_STMT_START { \
+        nm_log ((level), _NMLOG_DOMAIN, \
+                "%s[%p]: " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), \
+                _NMLOG_PREFIX_NAME, \
+                (self) \
+                _NM_UTILS_MACRO_REST(__VA_ARGS__)); \
+    } G_STMT_END
+
+/*****************************************************************************/
+
+static guint16
+_get_u16 (const guint8 *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static void
+_set_u16 (guint8 *p, guint16 v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xFF;
+}
+
+static guint32
+_get_u32 (const guint8 *p)
+{
+	return ((guint32) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void
+_set_u32 (guint8 *p, guint32 v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xFF;
+	p[2] = (v >> 8) & 0xFF;
+	p[3] = v & 0xFF;
+}
+
+/* Returns the offset following the (possibly compressed) name at @pos,
+ * or 0 if it is malformed. If @out is given, the name is appended to it in
+ * lower case with each label followed by a dot. */
+static gsize
+_msg_read_name (const guint8 *msg, gsize len, gsize pos, GString *out)
+{
+	gsize end = 0;
+	guint jumps = 0;
+
+	for (;;) {
+		guint8 l;
+		guint i;
+
+		if (pos >= len)
+			return 0;
+		l = msg[pos];
+
+		if ((l & 0xC0) == 0xC0) {
+			if (pos + 1 >= len || ++jumps > 16)
+				return 0;
+			if (!end)
+				end = pos + 2;
+			pos = ((l & 0x3F) << 8) | msg[pos + 1];
+			continue;
+		}
+		if (l & 0xC0)
+			return 0;
+		if (l == 0)
+			return end ? end : pos + 1;
+		if (pos + 1 + l > len)
+			return 0;
+
+		if (out) {
+			for (i = 0; i < l; i++)
+				g_string_append_c (out, g_ascii_tolower (msg[pos + 1 + i]));
+			g_string_append_c (out, '.');
+		}
+		pos += 1 + l;
+	}
+}
+
+/* Returns the offset following the single question of @msg, or 0. */
+static gsize
+_msg_question_end (const guint8 *msg, gsize len)
+{
+	gsize pos;
+
+	if (len < DNS_HEADER_SIZE || _get_u16 (&msg[4]) != 1)
+		return 0;
+	pos = _msg_read_name (msg, len, DNS_HEADER_SIZE, NULL);
+	if (!pos || pos + 4 > len)
+		return 0;
+	return pos + 4;
+}
+
+typedef struct {
+	/* lower case, without the trailing dot */
+	char *name;
+	guint16 qtype;
+	guint16 qclass;
+	gsize question_end;
+	gsize max_udp_size;
+	gboolean dnssec_ok;
+} DnsQuestion;
+
+static gboolean
+_msg_parse_query (const guint8 *msg, gsize len, DnsQuestion *q)
+{
+	GString *name;
+	gsize pos;
+	guint i, n;
+
+	if (len < DNS_HEADER_SIZE || (_get_u16 (&msg[2]) & DNS_FLAG_QR))
+		return FALSE;
+	if (_get_u16 (&msg[4]) != 1)
+		return FALSE;
+
+	name = g_string_new (NULL);
+	pos = _msg_read_name (msg, len, DNS_HEADER_SIZE, name);
+	if (!pos || pos + 4 > len) {
+		g_string_free (name, TRUE);
+		return FALSE;
+	}
+	if (name->len)
+		g_string_truncate (name, name->len - 1);
+
+	q->name = g_string_free (name, FALSE);
+	q->qtype = _get_u16 (&msg[pos]);
+	q->qclass = _get_u16 (&msg[pos + 2]);
+	q->question_end = pos + 4;
+	q->max_udp_size = DNS_UDP_DEFAULT_SIZE;
+	q->dnssec_ok = FALSE;
+
+	/* The EDNS OPT record tells how large an UDP answer may be */
+	pos = q->question_end;
+	n = _get_u16 (&msg[6]) + _get_u16 (&msg[8]) + _get_u16 (&msg[10]);
+	for (i = 0; i < n; i++) {
+		pos = _msg_read_name (msg, len, pos, NULL);
+		if (!pos || pos + 10 > len)
+			break;
+		if (_get_u16 (&msg[pos]) == DNS_TYPE_OPT) {
+			q->max_udp_size = MAX (_get_u16 (&msg[pos + 2]), DNS_UDP_DEFAULT_SIZE);
+			q->dnssec_ok = NM_FLAGS_HAS (_get_u16 (&msg[pos + 6]), DNS_EDNS_FLAG_DO);
+		}
+		pos += 10 + _get_u16 (&msg[pos + 8]);
+	}
+
+	return TRUE;
+}
+
+static guint32
+_ttl_sanitize (guint32 ttl)
+{
+	/* RFC 2181, 8: values with the most significant bit set mean zero */
+	return (ttl & 0x80000000) ? 0 : ttl;
+}
+
+/* Walks the resource records of the answer @msg. Returns in @out_min_ttl
+ * the lowest TTL found (G_MAXUINT32 if there are no records) and, if @age
+ * is not zero, reduces all TTLs by @age seconds. @out_soa_ttl is set to
+ * the lower of the TTL and the MINIMUM field of the first SOA record in
+ * the authority section, or G_MAXUINT32 if there is none. */
+static gboolean
+_msg_process_ttls (guint8 *msg, gsize len, guint32 age, guint32 *out_min_ttl, guint32 *out_soa_ttl)
+{
+	guint32 min_ttl = G_MAXUINT32;
+	guint32 soa_ttl = G_MAXUINT32;
+	gsize pos, rdlen;
+	guint i, n, n_answers, n_authority;
+
+	pos = _msg_question_end (msg, len);
+	if (!pos)
+		return FALSE;
+
+	n_answers = _get_u16 (&msg[6]);
+	n_authority = _get_u16 (&msg[8]);
+	n = n_answers + n_authority + _get_u16 (&msg[10]);
+	for (i = 0; i < n; i++) {
+		guint16 type;
+
+		pos = _msg_read_name (msg, len, pos, NULL);
+		if (!pos || pos + 10 > len)
+			return FALSE;
+
+		type = _get_u16 (&msg[pos]);
+		rdlen = _get_u16 (&msg[pos + 8]);
+		if (pos + 10 + rdlen > len)
+			return FALSE;
+
+		if (type != DNS_TYPE_OPT) {
+			guint32 ttl = _ttl_sanitize (_get_u32 (&msg[pos + 4]));
+
+			if (age)
+				_set_u32 (&msg[pos + 4], ttl > age ? ttl - age : 0);
+			min_ttl = MIN (min_ttl, ttl);
+
+			/* the MINIMUM field is the last of the SOA's RDATA, after two
+			 * names and four other 32 bit fields */
+			if (   type == DNS_TYPE_SOA
+			    && i >= n_answers
+			    && i < n_answers + n_authority
+			    && soa_ttl == G_MAXUINT32
+			    && rdlen >= 22)
+				soa_ttl = MIN (ttl, _ttl_sanitize (_get_u32 (&msg[pos + 10 + rdlen - 4])));
+		}
+
+		pos += 10 + rdlen;
+	}
+
+	if (out_min_ttl)
+		*out_min_ttl = min_ttl;
+	if (out_soa_ttl)
+		*out_soa_ttl = soa_ttl;
+	return TRUE;
+}
+
+/* Returns for how many seconds the answer @msg can be cached, or 0. */
+static guint32
+_msg_cache_ttl (const guint8 *msg, gsize len)
+{
+	guint16 flags = _get_u16 (&msg[2]);
+	guint32 ttl, soa_ttl;
+	gboolean negative;
+
+	if (NM_FLAGS_HAS (flags, DNS_FLAG_TC))
+		return 0;
+
+	switch (flags & DNS_RCODE_MASK) {
+	case DNS_RCODE_NOERROR:
+		negative = _get_u16 (&msg[6]) == 0;
+		break;
+	case DNS_RCODE_NXDOMAIN:
+		negative = TRUE;
+		break;
+	default:
+		return 0;
+	}
+
+	if (!_msg_process_ttls ((guint8 *) msg, len, 0, &ttl, &soa_ttl))
+		return 0;
+
+	if (negative) {
+		/* RFC 2308, 5: a negative answer is cached for the lower of the
+		 * TTL and the MINIMUM field of its SOA record. Without SOA record
+		 * it must not be cached. */
+		if (soa_ttl == G_MAXUINT32)
+			return 0;
+		return MIN (soa_ttl, CACHE_NEGATIVE_MAX_TTL);
+	}
+
+	if (ttl == G_MAXUINT32)
+		return 0;
+	return MIN (ttl, CACHE_MAX_TTL);
+}
+
+guint32
+_nm_dns_stub_msg_cache_ttl (const guint8 *msg, gsize len)
+{
+	g_return_val_if_fail (msg && len >= DNS_HEADER_SIZE, 0);
+
+	return _msg_cache_ttl (msg, len);
+}
+
+/* Builds an empty answer for the query @msg with @rcode, optionally keeping
+ * the question (@question_end not zero). */
+static guint8 *
+_msg_new_error (const guint8 *msg, gsize question_end, guint rcode, gsize *out_len)
+{
+	guint8 *answer;
+	gsize len = question_end ?: DNS_HEADER_SIZE;
+	guint16 flags = _get_u16 (&msg[2]);
+
+	answer = g_memdup (msg, len);
+	_set_u16 (&answer[2], DNS_FLAG_QR | DNS_FLAG_RA | (flags & (DNS_OPCODE_MASK | DNS_FLAG_RD)) | rcode);
+	_set_u16 (&answer[4], question_end ? 1 : 0);
+	_set_u16 (&answer[6], 0);
+	_set_u16 (&answer[8], 0);
+	_set_u16 (&answer[10], 0);
+
+	*out_len = len;
+	return answer;
+}
+
+/*****************************************************************************/
+
+static gboolean
+_address_equal (GInetSocketAddress *a, GInetSocketAddress *b)
+{
+	return    g_inet_socket_address_get_port (a) == g_inet_socket_address_get_port (b)
+	       && g_inet_socket_address_get_scope_id (a) == g_inet_socket_address_get_scope_id (b)
+	       && g_inet_address_equal (g_inet_socket_address_get_address (a),
+	                                g_inet_socket_address_get_address (b));
+}
+
+static char *
+_address_to_string (GInetSocketAddress *address)
+{
+	return g_inet_address_to_string (g_inet_socket_address_get_address (address));
+}
+
+static void
+_server_free (gpointer data)
+{
+	StubServer *server = data;
+
+	g_object_unref (server->address);
+	g_free (server->domain);
+	g_slice_free (StubServer, server);
+}
+
+static gboolean
+_server_equal (const StubServer *a, const StubServer *b)
+{
+	return    nm_streq0 (a->domain, b->domain)
+	       && _address_equal (a->address, b->address);
+}
+
+static void
+add_server (NMDnsStub *self,
+            GPtrArray *servers,
+            GInetAddress *address,
+            const char *iface,
+            const char *domain)
+{
+	StubServer *server;
+	guint scope_id = 0;
+	gs_free char *str = NULL;
+
+	if (   iface
+	    && g_inet_address_get_family (address) == G_SOCKET_FAMILY_IPV6
+	    && g_inet_address_get_is_link_local (address))
+		scope_id = MAX (nm_platform_link_get_ifindex (NM_PLATFORM_GET, iface), 0);
+
+	server = g_slice_new0 (StubServer);
+	server->address = g_object_new (G_TYPE_INET_SOCKET_ADDRESS,
+	                                "address", address,
+	                                "port", DNS_PORT,
+	                                "scope-id", scope_id,
+	                                NULL);
+	if (domain) {
+		server->domain = g_ascii_strdown (domain, -1);
+		g_strstrip (server->domain);
+		while (g_str_has_suffix (server->domain, "."))
+			server->domain[strlen (server->domain) - 1] = '\0';
+		if (!server->domain[0])
+			g_clear_pointer (&server->domain, g_free);
+	}
+
+	str = g_inet_address_to_string (address);
+	_LOGD ("adding nameserver '%s'%s%s%s%s%s%s", str,
+	       NM_PRINT_FMT_QUOTED (iface, "@", iface, "", ""),
+	       NM_PRINT_FMT_QUOTED (server->domain, " for domain \"", server->domain, "\"", ""));
+
+	g_ptr_array_add (servers, server);
+}
+
+static void
+add_ip4_config (NMDnsStub *self, GPtrArray *servers, NMIP4Config *ip4,
+                const char *iface, gboolean split)
+{
+	int nnameservers, i_nameserver, n, i;
+	gboolean added = FALSE;
+
+	nnameservers = nm_ip4_config_get_num_nameservers (ip4);
+
+	for (i_nameserver = 0; split && i_nameserver < nnameservers; i_nameserver++) {
+		in_addr_t addr = nm_ip4_config_get_nameserver (ip4, i_nameserver);
+		gs_unref_object GInetAddress *address = NULL;
+		char **domains, **iter;
+
+		address = g_inet_address_new_from_bytes ((guint8 *) &addr, G_SOCKET_FAMILY_IPV4);
+
+		/* searches are preferred over domains */
+		n = nm_ip4_config_get_num_searches (ip4);
+		for (i = 0; i < n; i++) {
+			add_server (self, servers, address, iface, nm_ip4_config_get_search (ip4, i));
+			added = TRUE;
+		}
+		if (n == 0) {
+			n = nm_ip4_config_get_num_domains (ip4);
+			for (i = 0; i < n; i++) {
+				add_server (self, servers, address, iface, nm_ip4_config_get_domain (ip4, i));
+				added = TRUE;
+			}
+		}
+
+		/* the split domain's nameserver also answers its reverse lookups */
+		domains = nm_dns_utils_get_ip4_rdns_domains (ip4);
+		if (domains) {
+			for (iter = domains; *iter; iter++)
+				add_server (self, servers, address, iface, *iter);
+			g_strfreev (domains);
+		}
+	}
+
+	if (!added) {
+		for (i = 0; i < nnameservers; i++) {
+			in_addr_t addr = nm_ip4_config_get_nameserver (ip4, i);
+			gs_unref_object GInetAddress *address = NULL;
+
+			address = g_inet_address_new_from_bytes ((guint8 *) &addr, G_SOCKET_FAMILY_IPV4);
+			add_server (self, servers, address, iface, NULL);
+		}
+	}
+}
+
+static GInetAddress *
+ip6_addr_to_inet_address (const struct in6_addr *addr)
+{
+	if (IN6_IS_ADDR_V4MAPPED (addr))
+		return g_inet_address_new_from_bytes ((guint8 *) &addr->s6_addr32[3], G_SOCKET_FAMILY_IPV4);
+	return g_inet_address_new_from_bytes ((guint8 *) addr, G_SOCKET_FAMILY_IPV6);
+}
+
+static void
+add_ip6_config (NMDnsStub *self, GPtrArray *servers, NMIP6Config *ip6,
+                const char *iface, gboolean split)
+{
+	int nnameservers, i_nameserver, n, i;
+	gboolean added = FALSE;
+
+	nnameservers = nm_ip6_config_get_num_nameservers (ip6);
+
+	for (i_nameserver = 0; split && i_nameserver < nnameservers; i_nameserver++) {
+		gs_unref_object GInetAddress *address = NULL;
+
+		address = ip6_addr_to_inet_address (nm_ip6_config_get_nameserver (ip6, i_nameserver));
+
+		/* searches are preferred over domains */
+		n = nm_ip6_config_get_num_searches (ip6);
+		for (i = 0; i < n; i++) {
+			add_server (self, servers, address, iface, nm_ip6_config_get_search (ip6, i));
+			added = TRUE;
+		}
+		if (n == 0) {
+			n = nm_ip6_config_get_num_domains (ip6);
+			for (i = 0; i < n; i++) {
+				add_server (self, servers, address, iface, nm_ip6_config_get_domain (ip6, i));
+				added = TRUE;
+			}
+		}
+	}
+
+	if (!added) {
+		for (i = 0; i < nnameservers; i++) {
+			gs_unref_object GInetAddress *address = NULL;
+
+			address = ip6_addr_to_inet_address (nm_ip6_config_get_nameserver (ip6, i));
+			add_server (self, servers, address, iface, NULL);
+		}
+	}
+}
+
+static void
+add_global_config (NMDnsStub *self, GPtrArray *servers, const NMGlobalDnsConfig *config)
+{
+	guint i, j;
+
+	for (i = 0; i < nm_global_dns_config_get_num_domains (config); i++) {
+		NMGlobalDnsDomain *domain = nm_global_dns_config_get_domain (config, i);
+		const char *const *strv = nm_global_dns_domain_get_servers (domain);
+		const char *name = nm_global_dns_domain_get_name (domain);
+
+		g_return_if_fail (name);
+
+		for (j = 0; strv && strv[j]; j++) {
+			gs_unref_object GInetAddress *address = NULL;
+
+			address = g_inet_address_new_from_string (strv[j]);
+			if (!address) {
+				_LOGW ("ignoring invalid global nameserver '%s'", strv[j]);
+				continue;
+			}
+			add_server (self, servers, address, NULL, nm_streq (name, "*") ? NULL : name);
+		}
+	}
+}
+
+static void
+add_ip_config_data (NMDnsStub *self, GPtrArray *servers, const NMDnsIPConfigData *data)
+{
+	if (NM_IS_IP4_CONFIG (data->config)) {
+		add_ip4_config (self,
+		                servers,
+		                (NMIP4Config *) data->config,
+		                data->iface,
+		                data->type == NM_DNS_IP_CONFIG_TYPE_VPN);
+	} else if (NM_IS_IP6_CONFIG (data->config)) {
+		add_ip6_config (self,
+		                servers,
+		                (NMIP6Config *) data->config,
+		                data->iface,
+		                data->type == NM_DNS_IP_CONFIG_TYPE_VPN);
+	} else
+		g_return_if_reached ();
+}
+
+/* Returns the addresses of the servers for the longest domain that
+ * contains @name, falling back to the default servers. */
+static GPtrArray *
+_servers_for_name (NMDnsStub *self, const char *name)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	GPtrArray *result;
+	gsize name_len = strlen (name);
+	gssize best = -1;
+	guint i;
+
+	result = g_ptr_array_new_with_free_func (g_object_unref);
+
+	for (i = 0; priv->servers && i < priv->servers->len; i++) {
+		StubServer *server = priv->servers->pdata[i];
+		gssize l = 0;
+
+		if (server->domain) {
+			l = strlen (server->domain);
+			if (   (gsize) l > name_len
+			    || strcmp (&name[name_len - l], server->domain) != 0
+			    || ((gsize) l < name_len && name[name_len - l - 1] != '.'))
+				continue;
+		}
+
+		if (l > best) {
+			g_ptr_array_set_size (result, 0);
+			best = l;
+		}
+		if (l == best)
+			g_ptr_array_add (result, g_object_ref (server->address));
+	}
+
+	return result;
+}
+
+/*****************************************************************************/
+
+static void
+_cache_entry_free (gpointer data)
+{
+	CacheEntry *entry = data;
+
+	g_free (entry->data);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+_cache_add (NMDnsStub *self, const char *key, const guint8 *msg, gsize len, guint32 ttl)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	CacheEntry *entry;
+
+	if (g_hash_table_size (priv->cache) >= CACHE_MAX_ENTRIES) {
+		GHashTableIter iter;
+		gpointer entry_key, oldest_key = NULL;
+		gint32 oldest = G_MAXINT32;
+
+		g_hash_table_iter_init (&iter, priv->cache);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+			if (entry->expires <= now)
+				g_hash_table_iter_remove (&iter);
+		}
+
+		if (g_hash_table_size (priv->cache) >= CACHE_MAX_ENTRIES) {
+			g_hash_table_iter_init (&iter, priv->cache);
+			while (g_hash_table_iter_next (&iter, &entry_key, (gpointer *) &entry)) {
+				if (entry->expires < oldest) {
+					oldest = entry->expires;
+					oldest_key = entry_key;
+				}
+			}
+			g_hash_table_remove (priv->cache, oldest_key);
+		}
+	}
+
+	entry = g_slice_new (CacheEntry);
+	entry->data = g_memdup (msg, len);
+	entry->len = len;
+	entry->stored = now;
+	entry->expires = now + ttl;
+	g_hash_table_replace (priv->cache, g_strdup (key), entry);
+}
+
+/* Returns a copy of the cached answer for @key with the TTLs counted
+ * down, or NULL. */
+static guint8 *
+_cache_lookup (NMDnsStub *self, const char *key, gsize *out_len)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	CacheEntry *entry;
+	guint8 *answer;
+
+	entry = g_hash_table_lookup (priv->cache, key);
+	if (!entry)
+		return NULL;
+	if (entry->expires <= now) {
+		g_hash_table_remove (priv->cache, key);
+		return NULL;
+	}
+
+	answer = g_memdup (entry->data, entry->len);
+	_msg_process_ttls (answer, entry->len, now - entry->stored, NULL, NULL);
+	*out_len = entry->len;
+	return answer;
+}
+
+/*****************************************************************************/
+
+typedef void (*TcpReadFunc) (guint8 *msg, gsize len, gpointer user_data);
+typedef void (*TcpWriteFunc) (gboolean success, gpointer user_data);
+
+/* A DNS message over TCP, prefixed by its length (RFC 1035, 4.2.2).
+ * When the operation is cancelled the callback is not invoked. */
+typedef struct {
+	GInputStream *input;
+	GOutputStream *output;
+	GCancellable *cancellable;
+	guint8 *buf;
+	gsize len;
+	gsize pos;
+	gboolean have_len;
+	union {
+		TcpReadFunc read;
+		TcpWriteFunc write;
+	} callback;
+	gpointer user_data;
+} TcpOp;
+
+static void
+_tcp_op_free (TcpOp *op)
+{
+	g_clear_object (&op->input);
+	g_clear_object (&op->output);
+	g_clear_object (&op->cancellable);
+	g_free (op->buf);
+	g_slice_free (TcpOp, op);
+}
+
+static void _tcp_read_continue (TcpOp *op);
+
+static void
+_tcp_read_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	TcpOp *op = user_data;
+	gs_free_error GError *error = NULL;
+	gssize n;
+
+	n = g_input_stream_read_finish (G_INPUT_STREAM (source), res, &error);
+	if (   g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)
+	    || g_cancellable_is_cancelled (op->cancellable)) {
+		_tcp_op_free (op);
+		return;
+	}
+	if (n <= 0) {
+		/* end of stream or error */
+		op->callback.read (NULL, 0, op->user_data);
+		_tcp_op_free (op);
+		return;
+	}
+
+	op->pos += n;
+	if (op->pos < op->len) {
+		_tcp_read_continue (op);
+		return;
+	}
+
+	if (!op->have_len) {
+		op->len = _get_u16 (op->buf);
+		op->pos = 0;
+		op->have_len = TRUE;
+		g_free (op->buf);
+		op->buf = g_malloc (MAX (op->len, 1));
+		_tcp_read_continue (op);
+		return;
+	}
+
+	op->callback.read (op->buf, op->len, op->user_data);
+	op->buf = NULL;
+	_tcp_op_free (op);
+}
+
+static void
+_tcp_read_continue (TcpOp *op)
+{
+	g_input_stream_read_async (op->input,
+	                           &op->buf[op->pos],
+	                           op->len - op->pos,
+	                           G_PRIORITY_DEFAULT,
+	                           op->cancellable,
+	                           _tcp_read_cb,
+	                           op);
+}
+
+/* Reads one message; @callback gets it (transfer full), or NULL on failure. */
+static void
+_tcp_read_msg (GIOStream *stream, GCancellable *cancellable, TcpReadFunc callback, gpointer user_data)
+{
+	TcpOp *op;
+
+	op = g_slice_new0 (TcpOp);
+	op->input = g_object_ref (g_io_stream_get_input_stream (stream));
+	op->cancellable = g_object_ref (cancellable);
+	op->len = 2;
+	op->buf = g_malloc (op->len);
+	op->callback.read = callback;
+	op->user_data = user_data;
+	_tcp_read_continue (op);
+}
+
+static void _tcp_write_continue (TcpOp *op);
+
+static void
+_tcp_write_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	TcpOp *op = user_data;
+	gs_free_error GError *error = NULL;
+	gssize n;
+
+	n = g_output_stream_write_finish (G_OUTPUT_STREAM (source), res, &error);
+	if (   g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)
+	    || g_cancellable_is_cancelled (op->cancellable)) {
+		_tcp_op_free (op);
+		return;
+	}
+	if (n <= 0) {
+		op->callback.write (FALSE, op->user_data);
+		_tcp_op_free (op);
+		return;
+	}
+
+	op->pos += n;
+	if (op->pos < op->len) {
+		_tcp_write_continue (op);
+		return;
+	}
+
+	op->callback.write (TRUE, op->user_data);
+	_tcp_op_free (op);
+}
+
+static void
+_tcp_write_continue (TcpOp *op)
+{
+	g_output_stream_write_async (op->output,
+	                             &op->buf[op->pos],
+	                             op->len - op->pos,
+	                             G_PRIORITY_DEFAULT,
+	                             op->cancellable,
+	                             _tcp_write_cb,
+	                             op);
+}
+
+static void
+_tcp_write_msg (GIOStream *stream, GCancellable *cancellable,
+                const guint8 *msg, gsize len,
+                TcpWriteFunc callback, gpointer user_data)
+{
+	TcpOp *op;
+
+	op = g_slice_new0 (TcpOp);
+	op->output = g_object_ref (g_io_stream_get_output_stream (stream));
+	op->cancellable = g_object_ref (cancellable);
+	op->len = len + 2;
+	op->buf = g_malloc (op->len);
+	_set_u16 (op->buf, len);
+	memcpy (&op->buf[2], msg, len);
+	op->callback.write = callback;
+	op->user_data = user_data;
+	_tcp_write_continue (op);
+}
+
+/*****************************************************************************/
+
+static void
+_tcp_client_unref (StubTcpClient *client)
+{
+	if (--client->ref_count > 0)
+		return;
+
+	g_queue_foreach (&client->writes, (GFunc) g_bytes_unref, NULL);
+	g_queue_clear (&client->writes);
+	g_clear_object (&client->cancellable);
+	g_clear_object (&client->connection);
+	g_slice_free (StubTcpClient, client);
+}
+
+static void
+_tcp_client_close (StubTcpClient *client)
+{
+	NMDnsStubPrivate *priv;
+
+	if (!client->self)
+		return;
+
+	priv = NM_DNS_STUB_GET_PRIVATE (client->self);
+	priv->tcp_clients = g_slist_remove (priv->tcp_clients, client);
+	client->self = NULL;
+	g_cancellable_cancel (client->cancellable);
+	g_socket_close (g_socket_connection_get_socket (client->connection), NULL);
+	_tcp_client_unref (client);
+}
+
+static void _tcp_client_write_next (StubTcpClient *client);
+
+static void
+_tcp_client_write_done (gboolean success, gpointer user_data)
+{
+	StubTcpClient *client = user_data;
+
+	client->writing = FALSE;
+	if (!success)
+		_tcp_client_close (client);
+	else
+		_tcp_client_write_next (client);
+}
+
+static void
+_tcp_client_write_next (StubTcpClient *client)
+{
+	GBytes *bytes;
+
+	if (client->writing || !client->self)
+		return;
+
+	bytes = g_queue_pop_head (&client->writes);
+	if (!bytes)
+		return;
+
+	client->writing = TRUE;
+	_tcp_write_msg (G_IO_STREAM (client->connection),
+	                client->cancellable,
+	                g_bytes_get_data (bytes, NULL),
+	                g_bytes_get_size (bytes),
+	                _tcp_client_write_done,
+	                client);
+	g_bytes_unref (bytes);
+}
+
+static void handle_query (NMDnsStub *self,
+                          const guint8 *msg,
+                          gsize len,
+                          GSocketAddress *client,
+                          StubTcpClient *tcp_client);
+
+static void
+_tcp_client_read_done (guint8 *msg, gsize len, gpointer user_data)
+{
+	StubTcpClient *client = user_data;
+
+	if (!msg) {
+		_tcp_client_close (client);
+		return;
+	}
+
+	/* clients may send further queries before the first one is answered */
+	handle_query (client->self, msg, len, NULL, client);
+	g_free (msg);
+
+	if (client->self) {
+		_tcp_read_msg (G_IO_STREAM (client->connection),
+		               client->cancellable,
+		               _tcp_client_read_done,
+		               client);
+	}
+}
+
+static gboolean
+tcp_incoming_cb (GSocketService *service,
+                 GSocketConnection *connection,
+                 GObject *source_object,
+                 gpointer user_data)
+{
+	NMDnsStub *self = NM_DNS_STUB (user_data);
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	StubTcpClient *client;
+
+	if (g_slist_length (priv->tcp_clients) >= TCP_MAX_CLIENTS) {
+		_LOGD ("too many TCP clients, refusing connection");
+		return TRUE;
+	}
+
+	client = g_slice_new0 (StubTcpClient);
+	client->ref_count = 1;
+	client->self = self;
+	client->connection = g_object_ref (connection);
+	client->cancellable = g_cancellable_new ();
+	g_queue_init (&client->writes);
+	priv->tcp_clients = g_slist_prepend (priv->tcp_clients, client);
+
+	_tcp_read_msg (G_IO_STREAM (connection),
+	               client->cancellable,
+	               _tcp_client_read_done,
+	               client);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+/* Sends @msg (transfer full) to the client. */
+static void
+send_reply (NMDnsStub *self,
+            GSocketAddress *client,
+            StubTcpClient *tcp_client,
+            gsize max_udp_size,
+            guint8 *msg,
+            gsize len)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
+
+	if (tcp_client) {
+		if (tcp_client->self) {
+			g_queue_push_tail (&tcp_client->writes, g_bytes_new_take (msg, len));
+			_tcp_client_write_next (tcp_client);
+		} else
+			g_free (msg);
+		return;
+	}
+
+	if (len > max_udp_size) {
+		gsize question_end = _msg_question_end (msg, len);
+
+		/* let the client retry over TCP */
+		_set_u16 (&msg[2], _get_u16 (&msg[2]) | DNS_FLAG_TC);
+		_set_u16 (&msg[6], 0);
+		_set_u16 (&msg[8], 0);
+		_set_u16 (&msg[10], 0);
+		len = question_end ?: DNS_HEADER_SIZE;
+		if (!question_end)
+			_set_u16 (&msg[4], 0);
+	}
+
+	if (g_socket_send_to (priv->listen_udp, client, (char *) msg, len, NULL, &error) < 0)
+		_LOGD ("failed to send answer: %s", error->message);
+	g_free (msg);
+}
+
+static void
+send_error (NMDnsStub *self,
+            GSocketAddress *client,
+            StubTcpClient *tcp_client,
+            const guint8 *msg,
+            gsize question_end,
+            guint rcode)
+{
+	guint8 *answer;
+	gsize len;
+
+	answer = _msg_new_error (msg, question_end, rcode, &len);
+	send_reply (self, client, tcp_client, DNS_UDP_DEFAULT_SIZE, answer, len);
+}
+
+/*****************************************************************************/
+
+static GSocket *
+_socket_new_udp (GSocketFamily family, GSocketAddress *bind_address, GError **error)
+{
+	GSocket *socket;
+
+	socket = g_socket_new (family, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, error);
+	if (!socket)
+		return NULL;
+
+	g_socket_set_blocking (socket, FALSE);
+	if (   bind_address
+	    && !g_socket_bind (socket, bind_address, TRUE, error)) {
+		g_object_unref (socket);
+		return NULL;
+	}
+	return socket;
+}
+
+static GSource *
+_socket_watch (GSocket *socket, GSocketSourceFunc func, gpointer user_data)
+{
+	GSource *source;
+
+	source = g_socket_create_source (socket, G_IO_IN, NULL);
+	g_source_set_callback (source, (GSourceFunc) func, user_data, NULL);
+	g_source_attach (source, NULL);
+	return source;
+}
+
+static void
+_clear_source (GSource **source)
+{
+	if (*source) {
+		g_source_destroy (*source);
+		g_source_unref (*source);
+		*source = NULL;
+	}
+}
+
+static void
+_query_free (StubQuery *query)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (query->self);
+
+	g_hash_table_remove (priv->queries, GUINT_TO_POINTER (query->upstream_id));
+
+	nm_clear_g_source (&query->timeout_id);
+	nm_clear_g_cancellable (&query->tcp_cancellable);
+	g_clear_object (&query->tcp_connection);
+	_clear_source (&query->socket_source);
+	g_clear_object (&query->socket);
+	g_clear_object (&query->client);
+	if (query->tcp_client)
+		_tcp_client_unref (query->tcp_client);
+	g_ptr_array_unref (query->servers);
+	g_free (query->cache_key);
+	g_free (query->msg);
+	g_slice_free (StubQuery, query);
+}
+
+static GInetSocketAddress *
+_query_server (StubQuery *query)
+{
+	return query->servers->pdata[query->server_idx];
+}
+
+static void _query_send (StubQuery *query);
+
+static void
+_query_next_server (StubQuery *query)
+{
+	NMDnsStub *self = query->self;
+
+	nm_clear_g_source (&query->timeout_id);
+	nm_clear_g_cancellable (&query->tcp_cancellable);
+	g_clear_object (&query->tcp_connection);
+
+	if (++query->server_idx >= query->servers->len) {
+		NM_DNS_STUB_GET_PRIVATE (self)->stats.failures++;
+		_LOGD ("no nameserver answered query for '%s'", query->cache_key);
+
+		_set_u16 (query->msg, query->client_id);
+		send_error (self, query->client, query->tcp_client,
+		            query->msg, query->question_end, DNS_RCODE_SERVFAIL);
+		_query_free (query);
+		return;
+	}
+
+	_query_send (query);
+}
+
+static gboolean
+_query_timeout_cb (gpointer user_data)
+{
+	StubQuery *query = user_data;
+	NMDnsStub *self = query->self;
+
+	query->timeout_id = 0;
+	NM_DNS_STUB_GET_PRIVATE (self)->stats.upstream_timeouts++;
+	_LOGD ("query for '%s' timed out", query->cache_key);
+	_query_next_server (query);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_query_complete (StubQuery *query, guint8 *answer, gsize len)
+{
+	NMDnsStub *self = query->self;
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	guint32 ttl;
+
+	priv->stats.upstream_answers++;
+	priv->stats.upstream_usec += nm_utils_get_monotonic_timestamp_us () - query->start_usec;
+
+	ttl = _msg_cache_ttl (answer, len);
+	if (ttl)
+		_cache_add (self, query->cache_key, answer, len, ttl);
+
+	_set_u16 (answer, query->client_id);
+	send_reply (self, query->client, query->tcp_client, query->max_udp_size,
+	            g_memdup (answer, len), len);
+	_query_free (query);
+}
+
+/* Whether @answer is the answer to @query: the question must match,
+ * ignoring case. */
+static gboolean
+_query_matches (StubQuery *query, const guint8 *answer, gsize len)
+{
+	gsize i;
+
+	if (   len < query->question_end
+	    || !NM_FLAGS_HAS (_get_u16 (&answer[2]), DNS_FLAG_QR)
+	    || _get_u16 (&answer[4]) != 1)
+		return FALSE;
+
+	for (i = DNS_HEADER_SIZE; i < query->question_end; i++) {
+		if (g_ascii_tolower (answer[i]) != g_ascii_tolower (query->msg[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_query_tcp_read_done (guint8 *msg, gsize len, gpointer user_data)
+{
+	StubQuery *query = user_data;
+	NMDnsStub *self = query->self;
+
+	if (   !msg
+	    || _get_u16 (msg) != query->upstream_id
+	    || !_query_matches (query, msg, len)) {
+		_LOGD ("TCP query for '%s' failed", query->cache_key);
+		g_free (msg);
+		_query_next_server (query);
+		return;
+	}
+
+	_query_complete (query, msg, len);
+	g_free (msg);
+}
+
+static void
+_query_tcp_write_done (gboolean success, gpointer user_data)
+{
+	StubQuery *query = user_data;
+
+	if (!success) {
+		_query_next_server (query);
+		return;
+	}
+
+	_tcp_read_msg (G_IO_STREAM (query->tcp_connection),
+	               query->tcp_cancellable,
+	               _query_tcp_read_done,
+	               query);
+}
+
+static void
+_query_tcp_connect_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	StubQuery *query;
+	GSocketConnection *connection;
+	gs_free_error GError *error = NULL;
+
+	connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source), res, &error);
+	if (   !connection
+	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	query = user_data;
+	if (!connection) {
+		NMDnsStub *self = query->self;
+
+		_LOGD ("TCP connection for query '%s' failed: %s", query->cache_key, error->message);
+		_query_next_server (query);
+		return;
+	}
+
+	query->tcp_connection = connection;
+	_tcp_write_msg (G_IO_STREAM (connection),
+	                query->tcp_cancellable,
+	                query->msg,
+	                query->len,
+	                _query_tcp_write_done,
+	                query);
+}
+
+/* The UDP answer was truncated; ask the same server again over TCP */
+static void
+_query_start_tcp (StubQuery *query)
+{
+	GSocketClient *client;
+
+	nm_clear_g_source (&query->timeout_id);
+	query->tcp_cancellable = g_cancellable_new ();
+
+	client = g_socket_client_new ();
+	g_socket_client_connect_async (client,
+	                               G_SOCKET_CONNECTABLE (_query_server (query)),
+	                               query->tcp_cancellable,
+	                               _query_tcp_connect_cb,
+	                               query);
+	g_object_unref (client);
+
+	query->timeout_id = g_timeout_add (UPSTREAM_TCP_TIMEOUT_MSEC, _query_timeout_cb, query);
+}
+
+static gboolean
+upstream_cb (GSocket *socket, GIOCondition condition, gpointer user_data)
+{
+	StubQuery *query = user_data;
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (query->self);
+
+	for (;;) {
+		gs_unref_object GSocketAddress *from = NULL;
+		gssize n;
+
+		n = g_socket_receive_from (socket, &from, (char *) priv->buf, DNS_MAX_SIZE, NULL, NULL);
+		if (n < 0)
+			break;
+		if (   n < DNS_HEADER_SIZE
+		    || _get_u16 (priv->buf) != query->upstream_id
+		    || query->tcp_cancellable
+		    || !G_IS_INET_SOCKET_ADDRESS (from)
+		    || !_address_equal (G_INET_SOCKET_ADDRESS (from), _query_server (query))
+		    || !_query_matches (query, priv->buf, n))
+			continue;
+
+		if (NM_FLAGS_HAS (_get_u16 (&priv->buf[2]), DNS_FLAG_TC)) {
+			_query_start_tcp (query);
+			break;
+		}
+
+		/* frees @query and destroys this source */
+		_query_complete (query, priv->buf, n);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+_query_send (StubQuery *query)
+{
+	NMDnsStub *self = query->self;
+	GInetSocketAddress *server = _query_server (query);
+	gs_free_error GError *error = NULL;
+
+	/* The kernel binds a new socket to a random ephemeral port, which,
+	 * together with the random ID, makes spoofing answers harder. */
+	_clear_source (&query->socket_source);
+	g_clear_object (&query->socket);
+	query->socket = _socket_new_udp (g_socket_address_get_family (G_SOCKET_ADDRESS (server)), NULL, &error);
+	if (   !query->socket
+	    || g_socket_send_to (query->socket, G_SOCKET_ADDRESS (server),
+	                         (char *) query->msg, query->len, NULL, &error) < 0) {
+		gs_free char *str = _address_to_string (server);
+
+		_LOGD ("failed to send query to %s: %s", str, error->message);
+		_query_next_server (query);
+		return;
+	}
+	query->socket_source = _socket_watch (query->socket, upstream_cb, query);
+
+	query->timeout_id = g_timeout_add (UPSTREAM_UDP_TIMEOUT_MSEC, _query_timeout_cb, query);
+}
+
+static guint16
+_query_alloc_id (NMDnsStub *self)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	guint16 id;
+
+	/* random IDs make spoofing answers harder */
+	do {
+		id = g_random_int_range (0, 0x10000);
+	} while (g_hash_table_contains (priv->queries, GUINT_TO_POINTER (id)));
+	return id;
+}
+
+static void
+handle_query (NMDnsStub *self,
+              const guint8 *msg,
+              gsize len,
+              GSocketAddress *client,
+              StubTcpClient *tcp_client)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	DnsQuestion q;
+	gs_free char *key = NULL;
+	GPtrArray *servers;
+	StubQuery *query;
+	guint8 *answer;
+	gsize answer_len;
+
+	priv->stats.queries++;
+
+	if (!_msg_parse_query (msg, len, &q)) {
+		if (len >= DNS_HEADER_SIZE && !(_get_u16 (&msg[2]) & DNS_FLAG_QR))
+			send_error (self, client, tcp_client, msg, 0, DNS_RCODE_FORMERR);
+		return;
+	}
+
+	key = g_strdup_printf ("%s/%u/%u%s", q.name, q.qtype, q.qclass, q.dnssec_ok ? "/do" : "");
+
+	answer = _cache_lookup (self, key, &answer_len);
+	if (answer) {
+		priv->stats.cache_hits++;
+		memcpy (answer, msg, 2);
+		/* echo the question as the client spelt it */
+		if (_msg_question_end (answer, answer_len) == q.question_end)
+			memcpy (&answer[DNS_HEADER_SIZE], &msg[DNS_HEADER_SIZE], q.question_end - DNS_HEADER_SIZE);
+		send_reply (self, client, tcp_client, q.max_udp_size, answer, answer_len);
+		g_free (q.name);
+		return;
+	}
+	priv->stats.cache_misses++;
+
+	servers = _servers_for_name (self, q.name);
+	g_free (q.name);
+	if (!servers->len) {
+		g_ptr_array_unref (servers);
+		send_error (self, client, tcp_client, msg, q.question_end, DNS_RCODE_SERVFAIL);
+		return;
+	}
+
+	query = g_slice_new0 (StubQuery);
+	query->self = self;
+	query->client = client ? g_object_ref (client) : NULL;
+	if (tcp_client) {
+		query->tcp_client = tcp_client;
+		tcp_client->ref_count++;
+	}
+	query->max_udp_size = q.max_udp_size;
+	query->msg = g_memdup (msg, len);
+	query->len = len;
+	query->question_end = q.question_end;
+	query->client_id = _get_u16 (msg);
+	query->upstream_id = _query_alloc_id (self);
+	_set_u16 (query->msg, query->upstream_id);
+	query->cache_key = key;
+	key = NULL;
+	query->servers = servers;
+	query->start_usec = nm_utils_get_monotonic_timestamp_us ();
+
+	g_hash_table_insert (priv->queries, GUINT_TO_POINTER (query->upstream_id), query);
+	_query_send (query);
+}
+
+static gboolean
+listen_udp_cb (GSocket *socket, GIOCondition condition, gpointer user_data)
+{
+	NMDnsStub *self = NM_DNS_STUB (user_data);
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+
+	for (;;) {
+		gs_unref_object GSocketAddress *from = NULL;
+		gssize n;
+
+		n = g_socket_receive_from (socket, &from, (char *) priv->buf, DNS_MAX_SIZE, NULL, NULL);
+		if (n < 0)
+			break;
+		handle_query (self, priv->buf, n, from, NULL);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+start_listening (NMDnsStub *self)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	gs_unref_object GInetAddress *loopback = NULL;
+	gs_unref_object GSocketAddress *address = NULL;
+	gs_free_error GError *error = NULL;
+
+	if (priv->listen_udp)
+		return TRUE;
+
+	loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+	address = g_inet_socket_address_new (loopback, DNS_PORT);
+
+	priv->listen_udp = _socket_new_udp (G_SOCKET_FAMILY_IPV4, address, &error);
+	if (!priv->listen_udp) {
+		_LOGW ("failed to listen on 127.0.0.1: %s", error->message);
+		return FALSE;
+	}
+	priv->listen_udp_source = _socket_watch (priv->listen_udp, listen_udp_cb, self);
+
+	priv->listen_tcp = g_socket_service_new ();
+	if (!g_socket_listener_add_address (G_SOCKET_LISTENER (priv->listen_tcp),
+	                                    address,
+	                                    G_SOCKET_TYPE_STREAM,
+	                                    G_SOCKET_PROTOCOL_TCP,
+	                                    NULL,
+	                                    NULL,
+	                                    &error)) {
+		/* UDP alone is enough for most clients */
+		_LOGW ("failed to listen on 127.0.0.1 for TCP: %s", error->message);
+		g_clear_error (&error);
+		g_clear_object (&priv->listen_tcp);
+	} else {
+		g_signal_connect (priv->listen_tcp, "incoming", G_CALLBACK (tcp_incoming_cb), self);
+		g_socket_service_start (priv->listen_tcp);
+	}
+
+	_LOGI ("listening on 127.0.0.1");
+	return TRUE;
+}
+
+static void
+_clear_queries (NMDnsStub *self)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	GList *queries, *iter;
+
+	queries = g_hash_table_get_values (priv->queries);
+	for (iter = queries; iter; iter = iter->next)
+		_query_free (iter->data);
+	g_list_free (queries);
+}
+
+static gboolean
+_servers_equal (GPtrArray *a, GPtrArray *b)
+{
+	guint i;
+
+	if ((a ? a->len : 0) != (b ? b->len : 0))
+		return FALSE;
+	for (i = 0; a && i < a->len; i++) {
+		if (!_server_equal (a->pdata[i], b->pdata[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+set_servers (NMDnsStub *self,
+             const NMDnsIPConfigData **configs,
+             const NMGlobalDnsConfig *global_config)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+	GPtrArray *servers;
+
+	servers = g_ptr_array_new_with_free_func (_server_free);
+	if (global_config)
+		add_global_config (self, servers, global_config);
+	else {
+		while (*configs) {
+			add_ip_config_data (self, servers, *configs);
+			configs++;
+		}
+	}
+
+	/* The cached answers came from the old servers. Any change, even a
+	 * removed server or a domain moving to another one, may make them
+	 * wrong: for example when a VPN goes down, the names it resolved
+	 * must not keep the VPN's answers. */
+	if (!_servers_equal (priv->servers, servers)) {
+		_LOGD ("nameservers changed, clearing the cache");
+		g_hash_table_remove_all (priv->cache);
+	}
+
+	if (priv->servers)
+		g_ptr_array_unref (priv->servers);
+	priv->servers = servers;
+}
+
+void
+_nm_dns_stub_set_servers (NMDnsStub *self,
+                          const NMDnsIPConfigData **configs,
+                          const NMGlobalDnsConfig *global_config)
+{
+	g_return_if_fail (NM_IS_DNS_STUB (self));
+
+	set_servers (self, configs, global_config);
+}
+
+void
+_nm_dns_stub_cache_add (NMDnsStub *self, const char *key, const guint8 *msg, gsize len, guint32 ttl)
+{
+	g_return_if_fail (NM_IS_DNS_STUB (self));
+
+	_cache_add (self, key, msg, len, ttl);
+}
+
+static gboolean
+update (NMDnsPlugin *plugin,
+        const NMDnsIPConfigData **configs,
+        const NMGlobalDnsConfig *global_config,
+        const char *hostname)
+{
+	NMDnsStub *self = NM_DNS_STUB (plugin);
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+
+	if (!start_listening (self))
+		return FALSE;
+
+	set_servers (self, configs, global_config);
+
+	_LOGD ("%"G_GUINT64_FORMAT" queries, %"G_GUINT64_FORMAT" cache hits, "
+	       "%"G_GUINT64_FORMAT" upstream answers (average %"G_GUINT64_FORMAT" usec), "
+	       "%"G_GUINT64_FORMAT" timeouts, %"G_GUINT64_FORMAT" failures",
+	       priv->stats.queries, priv->stats.cache_hits, priv->stats.upstream_answers,
+	       priv->stats.upstream_answers ? priv->stats.upstream_usec / priv->stats.upstream_answers : 0,
+	       priv->stats.upstream_timeouts, priv->stats.failures);
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+void
+nm_dns_stub_get_stats (NMDnsStub *self, NMDnsStubStats *stats)
+{
+	NMDnsStubPrivate *priv;
+
+	g_return_if_fail (NM_IS_DNS_STUB (self));
+	g_return_if_fail (stats);
+
+	priv = NM_DNS_STUB_GET_PRIVATE (self);
+	*stats = priv->stats;
+	stats->cache_size = g_hash_table_size (priv->cache);
+}
+
+static gboolean
+is_caching (NMDnsPlugin *plugin)
+{
+	return TRUE;
+}
+
+static const char *
+get_name (NMDnsPlugin *plugin)
+{
+	return "stub";
+}
+
+/*****************************************************************************/
+
+NMDnsPlugin *
+nm_dns_stub_new (void)
+{
+	return g_object_new (NM_TYPE_DNS_STUB, NULL);
+}
+
+static void
+nm_dns_stub_init (NMDnsStub *self)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (self);
+
+	priv->queries = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _cache_entry_free);
+	priv->buf = g_malloc (DNS_MAX_SIZE);
+}
+
+static void
+dispose (GObject *object)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (object);
+
+	_clear_queries (NM_DNS_STUB (object));
+	while (priv->tcp_clients)
+		_tcp_client_close (priv->tcp_clients->data);
+
+	if (priv->listen_tcp) {
+		g_signal_handlers_disconnect_by_func (priv->listen_tcp, tcp_incoming_cb, object);
+		g_socket_service_stop (priv->listen_tcp);
+		g_socket_listener_close (G_SOCKET_LISTENER (priv->listen_tcp));
+		g_clear_object (&priv->listen_tcp);
+	}
+
+	_clear_source (&priv->listen_udp_source);
+	g_clear_object (&priv->listen_udp);
+
+	g_clear_pointer (&priv->servers, g_ptr_array_unref);
+	g_hash_table_remove_all (priv->cache);
+
+	G_OBJECT_CLASS (nm_dns_stub_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE (object);
+
+	g_hash_table_unref (priv->queries);
+	g_hash_table_unref (priv->cache);
+	g_free (priv->buf);
+
+	G_OBJECT_CLASS (nm_dns_stub_parent_class)->finalize (object);
+}
+
+static void
+nm_dns_stub_class_init (NMDnsStubClass *stub_class)
+{
+	NMDnsPluginClass *plugin_class = NM_DNS_PLUGIN_CLASS (stub_class);
+	GObjectClass *object_class = G_OBJECT_CLASS (stub_class);
+
+	g_type_class_add_private (stub_class, sizeof (NMDnsStubPrivate));
+
+	object_class->dispose = dispose;
+	object_class->finalize = finalize;
+
+	plugin_class->is_caching = is_caching;
+	plugin_class->update = update;
+	plugin_class->get_name = get_name;
+}
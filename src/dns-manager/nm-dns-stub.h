@@ -0,0 +1,65 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+#ifndef __NETWORKMANAGER_DNS_STUB_H__
+#define __NETWORKMANAGER_DNS_STUB_H__
+
+#include "nm-dns-plugin.h"
+
+#define NM_TYPE_DNS_STUB            (nm_dns_stub_get_type ())
+#define NM_DNS_STUB(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_DNS_STUB, NMDnsStub))
+#define NM_DNS_STUB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_DNS_STUB, NMDnsStubClass))
+#define NM_IS_DNS_STUB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_DNS_STUB))
+#define NM_IS_DNS_STUB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_DNS_STUB))
+#define NM_DNS_STUB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_DNS_STUB, NMDnsStubClass))
+
+typedef struct {
+	NMDnsPlugin parent;
+} NMDnsStub;
+
+typedef struct {
+	NMDnsPluginClass parent;
+} NMDnsStubClass;
+
+typedef struct {
+	guint64 queries;
+	guint64 cache_hits;
+	guint64 cache_misses;
+	guint64 upstream_answers;
+	guint64 upstream_timeouts;
+	guint64 failures;
+
+	/* total time spent waiting for the upstream answers */
+	guint64 upstream_usec;
+
+	guint cache_size;
+} NMDnsStubStats;
+
+GType nm_dns_stub_get_type (void);
+
+NMDnsPlugin *nm_dns_stub_new (void);
+
+void nm_dns_stub_get_stats (NMDnsStub *self, NMDnsStubStats *stats);
+
+/* exposed for the unit tests */
+guint32 _nm_dns_stub_msg_cache_ttl (const guint8 *msg, gsize len);
+void _nm_dns_stub_cache_add (NMDnsStub *self, const char *key, const guint8 *msg, gsize len, guint32 ttl);
+void _nm_dns_stub_set_servers (NMDnsStub *self,
+                               const NMDnsIPConfigData **configs,
+                               const NMGlobalDnsConfig *global_config);
+
+#endif /* __NETWORKMANAGER_DNS_STUB_H__ */
@@ -20,18 +20,62 @@
 #include "nm-default.h"
 
 #include "nm-dns-unbound.h"
+#include "nm-ip4-config.h"
+#include "nm-ip6-config.h"
 #include "NetworkManagerUtils.h"
 
 G_DEFINE_TYPE (NMDnsUnbound, nm_dns_unbound, NM_TYPE_DNS_PLUGIN)
 
+#define NM_DNS_UNBOUND_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DNS_UNBOUND, NMDnsUnboundPrivate))
+
+typedef struct {
+	/* digest of the configuration the script was last run for */
+	guint64 digest;
+	gboolean have_digest;
+} NMDnsUnboundPrivate;
+
 /*******************************************/
 
+static guint64
+compute_digest (const NMDnsIPConfigData **configs,
+                const NMGlobalDnsConfig *global_config)
+{
+	guint64 h = NM_UTILS_DIGEST_INIT;
+
+	if (global_config) {
+		GChecksum *sum;
+		guint8 buffer[20];
+		gsize len = sizeof (buffer);
+
+		sum = g_checksum_new (G_CHECKSUM_SHA1);
+		nm_global_dns_config_update_checksum (global_config, sum);
+		g_checksum_get_digest (sum, buffer, &len);
+		g_checksum_free (sum);
+		return nm_utils_digest_mem (h, buffer, len);
+	}
+
+	for (; *configs; configs++) {
+		const NMDnsIPConfigData *data = *configs;
+
+		h = nm_utils_digest_u32 (h, data->type);
+		h = nm_utils_digest_str (h, data->iface);
+		if (NM_IS_IP4_CONFIG (data->config))
+			h = nm_utils_digest_u64 (h, nm_ip4_config_get_digest (data->config, TRUE));
+		else if (NM_IS_IP6_CONFIG (data->config))
+			h = nm_utils_digest_u64 (h, nm_ip6_config_get_digest (data->config, TRUE));
+	}
+	return h;
+}
+
 static gboolean
 update (NMDnsPlugin *plugin,
         const NMDnsIPConfigData **configs,
         const NMGlobalDnsConfig *global_config,
         const char *hostname)
 {
+	NMDnsUnboundPrivate *priv = NM_DNS_UNBOUND_GET_PRIVATE (plugin);
+	guint64 digest;
+
 	/* TODO: We currently call a script installed with the dnssec-trigger
 	 * package that queries all information itself. Later, the dependency
 	 * on that package will be optional and the only hard dependency will
@@ -41,7 +85,23 @@ update (NMDnsPlugin *plugin,
 	 * without calling custom scripts. The dnssec-trigger functionality
 	 * may be eventually merged into NetworkManager.
 	 */
-	return nm_spawn_process (DNSSEC_TRIGGER_SCRIPT " --async --update", NULL) == 0;
+
+	/* The script fetches the DNS information from NetworkManager itself, so
+	 * there is nothing to tell it as long as that didn't change. */
+	digest = compute_digest (configs, global_config);
+	if (priv->have_digest && priv->digest == digest) {
+		nm_log_dbg (LOGD_DNS, "unbound: DNS configuration unchanged, not running " DNSSEC_TRIGGER_SCRIPT);
+		return TRUE;
+	}
+
+	if (nm_spawn_process (DNSSEC_TRIGGER_SCRIPT " --async --update", NULL) != 0) {
+		priv->have_digest = FALSE;
+		return FALSE;
+	}
+
+	priv->digest = digest;
+	priv->have_digest = TRUE;
+	return TRUE;
 }
 
 static gboolean
@@ -74,6 +134,8 @@ nm_dns_unbound_class_init (NMDnsUnboundClass *klass)
 {
 	NMDnsPluginClass *plugin_class = NM_DNS_PLUGIN_CLASS (klass);
 
+	g_type_class_add_private (klass, sizeof (NMDnsUnboundPrivate));
+
 	plugin_class->update = update;
 	plugin_class->is_caching = is_caching;
 	plugin_class->get_name = get_name;
@@ -47,13 +47,18 @@
 typedef struct {
 	char *iface;
 	char *pidfile;
+	char *leasefile;
 	GPid pid;
 	guint dm_watch_id;
+
+	/* command line of the running instance */
+	char *cmd_str;
 } NMDnsMasqManagerPrivate;
 
 #define NM_DNSMASQ_MANAGER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DNSMASQ_MANAGER, NMDnsMasqManagerPrivate))
 
 #define CONFDIR NMCONFDIR "/dnsmasq-shared.d"
+#define HOSTSDIR NMCONFDIR "/dnsmasq-shared-hosts.d"
 
 G_DEFINE_TYPE (NMDnsMasqManager, nm_dnsmasq_manager, G_TYPE_OBJECT)
 
@@ -133,6 +138,7 @@ dm_watch_cb (GPid pid, gint status, gpointer user_data)
 
 	priv->pid = 0;
 	priv->dm_watch_id = 0;
+	g_clear_pointer (&priv->cmd_str, g_free);
 
 	g_signal_emit (manager, signals[STATE_CHANGED], 0, NM_DNSMASQ_STATUS_DEAD);
 }
@@ -141,6 +147,7 @@ static NMCmdLine *
 create_dm_cmd_line (const char *iface,
                     const NMIP4Config *ip4_config,
                     const char *pidfile,
+                    const char *leasefile,
                     GError **error)
 {
 	NMCmdLine *cmd;
@@ -219,6 +226,14 @@ create_dm_cmd_line (const char *iface,
 
 	nm_cmd_line_add_string (cmd, "--dhcp-lease-max=50");
 
+	/* Keep a lease file per interface so that clients get their addresses
+	 * back after dnsmasq or NetworkManager restarts.
+	 */
+	s = g_string_new ("--dhcp-leasefile=");
+	g_string_append (s, leasefile);
+	nm_cmd_line_add_string (cmd, s->str);
+	g_string_free (s, TRUE);
+
 	s = g_string_new ("--pid-file=");
 	g_string_append (s, pidfile);
 	nm_cmd_line_add_string (cmd, s->str);
@@ -228,6 +243,13 @@ create_dm_cmd_line (const char *iface,
 	if (g_file_test (CONFDIR, G_FILE_TEST_IS_DIR))
 		nm_cmd_line_add_string (cmd, "--conf-dir=" CONFDIR);
 
+	/* Static leases in the hosts dir are picked up by dnsmasq as they
+	 * change, without a restart. Upstream DNS servers already are, as
+	 * dnsmasq polls resolv.conf.
+	 */
+	if (g_file_test (HOSTSDIR, G_FILE_TEST_IS_DIR))
+		nm_cmd_line_add_string (cmd, "--dhcp-hostsdir=" HOSTSDIR);
+
 	return cmd;
 }
 
@@ -285,16 +307,30 @@ nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 
 	priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
 
-	kill_existing_by_pidfile (priv->pidfile);
-
-	dm_cmd = create_dm_cmd_line (priv->iface, ip4_config, priv->pidfile, error);
+	dm_cmd = create_dm_cmd_line (priv->iface, ip4_config, priv->pidfile, priv->leasefile, error);
 	if (!dm_cmd)
 		return FALSE;
 
 	g_ptr_array_add (dm_cmd->array, NULL);
+	cmd_str = nm_cmd_line_to_str (dm_cmd);
+
+	/* Don't interrupt DHCP and DNS service for the clients when nothing
+	 * changed; just let dnsmasq reload its hosts files and upstreams.
+	 */
+	if (priv->pid && !g_strcmp0 (priv->cmd_str, cmd_str)) {
+		_LOGD ("dnsmasq configuration unchanged, reloading");
+		kill (priv->pid, SIGHUP);
+		nm_cmd_line_destroy (dm_cmd);
+		return TRUE;
+	}
+
+	if (priv->pid)
+		nm_dnsmasq_manager_stop (manager);
+	else
+		kill_existing_by_pidfile (priv->pidfile);
 
 	_LOGI ("starting dnsmasq...");
-	_LOGD ("command line: %s", (cmd_str = nm_cmd_line_to_str (dm_cmd)));
+	_LOGD ("command line: %s", cmd_str);
 
 	priv->pid = 0;
 	if (!g_spawn_async (NULL, (char **) dm_cmd->array->pdata, NULL,
@@ -306,6 +342,8 @@ nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 
 	_LOGD ("dnsmasq started with pid %d", priv->pid);
 
+	priv->cmd_str = g_steal_pointer (&cmd_str);
+
 	priv->dm_watch_id = g_child_watch_add (priv->pid, (GChildWatchFunc) dm_watch_cb, manager);
 
  out:
@@ -330,6 +368,7 @@ nm_dnsmasq_manager_stop (NMDnsMasqManager *manager)
 		nm_utils_kill_child_async (priv->pid, SIGTERM, LOGD_SHARING, "dnsmasq", 2000, NULL, NULL);
 		priv->pid = 0;
 	}
+	g_clear_pointer (&priv->cmd_str, g_free);
 
 	unlink (priv->pidfile);
 }
@@ -345,6 +384,7 @@ nm_dnsmasq_manager_new (const char *iface)
 	priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
 	priv->iface = g_strdup (iface);
 	priv->pidfile = g_strdup_printf (RUNSTATEDIR "/nm-dnsmasq-%s.pid", iface);
+	priv->leasefile = g_strdup_printf (NMSTATEDIR "/dnsmasq-%s.leases", iface);
 
 	return manager;
 }
@@ -363,6 +403,7 @@ finalize (GObject *object)
 
 	g_free (priv->iface);
 	g_free (priv->pidfile);
+	g_free (priv->leasefile);
 
 	G_OBJECT_CLASS (nm_dnsmasq_manager_parent_class)->finalize (object);
 }
@@ -39,13 +39,20 @@
 #include "NetworkManagerUtils.h"
 #include "nm-manager.h"
 #include "nm-linux-platform.h"
+#include "nm-fake-platform.h"
 #include "nm-bus-manager.h"
 #include "nm-device.h"
 #include "nm-dhcp-manager.h"
 #include "nm-config.h"
+#include "nm-executor.h"
 #include "nm-session-monitor.h"
+#include "nm-startup-profile.h"
+#include "nm-statistics.h"
+#include "nm-watchdog.h"
 #include "nm-dispatcher.h"
 #include "nm-settings.h"
+#include "nm-settings-connection.h"
+#include "nm-settings-writer.h"
 #include "nm-auth-manager.h"
 #include "nm-core-internal.h"
 #include "nm-exported-object.h"
@@ -57,6 +64,8 @@
 
 #define NM_DEFAULT_PID_FILE          NMRUNDIR "/NetworkManager.pid"
 #define NM_DEFAULT_SYSTEM_STATE_FILE NMSTATEDIR "/NetworkManager.state"
+#define NM_LOG_RING_FILE             NMRUNDIR "/log-ring"
+#define NM_LOG_RING_SIZE_DEFAULT     8192
 
 static GMainLoop *main_loop = NULL;
 static gboolean configure_and_quit = FALSE;
@@ -67,6 +76,8 @@ static struct {
 	gboolean become_daemon;
 	gboolean g_fatal_warnings;
 	gboolean run_from_build_dir;
+	gboolean profile_startup;
+	int fake_platform_links;
 	char *opt_log_level;
 	char *opt_log_domains;
 	char *pidfile;
@@ -116,6 +127,22 @@ _init_nm_debug (const char *debug)
 void
 nm_main_config_reload (int signal)
 {
+	if (signal == SIGUSR2 && nm_logging_ring_enabled ()) {
+		int fd;
+
+		/* the recorded messages may be more verbose than what the
+		 * journal gets. Only root may read them. */
+		fd = open (NM_LOG_RING_FILE, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+		if (fd >= 0) {
+			nm_logging_ring_dump_fd (fd);
+			close (fd);
+			nm_log_info (LOGD_CORE, "logging: flight recorder written to %s", NM_LOG_RING_FILE);
+		} else {
+			nm_log_warn (LOGD_CORE, "logging: failed to write flight recorder to %s: %s",
+			             NM_LOG_RING_FILE, strerror (errno));
+		}
+	}
+
 	nm_log_info (LOGD_CORE, "reload configuration (signal %s)...", strsignal (signal));
 	/* The signal handler thread is only installed after
 	 * creating NMConfig instance, and on shut down we
@@ -134,6 +161,69 @@ manager_configure_quit (NMManager *manager, gpointer user_data)
 	configure_and_quit = TRUE;
 }
 
+static void
+setup_log_rate_limit (NMConfig *config)
+{
+	const char *domain_rate;
+	const char *callsite_rate;
+
+	domain_rate = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                               NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                               NM_CONFIG_KEYFILE_KEY_LOGGING_RATE_LIMIT,
+	                                               NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	callsite_rate = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                 NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                                 NM_CONFIG_KEYFILE_KEY_LOGGING_RATE_LIMIT_CALLSITE,
+	                                                 NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	if (!domain_rate && !callsite_rate)
+		return;
+
+	nm_logging_rate_limit_setup (_nm_utils_ascii_str_to_int64 (domain_rate, 10, 0, G_MAXUINT32, 0),
+	                             _nm_utils_ascii_str_to_int64 (callsite_rate, 10, 0, G_MAXUINT32, 0));
+}
+
+static void
+setup_log_ring (NMConfig *config)
+{
+	const char *level;
+	const char *size;
+	gs_free_error GError *error = NULL;
+
+	level = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                         NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                         NM_CONFIG_KEYFILE_KEY_LOGGING_RING_LEVEL,
+	                                         NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	if (!level)
+		return;
+
+	size = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                        NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                        NM_CONFIG_KEYFILE_KEY_LOGGING_RING_SIZE,
+	                                        NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+
+	if (!nm_logging_ring_setup (level,
+	                            _nm_utils_ascii_str_to_int64 (size, 10, 1, 1 << 20, NM_LOG_RING_SIZE_DEFAULT),
+	                            &error))
+		nm_log_warn (LOGD_CORE, "logging: invalid ring-level: %s", error->message);
+}
+
+static void
+setup_watchdog (void)
+{
+	const char *value;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_WATCHDOG_THRESHOLD,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	nm_watchdog_start (_nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXUINT32 / 1000,
+	                                                 NM_WATCHDOG_THRESHOLD_DEFAULT),
+	                   nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA_ORIG,
+	                                                     NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                     NM_CONFIG_KEYFILE_KEY_MAIN_WATCHDOG_BACKTRACE,
+	                                                     FALSE));
+}
+
 static int
 print_config (NMConfigCmdLineOptions *config_cli)
 {
@@ -169,6 +259,9 @@ do_early_setup (int *argc, char **argv[], NMConfigCmdLineOptions *config_cli)
 		{ "pid-file", 'p', 0, G_OPTION_ARG_FILENAME, &global_opt.pidfile, N_("Specify the location of a PID file"), N_(NM_DEFAULT_PID_FILE) },
 		{ "run-from-build-dir", 0, 0, G_OPTION_ARG_NONE, &global_opt.run_from_build_dir, "Run from build directory", NULL },
 		{ "print-config", 0, 0, G_OPTION_ARG_NONE, &global_opt.print_config, N_("Print NetworkManager configuration and exit"), NULL },
+		{ "profile-startup", 0, 0, G_OPTION_ARG_NONE, &global_opt.profile_startup, N_("Log the duration of the startup phases and write a trace to " NM_STARTUP_PROFILE_TRACE_FILE), NULL },
+		/* for tools/run-simulation.py only */
+		{ "fake-platform", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_INT, &global_opt.fake_platform_links, "Manage N simulated ethernet links instead of the kernel's", "N" },
 		{NULL}
 	};
 
@@ -198,6 +291,9 @@ main (int argc, char *argv[])
 	char *bad_domains = NULL;
 	NMConfigCmdLineOptions *config_cli;
 	guint sd_id = 0;
+	gint64 start_ts, ts;
+
+	start_ts = g_get_monotonic_time ();
 
 	nm_g_type_init ();
 
@@ -276,6 +372,7 @@ main (int argc, char *argv[])
 	}
 
 	/* Read the config file and CLI overrides */
+	ts = g_get_monotonic_time ();
 	config = nm_config_setup (config_cli, NULL, &error);
 	nm_config_cmd_line_options_free (config_cli);
 	config_cli = NULL;
@@ -287,6 +384,15 @@ main (int argc, char *argv[])
 
 	_init_nm_debug (nm_config_get_debug (config));
 
+	if (   global_opt.profile_startup
+	    || nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA_ORIG,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_PROFILE_STARTUP,
+	                                         FALSE)) {
+		nm_startup_profile_enable (start_ts);
+		nm_startup_profile_end (ts, "config-read", NULL);
+	}
+
 	/* Initialize logging from config file *only* if not explicitly
 	 * specified by commandline.
 	 */
@@ -329,6 +435,9 @@ main (int argc, char *argv[])
 	                                                              NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND,
 	                                                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY));
 
+	setup_log_rate_limit (config);
+	setup_log_ring (config);
+
 	nm_log_info (LOGD_CORE, "NetworkManager (version " NM_DIST_VERSION ") is starting...");
 
 	nm_log_info (LOGD_CORE, "Read config: %s", nm_config_data_get_config_description (nm_config_get_data (config)));
@@ -360,18 +469,29 @@ main (int argc, char *argv[])
 	}
 
 	/* Set up platform interaction layer */
-	nm_linux_platform_setup ();
+	ts = nm_startup_profile_begin ();
+	if (global_opt.fake_platform_links > 0) {
+		nm_log_warn (LOGD_CORE, "simulating %d ethernet links on a fake platform",
+		             global_opt.fake_platform_links);
+		nm_fake_platform_setup_simulation (global_opt.fake_platform_links);
+	} else
+		nm_linux_platform_setup ();
+	nm_startup_profile_end (ts, "platform-setup", NULL);
 
 	NM_UTILS_KEEP_ALIVE (config, NM_PLATFORM_GET, "NMConfig-depends-on-NMPlatform");
 
 	nm_dispatcher_init ();
 
+	NM_UTILS_KEEP_ALIVE (nm_statistics_get (), NM_PLATFORM_GET, "NMStatistics-depends-on-NMPlatform");
+
 	g_signal_connect (nm_manager_get (), NM_MANAGER_CONFIGURE_QUIT, G_CALLBACK (manager_configure_quit), config);
 
+	ts = nm_startup_profile_begin ();
 	if (!nm_manager_start (nm_manager_get (), &error)) {
 		nm_log_err (LOGD_CORE, "failed to initialize: %s", error->message);
 		goto done;
 	}
+	nm_startup_profile_end (ts, "manager-start", NULL);
 
 	/* Make sure the loopback interface is up. If interface is down, we bring
 	 * it up and kernel will assign it link-local IPv4 and IPv6 addresses. If
@@ -391,7 +511,9 @@ main (int argc, char *argv[])
 	if (configure_and_quit == FALSE) {
 		sd_id = nm_sd_event_attach_default ();
 
+		setup_watchdog ();
 		g_main_loop_run (main_loop);
+		nm_watchdog_stop ();
 	}
 
 done:
@@ -399,8 +521,13 @@ done:
 
 	nm_manager_stop (nm_manager_get ());
 
+	nm_settings_connection_flush_databases ();
 	nm_config_state_set (config, TRUE, TRUE);
 
+	/* complete pending writes, like of resolv.conf or the intern config */
+	nm_executor_flush ();
+	nm_settings_write_sync ();
+
 	if (global_opt.pidfile && wrote_pidfile)
 		unlink (global_opt.pidfile);
 
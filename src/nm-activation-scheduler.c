@@ -0,0 +1,398 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-activation-scheduler.h"
+
+#include "nm-device.h"
+#include "NetworkManagerUtils.h"
+
+/* The scheduler limits how many devices are in stage 3 (IP configuration)
+ * at the same time. When many devices become ready at once, starting DHCP,
+ * DAD and firewall calls for all of them together only makes them time out.
+ * A device first requests a slot; the start function is invoked right away
+ * if one is free, or once a slot gets released otherwise. Waiting devices
+ * are admitted by priority, then in request order.
+ *
+ * A device that has nothing running, like a master waiting for its slaves,
+ * must not hold a slot: it releases it and requests it again once it can
+ * go on. */
+
+typedef struct {
+	/* the device, or in the unit tests any GObject */
+	GObject *device;
+	char *name;
+	NMActivationSchedulerStartFunc start_func;
+	int priority;
+	guint64 seq;
+	gint64 requested_at;
+	gboolean running;
+} Entry;
+
+typedef struct {
+	/* NMDevice -> Entry, both for queued and running devices */
+	GHashTable *entries;
+	/* the queued entries, sorted by _entry_cmp() */
+	GQueue queue;
+	guint running;
+	guint max_concurrent;
+	guint64 seq;
+	guint wait_time;
+} NMActivationSchedulerPrivate;
+
+struct _NMActivationScheduler {
+	GObject parent;
+	NMActivationSchedulerPrivate _priv;
+};
+
+struct _NMActivationSchedulerClass {
+	GObjectClass parent;
+};
+
+G_DEFINE_TYPE (NMActivationScheduler, nm_activation_scheduler, G_TYPE_OBJECT)
+
+#define NM_ACTIVATION_SCHEDULER_GET_PRIVATE(self) \
+	({ \
+		NMActivationScheduler *_self = (self); \
+		\
+		nm_assert (NM_IS_ACTIVATION_SCHEDULER (_self)); \
+		&_self->_priv; \
+	})
+
+NM_GOBJECT_PROPERTIES_DEFINE (NMActivationScheduler,
+	PROP_QUEUE_DEPTH,
+	PROP_WAIT_TIME,
+);
+
+NM_DEFINE_SINGLETON_GETTER (NMActivationScheduler, nm_activation_scheduler_get, NM_TYPE_ACTIVATION_SCHEDULER);
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN         LOGD_DEVICE
+#define _NMLOG_PREFIX_NAME    "activation-scheduler"
+#define _NMLOG(level, ...) \
+    G_STMT_START { \
+        nm_log ((level), _NMLOG_DOMAIN, \
+                "%s: " _NM_UTILS_MACRO_FIRST (__VA_ARGS__), \
+                _NMLOG_PREFIX_NAME \
+                _NM_UTILS_MACRO_REST (__VA_ARGS__)); \
+    } G_STMT_END
+
+/*****************************************************************************/
+
+static gint
+_entry_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const Entry *ea = a;
+	const Entry *eb = b;
+
+	if (ea->priority != eb->priority)
+		return ea->priority > eb->priority ? -1 : 1;
+	if (ea->seq != eb->seq)
+		return ea->seq < eb->seq ? -1 : 1;
+	return 0;
+}
+
+static void
+_entry_free (gpointer data)
+{
+	Entry *entry = data;
+
+	g_object_unref (entry->device);
+	g_free (entry->name);
+	g_slice_free (Entry, entry);
+}
+
+static void
+_start (NMActivationScheduler *self, Entry *entry)
+{
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+	gint64 waited;
+
+	nm_assert (!entry->running);
+
+	entry->running = TRUE;
+	priv->running++;
+
+	waited = nm_utils_get_monotonic_timestamp_ms () - entry->requested_at;
+	waited = CLAMP (waited, 0, G_MAXUINT32);
+	if (priv->wait_time != waited) {
+		priv->wait_time = waited;
+		_notify (self, PROP_WAIT_TIME);
+	}
+
+	_LOGD ("start %s after %u ms (priority %d, %u running)",
+	       entry->name, (guint) waited,
+	       entry->priority, priv->running);
+
+	entry->start_func ((NMDevice *) entry->device);
+}
+
+static void
+_dispatch (NMActivationScheduler *self)
+{
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+	gboolean changed = FALSE;
+	Entry *entry;
+
+	while (   priv->queue.length > 0
+	       && (   priv->max_concurrent == 0
+	           || priv->running < priv->max_concurrent)) {
+		entry = g_queue_pop_head (&priv->queue);
+		changed = TRUE;
+		_start (self, entry);
+	}
+
+	if (changed)
+		_notify (self, PROP_QUEUE_DEPTH);
+}
+
+/**
+ * nm_activation_scheduler_request:
+ * @self: the #NMActivationScheduler
+ * @device: the device that wants to start IP configuration
+ * @priority: devices with a higher priority are started first
+ * @start_func: invoked once @device may proceed
+ *
+ * Requests a slot for @device. @start_func is called synchronously if
+ * a slot is free or @device already holds one. Otherwise @device is queued,
+ * and a repeated request only updates @priority and @start_func.
+ * The slot is held until nm_activation_scheduler_release().
+ */
+void
+nm_activation_scheduler_request (NMActivationScheduler *self,
+                                 NMDevice *device,
+                                 int priority,
+                                 NMActivationSchedulerStartFunc start_func)
+{
+	g_return_if_fail (NM_IS_DEVICE (device));
+
+	_nm_activation_scheduler_request (self, G_OBJECT (device), nm_device_get_iface (device),
+	                                  priority, start_func);
+}
+
+void
+_nm_activation_scheduler_request (NMActivationScheduler *self,
+                                  GObject *device,
+                                  const char *name,
+                                  int priority,
+                                  NMActivationSchedulerStartFunc start_func)
+{
+	NMActivationSchedulerPrivate *priv;
+	Entry *entry;
+
+	g_return_if_fail (NM_IS_ACTIVATION_SCHEDULER (self));
+	g_return_if_fail (G_IS_OBJECT (device));
+	g_return_if_fail (start_func);
+
+	priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	entry = g_hash_table_lookup (priv->entries, device);
+	if (entry) {
+		entry->start_func = start_func;
+		if (entry->running) {
+			start_func ((NMDevice *) device);
+			return;
+		}
+		if (entry->priority != priority) {
+			entry->priority = priority;
+			g_queue_remove (&priv->queue, entry);
+			g_queue_insert_sorted (&priv->queue, entry, _entry_cmp, NULL);
+		}
+		return;
+	}
+
+	entry = g_slice_new0 (Entry);
+	entry->device = g_object_ref (device);
+	entry->name = g_strdup (name);
+	entry->start_func = start_func;
+	entry->priority = priority;
+	entry->seq = ++priv->seq;
+	entry->requested_at = nm_utils_get_monotonic_timestamp_ms ();
+	g_hash_table_insert (priv->entries, device, entry);
+
+	if (   priv->max_concurrent == 0
+	    || priv->running < priv->max_concurrent) {
+		_start (self, entry);
+		return;
+	}
+
+	/* new entries have the highest sequence number, so they
+	 * end up behind all queued entries of the same priority. */
+	g_queue_insert_sorted (&priv->queue, entry, _entry_cmp, NULL);
+	_LOGD ("queue %s (priority %d, %u waiting)",
+	       entry->name, priority, priv->queue.length);
+	_notify (self, PROP_QUEUE_DEPTH);
+}
+
+/**
+ * nm_activation_scheduler_release:
+ * @self: the #NMActivationScheduler
+ * @device: the device
+ *
+ * Gives up the slot of @device, or removes it from the queue. Does
+ * nothing if @device has no pending request.
+ */
+void
+nm_activation_scheduler_release (NMActivationScheduler *self,
+                                 NMDevice *device)
+{
+	NMActivationSchedulerPrivate *priv;
+	Entry *entry;
+
+	g_return_if_fail (NM_IS_ACTIVATION_SCHEDULER (self));
+
+	priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	entry = g_hash_table_lookup (priv->entries, device);
+	if (!entry)
+		return;
+
+	if (entry->running) {
+		nm_assert (priv->running > 0);
+		priv->running--;
+		g_hash_table_remove (priv->entries, device);
+		_dispatch (self);
+	} else {
+		g_queue_remove (&priv->queue, entry);
+		g_hash_table_remove (priv->entries, device);
+		_notify (self, PROP_QUEUE_DEPTH);
+	}
+}
+
+/**
+ * nm_activation_scheduler_set_max_concurrent:
+ * @self: the #NMActivationScheduler
+ * @max_concurrent: the number of devices allowed in IP configuration,
+ *   or 0 for no limit
+ */
+void
+nm_activation_scheduler_set_max_concurrent (NMActivationScheduler *self,
+                                            guint max_concurrent)
+{
+	NMActivationSchedulerPrivate *priv;
+
+	g_return_if_fail (NM_IS_ACTIVATION_SCHEDULER (self));
+
+	priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	if (priv->max_concurrent == max_concurrent)
+		return;
+	priv->max_concurrent = max_concurrent;
+	_dispatch (self);
+}
+
+guint
+nm_activation_scheduler_get_queue_depth (NMActivationScheduler *self)
+{
+	g_return_val_if_fail (NM_IS_ACTIVATION_SCHEDULER (self), 0);
+
+	return NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self)->queue.length;
+}
+
+guint
+nm_activation_scheduler_get_wait_time (NMActivationScheduler *self)
+{
+	g_return_val_if_fail (NM_IS_ACTIVATION_SCHEDULER (self), 0);
+
+	return NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self)->wait_time;
+}
+
+/*****************************************************************************/
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	NMActivationScheduler *self = NM_ACTIVATION_SCHEDULER (object);
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	switch (prop_id) {
+	case PROP_QUEUE_DEPTH:
+		g_value_set_uint (value, priv->queue.length);
+		break;
+	case PROP_WAIT_TIME:
+		g_value_set_uint (value, priv->wait_time);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+nm_activation_scheduler_init (NMActivationScheduler *self)
+{
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	priv->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, _entry_free);
+	g_queue_init (&priv->queue);
+	priv->max_concurrent = NM_ACTIVATION_SCHEDULER_MAX_CONCURRENT_DEFAULT;
+}
+
+static void
+dispose (GObject *object)
+{
+	NMActivationScheduler *self = NM_ACTIVATION_SCHEDULER (object);
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	g_queue_clear (&priv->queue);
+	priv->running = 0;
+	if (priv->entries)
+		g_hash_table_remove_all (priv->entries);
+
+	G_OBJECT_CLASS (nm_activation_scheduler_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMActivationScheduler *self = NM_ACTIVATION_SCHEDULER (object);
+	NMActivationSchedulerPrivate *priv = NM_ACTIVATION_SCHEDULER_GET_PRIVATE (self);
+
+	g_hash_table_unref (priv->entries);
+
+	G_OBJECT_CLASS (nm_activation_scheduler_parent_class)->finalize (object);
+}
+
+static void
+nm_activation_scheduler_class_init (NMActivationSchedulerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->get_property = get_property;
+	object_class->dispose = dispose;
+	object_class->finalize = finalize;
+
+	obj_properties[PROP_QUEUE_DEPTH] =
+	    g_param_spec_uint (NM_ACTIVATION_SCHEDULER_QUEUE_DEPTH, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	obj_properties[PROP_WAIT_TIME] =
+	    g_param_spec_uint (NM_ACTIVATION_SCHEDULER_WAIT_TIME, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
+}
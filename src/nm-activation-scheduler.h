@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_ACTIVATION_SCHEDULER_H__
+#define __NETWORKMANAGER_ACTIVATION_SCHEDULER_H__
+
+#include "nm-default.h"
+
+#define NM_TYPE_ACTIVATION_SCHEDULER            (nm_activation_scheduler_get_type ())
+#define NM_ACTIVATION_SCHEDULER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_ACTIVATION_SCHEDULER, NMActivationScheduler))
+#define NM_ACTIVATION_SCHEDULER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_ACTIVATION_SCHEDULER, NMActivationSchedulerClass))
+#define NM_IS_ACTIVATION_SCHEDULER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_ACTIVATION_SCHEDULER))
+#define NM_IS_ACTIVATION_SCHEDULER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_ACTIVATION_SCHEDULER))
+#define NM_ACTIVATION_SCHEDULER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_ACTIVATION_SCHEDULER, NMActivationSchedulerClass))
+
+#define NM_ACTIVATION_SCHEDULER_QUEUE_DEPTH "queue-depth"
+#define NM_ACTIVATION_SCHEDULER_WAIT_TIME   "wait-time"
+
+/* default for the main.activation-max-concurrent configuration option */
+#define NM_ACTIVATION_SCHEDULER_MAX_CONCURRENT_DEFAULT 32
+
+typedef struct _NMActivationSchedulerClass NMActivationSchedulerClass;
+
+typedef void (*NMActivationSchedulerStartFunc) (NMDevice *device);
+
+GType nm_activation_scheduler_get_type (void);
+
+NMActivationScheduler *nm_activation_scheduler_get (void);
+
+void nm_activation_scheduler_request (NMActivationScheduler *self,
+                                      NMDevice *device,
+                                      int priority,
+                                      NMActivationSchedulerStartFunc start_func);
+void nm_activation_scheduler_release (NMActivationScheduler *self,
+                                      NMDevice *device);
+
+void nm_activation_scheduler_set_max_concurrent (NMActivationScheduler *self,
+                                                 guint max_concurrent);
+
+guint nm_activation_scheduler_get_queue_depth (NMActivationScheduler *self);
+guint nm_activation_scheduler_get_wait_time (NMActivationScheduler *self);
+
+/* exposed for the unit tests, which have no devices */
+void _nm_activation_scheduler_request (NMActivationScheduler *self,
+                                       GObject *device,
+                                       const char *name,
+                                       int priority,
+                                       NMActivationSchedulerStartFunc start_func);
+
+#endif  /* __NETWORKMANAGER_ACTIVATION_SCHEDULER_H__ */
@@ -63,6 +63,12 @@ typedef struct {
 
 	gboolean assumed;
 
+	struct {
+		gint64 start_us;
+		GArray *entries;
+		bool finished;
+	} timeline;
+
 	NMAuthChain *chain;
 	const char *wifi_shared_permission;
 	NMActiveConnectionAuthResultFunc result_func;
@@ -86,6 +92,7 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMActiveConnection,
 	PROP_DHCP6_CONFIG,
 	PROP_VPN,
 	PROP_MASTER,
+	PROP_TIMELINE,
 
 	PROP_INT_SETTINGS_CONNECTION,
 	PROP_INT_DEVICE,
@@ -353,6 +360,135 @@ nm_active_connection_clear_secrets (NMActiveConnection *self)
 
 /*******************************************************************/
 
+typedef struct {
+	char *event;
+	gint64 timestamp_us;
+} TimelineEntry;
+
+static void
+_timeline_entry_clear (gpointer data)
+{
+	g_free (((TimelineEntry *) data)->event);
+}
+
+/* more entries than that mean that something loops */
+#define TIMELINE_MAX_ENTRIES 256
+
+/**
+ * nm_active_connection_timeline_add:
+ * @self: the #NMActiveConnection
+ * @event: the kind of the step, like "state" or "dhcp4"
+ * @detail: (allow-none): what happened, like "ip-config" or "lease"
+ *
+ * Records the monotonic time at which a step of the activation happened.
+ * Does nothing after nm_active_connection_timeline_finish().
+ */
+void
+nm_active_connection_timeline_add (NMActiveConnection *self,
+                                   const char *event,
+                                   const char *detail)
+{
+	NMActiveConnectionPrivate *priv;
+	TimelineEntry entry;
+
+	g_return_if_fail (NM_IS_ACTIVE_CONNECTION (self));
+	g_return_if_fail (event);
+
+	priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+
+	if (priv->timeline.finished)
+		return;
+	if (!priv->timeline.entries) {
+		priv->timeline.entries = g_array_new (FALSE, FALSE, sizeof (TimelineEntry));
+		g_array_set_clear_func (priv->timeline.entries, _timeline_entry_clear);
+	} else if (priv->timeline.entries->len >= TIMELINE_MAX_ENTRIES)
+		return;
+
+	entry.event = detail ? g_strconcat (event, ":", detail, NULL) : g_strdup (event);
+	entry.timestamp_us = g_get_monotonic_time ();
+	g_array_append_val (priv->timeline.entries, entry);
+
+	_notify (self, PROP_TIMELINE);
+}
+
+/**
+ * nm_active_connection_timeline_finish:
+ * @self: the #NMActiveConnection
+ *
+ * Stops the recording of the timeline, once the activation completed
+ * or failed.
+ *
+ * Returns: %TRUE if the timeline was still being recorded.
+ */
+gboolean
+nm_active_connection_timeline_finish (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (self), FALSE);
+
+	priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+
+	if (priv->timeline.finished)
+		return FALSE;
+	priv->timeline.finished = TRUE;
+	return TRUE;
+}
+
+/**
+ * nm_active_connection_timeline_to_string:
+ * @self: the #NMActiveConnection
+ *
+ * Returns: the timeline for logging, with the milliseconds of each
+ *   step since the activation was requested. Free with g_free().
+ */
+char *
+nm_active_connection_timeline_to_string (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv;
+	GString *str;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (self), NULL);
+
+	priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+
+	str = g_string_new (NULL);
+	for (i = 0; priv->timeline.entries && i < priv->timeline.entries->len; i++) {
+		const TimelineEntry *entry = &g_array_index (priv->timeline.entries, TimelineEntry, i);
+		gint64 usec = entry->timestamp_us - priv->timeline.start_us;
+
+		g_string_append_printf (str, "%s%s +%"G_GINT64_FORMAT".%03d",
+		                        i ? ", " : "",
+		                        entry->event,
+		                        usec / 1000,
+		                        (int) ((usec % 1000)));
+	}
+	if (!str->len)
+		g_string_append (str, "(empty)");
+	return g_string_free (str, FALSE);
+}
+
+static GVariant *
+_timeline_to_variant (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(st)"));
+	for (i = 0; priv->timeline.entries && i < priv->timeline.entries->len; i++) {
+		const TimelineEntry *entry = &g_array_index (priv->timeline.entries, TimelineEntry, i);
+
+		g_variant_builder_add (&builder, "(st)",
+		                       entry->event,
+		                       (guint64) (entry->timestamp_us - priv->timeline.start_us));
+	}
+	return g_variant_builder_end (&builder);
+}
+
+/*******************************************************************/
+
 const char *
 nm_active_connection_get_specific_object (NMActiveConnection *self)
 {
@@ -938,6 +1074,7 @@ nm_active_connection_init (NMActiveConnection *self)
 	_LOGT ("creating");
 
 	priv->version_id = _version_id_new ();
+	priv->timeline.start_us = g_get_monotonic_time ();
 }
 
 static void
@@ -1073,6 +1210,9 @@ get_property (GObject *object, guint prop_id,
 			master_device = nm_active_connection_get_device (priv->master);
 		nm_utils_g_value_set_object_path (value, master_device);
 		break;
+	case PROP_TIMELINE:
+		g_value_take_variant (value, _timeline_to_variant (NM_ACTIVE_CONNECTION (object)));
+		break;
 	case PROP_INT_SUBJECT:
 		g_value_set_object (value, priv->subject);
 		break;
@@ -1137,6 +1277,8 @@ dispose (GObject *object)
 
 	g_clear_object (&priv->subject);
 
+	g_clear_pointer (&priv->timeline.entries, g_array_unref);
+
 	G_OBJECT_CLASS (nm_active_connection_parent_class)->dispose (object);
 }
 
@@ -1249,6 +1391,13 @@ nm_active_connection_class_init (NMActiveConnectionClass *ac_class)
 	                          G_PARAM_READABLE |
 	                          G_PARAM_STATIC_STRINGS);
 
+	obj_properties[PROP_TIMELINE] =
+	     g_param_spec_variant (NM_ACTIVE_CONNECTION_TIMELINE, "", "",
+	                           G_VARIANT_TYPE ("a(st)"),
+	                           NULL,
+	                           G_PARAM_READABLE |
+	                           G_PARAM_STATIC_STRINGS);
+
 	/* Internal properties */
 	obj_properties[PROP_INT_SETTINGS_CONNECTION] =
 	     g_param_spec_object (NM_ACTIVE_CONNECTION_INT_SETTINGS_CONNECTION, "", "",
@@ -47,6 +47,7 @@
 #define NM_ACTIVE_CONNECTION_DHCP6_CONFIG    "dhcp6-config"
 #define NM_ACTIVE_CONNECTION_VPN             "vpn"
 #define NM_ACTIVE_CONNECTION_MASTER          "master"
+#define NM_ACTIVE_CONNECTION_TIMELINE        "timeline"
 
 /* Internal non-exported properties */
 #define NM_ACTIVE_CONNECTION_INT_SETTINGS_CONNECTION "int-settings-connection"
@@ -161,4 +162,12 @@ gboolean      nm_active_connection_get_assumed (NMActiveConnection *self);
 
 void          nm_active_connection_clear_secrets (NMActiveConnection *self);
 
+void          nm_active_connection_timeline_add (NMActiveConnection *self,
+                                                 const char *event,
+                                                 const char *detail);
+
+gboolean      nm_active_connection_timeline_finish (NMActiveConnection *self);
+
+char *        nm_active_connection_timeline_to_string (NMActiveConnection *self);
+
 #endif /* __NETWORKMANAGER_ACTIVE_CONNECTION_H__ */
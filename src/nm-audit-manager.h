@@ -62,6 +62,7 @@ typedef struct {
 #define NM_AUDIT_OP_DEVICE_DELETE           "device-delete"
 #define NM_AUDIT_OP_DEVICE_MANAGED          "device-managed"
 #define NM_AUDIT_OP_DEVICE_REAPPLY          "device-reapply"
+#define NM_AUDIT_OP_STATISTICS              "statistics"
 
 GType nm_audit_manager_get_type (void);
 NMAuditManager *nm_audit_manager_get (void);
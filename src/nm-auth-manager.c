@@ -25,17 +25,22 @@
 #include "nm-errors.h"
 #include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
+#include "nm-session-monitor.h"
 
 #define POLKIT_SERVICE                      "org.freedesktop.PolicyKit1"
 #define POLKIT_OBJECT_PATH                  "/org/freedesktop/PolicyKit1/Authority"
 #define POLKIT_INTERFACE                    "org.freedesktop.PolicyKit1.Authority"
 
+/* how long a polkit decision is reused for the same subject and action */
+#define DECISION_CACHE_TTL_USEC             (5 * G_USEC_PER_SEC)
+#define DECISION_CACHE_MAX                  1024
+
 
 #define _NMLOG_PREFIX_NAME    "auth"
 #define _NMLOG_DOMAIN         LOGD_CORE
 #define _NMLOG(level, ...) \
     G_STMT_START { \
-        if (nm_logging_enabled ((level), (_NMLOG_DOMAIN))) { \
+        if (_nm_logging_wanted ((level), (_NMLOG_DOMAIN))) { \
             char __prefix[30] = _NMLOG_PREFIX_NAME; \
             \
             if ((self) != singleton_instance) \
@@ -68,6 +73,16 @@ typedef struct {
 	GCancellable *new_proxy_cancellable;
 	GSList *queued_calls;
 	GDBusProxy *proxy;
+
+	/* "subject|action|flags" -> CachedDecision */
+	GHashTable *decisions;
+	/* "subject|action|flags" -> CheckAuthData, for the calls that are
+	 * in progress and can be joined by identical requests. */
+	GHashTable *in_flight;
+	/* bumped when the cache is flushed, so that calls that were in
+	 * flight meanwhile don't add stale results. */
+	guint decisions_generation;
+	NMSessionMonitor *session_monitor;
 #endif
 } NMAuthManagerPrivate;
 
@@ -96,27 +111,222 @@ typedef enum {
 	POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION = (1<<0),
 } PolkitCheckAuthorizationFlags;
 
+typedef struct {
+	GSimpleAsyncResult *simple;
+	GCancellable *cancellable;
+	gulong cancelled_id;
+} CheckAuthWaiter;
+
 typedef struct {
 	guint call_id;
 	NMAuthManager *self;
-	GSimpleAsyncResult *simple;
+	/* the requests waiting for the result of this call. The first one
+	 * started the call, the others joined it. */
+	GSList *waiters;
+	guint n_uncancelled;
 	gchar *cancellation_id;
 	GVariant *dbus_parameters;
+	/* private to the call, and cancelled only after all waiters cancelled */
 	GCancellable *cancellable;
+	char *decision_key;
+	guint decisions_generation;
+	/* the check may show an authentication dialog */
+	gboolean interactive;
 } CheckAuthData;
 
+typedef struct {
+	gboolean is_authorized;
+	gboolean is_challenge;
+} CheckAuthorizationResult;
+
+typedef struct {
+	CheckAuthorizationResult result;
+	gint64 expires_at;
+} CachedDecision;
+
 static void
 _check_auth_data_free (CheckAuthData *data)
 {
+	nm_assert (!data->waiters);
+
 	if (data->dbus_parameters)
 		g_variant_unref (data->dbus_parameters);
 	g_object_unref (data->self);
-	g_object_unref (data->simple);
 	g_clear_object (&data->cancellable);
 	g_free (data->cancellation_id);
+	g_free (data->decision_key);
 	g_free (data);
 }
 
+static void
+_check_auth_waiter_cancelled_cb (GCancellable *cancellable, gpointer user_data)
+{
+	CheckAuthData *data = user_data;
+
+	nm_assert (data->n_uncancelled > 0);
+
+	/* the D-Bus call is only aborted when nobody is interested in
+	 * the result anymore. */
+	if (--data->n_uncancelled == 0 && data->cancellable)
+		g_cancellable_cancel (data->cancellable);
+}
+
+static void
+_check_auth_data_add_waiter (CheckAuthData *data,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+	CheckAuthWaiter *waiter;
+
+	waiter = g_slice_new0 (CheckAuthWaiter);
+	waiter->simple = g_simple_async_result_new (G_OBJECT (data->self),
+	                                            callback,
+	                                            user_data,
+	                                            nm_auth_manager_polkit_authority_check_authorization);
+	data->waiters = g_slist_append (data->waiters, waiter);
+	data->n_uncancelled++;
+
+	if (cancellable) {
+		waiter->cancellable = g_object_ref (cancellable);
+		waiter->cancelled_id = g_cancellable_connect (cancellable,
+		                                              G_CALLBACK (_check_auth_waiter_cancelled_cb),
+		                                              data,
+		                                              NULL);
+	} else if (data->cancellable) {
+		/* this waiter can't be cancelled, so neither can the call */
+		g_clear_object (&data->cancellable);
+	}
+}
+
+/* completes all waiters of @data and frees it. Either @result or
+ * @error_message must be given. */
+static void
+_check_auth_data_complete (CheckAuthData *data,
+                           const CheckAuthorizationResult *result,
+                           const char *error_message,
+                           gboolean in_idle)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (data->self);
+	GSList *waiters;
+
+	if (   priv->in_flight
+	    && g_hash_table_lookup (priv->in_flight, data->decision_key) == data)
+		g_hash_table_remove (priv->in_flight, data->decision_key);
+
+	/* the callbacks might start new checks. Detach the waiters first. */
+	waiters = g_steal_pointer (&data->waiters);
+	while (waiters) {
+		CheckAuthWaiter *waiter = waiters->data;
+
+		waiters = g_slist_delete_link (waiters, waiters);
+
+		if (waiter->cancellable) {
+			g_cancellable_disconnect (waiter->cancellable, waiter->cancelled_id);
+			g_object_unref (waiter->cancellable);
+		}
+
+		if (result) {
+			g_simple_async_result_set_op_res_gpointer (waiter->simple,
+			                                           g_memdup (result, sizeof (*result)),
+			                                           g_free);
+		} else {
+			g_simple_async_result_set_error (waiter->simple,
+			                                 NM_MANAGER_ERROR,
+			                                 NM_MANAGER_ERROR_FAILED,
+			                                 "Authorization check failed: %s",
+			                                 error_message);
+		}
+
+		if (in_idle)
+			g_simple_async_result_complete_in_idle (waiter->simple);
+		else
+			g_simple_async_result_complete (waiter->simple);
+		g_object_unref (waiter->simple);
+		g_slice_free (CheckAuthWaiter, waiter);
+	}
+
+	_check_auth_data_free (data);
+}
+
+/*****************************************************************************/
+
+/* Clients like applets call GetPermissions often, which checks every
+ * permission, and scripts may issue many authorized calls in a row. Polkit's
+ * answers are reused for a short time; the cache is flushed whenever polkit
+ * or the session monitor signal a change.
+ *
+ * The answer to an interactive check is only reused if polkit retains the
+ * authorization. Otherwise a one-shot auth_admin challenge would grant the
+ * repeated actions within the cache lifetime. */
+
+static void
+_decisions_flush (NMAuthManager *self)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	priv->decisions_generation++;
+
+	/* calls in progress might give outdated answers. Let them finish,
+	 * but don't let new requests join them. */
+	if (priv->in_flight)
+		g_hash_table_remove_all (priv->in_flight);
+
+	if (priv->decisions && g_hash_table_size (priv->decisions)) {
+		_LOGT ("flush %u cached decisions", g_hash_table_size (priv->decisions));
+		g_hash_table_remove_all (priv->decisions);
+	}
+}
+
+static const CheckAuthorizationResult *
+_decisions_lookup (NMAuthManager *self, const char *key)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CachedDecision *decision;
+
+	if (!priv->decisions)
+		return NULL;
+
+	decision = g_hash_table_lookup (priv->decisions, key);
+	if (!decision)
+		return NULL;
+	if (decision->expires_at <= g_get_monotonic_time ()) {
+		g_hash_table_remove (priv->decisions, key);
+		return NULL;
+	}
+	return &decision->result;
+}
+
+static void
+_decisions_add (CheckAuthData *data, const CheckAuthorizationResult *result, gboolean retained)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (data->self);
+	CachedDecision *decision;
+
+	if (data->decisions_generation != priv->decisions_generation)
+		return;
+	if (data->interactive && !(result->is_authorized && retained))
+		return;
+
+	if (!priv->decisions)
+		priv->decisions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	else if (g_hash_table_size (priv->decisions) >= DECISION_CACHE_MAX)
+		g_hash_table_remove_all (priv->decisions);
+
+	decision = g_new (CachedDecision, 1);
+	decision->result = *result;
+	decision->expires_at = g_get_monotonic_time () + DECISION_CACHE_TTL_USEC;
+	g_hash_table_insert (priv->decisions, g_strdup (data->decision_key), decision);
+}
+
+static void
+_session_monitor_changed_cb (NMSessionMonitor *monitor, gpointer user_data)
+{
+	_decisions_flush (user_data);
+}
+
+/*****************************************************************************/
+
 static void
 _call_check_authorization_complete_with_error (CheckAuthData *data,
                                                const char *error_message)
@@ -124,15 +334,7 @@ _call_check_authorization_complete_with_error (CheckAuthData *data,
 	NMAuthManager *self = data->self;
 
 	_LOGD ("call[%u]: CheckAuthorization failed due to internal error: %s", data->call_id, error_message);
-	g_simple_async_result_set_error (data->simple,
-	                                 NM_MANAGER_ERROR,
-	                                 NM_MANAGER_ERROR_FAILED,
-	                                 "Authorization check failed: %s",
-	                                 error_message);
-
-	g_simple_async_result_complete_in_idle (data->simple);
-
-	_check_auth_data_free (data);
+	_check_auth_data_complete (data, NULL, error_message, TRUE);
 }
 
 static void
@@ -155,11 +357,6 @@ cancel_check_authorization_cb (GDBusProxy *proxy,
 	g_object_unref (self);
 }
 
-typedef struct {
-	gboolean is_authorized;
-	gboolean is_challenge;
-} CheckAuthorizationResult;
-
 static void
 check_authorization_cb (GDBusProxy *proxy,
                         GAsyncResult *res,
@@ -188,31 +385,28 @@ check_authorization_cb (GDBusProxy *proxy,
 		} else
 			_LOGD ("call[%u]: CheckAuthorization failed: %s", data->call_id, error->message);
 		g_dbus_error_strip_remote_error (error);
-		g_simple_async_result_set_error (data->simple,
-		                                 NM_MANAGER_ERROR,
-		                                 NM_MANAGER_ERROR_FAILED,
-		                                 "Authorization check failed: %s",
-		                                 error->message);
+		_check_auth_data_complete (data, NULL, error->message, FALSE);
 		g_error_free (error);
 	} else {
-		CheckAuthorizationResult *result;
-
-		result = g_new0 (CheckAuthorizationResult, 1);
+		CheckAuthorizationResult result = { 0 };
+		gs_unref_variant GVariant *details = NULL;
+		const char *tmp_auth_id = NULL;
 
 		g_variant_get (value,
 		               "((bb@a{ss}))",
-		               &result->is_authorized,
-		               &result->is_challenge,
-		               NULL);
+		               &result.is_authorized,
+		               &result.is_challenge,
+		               &details);
 		g_variant_unref (value);
 
-		_LOGD ("call[%u]: CheckAuthorization succeeded: (is_authorized=%d, is_challenge=%d)", data->call_id, result->is_authorized, result->is_challenge);
-		g_simple_async_result_set_op_res_gpointer (data->simple, result, g_free);
-	}
-
-	g_simple_async_result_complete (data->simple);
+		/* polkit reports the temporary authorization that an auth_*_keep
+		 * challenge left behind. */
+		g_variant_lookup (details, "polkit.temporary_authorization_id", "&s", &tmp_auth_id);
 
-	_check_auth_data_free (data);
+		_LOGD ("call[%u]: CheckAuthorization succeeded: (is_authorized=%d, is_challenge=%d)", data->call_id, result.is_authorized, result.is_challenge);
+		_decisions_add (data, &result, tmp_auth_id != NULL);
+		_check_auth_data_complete (data, &result, NULL, FALSE);
+	}
 }
 
 static void
@@ -228,7 +422,6 @@ _call_check_authorization (CheckAuthData *data)
 	                   data->cancellable,
 	                   (GAsyncReadyCallback) check_authorization_cb,
 	                   data);
-	g_clear_object (&data->cancellable);
 	data->dbus_parameters = NULL;
 }
 
@@ -243,11 +436,14 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 {
 	NMAuthManagerPrivate *priv;
 	char subject_buf[64];
+	char key_subject_buf[128];
 	GVariantBuilder builder;
 	PolkitCheckAuthorizationFlags flags;
 	GVariant *subject_value;
 	GVariant *details_value;
 	CheckAuthData *data;
+	char *decision_key;
+	const CheckAuthorizationResult *cached;
 
 	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
 	g_return_if_fail (NM_IS_AUTH_SUBJECT (subject));
@@ -263,6 +459,44 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 	    ? POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION
 	    : POLKIT_CHECK_AUTHORIZATION_FLAGS_NONE;
 
+	decision_key = g_strdup_printf ("%s|%s|%u",
+	                                nm_auth_subject_to_string (subject, key_subject_buf, sizeof (key_subject_buf)),
+	                                action_id,
+	                                (guint) flags);
+	cached = _decisions_lookup (self, decision_key);
+	if (cached) {
+		GSimpleAsyncResult *simple;
+
+		_LOGD ("CheckAuthorization(%s), subject=%s (cached: is_authorized=%d, is_challenge=%d)",
+		       action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)),
+		       cached->is_authorized, cached->is_challenge);
+		simple = g_simple_async_result_new (G_OBJECT (self),
+		                                    callback,
+		                                    user_data,
+		                                    nm_auth_manager_polkit_authority_check_authorization);
+		g_simple_async_result_set_op_res_gpointer (simple,
+		                                           g_memdup (cached, sizeof (*cached)),
+		                                           g_free);
+		g_simple_async_result_complete_in_idle (simple);
+		g_object_unref (simple);
+		g_free (decision_key);
+		return;
+	}
+
+	/* an interactive check is not shared either, each one gets its own
+	 * challenge. */
+	data =   priv->in_flight && !allow_user_interaction
+	       ? g_hash_table_lookup (priv->in_flight, decision_key)
+	       : NULL;
+	if (data) {
+		/* an identical check is already in progress, e.g. from another
+		 * auth-chain. Share its answer. */
+		_LOGD ("call[%u]: CheckAuthorization(%s), subject=%s (joined)", data->call_id, action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)));
+		_check_auth_data_add_waiter (data, cancellable, callback, user_data);
+		g_free (decision_key);
+		return;
+	}
+
 	subject_value = nm_auth_subject_unix_process_to_polkit_gvariant (subject);
 	nm_assert (g_variant_is_floating (subject_value));
 
@@ -273,13 +507,19 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 	data = g_new0 (CheckAuthData, 1);
 	data->call_id = ++priv->call_id_counter;
 	data->self = g_object_ref (self);
-	data->simple = g_simple_async_result_new (G_OBJECT (self),
-	                                          callback,
-	                                          user_data,
-	                                          nm_auth_manager_polkit_authority_check_authorization);
+	data->decision_key = decision_key;
+	data->decisions_generation = priv->decisions_generation;
+	data->interactive = allow_user_interaction;
 	if (cancellable != NULL) {
 		data->cancellation_id = g_strdup_printf ("cancellation-id-%u", data->call_id);
-		data->cancellable = g_object_ref (cancellable);
+		data->cancellable = g_cancellable_new ();
+	}
+	_check_auth_data_add_waiter (data, cancellable, callback, user_data);
+
+	if (!allow_user_interaction) {
+		if (!priv->in_flight)
+			priv->in_flight = g_hash_table_new (g_str_hash, g_str_equal);
+		g_hash_table_insert (priv->in_flight, data->decision_key, data);
 	}
 
 	data->dbus_parameters = g_variant_new ("(@(sa{sv})s@a{ss}us)",
@@ -341,6 +581,7 @@ nm_auth_manager_polkit_authority_check_authorization_finish (NMAuthManager *self
 static void
 _emit_changed_signal (NMAuthManager *self)
 {
+	_decisions_flush (self);
 	_LOGD ("emit changed signal");
 	g_signal_emit_by_name (self, NM_AUTH_MANAGER_SIGNAL_CHANGED);
 }
@@ -549,6 +790,12 @@ constructed (GObject *object)
 	if (priv->polkit_enabled) {
 		NMAuthManager **p_self;
 
+		priv->session_monitor = g_object_ref (nm_session_monitor_get ());
+		g_signal_connect (priv->session_monitor,
+		                  NM_SESSION_MONITOR_CHANGED,
+		                  G_CALLBACK (_session_monitor_changed_cb),
+		                  self);
+
 		priv->new_proxy_cancellable = g_cancellable_new ();
 		p_self = g_new (NMAuthManager *, 1);
 		*p_self = self;
@@ -595,6 +842,14 @@ dispose (GObject *object)
 		g_signal_handlers_disconnect_by_data (priv->proxy, self);
 		g_clear_object (&priv->proxy);
 	}
+
+	if (priv->session_monitor) {
+		g_signal_handlers_disconnect_by_func (priv->session_monitor, _session_monitor_changed_cb, self);
+		g_clear_object (&priv->session_monitor);
+	}
+
+	g_clear_pointer (&priv->decisions, g_hash_table_unref);
+	g_clear_pointer (&priv->in_flight, g_hash_table_unref);
 #endif
 
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->dispose (object);
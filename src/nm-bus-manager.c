@@ -70,6 +70,10 @@ typedef struct {
 
 	GDBusProxy *proxy;
 
+	/* unique bus name :: CallerCredentials */
+	GHashTable *credentials;
+	guint name_owner_changed_id;
+
 	gulong bus_closed_id;
 	guint reconnect_id;
 } NMBusManagerPrivate;
@@ -133,8 +137,27 @@ struct _PrivateServer {
 	GHashTable *obj_managers;
 
 	NMBusManager *manager;
+
+	/* whether all registered objects are exported on the connections,
+	 * like on the bus. Otherwise the users of the server export what
+	 * they need themselves. */
+	gboolean export_objects;
 };
 
+static void
+_private_server_export_objects (PrivateServer *s, GDBusObjectManagerServer *manager)
+{
+	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (s->manager);
+	GList *exported, *iter;
+
+	exported = g_dbus_object_manager_get_objects ((GDBusObjectManager *) priv->obj_manager);
+	for (iter = exported; iter; iter = iter->next) {
+		nm_exported_object_ensure_skeletons (iter->data);
+		g_dbus_object_manager_server_export (manager, iter->data);
+	}
+	g_list_free_full (exported, g_object_unref);
+}
+
 typedef struct {
 	GDBusConnection *connection;
 	PrivateServer *server;
@@ -216,6 +239,8 @@ private_server_new_connection (GDBusServer *server,
 	sender = g_strdup_printf ("x:y:%d", counter++);
 
 	manager = g_dbus_object_manager_server_new (OBJECT_MANAGER_SERVER_BASE_PATH);
+	if (s->export_objects)
+		_private_server_export_objects (s, manager);
 	g_dbus_object_manager_server_set_connection (manager, conn);
 	g_hash_table_insert (s->obj_managers, manager, sender);
 
@@ -253,6 +278,7 @@ private_server_authorize (GDBusAuthObserver *observer,
 static PrivateServer *
 private_server_new (const char *path,
                     const char *tag,
+                    gboolean export_objects,
                     NMBusManager *manager)
 {
 	PrivateServer *s;
@@ -296,6 +322,7 @@ private_server_new (const char *path,
 	                                         (GDestroyNotify) private_server_manager_destroy,
 	                                         g_free);
 	s->manager = manager;
+	s->export_objects = export_objects;
 	s->detail = g_quark_from_string (tag);
 	s->tag = g_quark_to_string (s->detail);
 
@@ -320,10 +347,24 @@ private_server_free (gpointer ptr)
 	g_free (s);
 }
 
+/**
+ * nm_bus_manager_private_server_register:
+ * @self: the #NMBusManager
+ * @path: the path of the unix socket
+ * @tag: the detail of the private-connection-new and
+ *   private-connection-disconnected signals for the server
+ * @export_objects: if %TRUE, all registered objects are exported on
+ *   the connections of the server, so that it offers the same API as
+ *   the bus. Such a server is for root clients that want to avoid the
+ *   overhead of the bus daemon.
+ *
+ * Starts a D-Bus server on @path, which only accepts root peers.
+ */
 void
 nm_bus_manager_private_server_register (NMBusManager *self,
                                         const char *path,
-                                        const char *tag)
+                                        const char *tag,
+                                        gboolean export_objects)
 {
 	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
 	PrivateServer *s;
@@ -340,7 +381,7 @@ nm_bus_manager_private_server_register (NMBusManager *self,
 			return;
 	}
 
-	s = private_server_new (path, tag, self);
+	s = private_server_new (path, tag, export_objects, self);
 	if (s)
 		priv->private_servers = g_slist_append (priv->private_servers, s);
 }
@@ -428,6 +469,121 @@ _bus_get_unix_user (NMBusManager *self,
 	return TRUE;
 }
 
+typedef struct {
+	gulong uid;
+	gulong pid;
+} CallerCredentials;
+
+static gboolean
+_bus_get_connection_credentials (NMBusManager *self,
+                                 const char *sender,
+                                 CallerCredentials *creds,
+                                 GError **error)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_unref_variant GVariant *dict = NULL;
+	GError *local = NULL;
+	guint32 v;
+
+	ret = _nm_dbus_proxy_call_sync (NM_BUS_MANAGER_GET_PRIVATE (self)->proxy,
+	                                "GetConnectionCredentials",
+	                                g_variant_new ("(s)", sender),
+	                                G_VARIANT_TYPE ("(a{sv})"),
+	                                G_DBUS_CALL_FLAGS_NONE, 2000,
+	                                NULL, &local);
+	if (!ret) {
+		if (!g_error_matches (local, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			g_propagate_error (error, local);
+			return FALSE;
+		}
+		g_clear_error (&local);
+
+		/* the bus daemon predates GetConnectionCredentials */
+		return    _bus_get_unix_user (self, sender, &creds->uid, error)
+		       && _bus_get_unix_pid (self, sender, &creds->pid, error);
+	}
+
+	g_variant_get (ret, "(@a{sv})", &dict);
+
+	if (!g_variant_lookup (dict, "UnixUserID", "u", &v)) {
+		g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+		             "no UnixUserID in the credentials of %s", sender);
+		return FALSE;
+	}
+	creds->uid = v;
+
+	if (g_variant_lookup (dict, "ProcessID", "u", &v))
+		creds->pid = v;
+	else if (!_bus_get_unix_pid (self, sender, &creds->pid, error))
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Gets the credentials of a bus connection. They don't change during the
+ * lifetime of the connection, so they are cached per unique name until the
+ * name vanishes from the bus (see name_owner_changed_cb()). */
+static gboolean
+_bus_get_credentials (NMBusManager *self,
+                      const char *sender,
+                      CallerCredentials *out_creds,
+                      GError **error)
+{
+	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
+	CallerCredentials *creds;
+
+	creds = g_hash_table_lookup (priv->credentials, sender);
+	if (creds) {
+		*out_creds = *creds;
+		return TRUE;
+	}
+
+	if (!priv->proxy) {
+		g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_DISCONNECTED,
+		                     "not connected to the bus");
+		return FALSE;
+	}
+
+	if (!_bus_get_connection_credentials (self, sender, out_creds, error))
+		return FALSE;
+
+	/* only unique names always refer to the same connection, and we
+	 * can only cache while we get notified about their disappearance. */
+	if (   sender[0] == ':'
+	    && priv->name_owner_changed_id) {
+		creds = g_slice_new (CallerCredentials);
+		*creds = *out_creds;
+		g_hash_table_insert (priv->credentials, g_strdup (sender), creds);
+	}
+	return TRUE;
+}
+
+static void
+_credentials_free (gpointer data)
+{
+	g_slice_free (CallerCredentials, data);
+}
+
+static void
+name_owner_changed_cb (GDBusConnection *connection,
+                       const char *sender_name,
+                       const char *object_path,
+                       const char *interface_name,
+                       const char *signal_name,
+                       GVariant *parameters,
+                       gpointer user_data)
+{
+	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (user_data);
+	const char *name, *old_owner, *new_owner;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sss)")))
+		return;
+
+	g_variant_get (parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+	if (name[0] == ':' && !new_owner[0])
+		g_hash_table_remove (priv->credentials, name);
+}
+
 /**
  * _get_caller_info():
  *
@@ -446,6 +602,7 @@ _get_caller_info (NMBusManager *self,
 	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
 	const char *sender;
 	GSList *iter;
+	CallerCredentials creds;
 
 	if (context) {
 		connection = g_dbus_method_invocation_get_connection (context);
@@ -492,18 +649,14 @@ _get_caller_info (NMBusManager *self,
 
 	/* Bus connections always have a sender */
 	g_assert (sender);
-	if (out_uid) {
-		if (!_bus_get_unix_user (self, sender, out_uid, NULL)) {
-			*out_uid = G_MAXULONG;
-			return FALSE;
-		}
-	}
-
-	if (out_pid) {
-		if (!_bus_get_unix_pid (self, sender, out_pid, NULL)) {
-			*out_pid = G_MAXULONG;
+	if (out_uid || out_pid) {
+		if (!_bus_get_credentials (self, sender, &creds, NULL)) {
+			NM_SET_OUT (out_uid, G_MAXULONG);
+			NM_SET_OUT (out_pid, G_MAXULONG);
 			return FALSE;
 		}
+		NM_SET_OUT (out_uid, creds.uid);
+		NM_SET_OUT (out_pid, creds.pid);
 	}
 
 	if (out_sender)
@@ -541,6 +694,7 @@ nm_bus_manager_get_unix_user (NMBusManager *self,
 	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
 	GSList *iter;
 	GError *error = NULL;
+	CallerCredentials creds;
 
 	g_return_val_if_fail (sender != NULL, FALSE);
 	g_return_val_if_fail (out_uid != NULL, FALSE);
@@ -554,13 +708,14 @@ nm_bus_manager_get_unix_user (NMBusManager *self,
 	}
 
 	/* Otherwise, a bus connection */
-	if (!_bus_get_unix_user (self, sender, out_uid, &error)) {
+	if (!_bus_get_credentials (self, sender, &creds, &error)) {
 		_LOGW ("failed to get unix user for dbus sender '%s': %s",
 		       sender, error->message);
 		g_error_free (error);
 		return FALSE;
 	}
 
+	*out_uid = creds.uid;
 	return TRUE;
 }
 
@@ -572,6 +727,7 @@ nm_bus_manager_init (NMBusManager *self)
 	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
 
 	priv->obj_manager = g_dbus_object_manager_server_new (OBJECT_MANAGER_SERVER_BASE_PATH);
+	priv->credentials = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _credentials_free);
 }
 
 static void
@@ -603,6 +759,7 @@ nm_bus_manager_dispose (GObject *object)
 	}
 
 	nm_clear_g_source (&priv->reconnect_id);
+	g_clear_pointer (&priv->credentials, g_hash_table_unref);
 
 	G_OBJECT_CLASS (nm_bus_manager_parent_class)->dispose (object);
 }
@@ -649,7 +806,15 @@ nm_bus_manager_cleanup (NMBusManager *self)
 
 	g_clear_object (&priv->proxy);
 
+	/* without the bus we miss vanishing names */
+	if (priv->credentials)
+		g_hash_table_remove_all (priv->credentials);
+
 	if (priv->connection) {
+		if (priv->name_owner_changed_id) {
+			g_dbus_connection_signal_unsubscribe (priv->connection, priv->name_owner_changed_id);
+			priv->name_owner_changed_id = 0;
+		}
 		g_signal_handler_disconnect (priv->connection, priv->bus_closed_id);
 		priv->bus_closed_id = 0;
 		g_clear_object (&priv->connection);
@@ -712,6 +877,21 @@ closed_cb (GDBusConnection *connection,
 	start_reconnection_timeout (self);
 }
 
+/* Objects exported while there was no connection to the bus have
+ * no interfaces yet. Create them before the object manager puts
+ * the objects on the bus. */
+static void
+_ensure_skeletons (NMBusManager *self)
+{
+	NMBusManagerPrivate *priv = NM_BUS_MANAGER_GET_PRIVATE (self);
+	GList *exported, *iter;
+
+	exported = g_dbus_object_manager_get_objects ((GDBusObjectManager *) priv->obj_manager);
+	for (iter = exported; iter; iter = iter->next)
+		nm_exported_object_ensure_skeletons (iter->data);
+	g_list_free_full (exported, g_object_unref);
+}
+
 static gboolean
 nm_bus_manager_init_bus (NMBusManager *self)
 {
@@ -757,6 +937,18 @@ nm_bus_manager_init_bus (NMBusManager *self)
 		return FALSE;
 	}
 
+	priv->name_owner_changed_id = g_dbus_connection_signal_subscribe (priv->connection,
+	                                                                  DBUS_SERVICE_DBUS,
+	                                                                  DBUS_INTERFACE_DBUS,
+	                                                                  "NameOwnerChanged",
+	                                                                  DBUS_PATH_DBUS,
+	                                                                  NULL,
+	                                                                  G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                                  name_owner_changed_cb,
+	                                                                  self,
+	                                                                  NULL);
+
+	_ensure_skeletons (self);
 	g_dbus_object_manager_server_set_connection (priv->obj_manager, priv->connection);
 	return TRUE;
 }
@@ -824,6 +1016,7 @@ nm_bus_manager_register_object (NMBusManager *self,
                                 GDBusObjectSkeleton *object)
 {
 	NMBusManagerPrivate *priv;
+	GSList *iter;
 
 	g_return_if_fail (NM_IS_BUS_MANAGER (self));
 	g_return_if_fail (NM_IS_EXPORTED_OBJECT (object));
@@ -838,6 +1031,21 @@ nm_bus_manager_register_object (NMBusManager *self,
 #endif
 
 	g_dbus_object_manager_server_export (priv->obj_manager, object);
+
+	for (iter = priv->private_servers; iter; iter = iter->next) {
+		PrivateServer *s = iter->data;
+		GHashTableIter h_iter;
+		GDBusObjectManagerServer *manager;
+
+		if (!s->export_objects)
+			continue;
+
+		g_hash_table_iter_init (&h_iter, s->obj_managers);
+		while (g_hash_table_iter_next (&h_iter, (gpointer) &manager, NULL)) {
+			nm_exported_object_ensure_skeletons ((NMExportedObject *) object);
+			g_dbus_object_manager_server_export (manager, object);
+		}
+	}
 }
 
 GDBusObjectSkeleton *
@@ -849,12 +1057,78 @@ nm_bus_manager_get_registered_object (NMBusManager *self,
 	return G_DBUS_OBJECT_SKELETON (g_dbus_object_manager_get_object ((GDBusObjectManager *) priv->obj_manager, path));
 }
 
+static int
+_sort_objects_by_path (gconstpointer a, gconstpointer b)
+{
+	return strcmp (g_dbus_object_get_object_path (*((GDBusObject **) a)),
+	               g_dbus_object_get_object_path (*((GDBusObject **) b)));
+}
+
+/**
+ * nm_bus_manager_get_managed_objects:
+ * @self: the #NMBusManager
+ *
+ * Returns: (transfer floating): the properties of all registered
+ * objects, in the a{oa{sa{sv}}} format of
+ * org.freedesktop.DBus.ObjectManager.GetManagedObjects(), sorted by
+ * object path. The values are taken from the interface skeletons,
+ * which already cache them.
+ */
+GVariant *
+nm_bus_manager_get_managed_objects (NMBusManager *self)
+{
+	NMBusManagerPrivate *priv;
+	GVariantBuilder objects;
+	GList *list, *iter;
+	GPtrArray *sorted;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_BUS_MANAGER (self), NULL);
+
+	priv = NM_BUS_MANAGER_GET_PRIVATE (self);
+
+	list = g_dbus_object_manager_get_objects ((GDBusObjectManager *) priv->obj_manager);
+	sorted = g_ptr_array_new_with_free_func (g_object_unref);
+	for (iter = list; iter; iter = iter->next)
+		g_ptr_array_add (sorted, iter->data);
+	g_list_free (list);
+	g_ptr_array_sort (sorted, _sort_objects_by_path);
+
+	g_variant_builder_init (&objects, G_VARIANT_TYPE ("a{oa{sa{sv}}}"));
+	for (i = 0; i < sorted->len; i++) {
+		GDBusObject *object = sorted->pdata[i];
+		GVariantBuilder interfaces;
+		GList *ifaces;
+
+		nm_exported_object_ensure_skeletons ((NMExportedObject *) object);
+
+		g_variant_builder_init (&interfaces, G_VARIANT_TYPE ("a{sa{sv}}"));
+		ifaces = g_dbus_object_get_interfaces (object);
+		for (iter = ifaces; iter; iter = iter->next) {
+			GDBusInterfaceSkeleton *skeleton = iter->data;
+
+			g_variant_builder_add (&interfaces, "{s@a{sv}}",
+			                       g_dbus_interface_skeleton_get_info (skeleton)->name,
+			                       g_dbus_interface_skeleton_get_properties (skeleton));
+		}
+		g_list_free_full (ifaces, g_object_unref);
+
+		g_variant_builder_add (&objects, "{oa{sa{sv}}}",
+		                       g_dbus_object_get_object_path (object),
+		                       &interfaces);
+	}
+	g_ptr_array_unref (sorted);
+
+	return g_variant_builder_end (&objects);
+}
+
 void
 nm_bus_manager_unregister_object (NMBusManager *self,
                                   GDBusObjectSkeleton *object)
 {
 	NMBusManagerPrivate *priv;
 	gs_free char *path = NULL;
+	GSList *iter;
 
 	g_return_if_fail (NM_IS_BUS_MANAGER (self));
 	g_return_if_fail (NM_IS_EXPORTED_OBJECT (object));
@@ -872,6 +1146,19 @@ nm_bus_manager_unregister_object (NMBusManager *self,
 	g_return_if_fail (path != NULL);
 
 	g_dbus_object_manager_server_unexport (priv->obj_manager, path);
+
+	for (iter = priv->private_servers; iter; iter = iter->next) {
+		PrivateServer *s = iter->data;
+		GHashTableIter h_iter;
+		GDBusObjectManagerServer *manager;
+
+		if (!s->export_objects)
+			continue;
+
+		g_hash_table_iter_init (&h_iter, s->obj_managers);
+		while (g_hash_table_iter_next (&h_iter, (gpointer) &manager, NULL))
+			g_dbus_object_manager_server_unexport (manager, path);
+	}
 }
 
 const char *
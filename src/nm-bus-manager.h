@@ -91,9 +91,12 @@ void nm_bus_manager_unregister_object (NMBusManager *self,
 GDBusObjectSkeleton *nm_bus_manager_get_registered_object (NMBusManager *self,
                                                            const char *path);
 
+GVariant *nm_bus_manager_get_managed_objects (NMBusManager *self);
+
 void nm_bus_manager_private_server_register (NMBusManager *self,
                                              const char *path,
-                                             const char *tag);
+                                             const char *tag,
+                                             gboolean export_objects);
 
 GDBusProxy *nm_bus_manager_new_proxy (NMBusManager *self,
                                       GDBusConnection *connection,
@@ -39,6 +39,7 @@ typedef struct {
 		 * "match-device" was unspecified. */
 		gboolean has;
 		GSList *spec;
+		NMMatchSpecCompiled *compiled;
 	} match_device;
 } ConnectionInfo;
 
@@ -64,10 +65,16 @@ typedef struct {
 		char **arr;
 		GSList *specs;
 		GSList *specs_config;
+		NMMatchSpecCompiled *compiled;
+		NMMatchSpecCompiled *compiled_config;
 	} no_auto_default;
 
+	/* the device specs are compiled once, as they are matched
+	 * against devices over and over. */
 	GSList *ignore_carrier;
+	NMMatchSpecCompiled *ignore_carrier_compiled;
 	GSList *assume_ipv6ll_only;
+	NMMatchSpecCompiled *assume_ipv6ll_only_compiled;
 
 	char *dns_mode;
 	char *rc_manager;
@@ -76,8 +83,30 @@ typedef struct {
 
 	/* mutable field */
 	char *value_cached;
+
+	/* mutable field. The per-device results of the lookups, see
+	 * _device_cache_get(). */
+	GHashTable *device_cache;
 } NMConfigDataPrivate;
 
+typedef enum {
+	DEVICE_CACHE_IGNORE_CARRIER         = (1LL << 0),
+	DEVICE_CACHE_ASSUME_IPV6LL_ONLY     = (1LL << 1),
+	DEVICE_CACHE_NO_AUTO_DEFAULT        = (1LL << 2),
+} DeviceCacheFlags;
+
+typedef struct {
+	/* the identity of the device when the entry was filled */
+	char *iface;
+	char *hw_addr;
+
+	DeviceCacheFlags valid;
+	DeviceCacheFlags values;
+
+	/* property -> the value of nm_config_data_get_connection_default(), or %NULL */
+	GHashTable *connection_defaults;
+} DeviceCache;
+
 struct _NMGlobalDnsDomain {
 	char *name;
 	char **servers;
@@ -236,6 +265,90 @@ nm_config_data_get_no_auto_default (const NMConfigData *self)
 	return (const char *const*) NM_CONFIG_DATA_GET_PRIVATE (self)->no_auto_default.arr;
 }
 
+/*****************************************************************************/
+
+/* NMConfigData is immutable, so whatever is looked up for a device stays valid
+ * for the lifetime of the instance -- as long as the device keeps the interface
+ * name and hardware address that the match specs were evaluated against. A new
+ * instance (on reload) starts with an empty cache. */
+
+static void
+_device_cache_free (gpointer data)
+{
+	DeviceCache *cache = data;
+
+	g_free (cache->iface);
+	g_free (cache->hw_addr);
+	if (cache->connection_defaults)
+		g_hash_table_unref (cache->connection_defaults);
+	g_slice_free (DeviceCache, cache);
+}
+
+static void
+_device_cache_weak_notify (gpointer data, GObject *where_the_object_was)
+{
+	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (data);
+
+	g_hash_table_remove (priv->device_cache, where_the_object_was);
+}
+
+static DeviceCache *
+_device_cache_get (const NMConfigData *self, NMDevice *device)
+{
+	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+	const char *iface = nm_device_get_iface (device);
+	const char *hw_addr = nm_device_get_hw_address (device);
+	DeviceCache *cache;
+
+	if (G_UNLIKELY (!priv->device_cache))
+		priv->device_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, _device_cache_free);
+
+	cache = g_hash_table_lookup (priv->device_cache, device);
+	if (!cache) {
+		cache = g_slice_new0 (DeviceCache);
+		cache->iface = g_strdup (iface);
+		cache->hw_addr = g_strdup (hw_addr);
+		g_hash_table_insert (priv->device_cache, device, cache);
+		g_object_weak_ref (G_OBJECT (device), _device_cache_weak_notify, (gpointer) self);
+	} else if (   g_strcmp0 (cache->iface, iface)
+	           || g_strcmp0 (cache->hw_addr, hw_addr)) {
+		g_free (cache->iface);
+		cache->iface = g_strdup (iface);
+		g_free (cache->hw_addr);
+		cache->hw_addr = g_strdup (hw_addr);
+		cache->valid = 0;
+		if (cache->connection_defaults)
+			g_hash_table_remove_all (cache->connection_defaults);
+	}
+	return cache;
+}
+
+static gboolean
+_device_cache_lookup (const NMConfigData *self,
+                      NMDevice *device,
+                      DeviceCacheFlags flag,
+                      NMMatchSpecCompiled *compiled,
+                      NMMatchSpecCompiled *compiled2)
+{
+	DeviceCache *cache;
+
+	if (!compiled && !compiled2)
+		return FALSE;
+
+	cache = _device_cache_get (self, device);
+	if (!NM_FLAGS_HAS (cache->valid, flag)) {
+		if (   nm_device_spec_match_compiled (device, compiled)
+		    || nm_device_spec_match_compiled (device, compiled2))
+			cache->values |= flag;
+		else
+			cache->values &= ~flag;
+		cache->valid |= flag;
+	}
+	return NM_FLAGS_HAS (cache->values, flag);
+}
+
+/*****************************************************************************/
+
 gboolean
 nm_config_data_get_no_auto_default_for_device (const NMConfigData *self, NMDevice *device)
 {
@@ -245,8 +358,9 @@ nm_config_data_get_no_auto_default_for_device (const NMConfigData *self, NMDevic
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
-	return    nm_device_spec_match_list (device, priv->no_auto_default.specs)
-	       || nm_device_spec_match_list (device, priv->no_auto_default.specs_config);
+	return _device_cache_lookup (self, device, DEVICE_CACHE_NO_AUTO_DEFAULT,
+	                             priv->no_auto_default.compiled,
+	                             priv->no_auto_default.compiled_config);
 }
 
 const char *
@@ -271,7 +385,9 @@ nm_config_data_get_ignore_carrier (const NMConfigData *self, NMDevice *device)
 	g_return_val_if_fail (NM_IS_CONFIG_DATA (self), FALSE);
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
-	return nm_device_spec_match_list (device, NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier);
+	return _device_cache_lookup (self, device, DEVICE_CACHE_IGNORE_CARRIER,
+	                             NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier_compiled,
+	                             NULL);
 }
 
 gboolean
@@ -280,7 +396,9 @@ nm_config_data_get_assume_ipv6ll_only (const NMConfigData *self, NMDevice *devic
 	g_return_val_if_fail (NM_IS_CONFIG_DATA (self), FALSE);
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
-	return nm_device_spec_match_list (device, NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only);
+	return _device_cache_lookup (self, device, DEVICE_CACHE_ASSUME_IPV6LL_ONLY,
+	                             NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only_compiled,
+	                             NULL);
 }
 
 GKeyFile *
@@ -1056,6 +1174,8 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 {
 	NMConfigDataPrivate *priv;
 	const ConnectionInfo *connection_info;
+	DeviceCache *cache = NULL;
+	char *value = NULL;
 
 	g_return_val_if_fail (self, NULL);
 	g_return_val_if_fail (property && *property, NULL);
@@ -1066,8 +1186,17 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 	if (!priv->connection_infos)
 		return NULL;
 
+	if (device) {
+		const char *cached;
+
+		cache = _device_cache_get (self, device);
+		if (!cache->connection_defaults)
+			cache->connection_defaults = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		else if (g_hash_table_lookup_extended (cache->connection_defaults, property, NULL, (gpointer *) &cached))
+			return g_strdup (cached);
+	}
+
 	for (connection_info = &priv->connection_infos[0]; connection_info->group_name; connection_info++) {
-		char *value;
 		gboolean match;
 
 		/* FIXME: Here we use g_key_file_get_string(). This should be in sync with what keyfile-reader
@@ -1083,13 +1212,16 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 
 		match = TRUE;
 		if (connection_info->match_device.has)
-			match = device && nm_device_spec_match_list (device, connection_info->match_device.spec);
+			match = device && nm_device_spec_match_compiled (device, connection_info->match_device.compiled);
 
 		if (match)
-			return value;
-		g_free (value);
+			break;
+		g_clear_pointer (&value, g_free);
 	}
-	return NULL;
+
+	if (cache)
+		g_hash_table_insert (cache->connection_defaults, g_strdup (property), g_strdup (value));
+	return value;
 }
 
 static void
@@ -1102,6 +1234,7 @@ _get_connection_info_init (ConnectionInfo *connection_info, GKeyFile *keyfile, c
 	                                                               group,
 	                                                               "match-device",
 	                                                               &connection_info->match_device.has);
+	connection_info->match_device.compiled = nm_match_spec_compile (connection_info->match_device.spec);
 	connection_info->stop_match = nm_config_keyfile_get_boolean (keyfile, group, "stop-match", FALSE);
 }
 
@@ -1201,6 +1334,9 @@ nm_config_data_diff (NMConfigData *old_data, NMConfigData *new_data)
 	if (!global_dns_equal (priv_old->global_dns, priv_new->global_dns))
 		changes |= NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG;
 
+	if (!_slist_str_equals (priv_old->ignore_carrier, priv_new->ignore_carrier))
+		changes |= NM_CONFIG_CHANGE_IGNORE_CARRIER;
+
 	return changes;
 }
 
@@ -1314,20 +1450,35 @@ finalize (GObject *gobject)
 
 	g_slist_free_full (priv->no_auto_default.specs, g_free);
 	g_slist_free_full (priv->no_auto_default.specs_config, g_free);
+	nm_match_spec_compiled_free (priv->no_auto_default.compiled);
+	nm_match_spec_compiled_free (priv->no_auto_default.compiled_config);
 	g_strfreev (priv->no_auto_default.arr);
 
 	g_free (priv->dns_mode);
 	g_free (priv->rc_manager);
 
 	g_slist_free_full (priv->ignore_carrier, g_free);
+	nm_match_spec_compiled_free (priv->ignore_carrier_compiled);
 	g_slist_free_full (priv->assume_ipv6ll_only, g_free);
+	nm_match_spec_compiled_free (priv->assume_ipv6ll_only_compiled);
 
 	nm_global_dns_config_free (priv->global_dns);
 
+	if (priv->device_cache) {
+		GHashTableIter iter;
+		gpointer device;
+
+		g_hash_table_iter_init (&iter, priv->device_cache);
+		while (g_hash_table_iter_next (&iter, &device, NULL))
+			g_object_weak_unref (device, _device_cache_weak_notify, gobject);
+		g_hash_table_unref (priv->device_cache);
+	}
+
 	if (priv->connection_infos) {
 		for (i = 0; priv->connection_infos[i].group_name; i++) {
 			g_free (priv->connection_infos[i].group_name);
 			g_slist_free_full (priv->connection_infos[i].match_device.spec, g_free);
+			nm_match_spec_compiled_free (priv->connection_infos[i].match_device.compiled);
 		}
 		g_free (priv->connection_infos);
 	}
@@ -1378,6 +1529,11 @@ constructed (GObject *object)
 
 	priv->no_auto_default.specs_config = nm_config_get_match_spec (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "no-auto-default", NULL);
 
+	priv->ignore_carrier_compiled = nm_match_spec_compile (priv->ignore_carrier);
+	priv->assume_ipv6ll_only_compiled = nm_match_spec_compile (priv->assume_ipv6ll_only);
+	priv->no_auto_default.compiled = nm_match_spec_compile (priv->no_auto_default.specs);
+	priv->no_auto_default.compiled_config = nm_match_spec_compile (priv->no_auto_default.specs_config);
+
 	priv->global_dns = load_global_dns (priv->keyfile_user, FALSE);
 	if (!priv->global_dns)
 		priv->global_dns = load_global_dns (priv->keyfile_intern, TRUE);
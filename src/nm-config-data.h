@@ -77,6 +77,7 @@ typedef enum { /*< flags >*/
 	NM_CONFIG_CHANGE_DNS_MODE                  = (1L << 9),
 	NM_CONFIG_CHANGE_RC_MANAGER                = (1L << 10),
 	NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG         = (1L << 11),
+	NM_CONFIG_CHANGE_IGNORE_CARRIER            = (1L << 12),
 
 	_NM_CONFIG_CHANGE_LAST,
 	NM_CONFIG_CHANGE_ALL                       = ((_NM_CONFIG_CHANGE_LAST - 1) << 1) - 1,
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 #include "nm-config.h"
 #include "nm-utils.h"
@@ -31,6 +32,7 @@
 #include "nm-enum-types.h"
 #include "nm-core-internal.h"
 #include "nm-keyfile-internal.h"
+#include "nm-executor.h"
 
 #define DEFAULT_CONFIG_MAIN_FILE        NMCONFDIR "/NetworkManager.conf"
 #define DEFAULT_CONFIG_DIR              NMCONFDIR "/conf.d"
@@ -87,6 +89,10 @@ typedef struct {
 	char *no_auto_default_file;
 	char *intern_config_file;
 
+	/* digest over the stat() of all files read by the last (re)load,
+	 * see _config_files_digest(). */
+	guint64 config_files_digest;
+
 	char **plugins;
 	gboolean monitor_connection_files;
 	gboolean auth_polkit;
@@ -920,6 +926,68 @@ _get_config_dir_files (const char *config_dir)
 	return confs;
 }
 
+static guint64
+_file_digest (guint64 h, const char *dirname, const char *filename)
+{
+	gs_free char *path = NULL;
+	struct stat st;
+
+	if (!filename || !*filename)
+		return h;
+
+	if (dirname)
+		filename = path = g_build_filename (dirname, filename, NULL);
+
+	h = nm_utils_digest_str (h, filename);
+	if (stat (filename, &st) != 0)
+		return nm_utils_digest_u32 (h, 0);
+
+	h = nm_utils_digest_u32 (h, 1);
+	h = nm_utils_digest_u64 (h, st.st_dev);
+	h = nm_utils_digest_u64 (h, st.st_ino);
+	h = nm_utils_digest_u64 (h, st.st_size);
+	h = nm_utils_digest_u64 (h, st.st_mtim.tv_sec);
+	h = nm_utils_digest_u32 (h, st.st_mtim.tv_nsec);
+	h = nm_utils_digest_u64 (h, st.st_ctim.tv_sec);
+	return nm_utils_digest_u32 (h, st.st_ctim.tv_nsec);
+}
+
+/* Covers every file that read_entire_config(), intern_config_read() and
+ * no_auto_default_from_file() may read, including the candidates that don't
+ * exist. If the digest didn't change since the last load, there is nothing
+ * to re-read on SIGHUP. It must be computed *before* reading the files, so
+ * that a concurrent modification is picked up by the next reload. */
+static guint64
+_config_files_digest (NMConfigPrivate *priv)
+{
+	gs_unref_ptrarray GPtrArray *system_confs = NULL;
+	gs_unref_ptrarray GPtrArray *confs = NULL;
+	guint64 h = NM_UTILS_DIGEST_INIT;
+	guint i;
+
+	system_confs = _get_config_dir_files (priv->system_config_dir);
+	for (i = 0; i < system_confs->len; i++)
+		h = _file_digest (h, priv->system_config_dir, system_confs->pdata[i]);
+
+	/* separate the lists, so that moving a file from one directory to
+	 * the other is noticed. */
+	h = nm_utils_digest_u32 (h, system_confs->len);
+
+	confs = _get_config_dir_files (priv->config_dir);
+	for (i = 0; i < confs->len; i++)
+		h = _file_digest (h, priv->config_dir, confs->pdata[i]);
+
+	if (priv->cli.config_main_file)
+		h = _file_digest (h, NULL, priv->cli.config_main_file);
+	else {
+		h = _file_digest (h, NULL, DEFAULT_CONFIG_MAIN_FILE_OLD);
+		h = _file_digest (h, NULL, DEFAULT_CONFIG_MAIN_FILE);
+	}
+
+	h = _file_digest (h, NULL, priv->intern_config_file);
+	return _file_digest (h, NULL, priv->no_auto_default_file);
+}
+
 static GKeyFile *
 read_entire_config (const NMConfigCmdLineOptions *cli,
                     const char *config_dir,
@@ -1165,6 +1233,9 @@ intern_config_read (const char *filename,
 		return NULL;
 	}
 
+	/* a previous write might still be pending. */
+	nm_executor_flush ();
+
 	keyfile_intern = nm_config_create_keyfile ();
 
 	keyfile = nm_config_create_keyfile ();
@@ -1334,25 +1405,36 @@ _intern_config_write_sort_fcn (const char **a, const char **b, const char *const
 	return g_strcmp0 (g_a, g_b);
 }
 
-static gboolean
+static void
+intern_config_write_done (GError *error, gpointer user_data)
+{
+	char *filename = user_data;
+
+	if (error)
+		nm_log_warn (LOGD_CORE, "error saving internal configuration \"%s\": %s", filename, error->message);
+	else
+		nm_log_dbg (LOGD_CORE, "write intern config file \"%s\"", filename);
+	g_free (filename);
+}
+
+static void
 intern_config_write (const char *filename,
                      GKeyFile *keyfile_intern,
                      GKeyFile *keyfile_conf,
-                     const char *const*atomic_section_prefixes,
-                     GError **error)
+                     const char *const*atomic_section_prefixes)
 {
 	GKeyFile *keyfile;
 	gs_strfreev char **groups = NULL;
 	guint g, k;
 	gboolean has_intern = FALSE;
-	gboolean success = FALSE;
-	GError *local = NULL;
+	char *data;
+	gsize length;
 
-	g_return_val_if_fail (filename, FALSE);
+	g_return_if_fail (filename);
 
 	if (!*filename) {
-		g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_NOT_FOUND, "no filename to write (use --intern-config?)");
-		return FALSE;
+		nm_log_dbg (LOGD_CORE, "no filename to write intern config (use --intern-config?)");
+		return;
 	}
 
 	keyfile = nm_config_create_keyfile ();
@@ -1494,13 +1576,11 @@ intern_config_write (const char *filename,
 	                        " CHANGES TO THIS FILE WILL BE OVERWRITTEN",
 	                        NULL);
 
-	success = g_key_file_save_to_file (keyfile, filename, &local);
-
-	nm_log_dbg (LOGD_CORE, "write intern config file \"%s\"%s%s", filename, success ? "" : ": ", success ? "" : local->message);
+	/* the file is written by the executor, off the main loop. */
+	data = g_key_file_to_data (keyfile, &length, NULL);
 	g_key_file_unref (keyfile);
-	if (!success)
-		g_propagate_error (error, local);
-	return success;
+	nm_executor_write_file (filename, data, length,
+	                        intern_config_write_done, g_strdup (filename));
 }
 
 /************************************************************************/
@@ -1627,7 +1707,6 @@ nm_config_set_values (NMConfig *self,
 	GKeyFile *keyfile_intern_current;
 	GKeyFile *keyfile_user;
 	GKeyFile *keyfile_new;
-	GError *local = NULL;
 	NMConfigData *new_data = NULL;
 	gs_strfreev char **groups = NULL;
 	gint g;
@@ -1665,11 +1744,8 @@ nm_config_set_values (NMConfig *self,
 		 * changes on disk happened in any case *after* now. */
 		if (*priv->intern_config_file) {
 			keyfile_user = _nm_config_data_get_keyfile_user (priv->config_data);
-			if (!intern_config_write (priv->intern_config_file, keyfile_new, keyfile_user,
-			                          (const char *const*) priv->atomic_section_prefixes, &local)) {
-				nm_log_warn (LOGD_CORE, "error saving internal configuration \"%s\": %s", priv->intern_config_file, local->message);
-				g_clear_error (&local);
-			}
+			intern_config_write (priv->intern_config_file, keyfile_new, keyfile_user,
+			                     (const char *const*) priv->atomic_section_prefixes);
 		} else
 			nm_log_dbg (LOGD_CORE, "don't persistate internal configuration (no file set, use --intern-config?)");
 	}
@@ -1875,6 +1951,7 @@ nm_config_reload (NMConfig *self, int signal)
 	char *config_description = NULL;
 	gs_strfreev char **no_auto_default = NULL;
 	gboolean intern_config_needs_rewrite;
+	guint64 config_files_digest;
 
 	g_return_if_fail (NM_IS_CONFIG (self));
 
@@ -1885,6 +1962,14 @@ nm_config_reload (NMConfig *self, int signal)
 		return;
 	}
 
+	config_files_digest = _config_files_digest (priv);
+	if (config_files_digest == priv->config_files_digest) {
+		/* the current data is what reading the files would give again. */
+		nm_log_dbg (LOGD_CORE, "config: no configuration file changed, skip reading them");
+		_set_config_data (self, g_object_ref (priv->config_data), signal);
+		return;
+	}
+
 	/* pass on the original command line options. This means, that
 	 * options specified at command line cannot ever be reloaded from
 	 * file. That seems desirable.
@@ -1901,6 +1986,7 @@ nm_config_reload (NMConfig *self, int signal)
 		_set_config_data (self, NULL, signal);
 		return;
 	}
+	priv->config_files_digest = config_files_digest;
 
 	no_auto_default = no_auto_default_from_file (priv->no_auto_default_file);
 
@@ -1910,7 +1996,7 @@ nm_config_reload (NMConfig *self, int signal)
 	                                     &intern_config_needs_rewrite);
 	if (intern_config_needs_rewrite) {
 		intern_config_write (priv->intern_config_file, keyfile_intern, keyfile,
-		                     (const char *const*) priv->atomic_section_prefixes, NULL);
+		                     (const char *const*) priv->atomic_section_prefixes);
 	}
 
 	new_data = nm_config_data_new (config_main_file, config_description, (const char *const*) no_auto_default, keyfile, keyfile_intern);
@@ -1936,6 +2022,7 @@ NM_UTILS_FLAGS2STR_DEFINE (nm_config_change_flags_to_string, NMConfigChangeFlags
 	NM_UTILS_FLAGS2STR (NM_CONFIG_CHANGE_DNS_MODE, "dns-mode"),
 	NM_UTILS_FLAGS2STR (NM_CONFIG_CHANGE_RC_MANAGER, "rc-manager"),
 	NM_UTILS_FLAGS2STR (NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG, "global-dns-config"),
+	NM_UTILS_FLAGS2STR (NM_CONFIG_CHANGE_IGNORE_CARRIER, "ignore-carrier"),
 );
 
 static void
@@ -1962,7 +2049,9 @@ _set_config_data (NMConfig *self, NMConfigData *new_data, int signal)
 	}
 
 	if (new_data) {
-		changes_diff = nm_config_data_diff (old_data, new_data);
+		changes_diff = new_data != old_data
+		               ? nm_config_data_diff (old_data, new_data)
+		               : NM_CONFIG_CHANGE_NONE;
 		if (changes_diff == NM_CONFIG_CHANGE_NONE)
 			g_clear_object (&new_data);
 		else
@@ -2054,6 +2143,13 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 	else
 		priv->intern_config_file = g_strdup (DEFAULT_INTERN_CONFIG_FILE);
 
+	if (priv->cli.no_auto_default_file)
+		priv->no_auto_default_file = g_strdup (priv->cli.no_auto_default_file);
+	else
+		priv->no_auto_default_file = g_strdup (DEFAULT_NO_AUTO_DEFAULT_FILE);
+
+	priv->config_files_digest = _config_files_digest (priv);
+
 	keyfile = read_entire_config (&priv->cli,
 	                              priv->config_dir,
 	                              priv->system_config_dir,
@@ -2065,11 +2161,6 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 
 	/* Initialize read only private members */
 
-	if (priv->cli.no_auto_default_file)
-		priv->no_auto_default_file = g_strdup (priv->cli.no_auto_default_file);
-	else
-		priv->no_auto_default_file = g_strdup (DEFAULT_NO_AUTO_DEFAULT_FILE);
-
 	priv->plugins = _nm_utils_strv_cleanup (g_key_file_get_string_list (keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "plugins", NULL, NULL),
 	                                        TRUE, TRUE, TRUE);
 	if (!priv->plugins)
@@ -2096,7 +2187,7 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 	                                     &intern_config_needs_rewrite);
 	if (intern_config_needs_rewrite) {
 		intern_config_write (priv->intern_config_file, keyfile_intern, keyfile,
-		                     (const char *const*) priv->atomic_section_prefixes, NULL);
+		                     (const char *const*) priv->atomic_section_prefixes);
 	}
 
 	priv->config_data_orig = nm_config_data_new (config_main_file, config_description, (const char *const*) no_auto_default, keyfile, keyfile_intern);
@@ -63,6 +63,10 @@ G_BEGIN_DECLS
 #define NM_CONFIG_KEYFILE_GROUP_IFNET                       "ifnet"
 
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND               "backend"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_RING_LEVEL            "ring-level"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_RING_SIZE             "ring-size"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_RATE_LIMIT           "rate-limit"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_RATE_LIMIT_CALLSITE  "rate-limit-callsite"
 #define NM_CONFIG_KEYFILE_KEY_CONFIG_ENABLE                 "enable"
 #define NM_CONFIG_KEYFILE_KEY_ATOMIC_SECTION_WAS            ".was"
 #define NM_CONFIG_KEYFILE_KEY_KEYFILE_PATH                  "path"
@@ -72,6 +76,26 @@ G_BEGIN_DECLS
 #define NM_CONFIG_KEYFILE_KEY_IFNET_MANAGED                 "managed"
 #define NM_CONFIG_KEYFILE_KEY_IFUPDOWN_MANAGED              "managed"
 #define NM_CONFIG_KEYFILE_KEY_AUDIT                         "audit"
+#define NM_CONFIG_KEYFILE_KEY_CONNECTIVITY_PER_DEVICE       "per-device"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_ACTIVATION_MAX_CONCURRENT "activation-max-concurrent"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_CARRIER_FLAP_MAX_DELAY  "carrier-flap-max-delay"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_ROUTING_DNS_MAX_LATENCY "routing-dns-max-latency"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_FAST_RESUME             "fast-resume"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DNS_UPDATE_MAX_LATENCY  "dns-update-max-latency"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_OPTIMISTIC_LEASE   "dhcp-optimistic-lease"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_SHARED_SOCKET      "dhcp-shared-socket"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_RENEWAL_JITTER     "dhcp-renewal-jitter"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_RESTART_RATE       "dhcp-restart-rate"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_VPN_PREWARM            "vpn-prewarm"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_NOTIFY_BUDGET     "dbus-notify-budget"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_NOTIFY_MAX_LATENCY "dbus-notify-max-latency"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_PROFILE_STARTUP        "profile-startup"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_WATCHDOG_THRESHOLD     "watchdog-threshold"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_WATCHDOG_BACKTRACE     "watchdog-backtrace"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_SECRET_AGENTS_PARALLEL "secret-agents-parallel"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_SECRET_AGENT_TIMEOUT  "secret-agent-timeout"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_AGENT_SECRETS_CACHE_TIMEOUT "agent-secrets-cache-timeout"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DEVICE_PLUGINS_ON_DEMAND "device-plugins-on-demand"
 
 #define NM_CONFIG_KEYFILE_KEYPREFIX_WAS                     ".was."
 #define NM_CONFIG_KEYFILE_KEYPREFIX_SET                     ".set."
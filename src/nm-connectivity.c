@@ -107,57 +107,66 @@ typedef struct {
 	guint check_id_when_scheduled;
 } ConCheckCbData;
 
-static void
-nm_connectivity_check_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+static NMConnectivityState
+_check_response_to_state (SoupMessage *msg, const char *uri, const char *response, const char *log_prefix)
 {
-	NMConnectivity *self;
-	NMConnectivityPrivate *priv;
-	ConCheckCbData *cb_data = user_data;
-	GSimpleAsyncResult *simple = cb_data->simple;
 	NMConnectivityState new_state;
 	const char *nm_header;
-	const char *uri = cb_data->uri;
-	const char *response = cb_data->response ? cb_data->response : NM_CONFIG_DEFAULT_CONNECTIVITY_RESPONSE;
 
-	self = NM_CONNECTIVITY (g_async_result_get_source_object (G_ASYNC_RESULT (simple)));
-	/* it is safe to unref @self here, @simple holds yet another reference. */
-	g_object_unref (self);
-	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	if (!response)
+		response = NM_CONFIG_DEFAULT_CONNECTIVITY_RESPONSE;
 
 	if (SOUP_STATUS_IS_TRANSPORT_ERROR (msg->status_code)) {
-		_LOGI ("check for uri '%s' failed with '%s'", uri, msg->reason_phrase);
-		new_state = NM_CONNECTIVITY_LIMITED;
-		goto done;
+		_LOGI ("%scheck for uri '%s' failed with '%s'", log_prefix, uri, msg->reason_phrase);
+		return NM_CONNECTIVITY_LIMITED;
 	}
 
 	if (msg->status_code == 511) {
-		_LOGD ("check for uri '%s' returned status '%d %s'; captive portal present.",
-		       uri, msg->status_code, msg->reason_phrase);
+		_LOGD ("%scheck for uri '%s' returned status '%d %s'; captive portal present.",
+		       log_prefix, uri, msg->status_code, msg->reason_phrase);
 		new_state = NM_CONNECTIVITY_PORTAL;
 	} else {
 		/* Check headers; if we find the NM-specific one we're done */
 		nm_header = soup_message_headers_get_one (msg->response_headers, "X-NetworkManager-Status");
 		if (g_strcmp0 (nm_header, "online") == 0) {
-			_LOGD ("check for uri '%s' with Status header successful.", uri);
+			_LOGD ("%scheck for uri '%s' with Status header successful.", log_prefix, uri);
 			new_state = NM_CONNECTIVITY_FULL;
 		} else if (msg->status_code == SOUP_STATUS_OK) {
 			/* check response */
 			if (msg->response_body->data && g_str_has_prefix (msg->response_body->data, response)) {
-				_LOGD ("check for uri '%s' successful.", uri);
+				_LOGD ("%scheck for uri '%s' successful.", log_prefix, uri);
 				new_state = NM_CONNECTIVITY_FULL;
 			} else {
-				_LOGI ("check for uri '%s' did not match expected response '%s'; assuming captive portal.",
-					   uri, response);
+				_LOGI ("%scheck for uri '%s' did not match expected response '%s'; assuming captive portal.",
+					   log_prefix, uri, response);
 				new_state = NM_CONNECTIVITY_PORTAL;
 			}
 		} else {
-			_LOGI ("check for uri '%s' returned status '%d %s'; assuming captive portal.",
-			       uri, msg->status_code, msg->reason_phrase);
+			_LOGI ("%scheck for uri '%s' returned status '%d %s'; assuming captive portal.",
+			       log_prefix, uri, msg->status_code, msg->reason_phrase);
 			new_state = NM_CONNECTIVITY_PORTAL;
 		}
 	}
 
- done:
+	return new_state;
+}
+
+static void
+nm_connectivity_check_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	NMConnectivity *self;
+	NMConnectivityPrivate *priv;
+	ConCheckCbData *cb_data = user_data;
+	GSimpleAsyncResult *simple = cb_data->simple;
+	NMConnectivityState new_state;
+
+	self = NM_CONNECTIVITY (g_async_result_get_source_object (G_ASYNC_RESULT (simple)));
+	/* it is safe to unref @self here, @simple holds yet another reference. */
+	g_object_unref (self);
+	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+
+	new_state = _check_response_to_state (msg, cb_data->uri, cb_data->response, "");
+
 	/* Only update the state, if the call was done from external, or if the periodic check
 	 * is still the one that called this async check. */
 	if (!cb_data->check_id_when_scheduled || cb_data->check_id_when_scheduled == priv->check_id) {
@@ -327,6 +336,254 @@ nm_connectivity_check_finish (NMConnectivity  *self,
 
 /**************************************************************************/
 
+/* Per-device probes.
+ *
+ * Unlike the global check, each probe has its own SoupSession bound to the
+ * local address of its device, and keeps the connection to the server open
+ * between checks. The interval adapts to the result: while the state is
+ * not full connectivity it starts at PROBE_DEGRADED_INTERVAL, while it is
+ * full at PROBE_STABLE_INTERVAL, and it doubles with every further identical
+ * result up to the configured interval. Every delay is jittered by 10% so
+ * that the probes of several devices don't stay in lockstep. */
+
+#define PROBE_DEGRADED_INTERVAL  5
+#define PROBE_STABLE_INTERVAL    30
+
+struct _NMConnectivityProbe {
+	NMConnectivity *self;
+	char *ifname;
+	char *log_prefix;
+	NMConnectivityProbeCallback callback;
+	gpointer user_data;
+
+	NMConnectivityState state;
+	guint n_same;
+	guint timeout_id;
+
+#if WITH_CONCHECK
+	SoupSession *session;
+	/* the request in flight, and the data of its callback */
+	SoupMessage *msg;
+	struct _NMConnectivityProbe **msg_handle;
+	gint64 sent_at;
+	char *uri;
+	char *response;
+#endif
+};
+
+#if WITH_CONCHECK
+static void _probe_schedule (NMConnectivityProbe *probe);
+
+/* schedules the next probe and notifies the owner, who is allowed to
+ * free @probe from the callback. */
+static void
+_probe_report (NMConnectivityProbe *probe, NMConnectivityState state, guint latency_msec)
+{
+	if (probe->state == state)
+		probe->n_same++;
+	else {
+		probe->state = state;
+		probe->n_same = 0;
+	}
+	_probe_schedule (probe);
+	probe->callback (probe, state, latency_msec, probe->user_data);
+}
+
+static void
+_probe_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	NMConnectivityProbe **handle = user_data;
+	NMConnectivityProbe *probe = *handle;
+	NMConnectivityState state;
+	guint latency_msec;
+
+	g_free (handle);
+
+	/* the probe was freed meanwhile */
+	if (!probe)
+		return;
+
+	probe->msg = NULL;
+	probe->msg_handle = NULL;
+	latency_msec = (g_get_monotonic_time () - probe->sent_at) / 1000;
+
+	state = _check_response_to_state (msg, probe->uri, probe->response, probe->log_prefix);
+	_probe_report (probe, state, state == NM_CONNECTIVITY_FULL ? latency_msec : 0);
+}
+
+static gboolean
+_probe_run (gpointer user_data)
+{
+	NMConnectivityProbe *probe = user_data;
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (probe->self);
+
+	probe->timeout_id = 0;
+
+	if (!priv->uri || !priv->interval) {
+		_probe_report (probe, NM_CONNECTIVITY_UNKNOWN, 0);
+		return G_SOURCE_REMOVE;
+	}
+
+	if (g_strcmp0 (probe->uri, priv->uri)) {
+		g_free (probe->uri);
+		probe->uri = g_strdup (priv->uri);
+	}
+	if (g_strcmp0 (probe->response, priv->response)) {
+		g_free (probe->response);
+		probe->response = g_strdup (priv->response);
+	}
+
+	probe->msg = soup_message_new ("GET", probe->uri);
+	if (!probe->msg) {
+		_probe_report (probe, NM_CONNECTIVITY_UNKNOWN, 0);
+		return G_SOURCE_REMOVE;
+	}
+	soup_message_set_flags (probe->msg, SOUP_MESSAGE_NO_REDIRECT);
+	probe->sent_at = g_get_monotonic_time ();
+
+	probe->msg_handle = g_new (NMConnectivityProbe *, 1);
+	*probe->msg_handle = probe;
+
+	_LOGT ("%scheck: send request to '%s'", probe->log_prefix, probe->uri);
+	soup_session_queue_message (probe->session, probe->msg, _probe_cb, probe->msg_handle);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_probe_schedule (NMConnectivityProbe *probe)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (probe->self);
+	guint interval;
+	guint msec;
+
+	interval = probe->state == NM_CONNECTIVITY_FULL
+	           ? PROBE_STABLE_INTERVAL
+	           : PROBE_DEGRADED_INTERVAL;
+	interval <<= MIN (probe->n_same, 6u);
+	if (priv->interval)
+		interval = MIN (interval, priv->interval);
+
+	msec = interval * 1000;
+	msec = msec - msec / 10 + g_random_int_range (0, msec / 5 + 1);
+
+	nm_clear_g_source (&probe->timeout_id);
+	probe->timeout_id = g_timeout_add (msec, _probe_run, probe);
+}
+
+static SoupSession *
+_probe_session_new (const char *ifname, const char *local_address)
+{
+	static gboolean warned = FALSE;
+	SoupAddress *address;
+	SoupSession *session;
+	GObjectClass *klass;
+	gboolean supported;
+
+	/* binding to a local address needs libsoup 2.42 */
+	klass = g_type_class_ref (SOUP_TYPE_SESSION_ASYNC);
+	supported = !!g_object_class_find_property (klass, "local-address");
+	g_type_class_unref (klass);
+
+	if (local_address && supported) {
+		address = soup_address_new (local_address, SOUP_ADDRESS_ANY_PORT);
+		session = g_object_new (SOUP_TYPE_SESSION_ASYNC,
+		                        SOUP_SESSION_TIMEOUT, 15,
+		                        SOUP_SESSION_MAX_CONNS_PER_HOST, 1,
+		                        "local-address", address,
+		                        NULL);
+		g_object_unref (address);
+		return session;
+	}
+
+	if (local_address && !warned) {
+		_LOGW ("libsoup can't bind to a local address; the probe of %s uses the default route", ifname);
+		warned = TRUE;
+	}
+	return g_object_new (SOUP_TYPE_SESSION_ASYNC,
+	                     SOUP_SESSION_TIMEOUT, 15,
+	                     SOUP_SESSION_MAX_CONNS_PER_HOST, 1,
+	                     NULL);
+}
+#endif
+
+/**
+ * nm_connectivity_probe_new:
+ * @self: the #NMConnectivity whose URI, response and interval to use
+ * @ifname: the interface, for logging
+ * @local_address: (allow-none): the address of the interface to send
+ *   the requests from
+ * @callback: called with the result of every probe
+ * @user_data: data for @callback
+ *
+ * Starts probing the connectivity of a single device. The first probe is
+ * sent right away.
+ *
+ * Returns: the probe, to be freed with nm_connectivity_probe_free(). %NULL
+ *   if connectivity checking is not supported.
+ */
+NMConnectivityProbe *
+nm_connectivity_probe_new (NMConnectivity *self,
+                           const char *ifname,
+                           const char *local_address,
+                           NMConnectivityProbeCallback callback,
+                           gpointer user_data)
+{
+#if WITH_CONCHECK
+	NMConnectivityProbe *probe;
+
+	g_return_val_if_fail (NM_IS_CONNECTIVITY (self), NULL);
+	g_return_val_if_fail (ifname, NULL);
+	g_return_val_if_fail (callback, NULL);
+
+	probe = g_slice_new0 (NMConnectivityProbe);
+	probe->self = g_object_ref (self);
+	probe->ifname = g_strdup (ifname);
+	probe->log_prefix = g_strdup_printf ("(%s): ", ifname);
+	probe->callback = callback;
+	probe->user_data = user_data;
+	probe->state = NM_CONNECTIVITY_UNKNOWN;
+	probe->session = _probe_session_new (ifname, local_address);
+
+	_LOGD ("%sstart probing%s%s", probe->log_prefix,
+	       local_address ? " from " : "",
+	       local_address ?: "");
+
+	probe->timeout_id = g_idle_add (_probe_run, probe);
+	return probe;
+#else
+	return NULL;
+#endif
+}
+
+void
+nm_connectivity_probe_free (NMConnectivityProbe *probe)
+{
+	if (!probe)
+		return;
+
+#if WITH_CONCHECK
+	_LOGD ("%sstop probing", probe->log_prefix);
+
+	nm_clear_g_source (&probe->timeout_id);
+	if (probe->msg) {
+		/* the callback is still invoked, maybe later */
+		*probe->msg_handle = NULL;
+		soup_session_cancel_message (probe->session, probe->msg, SOUP_STATUS_CANCELLED);
+	}
+	soup_session_abort (probe->session);
+	g_object_unref (probe->session);
+	g_free (probe->uri);
+	g_free (probe->response);
+#endif
+
+	g_object_unref (probe->self);
+	g_free (probe->ifname);
+	g_free (probe->log_prefix);
+	g_slice_free (NMConnectivityProbe, probe);
+}
+
+/**************************************************************************/
+
 NMConnectivity *
 nm_connectivity_new (const char *uri,
                      guint interval,
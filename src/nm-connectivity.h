@@ -66,4 +66,18 @@ NMConnectivityState  nm_connectivity_check_finish (NMConnectivity       *self,
                                                    GAsyncResult         *result,
                                                    GError              **error);
 
+typedef struct _NMConnectivityProbe NMConnectivityProbe;
+
+typedef void (*NMConnectivityProbeCallback) (NMConnectivityProbe *probe,
+                                             NMConnectivityState state,
+                                             guint latency_msec,
+                                             gpointer user_data);
+
+NMConnectivityProbe *nm_connectivity_probe_new  (NMConnectivity              *self,
+                                                 const char                  *ifname,
+                                                 const char                  *local_address,
+                                                 NMConnectivityProbeCallback  callback,
+                                                 gpointer                     user_data);
+void                 nm_connectivity_probe_free (NMConnectivityProbe         *probe);
+
 #endif /* __NETWORKMANAGER_CONNECTIVITY_H__ */
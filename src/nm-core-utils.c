@@ -366,6 +366,241 @@ nm_utils_array_remove_at_indexes (GArray *array, const guint *indexes_to_delete,
 	g_array_set_size (array, res_length);
 }
 
+/*****************************************************************************/
+
+/**
+ * nm_utils_array_index_lookup:
+ * @index: the cached index for @array
+ * @array: the array to search
+ * @hash_func: hashes an element of @array by its identity
+ * @equal_func: compares two elements by their identity. It must be
+ *   consistent with @hash_func.
+ * @needle: the element to look up. It doesn't need to be part of @array.
+ *
+ * Looks up the first element in @array with the same identity as @needle.
+ * The hash index is built lazily and kept in @index. Elements appended to
+ * the array since the previous lookup are picked up incrementally, but
+ * the caller must nm_utils_array_index_clear() the index whenever existing
+ * elements are removed, reordered or change their identity.
+ *
+ * Returns: the position of the first matching element or -1.
+ */
+int
+nm_utils_array_index_lookup (NMUtilsArrayIndex *index,
+                             const GArray *array,
+                             GHashFunc hash_func,
+                             GEqualFunc equal_func,
+                             gconstpointer needle)
+{
+	gsize elt_size;
+	gpointer value;
+	guint i;
+
+	nm_assert (index);
+	nm_assert (array);
+	nm_assert (needle);
+
+	if (array->len == 0)
+		return -1;
+
+	if (!index->idx)
+		index->idx = g_hash_table_new (hash_func, equal_func);
+	else if (   index->data != array->data
+	         || index->len > array->len) {
+		/* the array was reallocated. The keys point into the old buffer. */
+		g_hash_table_remove_all (index->idx);
+		index->len = 0;
+	}
+
+	elt_size = g_array_get_element_size ((GArray *) array);
+	for (i = index->len; i < array->len; i++) {
+		gpointer elt = &array->data[i * elt_size];
+
+		/* the first element of a given identity wins. */
+		if (!g_hash_table_contains (index->idx, elt))
+			g_hash_table_insert (index->idx, elt, GUINT_TO_POINTER (i));
+	}
+	index->data = array->data;
+	index->len = array->len;
+
+	if (!g_hash_table_lookup_extended (index->idx, needle, NULL, &value))
+		return -1;
+	return (int) GPOINTER_TO_UINT (value);
+}
+
+/**
+ * nm_utils_array_index_subtract:
+ * @dst: the array to remove elements from
+ * @dst_idx: the cached index for @dst
+ * @src: the elements to remove
+ * @hash_func: hashes an element by its identity
+ * @equal_func: compares two elements by their identity
+ *
+ * Each element of @src removes the first not yet removed element of @dst with
+ * the same identity, the same as looking up and removing them one by one.
+ * But @dst is compacted in one pass, preserving the order of the remaining
+ * elements.
+ *
+ * Returns: whether any element was removed.
+ */
+gboolean
+nm_utils_array_index_subtract (GArray *dst,
+                               NMUtilsArrayIndex *dst_idx,
+                               const GArray *src,
+                               GHashFunc hash_func,
+                               GEqualFunc equal_func)
+{
+	gs_free gboolean *deleted = NULL;
+	gsize elt_size;
+	guint n_deleted = 0;
+	guint i, j, n;
+	int idx;
+
+	if (!dst->len || !src->len)
+		return FALSE;
+
+	elt_size = g_array_get_element_size (dst);
+	for (i = 0; i < src->len; i++) {
+		gconstpointer needle = &src->data[i * elt_size];
+
+		idx = nm_utils_array_index_lookup (dst_idx, dst, hash_func, equal_func, needle);
+		if (idx < 0)
+			continue;
+
+		if (!deleted)
+			deleted = g_new0 (gboolean, dst->len);
+
+		if (deleted[idx]) {
+			/* already removed. Duplicates in @dst are rare, search for the next one. */
+			for (j = idx + 1; j < dst->len; j++) {
+				if (!deleted[j] && equal_func (&dst->data[j * elt_size], needle))
+					break;
+			}
+			if (j >= dst->len)
+				continue;
+			idx = j;
+		}
+		deleted[idx] = TRUE;
+		n_deleted++;
+	}
+
+	if (!n_deleted)
+		return FALSE;
+
+	for (i = 0, n = 0; i < dst->len; i++) {
+		if (deleted[i])
+			continue;
+		if (n != i)
+			memcpy (&dst->data[n * elt_size], &dst->data[i * elt_size], elt_size);
+		n++;
+	}
+	g_array_set_size (dst, n);
+	nm_utils_array_index_clear (dst_idx);
+	return TRUE;
+}
+
+/**
+ * nm_utils_array_index_intersect:
+ * @dst: the array to remove elements from
+ * @dst_idx: the cached index for @dst
+ * @src: the elements to keep
+ * @src_idx: the cached index for @src
+ * @hash_func: hashes an element by its identity
+ * @equal_func: compares two elements by their identity
+ *
+ * Removes all elements from @dst whose identity is not found in @src,
+ * preserving the order of the remaining elements.
+ *
+ * Returns: whether any element was removed.
+ */
+gboolean
+nm_utils_array_index_intersect (GArray *dst,
+                                NMUtilsArrayIndex *dst_idx,
+                                const GArray *src,
+                                NMUtilsArrayIndex *src_idx,
+                                GHashFunc hash_func,
+                                GEqualFunc equal_func)
+{
+	gsize elt_size;
+	guint i, n;
+
+	elt_size = g_array_get_element_size (dst);
+	for (i = 0, n = 0; i < dst->len; i++) {
+		gconstpointer elt = &dst->data[i * elt_size];
+
+		if (nm_utils_array_index_lookup (src_idx, src, hash_func, equal_func, elt) < 0)
+			continue;
+		if (n != i)
+			memcpy (&dst->data[n * elt_size], elt, elt_size);
+		n++;
+	}
+
+	if (n == dst->len)
+		return FALSE;
+
+	g_array_set_size (dst, n);
+	nm_utils_array_index_clear (dst_idx);
+	return TRUE;
+}
+
+void
+nm_utils_array_index_clear (NMUtilsArrayIndex *index)
+{
+	if (index->idx && index->len)
+		g_hash_table_remove_all (index->idx);
+	index->data = NULL;
+	index->len = 0;
+}
+
+void
+nm_utils_array_index_destroy (NMUtilsArrayIndex *index)
+{
+	g_clear_pointer (&index->idx, g_hash_table_unref);
+	index->data = NULL;
+	index->len = 0;
+}
+
+/**
+ * nm_utils_digest_mem:
+ * @digest: the digest so far, start with %NM_UTILS_DIGEST_INIT
+ * @data: the data to fold in
+ * @len: number of bytes in @data
+ *
+ * Returns: @digest updated with @data. The length is folded in too, so
+ * that consecutive buffers cannot run into each other.
+ */
+guint64
+nm_utils_digest_mem (guint64 digest, gconstpointer data, gsize len)
+{
+	const guint8 *p = data;
+	gsize i;
+
+	for (i = 0; i + sizeof (guint32) <= len; i += sizeof (guint32)) {
+		guint32 v;
+
+		memcpy (&v, &p[i], sizeof (v));
+		digest = nm_utils_digest_u32 (digest, v);
+	}
+	for (; i < len; i++)
+		digest = nm_utils_digest_u32 (digest, p[i] | 0x100);
+	return nm_utils_digest_u64 (digest, len);
+}
+
+/**
+ * nm_utils_digest_str:
+ * @digest: the digest so far
+ * @str: (allow-none): the string to fold in
+ *
+ * Returns: @digest updated with @str. %NULL and "" give different results.
+ */
+guint64
+nm_utils_digest_str (guint64 digest, const char *str)
+{
+	if (!str)
+		return nm_utils_digest_u64 (digest, G_MAXUINT64);
+	return nm_utils_digest_mem (digest, str, strlen (str));
+}
+
 int
 nm_spawn_process (const char *args, GError **error)
 {
@@ -1271,9 +1506,14 @@ nm_match_spec_hwaddr (const GSList *specs, const char *hwaddr)
 {
 	const GSList *iter;
 	NMMatchSpecMatchType match = NM_MATCH_SPEC_NO_MATCH;
+	NMHwAddr addr;
 
 	g_return_val_if_fail (hwaddr != NULL, NM_MATCH_SPEC_NO_MATCH);
 
+	/* an invalid address matches no spec */
+	if (!_nm_hwaddr_from_str (&addr, hwaddr))
+		return NM_MATCH_SPEC_NO_MATCH;
+
 	for (iter = specs; iter; iter = g_slist_next (iter)) {
 		const char *spec_str = iter->data;
 		gboolean except;
@@ -1293,7 +1533,7 @@ nm_match_spec_hwaddr (const GSList *specs, const char *hwaddr)
 		else if (except)
 			continue;
 
-		if (nm_utils_hwaddr_matches (spec_str, -1, hwaddr, -1)) {
+		if (_nm_hwaddr_matches_str (&addr, spec_str)) {
 			if (except)
 				return NM_MATCH_SPEC_NEG_MATCH;
 			match = NM_MATCH_SPEC_MATCH;
@@ -1452,6 +1692,291 @@ nm_match_spec_s390_subchannels (const GSList *specs, const char *subchannels)
 	return match;
 }
 
+/*****************************************************************************/
+
+/* Lists of device specs are usually evaluated again and again for the same
+ * devices, while they only change on config reload. NMMatchSpecCompiled
+ * sorts the specs once by their kind: exact interface names, MAC addresses
+ * and device types go into hash tables, interface name patterns are
+ * compiled to GPatternSpec and s390 subchannels are parsed. The result is
+ * the same as combining nm_match_spec_interface_name(), nm_match_spec_hwaddr(),
+ * nm_match_spec_device_type() and nm_match_spec_s390_subchannels().
+ *
+ * If there are patterns, results are also cached per device so that only
+ * the first lookup pays for them. */
+
+#define MATCH_SPEC_CACHE_MAX 256
+
+typedef struct {
+	guint32 a, b, c;
+} MatchSpecSubchannels;
+
+typedef struct {
+	GHashTable *interface_names;
+	GPtrArray *interface_patterns;
+	GHashTable *hwaddrs;
+	GHashTable *device_types;
+	GArray *subchannels;
+} MatchSpecCompiledSet;
+
+struct _NMMatchSpecCompiled {
+	/* [0] holds the regular specs, [1] the ones with "except:" */
+	MatchSpecCompiledSet sets[2];
+	gboolean match_all;
+	GHashTable *cache;
+};
+
+static char *
+_match_spec_hwaddr_key (const char *hwaddr)
+{
+	char *canonical;
+	gsize len;
+
+	canonical = nm_utils_hwaddr_canonical (hwaddr, -1);
+	if (!canonical)
+		return NULL;
+
+	/* Like nm_utils_hwaddr_matches(), only compare the last 8 bytes of
+	 * InfiniBand addresses. */
+	len = strlen (canonical);
+	if (len == INFINIBAND_ALEN * 3 - 1) {
+		char *key;
+
+		key = g_strconcat ("ib:", &canonical[(INFINIBAND_ALEN - 8) * 3], NULL);
+		g_free (canonical);
+		return key;
+	}
+	return canonical;
+}
+
+static void
+_match_spec_set_add (GHashTable **table, char *key)
+{
+	if (!*table)
+		*table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_add (*table, key);
+}
+
+/**
+ * nm_match_spec_compile:
+ * @specs: (element-type utf8): a list of device specs
+ *
+ * Returns: (transfer full): the compiled form of @specs, to be freed
+ *   with nm_match_spec_compiled_free(). %NULL if @specs is empty.
+ */
+NMMatchSpecCompiled *
+nm_match_spec_compile (const GSList *specs)
+{
+	NMMatchSpecCompiled *compiled;
+	const GSList *iter;
+
+	if (!specs)
+		return NULL;
+
+	compiled = g_slice_new0 (NMMatchSpecCompiled);
+
+	for (iter = specs; iter; iter = g_slist_next (iter)) {
+		const char *spec_str = iter->data;
+		MatchSpecCompiledSet *set;
+		gboolean except;
+		char *key;
+
+		if (!spec_str || !*spec_str)
+			continue;
+
+		if (!strcmp (spec_str, "*")) {
+			compiled->match_all = TRUE;
+			continue;
+		}
+
+		spec_str = _match_except (spec_str, &except);
+		set = &compiled->sets[except];
+
+		if (_spec_has_prefix (&spec_str, DEVICE_TYPE_TAG)) {
+			if (*spec_str)
+				_match_spec_set_add (&set->device_types, g_strdup (spec_str));
+		} else if (_spec_has_prefix (&spec_str, SUBCHAN_TAG)) {
+			MatchSpecSubchannels s = { 0 };
+
+			if (parse_subchannels (spec_str, &s.a, &s.b, &s.c)) {
+				if (!set->subchannels)
+					set->subchannels = g_array_new (FALSE, FALSE, sizeof (MatchSpecSubchannels));
+				g_array_append_val (set->subchannels, s);
+			}
+		} else if (_spec_has_prefix (&spec_str, INTERFACE_NAME_TAG)) {
+			if (spec_str[0] == '=')
+				_match_spec_set_add (&set->interface_names, g_strdup (&spec_str[1]));
+			else {
+				if (spec_str[0] == '~')
+					spec_str++;
+				if (strpbrk (spec_str, "*?")) {
+					if (!set->interface_patterns)
+						set->interface_patterns = g_ptr_array_new_with_free_func ((GDestroyNotify) g_pattern_spec_free);
+					g_ptr_array_add (set->interface_patterns, g_pattern_spec_new (spec_str));
+				} else
+					_match_spec_set_add (&set->interface_names, g_strdup (spec_str));
+			}
+		} else if (_spec_has_prefix (&spec_str, MAC_TAG)) {
+			key = _match_spec_hwaddr_key (spec_str);
+			if (key)
+				_match_spec_set_add (&set->hwaddrs, key);
+		} else if (!except) {
+			/* untagged specs are both an interface name and a MAC address */
+			_match_spec_set_add (&set->interface_names, g_strdup (spec_str));
+			key = _match_spec_hwaddr_key (spec_str);
+			if (key)
+				_match_spec_set_add (&set->hwaddrs, key);
+		}
+	}
+
+	if (compiled->sets[0].interface_patterns || compiled->sets[1].interface_patterns)
+		compiled->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	return compiled;
+}
+
+void
+nm_match_spec_compiled_free (NMMatchSpecCompiled *compiled)
+{
+	guint i;
+
+	if (!compiled)
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS (compiled->sets); i++) {
+		MatchSpecCompiledSet *set = &compiled->sets[i];
+
+		if (set->interface_names)
+			g_hash_table_unref (set->interface_names);
+		if (set->interface_patterns)
+			g_ptr_array_unref (set->interface_patterns);
+		if (set->hwaddrs)
+			g_hash_table_unref (set->hwaddrs);
+		if (set->device_types)
+			g_hash_table_unref (set->device_types);
+		if (set->subchannels)
+			g_array_unref (set->subchannels);
+	}
+	if (compiled->cache)
+		g_hash_table_unref (compiled->cache);
+	g_slice_free (NMMatchSpecCompiled, compiled);
+}
+
+static gboolean
+_match_spec_set_matches (const MatchSpecCompiledSet *set,
+                         const char *interface_name,
+                         const char *hwaddr_key,
+                         const char *device_type,
+                         const MatchSpecSubchannels *subchannels)
+{
+	guint i;
+
+	if (interface_name) {
+		if (   set->interface_names
+		    && g_hash_table_contains (set->interface_names, interface_name))
+			return TRUE;
+		if (set->interface_patterns) {
+			for (i = 0; i < set->interface_patterns->len; i++) {
+				if (g_pattern_match_string (set->interface_patterns->pdata[i], interface_name))
+					return TRUE;
+			}
+		}
+	}
+
+	if (   hwaddr_key
+	    && set->hwaddrs
+	    && g_hash_table_contains (set->hwaddrs, hwaddr_key))
+		return TRUE;
+
+	if (   device_type
+	    && set->device_types
+	    && g_hash_table_contains (set->device_types, device_type))
+		return TRUE;
+
+	if (subchannels && set->subchannels) {
+		for (i = 0; i < set->subchannels->len; i++) {
+			const MatchSpecSubchannels *s = &g_array_index (set->subchannels, MatchSpecSubchannels, i);
+
+			if (   s->a == subchannels->a
+			    && s->b == subchannels->b
+			    && s->c == subchannels->c)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * nm_match_spec_compiled_match:
+ * @compiled: (allow-none): the result of nm_match_spec_compile()
+ * @interface_name: (allow-none): the interface name of the device
+ * @hwaddr: (allow-none): the hardware address of the device
+ * @device_type: (allow-none): the type description of the device
+ * @s390_subchannels: (allow-none): the s390 subchannels of the device
+ *
+ * Returns: whether the device matches the compiled specs, the same way
+ * as if all nm_match_spec_*() functions were combined on the original list.
+ */
+NMMatchSpecMatchType
+nm_match_spec_compiled_match (NMMatchSpecCompiled *compiled,
+                              const char *interface_name,
+                              const char *hwaddr,
+                              const char *device_type,
+                              const char *s390_subchannels)
+{
+	gs_free char *hwaddr_key = NULL;
+	MatchSpecSubchannels subchannels = { 0 };
+	gboolean has_subchannels = FALSE;
+	NMMatchSpecMatchType match;
+	char cache_key[256];
+	gboolean use_cache = FALSE;
+	gpointer cached;
+
+	if (!compiled)
+		return NM_MATCH_SPEC_NO_MATCH;
+
+	if (compiled->cache) {
+		int len;
+
+		len = g_snprintf (cache_key, sizeof (cache_key), "%s|%s|%s|%s",
+		                  interface_name ?: "",
+		                  hwaddr ?: "",
+		                  device_type ?: "",
+		                  s390_subchannels ?: "");
+		if (len >= 0 && len < (int) sizeof (cache_key)) {
+			use_cache = TRUE;
+			if (g_hash_table_lookup_extended (compiled->cache, cache_key, NULL, &cached))
+				return GPOINTER_TO_INT (cached);
+		}
+	}
+
+	if (hwaddr && (compiled->sets[0].hwaddrs || compiled->sets[1].hwaddrs))
+		hwaddr_key = _match_spec_hwaddr_key (hwaddr);
+	if (device_type && !*device_type)
+		device_type = NULL;
+	if (s390_subchannels && (compiled->sets[0].subchannels || compiled->sets[1].subchannels))
+		has_subchannels = parse_subchannels (s390_subchannels, &subchannels.a, &subchannels.b, &subchannels.c);
+
+	if (_match_spec_set_matches (&compiled->sets[1], interface_name, hwaddr_key,
+	                             device_type, has_subchannels ? &subchannels : NULL))
+		match = NM_MATCH_SPEC_NEG_MATCH;
+	else if (   compiled->match_all
+	         || _match_spec_set_matches (&compiled->sets[0], interface_name, hwaddr_key,
+	                                     device_type, has_subchannels ? &subchannels : NULL))
+		match = NM_MATCH_SPEC_MATCH;
+	else
+		match = NM_MATCH_SPEC_NO_MATCH;
+
+	if (use_cache) {
+		if (g_hash_table_size (compiled->cache) >= MATCH_SPEC_CACHE_MAX)
+			g_hash_table_remove_all (compiled->cache);
+		g_hash_table_insert (compiled->cache, g_strdup (cache_key), GINT_TO_POINTER (match));
+	}
+
+	return match;
+}
+
 static gboolean
 _match_config_nm_version (const char *str, const char *tag, guint cur_nm_version)
 {
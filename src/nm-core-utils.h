@@ -151,6 +151,16 @@ NMMatchSpecMatchType nm_match_spec_match_config (const GSList *specs, guint nm_v
 GSList *nm_match_spec_split (const char *value);
 char *nm_match_spec_join (GSList *specs);
 
+typedef struct _NMMatchSpecCompiled NMMatchSpecCompiled;
+
+NMMatchSpecCompiled *nm_match_spec_compile (const GSList *specs);
+void nm_match_spec_compiled_free (NMMatchSpecCompiled *compiled);
+NMMatchSpecMatchType nm_match_spec_compiled_match (NMMatchSpecCompiled *compiled,
+                                                   const char *interface_name,
+                                                   const char *hwaddr,
+                                                   const char *device_type,
+                                                   const char *s390_subchannels);
+
 extern char _nm_utils_to_string_buffer[2096];
 
 void     nm_utils_to_string_buffer_init (char **buf, gsize *len);
@@ -355,6 +365,53 @@ void nm_utils_ipv6_interface_identfier_get_from_addr (NMUtilsIPv6IfaceId *iid,
 
 void nm_utils_array_remove_at_indexes (GArray *array, const guint *indexes_to_delete, gsize len);
 
+typedef struct {
+	GHashTable *idx;
+	gconstpointer data;
+	guint len;
+} NMUtilsArrayIndex;
+
+int nm_utils_array_index_lookup (NMUtilsArrayIndex *index,
+                                 const GArray *array,
+                                 GHashFunc hash_func,
+                                 GEqualFunc equal_func,
+                                 gconstpointer needle);
+gboolean nm_utils_array_index_subtract (GArray *dst,
+                                        NMUtilsArrayIndex *dst_idx,
+                                        const GArray *src,
+                                        GHashFunc hash_func,
+                                        GEqualFunc equal_func);
+gboolean nm_utils_array_index_intersect (GArray *dst,
+                                         NMUtilsArrayIndex *dst_idx,
+                                         const GArray *src,
+                                         NMUtilsArrayIndex *src_idx,
+                                         GHashFunc hash_func,
+                                         GEqualFunc equal_func);
+void nm_utils_array_index_clear (NMUtilsArrayIndex *index);
+void nm_utils_array_index_destroy (NMUtilsArrayIndex *index);
+
+/* A cheap 64 bit digest for detecting changes within one process. It is
+ * neither stable across versions nor cryptographically strong; use
+ * GChecksum where either matters. */
+#define NM_UTILS_DIGEST_INIT ((guint64) 0xcbf29ce484222325ull)
+
+static inline guint64
+nm_utils_digest_u32 (guint64 digest, guint32 v)
+{
+	digest ^= v;
+	digest *= 0x9e3779b97f4a7c15ull;
+	return digest ^ (digest >> 32);
+}
+
+static inline guint64
+nm_utils_digest_u64 (guint64 digest, guint64 v)
+{
+	return nm_utils_digest_u32 (nm_utils_digest_u32 (digest, (guint32) v), (guint32) (v >> 32));
+}
+
+guint64 nm_utils_digest_mem (guint64 digest, gconstpointer data, gsize len);
+guint64 nm_utils_digest_str (guint64 digest, const char *str);
+
 void nm_utils_setpgid (gpointer unused);
 
 typedef enum {
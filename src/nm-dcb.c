@@ -29,6 +29,10 @@
 
 static const char *helper_names[] = { "dcbtool", "fcoeadm" };
 
+#define DCB_APP_ETHTYPE_FCOE   0x8906
+#define DCB_APP_ETHTYPE_FIP    0x8914
+#define DCB_APP_PORT_ISCSI     3260
+
 gboolean
 do_helper (const char *iface,
            guint which,
@@ -284,6 +288,117 @@ _fcoe_cleanup (const char *iface,
 	return do_helper (NULL, FCOEADM, run_func, user_data, error, "-d %s", iface);
 }
 
+static guint8
+_dcb_flags_to_platform (NMSettingDcbFlags flags)
+{
+	if (!(flags & NM_SETTING_DCB_FLAG_ENABLE))
+		return 0;
+	return   NM_PLATFORM_DCB_FEAT_ENABLE
+	       | ((flags & NM_SETTING_DCB_FLAG_WILLING) ? NM_PLATFORM_DCB_FEAT_WILLING : 0)
+	       | ((flags & NM_SETTING_DCB_FLAG_ADVERTISE) ? NM_PLATFORM_DCB_FEAT_ADVERTISE : 0);
+}
+
+static void
+_dcb_app_to_platform (NMPlatformDcbConfig *config,
+                      NMSettingDcbFlags flags,
+                      int priority,
+                      guint8 idtype,
+                      guint16 id)
+{
+	if (!(flags & NM_SETTING_DCB_FLAG_ENABLE) || priority < 0)
+		return;
+
+	config->apps[config->n_apps].idtype = idtype;
+	config->apps[config->n_apps].id = id;
+	config->apps[config->n_apps].up_map = 1 << priority;
+	config->n_apps++;
+}
+
+/**
+ * _dcb_to_platform_config:
+ * @s_dcb: the DCB setting
+ * @config: (out): the configuration for nm_platform_link_set_dcb()
+ *
+ * Converts @s_dcb to the CEE configuration of the kernel driver. The
+ * per-priority settings of priority groups are regrouped by traffic class,
+ * like lldpad does when it applies "pg" to the driver.
+ */
+void
+_dcb_to_platform_config (NMSettingDcb *s_dcb, NMPlatformDcbConfig *config)
+{
+	NMSettingDcbFlags flags;
+	guint i;
+
+	g_return_if_fail (NM_IS_SETTING_DCB (s_dcb));
+	g_return_if_fail (config);
+
+	memset (config, 0, sizeof (*config));
+
+	/* CEE knows only one set of flags for all applications */
+	flags = nm_setting_dcb_get_app_fcoe_flags (s_dcb);
+	_dcb_app_to_platform (config, flags, nm_setting_dcb_get_app_fcoe_priority (s_dcb),
+	                      NM_PLATFORM_DCB_APP_IDTYPE_ETHTYPE, DCB_APP_ETHTYPE_FCOE);
+	config->app_flags |= _dcb_flags_to_platform (flags);
+
+	flags = nm_setting_dcb_get_app_iscsi_flags (s_dcb);
+	_dcb_app_to_platform (config, flags, nm_setting_dcb_get_app_iscsi_priority (s_dcb),
+	                      NM_PLATFORM_DCB_APP_IDTYPE_PORTNUM, DCB_APP_PORT_ISCSI);
+	config->app_flags |= _dcb_flags_to_platform (flags);
+
+	flags = nm_setting_dcb_get_app_fip_flags (s_dcb);
+	_dcb_app_to_platform (config, flags, nm_setting_dcb_get_app_fip_priority (s_dcb),
+	                      NM_PLATFORM_DCB_APP_IDTYPE_ETHTYPE, DCB_APP_ETHTYPE_FIP);
+	config->app_flags |= _dcb_flags_to_platform (flags);
+
+	/* Priority Flow Control */
+	config->pfc_flags = _dcb_flags_to_platform (nm_setting_dcb_get_priority_flow_control_flags (s_dcb));
+	if (config->pfc_flags) {
+		for (i = 0; i < 8; i++) {
+			if (nm_setting_dcb_get_priority_flow_control (s_dcb, i))
+				config->pfc_up |= 1 << i;
+		}
+	}
+
+	/* Priority Groups */
+	config->pg_flags = _dcb_flags_to_platform (nm_setting_dcb_get_priority_group_flags (s_dcb));
+	if (config->pg_flags) {
+		for (i = 0; i < 8; i++)
+			config->pg_bw_pct[i] = nm_setting_dcb_get_priority_group_bandwidth (s_dcb, i);
+
+		for (i = 0; i < 8; i++) {
+			guint tc = nm_setting_dcb_get_priority_traffic_class (s_dcb, i);
+			guint bw;
+
+			g_assert (tc < 8);
+
+			config->pg_tc[tc].pgid = nm_setting_dcb_get_priority_group_id (s_dcb, i);
+			config->pg_tc[tc].up_mapping |= 1 << i;
+			bw = config->pg_tc[tc].bw_pct + nm_setting_dcb_get_priority_bandwidth (s_dcb, i);
+			config->pg_tc[tc].bw_pct = MIN (bw, 100);
+			if (nm_setting_dcb_get_priority_strict_bandwidth (s_dcb, i))
+				config->pg_tc[tc].strict = 2;
+		}
+	}
+}
+
+/* Configures DCB through the dcbnl operations of the driver, when it
+ * has them. */
+static gboolean
+_dcb_set_platform (const char *iface, gboolean enable, const NMPlatformDcbConfig *config)
+{
+	int ifindex;
+
+	ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, iface);
+	if (ifindex <= 0)
+		return FALSE;
+
+	if (!nm_platform_link_set_dcb (NM_PLATFORM_GET, ifindex, enable, config)) {
+		nm_log_dbg (LOGD_DCB, "(%s): netlink DCB configuration failed, using dcbtool", iface);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 run_helper (char **argv, guint which, gpointer user_data, GError **error)
 {
@@ -330,15 +445,22 @@ run_helper (char **argv, guint which, gpointer user_data, GError **error)
 gboolean
 nm_dcb_enable (const char *iface, gboolean enable, GError **error)
 {
+	if (_dcb_set_platform (iface, enable, NULL))
+		return TRUE;
 	return _dcb_enable (iface, enable, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
 }
 
 gboolean
 nm_dcb_setup (const char *iface, NMSettingDcb *s_dcb, GError **error)
 {
+	NMPlatformDcbConfig config;
 	gboolean success;
 
-	success = _dcb_setup (iface, s_dcb, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
+	_dcb_to_platform_config (s_dcb, &config);
+	if (_dcb_set_platform (iface, TRUE, &config))
+		success = TRUE;
+	else
+		success = _dcb_setup (iface, s_dcb, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
 	if (success)
 		success = _fcoe_setup (iface, s_dcb, run_helper, GUINT_TO_POINTER (FCOEADM), error);
 
@@ -373,6 +495,8 @@ carrier_wait (const char *iface, guint secs, gboolean up)
 gboolean
 nm_dcb_cleanup (const char *iface, GError **error)
 {
+	const NMPlatformDcbConfig config_off = { 0 };
+
 	/* Ignore FCoE cleanup errors */
 	_fcoe_cleanup (iface, run_helper, GUINT_TO_POINTER (FCOEADM), NULL);
 
@@ -382,6 +506,8 @@ nm_dcb_cleanup (const char *iface, GError **error)
 	carrier_wait (iface, 2, FALSE);
 	carrier_wait (iface, 4, TRUE);
 
+	if (_dcb_set_platform (iface, FALSE, &config_off))
+		return TRUE;
 	return _dcb_cleanup (iface, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
 }
 
@@ -23,6 +23,7 @@
 
 #include "nm-default.h"
 #include "nm-setting-dcb.h"
+#include "nm-platform.h"
 
 gboolean nm_dcb_enable (const char *iface, gboolean enable, GError **error);
 gboolean nm_dcb_setup (const char *iface, NMSettingDcb *s_dcb, GError **error);
@@ -73,4 +74,7 @@ gboolean _fcoe_cleanup (const char *iface,
                         gpointer user_data,
                         GError **error);
 
+void _dcb_to_platform_config (NMSettingDcb *s_dcb,
+                              NMPlatformDcbConfig *config);
+
 #endif /* __NETWORKMANAGER_DCB_H__ */
@@ -27,10 +27,12 @@
 #include "nm-device.h"
 #include "nm-vpn-connection.h"
 #include "nm-platform.h"
+#include "nmp-object.h"
 #include "nm-manager.h"
 #include "nm-ip4-config.h"
 #include "nm-ip6-config.h"
 #include "nm-activation-request.h"
+#include "nm-loop-sched.h"
 
 typedef struct {
 	GPtrArray *entries_ip4;
@@ -38,6 +40,8 @@ typedef struct {
 	struct {
 		guint guard;
 		guint backoff_wait_time_ms;
+		/* with a backoff wait time, a timeout source. Otherwise queued
+		 * with nm_loop_sched_add(). */
 		guint idle_handle;
 		gboolean has_v4_changes;
 		gboolean has_v6_changes;
@@ -80,7 +84,7 @@ NM_DEFINE_SINGLETON_GETTER (NMDefaultRouteManager, nm_default_route_manager_get,
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = __addr_family == AF_INET ? LOGD_IP4 : (__addr_family == AF_INET6 ? LOGD_IP6 : LOGD_IP); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             char __prefix_buf[100]; \
             \
             _nm_log (__level, __domain, 0, \
@@ -104,7 +108,7 @@ NM_DEFINE_SINGLETON_GETTER (NMDefaultRouteManager, nm_default_route_manager_get,
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = __addr_family == AF_INET ? LOGD_IP4 : (__addr_family == AF_INET6 ? LOGD_IP6 : LOGD_IP); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             char __prefix_buf[100]; \
             guint __entry_idx = (entry_idx); \
             const Entry *const __entry = (entry); \
@@ -169,6 +173,12 @@ typedef struct {
 	gboolean synced;
 	gboolean never_default;
 
+	/* For synced IPv4 entries of devices, the ipv4.multipath-weight of the
+	 * applied connection. Consecutive synced entries that have a weight and
+	 * the same metric form a group. They all get the effective metric of the
+	 * first one (the leader), and share one multipath route. */
+	guint multipath_weight;
+
 	guint32 effective_metric;
 } Entry;
 
@@ -188,30 +198,73 @@ _vt_route_index (const VTableIP *vtable, GArray *routes, guint index)
 		return (NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP6Route, index);
 }
 
+static guint
+_vt_route_id_hash (gconstpointer key)
+{
+	const NMPlatformIPRoute *route = key;
+
+	return (((guint) route->ifindex) * 33) + route->metric;
+}
+
 static gboolean
-_vt_routes_has_entry (const VTableIP *vtable, GArray *routes, const Entry *entry)
+_vt_route_id_equal (gconstpointer a, gconstpointer b)
 {
+	const NMPlatformIPRoute *r_a = a;
+	const NMPlatformIPRoute *r_b = b;
+
+	return    r_a->ifindex == r_b->ifindex
+	       && r_a->metric == r_b->metric;
+}
+
+static GHashTable *
+_vt_routes_index_create (const VTableIP *vtable, GArray *routes)
+{
+	GHashTable *index;
+	GSList *list;
 	guint i;
-	NMPlatformIPXRoute route = entry->route;
 
-	route.rx.metric = entry->effective_metric;
+	/* index the platform routes by ifindex and metric. There can be several
+	 * default routes for the same pair, for example with different gateways,
+	 * so each key maps to the list of all of them. The index points
+	 * into @routes. */
+	index = g_hash_table_new_full (_vt_route_id_hash, _vt_route_id_equal, NULL, (GDestroyNotify) g_slist_free);
+	for (i = routes->len; i > 0; i--) {
+		NMPlatformIPRoute *r = _vt_route_index (vtable, routes, i - 1);
+
+		/* prepend in reverse order, so that the lists keep the order of @routes. */
+		list = g_hash_table_lookup (index, r);
+		if (list)
+			g_hash_table_steal (index, r);
+		g_hash_table_insert (index, r, g_slist_prepend (list, r));
+	}
+	return index;
+}
 
-	if (vtable->vt->is_ip4) {
-		for (i = 0; i < routes->len; i++) {
-			NMPlatformIP4Route *r = &g_array_index (routes, NMPlatformIP4Route, i);
+static const GSList *
+_vt_routes_index_lookup (GHashTable *routes_index, int ifindex, guint32 metric)
+{
+	NMPlatformIPRoute needle = { 0 };
 
-			route.rx.rt_source = r->rt_source;
-			if (nm_platform_ip4_route_cmp (r, &route.r4) == 0)
-				return TRUE;
-		}
-	} else {
-		for (i = 0; i < routes->len; i++) {
-			NMPlatformIP6Route *r = &g_array_index (routes, NMPlatformIP6Route, i);
+	needle.ifindex = ifindex;
+	needle.metric = metric;
+	return g_hash_table_lookup (routes_index, &needle);
+}
 
-			route.rx.rt_source = r->rt_source;
-			if (nm_platform_ip6_route_cmp (r, &route.r6) == 0)
-				return TRUE;
-		}
+static gboolean
+_vt_routes_has_entry (const VTableIP *vtable, GHashTable *routes_index, const Entry *entry)
+{
+	const GSList *iter;
+	NMPlatformIPXRoute route = entry->route;
+
+	route.rx.metric = entry->effective_metric;
+	for (iter = _vt_routes_index_lookup (routes_index, entry->route.rx.ifindex, entry->effective_metric);
+	     iter;
+	     iter = iter->next) {
+		const NMPlatformIPRoute *r = iter->data;
+
+		route.rx.rt_source = r->rt_source;
+		if (vtable->vt->route_cmp ((const NMPlatformIPXRoute *) r, &route) == 0)
+			return TRUE;
 	}
 	return FALSE;
 }
@@ -245,36 +298,99 @@ _entry_find_by_source (GPtrArray *entries, gpointer source, guint *out_idx)
 	return NULL;
 }
 
-static gboolean
-_platform_route_sync_add (const VTableIP *vtable, NMDefaultRouteManager *self, guint32 metric)
+static Entry *
+_entry_find_synced_by_metric (GPtrArray *entries, GHashTable *synced_by_metric, int ifindex, guint32 metric)
 {
-	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
-	GPtrArray *entries = vtable->get_entries (priv);
+	Entry *entry;
 	guint i;
-	Entry *entry_unsynced = NULL;
-	Entry *entry = NULL;
-	gboolean success;
 
-	/* Find the entries for the given metric.
+	/* Find the synced entry with a default route for the given effective metric,
+	 * and (if @ifindex is set) for the given ifindex.
 	 * The effective metric for synced entries is choosen in a way that it
-	 * is unique (except for G_MAXUINT32, where a clash is not solvable). */
+	 * is unique (except for G_MAXUINT32, where a clash is not solvable,
+	 * and for the members of a multipath group, which share it). */
+	entry = g_hash_table_lookup (synced_by_metric, GUINT_TO_POINTER (metric));
+	if (!entry)
+		return NULL;
+	if (ifindex == 0 || entry->route.rx.ifindex == ifindex)
+		return entry;
+	if (   metric != G_MAXUINT32
+	    && !entry->multipath_weight)
+		return NULL;
+
 	for (i = 0; i < entries->len; i++) {
 		Entry *e = g_ptr_array_index (entries, i);
 
-		if (e->never_default)
-			continue;
+		if (   e->synced
+		    && !e->never_default
+		    && e->effective_metric == metric
+		    && e->route.rx.ifindex == ifindex)
+			return e;
+	}
+	return NULL;
+}
 
-		if (e->effective_metric != metric)
+static gboolean
+_platform_route_sync_add_multipath (NMDefaultRouteManager *self, GPtrArray *entries, const Entry *leader)
+{
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	gs_unref_array GArray *nexthops = NULL;
+	NMPlatformIP4RouteNexthop hop;
+	guint i;
+
+	/* Collect the nexthops of the group of @leader. Returns FALSE if there is
+	 * only the leader, or if the multipath route could not be added; then the
+	 * leader gets a regular default route. */
+	nexthops = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4RouteNexthop));
+	for (i = 0; i < entries->len; i++) {
+		const Entry *e = g_ptr_array_index (entries, i);
+
+		if (   !e->synced
+		    || e->never_default
+		    || !e->multipath_weight
+		    || e->effective_metric != leader->effective_metric)
 			continue;
 
-		if (e->synced) {
-			g_assert (!entry || metric == G_MAXUINT32);
-			if (!entry)
-				entry = e;
-		} else
-			entry_unsynced = e;
+		hop.ifindex = e->route.rx.ifindex;
+		hop.gateway = e->route.r4.gateway;
+		hop.weight = e->multipath_weight;
+		if (e == leader)
+			g_array_prepend_val (nexthops, hop);
+		else
+			g_array_append_val (nexthops, hop);
 	}
 
+	if (nexthops->len < 2)
+		return FALSE;
+
+	if (nm_platform_ip4_route_add_multipath (priv->platform,
+	                                         leader->route.rx.rt_source,
+	                                         0,
+	                                         0,
+	                                         leader->effective_metric,
+	                                         leader->route.rx.mss,
+	                                         (const NMPlatformIP4RouteNexthop *) nexthops->data,
+	                                         nexthops->len))
+		return TRUE;
+
+	_LOGW (AF_INET, "failed to add multipath default route with %u nexthops and effective metric %u",
+	       nexthops->len, (guint) leader->effective_metric);
+	return FALSE;
+}
+
+static gboolean
+_platform_route_sync_add (const VTableIP *vtable, NMDefaultRouteManager *self, GHashTable *synced_by_metric, GHashTable *unsynced_by_metric, guint32 metric)
+{
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	GPtrArray *entries = vtable->get_entries (priv);
+	Entry *entry_unsynced;
+	Entry *entry;
+	gboolean success;
+
+	/* Find the entries for the given metric. */
+	entry = _entry_find_synced_by_metric (entries, synced_by_metric, 0, metric);
+	entry_unsynced = g_hash_table_lookup (unsynced_by_metric, GUINT_TO_POINTER (metric));
+
 	/* We don't expect to have an unsynced *and* a synced entry for the same metric.
 	 * Unless, (a) their metric is G_MAXUINT32, in which case we could not find an unused effective metric,
 	 * or (b) if we have an unsynced and a synced entry for the same ifindex.
@@ -286,6 +402,11 @@ _platform_route_sync_add (const VTableIP *vtable, NMDefaultRouteManager *self, g
 	if (!entry)
 		return FALSE;
 
+	if (   vtable->vt->is_ip4
+	    && entry->multipath_weight
+	    && _platform_route_sync_add_multipath (self, entries, entry))
+		return TRUE;
+
 	if (vtable->vt->is_ip4) {
 		success = nm_platform_ip4_route_add (priv->platform,
 		                                     entry->route.rx.ifindex,
@@ -314,12 +435,12 @@ _platform_route_sync_add (const VTableIP *vtable, NMDefaultRouteManager *self, g
 }
 
 static gboolean
-_platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self, int ifindex_to_flush)
+_platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self, GHashTable *synced_ifindexes, GHashTable *synced_by_metric, int ifindex_to_flush)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries = vtable->get_entries (priv);
 	GArray *routes;
-	guint i, j;
+	guint i;
 	gboolean changed = FALSE;
 
 	/* prune all other default routes from this device. */
@@ -327,24 +448,16 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 
 	for (i = 0; i < routes->len; i++) {
 		const NMPlatformIPRoute *route;
-		gboolean has_ifindex_synced = FALSE;
-		Entry *entry = NULL;
+		gboolean has_ifindex_synced;
+		Entry *entry;
 
 		route = _vt_route_index (vtable, routes, i);
 
-		/* look at all entries and see if the route for this ifindex pair is
-		 * a known entry. */
-		for (j = 0; j < entries->len; j++) {
-			Entry *e = g_ptr_array_index (entries, j);
-
-			if (   e->route.rx.ifindex == route->ifindex
-			    && e->synced) {
-				has_ifindex_synced = TRUE;
-				if (   !e->never_default
-				    && e->effective_metric == route->metric)
-					entry = e;
-			}
-		}
+		/* see if the route for this ifindex pair is a known entry. */
+		has_ifindex_synced = g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex));
+		entry = has_ifindex_synced
+		        ? _entry_find_synced_by_metric (entries, synced_by_metric, route->ifindex, route->metric)
+		        : NULL;
 
 		/* we only delete the route if we don't have a matching entry,
 		 * and there is at least one entry that references this ifindex
@@ -405,12 +518,70 @@ _sort_entries_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 	return 0;
 }
 
+static void
+_entries_reposition (GPtrArray *entries, guint entry_idx)
+{
+	Entry *entry = g_ptr_array_index (entries, entry_idx);
+	guint lo, hi, mid, lower, upper, pos;
+
+	/* All entries except the one at @entry_idx are sorted. Move the entry to
+	 * its place, with the same result as g_ptr_array_sort_with_data() would give.
+	 * That is, among equal entries, the entry keeps its relative position. */
+	g_ptr_array_remove_index (entries, entry_idx);
+
+	lo = 0;
+	hi = entries->len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (_sort_entries_cmp (&entries->pdata[mid], &entry, NULL) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	lower = lo;
+
+	hi = entries->len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (_sort_entries_cmp (&entries->pdata[mid], &entry, NULL) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	upper = lo;
+
+	pos = CLAMP (entry_idx, lower, upper);
+	g_ptr_array_insert (entries, pos, entry);
+}
+
 static GHashTable *
-_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, GArray *routes)
+_get_synced_ifindexes (const VTableIP *vtable, NMDefaultRouteManager *self)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries;
-	guint i, j;
+	guint i;
+	GHashTable *result;
+
+	/* create the set of all ifindexes that have at least one synced entry. */
+
+	entries = vtable->get_entries (priv);
+
+	result = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < entries->len; i++) {
+		const Entry *e = g_ptr_array_index (entries, i);
+
+		if (e->synced)
+			g_hash_table_add (result, GINT_TO_POINTER (e->route.rx.ifindex));
+	}
+	return result;
+}
+
+static GHashTable *
+_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, GArray *routes, GHashTable *synced_ifindexes)
+{
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	GPtrArray *entries;
+	guint i;
 	GHashTable *result;
 
 	/* create a list of all metrics that are currently assigned on an interface
@@ -423,22 +594,11 @@ _get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *s
 	result = g_hash_table_new (NULL, NULL);
 
 	for (i = 0; i < routes->len; i++) {
-		gboolean ifindex_has_synced_entry = FALSE;
 		const NMPlatformIPRoute *route;
 
 		route = _vt_route_index (vtable, routes, i);
 
-		for (j = 0; j < entries->len; j++) {
-			Entry *e = g_ptr_array_index (entries, j);
-
-			if (   e->synced
-			    && e->route.rx.ifindex == route->ifindex) {
-				ifindex_has_synced_entry = TRUE;
-				break;
-			}
-		}
-
-		if (!ifindex_has_synced_entry)
+		if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex)))
 			g_hash_table_add (result, GUINT_TO_POINTER (vtable->vt->metric_normalize (route->metric)));
 	}
 
@@ -446,23 +606,12 @@ _get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *s
 	 * we track as non-synced but that are no longer part of platform routes. Anyway, for now
 	 * we still want to treat them as assumed. */
 	for (i = 0; i < entries->len; i++) {
-		gboolean ifindex_has_synced_entry = FALSE;
 		Entry *e_i = g_ptr_array_index (entries, i);
 
 		if (e_i->synced)
 			continue;
 
-		for (j = 0; j < entries->len; j++) {
-			Entry *e_j = g_ptr_array_index (entries, j);
-
-			if (   j != i
-			    && (e_j->synced && e_j->route.rx.ifindex == e_i->route.rx.ifindex)) {
-				ifindex_has_synced_entry = TRUE;
-				break;
-			}
-		}
-
-		if (!ifindex_has_synced_entry)
+		if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (e_i->route.rx.ifindex)))
 			g_hash_table_add (result, GUINT_TO_POINTER (vtable->vt->metric_normalize (e_i->route.rx.metric)));
 	}
 
@@ -491,9 +640,15 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	GPtrArray *entries;
 	GArray *changed_metrics = g_array_new (FALSE, FALSE, sizeof (guint32));
 	GHashTable *assumed_metrics;
+	GHashTable *synced_ifindexes;
+	GHashTable *synced_by_metric;
+	GHashTable *unsynced_by_metric;
+	GHashTable *routes_index;
 	GArray *routes;
 	gboolean changed = FALSE;
 	int ifindex_to_flush = 0;
+	const Entry *last_synced = NULL;
+	gboolean is_group_member;
 
 	g_assert (priv->resync.guard == 0);
 	priv->resync.guard++;
@@ -510,8 +665,10 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	entries = vtable->get_entries (priv);
 
 	routes = vtable->vt->route_get_all (priv->platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	routes_index = _vt_routes_index_create (vtable, routes);
 
-	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes);
+	synced_ifindexes = _get_synced_ifindexes (vtable, self);
+	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes, synced_ifindexes);
 
 	if (old_entry && old_entry->synced && !old_entry->never_default) {
 		/* The old version obviously changed. */
@@ -528,48 +685,37 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			continue;
 
 		if (!entry->synced) {
-			gboolean has_synced_entry = FALSE;
-
 			/* A non synced entry is completely ignored, if we have
 			 * a synced entry for the same if index.
 			 * Otherwise the metric of the entry is still remembered as
 			 * last_metric to avoid reusing it. */
-			for (j = 0; j < entries->len; j++) {
-				const Entry *e = g_ptr_array_index (entries, j);
-
-				if (   e->synced
-					&& e->route.rx.ifindex == entry->route.rx.ifindex) {
-					has_synced_entry = TRUE;
-					break;
-				}
-			}
-			if (!has_synced_entry)
+			if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (entry->route.rx.ifindex)))
 				last_metric = MAX (last_metric, (gint64) entry->effective_metric);
 			continue;
 		}
 
+		/* an entry that shares the multipath route of the previous one
+		 * gets the same effective metric. */
+		is_group_member =    entry->multipath_weight
+		                  && last_synced
+		                  && last_synced->multipath_weight
+		                  && last_synced->route.rx.metric == entry->route.rx.metric;
+		last_synced = entry;
+
 		expected_metric = entry->route.rx.metric;
-		if ((gint64) expected_metric <= last_metric)
+		if (is_group_member)
+			expected_metric = last_metric;
+		else if ((gint64) expected_metric <= last_metric)
 			expected_metric = last_metric == G_MAXUINT32 ? G_MAXUINT32 : last_metric + 1;
 
-		while (   expected_metric < G_MAXUINT32
+		while (   !is_group_member
+		       && expected_metric < G_MAXUINT32
 		       && g_hash_table_contains (assumed_metrics, GUINT_TO_POINTER (expected_metric))) {
-			gboolean has_metric_for_ifindex = FALSE;
-
 			/* Check if there are assumed devices that have default routes with this metric.
 			 * If there are any, we have to pick another effective_metric. */
 
 			/* However, if there is a matching route (ifindex+metric) for our current entry, we are done. */
-			for (j = 0; j < routes->len; j++) {
-				const NMPlatformIPRoute *r = _vt_route_index (vtable, routes, i);
-
-				if (   r->metric == expected_metric
-				    && r->ifindex == entry->route.rx.ifindex) {
-					has_metric_for_ifindex = TRUE;
-					break;
-				}
-			}
-			if (has_metric_for_ifindex)
+			if (_vt_routes_index_lookup (routes_index, entry->route.rx.ifindex, expected_metric))
 				break;
 			expected_metric++;
 		}
@@ -592,8 +738,10 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			_LOG2D (vtable, i, entry, "sync:metric %s (%u -> %u)",
 			        vtable->vt->route_to_string (&entry->route, NULL, 0), (guint) entry->effective_metric,
 			        (guint) expected_metric);
-		} else {
-			if (!_vt_routes_has_entry (vtable, routes, entry)) {
+		} else if (!is_group_member) {
+			/* members of a group have no route of their own, the route is
+			 * checked for the leader. */
+			if (!_vt_routes_has_entry (vtable, routes_index, entry)) {
 				g_array_append_val (changed_metrics, entry->effective_metric);
 				_LOG2D (vtable, i, entry, "sync:re-add %s (%u -> %u)",
 				        vtable->vt->route_to_string (&entry->route, NULL, 0), (guint) entry->effective_metric,
@@ -608,8 +756,26 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		last_metric = expected_metric;
 	}
 
+	g_hash_table_unref (routes_index);
 	g_array_free (routes, TRUE);
 
+	/* index the entries by their (now final) effective metric. */
+	synced_by_metric = g_hash_table_new (NULL, NULL);
+	unsynced_by_metric = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < entries->len; i++) {
+		entry = g_ptr_array_index (entries, i);
+
+		if (entry->never_default)
+			continue;
+		if (!entry->synced)
+			g_hash_table_insert (unsynced_by_metric, GUINT_TO_POINTER (entry->effective_metric), entry);
+		else if (!g_hash_table_contains (synced_by_metric, GUINT_TO_POINTER (entry->effective_metric)))
+			g_hash_table_insert (synced_by_metric, GUINT_TO_POINTER (entry->effective_metric), entry);
+		else
+			g_assert (entry->effective_metric == G_MAXUINT32 || entry->multipath_weight);
+	}
+
+	/* only re-program the routes whose effective metric actually changed. */
 	g_array_sort (changed_metrics, _sort_metrics_ascending_fcn);
 	last_metric = -1;
 	for (j = 0; j < changed_metrics->len; j++) {
@@ -619,7 +785,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			/* skip duplicates. */
 			continue;
 		}
-		changed |= _platform_route_sync_add (vtable, self, expected_metric);
+		changed |= _platform_route_sync_add (vtable, self, synced_by_metric, unsynced_by_metric, expected_metric);
 		last_metric = expected_metric;
 	}
 
@@ -633,10 +799,13 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		ifindex_to_flush = old_entry->route.rx.ifindex;
 	}
 
-	changed |= _platform_route_sync_flush (vtable, self, ifindex_to_flush);
+	changed |= _platform_route_sync_flush (vtable, self, synced_ifindexes, synced_by_metric, ifindex_to_flush);
 
 	g_array_free (changed_metrics, TRUE);
 	g_hash_table_unref (assumed_metrics);
+	g_hash_table_unref (synced_ifindexes);
+	g_hash_table_unref (synced_by_metric);
+	g_hash_table_unref (unsynced_by_metric);
 
 	priv->resync.guard--;
 	return changed;
@@ -665,7 +834,7 @@ _entry_at_idx_update (const VTableIP *vtable, NMDefaultRouteManager *self, guint
 	        vtable->vt->route_to_string (&entry->route, NULL, 0),
 	        entry->effective_metric);
 
-	g_ptr_array_sort_with_data (entries, _sort_entries_cmp, NULL);
+	_entries_reposition (entries, entry_idx);
 
 	_resync_all (vtable, self, entry, old_entry, FALSE);
 }
@@ -711,6 +880,7 @@ _ipx_update_default_route (const VTableIP *vtable, NMDefaultRouteManager *self,
 	NMVpnConnection *vpn = NULL;
 	gboolean never_default = FALSE;
 	gboolean synced = FALSE;
+	guint multipath_weight = 0;
 
 	g_return_if_fail (NM_IS_DEFAULT_ROUTE_MANAGER (self));
 
@@ -822,6 +992,17 @@ _ipx_update_default_route (const VTableIP *vtable, NMDefaultRouteManager *self,
 
 	g_assert (!default_route || default_route->plen == 0);
 
+	if (   device
+	    && vtable->vt->is_ip4
+	    && synced
+	    && !never_default) {
+		NMSettingIP4Config *s_ip4;
+
+		s_ip4 = (NMSettingIP4Config *) nm_device_get_applied_setting (device, NM_TYPE_SETTING_IP4_CONFIG);
+		if (s_ip4)
+			multipath_weight = nm_setting_ip4_config_get_multipath_weight (s_ip4);
+	}
+
 	if (!synced && never_default) {
 		/* having a non-synced, never-default entry is non-sensical. Unset
 		 * @default_route so that we don't add such an entry below. */
@@ -846,6 +1027,7 @@ _ipx_update_default_route (const VTableIP *vtable, NMDefaultRouteManager *self,
 		entry->never_default = never_default;
 		entry->effective_metric = entry->route.rx.metric;
 		entry->synced = synced;
+		entry->multipath_weight = multipath_weight;
 
 		g_ptr_array_add (entries, entry);
 		_entry_at_idx_update (vtable, self, entries->len - 1, NULL);
@@ -863,6 +1045,7 @@ _ipx_update_default_route (const VTableIP *vtable, NMDefaultRouteManager *self,
 		new_entry.route.rx.ifindex = ip_ifindex;
 		new_entry.never_default = never_default;
 		new_entry.synced = synced;
+		new_entry.multipath_weight = multipath_weight;
 
 		if (memcmp (entry, &new_entry, sizeof (new_entry)) == 0)
 			return;
@@ -1287,7 +1470,10 @@ _resync_idle_cancel (NMDefaultRouteManager *self)
 
 	if (priv->resync.idle_handle) {
 		_LOGD (0, "resync: cancelled (%u)", priv->resync.idle_handle);
-		g_source_remove (priv->resync.idle_handle);
+		if (priv->resync.backoff_wait_time_ms)
+			g_source_remove (priv->resync.idle_handle);
+		else
+			nm_loop_sched_remove (priv->resync.idle_handle);
 		priv->resync.idle_handle = 0;
 	}
 	priv->resync.backoff_wait_time_ms = 0;
@@ -1308,12 +1494,12 @@ _resync_idle_reschedule (NMDefaultRouteManager *self)
 	if (priv->resync.backoff_wait_time_ms == 0) {
 		/* for scheduling idle, always reschedule (to process all other events first) */
 		if (priv->resync.idle_handle)
-			g_source_remove (priv->resync.idle_handle);
+			nm_loop_sched_remove (priv->resync.idle_handle);
 		else
 			_LOGD (0, "resync: schedule on idle");
-		/* Schedule this at low priority so that on an external change to platform
+		/* Schedule this as background work so that on an external change to platform
 		 * a NMDevice has a chance to picks up the changes first. */
-		priv->resync.idle_handle = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) _resync_idle_now, self, NULL);
+		priv->resync.idle_handle = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_BACKGROUND, (GSourceFunc) _resync_idle_now, self);
 	} else if (!priv->resync.idle_handle) {
 		priv->resync.idle_handle =  g_timeout_add (priv->resync.backoff_wait_time_ms, (GSourceFunc) _resync_idle_now, self);
 		_LOGD (0, "resync: schedule in %u.%03u seconds (%u)", priv->resync.backoff_wait_time_ms/1000,
@@ -1322,58 +1508,58 @@ _resync_idle_reschedule (NMDefaultRouteManager *self)
 }
 
 static void
-_platform_ipx_route_changed_cb (const VTableIP *vtable,
-                                NMDefaultRouteManager *self,
-                                const NMPlatformIPRoute *route)
+_platform_changes_batch_cb (NMPlatform *platform,
+                            const GArray *batch,
+                            NMDefaultRouteManager *self)
 {
-	NMDefaultRouteManagerPrivate *priv;
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	gboolean has_v4_changes = FALSE;
+	gboolean has_v6_changes = FALSE;
+	guint i;
 
-	if (route && !NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
-		/* we only care about address changes or changes of default route. */
+	if (priv->resync.guard) {
+		/* callbacks while executing _resync_all() are ignored. */
 		return;
 	}
 
-	priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	for (i = 0; i < batch->len; i++) {
+		const NMPlatformChangesBatchEntry *entry = &g_array_index (batch, NMPlatformChangesBatchEntry, i);
 
-	if (priv->resync.guard) {
-		/* callbacks while executing _resync_all() are ignored. */
-		return;
+		/* we only care about address changes or changes of default route. */
+		switch (entry->obj_type) {
+		case NMP_OBJECT_TYPE_IP4_ADDRESS:
+			has_v4_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP6_ADDRESS:
+			has_v6_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP4_ROUTE:
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (&entry->obj->ip4_route))
+				has_v4_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP6_ROUTE:
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (&entry->obj->ip6_route))
+				has_v6_changes = TRUE;
+			break;
+		default:
+			break;
+		}
+		if (has_v4_changes && has_v6_changes)
+			break;
 	}
 
-	if (vtable->vt->is_ip4)
+	if (!has_v4_changes && !has_v6_changes)
+		return;
+
+	if (has_v4_changes)
 		priv->resync.has_v4_changes = TRUE;
-	else
+	if (has_v6_changes)
 		priv->resync.has_v6_changes = TRUE;
 
+	/* reschedule only once per batch. */
 	_resync_idle_reschedule (self);
 }
 
-static void
-_platform_changed_cb (NMPlatform *platform,
-                      NMPObjectType obj_type,
-                      int ifindex,
-                      gpointer platform_object,
-                      NMPlatformSignalChangeType change_type,
-                      NMDefaultRouteManager *self)
-{
-	switch (obj_type) {
-	case NMP_OBJECT_TYPE_IP4_ADDRESS:
-		_platform_ipx_route_changed_cb (&vtable_ip4, self, NULL);
-		break;
-	case NMP_OBJECT_TYPE_IP6_ADDRESS:
-		_platform_ipx_route_changed_cb (&vtable_ip6, self, NULL);
-		break;
-	case NMP_OBJECT_TYPE_IP4_ROUTE:
-		_platform_ipx_route_changed_cb (&vtable_ip4, self, (const NMPlatformIPRoute *) platform_object);
-		break;
-	case NMP_OBJECT_TYPE_IP6_ROUTE:
-		_platform_ipx_route_changed_cb (&vtable_ip6, self, (const NMPlatformIPRoute *) platform_object);
-		break;
-	default:
-		g_return_if_reached ();
-	}
-}
-
 /***********************************************************************************/
 
 static void
@@ -1411,10 +1597,7 @@ constructed (GObject *object)
 	priv->entries_ip4 = g_ptr_array_new_full (0, (GDestroyNotify) _entry_free);
 	priv->entries_ip6 = g_ptr_array_new_full (0, (GDestroyNotify) _entry_free);
 
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, G_CALLBACK (_platform_changed_cb), self);
+	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_CHANGES_BATCH, G_CALLBACK (_platform_changes_batch_cb), self);
 }
 
 NMDefaultRouteManager *
@@ -1434,7 +1617,7 @@ dispose (GObject *object)
 	priv->disposed = TRUE;
 
 	if (priv->platform) {
-		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_changed_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_changes_batch_cb), self);
 		g_clear_object (&priv->platform);
 	}
 
@@ -34,6 +34,7 @@
 #include "nm-ip4-config.h"
 #include "nm-ip6-config.h"
 #include "nm-settings-connection.h"
+#include "nm-activation-request.h"
 #include "nm-platform.h"
 #include "nm-core-internal.h"
 
@@ -64,13 +65,15 @@ enum {
 	MONITOR_INDEX_DEFAULT,
 	MONITOR_INDEX_PRE_UP,
 	MONITOR_INDEX_PRE_DOWN,
+	MONITOR_INDEX_PLUGINS,
 };
 
-static Monitor monitors[3] = {
+static Monitor monitors[4] = {
 #define MONITORS_INIT_SET(INDEX, USE, SCRIPT_DIR)   [INDEX] = { .dir_len = NM_STRLEN (SCRIPT_DIR), .dir = SCRIPT_DIR, .description = ("" USE), .has_scripts = TRUE }
 	MONITORS_INIT_SET (MONITOR_INDEX_DEFAULT,  "default",  NMD_SCRIPT_DIR_DEFAULT),
 	MONITORS_INIT_SET (MONITOR_INDEX_PRE_UP,   "pre-up",   NMD_SCRIPT_DIR_PRE_UP),
 	MONITORS_INIT_SET (MONITOR_INDEX_PRE_DOWN, "pre-down", NMD_SCRIPT_DIR_PRE_DOWN),
+	MONITORS_INIT_SET (MONITOR_INDEX_PLUGINS,  "plugin",   NMD_PLUGIN_DIR),
 };
 
 static const Monitor*
@@ -226,14 +229,118 @@ dump_ip6_to_props (NMIP6Config *ip6, GVariantBuilder *builder)
 	                       g_variant_builder_end (&int_builder));
 }
 
+/*****************************************************************************/
+
+/* The parts of the payload that are expensive to build are kept on the
+ * device and reused for consecutive events, as long as the applied
+ * connection (version-id of the act-request) and the IP configs (digest)
+ * stay the same. The DHCP options are a variant already. */
+typedef struct {
+	guint64 version_id;
+	GVariant *connection_dict;
+	guint64 ip4_digest;
+	GVariant *ip4_props;
+	guint64 ip6_digest;
+	GVariant *ip6_props;
+} PayloadCache;
+
+static GQuark payload_cache_quark;
+
+static void
+payload_cache_free (gpointer data)
+{
+	PayloadCache *cache = data;
+
+	nm_clear_g_variant (&cache->connection_dict);
+	nm_clear_g_variant (&cache->ip4_props);
+	nm_clear_g_variant (&cache->ip6_props);
+	g_slice_free (PayloadCache, cache);
+}
+
+static PayloadCache *
+payload_cache_get (NMDevice *device)
+{
+	PayloadCache *cache;
+
+	if (G_UNLIKELY (!payload_cache_quark))
+		payload_cache_quark = g_quark_from_static_string ("nm-dispatcher-payload-cache");
+
+	cache = g_object_get_qdata (G_OBJECT (device), payload_cache_quark);
+	if (!cache) {
+		cache = g_slice_new0 (PayloadCache);
+		g_object_set_qdata_full (G_OBJECT (device), payload_cache_quark, cache, payload_cache_free);
+	}
+	return cache;
+}
+
+static GVariant *
+connection_dict_get (NMDevice *device, NMConnection *applied_connection)
+{
+	NMActRequest *req;
+	PayloadCache *cache;
+	guint64 version_id;
+
+	req = device ? nm_device_get_act_request (device) : NULL;
+	if (   !req
+	    || nm_active_connection_get_applied_connection (NM_ACTIVE_CONNECTION (req)) != applied_connection)
+		return g_variant_ref_sink (nm_connection_to_dbus (applied_connection, NM_CONNECTION_SERIALIZE_NO_SECRETS));
+
+	/* version-ids are unique, a new act-request never matches the old entry. */
+	cache = payload_cache_get (device);
+	version_id = nm_active_connection_version_id_get (NM_ACTIVE_CONNECTION (req));
+	if (!cache->connection_dict || cache->version_id != version_id) {
+		nm_clear_g_variant (&cache->connection_dict);
+		cache->connection_dict = g_variant_ref_sink (nm_connection_to_dbus (applied_connection, NM_CONNECTION_SERIALIZE_NO_SECRETS));
+		cache->version_id = version_id;
+	}
+	return g_variant_ref (cache->connection_dict);
+}
+
+static GVariant *
+ip4_props_get (PayloadCache *cache, NMIP4Config *ip4_config)
+{
+	GVariantBuilder builder;
+	guint64 digest;
+
+	digest = nm_ip4_config_get_digest (ip4_config, FALSE);
+	if (!cache->ip4_props || cache->ip4_digest != digest) {
+		g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+		dump_ip4_to_props (ip4_config, &builder);
+		nm_clear_g_variant (&cache->ip4_props);
+		cache->ip4_props = g_variant_ref_sink (g_variant_builder_end (&builder));
+		cache->ip4_digest = digest;
+	}
+	return g_variant_ref (cache->ip4_props);
+}
+
+static GVariant *
+ip6_props_get (PayloadCache *cache, NMIP6Config *ip6_config)
+{
+	GVariantBuilder builder;
+	guint64 digest;
+
+	digest = nm_ip6_config_get_digest (ip6_config, FALSE);
+	if (!cache->ip6_props || cache->ip6_digest != digest) {
+		g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+		dump_ip6_to_props (ip6_config, &builder);
+		nm_clear_g_variant (&cache->ip6_props);
+		cache->ip6_props = g_variant_ref_sink (g_variant_builder_end (&builder));
+		cache->ip6_digest = digest;
+	}
+	return g_variant_ref (cache->ip6_props);
+}
+
+/*****************************************************************************/
+
 static void
 fill_device_props (NMDevice *device,
                    GVariantBuilder *dev_builder,
-                   GVariantBuilder *ip4_builder,
-                   GVariantBuilder *ip6_builder,
+                   GVariant **ip4_props,
+                   GVariant **ip6_props,
                    GVariant **dhcp4_props,
                    GVariant **dhcp6_props)
 {
+	PayloadCache *cache;
 	NMIP4Config *ip4_config;
 	NMIP6Config *ip6_config;
 	NMDhcp4Config *dhcp4_config;
@@ -252,13 +359,15 @@ fill_device_props (NMDevice *device,
 		g_variant_builder_add (dev_builder, "{sv}", NMD_DEVICE_PROPS_PATH,
 		                       g_variant_new_object_path (nm_exported_object_get_path (NM_EXPORTED_OBJECT (device))));
 
+	cache = payload_cache_get (device);
+
 	ip4_config = nm_device_get_ip4_config (device);
 	if (ip4_config)
-		dump_ip4_to_props (ip4_config, ip4_builder);
+		*ip4_props = ip4_props_get (cache, ip4_config);
 
 	ip6_config = nm_device_get_ip6_config (device);
 	if (ip6_config)
-		dump_ip6_to_props (ip6_config, ip6_builder);
+		*ip6_props = ip6_props_get (cache, ip6_config);
 
 	dhcp4_config = nm_device_get_dhcp4_config (device);
 	if (dhcp4_config)
@@ -328,6 +437,8 @@ dispatch_result_to_string (DispatchResult result)
 		return "failed";
 	case DISPATCH_RESULT_TIMEOUT:
 		return "timed out";
+	case DISPATCH_RESULT_SUPERSEDED:
+		return "superseded";
 	}
 	g_assert_not_reached ();
 }
@@ -352,6 +463,8 @@ dispatcher_results_process (guint request_id, DispatcherAction action, GVariantI
 		if (!*script) {
 			script_validation_msg = " (path is NULL)";
 			script = "(unknown)";
+		} else if (g_str_has_prefix (script, NMD_PLUGIN_RESULT_PREFIX)) {
+			/* an in-process hook of the dispatcher */
 		} else if (!strncmp (script, monitor->dir, monitor->dir_len)            /* check: prefixed by script directory */
 		    && script[monitor->dir_len] == '/' && script[monitor->dir_len+1]    /* check: with additional "/?" */
 		    && !strchr (&script[monitor->dir_len+1], '/')) {                    /* check: and no further '/' */
@@ -365,6 +478,11 @@ dispatcher_results_process (guint request_id, DispatcherAction action, GVariantI
 			_LOGD ("(%u) %s succeeded%s",
 			       request_id,
 			       script, script_validation_msg);
+		} else if (result == DISPATCH_RESULT_SUPERSEDED) {
+			_LOGD ("(%u) %s skipped: %s%s",
+			       request_id,
+			       script, err,
+			       script_validation_msg);
 		} else {
 			_LOGW ("(%u) %s failed (%s): %s%s",
 			       request_id,
@@ -459,8 +577,8 @@ _dispatcher_call (DispatcherAction action,
 	GVariant *connection_dict;
 	GVariantBuilder connection_props;
 	GVariantBuilder device_props;
-	GVariantBuilder device_ip4_props;
-	GVariantBuilder device_ip6_props;
+	GVariant *device_ip4_props = NULL;
+	GVariant *device_ip6_props = NULL;
 	GVariant *device_dhcp4_props = NULL;
 	GVariant *device_dhcp6_props = NULL;
 	GVariantBuilder vpn_ip4_props;
@@ -501,7 +619,8 @@ _dispatcher_call (DispatcherAction action,
 		           : (callback ? " (with callback)" : ""));
 	}
 
-	if (!_get_monitor_by_action(action)->has_scripts) {
+	if (   !_get_monitor_by_action(action)->has_scripts
+	    && !monitors[MONITOR_INDEX_PLUGINS].has_scripts) {
 		if (blocking == FALSE && (out_call_id || callback)) {
 			info = g_malloc0 (sizeof (*info));
 			info->action = action;
@@ -517,9 +636,9 @@ _dispatcher_call (DispatcherAction action,
 	}
 
 	if (applied_connection)
-		connection_dict = nm_connection_to_dbus (applied_connection, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+		connection_dict = connection_dict_get (device, applied_connection);
 	else
-		connection_dict = g_variant_new_array (G_VARIANT_TYPE ("{sa{sv}}"), NULL, 0);
+		connection_dict = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sa{sv}}"), NULL, 0));
 
 	g_variant_builder_init (&connection_props, G_VARIANT_TYPE_VARDICT);
 	if (settings_connection) {
@@ -546,8 +665,6 @@ _dispatcher_call (DispatcherAction action,
 	}
 
 	g_variant_builder_init (&device_props, G_VARIANT_TYPE_VARDICT);
-	g_variant_builder_init (&device_ip4_props, G_VARIANT_TYPE_VARDICT);
-	g_variant_builder_init (&device_ip6_props, G_VARIANT_TYPE_VARDICT);
 	g_variant_builder_init (&vpn_ip4_props, G_VARIANT_TYPE_VARDICT);
 	g_variant_builder_init (&vpn_ip6_props, G_VARIANT_TYPE_VARDICT);
 
@@ -567,6 +684,10 @@ _dispatcher_call (DispatcherAction action,
 		}
 	}
 
+	if (!device_ip4_props)
+		device_ip4_props = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0));
+	if (!device_ip6_props)
+		device_ip6_props = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0));
 	if (!device_dhcp4_props)
 		device_dhcp4_props = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0));
 	if (!device_dhcp6_props)
@@ -578,13 +699,13 @@ _dispatcher_call (DispatcherAction action,
 		GVariantIter *results;
 
 		ret = _nm_dbus_proxy_call_sync (dispatcher_proxy, "Action",
-		                                g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}a{sv}a{sv}@a{sv}@a{sv}sa{sv}a{sv}b)",
+		                                g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}@a{sv}@a{sv}@a{sv}@a{sv}sa{sv}a{sv}b)",
 		                                               action_to_string (action),
 		                                               connection_dict,
 		                                               &connection_props,
 		                                               &device_props,
-		                                               &device_ip4_props,
-		                                               &device_ip6_props,
+		                                               device_ip4_props,
+		                                               device_ip6_props,
 		                                               device_dhcp4_props,
 		                                               device_dhcp6_props,
 		                                               vpn_iface ? vpn_iface : "",
@@ -613,13 +734,13 @@ _dispatcher_call (DispatcherAction action,
 		info->callback = callback;
 		info->user_data = user_data;
 		g_dbus_proxy_call (dispatcher_proxy, "Action",
-		                   g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}a{sv}a{sv}@a{sv}@a{sv}sa{sv}a{sv}b)",
+		                   g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}@a{sv}@a{sv}@a{sv}@a{sv}sa{sv}a{sv}b)",
 		                                  action_to_string (action),
 		                                  connection_dict,
 		                                  &connection_props,
 		                                  &device_props,
-		                                  &device_ip4_props,
-		                                  &device_ip6_props,
+		                                  device_ip4_props,
+		                                  device_ip6_props,
 		                                  device_dhcp4_props,
 		                                  device_dhcp6_props,
 		                                  vpn_iface ? vpn_iface : "",
@@ -631,6 +752,9 @@ _dispatcher_call (DispatcherAction action,
 		success = TRUE;
 	}
 
+	g_variant_unref (connection_dict);
+	g_variant_unref (device_ip4_props);
+	g_variant_unref (device_ip6_props);
 	g_variant_unref (device_dhcp4_props);
 	g_variant_unref (device_dhcp6_props);
 
@@ -0,0 +1,206 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-executor.h"
+
+typedef struct {
+	NMExecutorFunc func;
+	NMExecutorDoneFunc done;
+	gpointer user_data;
+	GError *error;
+} Job;
+
+static struct {
+	GThreadPool *pool;
+	GAsyncQueue *completed;
+
+	/* protects the fields below */
+	GMutex lock;
+	GCond cond;
+	guint n_pending;
+	bool idle_scheduled:1;
+} executor;
+
+/*****************************************************************************/
+
+static void
+_complete_jobs (void)
+{
+	Job *job;
+
+	while ((job = g_async_queue_try_pop (executor.completed))) {
+		if (job->done)
+			job->done (job->error, job->user_data);
+		g_clear_error (&job->error);
+		g_slice_free (Job, job);
+	}
+}
+
+static gboolean
+_complete_idle_cb (gpointer user_data)
+{
+	g_mutex_lock (&executor.lock);
+	executor.idle_scheduled = FALSE;
+	g_mutex_unlock (&executor.lock);
+
+	_complete_jobs ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_job_run (gpointer data, gpointer user_data)
+{
+	Job *job = data;
+
+	job->func (job->user_data, &job->error);
+
+	g_async_queue_push (executor.completed, job);
+
+	g_mutex_lock (&executor.lock);
+	executor.n_pending--;
+	if (!executor.idle_scheduled) {
+		executor.idle_scheduled = TRUE;
+		g_idle_add (_complete_idle_cb, NULL);
+	}
+	g_cond_broadcast (&executor.cond);
+	g_mutex_unlock (&executor.lock);
+}
+
+/**
+ * nm_executor_run:
+ * @func: the job, called on the worker thread. On failure it
+ *   returns %FALSE and sets the error.
+ * @done: (allow-none): called from the main loop with the error
+ *   of @func, or %NULL on success.
+ * @user_data: the data for @func and @done.
+ */
+void
+nm_executor_run (NMExecutorFunc func,
+                 NMExecutorDoneFunc done,
+                 gpointer user_data)
+{
+	Job *job;
+
+	g_return_if_fail (func);
+
+	if (G_UNLIKELY (!executor.pool)) {
+		executor.completed = g_async_queue_new ();
+		executor.pool = g_thread_pool_new (_job_run, NULL, 1, FALSE, NULL);
+	}
+
+	job = g_slice_new0 (Job);
+	job->func = func;
+	job->done = done;
+	job->user_data = user_data;
+
+	g_mutex_lock (&executor.lock);
+	executor.n_pending++;
+	g_mutex_unlock (&executor.lock);
+
+	g_thread_pool_push (executor.pool, job, NULL);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	char *filename;
+	char *contents;
+	gssize length;
+	NMExecutorDoneFunc done;
+	gpointer user_data;
+} WriteFileData;
+
+static gboolean
+_write_file_job (gpointer user_data, GError **error)
+{
+	WriteFileData *data = user_data;
+
+	return g_file_set_contents (data->filename, data->contents, data->length, error);
+}
+
+static void
+_write_file_done (GError *error, gpointer user_data)
+{
+	WriteFileData *data = user_data;
+
+	if (data->done)
+		data->done (error, data->user_data);
+	g_free (data->filename);
+	g_free (data->contents);
+	g_slice_free (WriteFileData, data);
+}
+
+/**
+ * nm_executor_write_file:
+ * @filename: the file to write
+ * @contents: (transfer full): the new contents
+ * @length: the length of @contents or -1, if it is NUL terminated
+ * @done: (allow-none): called from the main loop once the file is written
+ * @user_data: the data for @done
+ *
+ * Replaces the file atomically like g_file_set_contents() does, but
+ * without blocking the main loop.
+ */
+void
+nm_executor_write_file (const char *filename,
+                        char *contents,
+                        gssize length,
+                        NMExecutorDoneFunc done,
+                        gpointer user_data)
+{
+	WriteFileData *data;
+
+	g_return_if_fail (filename);
+	g_return_if_fail (contents);
+
+	data = g_slice_new (WriteFileData);
+	data->filename = g_strdup (filename);
+	data->contents = contents;
+	data->length = length;
+	data->done = done;
+	data->user_data = user_data;
+
+	nm_executor_run (_write_file_job, _write_file_done, data);
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_executor_flush:
+ *
+ * Waits until all submitted jobs ran and invokes their pending
+ * callbacks. Used before reading back a file that might still be
+ * written and at shutdown, so that no write gets lost.
+ */
+void
+nm_executor_flush (void)
+{
+	if (!executor.pool)
+		return;
+
+	g_mutex_lock (&executor.lock);
+	while (executor.n_pending > 0)
+		g_cond_wait (&executor.cond, &executor.lock);
+	g_mutex_unlock (&executor.lock);
+
+	_complete_jobs ();
+}
@@ -0,0 +1,47 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_EXECUTOR_H__
+#define __NETWORKMANAGER_EXECUTOR_H__
+
+/* Runs blocking work, like writing files, on a worker thread.
+ *
+ * There is only one worker, so jobs run one after another in the order
+ * in which they were submitted. Their @done callback is invoked from the
+ * main loop, also in order. The job function itself runs on the worker
+ * and must not touch any state of the main thread; in particular it
+ * must not log, as nm-logging is not thread-safe. */
+
+typedef gboolean (*NMExecutorFunc) (gpointer user_data, GError **error);
+typedef void (*NMExecutorDoneFunc) (GError *error, gpointer user_data);
+
+void nm_executor_run (NMExecutorFunc func,
+                      NMExecutorDoneFunc done,
+                      gpointer user_data);
+
+void nm_executor_write_file (const char *filename,
+                             char *contents,
+                             gssize length,
+                             NMExecutorDoneFunc done,
+                             gpointer user_data);
+
+void nm_executor_flush (void);
+
+#endif /* __NETWORKMANAGER_EXECUTOR_H__ */
@@ -26,6 +26,8 @@
 #include <string.h>
 
 #include "nm-bus-manager.h"
+#include "nm-probes.h"
+#include "nm-statistics.h"
 
 #if NM_MORE_ASSERTS >= 2
 #define _ASSERT_NO_EARLY_EXPORT
@@ -33,6 +35,26 @@
 
 static gboolean quitting = FALSE;
 
+/* PropertiesChanged signals of all objects are emitted from one FIFO
+ * queue, in the order in which the objects first changed since their
+ * last signal. Each main loop iteration emits at most @budget of them
+ * so that a burst (say, many devices changing state at once) doesn't
+ * block the main loop; only when that happens, everything still
+ * pending is emitted at once after @max_latency_ms.
+ */
+static struct {
+	GSequence *queue;
+	guint idle_id;
+	guint timeout_id;
+	guint budget;
+	guint max_latency_ms;
+} notify_queue = {
+	.budget = NM_EXPORTED_OBJECT_NOTIFY_BUDGET_DEFAULT,
+	.max_latency_ms = NM_EXPORTED_OBJECT_NOTIFY_MAX_LATENCY_DEFAULT,
+};
+
+static void _notify_queue_remove (NMExportedObject *self);
+
 G_DEFINE_ABSTRACT_TYPE (NMExportedObject, nm_exported_object, G_TYPE_DBUS_OBJECT_SKELETON);
 
 typedef struct {
@@ -49,7 +71,7 @@ typedef struct {
 	InterfaceData *interfaces;
 	guint num_interfaces;
 
-	guint notify_idle_id;
+	GSequenceIter *notify_iter;
 
 #ifdef _ASSERT_NO_EARLY_EXPORT
 	bool _constructed:1;
@@ -360,6 +382,17 @@ nm_exported_object_meta_marshal (GClosure *closure, GValue *return_value,
                                  gpointer invocation_hint, gpointer marshal_data)
 {
 	GValue *local_param_values;
+#ifdef WITH_SDT
+	GDBusMethodInvocation *invocation = g_value_get_object (&param_values[1]);
+#endif
+
+	nm_statistics_inc (NM_STATISTICS_COUNTER_DBUS_CALLS);
+
+	/* the handler may already return (and release) the invocation, so
+	 * the exit probe only gets the object. */
+	NM_PROBE3 (dbus__method__entry, closure->data,
+	           g_dbus_method_invocation_get_interface_name (invocation),
+	           g_dbus_method_invocation_get_method_name (invocation));
 
 	local_param_values = g_new0 (GValue, n_param_values);
 	g_value_init (&local_param_values[0], G_TYPE_POINTER);
@@ -372,6 +405,8 @@ nm_exported_object_meta_marshal (GClosure *closure, GValue *return_value,
 	                            ((GCClosure *)closure)->callback);
 	g_value_set_boolean (return_value, TRUE);
 
+	NM_PROBE1 (dbus__method__exit, closure->data);
+
 	g_value_unset (&local_param_values[0]);
 	g_free (local_param_values);
 }
@@ -384,6 +419,15 @@ typedef struct {
 	gulong *method_signals;
 } SkeletonData;
 
+static gsize
+_skeleton_sizeof (GType dbus_skeleton_type)
+{
+	GTypeQuery query;
+
+	g_type_query (dbus_skeleton_type, &query);
+	return query.instance_size + sizeof (SkeletonData);
+}
+
 GDBusInterfaceSkeleton *
 nm_exported_object_skeleton_create (GType dbus_skeleton_type,
                                     GObjectClass *object_class,
@@ -400,6 +444,8 @@ nm_exported_object_skeleton_create (GType dbus_skeleton_type,
 	interface = G_DBUS_INTERFACE_SKELETON (g_object_new (dbus_skeleton_type, NULL));
 
 	skeleton_data = g_slice_new (SkeletonData);
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_DBUS_SKELETONS,
+	                          _skeleton_sizeof (dbus_skeleton_type));
 
 	/* Bind properties */
 	properties = g_object_class_list_properties (G_OBJECT_GET_CLASS (interface), &n_properties);
@@ -520,6 +566,8 @@ nm_exported_object_skeleton_release (GDBusInterfaceSkeleton *interface)
 	g_free (skeleton_data->prop_bindings);
 	g_free (skeleton_data->method_signals);
 	g_slice_free (SkeletonData, skeleton_data);
+	nm_statistics_memory_remove (NM_STATISTICS_MEMORY_DBUS_SKELETONS,
+	                             _skeleton_sizeof (G_OBJECT_TYPE (interface)));
 
 	g_object_unref (interface);
 }
@@ -530,7 +578,10 @@ nm_exported_object_destroy_skeletons (NMExportedObject *self)
 	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
 	guint n;
 
-	g_return_if_fail (priv->num_interfaces > 0);
+	if (priv->num_interfaces == 0) {
+		/* the skeletons were never needed. */
+		return;
+	}
 	nm_assert (priv->interfaces);
 
 	n = priv->num_interfaces;
@@ -546,6 +597,40 @@ nm_exported_object_destroy_skeletons (NMExportedObject *self)
 	priv->interfaces = NULL;
 }
 
+/**
+ * nm_exported_object_ensure_skeletons:
+ * @self: an exported #NMExportedObject
+ *
+ * Creates the D-Bus interface skeletons of @self, unless that
+ * already happened. nm_exported_object_export() only does so when
+ * the bus manager is connected to the bus; otherwise nobody could
+ * introspect or call @self and they are created once the connection
+ * comes up (or somebody asks for them).
+ */
+void
+nm_exported_object_ensure_skeletons (NMExportedObject *self)
+{
+	NMExportedObjectPrivate *priv;
+	GType type;
+
+	g_return_if_fail (NM_IS_EXPORTED_OBJECT (self));
+
+	priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+
+	g_return_if_fail (priv->path);
+
+	if (priv->num_interfaces > 0)
+		return;
+
+	_LOGT ("create skeletons: \"%s\"", priv->path);
+
+	type = G_OBJECT_TYPE (self);
+	while (type != NM_TYPE_EXPORTED_OBJECT) {
+		nm_exported_object_create_skeletons (self, type);
+		type = g_type_parent (type);
+	}
+}
+
 static char *
 _create_export_path (NMExportedObjectClass *klass)
 {
@@ -621,13 +706,15 @@ nm_exported_object_is_exported (NMExportedObject *self)
  * its own counter). Otherwise, %export_path will be used literally (implying
  * that @self must be a singleton).
  *
+ * The interface skeletons are only created if the bus manager has a
+ * connection to the bus; see nm_exported_object_ensure_skeletons().
+ *
  * Returns: the path @self was exported under
  */
 const char *
 nm_exported_object_export (NMExportedObject *self)
 {
 	NMExportedObjectPrivate *priv;
-	GType type;
 
 	g_return_val_if_fail (NM_IS_EXPORTED_OBJECT (self), NULL);
 	priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
@@ -644,19 +731,16 @@ nm_exported_object_export (NMExportedObject *self)
 		g_return_val_if_reached (NULL);
 	g_object_add_weak_pointer ((GObject *) priv->bus_mgr, (gpointer *) &priv->bus_mgr);
 
-	type = G_OBJECT_TYPE (self);
-	while (type != NM_TYPE_EXPORTED_OBJECT) {
-		nm_exported_object_create_skeletons (self, type);
-		type = g_type_parent (type);
-	}
-
 	priv->path = _create_export_path (NM_EXPORTED_OBJECT_GET_CLASS (self));
 
 	_LOGT ("export: \"%s\"", priv->path);
 	g_dbus_object_skeleton_set_object_path (G_DBUS_OBJECT_SKELETON (self), priv->path);
 
-	/* Important: priv->path and priv->interfaces must not change while
-	 * the object is registered. */
+	if (nm_bus_manager_get_connection (priv->bus_mgr))
+		nm_exported_object_ensure_skeletons (self);
+
+	/* Important: priv->path must not change while the object is registered.
+	 * The interfaces are added at most once, possibly after registering. */
 
 	nm_bus_manager_register_object (priv->bus_mgr, (GDBusObjectSkeleton *) self);
 
@@ -680,8 +764,7 @@ nm_exported_object_unexport (NMExportedObject *self)
 
 	g_return_if_fail (priv->path);
 
-	/* Important: priv->path and priv->interfaces must not change while
-	 * the object is registered. */
+	/* Important: priv->path must not change while the object is registered. */
 
 	_LOGT ("unexport: \"%s\"", priv->path);
 
@@ -691,17 +774,18 @@ nm_exported_object_unexport (NMExportedObject *self)
 		priv->bus_mgr = NULL;
 	}
 
+	if (priv->notify_iter) {
+		/* We had a notification queued. Since we remove all interfaces,
+		 * the notification is obsolete and must be cleaned up. */
+		_notify_queue_remove (self);
+		g_hash_table_remove_all (priv->pending_notifies);
+	}
+
 	nm_exported_object_destroy_skeletons (self);
 
 	g_dbus_object_skeleton_set_object_path ((GDBusObjectSkeleton *) self, NULL);
 
 	g_clear_pointer (&priv->path, g_free);
-
-	if (nm_clear_g_source (&priv->notify_idle_id)) {
-		/* We had a notification queued. Since we removed all interfaces,
-		 * the notification is obsolete and must be cleaned up. */
-		g_hash_table_remove_all (priv->pending_notifies);
-	}
 }
 
 /*****************************************************************************/
@@ -741,6 +825,8 @@ nm_exported_object_get_interface_by_type (NMExportedObject *self, GType interfac
 	priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
 
 	g_return_val_if_fail (priv->path, NULL);
+
+	nm_exported_object_ensure_skeletons (self);
 	g_return_val_if_fail (priv->num_interfaces > 0, NULL);
 
 	nm_assert (priv->interfaces);
@@ -762,6 +848,20 @@ nm_exported_object_class_set_quitting (void)
 	quitting = TRUE;
 }
 
+/**
+ * nm_exported_object_class_set_notify_limits:
+ * @budget: the maximum number of objects whose PropertiesChanged signal
+ *   is emitted per main loop iteration, or 0 for no limit
+ * @max_latency_ms: the time after which all pending signals are emitted
+ *   regardless of @budget, or 0 to never force them out
+ */
+void
+nm_exported_object_class_set_notify_limits (guint budget, guint max_latency_ms)
+{
+	notify_queue.budget = budget;
+	notify_queue.max_latency_ms = max_latency_ms;
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -776,8 +876,8 @@ _sort_pending_notifies (gconstpointer a, gconstpointer b, gpointer       user_da
 	               ((const PendingNotifiesItem *) b)->property_name);
 }
 
-static gboolean
-idle_emit_properties_changed (gpointer self)
+static void
+emit_properties_changed (NMExportedObject *self)
 {
 	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
 	gs_unref_variant GVariant *variant = NULL;
@@ -787,11 +887,8 @@ idle_emit_properties_changed (gpointer self)
 	guint i, n;
 	PendingNotifiesItem *values;
 
-	priv->notify_idle_id = 0;
-
-
 	n = g_hash_table_size (priv->pending_notifies);
-	g_return_val_if_fail (n > 0, FALSE);
+	g_return_if_fail (n > 0);
 
 	values = g_alloca (sizeof (values[0]) * n);
 
@@ -816,7 +913,7 @@ idle_emit_properties_changed (gpointer self)
 			break;
 		}
 	}
-	g_return_val_if_fail (ifdata, FALSE);
+	g_return_if_fail (ifdata);
 
 	if (nm_logging_enabled (LOGL_DEBUG, LOGD_DBUS_PROPS)) {
 		gs_free char *notification = g_variant_print (variant, TRUE);
@@ -825,8 +922,88 @@ idle_emit_properties_changed (gpointer self)
 		            G_OBJECT_TYPE_NAME (self), self, notification);
 	}
 
+	nm_statistics_inc (NM_STATISTICS_COUNTER_DBUS_PROPERTIES_CHANGED);
 	g_signal_emit (ifdata->interface, ifdata->property_changed_signal_id, 0, variant);
-	return FALSE;
+}
+
+static void
+_notify_queue_flush (guint max)
+{
+	guint n = 0;
+
+	while (   !g_sequence_is_empty (notify_queue.queue)
+	       && (max == 0 || n < max)) {
+		GSequenceIter *iter = g_sequence_get_begin_iter (notify_queue.queue);
+		NMExportedObject *self = g_object_ref (g_sequence_get (iter));
+
+		g_sequence_remove (iter);
+		NM_EXPORTED_OBJECT_GET_PRIVATE (self)->notify_iter = NULL;
+
+		emit_properties_changed (self);
+		g_object_unref (self);
+		n++;
+	}
+}
+
+static gboolean
+_notify_queue_timeout_cb (gpointer user_data)
+{
+	notify_queue.timeout_id = 0;
+	_notify_queue_flush (0);
+	nm_clear_g_source (&notify_queue.idle_id);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_notify_queue_idle_cb (gpointer user_data)
+{
+	_notify_queue_flush (notify_queue.budget);
+	if (!g_sequence_is_empty (notify_queue.queue)) {
+		/* Over budget; the rest follows in the next iterations, but
+		 * no later than @max_latency_ms from now. */
+		if (!notify_queue.timeout_id && notify_queue.max_latency_ms)
+			notify_queue.timeout_id = g_timeout_add (notify_queue.max_latency_ms, _notify_queue_timeout_cb, NULL);
+		return G_SOURCE_CONTINUE;
+	}
+
+	notify_queue.idle_id = 0;
+	nm_clear_g_source (&notify_queue.timeout_id);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_notify_queue_add (NMExportedObject *self)
+{
+	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+
+	if (priv->notify_iter)
+		return;
+
+	nm_assert (priv->path);
+
+	if (!notify_queue.queue)
+		notify_queue.queue = g_sequence_new (NULL);
+	priv->notify_iter = g_sequence_append (notify_queue.queue, self);
+
+	if (!notify_queue.idle_id)
+		notify_queue.idle_id = g_idle_add (_notify_queue_idle_cb, NULL);
+}
+
+static void
+_notify_queue_remove (NMExportedObject *self)
+{
+	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+
+	if (!priv->notify_iter)
+		return;
+
+	g_sequence_remove (priv->notify_iter);
+	priv->notify_iter = NULL;
+
+	if (g_sequence_is_empty (notify_queue.queue)) {
+		nm_clear_g_source (&notify_queue.idle_id);
+		nm_clear_g_source (&notify_queue.timeout_id);
+	}
 }
 
 static void
@@ -883,8 +1060,7 @@ vtype_found:
 	                     g_dbus_gvalue_to_gvariant (&value, vtype));
 	g_value_unset (&value);
 
-	if (!priv->notify_idle_id)
-		priv->notify_idle_id = g_idle_add (idle_emit_properties_changed, object);
+	_notify_queue_add ((NMExportedObject *) object);
 }
 
 /*****************************************************************************/
@@ -933,8 +1109,8 @@ nm_exported_object_dispose (GObject *object)
 	} else
 		g_clear_pointer (&priv->path, g_free);
 
+	_notify_queue_remove (NM_EXPORTED_OBJECT (object));
 	g_clear_pointer (&priv->pending_notifies, g_hash_table_destroy);
-	nm_clear_g_source (&priv->notify_idle_id);
 
 	G_OBJECT_CLASS (nm_exported_object_parent_class)->dispose (object);
 }
@@ -66,6 +66,13 @@ GType nm_exported_object_get_type (void);
 
 void nm_exported_object_class_set_quitting  (void);
 
+/* defaults for the main.dbus-notify-budget and main.dbus-notify-max-latency
+ * configuration options */
+#define NM_EXPORTED_OBJECT_NOTIFY_BUDGET_DEFAULT      64
+#define NM_EXPORTED_OBJECT_NOTIFY_MAX_LATENCY_DEFAULT 100
+
+void nm_exported_object_class_set_notify_limits (guint budget, guint max_latency_ms);
+
 void nm_exported_object_class_add_interface (NMExportedObjectClass *object_class,
                                              GType                  dbus_skeleton_type,
                                              ...) G_GNUC_NULL_TERMINATED;
@@ -74,6 +81,7 @@ const char *nm_exported_object_export      (NMExportedObject *self);
 const char *nm_exported_object_get_path    (NMExportedObject *self);
 gboolean    nm_exported_object_is_exported (NMExportedObject *self);
 void        nm_exported_object_unexport    (NMExportedObject *self);
+void        nm_exported_object_ensure_skeletons (NMExportedObject *self);
 GDBusInterfaceSkeleton *nm_exported_object_get_interface_by_type (NMExportedObject *self, GType interface_type);
 
 void        _nm_exported_object_clear_and_unexport (NMExportedObject **location);
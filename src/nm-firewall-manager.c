@@ -44,6 +44,10 @@ typedef struct {
 	gboolean        running;
 
 	GHashTable     *pending_calls;
+
+	/* requests that are not yet sent to firewalld */
+	GQueue          queue;
+	guint           queue_id;
 } NMFirewallManagerPrivate;
 
 enum {
@@ -56,6 +60,12 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 NM_DEFINE_SINGLETON_GETTER (NMFirewallManager, nm_firewall_manager_get, NM_TYPE_FIREWALL_MANAGER);
 
+/* Requests are not sent to firewalld right away, but collected for a short
+ * while. When many devices activate at once (e.g. during startup) this
+ * collapses operations on the same interface that supersede each other and
+ * sends the rest together instead of trickling them to firewalld one by one. */
+#define QUEUE_DELAY_MSEC 50
+
 /********************************************************************/
 
 typedef enum {
@@ -66,6 +76,7 @@ typedef enum {
 
 typedef enum {
 	CB_INFO_MODE_IDLE = 1,
+	CB_INFO_MODE_QUEUED,
 	CB_INFO_MODE_DBUS,
 	CB_INFO_MODE_DBUS_COMPLETED,
 } CBInfoMode;
@@ -75,6 +86,7 @@ struct _NMFirewallManagerCallId {
 	CBInfoOpsType ops_type;
 	CBInfoMode mode;
 	char *iface;
+	char *zone;
 	NMFirewallManagerAddRemoveCallback callback;
 	gpointer user_data;
 
@@ -106,7 +118,7 @@ _ops_type_to_string (CBInfoOpsType ops_type)
 #define _NMLOG_PREFIX_NAME "firewall"
 #define _NMLOG(level, info, ...) \
     G_STMT_START { \
-        if (nm_logging_enabled ((level), (_NMLOG_DOMAIN))) { \
+        if (_nm_logging_wanted ((level), (_NMLOG_DOMAIN))) { \
             CBInfo *__info = (info); \
             char __prefix_name[30]; \
             char __prefix_info[64]; \
@@ -143,6 +155,7 @@ static CBInfo *
 _cb_info_create (NMFirewallManager *self,
                  CBInfoOpsType ops_type,
                  const char *iface,
+                 const char *zone,
                  NMFirewallManagerAddRemoveCallback callback,
                  gpointer user_data)
 {
@@ -153,11 +166,12 @@ _cb_info_create (NMFirewallManager *self,
 	info->self = g_object_ref (self);
 	info->ops_type = ops_type;
 	info->iface = g_strdup (iface);
+	info->zone = g_strdup (zone);
 	info->callback = callback;
 	info->user_data = user_data;
 
 	if (priv->running) {
-		info->mode = CB_INFO_MODE_DBUS;
+		info->mode = CB_INFO_MODE_QUEUED;
 		info->dbus.cancellable = g_cancellable_new ();
 	} else
 		info->mode = CB_INFO_MODE_IDLE;
@@ -174,6 +188,7 @@ _cb_info_free (CBInfo *info)
 	if (!_cb_info_is_idle (info))
 		g_object_unref (info->dbus.cancellable);
 	g_free (info->iface);
+	g_free (info->zone);
 	if (info->self)
 		g_object_unref (info->self);
 	g_slice_free (CBInfo, info);
@@ -261,6 +276,96 @@ _handle_dbus (GObject *proxy, GAsyncResult *result, gpointer user_data)
 	_cb_info_complete_normal (info, error);
 }
 
+static void
+_cb_info_start_dbus (CBInfo *info)
+{
+	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (info->self);
+	const char *dbus_method;
+
+	nm_assert (info->mode == CB_INFO_MODE_QUEUED);
+
+	switch (info->ops_type) {
+	case CB_INFO_OPS_ADD:
+		dbus_method = "addInterface";
+		break;
+	case CB_INFO_OPS_CHANGE:
+		dbus_method = "changeZone";
+		break;
+	case CB_INFO_OPS_REMOVE:
+		dbus_method = "removeInterface";
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+
+	info->mode = CB_INFO_MODE_DBUS;
+	g_dbus_proxy_call (priv->proxy,
+	                   dbus_method,
+	                   g_variant_new ("(ss)", info->zone ? info->zone : "", info->iface),
+	                   G_DBUS_CALL_FLAGS_NONE, 10000,
+	                   info->dbus.cancellable,
+	                   _handle_dbus,
+	                   info);
+}
+
+static void
+_cb_info_fake_success (CBInfo *info)
+{
+	nm_assert (info->mode == CB_INFO_MODE_QUEUED);
+
+	/* turn the request into an idle one. We don't invoke the callback
+	 * right away as the flush must not be reentered. */
+	g_object_unref (info->dbus.cancellable);
+	info->mode = CB_INFO_MODE_IDLE;
+	if (info->callback)
+		info->idle.id = g_idle_add (_handle_idle, info);
+	else
+		_cb_info_complete_normal (info, NULL);
+}
+
+static gboolean
+_queue_flush_cb (gpointer user_data)
+{
+	NMFirewallManager *self = user_data;
+	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *last = NULL;
+	GList *iter;
+	CBInfo *info;
+
+	priv->queue_id = 0;
+
+	/* the final state of an interface only depends on the last request for it. */
+	last = g_hash_table_new (g_str_hash, g_str_equal);
+	for (iter = priv->queue.head; iter; iter = iter->next) {
+		info = iter->data;
+		g_hash_table_insert (last, info->iface, info);
+	}
+
+	_LOGD (NULL, "flush %u queued requests for %u interfaces",
+	       priv->queue.length, g_hash_table_size (last));
+
+	while ((info = g_queue_pop_head (&priv->queue))) {
+		CBInfo *info_last = g_hash_table_lookup (last, info->iface);
+
+		if (!priv->running) {
+			_LOGD (info, "firewall stopped, simulate success");
+			_cb_info_fake_success (info);
+		} else if (info_last != info) {
+			/* a later request on the same interface supersedes this one.
+			 * Since we skip the earlier requests, the interface might still
+			 * be in some zone when the last one is sent. "changeZone" moves
+			 * it in any case while "addInterface" would fail with ZONE_CONFLICT. */
+			if (info_last->ops_type == CB_INFO_OPS_ADD)
+				info_last->ops_type = CB_INFO_OPS_CHANGE;
+			_LOGD (info, "superseded by [%p], simulate success", info_last);
+			_cb_info_fake_success (info);
+		} else
+			_cb_info_start_dbus (info);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
 static NMFirewallManagerCallId
 _start_request (NMFirewallManager *self,
                 CBInfoOpsType ops_type,
@@ -271,14 +376,13 @@ _start_request (NMFirewallManager *self,
 {
 	NMFirewallManagerPrivate *priv;
 	CBInfo *info;
-	const char *dbus_method;
 
 	g_return_val_if_fail (NM_IS_FIREWALL_MANAGER (self), NULL);
 	g_return_val_if_fail (iface && *iface, NULL);
 
 	priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
 
-	info = _cb_info_create (self, ops_type, iface, callback, user_data);
+	info = _cb_info_create (self, ops_type, iface, zone, callback, user_data);
 
 	_LOGD (info, "firewall zone %s %s:%s%s%s%s",
 	       _ops_type_to_string (info->ops_type),
@@ -287,28 +391,9 @@ _start_request (NMFirewallManager *self,
 	       _cb_info_is_idle (info) ? " (not running, simulate success)" : "");
 
 	if (!_cb_info_is_idle (info)) {
-
-		switch (ops_type) {
-		case CB_INFO_OPS_ADD:
-			dbus_method = "addInterface";
-			break;
-		case CB_INFO_OPS_CHANGE:
-			dbus_method = "changeZone";
-			break;
-		case CB_INFO_OPS_REMOVE:
-			dbus_method = "removeInterface";
-			break;
-		default:
-			g_assert_not_reached ();
-		}
-
-		g_dbus_proxy_call (priv->proxy,
-		                   dbus_method,
-		                   g_variant_new ("(ss)", zone ? zone : "", iface),
-		                   G_DBUS_CALL_FLAGS_NONE, 10000,
-		                   info->dbus.cancellable,
-		                   _handle_dbus,
-		                   info);
+		g_queue_push_tail (&priv->queue, info);
+		if (!priv->queue_id)
+			priv->queue_id = g_timeout_add (QUEUE_DELAY_MSEC, _queue_flush_cb, self);
 
 		if (!info->callback) {
 			/* if the user did not provide a callback, the call_id is useless.
@@ -389,6 +474,9 @@ nm_firewall_manager_cancel_call (NMFirewallManagerCallId call)
 	if (_cb_info_is_idle (info)) {
 		g_source_remove (info->idle.id);
 		_cb_info_free (info);
+	} else if (info->mode == CB_INFO_MODE_QUEUED) {
+		g_queue_remove (&priv->queue, info);
+		_cb_info_free (info);
 	} else {
 		info->mode = CB_INFO_MODE_DBUS_COMPLETED;
 		g_cancellable_cancel (info->dbus.cancellable);
@@ -436,6 +524,7 @@ nm_firewall_manager_init (NMFirewallManager * self)
 	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
 
 	priv->pending_calls = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_queue_init (&priv->queue);
 }
 
 static void
@@ -495,6 +584,9 @@ dispose (GObject *object)
 		priv->pending_calls = NULL;
 	}
 
+	nm_assert (g_queue_is_empty (&priv->queue));
+	nm_clear_g_source (&priv->queue_id);
+
 	g_clear_object (&priv->proxy);
 
 	/* Chain up to the parent class */
@@ -63,6 +63,7 @@ static struct {
 	gboolean g_fatal_warnings;
 	gboolean slaac_required;
 	gboolean dhcp4_required;
+	gboolean full_platform_cache;
 	int tempaddr;
 	char *ifname;
 	char *uuid;
@@ -112,7 +113,7 @@ dhcp4_state_changed (NMDhcpClient *client,
 		if (last_config)
 			g_object_unref (last_config);
 		last_config = nm_ip4_config_new (nm_dhcp_client_get_ifindex (client));
-		nm_ip4_config_replace (last_config, ip4_config, NULL);
+		nm_ip4_config_replace (last_config, ip4_config, NULL, NULL);
 		break;
 	case NM_DHCP_STATE_TIMEOUT:
 	case NM_DHCP_STATE_DONE:
@@ -293,6 +294,7 @@ do_early_setup (int *argc, char **argv[])
 		{ "iid", 'e', 0, G_OPTION_ARG_STRING, &global_opt.iid_str, N_("Hex-encoded Interface Identifier"), "" },
 		{ "addr-gen-mode", 'e', 0, G_OPTION_ARG_INT, &global_opt.addr_gen_mode, N_("IPv6 SLAAC address generation mode"), "eui64" },
 		{ "logging-backend", '\0', 0, G_OPTION_ARG_STRING, &global_opt.logging_backend, N_("The logging backend configuration value. See logging.backend in NetworkManager.conf"), NULL },
+		{ "full-platform-cache", '\0', 0, G_OPTION_ARG_NONE, &global_opt.full_platform_cache, N_("Cache all links, addresses and routes of the host instead of only those of the interface"), NULL },
 
 		/* Logging/debugging */
 		{ "version", 'V', 0, G_OPTION_ARG_NONE, &global_opt.show_version, N_("Print NetworkManager version and exit"), NULL },
@@ -424,8 +426,12 @@ main (int argc, char *argv[])
 
 	nm_log_info (LOGD_CORE, "nm-iface-helper (version " NM_DIST_VERSION ") is starting...");
 
-	/* Set up platform interaction layer */
-	nm_linux_platform_setup ();
+	/* Set up platform interaction layer. The helper only manages its own
+	 * interface, so by default it doesn't cache the rest of the host. */
+	if (global_opt.full_platform_cache)
+		nm_linux_platform_setup ();
+	else
+		nm_linux_platform_setup_for_ifindex (ifindex);
 
 	tmp = nm_platform_link_get_address (NM_PLATFORM_GET, ifindex, &hwaddr_len);
 	if (tmp) {
@@ -41,6 +41,21 @@ typedef struct {
 	gboolean has_gateway;
 	GArray *addresses;
 	GArray *routes;
+	NMUtilsArrayIndex addresses_idx;
+	NMUtilsArrayIndex routes_idx;
+	/* whether the arrays may be shared with another config, see _array_share() */
+	bool addresses_shared;
+	bool routes_shared;
+	/* cached D-Bus representations, dropped by _notify() */
+	GVariant *address_data_variant;
+	GVariant *addresses_variant;
+	GVariant *route_data_variant;
+	GVariant *routes_variant;
+	/* cached nm_ip4_config_get_digest() results, also dropped by _notify() */
+	guint64 digest;
+	guint64 digest_dns;
+	bool digest_valid:1;
+	bool digest_dns_valid:1;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -85,7 +100,7 @@ G_DEFINE_TYPE (NMIP4Config, nm_ip4_config, NM_TYPE_EXPORTED_OBJECT)
 G_STATIC_ASSERT (sizeof (uint) >= sizeof (guint32));
 G_STATIC_ASSERT (G_MAXUINT >= 0xFFFFFFFF);
 
-NM_GOBJECT_PROPERTIES_DEFINE (NMIP4Config,
+NM_GOBJECT_PROPERTIES_DEFINE_BASE (
 	PROP_IFINDEX,
 	PROP_ADDRESS_DATA,
 	PROP_ADDRESSES,
@@ -100,6 +115,38 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMIP4Config,
 	PROP_DNS_PRIORITY,
 );
 
+static void
+_notify (NMIP4Config *self, _PropertyEnums prop)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
+
+	/* Every change of an exported property gets notified. Drop the cached
+	 * variant right away, the property might be read before the notification
+	 * is dispatched. */
+	priv->digest_valid = FALSE;
+	priv->digest_dns_valid = FALSE;
+	switch (prop) {
+	case PROP_ADDRESS_DATA:
+		nm_clear_g_variant (&priv->address_data_variant);
+		break;
+	case PROP_GATEWAY:
+		/* the legacy addresses carry the gateway. */
+	case PROP_ADDRESSES:
+		nm_clear_g_variant (&priv->addresses_variant);
+		break;
+	case PROP_ROUTE_DATA:
+		nm_clear_g_variant (&priv->route_data_variant);
+		break;
+	case PROP_ROUTES:
+		nm_clear_g_variant (&priv->routes_variant);
+		break;
+	default:
+		break;
+	}
+
+	g_object_notify_by_pspec ((GObject *) self, obj_properties[prop]);
+}
+
 NMIP4Config *
 nm_ip4_config_new (int ifindex)
 {
@@ -109,6 +156,18 @@ nm_ip4_config_new (int ifindex)
 	                                     NULL);
 }
 
+NMIP4Config *
+nm_ip4_config_new_cloned (const NMIP4Config *src)
+{
+	NMIP4Config *new;
+
+	g_return_val_if_fail (NM_IS_IP4_CONFIG (src), NULL);
+
+	new = nm_ip4_config_new (nm_ip4_config_get_ifindex (src));
+	nm_ip4_config_replace (new, src, NULL, NULL);
+	return new;
+}
+
 int
 nm_ip4_config_get_ifindex (const NMIP4Config *config)
 {
@@ -205,6 +264,110 @@ routes_are_duplicate (const NMPlatformIP4Route *a, const NMPlatformIP4Route *b,
 	       (!consider_gateway_and_metric || (a->gateway == b->gateway && a->metric == b->metric));
 }
 
+/* whether the two differ only in attributes that are not exported on D-Bus. */
+static gboolean
+addresses_are_dbus_equal (const NMPlatformIP4Address *a, const NMPlatformIP4Address *b)
+{
+	return    a->address == b->address
+	       && a->plen == b->plen
+	       && a->peer_address == b->peer_address
+	       && strcmp (a->label, b->label) == 0;
+}
+
+static gboolean
+routes_are_dbus_equal (const NMPlatformIP4Route *a, const NMPlatformIP4Route *b)
+{
+	return routes_are_duplicate (a, b, TRUE);
+}
+
+/* hash and equal functions for the identity of addresses and routes, consistent
+ * with addresses_are_duplicate() and routes_are_duplicate(). */
+
+static guint
+_addresses_id_hash (gconstpointer ptr)
+{
+	const NMPlatformIP4Address *a = ptr;
+	guint h = 1979;
+
+	h = (h * 33) + a->address;
+	h = (h * 33) + a->plen;
+	h = (h * 33) + (a->peer_address & nm_utils_ip4_prefix_to_netmask (a->plen));
+	return h;
+}
+
+static gboolean
+_addresses_id_equal (gconstpointer a, gconstpointer b)
+{
+	return addresses_are_duplicate (a, b);
+}
+
+static guint
+_routes_id_hash (gconstpointer ptr)
+{
+	const NMPlatformIP4Route *r = ptr;
+	guint h = 2011;
+
+	h = (h * 33) + r->network;
+	h = (h * 33) + r->plen;
+	return h;
+}
+
+static gboolean
+_routes_id_equal (gconstpointer a, gconstpointer b)
+{
+	return routes_are_duplicate (a, b, FALSE);
+}
+
+/*****************************************************************************/
+
+/* nm_ip4_config_replace() doesn't copy the address and route arrays but
+ * shares them with the source. Configs that are replaced with an unchanged
+ * source thus keep the same arrays and the next replace only compares
+ * pointers. Whoever modifies an array in place must unshare it first.
+ *
+ * Both configs mark the array as shared. The flag is not cleared when the
+ * other config lets go of it, so that costs one copy too many at worst. */
+static void
+_array_share (GArray **p_dst, bool *p_dst_shared, NMUtilsArrayIndex *dst_idx,
+              GArray *src, bool *p_src_shared)
+{
+	if (*p_dst == src)
+		return;
+
+	g_array_unref (*p_dst);
+	*p_dst = g_array_ref (src);
+	*p_dst_shared = TRUE;
+	*p_src_shared = TRUE;
+	nm_utils_array_index_clear (dst_idx);
+}
+
+static void
+_array_ensure_writable (GArray **p_array, bool *p_shared, NMUtilsArrayIndex *idx, gboolean copy)
+{
+	GArray *old = *p_array;
+
+	if (!*p_shared)
+		return;
+
+	*p_array = g_array_sized_new (FALSE, FALSE, g_array_get_element_size (old), copy ? old->len : 0);
+	if (copy)
+		g_array_append_vals (*p_array, old->data, old->len);
+	g_array_unref (old);
+	*p_shared = FALSE;
+	nm_utils_array_index_clear (idx);
+}
+
+#define _addresses_share(dst_priv, src_priv) \
+	_array_share (&(dst_priv)->addresses, &(dst_priv)->addresses_shared, &(dst_priv)->addresses_idx, \
+	              (src_priv)->addresses, &(src_priv)->addresses_shared)
+#define _routes_share(dst_priv, src_priv) \
+	_array_share (&(dst_priv)->routes, &(dst_priv)->routes_shared, &(dst_priv)->routes_idx, \
+	              (src_priv)->routes, &(src_priv)->routes_shared)
+#define _addresses_ensure_writable(priv, copy) \
+	_array_ensure_writable (&(priv)->addresses, &(priv)->addresses_shared, &(priv)->addresses_idx, (copy))
+#define _routes_ensure_writable(priv, copy) \
+	_array_ensure_writable (&(priv)->routes, &(priv)->routes_shared, &(priv)->routes_idx, (copy))
+
 /*****************************************************************************/
 
 static gint
@@ -252,11 +415,13 @@ nm_ip4_config_addresses_sort (NMIP4Config *self)
 
 	priv = NM_IP4_CONFIG_GET_PRIVATE (self);
 	if (priv->addresses->len > 1) {
+		_addresses_ensure_writable (priv, TRUE);
 		data_len = priv->addresses->len * g_array_get_element_size (priv->addresses);
 		data_pre = g_new (char, data_len);
 		memcpy (data_pre, priv->addresses->data, data_len);
 
 		g_array_sort (priv->addresses, _addresses_sort_cmp);
+		nm_utils_array_index_clear (&priv->addresses_idx);
 
 		changed = memcmp (data_pre, priv->addresses->data, data_len) != 0;
 		g_free (data_pre);
@@ -281,6 +446,9 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	guint32 lowest_metric = G_MAXUINT32;
 	guint32 old_gateway = 0;
 	gboolean old_has_gateway = FALSE;
+	const NMPlatformIP4Address *const *plat_addresses;
+	const NMPlatformIP4Route *const *plat_routes;
+	guint n_plat_addresses, n_plat_routes;
 
 	/* Slaves have no IP configuration */
 	if (nm_platform_link_get_master (NM_PLATFORM_GET, ifindex) > 0)
@@ -289,17 +457,21 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	config = nm_ip4_config_new (ifindex);
 	priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
-	g_array_unref (priv->addresses);
-	g_array_unref (priv->routes);
+	/* Read directly from the platform cache. The views are valid until we
+	 * call into platform again, so all copying happens right here. */
+	plat_addresses = nm_platform_ip4_address_get_view (NM_PLATFORM_GET, ifindex, &n_plat_addresses);
+	plat_routes = nm_platform_ip4_route_get_view (NM_PLATFORM_GET, ifindex,
+	                                              NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT,
+	                                              &n_plat_routes);
 
-	priv->addresses = nm_platform_ip4_address_get_all (NM_PLATFORM_GET, ifindex);
-	priv->routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	for (i = 0; i < n_plat_addresses; i++)
+		g_array_append_vals (priv->addresses, plat_addresses[i], 1);
 
 	/* Extract gateway from default route */
 	old_gateway = priv->gateway;
 	old_has_gateway = priv->has_gateway;
-	for (i = 0; i < priv->routes->len; ) {
-		const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	for (i = 0; i < n_plat_routes; i++) {
+		const NMPlatformIP4Route *route = plat_routes[i];
 
 		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
 			if (route->metric < lowest_metric) {
@@ -307,31 +479,30 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 				lowest_metric = route->metric;
 			}
 			priv->has_gateway = TRUE;
-			/* Remove the default route from the list */
-			g_array_remove_index_fast (priv->routes, i);
-			continue;
 		}
-		i++;
 	}
 
 	/* we detect the route metric based on the default route. All non-default
 	 * routes have their route metrics explicitly set. */
 	priv->route_metric = priv->has_gateway ? (gint64) lowest_metric : (gint64) -1;
 
-	/* If there is a host route to the gateway, ignore that route.  It is
-	 * automatically added by NetworkManager when needed.
-	 */
-	if (priv->has_gateway) {
-		for (i = 0; i < priv->routes->len; i++) {
-			const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	for (i = 0; i < n_plat_routes; i++) {
+		const NMPlatformIP4Route *route = plat_routes[i];
 
-			if (   (route->plen == 32)
-			    && (route->network == priv->gateway)
-			    && (route->gateway == 0)) {
-				g_array_remove_index (priv->routes, i);
-				i--;
-			}
-		}
+		/* Skip the default routes, they are tracked as gateway. */
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+			continue;
+
+		/* If there is a host route to the gateway, ignore that route.  It is
+		 * automatically added by NetworkManager when needed.
+		 */
+		if (   priv->has_gateway
+		    && (route->plen == 32)
+		    && (route->network == priv->gateway)
+		    && (route->gateway == 0))
+			continue;
+
+		g_array_append_vals (priv->routes, route, 1);
 	}
 
 	/* If the interface has the default route, and has IPv4 addresses, capture
@@ -523,6 +694,7 @@ nm_ip4_config_merge_setting (NMIP4Config *config, NMSettingIPConfig *setting, gu
 		else
 			route.metric = nm_ip_route_get_metric (s_route);
 		route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+		nm_utils_ip_route_attributes_to_platform (s_route, (NMPlatformIPRoute *) &route);
 
 		nm_ip4_config_add_route (config, &route);
 	}
@@ -769,16 +941,12 @@ nm_ip4_config_merge (NMIP4Config *dst, const NMIP4Config *src, NMIPConfigMergeFl
 static int
 _addresses_get_index (const NMIP4Config *self, const NMPlatformIP4Address *addr)
 {
-	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
-	guint i;
+	/* the index is only a cache, it's fine to update it for a const @self. */
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) self);
 
-	for (i = 0; i < priv->addresses->len; i++) {
-		const NMPlatformIP4Address *a = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
-
-		if (addresses_are_duplicate (addr, a))
-			return (int) i;
-	}
-	return -1;
+	return nm_utils_array_index_lookup (&priv->addresses_idx, priv->addresses,
+	                                    _addresses_id_hash, _addresses_id_equal,
+	                                    addr);
 }
 
 static int
@@ -799,17 +967,11 @@ _nameservers_get_index (const NMIP4Config *self, guint32 ns)
 static int
 _routes_get_index (const NMIP4Config *self, const NMPlatformIP4Route *route)
 {
-	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
-	guint i;
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) self);
 
-	for (i = 0; i < priv->routes->len; i++) {
-		const NMPlatformIP4Route *r = &g_array_index (priv->routes, NMPlatformIP4Route, i);
-
-		if (   route->network == r->network
-		    && route->plen == r->plen)
-			return (int) i;
-	}
-	return -1;
+	return nm_utils_array_index_lookup (&priv->routes_idx, priv->routes,
+	                                    _routes_id_hash, _routes_id_equal,
+	                                    route);
 }
 
 static int
@@ -899,6 +1061,8 @@ _wins_get_index (const NMIP4Config *self, guint32 wins_server)
 void
 nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 {
+	NMIP4ConfigPrivate *dst_priv;
+	const NMIP4ConfigPrivate *src_priv;
 	guint32 i;
 	gint idx;
 
@@ -907,11 +1071,16 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 
 	g_object_freeze_notify (G_OBJECT (dst));
 
+	dst_priv = NM_IP4_CONFIG_GET_PRIVATE (dst);
+	src_priv = NM_IP4_CONFIG_GET_PRIVATE (src);
+
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++) {
-		idx = _addresses_get_index (dst, nm_ip4_config_get_address (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_address (dst, idx);
+	_addresses_ensure_writable (dst_priv, TRUE);
+	if (nm_utils_array_index_subtract (dst_priv->addresses, &dst_priv->addresses_idx,
+	                                   src_priv->addresses,
+	                                   _addresses_id_hash, _addresses_id_equal)) {
+		_notify (dst, PROP_ADDRESS_DATA);
+		_notify (dst, PROP_ADDRESSES);
 	}
 
 	/* nameservers */
@@ -932,10 +1101,12 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 	/* ignore route_metric */
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (src); i++) {
-		idx = _routes_get_index (dst, nm_ip4_config_get_route (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_route (dst, idx);
+	_routes_ensure_writable (dst_priv, TRUE);
+	if (nm_utils_array_index_subtract (dst_priv->routes, &dst_priv->routes_idx,
+	                                   src_priv->routes,
+	                                   _routes_id_hash, _routes_id_equal)) {
+		_notify (dst, PROP_ROUTE_DATA);
+		_notify (dst, PROP_ROUTES);
 	}
 
 	/* domains */
@@ -994,21 +1165,24 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 void
 nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 {
-	guint32 i;
-	gint idx;
+	NMIP4ConfigPrivate *dst_priv, *src_priv;
 
 	g_return_if_fail (src != NULL);
 	g_return_if_fail (dst != NULL);
 
+	dst_priv = NM_IP4_CONFIG_GET_PRIVATE (dst);
+	/* @src is not modified, only its cached indexes get updated. */
+	src_priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) src);
+
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (dst); ) {
-		idx = _addresses_get_index (src, nm_ip4_config_get_address (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_address (dst, i);
-		else
-			i++;
+	_addresses_ensure_writable (dst_priv, TRUE);
+	if (nm_utils_array_index_intersect (dst_priv->addresses, &dst_priv->addresses_idx,
+	                                    src_priv->addresses, &src_priv->addresses_idx,
+	                                    _addresses_id_hash, _addresses_id_equal)) {
+		_notify (dst, PROP_ADDRESS_DATA);
+		_notify (dst, PROP_ADDRESSES);
 	}
 
 	/* ignore route_metric */
@@ -1022,12 +1196,12 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 	}
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (dst); ) {
-		idx = _routes_get_index (src, nm_ip4_config_get_route (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_route (dst, i);
-		else
-			i++;
+	_routes_ensure_writable (dst_priv, TRUE);
+	if (nm_utils_array_index_intersect (dst_priv->routes, &dst_priv->routes_idx,
+	                                    src_priv->routes, &src_priv->routes_idx,
+	                                    _routes_id_hash, _routes_id_equal)) {
+		_notify (dst, PROP_ROUTE_DATA);
+		_notify (dst, PROP_ROUTES);
 	}
 
 	/* ignore domains */
@@ -1047,6 +1221,8 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
  * @relevant_changes: return whether there are changes to the
  * destination object that are relevant. This is equal to
  * nm_ip4_config_equal() showing any difference.
+ * @out_changes: (allow-none): return which parts of @dst changed.
+ *   Only the changed collections emit a property notification.
  *
  * Replaces everything in @dst with @src so that the two configurations
  * contain the same content -- with the exception of the dbus path.
@@ -1055,12 +1231,14 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
  * that are not signaled by the output parameter @relevant_changes).
  */
 gboolean
-nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relevant_changes)
+nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relevant_changes,
+                       NMIPConfigChangeFlags *out_changes)
 {
 #if NM_MORE_ASSERTS
 	gboolean config_equal;
 #endif
-	gboolean has_minor_changes = FALSE, has_relevant_changes = FALSE, are_equal;
+	gboolean has_minor_changes = FALSE, has_relevant_changes = FALSE, are_equal, dbus_equal;
+	NMIPConfigChangeFlags changes = NM_IP_CONFIG_CHANGE_NONE;
 	guint i, num;
 	NMIP4ConfigPrivate *dst_priv;
 	const NMIP4ConfigPrivate *src_priv;
@@ -1083,12 +1261,14 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 	/* ifindex */
 	if (src_priv->ifindex != dst_priv->ifindex) {
 		dst_priv->ifindex = src_priv->ifindex;
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
 	/* never_default */
 	if (src_priv->never_default != dst_priv->never_default) {
 		dst_priv->never_default = src_priv->never_default;
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
@@ -1099,59 +1279,88 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 			nm_ip4_config_set_gateway (dst, src_priv->gateway);
 		else
 			nm_ip4_config_unset_gateway (dst);
+		changes |= NM_IP_CONFIG_CHANGE_GATEWAY;
 		has_relevant_changes = TRUE;
 	}
 
 	if (src_priv->route_metric != dst_priv->route_metric) {
 		dst_priv->route_metric = src_priv->route_metric;
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
 	/* addresses */
-	num = nm_ip4_config_get_num_addresses (src);
-	are_equal = num == nm_ip4_config_get_num_addresses (dst);
-	if (are_equal) {
-		for (i = 0; i < num; i++ ) {
-			if (nm_platform_ip4_address_cmp (src_addr = nm_ip4_config_get_address (src, i),
-			                                 dst_addr = nm_ip4_config_get_address (dst, i))) {
-				are_equal = FALSE;
-				if (   !addresses_are_duplicate (src_addr, dst_addr)
-				    || src_addr->peer_address != dst_addr->peer_address) {
-					has_relevant_changes = TRUE;
-					break;
+	if (dst_priv->addresses != src_priv->addresses) {
+		num = nm_ip4_config_get_num_addresses (src);
+		are_equal = num == nm_ip4_config_get_num_addresses (dst);
+		dbus_equal = are_equal;
+		if (are_equal) {
+			for (i = 0; i < num; i++ ) {
+				if (nm_platform_ip4_address_cmp (src_addr = nm_ip4_config_get_address (src, i),
+				                                 dst_addr = nm_ip4_config_get_address (dst, i))) {
+					are_equal = FALSE;
+					if (   !addresses_are_duplicate (src_addr, dst_addr)
+					    || src_addr->peer_address != dst_addr->peer_address) {
+						has_relevant_changes = TRUE;
+						dbus_equal = FALSE;
+						break;
+					}
+					if (!addresses_are_dbus_equal (src_addr, dst_addr))
+						dbus_equal = FALSE;
 				}
 			}
+		} else
+			has_relevant_changes = TRUE;
+		if (!are_equal) {
+			if (dbus_equal) {
+				/* only attributes changed that are not exported on D-Bus, such as
+				 * the lifetimes on a DHCP renewal. Don't notify. */
+				changes |= NM_IP_CONFIG_CHANGE_ADDRESS_ATTRIBUTES;
+			} else {
+				_notify (dst, PROP_ADDRESS_DATA);
+				_notify (dst, PROP_ADDRESSES);
+				changes |= NM_IP_CONFIG_CHANGE_ADDRESSES;
+			}
+			has_minor_changes = TRUE;
 		}
-	} else
-		has_relevant_changes = TRUE;
-	if (!are_equal) {
-		nm_ip4_config_reset_addresses (dst);
-		for (i = 0; i < num; i++)
-			nm_ip4_config_add_address (dst, nm_ip4_config_get_address (src, i));
-		has_minor_changes = TRUE;
+		/* also when they are equal, so that the next time only the pointers
+		 * are compared. */
+		_addresses_share (dst_priv, (NMIP4ConfigPrivate *) src_priv);
 	}
 
 	/* routes */
-	num = nm_ip4_config_get_num_routes (src);
-	are_equal = num == nm_ip4_config_get_num_routes (dst);
-	if (are_equal) {
-		for (i = 0; i < num; i++ ) {
-			if (nm_platform_ip4_route_cmp (src_route = nm_ip4_config_get_route (src, i),
-			                               dst_route = nm_ip4_config_get_route (dst, i))) {
-				are_equal = FALSE;
-				if (!routes_are_duplicate (src_route, dst_route, TRUE)) {
-					has_relevant_changes = TRUE;
-					break;
+	if (dst_priv->routes != src_priv->routes) {
+		num = nm_ip4_config_get_num_routes (src);
+		are_equal = num == nm_ip4_config_get_num_routes (dst);
+		dbus_equal = are_equal;
+		if (are_equal) {
+			for (i = 0; i < num; i++ ) {
+				if (nm_platform_ip4_route_cmp (src_route = nm_ip4_config_get_route (src, i),
+				                               dst_route = nm_ip4_config_get_route (dst, i))) {
+					are_equal = FALSE;
+					if (!routes_are_duplicate (src_route, dst_route, TRUE)) {
+						has_relevant_changes = TRUE;
+						dbus_equal = FALSE;
+						break;
+					}
+					if (!routes_are_dbus_equal (src_route, dst_route))
+						dbus_equal = FALSE;
 				}
 			}
+		} else
+			has_relevant_changes = TRUE;
+		if (!are_equal) {
+			if (dbus_equal)
+				changes |= NM_IP_CONFIG_CHANGE_ROUTE_ATTRIBUTES;
+			else {
+				_notify (dst, PROP_ROUTE_DATA);
+				_notify (dst, PROP_ROUTES);
+				changes |= NM_IP_CONFIG_CHANGE_ROUTES;
+			}
+			has_minor_changes = TRUE;
 		}
-	} else
-		has_relevant_changes = TRUE;
-	if (!are_equal) {
-		nm_ip4_config_reset_routes (dst);
-		for (i = 0; i < num; i++)
-			nm_ip4_config_add_route (dst, nm_ip4_config_get_route (src, i));
-		has_minor_changes = TRUE;
+		/* the routes of @src have the ifindex of @src, which @dst has now. */
+		_routes_share (dst_priv, (NMIP4ConfigPrivate *) src_priv);
 	}
 
 	/* nameservers */
@@ -1169,6 +1378,7 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_nameservers (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_nameserver (dst, nm_ip4_config_get_nameserver (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_NAMESERVERS;
 		has_relevant_changes = TRUE;
 	}
 
@@ -1188,6 +1398,7 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_domains (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_domain (dst, nm_ip4_config_get_domain (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_DOMAINS;
 		has_relevant_changes = TRUE;
 	}
 
@@ -1207,6 +1418,7 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_searches (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_search (dst, nm_ip4_config_get_search (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_SEARCHES;
 		has_relevant_changes = TRUE;
 	}
 
@@ -1226,18 +1438,21 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_dns_options (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_dns_option (dst, nm_ip4_config_get_dns_option (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_DNS_OPTIONS;
 		has_relevant_changes = TRUE;
 	}
 
 	/* DNS priority */
 	if (src_priv->dns_priority != dst_priv->dns_priority) {
 		nm_ip4_config_set_dns_priority (dst, src_priv->dns_priority);
+		changes |= NM_IP_CONFIG_CHANGE_DNS_PRIORITY;
 		has_relevant_changes = TRUE;
 	}
 
 	/* mss */
 	if (src_priv->mss != dst_priv->mss) {
 		nm_ip4_config_set_mss (dst, src_priv->mss);
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
@@ -1256,12 +1471,14 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_nis_servers (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_nis_server (dst, nm_ip4_config_get_nis_server (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_NIS;
 		has_relevant_changes = TRUE;
 	}
 
 	/* nis_domain */
 	if (g_strcmp0 (src_priv->nis_domain, dst_priv->nis_domain)) {
 		nm_ip4_config_set_nis_domain (dst, src_priv->nis_domain);
+		changes |= NM_IP_CONFIG_CHANGE_NIS;
 		has_relevant_changes = TRUE;
 	}
 
@@ -1280,18 +1497,21 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 		nm_ip4_config_reset_wins (dst);
 		for (i = 0; i < num; i++)
 			nm_ip4_config_add_wins (dst, nm_ip4_config_get_wins (src, i));
+		changes |= NM_IP_CONFIG_CHANGE_WINS;
 		has_relevant_changes = TRUE;
 	}
 
 	/* mtu */
 	if (src_priv->mtu != dst_priv->mtu) {
 		nm_ip4_config_set_mtu (dst, src_priv->mtu, src_priv->mtu_source);
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
 	/* metered */
 	if (src_priv->metered != dst_priv->metered) {
 		dst_priv->metered = src_priv->metered;
+		changes |= NM_IP_CONFIG_CHANGE_OTHER;
 		has_minor_changes = TRUE;
 	}
 
@@ -1305,6 +1525,8 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 
 	if (relevant_changes)
 		*relevant_changes = has_relevant_changes;
+	if (out_changes)
+		*out_changes = changes;
 
 	return has_relevant_changes || has_minor_changes;
 }
@@ -1491,7 +1713,9 @@ nm_ip4_config_reset_addresses (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->addresses->len != 0) {
+		_addresses_ensure_writable (priv, FALSE);
 		g_array_set_size (priv->addresses, 0);
+		nm_utils_array_index_clear (&priv->addresses_idx);
 		_notify (config, PROP_ADDRESS_DATA);
 		_notify (config, PROP_ADDRESSES);
 	}
@@ -1516,38 +1740,41 @@ nm_ip4_config_add_address (NMIP4Config *config, const NMPlatformIP4Address *new)
 
 	g_return_if_fail (new != NULL);
 
-	for (i = 0; i < priv->addresses->len; i++ ) {
+	i = _addresses_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Address *item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
 
-		if (addresses_are_duplicate (item, new)) {
-			if (nm_platform_ip4_address_cmp (item, new) == 0)
-				return;
-
-			/* remember the old values. */
-			item_old = *item;
-			/* Copy over old item to get new lifetime, timestamp, preferred */
-			*item = *new;
-
-			/* But restore highest priority source */
-			item->addr_source = MAX (item_old.addr_source, new->addr_source);
-
-			/* for addresses that we read from the kernel, we keep the timestamps as defined
-			 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
-			 * with "what should be" and the kernel values are "what turned out after configuring it".
-			 *
-			 * For other sources, the longer lifetime wins. */
-			if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
-			    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
-				item->timestamp = item_old.timestamp;
-				item->lifetime = item_old.lifetime;
-				item->preferred = item_old.preferred;
-			}
-			if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
-				return;
-			goto NOTIFY;
+		if (nm_platform_ip4_address_cmp (item, new) == 0)
+			return;
+
+		_addresses_ensure_writable (priv, TRUE);
+		item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+
+		/* remember the old values. */
+		item_old = *item;
+		/* Copy over old item to get new lifetime, timestamp, preferred */
+		*item = *new;
+
+		/* But restore highest priority source */
+		item->addr_source = MAX (item_old.addr_source, new->addr_source);
+
+		/* for addresses that we read from the kernel, we keep the timestamps as defined
+		 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
+		 * with "what should be" and the kernel values are "what turned out after configuring it".
+		 *
+		 * For other sources, the longer lifetime wins. */
+		if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
+		    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
+			item->timestamp = item_old.timestamp;
+			item->lifetime = item_old.lifetime;
+			item->preferred = item_old.preferred;
 		}
+		if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
+			return;
+		goto NOTIFY;
 	}
 
+	_addresses_ensure_writable (priv, TRUE);
 	g_array_append_val (priv->addresses, *new);
 NOTIFY:
 	_notify (config, PROP_ADDRESS_DATA);
@@ -1561,7 +1788,9 @@ nm_ip4_config_del_address (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->addresses->len);
 
+	_addresses_ensure_writable (priv, TRUE);
 	g_array_remove_index (priv->addresses, i);
+	nm_utils_array_index_clear (&priv->addresses_idx);
 	_notify (config, PROP_ADDRESS_DATA);
 	_notify (config, PROP_ADDRESSES);
 }
@@ -1597,7 +1826,9 @@ nm_ip4_config_reset_routes (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->routes->len != 0) {
+		_routes_ensure_writable (priv, FALSE);
 		g_array_set_size (priv->routes, 0);
+		nm_utils_array_index_clear (&priv->routes_idx);
 		_notify (config, PROP_ROUTE_DATA);
 		_notify (config, PROP_ROUTES);
 	}
@@ -1624,21 +1855,23 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 	g_return_if_fail (new->plen > 0 && new->plen <= 32);
 	g_assert (priv->ifindex);
 
-	for (i = 0; i < priv->routes->len; i++ ) {
+	i = _routes_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Route *item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 
-		if (routes_are_duplicate (item, new, FALSE)) {
-			if (nm_platform_ip4_route_cmp (item, new) == 0)
-				return;
-			old_source = item->rt_source;
-			memcpy (item, new, sizeof (*item));
-			/* Restore highest priority source */
-			item->rt_source = MAX (old_source, new->rt_source);
-			item->ifindex = priv->ifindex;
-			goto NOTIFY;
-		}
+		if (nm_platform_ip4_route_cmp (item, new) == 0)
+			return;
+		_routes_ensure_writable (priv, TRUE);
+		item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+		old_source = item->rt_source;
+		memcpy (item, new, sizeof (*item));
+		/* Restore highest priority source */
+		item->rt_source = MAX (old_source, new->rt_source);
+		item->ifindex = priv->ifindex;
+		goto NOTIFY;
 	}
 
+	_routes_ensure_writable (priv, TRUE);
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP4Route, priv->routes->len - 1).ifindex = priv->ifindex;
 NOTIFY:
@@ -1646,6 +1879,39 @@ NOTIFY:
 	_notify (config, PROP_ROUTES);
 }
 
+/**
+ * nm_ip4_config_add_routes:
+ * @config: the #NMIP4Config
+ * @routes: the routes to add
+ * @len: number of elements in @routes
+ *
+ * Like calling nm_ip4_config_add_route() for each element of @routes, but
+ * the array is grown only once and the properties are notified only once.
+ * For the large route sets that VPNs push.
+ */
+void
+nm_ip4_config_add_routes (NMIP4Config *config, const NMPlatformIP4Route *routes, guint len)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	guint i, old_len;
+
+	g_return_if_fail (routes || !len);
+
+	if (!len)
+		return;
+
+	/* reserve the space up front: GArray keeps its allocation when shrinking. */
+	_routes_ensure_writable (priv, TRUE);
+	old_len = priv->routes->len;
+	g_array_set_size (priv->routes, old_len + len);
+	g_array_set_size (priv->routes, old_len);
+
+	g_object_freeze_notify (G_OBJECT (config));
+	for (i = 0; i < len; i++)
+		nm_ip4_config_add_route (config, &routes[i]);
+	g_object_thaw_notify (G_OBJECT (config));
+}
+
 void
 nm_ip4_config_del_route (NMIP4Config *config, guint i)
 {
@@ -1653,11 +1919,67 @@ nm_ip4_config_del_route (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->routes->len);
 
+	_routes_ensure_writable (priv, TRUE);
 	g_array_remove_index (priv->routes, i);
+	nm_utils_array_index_clear (&priv->routes_idx);
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
 }
 
+/**
+ * nm_ip4_config_lookup_route:
+ * @config: the #NMIP4Config
+ * @needle: the route to look up
+ *
+ * Returns: the first route of @config with the same network and prefix
+ *   as @needle, or %NULL.
+ */
+const NMPlatformIP4Route *
+nm_ip4_config_lookup_route (const NMIP4Config *config, const NMPlatformIP4Route *needle)
+{
+	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	int i;
+
+	i = _routes_get_index (config, needle);
+	return i >= 0 ? &g_array_index (priv->routes, NMPlatformIP4Route, i) : NULL;
+}
+
+/**
+ * nm_ip4_config_remove_route:
+ * @config: the #NMIP4Config
+ * @needle: the route to remove
+ * @exact: if %TRUE, only remove the routes that also have the gateway
+ *   and metric of @needle
+ *
+ * Removes the routes with the same network and prefix as @needle.
+ *
+ * Returns: whether any route was removed.
+ */
+gboolean
+nm_ip4_config_remove_route (NMIP4Config *config, const NMPlatformIP4Route *needle, gboolean exact)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	gboolean changed = FALSE;
+	guint i;
+
+	g_return_val_if_fail (needle, FALSE);
+
+	for (i = priv->routes->len; i > 0; i--) {
+		if (routes_are_duplicate (&g_array_index (priv->routes, NMPlatformIP4Route, i - 1), needle, exact)) {
+			_routes_ensure_writable (priv, TRUE);
+			g_array_remove_index (priv->routes, i - 1);
+			changed = TRUE;
+		}
+	}
+
+	if (changed) {
+		nm_utils_array_index_clear (&priv->routes_idx);
+		_notify (config, PROP_ROUTE_DATA);
+		_notify (config, PROP_ROUTES);
+	}
+	return changed;
+}
+
 guint
 nm_ip4_config_get_num_routes (const NMIP4Config *config)
 {
@@ -1993,6 +2315,7 @@ nm_ip4_config_reset_nis_servers (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	g_array_set_size (priv->nis, 0);
+	priv->digest_valid = FALSE;
 }
 
 void
@@ -2006,6 +2329,7 @@ nm_ip4_config_add_nis_server (NMIP4Config *config, guint32 nis)
 			return;
 
 	g_array_append_val (priv->nis, nis);
+	priv->digest_valid = FALSE;
 }
 
 void
@@ -2016,6 +2340,7 @@ nm_ip4_config_del_nis_server (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->nis->len);
 
 	g_array_remove_index (priv->nis, i);
+	priv->digest_valid = FALSE;
 }
 
 guint32
@@ -2041,6 +2366,7 @@ nm_ip4_config_set_nis_domain (NMIP4Config *config, const char *domain)
 
 	g_free (priv->nis_domain);
 	priv->nis_domain = g_strdup (domain);
+	priv->digest_valid = FALSE;
 }
 
 const char *
@@ -2224,6 +2550,111 @@ nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only
 	hash_u32 (sum, (guint32) nm_ip4_config_get_dns_priority (config));
 }
 
+static guint64
+_digest_compute (const NMIP4ConfigPrivate *priv, gboolean dns_only)
+{
+	guint64 h = NM_UTILS_DIGEST_INIT;
+	guint i;
+
+	if (!dns_only) {
+		h = nm_utils_digest_u32 (h, priv->has_gateway);
+		h = nm_utils_digest_u32 (h, priv->gateway);
+
+		h = nm_utils_digest_u32 (h, priv->addresses->len);
+		for (i = 0; i < priv->addresses->len; i++) {
+			const NMPlatformIP4Address *address = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+
+			h = nm_utils_digest_u32 (h, address->address);
+			h = nm_utils_digest_u32 (h, address->plen);
+			h = nm_utils_digest_u32 (h, address->peer_address & nm_utils_ip4_prefix_to_netmask (address->plen));
+		}
+
+		h = nm_utils_digest_u32 (h, priv->routes->len);
+		for (i = 0; i < priv->routes->len; i++) {
+			const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+
+			h = nm_utils_digest_u32 (h, route->network);
+			h = nm_utils_digest_u32 (h, route->plen);
+			h = nm_utils_digest_u32 (h, route->gateway);
+			h = nm_utils_digest_u32 (h, route->metric);
+		}
+
+		h = nm_utils_digest_mem (h, priv->nis->data, priv->nis->len * sizeof (guint32));
+		h = nm_utils_digest_str (h, priv->nis_domain);
+	}
+
+	h = nm_utils_digest_mem (h, priv->nameservers->data, priv->nameservers->len * sizeof (guint32));
+	h = nm_utils_digest_mem (h, priv->wins->data, priv->wins->len * sizeof (guint32));
+
+	h = nm_utils_digest_u32 (h, priv->domains->len);
+	for (i = 0; i < priv->domains->len; i++)
+		h = nm_utils_digest_str (h, priv->domains->pdata[i]);
+
+	h = nm_utils_digest_u32 (h, priv->searches->len);
+	for (i = 0; i < priv->searches->len; i++)
+		h = nm_utils_digest_str (h, priv->searches->pdata[i]);
+
+	h = nm_utils_digest_u32 (h, priv->dns_options->len);
+	for (i = 0; i < priv->dns_options->len; i++)
+		h = nm_utils_digest_str (h, priv->dns_options->pdata[i]);
+
+	return nm_utils_digest_u32 (h, (guint32) priv->dns_priority);
+}
+
+/**
+ * nm_ip4_config_get_digest:
+ * @config: the #NMIP4Config
+ * @dns_only: only cover the DNS related attributes
+ *
+ * Returns a 64 bit digest over the same attributes as nm_ip4_config_hash().
+ * The digest is cached until the next change of @config, so comparing
+ * configs this way is cheap. It is only meaningful within this process;
+ * use nm_ip4_config_hash() if the value must be stable.
+ *
+ * Returns: the digest of @config
+ */
+guint64
+nm_ip4_config_get_digest (const NMIP4Config *config, gboolean dns_only)
+{
+	/* the digests are only a cache and don't change the config. */
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) config);
+
+	if (dns_only) {
+		if (!priv->digest_dns_valid) {
+			priv->digest_dns = _digest_compute (priv, TRUE);
+			priv->digest_dns_valid = TRUE;
+		}
+		return priv->digest_dns;
+	}
+
+	if (!priv->digest_valid) {
+		priv->digest = _digest_compute (priv, FALSE);
+		priv->digest_valid = TRUE;
+	}
+	return priv->digest;
+}
+
+static gboolean
+_is_empty_for_digest (const NMIP4Config *config)
+{
+	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	/* a %NULL config hashes like a config where all attributes covered
+	 * by nm_ip4_config_hash() are unset. */
+	return    !priv->has_gateway
+	       && !priv->gateway
+	       && !priv->addresses->len
+	       && !priv->routes->len
+	       && !priv->nis->len
+	       && !priv->nis_domain
+	       && !priv->nameservers->len
+	       && !priv->wins->len
+	       && !priv->domains->len
+	       && !priv->searches->len
+	       && !priv->dns_options->len
+	       && !priv->dns_priority;
+}
+
 /**
  * nm_ip4_config_equal:
  * @a: first config to compare
@@ -2232,7 +2663,8 @@ nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only
  * Compares two #NMIP4Configs for basic equality.  This means that all
  * attributes must exist in the same order in both configs (addresses, routes,
  * domains, DNS servers, etc) but some attributes (address lifetimes, and address
- * and route sources) are ignored.
+ * and route sources) are ignored. The comparison uses the cached digests from
+ * nm_ip4_config_get_digest().
  *
  * Returns: %TRUE if the configurations are basically equal to each other,
  * %FALSE if not
@@ -2240,28 +2672,11 @@ nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only
 gboolean
 nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b)
 {
-	GChecksum *a_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	GChecksum *b_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	gsize a_len = g_checksum_type_get_length (G_CHECKSUM_SHA1);
-	gsize b_len = g_checksum_type_get_length (G_CHECKSUM_SHA1);
-	guchar a_data[a_len], b_data[b_len];
-	gboolean equal;
-
-	if (a)
-		nm_ip4_config_hash (a, a_checksum, FALSE);
-	if (b)
-		nm_ip4_config_hash (b, b_checksum, FALSE);
-
-	g_checksum_get_digest (a_checksum, a_data, &a_len);
-	g_checksum_get_digest (b_checksum, b_data, &b_len);
-
-	g_assert (a_len == b_len);
-	equal = !memcmp (a_data, b_data, a_len);
-
-	g_checksum_free (a_checksum);
-	g_checksum_free (b_checksum);
-
-	return equal;
+	if (a == b)
+		return TRUE;
+	if (!a || !b)
+		return _is_empty_for_digest (a ?: b);
+	return nm_ip4_config_get_digest (a, FALSE) == nm_ip4_config_get_digest (b, FALSE);
 }
 
 /******************************************************************/
@@ -2290,6 +2705,12 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	nm_utils_array_index_destroy (&priv->addresses_idx);
+	nm_utils_array_index_destroy (&priv->routes_idx);
+	nm_clear_g_variant (&priv->address_data_variant);
+	nm_clear_g_variant (&priv->addresses_variant);
+	nm_clear_g_variant (&priv->route_data_variant);
+	nm_clear_g_variant (&priv->routes_variant);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
@@ -2313,7 +2734,7 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_int (value, priv->ifindex);
 		break;
 	case PROP_ADDRESS_DATA:
-		{
+		if (!priv->address_data_variant) {
 			GVariantBuilder array_builder, addr_builder;
 			int naddr = nm_ip4_config_get_num_addresses (config);
 			int i;
@@ -2344,11 +2765,12 @@ get_property (GObject *object, guint prop_id,
 				g_variant_builder_add (&array_builder, "a{sv}", &addr_builder);
 			}
 
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
+			priv->address_data_variant = g_variant_ref_sink (g_variant_builder_end (&array_builder));
 		}
+		g_value_set_variant (value, priv->address_data_variant);
 		break;
 	case PROP_ADDRESSES:
-		{
+		if (!priv->addresses_variant) {
 			GVariantBuilder array_builder;
 			int naddr = nm_ip4_config_get_num_addresses (config);
 			int i;
@@ -2367,11 +2789,12 @@ get_property (GObject *object, guint prop_id,
 				                                                  dbus_addr, 3, sizeof (guint32)));
 			}
 
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
+			priv->addresses_variant = g_variant_ref_sink (g_variant_builder_end (&array_builder));
 		}
+		g_value_set_variant (value, priv->addresses_variant);
 		break;
 	case PROP_ROUTE_DATA:
-		{
+		if (!priv->route_data_variant) {
 			GVariantBuilder array_builder, route_builder;
 			guint nroutes = nm_ip4_config_get_num_routes (config);
 			int i;
@@ -2399,11 +2822,12 @@ get_property (GObject *object, guint prop_id,
 				g_variant_builder_add (&array_builder, "a{sv}", &route_builder);
 			}
 
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
+			priv->route_data_variant = g_variant_ref_sink (g_variant_builder_end (&array_builder));
 		}
+		g_value_set_variant (value, priv->route_data_variant);
 		break;
 	case PROP_ROUTES:
-		{
+		if (!priv->routes_variant) {
 			GVariantBuilder array_builder;
 			guint nroutes = nm_ip4_config_get_num_routes (config);
 			int i;
@@ -2428,8 +2852,9 @@ get_property (GObject *object, guint prop_id,
 				                                                  dbus_route, 4, sizeof (guint32)));
 			}
 
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
+			priv->routes_variant = g_variant_ref_sink (g_variant_builder_end (&array_builder));
 		}
+		g_value_set_variant (value, priv->routes_variant);
 		break;
 	case PROP_GATEWAY:
 		if (priv->has_gateway)
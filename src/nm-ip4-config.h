@@ -55,6 +55,7 @@ GType nm_ip4_config_get_type (void);
 
 
 NMIP4Config * nm_ip4_config_new (int ifindex);
+NMIP4Config * nm_ip4_config_new_cloned (const NMIP4Config *src);
 
 int nm_ip4_config_get_ifindex (const NMIP4Config *config);
 
@@ -68,7 +69,8 @@ NMSetting *nm_ip4_config_create_setting (const NMIP4Config *config);
 void nm_ip4_config_merge (NMIP4Config *dst, const NMIP4Config *src, NMIPConfigMergeFlags merge_flags);
 void nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src);
 void nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src);
-gboolean nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relevant_changes);
+gboolean nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relevant_changes,
+                                NMIPConfigChangeFlags *out_changes);
 gboolean nm_ip4_config_destination_is_direct (const NMIP4Config *config, guint32 dest, guint8 plen);
 void nm_ip4_config_dump (const NMIP4Config *config, const char *detail);
 
@@ -93,7 +95,10 @@ gboolean nm_ip4_config_addresses_sort (NMIP4Config *config);
 /* Routes */
 void nm_ip4_config_reset_routes (NMIP4Config *config);
 void nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *route);
+void nm_ip4_config_add_routes (NMIP4Config *config, const NMPlatformIP4Route *routes, guint len);
 void nm_ip4_config_del_route (NMIP4Config *config, guint i);
+const NMPlatformIP4Route *nm_ip4_config_lookup_route (const NMIP4Config *config, const NMPlatformIP4Route *needle);
+gboolean nm_ip4_config_remove_route (NMIP4Config *config, const NMPlatformIP4Route *needle, gboolean exact);
 guint32 nm_ip4_config_get_num_routes (const NMIP4Config *config);
 const NMPlatformIP4Route *nm_ip4_config_get_route (const NMIP4Config *config, guint32 i);
 
@@ -161,6 +166,7 @@ void nm_ip4_config_set_metered (NMIP4Config *config, gboolean metered);
 gboolean nm_ip4_config_get_metered (const NMIP4Config *config);
 
 void nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only);
+guint64 nm_ip4_config_get_digest (const NMIP4Config *config, gboolean dns_only);
 gboolean nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b);
 
 /******************************************************/
@@ -70,7 +70,8 @@ NMSetting *nm_ip6_config_create_setting (const NMIP6Config *config);
 void nm_ip6_config_merge (NMIP6Config *dst, const NMIP6Config *src, NMIPConfigMergeFlags merge_flags);
 void nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src);
 void nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src);
-gboolean nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relevant_changes);
+gboolean nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relevant_changes,
+                                NMIPConfigChangeFlags *out_changes);
 int nm_ip6_config_destination_is_direct (const NMIP6Config *config, const struct in6_addr *dest, guint8 plen);
 void nm_ip6_config_dump (const NMIP6Config *config, const char *detail);
 
@@ -89,6 +90,7 @@ guint nm_ip6_config_get_num_addresses (const NMIP6Config *config);
 const NMPlatformIP6Address *nm_ip6_config_get_address (const NMIP6Config *config, guint i);
 const NMPlatformIP6Address *nm_ip6_config_get_address_first_nontentative (const NMIP6Config *config, gboolean linklocal);
 gboolean nm_ip6_config_address_exists (const NMIP6Config *config, const NMPlatformIP6Address *address);
+gboolean nm_ip6_config_remove_address (NMIP6Config *config, const NMPlatformIP6Address *needle);
 gboolean nm_ip6_config_addresses_sort (NMIP6Config *config, NMSettingIP6ConfigPrivacy use_temporary);
 gboolean nm_ip6_config_has_any_dad_pending (const NMIP6Config *self,
                                             const NMIP6Config *candidates);
@@ -96,7 +98,10 @@ gboolean nm_ip6_config_has_any_dad_pending (const NMIP6Config *self,
 /* Routes */
 void nm_ip6_config_reset_routes (NMIP6Config *config);
 void nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *route);
+void nm_ip6_config_add_routes (NMIP6Config *config, const NMPlatformIP6Route *routes, guint len);
 void nm_ip6_config_del_route (NMIP6Config *config, guint i);
+const NMPlatformIP6Route *nm_ip6_config_lookup_route (const NMIP6Config *config, const NMPlatformIP6Route *needle);
+gboolean nm_ip6_config_remove_route (NMIP6Config *config, const NMPlatformIP6Route *needle, gboolean exact);
 guint32 nm_ip6_config_get_num_routes (const NMIP6Config *config);
 const NMPlatformIP6Route *nm_ip6_config_get_route (const NMIP6Config *config, guint32 i);
 
@@ -140,6 +145,7 @@ void nm_ip6_config_set_mss (NMIP6Config *config, guint32 mss);
 guint32 nm_ip6_config_get_mss (const NMIP6Config *config);
 
 void nm_ip6_config_hash (const NMIP6Config *config, GChecksum *sum, gboolean dns_only);
+guint64 nm_ip6_config_get_digest (const NMIP6Config *config, gboolean dns_only);
 gboolean nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b);
 
 /******************************************************/
@@ -22,6 +22,7 @@
 #include "nm-default.h"
 
 #include <dlfcn.h>
+#include <signal.h>
 #include <syslog.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -44,6 +45,7 @@
 
 #include "nm-errors.h"
 #include "nm-core-utils.h"
+#include "nm-probes.h"
 
 typedef enum {
 	LOG_FORMAT_FLAG_NONE                                = 0,
@@ -114,9 +116,66 @@ NMLogDomain _nm_logging_enabled_state[_LOGL_N_REAL] = {
 	[LOGL_ERR]  = LOGD_DEFAULT,
 };
 
+NMLogDomain _nm_logging_recorded_state[_LOGL_N_REAL];
+
+/* A record of the flight recorder. The message is formatted right away into
+ * the record (the arguments might not be valid for longer), but nothing else
+ * is done: no allocation, no timestamp/location formatting and no write to
+ * the logging backend. */
+#define LOG_RING_MSG_LEN 232
+
+typedef struct {
+	/* the sequence number of the record plus one, or 0 while it is written */
+	volatile gint seq;
+	guint8 level;
+	gint64 timestamp_us;
+	NMLogDomain domain;
+	char msg[LOG_RING_MSG_LEN];
+} LogRingRecord;
+
+/* A token bucket for rate limiting. It holds up to one second worth
+ * of messages, in units of 1/G_USEC_PER_SEC messages. */
+typedef struct {
+	gint64 tokens;
+	gint64 last_us;
+	guint suppressed;
+} LogRateBucket;
+
+typedef struct {
+	const char *file;
+	guint line;
+	LogRateBucket bucket;
+} LogRateCallsite;
+
 static struct {
 	NMLogLevel log_level;
 	LogFormatFlags log_format_flags;
+
+	/* the domains enabled for the logging backend, as exposed by
+	 * _nm_logging_enabled_state. The ones recorded by the flight
+	 * recorder are tracked separately in _nm_logging_recorded_state. */
+	NMLogDomain output_state[_LOGL_N_REAL];
+
+	struct {
+		LogRingRecord *records;
+		/* a power of two */
+		guint n_records;
+		volatile gint head;
+		NMLogLevel level;
+	} ring;
+
+	struct {
+		/* whether any rate is set */
+		bool active;
+		/* messages per second, 0 for unlimited */
+		guint domain_default;
+		guint callsite;
+		guint domain[64];
+		LogRateBucket domain_bucket[64];
+		/* (file, line) -> LogRateBucket */
+		GHashTable *callsite_buckets;
+	} rate_limit;
+
 	bool uses_syslog:1;
 	enum {
 		LOG_BACKEND_GLIB,
@@ -133,6 +192,14 @@ static struct {
 } global = {
 	/* nm_logging_setup ("INFO", LOGD_DEFAULT_STRING, NULL, NULL); */
 	.log_level = LOGL_INFO,
+	.output_state = {
+		[LOGL_INFO] = LOGD_DEFAULT,
+		[LOGL_WARN] = LOGD_DEFAULT,
+		[LOGL_ERR]  = LOGD_DEFAULT,
+	},
+	.ring = {
+		.level = _LOGL_OFF,
+	},
 	.log_backend = LOG_BACKEND_GLIB,
 	.log_format_flags = _LOG_FORMAT_FLAG_DEFAULT,
 	.level_desc = {
@@ -200,6 +267,38 @@ G_STATIC_ASSERT (sizeof (NMLogDomain) >= sizeof (guint64));
 
 static char *_domains_to_string (gboolean include_level_override);
 
+G_LOCK_DEFINE_STATIC (rate_limit);
+
+static guint
+_domain_index (NMLogDomain domain)
+{
+	nm_assert (domain);
+	return __builtin_ctzll ((guint64) domain);
+}
+
+static void
+_rate_limit_update_active (void)
+{
+	guint i;
+
+	global.rate_limit.active = global.rate_limit.callsite > 0;
+	for (i = 0; !global.rate_limit.active && i < G_N_ELEMENTS (global.rate_limit.domain); i++)
+		global.rate_limit.active = global.rate_limit.domain[i] > 0;
+}
+
+static void
+_update_enabled_state (void)
+{
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
+		_nm_logging_enabled_state[i] = global.output_state[i];
+		_nm_logging_recorded_state[i] =   (global.ring.records && i >= global.ring.level)
+		                                ? LOGD_ALL
+		                                : LOGD_NONE;
+	}
+}
+
 /************************************************************************/
 
 static gboolean
@@ -229,7 +328,9 @@ nm_logging_setup (const char  *level,
 {
 	GString *unrecognized = NULL;
 	NMLogDomain new_logging[G_N_ELEMENTS (_nm_logging_enabled_state)];
+	guint new_rate[G_N_ELEMENTS (global.rate_limit.domain)];
 	NMLogLevel new_log_level = global.log_level;
+	gboolean keep_rates = FALSE;
 	char **tmp, **iter;
 	int i;
 	gboolean had_platform_debug;
@@ -239,8 +340,10 @@ nm_logging_setup (const char  *level,
 	g_return_val_if_fail (!error || !*error, FALSE);
 
 	/* domains */
-	if (!domains || !*domains)
+	if (!domains || !*domains) {
 		domains = (domains_free = _domains_to_string (FALSE));
+		keep_rates = TRUE;
+	}
 
 	for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
 		new_logging[i] = 0;
@@ -252,20 +355,41 @@ nm_logging_setup (const char  *level,
 		if (new_log_level == _LOGL_KEEP) {
 			new_log_level = global.log_level;
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = _nm_logging_enabled_state[i];
+				new_logging[i] = global.output_state[i];
+			keep_rates = TRUE;
 		}
 	}
 
+	for (i = 0; i < G_N_ELEMENTS (new_rate); i++) {
+		new_rate[i] = keep_rates
+		              ? global.rate_limit.domain[i]
+		              : global.rate_limit.domain_default;
+	}
+
 	tmp = g_strsplit_set (domains, ", ", 0);
 	for (iter = tmp; iter && *iter; iter++) {
 		const LogDesc *diter;
 		NMLogLevel domain_log_level;
 		NMLogDomain bits;
+		gint64 rate = -1;
 		char *p;
 
 		if (!strlen (*iter))
 			continue;
 
+		/* DOMAIN[:LEVEL][@RATE] */
+		p = strchr (*iter, '@');
+		if (p) {
+			*p = '\0';
+			rate = _nm_utils_ascii_str_to_int64 (p + 1, 10, 0, G_MAXUINT32, -1);
+			if (rate < 0) {
+				g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_LEVEL,
+				             _("Invalid rate limit '%s'"), p + 1);
+				g_strfreev (tmp);
+				return FALSE;
+			}
+		}
+
 		p = strchr (*iter, ':');
 		if (p) {
 			*p = '\0';
@@ -318,9 +442,16 @@ nm_logging_setup (const char  *level,
 			}
 		}
 
+		if (rate >= 0) {
+			for (i = 0; i < G_N_ELEMENTS (new_rate); i++) {
+				if (bits & (((NMLogDomain) 1) << i))
+					new_rate[i] = rate;
+			}
+		}
+
 		if (domain_log_level == _LOGL_KEEP) {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = (new_logging[i] & ~bits) | (_nm_logging_enabled_state[i] & bits);
+				new_logging[i] = (new_logging[i] & ~bits) | (global.output_state[i] & bits);
 		} else {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++) {
 				if (i < domain_log_level)
@@ -338,7 +469,14 @@ nm_logging_setup (const char  *level,
 
 	global.log_level = new_log_level;
 	for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-		_nm_logging_enabled_state[i] = new_logging[i];
+		global.output_state[i] = new_logging[i];
+	_update_enabled_state ();
+
+	G_LOCK (rate_limit);
+	for (i = 0; i < G_N_ELEMENTS (new_rate); i++)
+		global.rate_limit.domain[i] = new_rate[i];
+	_rate_limit_update_active ();
+	G_UNLOCK (rate_limit);
 
 	if (   had_platform_debug
 	    && _nm_logging_clear_platform_logging_cache
@@ -403,7 +541,7 @@ _domains_to_string (gboolean include_level_override)
 	str = g_string_sized_new (75);
 	for (diter = &global.domain_desc[0]; diter->name; diter++) {
 		/* If it's set for any lower level, it will also be set for LOGL_ERR */
-		if (!(diter->num & _nm_logging_enabled_state[LOGL_ERR]))
+		if (!(diter->num & global.output_state[LOGL_ERR]))
 			continue;
 
 		if (str->len)
@@ -415,20 +553,24 @@ _domains_to_string (gboolean include_level_override)
 
 		/* Check if it's logging at a lower level than the default. */
 		for (i = 0; i < global.log_level; i++) {
-			if (diter->num & _nm_logging_enabled_state[i]) {
+			if (diter->num & global.output_state[i]) {
 				g_string_append_printf (str, ":%s", global.level_desc[i].name);
 				break;
 			}
 		}
 		/* Check if it's logging at a higher level than the default. */
-		if (!(diter->num & _nm_logging_enabled_state[global.log_level])) {
-			for (i = global.log_level + 1; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
-				if (diter->num & _nm_logging_enabled_state[i]) {
+		if (!(diter->num & global.output_state[global.log_level])) {
+			for (i = global.log_level + 1; i < G_N_ELEMENTS (global.output_state); i++) {
+				if (diter->num & global.output_state[i]) {
 					g_string_append_printf (str, ":%s", global.level_desc[i].name);
 					break;
 				}
 			}
 		}
+
+		i = _domain_index (diter->num);
+		if (global.rate_limit.domain[i] != global.rate_limit.domain_default)
+			g_string_append_printf (str, "@%u", global.rate_limit.domain[i]);
 	}
 	return g_string_free (str, FALSE);
 }
@@ -477,6 +619,419 @@ nm_logging_get_level (NMLogDomain domain)
 	return sl;
 }
 
+/*****************************************************************************/
+
+static LogRingRecord *
+_ring_record_begin (NMLogLevel level, NMLogDomain domain, guint *out_seq)
+{
+	LogRingRecord *rec;
+	guint seq;
+
+	seq = (guint) g_atomic_int_add (&global.ring.head, 1);
+	rec = &global.ring.records[seq & (global.ring.n_records - 1)];
+	g_atomic_int_set (&rec->seq, 0);
+
+	rec->level = level;
+	rec->domain = domain;
+	rec->timestamp_us = g_get_real_time ();
+	*out_seq = seq;
+	return rec;
+}
+
+static void
+_ring_record_end (LogRingRecord *rec, guint seq)
+{
+	g_atomic_int_set (&rec->seq, (gint) (seq + 1));
+}
+
+static void
+_ring_append_v (NMLogLevel level, NMLogDomain domain, const char *fmt, va_list args)
+{
+	LogRingRecord *rec;
+	guint seq;
+	int errsv = errno;
+
+	rec = _ring_record_begin (level, domain, &seq);
+	/* for %m */
+	errno = errsv;
+	g_vsnprintf (rec->msg, sizeof (rec->msg), fmt, args);
+	_ring_record_end (rec, seq);
+}
+
+static void
+_ring_append (NMLogLevel level, NMLogDomain domain, const char *msg)
+{
+	LogRingRecord *rec;
+	guint seq;
+
+	rec = _ring_record_begin (level, domain, &seq);
+	g_strlcpy (rec->msg, msg, sizeof (rec->msg));
+	_ring_record_end (rec, seq);
+}
+
+static const char *
+_ring_domain_name (NMLogDomain domain)
+{
+	const LogDesc *diter;
+
+	for (diter = &global.domain_desc[0]; diter->name; diter++) {
+		if (NM_FLAGS_ANY (domain, diter->num))
+			return diter->name;
+	}
+	return "?";
+}
+
+static char *
+_ring_format_str (char *p, const char *end, const char *str, gsize min_len)
+{
+	gsize len = strlen (str);
+
+	len = MIN (len, (gsize) (end - p));
+	memcpy (p, str, len);
+	p += len;
+	for (; len < min_len && p < end; len++)
+		*(p++) = ' ';
+	return p;
+}
+
+static char *
+_ring_format_uint (char *p, const char *end, guint64 num, guint min_digits)
+{
+	char digits[24];
+	guint n = 0;
+
+	do {
+		digits[n++] = '0' + (num % 10);
+		num /= 10;
+	} while (num || n < min_digits);
+
+	while (n > 0 && p < end)
+		*(p++) = digits[--n];
+	return p;
+}
+
+/* Formats @rec as one line, terminated by a newline, into @buf. Like
+ * "%-7s [%ld.%04ld] %s: %s\n", but only using async-signal-safe
+ * functions, as it is also called from the crash handler. */
+static gsize
+_ring_format_record (char *buf, gsize size, const LogRingRecord *rec)
+{
+	const char *end = &buf[size - 1];
+	guint64 ts = MAX (rec->timestamp_us, 0);
+	char *p = buf;
+
+	p = _ring_format_str (p, end, global.level_desc[rec->level].level_str, 7);
+	p = _ring_format_str (p, end, " [", 0);
+	p = _ring_format_uint (p, end, ts / G_USEC_PER_SEC, 1);
+	p = _ring_format_str (p, end, ".", 0);
+	p = _ring_format_uint (p, end, (ts % G_USEC_PER_SEC) / 100, 4);
+	p = _ring_format_str (p, end, "] ", 0);
+	p = _ring_format_str (p, end, _ring_domain_name (rec->domain), 0);
+	p = _ring_format_str (p, end, ": ", 0);
+	p = _ring_format_str (p, end, rec->msg, 0);
+	*(p++) = '\n';
+	return p - buf;
+}
+
+typedef void (*RingForeachFunc) (const char *line, gsize len, gpointer user_data);
+
+/* Formats the records of the flight recorder from the oldest to the newest.
+ * Records that are overwritten while they are being read are skipped. This
+ * neither allocates nor takes a lock and only uses async-signal-safe
+ * functions, so that it can also be used from the crash handler. */
+static void
+_ring_foreach (RingForeachFunc func, gpointer user_data)
+{
+	LogRingRecord rec;
+	const LogRingRecord *r;
+	char line[LOG_RING_MSG_LEN + 64];
+	guint head, n, seq;
+
+	if (!global.ring.records)
+		return;
+
+	head = (guint) g_atomic_int_get (&global.ring.head);
+	n = MIN (head, global.ring.n_records);
+
+	for (seq = head - n; seq != head; seq++) {
+		r = &global.ring.records[seq & (global.ring.n_records - 1)];
+		if ((guint) g_atomic_int_get (&r->seq) != seq + 1)
+			continue;
+		memcpy (&rec, (const void *) r, sizeof (rec));
+		if ((guint) g_atomic_int_get (&r->seq) != seq + 1)
+			continue;
+		rec.msg[sizeof (rec.msg) - 1] = '\0';
+
+		func (line, _ring_format_record (line, sizeof (line), &rec), user_data);
+	}
+}
+
+static void
+_ring_dump_string_cb (const char *line, gsize len, gpointer user_data)
+{
+	g_string_append_len (user_data, line, len);
+}
+
+/**
+ * nm_logging_ring_dump:
+ *
+ * Returns: the content of the flight recorder, one message per line
+ *   from the oldest to the newest. An empty string if it is disabled.
+ */
+char *
+nm_logging_ring_dump (void)
+{
+	GString *str;
+
+	str = g_string_sized_new (global.ring.records ? 4096 : 0);
+	_ring_foreach (_ring_dump_string_cb, str);
+	return g_string_free (str, FALSE);
+}
+
+static void
+_ring_dump_fd_cb (const char *line, gsize len, gpointer user_data)
+{
+	int fd = GPOINTER_TO_INT (user_data);
+	gssize n;
+
+	while (len > 0) {
+		n = write (fd, line, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		line += n;
+		len -= n;
+	}
+}
+
+/**
+ * nm_logging_ring_dump_fd:
+ * @fd: the file descriptor to write to
+ *
+ * Writes the content of the flight recorder to @fd, like
+ * nm_logging_ring_dump() but without allocating memory.
+ */
+void
+nm_logging_ring_dump_fd (int fd)
+{
+	_ring_foreach (_ring_dump_fd_cb, GINT_TO_POINTER (fd));
+}
+
+static void
+_ring_crash_handler (int signo)
+{
+	static const char header[] = "NetworkManager: caught fatal signal, last log messages follow:\n";
+	int errsv = errno;
+
+	if (write (STDERR_FILENO, header, NM_STRLEN (header)) > 0)
+		nm_logging_ring_dump_fd (STDERR_FILENO);
+
+	/* the handler was installed with SA_RESETHAND. Re-raise the
+	 * signal to get the default action (and the core dump). */
+	errno = errsv;
+	raise (signo);
+}
+
+/**
+ * nm_logging_ring_setup:
+ * @level: the level from which on messages of all domains are recorded,
+ *   or "OFF"
+ * @n_records: the number of messages kept. It is rounded up to a power
+ *   of two and can only be set once, on the first call that enables
+ *   the recorder.
+ * @error: the error
+ *
+ * Sets up the flight recorder: a ring buffer of the last messages, which
+ * records them even when they are not enabled for the logging backend. As
+ * only the message itself is formatted and nothing is written, this is cheap
+ * enough to keep trace messages recorded all the time. The content can be
+ * retrieved with nm_logging_ring_dump(); it is also written to stderr when
+ * NetworkManager crashes.
+ *
+ * Returns: %FALSE if @level is invalid.
+ */
+gboolean
+nm_logging_ring_setup (const char *level, guint n_records, GError **error)
+{
+	NMLogLevel new_level;
+
+	g_return_val_if_fail (level, FALSE);
+	g_return_val_if_fail (!error || !*error, FALSE);
+
+	if (!match_log_level (level, &new_level, error))
+		return FALSE;
+	if (new_level == _LOGL_KEEP)
+		new_level = global.ring.level;
+
+	if (new_level != _LOGL_OFF && !global.ring.records && n_records > 0) {
+		static const int fatal_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+		struct sigaction sa = { 0 };
+		guint n = 1;
+		int i;
+
+		while (n < n_records && n < (1u << 20))
+			n <<= 1;
+		global.ring.records = g_new0 (LogRingRecord, n);
+		global.ring.n_records = n;
+
+		sa.sa_handler = _ring_crash_handler;
+		sa.sa_flags = SA_RESETHAND;
+		sigemptyset (&sa.sa_mask);
+		for (i = 0; i < G_N_ELEMENTS (fatal_signals); i++)
+			sigaction (fatal_signals[i], &sa, NULL);
+	}
+
+	global.ring.level = new_level;
+	_update_enabled_state ();
+	return TRUE;
+}
+
+/**
+ * nm_logging_ring_enabled:
+ *
+ * Returns: whether the flight recorder records messages.
+ */
+gboolean
+nm_logging_ring_enabled (void)
+{
+	return global.ring.records && global.ring.level != _LOGL_OFF;
+}
+
+/*****************************************************************************/
+
+static gboolean
+_rate_bucket_take (LogRateBucket *bucket, guint rate, gint64 now_us)
+{
+	gint64 max = (gint64) rate * G_USEC_PER_SEC;
+
+	if (bucket->last_us == 0)
+		bucket->tokens = max;
+	else
+		bucket->tokens = MIN (max, bucket->tokens + (now_us - bucket->last_us) * rate);
+	bucket->last_us = now_us;
+
+	if (bucket->tokens < G_USEC_PER_SEC) {
+		bucket->suppressed++;
+		return FALSE;
+	}
+	bucket->tokens -= G_USEC_PER_SEC;
+	return TRUE;
+}
+
+static guint
+_rate_callsite_hash (gconstpointer key)
+{
+	const LogRateCallsite *callsite = key;
+
+	return g_direct_hash (callsite->file) ^ callsite->line;
+}
+
+static gboolean
+_rate_callsite_equal (gconstpointer a, gconstpointer b)
+{
+	const LogRateCallsite *callsite_a = a;
+	const LogRateCallsite *callsite_b = b;
+
+	return    callsite_a->file == callsite_b->file
+	       && callsite_a->line == callsite_b->line;
+}
+
+/* Returns %FALSE if the message must be dropped. Otherwise, returns the number
+ * of messages suppressed before it, for which a summary is to be printed. */
+static gboolean
+_rate_limit_check (const char *file,
+                   guint line,
+                   NMLogDomain domain,
+                   guint *out_suppressed_domain,
+                   guint *out_suppressed_callsite)
+{
+	LogRateCallsite *callsite = NULL;
+	LogRateBucket *domain_bucket = NULL;
+	gint64 now_us;
+	guint idx;
+	gboolean pass = FALSE;
+
+	now_us = g_get_monotonic_time ();
+
+	G_LOCK (rate_limit);
+
+	if (global.rate_limit.callsite && file) {
+		LogRateCallsite needle = { .file = file, .line = line };
+
+		if (G_UNLIKELY (!global.rate_limit.callsite_buckets))
+			global.rate_limit.callsite_buckets = g_hash_table_new_full (_rate_callsite_hash, _rate_callsite_equal, g_free, NULL);
+
+		callsite = g_hash_table_lookup (global.rate_limit.callsite_buckets, &needle);
+		if (!callsite) {
+			callsite = g_new0 (LogRateCallsite, 1);
+			callsite->file = file;
+			callsite->line = line;
+			g_hash_table_add (global.rate_limit.callsite_buckets, callsite);
+		}
+		if (!_rate_bucket_take (&callsite->bucket, global.rate_limit.callsite, now_us))
+			goto out;
+	}
+
+	/* a message of several domains counts for the first one enabled */
+	idx = _domain_index (domain);
+	if (global.rate_limit.domain[idx]) {
+		domain_bucket = &global.rate_limit.domain_bucket[idx];
+		if (!_rate_bucket_take (domain_bucket, global.rate_limit.domain[idx], now_us)) {
+			/* the message is not emitted, give back the token of the callsite */
+			if (callsite)
+				callsite->bucket.tokens += G_USEC_PER_SEC;
+			goto out;
+		}
+	}
+
+	pass = TRUE;
+	if (callsite) {
+		*out_suppressed_callsite = callsite->bucket.suppressed;
+		callsite->bucket.suppressed = 0;
+	}
+	if (domain_bucket) {
+		*out_suppressed_domain = domain_bucket->suppressed;
+		domain_bucket->suppressed = 0;
+	}
+
+out:
+	G_UNLOCK (rate_limit);
+	return pass;
+}
+
+/**
+ * nm_logging_rate_limit_setup:
+ * @domain_rate: the number of messages per second allowed for each domain
+ *   that doesn't have a rate set with nm_logging_setup(), or 0 for no limit
+ * @callsite_rate: the number of messages per second allowed for each
+ *   place in the code that logs, or 0 for no limit
+ *
+ * Debug, trace and info messages beyond these rates are dropped, and the
+ * number of dropped messages is logged with the next message that passes.
+ * Warnings and errors are never rate limited.
+ */
+void
+nm_logging_rate_limit_setup (guint domain_rate, guint callsite_rate)
+{
+	guint i;
+
+	G_LOCK (rate_limit);
+	for (i = 0; i < G_N_ELEMENTS (global.rate_limit.domain); i++) {
+		if (global.rate_limit.domain[i] == global.rate_limit.domain_default)
+			global.rate_limit.domain[i] = domain_rate;
+	}
+	global.rate_limit.domain_default = domain_rate;
+	global.rate_limit.callsite = callsite_rate;
+	_rate_limit_update_active ();
+	G_UNLOCK (rate_limit);
+
+	g_clear_pointer (&global.logging_domains_to_string, g_free);
+}
+
+/*****************************************************************************/
+
 #if SYSTEMD_JOURNAL
 __attribute__((__format__ (__printf__, 4, 5)))
 static void
@@ -504,40 +1059,20 @@ _iovec_set_string (struct iovec *iov, gboolean *iov_free, int i, const char *str
 #define _iovec_set_literal_string(iov, iov_free, i, str) _iovec_set_string ((iov), (iov_free), (i), (""str""), NM_STRLEN (str))
 #endif
 
-void
-_nm_log_impl (const char *file,
-              guint line,
-              const char *func,
-              NMLogLevel level,
-              NMLogDomain domain,
-              int error,
-              const char *fmt,
-              ...)
+static void
+_log_write (const char *file,
+            guint line,
+            const char *func,
+            NMLogLevel level,
+            NMLogDomain domain,
+            int error,
+            const char *msg)
 {
-	va_list args;
-	char *msg;
 	char *fullmsg;
 	char s_buf_timestamp[64];
 	char s_buf_location[1024];
 	GTimeVal tv;
 
-	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
-		g_return_if_reached ();
-
-	if (!(_nm_logging_enabled_state[level] & domain))
-		return;
-
-	/* Make sure that %m maps to the specified error */
-	if (error != 0) {
-		if (error < 0)
-			error = -error;
-		errno = error;
-	}
-
-	va_start (args, fmt);
-	msg = g_strdup_vprintf (fmt, args);
-	va_end (args);
-
 	if (NM_FLAGS_ANY (global.log_format_flags, global.level_desc[level].log_format_level & _LOG_FORMAT_FLAG_TIMESTAMP)) {
 		g_get_current_time (&tv);
 		nm_sprintf_buf (s_buf_timestamp, " [%ld.%04ld]", tv.tv_sec, (tv.tv_usec + 50) / 100);
@@ -613,7 +1148,7 @@ _nm_log_impl (const char *file,
 				const char *s_domain_1 = NULL;
 				GString *s_domain_all = NULL;
 				NMLogDomain dom_all = domain;
-				NMLogDomain dom = dom_all & _nm_logging_enabled_state[level];
+				NMLogDomain dom = dom_all & global.output_state[level];
 
 				for (diter = &global.domain_desc[0]; diter->name; diter++) {
 					if (!NM_FLAGS_HAS (dom_all, diter->num))
@@ -685,6 +1220,86 @@ _nm_log_impl (const char *file,
 		break;
 	}
 
+}
+
+void
+_nm_log_impl (const char *file,
+              guint line,
+              const char *func,
+              NMLogLevel level,
+              NMLogDomain domain,
+              int error,
+              const char *fmt,
+              ...)
+{
+	va_list args;
+	char *msg;
+	NMLogDomain dom;
+	guint suppressed_domain = 0, suppressed_callsite = 0;
+
+	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
+		g_return_if_reached ();
+
+	if (!((_nm_logging_enabled_state[level] | _nm_logging_recorded_state[level]) & domain))
+		return;
+
+	/* Make sure that %m maps to the specified error */
+	if (error != 0) {
+		if (error < 0)
+			error = -error;
+		errno = error;
+	}
+
+	dom = global.output_state[level] & domain;
+	if (!dom) {
+		/* only enabled for the flight recorder */
+		va_start (args, fmt);
+		_ring_append_v (level, domain, fmt, args);
+		va_end (args);
+		return;
+	}
+
+	/* warnings and errors are never dropped */
+	if (   level < LOGL_WARN
+	    && global.rate_limit.active) {
+		int errsv = errno;
+
+		if (!_rate_limit_check (file, line, dom, &suppressed_domain, &suppressed_callsite)) {
+			NM_PROBE3 (log__drop, file, line, (guint64) dom);
+			if (nm_logging_ring_enabled () && level >= global.ring.level) {
+				errno = errsv;
+				va_start (args, fmt);
+				_ring_append_v (level, domain, fmt, args);
+				va_end (args);
+			}
+			return;
+		}
+		errno = errsv;
+	}
+
+	va_start (args, fmt);
+	msg = g_strdup_vprintf (fmt, args);
+	va_end (args);
+
+	if (nm_logging_ring_enabled () && level >= global.ring.level)
+		_ring_append (level, domain, msg);
+
+	if (suppressed_callsite) {
+		gs_free char *m = g_strdup_printf ("%u messages from %s:%u suppressed by rate limiting",
+		                                   suppressed_callsite, file ?: "?", line);
+
+		_log_write (NULL, 0, NULL, level, domain, 0, m);
+	}
+	if (suppressed_domain) {
+		gs_free char *m = g_strdup_printf ("%u %s messages suppressed by rate limiting",
+		                                   suppressed_domain,
+		                                   _ring_domain_name (((NMLogDomain) 1) << _domain_index (dom)));
+
+		_log_write (NULL, 0, NULL, level, domain, 0, m);
+	}
+
+	_log_write (file, line, func, level, domain, error, msg);
+
 	g_free (msg);
 }
 
@@ -114,10 +114,11 @@ typedef enum  { /*< skip >*/
     } G_STMT_END
 
 /* nm_log() only evaluates it's argument list after checking
- * whether logging for the given level/domain is enabled.  */
+ * whether logging for the given level/domain is enabled (or
+ * the message is recorded by the flight recorder).  */
 #define nm_log(level, domain, ...) \
     G_STMT_START { \
-        if (nm_logging_enabled ((level), (domain))) { \
+        if (_nm_logging_wanted ((level), (domain))) { \
             _nm_log (level, domain, 0, __VA_ARGS__); \
         } \
     } G_STMT_END
@@ -172,6 +173,19 @@ nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
 	       && !!(_nm_logging_enabled_state[level] & domain);
 }
 
+/* Whether a message for @level and @domain is either logged or recorded by
+ * the flight recorder. Contrary to nm_logging_enabled(), this is also true
+ * for messages that only the flight recorder records. Use it only to decide
+ * whether to emit a message, not to enable any debugging behavior. */
+extern NMLogDomain _nm_logging_recorded_state[_LOGL_N_REAL];
+static inline gboolean
+_nm_logging_wanted (NMLogLevel level, NMLogDomain domain)
+{
+	nm_assert (((guint) level) < G_N_ELEMENTS (_nm_logging_enabled_state));
+	return    (((guint) level) < G_N_ELEMENTS (_nm_logging_enabled_state))
+	       && !!((_nm_logging_enabled_state[level] | _nm_logging_recorded_state[level]) & domain);
+}
+
 NMLogLevel nm_logging_get_level (NMLogDomain domain);
 
 const char *nm_logging_all_levels_to_string (void);
@@ -184,6 +198,13 @@ gboolean nm_logging_setup (const char  *level,
 void     nm_logging_syslog_openlog (const char *logging_backend);
 gboolean nm_logging_syslog_enabled (void);
 
+void     nm_logging_rate_limit_setup (guint domain_rate, guint callsite_rate);
+
+gboolean nm_logging_ring_setup (const char *level, guint n_records, GError **error);
+gboolean nm_logging_ring_enabled (void);
+char    *nm_logging_ring_dump (void);
+void     nm_logging_ring_dump_fd (int fd);
+
 /*****************************************************************************/
 
 /* This is the default definition of _NMLOG_ENABLED(). Special implementations
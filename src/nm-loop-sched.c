@@ -0,0 +1,298 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-loop-sched.h"
+
+typedef struct {
+	const char *name;
+	int priority;
+	gint64 budget_usec;
+	guint max_wait_ms;
+} ClassInfo;
+
+static const ClassInfo class_infos[_NM_LOOP_SCHED_CLASS_NUM] = {
+	[NM_LOOP_SCHED_CLASS_DEVICE]     = { "device",     G_PRIORITY_DEFAULT_IDLE, 5000,  200 },
+	[NM_LOOP_SCHED_CLASS_BACKGROUND] = { "background", G_PRIORITY_LOW,          2000, 2000 },
+};
+
+typedef struct {
+	GList link;
+	guint id;
+	NMLoopSchedClass klass;
+	GSourceFunc func;
+	gpointer user_data;
+	gint64 queued_at;
+	gboolean running;
+	/* removed while running; freed when the callback returns */
+	gboolean removed;
+} Item;
+
+typedef struct {
+	GSource parent;
+	NMLoopSchedClass klass;
+} SchedSource;
+
+typedef struct {
+	GSource *source;
+	GQueue queue;
+	/* the timeout that raises the priority of a starved class */
+	guint boost_id;
+	gboolean boosted;
+	NMLoopSchedStats stats;
+} Class;
+
+static struct {
+	guint id_last;
+	/* id -> Item */
+	GHashTable *items;
+	Class classes[_NM_LOOP_SCHED_CLASS_NUM];
+} sched;
+
+/*****************************************************************************/
+
+const char *
+nm_loop_sched_class_to_string (NMLoopSchedClass klass)
+{
+	g_return_val_if_fail (klass >= 0 && klass < _NM_LOOP_SCHED_CLASS_NUM, NULL);
+
+	return class_infos[klass].name;
+}
+
+static gboolean
+_boost_cb (gpointer user_data)
+{
+	NMLoopSchedClass klass = GPOINTER_TO_INT (user_data);
+	Class *c = &sched.classes[klass];
+
+	c->boost_id = 0;
+	if (c->queue.length && !c->boosted) {
+		nm_log_dbg (LOGD_CORE, "loop-sched: %s work waited for %u msec, raise its priority (%u queued)",
+		            class_infos[klass].name, class_infos[klass].max_wait_ms, c->queue.length);
+		c->boosted = TRUE;
+		c->stats.boosts++;
+		g_source_set_priority (c->source, G_PRIORITY_DEFAULT);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+/* Called after the class was served or its queue changed. The starvation
+ * timeout measures the time since the class was last served, so it is
+ * restarted after every dispatch that leaves work behind. */
+static void
+_class_update (NMLoopSchedClass klass, gboolean served)
+{
+	Class *c = &sched.classes[klass];
+
+	c->stats.depth = c->queue.length;
+
+	if (!c->queue.length) {
+		nm_clear_g_source (&c->boost_id);
+		if (c->boosted) {
+			c->boosted = FALSE;
+			g_source_set_priority (c->source, class_infos[klass].priority);
+		}
+		return;
+	}
+
+	if (c->boosted)
+		return;
+	if (served)
+		nm_clear_g_source (&c->boost_id);
+	if (!c->boost_id) {
+		c->boost_id = g_timeout_add_full (G_PRIORITY_DEFAULT,
+		                                  class_infos[klass].max_wait_ms,
+		                                  _boost_cb,
+		                                  GINT_TO_POINTER (klass),
+		                                  NULL);
+	}
+}
+
+static void
+_item_free (Item *item)
+{
+	g_slice_free (Item, item);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_source_prepare (GSource *source, gint *timeout)
+{
+	*timeout = -1;
+	return sched.classes[((SchedSource *) source)->klass].queue.length > 0;
+}
+
+static gboolean
+_source_check (GSource *source)
+{
+	return sched.classes[((SchedSource *) source)->klass].queue.length > 0;
+}
+
+static gboolean
+_source_dispatch (GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	NMLoopSchedClass klass = ((SchedSource *) source)->klass;
+	Class *c = &sched.classes[klass];
+	gint64 start, now;
+	guint n;
+
+	start = now = g_get_monotonic_time ();
+	c->stats.dispatched++;
+
+	/* only run what was queued before, like separate idle sources would.
+	 * Callbacks that are queued or requeued now run in the next dispatch. */
+	for (n = c->queue.length; n > 0 && c->queue.head; n--) {
+		Item *item = c->queue.head->data;
+		gboolean again;
+
+		g_queue_unlink (&c->queue, &item->link);
+		c->stats.wait_max_usec = MAX (c->stats.wait_max_usec, now - item->queued_at);
+
+		item->running = TRUE;
+		again = item->func (item->user_data);
+		item->running = FALSE;
+
+		now = g_get_monotonic_time ();
+
+		if (item->removed)
+			_item_free (item);
+		else if (again) {
+			item->queued_at = now;
+			g_queue_push_tail_link (&c->queue, &item->link);
+		} else {
+			g_hash_table_remove (sched.items, GUINT_TO_POINTER (item->id));
+			_item_free (item);
+		}
+
+		if (n > 1 && now - start >= class_infos[klass].budget_usec) {
+			c->stats.yields++;
+			break;
+		}
+	}
+
+	_class_update (klass, TRUE);
+	return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs source_funcs = {
+	.prepare = _source_prepare,
+	.check = _source_check,
+	.dispatch = _source_dispatch,
+};
+
+/*****************************************************************************/
+
+/**
+ * nm_loop_sched_add:
+ * @klass: the class of the work
+ * @func: the callback. Like for g_idle_add(), it is called again
+ *   if it returns %G_SOURCE_CONTINUE.
+ * @user_data: the argument of @func
+ *
+ * Queues @func on the default main context, behind the work of the same
+ * class that is already queued.
+ *
+ * Returns: the id for nm_loop_sched_remove(). Unlike the id of a GSource,
+ *   it must not be passed to g_source_remove().
+ */
+guint
+nm_loop_sched_add (NMLoopSchedClass klass, GSourceFunc func, gpointer user_data)
+{
+	Class *c;
+	Item *item;
+
+	g_return_val_if_fail (klass >= 0 && klass < _NM_LOOP_SCHED_CLASS_NUM, 0);
+	g_return_val_if_fail (func, 0);
+
+	c = &sched.classes[klass];
+
+	if (G_UNLIKELY (!sched.items))
+		sched.items = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	if (G_UNLIKELY (!c->source)) {
+		char name[64];
+
+		c->source = g_source_new (&source_funcs, sizeof (SchedSource));
+		((SchedSource *) c->source)->klass = klass;
+		g_source_set_priority (c->source, class_infos[klass].priority);
+		g_source_set_name (c->source, nm_sprintf_buf (name, "nm-loop-sched-%s", class_infos[klass].name));
+		g_source_attach (c->source, NULL);
+	}
+
+	item = g_slice_new0 (Item);
+	item->link.data = item;
+	item->klass = klass;
+	item->func = func;
+	item->user_data = user_data;
+	item->queued_at = g_get_monotonic_time ();
+	do {
+		item->id = ++sched.id_last;
+	} while (   G_UNLIKELY (!item->id)
+	         || G_UNLIKELY (g_hash_table_contains (sched.items, GUINT_TO_POINTER (item->id))));
+
+	g_hash_table_insert (sched.items, GUINT_TO_POINTER (item->id), item);
+	g_queue_push_tail_link (&c->queue, &item->link);
+	c->stats.depth_max = MAX (c->stats.depth_max, c->queue.length);
+
+	_class_update (klass, FALSE);
+	return item->id;
+}
+
+/**
+ * nm_loop_sched_remove:
+ * @id: the return value of nm_loop_sched_add()
+ *
+ * Returns: %TRUE if the callback was still queued or running.
+ */
+gboolean
+nm_loop_sched_remove (guint id)
+{
+	Item *item;
+
+	if (!sched.items)
+		return FALSE;
+
+	item = g_hash_table_lookup (sched.items, GUINT_TO_POINTER (id));
+	if (!item)
+		return FALSE;
+
+	g_hash_table_remove (sched.items, GUINT_TO_POINTER (id));
+
+	if (item->running) {
+		item->removed = TRUE;
+		return TRUE;
+	}
+
+	g_queue_unlink (&sched.classes[item->klass].queue, &item->link);
+	_class_update (item->klass, FALSE);
+	_item_free (item);
+	return TRUE;
+}
+
+void
+nm_loop_sched_get_stats (NMLoopSchedClass klass, NMLoopSchedStats *out_stats)
+{
+	g_return_if_fail (klass >= 0 && klass < _NM_LOOP_SCHED_CLASS_NUM);
+	g_return_if_fail (out_stats);
+
+	*out_stats = sched.classes[klass].stats;
+}
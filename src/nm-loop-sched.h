@@ -0,0 +1,93 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_LOOP_SCHED_H__
+#define __NETWORKMANAGER_LOOP_SCHED_H__
+
+#include "nm-default.h"
+
+/* The priorities of the work on the default main context, from the most
+ * to the least important:
+ *
+ *  - netlink events, so that the receive buffer of the event socket
+ *    doesn't overrun. The platform demotes its watch to the priority
+ *    of D-Bus while it is over its time budget.
+ *  - D-Bus method calls and replies, dispatched by GDBus at
+ *    G_PRIORITY_DEFAULT.
+ *  - the state machines of the devices.
+ *  - background work, like the resync of the default routes.
+ *
+ * The last two classes are queued here. Each class is served by one
+ * GSource, which runs the queued callbacks in order but stops after the
+ * time budget of the class, so that one iteration of the main loop stays
+ * short. A class that wasn't served for its maximum wait time is raised
+ * to G_PRIORITY_DEFAULT until its queue is empty, so that a flood of
+ * D-Bus calls only delays it, but can't starve it. */
+
+#define NM_LOOP_SCHED_PRIORITY_NETLINK    (G_PRIORITY_DEFAULT - 10)
+#define NM_LOOP_SCHED_PRIORITY_DBUS       G_PRIORITY_DEFAULT
+
+/* time the platform handles netlink events at NM_LOOP_SCHED_PRIORITY_NETLINK
+ * before it yields to D-Bus */
+#define NM_LOOP_SCHED_NETLINK_BUDGET_USEC 20000
+
+typedef enum {
+	/* G_PRIORITY_DEFAULT_IDLE, like the g_idle_add() it replaces */
+	NM_LOOP_SCHED_CLASS_DEVICE,
+	/* G_PRIORITY_LOW */
+	NM_LOOP_SCHED_CLASS_BACKGROUND,
+
+	_NM_LOOP_SCHED_CLASS_NUM,
+} NMLoopSchedClass;
+
+typedef struct {
+	/* callbacks currently queued, and the maximum ever queued */
+	guint depth;
+	guint depth_max;
+
+	guint64 dispatched;
+	/* dispatches that stopped with work left because the budget
+	 * was used up */
+	guint64 yields;
+	/* times the class was raised after waiting too long */
+	guint64 boosts;
+	/* the longest time a callback was queued */
+	gint64 wait_max_usec;
+} NMLoopSchedStats;
+
+const char *nm_loop_sched_class_to_string (NMLoopSchedClass klass);
+
+guint nm_loop_sched_add (NMLoopSchedClass klass, GSourceFunc func, gpointer user_data);
+gboolean nm_loop_sched_remove (guint id);
+
+void nm_loop_sched_get_stats (NMLoopSchedClass klass, NMLoopSchedStats *out_stats);
+
+static inline gboolean
+nm_clear_loop_sched (guint *id)
+{
+	if (id && *id) {
+		nm_loop_sched_remove (*id);
+		*id = 0;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+#endif /* __NETWORKMANAGER_LOOP_SCHED_H__ */
@@ -0,0 +1,382 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-lpm-trie.h"
+
+#include <string.h>
+
+#define ADDR_LEN_MAX 16
+
+typedef struct _NMLpmTrieNode NMLpmTrieNode;
+
+struct _NMLpmTrieNode {
+	NMLpmTrieNode *child[2];
+
+	/* NULL terminated list of values. Nodes without values only exist
+	 * to join two subtrees, and always have two children. */
+	gpointer *values;
+	guint values_len;
+
+	guint8 plen;
+
+	/* the prefix, with the host part cleared. */
+	guint8 key[];
+};
+
+struct NMLpmTrie {
+	NMLpmTrieNode *root;
+	guint addr_len;
+	guint num_prefixes;
+};
+
+/******************************************************************************************/
+
+static inline guint
+_get_bit (const guint8 *key, guint idx)
+{
+	return (key[idx / 8] >> (7 - (idx % 8))) & 1;
+}
+
+/* returns the number of leading bits that @a and @b have in common, but
+ * at most @max_plen. */
+static guint
+_common_plen (const guint8 *a, const guint8 *b, guint max_plen)
+{
+	guint i, n;
+	guint8 x;
+
+	for (i = 0; i * 8 < max_plen; i++) {
+		x = a[i] ^ b[i];
+		if (x) {
+			for (n = i * 8; !(x & 0x80); n++)
+				x <<= 1;
+			return MIN (n, max_plen);
+		}
+	}
+	return max_plen;
+}
+
+static NMLpmTrieNode *
+_node_new (const NMLpmTrie *trie, const guint8 *prefix, guint8 plen)
+{
+	NMLpmTrieNode *node;
+	guint i;
+
+	node = g_malloc0 (sizeof (NMLpmTrieNode) + trie->addr_len);
+	node->plen = plen;
+	memcpy (node->key, prefix, trie->addr_len);
+
+	/* clear the host part */
+	i = plen / 8;
+	if (i < trie->addr_len) {
+		if (plen % 8)
+			node->key[i++] &= (guint8) (0xFF << (8 - (plen % 8)));
+		memset (&node->key[i], 0, trie->addr_len - i);
+	}
+	return node;
+}
+
+static void
+_node_free_recursive (NMLpmTrieNode *node)
+{
+	if (node) {
+		_node_free_recursive (node->child[0]);
+		_node_free_recursive (node->child[1]);
+		g_free (node->values);
+		g_free (node);
+	}
+}
+
+/* drops the node at @p_node if it has no values and doesn't join two subtrees. */
+static void
+_node_prune (NMLpmTrieNode **p_node)
+{
+	NMLpmTrieNode *node = *p_node;
+
+	if (   node->values
+	    || (node->child[0] && node->child[1]))
+		return;
+
+	*p_node = node->child[0] ?: node->child[1];
+	g_free (node);
+}
+
+static NMLpmTrieNode *
+_node_ensure (NMLpmTrie *trie, const guint8 *prefix, guint8 plen)
+{
+	NMLpmTrieNode **p_node = &trie->root;
+	NMLpmTrieNode *node, *glue;
+	guint common;
+
+	while ((node = *p_node)) {
+		common = _common_plen (node->key, prefix, MIN (node->plen, plen));
+
+		if (common < node->plen) {
+			/* @node is not a parent of @prefix. Insert a new node in between. */
+			if (common == plen) {
+				/* ... the new node is a parent of @node */
+				glue = _node_new (trie, prefix, plen);
+				glue->child[_get_bit (node->key, plen)] = node;
+				*p_node = glue;
+				return glue;
+			}
+
+			/* ... the new node and @node are siblings below a joining node. */
+			glue = _node_new (trie, prefix, common);
+			glue->child[_get_bit (node->key, common)] = node;
+			*p_node = glue;
+			p_node = &glue->child[_get_bit (prefix, common)];
+			break;
+		}
+
+		if (node->plen == plen)
+			return node;
+
+		p_node = &node->child[_get_bit (prefix, node->plen)];
+	}
+
+	node = _node_new (trie, prefix, plen);
+	*p_node = node;
+	return node;
+}
+
+static NMLpmTrieNode **
+_node_lookup_exact (const NMLpmTrie *trie, const guint8 *prefix, guint8 plen, NMLpmTrieNode ***out_p_parent)
+{
+	NMLpmTrieNode *const*p_node = &trie->root;
+	NMLpmTrieNode *const*p_parent = NULL;
+	NMLpmTrieNode *node;
+
+	while ((node = *p_node)) {
+		if (   node->plen > plen
+		    || _common_plen (node->key, prefix, node->plen) < node->plen)
+			return NULL;
+		if (node->plen == plen)
+			break;
+		p_parent = p_node;
+		p_node = &node->child[_get_bit (prefix, node->plen)];
+	}
+
+	if (!node || !node->values)
+		return NULL;
+
+	if (out_p_parent)
+		*out_p_parent = (NMLpmTrieNode **) p_parent;
+	return (NMLpmTrieNode **) p_node;
+}
+
+/******************************************************************************************/
+
+/**
+ * nm_lpm_trie_new:
+ * @addr_len: the length of the addresses in bytes, that is 4 for
+ *   IPv4 and 16 for IPv6.
+ *
+ * Returns: a new, empty trie.
+ */
+NMLpmTrie *
+nm_lpm_trie_new (guint addr_len)
+{
+	NMLpmTrie *trie;
+
+	g_return_val_if_fail (addr_len > 0 && addr_len <= ADDR_LEN_MAX, NULL);
+
+	trie = g_slice_new0 (NMLpmTrie);
+	trie->addr_len = addr_len;
+	return trie;
+}
+
+void
+nm_lpm_trie_free (NMLpmTrie *trie)
+{
+	g_return_if_fail (trie);
+
+	_node_free_recursive (trie->root);
+	g_slice_free (NMLpmTrie, trie);
+}
+
+/**
+ * nm_lpm_trie_add:
+ * @trie: the #NMLpmTrie
+ * @prefix: the network of length @addr_len. The host part is ignored.
+ * @plen: the prefix length
+ * @value: the value to add for @prefix/@plen.
+ *
+ * Returns: %FALSE if @value was already present for @prefix/@plen.
+ */
+gboolean
+nm_lpm_trie_add (NMLpmTrie *trie,
+                 gconstpointer prefix,
+                 guint8 plen,
+                 gconstpointer value)
+{
+	NMLpmTrieNode *node;
+	guint i;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (prefix, FALSE);
+	g_return_val_if_fail (plen <= trie->addr_len * 8, FALSE);
+	g_return_val_if_fail (value, FALSE);
+
+	node = _node_ensure (trie, prefix, plen);
+
+	if (node->values) {
+		for (i = 0; i < node->values_len; i++) {
+			if (node->values[i] == value)
+				return FALSE;
+		}
+	} else
+		trie->num_prefixes++;
+
+	node->values = g_renew (gpointer, node->values, node->values_len + 2);
+	node->values[node->values_len++] = (gpointer) value;
+	node->values[node->values_len] = NULL;
+	return TRUE;
+}
+
+/**
+ * nm_lpm_trie_remove:
+ * @trie: the #NMLpmTrie
+ * @prefix: the network of length @addr_len. The host part is ignored.
+ * @plen: the prefix length
+ * @value: the value to remove for @prefix/@plen.
+ *
+ * Returns: %FALSE if @value was not present for @prefix/@plen.
+ */
+gboolean
+nm_lpm_trie_remove (NMLpmTrie *trie,
+                    gconstpointer prefix,
+                    guint8 plen,
+                    gconstpointer value)
+{
+	NMLpmTrieNode **p_node, **p_parent = NULL;
+	NMLpmTrieNode *node;
+	guint i;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (prefix, FALSE);
+	g_return_val_if_fail (value, FALSE);
+
+	p_node = _node_lookup_exact (trie, prefix, plen, &p_parent);
+	if (!p_node)
+		return FALSE;
+	node = *p_node;
+
+	for (i = 0; i < node->values_len; i++) {
+		if (node->values[i] == value)
+			break;
+	}
+	if (i >= node->values_len)
+		return FALSE;
+
+	/* the order of the values is irrelevant. Replace the item by the last one. */
+	node->values_len--;
+	node->values[i] = node->values[node->values_len];
+	node->values[node->values_len] = NULL;
+
+	if (node->values_len == 0) {
+		g_clear_pointer (&node->values, g_free);
+		trie->num_prefixes--;
+
+		_node_prune (p_node);
+		if (p_parent)
+			_node_prune (p_parent);
+	}
+	return TRUE;
+}
+
+/**
+ * nm_lpm_trie_lookup_exact:
+ * @trie: the #NMLpmTrie
+ * @prefix: the network of length @addr_len. The host part is ignored.
+ * @plen: the prefix length
+ * @out_len: (allow-none): the number of returned values.
+ *
+ * Returns: the NULL terminated list of values for exactly @prefix/@plen,
+ *   or %NULL if there are none.
+ */
+void *const*
+nm_lpm_trie_lookup_exact (const NMLpmTrie *trie,
+                          gconstpointer prefix,
+                          guint8 plen,
+                          guint *out_len)
+{
+	NMLpmTrieNode **p_node;
+
+	g_return_val_if_fail (trie, NULL);
+	g_return_val_if_fail (prefix, NULL);
+
+	p_node = _node_lookup_exact (trie, prefix, plen, NULL);
+	if (!p_node) {
+		NM_SET_OUT (out_len, 0);
+		return NULL;
+	}
+	NM_SET_OUT (out_len, (*p_node)->values_len);
+	return (*p_node)->values;
+}
+
+/**
+ * nm_lpm_trie_foreach_match:
+ * @trie: the #NMLpmTrie
+ * @addr: the address to lookup, of length @addr_len.
+ * @foreach_func: called for every prefix that contains @addr, starting with
+ *   the longest one. It must not modify @trie.
+ * @user_data: user data for @foreach_func.
+ */
+void
+nm_lpm_trie_foreach_match (const NMLpmTrie *trie,
+                           gconstpointer addr,
+                           NMLpmTrieForeachFunc foreach_func,
+                           gpointer user_data)
+{
+	const NMLpmTrieNode *matches[ADDR_LEN_MAX * 8 + 1];
+	const NMLpmTrieNode *node;
+	guint n = 0;
+
+	g_return_if_fail (trie);
+	g_return_if_fail (addr);
+	g_return_if_fail (foreach_func);
+
+	for (node = trie->root; node; ) {
+		if (_common_plen (node->key, addr, node->plen) < node->plen)
+			break;
+		if (node->values)
+			matches[n++] = node;
+		if (node->plen >= trie->addr_len * 8)
+			break;
+		node = node->child[_get_bit (addr, node->plen)];
+	}
+
+	while (n > 0) {
+		n--;
+		if (!foreach_func (matches[n]->plen, matches[n]->values, matches[n]->values_len, user_data))
+			return;
+	}
+}
+
+guint
+nm_lpm_trie_get_num_prefixes (const NMLpmTrie *trie)
+{
+	g_return_val_if_fail (trie, 0);
+
+	return trie->num_prefixes;
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_LPM_TRIE__
+#define __NM_LPM_TRIE__
+
+#include "nm-default.h"
+
+G_BEGIN_DECLS
+
+/* NMLpmTrie is a path-compressed binary trie (PATRICIA) of network prefixes.
+ * For each prefix, it holds a list of values (pointers). Lookups of an address
+ * visit all prefixes that contain the address, in O(prefix-length). */
+typedef struct NMLpmTrie NMLpmTrie;
+
+/* Called for each prefix that matches, starting with the longest one.
+ * @values is NULL terminated. Return %FALSE to stop the iteration. */
+typedef gboolean (*NMLpmTrieForeachFunc) (guint8 plen, void *const*values, guint len, gpointer user_data);
+
+NMLpmTrie *nm_lpm_trie_new (guint addr_len);
+void nm_lpm_trie_free (NMLpmTrie *trie);
+
+gboolean nm_lpm_trie_add (NMLpmTrie *trie,
+                          gconstpointer prefix,
+                          guint8 plen,
+                          gconstpointer value);
+
+gboolean nm_lpm_trie_remove (NMLpmTrie *trie,
+                             gconstpointer prefix,
+                             guint8 plen,
+                             gconstpointer value);
+
+void *const*nm_lpm_trie_lookup_exact (const NMLpmTrie *trie,
+                                      gconstpointer prefix,
+                                      guint8 plen,
+                                      guint *out_len);
+
+void nm_lpm_trie_foreach_match (const NMLpmTrie *trie,
+                                gconstpointer addr,
+                                NMLpmTrieForeachFunc foreach_func,
+                                gpointer user_data);
+
+guint nm_lpm_trie_get_num_prefixes (const NMLpmTrie *trie);
+
+G_END_DECLS
+
+#endif /* __NM_LPM_TRIE__ */
@@ -51,11 +51,17 @@
 #include "nm-core-internal.h"
 #include "nm-config.h"
 #include "nm-audit-manager.h"
+#include "nm-activation-scheduler.h"
+#include "nm-startup-profile.h"
+#include "nm-dhcp4-config.h"
+#include "nm-ip4-config.h"
+#include "nm-ip6-config.h"
 #include "nm-dbus-compat.h"
 #include "NetworkManagerUtils.h"
 
 #include "nmdbus-manager.h"
 #include "nmdbus-device.h"
+#include "nmdbus-device-statistics.h"
 
 static gboolean add_device (NMManager *self, NMDevice *device, GError **error);
 
@@ -79,12 +85,21 @@ static gboolean find_master (NMManager *self,
 static void nm_manager_update_state (NMManager *manager);
 
 static void connection_changed (NMManager *self, NMConnection *connection);
+static void retry_connections_for_parent_device (NMManager *self, NMDevice *device);
 static void device_sleep_cb (NMDevice *device,
                              GParamSpec *pspec,
                              NMManager *self);
+static void resume_device_state_changed (NMManager *self,
+                                         NMDevice *device,
+                                         NMDeviceState new_state);
 
 #define TAG_ACTIVE_CONNETION_ADD_AND_ACTIVATE "act-con-add-and-activate"
 
+/* libnm connects here when running as root with NM_CLIENT_PRIVATE_SOCKET,
+ * see _nm_dbus_new_connection(). */
+#define PRIV_SOCK_PATH            NMRUNDIR "/private"
+#define PRIV_SOCK_TAG             "private"
+
 typedef struct {
 	gboolean user_enabled;
 	gboolean sw_enabled;
@@ -96,6 +111,17 @@ typedef struct {
 	const char *hw_prop;
 } RadioState;
 
+/* How an active connection contributes to the global state, see
+ * find_best_device_state(). */
+typedef enum {
+	AC_STATE_CLASS_NONE,
+	AC_STATE_CLASS_DEACTIVATING,
+	AC_STATE_CLASS_ACTIVATED,
+	AC_STATE_CLASS_ACTIVATING,
+	AC_STATE_CLASS_ACTIVATED_DEFAULT,
+	_AC_STATE_CLASS_NUM,
+} AcStateClass;
+
 typedef struct {
 	GSList *active_connections;
 	GSList *authorizing_connections;
@@ -105,9 +131,40 @@ typedef struct {
 	NMMetered metered;
 
 	GSList *devices;
+
+	/* Lookup indexes for @devices. Each maps a key to a GPtrArray of the
+	 * devices with that key, in the order they were indexed. The string
+	 * keys are interned and hashed by pointer. */
+	struct {
+		GHashTable *by_ifindex;
+		GHashTable *by_path;
+		GHashTable *by_iface;
+		GHashTable *by_ip_iface;
+		GHashTable *by_hw_addr;
+		/* NMDevice -> DeviceIndexKeys */
+		GHashTable *keys;
+	} device_idx;
+
+	/* Lookup indexes for @active_connections, like @device_idx. The
+	 * buckets are in the order the connections were added. */
+	struct {
+		GHashTable *by_settings_connection;
+		GHashTable *by_path;
+		GHashTable *by_device;
+		/* NMActiveConnection -> AcIndexKeys */
+		GHashTable *keys;
+		/* the number of active connections per AcStateClass */
+		guint state_count[_AC_STATE_CLASS_NUM];
+	} ac_idx;
+
 	NMState state;
 	NMConfig *config;
 	NMConnectivity *connectivity;
+	/* NMDevice -> NMConnectivityProbe, for [connectivity].per-device */
+	GHashTable *connectivity_probes;
+	bool connectivity_per_device;
+
+	NMActivationScheduler *activation_scheduler;
 
 	NMPolicy *policy;
 
@@ -132,13 +189,48 @@ typedef struct {
 	GSList *auth_chains;
 	GHashTable *sleep_devices;
 
+	struct {
+		/* device -> ResumeSnapshot, taken when suspending */
+		GHashTable *snapshots;
+		/* devices re-activated from their snapshot, not yet activated */
+		GHashTable *activating;
+		/* interface name -> milliseconds from wake to activated */
+		GHashTable *timeline;
+		gint64 wake_ts;
+		guint idle_id;
+	} resume;
+
 	/* Firmware dir monitor */
 	GFileMonitor *fw_monitor;
 	guint fw_changed_id;
 
 	guint timestamp_update_id;
 
+	struct {
+		/* ifindexes of links that were added or removed, in order. */
+		GArray *ifindexes;
+		GHashTable *idx;
+		guint idle_id;
+	} platform_link_pending;
+
+	/* virtual devices whose creation is deferred until the end of
+	 * the current bulk section, see virtual_devices_bulk_begin(). */
+	struct {
+		GArray *pending;
+		/* the devices in @pending */
+		GHashTable *queued;
+		guint depth;
+	} create_bulk;
+
+	/* open transactions, see BeginTransaction() */
+	struct {
+		GSList *list;
+		guint last_id;
+	} transactions;
+
 	gboolean startup;
+	/* a device was activated during startup; for the startup profile */
+	gboolean startup_activated;
 	gboolean devices_inited;
 } NMManagerPrivate;
 
@@ -191,6 +283,9 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMManager,
 	PROP_METERED,
 	PROP_GLOBAL_DNS_CONFIGURATION,
 	PROP_ALL_DEVICES,
+	PROP_ACTIVATION_QUEUE_DEPTH,
+	PROP_ACTIVATION_WAIT_TIME,
+	PROP_RESUME_TIMELINE,
 
 	/* Not exported */
 	PROP_HOSTNAME,
@@ -207,7 +302,7 @@ NM_DEFINE_SINGLETON_INSTANCE (NMManager);
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = (domain); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             const NMManager *const __self = (self); \
             char __sbuf[32]; \
             \
@@ -232,6 +327,13 @@ static void active_connection_default_changed (NMActiveConnection *active,
 static void active_connection_parent_active (NMActiveConnection *active,
                                              NMActiveConnection *parent_ac,
                                              NMManager *self);
+static void active_connection_device_changed (NMActiveConnection *active,
+                                              GParamSpec *pspec,
+                                              NMManager *self);
+
+static void _ac_index_update (NMManager *self, NMActiveConnection *active);
+static void _ac_index_remove (NMManager *self, NMActiveConnection *active);
+static NMActiveConnection *_ac_index_lookup_path (NMManager *self, const char *path);
 
 /* Returns: whether to notify D-Bus of the removal or not */
 static gboolean
@@ -247,10 +349,12 @@ active_connection_remove (NMManager *self, NMActiveConnection *active)
 		NMSettingsConnection *connection;
 
 		priv->active_connections = g_slist_remove (priv->active_connections, active);
+		_ac_index_remove (self, active);
 		g_signal_emit (self, signals[ACTIVE_CONNECTION_REMOVED], 0, active);
 		g_signal_handlers_disconnect_by_func (active, active_connection_state_changed, self);
 		g_signal_handlers_disconnect_by_func (active, active_connection_default_changed, self);
 		g_signal_handlers_disconnect_by_func (active, active_connection_parent_active, self);
+		g_signal_handlers_disconnect_by_func (active, active_connection_device_changed, self);
 
 		if (   nm_active_connection_get_assumed (active)
 		    && (connection = nm_active_connection_get_settings_connection (active))
@@ -317,6 +421,7 @@ active_connection_state_changed (NMActiveConnection *active,
 			priv->ac_cleanup_id = g_idle_add (_active_connection_cleanup, self);
 	}
 
+	_ac_index_update (self, active);
 	nm_manager_update_state (self);
 }
 
@@ -325,9 +430,18 @@ active_connection_default_changed (NMActiveConnection *active,
                                    GParamSpec *pspec,
                                    NMManager *self)
 {
+	_ac_index_update (self, active);
 	nm_manager_update_state (self);
 }
 
+static void
+active_connection_device_changed (NMActiveConnection *active,
+                                  GParamSpec *pspec,
+                                  NMManager *self)
+{
+	_ac_index_update (self, active);
+}
+
 /**
  * active_connection_add():
  * @self: the #NMManager
@@ -344,6 +458,7 @@ active_connection_add (NMManager *self, NMActiveConnection *active)
 
 	priv->active_connections = g_slist_prepend (priv->active_connections,
 	                                            g_object_ref (active));
+	_ac_index_update (self, active);
 
 	g_signal_connect (active,
 	                  "notify::" NM_ACTIVE_CONNECTION_STATE,
@@ -357,6 +472,10 @@ active_connection_add (NMManager *self, NMActiveConnection *active)
 	                  "notify::" NM_ACTIVE_CONNECTION_DEFAULT6,
 	                  G_CALLBACK (active_connection_default_changed),
 	                  self);
+	g_signal_connect (active,
+	                  "notify::" NM_ACTIVE_CONNECTION_INT_DEVICE,
+	                  G_CALLBACK (active_connection_device_changed),
+	                  self);
 
 	g_signal_emit (self, signals[ACTIVE_CONNECTION_ADDED], 0, active);
 
@@ -375,32 +494,25 @@ static NMActiveConnection *
 find_ac_for_connection (NMManager *manager, NMConnection *connection)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
-	GSList *iter;
-	const char *uuid = NULL;
-	gboolean is_settings_connection;
-
-	is_settings_connection = NM_IS_SETTINGS_CONNECTION (connection);
-
-	if (!is_settings_connection)
-		uuid = nm_connection_get_uuid (connection);
-
-	for (iter = priv->active_connections; iter; iter = iter->next) {
-		NMActiveConnection *ac = iter->data;
-		NMSettingsConnection *con;
+	NMActiveConnection *const *acs;
+	NMSettingsConnection *con;
+	guint i;
 
-		con = nm_active_connection_get_settings_connection (ac);
+	/* depending on whether we have a NMSettingsConnection or a NMConnection,
+	 * we lookup by reference or by UUID. */
+	if (NM_IS_SETTINGS_CONNECTION (connection))
+		con = (NMSettingsConnection *) connection;
+	else {
+		con = nm_settings_get_connection_by_uuid (priv->settings, nm_connection_get_uuid (connection));
+		if (!con)
+			return NULL;
+	}
 
-		/* depending on whether we have a NMSettingsConnection or a NMConnection,
-		 * we lookup by UUID or by reference. */
-		if (is_settings_connection) {
-			if (con != (NMSettingsConnection *) connection)
-				continue;
-		} else {
-			if (strcmp (uuid, nm_connection_get_uuid (NM_CONNECTION (con))) != 0)
-				continue;
-		}
-		if (nm_active_connection_get_state (ac) < NM_ACTIVE_CONNECTION_STATE_DEACTIVATED)
-			return ac;
+	/* the most recently added one first */
+	acs = nm_manager_get_active_connections_for_connection (manager, con, &i);
+	while (i-- > 0) {
+		if (nm_active_connection_get_state (acs[i]) < NM_ACTIVE_CONNECTION_STATE_DEACTIVATED)
+			return acs[i];
 	}
 
 	return NULL;
@@ -431,101 +543,570 @@ nm_manager_get_activatable_connections (NMManager *manager)
 	return g_slist_reverse (connections);
 }
 
+/**
+ * nm_manager_connection_is_activatable:
+ * @manager: the #NMManager
+ * @connection: the #NMSettingsConnection to check
+ *
+ * Returns: %TRUE if @connection is not already active, the per-connection
+ *   counterpart of nm_manager_get_activatable_connections().
+ */
+gboolean
+nm_manager_connection_is_activatable (NMManager *manager,
+                                      NMSettingsConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_MANAGER (manager), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (connection), FALSE);
+
+	return !find_ac_for_connection (manager, NM_CONNECTION (connection));
+}
+
 static NMActiveConnection *
 active_connection_get_by_path (NMManager *manager, const char *path)
 {
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
-	GSList *iter;
-
 	g_return_val_if_fail (manager != NULL, NULL);
 	g_return_val_if_fail (path != NULL, NULL);
 
-	for (iter = priv->active_connections; iter; iter = g_slist_next (iter)) {
-		NMActiveConnection *candidate = iter->data;
+	return _ac_index_lookup_path (manager, path);
+}
 
-		if (g_strcmp0 (path, nm_exported_object_get_path (NM_EXPORTED_OBJECT (candidate))) == 0)
-			return candidate;
+/************************************************************************/
+
+static void
+_activation_scheduler_update_config (NMManager *self, NMConfigData *config_data)
+{
+	const char *value;
+
+	value = nm_config_data_get_value_cached (config_data,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_ACTIVATION_MAX_CONCURRENT,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	nm_activation_scheduler_set_max_concurrent (NM_MANAGER_GET_PRIVATE (self)->activation_scheduler,
+	                                            _nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXUINT32,
+	                                                                          NM_ACTIVATION_SCHEDULER_MAX_CONCURRENT_DEFAULT));
+}
+
+static void
+_dbus_notify_update_config (NMConfigData *config_data)
+{
+	const char *budget, *max_latency;
+
+	budget = nm_config_data_get_value_cached (config_data,
+	                                          NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                          NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_NOTIFY_BUDGET,
+	                                          NM_CONFIG_GET_VALUE_STRIP);
+	max_latency = nm_config_data_get_value_cached (config_data,
+	                                               NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                               NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_NOTIFY_MAX_LATENCY,
+	                                               NM_CONFIG_GET_VALUE_STRIP);
+	nm_exported_object_class_set_notify_limits (_nm_utils_ascii_str_to_int64 (budget, 10, 0, G_MAXUINT32,
+	                                                                          NM_EXPORTED_OBJECT_NOTIFY_BUDGET_DEFAULT),
+	                                            _nm_utils_ascii_str_to_int64 (max_latency, 10, 0, G_MAXUINT32,
+	                                                                          NM_EXPORTED_OBJECT_NOTIFY_MAX_LATENCY_DEFAULT));
+}
+
+static void
+activation_scheduler_changed (NMActivationScheduler *scheduler,
+                              GParamSpec *pspec,
+                              NMManager *self)
+{
+	if (nm_streq (pspec->name, NM_ACTIVATION_SCHEDULER_QUEUE_DEPTH))
+		_notify (self, PROP_ACTIVATION_QUEUE_DEPTH);
+	else
+		_notify (self, PROP_ACTIVATION_WAIT_TIME);
+}
+
+/************************************************************************/
+
+static void
+_connectivity_probe_cb (NMConnectivityProbe *probe,
+                        NMConnectivityState state,
+                        guint latency_msec,
+                        gpointer user_data)
+{
+	nm_device_set_connectivity (NM_DEVICE (user_data), state, latency_msec);
+}
+
+static char *
+_connectivity_probe_local_address (NMDevice *device)
+{
+	NMIP4Config *ip4_config;
+	NMIP6Config *ip6_config;
+	guint i;
+
+	ip4_config = nm_device_get_ip4_config (device);
+	if (ip4_config && nm_ip4_config_get_num_addresses (ip4_config))
+		return g_strdup (nm_utils_inet4_ntop (nm_ip4_config_get_address (ip4_config, 0)->address, NULL));
+
+	ip6_config = nm_device_get_ip6_config (device);
+	for (i = 0; ip6_config && i < nm_ip6_config_get_num_addresses (ip6_config); i++) {
+		const NMPlatformIP6Address *address = nm_ip6_config_get_address (ip6_config, i);
+
+		if (!IN6_IS_ADDR_LINKLOCAL (&address->address))
+			return g_strdup (nm_utils_inet6_ntop (&address->address, NULL));
 	}
 	return NULL;
 }
 
+/* Probes run for activated devices with an address to send from. */
+static void
+_connectivity_probe_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	NMConnectivityProbe *probe;
+	gs_free char *local_address = NULL;
+
+	if (   !priv->connectivity_per_device
+	    || nm_device_get_state (device) != NM_DEVICE_STATE_ACTIVATED) {
+		if (g_hash_table_remove (priv->connectivity_probes, device))
+			nm_device_set_connectivity (device, NM_CONNECTIVITY_UNKNOWN, 0);
+		return;
+	}
+
+	if (g_hash_table_contains (priv->connectivity_probes, device))
+		return;
+
+	local_address = _connectivity_probe_local_address (device);
+	if (!local_address)
+		return;
+
+	probe = nm_connectivity_probe_new (priv->connectivity,
+	                                   nm_device_get_ip_iface (device),
+	                                   local_address,
+	                                   _connectivity_probe_cb,
+	                                   device);
+	if (probe)
+		g_hash_table_insert (priv->connectivity_probes, device, probe);
+}
+
+static void
+_connectivity_probe_update_config (NMManager *self, NMConfigData *config_data)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gboolean per_device;
+	GSList *iter;
+
+	per_device = nm_config_data_get_value_boolean (config_data,
+	                                               NM_CONFIG_KEYFILE_GROUP_CONNECTIVITY,
+	                                               NM_CONFIG_KEYFILE_KEY_CONNECTIVITY_PER_DEVICE,
+	                                               FALSE);
+	if (priv->connectivity_per_device == per_device)
+		return;
+
+	priv->connectivity_per_device = per_device;
+	for (iter = priv->devices; iter; iter = iter->next)
+		_connectivity_probe_update (self, iter->data);
+}
+
 /************************************************************************/
 
 static void
 _config_changed_cb (NMConfig *config, NMConfigData *config_data, NMConfigChangeFlags changes, NMConfigData *old_data, NMManager *self)
 {
-	g_object_set (NM_MANAGER_GET_PRIVATE (self)->connectivity,
-	              NM_CONNECTIVITY_URI, nm_config_data_get_connectivity_uri (config_data),
-	              NM_CONNECTIVITY_INTERVAL, nm_config_data_get_connectivity_interval (config_data),
-	              NM_CONNECTIVITY_RESPONSE, nm_config_data_get_connectivity_response (config_data),
-	              NULL);
+	if (NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_CONNECTIVITY)) {
+		g_object_set (NM_MANAGER_GET_PRIVATE (self)->connectivity,
+		              NM_CONNECTIVITY_URI, nm_config_data_get_connectivity_uri (config_data),
+		              NM_CONNECTIVITY_INTERVAL, nm_config_data_get_connectivity_interval (config_data),
+		              NM_CONNECTIVITY_RESPONSE, nm_config_data_get_connectivity_response (config_data),
+		              NULL);
+	}
 
 	if (NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG))
 		_notify (self, PROP_GLOBAL_DNS_CONFIGURATION);
+
+	/* the remaining options are plain values, a signal without new
+	 * configuration doesn't change them. */
+	if (!NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_VALUES))
+		return;
+
+	_activation_scheduler_update_config (self, config_data);
+	_dbus_notify_update_config (config_data);
+	_connectivity_probe_update_config (self, config_data);
 }
 
 /************************************************************************/
 
+typedef struct {
+	int ifindex;
+	/* interned */
+	const char *path;
+	const char *iface;
+	const char *ip_iface;
+	GBytes *hw_addr;
+} DeviceIndexKeys;
+
+static void
+_device_index_keys_free (gpointer data)
+{
+	DeviceIndexKeys *keys = data;
+
+	nm_intern_str_unref (keys->path);
+	nm_intern_str_unref (keys->iface);
+	nm_intern_str_unref (keys->ip_iface);
+	if (keys->hw_addr)
+		g_bytes_unref (keys->hw_addr);
+	g_slice_free (DeviceIndexKeys, keys);
+}
+
+/* @hwaddr as compared by nm_utils_hwaddr_matches(), prefixed by its
+ * length. */
+static GBytes *
+_hw_addr_index_key (const NMHwAddr *hwaddr)
+{
+	guint8 buf[1 + NM_UTILS_HWADDR_LEN_MAX];
+
+	if (!hwaddr || !hwaddr->len)
+		return NULL;
+
+	/* only the last 8 bytes of an InfiniBand address are significant. */
+	if (hwaddr->len == INFINIBAND_ALEN) {
+		buf[0] = INFINIBAND_ALEN;
+		memcpy (&buf[1], &hwaddr->addr[INFINIBAND_ALEN - 8], 8);
+		return g_bytes_new (buf, 1 + 8);
+	}
+	buf[0] = hwaddr->len;
+	memcpy (&buf[1], hwaddr->addr, hwaddr->len);
+	return g_bytes_new (buf, 1 + hwaddr->len);
+}
+
+/* The helpers are shared by the device and the active connection indexes,
+ * so they take the indexed object as a plain pointer. */
+static void
+_device_idx_add (GHashTable *idx, gconstpointer key, GBoxedCopyFunc key_copy, gpointer obj)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (idx, key_copy ? key_copy ((gpointer) key) : (gpointer) key, bucket);
+	}
+	g_ptr_array_add (bucket, obj);
+}
+
+static void
+_device_idx_remove (GHashTable *idx, gconstpointer key, gpointer obj)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	g_return_if_fail (bucket);
+
+	g_ptr_array_remove (bucket, obj);
+	if (!bucket->len)
+		g_hash_table_remove (idx, key);
+}
+
+static NMDevice *const *
+_device_idx_lookup (GHashTable *idx, gconstpointer key, guint *out_len)
+{
+	GPtrArray *bucket;
+
+	bucket = key ? g_hash_table_lookup (idx, key) : NULL;
+	*out_len = bucket ? bucket->len : 0;
+	return bucket ? (NMDevice *const *) bucket->pdata : NULL;
+}
+
+/* Looks up a string key. A string that isn't interned isn't held
+ * by any device, so there is no need to search the index. */
+static NMDevice *const *
+_device_idx_lookup_str (GHashTable *idx, const char *key, guint *out_len)
+{
+	return _device_idx_lookup (idx, nm_intern_str_lookup (key), out_len);
+}
+
+static void
+_device_idx_update_str (GHashTable *idx, const char **p_key, const char *new_key, gpointer device)
+{
+	const char *old_key = *p_key;
+
+	*p_key = nm_intern_str_ref (new_key);
+	if (*p_key == old_key) {
+		nm_intern_str_unref (old_key);
+		return;
+	}
+
+	if (old_key) {
+		_device_idx_remove (idx, old_key, device);
+		nm_intern_str_unref (old_key);
+	}
+	if (*p_key)
+		_device_idx_add (idx, *p_key, (GBoxedCopyFunc) nm_intern_str_ref_interned, device);
+}
+
+/* Re-index @device after one of its keys changed. */
+static void
+_device_index_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIndexKeys *keys;
+	GBytes *hw_addr;
+	int ifindex;
+
+	keys = g_hash_table_lookup (priv->device_idx.keys, device);
+	if (!keys) {
+		keys = g_slice_new0 (DeviceIndexKeys);
+		g_hash_table_insert (priv->device_idx.keys, device, keys);
+	}
+
+	ifindex = nm_device_get_ifindex (device);
+	if (ifindex <= 0)
+		ifindex = 0;
+	if (keys->ifindex != ifindex) {
+		if (keys->ifindex)
+			_device_idx_remove (priv->device_idx.by_ifindex, GINT_TO_POINTER (keys->ifindex), device);
+		keys->ifindex = ifindex;
+		if (keys->ifindex)
+			_device_idx_add (priv->device_idx.by_ifindex, GINT_TO_POINTER (keys->ifindex), NULL, device);
+	}
+
+	_device_idx_update_str (priv->device_idx.by_path, &keys->path,
+	                        nm_exported_object_get_path (NM_EXPORTED_OBJECT (device)), device);
+	_device_idx_update_str (priv->device_idx.by_iface, &keys->iface,
+	                        nm_device_get_iface (device), device);
+	_device_idx_update_str (priv->device_idx.by_ip_iface, &keys->ip_iface,
+	                        nm_device_get_ip_iface (device), device);
+
+	hw_addr = _hw_addr_index_key (nm_device_get_hw_address_bin (device));
+	if (   !hw_addr != !keys->hw_addr
+	    || (hw_addr && !g_bytes_equal (hw_addr, keys->hw_addr))) {
+		if (keys->hw_addr) {
+			_device_idx_remove (priv->device_idx.by_hw_addr, keys->hw_addr, device);
+			g_bytes_unref (keys->hw_addr);
+		}
+		keys->hw_addr = hw_addr;
+		if (keys->hw_addr)
+			_device_idx_add (priv->device_idx.by_hw_addr, keys->hw_addr, (GBoxedCopyFunc) g_bytes_ref, device);
+	} else if (hw_addr)
+		g_bytes_unref (hw_addr);
+}
+
+static void
+_device_index_remove (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIndexKeys *keys;
+
+	keys = g_hash_table_lookup (priv->device_idx.keys, device);
+	if (!keys)
+		return;
+
+	if (keys->ifindex)
+		_device_idx_remove (priv->device_idx.by_ifindex, GINT_TO_POINTER (keys->ifindex), device);
+	if (keys->path)
+		_device_idx_remove (priv->device_idx.by_path, keys->path, device);
+	if (keys->iface)
+		_device_idx_remove (priv->device_idx.by_iface, keys->iface, device);
+	if (keys->ip_iface)
+		_device_idx_remove (priv->device_idx.by_ip_iface, keys->ip_iface, device);
+	if (keys->hw_addr)
+		_device_idx_remove (priv->device_idx.by_hw_addr, keys->hw_addr, device);
+	g_hash_table_remove (priv->device_idx.keys, device);
+}
+
+typedef struct {
+	NMSettingsConnection *settings_connection;
+	const char *path;
+	NMDevice *device;
+	AcStateClass state_class;
+} AcIndexKeys;
+
+static AcStateClass
+_ac_state_class (NMActiveConnection *active)
+{
+	switch (nm_active_connection_get_state (active)) {
+	case NM_ACTIVE_CONNECTION_STATE_ACTIVATED:
+		if (   nm_active_connection_get_default (active)
+		    || nm_active_connection_get_default6 (active))
+			return AC_STATE_CLASS_ACTIVATED_DEFAULT;
+		return AC_STATE_CLASS_ACTIVATED;
+	case NM_ACTIVE_CONNECTION_STATE_ACTIVATING:
+		if (!nm_active_connection_get_assumed (active))
+			return AC_STATE_CLASS_ACTIVATING;
+		return AC_STATE_CLASS_NONE;
+	case NM_ACTIVE_CONNECTION_STATE_DEACTIVATING:
+		if (!nm_active_connection_get_assumed (active))
+			return AC_STATE_CLASS_DEACTIVATING;
+		return AC_STATE_CLASS_NONE;
+	default:
+		return AC_STATE_CLASS_NONE;
+	}
+}
+
+static void
+_ac_index_keys_free (gpointer data)
+{
+	AcIndexKeys *keys = data;
+
+	nm_intern_str_unref (keys->path);
+	g_slice_free (AcIndexKeys, keys);
+}
+
+/* The settings connection and the path of an active connection don't
+ * change once it is added, but its device might. */
+static void
+_ac_index_update (NMManager *self, NMActiveConnection *active)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	AcIndexKeys *keys;
+	NMSettingsConnection *con;
+	NMDevice *device;
+
+	keys = g_hash_table_lookup (priv->ac_idx.keys, active);
+	if (!keys) {
+		keys = g_slice_new0 (AcIndexKeys);
+		g_hash_table_insert (priv->ac_idx.keys, active, keys);
+		priv->ac_idx.state_count[keys->state_class]++;
+	}
+
+	con = _nm_active_connection_get_settings_connection (active);
+	if (keys->settings_connection != con) {
+		if (keys->settings_connection)
+			_device_idx_remove (priv->ac_idx.by_settings_connection, keys->settings_connection, active);
+		keys->settings_connection = con;
+		if (keys->settings_connection)
+			_device_idx_add (priv->ac_idx.by_settings_connection, keys->settings_connection, NULL, active);
+	}
+
+	_device_idx_update_str (priv->ac_idx.by_path, &keys->path,
+	                        nm_exported_object_get_path (NM_EXPORTED_OBJECT (active)), active);
+
+	device = nm_active_connection_get_device (active);
+	if (keys->device != device) {
+		if (keys->device)
+			_device_idx_remove (priv->ac_idx.by_device, keys->device, active);
+		keys->device = device;
+		if (keys->device)
+			_device_idx_add (priv->ac_idx.by_device, keys->device, NULL, active);
+	}
+
+	priv->ac_idx.state_count[keys->state_class]--;
+	keys->state_class = _ac_state_class (active);
+	priv->ac_idx.state_count[keys->state_class]++;
+}
+
+static void
+_ac_index_remove (NMManager *self, NMActiveConnection *active)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	AcIndexKeys *keys;
+
+	keys = g_hash_table_lookup (priv->ac_idx.keys, active);
+	if (!keys)
+		return;
+
+	if (keys->settings_connection)
+		_device_idx_remove (priv->ac_idx.by_settings_connection, keys->settings_connection, active);
+	if (keys->path)
+		_device_idx_remove (priv->ac_idx.by_path, keys->path, active);
+	if (keys->device)
+		_device_idx_remove (priv->ac_idx.by_device, keys->device, active);
+	priv->ac_idx.state_count[keys->state_class]--;
+	g_hash_table_remove (priv->ac_idx.keys, active);
+}
+
+static NMActiveConnection *
+_ac_index_lookup_path (NMManager *self, const char *path)
+{
+	NMActiveConnection *const *acs;
+	guint len;
+
+	acs = (NMActiveConnection *const *) _device_idx_lookup_str (NM_MANAGER_GET_PRIVATE (self)->ac_idx.by_path, path, &len);
+	return len ? acs[0] : NULL;
+}
+
+/**
+ * nm_manager_get_active_connections_for_connection:
+ * @manager: the #NMManager
+ * @connection: the #NMSettingsConnection
+ * @out_len: (out): the number of returned active connections
+ *
+ * Returns: (transfer none): the active connections of @connection, in any
+ *   state, in the order they were added. The list is only valid until the
+ *   next active connection is added or removed.
+ */
+NMActiveConnection *const *
+nm_manager_get_active_connections_for_connection (NMManager *manager,
+                                                  NMSettingsConnection *connection,
+                                                  guint *out_len)
+{
+	return (NMActiveConnection *const *) _device_idx_lookup (NM_MANAGER_GET_PRIVATE (manager)->ac_idx.by_settings_connection,
+	                                                         connection, out_len);
+}
+
+/**
+ * nm_manager_get_active_connections_for_device:
+ * @manager: the #NMManager
+ * @device: the #NMDevice
+ * @out_len: (out): the number of returned active connections
+ *
+ * Like nm_manager_get_active_connections_for_connection(), for the active
+ * connections whose device is @device.
+ */
+NMActiveConnection *const *
+nm_manager_get_active_connections_for_device (NMManager *manager,
+                                              NMDevice *device,
+                                              guint *out_len)
+{
+	return (NMActiveConnection *const *) _device_idx_lookup (NM_MANAGER_GET_PRIVATE (manager)->ac_idx.by_device,
+	                                                         device, out_len);
+}
+
 static NMDevice *
 nm_manager_get_device_by_path (NMManager *manager, const char *path)
 {
-	GSList *iter;
+	NMDevice *const *devices;
+	guint len;
 
 	g_return_val_if_fail (path != NULL, NULL);
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		if (!strcmp (nm_exported_object_get_path (NM_EXPORTED_OBJECT (iter->data)), path))
-			return NM_DEVICE (iter->data);
-	}
-	return NULL;
+	devices = _device_idx_lookup_str (NM_MANAGER_GET_PRIVATE (manager)->device_idx.by_path, path, &len);
+	return len ? devices[0] : NULL;
 }
 
 NMDevice *
 nm_manager_get_device_by_ifindex (NMManager *manager, int ifindex)
 {
-	GSList *iter;
+	NMDevice *const *devices;
+	guint len;
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		NMDevice *device = NM_DEVICE (iter->data);
-
-		if (nm_device_get_ifindex (device) == ifindex)
-			return device;
-	}
+	if (ifindex <= 0)
+		return NULL;
 
-	return NULL;
+	devices = _device_idx_lookup (NM_MANAGER_GET_PRIVATE (manager)->device_idx.by_ifindex,
+	                              GINT_TO_POINTER (ifindex), &len);
+	return len ? devices[0] : NULL;
 }
 
 static NMDevice *
 find_device_by_hw_addr (NMManager *manager, const char *hwaddr)
 {
-	GSList *iter;
-	const char *device_addr;
+	gs_unref_bytes GBytes *key = NULL;
+	NMDevice *const *devices;
+	NMHwAddr addr;
+	guint len;
 
 	g_return_val_if_fail (hwaddr != NULL, NULL);
 
-	if (nm_utils_hwaddr_valid (hwaddr, -1)) {
-		for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-			device_addr = nm_device_get_hw_address (NM_DEVICE (iter->data));
-			if (device_addr && nm_utils_hwaddr_matches (hwaddr, -1, device_addr, -1))
-				return NM_DEVICE (iter->data);
-		}
-	}
-	return NULL;
+	if (!_nm_hwaddr_from_str (&addr, hwaddr))
+		return NULL;
+	key = _hw_addr_index_key (&addr);
+	devices = _device_idx_lookup (NM_MANAGER_GET_PRIVATE (manager)->device_idx.by_hw_addr, key, &len);
+	return len ? devices[0] : NULL;
 }
 
 static NMDevice *
 find_device_by_ip_iface (NMManager *self, const gchar *iface)
 {
-	GSList *iter;
+	NMDevice *const *devices;
+	guint i, len;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = g_slist_next (iter)) {
-		NMDevice *candidate = iter->data;
-
-		if (   nm_device_is_real (candidate)
-		    && g_strcmp0 (nm_device_get_ip_iface (candidate), iface) == 0)
-			return candidate;
+	devices = _device_idx_lookup_str (NM_MANAGER_GET_PRIVATE (self)->device_idx.by_ip_iface, iface, &len);
+	for (i = 0; i < len; i++) {
+		if (nm_device_is_real (devices[i]))
+			return devices[i];
 	}
 	return NULL;
 }
@@ -553,15 +1134,15 @@ find_device_by_iface (NMManager *self,
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *fallback = NULL;
-	GSList *iter;
+	NMDevice *const *devices;
+	guint i, len;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
-	for (iter = priv->devices; iter; iter = iter->next) {
-		NMDevice *candidate = iter->data;
+	devices = _device_idx_lookup_str (priv->device_idx.by_iface, iface, &len);
+	for (i = 0; i < len; i++) {
+		NMDevice *candidate = devices[i];
 
-		if (strcmp (nm_device_get_iface (candidate), iface))
-			continue;
 		if (connection && !nm_device_check_connection_compatible (candidate, connection))
 			continue;
 		if (slave) {
@@ -650,48 +1231,28 @@ checked_connectivity (GObject *object, GAsyncResult *result, gpointer user_data)
 	g_object_unref (manager);
 }
 
+/* The state follows from the number of active connections in each
+ * AcStateClass, which the active connection index keeps up to date. A
+ * connection with the default route wins over one that is activating,
+ * which wins over one that is only locally connected. */
 static NMState
 find_best_device_state (NMManager *manager)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
-	NMState best_state = NM_STATE_DISCONNECTED;
-	GSList *iter;
-
-	for (iter = priv->active_connections; iter; iter = iter->next) {
-		NMActiveConnection *ac = NM_ACTIVE_CONNECTION (iter->data);
-		NMActiveConnectionState ac_state = nm_active_connection_get_state (ac);
-
-		switch (ac_state) {
-		case NM_ACTIVE_CONNECTION_STATE_ACTIVATED:
-			if (   nm_active_connection_get_default (ac)
-			    || nm_active_connection_get_default6 (ac)) {
-				if (nm_connectivity_get_state (priv->connectivity) == NM_CONNECTIVITY_FULL)
-					return NM_STATE_CONNECTED_GLOBAL;
+	const guint *count = priv->ac_idx.state_count;
 
-				best_state = NM_STATE_CONNECTED_SITE;
-			} else {
-				if (best_state < NM_STATE_CONNECTING)
-					best_state = NM_STATE_CONNECTED_LOCAL;
-			}
-			break;
-		case NM_ACTIVE_CONNECTION_STATE_ACTIVATING:
-			if (!nm_active_connection_get_assumed (ac)) {
-				if (best_state != NM_STATE_CONNECTED_GLOBAL)
-					best_state = NM_STATE_CONNECTING;
-			}
-			break;
-		case NM_ACTIVE_CONNECTION_STATE_DEACTIVATING:
-			if (!nm_active_connection_get_assumed (ac)) {
-				if (best_state < NM_STATE_DISCONNECTING)
-					best_state = NM_STATE_DISCONNECTING;
-			}
-			break;
-		default:
-			break;
-		}
+	if (count[AC_STATE_CLASS_ACTIVATED_DEFAULT]) {
+		if (nm_connectivity_get_state (priv->connectivity) == NM_CONNECTIVITY_FULL)
+			return NM_STATE_CONNECTED_GLOBAL;
+		return NM_STATE_CONNECTED_SITE;
 	}
-
-	return best_state;
+	if (count[AC_STATE_CLASS_ACTIVATING])
+		return NM_STATE_CONNECTING;
+	if (count[AC_STATE_CLASS_ACTIVATED])
+		return NM_STATE_CONNECTED_LOCAL;
+	if (count[AC_STATE_CLASS_DEACTIVATING])
+		return NM_STATE_DISCONNECTING;
+	return NM_STATE_DISCONNECTED;
 }
 
 static void
@@ -768,6 +1329,17 @@ manager_device_state_changed (NMDevice *device,
 	if (   new_state == NM_DEVICE_STATE_UNAVAILABLE
 	    || new_state == NM_DEVICE_STATE_DISCONNECTED)
 		nm_settings_device_added (priv->settings, device);
+
+	if (   new_state == NM_DEVICE_STATE_ACTIVATED
+	    && priv->startup
+	    && !priv->startup_activated) {
+		priv->startup_activated = TRUE;
+		nm_startup_profile_mark ("first-activation", nm_device_get_iface (device));
+	}
+
+	_connectivity_probe_update (self, device);
+
+	resume_device_state_changed (self, device, new_state);
 }
 
 static void device_has_pending_action_changed (NMDevice *device,
@@ -806,6 +1378,9 @@ check_if_startup_complete (NMManager *self)
 	priv->startup = FALSE;
 	_notify (self, PROP_STARTUP);
 
+	nm_startup_profile_mark ("startup-complete", NULL);
+	nm_startup_profile_finish ();
+
 	/* We don't have to watch notify::has-pending-action any more. */
 	for (iter = priv->devices; iter; iter = iter->next) {
 		NMDevice *dev = iter->data;
@@ -884,6 +1459,10 @@ remove_device (NMManager *self,
 
 	nm_settings_device_removed (priv->settings, device, quitting);
 	priv->devices = g_slist_remove (priv->devices, device);
+	_device_index_remove (self, device);
+	g_hash_table_remove (priv->resume.snapshots, device);
+	g_hash_table_remove (priv->resume.activating, device);
+	g_hash_table_remove (priv->connectivity_probes, device);
 
 	if (nm_device_is_real (device)) {
 		gboolean unconfigure_ip_config = !quitting || unmanage;
@@ -1144,6 +1723,33 @@ system_create_virtual_device (NMManager *self, NMConnection *connection)
 		if (!nm_setting_connection_get_autoconnect (s_con))
 			continue;
 
+		if (   priv->create_bulk.depth > 0
+		    && nm_device_can_create_batched (device)) {
+			NMDeviceCreateData data;
+
+			/* another connection for the same device may already have
+			 * queued it. Creating it twice fails with EEXIST. */
+			if (g_hash_table_contains (priv->create_bulk.queued, device)) {
+				_LOGD (LOGD_DEVICE, "(%s) virtual interface %s is already queued",
+				       nm_connection_get_id (connection), iface);
+				return NULL;
+			}
+
+			data = (NMDeviceCreateData) {
+				.device = g_object_ref (device),
+				.connection = g_object_ref (connection),
+				.parent = parent ? g_object_ref (parent) : NULL,
+			};
+
+			/* Create the link together with the others at the end of the bulk
+			 * section. Until then, it can't be the parent of other devices. */
+			_LOGD (LOGD_DEVICE, "(%s) defer creating virtual interface %s",
+			       nm_connection_get_id (connection), iface);
+			g_array_append_val (priv->create_bulk.pending, data);
+			g_hash_table_add (priv->create_bulk.queued, device);
+			return NULL;
+		}
+
 		/* Create any backing resources the device needs */
 		if (!nm_device_create_and_realize (device, connection, parent, &error)) {
 			_LOGW (LOGD_DEVICE, "(%s) couldn't create the device: %s",
@@ -1158,6 +1764,66 @@ system_create_virtual_device (NMManager *self, NMConnection *connection)
 	return device;
 }
 
+/* Between virtual_devices_bulk_begin() and virtual_devices_bulk_end(),
+ * system_create_virtual_device() only queues the devices it can create
+ * with nm_device_create_and_realize_many(). The kernel links of all of them
+ * are then created with one pipelined batch of netlink requests, instead
+ * of one netlink round trip and cache lookup per device. That matters for
+ * profiles with thousands of VLANs on one trunk. */
+static void
+virtual_devices_bulk_begin (NMManager *self)
+{
+	NM_MANAGER_GET_PRIVATE (self)->create_bulk.depth++;
+}
+
+static void
+virtual_devices_bulk_end (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	g_return_if_fail (priv->create_bulk.depth > 0);
+
+	if (priv->create_bulk.depth > 1) {
+		priv->create_bulk.depth--;
+		return;
+	}
+
+	/* Creating the queued devices may queue more of them, for
+	 * connections that use one of them as parent. Keep the section
+	 * open until nothing is left. */
+	while (priv->create_bulk.pending->len) {
+		gs_unref_array GArray *pending = priv->create_bulk.pending;
+		guint i;
+
+		priv->create_bulk.pending = g_array_new (FALSE, FALSE, sizeof (NMDeviceCreateData));
+		g_hash_table_remove_all (priv->create_bulk.queued);
+
+		_LOGD (LOGD_DEVICE, "creating %u virtual interfaces", pending->len);
+		nm_device_create_and_realize_many (&g_array_index (pending, NMDeviceCreateData, 0),
+		                                   pending->len);
+
+		for (i = 0; i < pending->len; i++) {
+			NMDeviceCreateData *data = &g_array_index (pending, NMDeviceCreateData, i);
+
+			if (data->error) {
+				_LOGW (LOGD_DEVICE, "(%s) couldn't create the device: %s",
+				       nm_connection_get_id (data->connection), data->error->message);
+				g_clear_error (&data->error);
+				/* don't remove a device that another entry realized */
+				if (!nm_device_is_real (data->device))
+					remove_device (self, data->device, FALSE, TRUE);
+			} else
+				retry_connections_for_parent_device (self, data->device);
+
+			g_object_unref (data->device);
+			g_object_unref (data->connection);
+			g_clear_object (&data->parent);
+		}
+	}
+
+	priv->create_bulk.depth--;
+}
+
 static void
 retry_connections_for_parent_device (NMManager *self, NMDevice *device)
 {
@@ -1166,6 +1832,8 @@ retry_connections_for_parent_device (NMManager *self, NMDevice *device)
 
 	g_return_if_fail (device);
 
+	virtual_devices_bulk_begin (self);
+
 	connections = nm_settings_get_connections_sorted (priv->settings);
 	for (iter = connections; iter; iter = g_slist_next (iter)) {
 		NMConnection *candidate = iter->data;
@@ -1185,6 +1853,8 @@ retry_connections_for_parent_device (NMManager *self, NMDevice *device)
 	}
 
 	g_slist_free (connections);
+
+	virtual_devices_bulk_end (self);
 }
 
 static void
@@ -1193,6 +1863,9 @@ connection_changed (NMManager *self,
 {
 	NMDevice *device;
 
+	/* loads the device plugin for the type, if it was deferred */
+	nm_device_factory_manager_find_factory_for_connection (connection);
+
 	if (!nm_connection_is_virtual (connection))
 		return;
 
@@ -1531,6 +2204,55 @@ match_connection_filter (NMConnection *connection, gpointer user_data)
 	return nm_device_check_connection_compatible (NM_DEVICE (user_data), connection);
 }
 
+static int
+_cmp_assume_candidates (gconstpointer a, gconstpointer b)
+{
+	NMSettingConnection *s_con_a = nm_connection_get_setting_connection ((NMConnection *) a);
+	NMSettingConnection *s_con_b = nm_connection_get_setting_connection ((NMConnection *) b);
+	int c;
+
+	/* the most recently used first. */
+	c = nm_settings_sort_connections (b, a);
+	if (c)
+		return c;
+
+	/* This is the order the full list used to get: it was sorted with
+	 * the autoconnect connections first, and then reversed. */
+	if (   !nm_setting_connection_get_autoconnect (s_con_a)
+	    != !nm_setting_connection_get_autoconnect (s_con_b))
+		return nm_setting_connection_get_autoconnect (s_con_a) ? 1 : -1;
+	return 0;
+}
+
+/* Returns the activatable connections that could match @device, in the
+ * order nm_utils_match_connection() should try them. Only connections
+ * bound to the name of @device or to no interface at all are candidates;
+ * looking them up in the settings' interface index keeps assuming
+ * many devices from being quadratic in the number of connections.
+ *
+ * The index has no order, so the candidates are sorted explicitly, the
+ * same way the full list of connections was: by timestamp, then by
+ * autoconnect. Connections equal in both are tried in no particular order,
+ * also as before. */
+static GSList *
+get_assume_candidates (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_free NMSettingsConnection **candidates = NULL;
+	GSList *connections = NULL;
+	guint i;
+
+	candidates = nm_settings_get_connections_for_iface (priv->settings,
+	                                                    nm_device_get_iface (device),
+	                                                    NULL);
+	for (i = 0; candidates[i]; i++) {
+		if (!find_ac_for_connection (self, NM_CONNECTION (candidates[i])))
+			connections = g_slist_prepend (connections, candidates[i]);
+	}
+
+	return g_slist_sort (connections, _cmp_assume_candidates);
+}
+
 /**
  * get_existing_connection:
  * @manager: #NMManager instance
@@ -1544,7 +2266,7 @@ static NMSettingsConnection *
 get_existing_connection (NMManager *self, NMDevice *device, gboolean *out_generated)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	gs_free_slist GSList *connections = nm_manager_get_activatable_connections (self);
+	gs_free_slist GSList *connections = NULL;
 	NMConnection *connection = NULL;
 	NMSettingsConnection *matched;
 	NMSettingsConnection *added = NULL;
@@ -1594,7 +2316,7 @@ get_existing_connection (NMManager *self, NMDevice *device, gboolean *out_genera
 	 * When no configured connection matches the generated connection, we keep
 	 * the generated connection instead.
 	 */
-	connections = g_slist_reverse (g_slist_sort (connections, nm_settings_sort_connections));
+	connections = get_assume_candidates (self, device);
 	matched = NM_SETTINGS_CONNECTION (nm_utils_match_connection (connections,
 	                                                             connection,
 	                                                             nm_device_has_carrier (device),
@@ -1743,18 +2465,21 @@ device_ip_iface_changed (NMDevice *device,
                          NMManager *self)
 {
 	const char *ip_iface = nm_device_get_ip_iface (device);
-	GSList *iter;
+	NMDevice *const *devices;
+	guint i, len;
+
+	_device_index_update (self, device);
 
 	/* Remove NMDevice objects that are actually child devices of others,
 	 * when the other device finally knows its IP interface name.  For example,
 	 * remove the PPP interface that's a child of a WWAN device, since it's
 	 * not really a standalone NMDevice.
 	 */
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = iter->next) {
-		NMDevice *candidate = NM_DEVICE (iter->data);
+	devices = _device_idx_lookup_str (NM_MANAGER_GET_PRIVATE (self)->device_idx.by_iface, ip_iface, &len);
+	for (i = 0; i < len; i++) {
+		NMDevice *candidate = devices[i];
 
 		if (   candidate != device
-		    && g_strcmp0 (nm_device_get_iface (candidate), ip_iface) == 0
 		    && nm_device_is_real (candidate)) {
 			remove_device (self, candidate, FALSE, FALSE);
 			break;
@@ -1767,12 +2492,22 @@ device_iface_changed (NMDevice *device,
                       GParamSpec *pspec,
                       NMManager *self)
 {
+	_device_index_update (self, device);
+
 	/* Virtual connections may refer to the new device name as
 	 * parent device, retry to activate them.
 	 */
 	retry_connections_for_parent_device (self, device);
 }
 
+static void
+device_index_key_changed (NMDevice *device,
+                          GParamSpec *pspec,
+                          NMManager *self)
+{
+	_device_index_update (self, device);
+}
+
 
 static void
 device_realized (NMDevice *device,
@@ -1852,6 +2587,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	g_slist_free (remove);
 
 	priv->devices = g_slist_append (priv->devices, g_object_ref (device));
+	_device_index_update (self, device);
 
 	g_signal_connect (device, NM_DEVICE_STATE_CHANGED,
 	                  G_CALLBACK (manager_device_state_changed),
@@ -1877,6 +2613,14 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	                  G_CALLBACK (device_iface_changed),
 	                  self);
 
+	g_signal_connect (device, "notify::" NM_DEVICE_IFINDEX,
+	                  G_CALLBACK (device_index_key_changed),
+	                  self);
+
+	g_signal_connect (device, "notify::" NM_DEVICE_HW_ADDRESS,
+	                  G_CALLBACK (device_index_key_changed),
+	                  self);
+
 	g_signal_connect (device, "notify::" NM_DEVICE_REAL,
 	                  G_CALLBACK (device_realized),
 	                  self);
@@ -1909,6 +2653,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	                               manager_sleeping (self));
 
 	dbus_path = nm_exported_object_export (NM_EXPORTED_OBJECT (device));
+	_device_index_update (self, device);
 	_LOGI (LOGD_DEVICE, "(%s): new %s device (%s)", iface, type_desc, dbus_path);
 
 	nm_settings_device_added (priv->settings, device);
@@ -1994,22 +2739,25 @@ platform_link_added (NMManager *self,
 	NMDeviceFactory *factory;
 	NMDevice *device = NULL;
 	gboolean nm_plugin_missing = FALSE;
-	GSList *iter;
+	NMDevice *const *devices;
+	gs_free NMDevice **candidates = NULL;
+	guint i, len;
 
 	g_return_if_fail (ifindex > 0);
 
 	if (nm_manager_get_device_by_ifindex (self, ifindex))
 		return;
 
-	/* Let unrealized devices try to realize themselves with the link */
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = iter->next) {
-		NMDevice *candidate = iter->data;
+	/* Let unrealized devices try to realize themselves with the link. Realizing
+	 * re-indexes the device, so iterate over a copy of the bucket. */
+	devices = _device_idx_lookup_str (NM_MANAGER_GET_PRIVATE (self)->device_idx.by_iface, plink->name, &len);
+	if (len)
+		candidates = g_memdup (devices, sizeof (NMDevice *) * len);
+	for (i = 0; i < len; i++) {
+		NMDevice *candidate = candidates[i];
 		gboolean compatible = TRUE;
 		gs_free_error GError *error = NULL;
 
-		if (strcmp (nm_device_get_iface (candidate), plink->name))
-			continue;
-
 		if (nm_device_is_real (candidate)) {
 			/* Ignore the link added event since there's already a realized
 			 * device with the link's name.
@@ -2079,33 +2827,22 @@ platform_link_added (NMManager *self,
 	}
 }
 
-typedef struct {
-	NMManager *self;
-	int ifindex;
-} PlatformLinkCbData;
-
-static gboolean
-_platform_link_cb_idle (PlatformLinkCbData *data)
+static void
+_platform_link_handle (NMManager *self, int ifindex)
 {
-	NMManager *self = data->self;
 	const NMPlatformLink *l;
 
-	if (!self)
-		goto out;
-
-	g_object_remove_weak_pointer (G_OBJECT (self), (gpointer *) &data->self);
-
-	l = nm_platform_link_get (NM_PLATFORM_GET, data->ifindex);
+	l = nm_platform_link_get (NM_PLATFORM_GET, ifindex);
 	if (l) {
 		NMPlatformLink pllink;
 
 		pllink = *l; /* make a copy of the link instance */
-		platform_link_added (self, data->ifindex, &pllink);
+		platform_link_added (self, ifindex, &pllink);
 	} else {
 		NMDevice *device;
 		GError *error = NULL;
 
-		device = nm_manager_get_device_by_ifindex (self, data->ifindex);
+		device = nm_manager_get_device_by_ifindex (self, ifindex);
 		if (device) {
 			if (nm_device_is_software (device)) {
 				/* Our software devices stick around until their connection is removed */
@@ -2122,34 +2859,59 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 			}
 		}
 	}
+}
+
+static gboolean
+_platform_link_cb_idle (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_unref_array GArray *ifindexes = NULL;
+	guint i;
+
+	priv->platform_link_pending.idle_id = 0;
+
+	/* the handling might schedule new changes. Take the list. */
+	ifindexes = priv->platform_link_pending.ifindexes;
+	priv->platform_link_pending.ifindexes = NULL;
+	g_hash_table_remove_all (priv->platform_link_pending.idx);
+
+	for (i = 0; ifindexes && i < ifindexes->len; i++)
+		_platform_link_handle (self, g_array_index (ifindexes, int, i));
 
-out:
-	g_slice_free (PlatformLinkCbData, data);
 	return G_SOURCE_REMOVE;
 }
 
 static void
-platform_link_cb (NMPlatform *platform,
-                  NMPObjectType obj_type,
-                  int ifindex,
-                  NMPlatformLink *plink,
-                  NMPlatformSignalChangeType change_type,
-                  gpointer user_data)
-{
-	PlatformLinkCbData *data;
-
-	switch (change_type) {
-	case NM_PLATFORM_SIGNAL_ADDED:
-	case NM_PLATFORM_SIGNAL_REMOVED:
-		data = g_slice_new (PlatformLinkCbData);
-		data->self = NM_MANAGER (user_data);
-		data->ifindex = ifindex;
-		g_object_add_weak_pointer (G_OBJECT (data->self), (gpointer *) &data->self);
-		g_idle_add ((GSourceFunc) _platform_link_cb_idle, data);
-		break;
-	default:
-		break;
+platform_changes_batch_cb (NMPlatform *platform,
+                           const GArray *batch,
+                           gpointer user_data)
+{
+	NMManager *self = NM_MANAGER (user_data);
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	guint i;
+
+	/* Only additions and removals of links are interesting. Collect the affected
+	 * ifindexes and handle them all together on idle. The handler looks up the
+	 * current state from platform, so each ifindex needs handling only once. */
+	for (i = 0; i < batch->len; i++) {
+		const NMPlatformChangesBatchEntry *entry = &g_array_index (batch, NMPlatformChangesBatchEntry, i);
+
+		if (entry->obj_type != NMP_OBJECT_TYPE_LINK)
+			continue;
+		if (!NM_IN_SET (entry->change_type, NM_PLATFORM_SIGNAL_ADDED, NM_PLATFORM_SIGNAL_REMOVED))
+			continue;
+		if (g_hash_table_contains (priv->platform_link_pending.idx, GINT_TO_POINTER (entry->ifindex)))
+			continue;
+
+		if (!priv->platform_link_pending.ifindexes)
+			priv->platform_link_pending.ifindexes = g_array_new (FALSE, FALSE, sizeof (int));
+		g_array_append_val (priv->platform_link_pending.ifindexes, entry->ifindex);
+		g_hash_table_add (priv->platform_link_pending.idx, GINT_TO_POINTER (entry->ifindex));
 	}
+
+	if (   priv->platform_link_pending.ifindexes
+	    && !priv->platform_link_pending.idle_id)
+		priv->platform_link_pending.idle_id = g_idle_add ((GSourceFunc) _platform_link_cb_idle, self);
 }
 
 static void
@@ -2587,10 +3349,11 @@ find_slaves (NMManager *manager,
              NMDevice *device)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
-	GSList *all_connections, *iter;
+	GSList *candidates, *iter;
 	GSList *slaves = NULL;
 	NMSettingConnection *s_con;
 	const char *master;
+	GPtrArray *names;
 
 	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
 	g_assert (s_con);
@@ -2599,12 +3362,28 @@ find_slaves (NMManager *manager,
 	if (master != NULL)
 		return NULL;  /* connection is not master */
 
-	/* Search through all connections, not only inactive ones, because
-	 * even if a slave was already active, it might be deactivated during
-	 * master reactivation.
+	/* A slave names its master by the connection UUID or by the interface
+	 * name of the master device, see find_master(). Only look at the
+	 * connections that use one of the names of @connection. All of them,
+	 * not only inactive ones, because even if a slave was already active,
+	 * it might be deactivated during master reactivation.
 	 */
-	all_connections = nm_settings_get_connections_sorted (priv->settings);
-	for (iter = all_connections; iter; iter = iter->next) {
+	names = g_ptr_array_new ();
+	g_ptr_array_add (names, (gpointer) nm_settings_connection_get_uuid (connection));
+	if (nm_connection_get_interface_name (NM_CONNECTION (connection)))
+		g_ptr_array_add (names, (gpointer) nm_connection_get_interface_name (NM_CONNECTION (connection)));
+	if (device)
+		g_ptr_array_add (names, (gpointer) nm_device_get_iface (device));
+	for (iter = priv->devices; iter; iter = iter->next) {
+		if (nm_device_get_settings_connection (iter->data) == connection)
+			g_ptr_array_add (names, (gpointer) nm_device_get_iface (iter->data));
+	}
+	g_ptr_array_add (names, NULL);
+
+	candidates = nm_settings_get_connections_for_master (priv->settings, (const char *const*) names->pdata);
+	g_ptr_array_unref (names);
+
+	for (iter = candidates; iter; iter = iter->next) {
 		NMSettingsConnection *master_connection = NULL;
 		NMDevice *master_device = NULL;
 		NMConnection *candidate = iter->data;
@@ -2615,7 +3394,7 @@ find_slaves (NMManager *manager,
 			slaves = g_slist_prepend (slaves, candidate);
 		}
 	}
-	g_slist_free (all_connections);
+	g_slist_free (candidates);
 
 	return g_slist_reverse (slaves);
 }
@@ -3924,11 +4703,169 @@ device_sleep_cb (NMDevice *device,
 	}
 }
 
+/*****************************************************************************/
+
+/* Snapshots are only used for devices that become ready this long after
+ * waking up; later the normal autoconnect path decides. */
+#define RESUME_SNAPSHOT_TIMEOUT_MS 60000
+
+typedef struct {
+	NMSettingsConnection *connection;
+	char *dhcp4_address;
+	bool ready;
+} ResumeSnapshot;
+
+static void
+resume_snapshot_free (gpointer data)
+{
+	ResumeSnapshot *snapshot = data;
+
+	g_object_unref (snapshot->connection);
+	g_free (snapshot->dhcp4_address);
+	g_slice_free (ResumeSnapshot, snapshot);
+}
+
+static void
+resume_snapshot_take (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	NMSettingsConnection *connection;
+	NMDhcp4Config *dhcp4_config;
+	ResumeSnapshot *snapshot;
+
+	if (nm_device_get_state (device) != NM_DEVICE_STATE_ACTIVATED)
+		return;
+	connection = nm_device_get_settings_connection (device);
+	if (!connection)
+		return;
+
+	snapshot = g_slice_new0 (ResumeSnapshot);
+	snapshot->connection = g_object_ref (connection);
+	dhcp4_config = nm_device_get_dhcp4_config (device);
+	if (dhcp4_config)
+		snapshot->dhcp4_address = g_strdup (nm_dhcp4_config_get_option (dhcp4_config, "ip_address"));
+	g_hash_table_insert (priv->resume.snapshots, device, snapshot);
+
+	_LOGD (LOGD_SUSPEND, "sleep: remember connection '%s' on %s for fast resume",
+	       nm_settings_connection_get_id (connection),
+	       nm_device_get_iface (device));
+}
+
+static gboolean
+resume_activate_cb (gpointer user_data)
+{
+	NMManager *self = user_data;
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_unref_object NMAuthSubject *subject = NULL;
+	GHashTableIter iter;
+	NMDevice *device;
+	ResumeSnapshot *snapshot;
+
+	priv->resume.idle_id = 0;
+
+	g_hash_table_iter_init (&iter, priv->resume.snapshots);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &device, (gpointer *) &snapshot)) {
+		GError *error = NULL;
+
+		if (!snapshot->ready)
+			continue;
+
+		if (   nm_device_get_state (device) == NM_DEVICE_STATE_DISCONNECTED
+		    && !nm_device_get_act_request (device)
+		    && nm_device_autoconnect_allowed (device)
+		    && nm_settings_has_connection (priv->settings, snapshot->connection)) {
+			_LOGI (LOGD_SUSPEND, "wake: fast resume of connection '%s' on %s",
+			       nm_settings_connection_get_id (snapshot->connection),
+			       nm_device_get_iface (device));
+
+			if (!subject)
+				subject = nm_auth_subject_new_internal ();
+			nm_device_set_dhcp4_last_address (device, snapshot->dhcp4_address);
+			if (nm_manager_activate_connection (self, snapshot->connection, NULL,
+			                                    device, subject, &error))
+				g_hash_table_add (priv->resume.activating, device);
+			else {
+				_LOGD (LOGD_SUSPEND, "wake: fast resume on %s failed: %s",
+				       nm_device_get_iface (device), error->message);
+				nm_device_set_dhcp4_last_address (device, NULL);
+				g_clear_error (&error);
+			}
+		}
+		g_hash_table_iter_remove (&iter);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+resume_device_state_changed (NMManager *self,
+                             NMDevice *device,
+                             NMDeviceState new_state)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	ResumeSnapshot *snapshot;
+
+	switch (new_state) {
+	case NM_DEVICE_STATE_ACTIVATED:
+		if (g_hash_table_remove (priv->resume.activating, device)) {
+			g_hash_table_insert (priv->resume.timeline,
+			                     g_strdup (nm_device_get_iface (device)),
+			                     GUINT_TO_POINTER (nm_utils_get_monotonic_timestamp_ms () - priv->resume.wake_ts));
+			_notify (self, PROP_RESUME_TIMELINE);
+		}
+		break;
+	case NM_DEVICE_STATE_FAILED:
+		/* the background validation, i.e. the activation itself, failed.
+		 * The normal autoconnect path takes over. */
+		g_hash_table_remove (priv->resume.activating, device);
+		break;
+	case NM_DEVICE_STATE_DISCONNECTED:
+		g_hash_table_remove (priv->resume.activating, device);
+
+		if (manager_sleeping (self) || !priv->resume.wake_ts)
+			break;
+		snapshot = g_hash_table_lookup (priv->resume.snapshots, device);
+		if (!snapshot)
+			break;
+		if (nm_utils_get_monotonic_timestamp_ms () - priv->resume.wake_ts > RESUME_SNAPSHOT_TIMEOUT_MS) {
+			g_hash_table_remove (priv->resume.snapshots, device);
+			break;
+		}
+
+		/* Activate from an idle handler, like NMPolicy does, and not
+		 * from within the state change. NMPolicy's own check is queued
+		 * after this one. */
+		snapshot->ready = TRUE;
+		if (!priv->resume.idle_id)
+			priv->resume.idle_id = g_idle_add (resume_activate_cb, self);
+		break;
+	default:
+		break;
+	}
+}
+
+static GVariant *
+resume_timeline_to_variant (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	const char *iface;
+	gpointer ms;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+	g_hash_table_iter_init (&iter, priv->resume.timeline);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &iface, &ms))
+		g_variant_builder_add (&builder, "{su}", iface, (guint32) GPOINTER_TO_UINT (ms));
+	return g_variant_builder_end (&builder);
+}
+
 static void
 do_sleep_wake (NMManager *self, gboolean sleeping_changed)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	gboolean suspending, waking_from_suspend;
+	NMSettingsConnection *const*connections;
 	GSList *iter;
 
 	suspending = sleeping_changed && priv->sleeping;
@@ -3937,6 +4874,31 @@ do_sleep_wake (NMManager *self, gboolean sleeping_changed)
 	if (manager_sleeping (self)) {
 		_LOGI (LOGD_SUSPEND, "%s...", suspending ? "sleeping" : "disabling");
 
+		if (suspending) {
+			nm_clear_g_source (&priv->resume.idle_id);
+			g_hash_table_remove_all (priv->resume.snapshots);
+			g_hash_table_remove_all (priv->resume.activating);
+			priv->resume.wake_ts = 0;
+
+			/* the write-behind databases might not survive the suspend */
+			nm_settings_connection_flush_databases ();
+
+			/* whoever resumes the machine has to enter the secrets again */
+			connections = nm_settings_get_connections (priv->settings, NULL);
+			for (; *connections; connections++)
+				nm_settings_connection_clear_secrets_cache (*connections);
+
+			if (nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA,
+			                                      NM_CONFIG_KEYFILE_GROUP_MAIN,
+			                                      NM_CONFIG_KEYFILE_KEY_MAIN_FAST_RESUME,
+			                                      FALSE)) {
+				for (iter = priv->devices; iter; iter = iter->next) {
+					if (!nm_device_is_software (iter->data))
+						resume_snapshot_take (self, iter->data);
+				}
+			}
+		}
+
 		/* FIXME: are there still hardware devices that need to be disabled around
 		 * suspend/resume?
 		 */
@@ -3968,6 +4930,12 @@ do_sleep_wake (NMManager *self, gboolean sleeping_changed)
 		_LOGI (LOGD_SUSPEND, "%s...", waking_from_suspend ? "waking up" : "re-enabling");
 
 		if (waking_from_suspend) {
+			if (g_hash_table_size (priv->resume.snapshots)) {
+				priv->resume.wake_ts = nm_utils_get_monotonic_timestamp_ms ();
+				g_hash_table_remove_all (priv->resume.timeline);
+				_notify (self, PROP_RESUME_TIMELINE);
+			}
+
 			sleep_devices_clear (self);
 			/* Belatedly take down Wake-on-LAN devices; ideally we wouldn't have to do this
 			 * but for now it's the only way to make sure we re-check their connectivity.
@@ -4406,6 +5374,205 @@ impl_manager_get_logging (NMManager *manager,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_dump_log (NMManager *self,
+                       GDBusMethodInvocation *context)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_free char *log = NULL;
+	gulong caller_uid = G_MAXULONG;
+
+	if (!nm_bus_manager_get_caller_info (priv->dbus_mgr, context, NULL, &caller_uid, NULL)) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Failed to get request UID.");
+		return;
+	}
+
+	if (0 != caller_uid) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Permission denied");
+		return;
+	}
+
+	log = nm_logging_ring_dump ();
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(s)", log));
+}
+
+/* a transaction holds back autoconnect, so keep it short */
+#define TRANSACTION_TIMEOUT_DEFAULT 3
+#define TRANSACTION_TIMEOUT_MAX     5
+
+typedef struct {
+	NMManager *self;
+	guint id;
+	guint timeout_id;
+	guint watch_id;
+
+	/* for callers on the private socket, which have no bus name */
+	GDBusConnection *connection;
+	gulong closed_id;
+} Transaction;
+
+static void
+transaction_commit (Transaction *t, const char *reason)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (t->self);
+
+	_LOGD (LOGD_CORE, "transaction %u: commit (%s)", t->id, reason);
+
+	priv->transactions.list = g_slist_remove (priv->transactions.list, t);
+	nm_clear_g_source (&t->timeout_id);
+	if (t->watch_id)
+		g_bus_unwatch_name (t->watch_id);
+	if (t->connection) {
+		nm_clear_g_signal_handler (t->connection, &t->closed_id);
+		g_clear_object (&t->connection);
+	}
+	nm_policy_transaction_commit (priv->policy);
+	g_slice_free (Transaction, t);
+}
+
+static gboolean
+transaction_timeout_cb (gpointer user_data)
+{
+	Transaction *t = user_data;
+
+	t->timeout_id = 0;
+	transaction_commit (t, "timeout");
+	return G_SOURCE_REMOVE;
+}
+
+static void
+transaction_name_vanished_cb (GDBusConnection *connection,
+                              const char *name,
+                              gpointer user_data)
+{
+	transaction_commit (user_data, "owner left the bus");
+}
+
+static void
+transaction_connection_closed_cb (GDBusConnection *connection,
+                                  gboolean remote_peer_vanished,
+                                  GError *error,
+                                  gpointer user_data)
+{
+	transaction_commit (user_data, "connection closed");
+}
+
+static void
+impl_manager_begin_transaction (NMManager *self,
+                                GDBusMethodInvocation *context,
+                                guint32 timeout)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_free char *sender = NULL;
+	gulong caller_uid = G_MAXULONG;
+	Transaction *t;
+
+	if (!nm_bus_manager_get_caller_info (priv->dbus_mgr, context, &sender, &caller_uid, NULL)) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Failed to get request UID.");
+		return;
+	}
+
+	if (0 != caller_uid) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Permission denied");
+		return;
+	}
+
+	if (!timeout)
+		timeout = TRANSACTION_TIMEOUT_DEFAULT;
+	else if (timeout > TRANSACTION_TIMEOUT_MAX) {
+		_LOGD (LOGD_CORE, "transaction: limiting the timeout of %u seconds to %u",
+		       (guint) timeout, (guint) TRANSACTION_TIMEOUT_MAX);
+		timeout = TRANSACTION_TIMEOUT_MAX;
+	}
+
+	t = g_slice_new0 (Transaction);
+	t->self = self;
+	do {
+		t->id = ++priv->transactions.last_id;
+	} while (!t->id);
+	t->timeout_id = g_timeout_add_seconds (timeout, transaction_timeout_cb, t);
+
+	priv->transactions.list = g_slist_prepend (priv->transactions.list, t);
+	nm_policy_transaction_begin (priv->policy);
+	_LOGD (LOGD_CORE, "transaction %u: begin", t->id);
+
+	/* Commit the transaction when the caller goes away. Callers on the
+	 * private socket have no bus name, their connection closes instead. */
+	if (sender && sender[0] == ':') {
+		t->watch_id = g_bus_watch_name_on_connection (g_dbus_method_invocation_get_connection (context),
+		                                              sender,
+		                                              G_BUS_NAME_WATCHER_FLAGS_NONE,
+		                                              NULL,
+		                                              transaction_name_vanished_cb,
+		                                              t,
+		                                              NULL);
+	} else {
+		t->connection = g_object_ref (g_dbus_method_invocation_get_connection (context));
+		t->closed_id = g_signal_connect (t->connection, "closed",
+		                                 G_CALLBACK (transaction_connection_closed_cb), t);
+	}
+
+	g_dbus_method_invocation_return_value (context, g_variant_new ("(u)", t->id));
+}
+
+static void
+impl_manager_commit (NMManager *self,
+                     GDBusMethodInvocation *context,
+                     guint32 id)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GSList *iter;
+
+	for (iter = priv->transactions.list; iter; iter = iter->next) {
+		Transaction *t = iter->data;
+
+		if (t->id == id) {
+			transaction_commit (t, "requested");
+			g_dbus_method_invocation_return_value (context, NULL);
+			return;
+		}
+	}
+
+	g_dbus_method_invocation_return_error (context,
+	                                       NM_MANAGER_ERROR,
+	                                       NM_MANAGER_ERROR_FAILED,
+	                                       "No transaction %u", (guint) id);
+}
+
+static void
+impl_manager_get_state_snapshot (NMManager *self,
+                                 GDBusMethodInvocation *context,
+                                 guint32 flags)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	if (flags != 0) {
+		g_dbus_method_invocation_return_error (context,
+		                                       NM_MANAGER_ERROR,
+		                                       NM_MANAGER_ERROR_FAILED,
+		                                       "Unsupported flags 0x%x",
+		                                       (guint) flags);
+		return;
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(@a{oa{sa{sv}}})",
+	                                                      nm_bus_manager_get_managed_objects (priv->dbus_mgr)));
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -4496,13 +5663,14 @@ nm_manager_start (NMManager *self, GError **error)
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	GSList *iter, *connections;
 	guint i;
+	gint64 ts;
 
 	if (!nm_settings_start (priv->settings, error))
 		return FALSE;
 
 	g_signal_connect (NM_PLATFORM_GET,
-	                  NM_PLATFORM_SIGNAL_LINK_CHANGED,
-	                  G_CALLBACK (platform_link_cb),
+	                  NM_PLATFORM_SIGNAL_CHANGES_BATCH,
+	                  G_CALLBACK (platform_changes_batch_cb),
 	                  self);
 
 	/* Set initial radio enabled/disabled state */
@@ -4534,10 +5702,14 @@ nm_manager_start (NMManager *self, GError **error)
 	system_hostname_changed_cb (priv->settings, NULL, self);
 
 	/* Start device factories */
+	ts = nm_startup_profile_begin ();
 	nm_device_factory_manager_load_factories (_register_device_factory, self);
 	nm_device_factory_manager_for_each_factory (start_factory, NULL);
+	nm_startup_profile_end (ts, "device-factories-load", NULL);
 
+	ts = nm_startup_profile_begin ();
 	platform_query_devices (self);
+	nm_startup_profile_end (ts, "devices-realize", NULL);
 
 	/* Load VPN plugins */
 	priv->vpn_manager = g_object_ref (nm_vpn_manager_get ());
@@ -4546,10 +5718,14 @@ nm_manager_start (NMManager *self, GError **error)
 	 * connection-added signals thus devices have to be created manually.
 	 */
 	_LOGD (LOGD_CORE, "creating virtual devices...");
+	ts = nm_startup_profile_begin ();
 	connections = nm_settings_get_connections_sorted (priv->settings);
+	virtual_devices_bulk_begin (self);
 	for (iter = connections; iter; iter = iter->next)
 		connection_changed (self, NM_CONNECTION (iter->data));
+	virtual_devices_bulk_end (self);
 	g_slist_free (connections);
+	nm_startup_profile_end (ts, "virtual-devices-create", NULL);
 
 	priv->devices_inited = TRUE;
 
@@ -4809,6 +5985,9 @@ prop_set_auth_done_cb (NMAuthChain *chain,
 		/* ... but set the property on the @object itself. It would be correct to set the property
 		 * on the skeleton interface, but as it is now, the result is the same. */
 		g_object_set (object, pfd->glib_propname, value, NULL);
+	} else if (g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)) {
+		/* the same here */
+		g_object_set (object, pfd->glib_propname, g_variant_get_uint32 (value), NULL);
 	} else {
 		g_assert (g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN));
 		/* the same here */
@@ -4943,6 +6122,15 @@ prop_filter (GDBusConnection *connection,
 		} else
 			return message;
 		interface_type = NMDBUS_TYPE_DEVICE_SKELETON;
+	} else if (!strcmp (propiface, NM_DBUS_INTERFACE_DEVICE_STATISTICS)) {
+		if (!strcmp (propname, "RefreshRateMs")) {
+			glib_propname = NM_DEVICE_STATISTICS_REFRESH_RATE_MS;
+			permission = NM_AUTH_PERMISSION_NETWORK_CONTROL;
+			audit_op = NM_AUDIT_OP_STATISTICS;
+			expected_type = G_VARIANT_TYPE_UINT32;
+		} else
+			return message;
+		interface_type = NMDBUS_TYPE_DEVICE_STATISTICS_SKELETON;
 	} else
 		return message;
 
@@ -4965,6 +6153,9 @@ prop_filter (GDBusConnection *connection,
 	if (g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN)) {
 		pfd->audit_prop_value = g_strdup_printf ("%s:%d", pfd->glib_propname,
 		                                         g_variant_get_boolean (value));
+	} else if (g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)) {
+		pfd->audit_prop_value = g_strdup_printf ("%s:%u", pfd->glib_propname,
+		                                         g_variant_get_uint32 (value));
 	} else
 		pfd->audit_prop_value = g_strdup (pfd->glib_propname);
 
@@ -5252,6 +6443,18 @@ constructed (GObject *object)
 	                                          nm_config_data_get_connectivity_response (config_data));
 	g_signal_connect (priv->connectivity, "notify::" NM_CONNECTIVITY_STATE,
 	                  G_CALLBACK (connectivity_changed), self);
+	priv->connectivity_per_device = nm_config_data_get_value_boolean (config_data,
+	                                                                  NM_CONFIG_KEYFILE_GROUP_CONNECTIVITY,
+	                                                                  NM_CONFIG_KEYFILE_KEY_CONNECTIVITY_PER_DEVICE,
+	                                                                  FALSE);
+
+	priv->activation_scheduler = g_object_ref (nm_activation_scheduler_get ());
+	_activation_scheduler_update_config (self, config_data);
+	_dbus_notify_update_config (config_data);
+	g_signal_connect (priv->activation_scheduler, "notify::" NM_ACTIVATION_SCHEDULER_QUEUE_DEPTH,
+	                  G_CALLBACK (activation_scheduler_changed), self);
+	g_signal_connect (priv->activation_scheduler, "notify::" NM_ACTIVATION_SCHEDULER_WAIT_TIME,
+	                  G_CALLBACK (activation_scheduler_changed), self);
 
 	state = nm_config_state_get (priv->config);
 
@@ -5282,6 +6485,21 @@ nm_manager_init (NMManager *self)
 	guint i;
 	GFile *file;
 
+	priv->platform_link_pending.idx = g_hash_table_new (NULL, NULL);
+	priv->create_bulk.pending = g_array_new (FALSE, FALSE, sizeof (NMDeviceCreateData));
+	priv->create_bulk.queued = g_hash_table_new (NULL, NULL);
+
+	priv->device_idx.by_ifindex = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_ptr_array_unref);
+	priv->device_idx.by_path = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) nm_intern_str_unref, (GDestroyNotify) g_ptr_array_unref);
+	priv->device_idx.by_iface = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) nm_intern_str_unref, (GDestroyNotify) g_ptr_array_unref);
+	priv->device_idx.by_ip_iface = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) nm_intern_str_unref, (GDestroyNotify) g_ptr_array_unref);
+	priv->device_idx.by_hw_addr = g_hash_table_new_full (g_bytes_hash, g_bytes_equal, (GDestroyNotify) g_bytes_unref, (GDestroyNotify) g_ptr_array_unref);
+	priv->device_idx.keys = g_hash_table_new_full (NULL, NULL, NULL, _device_index_keys_free);
+	priv->ac_idx.by_settings_connection = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_ptr_array_unref);
+	priv->ac_idx.by_path = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) nm_intern_str_unref, (GDestroyNotify) g_ptr_array_unref);
+	priv->ac_idx.by_device = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_ptr_array_unref);
+	priv->ac_idx.keys = g_hash_table_new_full (NULL, NULL, NULL, _ac_index_keys_free);
+
 	/* Initialize rfkill structures and states */
 	memset (priv->radio_states, 0, sizeof (priv->radio_states));
 
@@ -5312,6 +6530,9 @@ nm_manager_init (NMManager *self)
 	                  G_CALLBACK (dbus_connection_changed_cb),
 	                  self);
 
+	/* Offer the whole API to root clients without the bus daemon in between */
+	nm_bus_manager_private_server_register (priv->dbus_mgr, PRIV_SOCK_PATH, PRIV_SOCK_TAG, TRUE);
+
 	/* sleep/wake handling */
 	priv->sleep_monitor = nm_sleep_monitor_new ();
 	g_signal_connect (priv->sleep_monitor, NM_SLEEP_MONITOR_SLEEPING,
@@ -5347,6 +6568,12 @@ nm_manager_init (NMManager *self)
 
 	priv->metered = NM_METERED_UNKNOWN;
 	priv->sleep_devices = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	priv->resume.snapshots = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, resume_snapshot_free);
+	priv->resume.activating = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->resume.timeline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->connectivity_probes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+	                                                   (GDestroyNotify) nm_connectivity_probe_free);
 }
 
 static gboolean
@@ -5440,6 +6667,15 @@ get_property (GObject *object, guint prop_id,
 	case PROP_ALL_DEVICES:
 		nm_utils_g_value_set_object_path_array (value, priv->devices, NULL, NULL);
 		break;
+	case PROP_ACTIVATION_QUEUE_DEPTH:
+		g_value_set_uint (value, nm_activation_scheduler_get_queue_depth (priv->activation_scheduler));
+		break;
+	case PROP_ACTIVATION_WAIT_TIME:
+		g_value_set_uint (value, nm_activation_scheduler_get_wait_time (priv->activation_scheduler));
+		break;
+	case PROP_RESUME_TIMELINE:
+		g_value_take_variant (value, resume_timeline_to_variant (self));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -5520,13 +6756,21 @@ dispose (GObject *object)
 		g_signal_handlers_disconnect_by_func (priv->config, _config_changed_cb, manager);
 		g_clear_object (&priv->config);
 	}
+	g_clear_pointer (&priv->connectivity_probes, g_hash_table_unref);
 	if (priv->connectivity) {
 		g_signal_handlers_disconnect_by_func (priv->connectivity, connectivity_changed, manager);
 		g_clear_object (&priv->connectivity);
 	}
+	if (priv->activation_scheduler) {
+		g_signal_handlers_disconnect_by_func (priv->activation_scheduler, activation_scheduler_changed, manager);
+		g_clear_object (&priv->activation_scheduler);
+	}
 
 	g_free (priv->hostname);
 
+	while (priv->transactions.list)
+		transaction_commit (priv->transactions.list->data, "shutdown");
+
 	if (priv->policy) {
 		g_signal_handlers_disconnect_by_func (priv->policy, policy_default_device_changed, manager);
 		g_signal_handlers_disconnect_by_func (priv->policy, policy_activating_device_changed, manager);
@@ -5554,6 +6798,11 @@ dispose (GObject *object)
 	sleep_devices_clear (manager);
 	g_clear_pointer (&priv->sleep_devices, g_hash_table_unref);
 
+	nm_clear_g_source (&priv->resume.idle_id);
+	g_clear_pointer (&priv->resume.snapshots, g_hash_table_unref);
+	g_clear_pointer (&priv->resume.activating, g_hash_table_unref);
+	g_clear_pointer (&priv->resume.timeline, g_hash_table_unref);
+
 	if (priv->sleep_monitor) {
 		g_signal_handlers_disconnect_by_func (priv->sleep_monitor, sleeping_cb, manager);
 		g_clear_object (&priv->sleep_monitor);
@@ -5577,6 +6826,25 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timestamp_update_id);
 
+	if (nm_platform_try_get ())
+		g_signal_handlers_disconnect_by_func (nm_platform_try_get (), G_CALLBACK (platform_changes_batch_cb), manager);
+	nm_clear_g_source (&priv->platform_link_pending.idle_id);
+	g_clear_pointer (&priv->platform_link_pending.ifindexes, g_array_unref);
+	g_clear_pointer (&priv->platform_link_pending.idx, g_hash_table_unref);
+	g_clear_pointer (&priv->create_bulk.pending, g_array_unref);
+	g_clear_pointer (&priv->create_bulk.queued, g_hash_table_unref);
+
+	g_clear_pointer (&priv->device_idx.by_ifindex, g_hash_table_unref);
+	g_clear_pointer (&priv->device_idx.by_path, g_hash_table_unref);
+	g_clear_pointer (&priv->device_idx.by_iface, g_hash_table_unref);
+	g_clear_pointer (&priv->device_idx.by_ip_iface, g_hash_table_unref);
+	g_clear_pointer (&priv->device_idx.by_hw_addr, g_hash_table_unref);
+	g_clear_pointer (&priv->device_idx.keys, g_hash_table_unref);
+	g_clear_pointer (&priv->ac_idx.by_settings_connection, g_hash_table_unref);
+	g_clear_pointer (&priv->ac_idx.by_path, g_hash_table_unref);
+	g_clear_pointer (&priv->ac_idx.by_device, g_hash_table_unref);
+	g_clear_pointer (&priv->ac_idx.keys, g_hash_table_unref);
+
 	G_OBJECT_CLASS (nm_manager_parent_class)->dispose (object);
 }
 
@@ -5745,6 +7013,42 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                        G_PARAM_READABLE |
 	                        G_PARAM_STATIC_STRINGS);
 
+	/**
+	 * NMManager:activation-queue-depth:
+	 *
+	 * The number of devices waiting for a free slot to start IP configuration.
+	 **/
+	obj_properties[PROP_ACTIVATION_QUEUE_DEPTH] =
+	    g_param_spec_uint (NM_MANAGER_ACTIVATION_QUEUE_DEPTH, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMManager:activation-wait-time:
+	 *
+	 * How long, in milliseconds, the device that most recently started IP
+	 * configuration had to wait for a free slot.
+	 **/
+	obj_properties[PROP_ACTIVATION_WAIT_TIME] =
+	    g_param_spec_uint (NM_MANAGER_ACTIVATION_WAIT_TIME, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMManager:resume-timeline:
+	 *
+	 * For every device re-activated by the fast resume, the number of
+	 * milliseconds from the last wake-up until it was activated again.
+	 **/
+	obj_properties[PROP_RESUME_TIMELINE] =
+	    g_param_spec_variant (NM_MANAGER_RESUME_TIMELINE, "", "",
+	                          G_VARIANT_TYPE ("a{su}"),
+	                          NULL,
+	                          G_PARAM_READABLE |
+	                          G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	/* signals */
@@ -5829,6 +7133,10 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                                        "GetPermissions", impl_manager_get_permissions,
 	                                        "SetLogging", impl_manager_set_logging,
 	                                        "GetLogging", impl_manager_get_logging,
+	                                        "DumpLog", impl_manager_dump_log,
+	                                        "GetStateSnapshot", impl_manager_get_state_snapshot,
+	                                        "BeginTransaction", impl_manager_begin_transaction,
+	                                        "Commit", impl_manager_commit,
 	                                        "CheckConnectivity", impl_manager_check_connectivity,
 	                                        "state", impl_manager_get_state,
 	                                        NULL);
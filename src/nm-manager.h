@@ -51,6 +51,9 @@
 #define NM_MANAGER_METERED "metered"
 #define NM_MANAGER_GLOBAL_DNS_CONFIGURATION "global-dns-configuration"
 #define NM_MANAGER_ALL_DEVICES "all-devices"
+#define NM_MANAGER_ACTIVATION_QUEUE_DEPTH "activation-queue-depth"
+#define NM_MANAGER_ACTIVATION_WAIT_TIME "activation-wait-time"
+#define NM_MANAGER_RESUME_TIMELINE "resume-timeline"
 
 /* Not exported */
 #define NM_MANAGER_HOSTNAME "hostname"
@@ -83,7 +86,15 @@ gboolean      nm_manager_start                         (NMManager *manager,
 void          nm_manager_stop                          (NMManager *manager);
 NMState       nm_manager_get_state                     (NMManager *manager);
 const GSList *nm_manager_get_active_connections        (NMManager *manager);
+NMActiveConnection *const *nm_manager_get_active_connections_for_connection (NMManager *manager,
+                                                                             NMSettingsConnection *connection,
+                                                                             guint *out_len);
+NMActiveConnection *const *nm_manager_get_active_connections_for_device (NMManager *manager,
+                                                                         NMDevice *device,
+                                                                         guint *out_len);
 GSList *      nm_manager_get_activatable_connections   (NMManager *manager);
+gboolean      nm_manager_connection_is_activatable     (NMManager *manager,
+                                                        NMSettingsConnection *connection);
 
 /* Device handling */
 
@@ -24,79 +24,376 @@
 
 #include <string.h>
 
+/* NMMultiIndex keeps two open-addressing tables with linear probing:
+ *
+ *  - @groups maps an id to its Group, which holds the values for that id
+ *    in a NULL terminated array. That array is returned directly by
+ *    nm_multi_index_lookup().
+ *
+ *  - @positions maps a (group, value) pair to the position of the value
+ *    inside the array of the group, so that a value can be found and
+ *    removed from large groups in O(1). Removal swaps the last value into
+ *    the hole.
+ *
+ * Most groups only have a few values. These are stored inline in the
+ * Group and searched linearly, without entries in @positions. A group
+ * moves its values to the heap when it outgrows the inline storage and
+ * moves them back once it shrank to half of it.
+ *
+ * Deletion uses backward shifting, so there are no tombstones and a
+ * lookup always ends at the first empty slot.
+ */
+
+#define GROUP_INLINE_LEN 4
+
+#define TABLE_MIN_SIZE 8
+
+typedef struct {
+	NMMultiIndexId *id;
+	guint hash;
+	guint len;
+
+	/* the NULL terminated array of the values. For small groups this points
+	 * to @values_inline, otherwise it is allocated with @alloc elements. */
+	gpointer *values;
+	guint alloc;
+
+	gpointer values_inline[GROUP_INLINE_LEN + 1];
+} Group;
+
+typedef struct {
+	guint hash;
+	Group *group;
+} GroupSlot;
+
+typedef struct {
+	const Group *group;
+	gconstpointer value;
+	guint pos;
+} PositionSlot;
+
 struct NMMultiIndex {
+	NMMultiIndexFuncHash hash_fcn;
 	NMMultiIndexFuncEqual equal_fcn;
 	NMMultiIndexFuncClone clone_fcn;
-	GHashTable *hash;
+	NMMultiIndexFuncDestroy destroy_fcn;
+
+	/* both tables have a power of two size and are at most half full. */
+	GroupSlot *groups;
+	guint groups_size;
+	guint groups_len;
+
+	PositionSlot *positions;
+	guint positions_size;
+	guint positions_len;
 };
 
-typedef struct {
-	/* when storing the first item for a multi-index id, we don't yet create
-	 * the hashtable @index. Instead we store it inplace to @value0. Note that
-	 * &values_data->value0 is a NULL terminated array with one item that is
-	 * suitable to be returned directly from nm_multi_index_lookup(). */
-	union {
-		gpointer value0;
-		gpointer *values;
-	};
-	GHashTable *index;
-} ValuesData;
+/******************************************************************************************/
+
+static inline guint
+_hash_mix (guint64 h)
+{
+	h ^= h >> 33;
+	h *= G_GUINT64_CONSTANT (0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	return (guint) h;
+}
+
+static inline guint
+_position_hash (const Group *group, gconstpointer value)
+{
+	return _hash_mix (  ((guint64) (gsize) group * G_GUINT64_CONSTANT (0x9e3779b97f4a7c15))
+	                  ^ (guint64) (gsize) value);
+}
+
+/* whether the slot @j, whose entry would ideally live at @k, may be moved
+ * into the hole @i, i.e. whether @k is not cyclically in (i, j]. */
+static inline gboolean
+_slot_can_shift (guint i, guint j, guint k)
+{
+	if (i <= j)
+		return k <= i || k > j;
+	return k <= i && k > j;
+}
+
+static inline gboolean
+_group_is_inline (const Group *group)
+{
+	return group->values == group->values_inline;
+}
 
 /******************************************************************************************/
 
+static GroupSlot *
+_groups_lookup (const NMMultiIndex *index, const NMMultiIndexId *id, guint hash)
+{
+	guint mask, i;
+
+	if (!index->groups_len)
+		return NULL;
+
+	mask = index->groups_size - 1;
+	for (i = hash & mask; index->groups[i].group; i = (i + 1) & mask) {
+		if (   index->groups[i].hash == hash
+		    && index->equal_fcn (index->groups[i].group->id, id))
+			return &index->groups[i];
+	}
+	return NULL;
+}
+
+static void
+_groups_resize (NMMultiIndex *index, guint size)
+{
+	GroupSlot *old = index->groups;
+	guint old_size = index->groups_size;
+	guint mask = size - 1;
+	guint i, j;
+
+	nm_assert (size >= TABLE_MIN_SIZE && (size & mask) == 0);
+	nm_assert (index->groups_len * 2 < size);
+
+	index->groups = g_new0 (GroupSlot, size);
+	index->groups_size = size;
+
+	for (i = 0; i < old_size; i++) {
+		if (!old[i].group)
+			continue;
+		for (j = old[i].hash & mask; index->groups[j].group; j = (j + 1) & mask)
+			;
+		index->groups[j] = old[i];
+	}
+	g_free (old);
+}
+
+static void
+_groups_insert (NMMultiIndex *index, Group *group)
+{
+	guint mask, i;
+
+	if ((index->groups_len + 1) * 2 > index->groups_size)
+		_groups_resize (index, MAX (index->groups_size * 2, TABLE_MIN_SIZE));
+
+	mask = index->groups_size - 1;
+	for (i = group->hash & mask; index->groups[i].group; i = (i + 1) & mask)
+		;
+	index->groups[i].hash = group->hash;
+	index->groups[i].group = group;
+	index->groups_len++;
+}
+
+static void
+_groups_remove_slot (NMMultiIndex *index, GroupSlot *slot)
+{
+	guint mask = index->groups_size - 1;
+	guint i, j;
+
+	i = slot - index->groups;
+	for (j = (i + 1) & mask; index->groups[j].group; j = (j + 1) & mask) {
+		if (_slot_can_shift (i, j, index->groups[j].hash & mask)) {
+			index->groups[i] = index->groups[j];
+			i = j;
+		}
+	}
+	index->groups[i].group = NULL;
+	index->groups_len--;
+
+	if (   index->groups_size > TABLE_MIN_SIZE
+	    && index->groups_len * 8 < index->groups_size)
+		_groups_resize (index, index->groups_size / 2);
+}
+
+/******************************************************************************************/
+
+static PositionSlot *
+_positions_lookup (const NMMultiIndex *index, const Group *group, gconstpointer value)
+{
+	guint mask, i;
+
+	if (!index->positions_len)
+		return NULL;
+
+	mask = index->positions_size - 1;
+	for (i = _position_hash (group, value) & mask; index->positions[i].value; i = (i + 1) & mask) {
+		if (   index->positions[i].value == value
+		    && index->positions[i].group == group)
+			return &index->positions[i];
+	}
+	return NULL;
+}
+
+static void
+_positions_resize (NMMultiIndex *index, guint size)
+{
+	PositionSlot *old = index->positions;
+	guint old_size = index->positions_size;
+	guint mask = size - 1;
+	guint i, j;
+
+	nm_assert (size >= TABLE_MIN_SIZE && (size & mask) == 0);
+	nm_assert (index->positions_len * 2 < size);
+
+	index->positions = g_new0 (PositionSlot, size);
+	index->positions_size = size;
+
+	for (i = 0; i < old_size; i++) {
+		if (!old[i].value)
+			continue;
+		for (j = _position_hash (old[i].group, old[i].value) & mask; index->positions[j].value; j = (j + 1) & mask)
+			;
+		index->positions[j] = old[i];
+	}
+	g_free (old);
+}
+
 static void
-_values_data_destroy (ValuesData *values_data)
+_positions_insert (NMMultiIndex *index, const Group *group, gconstpointer value, guint pos)
 {
-	if (values_data->index) {
-		g_free (values_data->values);
-		g_hash_table_unref (values_data->index);
+	guint mask, i;
+
+	if ((index->positions_len + 1) * 2 > index->positions_size)
+		_positions_resize (index, MAX (index->positions_size * 2, TABLE_MIN_SIZE));
+
+	mask = index->positions_size - 1;
+	for (i = _position_hash (group, value) & mask; index->positions[i].value; i = (i + 1) & mask)
+		;
+	index->positions[i].group = group;
+	index->positions[i].value = value;
+	index->positions[i].pos = pos;
+	index->positions_len++;
+}
+
+static void
+_positions_remove (NMMultiIndex *index, const Group *group, gconstpointer value)
+{
+	PositionSlot *slot;
+	guint mask = index->positions_size - 1;
+	guint i, j;
+
+	slot = _positions_lookup (index, group, value);
+	if (!slot)
+		g_return_if_reached ();
+
+	i = slot - index->positions;
+	for (j = (i + 1) & mask; index->positions[j].value; j = (j + 1) & mask) {
+		if (_slot_can_shift (i, j, _position_hash (index->positions[j].group, index->positions[j].value) & mask)) {
+			index->positions[i] = index->positions[j];
+			i = j;
+		}
 	}
-	g_slice_free (ValuesData, values_data);
+	index->positions[i].value = NULL;
+	index->positions[i].group = NULL;
+	index->positions_len--;
+
+	if (   index->positions_size > TABLE_MIN_SIZE
+	    && index->positions_len * 8 < index->positions_size)
+		_positions_resize (index, index->positions_size / 2);
+}
+
+/******************************************************************************************/
+
+static Group *
+_group_lookup (const NMMultiIndex *index, const NMMultiIndexId *id)
+{
+	GroupSlot *slot;
+
+	slot = _groups_lookup (index, id, _hash_mix (index->hash_fcn (id)));
+	return slot ? slot->group : NULL;
 }
 
 static gboolean
-_values_data_contains (ValuesData *values_data, gconstpointer value)
+_group_find (const NMMultiIndex *index, const Group *group, gconstpointer value, guint *out_pos)
 {
-	return values_data->index
-	       ? g_hash_table_contains (values_data->index, value)
-	       : value == values_data->value0;
+	PositionSlot *slot;
+	guint i;
+
+	if (_group_is_inline (group)) {
+		for (i = 0; i < group->len; i++) {
+			if (group->values[i] == value) {
+				NM_SET_OUT (out_pos, i);
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
+
+	slot = _positions_lookup (index, group, value);
+	if (!slot)
+		return FALSE;
+	nm_assert (group->values[slot->pos] == value);
+	NM_SET_OUT (out_pos, slot->pos);
+	return TRUE;
 }
 
 static void
-_values_data_get_data (ValuesData *values_data,
-                       void *const**out_data,
-                       guint *out_len)
+_group_append (NMMultiIndex *index, Group *group, gconstpointer value)
 {
-	guint i, len;
-	gpointer *values;
-	GHashTableIter iter;
+	guint i;
 
-	nm_assert (values_data);
+	if (_group_is_inline (group)) {
+		if (group->len < GROUP_INLINE_LEN) {
+			group->values[group->len++] = (gpointer) value;
+			group->values[group->len] = NULL;
+			return;
+		}
 
-	if (!values_data->index) {
-		NM_SET_OUT (out_data, &values_data->value0);
-		NM_SET_OUT (out_len, 1);
-		return;
+		/* the group outgrows the inline storage. Move it to the heap and
+		 * start tracking the positions of its values. */
+		group->alloc = (GROUP_INLINE_LEN + 1) * 2;
+		group->values = g_new (gpointer, group->alloc);
+		memcpy (group->values, group->values_inline, sizeof (gpointer) * group->len);
+		for (i = 0; i < group->len; i++)
+			_positions_insert (index, group, group->values[i], i);
+	} else if (group->len + 1 >= group->alloc) {
+		group->alloc *= 2;
+		group->values = g_renew (gpointer, group->values, group->alloc);
 	}
 
-	nm_assert (values_data->index && g_hash_table_size (values_data->index) > 0);
+	_positions_insert (index, group, value, group->len);
+	group->values[group->len++] = (gpointer) value;
+	group->values[group->len] = NULL;
+}
 
-	if (!values_data->values) {
-		len = g_hash_table_size (values_data->index);
-		values = g_new (gpointer, len + 1);
+static void
+_group_remove_at (NMMultiIndex *index, Group *group, guint pos)
+{
+	guint last = group->len - 1;
+	guint i;
 
-		g_hash_table_iter_init (&iter, values_data->index);
-		for (i = 0; g_hash_table_iter_next (&iter, &values[i], NULL); i++)
-			nm_assert (i < len);
-		nm_assert (i == len);
-		values[i] = NULL;
+	nm_assert (pos < group->len);
 
-		values_data->values = values;
-		NM_SET_OUT (out_len, len);
-	} else if (out_len)
-		NM_SET_OUT (out_len, g_hash_table_size (values_data->index));
+	if (!_group_is_inline (group)) {
+		_positions_remove (index, group, group->values[pos]);
+		if (pos != last) {
+			PositionSlot *slot;
 
-	NM_SET_OUT (out_data, values_data->values);
+			slot = _positions_lookup (index, group, group->values[last]);
+			nm_assert (slot && slot->pos == last);
+			slot->pos = pos;
+		}
+	}
+
+	group->values[pos] = group->values[last];
+	group->values[last] = NULL;
+	group->len = last;
+
+	if (   !_group_is_inline (group)
+	    && group->len <= GROUP_INLINE_LEN / 2) {
+		for (i = 0; i < group->len; i++)
+			_positions_remove (index, group, group->values[i]);
+		memcpy (group->values_inline, group->values, sizeof (gpointer) * (group->len + 1));
+		g_free (group->values);
+		group->values = group->values_inline;
+		group->alloc = 0;
+	}
+}
+
+static void
+_group_free (NMMultiIndex *index, Group *group)
+{
+	if (!_group_is_inline (group))
+		g_free (group->values);
+	index->destroy_fcn (group->id);
+	g_slice_free (Group, group);
 }
 
 /******************************************************************************************/
@@ -116,20 +413,18 @@ nm_multi_index_lookup (const NMMultiIndex *index,
                        const NMMultiIndexId *id,
                        guint *out_len)
 {
-	ValuesData *values_data;
-	void *const*values;
+	Group *group;
 
 	g_return_val_if_fail (index, NULL);
 	g_return_val_if_fail (id, NULL);
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data) {
-		if (out_len)
-			*out_len = 0;
+	group = _group_lookup (index, id);
+	if (!group) {
+		NM_SET_OUT (out_len, 0);
 		return NULL;
 	}
-	_values_data_get_data (values_data, &values, out_len);
-	return values;
+	NM_SET_OUT (out_len, group->len);
+	return group->values;
 }
 
 gboolean
@@ -137,39 +432,38 @@ nm_multi_index_contains (const NMMultiIndex *index,
                          const NMMultiIndexId *id,
                          gconstpointer value)
 {
-	ValuesData *values_data;
+	Group *group;
 
 	g_return_val_if_fail (index, FALSE);
 	g_return_val_if_fail (id, FALSE);
 	g_return_val_if_fail (value, FALSE);
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	return values_data && _values_data_contains (values_data, value);
+	group = _group_lookup (index, id);
+	return group && _group_find (index, group, value, NULL);
 }
 
 const NMMultiIndexId *
 nm_multi_index_lookup_first_by_value (const NMMultiIndex *index,
                                       gconstpointer value)
 {
-	GHashTableIter iter;
-	const NMMultiIndexId *id;
-	ValuesData *values_data;
+	guint i;
 
 	g_return_val_if_fail (index, NULL);
 	g_return_val_if_fail (value, NULL);
 
-	/* reverse-lookup needs to iterate over all hash tables. It should
-	 * still be fairly quick, if the number of hash tables is small.
+	/* reverse-lookup needs to iterate over all groups. It should
+	 * still be fairly quick, if the number of groups is small.
 	 * There is no O(1) reverse lookup implemented, because this access
 	 * pattern is not what NMMultiIndex is here for.
 	 * You are supposed to use NMMultiIndex by always knowing which @id
 	 * a @value has.
 	 */
 
-	g_hash_table_iter_init (&iter, index->hash);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &values_data)) {
-		if (_values_data_contains (values_data, value))
-			return id;
+	for (i = 0; i < index->groups_size; i++) {
+		Group *group = index->groups[i].group;
+
+		if (group && _group_find (index, group, value, NULL))
+			return group->id;
 	}
 	return NULL;
 }
@@ -180,21 +474,16 @@ nm_multi_index_foreach (const NMMultiIndex *index,
                         NMMultiIndexFuncForeach foreach_func,
                         gpointer user_data)
 {
-	GHashTableIter iter;
+	NMMultiIndexIter iter;
 	const NMMultiIndexId *id;
-	ValuesData *values_data;
-	guint len;
 	void *const*values;
+	guint len;
 
 	g_return_if_fail (index);
 	g_return_if_fail (foreach_func);
 
-	g_hash_table_iter_init (&iter, index->hash);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &values_data)) {
-		if (value && !_values_data_contains (values_data, value))
-			continue;
-
-		_values_data_get_data (values_data, &values, &len);
+	nm_multi_index_iter_init (&iter, index, value);
+	while (nm_multi_index_iter_next (&iter, &id, &values, &len)) {
 		if (!foreach_func (id, values, len, user_data))
 			return;
 	}
@@ -208,9 +497,9 @@ nm_multi_index_iter_init (NMMultiIndexIter *iter,
 	g_return_if_fail (index);
 	g_return_if_fail (iter);
 
-	g_hash_table_iter_init (&iter->_iter, index->hash);
 	iter->_index = index;
 	iter->_value = value;
+	iter->_pos = 0;
 }
 
 gboolean
@@ -219,20 +508,24 @@ nm_multi_index_iter_next (NMMultiIndexIter *iter,
                           void *const**out_values,
                           guint *out_len)
 {
-	const NMMultiIndexId *id;
-	ValuesData *values_data;
+	const NMMultiIndex *index;
+	Group *group;
 
 	g_return_val_if_fail (iter, FALSE);
 
-	while (g_hash_table_iter_next (&iter->_iter, (gpointer *) &id, (gpointer *) &values_data)) {
-		if (   !iter->_value
-		    || _values_data_contains (values_data, iter->_value)) {
-			if (out_values || out_len)
-				_values_data_get_data (values_data, out_values, out_len);
-			if (out_id)
-				*out_id = id;
-			return TRUE;
-		}
+	index = iter->_index;
+	while (iter->_pos < index->groups_size) {
+		group = index->groups[iter->_pos++].group;
+		if (!group)
+			continue;
+		if (   iter->_value
+		    && !_group_find (index, group, iter->_value, NULL))
+			continue;
+
+		NM_SET_OUT (out_values, group->values);
+		NM_SET_OUT (out_len, group->len);
+		NM_SET_OUT (out_id, group->id);
+		return TRUE;
 	}
 	return FALSE;
 }
@@ -244,22 +537,14 @@ nm_multi_index_id_iter_init (NMMultiIndexIdIter *iter,
                              const NMMultiIndex *index,
                              const NMMultiIndexId *id)
 {
-	ValuesData *values_data;
+	Group *group;
 
 	g_return_if_fail (index);
 	g_return_if_fail (iter);
 	g_return_if_fail (id);
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data)
-		iter->_state = 2;
-	else if (values_data->index) {
-		iter->_state = 1;
-		g_hash_table_iter_init (&iter->_iter, values_data->index);
-	} else {
-		iter->_state = 0;
-		iter->_value = values_data->value0;
-	}
+	group = _group_lookup (index, id);
+	iter->_values = group ? group->values : NULL;
 }
 
 gboolean
@@ -268,19 +553,12 @@ nm_multi_index_id_iter_next (NMMultiIndexIdIter *iter,
 {
 	g_return_val_if_fail (iter, FALSE);
 
-	switch (iter->_state) {
-	case 0:
-		iter->_state = 2;
-		NM_SET_OUT (out_value, iter->_value);
-		return TRUE;
-	case 1:
-		return g_hash_table_iter_next (&iter->_iter, out_value, NULL);
-	case 2:
-		iter->_state = 3;
+	if (!iter->_values || !iter->_values[0])
 		return FALSE;
-	default:
-		g_return_val_if_reached (FALSE);
-	}
+
+	NM_SET_OUT (out_value, iter->_values[0]);
+	iter->_values++;
+	return TRUE;
 }
 
 /******************************************************************************************/
@@ -290,10 +568,13 @@ _do_add (NMMultiIndex *index,
          const NMMultiIndexId *id,
          gconstpointer value)
 {
-	ValuesData *values_data;
+	GroupSlot *slot;
+	Group *group;
+	guint hash;
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data) {
+	hash = _hash_mix (index->hash_fcn (id));
+	slot = _groups_lookup (index, id, hash);
+	if (!slot) {
 		NMMultiIndexId *id_new;
 
 		/* Contrary to GHashTable, we don't take ownership of the @id that was
@@ -309,24 +590,22 @@ _do_add (NMMultiIndex *index,
 		if (!id_new)
 			g_return_val_if_reached (FALSE);
 
-		values_data = g_slice_new0 (ValuesData);
-		values_data->value0 = (gpointer) value;
+		group = g_slice_new (Group);
+		group->id = id_new;
+		group->hash = hash;
+		group->len = 0;
+		group->values = group->values_inline;
+		group->values[0] = NULL;
+		group->alloc = 0;
 
-		g_hash_table_insert (index->hash, id_new, values_data);
+		_groups_insert (index, group);
 	} else {
-		if (!values_data->index) {
-			if (values_data->value0 == value)
-				return FALSE;
-			values_data->index = g_hash_table_new (NULL, NULL);
-			g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value);
-			g_hash_table_replace (values_data->index, values_data->value0, values_data->value0);
-			values_data->values = NULL;
-		} else {
-			if (!nm_g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value))
-				return FALSE;
-			g_clear_pointer (&values_data->values, g_free);
-		}
+		group = slot->group;
+		if (_group_find (index, group, value, NULL))
+			return FALSE;
 	}
+
+	_group_append (index, group, value);
 	return TRUE;
 }
 
@@ -335,25 +614,24 @@ _do_remove (NMMultiIndex *index,
             const NMMultiIndexId *id,
             gconstpointer value)
 {
-	ValuesData *values_data;
+	GroupSlot *slot;
+	Group *group;
+	guint pos;
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data)
+	slot = _groups_lookup (index, id, _hash_mix (index->hash_fcn (id)));
+	if (!slot)
 		return FALSE;
 
-	if (values_data->index) {
-		if (!g_hash_table_remove (values_data->index, value))
-			return FALSE;
-		if (g_hash_table_size (values_data->index) == 0)
-			g_hash_table_remove (index->hash, id);
-		else
-			g_clear_pointer (&values_data->values, g_free);
-	} else {
-		if (values_data->value0 != value)
-			return FALSE;
-		g_hash_table_remove (index->hash, id);
-	}
+	group = slot->group;
+	if (!_group_find (index, group, value, &pos))
+		return FALSE;
 
+	_group_remove_at (index, group, pos);
+	if (group->len == 0) {
+		/* _group_remove_at() doesn't touch @groups, @slot is still valid. */
+		_groups_remove_slot (index, slot);
+		_group_free (index, group);
+	}
 	return TRUE;
 }
 
@@ -436,7 +714,7 @@ guint
 nm_multi_index_get_num_groups (const NMMultiIndex *index)
 {
 	g_return_val_if_fail (index, 0);
-	return g_hash_table_size (index->hash);
+	return index->groups_len;
 }
 
 NMMultiIndex *
@@ -452,22 +730,26 @@ nm_multi_index_new (NMMultiIndexFuncHash hash_fcn,
 	g_return_val_if_fail (clone_fcn, NULL);
 	g_return_val_if_fail (destroy_fcn, NULL);
 
-	index = g_new (NMMultiIndex, 1);
+	index = g_new0 (NMMultiIndex, 1);
+	index->hash_fcn = hash_fcn;
 	index->equal_fcn = equal_fcn;
 	index->clone_fcn = clone_fcn;
-
-	index->hash = g_hash_table_new_full ((GHashFunc) hash_fcn,
-	                                     (GEqualFunc) equal_fcn,
-	                                     (GDestroyNotify) destroy_fcn,
-	                                     (GDestroyNotify) _values_data_destroy);
+	index->destroy_fcn = destroy_fcn;
 	return index;
 }
 
 void
 nm_multi_index_free (NMMultiIndex *index)
 {
+	guint i;
+
 	g_return_if_fail (index);
-	g_hash_table_unref (index->hash);
+
+	for (i = 0; i < index->groups_size; i++) {
+		if (index->groups[i].group)
+			_group_free (index, index->groups[i].group);
+	}
+	g_free (index->groups);
+	g_free (index->positions);
 	g_free (index);
 }
-
@@ -33,17 +33,13 @@ typedef struct {
 typedef struct NMMultiIndex NMMultiIndex;
 
 typedef struct {
-	GHashTableIter _iter;
 	const NMMultiIndex *_index;
 	gconstpointer _value;
+	guint _pos;
 } NMMultiIndexIter;
 
 typedef struct {
-	union {
-		GHashTableIter _iter;
-		gpointer _value;
-	};
-	guint _state;
+	void *const*_values;
 } NMMultiIndexIdIter;
 
 typedef gboolean (*NMMultiIndexFuncEqual) (const NMMultiIndexId *id_a, const NMMultiIndexId *id_b);
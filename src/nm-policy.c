@@ -46,6 +46,7 @@
 #include "nm-settings-connection.h"
 #include "nm-dhcp4-config.h"
 #include "nm-dhcp6-config.h"
+#include "nm-config.h"
 
 #define _NMLOG_PREFIX_NAME    "policy"
 #define _NMLOG(level, domain, ...) \
@@ -83,7 +84,20 @@ struct _NMPolicyPrivate {
 
 	guint reset_retries_id;  /* idle handler for resetting the retries count */
 
-	guint schedule_activate_all_id; /* idle handler for schedule_activate_all(). */
+	guint schedule_activate_id; /* idle handler for schedule_activate_connection(). */
+	GHashTable *activate_dirty; /* devices to check once schedule_activate_id fires */
+
+	struct {
+		guint timeout_id;
+		guint pending;      /* RoutingDnsUpdateFlags still to be done */
+		bool force_update;
+		guint triggers;     /* triggers folded into the pending update */
+		guint64 updates;    /* recomputations done */
+		guint64 merged;     /* triggers that did not need a recomputation of their own */
+	} routing_dns;
+
+	/* open transactions, see nm_policy_transaction_begin() */
+	guint transaction_depth;
 
 	char *orig_hostname; /* hostname at NM start time */
 	char *cur_hostname;  /* hostname we want to assign */
@@ -106,9 +120,11 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMPolicy,
 	PROP_DEFAULT_IP6_DEVICE,
 	PROP_ACTIVATING_IP4_DEVICE,
 	PROP_ACTIVATING_IP6_DEVICE,
+	PROP_ROUTING_DNS_UPDATES,
+	PROP_ROUTING_DNS_MERGED,
 );
 
-static void schedule_activate_all (NMPolicy *self);
+static void schedule_activate_connection (NMPolicy *self, NMSettingsConnection *connection);
 
 
 static NMDevice *
@@ -604,23 +620,126 @@ update_ip6_routing (NMPolicy *self, gboolean force_update)
 	_notify (self, PROP_DEFAULT_IP6_DEVICE);
 }
 
+/*****************************************************************************/
+
+typedef enum {
+	ROUTING_DNS_UPDATE_DNS4     = (1LL << 0),
+	ROUTING_DNS_UPDATE_DNS6     = (1LL << 1),
+	ROUTING_DNS_UPDATE_ROUTING4 = (1LL << 2),
+	ROUTING_DNS_UPDATE_ROUTING6 = (1LL << 3),
+	ROUTING_DNS_UPDATE_HOSTNAME = (1LL << 4),
+
+	ROUTING_DNS_UPDATE_ALL      = (1LL << 5) - 1,
+} RoutingDnsUpdateFlags;
+
+#define ROUTING_DNS_MAX_LATENCY_DEFAULT 50
+
+static guint
+routing_dns_get_max_latency (void)
+{
+	const char *value;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_ROUTING_DNS_MAX_LATENCY,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	return _nm_utils_ascii_str_to_int64 (value, 10, 0, 10000,
+	                                     ROUTING_DNS_MAX_LATENCY_DEFAULT);
+}
+
 static void
-update_routing_and_dns (NMPolicy *self, gboolean force_update)
+routing_dns_flush (NMPolicy *self)
 {
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	RoutingDnsUpdateFlags flags = priv->routing_dns.pending;
+	gboolean force_update = priv->routing_dns.force_update;
 
-	nm_dns_manager_begin_updates (priv->dns_manager, __func__);
+	if (!flags)
+		return;
+
+	nm_clear_g_source (&priv->routing_dns.timeout_id);
+	priv->routing_dns.pending = 0;
+	priv->routing_dns.force_update = FALSE;
+
+	priv->routing_dns.updates++;
+	priv->routing_dns.merged += priv->routing_dns.triggers - 1;
+	if (priv->routing_dns.triggers > 1)
+		_LOGD (LOGD_CORE, "routing/DNS update for %u triggers", priv->routing_dns.triggers);
+	priv->routing_dns.triggers = 0;
 
-	update_ip4_dns (self, priv->dns_manager);
-	update_ip6_dns (self, priv->dns_manager);
+	if (NM_FLAGS_HAS (flags, ROUTING_DNS_UPDATE_DNS4))
+		update_ip4_dns (self, priv->dns_manager);
+	if (NM_FLAGS_HAS (flags, ROUTING_DNS_UPDATE_DNS6))
+		update_ip6_dns (self, priv->dns_manager);
 
-	update_ip4_routing (self, force_update);
-	update_ip6_routing (self, force_update);
+	if (NM_FLAGS_HAS (flags, ROUTING_DNS_UPDATE_ROUTING4))
+		update_ip4_routing (self, force_update);
+	if (NM_FLAGS_HAS (flags, ROUTING_DNS_UPDATE_ROUTING6))
+		update_ip6_routing (self, force_update);
 
 	/* Update the system hostname */
-	update_system_hostname (self, priv->default_device4, priv->default_device6);
+	if (NM_FLAGS_HAS (flags, ROUTING_DNS_UPDATE_HOSTNAME))
+		update_system_hostname (self, priv->default_device4, priv->default_device6);
 
+	/* closes the batch opened by routing_dns_schedule() */
 	nm_dns_manager_end_updates (priv->dns_manager, __func__);
+
+	_notify (self, PROP_ROUTING_DNS_UPDATES);
+	_notify (self, PROP_ROUTING_DNS_MERGED);
+}
+
+static gboolean
+routing_dns_timeout_cb (gpointer user_data)
+{
+	NMPolicy *self = user_data;
+
+	NM_POLICY_GET_PRIVATE (self)->routing_dns.timeout_id = 0;
+	routing_dns_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * routing_dns_schedule:
+ * @self: the #NMPolicy
+ * @flags: what needs to be recomputed
+ * @force_update: passed on to update_ip4_routing() and update_ip6_routing()
+ *
+ * Queues a recomputation of the best devices, routing and DNS. All triggers
+ * within main.routing-dns-max-latency milliseconds of the first one are
+ * merged into a single recomputation. The timeout is not restarted by later
+ * triggers, so the latency stays bounded. A DNS batch is kept open while
+ * the update is pending, so that resolv.conf is written once as well.
+ * The DNS manager counts its own main.dns-update-max-latency window from
+ * the start of that batch, so the two windows overlap instead of adding
+ * up.
+ */
+static void
+routing_dns_schedule (NMPolicy *self, RoutingDnsUpdateFlags flags, gboolean force_update)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	guint max_latency;
+
+	if (!priv->routing_dns.pending)
+		nm_dns_manager_begin_updates (priv->dns_manager, __func__);
+
+	priv->routing_dns.pending |= flags;
+	priv->routing_dns.force_update |= !!force_update;
+	priv->routing_dns.triggers++;
+
+	max_latency = routing_dns_get_max_latency ();
+	if (!max_latency)
+		routing_dns_flush (self);
+	else if (!priv->routing_dns.timeout_id)
+		priv->routing_dns.timeout_id = g_timeout_add (max_latency, routing_dns_timeout_cb, self);
+}
+
+static void
+update_routing_and_dns (NMPolicy *self, gboolean force_update)
+{
+	/* callers rely on the result right away; this also completes any
+	 * pending coalesced update. */
+	routing_dns_schedule (self, ROUTING_DNS_UPDATE_ALL, force_update);
+	routing_dns_flush (self);
 }
 
 static void
@@ -651,6 +770,7 @@ typedef struct {
 	NMPolicy *policy;
 	NMDevice *device;
 	guint autoactivate_id;
+	char *specific_object;
 } ActivateData;
 
 static void
@@ -664,10 +784,28 @@ activate_data_free (ActivateData *data)
 	if (data->autoactivate_id)
 		g_source_remove (data->autoactivate_id);
 	g_object_unref (data->device);
+	g_free (data->specific_object);
 
 	g_slice_free (ActivateData, data);
 }
 
+static gboolean
+auto_activate_filter (NMSettings *settings,
+                      NMConnection *connection,
+                      gpointer user_data)
+{
+	ActivateData *data = user_data;
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (data->policy);
+
+	if (!nm_settings_connection_can_autoconnect (NM_SETTINGS_CONNECTION (connection)))
+		return FALSE;
+	if (!nm_manager_connection_is_activatable (priv->manager, NM_SETTINGS_CONNECTION (connection)))
+		return FALSE;
+
+	g_clear_pointer (&data->specific_object, g_free);
+	return nm_device_can_auto_connect (data->device, connection, &data->specific_object);
+}
+
 static gboolean
 auto_activate_device (gpointer user_data)
 {
@@ -675,10 +813,6 @@ auto_activate_device (gpointer user_data)
 	NMPolicy *self;
 	NMPolicyPrivate *priv;
 	NMSettingsConnection *best_connection;
-	char *specific_object = NULL;
-	GPtrArray *connections;
-	GSList *connection_list;
-	guint i;
 
 	g_assert (data);
 	self = data->policy;
@@ -693,30 +827,12 @@ auto_activate_device (gpointer user_data)
 	if (nm_device_get_act_request (data->device))
 		goto out;
 
-	connection_list = nm_manager_get_activatable_connections (priv->manager);
-	if (!connection_list)
-		goto out;
-
-	connections = _nm_utils_copy_slist_to_array (connection_list, NULL, NULL);
-	g_slist_free (connection_list);
-
-	/* sort is stable (which is important at this point) so that connections
-	 * with same priority are still sorted by last-connected-timestamp. */
-	g_ptr_array_sort (connections, (GCompareFunc) nm_utils_cmp_connection_by_autoconnect_priority);
-
-	/* Find the first connection that should be auto-activated */
-	best_connection = NULL;
-	for (i = 0; i < connections->len; i++) {
-		NMSettingsConnection *candidate = NM_SETTINGS_CONNECTION (connections->pdata[i]);
-
-		if (!nm_settings_connection_can_autoconnect (candidate))
-			continue;
-		if (nm_device_can_auto_connect (data->device, (NMConnection *) candidate, &specific_object)) {
-			best_connection = candidate;
-			break;
-		}
-	}
-	g_ptr_array_free (connections, TRUE);
+	/* Find the first connection that should be auto-activated. NMSettings
+	 * keeps the connections sorted by autoconnect-priority and
+	 * last-connected-timestamp. */
+	best_connection = nm_settings_find_autoconnect_connection (priv->settings,
+	                                                           auto_activate_filter,
+	                                                           data);
 
 	if (best_connection) {
 		GError *error = NULL;
@@ -727,7 +843,7 @@ auto_activate_device (gpointer user_data)
 		subject = nm_auth_subject_new_internal ();
 		if (!nm_manager_activate_connection (priv->manager,
 		                                     best_connection,
-		                                     specific_object,
+		                                     data->specific_object,
 		                                     data->device,
 		                                     subject,
 		                                     &error)) {
@@ -876,20 +992,21 @@ static void
 reset_autoconnect_for_failed_secrets (NMPolicy *self)
 {
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
-	GSList *connections, *iter;
+	NMSettingsConnection *const *connections;
+	guint i, len;
 
 	_LOGD (LOGD_DEVICE, "re-enabling autoconnect for all connections with failed secrets");
 
-	connections = nm_settings_get_connections_sorted (priv->settings);
-	for (iter = connections; iter; iter = g_slist_next (iter)) {
-		NMSettingsConnection *connection = NM_SETTINGS_CONNECTION (iter->data);
+	connections = nm_settings_get_connections (priv->settings, &len);
+	for (i = 0; i < len; i++) {
+		NMSettingsConnection *connection = connections[i];
 
 		if (nm_settings_connection_get_autoconnect_blocked_reason (connection) == NM_DEVICE_STATE_REASON_NO_SECRETS) {
 			nm_settings_connection_reset_autoconnect_retries (connection);
 			nm_settings_connection_set_autoconnect_blocked_reason (connection, NM_DEVICE_STATE_REASON_NONE);
+			schedule_activate_connection (self, connection);
 		}
 	}
-	g_slist_free (connections);
 }
 
 static void
@@ -937,7 +1054,7 @@ schedule_activate_check (NMPolicy *self, NMDevice *device)
 {
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
 	ActivateData *data;
-	const GSList *active_connections, *iter;
+	guint len;
 
 	if (nm_manager_get_state (priv->manager) == NM_STATE_ASLEEP)
 		return;
@@ -951,11 +1068,9 @@ schedule_activate_check (NMPolicy *self, NMDevice *device)
 	if (find_pending_activation (priv->pending_activation_checks, device))
 		return;
 
-	active_connections = nm_manager_get_active_connections (priv->manager);
-	for (iter = active_connections; iter; iter = iter->next) {
-		if (nm_active_connection_get_device (NM_ACTIVE_CONNECTION (iter->data)) == device)
-			return;
-	}
+	nm_manager_get_active_connections_for_device (priv->manager, device, &len);
+	if (len)
+		return;
 
 	nm_device_add_pending_action (device, "autoactivate", TRUE);
 
@@ -984,7 +1099,6 @@ reset_connections_retries (gpointer user_data)
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
 	GSList *connections, *iter;
 	gint32 con_stamp, min_stamp, now;
-	gboolean changed = FALSE;
 
 	priv->reset_retries_id = 0;
 
@@ -1000,7 +1114,7 @@ reset_connections_retries (gpointer user_data)
 
 		if (con_stamp <= now) {
 			nm_settings_connection_reset_autoconnect_retries (connection);
-			changed = TRUE;
+			schedule_activate_connection (self, connection);
 		} else if (min_stamp == 0 || min_stamp > con_stamp)
 			min_stamp = con_stamp;
 	}
@@ -1010,10 +1124,6 @@ reset_connections_retries (gpointer user_data)
 	if (min_stamp != 0)
 		priv->reset_retries_id = g_timeout_add_seconds (min_stamp - now, reset_connections_retries, self);
 
-	/* If anything changed, try to activate the newly re-enabled connections */
-	if (changed)
-		schedule_activate_all (self);
-
 	return FALSE;
 }
 
@@ -1060,13 +1170,13 @@ activate_slave_connections (NMPolicy *self, NMDevice *device)
 
 		if (   !g_strcmp0 (slave_master, master_device)
 		    || !g_strcmp0 (slave_master, master_uuid_applied)
-		    || !g_strcmp0 (slave_master, master_uuid_settings))
+		    || !g_strcmp0 (slave_master, master_uuid_settings)) {
 			nm_settings_connection_reset_autoconnect_retries (NM_SETTINGS_CONNECTION (slave));
+			schedule_activate_connection (self, NM_SETTINGS_CONNECTION (slave));
+		}
 	}
 
 	g_slist_free (connections);
-
-	schedule_activate_all (self);
 }
 
 static gboolean
@@ -1290,11 +1400,13 @@ static void
 device_ip4_config_changed (NMDevice *device,
                            NMIP4Config *new_config,
                            NMIP4Config *old_config,
+                           guint changes,
                            gpointer user_data)
 {
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = priv->self;
 	const char *ip_iface = nm_device_get_ip_iface (device);
+	RoutingDnsUpdateFlags flags = ROUTING_DNS_UPDATE_ROUTING4;
 
 	nm_dns_manager_begin_updates (priv->dns_manager, __func__);
 
@@ -1309,8 +1421,15 @@ device_ip4_config_changed (NMDevice *device,
 			if (new_config)
 				nm_dns_manager_add_ip4_config (priv->dns_manager, ip_iface, new_config, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
 		}
-		update_ip4_dns (self, priv->dns_manager);
-		update_ip4_routing (self, TRUE);
+		/* Only the DNS information and the default route (which decides about
+		 * the best device) matter for DNS. Skip rehashing and rewriting the
+		 * DNS configuration when, for example, only routes changed. */
+		if (   old_config != new_config
+		    || NM_FLAGS_ANY (changes,   NM_IP_CONFIG_CHANGE_DNS
+		                              | NM_IP_CONFIG_CHANGE_GATEWAY
+		                              | NM_IP_CONFIG_CHANGE_OTHER))
+			flags |= ROUTING_DNS_UPDATE_DNS4;
+		routing_dns_schedule (self, flags, TRUE);
 	} else {
 		/* Old configs get removed immediately */
 		if (old_config)
@@ -1324,11 +1443,13 @@ static void
 device_ip6_config_changed (NMDevice *device,
                            NMIP6Config *new_config,
                            NMIP6Config *old_config,
+                           guint changes,
                            gpointer user_data)
 {
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = priv->self;
 	const char *ip_iface = nm_device_get_ip_iface (device);
+	RoutingDnsUpdateFlags flags = ROUTING_DNS_UPDATE_ROUTING6;
 
 	nm_dns_manager_begin_updates (priv->dns_manager, __func__);
 
@@ -1343,8 +1464,15 @@ device_ip6_config_changed (NMDevice *device,
 			if (new_config)
 				nm_dns_manager_add_ip6_config (priv->dns_manager, ip_iface, new_config, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
 		}
-		update_ip6_dns (self, priv->dns_manager);
-		update_ip6_routing (self, TRUE);
+		/* Only the DNS information and the default route (which decides about
+		 * the best device) matter for DNS. Skip rehashing and rewriting the
+		 * DNS configuration when, for example, only routes changed. */
+		if (   old_config != new_config
+		    || NM_FLAGS_ANY (changes,   NM_IP_CONFIG_CHANGE_DNS
+		                              | NM_IP_CONFIG_CHANGE_GATEWAY
+		                              | NM_IP_CONFIG_CHANGE_OTHER))
+			flags |= ROUTING_DNS_UPDATE_DNS6;
+		routing_dns_schedule (self, flags, TRUE);
 	} else {
 		/* Old configs get removed immediately */
 		if (old_config)
@@ -1420,6 +1548,7 @@ device_removed (NMManager *manager, NMDevice *device, gpointer user_data)
 
 	/* Clear any idle callbacks for this device */
 	clear_pending_activate_check (self, device);
+	g_hash_table_remove (priv->activate_dirty, device);
 
 	if (g_hash_table_remove (priv->devices, device))
 		devices_list_unregister (self, device);
@@ -1453,7 +1582,7 @@ vpn_connection_activated (NMPolicy *self, NMVpnConnection *vpn)
 	if (ip6_config)
 		nm_dns_manager_add_ip6_config (priv->dns_manager, ip_iface, ip6_config, NM_DNS_IP_CONFIG_TYPE_VPN);
 
-	update_routing_and_dns (self, TRUE);
+	routing_dns_schedule (self, ROUTING_DNS_UPDATE_ALL, TRUE);
 
 	nm_dns_manager_end_updates (priv->dns_manager, __func__);
 }
@@ -1479,7 +1608,7 @@ vpn_connection_deactivated (NMPolicy *self, NMVpnConnection *vpn)
 		nm_dns_manager_remove_ip6_config (priv->dns_manager, ip6_config);
 	}
 
-	update_routing_and_dns (self, TRUE);
+	routing_dns_schedule (self, ROUTING_DNS_UPDATE_ALL, TRUE);
 
 	nm_dns_manager_end_updates (priv->dns_manager, __func__);
 }
@@ -1579,30 +1708,117 @@ active_connection_removed (NMManager *manager,
 
 /**************************************************************************/
 
+/**
+ * nm_policy_transaction_begin:
+ * @self: the #NMPolicy
+ *
+ * Defers the activation checks that new and changed connections trigger
+ * until the matching nm_policy_transaction_commit(), so that they are
+ * done once for all connections of the transaction. Nothing else is held
+ * back: routing, DNS and hostname updates and the checks that device
+ * changes trigger go on as usual. Transactions nest.
+ */
+void
+nm_policy_transaction_begin (NMPolicy *self)
+{
+	NMPolicyPrivate *priv;
+
+	g_return_if_fail (NM_IS_POLICY (self));
+
+	priv = NM_POLICY_GET_PRIVATE (self);
+	if (priv->transaction_depth++)
+		return;
+
+	_LOGD (LOGD_CORE, "transaction started");
+}
+
+/**
+ * nm_policy_transaction_commit:
+ * @self: the #NMPolicy
+ *
+ * Ends a transaction started with nm_policy_transaction_begin(). When
+ * the last one ends, the deferred activation checks are scheduled.
+ */
+void
+nm_policy_transaction_commit (NMPolicy *self)
+{
+	NMPolicyPrivate *priv;
+
+	g_return_if_fail (NM_IS_POLICY (self));
+
+	priv = NM_POLICY_GET_PRIVATE (self);
+	g_return_if_fail (priv->transaction_depth > 0);
+
+	if (--priv->transaction_depth)
+		return;
+
+	_LOGD (LOGD_CORE, "transaction committed (%u devices to check)",
+	       g_hash_table_size (priv->activate_dirty));
+
+	if (   g_hash_table_size (priv->activate_dirty)
+	    && !priv->schedule_activate_id)
+		priv->schedule_activate_id = g_idle_add (schedule_activate_cb, self);
+}
+
 static gboolean
-schedule_activate_all_cb (gpointer user_data)
+schedule_activate_cb (gpointer user_data)
 {
 	NMPolicy *self = user_data;
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
-	const GSList *iter;
+	GHashTableIter iter;
+	NMDevice *device;
 
-	priv->schedule_activate_all_id = 0;
+	priv->schedule_activate_id = 0;
 
-	for (iter = nm_manager_get_devices (priv->manager); iter; iter = g_slist_next (iter))
-		schedule_activate_check (self, iter->data);
+	g_hash_table_iter_init (&iter, priv->activate_dirty);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &device, NULL)) {
+		g_hash_table_iter_remove (&iter);
+		schedule_activate_check (self, device);
+	}
 
 	return G_SOURCE_REMOVE;
 }
 
+/*
+ * schedule_activate_connection:
+ * @self: the #NMPolicy
+ * @connection: a connection that may have become activatable
+ *
+ * Marks the devices that @connection could be activated on as dirty and
+ * schedules an activation check for them. Devices that cannot take the
+ * connection (wrong type, interface-name or MAC address) are left alone.
+ */
 static void
-schedule_activate_all (NMPolicy *self)
+schedule_activate_connection (NMPolicy *self, NMSettingsConnection *connection)
 {
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	GHashTableIter iter;
+	NMDevice *device;
+	const char *iface;
+	guint n_dirty;
+
+	n_dirty = g_hash_table_size (priv->activate_dirty);
+	iface = nm_connection_get_interface_name (NM_CONNECTION (connection));
+
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &device, NULL)) {
+		if (g_hash_table_contains (priv->activate_dirty, device))
+			continue;
+		if (iface && g_strcmp0 (iface, nm_device_get_iface (device)))
+			continue;
+		if (!nm_device_check_connection_compatible (device, NM_CONNECTION (connection)))
+			continue;
+		g_hash_table_add (priv->activate_dirty, device);
+	}
+
+	if (g_hash_table_size (priv->activate_dirty) == n_dirty)
+		return;
 
 	/* always restart the idle handler. That way, we settle
 	 * all other events before restarting to activate them. */
-	nm_clear_g_source (&priv->schedule_activate_all_id);
-	priv->schedule_activate_all_id = g_idle_add (schedule_activate_all_cb, self);
+	nm_clear_g_source (&priv->schedule_activate_id);
+	if (!priv->transaction_depth)
+		priv->schedule_activate_id = g_idle_add (schedule_activate_cb, self);
 }
 
 static void
@@ -1613,7 +1829,7 @@ connection_added (NMSettings *settings,
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = priv->self;
 
-	schedule_activate_all (self);
+	schedule_activate_connection (self, connection);
 }
 
 static void
@@ -1691,22 +1907,28 @@ connection_updated (NMSettings *settings,
 		nm_settings_connection_reset_autoconnect_retries (connection);
 	}
 
-	schedule_activate_all (self);
+	schedule_activate_connection (self, connection);
 }
 
 static void
 _deactivate_if_active (NMManager *manager, NMSettingsConnection *connection)
 {
-	const GSList *active, *iter;
+	NMActiveConnection *const *acs;
+	gs_free NMActiveConnection **active = NULL;
+	guint i, len;
+
+	/* deactivating might change the list */
+	acs = nm_manager_get_active_connections_for_connection (manager, connection, &len);
+	if (!len)
+		return;
+	active = g_memdup (acs, sizeof (acs[0]) * len);
 
-	active = nm_manager_get_active_connections (manager);
-	for (iter = active; iter; iter = g_slist_next (iter)) {
-		NMActiveConnection *ac = iter->data;
+	for (i = 0; i < len; i++) {
+		NMActiveConnection *ac = active[i];
 		NMActiveConnectionState state = nm_active_connection_get_state (ac);
 		GError *error = NULL;
 
-		if (nm_active_connection_get_settings_connection (ac) == connection &&
-		    (state <= NM_ACTIVE_CONNECTION_STATE_ACTIVATED)) {
+		if (state <= NM_ACTIVE_CONNECTION_STATE_ACTIVATED) {
 			if (!nm_manager_deactivate_connection (manager,
 			                                       nm_exported_object_get_path (NM_EXPORTED_OBJECT (ac)),
 			                                       NM_DEVICE_STATE_REASON_CONNECTION_REMOVED,
@@ -1740,7 +1962,7 @@ connection_visibility_changed (NMSettings *settings,
 	NMPolicy *self = priv->self;
 
 	if (nm_settings_connection_is_visible (connection))
-		schedule_activate_all (self);
+		schedule_activate_connection (self, connection);
 	else
 		_deactivate_if_active (priv->manager, connection);
 }
@@ -1756,9 +1978,9 @@ secret_agent_registered (NMSettings *settings,
 	/* The registered secret agent may provide some missing secrets. Thus we
 	 * reset retries count here and schedule activation, so that the
 	 * connections failed due to missing secrets may re-try auto-connection.
+	 * Only devices that can take one of those connections are rechecked.
 	 */
 	reset_autoconnect_for_failed_secrets (self);
-	schedule_activate_all (self);
 }
 
 NMDevice *
@@ -1807,6 +2029,12 @@ get_property (GObject *object, guint prop_id,
 	case PROP_ACTIVATING_IP6_DEVICE:
 		g_value_set_object (value, priv->activating_device6);
 		break;
+	case PROP_ROUTING_DNS_UPDATES:
+		g_value_set_uint64 (value, priv->routing_dns.updates);
+		break;
+	case PROP_ROUTING_DNS_MERGED:
+		g_value_set_uint64 (value, priv->routing_dns.merged);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1848,6 +2076,7 @@ nm_policy_init (NMPolicy *self)
 	priv->self = self;
 
 	priv->devices = g_hash_table_new (NULL, NULL);
+	priv->activate_dirty = g_hash_table_new (NULL, NULL);
 }
 
 static void
@@ -1932,6 +2161,14 @@ dispose (GObject *object)
 		g_clear_object (&priv->firewall_manager);
 	}
 
+	if (priv->routing_dns.pending) {
+		nm_clear_g_source (&priv->routing_dns.timeout_id);
+		priv->routing_dns.pending = 0;
+		nm_dns_manager_end_updates (priv->dns_manager, __func__);
+	}
+
+	priv->transaction_depth = 0;
+
 	if (priv->dns_manager) {
 		nm_clear_g_signal_handler (priv->dns_manager, &priv->config_changed_id);
 		g_clear_object (&priv->dns_manager);
@@ -1951,7 +2188,8 @@ dispose (GObject *object)
 	g_assert (connections == NULL);
 
 	nm_clear_g_source (&priv->reset_retries_id);
-	nm_clear_g_source (&priv->schedule_activate_all_id);
+	nm_clear_g_source (&priv->schedule_activate_id);
+	g_hash_table_remove_all (priv->activate_dirty);
 
 	g_clear_pointer (&priv->orig_hostname, g_free);
 	g_clear_pointer (&priv->cur_hostname, g_free);
@@ -1980,6 +2218,7 @@ finalize (GObject *object)
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
 
 	g_hash_table_unref (priv->devices);
+	g_hash_table_unref (priv->activate_dirty);
 
 	G_OBJECT_CLASS (nm_policy_parent_class)->finalize (object);
 
@@ -2031,5 +2270,17 @@ nm_policy_class_init (NMPolicyClass *policy_class)
 	                         NM_TYPE_DEVICE,
 	                         G_PARAM_READABLE |
 	                         G_PARAM_STATIC_STRINGS);
+
+	obj_properties[PROP_ROUTING_DNS_UPDATES] =
+	    g_param_spec_uint64 (NM_POLICY_ROUTING_DNS_UPDATES, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
+
+	obj_properties[PROP_ROUTING_DNS_MERGED] =
+	    g_param_spec_uint64 (NM_POLICY_ROUTING_DNS_MERGED, "", "",
+	                         0, G_MAXUINT64, 0,
+	                         G_PARAM_READABLE |
+	                         G_PARAM_STATIC_STRINGS);
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 }
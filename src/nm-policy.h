@@ -37,6 +37,8 @@
 #define NM_POLICY_DEFAULT_IP6_DEVICE    "default-ip6-device"
 #define NM_POLICY_ACTIVATING_IP4_DEVICE "activating-ip4-device"
 #define NM_POLICY_ACTIVATING_IP6_DEVICE "activating-ip6-device"
+#define NM_POLICY_ROUTING_DNS_UPDATES   "routing-dns-updates"
+#define NM_POLICY_ROUTING_DNS_MERGED    "routing-dns-merged"
 
 struct _NMPolicyPrivate;
 
@@ -59,4 +61,7 @@ NMDevice *nm_policy_get_default_ip6_device (NMPolicy *policy);
 NMDevice *nm_policy_get_activating_ip4_device (NMPolicy *policy);
 NMDevice *nm_policy_get_activating_ip6_device (NMPolicy *policy);
 
+void nm_policy_transaction_begin (NMPolicy *policy);
+void nm_policy_transaction_commit (NMPolicy *policy);
+
 #endif /* __NETWORKMANAGER_POLICY_H__ */
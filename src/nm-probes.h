@@ -0,0 +1,54 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_PROBES_H__
+#define __NETWORKMANAGER_PROBES_H__
+
+/* Static tracepoints (USDT) of the provider "NetworkManager", compiled in
+ * with --enable-sdt. A probe is a single nop instruction plus a note in the
+ * ELF file; tracers like perf, bpftrace and SystemTap patch it at runtime.
+ * List them with e.g. `bpftrace -l 'usdt:/usr/sbin/NetworkManager:*'`.
+ *
+ * The arguments are always evaluated, so only pass values that are
+ * readily available. Strings are passed as pointers.
+ *
+ * Without --enable-sdt, the probes compile to nothing. */
+
+#ifdef WITH_SDT
+
+#include <sys/sdt.h>
+
+#define NM_PROBE0(name)                     DTRACE_PROBE (NetworkManager, name)
+#define NM_PROBE1(name, a1)                 DTRACE_PROBE1 (NetworkManager, name, a1)
+#define NM_PROBE2(name, a1, a2)             DTRACE_PROBE2 (NetworkManager, name, a1, a2)
+#define NM_PROBE3(name, a1, a2, a3)         DTRACE_PROBE3 (NetworkManager, name, a1, a2, a3)
+#define NM_PROBE4(name, a1, a2, a3, a4)     DTRACE_PROBE4 (NetworkManager, name, a1, a2, a3, a4)
+
+#else
+
+#define NM_PROBE0(name)                     G_STMT_START { } G_STMT_END
+#define NM_PROBE1(name, a1)                 G_STMT_START { } G_STMT_END
+#define NM_PROBE2(name, a1, a2)             G_STMT_START { } G_STMT_END
+#define NM_PROBE3(name, a1, a2, a3)         G_STMT_START { } G_STMT_END
+#define NM_PROBE4(name, a1, a2, a3, a4)     G_STMT_START { } G_STMT_END
+
+#endif
+
+#endif /* __NETWORKMANAGER_PROBES_H__ */
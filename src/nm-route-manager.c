@@ -27,18 +27,40 @@
 #include "nmp-object.h"
 #include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
+#include "nm-probes.h"
 
 /* if within half a second after adding an IP address a matching device-route shows
  * up, we delete it. */
 #define IP4_DEVICE_ROUTES_WAIT_TIME_NS                 (NM_UTILS_NS_PER_SECOND / 2)
 
-#define IP4_DEVICE_ROUTES_GC_INTERVAL_SEC              (IP4_DEVICE_ROUTES_WAIT_TIME_NS * 2)
+/* expired entries are cleaned up by a coarse timer wheel with a tick of 100 msec.
+ * The wheel has enough slots to cover the wait time. */
+#define IP4_DEVICE_ROUTES_WHEEL_TICK_NS                (NM_UTILS_NS_PER_MSEC * 100)
+#define IP4_DEVICE_ROUTES_WHEEL_SLOTS                  ((guint) (IP4_DEVICE_ROUTES_WAIT_TIME_NS / IP4_DEVICE_ROUTES_WHEEL_TICK_NS) + 2)
 
 typedef struct {
 	guint len;
 	NMPlatformIPXRoute *entries[1];
 } RouteIndex;
 
+/* the identity of a route, as kernel sees it. The struct is compared with memcmp(),
+ * so it must always be initialized via _route_id_init(). */
+typedef struct {
+	union {
+		in_addr_t addr4;
+		struct in6_addr addr6;
+	} network;
+	guint32 metric;
+	int ifindex;
+	guint8 plen;
+} RouteId;
+
+typedef struct {
+	/* maps RouteId to a NMPlatformIPXRoute. The keys point into @ids. */
+	GHashTable *by_id;
+	RouteId *ids;
+} RouteIdIndex;
+
 typedef struct {
 	GArray *entries;
 	RouteIndex *index;
@@ -49,12 +71,39 @@ typedef struct {
 	/* this array contains the effective metrics but using the reversed index that corresponds
 	 * to @entries, instead of @index. */
 	GArray *effective_metrics_reverse;
+
+	/* the routes of @entries that we configure, by their effective metric. Routes
+	 * that are shadowed are not contained. Rebuilt whenever the effective metrics change. */
+	RouteIdIndex effective_ids;
+
+	/* identity indexes of the platform routes, by ifindex. They point into the platform
+	 * cache and are dropped as soon as the cache generation changes. */
+	GHashTable *plat_indexes;
+	guint64 plat_indexes_generation;
 } RouteEntries;
 
+typedef struct {
+	/* the hash key, must be first. */
+	int ifindex;
+
+	/* the view of the platform routes and the index into it. Both include kernel routes. */
+	const NMPlatformIPXRoute *const *routes;
+	guint len;
+	RouteIdIndex ids;
+} PlatRouteIndex;
+
 typedef struct {
 	NMRouteManager *self;
 	gint64 scheduled_at_ns;
-	guint idle_id;
+
+	/* the tick of the timer wheel in which the entry expires. */
+	gint64 expire_tick;
+	GList wheel_link;
+
+	/* whether the entry is in the list of routes to purge. */
+	bool purge_pending;
+	GList purge_link;
+
 	NMPObject *obj;
 } IP4DeviceRoutePurgeEntry;
 
@@ -65,7 +114,15 @@ typedef struct {
 	RouteEntries ip6_routes;
 	struct {
 		GHashTable *entries;
+
+		/* the timer wheel. Each slot contains the entries that expire in the slot's tick. */
+		GQueue wheel[IP4_DEVICE_ROUTES_WHEEL_SLOTS];
+		gint64 wheel_tick;
 		guint gc_id;
+
+		/* the entries whose route showed up and is about to be deleted. */
+		GQueue purge_list;
+		guint purge_id;
 	} ip4_device_routes;
 } NMRouteManagerPrivate;
 
@@ -130,7 +187,7 @@ static const VTableIP vtable_v4, vtable_v6;
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = __addr_family == AF_INET ? LOGD_IP4 : (__addr_family == AF_INET6 ? LOGD_IP6 : LOGD_IP); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             char __ch = __addr_family == AF_INET ? '4' : (__addr_family == AF_INET6 ? '6' : '-'); \
             char __prefix[30] = _NMLOG_PREFIX_NAME; \
             \
@@ -162,12 +219,11 @@ ASSERT_route_index_valid (const VTableIP *vtable, const GArray *entries, const R
 
 	g_assert (index);
 
+	/* @entries is %NULL for indexes that point directly into the platform cache. */
 	if (entries)
 		g_assert_cmpint (entries->len, ==, index->len);
-	else
-		g_assert (index->len == 0);
 
-	if (index->len > 0) {
+	if (entries && index->len > 0) {
 		r_first = VTABLE_ROUTE_INDEX (vtable, entries, 0);
 		r_last = VTABLE_ROUTE_INDEX (vtable, entries, index->len - 1);
 	}
@@ -179,9 +235,11 @@ ASSERT_route_index_valid (const VTableIP *vtable, const GArray *entries, const R
 		r1 = index->entries[i];
 
 		g_assert (r1);
-		g_assert (r1 >= r_first);
-		g_assert (r1 <= r_last);
-		g_assert_cmpint ((((char *) r1) - ((char *) entries->data)) % vtable->vt->sizeof_route, ==, 0);
+		if (entries) {
+			g_assert (r1 >= r_first);
+			g_assert (r1 <= r_last);
+			g_assert_cmpint ((((char *) r1) - ((char *) entries->data)) % vtable->vt->sizeof_route, ==, 0);
+		}
 
 		g_assert (!g_hash_table_contains (ptrs, (gpointer) r1));
 		g_hash_table_add (ptrs, (gpointer) r1);
@@ -285,6 +343,210 @@ _route_index_create (const VTableIP *vtable, const GArray *routes)
 	return index;
 }
 
+static void
+_route_id_init (const VTableIP *vtable, RouteId *id, const NMPlatformIPXRoute *route, guint32 metric, int ifindex)
+{
+	memset (id, 0, sizeof (*id));
+	if (vtable->vt->is_ip4)
+		id->network.addr4 = nm_utils_ip4_address_clear_host_address (route->r4.network, route->r4.plen);
+	else
+		nm_utils_ip6_address_clear_host_address (&id->network.addr6, &route->r6.network, route->r6.plen);
+	id->metric = metric;
+	id->ifindex = ifindex;
+	id->plen = route->rx.plen;
+}
+
+static guint
+_route_id_hash (gconstpointer key)
+{
+	const RouteId *id = key;
+	const guint32 *p = (const guint32 *) &id->network;
+	guint h = id->plen;
+	guint i;
+
+	for (i = 0; i < sizeof (id->network) / sizeof (guint32); i++)
+		h = (h * 33) + p[i];
+	h = (h * 33) + id->metric;
+	h = (h * 33) + (guint) id->ifindex;
+	return h;
+}
+
+static gboolean
+_route_id_equal (gconstpointer a, gconstpointer b)
+{
+	return memcmp (a, b, sizeof (RouteId)) == 0;
+}
+
+static void
+_route_id_index_clear (RouteIdIndex *index)
+{
+	if (index->by_id) {
+		g_hash_table_unref (index->by_id);
+		index->by_id = NULL;
+	}
+	g_clear_pointer (&index->ids, g_free);
+}
+
+static void
+_route_id_index_reset (RouteIdIndex *index, guint len)
+{
+	_route_id_index_clear (index);
+	index->by_id = g_hash_table_new (_route_id_hash, _route_id_equal);
+	index->ids = g_new (RouteId, len + 1);
+}
+
+static void
+_route_id_index_add (const VTableIP *vtable, RouteIdIndex *index, guint i, const NMPlatformIPXRoute *route, guint32 metric, int ifindex)
+{
+	RouteId *id = &index->ids[i];
+
+	_route_id_init (vtable, id, route, metric, ifindex);
+
+	/* on duplicates, the first route wins. */
+	if (!g_hash_table_contains (index->by_id, id))
+		g_hash_table_insert (index->by_id, id, (gpointer) route);
+}
+
+static const NMPlatformIPXRoute *
+_route_id_index_lookup (const VTableIP *vtable, const RouteIdIndex *index, const NMPlatformIPXRoute *route, guint32 metric, int ifindex)
+{
+	RouteId id;
+
+	if (!index->by_id)
+		return NULL;
+	_route_id_init (vtable, &id, route, metric, ifindex);
+	return g_hash_table_lookup (index->by_id, &id);
+}
+
+static void
+_plat_route_index_free (PlatRouteIndex *plat_index)
+{
+	_route_id_index_clear (&plat_index->ids);
+	g_slice_free (PlatRouteIndex, plat_index);
+}
+
+static const PlatRouteIndex *
+_plat_route_index_get (const VTableIP *vtable, NMRouteManager *self, RouteEntries *ipx_routes, int ifindex)
+{
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
+	PlatRouteIndex *plat_index;
+	guint64 generation;
+	guint i;
+
+	/* Index the platform routes of @ifindex by their identity. Keep the
+	 * index around and reuse it as long as the platform cache is unchanged. */
+	generation = nm_platform_cache_get_generation (priv->platform);
+	if (ipx_routes->plat_indexes_generation != generation) {
+		g_hash_table_remove_all (ipx_routes->plat_indexes);
+		ipx_routes->plat_indexes_generation = generation;
+	}
+
+	plat_index = g_hash_table_lookup (ipx_routes->plat_indexes, &ifindex);
+	if (plat_index)
+		return plat_index;
+
+	plat_index = g_slice_new0 (PlatRouteIndex);
+	plat_index->ifindex = ifindex;
+	plat_index->routes = vtable->vt->route_get_view (priv->platform, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT, &plat_index->len);
+
+	_route_id_index_reset (&plat_index->ids, plat_index->len);
+	for (i = 0; i < plat_index->len; i++) {
+		const NMPlatformIPXRoute *r = plat_index->routes[i];
+
+		_route_id_index_add (vtable, &plat_index->ids, i, r, r->rx.metric, ifindex);
+	}
+
+	g_hash_table_add (ipx_routes->plat_indexes, plat_index);
+	return plat_index;
+}
+
+static const NMPlatformIPXRoute *
+_plat_route_index_lookup (const VTableIP *vtable, const PlatRouteIndex *plat_index, const NMPlatformIPXRoute *route, guint32 metric, gboolean ignore_kernel_routes)
+{
+	const NMPlatformIPXRoute *r;
+
+	r = _route_id_index_lookup (vtable, &plat_index->ids, route, metric, plat_index->ifindex);
+	if (   r
+	    && ignore_kernel_routes
+	    && r->rx.rt_source == NM_IP_CONFIG_SOURCE_RTPROT_KERNEL)
+		return NULL;
+	return r;
+}
+
+static RouteIndex *
+_route_index_update (const VTableIP *vtable,
+                     const RouteIndex *index,
+                     const guint *order,
+                     const guint *deleted,
+                     guint deleted_len,
+                     const GArray *routes,
+                     guint added_start)
+{
+	RouteIndex *new_index;
+	gs_free guint *remap = NULL;
+	gs_free NMPlatformIPXRoute **added = NULL;
+	guint n_added = routes->len - added_start;
+	guint old_len = index->len;
+	guint i, j, k;
+
+	/* like _route_index_create(), but reuses the order of the previous @index instead of
+	 * sorting all @routes again.
+	 *
+	 * @order contains for each position in @index the offset into @routes, before
+	 * the sorted offsets @deleted were removed and the routes starting at @added_start
+	 * were appended. Only the appended routes are sorted, and then merged with the
+	 * remaining ones. On ties, the remaining routes come first, which gives the identical
+	 * result as the stable sort in _route_index_create(). */
+
+	remap = g_new (guint, old_len + 1);
+	for (i = 0, j = 0; i < old_len; i++) {
+		if (j < deleted_len && deleted[j] == i) {
+			remap[i] = G_MAXUINT;
+			j++;
+		} else
+			remap[i] = i - j;
+	}
+	g_assert (j == deleted_len);
+
+	added = g_new (NMPlatformIPXRoute *, n_added + 1);
+	for (i = 0; i < n_added; i++)
+		added[i] = VTABLE_ROUTE_INDEX (vtable, routes, added_start + i);
+	g_qsort_with_data (added,
+	                   n_added,
+	                   sizeof (NMPlatformIPXRoute *),
+	                   (GCompareDataFunc) _route_index_create_sort,
+	                   (gpointer) vtable);
+
+	new_index = g_malloc (sizeof (RouteIndex) + routes->len * sizeof (NMPlatformIPXRoute *));
+
+	i = 0;
+	j = 0;
+	k = 0;
+	while (TRUE) {
+		NMPlatformIPXRoute *r_old = NULL;
+
+		while (i < old_len && remap[order[i]] == G_MAXUINT)
+			i++;
+		if (i < old_len)
+			r_old = VTABLE_ROUTE_INDEX (vtable, routes, remap[order[i]]);
+		else if (j >= n_added)
+			break;
+
+		if (   r_old
+		    && (   j >= n_added
+		        || vtable->route_id_cmp (r_old, added[j]) <= 0)) {
+			new_index->entries[k++] = r_old;
+			i++;
+		} else
+			new_index->entries[k++] = added[j++];
+	}
+	g_assert (k == routes->len);
+
+	new_index->len = k;
+	new_index->entries[k] = NULL;
+	return new_index;
+}
+
 static int
 _vx_route_id_cmp_full (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, const VTableIP *vtable)
 {
@@ -335,8 +597,8 @@ _route_index_reverse_idx (const VTableIP *vtable, const RouteIndex *index, guint
 		offset = &r->r4 - &r0->r4;
 	else
 		offset = &r->r6 - &r0->r6;
-	g_assert (offset >= 0 && offset < index->len);
-	g_assert (VTABLE_ROUTE_INDEX (vtable, routes, offset) == r);
+	nm_assert (offset >= 0 && offset < index->len);
+	nm_assert (VTABLE_ROUTE_INDEX (vtable, routes, offset) == r);
 	return offset;
 }
 
@@ -409,21 +671,6 @@ _get_next_known_route (const VTableIP *vtable, const RouteIndex *index, gboolean
 	return NULL;
 }
 
-static const NMPlatformIPXRoute *
-_get_next_plat_route (const RouteIndex *index, gboolean start_at_zero, guint *cur_idx)
-{
-	if (start_at_zero)
-		*cur_idx = 0;
-	else
-		++*cur_idx;
-
-	/* get next route from the platform index. */
-	if (*cur_idx < index->len)
-		return index->entries[*cur_idx];
-	*cur_idx = index->len;
-	return NULL;
-}
-
 static int
 _sort_indexes_cmp (guint *a, guint *b)
 {
@@ -437,9 +684,10 @@ static gboolean
 _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const GArray *known_routes, gboolean ignore_kernel_routes, gboolean full_sync)
 {
 	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
-	GArray *plat_routes;
+	guint64 plat_generation;
 	RouteEntries *ipx_routes;
-	RouteIndex *plat_routes_idx, *known_routes_idx;
+	const PlatRouteIndex *plat_routes_idx;
+	RouteIndex *known_routes_idx;
 	gboolean success = TRUE;
 	guint i, i_type;
 	GArray *to_delete_indexes = NULL;
@@ -450,20 +698,27 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 	gint64 *p_effective_metric = NULL;
 	gboolean ipx_routes_changed = FALSE;
 	gint64 *effective_metrics = NULL;
+	gs_unref_array GArray *batch = NULL;
+	guint i_batch_add;
+
+	NM_PROBE4 (route__sync__start, vtable->vt->addr_family, ifindex,
+	           known_routes ? known_routes->len : 0, full_sync);
 
 	nm_platform_process_events (priv->platform);
 
+	/* All changes to platform are queued in @batch and committed at once at the end. */
+	batch = nm_platform_batch_new ();
+
 	ipx_routes = vtable->vt->is_ip4 ? &priv->ip4_routes : &priv->ip6_routes;
-	plat_routes = vtable->vt->route_get_all (priv->platform, ifindex,
-	                                         ignore_kernel_routes
-	                                             ? NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT
-	                                             : NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL);
-	plat_routes_idx = _route_index_create (vtable, plat_routes);
+	/* Index the routes directly in the platform cache, without copying them.
+	 * We don't call into platform until nm_platform_batch_commit() below,
+	 * so the view stays valid. */
+	plat_generation = nm_platform_cache_get_generation (priv->platform);
+	plat_routes_idx = _plat_route_index_get (vtable, self, ipx_routes, ifindex);
 	known_routes_idx = _route_index_create (vtable, known_routes);
 
 	effective_metrics = &g_array_index (ipx_routes->effective_metrics, gint64, 0);
 
-	ASSERT_route_index_valid (vtable, plat_routes, plat_routes_idx, TRUE);
 	ASSERT_route_index_valid (vtable, known_routes, known_routes_idx, FALSE);
 
 	_LOGD (vtable->vt->addr_family, "%3d: sync %u IPv%c routes", ifindex, known_routes_idx->len, vtable->vt->is_ip4 ? '4' : '6');
@@ -541,12 +796,10 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 		 * known by route-manager, and are now deleted.
 		 ***************************************************************************/
 
-		/* iterate over @to_delete_indexes and @plat_routes.
+		/* iterate over @to_delete_indexes and look up the routes in @plat_routes_idx.
 		 * @to_delete_indexes contains the indexes (relative to ipx_routes->index) of items
 		 * we are about to delete. */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
 		for (i = 0; i < to_delete_indexes->len; i++) {
-			int route_dest_cmp_result = 0;
 			i_ipx_routes = g_array_index (to_delete_indexes, guint, i);
 			cur_ipx_route = ipx_routes->index->entries[i_ipx_routes];
 			p_effective_metric = &effective_metrics[i_ipx_routes];
@@ -556,33 +809,29 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			if (*p_effective_metric == -1)
 				continue;
 
-			/* skip over @plat_routes that are ordered before our @cur_ipx_route. */
-			while (   cur_plat_route
-			       && (route_dest_cmp_result = vtable->route_dest_cmp (cur_plat_route, cur_ipx_route)) <= 0) {
-				if (   route_dest_cmp_result == 0
-				    && cur_plat_route->rx.metric >= *p_effective_metric)
-					break;
-				cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
-			}
-
-			if (!cur_plat_route) {
-				/* no more platform routes. Break the loop. */
-				break;
-			}
-
-			if (   route_dest_cmp_result == 0
-			    && cur_plat_route->rx.metric == *p_effective_metric) {
+			cur_plat_route = _plat_route_index_lookup (vtable, plat_routes_idx, cur_ipx_route, *p_effective_metric, ignore_kernel_routes);
+			if (cur_plat_route) {
 				/* we are about to delete cur_ipx_route and we have a matching route
 				 * in platform. Delete it. */
-				_LOGt (vtable->vt->addr_family, "%3d: platform rt-rm #%u - %s", ifindex, i_plat_routes,
+				_LOGt (vtable->vt->addr_family, "%3d: platform rt-rm %s", ifindex,
 				       vtable->vt->route_to_string (cur_plat_route, NULL, 0));
-				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
+				vtable->vt->batch_route_delete (batch, ifindex, cur_plat_route);
 			}
 		}
 	}
 
 	/* Update @ipx_routes with the just learned changes. */
 	if (to_delete_indexes || to_add_routes) {
+		gs_free guint *order = NULL;
+		RouteIndex *new_index;
+		guint added_start;
+
+		/* remember the current order of @ipx_routes->index, as offsets into @ipx_routes->entries.
+		 * The pointers are invalidated by modifying @ipx_routes->entries below. */
+		order = g_new (guint, ipx_routes->index->len + 1);
+		for (i = 0; i < ipx_routes->index->len; i++)
+			order[i] = (((char *) ipx_routes->index->entries[i]) - ipx_routes->entries->data) / vtable->vt->sizeof_route;
+
 		if (to_delete_indexes) {
 			for (i = 0; i < to_delete_indexes->len; i++) {
 				guint idx = g_array_index (to_delete_indexes, guint, i);
@@ -594,8 +843,8 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			g_array_sort (to_delete_indexes, (GCompareFunc) _sort_indexes_cmp);
 			nm_utils_array_remove_at_indexes (ipx_routes->entries, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
 			nm_utils_array_remove_at_indexes (ipx_routes->effective_metrics_reverse, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
-			g_array_unref (to_delete_indexes);
 		}
+		added_start = ipx_routes->entries->len;
 		if (to_add_routes) {
 			guint j = ipx_routes->effective_metrics_reverse->len;
 
@@ -617,8 +866,17 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			}
 			g_ptr_array_unref (to_add_routes);
 		}
+		new_index = _route_index_update (vtable,
+		                                 ipx_routes->index,
+		                                 order,
+		                                 to_delete_indexes ? &g_array_index (to_delete_indexes, guint, 0) : NULL,
+		                                 to_delete_indexes ? to_delete_indexes->len : 0,
+		                                 ipx_routes->entries,
+		                                 added_start);
 		g_free (ipx_routes->index);
-		ipx_routes->index = _route_index_create (vtable, ipx_routes->entries);
+		ipx_routes->index = new_index;
+		if (to_delete_indexes)
+			g_array_unref (to_delete_indexes);
 		ipx_routes_changed = TRUE;
 		ASSERT_route_index_valid (vtable, ipx_routes->entries, ipx_routes->index, TRUE);
 	}
@@ -703,6 +961,16 @@ next:
 			       vtable->vt->route_to_string (cur_ipx_route, NULL, 0),
 			       (long long) *p_effective_metric);
 		}
+
+		/* Rebuild the identity index of the routes as we configure them. */
+		_route_id_index_reset (&ipx_routes->effective_ids, ipx_routes->index->len);
+		for (i_ipx_routes = 0; i_ipx_routes < ipx_routes->index->len; i_ipx_routes++) {
+			if (effective_metrics[i_ipx_routes] == -1)
+				continue;
+			cur_ipx_route = ipx_routes->index->entries[i_ipx_routes];
+			_route_id_index_add (vtable, &ipx_routes->effective_ids, i_ipx_routes, cur_ipx_route,
+			                     effective_metrics[i_ipx_routes], cur_ipx_route->rx.ifindex);
+		}
 	}
 
 	if (full_sync) {
@@ -713,38 +981,21 @@ next:
 		 * the interface.
 		 ***************************************************************************/
 
-		/* iterate over @plat_routes and @ipx_routes */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
-		cur_ipx_route = _get_next_ipx_route (ipx_routes->index, TRUE, &i_ipx_routes, ifindex);
-		if (cur_ipx_route)
-			p_effective_metric = &effective_metrics[i_ipx_routes];
-		while (cur_plat_route) {
-			int route_dest_cmp_result = 0;
+		/* iterate over @plat_routes and look them up in @ipx_routes */
+		for (i_plat_routes = 0; i_plat_routes < plat_routes_idx->len; i_plat_routes++) {
+			cur_plat_route = plat_routes_idx->routes[i_plat_routes];
 
 			g_assert (cur_plat_route->rx.ifindex == ifindex);
 
-			_LOGt (vtable->vt->addr_family, "%3d: platform rt    #%u - %s", ifindex, i_plat_routes, vtable->vt->route_to_string (cur_plat_route, NULL, 0));
-
-			/* skip over @cur_ipx_route that are ordered before @cur_plat_route */
-			while (   cur_ipx_route
-			       && ((route_dest_cmp_result = vtable->route_dest_cmp (cur_ipx_route, cur_plat_route)) <= 0)) {
-				if (   route_dest_cmp_result == 0
-				    && *p_effective_metric != -1
-				    && *p_effective_metric >= cur_plat_route->rx.metric) {
-					break;
-				}
-				cur_ipx_route = _get_next_ipx_route (ipx_routes->index, FALSE, &i_ipx_routes, ifindex);
-				if (cur_ipx_route)
-					p_effective_metric = &effective_metrics[i_ipx_routes];
-			}
+			if (   ignore_kernel_routes
+			    && cur_plat_route->rx.rt_source == NM_IP_CONFIG_SOURCE_RTPROT_KERNEL)
+				continue;
 
-			/* if @cur_ipx_route is not equal to @plat_route, the route must be deleted. */
-			if (   !cur_ipx_route
-			    || route_dest_cmp_result != 0
-			    || *p_effective_metric != cur_plat_route->rx.metric)
-				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
+			_LOGt (vtable->vt->addr_family, "%3d: platform rt    #%u - %s", ifindex, i_plat_routes, vtable->vt->route_to_string (cur_plat_route, NULL, 0));
 
-			cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
+			/* if there is no @ipx_routes entry with this effective metric, the route must be deleted. */
+			if (!_route_id_index_lookup (vtable, &ipx_routes->effective_ids, cur_plat_route, cur_plat_route->rx.metric, ifindex))
+				vtable->vt->batch_route_delete (batch, ifindex, cur_plat_route);
 		}
 	}
 
@@ -815,15 +1066,15 @@ next:
 					gateway_routes = g_array_new (FALSE, FALSE, sizeof (guint));
 				g_array_append_val (gateway_routes, i_ipx_routes);
 			} else
-				vtable->vt->route_add (priv->platform, 0, cur_ipx_route, *p_effective_metric);
+				vtable->vt->batch_route_add (batch, 0, cur_ipx_route, *p_effective_metric);
 		}
 
 		if (gateway_routes) {
 			for (i = 0; i < gateway_routes->len; i++) {
 				i_ipx_routes = g_array_index (gateway_routes, guint, i);
-				vtable->vt->route_add (priv->platform, 0,
-				                       ipx_routes->index->entries[i_ipx_routes],
-				                       effective_metrics[i_ipx_routes]);
+				vtable->vt->batch_route_add (batch, 0,
+				                             ipx_routes->index->entries[i_ipx_routes],
+				                             effective_metrics[i_ipx_routes]);
 			}
 			g_array_unref (gateway_routes);
 		}
@@ -833,16 +1084,14 @@ next:
 	 * Sync @ipx_routes for @ifindex to platform
 	 **************************************************************************/
 
+	i_batch_add = batch->len;
 	for (i_type = 0; i_type < 2; i_type++) {
-		/* iterate (twice) over @ipx_routes and @plat_routes */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
+		/* iterate (twice) over @ipx_routes and look them up in @plat_routes */
 		cur_ipx_route = _get_next_ipx_route (ipx_routes->index, TRUE, &i_ipx_routes, ifindex);
 		/* Iterate here over @ipx_routes instead of @known_routes. That is done because
 		 * we need to know whether a route is shadowed by another route, and that
 		 * requires to look at @ipx_routes. */
 		for (; cur_ipx_route; cur_ipx_route = _get_next_ipx_route (ipx_routes->index, FALSE, &i_ipx_routes, ifindex)) {
-			int route_dest_cmp_result = -1;
-
 			if (   (i_type == 0 && !VTABLE_IS_DEVICE_ROUTE (vtable, cur_ipx_route))
 			    || (i_type == 1 && VTABLE_IS_DEVICE_ROUTE (vtable, cur_ipx_route))) {
 				/* Make two runs over the list of @ipx_routes. On the first, only add
@@ -857,40 +1106,44 @@ next:
 				continue;
 			}
 
-			/* skip over @plat_routes that are ordered before our @cur_ipx_route. */
-			while (   cur_plat_route
-			       && (route_dest_cmp_result = vtable->route_dest_cmp (cur_plat_route, cur_ipx_route)) <= 0) {
-				if (   route_dest_cmp_result == 0
-				    && cur_plat_route->rx.metric >= *p_effective_metric)
-					break;
-				cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
-			}
+			cur_plat_route = _plat_route_index_lookup (vtable, plat_routes_idx, cur_ipx_route, *p_effective_metric, ignore_kernel_routes);
 
 			/* only add the route if we don't have an identical route in @plat_routes,
 			 * i.e. if @cur_plat_route is different from @cur_ipx_route. */
 			if (   !cur_plat_route
-			    || route_dest_cmp_result != 0
-			    || !_route_equals_ignoring_ifindex (vtable, cur_plat_route, cur_ipx_route, *p_effective_metric)) {
-
-				if (!vtable->vt->route_add (priv->platform, ifindex, cur_ipx_route, *p_effective_metric)) {
-					if (cur_ipx_route->rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
-						_LOGD (vtable->vt->addr_family,
-						       "ignore error adding IPv%c route to kernel: %s",
-						       vtable->vt->is_ip4 ? '4' : '6',
-						       vtable->vt->route_to_string (cur_ipx_route, NULL, 0));
-					} else {
-						/* Remember that there was a failure, but for now continue trying
-						 * to sync the remaining routes. */
-						success = FALSE;
-					}
-				}
-			}
+			    || !_route_equals_ignoring_ifindex (vtable, cur_plat_route, cur_ipx_route, *p_effective_metric))
+				vtable->vt->batch_route_add (batch, ifindex, cur_ipx_route, *p_effective_metric);
+		}
+	}
+
+	/* the platform routes must not have changed while we used the view. */
+	nm_assert (plat_generation == nm_platform_cache_get_generation (priv->platform));
+
+	/* Send all queued changes. Device routes were queued before gateway routes, and
+	 * kernel handles the requests in order. */
+	nm_platform_batch_commit (priv->platform, batch);
+
+	for (i = i_batch_add; i < batch->len; i++) {
+		const NMPlatformBatchEntry *entry = &g_array_index (batch, NMPlatformBatchEntry, i);
+
+		if (entry->success)
+			continue;
+
+		if (entry->ipx_route.rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
+			_LOGD (vtable->vt->addr_family,
+			       "ignore error adding IPv%c route to kernel: %s",
+			       vtable->vt->is_ip4 ? '4' : '6',
+			       vtable->vt->route_to_string (&entry->ipx_route, NULL, 0));
+		} else {
+			/* Remember that there was a failure, but continue checking
+			 * the remaining routes. */
+			success = FALSE;
 		}
 	}
 
 	g_free (known_routes_idx);
-	g_free (plat_routes_idx);
-	g_array_unref (plat_routes);
+
+	NM_PROBE3 (route__sync__end, vtable->vt->addr_family, ifindex, success);
 
 	return success;
 }
@@ -959,16 +1212,25 @@ _ip4_device_routes_entry_expired (const IP4DeviceRoutePurgeEntry *entry, gint64
 	return entry->scheduled_at_ns + IP4_DEVICE_ROUTES_WAIT_TIME_NS < now;
 }
 
+static gint64
+_ip4_device_routes_wheel_tick (gint64 now_ns)
+{
+	return now_ns / IP4_DEVICE_ROUTES_WHEEL_TICK_NS;
+}
+
 static IP4DeviceRoutePurgeEntry *
 _ip4_device_routes_purge_entry_create (NMRouteManager *self, const NMPlatformIP4Route *route, gint64 now_ns)
 {
 	IP4DeviceRoutePurgeEntry *entry;
 
-	entry = g_slice_new (IP4DeviceRoutePurgeEntry);
+	entry = g_slice_new0 (IP4DeviceRoutePurgeEntry);
 
 	entry->self = self;
 	entry->scheduled_at_ns = now_ns;
-	entry->idle_id = 0;
+	/* the first tick that starts after the entry expired. */
+	entry->expire_tick = _ip4_device_routes_wheel_tick (now_ns + IP4_DEVICE_ROUTES_WAIT_TIME_NS) + 1;
+	entry->wheel_link.data = entry;
+	entry->purge_link.data = entry;
 	entry->obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) route);
 	return entry;
 }
@@ -976,64 +1238,69 @@ _ip4_device_routes_purge_entry_create (NMRouteManager *self, const NMPlatformIP4
 static void
 _ip4_device_routes_purge_entry_free (IP4DeviceRoutePurgeEntry *entry)
 {
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (entry->self);
+
+	g_queue_unlink (&priv->ip4_device_routes.wheel[entry->expire_tick % IP4_DEVICE_ROUTES_WHEEL_SLOTS],
+	                &entry->wheel_link);
+	if (entry->purge_pending)
+		g_queue_unlink (&priv->ip4_device_routes.purge_list, &entry->purge_link);
 	nmp_object_unref (entry->obj);
-	nm_clear_g_source (&entry->idle_id);
 	g_slice_free (IP4DeviceRoutePurgeEntry, entry);
 }
 
 static gboolean
-_ip4_device_routes_idle_cb (IP4DeviceRoutePurgeEntry *entry)
+_ip4_device_routes_purge_cb (NMRouteManager *self)
 {
-	NMRouteManager *self;
-	NMRouteManagerPrivate *priv;
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
+	gs_unref_array GArray *batch = NULL;
+	GList *link;
 
-	nm_clear_g_source (&entry->idle_id);
+	priv->ip4_device_routes.purge_id = 0;
 
-	self = entry->self;
-	priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
-	if (_route_index_find (&vtable_v4, priv->ip4_routes.index, &entry->obj->ipx_route) >= 0) {
-		/* we have an identical route in our list. Don't delete it. */
-		return G_SOURCE_REMOVE;
-	}
+	/* delete all routes that showed up since the last run with one batch. */
+	while ((link = g_queue_peek_head_link (&priv->ip4_device_routes.purge_list))) {
+		IP4DeviceRoutePurgeEntry *entry = link->data;
 
-	_LOGt (vtable_v4.vt->addr_family, "device-route: delete %s", nmp_object_to_string (entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
+		g_queue_unlink (&priv->ip4_device_routes.purge_list, link);
+		entry->purge_pending = FALSE;
 
-	nm_platform_ip4_route_delete (priv->platform,
-	                              entry->obj->ip4_route.ifindex,
-	                              entry->obj->ip4_route.network,
-	                              entry->obj->ip4_route.plen,
-	                              entry->obj->ip4_route.metric);
+		if (_route_index_find (&vtable_v4, priv->ip4_routes.index, &entry->obj->ipx_route) >= 0) {
+			/* we have an identical route in our list. Don't delete it. */
+			continue;
+		}
+
+		_LOGt (vtable_v4.vt->addr_family, "device-route: delete %s", nmp_object_to_string (entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
+
+		if (!batch)
+			batch = nm_platform_batch_new ();
+		vtable_v4.vt->batch_route_delete (batch, entry->obj->ip4_route.ifindex, &entry->obj->ipx_route);
+
+		g_hash_table_remove (priv->ip4_device_routes.entries, entry->obj);
+	}
+
+	if (batch)
+		nm_platform_batch_commit (priv->platform, batch);
 
-	g_hash_table_remove (priv->ip4_device_routes.entries, entry->obj);
 	_ip4_device_routes_cancel (self);
 	return G_SOURCE_REMOVE;
 }
 
 static void
-_ip4_device_routes_ip4_route_changed (NMPlatform *platform,
-                                      NMPObjectType obj_type,
-                                      int ifindex,
-                                      const NMPlatformIP4Route *route,
-                                      NMPlatformSignalChangeType change_type,
-                                      NMRouteManager *self)
+_ip4_device_routes_ip4_route_changed (NMRouteManager *self,
+                                      const NMPObject *obj)
 {
 	NMRouteManagerPrivate *priv;
-	NMPObject obj_needle;
 	IP4DeviceRoutePurgeEntry *entry;
 
-	if (change_type == NM_PLATFORM_SIGNAL_REMOVED)
-		return;
-
-	if (   route->rt_source != NM_IP_CONFIG_SOURCE_RTPROT_KERNEL
-	    || route->metric != 0) {
+	if (   obj->ip4_route.rt_source != NM_IP_CONFIG_SOURCE_RTPROT_KERNEL
+	    || obj->ip4_route.metric != 0) {
 		/* we don't have an automatically created device route at hand. Bail out early. */
 		return;
 	}
 
 	priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
 
-	entry = g_hash_table_lookup (priv->ip4_device_routes.entries,
-	                             nmp_object_stackinit (&obj_needle, NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) route));
+	entry = g_hash_table_lookup (priv->ip4_device_routes.entries, obj);
 	if (!entry)
 		return;
 
@@ -1044,9 +1311,34 @@ _ip4_device_routes_ip4_route_changed (NMPlatform *platform,
 		return;
 	}
 
-	if (entry->idle_id == 0) {
+	if (!entry->purge_pending) {
 		_LOGt (vtable_v4.vt->addr_family, "device-route: schedule %s", nmp_object_to_string (entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
-		entry->idle_id = g_idle_add ((GSourceFunc) _ip4_device_routes_idle_cb, entry);
+		entry->purge_pending = TRUE;
+		g_queue_push_tail_link (&priv->ip4_device_routes.purge_list, &entry->purge_link);
+		if (!priv->ip4_device_routes.purge_id)
+			priv->ip4_device_routes.purge_id = g_idle_add ((GSourceFunc) _ip4_device_routes_purge_cb, self);
+	}
+}
+
+static void
+_ip4_device_routes_changes_batch_cb (NMPlatform *platform,
+                                     const GArray *batch,
+                                     NMRouteManager *self)
+{
+	guint i;
+
+	for (i = 0; i < batch->len; i++) {
+		const NMPlatformChangesBatchEntry *change = &g_array_index (batch, NMPlatformChangesBatchEntry, i);
+
+		if (   change->obj_type != NMP_OBJECT_TYPE_IP4_ROUTE
+		    || change->change_type == NM_PLATFORM_SIGNAL_REMOVED)
+			continue;
+
+		/* the watch might get cancelled by a previous entry. */
+		if (!NM_ROUTE_MANAGER_GET_PRIVATE (self)->ip4_device_routes.gc_id)
+			return;
+
+		_ip4_device_routes_ip4_route_changed (self, change->obj);
 	}
 }
 
@@ -1060,8 +1352,9 @@ _ip4_device_routes_cancel (NMRouteManager *self)
 			return G_SOURCE_CONTINUE;
 		_LOGt (vtable_v4.vt->addr_family, "device-route: cancel");
 		if (priv->platform)
-			g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_ip4_device_routes_ip4_route_changed), self);
+			g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_ip4_device_routes_changes_batch_cb), self);
 		nm_clear_g_source (&priv->ip4_device_routes.gc_id);
+		nm_clear_g_source (&priv->ip4_device_routes.purge_id);
 	}
 	return G_SOURCE_REMOVE;
 }
@@ -1070,17 +1363,34 @@ static gboolean
 _ip4_device_routes_gc (NMRouteManager *self)
 {
 	NMRouteManagerPrivate *priv;
-	GHashTableIter iter;
-	IP4DeviceRoutePurgeEntry *entry;
-	gint64 now = nm_utils_get_monotonic_timestamp_ns ();
+	gint64 now_tick;
+	GList *link;
 
 	priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
 
-	g_hash_table_iter_init (&iter, priv->ip4_device_routes.entries);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
-		if (_ip4_device_routes_entry_expired (entry, now)) {
+	now_tick = _ip4_device_routes_wheel_tick (nm_utils_get_monotonic_timestamp_ns ());
+
+	/* advance the wheel up to the current tick, and drop all entries of the
+	 * passed slots. If we were delayed for more than a full round, visiting
+	 * each slot once suffices. */
+	if (now_tick - priv->ip4_device_routes.wheel_tick > IP4_DEVICE_ROUTES_WHEEL_SLOTS)
+		priv->ip4_device_routes.wheel_tick = now_tick - IP4_DEVICE_ROUTES_WHEEL_SLOTS;
+
+	while (priv->ip4_device_routes.wheel_tick < now_tick) {
+		GQueue *slot;
+
+		priv->ip4_device_routes.wheel_tick++;
+		slot = &priv->ip4_device_routes.wheel[priv->ip4_device_routes.wheel_tick % IP4_DEVICE_ROUTES_WHEEL_SLOTS];
+
+		link = slot->head;
+		while (link) {
+			IP4DeviceRoutePurgeEntry *entry = link->data;
+
+			link = link->next;
+			if (entry->expire_tick > now_tick)
+				continue;
 			_LOGt (vtable_v4.vt->addr_family, "device-route: cleanup-gc %s", nmp_object_to_string (entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
-			g_hash_table_iter_remove (&iter);
+			g_hash_table_remove (priv->ip4_device_routes.entries, entry->obj);
 		}
 	}
 
@@ -1119,10 +1429,13 @@ nm_route_manager_ip4_route_register_device_route_purge_list (NMRouteManager *sel
 		g_hash_table_replace (priv->ip4_device_routes.entries,
 		                      nmp_object_ref (entry->obj),
 		                      entry);
+		g_queue_push_tail_link (&priv->ip4_device_routes.wheel[entry->expire_tick % IP4_DEVICE_ROUTES_WHEEL_SLOTS],
+		                        &entry->wheel_link);
 	}
 	if (priv->ip4_device_routes.gc_id == 0) {
-		g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (_ip4_device_routes_ip4_route_changed), self);
-		priv->ip4_device_routes.gc_id = g_timeout_add (IP4_DEVICE_ROUTES_GC_INTERVAL_SEC, (GSourceFunc) _ip4_device_routes_gc, self);
+		g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_CHANGES_BATCH, G_CALLBACK (_ip4_device_routes_changes_batch_cb), self);
+		priv->ip4_device_routes.wheel_tick = _ip4_device_routes_wheel_tick (now_ns);
+		priv->ip4_device_routes.gc_id = g_timeout_add (IP4_DEVICE_ROUTES_WHEEL_TICK_NS / NM_UTILS_NS_PER_MSEC, (GSourceFunc) _ip4_device_routes_gc, self);
 	}
 }
 
@@ -1176,6 +1489,8 @@ nm_route_manager_init (NMRouteManager *self)
 	priv->ip6_routes.effective_metrics_reverse = g_array_new (FALSE, FALSE, sizeof (gint64));
 	priv->ip4_routes.index = _route_index_create (&vtable_v4, priv->ip4_routes.entries);
 	priv->ip6_routes.index = _route_index_create (&vtable_v6, priv->ip6_routes.entries);
+	priv->ip4_routes.plat_indexes = g_hash_table_new_full (g_int_hash, g_int_equal, NULL, (GDestroyNotify) _plat_route_index_free);
+	priv->ip6_routes.plat_indexes = g_hash_table_new_full (g_int_hash, g_int_equal, NULL, (GDestroyNotify) _plat_route_index_free);
 	priv->ip4_device_routes.entries = g_hash_table_new_full ((GHashFunc) nmp_object_id_hash,
 	                                                         (GEqualFunc) nmp_object_id_equal,
 	                                                         (GDestroyNotify) nmp_object_unref,
@@ -1215,6 +1530,10 @@ finalize (GObject *object)
 	g_array_free (priv->ip6_routes.effective_metrics_reverse, TRUE);
 	g_free (priv->ip4_routes.index);
 	g_free (priv->ip6_routes.index);
+	g_hash_table_unref (priv->ip4_routes.plat_indexes);
+	g_hash_table_unref (priv->ip6_routes.plat_indexes);
+	_route_id_index_clear (&priv->ip4_routes.effective_ids);
+	_route_id_index_clear (&priv->ip6_routes.effective_ids);
 
 	g_hash_table_unref (priv->ip4_device_routes.entries);
 
@@ -0,0 +1,225 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-startup-profile.h"
+
+#include <unistd.h>
+
+typedef struct {
+	const char *phase;
+	char *detail;
+	gint64 begin_us;
+	/* -1 for an instant event */
+	gint64 duration_us;
+} Event;
+
+static struct {
+	gboolean enabled;
+	gint64 start_us;
+	GArray *events;
+} profile;
+
+/*****************************************************************************/
+
+/**
+ * nm_startup_profile_enable:
+ * @start_us: the monotonic time in usec at which the startup began.
+ *   The trace is relative to it.
+ */
+void
+nm_startup_profile_enable (gint64 start_us)
+{
+	if (profile.enabled)
+		return;
+
+	profile.enabled = TRUE;
+	profile.start_us = start_us;
+	profile.events = g_array_new (FALSE, FALSE, sizeof (Event));
+}
+
+gboolean
+nm_startup_profile_enabled (void)
+{
+	return profile.enabled;
+}
+
+/**
+ * nm_startup_profile_begin:
+ *
+ * Returns: the monotonic time in usec to pass to nm_startup_profile_end()
+ *   or 0, if profiling is disabled.
+ */
+gint64
+nm_startup_profile_begin (void)
+{
+	return profile.enabled ? g_get_monotonic_time () : 0;
+}
+
+static void
+_add_event (const char *phase, const char *detail, gint64 begin_us, gint64 duration_us)
+{
+	Event event = {
+		.phase = phase,
+		.detail = g_strdup (detail),
+		.begin_us = begin_us,
+		.duration_us = duration_us,
+	};
+
+	g_array_append_val (profile.events, event);
+}
+
+/**
+ * nm_startup_profile_end:
+ * @begin_us: the return value of nm_startup_profile_begin()
+ * @phase: the name of the phase, a static string
+ * @detail: (allow-none): e.g. the name of the plugin
+ */
+void
+nm_startup_profile_end (gint64 begin_us, const char *phase, const char *detail)
+{
+	if (!profile.enabled || !begin_us)
+		return;
+
+	_add_event (phase, detail, begin_us, g_get_monotonic_time () - begin_us);
+}
+
+/**
+ * nm_startup_profile_mark:
+ * @phase: the name of the event, a static string
+ * @detail: (allow-none): e.g. the name of the interface
+ *
+ * Records a point in time, like the first completed activation.
+ */
+void
+nm_startup_profile_mark (const char *phase, const char *detail)
+{
+	if (!profile.enabled)
+		return;
+
+	_add_event (phase, detail, g_get_monotonic_time (), -1);
+}
+
+/*****************************************************************************/
+
+static void
+_json_append_string (GString *str, const char *s)
+{
+	g_string_append_c (str, '"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			g_string_append_printf (str, "\\%c", *s);
+		else if ((guchar) *s < 0x20)
+			g_string_append_printf (str, "\\u%04x", (guint) (guchar) *s);
+		else
+			g_string_append_c (str, *s);
+	}
+	g_string_append_c (str, '"');
+}
+
+/* Writes the events in the Trace Event Format understood by
+ * chrome://tracing: complete events ("X") for the phases
+ * and instant events ("i") for the marks. */
+static void
+_write_trace (void)
+{
+	GString *str;
+	GError *error = NULL;
+	guint i;
+
+	str = g_string_new ("{\"traceEvents\":[\n");
+	for (i = 0; i < profile.events->len; i++) {
+		const Event *event = &g_array_index (profile.events, Event, i);
+
+		g_string_append (str, i ? ",\n{\"name\":" : "{\"name\":");
+		_json_append_string (str, event->phase);
+		g_string_append_printf (str, ",\"cat\":\"startup\",\"pid\":%ld,\"tid\":1,\"ts\":%"G_GINT64_FORMAT,
+		                        (long) getpid (),
+		                        event->begin_us - profile.start_us);
+		if (event->duration_us >= 0)
+			g_string_append_printf (str, ",\"ph\":\"X\",\"dur\":%"G_GINT64_FORMAT, event->duration_us);
+		else
+			g_string_append (str, ",\"ph\":\"i\",\"s\":\"p\"");
+		if (event->detail) {
+			g_string_append (str, ",\"args\":{\"detail\":");
+			_json_append_string (str, event->detail);
+			g_string_append_c (str, '}');
+		}
+		g_string_append_c (str, '}');
+	}
+	g_string_append (str, "\n]}\n");
+
+	if (!g_file_set_contents (NM_STARTUP_PROFILE_TRACE_FILE, str->str, str->len, &error)) {
+		nm_log_warn (LOGD_CORE, "startup-profile: failed to write %s: %s",
+		             NM_STARTUP_PROFILE_TRACE_FILE, error->message);
+		g_clear_error (&error);
+	} else
+		nm_log_info (LOGD_CORE, "startup-profile: trace written to %s", NM_STARTUP_PROFILE_TRACE_FILE);
+
+	g_string_free (str, TRUE);
+}
+
+/**
+ * nm_startup_profile_finish:
+ *
+ * Logs the phases at info level, writes the trace to
+ * %NM_STARTUP_PROFILE_TRACE_FILE and stops recording.
+ */
+void
+nm_startup_profile_finish (void)
+{
+	gint64 now;
+	guint i;
+
+	if (!profile.enabled)
+		return;
+	profile.enabled = FALSE;
+
+	now = g_get_monotonic_time ();
+	nm_log_info (LOGD_CORE, "startup-profile: startup took %"G_GINT64_FORMAT" msec",
+	             (now - profile.start_us) / 1000);
+	for (i = 0; i < profile.events->len; i++) {
+		const Event *event = &g_array_index (profile.events, Event, i);
+		char duration[64];
+
+		if (event->duration_us >= 0) {
+			nm_sprintf_buf (duration, ": %"G_GINT64_FORMAT".%03d msec",
+			                event->duration_us / 1000,
+			                (int) (event->duration_us % 1000));
+		} else
+			duration[0] = '\0';
+
+		nm_log_info (LOGD_CORE, "startup-profile: +%"G_GINT64_FORMAT" msec %s%s%s%s%s",
+		             (event->begin_us - profile.start_us) / 1000,
+		             event->phase,
+		             event->detail ? " (" : "",
+		             event->detail ? event->detail : "",
+		             event->detail ? ")" : "",
+		             duration);
+	}
+
+	_write_trace ();
+
+	for (i = 0; i < profile.events->len; i++)
+		g_free (g_array_index (profile.events, Event, i).detail);
+	g_array_unref (profile.events);
+	profile.events = NULL;
+}
@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_STARTUP_PROFILE_H__
+#define __NETWORKMANAGER_STARTUP_PROFILE_H__
+
+/* Records how long the phases of the startup take, when enabled with
+ * --profile-startup or the "profile-startup" option of [main]. Until
+ * then, and after nm_startup_profile_finish(), all calls are no-ops.
+ *
+ * A phase is measured as:
+ *
+ *   gint64 ts = nm_startup_profile_begin ();
+ *   ...
+ *   nm_startup_profile_end (ts, "connections-load", plugin_name);
+ */
+
+#define NM_STARTUP_PROFILE_TRACE_FILE NMRUNDIR "/startup-trace.json"
+
+void nm_startup_profile_enable (gint64 start_us);
+gboolean nm_startup_profile_enabled (void);
+
+gint64 nm_startup_profile_begin (void);
+void nm_startup_profile_end (gint64 begin_us, const char *phase, const char *detail);
+void nm_startup_profile_mark (const char *phase, const char *detail);
+
+void nm_startup_profile_finish (void);
+
+#endif /* __NETWORKMANAGER_STARTUP_PROFILE_H__ */
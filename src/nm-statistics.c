@@ -0,0 +1,345 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-statistics.h"
+
+#include "nm-dbus-interface.h"
+#include "nm-linux-platform.h"
+#include "nm-loop-sched.h"
+#include "nm-watchdog.h"
+#include "nmp-object.h"
+
+#include "nmdbus-statistics.h"
+
+typedef struct {
+	guint64 count;
+	guint64 total_usec;
+	guint64 max_usec;
+	guint64 buckets[NM_STATISTICS_HISTOGRAM_BUCKETS];
+} Histogram;
+
+typedef struct {
+	guint64 objects;
+	guint64 bytes;
+} Memory;
+
+static guint64 counters[_NM_STATISTICS_COUNTER_NUM];
+static Histogram histograms[_NM_STATISTICS_HISTOGRAM_NUM];
+static Memory memory[_NM_STATISTICS_MEMORY_NUM];
+
+static const char *const counter_names[_NM_STATISTICS_COUNTER_NUM] = {
+	[NM_STATISTICS_COUNTER_DBUS_CALLS]                 = "dbus-calls",
+	[NM_STATISTICS_COUNTER_DBUS_PROPERTIES_CHANGED]    = "dbus-properties-changed",
+	[NM_STATISTICS_COUNTER_MAIN_LOOP_STALLS]           = "main-loop-stalls",
+};
+
+static const char *const histogram_names[_NM_STATISTICS_HISTOGRAM_NUM] = {
+	[NM_STATISTICS_HISTOGRAM_NETLINK_EVENT]            = "netlink-event",
+	[NM_STATISTICS_HISTOGRAM_NETLINK_RESYNC]           = "netlink-resync",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_PREPARE]       = "activation-prepare",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_CONFIG]        = "activation-config",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_NEED_AUTH]     = "activation-need-auth",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CONFIG]     = "activation-ip-config",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CHECK]      = "activation-ip-check",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_SECONDARIES]   = "activation-secondaries",
+	[NM_STATISTICS_HISTOGRAM_ACTIVATION_TOTAL]         = "activation-total",
+	[NM_STATISTICS_HISTOGRAM_DNS_UPDATE]               = "dns-update",
+	[NM_STATISTICS_HISTOGRAM_MAIN_LOOP_DISPATCH]       = "main-loop-dispatch",
+};
+
+static const char *const memory_names[_NM_STATISTICS_MEMORY_NUM] = {
+	[NM_STATISTICS_MEMORY_SETTINGS_CONNECTIONS]        = "settings-connections",
+	[NM_STATISTICS_MEMORY_WIFI_APS]                    = "wifi-access-points",
+	[NM_STATISTICS_MEMORY_LLDP_NEIGHBORS]              = "lldp-neighbors",
+	[NM_STATISTICS_MEMORY_DBUS_SKELETONS]              = "dbus-skeletons",
+	[NM_STATISTICS_MEMORY_DHCP_CLIENTS]                = "dhcp-clients",
+	[NM_STATISTICS_MEMORY_RDISC]                       = "rdisc",
+};
+
+typedef struct {
+	GPollFunc orig_poll_func;
+} NMStatisticsPrivate;
+
+G_DEFINE_TYPE (NMStatistics, nm_statistics, NM_TYPE_EXPORTED_OBJECT)
+
+#define NM_STATISTICS_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_STATISTICS, NMStatisticsPrivate))
+
+NM_DEFINE_SINGLETON_GETTER (NMStatistics, nm_statistics_get, NM_TYPE_STATISTICS);
+
+/*****************************************************************************/
+
+void
+nm_statistics_inc (NMStatisticsCounter counter)
+{
+	nm_assert (counter >= 0 && counter < _NM_STATISTICS_COUNTER_NUM);
+
+	counters[counter]++;
+}
+
+void
+nm_statistics_record (NMStatisticsHistogram histogram, gint64 usec)
+{
+	Histogram *h;
+	guint bucket;
+
+	nm_assert (histogram >= 0 && histogram < _NM_STATISTICS_HISTOGRAM_NUM);
+
+	/* the monotonic clock doesn't go backwards, but callers might
+	 * compute the duration from a timestamp that was never set. */
+	if (usec < 0)
+		return;
+
+	h = &histograms[histogram];
+	h->count++;
+	h->total_usec += usec;
+	if ((guint64) usec > h->max_usec)
+		h->max_usec = usec;
+
+	bucket = usec ? g_bit_storage ((guint64) usec) : 0;
+	h->buckets[MIN (bucket, NM_STATISTICS_HISTOGRAM_BUCKETS - 1)]++;
+}
+
+void
+nm_statistics_memory_add (NMStatisticsMemory type, gsize bytes)
+{
+	nm_assert (type >= 0 && type < _NM_STATISTICS_MEMORY_NUM);
+
+	memory[type].objects++;
+	memory[type].bytes += bytes;
+}
+
+void
+nm_statistics_memory_remove (NMStatisticsMemory type, gsize bytes)
+{
+	nm_assert (type >= 0 && type < _NM_STATISTICS_MEMORY_NUM);
+	nm_assert (memory[type].objects > 0 && memory[type].bytes >= bytes);
+
+	memory[type].objects--;
+	memory[type].bytes -= bytes;
+}
+
+/*****************************************************************************/
+
+/* The poll function of the default main context is wrapped to measure
+ * how long an iteration takes from the end of one poll() to the start of
+ * the next one. That is the time spent in check and dispatch of the ready
+ * sources, and the prepare of the next iteration. It costs two reads of
+ * the monotonic clock per iteration. */
+static GPollFunc main_loop_orig_poll_func;
+static gint64 main_loop_poll_returned;
+
+static gint
+_main_loop_poll_func (GPollFD *ufds, guint nfsd, gint timeout)
+{
+	gint64 dispatch_usec = 0;
+	gint r;
+
+	if (main_loop_poll_returned) {
+		dispatch_usec = g_get_monotonic_time () - main_loop_poll_returned;
+		nm_statistics_record (NM_STATISTICS_HISTOGRAM_MAIN_LOOP_DISPATCH, dispatch_usec);
+	}
+	nm_watchdog_poll_enter (dispatch_usec);
+
+	r = main_loop_orig_poll_func (ufds, nfsd, timeout);
+
+	main_loop_poll_returned = g_get_monotonic_time ();
+	nm_watchdog_poll_leave ();
+	return r;
+}
+
+/*****************************************************************************/
+
+static void
+_add_counter (GVariantBuilder *builder, const char *name, guint64 value)
+{
+	g_variant_builder_add (builder, "{st}", name, value);
+}
+
+static void
+impl_statistics_get_counters (NMStatistics *self,
+                              GDBusMethodInvocation *context)
+{
+	GVariantBuilder builder;
+	NMPlatform *platform;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+
+	for (i = 0; i < _NM_STATISTICS_COUNTER_NUM; i++)
+		_add_counter (&builder, counter_names[i], counters[i]);
+	_add_counter (&builder, "interned-strings", nm_intern_str_get_count ());
+
+	platform = NM_PLATFORM_GET;
+	if (NM_IS_LINUX_PLATFORM (platform)) {
+		NMLinuxPlatformNetlinkStats stats;
+
+		nm_linux_platform_get_netlink_stats (platform, &stats);
+		_add_counter (&builder, "netlink-overruns", stats.overruns);
+		_add_counter (&builder, "netlink-resyncs", stats.resyncs);
+		_add_counter (&builder, "netlink-resync-dumps", stats.resync_dumps);
+		_add_counter (&builder, "netlink-resync-messages", stats.resync_messages);
+		_add_counter (&builder, "netlink-recv-syscalls", stats.recv_syscalls);
+		_add_counter (&builder, "netlink-recv-datagrams", stats.recv_datagrams);
+		_add_counter (&builder, "netlink-recv-messages", stats.recv_messages);
+		_add_counter (&builder, "netlink-recv-bytes", stats.recv_bytes);
+		_add_counter (&builder, "netlink-newlink-skipped", stats.newlink_skipped);
+		_add_counter (&builder, "netlink-filtered-messages", stats.filtered_messages);
+		_add_counter (&builder, "netlink-budget-yields", stats.budget_yields);
+	}
+
+	for (i = 0; i < _NM_LOOP_SCHED_CLASS_NUM; i++) {
+		NMLoopSchedStats stats;
+		const char *name = nm_loop_sched_class_to_string (i);
+		char buf[64];
+
+		nm_loop_sched_get_stats (i, &stats);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-depth", name), stats.depth);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-depth-max", name), stats.depth_max);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-dispatched", name), stats.dispatched);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-yields", name), stats.yields);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-boosts", name), stats.boosts);
+		_add_counter (&builder, nm_sprintf_buf (buf, "sched-%s-wait-max-usec", name), stats.wait_max_usec);
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(a{st})", &builder));
+}
+
+static void
+impl_statistics_get_histograms (NMStatistics *self,
+                                GDBusMethodInvocation *context)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(tttat)}"));
+
+	for (i = 0; i < _NM_STATISTICS_HISTOGRAM_NUM; i++) {
+		const Histogram *h = &histograms[i];
+
+		g_variant_builder_add (&builder, "{s(ttt@at)}",
+		                       histogram_names[i],
+		                       h->count,
+		                       h->total_usec,
+		                       h->max_usec,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64,
+		                                                  h->buckets,
+		                                                  G_N_ELEMENTS (h->buckets),
+		                                                  sizeof (h->buckets[0])));
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(a{s(tttat)})", &builder));
+}
+
+static void
+impl_statistics_get_memory (NMStatistics *self,
+                            GDBusMethodInvocation *context)
+{
+	GVariantBuilder builder;
+	NMPObjectType obj_type;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(tt)}"));
+
+	/* the platform cache, including the released objects kept for reuse */
+	for (obj_type = NMP_OBJECT_TYPE_UNKNOWN + 1; obj_type <= NMP_OBJECT_TYPE_MAX; obj_type++) {
+		char name[64];
+		guint live, n_free;
+		gsize bytes;
+
+		nmp_object_pool_get_stats (obj_type, &live, NULL, &n_free, &bytes);
+		if (!live && !n_free)
+			continue;
+		nm_sprintf_buf (name, "platform-%s", nmp_class_from_type (obj_type)->obj_type_name);
+		g_variant_builder_add (&builder, "{s(tt)}", name, (guint64) live, (guint64) bytes);
+	}
+
+	for (i = 0; i < _NM_STATISTICS_MEMORY_NUM; i++) {
+		g_variant_builder_add (&builder, "{s(tt)}",
+		                       memory_names[i],
+		                       memory[i].objects,
+		                       memory[i].bytes);
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(a{s(tt)})", &builder));
+}
+
+/*****************************************************************************/
+
+static void
+nm_statistics_init (NMStatistics *self)
+{
+}
+
+static void
+constructed (GObject *object)
+{
+	NMStatisticsPrivate *priv = NM_STATISTICS_GET_PRIVATE (object);
+	GMainContext *context = g_main_context_default ();
+
+	G_OBJECT_CLASS (nm_statistics_parent_class)->constructed (object);
+
+	priv->orig_poll_func = g_main_context_get_poll_func (context);
+	main_loop_orig_poll_func = priv->orig_poll_func;
+	main_loop_poll_returned = 0;
+	g_main_context_set_poll_func (context, _main_loop_poll_func);
+
+	nm_exported_object_export (NM_EXPORTED_OBJECT (object));
+}
+
+static void
+dispose (GObject *object)
+{
+	NMStatisticsPrivate *priv = NM_STATISTICS_GET_PRIVATE (object);
+
+	if (priv->orig_poll_func) {
+		g_main_context_set_poll_func (g_main_context_default (), priv->orig_poll_func);
+		priv->orig_poll_func = NULL;
+	}
+
+	nm_exported_object_unexport (NM_EXPORTED_OBJECT (object));
+
+	G_OBJECT_CLASS (nm_statistics_parent_class)->dispose (object);
+}
+
+static void
+nm_statistics_class_init (NMStatisticsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	NMExportedObjectClass *exported_object_class = NM_EXPORTED_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (object_class, sizeof (NMStatisticsPrivate));
+
+	exported_object_class->export_path = NM_DBUS_PATH_STATISTICS;
+
+	object_class->constructed = constructed;
+	object_class->dispose = dispose;
+
+	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (klass),
+	                                        NMDBUS_TYPE_STATISTICS_SKELETON,
+	                                        "GetCounters", impl_statistics_get_counters,
+	                                        "GetHistograms", impl_statistics_get_histograms,
+	                                        "GetMemory", impl_statistics_get_memory,
+	                                        NULL);
+}
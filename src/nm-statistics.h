@@ -0,0 +1,113 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_STATISTICS_H__
+#define __NETWORKMANAGER_STATISTICS_H__
+
+#include "nm-exported-object.h"
+
+/* Runtime performance counters of the daemon.
+ *
+ * Recording is always enabled: a counter is an increment of a static
+ * variable, a histogram sample adds to a handful of static fields. The
+ * values are exported on D-Bus by the NMStatistics singleton. */
+
+typedef enum {
+	NM_STATISTICS_COUNTER_DBUS_CALLS,
+	NM_STATISTICS_COUNTER_DBUS_PROPERTIES_CHANGED,
+	/* iterations of the main loop over the watchdog threshold */
+	NM_STATISTICS_COUNTER_MAIN_LOOP_STALLS,
+
+	_NM_STATISTICS_COUNTER_NUM,
+} NMStatisticsCounter;
+
+typedef enum {
+	/* handling of the events of one wakeup of the netlink socket */
+	NM_STATISTICS_HISTOGRAM_NETLINK_EVENT,
+	/* a resynchronization of the platform cache after an overrun */
+	NM_STATISTICS_HISTOGRAM_NETLINK_RESYNC,
+
+	/* time spent by devices in the activation states */
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_PREPARE,
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_CONFIG,
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_NEED_AUTH,
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CONFIG,
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_IP_CHECK,
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_SECONDARIES,
+	/* from PREPARE to ACTIVATED */
+	NM_STATISTICS_HISTOGRAM_ACTIVATION_TOTAL,
+
+	NM_STATISTICS_HISTOGRAM_DNS_UPDATE,
+
+	/* time from the return of poll() to the next poll() of the
+	 * default main context, that is one iteration of the main loop */
+	NM_STATISTICS_HISTOGRAM_MAIN_LOOP_DISPATCH,
+
+	_NM_STATISTICS_HISTOGRAM_NUM,
+} NMStatisticsHistogram;
+
+/* bucket 0 counts samples below 1 usec, bucket i counts samples in
+ * [2^(i-1), 2^i) usec. The last bucket takes everything above. */
+#define NM_STATISTICS_HISTOGRAM_BUCKETS 24
+
+/* Objects whose number and size are accounted. The owner of an object
+ * calls nm_statistics_memory_add() when creating it and
+ * nm_statistics_memory_remove() with the same size when freeing it.
+ * The size is that of the fixed allocations of the object; variable
+ * data like strings and arrays is not included. */
+typedef enum {
+	NM_STATISTICS_MEMORY_SETTINGS_CONNECTIONS,
+	NM_STATISTICS_MEMORY_WIFI_APS,
+	NM_STATISTICS_MEMORY_LLDP_NEIGHBORS,
+	NM_STATISTICS_MEMORY_DBUS_SKELETONS,
+	NM_STATISTICS_MEMORY_DHCP_CLIENTS,
+	NM_STATISTICS_MEMORY_RDISC,
+
+	_NM_STATISTICS_MEMORY_NUM,
+} NMStatisticsMemory;
+
+void nm_statistics_inc (NMStatisticsCounter counter);
+void nm_statistics_record (NMStatisticsHistogram histogram, gint64 usec);
+
+void nm_statistics_memory_add (NMStatisticsMemory memory, gsize bytes);
+void nm_statistics_memory_remove (NMStatisticsMemory memory, gsize bytes);
+
+/*****************************************************************************/
+
+#define NM_TYPE_STATISTICS            (nm_statistics_get_type ())
+#define NM_STATISTICS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_STATISTICS, NMStatistics))
+#define NM_STATISTICS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_STATISTICS, NMStatisticsClass))
+#define NM_IS_STATISTICS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_STATISTICS))
+#define NM_IS_STATISTICS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_STATISTICS))
+#define NM_STATISTICS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_STATISTICS, NMStatisticsClass))
+
+struct _NMStatistics {
+	NMExportedObject parent;
+};
+
+typedef struct {
+	NMExportedObjectClass parent;
+} NMStatisticsClass;
+
+GType nm_statistics_get_type (void);
+
+NMStatistics *nm_statistics_get (void);
+
+#endif /* __NETWORKMANAGER_STATISTICS_H__ */
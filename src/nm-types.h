@@ -28,6 +28,7 @@
 /* core */
 typedef struct _NMExportedObject     NMExportedObject;
 typedef struct _NMActiveConnection   NMActiveConnection;
+typedef struct _NMActivationScheduler NMActivationScheduler;
 typedef struct _NMAuditManager       NMAuditManager;
 typedef struct _NMVpnConnection      NMVpnConnection;
 typedef struct _NMActRequest         NMActRequest;
@@ -50,6 +51,7 @@ typedef struct _NMRfkillManager      NMRfkillManager;
 typedef struct _NMRouteManager       NMRouteManager;
 typedef struct _NMSessionMonitor     NMSessionMonitor;
 typedef struct _NMSleepMonitor       NMSleepMonitor;
+typedef struct _NMStatistics         NMStatistics;
 typedef struct _NMLldpListener       NMLldpListener;
 
 typedef enum {
@@ -173,6 +175,37 @@ typedef enum {
 	NM_IP_CONFIG_MERGE_NO_DNS                   = (1LL << 1),
 } NMIPConfigMergeFlags;
 
+/* What nm_ip4_config_replace()/nm_ip6_config_replace() changed. */
+typedef enum {
+	NM_IP_CONFIG_CHANGE_NONE                    = 0,
+
+	/* addresses were added, removed or changed in a way visible on D-Bus */
+	NM_IP_CONFIG_CHANGE_ADDRESSES               = (1LL << 0),
+	/* only attributes that are not exported changed, like the lifetimes */
+	NM_IP_CONFIG_CHANGE_ADDRESS_ATTRIBUTES      = (1LL << 1),
+	NM_IP_CONFIG_CHANGE_ROUTES                  = (1LL << 2),
+	NM_IP_CONFIG_CHANGE_ROUTE_ATTRIBUTES        = (1LL << 3),
+	NM_IP_CONFIG_CHANGE_GATEWAY                 = (1LL << 4),
+	NM_IP_CONFIG_CHANGE_NAMESERVERS             = (1LL << 5),
+	NM_IP_CONFIG_CHANGE_DOMAINS                 = (1LL << 6),
+	NM_IP_CONFIG_CHANGE_SEARCHES                = (1LL << 7),
+	NM_IP_CONFIG_CHANGE_DNS_OPTIONS             = (1LL << 8),
+	NM_IP_CONFIG_CHANGE_DNS_PRIORITY            = (1LL << 9),
+	NM_IP_CONFIG_CHANGE_WINS                    = (1LL << 10),
+	NM_IP_CONFIG_CHANGE_NIS                     = (1LL << 11),
+	/* ifindex, never-default, route metric, MSS, MTU and metered */
+	NM_IP_CONFIG_CHANGE_OTHER                   = (1LL << 12),
+
+	NM_IP_CONFIG_CHANGE_DNS                     = NM_IP_CONFIG_CHANGE_NAMESERVERS
+	                                            | NM_IP_CONFIG_CHANGE_DOMAINS
+	                                            | NM_IP_CONFIG_CHANGE_SEARCHES
+	                                            | NM_IP_CONFIG_CHANGE_DNS_OPTIONS
+	                                            | NM_IP_CONFIG_CHANGE_DNS_PRIORITY
+	                                            | NM_IP_CONFIG_CHANGE_WINS,
+
+	NM_IP_CONFIG_CHANGE_ALL                     = (1LL << 13) - 1,
+} NMIPConfigChangeFlags;
+
 /* settings */
 typedef struct _NMAgentManager       NMAgentManager;
 typedef struct _NMSecretAgent        NMSecretAgent;
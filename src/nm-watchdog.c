@@ -0,0 +1,351 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-watchdog.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
+#include "nm-statistics.h"
+
+/* The watchdog detects iterations of the default main context that take
+ * longer than a threshold, and tells what was dispatched meanwhile.
+ *
+ * The poll function of the main context increments a sequence number
+ * before and after each poll(): it is odd while the main thread checks
+ * and dispatches sources. A thread watches the number. When it stays at
+ * the same odd value for longer than the threshold, the thread sends
+ * SIGURG to the main thread, whose handler takes a snapshot of the source
+ * being dispatched and optionally of the stack. The stall is logged and
+ * counted once it ended, by the main thread: the logging isn't safe to
+ * use from another thread.
+ *
+ * While the main thread is in poll(), the watchdog thread sleeps until it
+ * gets woken by the next iteration, so an idle daemon has no extra
+ * wakeups. */
+
+#define SNAPSHOT_NAME_LEN  64
+#define SNAPSHOT_FRAMES    32
+
+typedef struct {
+	const GSourceFuncs *source_funcs;
+	char source_name[SNAPSHOT_NAME_LEN];
+	gpointer callback;
+	gpointer frames[SNAPSHOT_FRAMES];
+	int n_frames;
+} Snapshot;
+
+static struct {
+	gboolean started;
+	guint threshold_ms;
+	gboolean backtrace;
+	pthread_t main_thread;
+	GThread *thread;
+
+	GMutex lock;
+	GCond cond;
+	volatile gint parked;
+	volatile gint quit;
+
+	volatile gint seq;
+	/* the sequence number for which the watchdog asked for a snapshot,
+	 * and for which the signal handler took it. */
+	volatile gint snapshot_request;
+	volatile gint snapshot_seq;
+	Snapshot snapshot;
+} wd;
+
+/*****************************************************************************/
+
+static void
+_sigurg_handler (int signo)
+{
+	int errsv = errno;
+	gint seq = g_atomic_int_get (&wd.seq);
+	GSource *source;
+	Snapshot *s = &wd.snapshot;
+
+	/* a late signal, the stall already ended. */
+	if (   !(seq & 1)
+	    || g_atomic_int_get (&wd.snapshot_request) != seq
+	    || g_atomic_int_get (&wd.snapshot_seq) == seq)
+		goto out;
+
+	/* nothing here allocates or takes a lock. g_main_current_source() only
+	 * reads the thread-local state of the main thread, which exists as it
+	 * is dispatching. */
+	memset (s, 0, sizeof (*s));
+	source = g_main_current_source ();
+	if (source) {
+		GSourceFunc func = NULL;
+		gpointer data;
+
+		s->source_funcs = source->source_funcs;
+		if (source->name)
+			g_strlcpy (s->source_name, source->name, sizeof (s->source_name));
+		if (source->callback_funcs && source->callback_funcs->get) {
+			source->callback_funcs->get (source->callback_data, source, &func, &data);
+			s->callback = (gpointer) func;
+		}
+	}
+#ifdef HAVE_EXECINFO_H
+	if (wd.backtrace)
+		s->n_frames = backtrace (s->frames, SNAPSHOT_FRAMES);
+#endif
+
+	g_atomic_int_set (&wd.snapshot_seq, seq);
+out:
+	errno = errsv;
+}
+
+static gpointer
+_watchdog_thread (gpointer user_data)
+{
+	gint64 period_us = MAX (wd.threshold_ms * 1000 / 4, 10000);
+	gint last_seq = 0;
+	gint64 since = 0;
+	gboolean requested = FALSE;
+
+	while (!g_atomic_int_get (&wd.quit)) {
+		gint seq = g_atomic_int_get (&wd.seq);
+		gint64 now;
+
+		if (!(seq & 1)) {
+			/* in poll(): sleep until the next iteration. */
+			g_mutex_lock (&wd.lock);
+			g_atomic_int_set (&wd.parked, 1);
+			while (   g_atomic_int_get (&wd.seq) == seq
+			       && !g_atomic_int_get (&wd.quit))
+				g_cond_wait (&wd.cond, &wd.lock);
+			g_atomic_int_set (&wd.parked, 0);
+			g_mutex_unlock (&wd.lock);
+			continue;
+		}
+
+		now = g_get_monotonic_time ();
+		if (seq != last_seq) {
+			last_seq = seq;
+			since = now;
+			requested = FALSE;
+		} else if (   !requested
+		           && now - since >= (gint64) wd.threshold_ms * 1000) {
+			requested = TRUE;
+			g_atomic_int_set (&wd.snapshot_request, seq);
+			pthread_kill (wd.main_thread, SIGURG);
+		}
+
+		g_mutex_lock (&wd.lock);
+		if (!g_atomic_int_get (&wd.quit))
+			g_cond_wait_until (&wd.cond, &wd.lock, g_get_monotonic_time () + period_us);
+		g_mutex_unlock (&wd.lock);
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+
+static const char *
+_source_type (const GSourceFuncs *funcs)
+{
+	if (!funcs)
+		return "none";
+	if (funcs == &g_idle_funcs)
+		return "idle";
+	if (funcs == &g_timeout_funcs)
+		return "timeout";
+	if (funcs == &g_io_watch_funcs)
+		return "io-watch";
+	if (funcs == &g_child_watch_funcs)
+		return "child-watch";
+	return "custom";
+}
+
+static const char *
+_symbol_name (gpointer addr, char *buf, gsize len)
+{
+	Dl_info info;
+
+	if (!addr)
+		return "none";
+	if (dladdr (addr, &info) && info.dli_sname)
+		g_snprintf (buf, len, "%s()", info.dli_sname);
+	else
+		g_snprintf (buf, len, "%p", addr);
+	return buf;
+}
+
+static void
+_log_stall (gint64 dispatch_usec, const Snapshot *s)
+{
+	char callback[128];
+
+	if (!s) {
+		nm_log_warn (LOGD_CORE, "watchdog: main loop stalled for %"G_GINT64_FORMAT" msec",
+		             dispatch_usec / 1000);
+		return;
+	}
+
+	nm_log_warn (LOGD_CORE, "watchdog: main loop stalled for %"G_GINT64_FORMAT" msec in %s source%s%s%s, callback %s",
+	             dispatch_usec / 1000,
+	             _source_type (s->source_funcs),
+	             s->source_name[0] ? " \"" : "",
+	             s->source_name,
+	             s->source_name[0] ? "\"" : "",
+	             _symbol_name (s->callback, callback, sizeof (callback)));
+
+#ifdef HAVE_EXECINFO_H
+	if (s->n_frames > 0) {
+		gs_free char **symbols = NULL;
+		int i;
+
+		symbols = backtrace_symbols ((void *const *) s->frames, s->n_frames);
+		/* the first two frames are the signal handler and the trampoline */
+		for (i = 2; symbols && i < s->n_frames; i++)
+			nm_log_warn (LOGD_CORE, "watchdog:   #%d %s", i - 2, symbols[i]);
+	}
+#endif
+}
+
+/**
+ * nm_watchdog_poll_enter:
+ * @dispatch_usec: the time since the previous poll() returned, or 0.
+ *
+ * Called before each poll() of the default main context.
+ */
+void
+nm_watchdog_poll_enter (gint64 dispatch_usec)
+{
+	gint seq;
+
+	if (!wd.started)
+		return;
+
+	seq = g_atomic_int_get (&wd.seq);
+	if (   (seq & 1)
+	    && dispatch_usec >= (gint64) wd.threshold_ms * 1000) {
+		nm_statistics_inc (NM_STATISTICS_COUNTER_MAIN_LOOP_STALLS);
+		_log_stall (dispatch_usec,
+		            g_atomic_int_get (&wd.snapshot_seq) == seq ? &wd.snapshot : NULL);
+	}
+
+	/* the next even number. Only the main thread writes the number,
+	 * which wraps around. */
+	g_atomic_int_set (&wd.seq, (gint) (((guint) seq | 1u) + 1u));
+}
+
+/**
+ * nm_watchdog_poll_leave:
+ *
+ * Called after each poll() of the default main context.
+ */
+void
+nm_watchdog_poll_leave (void)
+{
+	if (!wd.started)
+		return;
+
+	g_atomic_int_set (&wd.seq, (gint) ((guint) g_atomic_int_get (&wd.seq) + 1u));
+	if (g_atomic_int_get (&wd.parked)) {
+		g_mutex_lock (&wd.lock);
+		g_cond_signal (&wd.cond);
+		g_mutex_unlock (&wd.lock);
+	}
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_watchdog_start:
+ * @threshold_ms: iterations of the main loop longer than that are
+ *   reported. 0 disables the watchdog.
+ * @backtrace: whether to log the stack of the main thread at the time
+ *   the stall was detected.
+ *
+ * Must be called from the main thread.
+ */
+void
+nm_watchdog_start (guint threshold_ms, gboolean backtrace)
+{
+	struct sigaction sa = { 0 };
+
+	if (wd.started || !threshold_ms)
+		return;
+
+#ifdef HAVE_EXECINFO_H
+	if (backtrace) {
+		gpointer frames[1];
+
+		/* the first call loads libgcc, which must not happen in the
+		 * signal handler. */
+		backtrace (frames, 1);
+	}
+#else
+	if (backtrace)
+		nm_log_warn (LOGD_CORE, "watchdog: backtraces are not supported");
+	backtrace = FALSE;
+#endif
+
+	sa.sa_handler = _sigurg_handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset (&sa.sa_mask);
+	if (sigaction (SIGURG, &sa, NULL) < 0) {
+		nm_log_warn (LOGD_CORE, "watchdog: cannot install signal handler: %s", strerror (errno));
+		return;
+	}
+
+	wd.threshold_ms = threshold_ms;
+	wd.backtrace = backtrace;
+	wd.main_thread = pthread_self ();
+	g_atomic_int_set (&wd.quit, 0);
+	/* the main loop is not running yet. Until its first poll(), the
+	 * thread treats it as idle. */
+	g_atomic_int_set (&wd.seq, 0);
+	wd.started = TRUE;
+
+	wd.thread = g_thread_new ("nm-watchdog", _watchdog_thread, NULL);
+
+	nm_log_dbg (LOGD_CORE, "watchdog: report main loop iterations longer than %u msec%s",
+	            threshold_ms, backtrace ? ", with backtrace" : "");
+}
+
+void
+nm_watchdog_stop (void)
+{
+	if (!wd.started)
+		return;
+
+	g_mutex_lock (&wd.lock);
+	g_atomic_int_set (&wd.quit, 1);
+	g_cond_signal (&wd.cond);
+	g_mutex_unlock (&wd.lock);
+
+	g_thread_join (wd.thread);
+	wd.thread = NULL;
+	wd.started = FALSE;
+}
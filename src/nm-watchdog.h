@@ -0,0 +1,37 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_WATCHDOG_H__
+#define __NETWORKMANAGER_WATCHDOG_H__
+
+#include "nm-default.h"
+
+/* default for the main.watchdog-threshold configuration option, in msec */
+#define NM_WATCHDOG_THRESHOLD_DEFAULT 1000
+
+void nm_watchdog_start (guint threshold_ms, gboolean backtrace);
+void nm_watchdog_stop (void);
+
+/* called by the poll function of the default main context, see
+ * nm-statistics.c */
+void nm_watchdog_poll_enter (gint64 dispatch_usec);
+void nm_watchdog_poll_leave (void);
+
+#endif /* __NETWORKMANAGER_WATCHDOG_H__ */
@@ -47,7 +47,7 @@
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = (domain); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             char __prefix[32]; \
             const char *__p_prefix = _NMLOG_PREFIX_NAME; \
             const void *const __self = (self); \
@@ -71,6 +71,13 @@ typedef struct {
 	GArray *ip6_addresses;
 	GArray *ip4_routes;
 	GArray *ip6_routes;
+
+	/* incremented on every change of the addresses and routes. */
+	guint64 generation;
+
+	/* views handed out by object_get_view(). They point into the arrays
+	 * above and are freed when @generation changes. */
+	GPtrArray *views;
 } NMFakePlatformPrivate;
 
 typedef struct {
@@ -101,6 +108,25 @@ static gboolean ip6_address_delete (NMPlatform *platform, int ifindex, struct in
 
 /******************************************************************/
 
+static void
+_generation_bump (NMPlatform *platform)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+
+	priv->generation++;
+	g_ptr_array_set_size (priv->views, 0);
+}
+
+/* The fake platform has no event loop, so every change is its own batch. */
+#define _signal_emit(platform, signal_name, obj_type, ifindex, obj, change_type) \
+	G_STMT_START { \
+		_generation_bump ((platform)); \
+		g_signal_emit_by_name ((platform), (signal_name), (obj_type), (ifindex), (obj), (change_type)); \
+		_nm_platform_changes_batch_flush ((platform)); \
+	} G_STMT_END
+
+/******************************************************************/
+
 static gboolean
 _ip4_address_equal_peer_net (in_addr_t peer1, in_addr_t peer2, guint8 plen)
 {
@@ -312,7 +338,7 @@ link_add (NMPlatform *platform,
 	new_device = &g_array_index (priv->links, NMFakePlatformLink, priv->links->len - 1);
 
 	if (device.link.ifindex) {
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, device.link.ifindex, &device, NM_PLATFORM_SIGNAL_ADDED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, device.link.ifindex, &device, NM_PLATFORM_SIGNAL_ADDED);
 
 		link_changed (platform, &g_array_index (priv->links, NMFakePlatformLink, priv->links->len - 1), FALSE);
 	}
@@ -364,7 +390,7 @@ link_delete (NMPlatform *platform, int ifindex)
 			memset (route, 0, sizeof (*route));
 	}
 
-	g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, ifindex, &deleted_device, NM_PLATFORM_SIGNAL_REMOVED);
+	_signal_emit (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, ifindex, &deleted_device, NM_PLATFORM_SIGNAL_REMOVED);
 
 	return TRUE;
 }
@@ -382,7 +408,7 @@ link_changed (NMPlatform *platform, NMFakePlatformLink *device, gboolean raise_s
 	int i;
 
 	if (raise_signal)
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, device->link.ifindex, &device->link, NM_PLATFORM_SIGNAL_CHANGED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, NMP_OBJECT_TYPE_LINK, device->link.ifindex, &device->link, NM_PLATFORM_SIGNAL_CHANGED);
 
 	if (device->link.ifindex && !IN6_IS_ADDR_UNSPECIFIED (&device->ip6_lladdr)) {
 		if (device->link.connected)
@@ -431,6 +457,8 @@ link_set_up (NMPlatform *platform, int ifindex, gboolean *out_no_firmware)
 	switch (device->link.type) {
 	case NM_LINK_TYPE_DUMMY:
 	case NM_LINK_TYPE_VLAN:
+	/* a simulated cable is always plugged in */
+	case NM_LINK_TYPE_ETHERNET:
 		break;
 	case NM_LINK_TYPE_BRIDGE:
 	case NM_LINK_TYPE_BOND:
@@ -706,6 +734,34 @@ link_vxlan_add (NMPlatform *platform,
 	return TRUE;
 }
 
+static gboolean
+link_macvlan_add (NMPlatform *platform,
+                  const char *name,
+                  int parent,
+                  const NMPlatformLnkMacvlan *props,
+                  const NMPlatformLink **out_link)
+{
+	NMFakePlatformLink *device;
+
+	if (!link_add (platform, name,
+	               props->tap ? NM_LINK_TYPE_MACVTAP : NM_LINK_TYPE_MACVLAN,
+	               NULL, 0, out_link))
+		return FALSE;
+
+	device = link_get (platform, nm_platform_link_get_ifindex (platform, name));
+
+	g_return_val_if_fail (device, FALSE);
+	g_return_val_if_fail (!device->lnk, FALSE);
+
+	device->lnk = nmp_object_new (props->tap ? NMP_OBJECT_TYPE_LNK_MACVTAP : NMP_OBJECT_TYPE_LNK_MACVLAN, NULL);
+	device->lnk->lnk_macvlan = *props;
+	device->link.parent = parent;
+
+	if (out_link)
+		*out_link = &device->link;
+	return TRUE;
+}
+
 static gboolean
 infiniband_partition_add (NMPlatform *platform, int parent, int p_key, const NMPlatformLink **out_link)
 {
@@ -938,12 +994,12 @@ ip4_address_add (NMPlatform *platform,
 
 		memcpy (item, &address, sizeof (address));
 		if (changed)
-			g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_CHANGED);
+			_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_CHANGED);
 		return TRUE;
 	}
 
 	g_array_append_val (priv->ip4_addresses, address);
-	g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_ADDED);
+	_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_ADDED);
 
 	return TRUE;
 }
@@ -985,12 +1041,12 @@ ip6_address_add (NMPlatform *platform,
 
 		memcpy (item, &address, sizeof (address));
 		if (changed)
-			g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_CHANGED);
+			_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_CHANGED);
 		return TRUE;
 	}
 
 	g_array_append_val (priv->ip6_addresses, address);
-	g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_ADDED);
+	_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &address, NM_PLATFORM_SIGNAL_ADDED);
 
 	return TRUE;
 }
@@ -1012,7 +1068,7 @@ ip4_address_delete (NMPlatform *platform, int ifindex, in_addr_t addr, guint8 pl
 
 			memcpy (&deleted_address, address, sizeof (deleted_address));
 			memset (address, 0, sizeof (*address));
-			g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &deleted_address, NM_PLATFORM_SIGNAL_REMOVED);
+			_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, &deleted_address, NM_PLATFORM_SIGNAL_REMOVED);
 			return TRUE;
 		}
 	}
@@ -1036,7 +1092,7 @@ ip6_address_delete (NMPlatform *platform, int ifindex, struct in6_addr addr, gui
 
 			memcpy (&deleted_address, address, sizeof (deleted_address));
 			memset (address, 0, sizeof (*address));
-			g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &deleted_address, NM_PLATFORM_SIGNAL_REMOVED);
+			_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, &deleted_address, NM_PLATFORM_SIGNAL_REMOVED);
 			return TRUE;
 		}
 	}
@@ -1161,7 +1217,7 @@ ip4_route_delete (NMPlatform *platform, int ifindex, in_addr_t network, guint8 p
 
 		memcpy (&deleted_route, route, sizeof (deleted_route));
 		g_array_remove_index (priv->ip4_routes, i);
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &deleted_route, NM_PLATFORM_SIGNAL_REMOVED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &deleted_route, NM_PLATFORM_SIGNAL_REMOVED);
 	}
 
 	return TRUE;
@@ -1187,12 +1243,76 @@ ip6_route_delete (NMPlatform *platform, int ifindex, struct in6_addr network, gu
 
 		memcpy (&deleted_route, route, sizeof (deleted_route));
 		g_array_remove_index (priv->ip6_routes, i);
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &deleted_route, NM_PLATFORM_SIGNAL_REMOVED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &deleted_route, NM_PLATFORM_SIGNAL_REMOVED);
 	}
 
 	return TRUE;
 }
 
+static gconstpointer
+object_get_view (NMPlatform *platform, NMPObjectType obj_type, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+	GArray *objects;
+	GPtrArray *view;
+	gsize elt_size;
+	gboolean is_route;
+	guint i;
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		objects = priv->ip4_addresses;
+		elt_size = sizeof (NMPlatformIP4Address);
+		is_route = FALSE;
+		break;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		objects = priv->ip6_addresses;
+		elt_size = sizeof (NMPlatformIP6Address);
+		is_route = FALSE;
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		objects = priv->ip4_routes;
+		elt_size = sizeof (NMPlatformIP4Route);
+		is_route = TRUE;
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		objects = priv->ip6_routes;
+		elt_size = sizeof (NMPlatformIP6Route);
+		is_route = TRUE;
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
+
+	/* same filtering as for the get_all() functions. */
+	view = g_ptr_array_new ();
+	for (i = 0; i < objects->len; i++) {
+		const NMPlatformObject *obj = (const NMPlatformObject *) &objects->data[i * elt_size];
+
+		if (is_route) {
+			if (ifindex && obj->ifindex != ifindex)
+				continue;
+			if (!NM_FLAGS_HAS (flags,
+			                   NM_PLATFORM_IP_ROUTE_IS_DEFAULT ((const NMPlatformIPRoute *) obj)
+			                       ? NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT
+			                       : NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT))
+				continue;
+		} else if (obj->ifindex != ifindex)
+			continue;
+		g_ptr_array_add (view, (gpointer) obj);
+	}
+	g_ptr_array_add (priv->views, view);
+
+	*out_len = view->len;
+	return view->len ? view->pdata : NULL;
+}
+
+static guint64
+cache_get_generation (NMPlatform *platform)
+{
+	return NM_FAKE_PLATFORM_GET_PRIVATE (platform)->generation;
+}
+
 static gboolean
 ip4_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
                in_addr_t network, guint8 plen, in_addr_t gateway,
@@ -1251,12 +1371,12 @@ ip4_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
 		}
 
 		memcpy (item, &route, sizeof (route));
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_CHANGED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_CHANGED);
 		return TRUE;
 	}
 
 	g_array_append_val (priv->ip4_routes, route);
-	g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_ADDED);
+	_signal_emit (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_ADDED);
 
 	return TRUE;
 }
@@ -1317,12 +1437,12 @@ ip6_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
 		}
 
 		memcpy (item, &route, sizeof (route));
-		g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_CHANGED);
+		_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_CHANGED);
 		return TRUE;
 	}
 
 	g_array_append_val (priv->ip6_routes, route);
-	g_signal_emit_by_name (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_ADDED);
+	_signal_emit (platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, &route, NM_PLATFORM_SIGNAL_ADDED);
 
 	return TRUE;
 }
@@ -1367,6 +1487,55 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint
 	return NULL;
 }
 
+static const NMPlatformIP4Route *
+ip4_route_lookup_best (NMPlatform *platform, int ifindex, in_addr_t host)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+	const NMPlatformIP4Route *best = NULL;
+	int i;
+
+	for (i = 0; i < priv->ip4_routes->len; i++) {
+		NMPlatformIP4Route *route = &g_array_index (priv->ip4_routes, NMPlatformIP4Route, i);
+
+		if (ifindex > 0 && route->ifindex != ifindex)
+			continue;
+		if (nm_utils_ip4_address_clear_host_address (host, route->plen) != nm_utils_ip4_address_clear_host_address (route->network, route->plen))
+			continue;
+		if (   !best
+		    || route->plen > best->plen
+		    || (route->plen == best->plen && route->metric < best->metric))
+			best = route;
+	}
+
+	return best;
+}
+
+static const NMPlatformIP6Route *
+ip6_route_lookup_best (NMPlatform *platform, int ifindex, const struct in6_addr *host)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+	const NMPlatformIP6Route *best = NULL;
+	int i;
+
+	for (i = 0; i < priv->ip6_routes->len; i++) {
+		NMPlatformIP6Route *route = &g_array_index (priv->ip6_routes, NMPlatformIP6Route, i);
+		struct in6_addr a, b;
+
+		if (ifindex > 0 && route->ifindex != ifindex)
+			continue;
+		nm_utils_ip6_address_clear_host_address (&a, host, route->plen);
+		nm_utils_ip6_address_clear_host_address (&b, &route->network, route->plen);
+		if (!IN6_ARE_ADDR_EQUAL (&a, &b))
+			continue;
+		if (   !best
+		    || route->plen > best->plen
+		    || (route->plen == best->plen && route->metric < best->metric))
+			best = route;
+	}
+
+	return best;
+}
+
 /******************************************************************/
 
 static void
@@ -1380,6 +1549,7 @@ nm_fake_platform_init (NMFakePlatform *fake_platform)
 	priv->ip6_addresses = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP6Address));
 	priv->ip4_routes = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP4Route));
 	priv->ip6_routes = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP6Route));
+	priv->views = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
 }
 
 void
@@ -1403,6 +1573,39 @@ nm_fake_platform_setup (void)
 	link_add (platform, "eth2", NM_LINK_TYPE_ETHERNET, NULL, 0, NULL);
 }
 
+/**
+ * nm_fake_platform_setup_simulation:
+ * @n_links: the number of ethernet links to create
+ *
+ * Sets up a fake platform for running the whole daemon without touching
+ * the kernel, see tools/run-simulation.py. Besides the loopback, it has
+ * @n_links ethernet links "sim0", "sim1", ... with distinct MAC
+ * addresses, which get carrier as soon as they are set up.
+ */
+void
+nm_fake_platform_setup_simulation (guint n_links)
+{
+	NMPlatform *platform;
+	guint i;
+
+	platform = g_object_new (NM_TYPE_FAKE_PLATFORM, NULL);
+
+	nm_platform_setup (platform);
+
+	/* skip zero element */
+	link_add (platform, NULL, NM_LINK_TYPE_NONE, NULL, 0, NULL);
+
+	link_add (platform, "lo", NM_LINK_TYPE_LOOPBACK, NULL, 0, NULL);
+
+	for (i = 0; i < n_links; i++) {
+		char name[IFNAMSIZ];
+		const guint8 addr[6 /*ETH_ALEN*/] = { 0x02, 0x00, i >> 24, i >> 16, i >> 8, i };
+
+		nm_sprintf_buf (name, "sim%u", i);
+		link_add (platform, name, NM_LINK_TYPE_ETHERNET, addr, sizeof (addr), NULL);
+	}
+}
+
 static void
 nm_fake_platform_finalize (GObject *object)
 {
@@ -1421,6 +1624,7 @@ nm_fake_platform_finalize (GObject *object)
 	g_array_unref (priv->ip6_addresses);
 	g_array_unref (priv->ip4_routes);
 	g_array_unref (priv->ip6_routes);
+	g_ptr_array_unref (priv->views);
 
 	G_OBJECT_CLASS (nm_fake_platform_parent_class)->finalize (object);
 }
@@ -1470,6 +1674,7 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 	platform_class->vlan_add = vlan_add;
 	platform_class->link_vlan_change = link_vlan_change;
 	platform_class->link_vxlan_add = link_vxlan_add;
+	platform_class->link_macvlan_add = link_macvlan_add;
 
 	platform_class->infiniband_partition_add = infiniband_partition_add;
 	platform_class->infiniband_partition_delete = infiniband_partition_delete;
@@ -1500,8 +1705,12 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 
 	platform_class->ip4_route_get = ip4_route_get;
 	platform_class->ip6_route_get = ip6_route_get;
+	platform_class->ip4_route_lookup_best = ip4_route_lookup_best;
+	platform_class->ip6_route_lookup_best = ip6_route_lookup_best;
 	platform_class->ip4_route_get_all = ip4_route_get_all;
 	platform_class->ip6_route_get_all = ip6_route_get_all;
+	platform_class->object_get_view = object_get_view;
+	platform_class->cache_get_generation = cache_get_generation;
 	platform_class->ip4_route_add = ip4_route_add;
 	platform_class->ip6_route_add = ip6_route_add;
 	platform_class->ip4_route_delete = ip4_route_delete;
@@ -45,5 +45,6 @@ typedef struct {
 GType nm_fake_platform_get_type (void);
 
 void nm_fake_platform_setup (void);
+void nm_fake_platform_setup_simulation (guint n_links);
 
 #endif /* __NETWORKMANAGER_FAKE_PLATFORM_H__ */
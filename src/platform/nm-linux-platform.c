@@ -35,6 +35,8 @@
 #include <linux/if_link.h>
 #include <linux/if_tun.h>
 #include <linux/if_tunnel.h>
+#include <linux/dcbnl.h>
+#include <linux/pkt_sched.h>
 #include <netlink/netlink.h>
 #include <netlink/object.h>
 #include <netlink/cache.h>
@@ -52,9 +54,21 @@
 #include "nmp-object.h"
 #include "nmp-netns.h"
 #include "nm-platform-utils.h"
+#include "nm-probes.h"
+#include "nm-loop-sched.h"
+#include "nm-startup-profile.h"
+#include "nm-statistics.h"
 #include "wifi/wifi-utils.h"
 #include "wifi/wifi-utils-wext.h"
 
+#ifndef SOL_NETLINK
+#define SOL_NETLINK 270
+#endif
+
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK 12
+#endif
+
 #define offset_plus_sizeof(t,m) (offsetof (t,m) + sizeof (((t *) NULL)->m))
 
 #define VLAN_FLAG_MVRP 0x8
@@ -88,6 +102,25 @@
 #define IFA_FLAGS                       8
 #define __IFA_MAX                       9
 
+#define TCA_FQ_CODEL_TARGET             1
+#define TCA_FQ_CODEL_LIMIT              2
+#define TCA_FQ_CODEL_INTERVAL           3
+#define TCA_FQ_CODEL_ECN                4
+
+#define TCA_FQ_PLIMIT                   1
+#define TCA_FQ_FLOW_MAX_RATE            7
+
+#define TCA_CAKE_BASE_RATE64            2
+#define TCA_CAKE_RTT                    7
+#define TCA_CAKE_TARGET                 8
+
+#ifndef RTAX_INITRWND
+#define RTAX_INITRWND                   14
+#endif
+#ifndef RTAX_CC_ALGO
+#define RTAX_CC_ALGO                    16
+#endif
+
 #define IFLA_MACVLAN_FLAGS              2
 #define __IFLA_MACVLAN_MAX              3
 
@@ -106,6 +139,48 @@
 #define IFLA_IPTUN_MAX                  (__IFLA_IPTUN_MAX - 1)
 #endif
 
+#define IFLA_BOND_MODE                  1
+#define IFLA_BOND_ACTIVE_SLAVE          2
+#define IFLA_BOND_MIIMON                3
+#define IFLA_BOND_UPDELAY               4
+#define IFLA_BOND_DOWNDELAY             5
+#define IFLA_BOND_USE_CARRIER           6
+#define IFLA_BOND_ARP_INTERVAL          7
+#define IFLA_BOND_ARP_IP_TARGET         8
+#define IFLA_BOND_ARP_VALIDATE          9
+#define IFLA_BOND_ARP_ALL_TARGETS       10
+#define IFLA_BOND_PRIMARY               11
+#define IFLA_BOND_PRIMARY_RESELECT      12
+#define IFLA_BOND_FAIL_OVER_MAC         13
+#define IFLA_BOND_XMIT_HASH_POLICY      14
+#define IFLA_BOND_RESEND_IGMP           15
+#define IFLA_BOND_NUM_PEER_NOTIF        16
+#define IFLA_BOND_ALL_SLAVES_ACTIVE     17
+#define IFLA_BOND_MIN_LINKS             18
+#define IFLA_BOND_LP_INTERVAL           19
+#define IFLA_BOND_PACKETS_PER_SLAVE     20
+#define IFLA_BOND_AD_LACP_RATE          21
+#define IFLA_BOND_AD_SELECT             22
+#define IFLA_BOND_AD_ACTOR_SYS_PRIO     24
+#define IFLA_BOND_AD_USER_PORT_KEY      25
+#define IFLA_BOND_AD_ACTOR_SYSTEM       26
+#define IFLA_BOND_TLB_DYNAMIC_LB        27
+
+#define IFLA_INFO_SLAVE_KIND            4
+#define IFLA_INFO_SLAVE_DATA            5
+
+#define IFLA_BR_FORWARD_DELAY           1
+#define IFLA_BR_HELLO_TIME              2
+#define IFLA_BR_MAX_AGE                 3
+#define IFLA_BR_AGEING_TIME             4
+#define IFLA_BR_STP_STATE               5
+#define IFLA_BR_PRIORITY                6
+#define IFLA_BR_MCAST_SNOOPING          23
+
+#define IFLA_BRPORT_PRIORITY            2
+#define IFLA_BRPORT_COST                3
+#define IFLA_BRPORT_MODE                4
+
 #ifndef MACVLAN_FLAG_NOPROMISC
 #define MACVLAN_FLAG_NOPROMISC          1
 #endif
@@ -145,7 +220,7 @@
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = (domain); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             _LOG_print (__level, __domain, 0, self, __VA_ARGS__); \
         } \
     } G_STMT_END
@@ -155,7 +230,7 @@
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = (domain); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             int __errsv = (errsv); \
             \
             /* The %m format specifier (GNU extension) would alread allow you to specify the error
@@ -176,6 +251,12 @@
  * Forward declarations and enums
  ******************************************************************/
 
+enum {
+	PROP_0,
+	PROP_IFINDEX_FILTER,
+	LAST_PROP,
+};
+
 typedef enum {
 	INFINIBAND_ACTION_CREATE_CHILD,
 	INFINIBAND_ACTION_DELETE_CHILD,
@@ -1522,6 +1603,10 @@ _new_from_nl_link (NMPlatform *platform, const NMPCache *cache, struct nlmsghdr
 
 	if (tb[IFLA_MTU])
 		obj->link.mtu = nla_get_u32 (tb[IFLA_MTU]);
+	if (tb[IFLA_NUM_RX_QUEUES])
+		obj->link.num_rx_queues = nla_get_u32 (tb[IFLA_NUM_RX_QUEUES]);
+	if (tb[IFLA_NUM_TX_QUEUES])
+		obj->link.num_tx_queues = nla_get_u32 (tb[IFLA_NUM_TX_QUEUES]);
 
 	switch (obj->link.type) {
 	case NM_LINK_TYPE_GRE:
@@ -1703,6 +1788,15 @@ errout:
 	return obj_result;
 }
 
+static guint32
+_metric_get_u32 (const struct nlattr *attr)
+{
+	if (   attr
+	    && nla_len (attr) >= sizeof (uint32_t))
+		return nla_get_u32 ((struct nlattr *) attr);
+	return 0;
+}
+
 /* Copied and heavily modified from libnl3's rtnl_route_parse() and parse_multipath(). */
 static NMPObject *
 _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
@@ -1728,7 +1822,11 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 		int ifindex;
 		NMIPAddr gateway;
 	} nh;
+	gs_free NMPlatformIP4RouteNexthop *nexthops = NULL;
+	guint n_nexthops = 0;
 	guint32 mss;
+	guint32 lock = 0, window = 0, rtt = 0, mtu = 0, initcwnd = 0, initrwnd = 0;
+	const char *congctl = NULL;
 	guint32 table;
 
 	if (!nlmsg_valid_hdr (nlh, sizeof (*rtm)))
@@ -1767,7 +1865,8 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 		goto errout;
 
 	/*****************************************************************
-	 * parse nexthops. Only handle routes with one nh.
+	 * parse nexthops. Only handle routes with one nh, except for
+	 * IPv4 multipath routes, whose nexthops are kept in the object.
 	 *****************************************************************/
 
 	memset (&nh, 0, sizeof (nh));
@@ -1777,14 +1876,12 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 		size_t tlen = nla_len(tb[RTA_MULTIPATH]);
 
 		while (tlen >= sizeof(*rtnh) && tlen >= rtnh->rtnh_len) {
+			NMIPAddr gateway = NMIPAddrInit;
 
-			if (nh.is_present) {
-				/* we don't support multipath routes. */
+			if (nh.is_present && !is_v4) {
+				/* we don't support IPv6 multipath routes. */
 				goto errout;
 			}
-			nh.is_present = TRUE;
-
-			nh.ifindex = rtnh->rtnh_ifindex;
 
 			if (rtnh->rtnh_len > sizeof(*rtnh)) {
 				struct nlattr *ntb[RTA_MAX + 1];
@@ -1797,7 +1894,21 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 					goto errout;
 
 				if (_check_addr_or_errout (ntb, RTA_GATEWAY, addr_len))
-					memcpy (&nh.gateway, nla_data (ntb[RTA_GATEWAY]), addr_len);
+					memcpy (&gateway, nla_data (ntb[RTA_GATEWAY]), addr_len);
+			}
+
+			if (!nh.is_present) {
+				nh.is_present = TRUE;
+				nh.ifindex = rtnh->rtnh_ifindex;
+				nh.gateway = gateway;
+			}
+
+			if (is_v4) {
+				nexthops = g_renew (NMPlatformIP4RouteNexthop, nexthops, n_nexthops + 1);
+				nexthops[n_nexthops].ifindex = rtnh->rtnh_ifindex;
+				nexthops[n_nexthops].gateway = gateway.addr4;
+				nexthops[n_nexthops].weight = ((guint16) rtnh->rtnh_hops) + 1;
+				n_nexthops++;
 			}
 
 			tlen -= RTNH_ALIGN(rtnh->rtnh_len);
@@ -1836,22 +1947,22 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 
 	mss = 0;
 	if (tb[RTA_METRICS]) {
-		struct nlattr *mtb[RTAX_MAX + 1];
-		int i;
+		struct nlattr *mtb[RTAX_CC_ALGO + 1];
 
-		err = nla_parse_nested(mtb, RTAX_MAX, tb[RTA_METRICS], NULL);
+		err = nla_parse_nested (mtb, RTAX_CC_ALGO, tb[RTA_METRICS], NULL);
 		if (err < 0)
 			goto errout;
 
-		for (i = 1; i <= RTAX_MAX; i++) {
-			if (mtb[i]) {
-				if (i == RTAX_ADVMSS) {
-					if (nla_len (mtb[i]) >= sizeof (uint32_t))
-						mss = nla_get_u32(mtb[i]);
-					break;
-				}
-			}
-		}
+		mss = _metric_get_u32 (mtb[RTAX_ADVMSS]);
+		lock = _metric_get_u32 (mtb[RTAX_LOCK]);
+		window = _metric_get_u32 (mtb[RTAX_WINDOW]);
+		rtt = _metric_get_u32 (mtb[RTAX_RTT]);
+		mtu = _metric_get_u32 (mtb[RTAX_MTU]);
+		initcwnd = _metric_get_u32 (mtb[RTAX_INITCWND]);
+		initrwnd = _metric_get_u32 (mtb[RTAX_INITRWND]);
+		if (   mtb[RTAX_CC_ALGO]
+		    && nla_len (mtb[RTAX_CC_ALGO]) > 1)
+			congctl = g_intern_string (nla_get_string (mtb[RTAX_CC_ALGO]));
 	}
 
 	/*****************************************************************/
@@ -1882,6 +1993,13 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 	}
 
 	obj->ip_route.mss = mss;
+	obj->ip_route.window = window;
+	obj->ip_route.initcwnd = initcwnd;
+	obj->ip_route.initrwnd = initrwnd;
+	obj->ip_route.rtt = rtt / 8;
+	obj->ip_route.mtu = mtu;
+	obj->ip_route.lock_mtu = NM_FLAGS_HAS (lock, (1 << RTAX_MTU));
+	obj->ip_route.congctl = congctl;
 
 	if (NM_FLAGS_HAS (rtm->rtm_flags, RTM_F_CLONED)) {
 		/* we must not straight way reject cloned routes, because we might have cached
@@ -1896,6 +2014,11 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 
 	obj->ip_route.rt_source = nmp_utils_ip_config_source_from_rtprot (rtm->rtm_protocol);
 
+	if (n_nexthops > 1) {
+		obj->_ip4_route.n_nexthops = n_nexthops;
+		obj->_ip4_route.nexthops = g_steal_pointer (&nexthops);
+	}
+
 	obj_result = obj;
 	obj = NULL;
 errout:
@@ -2247,6 +2370,7 @@ _nl_msg_new_route (int nlmsg_type,
                    gconstpointer gateway,
                    guint32 metric,
                    guint32 mss,
+                   const NMPlatformIPRoute *tuning,
                    gconstpointer pref_src)
 {
 	struct nl_msg *msg;
@@ -2286,24 +2410,109 @@ _nl_msg_new_route (int nlmsg_type,
 	if (pref_src)
 		NLA_PUT (msg, RTA_PREFSRC, addr_len, pref_src);
 
-	if (mss > 0) {
+	if (   mss > 0
+	    || (   tuning
+	        && (   tuning->window
+	            || tuning->initcwnd
+	            || tuning->initrwnd
+	            || tuning->rtt
+	            || tuning->mtu
+	            || tuning->lock_mtu
+	            || tuning->congctl))) {
 		struct nlattr *metrics;
 
 		metrics = nla_nest_start (msg, RTA_METRICS);
 		if (!metrics)
 			goto nla_put_failure;
 
-		NLA_PUT_U32 (msg, RTAX_ADVMSS, mss);
+		if (mss > 0)
+			NLA_PUT_U32 (msg, RTAX_ADVMSS, mss);
+		if (tuning) {
+			if (tuning->lock_mtu)
+				NLA_PUT_U32 (msg, RTAX_LOCK, (1 << RTAX_MTU));
+			if (tuning->mtu)
+				NLA_PUT_U32 (msg, RTAX_MTU, tuning->mtu);
+			if (tuning->window)
+				NLA_PUT_U32 (msg, RTAX_WINDOW, tuning->window);
+			/* the kernel expects the RTT in units of 1/8 msec */
+			if (tuning->rtt)
+				NLA_PUT_U32 (msg, RTAX_RTT, tuning->rtt * 8);
+			if (tuning->initcwnd)
+				NLA_PUT_U32 (msg, RTAX_INITCWND, tuning->initcwnd);
+			if (tuning->initrwnd)
+				NLA_PUT_U32 (msg, RTAX_INITRWND, tuning->initrwnd);
+			if (tuning->congctl)
+				NLA_PUT_STRING (msg, RTAX_CC_ALGO, tuning->congctl);
+		}
 
 		nla_nest_end(msg, metrics);
 	}
 
-	/* We currently don't have need for multi-hop routes... */
+	/* multipath routes have no ifindex, see _nl_msg_new_ip4_route_multipath(). */
 	if (   gateway
 	    && memcmp (gateway, &nm_ip_addr_zero, addr_len) != 0)
 		NLA_PUT (msg, RTA_GATEWAY, addr_len, gateway);
-	NLA_PUT_U32 (msg, RTA_OIF, ifindex);
+	if (ifindex > 0)
+		NLA_PUT_U32 (msg, RTA_OIF, ifindex);
+
+	return msg;
+
+nla_put_failure:
+	nlmsg_free (msg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_ip4_route_multipath (NMIPConfigSource source,
+                                 in_addr_t network,
+                                 guint8 plen,
+                                 guint32 metric,
+                                 guint32 mss,
+                                 const NMPlatformIP4RouteNexthop *nexthops,
+                                 guint n_nexthops)
+{
+	struct nl_msg *msg;
+	struct nlattr *multipath;
+	guint i;
+
+	msg = _nl_msg_new_route (RTM_NEWROUTE,
+	                         NLM_F_CREATE | NLM_F_REPLACE,
+	                         AF_INET,
+	                         0,
+	                         source,
+	                         RT_SCOPE_UNIVERSE,
+	                         &network,
+	                         plen,
+	                         NULL,
+	                         metric,
+	                         mss,
+	                         NULL,
+	                         NULL);
+	if (!msg)
+		return NULL;
+
+	multipath = nla_nest_start (msg, RTA_MULTIPATH);
+	if (!multipath)
+		goto nla_put_failure;
+
+	for (i = 0; i < n_nexthops; i++) {
+		struct rtnexthop *rtnh;
+
+		rtnh = nlmsg_reserve (msg, sizeof (*rtnh), NLMSG_ALIGNTO);
+		if (!rtnh)
+			goto nla_put_failure;
+
+		rtnh->rtnh_flags = 0;
+		rtnh->rtnh_hops = CLAMP (nexthops[i].weight, 1, 256) - 1;
+		rtnh->rtnh_ifindex = nexthops[i].ifindex;
+
+		if (nexthops[i].gateway)
+			NLA_PUT (msg, RTA_GATEWAY, sizeof (in_addr_t), &nexthops[i].gateway);
+
+		rtnh->rtnh_len = (char *) nlmsg_tail (nlmsg_hdr (msg)) - (char *) rtnh;
+	}
 
+	nla_nest_end (msg, multipath);
 	return msg;
 
 nla_put_failure:
@@ -2361,12 +2570,23 @@ typedef struct {
 	gint64 timeout_abs_ns;
 	WaitForNlResponseResult *out_seq_result;
 	gint *out_refresh_all_in_progess;
+	/* the request was sent on the event socket */
+	gboolean on_event_socket;
 } DelayedActionWaitForNlResponseData;
 
 typedef struct _NMLinuxPlatformPrivate NMLinuxPlatformPrivate;
 
 struct _NMLinuxPlatformPrivate {
+	/* the socket for our change requests and their ACKs. It has no
+	 * multicast memberships, so that waiting for an ACK doesn't
+	 * require parsing unrelated events. */
 	struct nl_sock *nlh;
+
+	/* the socket that is subscribed to the multicast groups. Dumps and
+	 * other requests that refresh the cache are sent on it too: their
+	 * replies must be ordered with the events, otherwise an event that
+	 * was queued before the dump would overwrite the newer dump state. */
+	struct nl_sock *nlh_event;
 	guint32 nlh_seq_next;
 #ifdef NM_MORE_LOGGING
 	guint32 nlh_seq_last_handled;
@@ -2375,10 +2595,22 @@ struct _NMLinuxPlatformPrivate {
 	NMPCache *cache;
 	GIOChannel *event_channel;
 	guint event_id;
+	GIOChannel *request_channel;
+	guint request_id;
 
 	gboolean sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
 
+	struct {
+		/* open file descriptors for sysctl paths, to be used with pread()/pwrite().
+		 * The platform instance is bound to one netns and the files are opened
+		 * inside it, so the path alone identifies the entry. Paths name
+		 * interfaces by ifname, so the entries of a link are dropped whenever
+		 * it is added, renamed or removed. */
+		GHashTable *entries;
+		GQueue lru;
+	} sysctl_fd_cache;
+
 	GUdevClient *udev_client;
 
 	struct {
@@ -2399,7 +2631,62 @@ struct _NMLinuxPlatformPrivate {
 
 	GHashTable *prune_candidates;
 
+	struct {
+		/* after an overrun of the receive buffer, the cache is resynchronized
+		 * in stages: links first, then one address/route type after the other.
+		 * Requesting all dumps at once makes the replies compete for the
+		 * receive buffer with new events, and easily causes the next overrun. */
+		DelayedActionType stages_pending;
+		gint64 start_ns;
+		guint rcvbuf_size;
+	} resync;
+
+	NMLinuxPlatformNetlinkStats netlink_stats;
+
+	struct {
+		/* while handling a wakeup of the event socket, the time after
+		 * which reading more events is left to the next wakeup, or 0. */
+		gint64 deadline;
+		gboolean exceeded;
+		/* the watch runs at the priority of D-Bus, because the last
+		 * wakeup exceeded its budget. */
+		gboolean demoted;
+	} event_budget;
+
+	/* number of replies to dcbnl set commands in which the driver
+	 * reported an error. See link_set_dcb(). */
+	guint dcb_failures;
+
+	/* the link whose root qdisc is requested by qdisc_get_root(), and
+	 * the kind from the reply. */
+	int qdisc_request_ifindex;
+	char qdisc_reply_kind[16];
+
+	/* LinkPayloadHash of the last RTM_NEWLINK message per ifindex. See
+	 * _link_payload_unchanged(). */
+	GHashTable *link_payload_hashes;
+
+	/* LinkStatistics per ifindex, from the IFLA_STATS64 attribute of the
+	 * last RTM_NEWLINK message. See _link_statistics_update(). */
+	GHashTable *link_statistics;
+
+	/* EthtoolCacheEntry per ifindex with results of ethtool ioctls that
+	 * don't change during the lifetime of a link. See _ethtool_cache_get(). */
+	GHashTable *ethtool_cache;
+
+	/* preallocated buffers for event_handler_recvmsgs(). */
+	struct _RecvBatch *recv_batch;
+	gboolean recv_batch_busy;
+	/* set once a datagram didn't fit into the RecvBatch buffers. From then on,
+	 * the size of each datagram is peeked before reading it. */
+	gboolean recv_batch_peek;
+
 	GHashTable *wifi_data;
+
+	/* if positive, only the link with this ifindex and its addresses and
+	 * routes are requested and cached. Everything else is dropped before
+	 * it gets parsed. */
+	int ifindex_filter;
 };
 
 static inline NMLinuxPlatformPrivate *
@@ -2421,6 +2708,37 @@ nm_linux_platform_new (gboolean netns_support)
 	                     NULL);
 }
 
+/**
+ * nm_linux_platform_new_for_netns:
+ * @filename: the network namespace file, see nmp_netns_new_from_path()
+ *
+ * Creates a platform instance that manages the existing network
+ * namespace @filename. It has its own netlink sockets and cache, so one
+ * process can manage several namespaces side by side, with one instance
+ * each.
+ *
+ * Returns: (transfer full): the new platform or %NULL if the namespace
+ *   cannot be entered.
+ */
+NMPlatform *
+nm_linux_platform_new_for_netns (const char *filename)
+{
+	NMPNetns *netns;
+	NMPlatform *platform;
+
+	netns = nmp_netns_new_from_path (filename);
+	if (!netns)
+		return NULL;
+
+	/* the platform binds to the current namespace */
+	platform = nm_linux_platform_new (TRUE);
+
+	nmp_netns_pop (netns);
+	g_object_unref (netns);
+
+	return platform;
+}
+
 void
 nm_linux_platform_setup (void)
 {
@@ -2430,6 +2748,27 @@ nm_linux_platform_setup (void)
 	              NULL);
 }
 
+/**
+ * nm_linux_platform_setup_for_ifindex:
+ * @ifindex: the interface to cache
+ *
+ * Like nm_linux_platform_setup(), but the platform only caches the link
+ * @ifindex with its addresses and routes. This is for processes that
+ * manage a single interface and must keep a small footprint on hosts
+ * with many links.
+ */
+void
+nm_linux_platform_setup_for_ifindex (int ifindex)
+{
+	g_return_if_fail (ifindex > 0);
+
+	g_object_new (NM_TYPE_LINUX_PLATFORM,
+	              NM_PLATFORM_REGISTER_SINGLETON, TRUE,
+	              NM_PLATFORM_NETNS_SUPPORT, FALSE,
+	              NM_LINUX_PLATFORM_IFINDEX_FILTER, ifindex,
+	              NULL);
+}
+
 /******************************************************************/
 
 static void
@@ -2445,10 +2784,19 @@ _assert_netns_current (NMPlatform *platform)
 static void
 _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *path, const char *value)
 {
+	nm_auto_pop_netns NMPNetns *netns = NULL;
 	GError *error = NULL;
 	char *contents, *contents_escaped;
 	char *value_escaped = g_strescape (value, NULL);
 
+	/* the file might have been opened without switching the namespace,
+	 * see _sysctl_open(). */
+	if (!nm_platform_netns_push (platform, &netns)) {
+		_LOGD ("sysctl: setting '%s' to '%s' (current value cannot be read: cannot switch namespace)", path, value_escaped);
+		g_free (value_escaped);
+		return;
+	}
+
 	if (!g_file_get_contents (path, &contents, NULL, &error)) {
 		_LOGD ("sysctl: setting '%s' to '%s' (current value cannot be read: %s)", path, value_escaped, error->message);
 		g_clear_error (&error);
@@ -2472,10 +2820,194 @@ _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *path, const char *va
 		} \
 	} G_STMT_END
 
+/******************************************************************/
+
 static gboolean
-sysctl_set (NMPlatform *platform, const char *path, const char *value)
+_sysctl_path_is_sysfs (const char *path)
+{
+	return g_str_has_prefix (path, "/sys/");
+}
+
+/* Opens @path inside the namespace of @platform. Files below "/sys" are
+ * opened relative to the sysfs directory of the namespace and don't require
+ * switching the namespace of the thread. For "/proc/sys", the kernel resolves
+ * the path according to the network namespace of the caller, so we have to
+ * switch there (the opened file stays bound to the namespace). */
+static int
+_sysctl_open (NMPlatform *platform, const char *path, int flags)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
+	NMPNetns *platform_netns;
+	int dirfd;
+
+	platform_netns = nm_platform_netns_get (platform);
+	if (   platform_netns
+	    && _sysctl_path_is_sysfs (path)
+	    && (dirfd = nmp_netns_get_fd_sysfs (platform_netns)) >= 0)
+		return openat (dirfd, &path[NM_STRLEN ("/sys/")], flags | O_CLOEXEC);
+
+	if (!nm_platform_netns_push (platform, &netns)) {
+		errno = ENETDOWN;
+		return -1;
+	}
+	return open (path, flags | O_CLOEXEC);
+}
+
+/******************************************************************/
+
+#define SYSCTL_FD_CACHE_MAX 256
+
+typedef struct {
+	char *path;
+	int fd;
+	GList lru_link;
+} SysctlFdCacheEntry;
+
+static void
+_sysctl_fd_cache_drop (NMLinuxPlatformPrivate *priv, SysctlFdCacheEntry *entry)
+{
+	g_queue_unlink (&priv->sysctl_fd_cache.lru, &entry->lru_link);
+	if (!g_hash_table_remove (priv->sysctl_fd_cache.entries, entry->path))
+		nm_assert_not_reached ();
+	close (entry->fd);
+	g_free (entry->path);
+	g_slice_free (SysctlFdCacheEntry, entry);
+}
+
+static void
+_sysctl_fd_cache_clear (NMLinuxPlatformPrivate *priv)
+{
+	while (priv->sysctl_fd_cache.lru.head)
+		_sysctl_fd_cache_drop (priv, priv->sysctl_fd_cache.lru.head->data);
+}
+
+/* Drop all cached files that belong to interface @ifname, for example
+ * because the link was removed or renamed. */
+static void
+_sysctl_fd_cache_invalidate_ifname (NMLinuxPlatformPrivate *priv, const char *ifname)
+{
+	gs_free char *needle = NULL;
+	GList *iter, *next;
+
+	if (!ifname || !ifname[0] || !priv->sysctl_fd_cache.lru.head)
+		return;
+
+	needle = g_strdup_printf ("/%s/", ifname);
+	for (iter = priv->sysctl_fd_cache.lru.head; iter; iter = next) {
+		SysctlFdCacheEntry *entry = iter->data;
+
+		next = iter->next;
+		if (strstr (entry->path, needle))
+			_sysctl_fd_cache_drop (priv, entry);
+	}
+}
+
+static SysctlFdCacheEntry *
+_sysctl_fd_cache_get (NMPlatform *platform, const char *path)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	SysctlFdCacheEntry *entry;
+	int fd;
+
+	entry = g_hash_table_lookup (priv->sysctl_fd_cache.entries, path);
+	if (entry) {
+		g_queue_unlink (&priv->sysctl_fd_cache.lru, &entry->lru_link);
+		g_queue_push_head_link (&priv->sysctl_fd_cache.lru, &entry->lru_link);
+		return entry;
+	}
+
+	/* Files that cannot be opened for both reading and writing are not
+	 * cached. The caller falls back to the uncached code path, which also
+	 * takes care of logging errors. */
+	fd = _sysctl_open (platform, path, O_RDWR);
+	if (fd == -1)
+		return NULL;
+
+	if (g_queue_get_length (&priv->sysctl_fd_cache.lru) >= SYSCTL_FD_CACHE_MAX)
+		_sysctl_fd_cache_drop (priv, priv->sysctl_fd_cache.lru.tail->data);
+
+	entry = g_slice_new0 (SysctlFdCacheEntry);
+	entry->path = g_strdup (path);
+	entry->fd = fd;
+	entry->lru_link.data = entry;
+	g_hash_table_insert (priv->sysctl_fd_cache.entries, entry->path, entry);
+	g_queue_push_head_link (&priv->sysctl_fd_cache.lru, &entry->lru_link);
+	return entry;
+}
+
+/* Returns: 1 if the value was written, 0 if the cache can't be used and
+ *   the value must be written via the uncached path, or -1 if writing
+ *   failed, with errno set. */
+static int
+_sysctl_fd_cache_write (NMPlatform *platform, const char *path, const char *value, const char *actual, gsize len)
+{
+	SysctlFdCacheEntry *entry;
+	gssize nwrote;
+	int errsv;
+
+	entry = _sysctl_fd_cache_get (platform, path);
+	if (!entry)
+		return 0;
+
+	do {
+		nwrote = pwrite (entry->fd, actual, len, 0);
+	} while (nwrote == -1 && errno == EINTR);
+
+	if (nwrote == len)
+		return 1;
+
+	errsv = nwrote == -1 ? errno : EIO;
+	if (NM_IN_SET (errsv, ENOENT, ENODEV, EBADF)) {
+		/* the file is stale, e.g. because the interface was renamed.
+		 * Retry via the uncached path, which reopens it. */
+		_sysctl_fd_cache_drop (NM_LINUX_PLATFORM_GET_PRIVATE (platform), entry);
+		return 0;
+	}
+
+	/* the value was rejected. Writing it again wouldn't help. */
+	if (nwrote == -1) {
+		if (errsv != EEXIST) {
+			_LOGE ("sysctl: failed to set '%s' to '%s': (%d) %s",
+			       path, value, errsv, strerror (errsv));
+		}
+	} else {
+		_LOGE ("sysctl: failed to set '%s' to '%s': partial write",
+		       path, value);
+	}
+	errno = errsv;
+	return -1;
+}
+
+static char *
+_sysctl_fd_cache_read (NMPlatform *platform, const char *path)
+{
+	SysctlFdCacheEntry *entry;
+	char buf[4096];
+	gssize nread;
+
+	entry = _sysctl_fd_cache_get (platform, path);
+	if (!entry)
+		return NULL;
+
+	do {
+		nread = pread (entry->fd, buf, sizeof (buf), 0);
+	} while (nread == -1 && errno == EINTR);
+
+	if (nread < 0 || nread >= sizeof (buf)) {
+		/* a read error, or the content is too large for the buffer. */
+		_sysctl_fd_cache_drop (NM_LINUX_PLATFORM_GET_PRIVATE (platform), entry);
+		return NULL;
+	}
+
+	buf[nread] = '\0';
+	return g_strstrip (g_strdup (buf));
+}
+
+/******************************************************************/
+
+static gboolean
+sysctl_set (NMPlatform *platform, const char *path, const char *value)
+{
 	int fd, tries;
 	gssize nwrote;
 	gsize len;
@@ -2492,14 +3024,36 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 	/* Don't write to suspicious locations */
 	g_assert (!strstr (path, "/../"));
 
-	if (!nm_platform_netns_push (platform, &netns)) {
-		errno = ENETDOWN;
-		return FALSE;
+	/* Most sysfs and sysctl options don't care about a trailing LF, while some
+	 * (like infiniband) do.  So always add the LF.  Also, neither sysfs nor
+	 * sysctl support partial writes so the LF must be added to the string we're
+	 * about to write.
+	 */
+	len = strlen (value) + 1;
+	if (len > 512)
+		actual = actual_free = g_malloc (len + 1);
+	else
+		actual = g_alloca (len + 1);
+	memcpy (actual, value, len - 1);
+	actual[len - 1] = '\n';
+	actual[len] = '\0';
+
+	/* With debug logging enabled, we read the current value before writing
+	 * it anyway. Use the regular code path in that case. */
+	if (!_LOGD_ENABLED ()) {
+		switch (_sysctl_fd_cache_write (platform, path, value, actual, len)) {
+		case 1:
+			return TRUE;
+		case -1:
+			return FALSE;
+		}
 	}
 
-	fd = open (path, O_WRONLY | O_TRUNC);
+	fd = _sysctl_open (platform, path, O_WRONLY | O_TRUNC);
 	if (fd == -1) {
 		errsv = errno;
+		if (errsv == ENETDOWN)
+			return FALSE;
 		if (errsv == ENOENT) {
 			_LOGD ("sysctl: failed to open '%s': (%d) %s",
 			       path, errsv, strerror (errsv));
@@ -2513,20 +3067,6 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 
 	_log_dbg_sysctl_set (platform, path, value);
 
-	/* Most sysfs and sysctl options don't care about a trailing LF, while some
-	 * (like infiniband) do.  So always add the LF.  Also, neither sysfs nor
-	 * sysctl support partial writes so the LF must be added to the string we're
-	 * about to write.
-	 */
-	len = strlen (value) + 1;
-	if (len > 512)
-		actual = actual_free = g_malloc (len + 1);
-	else
-		actual = g_alloca (len + 1);
-	memcpy (actual, value, len - 1);
-	actual[len - 1] = '\n';
-	actual[len] = '\0';
-
 	/* Try to write the entire value three times if a partial write occurs */
 	errsv = 0;
 	for (tries = 0, nwrote = 0; tries < 3 && nwrote != len; tries++) {
@@ -2567,6 +3107,38 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 	return TRUE;
 }
 
+static gboolean
+sysctl_set_many (NMPlatform *platform, NMPlatformSysctlSetEntry *entries, guint len)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	gboolean success = TRUE;
+	guint i;
+
+	/* files below /sys are opened without switching the namespace. For
+	 * the others, switch the netns once for all entries. The nested push
+	 * in sysctl_set() is then cheap. */
+	for (i = 0; i < len; i++) {
+		if (!_sysctl_path_is_sysfs (entries[i].path))
+			break;
+	}
+	if (   i < len
+	    && !nm_platform_netns_push (platform, &netns)) {
+		for (i = 0; i < len; i++)
+			entries[i].errsv = ENETDOWN;
+		return FALSE;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (sysctl_set (platform, entries[i].path, entries[i].value))
+			entries[i].errsv = 0;
+		else {
+			entries[i].errsv = errno ?: EIO;
+			success = FALSE;
+		}
+	}
+	return success;
+}
+
 static GSList *sysctl_clear_cache_list;
 
 static void
@@ -2630,9 +3202,11 @@ _log_dbg_sysctl_get_impl (NMPlatform *platform, const char *path, const char *co
 static char *
 sysctl_get (NMPlatform *platform, const char *path)
 {
-	nm_auto_pop_netns NMPNetns *netns = NULL;
-	GError *error = NULL;
+	GString *str;
+	char buf[4096];
+	gssize nread;
 	char *contents;
+	int fd, errsv;
 
 	/* Don't write outside known locations */
 	g_assert (g_str_has_prefix (path, "/proc/sys/")
@@ -2640,25 +3214,51 @@ sysctl_get (NMPlatform *platform, const char *path)
 	/* Don't write to suspicious locations */
 	g_assert (!strstr (path, "/../"));
 
-	if (!nm_platform_netns_push (platform, &netns))
-		return NULL;
+	contents = _sysctl_fd_cache_read (platform, path);
+	if (contents) {
+		_log_dbg_sysctl_get (platform, path, contents);
+		return contents;
+	}
 
-	if (!g_file_get_contents (path, &contents, NULL, &error)) {
-		/* We assume FAILED means EOPNOTSUP */
-		if (   g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)
-		    || g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_FAILED))
-			_LOGD ("error reading %s: %s", path, error->message);
-		else
-			_LOGE ("error reading %s: %s", path, error->message);
-		g_clear_error (&error);
-		return NULL;
+	fd = _sysctl_open (platform, path, O_RDONLY);
+	if (fd == -1) {
+		errsv = errno;
+		if (errsv == ENETDOWN)
+			return NULL;
+		goto out_error;
+	}
+
+	str = g_string_new (NULL);
+	for (;;) {
+		nread = read (fd, buf, sizeof (buf));
+		if (nread > 0) {
+			g_string_append_len (str, buf, nread);
+			continue;
+		}
+		if (nread == 0)
+			break;
+		errsv = errno;
+		if (errsv == EINTR)
+			continue;
+		close (fd);
+		g_string_free (str, TRUE);
+		goto out_error;
 	}
+	close (fd);
 
-	g_strstrip (contents);
+	contents = g_strstrip (g_string_free (str, FALSE));
 
 	_log_dbg_sysctl_get (platform, path, contents);
 
 	return contents;
+
+out_error:
+	/* We assume FAILED means EOPNOTSUP */
+	if (NM_IN_SET (g_file_error_from_errno (errsv), G_FILE_ERROR_NOENT, G_FILE_ERROR_FAILED))
+		_LOGD ("error reading %s: %s", path, g_strerror (errsv));
+	else
+		_LOGE ("error reading %s: %s", path, g_strerror (errsv));
+	return NULL;
 }
 
 /******************************************************************/
@@ -2745,6 +3345,8 @@ do_emit_signal (NMPlatform *platform, const NMPObject *obj, NMPCacheOpsType cach
 
 	klass = NMP_OBJECT_GET_CLASS (obj);
 
+	NM_PROBE3 (signal__emit, (int) klass->obj_type, (int) cache_op, obj->object.ifindex);
+
 	_LOGt ("emit signal %s %s: %s",
 	       klass->signal_type,
 	       nm_platform_signal_change_type_to_string ((NMPlatformSignalChangeType) cache_op),
@@ -2955,7 +3557,38 @@ delayed_action_handle_REFRESH_ALL (NMPlatform *platform, DelayedActionType flags
 	do_request_all_no_delayed_actions (platform, flags);
 }
 
-static void
+static gboolean
+delayed_action_handle_RESYNC (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionType iflags;
+
+	if (!priv->resync.start_ns)
+		return FALSE;
+
+	/* we only get here after the previous stage completed, because pending
+	 * dumps keep DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE scheduled. */
+	FOR_EACH_DELAYED_ACTION (iflags, priv->resync.stages_pending) {
+		priv->resync.stages_pending &= ~iflags;
+		priv->netlink_stats.resync_dumps++;
+		delayed_action_schedule (platform, iflags, NULL);
+		return TRUE;
+	}
+
+	priv->netlink_stats.resync_last_ns = nm_utils_get_monotonic_timestamp_ns () - priv->resync.start_ns;
+	priv->netlink_stats.resync_total_ns += priv->netlink_stats.resync_last_ns;
+	priv->resync.start_ns = 0;
+	nm_statistics_record (NM_STATISTICS_HISTOGRAM_NETLINK_RESYNC,
+	                      priv->netlink_stats.resync_last_ns / 1000);
+	_LOGD ("netlink: resync: completed in %"G_GINT64_FORMAT" msec (%u overruns, %u dumps, %u messages so far)",
+	       priv->netlink_stats.resync_last_ns / (NM_UTILS_NS_PER_SECOND / 1000),
+	       priv->netlink_stats.overruns,
+	       priv->netlink_stats.resync_dumps,
+	       priv->netlink_stats.resync_messages);
+	return FALSE;
+}
+
+static void
 delayed_action_handle_READ_NETLINK (NMPlatform *platform)
 {
 	event_handler_read_netlink (platform, FALSE);
@@ -2973,7 +3606,10 @@ delayed_action_handle_one (NMPlatform *platform)
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	gpointer user_data;
 
-	if (priv->delayed_action.flags == DELAYED_ACTION_TYPE_NONE)
+	/* a pending resync continues once all other actions are done, so
+	 * the empty flags alone don't mean that nothing is left to do. */
+	if (   priv->delayed_action.flags == DELAYED_ACTION_TYPE_NONE
+	    && !priv->resync.start_ns)
 		return FALSE;
 
 	/* First process DELAYED_ACTION_TYPE_MASTER_CONNECTED actions.
@@ -3043,6 +3679,10 @@ delayed_action_handle_one (NMPlatform *platform)
 		return TRUE;
 	}
 
+	/* Last, continue with the next stage of a pending resync. */
+	if (delayed_action_handle_RESYNC (platform))
+		return TRUE;
+
 	return FALSE;
 }
 
@@ -3063,6 +3703,8 @@ delayed_action_handle_all (NMPlatform *platform, gboolean read_netlink)
 
 	cache_prune_candidates_prune (platform);
 
+	_nm_platform_changes_batch_flush (platform);
+
 	return any;
 }
 
@@ -3105,12 +3747,14 @@ delayed_action_schedule (NMPlatform *platform, DelayedActionType action_type, gp
 
 static void
 delayed_action_schedule_WAIT_FOR_NL_RESPONSE (NMPlatform *platform,
+                                              gboolean on_event_socket,
                                               guint32 seq_number,
                                               WaitForNlResponseResult *out_seq_result,
                                               gint *out_refresh_all_in_progess)
 {
 	DelayedActionWaitForNlResponseData data = {
 		.seq_number = seq_number,
+		.on_event_socket = on_event_socket,
 		.timeout_abs_ns = nm_utils_get_monotonic_timestamp_ns () + (200 * (NM_UTILS_NS_PER_SECOND / 1000)),
 		.out_seq_result = out_seq_result,
 		.out_refresh_all_in_progess = out_refresh_all_in_progess,
@@ -3218,6 +3862,9 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 
 	nm_assert (klass == (new ? NMP_OBJECT_GET_CLASS (new) : NMP_OBJECT_GET_CLASS (old)));
 
+	NM_PROBE3 (cache__op, (int) ops_type, (int) klass->obj_type,
+	           (old ? old : new)->object.ifindex);
+
 	_LOGt ("update-cache-%s: %s: %s%s%s",
 	       klass->obj_type_name,
 	       (ops_type == NMP_CACHE_OPS_UPDATED
@@ -3235,6 +3882,41 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 
 	switch (klass->obj_type) {
 	case NMP_OBJECT_TYPE_LINK:
+		{
+			/* cached sysctl files of a removed or renamed link are stale. The
+			 * files are cached by path, so also drop those for the new name:
+			 * they might have been opened for another link that had the name
+			 * before, and that was renamed or removed in the meantime. */
+			if (   old
+			    && (   ops_type == NMP_CACHE_OPS_REMOVED
+			        || (new && strcmp (old->link.name, new->link.name) != 0)))
+				_sysctl_fd_cache_invalidate_ifname (priv, old->link.name);
+			if (   new
+			    && (   ops_type == NMP_CACHE_OPS_ADDED
+			        || (old && strcmp (old->link.name, new->link.name) != 0)))
+				_sysctl_fd_cache_invalidate_ifname (priv, new->link.name);
+		}
+		{
+			/* the results of ethtool refer to the interface with the name and
+			 * driver at the time of the query. */
+			if (   old
+			    && (   ops_type == NMP_CACHE_OPS_REMOVED
+			        || !new->_link.netlink.is_in_netlink
+			        || strcmp (old->link.name, new->link.name) != 0
+			        || old->link.driver != new->link.driver))
+				g_hash_table_remove (priv->ethtool_cache, &old->link.ifindex);
+		}
+		{
+			/* forget the payload hash and the counters of removed links. Also, if the
+			 * netlink part of the link is gone, the next RTM_NEWLINK must not be skipped. */
+			if (   old
+			    && (   ops_type == NMP_CACHE_OPS_REMOVED
+			        || !new->_link.netlink.is_in_netlink))
+				g_hash_table_remove (priv->link_payload_hashes, &old->link.ifindex);
+			if (   old
+			    && ops_type == NMP_CACHE_OPS_REMOVED)
+				g_hash_table_remove (priv->link_statistics, &old->link.ifindex);
+		}
 		{
 			/* check whether changing a slave link can cause a master link (bridge or bond) to go up/down */
 			if (   old
@@ -3470,10 +4152,11 @@ cache_post (NMPlatform *platform,
 /******************************************************************/
 
 static int
-_nl_send_auto_with_seq (NMPlatform *platform,
-                        struct nl_msg *nlmsg,
-                        WaitForNlResponseResult *out_seq_result,
-                        gint *out_refresh_all_in_progess)
+_nl_send_auto_with_seq_full (NMPlatform *platform,
+                             gboolean on_event_socket,
+                             struct nl_msg *nlmsg,
+                             WaitForNlResponseResult *out_seq_result,
+                             gint *out_refresh_all_in_progess)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	guint32 seq;
@@ -3484,17 +4167,84 @@ _nl_send_auto_with_seq (NMPlatform *platform,
 
 	nlmsg_hdr (nlmsg)->nlmsg_seq = seq;
 
-	nle = nl_send_auto (priv->nlh, nlmsg);
+	nle = nl_send_auto (on_event_socket ? priv->nlh_event : priv->nlh, nlmsg);
 
 	if (nle >= 0) {
 		nle = 0;
-		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, seq, out_seq_result, out_refresh_all_in_progess);
+		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, on_event_socket, seq, out_seq_result, out_refresh_all_in_progess);
 	} else
 		_LOGD ("netlink: send: failed sending message: %s (%d)", nl_geterror (nle), nle);
 
 	return nle;
 }
 
+static int
+_nl_send_auto_with_seq (NMPlatform *platform,
+                        struct nl_msg *nlmsg,
+                        WaitForNlResponseResult *out_seq_result,
+                        gint *out_refresh_all_in_progess)
+{
+	return _nl_send_auto_with_seq_full (platform, FALSE, nlmsg, out_seq_result, out_refresh_all_in_progess);
+}
+
+/* Limits for sending several netlink requests at once with _nl_send_batch_with_seq().
+ * The size must stay well below the socket's send buffer. */
+#define BATCH_SEND_MAX_MSGS    64
+#define BATCH_SEND_MAX_BYTES   (16 * 1024)
+
+static int
+_nl_send_batch_with_seq (NMPlatform *platform,
+                         struct nl_msg *const*nlmsgs,
+                         WaitForNlResponseResult *const*out_seq_results,
+                         guint n_msgs)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	struct sockaddr_nl nladdr = {
+		.nl_family = AF_NETLINK,
+	};
+	struct iovec iov[BATCH_SEND_MAX_MSGS];
+	guint32 seqs[BATCH_SEND_MAX_MSGS];
+	struct msghdr msg = {
+		.msg_name = &nladdr,
+		.msg_namelen = sizeof (nladdr),
+		.msg_iov = iov,
+		.msg_iovlen = n_msgs,
+	};
+	guint i;
+
+	nm_assert (n_msgs > 0 && n_msgs <= BATCH_SEND_MAX_MSGS);
+
+	for (i = 0; i < n_msgs; i++) {
+		struct nlmsghdr *hdr = nlmsg_hdr (nlmsgs[i]);
+
+		/* complete the message with a sequence number (ensuring it's not zero). */
+		seqs[i] = priv->nlh_seq_next++ ?: priv->nlh_seq_next++;
+		hdr->nlmsg_seq = seqs[i];
+
+		/* sets the port-id and the NLM_F_REQUEST and NLM_F_ACK flags. */
+		nl_complete_msg (priv->nlh, nlmsgs[i]);
+
+		iov[i].iov_base = hdr;
+		iov[i].iov_len = hdr->nlmsg_len;
+	}
+
+	/* Kernel processes (and acknowledges) each message of the datagram in order. */
+	while (sendmsg (nl_socket_get_fd (priv->nlh), &msg, 0) < 0) {
+		int errsv = errno;
+
+		if (errsv == EINTR)
+			continue;
+		_LOGD ("netlink: send: failed sending %u messages: %s (%d)", n_msgs, g_strerror (errsv), errsv);
+		for (i = 0; i < n_msgs; i++)
+			*out_seq_results[i] = -errsv;
+		return -errsv;
+	}
+
+	for (i = 0; i < n_msgs; i++)
+		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, FALSE, seqs[i], out_seq_results[i], NULL);
+	return 0;
+}
+
 static void
 do_request_link_no_delayed_actions (NMPlatform *platform, int ifindex, const char *name)
 {
@@ -3522,7 +4272,7 @@ do_request_link_no_delayed_actions (NMPlatform *platform, int ifindex, const cha
 	                          0,
 	                          0);
 	if (nlmsg)
-		_nl_send_auto_with_seq (platform, nlmsg, NULL, NULL);
+		_nl_send_auto_with_seq_full (platform, TRUE, nlmsg, NULL, NULL);
 }
 
 static void
@@ -3532,6 +4282,57 @@ do_request_link (NMPlatform *platform, int ifindex, const char *name)
 	delayed_action_handle_all (platform, FALSE);
 }
 
+/* Creates the request to refresh all objects of @obj_type that belong to
+ * @ifindex. The link is requested directly, with an ACK to complete the
+ * request. Address and route dumps carry the ifindex, which the kernel
+ * honours if NETLINK_GET_STRICT_CHK is enabled on the socket. Older kernels
+ * ignore it and dump everything, which event_valid_msg() then drops. */
+static struct nl_msg *
+_nl_msg_new_dump_filtered (NMPObjectType obj_type, int ifindex)
+{
+	const NMPClass *klass = nmp_class_from_type (obj_type);
+	struct nl_msg *msg;
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_LINK:
+		return _nl_msg_new_link (RTM_GETLINK, NLM_F_ACK, ifindex, NULL, 0, 0);
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+	case NMP_OBJECT_TYPE_IP6_ADDRESS: {
+		struct ifaddrmsg ifa = {
+			.ifa_family = klass->addr_family,
+			.ifa_index = ifindex,
+		};
+
+		msg = nlmsg_alloc_simple (klass->rtm_gettype, NLM_F_DUMP);
+		if (!msg)
+			return NULL;
+		if (nlmsg_append (msg, &ifa, sizeof (ifa), NLMSG_ALIGNTO) < 0)
+			goto nla_put_failure;
+		return msg;
+	}
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE: {
+		struct rtmsg rtm = {
+			.rtm_family = klass->addr_family,
+		};
+
+		msg = nlmsg_alloc_simple (klass->rtm_gettype, NLM_F_DUMP);
+		if (!msg)
+			return NULL;
+		if (nlmsg_append (msg, &rtm, sizeof (rtm), NLMSG_ALIGNTO) < 0)
+			goto nla_put_failure;
+		NLA_PUT_U32 (msg, RTA_OIF, ifindex);
+		return msg;
+	}
+	default:
+		g_return_val_if_reached (NULL);
+	}
+
+nla_put_failure:
+	nlmsg_free (msg);
+	g_return_val_if_reached (NULL);
+}
+
 static void
 do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType action_type)
 {
@@ -3570,19 +4371,25 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 
 		event_handler_read_netlink (platform, FALSE);
 
-		/* reimplement
-		 *   nl_rtgen_request (sk, klass->rtm_gettype, klass->addr_family, NLM_F_DUMP);
-		 * because we need the sequence number.
-		 */
-		nlmsg = nlmsg_alloc_simple (klass->rtm_gettype, NLM_F_DUMP);
-		if (!nlmsg)
-			continue;
+		if (priv->ifindex_filter > 0) {
+			nlmsg = _nl_msg_new_dump_filtered (obj_type, priv->ifindex_filter);
+			if (!nlmsg)
+				continue;
+		} else {
+			/* reimplement
+			 *   nl_rtgen_request (sk, klass->rtm_gettype, klass->addr_family, NLM_F_DUMP);
+			 * because we need the sequence number.
+			 */
+			nlmsg = nlmsg_alloc_simple (klass->rtm_gettype, NLM_F_DUMP);
+			if (!nlmsg)
+				continue;
 
-		nle = nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
-		if (nle < 0)
-			continue;
+			nle = nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
+			if (nle < 0)
+				continue;
+		}
 
-		if (_nl_send_auto_with_seq (platform, nlmsg, NULL, out_refresh_all_in_progess) < 0) {
+		if (_nl_send_auto_with_seq_full (platform, TRUE, nlmsg, NULL, out_refresh_all_in_progess) < 0) {
 			nm_assert (*out_refresh_all_in_progess > 0);
 			*out_refresh_all_in_progess -= 1;
 		}
@@ -3663,6 +4470,237 @@ event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResu
 #endif
 }
 
+typedef struct {
+	int ifindex;
+	guint64 hash;
+} LinkPayloadHash;
+
+#define FNV1A_64_INIT ((guint64) 0xcbf29ce484222325ULL)
+
+static guint64
+_fnv1a_64 (guint64 h, gconstpointer data, gsize len)
+{
+	const guint8 *p = data;
+
+	while (len--) {
+		h ^= *p++;
+		h *= (guint64) 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static guint64
+_link_payload_hash_nested (guint64 h, const struct nlattr *nla, int skip_type1, int skip_type2)
+{
+	struct nlattr *child;
+	int remaining;
+
+	h = _fnv1a_64 (h, &nla->nla_type, sizeof (nla->nla_type));
+	nla_for_each_nested (child, (struct nlattr *) nla, remaining) {
+		if (NM_IN_SET (nla_type (child), skip_type1, skip_type2))
+			continue;
+		h = _fnv1a_64 (h, child, child->nla_len);
+	}
+	return h;
+}
+
+static guint64
+_link_payload_hash (struct nlmsghdr *nlh)
+{
+	struct nlattr *nla;
+	struct nlattr *af_attr;
+	int remaining, remaining2;
+	guint64 h = FNV1A_64_INIT;
+
+	h = _fnv1a_64 (h, nlmsg_data (nlh), sizeof (struct ifinfomsg));
+
+	/* Hash all attributes, except the traffic counters. They change all the time,
+	 * but we don't parse them into NMPlatformLink anyway. */
+	nlmsg_for_each_attr (nla, nlh, sizeof (struct ifinfomsg), remaining) {
+		switch (nla_type (nla)) {
+		case IFLA_STATS:
+		case IFLA_STATS64:
+			break;
+		case IFLA_LINKINFO:
+			h = _link_payload_hash_nested (h, nla, IFLA_INFO_XSTATS, -1);
+			break;
+		case IFLA_AF_SPEC:
+			h = _fnv1a_64 (h, &nla->nla_type, sizeof (nla->nla_type));
+			nla_for_each_nested (af_attr, nla, remaining2) {
+				if (nla_type (af_attr) == AF_INET6)
+					h = _link_payload_hash_nested (h, af_attr, IFLA_INET6_STATS, IFLA_INET6_ICMP6STATS);
+				else
+					h = _fnv1a_64 (h, af_attr, af_attr->nla_len);
+			}
+			break;
+		default:
+			h = _fnv1a_64 (h, nla, nla->nla_len);
+			break;
+		}
+	}
+	return h;
+}
+
+/* Statistics-only RTM_NEWLINK messages arrive constantly on busy hosts.
+ * Parsing them is comparatively expensive (it might even read sysfs), only
+ * to find out in nmp_cache_update_netlink() that nothing changed. Remember
+ * a hash of the relevant payload per ifindex, and skip messages with the same
+ * hash before constructing an object. */
+static gboolean
+_link_payload_unchanged (NMPlatform *platform, struct nlmsghdr *nlh)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const struct ifinfomsg *ifi;
+	LinkPayloadHash *entry;
+	const NMPObject *obj_cache;
+	guint64 hash;
+
+	if (!nlmsg_valid_hdr (nlh, sizeof (*ifi)))
+		return FALSE;
+	ifi = nlmsg_data (nlh);
+
+	hash = _link_payload_hash (nlh);
+
+	entry = g_hash_table_lookup (priv->link_payload_hashes, &ifi->ifi_index);
+	if (entry) {
+		if (entry->hash == hash) {
+			obj_cache = nmp_cache_lookup_link (priv->cache, ifi->ifi_index);
+			if (obj_cache && obj_cache->_link.netlink.is_in_netlink) {
+				/* the message is still a reply to a dump, if a refresh is in progress. */
+				cache_prune_candidates_drop (platform, obj_cache);
+				return TRUE;
+			}
+		}
+	} else {
+		entry = g_slice_new (LinkPayloadHash);
+		entry->ifindex = ifi->ifi_index;
+		g_hash_table_add (priv->link_payload_hashes, entry);
+	}
+	entry->hash = hash;
+	return FALSE;
+}
+
+static void
+_link_payload_hash_free (gpointer data)
+{
+	g_slice_free (LinkPayloadHash, data);
+}
+
+typedef struct {
+	int ifindex;
+	NMPlatformLinkStatistics stats;
+} LinkStatistics;
+
+/* The counters are not part of NMPlatformLink, otherwise every message
+ * would be a change of the link. Instead, remember them separately
+ * before _link_payload_unchanged() possibly skips the message. */
+static void
+_link_statistics_update (NMPlatform *platform, struct nlmsghdr *nlh)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const struct ifinfomsg *ifi;
+	const struct nlattr *nla;
+	struct rtnl_link_stats64 stats64;
+	LinkStatistics *entry;
+
+	if (!nlmsg_valid_hdr (nlh, sizeof (*ifi)))
+		return;
+	ifi = nlmsg_data (nlh);
+
+	nla = nlmsg_find_attr (nlh, sizeof (*ifi), IFLA_STATS64);
+	if (   !nla
+	    || nla_len (nla) < (int) offset_plus_sizeof (struct rtnl_link_stats64, tx_bytes))
+		return;
+
+	memset (&stats64, 0, sizeof (stats64));
+	memcpy (&stats64, nla_data (nla), MIN ((gsize) nla_len (nla), sizeof (stats64)));
+
+	entry = g_hash_table_lookup (priv->link_statistics, &ifi->ifi_index);
+	if (!entry) {
+		entry = g_slice_new (LinkStatistics);
+		entry->ifindex = ifi->ifi_index;
+		g_hash_table_add (priv->link_statistics, entry);
+	}
+	entry->stats.rx_packets = stats64.rx_packets;
+	entry->stats.rx_bytes = stats64.rx_bytes;
+	entry->stats.tx_packets = stats64.tx_packets;
+	entry->stats.tx_bytes = stats64.tx_bytes;
+}
+
+static void
+_link_statistics_free (gpointer data)
+{
+	g_slice_free (LinkStatistics, data);
+}
+
+/* Whether a link or address message is about another interface than
+ * @ifindex. Routes always pass, their ifindex is checked after parsing. */
+static gboolean
+_nlmsg_ifindex_filtered (struct nlmsghdr *msghdr, int ifindex)
+{
+	switch (msghdr->nlmsg_type) {
+	case RTM_NEWLINK:
+	case RTM_DELLINK:
+		if (nlmsg_datalen (msghdr) < (int) sizeof (struct ifinfomsg))
+			return FALSE;
+		return ((const struct ifinfomsg *) nlmsg_data (msghdr))->ifi_index != ifindex;
+	case RTM_NEWADDR:
+	case RTM_DELADDR:
+		if (nlmsg_datalen (msghdr) < (int) sizeof (struct ifaddrmsg))
+			return FALSE;
+		return ((const struct ifaddrmsg *) nlmsg_data (msghdr))->ifa_index != ifindex;
+	default:
+		return FALSE;
+	}
+}
+
+/* The replies to dcbnl set commands carry the status that the driver
+ * returned in their only attribute; kernel acknowledges them anyway. */
+static void
+_dcb_reply_check (NMPlatform *platform, struct nlmsghdr *msghdr)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const struct dcbmsg *dcb;
+	struct nlattr *nla;
+
+	if (nlmsg_datalen (msghdr) < (int) sizeof (struct dcbmsg))
+		return;
+	dcb = nlmsg_data (msghdr);
+
+	nla = nlmsg_attrdata (msghdr, sizeof (struct dcbmsg));
+	if (   nlmsg_attrlen (msghdr, sizeof (struct dcbmsg)) >= (int) nla_attr_size (sizeof (guint8))
+	    && nla_len (nla) >= (int) sizeof (guint8)
+	    && nla_get_u8 (nla) != 0) {
+		_LOGD ("dcb: command %u failed with status %u", dcb->cmd, nla_get_u8 (nla));
+		priv->dcb_failures++;
+	}
+}
+
+/* The reply to the RTM_GETQDISC request of qdisc_get_root(). Qdisc
+ * messages are not cached, we don't subscribe to RTNLGRP_TC. */
+static void
+_qdisc_reply_check (NMPlatform *platform, struct nlmsghdr *msghdr)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	static struct nla_policy policy[TCA_MAX + 1] = {
+		[TCA_KIND] = { .type = NLA_STRING },
+	};
+	struct nlattr *tb[TCA_MAX + 1];
+	const struct tcmsg *tcm;
+
+	if (!priv->qdisc_request_ifindex)
+		return;
+	if (nlmsg_parse (msghdr, sizeof (struct tcmsg), tb, TCA_MAX, policy) < 0)
+		return;
+
+	tcm = nlmsg_data (msghdr);
+	if (   tcm->tcm_ifindex != priv->qdisc_request_ifindex
+	    || tcm->tcm_parent != TC_H_ROOT
+	    || !tb[TCA_KIND])
+		return;
+	nla_strlcpy (priv->qdisc_reply_kind, tb[TCA_KIND], sizeof (priv->qdisc_reply_kind));
+}
+
 static void
 event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_events)
 {
@@ -3677,9 +4715,21 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 
 	msghdr = nlmsg_hdr (msg);
 
+	NM_PROBE3 (netlink__msg, msghdr->nlmsg_type, msghdr->nlmsg_seq, msghdr->nlmsg_len);
+
 	if (_support_kernel_extended_ifa_flags_still_undecided () && msghdr->nlmsg_type == RTM_NEWADDR)
 		_support_kernel_extended_ifa_flags_detect (msg);
 
+	if (msghdr->nlmsg_type == RTM_SETDCB) {
+		_dcb_reply_check (platform, msghdr);
+		return;
+	}
+
+	if (msghdr->nlmsg_type == RTM_NEWQDISC) {
+		_qdisc_reply_check (platform, msghdr);
+		return;
+	}
+
 	if (!handle_events)
 		return;
 
@@ -3689,7 +4739,30 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 		id_only = TRUE;
 	}
 
+	if (priv->resync.start_ns)
+		priv->netlink_stats.resync_messages++;
+
+	if (   priv->ifindex_filter > 0
+	    && _nlmsg_ifindex_filtered (msghdr, priv->ifindex_filter)) {
+		priv->netlink_stats.filtered_messages++;
+		return;
+	}
+
+	if (msghdr->nlmsg_type == RTM_NEWLINK)
+		_link_statistics_update (platform, msghdr);
+
+	if (   msghdr->nlmsg_type == RTM_NEWLINK
+	    && _link_payload_unchanged (platform, msghdr)) {
+		priv->netlink_stats.newlink_skipped++;
+		_LOGt ("event-notification: %s, seq %u: skip unchanged link %d",
+		       _nl_nlmsg_type_to_str (msghdr->nlmsg_type, buf_nlmsg_type, sizeof (buf_nlmsg_type)),
+		       msghdr->nlmsg_seq, ((const struct ifinfomsg *) nlmsg_data (msghdr))->ifi_index);
+		return;
+	}
+
 	obj = nmp_object_new_from_nl (platform, priv->cache, msg, id_only);
+	NM_PROBE3 (netlink__parsed, msghdr->nlmsg_type, msghdr->nlmsg_seq,
+	           obj ? (int) NMP_OBJECT_GET_TYPE (obj) : 0);
 	if (!obj) {
 		_LOGT ("event-notification: %s, seq %u: ignore",
 		       _nl_nlmsg_type_to_str (msghdr->nlmsg_type, buf_nlmsg_type, sizeof (buf_nlmsg_type)),
@@ -3697,6 +4770,13 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 		return;
 	}
 
+	if (   priv->ifindex_filter > 0
+	    && obj->object.ifindex != priv->ifindex_filter) {
+		/* routes, whose ifindex is only known after parsing */
+		priv->netlink_stats.filtered_messages++;
+		return;
+	}
+
 	_LOGT ("event-notification: %s, seq %u: %s",
 	       _nl_nlmsg_type_to_str (msghdr->nlmsg_type, buf_nlmsg_type, sizeof (buf_nlmsg_type)),
 	       msghdr->nlmsg_seq, nmp_object_to_string (obj,
@@ -4019,9 +5099,10 @@ out:
 }
 
 static NMPlatformError
-do_change_link (NMPlatform *platform,
-                int ifindex,
-                struct nl_msg *nlmsg)
+do_change_link_full (NMPlatform *platform,
+                     int ifindex,
+                     struct nl_msg *nlmsg,
+                     gboolean retry_setlink)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
@@ -4051,7 +5132,8 @@ retry:
 
 	nm_assert (seq_result);
 
-	if (   NM_IN_SET (-((int) seq_result), EOPNOTSUPP)
+	if (   retry_setlink
+	    && NM_IN_SET (-((int) seq_result), EOPNOTSUPP)
 	    && nlmsg_hdr (nlmsg)->nlmsg_type == RTM_NEWLINK) {
 		nlmsg_hdr (nlmsg)->nlmsg_type = RTM_SETLINK;
 		goto retry;
@@ -4078,6 +5160,14 @@ retry:
 	return result;
 }
 
+static NMPlatformError
+do_change_link (NMPlatform *platform,
+                int ifindex,
+                struct nl_msg *nlmsg)
+{
+	return do_change_link_full (platform, ifindex, nlmsg, TRUE);
+}
+
 static gboolean
 link_add (NMPlatform *platform,
           const char *name,
@@ -4193,28 +5283,508 @@ link_refresh (NMPlatform *platform, int ifindex)
 	return !!cache_lookup_link (platform, ifindex);
 }
 
-static gboolean
-link_set_netns (NMPlatform *platform,
-                int ifindex,
-                int netns_fd)
+static void
+link_statistics_refresh (NMPlatform *platform)
 {
-	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	/* a single dump for all links. The replies update the counters,
+	 * unchanged links are skipped before parsing. */
+	do_request_one_type (platform, NMP_OBJECT_TYPE_LINK);
+}
 
-	_LOGD ("link: move link %d to network namespace with fd %d", ifindex, netns_fd);
+static gboolean
+link_get_statistics (NMPlatform *platform, int ifindex, NMPlatformLinkStatistics *out_stats)
+{
+	LinkStatistics *entry;
 
-	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
-	                          0,
-	                          ifindex,
-	                          NULL,
-	                          0,
-	                          0);
-	if (!nlmsg)
+	entry = g_hash_table_lookup (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->link_statistics, &ifindex);
+	if (!entry)
 		return FALSE;
 
-	NLA_PUT (nlmsg, IFLA_NET_NS_FD, 4, &netns_fd);
-	return do_change_link (platform, ifindex, nlmsg) == NM_PLATFORM_ERROR_SUCCESS;
+	*out_stats = entry->stats;
+	return TRUE;
+}
 
-nla_put_failure:
+static struct nl_msg *
+_nl_msg_new_dcb (const char *ifname, guint8 cmd)
+{
+	struct nl_msg *nlmsg;
+	const struct dcbmsg dcb = {
+		.dcb_family = AF_UNSPEC,
+		.cmd = cmd,
+	};
+
+	nlmsg = nlmsg_alloc_simple (RTM_SETDCB, 0);
+	if (!nlmsg)
+		g_return_val_if_reached (NULL);
+
+	if (nlmsg_append (nlmsg, &dcb, sizeof (dcb), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	NLA_PUT_STRING (nlmsg, DCB_ATTR_IFNAME, ifname);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_dcb_u8 (const char *ifname, guint8 cmd, int attr, guint8 value)
+{
+	struct nl_msg *nlmsg;
+
+	nlmsg = _nl_msg_new_dcb (ifname, cmd);
+	if (!nlmsg)
+		return NULL;
+	NLA_PUT_U8 (nlmsg, attr, value);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_dcb_featcfg (const char *ifname, const NMPlatformDcbConfig *config)
+{
+	struct nl_msg *nlmsg;
+	struct nlattr *nest;
+
+	nlmsg = _nl_msg_new_dcb (ifname, DCB_CMD_SFEATCFG);
+	if (!nlmsg)
+		return NULL;
+
+	if (!(nest = nla_nest_start (nlmsg, DCB_ATTR_FEATCFG)))
+		goto nla_put_failure;
+	NLA_PUT_U8 (nlmsg, DCB_FEATCFG_ATTR_PG, config ? config->pg_flags : 0);
+	NLA_PUT_U8 (nlmsg, DCB_FEATCFG_ATTR_PFC, config ? config->pfc_flags : 0);
+	NLA_PUT_U8 (nlmsg, DCB_FEATCFG_ATTR_APP, config ? config->app_flags : 0);
+	nla_nest_end (nlmsg, nest);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_dcb_pfc (const char *ifname, const NMPlatformDcbConfig *config)
+{
+	struct nl_msg *nlmsg;
+	struct nlattr *nest;
+	guint i;
+
+	nlmsg = _nl_msg_new_dcb (ifname, DCB_CMD_PFC_SCFG);
+	if (!nlmsg)
+		return NULL;
+
+	if (!(nest = nla_nest_start (nlmsg, DCB_ATTR_PFC_CFG)))
+		goto nla_put_failure;
+	for (i = 0; i < 8; i++)
+		NLA_PUT_U8 (nlmsg, DCB_PFC_UP_ATTR_0 + i, !!(config->pfc_up & (1 << i)));
+	nla_nest_end (nlmsg, nest);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_dcb_pg (const char *ifname, const NMPlatformDcbConfig *config)
+{
+	struct nl_msg *nlmsg;
+	struct nlattr *nest, *nest_tc;
+	guint i;
+
+	nlmsg = _nl_msg_new_dcb (ifname, DCB_CMD_PGTX_SCFG);
+	if (!nlmsg)
+		return NULL;
+
+	if (!(nest = nla_nest_start (nlmsg, DCB_ATTR_PG_CFG)))
+		goto nla_put_failure;
+	for (i = 0; i < 8; i++) {
+		if (!(nest_tc = nla_nest_start (nlmsg, DCB_PG_ATTR_TC_0 + i)))
+			goto nla_put_failure;
+		NLA_PUT_U8 (nlmsg, DCB_TC_ATTR_PARAM_PGID, config->pg_tc[i].pgid);
+		NLA_PUT_U8 (nlmsg, DCB_TC_ATTR_PARAM_UP_MAPPING, config->pg_tc[i].up_mapping);
+		NLA_PUT_U8 (nlmsg, DCB_TC_ATTR_PARAM_STRICT_PRIO, config->pg_tc[i].strict);
+		NLA_PUT_U8 (nlmsg, DCB_TC_ATTR_PARAM_BW_PCT, config->pg_tc[i].bw_pct);
+		nla_nest_end (nlmsg, nest_tc);
+	}
+	for (i = 0; i < 8; i++)
+		NLA_PUT_U8 (nlmsg, DCB_PG_ATTR_BW_ID_0 + i, config->pg_bw_pct[i]);
+	nla_nest_end (nlmsg, nest);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static struct nl_msg *
+_nl_msg_new_dcb_app (const char *ifname, const NMPlatformDcbConfig *config, guint idx)
+{
+	struct nl_msg *nlmsg;
+	struct nlattr *nest;
+
+	nlmsg = _nl_msg_new_dcb (ifname, DCB_CMD_SAPP);
+	if (!nlmsg)
+		return NULL;
+
+	if (!(nest = nla_nest_start (nlmsg, DCB_ATTR_APP)))
+		goto nla_put_failure;
+	NLA_PUT_U8 (nlmsg, DCB_APP_ATTR_IDTYPE, config->apps[idx].idtype);
+	NLA_PUT_U16 (nlmsg, DCB_APP_ATTR_ID, config->apps[idx].id);
+	NLA_PUT_U8 (nlmsg, DCB_APP_ATTR_PRIORITY, config->apps[idx].up_map);
+	nla_nest_end (nlmsg, nest);
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static gboolean
+link_set_dcb (NMPlatform *platform,
+              int ifindex,
+              gboolean enable,
+              const NMPlatformDcbConfig *config)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	struct nl_msg *nlmsgs[16];
+	WaitForNlResponseResult seq_results[G_N_ELEMENTS (nlmsgs)] = { 0 };
+	WaitForNlResponseResult *nlmsgs_seq_results[G_N_ELEMENTS (nlmsgs)];
+	const NMPlatformLink *pllink;
+	guint n = 0, i;
+	gboolean success = TRUE;
+	char s_buf[256];
+
+	pllink = nm_platform_link_get (platform, ifindex);
+	if (!pllink)
+		return FALSE;
+
+	/* One batch: the driver keeps the pending configuration and applies
+	 * all of it on DCB_CMD_SET_ALL. When disabling, the features are turned
+	 * off before DCB itself. */
+	if (enable)
+		nlmsgs[n++] = _nl_msg_new_dcb_u8 (pllink->name, DCB_CMD_SSTATE, DCB_ATTR_STATE, 1);
+	if (config) {
+		if (enable) {
+			if (config->pfc_flags & NM_PLATFORM_DCB_FEAT_ENABLE)
+				nlmsgs[n++] = _nl_msg_new_dcb_pfc (pllink->name, config);
+			nlmsgs[n++] = _nl_msg_new_dcb_u8 (pllink->name, DCB_CMD_SPFCSTATE, DCB_ATTR_PFC_STATE,
+			                                  !!(config->pfc_flags & NM_PLATFORM_DCB_FEAT_ENABLE));
+			if (config->pg_flags & NM_PLATFORM_DCB_FEAT_ENABLE)
+				nlmsgs[n++] = _nl_msg_new_dcb_pg (pllink->name, config);
+			for (i = 0; i < config->n_apps; i++)
+				nlmsgs[n++] = _nl_msg_new_dcb_app (pllink->name, config, i);
+		}
+		nlmsgs[n++] = _nl_msg_new_dcb_featcfg (pllink->name, enable ? config : NULL);
+		nlmsgs[n++] = _nl_msg_new_dcb_u8 (pllink->name, DCB_CMD_SET_ALL, DCB_ATTR_SET_ALL, 1);
+	}
+	if (!enable)
+		nlmsgs[n++] = _nl_msg_new_dcb_u8 (pllink->name, DCB_CMD_SSTATE, DCB_ATTR_STATE, 0);
+
+	nm_assert (n <= G_N_ELEMENTS (nlmsgs));
+
+	for (i = 0; i < n; i++) {
+		if (!nlmsgs[i])
+			success = FALSE;
+		nlmsgs_seq_results[i] = &seq_results[i];
+	}
+
+	if (success) {
+		event_handler_read_netlink (platform, FALSE);
+
+		priv->dcb_failures = 0;
+		_nl_send_batch_with_seq (platform, nlmsgs, nlmsgs_seq_results, n);
+		delayed_action_handle_all (platform, FALSE);
+
+		for (i = 0; i < n; i++) {
+			if (seq_results[i] != WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK) {
+				_LOGD ("dcb: %s: request %u failed: %s", pllink->name, i,
+				       wait_for_nl_response_to_string (seq_results[i], s_buf, sizeof (s_buf)));
+				success = FALSE;
+				break;
+			}
+		}
+		if (priv->dcb_failures)
+			success = FALSE;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (nlmsgs[i])
+			nlmsg_free (nlmsgs[i]);
+	}
+	return success;
+}
+
+static struct nl_msg *
+_nl_msg_new_qdisc (int nlmsg_type, int nlmsg_flags, int ifindex, const NMPlatformQdisc *qdisc)
+{
+	struct nl_msg *nlmsg;
+	struct nlattr *nest;
+	const struct tcmsg tcm = {
+		.tcm_family = AF_UNSPEC,
+		.tcm_ifindex = ifindex,
+		.tcm_parent = TC_H_ROOT,
+	};
+
+	nlmsg = nlmsg_alloc_simple (nlmsg_type, nlmsg_flags);
+	if (!nlmsg)
+		g_return_val_if_reached (NULL);
+
+	if (nlmsg_append (nlmsg, &tcm, sizeof (tcm), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	if (!qdisc)
+		return nlmsg;
+
+	NLA_PUT_STRING (nlmsg, TCA_KIND, qdisc->kind);
+
+	/* only add options for the kinds we know. Others, like "pfifo",
+	 * reject options that are shorter than they expect. */
+	if (nm_streq (qdisc->kind, "fq_codel")) {
+		if (!(nest = nla_nest_start (nlmsg, TCA_OPTIONS)))
+			goto nla_put_failure;
+		if (qdisc->target_us)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_CODEL_TARGET, qdisc->target_us);
+		if (qdisc->limit)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_CODEL_LIMIT, qdisc->limit);
+		if (qdisc->interval_us)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_CODEL_INTERVAL, qdisc->interval_us);
+		if (qdisc->ecn != -1)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_CODEL_ECN, !!qdisc->ecn);
+		nla_nest_end (nlmsg, nest);
+	} else if (nm_streq (qdisc->kind, "fq")) {
+		if (!(nest = nla_nest_start (nlmsg, TCA_OPTIONS)))
+			goto nla_put_failure;
+		if (qdisc->limit)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_PLIMIT, qdisc->limit);
+		if (qdisc->rate)
+			NLA_PUT_U32 (nlmsg, TCA_FQ_FLOW_MAX_RATE, MIN (qdisc->rate, G_MAXUINT32));
+		nla_nest_end (nlmsg, nest);
+	} else if (nm_streq (qdisc->kind, "cake")) {
+		if (!(nest = nla_nest_start (nlmsg, TCA_OPTIONS)))
+			goto nla_put_failure;
+		if (qdisc->rate)
+			NLA_PUT_U64 (nlmsg, TCA_CAKE_BASE_RATE64, qdisc->rate);
+		if (qdisc->interval_us)
+			NLA_PUT_U32 (nlmsg, TCA_CAKE_RTT, qdisc->interval_us);
+		if (qdisc->target_us)
+			NLA_PUT_U32 (nlmsg, TCA_CAKE_TARGET, qdisc->target_us);
+		nla_nest_end (nlmsg, nest);
+	}
+
+	return nlmsg;
+
+nla_put_failure:
+	nlmsg_free (nlmsg);
+	g_return_val_if_reached (NULL);
+}
+
+static gboolean
+qdisc_get_root (NMPlatform *platform, int ifindex, NMPlatformQdisc *out_qdisc)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
+	char s_buf[256];
+	int nle;
+
+	if (!nm_platform_netns_push (platform, &netns))
+		return FALSE;
+
+	/* without NLM_F_ECHO, kernel only sends the reply to RTNLGRP_TC. */
+	nlmsg = _nl_msg_new_qdisc (RTM_GETQDISC, NLM_F_ECHO, ifindex, NULL);
+	if (!nlmsg)
+		return FALSE;
+
+	event_handler_read_netlink (platform, FALSE);
+
+	priv->qdisc_request_ifindex = ifindex;
+	priv->qdisc_reply_kind[0] = '\0';
+
+	nle = _nl_send_auto_with_seq (platform, nlmsg, &seq_result, NULL);
+	if (nle >= 0)
+		delayed_action_handle_all (platform, FALSE);
+
+	priv->qdisc_request_ifindex = 0;
+
+	if (   nle < 0
+	    || seq_result != WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK
+	    || !priv->qdisc_reply_kind[0]) {
+		_LOGD ("qdisc: failure requesting the root qdisc of %d: %s",
+		       ifindex,
+		       nle < 0 ? nl_geterror (nle) : wait_for_nl_response_to_string (seq_result, s_buf, sizeof (s_buf)));
+		return FALSE;
+	}
+
+	memset (out_qdisc, 0, sizeof (*out_qdisc));
+	g_strlcpy (out_qdisc->kind, priv->qdisc_reply_kind, sizeof (out_qdisc->kind));
+	out_qdisc->ecn = -1;
+	return TRUE;
+}
+
+static gboolean
+qdisc_set_root (NMPlatform *platform, int ifindex, const NMPlatformQdisc *qdisc)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
+	char s_buf[256];
+	int nle;
+
+	if (!nm_platform_netns_push (platform, &netns))
+		return FALSE;
+
+	nlmsg = _nl_msg_new_qdisc (RTM_NEWQDISC, NLM_F_CREATE | NLM_F_REPLACE, ifindex, qdisc);
+	if (!nlmsg)
+		return FALSE;
+
+	nle = _nl_send_auto_with_seq (platform, nlmsg, &seq_result, NULL);
+	if (nle < 0) {
+		_LOGE ("qdisc: failure sending netlink request \"%s\" (%d)",
+		       nl_geterror (nle), -nle);
+		return FALSE;
+	}
+
+	delayed_action_handle_all (platform, FALSE);
+
+	nm_assert (seq_result);
+
+	_NMLOG (seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK ? LOGL_DEBUG : LOGL_ERR,
+	        "qdisc: %s setting root qdisc %s on %d: %s",
+	        seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK ? "success" : "failure",
+	        qdisc->kind,
+	        ifindex,
+	        wait_for_nl_response_to_string (seq_result, s_buf, sizeof (s_buf)));
+
+	return seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
+}
+
+static gboolean
+link_set_sriov (NMPlatform *platform, int ifindex, guint num_vfs, const NMPlatformSriovVF *vfs, guint n_vfs)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *vfinfo_list, *vfinfo;
+	gs_free char *path = NULL, *current = NULL;
+	const char *ifname;
+	char buf[32];
+	gint64 cur;
+	guint i;
+
+	ifname = nm_platform_link_get_name (platform, ifindex);
+	if (!ifname)
+		return FALSE;
+
+	ifname = NM_ASSERT_VALID_PATH_COMPONENT (ifname);
+
+	path = g_strdup_printf ("/sys/class/net/%s/device/sriov_numvfs", ifname);
+	current = sysctl_get (platform, path);
+	cur = _nm_utils_ascii_str_to_int64 (current, 10, 0, G_MAXUINT, -1);
+	if (cur < 0) {
+		_LOGD ("link: change %d: sriov: the device does not support SR-IOV", ifindex);
+		return FALSE;
+	}
+
+	if (cur != num_vfs) {
+		/* the number of VFs can only be changed from and to zero */
+		if (cur > 0 && !sysctl_set (platform, path, "0"))
+			return FALSE;
+		if (num_vfs > 0 && !sysctl_set (platform, path, nm_sprintf_buf (buf, "%u", num_vfs)))
+			return FALSE;
+	}
+
+	if (!n_vfs)
+		return TRUE;
+
+	_LOGD ("link: change %d: sriov: configuring %u VFs", ifindex, n_vfs);
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	/* All VFs in one message: the kernel applies the entries of the list
+	 * one after the other and stops at the first one that fails. */
+	if (!(vfinfo_list = nla_nest_start (nlmsg, IFLA_VFINFO_LIST)))
+		goto nla_put_failure;
+
+	for (i = 0; i < n_vfs; i++) {
+		const NMPlatformSriovVF *vf = &vfs[i];
+
+		if (!(vfinfo = nla_nest_start (nlmsg, IFLA_VF_INFO)))
+			goto nla_put_failure;
+
+		if (vf->has_mac) {
+			struct ifla_vf_mac ivm = { .vf = vf->index, };
+
+			memcpy (ivm.mac, vf->mac, sizeof (vf->mac));
+			NLA_PUT (nlmsg, IFLA_VF_MAC, sizeof (ivm), &ivm);
+		}
+		if (vf->vlan >= 0) {
+			struct ifla_vf_vlan ivv = {
+				.vf = vf->index,
+				.vlan = vf->vlan,
+				.qos = vf->qos,
+			};
+
+			NLA_PUT (nlmsg, IFLA_VF_VLAN, sizeof (ivv), &ivv);
+		}
+		if (vf->spoof_check >= 0) {
+			struct ifla_vf_spoofchk ivs = {
+				.vf = vf->index,
+				.setting = vf->spoof_check,
+			};
+
+			NLA_PUT (nlmsg, IFLA_VF_SPOOFCHK, sizeof (ivs), &ivs);
+		}
+		if (vf->trust >= 0) {
+			struct ifla_vf_trust ivt = {
+				.vf = vf->index,
+				.setting = vf->trust,
+			};
+
+			NLA_PUT (nlmsg, IFLA_VF_TRUST, sizeof (ivt), &ivt);
+		}
+
+		nla_nest_end (nlmsg, vfinfo);
+	}
+
+	nla_nest_end (nlmsg, vfinfo_list);
+
+	return do_change_link (platform, ifindex, nlmsg) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+link_set_netns (NMPlatform *platform,
+                int ifindex,
+                int netns_fd)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+
+	_LOGD ("link: move link %d to network namespace with fd %d", ifindex, netns_fd);
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	NLA_PUT (nlmsg, IFLA_NET_NS_FD, 4, &netns_fd);
+	return do_change_link (platform, ifindex, nlmsg) == NM_PLATFORM_ERROR_SUCCESS;
+
+nla_put_failure:
 	g_return_val_if_reached (FALSE);
 }
 
@@ -4262,6 +5832,33 @@ link_set_down (NMPlatform *platform, int ifindex)
 	return link_change_flags (platform, ifindex, IFF_UP, 0) == NM_PLATFORM_ERROR_SUCCESS;
 }
 
+static NMPlatformError
+link_change_attrs (NMPlatform *platform, int ifindex, const NMPlatformLinkChangeAttrs *attrs)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	gboolean has_flags = NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_FLAGS);
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          has_flags ? attrs->flags_mask : 0,
+	                          has_flags ? attrs->flags_set : 0);
+	if (!nlmsg)
+		return NM_PLATFORM_ERROR_UNSPECIFIED;
+
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_ADDRESS))
+		NLA_PUT (nlmsg, IFLA_ADDRESS, attrs->address_len, attrs->address);
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MTU))
+		NLA_PUT_U32 (nlmsg, IFLA_MTU, attrs->mtu);
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MASTER))
+		NLA_PUT_U32 (nlmsg, IFLA_MASTER, attrs->master);
+
+	return do_change_link (platform, ifindex, nlmsg);
+nla_put_failure:
+	g_return_val_if_reached (NM_PLATFORM_ERROR_UNSPECIFIED);
+}
+
 static gboolean
 link_set_arp (NMPlatform *platform, int ifindex)
 {
@@ -4329,15 +5926,89 @@ link_set_user_ipv6ll_enabled (NMPlatform *platform, int ifindex, gboolean enable
 	return do_change_link (platform, ifindex, nlmsg) == NM_PLATFORM_ERROR_SUCCESS;
 }
 
+/******************************************************************/
+
+/* Results of ethtool ioctls are cached per link, because they are
+ * requested repeatedly (for example whenever a device is realized or a connection
+ * is checked for compatibility). The cached values must be properties of the
+ * device that don't change while it exists. The entry is dropped when the
+ * link disappears or is renamed, see cache_pre_hook(). The wake-on-lan setting
+ * can be changed by others without a netlink notification and is not cached. */
+
+typedef enum {
+	ETHTOOL_CACHE_CARRIER_DETECT  = (1LL << 0),
+	ETHTOOL_CACHE_VLANS           = (1LL << 1),
+	ETHTOOL_CACHE_DRIVER_INFO     = (1LL << 2),
+	ETHTOOL_CACHE_PERM_ADDRESS    = (1LL << 3),
+} EthtoolCacheFlags;
+
+typedef struct {
+	/* must be the first field, for g_int_hash(). */
+	int ifindex;
+
+	EthtoolCacheFlags valid;
+
+	bool supports_carrier_detect:1;
+	bool supports_vlans:1;
+	bool has_driver_info:1;
+	bool has_perm_address:1;
+
+	char *driver_name;
+	char *driver_version;
+	char *fw_version;
+
+	guint8 perm_address[NM_UTILS_HWADDR_LEN_MAX];
+	guint8 perm_address_len;
+} EthtoolCacheEntry;
+
+static void
+_ethtool_cache_entry_free (gpointer data)
+{
+	EthtoolCacheEntry *entry = data;
+
+	g_free (entry->driver_name);
+	g_free (entry->driver_version);
+	g_free (entry->fw_version);
+	g_slice_free (EthtoolCacheEntry, entry);
+}
+
+static EthtoolCacheEntry *
+_ethtool_cache_get (NMPlatform *platform, int ifindex)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	EthtoolCacheEntry *entry;
+
+	/* only cache results for links that we know from netlink. Otherwise,
+	 * the entry would not be invalidated. */
+	if (!cache_lookup_link (platform, ifindex))
+		return NULL;
+
+	entry = g_hash_table_lookup (priv->ethtool_cache, &ifindex);
+	if (!entry) {
+		entry = g_slice_new0 (EthtoolCacheEntry);
+		entry->ifindex = ifindex;
+		g_hash_table_add (priv->ethtool_cache, entry);
+	}
+	return entry;
+}
+
+/******************************************************************/
+
 static gboolean
 link_supports_carrier_detect (NMPlatform *platform, int ifindex)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	const char *name = nm_platform_link_get_name (platform, ifindex);
+	EthtoolCacheEntry *entry;
+	gboolean supported;
 
 	if (!name)
 		return FALSE;
 
+	entry = _ethtool_cache_get (platform, ifindex);
+	if (entry && NM_FLAGS_HAS (entry->valid, ETHTOOL_CACHE_CARRIER_DETECT))
+		return entry->supports_carrier_detect;
+
 	if (!nm_platform_netns_push (platform, &netns))
 		return FALSE;
 
@@ -4345,7 +6016,13 @@ link_supports_carrier_detect (NMPlatform *platform, int ifindex)
 	 * us whether the device actually supports carrier detection in the first
 	 * place. We assume any device that does implements one of these two APIs.
 	 */
-	return nmp_utils_ethtool_supports_carrier_detect (name) || nmp_utils_mii_supports_carrier_detect (name);
+	supported = nmp_utils_ethtool_supports_carrier_detect (name) || nmp_utils_mii_supports_carrier_detect (name);
+
+	if (entry) {
+		entry->supports_carrier_detect = supported;
+		entry->valid |= ETHTOOL_CACHE_CARRIER_DETECT;
+	}
+	return supported;
 }
 
 static gboolean
@@ -4353,6 +6030,8 @@ link_supports_vlans (NMPlatform *platform, int ifindex)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	const NMPObject *obj;
+	EthtoolCacheEntry *entry;
+	gboolean supported;
 
 	obj = cache_lookup_link (platform, ifindex);
 
@@ -4360,10 +6039,20 @@ link_supports_vlans (NMPlatform *platform, int ifindex)
 	if (!obj || obj->link.arptype != ARPHRD_ETHER)
 		return FALSE;
 
+	entry = _ethtool_cache_get (platform, ifindex);
+	if (entry && NM_FLAGS_HAS (entry->valid, ETHTOOL_CACHE_VLANS))
+		return entry->supports_vlans;
+
 	if (!nm_platform_netns_push (platform, &netns))
 		return FALSE;
 
-	return nmp_utils_ethtool_supports_vlans (obj->link.name);
+	supported = nmp_utils_ethtool_supports_vlans (obj->link.name);
+
+	if (entry) {
+		entry->supports_vlans = supported;
+		entry->valid |= ETHTOOL_CACHE_VLANS;
+	}
+	return supported;
 }
 
 static gboolean
@@ -4402,11 +6091,33 @@ link_get_permanent_address (NMPlatform *platform,
                             size_t *length)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
+	EthtoolCacheEntry *entry;
+	gboolean success;
+
+	entry = _ethtool_cache_get (platform, ifindex);
+	if (entry && NM_FLAGS_HAS (entry->valid, ETHTOOL_CACHE_PERM_ADDRESS)) {
+		if (!entry->has_perm_address)
+			return FALSE;
+		memcpy (buf, entry->perm_address, entry->perm_address_len);
+		*length = entry->perm_address_len;
+		return TRUE;
+	}
 
 	if (!nm_platform_netns_push (platform, &netns))
 		return FALSE;
 
-	return nmp_utils_ethtool_get_permanent_address (nm_platform_link_get_name (platform, ifindex), buf, length);
+	success = nmp_utils_ethtool_get_permanent_address (nm_platform_link_get_name (platform, ifindex), buf, length);
+
+	if (entry) {
+		entry->has_perm_address = success;
+		if (success) {
+			nm_assert (*length <= sizeof (entry->perm_address));
+			memcpy (entry->perm_address, buf, *length);
+			entry->perm_address_len = *length;
+		}
+		entry->valid |= ETHTOOL_CACHE_PERM_ADDRESS;
+	}
+	return success;
 }
 
 static gboolean
@@ -4475,26 +6186,14 @@ link_get_dev_id (NMPlatform *platform, int ifindex)
 	return errno ? 0 : (int) int_val;
 }
 
-static int
-vlan_add (NMPlatform *platform,
-          const char *name,
-          int parent,
-          int vlan_id,
-          guint32 vlan_flags,
-          const NMPlatformLink **out_link)
+static struct nl_msg *
+_nl_msg_new_link_vlan (const char *name,
+                       int parent,
+                       int vlan_id,
+                       guint32 vlan_flags)
 {
 	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
 
-	G_STATIC_ASSERT (NM_VLAN_FLAG_REORDER_HEADERS == (guint32) VLAN_FLAG_REORDER_HDR);
-	G_STATIC_ASSERT (NM_VLAN_FLAG_GVRP == (guint32) VLAN_FLAG_GVRP);
-	G_STATIC_ASSERT (NM_VLAN_FLAG_LOOSE_BINDING == (guint32) VLAN_FLAG_LOOSE_BINDING);
-	G_STATIC_ASSERT (NM_VLAN_FLAG_MVRP == (guint32) VLAN_FLAG_MVRP);
-
-	vlan_flags &= (guint32) NM_VLAN_FLAGS_ALL;
-
-	_LOGD ("link: add vlan '%s', parent %d, vlan id %d, flags %X",
-	       name, parent, vlan_id, (unsigned int) vlan_flags);
-
 	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
 	                          NLM_F_CREATE | NLM_F_EXCL,
 	                          0,
@@ -4502,7 +6201,7 @@ vlan_add (NMPlatform *platform,
 	                          0,
 	                          0);
 	if (!nlmsg)
-		return FALSE;
+		return NULL;
 
 	NLA_PUT_U32 (nlmsg, IFLA_LINK, parent);
 
@@ -4514,11 +6213,38 @@ vlan_add (NMPlatform *platform,
 	                                         0,
 	                                         NULL,
 	                                         0))
+		return NULL;
+
+	return g_steal_pointer (&nlmsg);
+nla_put_failure:
+	g_return_val_if_reached (NULL);
+}
+
+static int
+vlan_add (NMPlatform *platform,
+          const char *name,
+          int parent,
+          int vlan_id,
+          guint32 vlan_flags,
+          const NMPlatformLink **out_link)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+
+	G_STATIC_ASSERT (NM_VLAN_FLAG_REORDER_HEADERS == (guint32) VLAN_FLAG_REORDER_HDR);
+	G_STATIC_ASSERT (NM_VLAN_FLAG_GVRP == (guint32) VLAN_FLAG_GVRP);
+	G_STATIC_ASSERT (NM_VLAN_FLAG_LOOSE_BINDING == (guint32) VLAN_FLAG_LOOSE_BINDING);
+	G_STATIC_ASSERT (NM_VLAN_FLAG_MVRP == (guint32) VLAN_FLAG_MVRP);
+
+	vlan_flags &= (guint32) NM_VLAN_FLAGS_ALL;
+
+	_LOGD ("link: add vlan '%s', parent %d, vlan id %d, flags %X",
+	       name, parent, vlan_id, (unsigned int) vlan_flags);
+
+	nlmsg = _nl_msg_new_link_vlan (name, parent, vlan_id, vlan_flags);
+	if (!nlmsg)
 		return FALSE;
 
 	return do_add_link_with_lookup (platform, NM_LINK_TYPE_VLAN, name, nlmsg, out_link);
-nla_put_failure:
-	g_return_val_if_reached (FALSE);
 }
 
 static int
@@ -4688,6 +6414,45 @@ nla_put_failure:
 	g_return_val_if_reached (FALSE);
 }
 
+static struct nl_msg *
+_nl_msg_new_link_macvlan (const char *name,
+                          int parent,
+                          const NMPlatformLnkMacvlan *props)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          NLM_F_CREATE | NLM_F_EXCL,
+	                          0,
+	                          name,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return NULL;
+
+	NLA_PUT_U32 (nlmsg, IFLA_LINK, parent);
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, props->tap ? "macvtap" : "macvlan");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U32 (nlmsg, IFLA_MACVLAN_MODE, props->mode);
+	NLA_PUT_U16 (nlmsg, IFLA_MACVLAN_FLAGS, props->no_promisc ? MACVLAN_FLAG_NOPROMISC : 0);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return g_steal_pointer (&nlmsg);
+nla_put_failure:
+	g_return_val_if_reached (NULL);
+}
+
 static int
 link_macvlan_add (NMPlatform *platform,
                   const char *name,
@@ -4696,8 +6461,6 @@ link_macvlan_add (NMPlatform *platform,
                   const NMPlatformLink **out_link)
 {
 	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-	struct nlattr *info;
-	struct nlattr *data;
 
 	_LOGD ("adding %s '%s' parent %u mode %u",
 	       props->tap ? "macvtap" : "macvlan",
@@ -4705,36 +6468,117 @@ link_macvlan_add (NMPlatform *platform,
 	       parent,
 	       props->mode);
 
-	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
-	                          NLM_F_CREATE | NLM_F_EXCL,
-	                          0,
-	                          name,
-	                          0,
-	                          0);
+	nlmsg = _nl_msg_new_link_macvlan (name, parent, props);
 	if (!nlmsg)
 		return FALSE;
 
-	NLA_PUT_U32 (nlmsg, IFLA_LINK, parent);
+	return do_add_link_with_lookup (platform,
+	                                props->tap ? NM_LINK_TYPE_MACVTAP : NM_LINK_TYPE_MACVLAN,
+	                                name, nlmsg, out_link);
+}
+
+/* Creates all links of @requests that are still pending (result SUCCESS
+ * and ifindex 0). Like batch_commit(), this pipelines the requests and
+ * only waits for the replies at the end, so that creating thousands of
+ * VLANs doesn't cost a round trip each. */
+static void
+link_add_batch (NMPlatform *platform, NMPlatformLinkAddRequest *requests, guint len)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free WaitForNlResponseResult *seq_results = NULL;
+	struct nl_msg *nlmsgs[BATCH_SEND_MAX_MSGS];
+	WaitForNlResponseResult *nlmsgs_seq_results[BATCH_SEND_MAX_MSGS];
+	guint n_nlmsgs = 0;
+	gsize n_nlmsgs_bytes = 0;
+	gboolean need_refresh = FALSE;
+	guint i, j;
+	char s_buf[256];
+
+	seq_results = g_new0 (WaitForNlResponseResult, len);
+
+	event_handler_read_netlink (platform, FALSE);
+
+	for (i = 0; i <= len; i++) {
+		NMPlatformLinkAddRequest *req = i < len ? &requests[i] : NULL;
+		struct nl_msg *nlmsg = NULL;
+
+		if (req) {
+			if (   req->result != NM_PLATFORM_ERROR_SUCCESS
+			    || req->ifindex != 0)
+				continue;
+
+			if (req->type == NM_LINK_TYPE_VLAN)
+				nlmsg = _nl_msg_new_link_vlan (req->name, req->parent, req->vlan.id, req->vlan.flags & (guint32) NM_VLAN_FLAGS_ALL);
+			else
+				nlmsg = _nl_msg_new_link_macvlan (req->name, req->parent, &req->macvlan);
+			if (!nlmsg) {
+				seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+				continue;
+			}
+		}
+
+		if (   n_nlmsgs > 0
+		    && (   !nlmsg
+		        || n_nlmsgs >= BATCH_SEND_MAX_MSGS
+		        || n_nlmsgs_bytes + nlmsg_hdr (nlmsg)->nlmsg_len > BATCH_SEND_MAX_BYTES)) {
+			_nl_send_batch_with_seq (platform, nlmsgs, nlmsgs_seq_results, n_nlmsgs);
+			for (j = 0; j < n_nlmsgs; j++)
+				nlmsg_free (nlmsgs[j]);
+			n_nlmsgs = 0;
+			n_nlmsgs_bytes = 0;
+
+			/* consume the RTM_NEWLINK notifications of the links created so far,
+			 * so that they don't overflow the socket's receive buffer. */
+			event_handler_read_netlink (platform, FALSE);
+		}
+
+		if (nlmsg) {
+			nlmsgs[n_nlmsgs] = nlmsg;
+			nlmsgs_seq_results[n_nlmsgs] = &seq_results[i];
+			n_nlmsgs++;
+			n_nlmsgs_bytes += nlmsg_hdr (nlmsg)->nlmsg_len;
+		}
+	}
+
+	delayed_action_handle_all (platform, FALSE);
 
-	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
-		goto nla_put_failure;
+	/* like do_add_link_with_lookup(), reload the links if kernel acknowledged
+	 * a request but the link is not in the cache -- but with one dump for
+	 * all of them. */
+	for (i = 0; i < len; i++) {
+		if (   seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK
+		    && !nmp_cache_lookup_link_full (priv->cache, 0, requests[i].name, FALSE, requests[i].type, NULL, NULL)) {
+			need_refresh = TRUE;
+			break;
+		}
+	}
+	if (need_refresh) {
+		do_request_all_no_delayed_actions (platform, DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS);
+		delayed_action_handle_all (platform, FALSE);
+	}
 
-	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, props->tap ? "macvtap" : "macvlan");
+	for (i = 0; i < len; i++) {
+		NMPlatformLinkAddRequest *req = &requests[i];
+		const NMPObject *obj = NULL;
 
-	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
-		goto nla_put_failure;
+		if (!seq_results[i])
+			continue;
 
-	NLA_PUT_U32 (nlmsg, IFLA_MACVLAN_MODE, props->mode);
-	NLA_PUT_U16 (nlmsg, IFLA_MACVLAN_FLAGS, props->no_promisc ? MACVLAN_FLAG_NOPROMISC : 0);
+		if (seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK)
+			obj = nmp_cache_lookup_link_full (priv->cache, 0, req->name, FALSE, req->type, NULL, NULL);
 
-	nla_nest_end (nlmsg, data);
-	nla_nest_end (nlmsg, info);
+		if (obj) {
+			req->result = NM_PLATFORM_ERROR_SUCCESS;
+			req->ifindex = obj->link.ifindex;
+		} else
+			req->result = NM_PLATFORM_ERROR_UNSPECIFIED;
 
-	return do_add_link_with_lookup (platform,
-	                                props->tap ? NM_LINK_TYPE_MACVTAP : NM_LINK_TYPE_MACVLAN,
-	                                name, nlmsg, out_link);
-nla_put_failure:
-	g_return_val_if_reached (FALSE);
+		_NMLOG (obj ? LOGL_DEBUG : LOGL_ERR,
+		        "do-add-link[%s/%s]: %s",
+		        req->name,
+		        nm_link_type_to_string (req->type),
+		        wait_for_nl_response_to_string (seq_results[i], s_buf, sizeof (s_buf)));
+	}
 }
 
 static int
@@ -5029,6 +6873,178 @@ link_vlan_change (NMPlatform *platform,
 	return do_change_link (platform, ifindex, nlmsg) == NM_PLATFORM_ERROR_SUCCESS;
 }
 
+static gboolean
+link_bond_change (NMPlatform *platform, int ifindex, const NMPlatformBondChange *change)
+{
+	static const struct {
+		guint16 attr;
+		guint8 size;
+	} attrs[_NM_PLATFORM_BOND_OPT_NUM] = {
+		[NM_PLATFORM_BOND_OPT_MODE]              = { IFLA_BOND_MODE,              1 },
+		[NM_PLATFORM_BOND_OPT_ACTIVE_SLAVE]      = { IFLA_BOND_ACTIVE_SLAVE,      4 },
+		[NM_PLATFORM_BOND_OPT_MIIMON]            = { IFLA_BOND_MIIMON,            4 },
+		[NM_PLATFORM_BOND_OPT_UPDELAY]           = { IFLA_BOND_UPDELAY,           4 },
+		[NM_PLATFORM_BOND_OPT_DOWNDELAY]         = { IFLA_BOND_DOWNDELAY,         4 },
+		[NM_PLATFORM_BOND_OPT_USE_CARRIER]       = { IFLA_BOND_USE_CARRIER,       1 },
+		[NM_PLATFORM_BOND_OPT_ARP_INTERVAL]      = { IFLA_BOND_ARP_INTERVAL,      4 },
+		[NM_PLATFORM_BOND_OPT_ARP_IP_TARGET]     = { IFLA_BOND_ARP_IP_TARGET,     0 },
+		[NM_PLATFORM_BOND_OPT_ARP_VALIDATE]      = { IFLA_BOND_ARP_VALIDATE,      4 },
+		[NM_PLATFORM_BOND_OPT_ARP_ALL_TARGETS]   = { IFLA_BOND_ARP_ALL_TARGETS,   4 },
+		[NM_PLATFORM_BOND_OPT_PRIMARY]           = { IFLA_BOND_PRIMARY,           4 },
+		[NM_PLATFORM_BOND_OPT_PRIMARY_RESELECT]  = { IFLA_BOND_PRIMARY_RESELECT,  1 },
+		[NM_PLATFORM_BOND_OPT_FAIL_OVER_MAC]     = { IFLA_BOND_FAIL_OVER_MAC,     1 },
+		[NM_PLATFORM_BOND_OPT_XMIT_HASH_POLICY]  = { IFLA_BOND_XMIT_HASH_POLICY,  1 },
+		[NM_PLATFORM_BOND_OPT_RESEND_IGMP]       = { IFLA_BOND_RESEND_IGMP,       4 },
+		[NM_PLATFORM_BOND_OPT_NUM_PEER_NOTIF]    = { IFLA_BOND_NUM_PEER_NOTIF,    1 },
+		[NM_PLATFORM_BOND_OPT_ALL_SLAVES_ACTIVE] = { IFLA_BOND_ALL_SLAVES_ACTIVE, 1 },
+		[NM_PLATFORM_BOND_OPT_MIN_LINKS]         = { IFLA_BOND_MIN_LINKS,         4 },
+		[NM_PLATFORM_BOND_OPT_LP_INTERVAL]       = { IFLA_BOND_LP_INTERVAL,       4 },
+		[NM_PLATFORM_BOND_OPT_PACKETS_PER_SLAVE] = { IFLA_BOND_PACKETS_PER_SLAVE, 4 },
+		[NM_PLATFORM_BOND_OPT_AD_LACP_RATE]      = { IFLA_BOND_AD_LACP_RATE,      1 },
+		[NM_PLATFORM_BOND_OPT_AD_SELECT]         = { IFLA_BOND_AD_SELECT,         1 },
+		[NM_PLATFORM_BOND_OPT_AD_ACTOR_SYS_PRIO] = { IFLA_BOND_AD_ACTOR_SYS_PRIO, 2 },
+		[NM_PLATFORM_BOND_OPT_AD_USER_PORT_KEY]  = { IFLA_BOND_AD_USER_PORT_KEY,  2 },
+		[NM_PLATFORM_BOND_OPT_AD_ACTOR_SYSTEM]   = { IFLA_BOND_AD_ACTOR_SYSTEM,   0 },
+		[NM_PLATFORM_BOND_OPT_TLB_DYNAMIC_LB]    = { IFLA_BOND_TLB_DYNAMIC_LB,    1 },
+	};
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+	struct nlattr *targets;
+	guint i;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "bond");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	/* the kernel applies the options in attribute order, which is also the
+	 * order of NMPlatformBondOpt. */
+	for (i = 0; i < _NM_PLATFORM_BOND_OPT_NUM; i++) {
+		guint32 v = change->values[i];
+
+		if (!NM_FLAGS_HAS (change->set, 1u << i))
+			continue;
+
+		switch (i) {
+		case NM_PLATFORM_BOND_OPT_ARP_IP_TARGET:
+			if (!(targets = nla_nest_start (nlmsg, attrs[i].attr)))
+				goto nla_put_failure;
+			for (v = 0; v < change->n_arp_ip_targets; v++)
+				NLA_PUT_U32 (nlmsg, v, change->arp_ip_targets[v]);
+			nla_nest_end (nlmsg, targets);
+			break;
+		case NM_PLATFORM_BOND_OPT_AD_ACTOR_SYSTEM:
+			NLA_PUT (nlmsg, attrs[i].attr, sizeof (change->ad_actor_system), change->ad_actor_system);
+			break;
+		default:
+			if (attrs[i].size == 1)
+				NLA_PUT_U8 (nlmsg, attrs[i].attr, v);
+			else if (attrs[i].size == 2)
+				NLA_PUT_U16 (nlmsg, attrs[i].attr, v);
+			else
+				NLA_PUT_U32 (nlmsg, attrs[i].attr, v);
+			break;
+		}
+	}
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	/* RTM_SETLINK would silently ignore IFLA_LINKINFO. */
+	return do_change_link_full (platform, ifindex, nlmsg, FALSE) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+link_bridge_change (NMPlatform *platform, int ifindex, const NMPlatformBridgeChange *change)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "bridge");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U32 (nlmsg, IFLA_BR_FORWARD_DELAY, change->forward_delay);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_HELLO_TIME, change->hello_time);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_MAX_AGE, change->max_age);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_AGEING_TIME, change->ageing_time);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_STP_STATE, change->stp_state);
+	NLA_PUT_U16 (nlmsg, IFLA_BR_PRIORITY, change->priority);
+	NLA_PUT_U8 (nlmsg, IFLA_BR_MCAST_SNOOPING, !!change->mcast_snooping);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return do_change_link_full (platform, ifindex, nlmsg, FALSE) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+link_bridge_port_change (NMPlatform *platform, int ifindex, const NMPlatformBridgePortChange *change)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_SLAVE_KIND, "bridge");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_SLAVE_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U16 (nlmsg, IFLA_BRPORT_PRIORITY, change->priority);
+	NLA_PUT_U32 (nlmsg, IFLA_BRPORT_COST, change->path_cost);
+	NLA_PUT_U8 (nlmsg, IFLA_BRPORT_MODE, !!change->hairpin_mode);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return do_change_link_full (platform, ifindex, nlmsg, FALSE) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
 static int
 tun_add (NMPlatform *platform, const char *name, gboolean tap,
          gint64 owner, gint64 group, gboolean pi, gboolean vnet_hdr,
@@ -5398,14 +7414,47 @@ link_get_driver_info (NMPlatform *platform,
                       char **out_fw_version)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
+	EthtoolCacheEntry *entry;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	entry = _ethtool_cache_get (platform, ifindex);
+	if (!entry || !NM_FLAGS_HAS (entry->valid, ETHTOOL_CACHE_DRIVER_INFO)) {
+		gs_free char *driver_name = NULL;
+		gs_free char *driver_version = NULL;
+		gs_free char *fw_version = NULL;
+		gboolean success;
+
+		if (!nm_platform_netns_push (platform, &netns))
+			return FALSE;
+
+		success = nmp_utils_ethtool_get_driver_info (nm_platform_link_get_name (platform, ifindex),
+		                                             &driver_name,
+		                                             &driver_version,
+		                                             &fw_version);
+		if (!entry) {
+			if (success) {
+				NM_SET_OUT (out_driver_name, g_steal_pointer (&driver_name));
+				NM_SET_OUT (out_driver_version, g_steal_pointer (&driver_version));
+				NM_SET_OUT (out_fw_version, g_steal_pointer (&fw_version));
+			}
+			return success;
+		}
+
+		entry->has_driver_info = success;
+		if (success) {
+			entry->driver_name = g_steal_pointer (&driver_name);
+			entry->driver_version = g_steal_pointer (&driver_version);
+			entry->fw_version = g_steal_pointer (&fw_version);
+		}
+		entry->valid |= ETHTOOL_CACHE_DRIVER_INFO;
+	}
+
+	if (!entry->has_driver_info)
 		return FALSE;
 
-	return nmp_utils_ethtool_get_driver_info (nm_platform_link_get_name (platform, ifindex),
-	                                          out_driver_name,
-	                                          out_driver_version,
-	                                          out_fw_version);
+	NM_SET_OUT (out_driver_name, g_strdup (entry->driver_name));
+	NM_SET_OUT (out_driver_version, g_strdup (entry->driver_version));
+	NM_SET_OUT (out_fw_version, g_strdup (entry->fw_version));
+	return TRUE;
 }
 
 /******************************************************************/
@@ -5614,6 +7663,38 @@ ipx_route_get_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type, NM
 	return array;
 }
 
+static gconstpointer
+object_get_view (NMPlatform *platform, NMPObjectType obj_type, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	NMPCacheId cache_id;
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id, obj_type, ifindex);
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		nmp_cache_id_init_routes_visible (&cache_id,
+		                                  obj_type,
+		                                  NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT),
+		                                  NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT),
+		                                  ifindex);
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
+
+	return nmp_cache_lookup_multi (priv->cache, &cache_id, out_len);
+}
+
+static guint64
+cache_get_generation (NMPlatform *platform)
+{
+	return nmp_cache_get_generation (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache);
+}
+
 static GArray *
 ip4_route_get_all (NMPlatform *platform, int ifindex, NMPlatformGetRouteFlags flags)
 {
@@ -5645,6 +7726,7 @@ ip4_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
 	                           &gateway,
 	                           metric,
 	                           mss,
+	                           NULL,
 	                           pref_src ? &pref_src : NULL);
 
 	nmp_object_stackinit_id_ip4_route (&obj_id, ifindex, network, plen, metric);
@@ -5670,12 +7752,30 @@ ip6_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
 	                           &gateway,
 	                           metric,
 	                           mss,
+	                           NULL,
 	                           NULL);
 
 	nmp_object_stackinit_id_ip6_route (&obj_id, ifindex, &network, plen, metric);
 	return do_add_addrroute (platform, &obj_id, nlmsg);
 }
 
+static gboolean
+ip4_route_add_multipath (NMPlatform *platform, NMIPConfigSource source,
+                         in_addr_t network, guint8 plen, guint32 metric, guint32 mss,
+                         const NMPlatformIP4RouteNexthop *nexthops, guint n_nexthops)
+{
+	NMPObject obj_id;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+
+	nlmsg = _nl_msg_new_ip4_route_multipath (source, network, plen, metric, mss, nexthops, n_nexthops);
+	if (!nlmsg)
+		return FALSE;
+
+	/* the kernel reports the route with the ifindex of the first nexthop. */
+	nmp_object_stackinit_id_ip4_route (&obj_id, nexthops[0].ifindex, network, plen, metric);
+	return do_add_addrroute (platform, &obj_id, nlmsg);
+}
+
 static gboolean
 ip4_route_delete (NMPlatform *platform, int ifindex, in_addr_t network, guint8 plen, guint32 metric)
 {
@@ -5725,6 +7825,7 @@ ip4_route_delete (NMPlatform *platform, int ifindex, in_addr_t network, guint8 p
 	                           NULL,
 	                           metric,
 	                           0,
+	                           NULL,
 	                           NULL);
 	if (!nlmsg)
 		return FALSE;
@@ -5751,6 +7852,7 @@ ip6_route_delete (NMPlatform *platform, int ifindex, struct in6_addr network, gu
 	                           NULL,
 	                           metric,
 	                           0,
+	                           NULL,
 	                           NULL);
 	if (!nlmsg)
 		return FALSE;
@@ -5766,26 +7868,315 @@ ip4_route_get (NMPlatform *platform, int ifindex, in_addr_t network, guint8 plen
 	NMPObject obj_id;
 	const NMPObject *obj;
 
-	nmp_object_stackinit_id_ip4_route (&obj_id, ifindex, network, plen, metric);
-	obj = nmp_cache_lookup_obj (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, &obj_id);
-	if (nmp_object_is_visible (obj))
-		return &obj->ip4_route;
-	return NULL;
-}
+	nmp_object_stackinit_id_ip4_route (&obj_id, ifindex, network, plen, metric);
+	obj = nmp_cache_lookup_obj (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, &obj_id);
+	if (nmp_object_is_visible (obj))
+		return &obj->ip4_route;
+	return NULL;
+}
+
+static const NMPlatformIP6Route *
+ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint8 plen, guint32 metric)
+{
+	NMPObject obj_id;
+	const NMPObject *obj;
+
+	metric = nm_utils_ip6_route_metric_normalize (metric);
+
+	nmp_object_stackinit_id_ip6_route (&obj_id, ifindex, &network, plen, metric);
+	obj = nmp_cache_lookup_obj (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, &obj_id);
+	if (nmp_object_is_visible (obj))
+		return &obj->ip6_route;
+	return NULL;
+}
+
+static const NMPlatformIP4Route *
+ip4_route_lookup_best (NMPlatform *platform, int ifindex, in_addr_t host)
+{
+	const NMPObject *obj;
+
+	obj = nmp_cache_lookup_route_best (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
+	                                   NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, &host);
+	return obj ? &obj->ip4_route : NULL;
+}
+
+static const NMPlatformIP6Route *
+ip6_route_lookup_best (NMPlatform *platform, int ifindex, const struct in6_addr *host)
+{
+	const NMPObject *obj;
+
+	obj = nmp_cache_lookup_route_best (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
+	                                   NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, host);
+	return obj ? &obj->ip6_route : NULL;
+}
+
+/******************************************************************/
+
+static void
+_batch_entry_stackinit_id (NMPObject *obj_id, const NMPlatformBatchEntry *entry)
+{
+	switch (entry->obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		nmp_object_stackinit_id_ip4_address (obj_id, entry->ip4_address.ifindex, entry->ip4_address.address,
+		                                     entry->ip4_address.plen, entry->ip4_address.peer_address);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		nmp_object_stackinit_id_ip6_address (obj_id, entry->ip6_address.ifindex, &entry->ip6_address.address,
+		                                     entry->ip6_address.plen);
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		nmp_object_stackinit_id_ip4_route (obj_id, entry->ip4_route.ifindex, entry->ip4_route.network,
+		                                   entry->ip4_route.plen, entry->ip4_route.metric);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		nmp_object_stackinit_id_ip6_route (obj_id, entry->ip6_route.ifindex, &entry->ip6_route.network,
+		                                   entry->ip6_route.plen,
+		                                   entry->is_delete
+		                                       ? nm_utils_ip6_route_metric_normalize (entry->ip6_route.metric)
+		                                       : entry->ip6_route.metric);
+		break;
+	default:
+		g_return_if_reached ();
+	}
+}
+
+static struct nl_msg *
+_nl_msg_new_batch_entry (const NMPlatformBatchEntry *entry)
+{
+	switch (entry->obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		if (entry->is_delete) {
+			return _nl_msg_new_address (RTM_DELADDR,
+			                            0,
+			                            AF_INET,
+			                            entry->ip4_address.ifindex,
+			                            &entry->ip4_address.address,
+			                            entry->ip4_address.plen,
+			                            &entry->ip4_address.peer_address,
+			                            0,
+			                            RT_SCOPE_NOWHERE,
+			                            NM_PLATFORM_LIFETIME_PERMANENT,
+			                            NM_PLATFORM_LIFETIME_PERMANENT,
+			                            NULL);
+		}
+		return _nl_msg_new_address (RTM_NEWADDR,
+		                            NLM_F_CREATE | NLM_F_REPLACE,
+		                            AF_INET,
+		                            entry->ip4_address.ifindex,
+		                            &entry->ip4_address.address,
+		                            entry->ip4_address.plen,
+		                            &entry->ip4_address.peer_address,
+		                            entry->ip4_address.n_ifa_flags,
+		                            nm_utils_ip4_address_is_link_local (entry->ip4_address.address) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE,
+		                            entry->ip4_address.lifetime,
+		                            entry->ip4_address.preferred,
+		                            entry->ip4_address.label);
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		if (entry->is_delete) {
+			return _nl_msg_new_address (RTM_DELADDR,
+			                            0,
+			                            AF_INET6,
+			                            entry->ip6_address.ifindex,
+			                            &entry->ip6_address.address,
+			                            entry->ip6_address.plen,
+			                            NULL,
+			                            0,
+			                            RT_SCOPE_NOWHERE,
+			                            NM_PLATFORM_LIFETIME_PERMANENT,
+			                            NM_PLATFORM_LIFETIME_PERMANENT,
+			                            NULL);
+		}
+		return _nl_msg_new_address (RTM_NEWADDR,
+		                            NLM_F_CREATE | NLM_F_REPLACE,
+		                            AF_INET6,
+		                            entry->ip6_address.ifindex,
+		                            &entry->ip6_address.address,
+		                            entry->ip6_address.plen,
+		                            &entry->ip6_address.peer_address,
+		                            entry->ip6_address.n_ifa_flags,
+		                            RT_SCOPE_UNIVERSE,
+		                            entry->ip6_address.lifetime,
+		                            entry->ip6_address.preferred,
+		                            NULL);
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (entry->is_delete) {
+			return _nl_msg_new_route (RTM_DELROUTE,
+			                          0,
+			                          AF_INET,
+			                          entry->ip4_route.ifindex,
+			                          NM_IP_CONFIG_SOURCE_UNKNOWN,
+			                          RT_SCOPE_NOWHERE,
+			                          &entry->ip4_route.network,
+			                          entry->ip4_route.plen,
+			                          NULL,
+			                          entry->ip4_route.metric,
+			                          0,
+			                          NULL,
+			                          NULL);
+		}
+		return _nl_msg_new_route (RTM_NEWROUTE,
+		                          NLM_F_CREATE | NLM_F_REPLACE,
+		                          AF_INET,
+		                          entry->ip4_route.ifindex,
+		                          entry->ip4_route.rt_source,
+		                          entry->ip4_route.gateway ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
+		                          &entry->ip4_route.network,
+		                          entry->ip4_route.plen,
+		                          &entry->ip4_route.gateway,
+		                          entry->ip4_route.metric,
+		                          entry->ip4_route.mss,
+		                          (const NMPlatformIPRoute *) &entry->ip4_route,
+		                          entry->ip4_route.pref_src ? &entry->ip4_route.pref_src : NULL);
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (entry->is_delete) {
+			return _nl_msg_new_route (RTM_DELROUTE,
+			                          0,
+			                          AF_INET6,
+			                          entry->ip6_route.ifindex,
+			                          NM_IP_CONFIG_SOURCE_UNKNOWN,
+			                          RT_SCOPE_NOWHERE,
+			                          &entry->ip6_route.network,
+			                          entry->ip6_route.plen,
+			                          NULL,
+			                          nm_utils_ip6_route_metric_normalize (entry->ip6_route.metric),
+			                          0,
+			                          NULL,
+			                          NULL);
+		}
+		return _nl_msg_new_route (RTM_NEWROUTE,
+		                          NLM_F_CREATE | NLM_F_REPLACE,
+		                          AF_INET6,
+		                          entry->ip6_route.ifindex,
+		                          entry->ip6_route.rt_source,
+		                          !IN6_IS_ADDR_UNSPECIFIED (&entry->ip6_route.gateway) ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
+		                          &entry->ip6_route.network,
+		                          entry->ip6_route.plen,
+		                          &entry->ip6_route.gateway,
+		                          entry->ip6_route.metric,
+		                          entry->ip6_route.mss,
+		                          (const NMPlatformIPRoute *) &entry->ip6_route,
+		                          NULL);
+	default:
+		g_return_val_if_reached (NULL);
+	}
+}
+
+static void
+batch_commit (NMPlatform *platform, NMPlatformBatchEntry *entries, guint len)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free WaitForNlResponseResult *seq_results = NULL;
+	struct nl_msg *nlmsgs[BATCH_SEND_MAX_MSGS];
+	WaitForNlResponseResult *nlmsgs_seq_results[BATCH_SEND_MAX_MSGS];
+	guint n_nlmsgs = 0;
+	gsize n_nlmsgs_bytes = 0;
+	DelayedActionType refresh_types = DELAYED_ACTION_TYPE_NONE;
+	NMPObject obj_id;
+	guint i, j;
+	char s_buf[256];
+
+	seq_results = g_new0 (WaitForNlResponseResult, len);
+
+	event_handler_read_netlink (platform, FALSE);
+
+	for (i = 0; i <= len; i++) {
+		NMPlatformBatchEntry *entry = i < len ? &entries[i] : NULL;
+		struct nl_msg *nlmsg = NULL;
+		gboolean sync_delete = FALSE;
+
+		if (entry) {
+			/* Deleting an IPv4 route with metric 0 possibly deletes another route
+			 * to the same destination. ip4_route_delete() takes care of that, but
+			 * must see the effect of all previous requests first. */
+			sync_delete =    entry->obj_type == NMP_OBJECT_TYPE_IP4_ROUTE
+			              && entry->is_delete
+			              && entry->ip4_route.metric == 0;
+			if (!sync_delete) {
+				nlmsg = _nl_msg_new_batch_entry (entry);
+				if (!nlmsg) {
+					seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+					continue;
+				}
+			}
+		}
+
+		if (   n_nlmsgs > 0
+		    && (   !nlmsg
+		        || n_nlmsgs >= BATCH_SEND_MAX_MSGS
+		        || n_nlmsgs_bytes + nlmsg_hdr (nlmsg)->nlmsg_len > BATCH_SEND_MAX_BYTES)) {
+			_nl_send_batch_with_seq (platform, nlmsgs, nlmsgs_seq_results, n_nlmsgs);
+			for (j = 0; j < n_nlmsgs; j++)
+				nlmsg_free (nlmsgs[j]);
+			n_nlmsgs = 0;
+			n_nlmsgs_bytes = 0;
+
+			/* Don't wait for the replies yet, but consume what is already there.
+			 * Otherwise, the notifications for our own changes could overflow
+			 * the socket's receive buffer. */
+			event_handler_read_netlink (platform, FALSE);
+		}
+
+		if (sync_delete) {
+			seq_results[i] = ip4_route_delete (platform, entry->ip4_route.ifindex, entry->ip4_route.network,
+			                                   entry->ip4_route.plen, entry->ip4_route.metric)
+			                 ? WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK
+			                 : WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+			continue;
+		}
+
+		if (nlmsg) {
+			nlmsgs[n_nlmsgs] = nlmsg;
+			nlmsgs_seq_results[n_nlmsgs] = &seq_results[i];
+			n_nlmsgs++;
+			n_nlmsgs_bytes += nlmsg_hdr (nlmsg)->nlmsg_len;
+		}
+	}
+
+	/* collect all the outstanding replies at once. */
+	delayed_action_handle_all (platform, FALSE);
+
+	/* In rare cases, the object is not yet in (or removed from) the cache although
+	 * kernel already acknowledged the request. Like do_add_addrroute() and
+	 * do_delete_object(), refetch then -- but only once per object type. */
+	for (i = 0; i < len; i++) {
+		gboolean in_cache;
+
+		_batch_entry_stackinit_id (&obj_id, &entries[i]);
+		in_cache = !!nmp_cache_lookup_obj (priv->cache, &obj_id);
+		if (in_cache == !!entries[i].is_delete)
+			refresh_types |= delayed_action_refresh_from_object_type (entries[i].obj_type);
+	}
+	if (refresh_types != DELAYED_ACTION_TYPE_NONE) {
+		do_request_all_no_delayed_actions (platform, refresh_types);
+		delayed_action_handle_all (platform, FALSE);
+	}
+
+	for (i = 0; i < len; i++) {
+		NMPlatformBatchEntry *entry = &entries[i];
+		const NMPObject *obj;
 
-static const NMPlatformIP6Route *
-ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint8 plen, guint32 metric)
-{
-	NMPObject obj_id;
-	const NMPObject *obj;
+		nm_assert (seq_results[i]);
 
-	metric = nm_utils_ip6_route_metric_normalize (metric);
+		_batch_entry_stackinit_id (&obj_id, entry);
+		obj = nmp_cache_lookup_obj (priv->cache, &obj_id);
 
-	nmp_object_stackinit_id_ip6_route (&obj_id, ifindex, &network, plen, metric);
-	obj = nmp_cache_lookup_obj (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, &obj_id);
-	if (nmp_object_is_visible (obj))
-		return &obj->ip6_route;
-	return NULL;
+		if (entry->is_delete) {
+			/* like for do_delete_object(), the deletion is successful if the
+			 * object is gone, regardless of what kernel told us. */
+			entry->success = !obj;
+		} else {
+			/* Adding is only successful, if kernel reported success *and* we have the
+			 * expected object in cache afterwards. */
+			entry->success = obj && seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
+		}
+
+		_NMLOG (entry->success ? LOGL_DEBUG : LOGL_ERR,
+		        "do-batch-%s-%s[%s]: %s",
+		        entry->is_delete ? "delete" : "add",
+		        NMP_OBJECT_GET_CLASS (&obj_id)->obj_type_name,
+		        nmp_object_to_string (&obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		        wait_for_nl_response_to_string (seq_results[i], s_buf, sizeof (s_buf)));
+	}
 }
 
 /******************************************************************/
@@ -5794,99 +8185,138 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint
 #define ERROR_CONDITIONS      ((GIOCondition) (G_IO_ERR | G_IO_NVAL))
 #define DISCONNECT_CONDITIONS ((GIOCondition) (G_IO_HUP))
 
+static void
+event_handler_set_priority (NMPlatform *platform, gboolean demoted)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GSource *source;
+
+	if (priv->event_budget.demoted == demoted)
+		return;
+	priv->event_budget.demoted = demoted;
+
+	source = g_main_context_find_source_by_id (NULL, priv->event_id);
+	if (source) {
+		g_source_set_priority (source,
+		                       demoted
+		                       ? NM_LOOP_SCHED_PRIORITY_DBUS
+		                       : NM_LOOP_SCHED_PRIORITY_NETLINK);
+	}
+	_LOGD ("netlink: event budget %s", demoted ? "exceeded, yield to D-Bus" : "met again");
+}
+
+/* Events are handled before D-Bus calls, so that a flood of calls can't
+ * overrun the receive buffer. A storm of events must not block D-Bus for
+ * long either: after NM_LOOP_SCHED_NETLINK_BUDGET_USEC, the remaining
+ * events are left to the next wakeup, which is then dispatched together
+ * with D-Bus until the socket is drained within the budget again. */
 static gboolean
 event_handler (GIOChannel *channel,
                GIOCondition io_condition,
                gpointer user_data)
 {
-	delayed_action_handle_all (NM_PLATFORM (user_data), TRUE);
+	NMPlatform *platform = NM_PLATFORM (user_data);
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gint64 start = g_get_monotonic_time ();
+
+	priv->event_budget.deadline = start + NM_LOOP_SCHED_NETLINK_BUDGET_USEC;
+	priv->event_budget.exceeded = FALSE;
+
+	delayed_action_handle_all (platform, TRUE);
+
+	priv->event_budget.deadline = 0;
+	if (priv->event_budget.exceeded)
+		priv->netlink_stats.budget_yields++;
+	event_handler_set_priority (platform, priv->event_budget.exceeded);
+
+	nm_statistics_record (NM_STATISTICS_HISTOGRAM_NETLINK_EVENT,
+	                      g_get_monotonic_time () - start);
 	return TRUE;
 }
 
 /*****************************************************************************/
 
-/* copied from libnl3's recvmsgs() */
+/* Instead of reading one datagram per recvmsg() into a newly allocated
+ * buffer, like libnl3's nl_recv() does, read up to RECV_BATCH_NUM datagrams
+ * with one recvmmsg() into preallocated buffers. Once a datagram turned out
+ * to be larger than these buffers, fall back to reading one datagram at a
+ * time after peeking at its size. */
+#define RECV_BATCH_NUM      8
+#define RECV_BATCH_BUF_SIZE (32*1024)
+
+typedef struct _RecvBatch {
+	struct mmsghdr msgs[RECV_BATCH_NUM];
+	struct iovec iovs[RECV_BATCH_NUM];
+	struct sockaddr_nl addrs[RECV_BATCH_NUM];
+	union {
+		char buf[CMSG_SPACE (sizeof (struct ucred))];
+		struct cmsghdr align;
+	} cmsgs[RECV_BATCH_NUM];
+	guint8 bufs[RECV_BATCH_NUM][RECV_BATCH_BUF_SIZE];
+} RecvBatch;
+
+static const struct ucred *
+_recv_batch_get_creds (struct msghdr *mh)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR (mh); cmsg; cmsg = CMSG_NXTHDR (mh, cmsg)) {
+		if (   cmsg->cmsg_level == SOL_SOCKET
+		    && cmsg->cmsg_type == SCM_CREDENTIALS)
+			return (const struct ucred *) CMSG_DATA (cmsg);
+	}
+	return NULL;
+}
+
+/* the message handling is copied from libnl3's recvmsgs() */
 static int
-event_handler_recvmsgs (NMPlatform *platform, gboolean handle_events)
+_recv_batch_process_datagram (NMPlatform *platform,
+                              gboolean is_event_socket,
+                              gboolean handle_events,
+                              struct mmsghdr *mmsg,
+                              int *interrupted)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	struct nl_sock *sk = priv->nlh;
-	int n, err = 0, multipart = 0, interrupted = 0;
+	int n, err = 0;
 	struct nlmsghdr *hdr;
 	WaitForNlResponseResult seq_result;
+	const struct sockaddr_nl *nla = mmsg->msg_hdr.msg_name;
+	const struct ucred *creds;
 
-	/*
-	nla is passed on to not only to nl_recv() but may also be passed
-	to a function pointer provided by the caller which may or may not
-	initialize the variable. Thomas Graf.
-	*/
-	struct sockaddr_nl nla = {0};
-	nm_auto_free struct ucred *creds = NULL;
-	nm_auto_free unsigned char *buf = NULL;
-
-continue_reading:
-	g_clear_pointer (&buf, free);
-	g_clear_pointer (&creds, free);
-	errno = 0;
-	n = nl_recv (sk, &nla, &buf, &creds);
-
-	switch (n) {
-	case 0:
-		/* Work around a libnl bug fixed in 3.2.22 (375a6294) */
-		if (errno == EAGAIN) {
-			/* EAGAIN is equal to EWOULDBLOCK. If it would not be, we'd have to
-			 * workaround libnl3 mapping EWOULDBLOCK to -NLE_FAILURE. */
-			G_STATIC_ASSERT (EAGAIN == EWOULDBLOCK);
-			n = -NLE_AGAIN;
-		}
-		break;
-	case -NLE_NOMEM:
-		if (errno == ENOBUFS) {
-			/* we are very much interested in a overrun of the receive buffer.
-			 * nl_recv() maps all kinds of errors to NLE_NOMEM, so check also
-			 * for errno explicitly. And if so, hack our own return code to signal
-			 * the overrun. */
-			n = -_NLE_NM_NOBUFS;
-		}
-		break;
-	}
+	n = mmsg->msg_len;
+	hdr = mmsg->msg_hdr.msg_iov->iov_base;
+	creds = _recv_batch_get_creds (&mmsg->msg_hdr);
 
-	if (n <= 0)
-		return n;
+	priv->netlink_stats.recv_datagrams++;
+	priv->netlink_stats.recv_bytes += n;
 
-	hdr = (struct nlmsghdr *) buf;
 	while (nlmsg_ok (hdr, n)) {
 		nm_auto_nlmsg struct nl_msg *msg = NULL;
 		gboolean abort_parsing = FALSE;
 		gboolean process_valid_msg = FALSE;
 		guint32 seq_number;
 
+		priv->netlink_stats.recv_messages++;
+
 		msg = nlmsg_convert (hdr);
-		if (!msg) {
-			err = -NLE_NOMEM;
-			goto out;
-		}
+		if (!msg)
+			return -NLE_NOMEM;
 
 		nlmsg_set_proto (msg, NETLINK_ROUTE);
-		nlmsg_set_src (msg, &nla);
+		nlmsg_set_src (msg, (struct sockaddr_nl *) nla);
 
 		if (!creds || creds->pid) {
 			if (creds)
 				_LOGT ("netlink: recvmsg: received non-kernel message (pid %d)", creds->pid);
 			else
 				_LOGT ("netlink: recvmsg: received message without credentials");
-			err = 0;
-			goto stop;
+			return 0;
 		}
 
 		_LOGt ("netlink: recvmsg: new message type %d, seq %u",
 		       hdr->nlmsg_type, hdr->nlmsg_seq);
 
-		if (creds)
-			nlmsg_set_creds (msg, creds);
-
-		if (hdr->nlmsg_flags & NLM_F_MULTI)
-			multipart = 1;
+		nlmsg_set_creds (msg, (struct ucred *) creds);
 
 		if (hdr->nlmsg_flags & NLM_F_DUMP_INTR) {
 			/*
@@ -5894,32 +8324,18 @@ continue_reading:
 			 * all messages until a NLMSG_DONE is
 			 * received and report the inconsistency.
 			 */
-			interrupted = 1;
-		}
-
-		/* Other side wishes to see an ack for this message */
-		if (hdr->nlmsg_flags & NLM_F_ACK) {
-			/* FIXME: implement */
+			*interrupted = 1;
 		}
 
 		seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
 
 		if (hdr->nlmsg_type == NLMSG_DONE) {
-			/* messages terminates a multipart message, this is
-			 * usually the end of a message and therefore we slip
-			 * out of the loop by default. the user may overrule
-			 * this action by skipping this packet. */
-			multipart = 0;
+			/* messages terminates a multipart message. */
 			seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 		} else if (hdr->nlmsg_type == NLMSG_NOOP) {
-			/* Message to be ignored, the default action is to
-			 * skip this message if no callback is specified. The
-			 * user may overrule this action by returning
-			 * NL_PROCEED. */
+			/* Message to be ignored. */
 		} else if (hdr->nlmsg_type == NLMSG_OVERRUN) {
-			/* Data got lost, report back to user. The default action is to
-			 * quit parsing. The user may overrule this action by retuning
-			 * NL_SKIP or NL_PROCEED (dangerous) */
+			/* Data got lost, report back to user and quit parsing. */
 			err = -NLE_MSG_OVERFLOW;
 			abort_parsing = TRUE;
 		} else if (hdr->nlmsg_type == NLMSG_ERROR) {
@@ -5927,10 +8343,7 @@ continue_reading:
 			struct nlmsgerr *e = nlmsg_data (hdr);
 
 			if (hdr->nlmsg_len < nlmsg_size (sizeof (*e))) {
-				/* Truncated error message, the default action
-				 * is to stop parsing. The user may overrule
-				 * this action by returning NL_SKIP or
-				 * NL_PROCEED (dangerous) */
+				/* Truncated error message, stop parsing. */
 				err = -NLE_MSG_TRUNC;
 				abort_parsing = TRUE;
 			} else if (e->error) {
@@ -5947,7 +8360,14 @@ continue_reading:
 		} else
 			process_valid_msg = TRUE;
 
-		seq_number = nlmsg_hdr (msg)->nlmsg_seq;
+		/* Multicast notifications carry the sequence number and port of
+		 * whoever caused them. They are unrelated to our requests, unlike
+		 * the replies to the dumps we sent on the event socket. */
+		if (   is_event_socket
+		    && hdr->nlmsg_pid != nl_socket_get_local_port (priv->nlh_event))
+			seq_number = 0;
+		else
+			seq_number = hdr->nlmsg_seq;
 
 		/* check whether the seq number is different from before, and
 		 * whether the previous number (@nlh_seq_last_seen) is a pending
@@ -5955,13 +8375,16 @@ continue_reading:
 		 * completed.
 		 *
 		 * We must do that before processing the message with event_valid_msg(),
-		 * because we must track the completion of the pending request before that. */
-		event_seq_check_refresh_all (platform, seq_number);
+		 * because we must track the completion of the pending request before that.
+		 *
+		 * Refresh-all requests are only sent on the event socket, the ACKs on
+		 * the request socket would interleave with the dumps. */
+		if (is_event_socket)
+			event_seq_check_refresh_all (platform, seq_number);
 
 		if (process_valid_msg) {
 			/* Valid message (not checking for MULTIPART bit to
-			 * get along with broken kernels. NL_SKIP has no
-			 * effect on this.  */
+			 * get along with broken kernels. */
 
 			event_valid_msg (platform, msg, handle_events);
 
@@ -5971,90 +8394,304 @@ continue_reading:
 		event_seq_check (platform, seq_number, seq_result);
 
 		if (abort_parsing)
-			goto stop;
+			return err;
 
-		err = 0;
 		hdr = nlmsg_next (hdr, &n);
 	}
 
-	if (multipart) {
-		/* Multipart message not yet complete, continue reading */
-		goto continue_reading;
+	return 0;
+}
+
+static void
+_recv_batch_init_msg (RecvBatch *batch, int i, guint8 *buf, gsize len)
+{
+	batch->iovs[i].iov_base = buf;
+	batch->iovs[i].iov_len = len;
+	memset (&batch->msgs[i], 0, sizeof (batch->msgs[i]));
+	batch->msgs[i].msg_hdr.msg_iov = &batch->iovs[i];
+	batch->msgs[i].msg_hdr.msg_iovlen = 1;
+	batch->msgs[i].msg_hdr.msg_name = &batch->addrs[i];
+	batch->msgs[i].msg_hdr.msg_namelen = sizeof (batch->addrs[i]);
+	batch->msgs[i].msg_hdr.msg_control = batch->cmsgs[i].buf;
+	batch->msgs[i].msg_hdr.msg_controllen = sizeof (batch->cmsgs[i].buf);
+}
+
+static int
+_recv_batch_errno (int errsv)
+{
+	if (errsv == EAGAIN)
+		return -NLE_AGAIN;
+	if (errsv == ENOBUFS) {
+		/* we are very much interested in a overrun of the receive buffer.
+		 * Signal it with our own return code. */
+		return -_NLE_NM_NOBUFS;
 	}
-stop:
-	if (!handle_events) {
+	return -nl_syserr2nlerr (errsv);
+}
+
+/* Reads a single datagram into the first slot of @batch. Like libnl3's
+ * nl_recv(), the size of the datagram is peeked first and a datagram
+ * that doesn't fit into the slot is read into a heap buffer, which is
+ * returned in @out_buf_free. */
+static int
+_recv_batch_recv_one (NMLinuxPlatformPrivate *priv, int fd, RecvBatch *batch, guint8 **out_buf_free)
+{
+	gssize len;
+	int n;
+
+	do {
+		priv->netlink_stats.recv_syscalls++;
+		len = recv (fd, NULL, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+	} while (len < 0 && errno == EINTR);
+	if (len < 0)
+		return _recv_batch_errno (errno);
+
+	if (len > RECV_BATCH_BUF_SIZE) {
+		*out_buf_free = g_malloc (len);
+		_recv_batch_init_msg (batch, 0, *out_buf_free, len);
+	} else
+		_recv_batch_init_msg (batch, 0, batch->bufs[0], RECV_BATCH_BUF_SIZE);
+
+	do {
+		priv->netlink_stats.recv_syscalls++;
+		n = recvmsg (fd, &batch->msgs[0].msg_hdr, MSG_DONTWAIT);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0)
+		return _recv_batch_errno (errno);
+
+	batch->msgs[0].msg_len = n;
+	return 1;
+}
+
+static int
+_recv_batch_read (NMPlatform *platform, gboolean is_event_socket, gboolean handle_events, RecvBatch *batch)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	int fd = nl_socket_get_fd (is_event_socket ? priv->nlh_event : priv->nlh);
+	int i, n_msgs, r, err, interrupted;
+
+	do {
+		gs_free guint8 *buf_free = NULL;
+
+		if (priv->recv_batch_peek)
+			n_msgs = _recv_batch_recv_one (priv, fd, batch, &buf_free);
+		else {
+			for (i = 0; i < RECV_BATCH_NUM; i++)
+				_recv_batch_init_msg (batch, i, batch->bufs[i], RECV_BATCH_BUF_SIZE);
+
+			do {
+				priv->netlink_stats.recv_syscalls++;
+				n_msgs = recvmmsg (fd, batch->msgs, RECV_BATCH_NUM, MSG_DONTWAIT, NULL);
+			} while (n_msgs < 0 && errno == EINTR);
+
+			if (n_msgs < 0)
+				n_msgs = _recv_batch_errno (errno);
+		}
+
+		if (n_msgs < 0)
+			return n_msgs;
+		if (n_msgs == 0)
+			return -NLE_AGAIN;
+
+		err = 0;
+		interrupted = 0;
+		for (i = 0; i < n_msgs; i++) {
+			if (NM_FLAGS_HAS (batch->msgs[i].msg_hdr.msg_flags, MSG_TRUNC)) {
+				/* the datagram didn't fit into the buffer and its data is lost,
+				 * just like on a receive buffer overrun. Peek at the size of
+				 * the datagrams from now on, so that the resync doesn't run
+				 * into the same datagram again. */
+				_LOGW ("netlink: recvmsg: message truncated to %u bytes", (guint) batch->iovs[i].iov_len);
+				priv->recv_batch_peek = TRUE;
+				return -_NLE_NM_NOBUFS;
+			}
+
+			r = _recv_batch_process_datagram (platform, is_event_socket, handle_events, &batch->msgs[i], &interrupted);
+			if (r < 0 && err == 0)
+				err = r;
+		}
+
 		/* when we don't handle events, we want to drain all messages from the socket
 		 * without handling the messages (but still check for sequence numbers).
 		 * Repeat reading. */
-		goto continue_reading;
-	}
-out:
+	} while (!handle_events);
+
 	if (interrupted)
 		err = -NLE_DUMP_INTR;
 	return err;
 }
 
+static int
+event_handler_recvmsgs (NMPlatform *platform, gboolean is_event_socket, gboolean handle_events)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free RecvBatch *batch_free = NULL;
+	int r;
+
+	/* processing the messages emits signals, whose handlers might call back
+	 * into the platform and read netlink again. Such a nested call gets its
+	 * own buffers. */
+	if (priv->recv_batch_busy) {
+		batch_free = g_malloc (sizeof (RecvBatch));
+		return _recv_batch_read (platform, is_event_socket, handle_events, batch_free);
+	}
+
+	if (!priv->recv_batch)
+		priv->recv_batch = g_malloc (sizeof (RecvBatch));
+
+	priv->recv_batch_busy = TRUE;
+	r = _recv_batch_read (platform, is_event_socket, handle_events, priv->recv_batch);
+	priv->recv_batch_busy = FALSE;
+	return r;
+}
+
 /*****************************************************************************/
 
+#define RESYNC_RCVBUF_SIZE_MAX (64*1024*1024)
+
+static void
+_resync_start (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->netlink_stats.overruns++;
+	if (!priv->resync.start_ns) {
+		priv->resync.start_ns = nm_utils_get_monotonic_timestamp_ns ();
+		priv->netlink_stats.resyncs++;
+	}
+
+	/* An overrun during a resync invalidates the stages that already completed.
+	 * Start over with the links. */
+	priv->resync.stages_pending =   DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES
+	                              | DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES
+	                              | DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES
+	                              | DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES;
+	priv->netlink_stats.resync_dumps++;
+	delayed_action_schedule (platform, DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS, NULL);
+
+	/* Repeated overruns mean that the receive buffer is too small for the
+	 * event rate. Grow it, up to a limit. */
+	if (priv->resync.rcvbuf_size < RESYNC_RCVBUF_SIZE_MAX) {
+		int nle;
+
+		priv->resync.rcvbuf_size = MIN (priv->resync.rcvbuf_size * 2, RESYNC_RCVBUF_SIZE_MAX);
+		nle = nl_socket_set_buffer_size (priv->nlh_event, priv->resync.rcvbuf_size, 0);
+		if (nle < 0)
+			_LOGD ("netlink: resync: failed to increase receive buffer to %u bytes: %s (%d)", priv->resync.rcvbuf_size, nl_geterror (nle), nle);
+		else
+			_LOGD ("netlink: resync: increase receive buffer to %u bytes", priv->resync.rcvbuf_size);
+	}
+}
+
+/**
+ * nm_linux_platform_get_netlink_stats:
+ * @platform: the #NMLinuxPlatform instance
+ * @out_stats: (out): the statistics about receive buffer overruns
+ *   and the cost of the resynchronizations they caused.
+ */
+void
+nm_linux_platform_get_netlink_stats (NMPlatform *platform, NMLinuxPlatformNetlinkStats *out_stats)
+{
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+	g_return_if_fail (out_stats);
+
+	*out_stats = NM_LINUX_PLATFORM_GET_PRIVATE (platform)->netlink_stats;
+}
+
+static gboolean
+_read_netlink_socket (NMPlatform *platform, gboolean is_event_socket, gint64 deadline)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gboolean any = FALSE;
+	int nle;
+
+	while (TRUE) {
+		if (   deadline
+		    && any
+		    && g_get_monotonic_time () >= deadline) {
+			priv->event_budget.exceeded = TRUE;
+			return any;
+		}
+
+		nle = event_handler_recvmsgs (platform, is_event_socket, TRUE);
+
+		if (nle < 0)
+			switch (nle) {
+			case -NLE_AGAIN:
+				return any;
+			case -NLE_DUMP_INTR:
+				_LOGD ("netlink: read: uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
+				break;
+			case -_NLE_NM_NOBUFS:
+				_LOGI ("netlink: read: too many netlink events. Need to resynchronize platform cache");
+				event_handler_recvmsgs (platform, is_event_socket, FALSE);
+				delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
+				_resync_start (platform);
+				break;
+			default:
+				_LOGE ("netlink: read: failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
+				break;
+		}
+		any = TRUE;
+	}
+}
+
 static gboolean
 event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	int r, nle;
-	struct pollfd pfd;
+	int r;
+	struct pollfd pfd[2];
 	gboolean any = FALSE;
+	gboolean read_events;
 	gint64 now_ns;
 	int timeout_ms;
 	guint i;
+	gint64 deadline;
 	struct {
 		guint32 seq_number;
 		gint64 timeout_abs_ns;
 	} data_next;
 
+	/* only the read of event_handler() itself has a budget. Nested reads,
+	 * from handlers of the emitted signals, must bring the cache up to
+	 * date for their caller. */
+	deadline = priv->event_budget.deadline;
+	priv->event_budget.deadline = 0;
+
 	if (!nm_platform_netns_push (platform, &netns))
 		return FALSE;
 
-	while (TRUE) {
-
-		while (TRUE) {
+	/* The replies to dumps arrive on the event socket, ordered with the
+	 * events. While one is pending, that socket is read too. */
+	read_events = FALSE;
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
+		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
+			if (g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i).on_event_socket) {
+				read_events = TRUE;
+				break;
+			}
+		}
+	}
 
-			nle = event_handler_recvmsgs (platform, TRUE);
+	while (TRUE) {
 
-			if (nle < 0)
-				switch (nle) {
-				case -NLE_AGAIN:
-					goto after_read;
-				case -NLE_DUMP_INTR:
-					_LOGD ("netlink: read: uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
-					break;
-				case -_NLE_NM_NOBUFS:
-					_LOGI ("netlink: read: too many netlink events. Need to resynchronize platform cache");
-					event_handler_recvmsgs (platform, FALSE);
-					delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
-					delayed_action_schedule (platform,
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-					                         NULL);
-					break;
-				default:
-					_LOGE ("netlink: read: failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
-					break;
-			}
+		if (_read_netlink_socket (platform, FALSE, 0))
+			any = TRUE;
+		if (   read_events
+		    && _read_netlink_socket (platform, TRUE, deadline))
 			any = TRUE;
-		}
 
 after_read:
 
 		if (!NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE))
-			return any;
+			goto out;
 
 		now_ns = 0;
 		data_next.seq_number = 0;
 		data_next.timeout_abs_ns = 0;
+		read_events = FALSE;
 
 		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; ) {
 			DelayedActionWaitForNlResponseData *data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
@@ -6066,6 +8703,8 @@ after_read:
 			else {
 				i++;
 
+				if (data->on_event_socket)
+					read_events = TRUE;
 				if (   data_next.seq_number == 0
 				    || data_next.timeout_abs_ns > data->timeout_abs_ns) {
 					data_next.seq_number = data->seq_number;
@@ -6076,7 +8715,7 @@ after_read:
 
 		if (   !wait_for_acks
 		    || !NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE))
-			return any;
+			goto out;
 
 		nm_assert (data_next.seq_number);
 		nm_assert (data_next.timeout_abs_ns > 0);
@@ -6086,10 +8725,12 @@ after_read:
 
 		timeout_ms = (data_next.timeout_abs_ns - now_ns) / (NM_UTILS_NS_PER_SECOND / 1000);
 
-		memset (&pfd, 0, sizeof (pfd));
-		pfd.fd = nl_socket_get_fd (priv->nlh);
-		pfd.events = POLLIN;
-		r = poll (&pfd, 1, MAX (1, timeout_ms));
+		memset (pfd, 0, sizeof (pfd));
+		pfd[0].fd = nl_socket_get_fd (priv->nlh);
+		pfd[0].events = POLLIN;
+		pfd[1].fd = nl_socket_get_fd (priv->nlh_event);
+		pfd[1].events = POLLIN;
+		r = poll (pfd, read_events ? 2 : 1, MAX (1, timeout_ms));
 
 		if (r == 0) {
 			/* timeout and there is nothing to read. */
@@ -6101,17 +8742,25 @@ after_read:
 			if (errsv != EINTR) {
 				_LOGE ("netlink: read: poll failed with %s", strerror (errsv));
 				delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_POLL);
-				return any;
+				goto out;
 			}
 			/* Continue to read again, even if there might be nothing to read after EINTR. */
 		}
 	}
+
+out:
+	/* The kernel queues the notifications caused by our requests on the
+	 * event socket before it sends the ACK. Process them now, so that the
+	 * cache is up to date when the caller looks at it. */
+	if (_read_netlink_socket (platform, TRUE, deadline))
+		any = TRUE;
+	return any;
 }
 
 /******************************************************************/
 
-static void
-cache_update_link_udev (NMPlatform *platform, int ifindex, GUdevDevice *udev_device)
+static gboolean
+_cache_update_link_udev (NMPlatform *platform, int ifindex, GUdevDevice *udev_device)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	nm_auto_nmpobj NMPObject *obj_cache = NULL;
@@ -6119,19 +8768,28 @@ cache_update_link_udev (NMPlatform *platform, int ifindex, GUdevDevice *udev_dev
 	NMPCacheOpsType cache_op;
 
 	cache_op = nmp_cache_update_link_udev (priv->cache, ifindex, udev_device, &obj_cache, &was_visible, cache_pre_hook, platform);
+	if (cache_op == NMP_CACHE_OPS_UNCHANGED)
+		return FALSE;
 
-	if (cache_op != NMP_CACHE_OPS_UNCHANGED) {
-		nm_auto_pop_netns NMPNetns *netns = NULL;
-
-		if (!nm_platform_netns_push (platform, &netns))
-			return;
-		do_emit_signal (platform, obj_cache, cache_op, was_visible);
-	}
+	do_emit_signal (platform, obj_cache, cache_op, was_visible);
+	return TRUE;
 }
 
 static void
-udev_device_added (NMPlatform *platform,
-                   GUdevDevice *udev_device)
+cache_update_link_udev (NMPlatform *platform, int ifindex, GUdevDevice *udev_device)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+
+	if (!nm_platform_netns_push (platform, &netns))
+		return;
+
+	if (   _cache_update_link_udev (platform, ifindex, udev_device)
+	    && !NM_LINUX_PLATFORM_GET_PRIVATE (platform)->delayed_action.is_handling)
+		_nm_platform_changes_batch_flush (platform);
+}
+
+static int
+_udev_device_get_ifindex (NMPlatform *platform, GUdevDevice *udev_device)
 {
 	const char *ifname;
 	int ifindex;
@@ -6139,26 +8797,75 @@ udev_device_added (NMPlatform *platform,
 	ifname = g_udev_device_get_name (udev_device);
 	if (!ifname) {
 		_LOGD ("udev-add: failed to get device's interface");
-		return;
+		return 0;
 	}
 
 	if (!g_udev_device_get_property (udev_device, "IFINDEX")) {
 		_LOGW ("udev-add[%s]failed to get device's ifindex", ifname);
-		return;
+		return 0;
 	}
 	ifindex = g_udev_device_get_property_as_int (udev_device, "IFINDEX");
 	if (ifindex <= 0) {
 		_LOGW ("udev-add[%s]: retrieved invalid IFINDEX=%d", ifname, ifindex);
-		return;
+		return 0;
 	}
 
 	if (!g_udev_device_get_sysfs_path (udev_device)) {
 		_LOGD ("udev-add[%s,%d]: couldn't determine device path; ignoring...", ifname, ifindex);
-		return;
+		return 0;
 	}
 
 	_LOGT ("udev-add[%s,%d]: device added", ifname, ifindex);
-	cache_update_link_udev (platform, ifindex, udev_device);
+	return ifindex;
+}
+
+static void
+udev_device_added (NMPlatform *platform,
+                   GUdevDevice *udev_device)
+{
+	int ifindex;
+
+	ifindex = _udev_device_get_ifindex (platform, udev_device);
+	if (ifindex > 0)
+		cache_update_link_udev (platform, ifindex, udev_device);
+}
+
+/* Adds the initially enumerated udev devices to the cache. All devices
+ * are validated and their driver is resolved first (which is the expensive
+ * part, as it may look up parent devices). Then the cache is updated in
+ * one go, with only one emission of the changes-batch signal. */
+static void
+udev_devices_add_all (NMPlatform *platform, GList *devices)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	gs_free int *ifindexes = NULL;
+	gboolean changed = FALSE;
+	GList *iter;
+	guint i, n;
+
+	ifindexes = g_new (int, g_list_length (devices) + 1);
+	for (iter = devices, n = 0; iter; iter = iter->next, n++) {
+		GUdevDevice *udev_device = iter->data;
+
+		ifindexes[n] = _udev_device_get_ifindex (platform, udev_device);
+		if (ifindexes[n] > 0)
+			nmp_utils_udev_get_driver (udev_device);
+	}
+
+	if (!nm_platform_netns_push (platform, &netns))
+		return;
+
+	for (iter = devices, i = 0; iter; iter = iter->next, i++) {
+		if (   ifindexes[i] > 0
+		    && _cache_update_link_udev (platform, ifindexes[i], iter->data))
+			changed = TRUE;
+	}
+
+	_LOGD ("udev: added %u initial devices", n);
+
+	if (   changed
+	    && !NM_LINUX_PLATFORM_GET_PRIVATE (platform)->delayed_action.is_handling)
+		_nm_platform_changes_batch_flush (platform);
 }
 
 static gboolean
@@ -6243,11 +8950,33 @@ nm_linux_platform_init (NMLinuxPlatform *self)
 	priv->delayed_action.list_refresh_link = g_ptr_array_new ();
 	priv->delayed_action.list_wait_for_nl_response = g_array_new (FALSE, TRUE, sizeof (DelayedActionWaitForNlResponseData));
 	priv->wifi_data = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) wifi_utils_deinit);
+	priv->sysctl_fd_cache.entries = g_hash_table_new (g_str_hash, g_str_equal);
+	g_queue_init (&priv->sysctl_fd_cache.lru);
+	priv->link_payload_hashes = g_hash_table_new_full (g_int_hash, g_int_equal, _link_payload_hash_free, NULL);
+	priv->link_statistics = g_hash_table_new_full (g_int_hash, g_int_equal, _link_statistics_free, NULL);
+	priv->ethtool_cache = g_hash_table_new_full (g_int_hash, g_int_equal, _ethtool_cache_entry_free, NULL);
 
 	if (use_udev)
 		priv->udev_client = g_udev_client_new ((const char *[]) { "net", NULL });
 }
 
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_IFINDEX_FILTER:
+		/* construct-only */
+		priv->ifindex_filter = g_value_get_int (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
 static void
 constructed (GObject *_object)
 {
@@ -6256,6 +8985,7 @@ constructed (GObject *_object)
 	int channel_flags;
 	gboolean status;
 	int nle;
+	gint64 ts;
 
 	nm_assert (!platform->_netns || platform->_netns == nmp_netns_get_current ());
 
@@ -6278,23 +9008,52 @@ constructed (GObject *_object)
 	nle = nl_socket_set_passcred (priv->nlh, 1);
 	g_assert (!nle);
 
-	/* No blocking for event socket, so that we can drain it safely. */
+	/* No blocking for the request socket, we poll() it while waiting for ACKs. */
 	nle = nl_socket_set_nonblocking (priv->nlh);
 	g_assert (!nle);
 
+	/* batched requests can queue many ACKs at once. */
+	nle = nl_socket_set_buffer_size (priv->nlh, 1024*1024, 0);
+	g_assert (!nle);
+
+	if (priv->ifindex_filter > 0) {
+		int one = 1;
+
+		/* let the kernel filter address and route dumps by ifindex */
+		if (setsockopt (nl_socket_get_fd (priv->nlh), SOL_NETLINK, NETLINK_GET_STRICT_CHK, &one, sizeof (one)) < 0)
+			_LOGD ("netlink: no strict checking for dump requests, filter ifindex %d in user space", priv->ifindex_filter);
+		else
+			_LOGD ("netlink: only cache ifindex %d", priv->ifindex_filter);
+	}
+
+	_LOGD ("Netlink socket for requests established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh), nl_socket_get_fd (priv->nlh));
+
+	priv->nlh_event = nl_socket_alloc ();
+	g_assert (priv->nlh_event);
+
+	nle = nl_connect (priv->nlh_event, NETLINK_ROUTE);
+	g_assert (!nle);
+	nle = nl_socket_set_passcred (priv->nlh_event, 1);
+	g_assert (!nle);
+
+	/* No blocking for event socket, so that we can drain it safely. */
+	nle = nl_socket_set_nonblocking (priv->nlh_event);
+	g_assert (!nle);
+
 	/* use 8 MB for receive socket kernel queue. */
-	nle = nl_socket_set_buffer_size (priv->nlh, 8*1024*1024, 0);
+	priv->resync.rcvbuf_size = 8*1024*1024;
+	nle = nl_socket_set_buffer_size (priv->nlh_event, priv->resync.rcvbuf_size, 0);
 	g_assert (!nle);
 
-	nle = nl_socket_add_memberships (priv->nlh,
+	nle = nl_socket_add_memberships (priv->nlh_event,
 	                                 RTNLGRP_LINK,
 	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
 	                                 RTNLGRP_IPV4_ROUTE,  RTNLGRP_IPV6_ROUTE,
 	                                 0);
 	g_assert (!nle);
-	_LOGD ("Netlink socket for events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh), nl_socket_get_fd (priv->nlh));
+	_LOGD ("Netlink socket for events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh_event), nl_socket_get_fd (priv->nlh_event));
 
-	priv->event_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh));
+	priv->event_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh_event));
 	g_io_channel_set_encoding (priv->event_channel, NULL, NULL);
 	g_io_channel_set_close_on_unref (priv->event_channel, TRUE);
 
@@ -6302,9 +9061,25 @@ constructed (GObject *_object)
 	status = g_io_channel_set_flags (priv->event_channel,
 	                                 channel_flags | G_IO_FLAG_NONBLOCK, NULL);
 	g_assert (status);
-	priv->event_id = g_io_add_watch (priv->event_channel,
-	                                (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
-	                                 event_handler, platform);
+	priv->event_id = g_io_add_watch_full (priv->event_channel,
+	                                      NM_LOOP_SCHED_PRIORITY_NETLINK,
+	                                      (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
+	                                      event_handler, platform, NULL);
+
+	/* ACKs of requests that nobody waits for synchronously must be read
+	 * even when no event arrives. */
+	priv->request_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh));
+	g_io_channel_set_encoding (priv->request_channel, NULL, NULL);
+	g_io_channel_set_close_on_unref (priv->request_channel, TRUE);
+
+	channel_flags = g_io_channel_get_flags (priv->request_channel);
+	status = g_io_channel_set_flags (priv->request_channel,
+	                                 channel_flags | G_IO_FLAG_NONBLOCK, NULL);
+	g_assert (status);
+	priv->request_id = g_io_add_watch_full (priv->request_channel,
+	                                        NM_LOOP_SCHED_PRIORITY_NETLINK,
+	                                        (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
+	                                        event_handler, platform, NULL);
 
 	/* complete construction of the GObject instance before populating the cache. */
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->constructed (_object);
@@ -6318,12 +9093,16 @@ constructed (GObject *_object)
 	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
 	                         NULL);
 
+	ts = nm_startup_profile_begin ();
 	delayed_action_handle_all (platform, FALSE);
+	nm_startup_profile_end (ts, "platform-dump", NULL);
 
 	/* Set up udev monitoring */
 	if (priv->udev_client) {
 		GUdevEnumerator *enumerator;
-		GList *devices, *iter;
+		GList *devices;
+
+		ts = nm_startup_profile_begin ();
 
 		g_signal_connect (priv->udev_client, "uevent", G_CALLBACK (handle_udev_event), platform);
 
@@ -6334,12 +9113,11 @@ constructed (GObject *_object)
 		g_udev_enumerator_add_match_is_initialized (enumerator);
 
 		devices = g_udev_enumerator_execute (enumerator);
-		for (iter = devices; iter; iter = g_list_next (iter)) {
-			udev_device_added (platform, G_UDEV_DEVICE (iter->data));
-			g_object_unref (G_UDEV_DEVICE (iter->data));
-		}
-		g_list_free (devices);
+		udev_devices_add_all (platform, devices);
+		g_list_free_full (devices, g_object_unref);
 		g_object_unref (enumerator);
+
+		nm_startup_profile_end (ts, "udev-enumeration", NULL);
 	}
 }
 
@@ -6381,10 +9159,20 @@ nm_linux_platform_finalize (GObject *object)
 	/* Free netlink resources */
 	g_source_remove (priv->event_id);
 	g_io_channel_unref (priv->event_channel);
+	g_source_remove (priv->request_id);
+	g_io_channel_unref (priv->request_channel);
 	nl_socket_free (priv->nlh);
+	nl_socket_free (priv->nlh_event);
+	g_free (priv->recv_batch);
 
 	g_hash_table_unref (priv->wifi_data);
 
+	_sysctl_fd_cache_clear (priv);
+	g_hash_table_unref (priv->sysctl_fd_cache.entries);
+	g_hash_table_unref (priv->link_payload_hashes);
+	g_hash_table_unref (priv->link_statistics);
+	g_hash_table_unref (priv->ethtool_cache);
+
 	if (priv->sysctl_get_prev_values) {
 		sysctl_clear_cache_list = g_slist_remove (sysctl_clear_cache_list, object);
 		g_hash_table_destroy (priv->sysctl_get_prev_values);
@@ -6404,11 +9192,21 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	g_type_class_add_private (klass, sizeof (NMLinuxPlatformPrivate));
 
 	/* virtual methods */
+	object_class->set_property = set_property;
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 	object_class->finalize = nm_linux_platform_finalize;
 
+	g_object_class_install_property
+	    (object_class, PROP_IFINDEX_FILTER,
+	     g_param_spec_int (NM_LINUX_PLATFORM_IFINDEX_FILTER, "", "",
+	                       0, G_MAXINT, 0,
+	                       G_PARAM_WRITABLE |
+	                       G_PARAM_CONSTRUCT_ONLY |
+	                       G_PARAM_STATIC_STRINGS));
+
 	platform_class->sysctl_set = sysctl_set;
+	platform_class->sysctl_set_many = sysctl_set_many;
 	platform_class->sysctl_get = sysctl_get;
 
 	platform_class->link_get = _nm_platform_link_get;
@@ -6423,6 +9221,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->link_get_lnk = link_get_lnk;
 
 	platform_class->link_refresh = link_refresh;
+	platform_class->link_statistics_refresh = link_statistics_refresh;
+	platform_class->link_get_statistics = link_get_statistics;
 
 	platform_class->link_set_netns = link_set_netns;
 
@@ -6439,6 +9239,11 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->link_set_address = link_set_address;
 	platform_class->link_get_permanent_address = link_get_permanent_address;
 	platform_class->link_set_mtu = link_set_mtu;
+	platform_class->link_set_dcb = link_set_dcb;
+	platform_class->qdisc_get_root = qdisc_get_root;
+	platform_class->qdisc_set_root = qdisc_set_root;
+	platform_class->link_set_sriov = link_set_sriov;
+	platform_class->link_change_attrs = link_change_attrs;
 
 	platform_class->link_get_physical_port_id = link_get_physical_port_id;
 	platform_class->link_get_dev_id = link_get_dev_id;
@@ -6455,6 +9260,10 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->vlan_add = vlan_add;
 	platform_class->link_vlan_change = link_vlan_change;
+	platform_class->link_bond_change = link_bond_change;
+	platform_class->link_add_batch = link_add_batch;
+	platform_class->link_bridge_change = link_bridge_change;
+	platform_class->link_bridge_port_change = link_bridge_port_change;
 	platform_class->link_vxlan_add = link_vxlan_add;
 
 	platform_class->tun_add = tun_add;
@@ -6494,13 +9303,20 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->ip4_route_get = ip4_route_get;
 	platform_class->ip6_route_get = ip6_route_get;
+	platform_class->ip4_route_lookup_best = ip4_route_lookup_best;
+	platform_class->ip6_route_lookup_best = ip6_route_lookup_best;
 	platform_class->ip4_route_get_all = ip4_route_get_all;
 	platform_class->ip6_route_get_all = ip6_route_get_all;
+	platform_class->object_get_view = object_get_view;
+	platform_class->cache_get_generation = cache_get_generation;
 	platform_class->ip4_route_add = ip4_route_add;
+	platform_class->ip4_route_add_multipath = ip4_route_add_multipath;
 	platform_class->ip6_route_add = ip6_route_add;
 	platform_class->ip4_route_delete = ip4_route_delete;
 	platform_class->ip6_route_delete = ip6_route_delete;
 
+	platform_class->batch_commit = batch_commit;
+
 	platform_class->check_support_kernel_extended_ifa_flags = check_support_kernel_extended_ifa_flags;
 	platform_class->check_support_user_ipv6ll = check_support_user_ipv6ll;
 
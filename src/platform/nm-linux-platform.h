@@ -30,6 +30,8 @@
 #define NM_IS_LINUX_PLATFORM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_LINUX_PLATFORM))
 #define NM_LINUX_PLATFORM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_LINUX_PLATFORM, NMLinuxPlatformClass))
 
+#define NM_LINUX_PLATFORM_IFINDEX_FILTER "ifindex-filter"
+
 /******************************************************************/
 
 struct _NMLinuxPlatformPrivate;
@@ -49,8 +51,46 @@ typedef struct {
 GType nm_linux_platform_get_type (void);
 
 NMPlatform *nm_linux_platform_new (gboolean netns_support);
+NMPlatform *nm_linux_platform_new_for_netns (const char *filename);
 
 void nm_linux_platform_setup (void);
+void nm_linux_platform_setup_for_ifindex (int ifindex);
+
+typedef struct {
+	/* number of overruns of the netlink receive buffer */
+	guint overruns;
+
+	/* number of resynchronizations of the cache. Overruns during
+	 * a pending resync don't start a new one. */
+	guint resyncs;
+
+	/* number of dump requests and of received messages for resyncs */
+	guint resync_dumps;
+	guint resync_messages;
+
+	/* duration of the last, and of all resyncs */
+	gint64 resync_last_ns;
+	gint64 resync_total_ns;
+
+	/* what was received from netlink, and with how many syscalls */
+	guint64 recv_syscalls;
+	guint64 recv_datagrams;
+	guint64 recv_messages;
+	guint64 recv_bytes;
+
+	/* RTM_NEWLINK messages that were skipped without parsing, because
+	 * their payload didn't change. */
+	guint64 newlink_skipped;
+
+	/* messages about other interfaces, dropped by the ifindex filter */
+	guint64 filtered_messages;
+
+	/* wakeups of the event socket that left events for later, because
+	 * handling them took longer than NM_LOOP_SCHED_NETLINK_BUDGET_USEC */
+	guint64 budget_yields;
+} NMLinuxPlatformNetlinkStats;
+
+void nm_linux_platform_get_netlink_stats (NMPlatform *platform, NMLinuxPlatformNetlinkStats *out_stats);
 
 struct _NMPCacheId;
 
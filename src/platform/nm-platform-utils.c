@@ -324,6 +324,163 @@ nmp_utils_ethtool_set_wake_on_lan (const char *ifname,
 	return ethtool_get (ifname, &wol_info);
 }
 
+/* LRO has no own command, it is one of the ETHTOOL_GFLAGS. */
+static const struct {
+	guint32 get_cmd;
+	guint32 set_cmd;
+} ethtool_feature_cmds[] = {
+	[NM_PLATFORM_ETHTOOL_FEATURE_GRO] = { ETHTOOL_GGRO, ETHTOOL_SGRO },
+	[NM_PLATFORM_ETHTOOL_FEATURE_GSO] = { ETHTOOL_GGSO, ETHTOOL_SGSO },
+	[NM_PLATFORM_ETHTOOL_FEATURE_TSO] = { ETHTOOL_GTSO, ETHTOOL_STSO },
+	[NM_PLATFORM_ETHTOOL_FEATURE_LRO] = { ETHTOOL_GFLAGS, ETHTOOL_SFLAGS },
+};
+
+gboolean
+nmp_utils_ethtool_get_feature (const char *ifname,
+                               NMPlatformEthtoolFeature feature,
+                               gboolean *out_enabled)
+{
+	struct ethtool_value edata = { };
+
+	g_return_val_if_fail (feature < G_N_ELEMENTS (ethtool_feature_cmds), FALSE);
+
+	edata.cmd = ethtool_feature_cmds[feature].get_cmd;
+	if (!ethtool_get (ifname, &edata))
+		return FALSE;
+
+	if (feature == NM_PLATFORM_ETHTOOL_FEATURE_LRO)
+		*out_enabled = NM_FLAGS_HAS (edata.data, ETH_FLAG_LRO);
+	else
+		*out_enabled = !!edata.data;
+	return TRUE;
+}
+
+gboolean
+nmp_utils_ethtool_set_feature (const char *ifname,
+                               NMPlatformEthtoolFeature feature,
+                               gboolean enabled)
+{
+	struct ethtool_value edata = { };
+
+	g_return_val_if_fail (feature < G_N_ELEMENTS (ethtool_feature_cmds), FALSE);
+
+	nm_log_dbg (LOGD_PLATFORM, "ethtool: %s: set feature %d to %s",
+	            ifname, (int) feature, enabled ? "on" : "off");
+
+	if (feature == NM_PLATFORM_ETHTOOL_FEATURE_LRO) {
+		/* keep the other flags */
+		edata.cmd = ETHTOOL_GFLAGS;
+		if (!ethtool_get (ifname, &edata))
+			return FALSE;
+		if (enabled)
+			edata.data |= ETH_FLAG_LRO;
+		else
+			edata.data &= ~ETH_FLAG_LRO;
+	} else
+		edata.data = !!enabled;
+
+	edata.cmd = ethtool_feature_cmds[feature].set_cmd;
+	return ethtool_get (ifname, &edata);
+}
+
+gboolean
+nmp_utils_ethtool_get_ring (const char *ifname, NMPlatformEthtoolRing *out_ring)
+{
+	struct ethtool_ringparam edata = {
+		.cmd = ETHTOOL_GRINGPARAM,
+	};
+
+	if (!ethtool_get (ifname, &edata))
+		return FALSE;
+
+	out_ring->rx = edata.rx_pending;
+	out_ring->rx_mini = edata.rx_mini_pending;
+	out_ring->rx_jumbo = edata.rx_jumbo_pending;
+	out_ring->tx = edata.tx_pending;
+	return TRUE;
+}
+
+gboolean
+nmp_utils_ethtool_set_ring (const char *ifname, const NMPlatformEthtoolRing *ring)
+{
+	struct ethtool_ringparam edata = {
+		.cmd = ETHTOOL_GRINGPARAM,
+	};
+
+	if (!ethtool_get (ifname, &edata))
+		return FALSE;
+
+	if (   edata.rx_pending == ring->rx
+	    && edata.rx_mini_pending == ring->rx_mini
+	    && edata.rx_jumbo_pending == ring->rx_jumbo
+	    && edata.tx_pending == ring->tx)
+		return TRUE;
+
+	nm_log_dbg (LOGD_PLATFORM, "ethtool: %s: set rings rx %u, rx-mini %u, rx-jumbo %u, tx %u",
+	            ifname, ring->rx, ring->rx_mini, ring->rx_jumbo, ring->tx);
+
+	/* resizing the rings usually resets the device, so only do it
+	 * when something changes. */
+	edata.cmd = ETHTOOL_SRINGPARAM;
+	edata.rx_pending = ring->rx;
+	edata.rx_mini_pending = ring->rx_mini;
+	edata.rx_jumbo_pending = ring->rx_jumbo;
+	edata.tx_pending = ring->tx;
+	return ethtool_get (ifname, &edata);
+}
+
+gboolean
+nmp_utils_ethtool_get_coalesce (const char *ifname, NMPlatformEthtoolCoalesce *out_coalesce)
+{
+	struct ethtool_coalesce edata = {
+		.cmd = ETHTOOL_GCOALESCE,
+	};
+
+	if (!ethtool_get (ifname, &edata))
+		return FALSE;
+
+	out_coalesce->rx_usecs = edata.rx_coalesce_usecs;
+	out_coalesce->rx_frames = edata.rx_max_coalesced_frames;
+	out_coalesce->tx_usecs = edata.tx_coalesce_usecs;
+	out_coalesce->tx_frames = edata.tx_max_coalesced_frames;
+	out_coalesce->adaptive_rx = !!edata.use_adaptive_rx_coalesce;
+	out_coalesce->adaptive_tx = !!edata.use_adaptive_tx_coalesce;
+	return TRUE;
+}
+
+gboolean
+nmp_utils_ethtool_set_coalesce (const char *ifname, const NMPlatformEthtoolCoalesce *coalesce)
+{
+	struct ethtool_coalesce edata = {
+		.cmd = ETHTOOL_GCOALESCE,
+	};
+
+	if (!ethtool_get (ifname, &edata))
+		return FALSE;
+
+	if (   edata.rx_coalesce_usecs == coalesce->rx_usecs
+	    && edata.rx_max_coalesced_frames == coalesce->rx_frames
+	    && edata.tx_coalesce_usecs == coalesce->tx_usecs
+	    && edata.tx_max_coalesced_frames == coalesce->tx_frames
+	    && !edata.use_adaptive_rx_coalesce == !coalesce->adaptive_rx
+	    && !edata.use_adaptive_tx_coalesce == !coalesce->adaptive_tx)
+		return TRUE;
+
+	nm_log_dbg (LOGD_PLATFORM, "ethtool: %s: set coalesce rx-usecs %u, rx-frames %u, tx-usecs %u, tx-frames %u, adaptive-rx %d, adaptive-tx %d",
+	            ifname, coalesce->rx_usecs, coalesce->rx_frames,
+	            coalesce->tx_usecs, coalesce->tx_frames,
+	            coalesce->adaptive_rx, coalesce->adaptive_tx);
+
+	edata.cmd = ETHTOOL_SCOALESCE;
+	edata.rx_coalesce_usecs = coalesce->rx_usecs;
+	edata.rx_max_coalesced_frames = coalesce->rx_frames;
+	edata.tx_coalesce_usecs = coalesce->tx_usecs;
+	edata.tx_max_coalesced_frames = coalesce->tx_frames;
+	edata.use_adaptive_rx_coalesce = coalesce->adaptive_rx;
+	edata.use_adaptive_tx_coalesce = coalesce->adaptive_tx;
+	return ethtool_get (ifname, &edata);
+}
+
 /******************************************************************
  * mii
  ******************************************************************/
@@ -380,12 +537,22 @@ out:
  * udev
  ******************************************************************/
 
+static GQuark _udev_driver_quark (void);
+G_DEFINE_QUARK (nmp-utils-udev-driver, _udev_driver)
+
 const char *
 nmp_utils_udev_get_driver (GUdevDevice *device)
 {
 	GUdevDevice *parent = NULL, *grandparent = NULL;
 	const char *driver, *subsys;
 
+	/* a GUdevDevice is an immutable snapshot of the device, so remember the
+	 * result. Looking up the parent devices is expensive and the driver is
+	 * requested every time the link is updated in the platform cache. */
+	driver = g_object_get_qdata (G_OBJECT (device), _udev_driver_quark ());
+	if (driver)
+		return driver[0] ? driver : NULL;
+
 	driver = g_udev_device_get_driver (device);
 	if (driver)
 		goto out;
@@ -414,7 +581,9 @@ nmp_utils_udev_get_driver (GUdevDevice *device)
 out:
 	/* Intern the string so we don't have to worry about memory
 	 * management in NMPlatformLink. */
-	return g_intern_string (driver);
+	driver = g_intern_string (driver);
+	g_object_set_qdata (G_OBJECT (device), _udev_driver_quark (), (gpointer) (driver ?: ""));
+	return driver;
 }
 
 /******************************************************************************
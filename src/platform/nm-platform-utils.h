@@ -37,6 +37,13 @@ gboolean nmp_utils_ethtool_set_wake_on_lan (const char *ifname, NMSettingWiredWa
 
 gboolean nmp_utils_ethtool_get_link_speed (const char *ifname, guint32 *out_speed);
 
+gboolean nmp_utils_ethtool_get_feature (const char *ifname, NMPlatformEthtoolFeature feature, gboolean *out_enabled);
+gboolean nmp_utils_ethtool_set_feature (const char *ifname, NMPlatformEthtoolFeature feature, gboolean enabled);
+gboolean nmp_utils_ethtool_get_ring (const char *ifname, NMPlatformEthtoolRing *out_ring);
+gboolean nmp_utils_ethtool_set_ring (const char *ifname, const NMPlatformEthtoolRing *ring);
+gboolean nmp_utils_ethtool_get_coalesce (const char *ifname, NMPlatformEthtoolCoalesce *out_coalesce);
+gboolean nmp_utils_ethtool_set_coalesce (const char *ifname, const NMPlatformEthtoolCoalesce *coalesce);
+
 gboolean nmp_utils_ethtool_get_driver_info (const char *ifname,
                                             char **out_driver_name,
                                             char **out_driver_version,
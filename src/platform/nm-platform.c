@@ -61,7 +61,7 @@ G_STATIC_ASSERT (G_STRUCT_OFFSET (NMPlatformIPRoute, network_ptr) == G_STRUCT_OF
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             char __prefix[32]; \
             const char *__p_prefix = _NMLOG_PREFIX_NAME; \
             const void *const __self = (self); \
@@ -95,6 +95,24 @@ enum {
 
 typedef struct {
 	gboolean register_singleton;
+
+	struct {
+		/* the not yet emitted NMPlatformChangesBatchEntry items. */
+		GArray *entries;
+
+		/* NMPObject id of entries -> index into @entries + 1 */
+		GHashTable *idx;
+	} changes_batch;
+
+	struct {
+		/* subscription id -> LinkStatisticsSubscription */
+		GHashTable *subscriptions;
+		guint last_id;
+
+		/* the period of the refreshes, the smallest requested rate. */
+		guint rate_ms;
+		guint timeout_id;
+	} link_statistics;
 } NMPlatformPrivate;
 
 /******************************************************************/
@@ -278,6 +296,47 @@ nm_platform_sysctl_set (NMPlatform *self, const char *path, const char *value)
 	return klass->sysctl_set (self, path, value);
 }
 
+/**
+ * nm_platform_sysctl_set_many:
+ * @self: platform instance
+ * @entries: the path/value pairs to write
+ * @len: the number of @entries
+ *
+ * Like nm_platform_sysctl_set(), but writes several values in one go,
+ * in the order given. The result for each entry is reported in its
+ * @errsv field.
+ *
+ * Returns: %TRUE if all values were written successfully.
+ */
+gboolean
+nm_platform_sysctl_set_many (NMPlatform *self, NMPlatformSysctlSetEntry *entries, guint len)
+{
+	gboolean success = TRUE;
+	guint i;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (entries || len == 0, FALSE);
+
+	for (i = 0; i < len; i++) {
+		g_return_val_if_fail (entries[i].path, FALSE);
+		g_return_val_if_fail (entries[i].value, FALSE);
+	}
+
+	if (klass->sysctl_set_many)
+		return klass->sysctl_set_many (self, entries, len);
+
+	for (i = 0; i < len; i++) {
+		if (klass->sysctl_set (self, entries[i].path, entries[i].value))
+			entries[i].errsv = 0;
+		else {
+			entries[i].errsv = errno ?: EIO;
+			success = FALSE;
+		}
+	}
+	return success;
+}
+
 gboolean
 nm_platform_sysctl_set_ip6_hop_limit_safe (NMPlatform *self, const char *iface, int value)
 {
@@ -842,6 +901,188 @@ nm_platform_link_refresh (NMPlatform *self, int ifindex)
 	return TRUE;
 }
 
+/******************************************************************/
+
+/* All subscribers share one timer, which refreshes the counters of all
+ * links at once at the smallest requested rate. A subscriber is only
+ * called every n-th refresh, so that it never gets updates faster than
+ * it asked for. */
+
+typedef struct {
+	guint id;
+	guint rate_ms;
+	NMPlatformLinkStatisticsFunc callback;
+	gpointer user_data;
+
+	/* refreshes to skip before calling @callback */
+	guint ticks;
+	guint ticks_left;
+} LinkStatisticsSubscription;
+
+static void
+_link_statistics_subscription_free (gpointer data)
+{
+	g_slice_free (LinkStatisticsSubscription, data);
+}
+
+static gboolean
+_link_statistics_timeout_cb (gpointer user_data)
+{
+	NMPlatform *self = user_data;
+	NMPlatformClass *klass = NM_PLATFORM_GET_CLASS (self);
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	gs_unref_array GArray *due = NULL;
+	GHashTableIter iter;
+	LinkStatisticsSubscription *sub;
+	guint i;
+
+	if (klass->link_statistics_refresh)
+		klass->link_statistics_refresh (self);
+
+	due = g_array_new (FALSE, FALSE, sizeof (guint));
+	g_hash_table_iter_init (&iter, priv->link_statistics.subscriptions);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &sub)) {
+		if (--sub->ticks_left > 0)
+			continue;
+		sub->ticks_left = sub->ticks;
+		g_array_append_val (due, sub->id);
+	}
+
+	/* the callbacks might (un)subscribe. */
+	for (i = 0; i < due->len; i++) {
+		sub = g_hash_table_lookup (priv->link_statistics.subscriptions,
+		                           GUINT_TO_POINTER (g_array_index (due, guint, i)));
+		if (sub)
+			sub->callback (self, sub->user_data);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+_link_statistics_reschedule (NMPlatform *self)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LinkStatisticsSubscription *sub;
+	guint rate_ms = 0;
+
+	if (priv->link_statistics.subscriptions) {
+		g_hash_table_iter_init (&iter, priv->link_statistics.subscriptions);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &sub)) {
+			if (rate_ms == 0 || sub->rate_ms < rate_ms)
+				rate_ms = sub->rate_ms;
+		}
+	}
+
+	if (rate_ms != priv->link_statistics.rate_ms) {
+		nm_clear_g_source (&priv->link_statistics.timeout_id);
+		priv->link_statistics.rate_ms = rate_ms;
+		if (rate_ms) {
+			_LOGD ("link-statistics: refresh every %u msec", rate_ms);
+			priv->link_statistics.timeout_id = g_timeout_add (rate_ms, _link_statistics_timeout_cb, self);
+		} else
+			_LOGD ("link-statistics: stop refreshing");
+	}
+
+	if (!rate_ms)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->link_statistics.subscriptions);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &sub)) {
+		guint ticks = (sub->rate_ms + rate_ms - 1) / rate_ms;
+
+		if (sub->ticks != ticks) {
+			sub->ticks = ticks;
+			sub->ticks_left = ticks;
+		}
+	}
+}
+
+/**
+ * nm_platform_link_statistics_subscribe:
+ * @self: platform instance
+ * @refresh_rate_ms: how often @callback wants to be called, at most
+ * @callback: called after the counters were refreshed
+ * @user_data: user data for @callback
+ *
+ * Refreshes the traffic counters of all links periodically with a single
+ * request, for as long as anybody is subscribed. Read them from @callback
+ * with nm_platform_link_get_statistics().
+ *
+ * Returns: the id for nm_platform_link_statistics_unsubscribe().
+ */
+guint
+nm_platform_link_statistics_subscribe (NMPlatform *self,
+                                       guint refresh_rate_ms,
+                                       NMPlatformLinkStatisticsFunc callback,
+                                       gpointer user_data)
+{
+	NMPlatformPrivate *priv;
+	LinkStatisticsSubscription *sub;
+
+	_CHECK_SELF (self, klass, 0);
+
+	g_return_val_if_fail (refresh_rate_ms > 0, 0);
+	g_return_val_if_fail (callback, 0);
+
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+
+	if (!priv->link_statistics.subscriptions)
+		priv->link_statistics.subscriptions = g_hash_table_new_full (NULL, NULL, NULL, _link_statistics_subscription_free);
+
+	sub = g_slice_new0 (LinkStatisticsSubscription);
+	if (++priv->link_statistics.last_id == 0)
+		priv->link_statistics.last_id++;
+	sub->id = priv->link_statistics.last_id;
+	sub->rate_ms = refresh_rate_ms;
+	sub->callback = callback;
+	sub->user_data = user_data;
+	g_hash_table_insert (priv->link_statistics.subscriptions, GUINT_TO_POINTER (sub->id), sub);
+
+	_link_statistics_reschedule (self);
+	return sub->id;
+}
+
+void
+nm_platform_link_statistics_unsubscribe (NMPlatform *self, guint subscription_id)
+{
+	NMPlatformPrivate *priv;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+
+	if (   !priv->link_statistics.subscriptions
+	    || !g_hash_table_remove (priv->link_statistics.subscriptions, GUINT_TO_POINTER (subscription_id)))
+		g_return_if_reached ();
+
+	_link_statistics_reschedule (self);
+}
+
+/**
+ * nm_platform_link_get_statistics:
+ * @self: platform instance
+ * @ifindex: Interface index
+ * @out_stats: (out): the counters of the link
+ *
+ * Returns: %FALSE if there are no counters for the link.
+ */
+gboolean
+nm_platform_link_get_statistics (NMPlatform *self, int ifindex, NMPlatformLinkStatistics *out_stats)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (out_stats, FALSE);
+
+	if (!klass->link_get_statistics)
+		return FALSE;
+	return klass->link_get_statistics (self, ifindex, out_stats);
+}
+
+/******************************************************************/
+
 static guint
 _link_get_flags (NMPlatform *self, int ifindex)
 {
@@ -1204,6 +1445,229 @@ nm_platform_link_set_mtu (NMPlatform *self, int ifindex, guint32 mtu)
 	return klass->link_set_mtu (self, ifindex, mtu);
 }
 
+/* Applies the changes one after the other, in the same order as kernel
+ * does when it gets them in one message. */
+static gboolean
+_link_change_attrs_each (NMPlatform *self, int ifindex, const NMPlatformLinkChangeAttrs *attrs, gboolean *out_no_firmware)
+{
+	NMPlatformClass *klass = NM_PLATFORM_GET_CLASS (self);
+
+	if (   NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_ADDRESS)
+	    && !klass->link_set_address (self, ifindex, attrs->address, attrs->address_len))
+		return FALSE;
+	if (   NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MTU)
+	    && !klass->link_set_mtu (self, ifindex, attrs->mtu))
+		return FALSE;
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_FLAGS)) {
+		if (NM_FLAGS_HAS (attrs->flags_mask, IFF_NOARP)) {
+			if (!(  NM_FLAGS_HAS (attrs->flags_set, IFF_NOARP)
+			      ? klass->link_set_noarp (self, ifindex)
+			      : klass->link_set_arp (self, ifindex)))
+				return FALSE;
+		}
+		if (NM_FLAGS_HAS (attrs->flags_mask, IFF_UP)) {
+			if (!(  NM_FLAGS_HAS (attrs->flags_set, IFF_UP)
+			      ? klass->link_set_up (self, ifindex, out_no_firmware)
+			      : klass->link_set_down (self, ifindex)))
+				return FALSE;
+		}
+	}
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MASTER)) {
+		if (attrs->master > 0) {
+			if (!klass->link_enslave (self, attrs->master, ifindex))
+				return FALSE;
+		} else {
+			int master = nm_platform_link_get_master (self, ifindex);
+
+			if (master > 0 && !klass->link_release (self, master, ifindex))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * nm_platform_link_change_attrs:
+ * @self: platform instance
+ * @ifindex: Interface index
+ * @attrs: the changes
+ * @out_no_firmware: (allow-none): if the failure reason is due to missing firmware.
+ *
+ * Changes several attributes of the link at once. Kernel applies the
+ * address and the MTU first, then the flags and then the master, so e.g.
+ * a link can be taken down and enslaved, or get a new address and be set
+ * up with a single request.
+ *
+ * If kernel rejects the combined request, the changes are retried one by
+ * one, to apply those that can be.
+ *
+ * Returns: %TRUE if all changes were applied.
+ */
+gboolean
+nm_platform_link_change_attrs (NMPlatform *self, int ifindex, const NMPlatformLinkChangeAttrs *attrs, gboolean *out_no_firmware)
+{
+	NMPlatformError plerr;
+	char s_flags[100];
+	char s_mtu[30];
+	char s_master[30];
+	gs_free char *mac = NULL;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (attrs, FALSE);
+	g_return_val_if_fail (!(attrs->flags_mask & ~(IFF_UP | IFF_NOARP)), FALSE);
+	g_return_val_if_fail (   !NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_ADDRESS)
+	                      || (attrs->address && attrs->address_len), FALSE);
+
+	NM_SET_OUT (out_no_firmware, FALSE);
+
+	if (attrs->change == NM_PLATFORM_LINK_CHANGE_NONE)
+		return TRUE;
+
+	s_flags[0] = '\0';
+	s_mtu[0] = '\0';
+	s_master[0] = '\0';
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_FLAGS)) {
+		nm_sprintf_buf (s_flags, " flags 0x%x/0x%x",
+		                attrs->flags_set & attrs->flags_mask, attrs->flags_mask);
+	}
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MTU))
+		nm_sprintf_buf (s_mtu, " mtu %u", (unsigned) attrs->mtu);
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_ADDRESS))
+		mac = nm_utils_hwaddr_ntoa (attrs->address, attrs->address_len);
+	if (NM_FLAGS_HAS (attrs->change, NM_PLATFORM_LINK_CHANGE_MASTER))
+		nm_sprintf_buf (s_master, " master %d", attrs->master);
+
+	_LOGD ("link: changing '%s' (%d):%s%s%s%s%s",
+	       nm_platform_link_get_name (self, ifindex), ifindex,
+	       s_flags, s_mtu,
+	       mac ? " address " : "", mac ?: "",
+	       s_master);
+
+	if (!klass->link_change_attrs)
+		return _link_change_attrs_each (self, ifindex, attrs, out_no_firmware);
+
+	plerr = klass->link_change_attrs (self, ifindex, attrs);
+	if (plerr == NM_PLATFORM_ERROR_SUCCESS)
+		return TRUE;
+	if (plerr == NM_PLATFORM_ERROR_NO_FIRMWARE) {
+		NM_SET_OUT (out_no_firmware, TRUE);
+		return FALSE;
+	}
+
+	if (nm_utils_is_power_of_two (attrs->change))
+		return FALSE;
+	_LOGD ("link: changing '%s' (%d) at once failed, retry one by one",
+	       nm_platform_link_get_name (self, ifindex), ifindex);
+	return _link_change_attrs_each (self, ifindex, attrs, out_no_firmware);
+}
+
+/**
+ * nm_platform_link_set_dcb:
+ * @self: platform instance
+ * @ifindex: Interface index
+ * @enable: whether DCB should be enabled
+ * @config: (allow-none): the configuration to commit with DCB enabled,
+ *   or to turn off before disabling it.
+ *
+ * Configures DCB of the link through the kernel driver (dcbnl), without
+ * lldpad. All settings are sent as one batch and committed together.
+ *
+ * Returns: %TRUE on success, %FALSE if the driver does not support it
+ *   or rejected the configuration.
+ */
+gboolean
+nm_platform_link_set_dcb (NMPlatform *self, int ifindex, gboolean enable, const NMPlatformDcbConfig *config)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	if (!klass->link_set_dcb)
+		return FALSE;
+
+	_LOGD ("link: %s DCB on '%s' (%d)%s", enable ? "enabling" : "disabling",
+	       nm_platform_link_get_name (self, ifindex), ifindex,
+	       config ? " with configuration" : "");
+	return klass->link_set_dcb (self, ifindex, enable, config);
+}
+
+/**
+ * nm_platform_qdisc_get_root:
+ * @self: platform instance
+ * @ifindex: Interface index
+ * @out_qdisc: (out): the root qdisc of the link. Only the kind is
+ *   filled in, the options are left at zero.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_platform_qdisc_get_root (NMPlatform *self, int ifindex, NMPlatformQdisc *out_qdisc)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (out_qdisc, FALSE);
+
+	if (!klass->qdisc_get_root)
+		return FALSE;
+	return klass->qdisc_get_root (self, ifindex, out_qdisc);
+}
+
+/**
+ * nm_platform_qdisc_set_root:
+ * @self: platform instance
+ * @ifindex: Interface index
+ * @qdisc: the qdisc to replace the root qdisc of the link with
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_platform_qdisc_set_root (NMPlatform *self, int ifindex, const NMPlatformQdisc *qdisc)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (qdisc && qdisc->kind[0], FALSE);
+
+	if (!klass->qdisc_set_root)
+		return FALSE;
+
+	_LOGD ("link: setting root qdisc of '%s' (%d) to %s",
+	       nm_platform_link_get_name (self, ifindex), ifindex, qdisc->kind);
+	return klass->qdisc_set_root (self, ifindex, qdisc);
+}
+
+/**
+ * nm_platform_link_set_sriov:
+ * @self: platform instance
+ * @ifindex: Interface index of the physical function
+ * @num_vfs: the number of virtual functions the link should have
+ * @vfs: (allow-none): the configuration of single VFs
+ * @n_vfs: the number of entries in @vfs
+ *
+ * Creates @num_vfs VFs, unless the link already has as many, and
+ * configures @vfs in one request.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_platform_link_set_sriov (NMPlatform *self, int ifindex, guint num_vfs, const NMPlatformSriovVF *vfs, guint n_vfs)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (vfs || !n_vfs, FALSE);
+
+	if (!klass->link_set_sriov)
+		return FALSE;
+
+	_LOGD ("link: setting %u VFs on '%s' (%d), configuring %u of them",
+	       num_vfs, nm_platform_link_get_name (self, ifindex), ifindex, n_vfs);
+	return klass->link_set_sriov (self, ifindex, num_vfs, vfs, n_vfs);
+}
+
 /**
  * nm_platform_link_get_mtu:
  * @self: platform instance
@@ -1861,6 +2325,91 @@ nm_platform_link_vlan_set_egress_map (NMPlatform *self, int ifindex, int from, i
 	return nm_platform_link_vlan_change (self, ifindex, 0, 0, FALSE, NULL, 0, FALSE, &map, 1);
 }
 
+/**
+ * nm_platform_link_bond_change:
+ * @self: platform instance
+ * @ifindex: the ifindex of the bond master
+ * @change: the options to set
+ *
+ * Sets all options of @change on the bond with a single netlink request.
+ * The kernel applies the options in the order of their IFLA_BOND_*
+ * attribute and stops at the first one it rejects, so on failure the
+ * bond may be left partially configured.
+ *
+ * Returns: %TRUE if the kernel accepted all options.
+ */
+gboolean
+nm_platform_link_bond_change (NMPlatform *self, int ifindex, const NMPlatformBondChange *change)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (change, FALSE);
+	g_return_val_if_fail (change->n_arp_ip_targets <= NM_PLATFORM_BOND_MAX_ARP_TARGETS, FALSE);
+
+	if (!klass->link_bond_change)
+		return FALSE;
+
+	_LOGD ("link: change bond %d: options 0x%x, %u arp targets",
+	       ifindex, (unsigned) change->set, change->n_arp_ip_targets);
+	return klass->link_bond_change (self, ifindex, change);
+}
+
+/**
+ * nm_platform_link_bridge_change:
+ * @self: platform instance
+ * @ifindex: the ifindex of the bridge
+ * @change: the bridge options
+ *
+ * Sets all options of @change on the bridge with a single netlink request.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_platform_link_bridge_change (NMPlatform *self, int ifindex, const NMPlatformBridgeChange *change)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (change, FALSE);
+
+	if (!klass->link_bridge_change)
+		return FALSE;
+
+	_LOGD ("link: change bridge %d: stp %u, priority %u, forward-delay %u, hello-time %u, max-age %u, ageing-time %u, multicast-snooping %d",
+	       ifindex, change->stp_state, change->priority, change->forward_delay,
+	       change->hello_time, change->max_age, change->ageing_time,
+	       (int) change->mcast_snooping);
+	return klass->link_bridge_change (self, ifindex, change);
+}
+
+/**
+ * nm_platform_link_bridge_port_change:
+ * @self: platform instance
+ * @ifindex: the ifindex of the bridge port
+ * @change: the port options
+ *
+ * Sets all options of @change on the bridge port with a single netlink
+ * request. The link must already be enslaved to the bridge.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_platform_link_bridge_port_change (NMPlatform *self, int ifindex, const NMPlatformBridgePortChange *change)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (change, FALSE);
+
+	if (!klass->link_bridge_port_change)
+		return FALSE;
+
+	_LOGD ("link: change bridge port %d: priority %u, path-cost %u, hairpin %d",
+	       ifindex, change->priority, change->path_cost, (int) change->hairpin_mode);
+	return klass->link_bridge_port_change (self, ifindex, change);
+}
+
 /**
  * nm_platform_link_gre_add:
  * @self: platform instance
@@ -2151,13 +2700,107 @@ nm_platform_link_macvlan_add (NMPlatform *self,
 }
 
 /**
- * nm_platform_sit_add:
+ * nm_platform_link_add_batch:
  * @self: platform instance
- * @name: name of the new interface
- * @props: interface properties
- * @out_link: on success, the link object
+ * @requests: the links to create
+ * @len: the number of @requests
  *
- * Create a software SIT device.
+ * Creates several VLAN or MACVLAN links at once. Unlike the individual
+ * add functions, the requests are sent to the kernel without waiting for
+ * each reply, and the new links are looked up in the cache once all
+ * replies were received. For each request, @result is set as the
+ * individual add function would return it, and @ifindex to the ifindex
+ * of the created or already existing link. A request for the same name
+ * as an earlier request of the batch is not sent; it gets the result and
+ * ifindex of that earlier request.
+ *
+ * Link-changed signals for the new links are emitted before this
+ * function returns.
+ */
+void
+nm_platform_link_add_batch (NMPlatform *self, NMPlatformLinkAddRequest *requests, guint len)
+{
+	gs_unref_hashtable GHashTable *names = NULL;
+	gs_free guint *dup_of = NULL;
+	guint i, n_pending = 0;
+	gpointer first;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	g_return_if_fail (requests || !len);
+
+	if (len > 1) {
+		names = g_hash_table_new (g_str_hash, g_str_equal);
+		dup_of = g_new (guint, len);
+	}
+
+	for (i = 0; i < len; i++) {
+		NMPlatformLinkAddRequest *req = &requests[i];
+		const NMPlatformLink *pllink;
+
+		g_return_if_fail (req->name);
+		g_return_if_fail (NM_IN_SET (req->type, NM_LINK_TYPE_VLAN, NM_LINK_TYPE_MACVLAN, NM_LINK_TYPE_MACVTAP));
+
+		req->ifindex = 0;
+
+		if (names) {
+			/* a second request for the same link would fail with EEXIST.
+			 * Don't send it, it gets the result of the first one below. */
+			if (g_hash_table_lookup_extended (names, req->name, NULL, &first)) {
+				dup_of[i] = GPOINTER_TO_UINT (first);
+				req->result = NM_PLATFORM_ERROR_EXISTS;
+				continue;
+			}
+			g_hash_table_insert (names, (gpointer) req->name, GUINT_TO_POINTER (i));
+			dup_of[i] = i;
+		}
+
+		req->result = _link_add_check_existing (self, req->name, req->type, &pllink);
+		if (req->result != NM_PLATFORM_ERROR_SUCCESS) {
+			req->ifindex = pllink->ifindex;
+			continue;
+		}
+
+		if (!klass->link_add_batch) {
+			const NMPlatformLink *plink = NULL;
+
+			if (req->type == NM_LINK_TYPE_VLAN)
+				req->result = nm_platform_link_vlan_add (self, req->name, req->parent, req->vlan.id, req->vlan.flags, &plink);
+			else
+				req->result = nm_platform_link_macvlan_add (self, req->name, req->parent, &req->macvlan, &plink);
+			if (plink)
+				req->ifindex = plink->ifindex;
+			continue;
+		}
+		n_pending++;
+	}
+
+	if (n_pending) {
+		_LOGD ("link: adding %u links in a batch", n_pending);
+
+		/* the implementation creates the links of all requests that are still
+		 * at NM_PLATFORM_ERROR_SUCCESS with ifindex 0. */
+		klass->link_add_batch (self, requests, len);
+	}
+
+	if (dup_of) {
+		for (i = 0; i < len; i++) {
+			if (dup_of[i] != i) {
+				requests[i].result = requests[dup_of[i]].result;
+				requests[i].ifindex = requests[dup_of[i]].ifindex;
+			}
+		}
+	}
+}
+
+/**
+ * nm_platform_sit_add:
+ * @self: platform instance
+ * @name: name of the new interface
+ * @props: interface properties
+ * @out_link: on success, the link object
+ *
+ * Create a software SIT device.
  */
 NMPlatformError
 nm_platform_link_sit_add (NMPlatform *self,
@@ -2500,6 +3143,78 @@ nm_platform_ethtool_get_link_speed (NMPlatform *self, const char *ifname, guint3
 	return nmp_utils_ethtool_get_link_speed (ifname, out_speed);
 }
 
+gboolean
+nm_platform_ethtool_get_feature (NMPlatform *self, const char *ifname, NMPlatformEthtoolFeature feature, gboolean *out_enabled)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_get_feature (ifname, feature, out_enabled);
+}
+
+gboolean
+nm_platform_ethtool_set_feature (NMPlatform *self, const char *ifname, NMPlatformEthtoolFeature feature, gboolean enabled)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_set_feature (ifname, feature, enabled);
+}
+
+gboolean
+nm_platform_ethtool_get_ring (NMPlatform *self, const char *ifname, NMPlatformEthtoolRing *out_ring)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_get_ring (ifname, out_ring);
+}
+
+gboolean
+nm_platform_ethtool_set_ring (NMPlatform *self, const char *ifname, const NMPlatformEthtoolRing *ring)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_set_ring (ifname, ring);
+}
+
+gboolean
+nm_platform_ethtool_get_coalesce (NMPlatform *self, const char *ifname, NMPlatformEthtoolCoalesce *out_coalesce)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_get_coalesce (ifname, out_coalesce);
+}
+
+gboolean
+nm_platform_ethtool_set_coalesce (NMPlatform *self, const char *ifname, const NMPlatformEthtoolCoalesce *coalesce)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!nm_platform_netns_push (self, &netns))
+		return FALSE;
+
+	return nmp_utils_ethtool_set_coalesce (ifname, coalesce);
+}
+
 /******************************************************************/
 
 void
@@ -2735,45 +3450,64 @@ nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArray *known
 {
 	GArray *addresses;
 	NMPlatformIP4Address *address;
+	gs_unref_array GArray *batch = NULL;
+	gs_unref_ptrarray GPtrArray *batch_added = NULL;
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	guint i_batch_add;
 	int i;
 
 	_CHECK_SELF (self, klass, FALSE);
 
+	batch = nm_platform_batch_new ();
+
 	/* Delete unknown addresses */
 	addresses = nm_platform_ip4_address_get_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
 		address = &g_array_index (addresses, NMPlatformIP4Address, i);
 
 		if (!array_contains_ip4_address (known_addresses, address, now))
-			nm_platform_ip4_address_delete (self, ifindex, address->address, address->plen, address->peer_address);
+			nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, TRUE, address);
 	}
 	g_array_free (addresses, TRUE);
 
 	if (out_added_addresses)
 		*out_added_addresses = NULL;
 
-	if (!known_addresses)
-		return TRUE;
-
 	/* Add missing addresses */
-	for (i = 0; i < known_addresses->len; i++) {
+	i_batch_add = batch->len;
+	for (i = 0; known_addresses && i < known_addresses->len; i++) {
 		const NMPlatformIP4Address *known_address = &g_array_index (known_addresses, NMPlatformIP4Address, i);
+		NMPlatformBatchEntry *entry;
 		guint32 lifetime, preferred;
 
 		if (!nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
 		                            now, &lifetime, &preferred))
 			continue;
 
-		if (!nm_platform_ip4_address_add (self, ifindex, known_address->address, known_address->plen,
-		                                  known_address->peer_address, lifetime, preferred,
-		                                  0, known_address->label))
+		entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, FALSE, known_address);
+		entry->ip4_address.ifindex = ifindex;
+		entry->ip4_address.timestamp = 0;
+		entry->ip4_address.lifetime = lifetime;
+		entry->ip4_address.preferred = preferred;
+		entry->ip4_address.n_ifa_flags = 0;
+
+		if (!batch_added)
+			batch_added = g_ptr_array_new ();
+		g_ptr_array_add (batch_added, (gpointer) known_address);
+	}
+
+	nm_platform_batch_commit (self, batch);
+
+	/* Failing to delete addresses is ignored. Additions are checked in order, and
+	 * @out_added_addresses contains those up to the first failure. */
+	for (i = 0; batch_added && i < batch_added->len; i++) {
+		if (!g_array_index (batch, NMPlatformBatchEntry, i_batch_add + i).success)
 			return FALSE;
 
 		if (out_added_addresses) {
 			if (!*out_added_addresses)
 				*out_added_addresses = g_ptr_array_new ();
-			g_ptr_array_add (*out_added_addresses, (gpointer) known_address);
+			g_ptr_array_add (*out_added_addresses, batch_added->pdata[i]);
 		}
 	}
 
@@ -2798,9 +3532,13 @@ nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known
 {
 	GArray *addresses;
 	NMPlatformIP6Address *address;
+	gs_unref_array GArray *batch = NULL;
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	guint i_batch_add;
 	int i;
 
+	batch = nm_platform_batch_new ();
+
 	/* Delete unknown addresses */
 	addresses = nm_platform_ip6_address_get_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
@@ -2811,25 +3549,32 @@ nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known
 			continue;
 
 		if (!array_contains_ip6_address (known_addresses, address, now))
-			nm_platform_ip6_address_delete (self, ifindex, address->address, address->plen);
+			nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP6_ADDRESS, TRUE, address);
 	}
 	g_array_free (addresses, TRUE);
 
-	if (!known_addresses)
-		return TRUE;
-
 	/* Add missing addresses */
-	for (i = 0; i < known_addresses->len; i++) {
+	i_batch_add = batch->len;
+	for (i = 0; known_addresses && i < known_addresses->len; i++) {
 		const NMPlatformIP6Address *known_address = &g_array_index (known_addresses, NMPlatformIP6Address, i);
+		NMPlatformBatchEntry *entry;
 		guint32 lifetime, preferred;
 
 		if (!nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
 		                            now, &lifetime, &preferred))
 			continue;
 
-		if (!nm_platform_ip6_address_add (self, ifindex, known_address->address,
-		                                  known_address->plen, known_address->peer_address,
-		                                  lifetime, preferred, known_address->n_ifa_flags))
+		entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP6_ADDRESS, FALSE, known_address);
+		entry->ip6_address.ifindex = ifindex;
+		entry->ip6_address.timestamp = 0;
+		entry->ip6_address.lifetime = lifetime;
+		entry->ip6_address.preferred = preferred;
+	}
+
+	nm_platform_batch_commit (self, batch);
+
+	for (i = i_batch_add; i < batch->len; i++) {
+		if (!g_array_index (batch, NMPlatformBatchEntry, i).success)
 			return FALSE;
 	}
 
@@ -2867,6 +3612,98 @@ nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRoute
 	return klass->ip6_route_get_all (self, ifindex, flags);
 }
 
+/******************************************************************/
+
+/**
+ * nm_platform_cache_get_generation:
+ * @self: platform instance
+ *
+ * Returns: a counter that changes whenever the platform's cache of
+ *   addresses and routes changes. A view returned by one of the
+ *   nm_platform_*_get_view() functions stays valid as long as the
+ *   generation does not change.
+ */
+guint64
+nm_platform_cache_get_generation (NMPlatform *self)
+{
+	_CHECK_SELF (self, klass, 0);
+
+	return klass->cache_get_generation (self);
+}
+
+static gconstpointer
+_object_get_view (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (out_len, NULL);
+
+	if (!NM_FLAGS_ANY (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT))
+		flags |= NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT;
+
+	return klass->object_get_view (self, obj_type, ifindex, flags, out_len);
+}
+
+/**
+ * nm_platform_ip4_address_get_view:
+ * @self: platform instance
+ * @ifindex: the ifindex of the addresses
+ * @out_len: (out): the number of addresses
+ *
+ * Like nm_platform_ip4_address_get_all(), but returns the platform's own
+ * array of addresses without copying it. The result is read-only and
+ * only valid as long as nm_platform_cache_get_generation() stays the same.
+ * In practice that means, until the next call into the platform that
+ * might process events or modify addresses and routes.
+ *
+ * Returns: (transfer none): the addresses. Can be %NULL if @out_len is zero.
+ */
+const NMPlatformIP4Address *const *
+nm_platform_ip4_address_get_view (NMPlatform *self, int ifindex, guint *out_len)
+{
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	return _object_get_view (self, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE, out_len);
+}
+
+const NMPlatformIP6Address *const *
+nm_platform_ip6_address_get_view (NMPlatform *self, int ifindex, guint *out_len)
+{
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	return _object_get_view (self, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE, out_len);
+}
+
+/**
+ * nm_platform_ip4_route_get_view:
+ * @self: platform instance
+ * @ifindex: the ifindex of the routes
+ * @flags: which routes to return. %NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL
+ *   is ignored, the view always contains kernel routes and the caller
+ *   must skip them itself, if needed.
+ * @out_len: (out): the number of routes
+ *
+ * Like nm_platform_ip4_route_get_all(), but without copying. The same
+ * rules as for nm_platform_ip4_address_get_view() apply.
+ *
+ * Returns: (transfer none): the routes. Can be %NULL if @out_len is zero.
+ */
+const NMPlatformIP4Route *const *
+nm_platform_ip4_route_get_view (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)
+{
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	return _object_get_view (self, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, flags, out_len);
+}
+
+const NMPlatformIP6Route *const *
+nm_platform_ip6_route_get_view (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)
+{
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	return _object_get_view (self, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, flags, out_len);
+}
+
 /**
  * nm_platform_ip4_route_add:
  * @self:
@@ -2951,6 +3788,58 @@ nm_platform_ip6_route_add (NMPlatform *self,
 	return klass->ip6_route_add (self, ifindex, source, network, plen, gateway, metric, mss);
 }
 
+/**
+ * nm_platform_ip4_route_add_multipath:
+ * @self:
+ * @source:
+ * @network:
+ * @plen:
+ * @metric:
+ * @mss:
+ * @nexthops: the nexthops of the route, at least two.
+ * @n_nexthops: the number of @nexthops.
+ *
+ * Adds or replaces an IPv4 route that spreads the traffic over all
+ * @nexthops (equal-cost multipath). The route is identified in the cache
+ * by the ifindex of the first nexthop, so it can be deleted with
+ * nm_platform_ip4_route_delete() for that ifindex.
+ *
+ * Returns: %TRUE in case of success.
+ */
+gboolean
+nm_platform_ip4_route_add_multipath (NMPlatform *self, NMIPConfigSource source,
+                                     in_addr_t network, guint8 plen, guint32 metric, guint32 mss,
+                                     const NMPlatformIP4RouteNexthop *nexthops, guint n_nexthops)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (plen <= 32, FALSE);
+	g_return_val_if_fail (nexthops && n_nexthops >= 2, FALSE);
+
+	if (!klass->ip4_route_add_multipath)
+		return FALSE;
+
+	if (_LOGD_ENABLED ()) {
+		char buf[NM_UTILS_INET_ADDRSTRLEN];
+		gs_free char *str_hops = NULL;
+		GString *str;
+		guint i;
+
+		str = g_string_new (NULL);
+		for (i = 0; i < n_nexthops; i++) {
+			g_string_append_printf (str, " nexthop %d", nexthops[i].ifindex);
+			if (nexthops[i].gateway)
+				g_string_append_printf (str, " via %s", nm_utils_inet4_ntop (nexthops[i].gateway, buf));
+			g_string_append_printf (str, " weight %u", (guint) MAX (nexthops[i].weight, 1));
+		}
+		str_hops = g_string_free (str, FALSE);
+
+		_LOGD ("route: adding or updating IPv4 multipath route %s/%d, metric=%"G_GUINT32_FORMAT", mss=%"G_GUINT32_FORMAT",%s",
+		       nm_utils_inet4_ntop (network, NULL), plen, metric, mss, str_hops);
+	}
+	return klass->ip4_route_add_multipath (self, source, network, plen, metric, mss, nexthops, n_nexthops);
+}
+
 gboolean
 nm_platform_ip4_route_delete (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric)
 {
@@ -2993,6 +3882,326 @@ nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr networ
 	return klass->ip6_route_get (self, ifindex, network, plen, metric);
 }
 
+/**
+ * nm_platform_ip4_route_lookup_best:
+ * @self: platform instance
+ * @ifindex: if positive, only consider routes on this interface.
+ * @host: the destination address
+ *
+ * Does a longest-prefix-match lookup of @host among the known routes.
+ *
+ * Returns: the route with the longest prefix containing @host. If there
+ *   are several routes with that prefix, the one with the lowest metric.
+ *   %NULL if no route matches.
+ */
+const NMPlatformIP4Route *
+nm_platform_ip4_route_lookup_best (NMPlatform *self, int ifindex, in_addr_t host)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	return klass->ip4_route_lookup_best (self, ifindex, host);
+}
+
+/**
+ * nm_platform_ip6_route_lookup_best:
+ * @self: platform instance
+ * @ifindex: if positive, only consider routes on this interface.
+ * @host: the destination address
+ *
+ * Like nm_platform_ip4_route_lookup_best(), but for IPv6.
+ */
+const NMPlatformIP6Route *
+nm_platform_ip6_route_lookup_best (NMPlatform *self, int ifindex, const struct in6_addr *host)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (host, NULL);
+
+	return klass->ip6_route_lookup_best (self, ifindex, host);
+}
+
+/******************************************************************/
+
+/**
+ * nm_platform_batch_new:
+ *
+ * Returns: a new, empty #GArray of #NMPlatformBatchEntry to be filled with
+ *   nm_platform_batch_append() and applied with nm_platform_batch_commit().
+ */
+GArray *
+nm_platform_batch_new (void)
+{
+	return g_array_new (FALSE, FALSE, sizeof (NMPlatformBatchEntry));
+}
+
+/**
+ * nm_platform_batch_append:
+ * @batch: the batch, as created by nm_platform_batch_new()
+ * @obj_type: the type of @obj. Only addresses and routes are supported.
+ * @is_delete: whether to queue a deletion or an addition of @obj.
+ * @obj: the NMPlatformIP4Address, NMPlatformIP6Address, NMPlatformIP4Route
+ *   or NMPlatformIP6Route according to @obj_type.
+ *
+ * Returns: the appended entry. It is only valid until the next modification
+ *   of @batch.
+ */
+NMPlatformBatchEntry *
+nm_platform_batch_append (GArray *batch, NMPObjectType obj_type, gboolean is_delete, gconstpointer obj)
+{
+	NMPlatformBatchEntry *entry;
+
+	g_return_val_if_fail (batch, NULL);
+	g_return_val_if_fail (obj, NULL);
+
+	g_array_set_size (batch, batch->len + 1);
+	entry = &g_array_index (batch, NMPlatformBatchEntry, batch->len - 1);
+
+	memset (entry, 0, sizeof (*entry));
+	entry->obj_type = obj_type;
+	entry->is_delete = !!is_delete;
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		entry->ip4_address = *((const NMPlatformIP4Address *) obj);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		entry->ip6_address = *((const NMPlatformIP6Address *) obj);
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		entry->ip4_route = *((const NMPlatformIP4Route *) obj);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		entry->ip6_route = *((const NMPlatformIP6Route *) obj);
+		break;
+	default:
+		g_array_set_size (batch, batch->len - 1);
+		g_return_val_if_reached (NULL);
+	}
+	return entry;
+}
+
+static void
+_batch_entry_log (NMPlatform *self, const NMPlatformBatchEntry *entry)
+{
+	char str_dev[TO_STRING_DEV_BUF_SIZE];
+
+	switch (entry->obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		if (entry->is_delete) {
+			_LOGD ("address: deleting IPv4 address %s/%d, ifindex %d%s (batched)",
+			       nm_utils_inet4_ntop (entry->ip4_address.address, NULL), entry->ip4_address.plen,
+			       entry->ip4_address.ifindex,
+			       _to_string_dev (self, entry->ip4_address.ifindex, str_dev, sizeof (str_dev)));
+		} else {
+			_LOGD ("address: adding or updating IPv4 address: %s (batched)",
+			       nm_platform_ip4_address_to_string (&entry->ip4_address, NULL, 0));
+		}
+		break;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		if (entry->is_delete) {
+			_LOGD ("address: deleting IPv6 address %s/%d, ifindex %d%s (batched)",
+			       nm_utils_inet6_ntop (&entry->ip6_address.address, NULL), entry->ip6_address.plen,
+			       entry->ip6_address.ifindex,
+			       _to_string_dev (self, entry->ip6_address.ifindex, str_dev, sizeof (str_dev)));
+		} else {
+			_LOGD ("address: adding or updating IPv6 address: %s (batched)",
+			       nm_platform_ip6_address_to_string (&entry->ip6_address, NULL, 0));
+		}
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (entry->is_delete) {
+			_LOGD ("route: deleting IPv4 route %s/%d, metric=%"G_GUINT32_FORMAT", ifindex %d%s (batched)",
+			       nm_utils_inet4_ntop (entry->ip4_route.network, NULL), entry->ip4_route.plen,
+			       entry->ip4_route.metric, entry->ip4_route.ifindex,
+			       _to_string_dev (self, entry->ip4_route.ifindex, str_dev, sizeof (str_dev)));
+		} else {
+			_LOGD ("route: adding or updating IPv4 route: %s (batched)",
+			       nm_platform_ip4_route_to_string (&entry->ip4_route, NULL, 0));
+		}
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (entry->is_delete) {
+			_LOGD ("route: deleting IPv6 route %s/%d, metric=%"G_GUINT32_FORMAT", ifindex %d%s (batched)",
+			       nm_utils_inet6_ntop (&entry->ip6_route.network, NULL), entry->ip6_route.plen,
+			       entry->ip6_route.metric, entry->ip6_route.ifindex,
+			       _to_string_dev (self, entry->ip6_route.ifindex, str_dev, sizeof (str_dev)));
+		} else {
+			_LOGD ("route: adding or updating IPv6 route: %s (batched)",
+			       nm_platform_ip6_route_to_string (&entry->ip6_route, NULL, 0));
+		}
+		break;
+	default:
+		g_return_if_reached ();
+	}
+}
+
+/* The same checks as nm_platform_ip4_address_add() and friends do on
+ * their arguments. */
+static gboolean
+_batch_entry_validate (const NMPlatformBatchEntry *entry)
+{
+	switch (entry->obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		g_return_val_if_fail (entry->ip4_address.ifindex > 0, FALSE);
+		g_return_val_if_fail (entry->ip4_address.plen <= 32, FALSE);
+		if (entry->is_delete)
+			return TRUE;
+		g_return_val_if_fail (entry->ip4_address.lifetime > 0, FALSE);
+		g_return_val_if_fail (entry->ip4_address.preferred <= entry->ip4_address.lifetime, FALSE);
+		g_return_val_if_fail (memchr (entry->ip4_address.label, '\0', sizeof (entry->ip4_address.label)), FALSE);
+		return TRUE;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		g_return_val_if_fail (entry->ip6_address.ifindex > 0, FALSE);
+		g_return_val_if_fail (entry->ip6_address.plen <= 128, FALSE);
+		if (entry->is_delete)
+			return TRUE;
+		g_return_val_if_fail (entry->ip6_address.lifetime > 0, FALSE);
+		g_return_val_if_fail (entry->ip6_address.preferred <= entry->ip6_address.lifetime, FALSE);
+		return TRUE;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (!entry->is_delete)
+			g_return_val_if_fail (entry->ip4_route.plen <= 32, FALSE);
+		return TRUE;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (!entry->is_delete)
+			g_return_val_if_fail (entry->ip6_route.plen <= 128, FALSE);
+		return TRUE;
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+}
+
+static gboolean
+_batch_entry_commit_one (NMPlatform *self, NMPlatformClass *klass, const NMPlatformBatchEntry *entry)
+{
+	switch (entry->obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		if (entry->is_delete) {
+			return klass->ip4_address_delete (self, entry->ip4_address.ifindex, entry->ip4_address.address,
+			                                  entry->ip4_address.plen, entry->ip4_address.peer_address);
+		}
+		return klass->ip4_address_add (self, entry->ip4_address.ifindex, entry->ip4_address.address,
+		                               entry->ip4_address.plen, entry->ip4_address.peer_address,
+		                               entry->ip4_address.lifetime, entry->ip4_address.preferred,
+		                               entry->ip4_address.n_ifa_flags, entry->ip4_address.label);
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		if (entry->is_delete) {
+			return klass->ip6_address_delete (self, entry->ip6_address.ifindex, entry->ip6_address.address,
+			                                  entry->ip6_address.plen);
+		}
+		return klass->ip6_address_add (self, entry->ip6_address.ifindex, entry->ip6_address.address,
+		                               entry->ip6_address.plen, entry->ip6_address.peer_address,
+		                               entry->ip6_address.lifetime, entry->ip6_address.preferred,
+		                               entry->ip6_address.n_ifa_flags);
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (entry->is_delete) {
+			return klass->ip4_route_delete (self, entry->ip4_route.ifindex, entry->ip4_route.network,
+			                                entry->ip4_route.plen, entry->ip4_route.metric);
+		}
+		return klass->ip4_route_add (self, entry->ip4_route.ifindex, entry->ip4_route.rt_source,
+		                             entry->ip4_route.network, entry->ip4_route.plen,
+		                             entry->ip4_route.gateway, entry->ip4_route.pref_src,
+		                             entry->ip4_route.metric, entry->ip4_route.mss);
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (entry->is_delete) {
+			return klass->ip6_route_delete (self, entry->ip6_route.ifindex, entry->ip6_route.network,
+			                                entry->ip6_route.plen, entry->ip6_route.metric);
+		}
+		return klass->ip6_route_add (self, entry->ip6_route.ifindex, entry->ip6_route.rt_source,
+		                             entry->ip6_route.network, entry->ip6_route.plen,
+		                             entry->ip6_route.gateway, entry->ip6_route.metric,
+		                             entry->ip6_route.mss);
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+}
+
+static void
+_batch_commit_entries (NMPlatform *self, NMPlatformClass *klass, NMPlatformBatchEntry *entries, guint len)
+{
+	guint i;
+
+	if (klass->batch_commit)
+		klass->batch_commit (self, entries, len);
+	else {
+		for (i = 0; i < len; i++)
+			entries[i].success = _batch_entry_commit_one (self, klass, &entries[i]);
+	}
+}
+
+/**
+ * nm_platform_batch_commit:
+ * @self: platform instance
+ * @batch: (allow-none): the #GArray of #NMPlatformBatchEntry to apply.
+ *
+ * Applies all queued changes of @batch in order. Contrary to calling
+ * nm_platform_ip4_route_add() and friends one-by-one, the platform
+ * implementation may send all requests at once and only wait for the
+ * replies afterwards. The result for each entry is stored in its
+ * @success field. Entries with arguments that the single calls would
+ * reject are not committed and fail.
+ *
+ * Returns: %TRUE if all entries succeeded.
+ */
+gboolean
+nm_platform_batch_commit (NMPlatform *self, GArray *batch)
+{
+	NMPlatformBatchEntry *entries;
+	gs_unref_array GArray *valid = NULL;
+	gs_free guint *valid_idx = NULL;
+	gboolean success = TRUE;
+	guint i;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!batch || batch->len == 0)
+		return TRUE;
+
+	entries = &g_array_index (batch, NMPlatformBatchEntry, 0);
+
+	for (i = 0; i < batch->len; i++) {
+		entries[i].success = _batch_entry_validate (&entries[i]);
+		if (!entries[i].success && !valid)
+			valid = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformBatchEntry), batch->len);
+	}
+
+	if (valid) {
+		/* commit only the valid entries, and copy their results back. */
+		valid_idx = g_new (guint, batch->len);
+		for (i = 0; i < batch->len; i++) {
+			if (entries[i].success) {
+				valid_idx[valid->len] = i;
+				g_array_append_val (valid, entries[i]);
+			}
+		}
+		entries = valid->len ? &g_array_index (valid, NMPlatformBatchEntry, 0) : NULL;
+	}
+
+	if (entries) {
+		guint len = valid ? valid->len : batch->len;
+
+		if (_LOGD_ENABLED ()) {
+			for (i = 0; i < len; i++)
+				_batch_entry_log (self, &entries[i]);
+		}
+		_batch_commit_entries (self, klass, entries, len);
+	}
+
+	if (valid) {
+		for (i = 0; i < valid->len; i++)
+			g_array_index (batch, NMPlatformBatchEntry, valid_idx[i]).success = g_array_index (valid, NMPlatformBatchEntry, i).success;
+		entries = &g_array_index (batch, NMPlatformBatchEntry, 0);
+	}
+
+	for (i = 0; i < batch->len; i++) {
+		if (!entries[i].success) {
+			success = FALSE;
+			break;
+		}
+	}
+	return success;
+}
+
 /******************************************************************/
 
 const char *
@@ -3619,6 +4828,27 @@ nm_platform_ip6_address_to_string (const NMPlatformIP6Address *address, char *bu
  *
  * Returns: a string representation of the route.
  */
+static const char *
+_route_tuning_to_string (const NMPlatformIPRoute *route, char *buf, gsize len)
+{
+	char *b = buf;
+
+	buf[0] = '\0';
+	if (route->window)
+		nm_utils_strbuf_append (&b, &len, " window %"G_GUINT32_FORMAT, route->window);
+	if (route->initcwnd)
+		nm_utils_strbuf_append (&b, &len, " initcwnd %"G_GUINT32_FORMAT, route->initcwnd);
+	if (route->initrwnd)
+		nm_utils_strbuf_append (&b, &len, " initrwnd %"G_GUINT32_FORMAT, route->initrwnd);
+	if (route->rtt)
+		nm_utils_strbuf_append (&b, &len, " rtt %"G_GUINT32_FORMAT"ms", route->rtt);
+	if (route->mtu || route->lock_mtu)
+		nm_utils_strbuf_append (&b, &len, " mtu %s%"G_GUINT32_FORMAT, route->lock_mtu ? "lock " : "", route->mtu);
+	if (route->congctl)
+		nm_utils_strbuf_append (&b, &len, " congctl %s", route->congctl);
+	return buf;
+}
+
 const char *
 nm_platform_ip4_route_to_string (const NMPlatformIP4Route *route, char *buf, gsize len)
 {
@@ -3626,6 +4856,7 @@ nm_platform_ip4_route_to_string (const NMPlatformIP4Route *route, char *buf, gsi
 	char s_pref_src[INET_ADDRSTRLEN];
 	char str_dev[TO_STRING_DEV_BUF_SIZE];
 	char str_scope[30], s_source[50];
+	char str_tuning[200];
 
 	if (!nm_utils_to_string_buffer_init_null (route, &buf, &len))
 		return buf;
@@ -3641,6 +4872,7 @@ nm_platform_ip4_route_to_string (const NMPlatformIP4Route *route, char *buf, gsi
 	            "%s"
 	            " metric %"G_GUINT32_FORMAT
 	            " mss %"G_GUINT32_FORMAT
+	            "%s" /* tuning */
 	            " src %s" /* source */
 	            "%s" /* cloned */
 	            "%s%s" /* scope */
@@ -3652,6 +4884,7 @@ nm_platform_ip4_route_to_string (const NMPlatformIP4Route *route, char *buf, gsi
 	            str_dev,
 	            route->metric,
 	            route->mss,
+	            _route_tuning_to_string ((const NMPlatformIPRoute *) route, str_tuning, sizeof (str_tuning)),
 	            nmp_utils_ip_config_source_to_string (route->rt_source, s_source, sizeof (s_source)),
 	            route->rt_cloned ? " cloned" : "",
 	            route->scope_inv ? " scope " : "",
@@ -3678,6 +4911,7 @@ nm_platform_ip6_route_to_string (const NMPlatformIP6Route *route, char *buf, gsi
 {
 	char s_network[INET6_ADDRSTRLEN], s_gateway[INET6_ADDRSTRLEN];
 	char str_dev[TO_STRING_DEV_BUF_SIZE], s_source[50];
+	char str_tuning[200];
 
 	if (!nm_utils_to_string_buffer_init_null (route, &buf, &len))
 		return buf;
@@ -3693,6 +4927,7 @@ nm_platform_ip6_route_to_string (const NMPlatformIP6Route *route, char *buf, gsi
 	            "%s"
 	            " metric %"G_GUINT32_FORMAT
 	            " mss %"G_GUINT32_FORMAT
+	            "%s" /* tuning */
 	            " src %s" /* source */
 	            "%s" /* cloned */
 	            "",
@@ -3702,6 +4937,7 @@ nm_platform_ip6_route_to_string (const NMPlatformIP6Route *route, char *buf, gsi
 	            str_dev,
 	            route->metric,
 	            route->mss,
+	            _route_tuning_to_string ((const NMPlatformIPRoute *) route, str_tuning, sizeof (str_tuning)),
 	            nmp_utils_ip_config_source_to_string (route->rt_source, s_source, sizeof (s_source)),
 	            route->rt_cloned ? " cloned" : "");
 	return buf;
@@ -3794,6 +5030,8 @@ nm_platform_link_cmp (const NMPlatformLink *a, const NMPlatformLink *b)
 	_CMP_FIELD (a, b, n_ifi_flags);
 	_CMP_FIELD (a, b, connected);
 	_CMP_FIELD (a, b, mtu);
+	_CMP_FIELD (a, b, num_rx_queues);
+	_CMP_FIELD (a, b, num_tx_queues);
 	_CMP_FIELD_BOOL (a, b, initialized);
 	_CMP_FIELD (a, b, arptype);
 	_CMP_FIELD (a, b, addr.len);
@@ -3971,6 +5209,13 @@ nm_platform_ip4_route_cmp (const NMPlatformIP4Route *a, const NMPlatformIP4Route
 	_CMP_FIELD (a, b, scope_inv);
 	_CMP_FIELD (a, b, pref_src);
 	_CMP_FIELD (a, b, rt_cloned);
+	_CMP_FIELD (a, b, window);
+	_CMP_FIELD (a, b, initcwnd);
+	_CMP_FIELD (a, b, initrwnd);
+	_CMP_FIELD (a, b, rtt);
+	_CMP_FIELD (a, b, mtu);
+	_CMP_FIELD (a, b, lock_mtu);
+	_CMP_FIELD_STR_INTERNED (a, b, congctl);
 	return 0;
 }
 
@@ -3986,6 +5231,13 @@ nm_platform_ip6_route_cmp (const NMPlatformIP6Route *a, const NMPlatformIP6Route
 	_CMP_FIELD (a, b, rt_source);
 	_CMP_FIELD (a, b, mss);
 	_CMP_FIELD (a, b, rt_cloned);
+	_CMP_FIELD (a, b, window);
+	_CMP_FIELD (a, b, initcwnd);
+	_CMP_FIELD (a, b, initrwnd);
+	_CMP_FIELD (a, b, rtt);
+	_CMP_FIELD (a, b, mtu);
+	_CMP_FIELD (a, b, lock_mtu);
+	_CMP_FIELD_STR_INTERNED (a, b, congctl);
 	return 0;
 }
 
@@ -4056,33 +5308,182 @@ nm_platform_signal_change_type_to_string (NMPlatformSignalChangeType change_type
 }
 
 static void
-log_link (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformLink *device, NMPlatformSignalChangeType change_type, gpointer user_data)
+_changes_batch_entry_clear (gpointer data)
+{
+	NMPlatformChangesBatchEntry *entry = data;
+
+	if (entry->obj)
+		nmp_object_unref ((NMPObject *) entry->obj);
+}
+
+/* Whether @obj, added after @old_obj with the same ID was removed, is
+ * a different object, like a new link that reuses the ifindex. */
+static gboolean
+_changes_batch_is_replacement (const NMPObject *old_obj, int old_ifindex, const NMPObject *obj, int ifindex)
+{
+	if (old_ifindex != ifindex)
+		return TRUE;
+	if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_LINK) {
+		return    old_obj->link.type != obj->link.type
+		       || !nm_streq0 (old_obj->link.kind, obj->link.kind);
+	}
+	return FALSE;
+}
+
+static void
+_changes_batch_append (NMPlatform *self, NMPObjectType obj_type, int ifindex, const NMPlatformObject *object, NMPlatformSignalChangeType change_type)
 {
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	NMPlatformChangesBatchEntry *entry;
+	NMPObject *obj;
+	gpointer idx;
+
+	if (!g_signal_has_handler_pending (self, signals[NM_PLATFORM_SIGNAL_ID_CHANGES_BATCH], 0, FALSE))
+		return;
+
+	if (!priv->changes_batch.entries) {
+		priv->changes_batch.entries = g_array_new (FALSE, FALSE, sizeof (NMPlatformChangesBatchEntry));
+		g_array_set_clear_func (priv->changes_batch.entries, _changes_batch_entry_clear);
+		if (!priv->changes_batch.idx)
+			priv->changes_batch.idx = g_hash_table_new ((GHashFunc) nmp_object_id_hash, (GEqualFunc) nmp_object_id_equal);
+	}
 
+	obj = nmp_object_new (obj_type, object);
+
+	idx = g_hash_table_lookup (priv->changes_batch.idx, obj);
+	if (idx) {
+		entry = &g_array_index (priv->changes_batch.entries, NMPlatformChangesBatchEntry, GPOINTER_TO_UINT (idx) - 1);
+
+		nm_assert (entry->obj && nmp_object_id_equal (entry->obj, obj));
+
+		switch (entry->change_type) {
+		case NM_PLATFORM_SIGNAL_ADDED:
+			if (change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+				/* the object came and went within the same batch. Drop it. */
+				g_hash_table_remove (priv->changes_batch.idx, entry->obj);
+				nmp_object_unref ((NMPObject *) entry->obj);
+				nmp_object_unref (obj);
+				entry->obj = NULL;
+				entry->change_type = NM_PLATFORM_SIGNAL_NONE;
+				return;
+			}
+			change_type = NM_PLATFORM_SIGNAL_ADDED;
+			break;
+		case NM_PLATFORM_SIGNAL_REMOVED:
+			if (change_type != NM_PLATFORM_SIGNAL_ADDED)
+				break;
+			if (_changes_batch_is_replacement (entry->obj, entry->ifindex, obj, ifindex)) {
+				/* keep the removal of the old object, and add the new
+				 * one as separate entry. */
+				g_hash_table_remove (priv->changes_batch.idx, entry->obj);
+				goto append;
+			}
+			change_type = NM_PLATFORM_SIGNAL_CHANGED;
+			break;
+		default:
+			break;
+		}
+
+		nmp_object_unref ((NMPObject *) entry->obj);
+		entry->obj = obj;
+		entry->change_type = change_type;
+		entry->ifindex = ifindex;
+		g_hash_table_replace (priv->changes_batch.idx, obj, idx);
+		return;
+	}
+
+append:
+	g_array_set_size (priv->changes_batch.entries, priv->changes_batch.entries->len + 1);
+	entry = &g_array_index (priv->changes_batch.entries, NMPlatformChangesBatchEntry, priv->changes_batch.entries->len - 1);
+	entry->obj_type = obj_type;
+	entry->change_type = change_type;
+	entry->ifindex = ifindex;
+	entry->obj = obj;
+	g_hash_table_insert (priv->changes_batch.idx, obj, GUINT_TO_POINTER (priv->changes_batch.entries->len));
+}
+
+/**
+ * _nm_platform_changes_batch_flush:
+ * @self: the #NMPlatform instance
+ *
+ * Emits NM_PLATFORM_SIGNAL_CHANGES_BATCH with all changes recorded since
+ * the last flush. To be called by the platform implementation whenever it
+ * finished processing a set of events. Does nothing, if there are no
+ * pending changes.
+ */
+void
+_nm_platform_changes_batch_flush (NMPlatform *self)
+{
+	NMPlatformPrivate *priv;
+	gs_unref_array GArray *entries = NULL;
+	NMPlatformChangesBatchEntry *entry;
+	guint i, j;
+
+	g_return_if_fail (NM_IS_PLATFORM (self));
+
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+
+	if (!priv->changes_batch.entries)
+		return;
+
+	/* take ownership of the array. Signal handlers might call back into
+	 * NMPlatform which starts recording a new batch. */
+	entries = priv->changes_batch.entries;
+	priv->changes_batch.entries = NULL;
+	g_hash_table_remove_all (priv->changes_batch.idx);
+
+	/* compact the array by removing dropped entries. */
+	for (i = 0, j = 0; i < entries->len; i++) {
+		entry = &g_array_index (entries, NMPlatformChangesBatchEntry, i);
+		if (entry->change_type == NM_PLATFORM_SIGNAL_NONE)
+			continue;
+		if (i != j) {
+			g_array_index (entries, NMPlatformChangesBatchEntry, j) = *entry;
+			entry->obj = NULL;
+		}
+		j++;
+	}
+	g_array_set_size (entries, j);
+
+	if (entries->len == 0)
+		return;
+
+	_LOGD ("signal: changes-batch with %u entries", entries->len);
+	g_signal_emit (self, signals[NM_PLATFORM_SIGNAL_ID_CHANGES_BATCH], 0, entries);
+}
+
+static void
+log_link (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformLink *device, NMPlatformSignalChangeType change_type, gpointer user_data)
+{
+	_changes_batch_append (self, obj_type, ifindex, (const NMPlatformObject *) device, change_type);
 	_LOGD ("signal: link %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_link_to_string (device, NULL, 0));
 }
 
 static void
 log_ip4_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_changes_batch_append (self, obj_type, ifindex, (const NMPlatformObject *) address, change_type);
 	_LOGD ("signal: address 4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_address_to_string (address, NULL, 0));
 }
 
 static void
 log_ip6_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_changes_batch_append (self, obj_type, ifindex, (const NMPlatformObject *) address, change_type);
 	_LOGD ("signal: address 6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_address_to_string (address, NULL, 0));
 }
 
 static void
 log_ip4_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_changes_batch_append (self, obj_type, ifindex, (const NMPlatformObject *) route, change_type);
 	_LOGD ("signal: route   4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_route_to_string (route, NULL, 0));
 }
 
 static void
 log_ip6_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_changes_batch_append (self, obj_type, ifindex, (const NMPlatformObject *) route, change_type);
 	_LOGD ("signal: route   6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_route_to_string (route, NULL, 0));
 }
 
@@ -4178,6 +5579,54 @@ _vtr_v6_route_delete_default (NMPlatform *self, int ifindex, guint32 metric)
 	return nm_platform_ip6_route_delete (self, ifindex, in6addr_any, 0, metric);
 }
 
+static NMPlatformBatchEntry *
+_vtr_v4_batch_route_add (GArray *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric)
+{
+	NMPlatformBatchEntry *entry;
+
+	entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ROUTE, FALSE, route);
+	if (ifindex > 0)
+		entry->ip4_route.ifindex = ifindex;
+	if (metric >= 0)
+		entry->ip4_route.metric = metric;
+	return entry;
+}
+
+static NMPlatformBatchEntry *
+_vtr_v6_batch_route_add (GArray *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric)
+{
+	NMPlatformBatchEntry *entry;
+
+	entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP6_ROUTE, FALSE, route);
+	if (ifindex > 0)
+		entry->ip6_route.ifindex = ifindex;
+	if (metric >= 0)
+		entry->ip6_route.metric = metric;
+	return entry;
+}
+
+static NMPlatformBatchEntry *
+_vtr_v4_batch_route_delete (GArray *batch, int ifindex, const NMPlatformIPXRoute *route)
+{
+	NMPlatformBatchEntry *entry;
+
+	entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ROUTE, TRUE, route);
+	if (ifindex > 0)
+		entry->ip4_route.ifindex = ifindex;
+	return entry;
+}
+
+static NMPlatformBatchEntry *
+_vtr_v6_batch_route_delete (GArray *batch, int ifindex, const NMPlatformIPXRoute *route)
+{
+	NMPlatformBatchEntry *entry;
+
+	entry = nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP6_ROUTE, TRUE, route);
+	if (ifindex > 0)
+		entry->ip6_route.ifindex = ifindex;
+	return entry;
+}
+
 /******************************************************************/
 
 const NMPlatformVTableRoute nm_platform_vtable_route_v4 = {
@@ -4187,10 +5636,13 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v4 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip4_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip4_route_to_string,
 	.route_get_all                  = nm_platform_ip4_route_get_all,
+	.route_get_view                 = (const NMPlatformIPXRoute *const *(*) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)) nm_platform_ip4_route_get_view,
 	.route_add                      = _vtr_v4_route_add,
 	.route_delete                   = _vtr_v4_route_delete,
 	.route_delete_default           = _vtr_v4_route_delete_default,
 	.metric_normalize               = _vtr_v4_metric_normalize,
+	.batch_route_add                = _vtr_v4_batch_route_add,
+	.batch_route_delete             = _vtr_v4_batch_route_delete,
 };
 
 const NMPlatformVTableRoute nm_platform_vtable_route_v6 = {
@@ -4200,10 +5652,13 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v6 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip6_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip6_route_to_string,
 	.route_get_all                  = nm_platform_ip6_route_get_all,
+	.route_get_view                 = (const NMPlatformIPXRoute *const *(*) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len)) nm_platform_ip6_route_get_view,
 	.route_add                      = _vtr_v6_route_add,
 	.route_delete                   = _vtr_v6_route_delete,
 	.route_delete_default           = _vtr_v6_route_delete_default,
 	.metric_normalize               = nm_utils_ip6_route_metric_normalize,
+	.batch_route_add                = _vtr_v6_batch_route_add,
+	.batch_route_delete             = _vtr_v6_batch_route_delete,
 };
 
 /******************************************************************/
@@ -4257,7 +5712,12 @@ static void
 finalize (GObject *object)
 {
 	NMPlatform *self = NM_PLATFORM (object);
+	NMPlatformPrivate *priv =  NM_PLATFORM_GET_PRIVATE (self);
 
+	g_clear_pointer (&priv->changes_batch.entries, g_array_unref);
+	g_clear_pointer (&priv->changes_batch.idx, g_hash_table_unref);
+	nm_clear_g_source (&priv->link_statistics.timeout_id);
+	g_clear_pointer (&priv->link_statistics.subscriptions, g_hash_table_unref);
 	g_clear_object (&self->_netns);
 }
 
@@ -4307,4 +5767,12 @@ nm_platform_class_init (NMPlatformClass *platform_class)
 	SIGNAL (NM_PLATFORM_SIGNAL_ID_IP6_ADDRESS, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, log_ip6_address);
 	SIGNAL (NM_PLATFORM_SIGNAL_ID_IP4_ROUTE,   NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED,   log_ip4_route);
 	SIGNAL (NM_PLATFORM_SIGNAL_ID_IP6_ROUTE,   NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED,   log_ip6_route);
+
+	signals[NM_PLATFORM_SIGNAL_ID_CHANGES_BATCH] =
+	    g_signal_new (NM_PLATFORM_SIGNAL_CHANGES_BATCH,
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_FIRST,
+	                  0,
+	                  NULL, NULL, NULL,
+	                  G_TYPE_NONE, 1, G_TYPE_POINTER);
 }
@@ -138,6 +138,10 @@ struct _NMPlatformLink {
 
 	guint mtu;
 
+	/* IFLA_NUM_RX_QUEUES and IFLA_NUM_TX_QUEUES, or 0 if unknown. */
+	guint num_rx_queues;
+	guint num_tx_queues;
+
 	/* rtnl_link_get_arptype(), ifinfomsg.ifi_type. */
 	guint32 arptype;
 
@@ -172,6 +176,7 @@ typedef enum { /*< skip >*/
 	NM_PLATFORM_SIGNAL_ID_IP6_ADDRESS,
 	NM_PLATFORM_SIGNAL_ID_IP4_ROUTE,
 	NM_PLATFORM_SIGNAL_ID_IP6_ROUTE,
+	NM_PLATFORM_SIGNAL_ID_CHANGES_BATCH,
 	_NM_PLATFORM_SIGNAL_ID_LAST,
 } NMPlatformSignalIdType;
 
@@ -196,6 +201,15 @@ typedef enum { /*< skip >*/
 	NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL              = (1LL << 2),
 } NMPlatformGetRouteFlags;
 
+typedef struct {
+	guint64 rx_packets;
+	guint64 rx_bytes;
+	guint64 tx_packets;
+	guint64 tx_bytes;
+} NMPlatformLinkStatistics;
+
+typedef void (*NMPlatformLinkStatisticsFunc) (NMPlatform *self, gpointer user_data);
+
 typedef struct {
 	__NMPlatformObject_COMMON;
 } NMPlatformObject;
@@ -321,8 +335,24 @@ typedef union {
 	 * routes. Such a route is not alive, according to nmp_object_is_alive(). */ \
 	bool rt_cloned:1; \
 	\
+	/* whether the path MTU is locked (RTAX_LOCK), so that path MTU
+	 * discovery doesn't change it. */ \
+	bool lock_mtu:1; \
+	\
 	guint32 metric; \
 	guint32 mss; \
+	\
+	/* TCP tuning metrics of the route (RTA_METRICS). Zero means unset. */ \
+	guint32 window; \
+	guint32 initcwnd; \
+	guint32 initrwnd; \
+	/* the initial RTT estimate, in milliseconds. */ \
+	guint32 rtt; \
+	guint32 mtu; \
+	\
+	/* the congestion control algorithm (RTAX_CC_ALGO) as interned
+	 * string, or %NULL. */ \
+	const char *congctl; \
 	;
 
 typedef struct {
@@ -364,9 +394,73 @@ typedef union {
 
 #undef __NMPlatformIPRoute_COMMON
 
+/**
+ * NMPlatformIP4RouteNexthop:
+ * @ifindex: the outgoing interface of the nexthop.
+ * @gateway: the gateway, or 0 for an on-link nexthop.
+ * @weight: the relative weight of the nexthop, between 1 and 256.
+ *   0 is treated like 1.
+ *
+ * One nexthop of an IPv4 multipath (ECMP) route, see
+ * nm_platform_ip4_route_add_multipath(). The #NMPlatformIP4Route of
+ * a multipath route in the cache carries the ifindex and gateway of the
+ * first nexthop, the others are only part of its #NMPObject.
+ **/
+typedef struct {
+	int ifindex;
+	in_addr_t gateway;
+	guint16 weight;
+} NMPlatformIP4RouteNexthop;
+
 
 #undef __NMPlatformObject_COMMON
 
+/**
+ * NMPlatformBatchEntry:
+ * @obj_type: one of the address or route object types.
+ * @is_delete: whether to delete the object or to add (and replace) it.
+ * @success: the result, set by nm_platform_batch_commit().
+ *
+ * One queued address or route change for nm_platform_batch_commit().
+ * When adding an address, @lifetime and @preferred are anchored at
+ * the time of the commit, like for nm_platform_ip4_address_add(). The
+ * @timestamp field is ignored.
+ **/
+typedef struct {
+	NMPObjectType obj_type;
+	bool is_delete:1;
+	bool success:1;
+	union {
+		NMPlatformIPXAddress ipx_address;
+		NMPlatformIP4Address ip4_address;
+		NMPlatformIP6Address ip6_address;
+		NMPlatformIPXRoute   ipx_route;
+		NMPlatformIP4Route   ip4_route;
+		NMPlatformIP6Route   ip6_route;
+	};
+} NMPlatformBatchEntry;
+
+/**
+ * NMPlatformChangesBatchEntry:
+ * @obj_type: the type of the changed object.
+ * @change_type: the (coalesced) change type.
+ * @ifindex: the ifindex of the object.
+ * @obj: a reference to a copy of the object, as it was last signalled.
+ *
+ * One entry of the array passed to NM_PLATFORM_SIGNAL_CHANGES_BATCH.
+ * Several changes to the same object within one batch are merged
+ * into a single entry. An object that was added and removed again
+ * within the same batch is dropped altogether. A removal followed by
+ * an addition becomes a change, unless the ifindex or, for links, the
+ * link type or kind differ; then both are kept.
+ **/
+typedef struct {
+	NMPObjectType obj_type;
+	NMPlatformSignalChangeType change_type;
+	int ifindex;
+	const NMPObject *obj;
+} NMPlatformChangesBatchEntry;
+
 
 typedef struct {
 	gboolean is_ip4;
@@ -375,10 +469,13 @@ typedef struct {
 	int (*route_cmp) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b);
 	const char *(*route_to_string) (const NMPlatformIPXRoute *route, char *buf, gsize len);
 	GArray *(*route_get_all) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+	const NMPlatformIPXRoute *const *(*route_get_view) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len);
 	gboolean (*route_add) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
 	gboolean (*route_delete) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route);
 	gboolean (*route_delete_default) (NMPlatform *self, int ifindex, guint32 metric);
 	guint32 (*metric_normalize) (guint32 metric);
+	NMPlatformBatchEntry *(*batch_route_add) (GArray *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
+	NMPlatformBatchEntry *(*batch_route_delete) (GArray *batch, int ifindex, const NMPlatformIPXRoute *route);
 } NMPlatformVTableRoute;
 
 extern const NMPlatformVTableRoute nm_platform_vtable_route_v4;
@@ -397,6 +494,69 @@ typedef struct {
 	bool path_mtu_discovery:1;
 } NMPlatformLnkGre;
 
+typedef enum {
+	NM_PLATFORM_BOND_OPT_MODE,
+	NM_PLATFORM_BOND_OPT_ACTIVE_SLAVE,
+	NM_PLATFORM_BOND_OPT_MIIMON,
+	NM_PLATFORM_BOND_OPT_UPDELAY,
+	NM_PLATFORM_BOND_OPT_DOWNDELAY,
+	NM_PLATFORM_BOND_OPT_USE_CARRIER,
+	NM_PLATFORM_BOND_OPT_ARP_INTERVAL,
+	NM_PLATFORM_BOND_OPT_ARP_IP_TARGET,
+	NM_PLATFORM_BOND_OPT_ARP_VALIDATE,
+	NM_PLATFORM_BOND_OPT_ARP_ALL_TARGETS,
+	NM_PLATFORM_BOND_OPT_PRIMARY,
+	NM_PLATFORM_BOND_OPT_PRIMARY_RESELECT,
+	NM_PLATFORM_BOND_OPT_FAIL_OVER_MAC,
+	NM_PLATFORM_BOND_OPT_XMIT_HASH_POLICY,
+	NM_PLATFORM_BOND_OPT_RESEND_IGMP,
+	NM_PLATFORM_BOND_OPT_NUM_PEER_NOTIF,
+	NM_PLATFORM_BOND_OPT_ALL_SLAVES_ACTIVE,
+	NM_PLATFORM_BOND_OPT_MIN_LINKS,
+	NM_PLATFORM_BOND_OPT_LP_INTERVAL,
+	NM_PLATFORM_BOND_OPT_PACKETS_PER_SLAVE,
+	NM_PLATFORM_BOND_OPT_AD_LACP_RATE,
+	NM_PLATFORM_BOND_OPT_AD_SELECT,
+	NM_PLATFORM_BOND_OPT_AD_ACTOR_SYS_PRIO,
+	NM_PLATFORM_BOND_OPT_AD_USER_PORT_KEY,
+	NM_PLATFORM_BOND_OPT_AD_ACTOR_SYSTEM,
+	NM_PLATFORM_BOND_OPT_TLB_DYNAMIC_LB,
+	_NM_PLATFORM_BOND_OPT_NUM,
+} NMPlatformBondOpt;
+
+#define NM_PLATFORM_BOND_MAX_ARP_TARGETS 16
+
+/* A set of bond options to program with one RTM_NEWLINK request. Only
+ * the options whose bit (1 << NMPlatformBondOpt) is in @set are sent.
+ * Numeric options are kept in @values, indexed by NMPlatformBondOpt;
+ * ACTIVE_SLAVE and PRIMARY are ifindexes. ARP_IP_TARGET replaces the
+ * whole target list of the bond. */
+typedef struct {
+	guint32 set;
+	guint32 values[_NM_PLATFORM_BOND_OPT_NUM];
+	in_addr_t arp_ip_targets[NM_PLATFORM_BOND_MAX_ARP_TARGETS];
+	guint n_arp_ip_targets;
+	guint8 ad_actor_system[6 /*ETH_ALEN*/];
+} NMPlatformBondChange;
+
+/* Bridge options for one RTM_NEWLINK request. Time values are in
+ * USER_HZ (clock_t), like the corresponding sysfs files. */
+typedef struct {
+	guint32 forward_delay;
+	guint32 hello_time;
+	guint32 max_age;
+	guint32 ageing_time;
+	guint32 stp_state;
+	guint16 priority;
+	bool mcast_snooping:1;
+} NMPlatformBridgeChange;
+
+typedef struct {
+	guint32 path_cost;
+	guint16 priority;
+	bool hairpin_mode:1;
+} NMPlatformBridgePortChange;
+
 typedef struct {
 	int p_key;
 	const char *mode;
@@ -430,6 +590,150 @@ typedef struct {
 
 typedef NMPlatformLnkMacvlan NMPlatformLnkMacvtap;
 
+/**
+ * NMPlatformLinkAddRequest:
+ * @type: %NM_LINK_TYPE_VLAN, %NM_LINK_TYPE_MACVLAN or %NM_LINK_TYPE_MACVTAP.
+ * @name: the name of the new link.
+ * @parent: the ifindex of the parent link.
+ * @result: set by nm_platform_link_add_batch().
+ * @ifindex: the ifindex of the new link, set by nm_platform_link_add_batch().
+ *
+ * One link to create with nm_platform_link_add_batch(). For macvtap
+ * links, @macvlan.tap must be set.
+ **/
+typedef struct {
+	NMLinkType type;
+	const char *name;
+	int parent;
+	union {
+		struct {
+			guint16 id;
+			guint32 flags;
+		} vlan;
+		NMPlatformLnkMacvlan macvlan;
+	};
+	NMPlatformError result;
+	int ifindex;
+} NMPlatformLinkAddRequest;
+
+typedef enum {
+	NM_PLATFORM_LINK_CHANGE_NONE            = 0,
+	NM_PLATFORM_LINK_CHANGE_FLAGS           = (1LL << 0),
+	NM_PLATFORM_LINK_CHANGE_MTU             = (1LL << 1),
+	NM_PLATFORM_LINK_CHANGE_ADDRESS         = (1LL << 2),
+	NM_PLATFORM_LINK_CHANGE_MASTER          = (1LL << 3),
+} NMPlatformLinkChangeFlags;
+
+/**
+ * NMPlatformLinkChangeAttrs:
+ * @change: which of the other fields are to be applied
+ * @flags_mask: the link flags to change, %IFF_UP and %IFF_NOARP
+ * @flags_set: the new values of the flags in @flags_mask
+ * @mtu: the new MTU
+ * @address: the new hardware address, @address_len bytes
+ * @master: the ifindex of the new master, or 0 to release the link
+ *
+ * A set of changes for nm_platform_link_change_attrs().
+ **/
+typedef struct {
+	NMPlatformLinkChangeFlags change;
+	unsigned flags_mask;
+	unsigned flags_set;
+	guint32 mtu;
+	gconstpointer address;
+	gsize address_len;
+	int master;
+} NMPlatformLinkChangeAttrs;
+
+/* Flags of the CEE features in #NMPlatformDcbConfig, the values of
+ * DCB_FEATCFG_* in <linux/dcbnl.h>. */
+#define NM_PLATFORM_DCB_FEAT_ENABLE    0x02
+#define NM_PLATFORM_DCB_FEAT_WILLING   0x04
+#define NM_PLATFORM_DCB_FEAT_ADVERTISE 0x08
+
+#define NM_PLATFORM_DCB_APP_IDTYPE_ETHTYPE 0
+#define NM_PLATFORM_DCB_APP_IDTYPE_PORTNUM 1
+
+/**
+ * NMPlatformDcbConfig:
+ * @pg_flags: %NM_PLATFORM_DCB_FEAT_* flags of priority groups
+ * @pfc_flags: %NM_PLATFORM_DCB_FEAT_* flags of priority flow control
+ * @app_flags: %NM_PLATFORM_DCB_FEAT_* flags of the applications
+ * @pfc_up: bit i is set if priority i has flow control
+ * @pg_tc: the transmit configuration of each traffic class, only
+ *   applied when @pg_flags has %NM_PLATFORM_DCB_FEAT_ENABLE.
+ * @pg_bw_pct: the bandwidth percentage of each priority group
+ * @apps: the priorities of the applications, @n_apps of them
+ *
+ * The CEE DCB configuration of a link, see nm_platform_link_set_dcb().
+ **/
+typedef struct {
+	guint8 pg_flags;
+	guint8 pfc_flags;
+	guint8 app_flags;
+	guint8 pfc_up;
+	struct {
+		/* 0 to 7, or 15 for no bandwidth limit */
+		guint8 pgid;
+		/* bitmap of the priorities of the traffic class */
+		guint8 up_mapping;
+		/* 0: none, 2: link strict */
+		guint8 strict;
+		guint8 bw_pct;
+	} pg_tc[8];
+	guint8 pg_bw_pct[8];
+	struct {
+		guint8 idtype;
+		guint16 id;
+		/* bitmap of priorities */
+		guint8 up_map;
+	} apps[3];
+	guint n_apps;
+} NMPlatformDcbConfig;
+
+/**
+ * NMPlatformQdisc:
+ * @kind: the kind of the qdisc, like "fq_codel"
+ * @limit: the maximum number of queued packets of "fq_codel" and "fq"
+ * @target_us: the target delay of "fq_codel" and "cake"
+ * @interval_us: the interval of "fq_codel", the round trip time of "cake"
+ * @ecn: whether "fq_codel" marks ECN, or -1
+ * @rate: in bytes per second, the shaped bandwidth of "cake" or the
+ *   maximum rate of a flow of "fq"
+ *
+ * The root queueing discipline of a link. Zero options are not sent,
+ * the kernel uses its defaults for them.
+ **/
+typedef struct {
+	char kind[16];
+	guint32 limit;
+	guint32 target_us;
+	guint32 interval_us;
+	gint8 ecn;
+	guint64 rate;
+} NMPlatformQdisc;
+
+/**
+ * NMPlatformSriovVF:
+ * @index: the number of the VF
+ * @has_mac: whether @mac is set
+ * @vlan: the VLAN ID, or -1 to leave it unchanged
+ * @qos: the VLAN priority, together with @vlan
+ * @spoof_check: 1 or 0, or -1 to leave it unchanged
+ * @trust: 1 or 0, or -1 to leave it unchanged
+ *
+ * The configuration of one SR-IOV virtual function of a link.
+ **/
+typedef struct {
+	guint32 index;
+	bool has_mac:1;
+	guint8 mac[6 /*ETH_ALEN*/];
+	gint32 vlan;
+	guint32 qos;
+	gint8 spoof_check;
+	gint8 trust;
+} NMPlatformSriovVF;
+
 typedef struct {
 	in_addr_t local;
 	in_addr_t remote;
@@ -477,6 +781,40 @@ typedef struct {
 	bool multi_queue:1;
 } NMPlatformTunProperties;
 
+typedef struct {
+	const char *path;
+	const char *value;
+
+	/* set by nm_platform_sysctl_set_many(): 0 on success, otherwise the errno. */
+	int errsv;
+} NMPlatformSysctlSetEntry;
+
+typedef enum {
+	NM_PLATFORM_ETHTOOL_FEATURE_GRO,
+	NM_PLATFORM_ETHTOOL_FEATURE_GSO,
+	NM_PLATFORM_ETHTOOL_FEATURE_TSO,
+	NM_PLATFORM_ETHTOOL_FEATURE_LRO,
+} NMPlatformEthtoolFeature;
+
+/* the sizes of the rings of a device (ETHTOOL_GRINGPARAM) */
+typedef struct {
+	guint32 rx;
+	guint32 rx_mini;
+	guint32 rx_jumbo;
+	guint32 tx;
+} NMPlatformEthtoolRing;
+
+/* the interrupt coalescing parameters of a device (ETHTOOL_GCOALESCE).
+ * When setting, the other parameters of the device are kept. */
+typedef struct {
+	guint32 rx_usecs;
+	guint32 rx_frames;
+	guint32 tx_usecs;
+	guint32 tx_frames;
+	bool adaptive_rx:1;
+	bool adaptive_tx:1;
+} NMPlatformEthtoolCoalesce;
+
 /******************************************************************/
 
 struct _NMPlatform {
@@ -489,6 +827,7 @@ typedef struct {
 	GObjectClass parent;
 
 	gboolean (*sysctl_set) (NMPlatform *, const char *path, const char *value);
+	gboolean (*sysctl_set_many) (NMPlatform *, NMPlatformSysctlSetEntry *entries, guint len);
 	char * (*sysctl_get) (NMPlatform *, const char *path);
 
 	const NMPlatformLink *(*link_get) (NMPlatform *platform, int ifindex);
@@ -510,6 +849,9 @@ typedef struct {
 
 	gboolean (*link_refresh) (NMPlatform *, int ifindex);
 
+	void (*link_statistics_refresh) (NMPlatform *self);
+	gboolean (*link_get_statistics) (NMPlatform *self, int ifindex, NMPlatformLinkStatistics *out_stats);
+
 	gboolean (*link_set_netns) (NMPlatform *, int ifindex, int netns_fd);
 
 	void (*process_events) (NMPlatform *self);
@@ -530,6 +872,11 @@ typedef struct {
 	                                        size_t *length);
 	gboolean (*link_set_address) (NMPlatform *, int ifindex, gconstpointer address, size_t length);
 	gboolean (*link_set_mtu) (NMPlatform *, int ifindex, guint32 mtu);
+	gboolean (*link_set_dcb) (NMPlatform *, int ifindex, gboolean enable, const NMPlatformDcbConfig *config);
+	gboolean (*qdisc_get_root) (NMPlatform *, int ifindex, NMPlatformQdisc *out_qdisc);
+	gboolean (*qdisc_set_root) (NMPlatform *, int ifindex, const NMPlatformQdisc *qdisc);
+	gboolean (*link_set_sriov) (NMPlatform *, int ifindex, guint num_vfs, const NMPlatformSriovVF *vfs, guint n_vfs);
+	NMPlatformError (*link_change_attrs) (NMPlatform *, int ifindex, const NMPlatformLinkChangeAttrs *attrs);
 
 	char *   (*link_get_physical_port_id) (NMPlatform *, int ifindex);
 	guint    (*link_get_dev_id) (NMPlatform *, int ifindex);
@@ -559,6 +906,9 @@ typedef struct {
 	                              gboolean egress_reset_all,
 	                              const NMVlanQosMapping *egress_map,
 	                              gsize n_egress_map);
+	gboolean (*link_bond_change) (NMPlatform *self, int ifindex, const NMPlatformBondChange *change);
+	gboolean (*link_bridge_change) (NMPlatform *self, int ifindex, const NMPlatformBridgeChange *change);
+	gboolean (*link_bridge_port_change) (NMPlatform *self, int ifindex, const NMPlatformBridgePortChange *change);
 	gboolean (*link_vxlan_add) (NMPlatform *,
 	                            const char *name,
 	                            const NMPlatformLnkVxlan *props,
@@ -575,6 +925,7 @@ typedef struct {
 	                           const char *name,
 	                           const NMPlatformLnkIpIp *props,
 	                           const NMPlatformLink **out_link);
+	void (*link_add_batch) (NMPlatform *self, NMPlatformLinkAddRequest *requests, guint len);
 	gboolean (*link_macvlan_add) (NMPlatform *,
 	                              const char *name,
 	                              int parent,
@@ -633,16 +984,25 @@ typedef struct {
 
 	GArray * (*ip4_route_get_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
 	GArray * (*ip6_route_get_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
+	gconstpointer (*object_get_view) (NMPlatform *, NMPObjectType obj_type, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len);
+	guint64 (*cache_get_generation) (NMPlatform *);
 	gboolean (*ip4_route_add) (NMPlatform *, int ifindex, NMIPConfigSource source,
 	                           in_addr_t network, guint8 plen, in_addr_t gateway,
 	                           in_addr_t pref_src, guint32 metric, guint32 mss);
 	gboolean (*ip6_route_add) (NMPlatform *, int ifindex, NMIPConfigSource source,
 	                           struct in6_addr network, guint8 plen, struct in6_addr gateway,
 	                           guint32 metric, guint32 mss);
+	gboolean (*ip4_route_add_multipath) (NMPlatform *, NMIPConfigSource source,
+	                                     in_addr_t network, guint8 plen, guint32 metric, guint32 mss,
+	                                     const NMPlatformIP4RouteNexthop *nexthops, guint n_nexthops);
 	gboolean (*ip4_route_delete) (NMPlatform *, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 	gboolean (*ip6_route_delete) (NMPlatform *, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 	const NMPlatformIP4Route *(*ip4_route_get) (NMPlatform *, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 	const NMPlatformIP6Route *(*ip6_route_get) (NMPlatform *, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
+	const NMPlatformIP4Route *(*ip4_route_lookup_best) (NMPlatform *, int ifindex, in_addr_t host);
+	const NMPlatformIP6Route *(*ip6_route_lookup_best) (NMPlatform *, int ifindex, const struct in6_addr *host);
+
+	void (*batch_commit) (NMPlatform *, NMPlatformBatchEntry *entries, guint len);
 
 	gboolean (*check_support_kernel_extended_ifa_flags) (NMPlatform *);
 	gboolean (*check_support_user_ipv6ll) (NMPlatform *);
@@ -665,6 +1025,16 @@ typedef struct {
 #define NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED "ip4-route-changed"
 #define NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED "ip6-route-changed"
 
+/* The "changes-batch" signal is emitted once after the platform finished
+ * processing a set of events, with a GArray of NMPlatformChangesBatchEntry
+ * as argument. The per-type signals above are still emitted for every single
+ * change. The batch is only recorded while a handler is connected, so users
+ * that don't care pay nothing for it. The array and the objects are owned by
+ * the platform and only valid during the signal emission. */
+#define NM_PLATFORM_SIGNAL_CHANGES_BATCH "changes-batch"
+
+void _nm_platform_changes_batch_flush (NMPlatform *self);
+
 const char *nm_platform_signal_change_type_to_string (NMPlatformSignalChangeType change_type);
 
 /******************************************************************/
@@ -705,6 +1075,7 @@ const char *_nm_platform_error_to_string (NMPlatformError error);
 #define nm_platform_error_to_string(error) NM_UTILS_LOOKUP_STR (_nm_platform_error_to_string, error)
 
 gboolean nm_platform_sysctl_set (NMPlatform *self, const char *path, const char *value);
+gboolean nm_platform_sysctl_set_many (NMPlatform *self, NMPlatformSysctlSetEntry *entries, guint len);
 char *nm_platform_sysctl_get (NMPlatform *self, const char *path);
 gint32 nm_platform_sysctl_get_int32 (NMPlatform *self, const char *path, gint32 fallback);
 gint64 nm_platform_sysctl_get_int_checked (NMPlatform *self, const char *path, guint base, gint64 min, gint64 max, gint64 fallback);
@@ -745,6 +1116,13 @@ gboolean nm_platform_link_supports_slaves (NMPlatform *self, int ifindex);
 const char *nm_platform_link_get_type_name (NMPlatform *self, int ifindex);
 
 gboolean nm_platform_link_refresh (NMPlatform *self, int ifindex);
+
+guint nm_platform_link_statistics_subscribe (NMPlatform *self,
+                                             guint refresh_rate_ms,
+                                             NMPlatformLinkStatisticsFunc callback,
+                                             gpointer user_data);
+void nm_platform_link_statistics_unsubscribe (NMPlatform *self, guint subscription_id);
+gboolean nm_platform_link_get_statistics (NMPlatform *self, int ifindex, NMPlatformLinkStatistics *out_stats);
 void nm_platform_process_events (NMPlatform *self);
 
 gboolean nm_platform_link_set_up (NMPlatform *self, int ifindex, gboolean *out_no_firmware);
@@ -761,6 +1139,11 @@ gboolean nm_platform_link_set_user_ipv6ll_enabled (NMPlatform *self, int ifindex
 gboolean nm_platform_link_get_permanent_address (NMPlatform *self, int ifindex, guint8 *buf, size_t *length);
 gboolean nm_platform_link_set_address (NMPlatform *self, int ifindex, const void *address, size_t length);
 gboolean nm_platform_link_set_mtu (NMPlatform *self, int ifindex, guint32 mtu);
+gboolean nm_platform_link_set_dcb (NMPlatform *self, int ifindex, gboolean enable, const NMPlatformDcbConfig *config);
+gboolean nm_platform_qdisc_get_root (NMPlatform *self, int ifindex, NMPlatformQdisc *out_qdisc);
+gboolean nm_platform_qdisc_set_root (NMPlatform *self, int ifindex, const NMPlatformQdisc *qdisc);
+gboolean nm_platform_link_set_sriov (NMPlatform *self, int ifindex, guint num_vfs, const NMPlatformSriovVF *vfs, guint n_vfs);
+gboolean nm_platform_link_change_attrs (NMPlatform *self, int ifindex, const NMPlatformLinkChangeAttrs *attrs, gboolean *out_no_firmware);
 
 char    *nm_platform_link_get_physical_port_id (NMPlatform *self, int ifindex);
 guint    nm_platform_link_get_dev_id (NMPlatform *self, int ifindex);
@@ -813,6 +1196,10 @@ gboolean nm_platform_link_vlan_change (NMPlatform *self,
                                        const NMVlanQosMapping *egress_map,
                                        gsize n_egress_map);
 
+gboolean nm_platform_link_bond_change (NMPlatform *self, int ifindex, const NMPlatformBondChange *change);
+gboolean nm_platform_link_bridge_change (NMPlatform *self, int ifindex, const NMPlatformBridgeChange *change);
+gboolean nm_platform_link_bridge_port_change (NMPlatform *self, int ifindex, const NMPlatformBridgePortChange *change);
+
 NMPlatformError nm_platform_link_vxlan_add (NMPlatform *self,
                                             const char *name,
                                             const NMPlatformLnkVxlan *props,
@@ -874,6 +1261,7 @@ NMPlatformError nm_platform_link_ipip_add (NMPlatform *self,
                                            const char *name,
                                            const NMPlatformLnkIpIp *props,
                                            const NMPlatformLink **out_link);
+void nm_platform_link_add_batch (NMPlatform *self, NMPlatformLinkAddRequest *requests, guint len);
 NMPlatformError nm_platform_link_macvlan_add (NMPlatform *self,
                                               const char *name,
                                               int parent,
@@ -912,17 +1300,32 @@ gboolean nm_platform_address_flush (NMPlatform *self, int ifindex);
 
 const NMPlatformIP4Route *nm_platform_ip4_route_get (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 const NMPlatformIP6Route *nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
+const NMPlatformIP4Route *nm_platform_ip4_route_lookup_best (NMPlatform *self, int ifindex, in_addr_t host);
+const NMPlatformIP6Route *nm_platform_ip6_route_lookup_best (NMPlatform *self, int ifindex, const struct in6_addr *host);
 GArray *nm_platform_ip4_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 GArray *nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+
+guint64 nm_platform_cache_get_generation (NMPlatform *self);
+const NMPlatformIP4Address *const *nm_platform_ip4_address_get_view (NMPlatform *self, int ifindex, guint *out_len);
+const NMPlatformIP6Address *const *nm_platform_ip6_address_get_view (NMPlatform *self, int ifindex, guint *out_len);
+const NMPlatformIP4Route *const *nm_platform_ip4_route_get_view (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len);
+const NMPlatformIP6Route *const *nm_platform_ip6_route_get_view (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags, guint *out_len);
 gboolean nm_platform_ip4_route_add (NMPlatform *self, int ifindex, NMIPConfigSource source,
                                     in_addr_t network, guint8 plen, in_addr_t gateway,
                                     in_addr_t pref_src, guint32 metric, guint32 mss);
 gboolean nm_platform_ip6_route_add (NMPlatform *self, int ifindex, NMIPConfigSource source,
                                     struct in6_addr network, guint8 plen, struct in6_addr gateway,
                                     guint32 metric, guint32 mss);
+gboolean nm_platform_ip4_route_add_multipath (NMPlatform *self, NMIPConfigSource source,
+                                              in_addr_t network, guint8 plen, guint32 metric, guint32 mss,
+                                              const NMPlatformIP4RouteNexthop *nexthops, guint n_nexthops);
 gboolean nm_platform_ip4_route_delete (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 gboolean nm_platform_ip6_route_delete (NMPlatform *self, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 
+GArray *nm_platform_batch_new (void);
+NMPlatformBatchEntry *nm_platform_batch_append (GArray *batch, NMPObjectType obj_type, gboolean is_delete, gconstpointer obj);
+gboolean nm_platform_batch_commit (NMPlatform *self, GArray *batch);
+
 const char *nm_platform_link_to_string (const NMPlatformLink *link, char *buf, gsize len);
 const char *nm_platform_lnk_gre_to_string (const NMPlatformLnkGre *lnk, char *buf, gsize len);
 const char *nm_platform_lnk_infiniband_to_string (const NMPlatformLnkInfiniband *lnk, char *buf, gsize len);
@@ -970,4 +1373,11 @@ int nm_platform_ip_address_cmp_expiry (const NMPlatformIPAddress *a, const NMPla
 gboolean nm_platform_ethtool_set_wake_on_lan (NMPlatform *self, const char *ifname, NMSettingWiredWakeOnLan wol, const char *wol_password);
 gboolean nm_platform_ethtool_get_link_speed (NMPlatform *self, const char *ifname, guint32 *out_speed);
 
+gboolean nm_platform_ethtool_get_feature (NMPlatform *self, const char *ifname, NMPlatformEthtoolFeature feature, gboolean *out_enabled);
+gboolean nm_platform_ethtool_set_feature (NMPlatform *self, const char *ifname, NMPlatformEthtoolFeature feature, gboolean enabled);
+gboolean nm_platform_ethtool_get_ring (NMPlatform *self, const char *ifname, NMPlatformEthtoolRing *out_ring);
+gboolean nm_platform_ethtool_set_ring (NMPlatform *self, const char *ifname, const NMPlatformEthtoolRing *ring);
+gboolean nm_platform_ethtool_get_coalesce (NMPlatform *self, const char *ifname, NMPlatformEthtoolCoalesce *out_coalesce);
+gboolean nm_platform_ethtool_set_coalesce (NMPlatform *self, const char *ifname, const NMPlatformEthtoolCoalesce *coalesce);
+
 #endif /* __NETWORKMANAGER_PLATFORM_H__ */
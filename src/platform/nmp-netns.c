@@ -71,7 +71,7 @@ __ns_types_to_str (int ns_types, int ns_types_already_set, char *buf, gsize len)
     G_STMT_START { \
         NMLogLevel _level = (level); \
         \
-        if (nm_logging_enabled (_level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (_level, _NMLOG_DOMAIN)) { \
             NMPNetns *_netns = (netns); \
             char _sbuf[20]; \
             \
@@ -95,6 +95,10 @@ typedef struct _NMPNetnsPrivate NMPNetnsPrivate;
 struct _NMPNetnsPrivate {
 	int fd_net;
 	int fd_mnt;
+
+	/* directory fd of /sys as mounted inside the namespace. -1 if
+	 * not yet opened, -2 if opening failed. See nmp_netns_get_fd_sysfs(). */
+	int fd_sysfs;
 };
 
 typedef struct {
@@ -408,6 +412,43 @@ nmp_netns_get_fd_mnt (NMPNetns *self)
 	return self->priv->fd_mnt;
 }
 
+/**
+ * nmp_netns_get_fd_sysfs:
+ * @self: the #NMPNetns instance
+ *
+ * Returns a directory file descriptor of "/sys" as it is mounted in @self.
+ * A sysfs mount is bound to the network namespace it was mounted in, so
+ * files below "/sys" can be opened with openat() relative to this
+ * descriptor without switching the namespaces of the calling thread.
+ * The descriptor is opened on first use and kept until @self is destroyed.
+ *
+ * Returns: the file descriptor or -1 on error.
+ */
+int
+nmp_netns_get_fd_sysfs (NMPNetns *self)
+{
+	NMPNetnsPrivate *priv;
+	int errsv;
+
+	g_return_val_if_fail (NMP_IS_NETNS (self), -1);
+
+	priv = self->priv;
+	if (priv->fd_sysfs == -1) {
+		if (!nmp_netns_push_type (self, CLONE_NEWNS))
+			return -1;
+
+		priv->fd_sysfs = open ("/sys", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (priv->fd_sysfs == -1) {
+			errsv = errno;
+			_LOGD (self, "failed to open /sys: %s", g_strerror (errsv));
+			priv->fd_sysfs = -2;
+		}
+
+		nmp_netns_pop (self);
+	}
+	return priv->fd_sysfs >= 0 ? priv->fd_sysfs : -1;
+}
+
 /*********************************************************************************************/
 
 static gboolean
@@ -513,6 +554,87 @@ err_out:
 	return NULL;
 }
 
+/**
+ * nmp_netns_new_from_path:
+ * @filename: a network namespace file, like "/var/run/netns/NAME"
+ *   as created by nmp_netns_bind_to_path() or "ip netns add".
+ *
+ * Like nmp_netns_new(), but enters the existing network namespace
+ * @filename instead of creating one. The mount namespace is new, so
+ * that "/sys" can be remounted to show the links of the namespace.
+ * On success, the new instance is pushed and the caller must pop it.
+ *
+ * Returns: the new #NMPNetns or %NULL on failure.
+ */
+NMPNetns *
+nmp_netns_new_from_path (const char *filename)
+{
+	NMPNetns *self;
+	int errsv;
+	int fd;
+	GError *error = NULL;
+
+	g_return_val_if_fail (filename && filename[0] == '/', NULL);
+
+	_stack_ensure_init ();
+
+	if (!_stack_peek ())
+		return NULL;
+
+	fd = open (filename, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		errsv = errno;
+		_LOGE (NULL, "failed to open netns %s: %s", filename, g_strerror (errsv));
+		return NULL;
+	}
+
+	if (setns (fd, CLONE_NEWNET) != 0) {
+		errsv = errno;
+		_LOGE (NULL, "failed to enter netns %s: %s", filename, g_strerror (errsv));
+		close (fd);
+		return NULL;
+	}
+	close (fd);
+
+	if (unshare (CLONE_NEWNS) != 0) {
+		errsv = errno;
+		_LOGE (NULL, "failed to create new mnt namespace: %s", g_strerror (errsv));
+		goto err_out;
+	}
+
+	if (mount ("", "/", "none", MS_SLAVE | MS_REC, NULL) != 0) {
+		errsv = errno;
+		_LOGE (NULL, "failed mount --make-rslave: %s", g_strerror (errsv));
+		goto err_out;
+	}
+
+	if (umount2 ("/sys", MNT_DETACH) != 0) {
+		errsv = errno;
+		_LOGE (NULL, "failed umount /sys: %s", g_strerror (errsv));
+		goto err_out;
+	}
+
+	if (mount ("sysfs", "/sys", "sysfs", 0, NULL) != 0) {
+		errsv = errno;
+		_LOGE (NULL, "failed mount /sys: %s", g_strerror (errsv));
+		goto err_out;
+	}
+
+	self = _netns_new (&error);
+	if (!self) {
+		_LOGE (NULL, "failed to create netns for %s: %s", filename, error->message);
+		g_clear_error (&error);
+		goto err_out;
+	}
+
+	_stack_push (self, _CLONE_NS_ALL);
+
+	return self;
+err_out:
+	_netns_switch_pop (NULL, _CLONE_NS_ALL);
+	return NULL;
+}
+
 gboolean
 nmp_netns_pop (NMPNetns *self)
 {
@@ -686,6 +808,7 @@ static void
 nmp_netns_init (NMPNetns *self)
 {
 	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, NMP_TYPE_NETNS, NMPNetnsPrivate);
+	self->priv->fd_sysfs = -1;
 }
 
 static void
@@ -703,6 +826,11 @@ dispose (GObject *object)
 		self->priv->fd_mnt = 0;
 	}
 
+	if (self->priv->fd_sysfs >= 0) {
+		close (self->priv->fd_sysfs);
+		self->priv->fd_sysfs = -1;
+	}
+
 	G_OBJECT_CLASS (nmp_netns_parent_class)->dispose (object);
 }
 
@@ -47,6 +47,7 @@ typedef struct {
 GType nmp_netns_get_type (void);
 
 NMPNetns *nmp_netns_new (void);
+NMPNetns *nmp_netns_new_from_path (const char *filename);
 
 gboolean nmp_netns_push (NMPNetns *self);
 gboolean nmp_netns_push_type (NMPNetns *self, int ns_types);
@@ -58,6 +59,7 @@ gboolean nmp_netns_is_initial (void);
 
 int nmp_netns_get_fd_net (NMPNetns *self);
 int nmp_netns_get_fd_mnt (NMPNetns *self);
+int nmp_netns_get_fd_sysfs (NMPNetns *self);
 
 static inline void
 _nm_auto_pop_netns (NMPNetns **p)
@@ -28,6 +28,7 @@
 
 #include "nm-core-utils.h"
 #include "nm-platform-utils.h"
+#include "nm-lpm-trie.h"
 
 /*********************************************************************************************/
 
@@ -36,7 +37,7 @@
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             const NMPObject *const __obj = (obj); \
             \
             _nm_log (__level, _NMLOG_DOMAIN, 0, \
@@ -67,6 +68,14 @@ struct _NMPCache {
 	GHashTable *idx_main;
 	NMMultiIndex *idx_multi;
 
+	/* longest-prefix-match indexes of all cached routes by destination. */
+	NMLpmTrie *idx_lpm_ip4;
+	NMLpmTrie *idx_lpm_ip6;
+
+	/* incremented on every modification of the cache. That allows users of
+	 * nmp_cache_lookup_multi() to check whether the returned array is still valid. */
+	guint64 generation;
+
 	gboolean use_udev;
 };
 
@@ -99,6 +108,24 @@ _vlan_xgress_qos_mappings_cmp (guint n_map,
 	return 0;
 }
 
+static int
+_ip4_route_nexthops_cmp (guint n_nexthops,
+                         const NMPlatformIP4RouteNexthop *hops1,
+                         const NMPlatformIP4RouteNexthop *hops2)
+{
+	guint i;
+
+	for (i = 0; i < n_nexthops; i++) {
+		if (hops1[i].ifindex != hops2[i].ifindex)
+			return hops1[i].ifindex < hops2[i].ifindex ? -1 : 1;
+		if (hops1[i].gateway != hops2[i].gateway)
+			return ntohl (hops1[i].gateway) < ntohl (hops2[i].gateway) ? -1 : 1;
+		if (hops1[i].weight != hops2[i].weight)
+			return hops1[i].weight < hops2[i].weight ? -1 : 1;
+	}
+	return 0;
+}
+
 static void
 _vlan_xgress_qos_mappings_cpy (guint *dst_n_map,
                                const NMVlanQosMapping **dst_map,
@@ -202,6 +229,127 @@ nmp_class_from_type (NMPObjectType obj_type)
 	return &_nmp_classes[obj_type - 1];
 }
 
+/******************************************************************
+ * Object pool
+ *
+ * Parsing netlink dumps creates and destroys a large number of short
+ * lived objects. Instead of handing every released object back to the
+ * slice allocator, keep a bounded freelist per object type and recycle
+ * them. Like the rest of the platform code, the pool is not thread-safe.
+ ******************************************************************/
+
+#define NMP_OBJECT_POOL_MAX_FREE 512
+
+typedef struct _NMPObjectPoolChunk NMPObjectPoolChunk;
+
+struct _NMPObjectPoolChunk {
+	NMPObjectPoolChunk *next;
+};
+
+typedef struct {
+	NMPObjectPoolChunk *free_list;
+	guint n_free;
+	guint n_live;
+	guint n_peak;
+} NMPObjectPool;
+
+static NMPObjectPool _nmp_object_pools[NMP_OBJECT_TYPE_MAX];
+
+static inline gsize
+_nmp_object_pool_sizeof (const NMPClass *klass)
+{
+	return klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object);
+}
+
+static NMPObject *
+_nmp_object_pool_alloc (const NMPClass *klass)
+{
+	NMPObjectPool *pool = &_nmp_object_pools[klass->obj_type - 1];
+	NMPObjectPoolChunk *chunk;
+	gsize size = _nmp_object_pool_sizeof (klass);
+
+	G_STATIC_ASSERT (sizeof (NMPObjectPoolChunk) <= sizeof (NMPObject));
+
+	if (++pool->n_live > pool->n_peak)
+		pool->n_peak = pool->n_live;
+
+	chunk = pool->free_list;
+	if (!chunk)
+		return g_slice_alloc0 (size);
+
+	pool->free_list = chunk->next;
+	pool->n_free--;
+	memset (chunk, 0, size);
+	return (NMPObject *) chunk;
+}
+
+static void
+_nmp_object_pool_free (const NMPClass *klass, NMPObject *obj)
+{
+	NMPObjectPool *pool = &_nmp_object_pools[klass->obj_type - 1];
+	NMPObjectPoolChunk *chunk;
+
+	nm_assert (pool->n_live > 0);
+	pool->n_live--;
+
+	if (pool->n_free >= NMP_OBJECT_POOL_MAX_FREE) {
+		g_slice_free1 (_nmp_object_pool_sizeof (klass), obj);
+		return;
+	}
+
+	chunk = (NMPObjectPoolChunk *) obj;
+	chunk->next = pool->free_list;
+	pool->free_list = chunk;
+	pool->n_free++;
+}
+
+/**
+ * nmp_object_pool_get_stats:
+ * @obj_type: the object type
+ * @out_live: (allow-none): the number of currently allocated objects
+ * @out_peak: (allow-none): the highest number of allocated objects so far
+ * @out_free: (allow-none): the number of released objects kept for reuse
+ * @out_bytes: (allow-none): the memory of the allocated and the released
+ *   objects. Data referenced by the objects, like the udev device of a
+ *   link, is not included.
+ */
+void
+nmp_object_pool_get_stats (NMPObjectType obj_type, guint *out_live, guint *out_peak, guint *out_free, gsize *out_bytes)
+{
+	const NMPObjectPool *pool;
+
+	g_return_if_fail (obj_type > NMP_OBJECT_TYPE_UNKNOWN && obj_type <= NMP_OBJECT_TYPE_MAX);
+
+	pool = &_nmp_object_pools[obj_type - 1];
+	NM_SET_OUT (out_live, pool->n_live);
+	NM_SET_OUT (out_peak, pool->n_peak);
+	NM_SET_OUT (out_free, pool->n_free);
+	NM_SET_OUT (out_bytes, (pool->n_live + pool->n_free) * _nmp_object_pool_sizeof (&_nmp_classes[obj_type - 1]));
+}
+
+/**
+ * nmp_object_pool_trim:
+ *
+ * Release all objects that are kept for reuse.
+ */
+void
+nmp_object_pool_trim (void)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (_nmp_object_pools); i++) {
+		NMPObjectPool *pool = &_nmp_object_pools[i];
+		gsize size = _nmp_object_pool_sizeof (&_nmp_classes[i]);
+		NMPObjectPoolChunk *chunk;
+
+		while ((chunk = pool->free_list)) {
+			pool->free_list = chunk->next;
+			g_slice_free1 (size, chunk);
+		}
+		pool->n_free = 0;
+	}
+}
+
 /******************************************************************/
 
 NMPObject *
@@ -231,7 +379,7 @@ nmp_object_unref (NMPObject *obj)
 			nm_assert (!obj->is_cached);
 			if (klass->cmd_obj_dispose)
 				klass->cmd_obj_dispose (obj);
-			g_slice_free1 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object), obj);
+			_nmp_object_pool_free (klass, obj);
 		}
 	}
 }
@@ -250,6 +398,12 @@ _vt_cmd_obj_dispose_lnk_vlan (NMPObject *obj)
 	g_free ((gpointer) obj->_lnk_vlan.egress_qos_map);
 }
 
+static void
+_vt_cmd_obj_dispose_ip4_route (NMPObject *obj)
+{
+	g_free ((gpointer) obj->_ip4_route.nexthops);
+}
+
 static NMPObject *
 _nmp_object_new_from_class (const NMPClass *klass)
 {
@@ -259,7 +413,7 @@ _nmp_object_new_from_class (const NMPClass *klass)
 	nm_assert (klass->sizeof_data > 0);
 	nm_assert (klass->sizeof_public > 0 && klass->sizeof_public <= klass->sizeof_data);
 
-	obj = g_slice_alloc0 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object));
+	obj = _nmp_object_pool_alloc (klass);
 	obj->_class = klass;
 	obj->_ref_count = 1;
 	_LOGt (obj, "new");
@@ -548,6 +702,53 @@ _vt_cmd_obj_to_string_lnk_vlan (const NMPObject *obj, NMPObjectToStringMode to_s
 	}
 }
 
+static const char *
+_vt_cmd_obj_to_string_ip4_route (const NMPObject *obj, NMPObjectToStringMode to_string_mode, char *buf, gsize buf_size)
+{
+	const NMPClass *klass = NMP_OBJECT_GET_CLASS (obj);
+	char buf2[sizeof (_nm_utils_to_string_buffer)];
+	char s_gateway[NM_UTILS_INET_ADDRSTRLEN];
+	char *b;
+	gsize l;
+	guint i;
+
+	switch (to_string_mode) {
+	case NMP_OBJECT_TO_STRING_ID:
+		return klass->cmd_plobj_to_string_id (&obj->object, buf, buf_size);
+	case NMP_OBJECT_TO_STRING_ALL:
+		g_snprintf (buf, buf_size,
+		            "[%s,%p,%d,%ccache,%calive,%cvisible; %s]",
+		            klass->obj_type_name, obj, obj->_ref_count,
+		            obj->is_cached ? '+' : '-',
+		            nmp_object_is_alive (obj) ? '+' : '-',
+		            nmp_object_is_visible (obj) ? '+' : '-',
+		            nmp_object_to_string (obj, NMP_OBJECT_TO_STRING_PUBLIC, buf2, sizeof (buf2)));
+		return buf;
+	case NMP_OBJECT_TO_STRING_PUBLIC:
+		klass->cmd_plobj_to_string (&obj->object, buf, buf_size);
+
+		b = buf;
+		l = strlen (b);
+		b += l;
+		buf_size -= l;
+
+		for (i = 0; i < obj->_ip4_route.n_nexthops && buf_size > 1; i++) {
+			const NMPlatformIP4RouteNexthop *hop = &obj->_ip4_route.nexthops[i];
+
+			g_snprintf (b, buf_size, " nexthop %d via %s weight %u",
+			            hop->ifindex,
+			            nm_utils_inet4_ntop (hop->gateway, s_gateway),
+			            (guint) hop->weight);
+			l = strlen (b);
+			b += l;
+			buf_size -= l;
+		}
+		return buf;
+	default:
+		g_return_val_if_reached ("ERROR");
+	}
+}
+
 #define _vt_cmd_plobj_to_string_id(type, plat_type, ...) \
 static const char * \
 _vt_cmd_plobj_to_string_id_##type (const NMPlatformObject *_obj, char *buf, gsize buf_len) \
@@ -647,6 +848,21 @@ _vt_cmd_obj_cmp_lnk_vlan (const NMPObject *obj1, const NMPObject *obj2)
 	return c;
 }
 
+static int
+_vt_cmd_obj_cmp_ip4_route (const NMPObject *obj1, const NMPObject *obj2)
+{
+	int c;
+
+	c = nm_platform_ip4_route_cmp (&obj1->ip4_route, &obj2->ip4_route);
+	if (c)
+		return c;
+
+	if (obj1->_ip4_route.n_nexthops != obj2->_ip4_route.n_nexthops)
+		return obj1->_ip4_route.n_nexthops < obj2->_ip4_route.n_nexthops ? -1 : 1;
+
+	return _ip4_route_nexthops_cmp (obj1->_ip4_route.n_nexthops, obj1->_ip4_route.nexthops, obj2->_ip4_route.nexthops);
+}
+
 gboolean
 nmp_object_equal (const NMPObject *obj1, const NMPObject *obj2)
 {
@@ -711,6 +927,22 @@ _vt_cmd_obj_copy_lnk_vlan (NMPObject *dst, const NMPObject *src)
 	                               src->_lnk_vlan.egress_qos_map);
 }
 
+static void
+_vt_cmd_obj_copy_ip4_route (NMPObject *dst, const NMPObject *src)
+{
+	dst->ip4_route = src->ip4_route;
+	if (src->_ip4_route.n_nexthops == 0) {
+		g_clear_pointer ((gpointer *) &dst->_ip4_route.nexthops, g_free);
+		dst->_ip4_route.n_nexthops = 0;
+	} else if (   src->_ip4_route.n_nexthops != dst->_ip4_route.n_nexthops
+	           || _ip4_route_nexthops_cmp (src->_ip4_route.n_nexthops, dst->_ip4_route.nexthops, src->_ip4_route.nexthops) != 0) {
+		g_free ((gpointer) dst->_ip4_route.nexthops);
+		dst->_ip4_route.n_nexthops = src->_ip4_route.n_nexthops;
+		dst->_ip4_route.nexthops = g_memdup (src->_ip4_route.nexthops,
+		                                     sizeof (NMPlatformIP4RouteNexthop) * src->_ip4_route.n_nexthops);
+	}
+}
+
 #define _vt_cmd_plobj_id_copy(type, plat_type, cmd) \
 static void \
 _vt_cmd_plobj_id_copy_##type (NMPlatformObject *_dst, const NMPlatformObject *_src) \
@@ -1414,6 +1646,20 @@ nmp_cache_link_connected_needs_toggle_by_ifindex (const NMPCache *cache, int mas
 
 /******************************************************************/
 
+/**
+ * nmp_cache_get_generation:
+ * @cache: the #NMPCache
+ *
+ * Returns: a counter that changes with every modification of @cache.
+ *   As long as it stays the same, arrays returned by nmp_cache_lookup_multi()
+ *   and the objects they point to are valid and unchanged.
+ */
+guint64
+nmp_cache_get_generation (const NMPCache *cache)
+{
+	return cache->generation;
+}
+
 const NMPlatformObject *const *
 nmp_cache_lookup_multi (const NMPCache *cache, const NMPCacheId *cache_id, guint *out_len)
 {
@@ -1503,6 +1749,73 @@ nmp_cache_find_other_route_for_same_destination (const NMPCache *cache, const NM
 	return NULL;
 }
 
+typedef struct {
+	int ifindex;
+	const NMPObject *best;
+} LookupRouteBestData;
+
+static gboolean
+_lookup_route_best_cb (guint8 plen, void *const*values, guint len, gpointer user_data)
+{
+	LookupRouteBestData *data = user_data;
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		const NMPObject *candidate = NMP_OBJECT_UP_CAST (values[i]);
+
+		if (   data->ifindex > 0
+		    && candidate->ip_route.ifindex != data->ifindex)
+			continue;
+		if (!nmp_object_is_visible (candidate))
+			continue;
+		if (   !data->best
+		    || candidate->ip_route.metric < data->best->ip_route.metric)
+			data->best = candidate;
+	}
+
+	/* stop at the longest prefix that has a matching route. */
+	return !data->best;
+}
+
+/**
+ * nmp_cache_lookup_route_best:
+ * @cache:
+ * @obj_type: either %NMP_OBJECT_TYPE_IP4_ROUTE or %NMP_OBJECT_TYPE_IP6_ROUTE
+ * @ifindex: if positive, only consider routes on this interface.
+ * @host: the destination address, either an #in_addr_t or a #struct in6_addr.
+ *
+ * Does a longest-prefix-match for @host among the cached routes.
+ *
+ * Returns: (transfer none): the route with the longest prefix that
+ *   contains @host, and the lowest metric among the routes with that prefix.
+ *   Or %NULL, if no route matches.
+ */
+const NMPObject *
+nmp_cache_lookup_route_best (const NMPCache *cache, NMPObjectType obj_type, int ifindex, gconstpointer host)
+{
+	LookupRouteBestData data = {
+		.ifindex = ifindex,
+	};
+	NMLpmTrie *idx_lpm;
+
+	nm_assert (cache);
+	nm_assert (host);
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		idx_lpm = cache->idx_lpm_ip4;
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		idx_lpm = cache->idx_lpm_ip6;
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
+
+	nm_lpm_trie_foreach_match (idx_lpm, host, _lookup_route_best_cb, &data);
+	return data.best;
+}
+
 const NMPObject *
 nmp_cache_lookup_link_full (const NMPCache *cache,
                             int ifindex,
@@ -1579,10 +1892,27 @@ nmp_cache_lookup_all_to_hash (const NMPCache *cache,
 
 /******************************************************************/
 
+static NMLpmTrie *
+_nmp_cache_get_idx_lpm (const NMPCache *cache, const NMPObject *obj, gconstpointer *out_network)
+{
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		*out_network = &obj->ip4_route.network;
+		return cache->idx_lpm_ip4;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		*out_network = &obj->ip6_route.network;
+		return cache->idx_lpm_ip6;
+	default:
+		return NULL;
+	}
+}
+
 static void
 _nmp_cache_update_cache (NMPCache *cache, NMPObject *obj, gboolean remove)
 {
 	const guint8 *id_type;
+	NMLpmTrie *idx_lpm;
+	gconstpointer network;
 
 	for (id_type = NMP_OBJECT_GET_CLASS (obj)->supported_cache_ids; *id_type; id_type++) {
 		NMPCacheId cache_id_storage;
@@ -1607,6 +1937,19 @@ _nmp_cache_update_cache (NMPCache *cache, NMPObject *obj, gboolean remove)
 				g_assert_not_reached ();
 		}
 	}
+
+	/* The route identity (ifindex,network,plen,metric) never changes for a cached
+	 * object, so there is no need to touch the LPM index in _nmp_cache_update_update(). */
+	idx_lpm = _nmp_cache_get_idx_lpm (cache, obj, &network);
+	if (idx_lpm) {
+		if (remove) {
+			if (!nm_lpm_trie_remove (idx_lpm, network, obj->ip_route.plen, &obj->object))
+				g_assert_not_reached ();
+		} else {
+			if (!nm_lpm_trie_add (idx_lpm, network, obj->ip_route.plen, &obj->object))
+				g_assert_not_reached ();
+		}
+	}
 }
 
 static void
@@ -1619,6 +1962,7 @@ _nmp_cache_update_add (NMPCache *cache, NMPObject *obj)
 		g_assert_not_reached ();
 	obj->is_cached = TRUE;
 	_nmp_cache_update_cache (cache, obj, FALSE);
+	cache->generation++;
 }
 
 static void
@@ -1626,6 +1970,7 @@ _nmp_cache_update_remove (NMPCache *cache, NMPObject *obj)
 {
 	nm_assert (obj->is_cached);
 	_nmp_cache_update_cache (cache, obj, TRUE);
+	cache->generation++;
 	obj->is_cached = FALSE;
 	if (!g_hash_table_remove (cache->idx_main, obj))
 		g_assert_not_reached ();
@@ -1655,6 +2000,7 @@ _nmp_cache_update_update (NMPCache *cache, NMPObject *obj, const NMPObject *new)
 			g_assert_not_reached ();
 	}
 	nmp_object_copy (obj, new, FALSE);
+	cache->generation++;
 }
 
 NMPCacheOpsType
@@ -2004,6 +2350,9 @@ nmp_cache_new (gboolean use_udev)
 	                                       (NMMultiIndexFuncEqual) nmp_cache_id_equal,
 	                                       (NMMultiIndexFuncClone) nmp_cache_id_clone,
 	                                       (NMMultiIndexFuncDestroy) nmp_cache_id_destroy);
+	cache->idx_lpm_ip4 = nm_lpm_trie_new (sizeof (in_addr_t));
+	cache->idx_lpm_ip6 = nm_lpm_trie_new (sizeof (struct in6_addr));
+	cache->generation = 0;
 	cache->use_udev = !!use_udev;
 	return cache;
 }
@@ -2024,6 +2373,8 @@ nmp_cache_free (NMPCache *cache)
 		obj->is_cached = FALSE;
 	}
 
+	nm_lpm_trie_free (cache->idx_lpm_ip4);
+	nm_lpm_trie_free (cache->idx_lpm_ip6);
 	nm_multi_index_free (cache->idx_multi);
 	g_hash_table_unref (cache->idx_main);
 
@@ -2060,6 +2411,24 @@ ASSERT_nmp_cache_is_consistent (const NMPCache *cache)
 				continue;
 			g_assert (nm_multi_index_contains (cache->idx_multi, &cache_id->base, &obj->object));
 		}
+
+		{
+			NMLpmTrie *idx_lpm;
+			gconstpointer network;
+			void *const*values;
+			guint i_lpm, len_lpm;
+
+			idx_lpm = _nmp_cache_get_idx_lpm (cache, obj, &network);
+			if (idx_lpm) {
+				values = nm_lpm_trie_lookup_exact (idx_lpm, network, obj->ip_route.plen, &len_lpm);
+				g_assert (values);
+				for (i_lpm = 0; i_lpm < len_lpm; i_lpm++) {
+					if (values[i_lpm] == &obj->object)
+						break;
+				}
+				g_assert (i_lpm < len_lpm);
+			}
+		}
 	}
 
 	nm_multi_index_iter_init (&iter_multi, cache->idx_multi, NULL);
@@ -2169,6 +2538,10 @@ const NMPClass _nmp_classes[NMP_OBJECT_TYPE_MAX] = {
 		.cmd_obj_init_cache_id              = _vt_cmd_obj_init_cache_id_ipx_route,
 		.cmd_obj_stackinit_id               = _vt_cmd_obj_stackinit_id_ip4_route,
 		.cmd_obj_is_alive                   = _vt_cmd_obj_is_alive_ipx_route,
+		.cmd_obj_cmp                        = _vt_cmd_obj_cmp_ip4_route,
+		.cmd_obj_copy                       = _vt_cmd_obj_copy_ip4_route,
+		.cmd_obj_dispose                    = _vt_cmd_obj_dispose_ip4_route,
+		.cmd_obj_to_string                  = _vt_cmd_obj_to_string_ip4_route,
 		.cmd_plobj_id_copy                  = _vt_cmd_plobj_id_copy_ip4_route,
 		.cmd_plobj_id_equal                 = _vt_cmd_plobj_id_equal_ip4_route,
 		.cmd_plobj_id_hash                  = _vt_cmd_plobj_id_hash_ip4_route,
@@ -239,6 +239,11 @@ typedef struct {
 
 typedef struct {
 	NMPlatformIP4Route _public;
+
+	/* the nexthops of a multipath route, or none for a regular route.
+	 * The first one is also reflected by the public ifindex and gateway. */
+	guint n_nexthops;
+	const NMPlatformIP4RouteNexthop *nexthops;
 } NMPObjectIP4Route;
 
 typedef struct {
@@ -362,6 +367,9 @@ NMP_OBJECT_GET_TYPE (const NMPObject *obj)
 
 const NMPClass *nmp_class_from_type (NMPObjectType obj_type);
 
+void nmp_object_pool_get_stats (NMPObjectType obj_type, guint *out_live, guint *out_peak, guint *out_free, gsize *out_bytes);
+void nmp_object_pool_trim (void);
+
 NMPObject *nmp_object_ref (NMPObject *object);
 void nmp_object_unref (NMPObject *object);
 NMPObject *nmp_object_new (NMPObjectType obj_type, const NMPlatformObject *plob);
@@ -412,12 +420,14 @@ NMPCacheId *nmp_cache_id_init_link_by_ifname (NMPCacheId *id, const char *ifname
 NMPCacheId *nmp_cache_id_init_routes_by_destination_ip4 (NMPCacheId *id, guint32 network, guint8 plen, guint32 metric);
 NMPCacheId *nmp_cache_id_init_routes_by_destination_ip6 (NMPCacheId *id, const struct in6_addr *network, guint8 plen, guint32 metric);
 
+guint64 nmp_cache_get_generation (const NMPCache *cache);
 const NMPlatformObject *const *nmp_cache_lookup_multi (const NMPCache *cache, const NMPCacheId *cache_id, guint *out_len);
 GArray *nmp_cache_lookup_multi_to_array (const NMPCache *cache, NMPObjectType obj_type, const NMPCacheId *cache_id);
 const NMPObject *nmp_cache_lookup_obj (const NMPCache *cache, const NMPObject *obj);
 const NMPObject *nmp_cache_lookup_link (const NMPCache *cache, int ifindex);
 
 const NMPObject *nmp_cache_find_other_route_for_same_destination (const NMPCache *cache, const NMPObject *route);
+const NMPObject *nmp_cache_lookup_route_best (const NMPCache *cache, NMPObjectType obj_type, int ifindex, gconstpointer host);
 
 const NMPObject *nmp_cache_lookup_link_full (const NMPCache *cache,
                                              int ifindex,
@@ -0,0 +1,418 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager platform benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Populates the fake platform with a large number of links, addresses and
+ * routes and measures the time spent in the platform cache and in
+ * NMRouteManager. It also compares allocating platform objects from the
+ * object pool with plain slice allocations.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+
+#include "nm-fake-platform.h"
+#include "nm-route-manager.h"
+#include "nmp-object.h"
+
+#include "nm-test-utils-core.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int links;
+	int addresses;
+	int routes;
+	int handlers;
+} global_opt = {
+	.links = 100,
+	.addresses = 4,
+	.routes = 50,
+	.handlers = 8,
+};
+
+static int *ifindexes;
+static guint n_signals;
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "links", 'n', 0, G_OPTION_ARG_INT, &global_opt.links, "Number of links to create", "N" },
+		{ "addresses", 'm', 0, G_OPTION_ARG_INT, &global_opt.addresses, "Number of IPv4 addresses per link", "M" },
+		{ "routes", 'r', 0, G_OPTION_ARG_INT, &global_opt.routes, "Number of IPv4 routes per link", "R" },
+		{ "handlers", 'H', 0, G_OPTION_ARG_INT, &global_opt.handlers, "Number of signal handlers connected for the fan-out phase", "K" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark the platform cache and route manager on the fake platform.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.links <= 0
+	    || global_opt.addresses < 0
+	    || global_opt.routes < 0
+	    || global_opt.handlers < 0) {
+		g_warning ("Invalid arguments: counts must not be negative");
+		return FALSE;
+	}
+	if (   (gint64) global_opt.links * MAX (global_opt.addresses, global_opt.routes) >= 0x400000
+	    || global_opt.links >= 0x10000) {
+		g_warning ("Invalid arguments: too many links, addresses or routes");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static in_addr_t
+_address (int link, int i)
+{
+	/* 100.64.0.0/10 */
+	return htonl (0x64400000u + (guint32) (link * global_opt.addresses + i));
+}
+
+static in_addr_t
+_route (guint32 base, int link, int i)
+{
+	return htonl (base + (guint32) (link * global_opt.routes + i));
+}
+
+#define ROUTE_BASE      0x0A000000u /* 10.0.0.0/10 */
+#define ROUTE_BASE_SYNC 0x0A400000u /* 10.64.0.0/10 */
+
+static void
+_route_changed_cb (NMPlatform *platform,
+                   int obj_type_i,
+                   int ifindex,
+                   const NMPlatformIP4Route *route,
+                   int change_type_i,
+                   gpointer user_data)
+{
+	n_signals++;
+}
+
+static void
+_changes_batch_cb (NMPlatform *platform, const GArray *batch, gpointer user_data)
+{
+	n_signals += batch->len;
+}
+
+/*****************************************************************************/
+
+static void
+bench_links_add (NMPlatform *platform, int parent)
+{
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, "link-add");
+	for (i = 0; i < global_opt.links; i++) {
+		const NMPlatformLink *plink = NULL;
+		char name[IFNAMSIZ];
+		NMPlatformError plerr;
+
+		switch (i % 3) {
+		case 0:
+			nm_sprintf_buf (name, "bv%d", i);
+			plerr = nm_platform_link_vlan_add (platform, name, parent, 1 + (i % 4094), 0, &plink);
+			break;
+		case 1: {
+			const NMPlatformLnkMacvlan props = {
+				.mode = 4 /* MACVLAN_MODE_BRIDGE */,
+			};
+
+			nm_sprintf_buf (name, "bm%d", i);
+			plerr = nm_platform_link_macvlan_add (platform, name, parent, &props, &plink);
+			break;
+		}
+		default:
+			/* the platform has no API to create veth pairs, use
+			 * dummy links as the third kind of software link. */
+			nm_sprintf_buf (name, "bd%d", i);
+			plerr = nm_platform_link_dummy_add (platform, name, &plink);
+			break;
+		}
+		g_assert_cmpint (plerr, ==, NM_PLATFORM_ERROR_SUCCESS);
+		g_assert (plink);
+
+		ifindexes[i] = plink->ifindex;
+		g_assert (nm_platform_link_set_up (platform, ifindexes[i], NULL));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_addresses_add (NMPlatform *platform)
+{
+	NMBenchTimer timer;
+	int i, j;
+
+	nm_bench_timer_start (&timer, "address-add");
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.addresses; j++) {
+			in_addr_t addr = _address (i, j);
+
+			g_assert (nm_platform_ip4_address_add (platform, ifindexes[i], addr, 32, addr,
+			                                       NM_PLATFORM_LIFETIME_PERMANENT,
+			                                       NM_PLATFORM_LIFETIME_PERMANENT,
+			                                       0, NULL));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_routes_add (NMPlatform *platform, const char *phase, guint32 mss)
+{
+	NMBenchTimer timer;
+	int i, j;
+
+	nm_bench_timer_start (&timer, phase);
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.routes; j++) {
+			g_assert (nm_platform_ip4_route_add (platform, ifindexes[i], NM_IP_CONFIG_SOURCE_USER,
+			                                     _route (ROUTE_BASE, i, j), 32, 0, 0,
+			                                     100, mss));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_lookup (NMPlatform *platform)
+{
+	NMBenchTimer timer;
+	int i, j;
+
+	nm_bench_timer_start (&timer, "link-lookup");
+	for (i = 0; i < global_opt.links; i++) {
+		const NMPlatformLink *plink;
+
+		plink = nm_platform_link_get (platform, ifindexes[i]);
+		g_assert (plink);
+		g_assert (nm_platform_link_get_by_ifname (platform, plink->name) == plink);
+		timer.ops += 2;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "address-lookup");
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.addresses; j++) {
+			in_addr_t addr = _address (i, j);
+
+			g_assert (nm_platform_ip4_address_get (platform, ifindexes[i], addr, 32, addr));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "route-lookup");
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.routes; j++) {
+			g_assert (nm_platform_ip4_route_get (platform, ifindexes[i], _route (ROUTE_BASE, i, j), 32, 100));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "route-lookup-best");
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.routes; j++) {
+			g_assert (nm_platform_ip4_route_lookup_best (platform, 0, _route (ROUTE_BASE, i, j)));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_signal_fanout (NMPlatform *platform)
+{
+	gs_free gulong *ids = NULL;
+	gulong batch_id;
+	int i;
+
+	ids = g_new0 (gulong, global_opt.handlers + 1);
+	for (i = 0; i < global_opt.handlers; i++) {
+		ids[i] = g_signal_connect (platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED,
+		                           G_CALLBACK (_route_changed_cb), NULL);
+	}
+	batch_id = g_signal_connect (platform, NM_PLATFORM_SIGNAL_CHANGES_BATCH,
+	                             G_CALLBACK (_changes_batch_cb), NULL);
+
+	/* re-adding the routes with a different MSS emits CHANGED for each of them. */
+	n_signals = 0;
+	bench_routes_add (platform, "route-change-fanout", 1400);
+	g_print ("signal-deliveries\t%u\t0\t0\n", n_signals);
+
+	for (i = 0; i < global_opt.handlers; i++)
+		g_signal_handler_disconnect (platform, ids[i]);
+	g_signal_handler_disconnect (platform, batch_id);
+}
+
+static void
+bench_route_sync (NMPlatform *platform)
+{
+	gs_unref_object NMRouteManager *route_manager = NULL;
+	gs_unref_array GArray *routes = NULL;
+	NMBenchTimer timer;
+	int i, j;
+
+	route_manager = nm_route_manager_new (platform);
+	routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route), global_opt.routes);
+
+	/* keep every other route and replace the rest by new ones. */
+	nm_bench_timer_start (&timer, "route-manager-sync");
+	for (i = 0; i < global_opt.links; i++) {
+		g_array_set_size (routes, 0);
+		for (j = 0; j < global_opt.routes; j++) {
+			NMPlatformIP4Route r = {
+				.ifindex = ifindexes[i],
+				.rt_source = NM_IP_CONFIG_SOURCE_USER,
+				.network = _route ((j % 2) ? ROUTE_BASE_SYNC : ROUTE_BASE, i, j),
+				.plen = 32,
+				.metric = 100,
+			};
+
+			g_array_append_val (routes, r);
+		}
+		g_assert (nm_route_manager_ip4_route_sync (route_manager, ifindexes[i], routes, TRUE, TRUE));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "route-manager-flush");
+	for (i = 0; i < global_opt.links; i++) {
+		g_array_set_size (routes, 0);
+		g_assert (nm_route_manager_ip4_route_sync (route_manager, ifindexes[i], routes, TRUE, TRUE));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_delete (NMPlatform *platform)
+{
+	NMBenchTimer timer;
+	int i, j;
+
+	nm_bench_timer_start (&timer, "address-delete");
+	for (i = 0; i < global_opt.links; i++) {
+		for (j = 0; j < global_opt.addresses; j++) {
+			in_addr_t addr = _address (i, j);
+
+			g_assert (nm_platform_ip4_address_delete (platform, ifindexes[i], addr, 32, addr));
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "link-delete");
+	for (i = global_opt.links - 1; i >= 0; i--) {
+		g_assert (nm_platform_link_delete (platform, ifindexes[i]));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_object_pool (void)
+{
+	const guint n_objects = 2000;
+	const guint n_rounds = 200;
+	gs_free NMPObject **objs = g_new (NMPObject *, n_objects);
+	gs_free gpointer *mems = g_new (gpointer, n_objects);
+	const NMPClass *klass = nmp_class_from_type (NMP_OBJECT_TYPE_IP4_ROUTE);
+	gsize size = klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object);
+	NMBenchTimer timer;
+	guint i, j;
+
+	/* the baseline: a plain slice allocation for each object. */
+	nm_bench_timer_start (&timer, "object-alloc-slice");
+	for (j = 0; j < n_rounds; j++) {
+		for (i = 0; i < n_objects; i++)
+			mems[i] = g_slice_alloc0 (size);
+		for (i = 0; i < n_objects; i++)
+			g_slice_free1 (size, mems[i]);
+		timer.ops += n_objects;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "object-alloc-pool");
+	for (j = 0; j < n_rounds; j++) {
+		for (i = 0; i < n_objects; i++)
+			objs[i] = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, NULL);
+		for (i = 0; i < n_objects; i++)
+			nmp_object_unref (objs[i]);
+		timer.ops += n_objects;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nmp_object_pool_trim ();
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	NMPlatform *platform;
+	const NMPlatformLink *parent = NULL;
+
+	nmtst_init_with_logging (&argc, &argv, "ERR", "ALL");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	nm_fake_platform_setup ();
+	platform = NM_PLATFORM_GET;
+
+	g_assert_cmpint (nm_platform_link_dummy_add (platform, "bench0", &parent), ==, NM_PLATFORM_ERROR_SUCCESS);
+	g_assert (parent);
+	g_assert (nm_platform_link_set_up (platform, parent->ifindex, NULL));
+
+	ifindexes = g_new0 (int, global_opt.links);
+
+	g_print ("# links=%d addresses=%d routes=%d handlers=%d\n",
+	         global_opt.links, global_opt.addresses, global_opt.routes, global_opt.handlers);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	bench_links_add (platform, parent->ifindex);
+	bench_addresses_add (platform);
+	bench_routes_add (platform, "route-add", 0);
+	bench_lookup (platform);
+	bench_signal_fanout (platform);
+	bench_route_sync (platform);
+	bench_delete (platform);
+	bench_object_pool ();
+
+	g_free (ifindexes);
+
+	return EXIT_SUCCESS;
+}
@@ -31,6 +31,7 @@ NMTST_DEFINE ();
 
 static struct {
 	gboolean persist;
+	int stats_interval;
 } global_opt = {
 	.persist = TRUE,
 };
@@ -41,6 +42,7 @@ read_argv (int *argc, char ***argv)
 	GOptionContext *context;
 	GOptionEntry options[] = {
 		{ "no-persist", 'P', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &global_opt.persist, "Exit after processing netlink messages", NULL },
+		{ "stats", 's', 0, G_OPTION_ARG_INT, &global_opt.stats_interval, "Print netlink receive statistics every N seconds", "N" },
 		{ 0 },
 	};
 	gs_free_error GError *error = NULL;
@@ -59,6 +61,28 @@ read_argv (int *argc, char ***argv)
 	return TRUE;
 }
 
+static gboolean
+print_stats (gpointer user_data)
+{
+	static NMLinuxPlatformNetlinkStats last;
+	NMLinuxPlatformNetlinkStats stats;
+	double secs = global_opt.stats_interval;
+
+	nm_linux_platform_get_netlink_stats (NM_PLATFORM_GET, &stats);
+
+	nm_log_info (LOGD_PLATFORM, "netlink: %.1f messages/s, %.1f bytes/s, %.1f syscalls/s (%.1f messages/syscall), %.1f unchanged links skipped/s, %u overruns",
+	             (stats.recv_messages - last.recv_messages) / secs,
+	             (stats.recv_bytes - last.recv_bytes) / secs,
+	             (stats.recv_syscalls - last.recv_syscalls) / secs,
+	             stats.recv_syscalls > last.recv_syscalls
+	                 ? (double) (stats.recv_messages - last.recv_messages) / (stats.recv_syscalls - last.recv_syscalls)
+	                 : 0.0,
+	             (stats.newlink_skipped - last.newlink_skipped) / secs,
+	             stats.overruns);
+	last = stats;
+	return G_SOURCE_CONTINUE;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -78,6 +102,9 @@ main (int argc, char **argv)
 
 	nm_linux_platform_setup ();
 
+	if (global_opt.stats_interval > 0)
+		g_timeout_add_seconds (global_opt.stats_interval, print_stats, NULL);
+
 	if (global_opt.persist)
 		g_main_loop_run (loop);
 
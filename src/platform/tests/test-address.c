@@ -20,6 +20,8 @@
 
 #include "nm-default.h"
 
+#include "nmp-object.h"
+
 #include "test-common.h"
 
 #define DEVICE_NAME "nm-test-device"
@@ -250,6 +252,147 @@ test_ip6_address_general_2 (void)
 
 /*****************************************************************************/
 
+typedef struct {
+	int ifindex;
+	in_addr_t addr;
+	guint n_batches;
+	guint n_added;
+	guint n_removed;
+} ChangesBatchData;
+
+static void
+changes_batch_callback (NMPlatform *platform, const GArray *batch, ChangesBatchData *data)
+{
+	guint i;
+
+	g_assert (batch && batch->len > 0);
+
+	data->n_batches++;
+	for (i = 0; i < batch->len; i++) {
+		const NMPlatformChangesBatchEntry *entry = &g_array_index (batch, NMPlatformChangesBatchEntry, i);
+
+		g_assert (entry->obj);
+		g_assert (NMP_OBJECT_GET_TYPE (entry->obj) == entry->obj_type);
+		g_assert (NM_IN_SET (entry->change_type, NM_PLATFORM_SIGNAL_ADDED, NM_PLATFORM_SIGNAL_CHANGED, NM_PLATFORM_SIGNAL_REMOVED));
+
+		if (   entry->obj_type != NMP_OBJECT_TYPE_IP4_ADDRESS
+		    || entry->ifindex != data->ifindex
+		    || entry->obj->ip4_address.address != data->addr)
+			continue;
+
+		g_assert_cmpint (entry->obj->ip4_address.ifindex, ==, entry->ifindex);
+		if (entry->change_type == NM_PLATFORM_SIGNAL_ADDED)
+			data->n_added++;
+		else if (entry->change_type == NM_PLATFORM_SIGNAL_REMOVED)
+			data->n_removed++;
+	}
+}
+
+static void
+test_ip4_address_changes_batch (void)
+{
+	ChangesBatchData data = {
+		.ifindex = DEVICE_IFINDEX,
+	};
+	gulong id;
+
+	inet_pton (AF_INET, IP4_ADDRESS, &data.addr);
+	g_assert (data.ifindex > 0);
+
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, DEVICE_IFINDEX, NULL));
+
+	id = g_signal_connect (NM_PLATFORM_GET, NM_PLATFORM_SIGNAL_CHANGES_BATCH, G_CALLBACK (changes_batch_callback), &data);
+
+	g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, data.ifindex, data.addr, IP4_PLEN, data.addr, NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0, NULL));
+	g_assert_cmpint (data.n_added, ==, 1);
+	g_assert_cmpint (data.n_removed, ==, 0);
+	g_assert_cmpint (data.n_batches, >=, 1);
+
+	g_assert (nm_platform_ip4_address_delete (NM_PLATFORM_GET, data.ifindex, data.addr, IP4_PLEN, data.addr));
+	g_assert_cmpint (data.n_added, ==, 1);
+	g_assert_cmpint (data.n_removed, ==, 1);
+
+	g_signal_handler_disconnect (NM_PLATFORM_GET, id);
+}
+
+static void
+test_ip4_address_batch_invalid (void)
+{
+	const int ifindex = DEVICE_IFINDEX;
+	gs_unref_array GArray *batch = NULL;
+	NMPlatformIP4Address address = { 0 };
+	in_addr_t addr;
+
+	inet_pton (AF_INET, IP4_ADDRESS, &addr);
+	g_assert (ifindex > 0);
+
+	address.ifindex = ifindex;
+	address.address = addr;
+	address.peer_address = addr;
+	address.plen = IP4_PLEN;
+	address.lifetime = NM_PLATFORM_LIFETIME_PERMANENT;
+	address.preferred = NM_PLATFORM_LIFETIME_PERMANENT;
+
+	batch = nm_platform_batch_new ();
+	nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, FALSE, &address);
+
+	/* a zero lifetime is rejected, like by nm_platform_ip4_address_add(). */
+	address.address = htonl (ntohl (addr) + 1);
+	address.lifetime = 0;
+	address.preferred = 0;
+	nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, FALSE, &address);
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_CRITICAL, "*lifetime > 0*");
+	g_assert (!nm_platform_batch_commit (NM_PLATFORM_GET, batch));
+	g_test_assert_expected_messages ();
+
+	g_assert (g_array_index (batch, NMPlatformBatchEntry, 0).success);
+	g_assert (!g_array_index (batch, NMPlatformBatchEntry, 1).success);
+	g_assert (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, addr, IP4_PLEN, addr));
+	g_assert (!nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, address.address, IP4_PLEN, address.address));
+
+	g_assert (nm_platform_ip4_address_delete (NM_PLATFORM_GET, ifindex, addr, IP4_PLEN, addr));
+}
+
+static void
+test_ip4_address_view (void)
+{
+	const int ifindex = DEVICE_IFINDEX;
+	const NMPlatformIP4Address *const *view;
+	gs_unref_array GArray *all = NULL;
+	guint64 generation;
+	in_addr_t addr;
+	guint len, i;
+	gboolean found = FALSE;
+
+	inet_pton (AF_INET, IP4_ADDRESS, &addr);
+	g_assert (ifindex > 0);
+
+	generation = nm_platform_cache_get_generation (NM_PLATFORM_GET);
+
+	g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, ifindex, addr, IP4_PLEN, addr, NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0, NULL));
+	g_assert (generation != nm_platform_cache_get_generation (NM_PLATFORM_GET));
+
+	generation = nm_platform_cache_get_generation (NM_PLATFORM_GET);
+	view = nm_platform_ip4_address_get_view (NM_PLATFORM_GET, ifindex, &len);
+	all = nm_platform_ip4_address_get_all (NM_PLATFORM_GET, ifindex);
+
+	/* the view has the same content as the copy. */
+	g_assert_cmpint (len, ==, all->len);
+	for (i = 0; i < len; i++) {
+		g_assert (nm_platform_ip4_address_cmp (view[i], &g_array_index (all, NMPlatformIP4Address, i)) == 0);
+		if (view[i]->address == addr)
+			found = TRUE;
+	}
+	g_assert (found);
+
+	/* reading doesn't change the generation. */
+	g_assert (generation == nm_platform_cache_get_generation (NM_PLATFORM_GET));
+
+	g_assert (nm_platform_ip4_address_delete (NM_PLATFORM_GET, ifindex, addr, IP4_PLEN, addr));
+	g_assert (generation != nm_platform_cache_get_generation (NM_PLATFORM_GET));
+}
+
 static void
 test_ip4_address_peer (void)
 {
@@ -420,6 +563,10 @@ _nmtstp_setup_tests (void)
 	_g_test_add_func ("/address/ipv4/general-2", test_ip4_address_general_2);
 	_g_test_add_func ("/address/ipv6/general-2", test_ip6_address_general_2);
 
+	_g_test_add_func ("/address/ipv4/changes-batch", test_ip4_address_changes_batch);
+	_g_test_add_func ("/address/ipv4/batch/invalid", test_ip4_address_batch_invalid);
+	_g_test_add_func ("/address/ipv4/view", test_ip4_address_view);
+
 	_g_test_add_func ("/address/ipv4/peer", test_ip4_address_peer);
 	_g_test_add_func ("/address/ipv4/peer/zero", test_ip4_address_peer_zero);
 }
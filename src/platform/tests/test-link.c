@@ -1603,6 +1603,250 @@ test_vlan_set_xgress (void)
 
 /*****************************************************************************/
 
+static void
+_assert_master_option (int ifindex, const char *option, const char *expected)
+{
+	gs_free char *value = NULL;
+
+	value = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, option);
+	g_assert_cmpstr (value, ==, expected);
+}
+
+static void
+test_bond_change (void)
+{
+	NMPlatformBondChange change = { 0 };
+	int ifindex;
+
+	if (   !g_file_test ("/proc/1/net/bonding", G_FILE_TEST_IS_DIR)
+	    && system("modprobe --show bonding") != 0) {
+		g_test_skip ("Skipping test for bonding: bonding module not available");
+		return;
+	}
+
+	nmtstp_run_command_check ("ip link add %s type bond", DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, DEVICE_NAME, NM_LINK_TYPE_BOND, 100)->ifindex;
+
+#define SET_OPT(opt, v) \
+	G_STMT_START { \
+		change.set |= (1u << NM_PLATFORM_BOND_OPT_##opt); \
+		change.values[NM_PLATFORM_BOND_OPT_##opt] = (v); \
+	} G_STMT_END
+
+	SET_OPT (MODE, 1);
+	SET_OPT (MIIMON, 0);
+	SET_OPT (ARP_INTERVAL, 250);
+	SET_OPT (ARP_VALIDATE, 3);
+	SET_OPT (PRIMARY_RESELECT, 2);
+	SET_OPT (RESEND_IGMP, 7);
+	SET_OPT (NUM_PEER_NOTIF, 3);
+	SET_OPT (LP_INTERVAL, 5);
+	change.set |= (1u << NM_PLATFORM_BOND_OPT_ARP_IP_TARGET);
+	change.arp_ip_targets[change.n_arp_ip_targets++] = nmtst_inet4_from_string ("192.168.1.1");
+	change.arp_ip_targets[change.n_arp_ip_targets++] = nmtst_inet4_from_string ("192.168.1.2");
+
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, ifindex, &change));
+
+	_assert_master_option (ifindex, "mode", "active-backup 1");
+	_assert_master_option (ifindex, "miimon", "0");
+	_assert_master_option (ifindex, "arp_interval", "250");
+	_assert_master_option (ifindex, "arp_validate", "all 3");
+	_assert_master_option (ifindex, "arp_ip_target", "192.168.1.1 192.168.1.2");
+	_assert_master_option (ifindex, "primary_reselect", "failure 2");
+	_assert_master_option (ifindex, "resend_igmp", "7");
+	_assert_master_option (ifindex, "num_grat_arp", "3");
+	_assert_master_option (ifindex, "lp_interval", "5");
+
+	/* the target list is replaced as a whole */
+	memset (&change, 0, sizeof (change));
+	change.set |= (1u << NM_PLATFORM_BOND_OPT_ARP_IP_TARGET);
+	change.arp_ip_targets[change.n_arp_ip_targets++] = nmtst_inet4_from_string ("10.0.0.1");
+	SET_OPT (ARP_INTERVAL, 0);
+	SET_OPT (MIIMON, 100);
+
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, ifindex, &change));
+
+	_assert_master_option (ifindex, "arp_ip_target", "10.0.0.1");
+	_assert_master_option (ifindex, "miimon", "100");
+	_assert_master_option (ifindex, "arp_interval", "0");
+
+#undef SET_OPT
+
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+static void
+test_link_add_batch (void)
+{
+	enum { N = 20 };
+	NMPlatformLinkAddRequest requests[N + 3];
+	char names[N + 3][IFNAMSIZ];
+	int ifindex_parent;
+	guint i;
+
+	nmtstp_run_command_check ("ip link add %s type dummy", PARENT_NAME);
+	ifindex_parent = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, PARENT_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+
+	memset (requests, 0, sizeof (requests));
+	for (i = 0; i < N; i++) {
+		nm_sprintf_buf (names[i], "nm-bvlan%u", i);
+		requests[i].type = NM_LINK_TYPE_VLAN;
+		requests[i].name = names[i];
+		requests[i].parent = ifindex_parent;
+		requests[i].vlan.id = 100 + i;
+	}
+	nm_sprintf_buf (names[N], "nm-bmacvlan");
+	requests[N].type = NM_LINK_TYPE_MACVLAN;
+	requests[N].name = names[N];
+	requests[N].parent = ifindex_parent;
+	requests[N].macvlan.mode = MACVLAN_MODE_BRIDGE;
+
+	/* an existing link is reported, not created */
+	nm_sprintf_buf (names[N + 1], "%s", PARENT_NAME);
+	requests[N + 1].type = NM_LINK_TYPE_VLAN;
+	requests[N + 1].name = names[N + 1];
+	requests[N + 1].parent = ifindex_parent;
+	requests[N + 1].vlan.id = 1;
+
+	/* a duplicate of a queued request gets the result of the first one */
+	requests[N + 2] = requests[0];
+
+	nm_platform_link_add_batch (NM_PLATFORM_GET, requests, G_N_ELEMENTS (requests));
+
+	for (i = 0; i <= N; i++) {
+		const NMPlatformLink *plink;
+
+		g_assert_cmpint (requests[i].result, ==, NM_PLATFORM_ERROR_SUCCESS);
+		g_assert_cmpint (requests[i].ifindex, >, 0);
+
+		plink = nm_platform_link_get (NM_PLATFORM_GET, requests[i].ifindex);
+		g_assert (plink);
+		g_assert_cmpstr (plink->name, ==, names[i]);
+		g_assert_cmpint (plink->type, ==, requests[i].type);
+		g_assert_cmpint (plink->parent, ==, ifindex_parent);
+		if (i < N) {
+			const NMPlatformLnkVlan *lnk;
+
+			lnk = nm_platform_link_get_lnk_vlan (NM_PLATFORM_GET, requests[i].ifindex, NULL);
+			g_assert (lnk);
+			g_assert_cmpint (lnk->id, ==, 100 + i);
+		}
+	}
+	g_assert_cmpint (requests[N + 1].result, ==, NM_PLATFORM_ERROR_WRONG_TYPE);
+	g_assert_cmpint (requests[N + 1].ifindex, ==, ifindex_parent);
+	g_assert_cmpint (requests[N + 2].result, ==, NM_PLATFORM_ERROR_SUCCESS);
+	g_assert_cmpint (requests[N + 2].ifindex, ==, requests[0].ifindex);
+
+	for (i = 0; i <= N; i++)
+		nmtstp_link_del (NULL, -1, requests[i].ifindex, names[i]);
+	nmtstp_link_del (NULL, -1, ifindex_parent, PARENT_NAME);
+}
+
+static void
+test_bridge_change (void)
+{
+	const NMPlatformBridgeChange change = {
+		.forward_delay = 1200,
+		.hello_time = 300,
+		.max_age = 1500,
+		.ageing_time = 6000,
+		.stp_state = 1,
+		.priority = 4096,
+		.mcast_snooping = FALSE,
+	};
+	const NMPlatformBridgePortChange port_change = {
+		.path_cost = 42,
+		.priority = 12,
+		.hairpin_mode = TRUE,
+	};
+	gs_free char *value = NULL;
+	int ifindex, ifindex_port;
+
+	nmtstp_run_command_check ("ip link add %s type bridge", DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, DEVICE_NAME, NM_LINK_TYPE_BRIDGE, 100)->ifindex;
+	nmtstp_run_command_check ("ip link add %s type dummy", PARENT_NAME);
+	ifindex_port = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, PARENT_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+
+	g_assert (nm_platform_link_bridge_change (NM_PLATFORM_GET, ifindex, &change));
+
+	_assert_master_option (ifindex, "forward_delay", "1200");
+	_assert_master_option (ifindex, "hello_time", "300");
+	_assert_master_option (ifindex, "max_age", "1500");
+	_assert_master_option (ifindex, "ageing_time", "6000");
+	_assert_master_option (ifindex, "stp_state", "1");
+	_assert_master_option (ifindex, "priority", "4096");
+	_assert_master_option (ifindex, "multicast_snooping", "0");
+
+	g_assert (nm_platform_link_enslave (NM_PLATFORM_GET, ifindex, ifindex_port));
+	g_assert (nm_platform_link_bridge_port_change (NM_PLATFORM_GET, ifindex_port, &port_change));
+
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_port, "path_cost");
+	g_assert_cmpstr (value, ==, "42");
+	g_free (value);
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_port, "priority");
+	g_assert_cmpstr (value, ==, "12");
+	g_free (value);
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_port, "hairpin_mode");
+	g_assert_cmpstr (value, ==, "1");
+
+	nmtstp_link_del (NULL, -1, ifindex_port, PARENT_NAME);
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+static void
+test_link_change_attrs (void)
+{
+	const guint8 address[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x12, 0x34, 0x56 };
+	NMPlatformLinkChangeAttrs attrs = {
+		.change =   NM_PLATFORM_LINK_CHANGE_ADDRESS
+		          | NM_PLATFORM_LINK_CHANGE_MTU
+		          | NM_PLATFORM_LINK_CHANGE_FLAGS
+		          | NM_PLATFORM_LINK_CHANGE_MASTER,
+		.address = address,
+		.address_len = sizeof (address),
+		.mtu = 1400,
+		.flags_mask = IFF_UP | IFF_NOARP,
+		.flags_set = IFF_NOARP,
+	};
+	const NMPlatformLink *plink;
+	int ifindex, ifindex_port;
+
+	nmtstp_run_command_check ("ip link add %s type bridge", DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, DEVICE_NAME, NM_LINK_TYPE_BRIDGE, 100)->ifindex;
+	nmtstp_run_command_check ("ip link add %s type dummy", PARENT_NAME);
+	ifindex_port = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, PARENT_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, ifindex_port, NULL));
+
+	attrs.master = ifindex;
+	g_assert (nm_platform_link_change_attrs (NM_PLATFORM_GET, ifindex_port, &attrs, NULL));
+
+	plink = nm_platform_link_get (NM_PLATFORM_GET, ifindex_port);
+	g_assert (plink);
+	g_assert_cmpint (plink->master, ==, ifindex);
+	g_assert_cmpint (plink->mtu, ==, 1400);
+	g_assert (!NM_FLAGS_HAS (plink->n_ifi_flags, IFF_UP));
+	g_assert (NM_FLAGS_HAS (plink->n_ifi_flags, IFF_NOARP));
+	g_assert_cmpint (plink->addr.len, ==, sizeof (address));
+	g_assert (memcmp (plink->addr.data, address, sizeof (address)) == 0);
+
+	memset (&attrs, 0, sizeof (attrs));
+	attrs.change = NM_PLATFORM_LINK_CHANGE_MASTER | NM_PLATFORM_LINK_CHANGE_FLAGS;
+	attrs.master = 0;
+	attrs.flags_mask = IFF_UP;
+	attrs.flags_set = IFF_UP;
+	g_assert (nm_platform_link_change_attrs (NM_PLATFORM_GET, ifindex_port, &attrs, NULL));
+
+	plink = nm_platform_link_get (NM_PLATFORM_GET, ifindex_port);
+	g_assert (plink);
+	g_assert_cmpint (plink->master, ==, 0);
+	g_assert (NM_FLAGS_HAS (plink->n_ifi_flags, IFF_UP));
+
+	nmtstp_link_del (NULL, -1, ifindex_port, PARENT_NAME);
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+/*****************************************************************************/
+
 static void
 test_create_many_links_do (guint n_devices)
 {
@@ -1680,6 +1924,146 @@ test_create_many_links (gconstpointer user_data)
 
 /*****************************************************************************/
 
+static void
+test_ifindex_filter (gconstpointer user_data)
+{
+	guint n_devices = GPOINTER_TO_UINT (user_data);
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_array GArray *ifindexes = g_array_sized_new (FALSE, FALSE, sizeof (int), n_devices);
+	NMLinuxPlatformNetlinkStats stats;
+	const NMPlatformLink *pllink;
+	GArray *links;
+	char name[64];
+	int ifindex;
+	guint i;
+
+	if (!NM_IS_LINUX_PLATFORM (NM_PLATFORM_GET)) {
+		g_test_skip ("Skip test with fake platform");
+		return;
+	}
+
+	for (i = 0; i < n_devices; i++) {
+		nm_sprintf_buf (name, "t-filter-%03u", i);
+		pllink = nmtstp_link_dummy_add (NULL, FALSE, name);
+		g_array_append_val (ifindexes, pllink->ifindex);
+	}
+	ifindex = g_array_index (ifindexes, int, nmtst_get_rand_int () % n_devices);
+
+	platform = g_object_new (NM_TYPE_LINUX_PLATFORM,
+	                         NM_PLATFORM_REGISTER_SINGLETON, FALSE,
+	                         NM_PLATFORM_NETNS_SUPPORT, TRUE,
+	                         NM_LINUX_PLATFORM_IFINDEX_FILTER, ifindex,
+	                         NULL);
+
+	/* The footprint of a single-interface process must not depend on the
+	 * number of links on the host: only its own link gets cached. */
+	links = nm_platform_link_get_all (platform);
+	g_assert_cmpint (links->len, ==, 1);
+	g_assert_cmpint (g_array_index (links, NMPlatformLink, 0).ifindex, ==, ifindex);
+	g_array_unref (links);
+
+	for (i = 0; i < n_devices; i++) {
+		int other = g_array_index (ifindexes, int, i);
+
+		if (other != ifindex)
+			g_assert (!nm_platform_link_get (platform, other));
+	}
+
+	/* events about other links are dropped as well */
+	nmtstp_link_dummy_add (NULL, FALSE, "t-filter-new");
+	nm_platform_process_events (platform);
+	g_assert (!nm_platform_link_get_by_ifname (platform, "t-filter-new"));
+	nm_linux_platform_get_netlink_stats (platform, &stats);
+	g_assert_cmpint (stats.filtered_messages, >, 0);
+
+	nmtstp_link_set_updown (NULL, FALSE, ifindex, TRUE);
+	nm_platform_process_events (platform);
+	g_assert (NM_FLAGS_HAS (nm_platform_link_get (platform, ifindex)->n_ifi_flags, IFF_UP));
+
+	nmtstp_link_del (NULL, FALSE, nm_platform_link_get_ifindex (NM_PLATFORM_GET, "t-filter-new"), "t-filter-new");
+	for (i = 0; i < n_devices; i++) {
+		nm_sprintf_buf (name, "t-filter-%03u", i);
+		nmtstp_link_del (NULL, FALSE, g_array_index (ifindexes, int, i), name);
+	}
+}
+
+/*****************************************************************************/
+
+static void
+test_resync (void)
+{
+	gs_unref_object NMPlatform *platform = NULL;
+	NMLinuxPlatformNetlinkStats stats;
+	const NMPlatformLink *pllink;
+	GArray *addrs;
+	guint n_addrs = 0;
+	guint resync_messages;
+	int ifindex;
+	int i, j;
+
+	if (!NM_IS_LINUX_PLATFORM (NM_PLATFORM_GET)) {
+		g_test_skip ("Skip test with fake platform");
+		return;
+	}
+
+	pllink = nmtstp_link_dummy_add (NULL, FALSE, "t-resync");
+	ifindex = pllink->ifindex;
+	nmtstp_link_set_updown (NULL, FALSE, ifindex, TRUE);
+
+	platform = g_object_new (NM_TYPE_LINUX_PLATFORM,
+	                         NM_PLATFORM_REGISTER_SINGLETON, FALSE,
+	                         NM_PLATFORM_NETNS_SUPPORT, TRUE,
+	                         NULL);
+
+	/* @platform doesn't read its event socket while the singleton adds
+	 * the addresses, until its receive buffer overruns. */
+	for (i = 0; i < 20; i++) {
+		for (j = 0; j < 500; j++, n_addrs++) {
+			in_addr_t addr = htonl (0x64400000u + n_addrs);
+
+			g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, ifindex, addr, 32, addr,
+			                                       NM_PLATFORM_LIFETIME_PERMANENT,
+			                                       NM_PLATFORM_LIFETIME_PERMANENT,
+			                                       0, NULL));
+		}
+		nm_platform_process_events (platform);
+		nm_linux_platform_get_netlink_stats (platform, &stats);
+		if (stats.overruns > 0)
+			break;
+	}
+
+	if (stats.overruns == 0) {
+		nmtstp_link_del (NULL, FALSE, ifindex, "t-resync");
+		g_test_skip ("Skip test as the receive buffer didn't overrun");
+		return;
+	}
+
+	for (i = 0; i < 10 && !stats.resync_last_ns; i++) {
+		nm_platform_process_events (platform);
+		nm_linux_platform_get_netlink_stats (platform, &stats);
+	}
+
+	/* the resync went through all stages: links, then IPv4 and IPv6
+	 * addresses and routes. */
+	g_assert_cmpint (stats.resync_last_ns, >, 0);
+	g_assert_cmpint (stats.resync_dumps, >=, 5);
+
+	addrs = nm_platform_ip4_address_get_all (platform, ifindex);
+	g_assert_cmpint (addrs->len, ==, n_addrs);
+	g_array_unref (addrs);
+
+	/* once completed, later messages don't count for the resync. */
+	resync_messages = stats.resync_messages;
+	nmtstp_link_set_updown (NULL, FALSE, ifindex, FALSE);
+	nm_platform_process_events (platform);
+	nm_linux_platform_get_netlink_stats (platform, &stats);
+	g_assert_cmpint (stats.resync_messages, ==, resync_messages);
+
+	nmtstp_link_del (NULL, FALSE, ifindex, "t-resync");
+}
+
+/*****************************************************************************/
+
 static void
 test_nl_bugs_veth (void)
 {
@@ -2292,6 +2676,50 @@ test_netns_bind_to_path (gpointer fixture, gconstpointer test_data)
 
 /*****************************************************************************/
 
+static void
+test_netns_new_for_netns (gpointer fixture, gconstpointer test_data)
+{
+	gs_unref_object NMPlatform *platform_0 = NULL;
+	gs_unref_object NMPlatform *platform_1 = NULL;
+	gs_unref_object NMPlatform *platform_2 = NULL;
+	const NMPlatformLink *link;
+
+	if (_test_netns_check_skip ())
+		return;
+
+	platform_0 = nm_linux_platform_new (TRUE);
+	platform_1 = _test_netns_create_platform ();
+
+	g_assert_cmpint (mount ("tmpfs", P_VAR_RUN, "tmpfs", MS_NOATIME | MS_NODEV | MS_NOSUID, "mode=0755,size=32K"), ==, 0);
+	g_assert_cmpint (mkdir (P_VAR_RUN_NETNS, 755), ==, 0);
+
+	g_assert (!nm_linux_platform_new_for_netns (P_VAR_RUN_NETNS_BINDNAME));
+
+	_ADD_DUMMY (platform_1, "dummy3a");
+	g_assert (nmp_netns_bind_to_path (nm_platform_netns_get (platform_1), P_VAR_RUN_NETNS_BINDNAME, NULL));
+
+	/* a second instance for the same namespace sees its links */
+	platform_2 = nm_linux_platform_new_for_netns (P_VAR_RUN_NETNS_BINDNAME);
+	g_assert (NM_IS_LINUX_PLATFORM (platform_2));
+	g_assert (nm_platform_netns_get (platform_2));
+	g_assert (nm_platform_netns_get (platform_2) != nm_platform_netns_get (platform_1));
+
+	link = nm_platform_link_get_by_ifname (platform_2, "dummy3a");
+	g_assert (link);
+	g_assert_cmpint (link->ifindex, ==, nm_platform_link_get_ifindex (platform_1, "dummy3a"));
+	g_assert (!nm_platform_link_get_by_ifname (platform_0, "dummy3a"));
+
+	_ADD_DUMMY (platform_2, "dummy3b");
+	nm_platform_process_events (platform_1);
+	g_assert (nm_platform_link_get_by_ifname (platform_1, "dummy3b"));
+	g_assert (!nm_platform_link_get_by_ifname (platform_0, "dummy3b"));
+
+	g_assert (nmp_netns_bind_to_path_destroy (nm_platform_netns_get (platform_1), P_VAR_RUN_NETNS_BINDNAME));
+	g_assert_cmpint (umount (P_VAR_RUN), ==, 0);
+}
+
+/*****************************************************************************/
+
 void
 _nmtstp_init_tests (int *argc, char ***argv)
 {
@@ -2331,10 +2759,17 @@ _nmtstp_setup_tests (void)
 		test_software_detect_add ("/link/software/detect/vxlan/1", NM_LINK_TYPE_VXLAN, 1);
 
 		g_test_add_func ("/link/software/vlan/set-xgress", test_vlan_set_xgress);
+		g_test_add_func ("/link/software/bond/change", test_bond_change);
+		g_test_add_func ("/link/software/bridge/change", test_bridge_change);
+		g_test_add_func ("/link/software/add-batch", test_link_add_batch);
+		g_test_add_func ("/link/change-attrs", test_link_change_attrs);
 
 		g_test_add_data_func ("/link/create-many-links/20", GUINT_TO_POINTER (20), test_create_many_links);
 		g_test_add_data_func ("/link/create-many-links/1000", GUINT_TO_POINTER (1000), test_create_many_links);
 
+		g_test_add_data_func ("/link/ifindex-filter/50", GUINT_TO_POINTER (50), test_ifindex_filter);
+		g_test_add_func ("/link/resync", test_resync);
+
 		g_test_add_func ("/link/nl-bugs/veth", test_nl_bugs_veth);
 		g_test_add_func ("/link/nl-bugs/spurious-newlink", test_nl_bugs_spuroius_newlink);
 		g_test_add_func ("/link/nl-bugs/spurious-dellink", test_nl_bugs_spuroius_dellink);
@@ -2343,5 +2778,6 @@ _nmtstp_setup_tests (void)
 		g_test_add_vtable ("/general/netns/set-netns", 0, NULL, _test_netns_setup, test_netns_set_netns, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/push", 0, NULL, _test_netns_setup, test_netns_push, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/bind-to-path", 0, NULL, _test_netns_setup, test_netns_bind_to_path, _test_netns_teardown);
+		g_test_add_vtable ("/general/netns/new-for-netns", 0, NULL, _test_netns_setup, test_netns_new_for_netns, _test_netns_teardown);
 	}
 }
@@ -384,6 +384,40 @@ test_cache_link (void)
 
 /******************************************************************/
 
+static void
+test_object_pool (void)
+{
+	const guint n_objects = 2000;
+	const guint n_rounds = nmtst_test_quick () ? 2 : 20;
+	gs_free NMPObject **objs = g_new (NMPObject *, n_objects);
+	guint live0, peak, n_free, live;
+	guint i, j;
+
+	nmp_object_pool_get_stats (NMP_OBJECT_TYPE_IP4_ROUTE, &live0, NULL, NULL);
+
+	for (j = 0; j < n_rounds; j++) {
+		for (i = 0; i < n_objects; i++) {
+			objs[i] = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, NULL);
+			g_assert (objs[i]->ip4_route.ifindex == 0);
+			objs[i]->ip4_route.ifindex = i + 1;
+		}
+		for (i = 0; i < n_objects; i++)
+			nmp_object_unref (objs[i]);
+	}
+
+	nmp_object_pool_get_stats (NMP_OBJECT_TYPE_IP4_ROUTE, &live, &peak, &n_free);
+	g_assert_cmpint (live, ==, live0);
+	g_assert_cmpint (peak, >=, live0 + n_objects);
+	g_assert_cmpint (n_free, >, 0);
+	g_assert_cmpint (n_free, <=, n_objects);
+
+	nmp_object_pool_trim ();
+	nmp_object_pool_get_stats (NMP_OBJECT_TYPE_IP4_ROUTE, NULL, NULL, &n_free);
+	g_assert_cmpint (n_free, ==, 0);
+}
+
+/******************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -410,6 +444,7 @@ main (int argc, char **argv)
 	}
 
 	g_test_add_func ("/nmp-object/cache_link", test_cache_link);
+	g_test_add_func ("/nmp-object/object_pool", test_object_pool);
 
 	result = g_test_run ();
 
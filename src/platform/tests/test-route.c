@@ -24,6 +24,7 @@
 
 #include "nm-core-utils.h"
 #include "nm-platform-utils.h"
+#include "nmp-object.h"
 
 #include "test-common.h"
 
@@ -328,6 +329,96 @@ test_ip4_zero_gateway (void)
 
 /*****************************************************************************/
 
+static void
+test_ip4_route_batch (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	gs_unref_array GArray *batch = NULL;
+	gs_unref_array GArray *routes = NULL;
+	NMPlatformIP4Route route = { 0 };
+	guint i;
+	const guint n_routes = 200;
+
+	route.ifindex = ifindex;
+	route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+	route.plen = 32;
+	route.metric = 22987;
+
+	/* queue many routes at once. */
+	batch = nm_platform_batch_new ();
+	for (i = 0; i < n_routes; i++) {
+		route.network = htonl (0xC6120000u + i); /* from 198.18.0.0/15 (rfc2544) */
+		nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ROUTE, FALSE, &route);
+	}
+	g_assert (nm_platform_batch_commit (NM_PLATFORM_GET, batch));
+	for (i = 0; i < batch->len; i++)
+		g_assert (g_array_index (batch, NMPlatformBatchEntry, i).success);
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes->len, ==, n_routes);
+	g_clear_pointer (&routes, g_array_unref);
+
+	/* and remove them again, also in a single batch. */
+	g_array_set_size (batch, 0);
+	for (i = 0; i < n_routes; i++) {
+		route.network = htonl (0xC6120000u + i);
+		nm_platform_batch_append (batch, NMP_OBJECT_TYPE_IP4_ROUTE, TRUE, &route);
+	}
+	g_assert (nm_platform_batch_commit (NM_PLATFORM_GET, batch));
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes->len, ==, 0);
+}
+
+/*****************************************************************************/
+
+static void
+test_ip4_route_multipath (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	NMPlatformIP4RouteNexthop hops[2] = { { 0 } };
+	const NMPlatformIP4Route *route;
+	const NMPObject *obj;
+	in_addr_t network = nmtst_inet4_from_string ("198.51.100.0");
+	guint32 metric = 22988;
+
+	/* make the gateways reachable. */
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, 24, INADDR_ANY, 0, metric, 0));
+
+	hops[0].ifindex = ifindex;
+	hops[0].gateway = nmtst_inet4_from_string ("198.51.100.1");
+	hops[0].weight = 1;
+	hops[1].ifindex = ifindex;
+	hops[1].gateway = nmtst_inet4_from_string ("198.51.100.2");
+	hops[1].weight = 3;
+
+	g_assert (nm_platform_ip4_route_add_multipath (NM_PLATFORM_GET, NM_IP_CONFIG_SOURCE_USER, 0, 0, metric, 0, hops, G_N_ELEMENTS (hops)));
+
+	/* the route is cached with the first nexthop... */
+	route = nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, 0, 0, metric);
+	g_assert (route);
+	g_assert_cmpint (route->gateway, ==, hops[0].gateway);
+
+	/* ... and the object knows all of them. */
+	obj = NMP_OBJECT_UP_CAST (route);
+	g_assert_cmpint (obj->_ip4_route.n_nexthops, ==, 2);
+	g_assert_cmpint (obj->_ip4_route.nexthops[0].weight, ==, 1);
+	g_assert_cmpint (obj->_ip4_route.nexthops[1].gateway, ==, hops[1].gateway);
+	g_assert_cmpint (obj->_ip4_route.nexthops[1].weight, ==, 3);
+
+	/* replacing it by a single-hop route drops the nexthops. */
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, 0, 0, hops[0].gateway, 0, metric, 0));
+	route = nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, 0, 0, metric);
+	g_assert (route);
+	g_assert_cmpint (NMP_OBJECT_UP_CAST (route)->_ip4_route.n_nexthops, ==, 0);
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, 0, 0, metric));
+	g_assert (!nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, 0, 0, metric));
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network, 24, metric));
+}
+
+/*****************************************************************************/
+
 void
 _nmtstp_init_tests (int *argc, char ***argv)
 {
@@ -350,7 +441,10 @@ _nmtstp_setup_tests (void)
 	g_test_add_func ("/route/ip4", test_ip4_route);
 	g_test_add_func ("/route/ip6", test_ip6_route);
 	g_test_add_func ("/route/ip4_metric0", test_ip4_route_metric0);
+	g_test_add_func ("/route/ip4_batch", test_ip4_route_batch);
 
-	if (nmtstp_is_root_test ())
+	if (nmtstp_is_root_test ()) {
 		g_test_add_func ("/route/ip4_zero_gateway", test_ip4_zero_gateway);
+		g_test_add_func ("/route/ip4_multipath", test_ip4_route_multipath);
+	}
 }
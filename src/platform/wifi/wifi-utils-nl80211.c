@@ -25,9 +25,11 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <net/ethernet.h>
 #include <unistd.h>
 #include <math.h>
+#include <poll.h>
 #include <netlink/netlink.h>
 #include <netlink/msg.h>
 #include <linux/nl80211.h>
@@ -35,6 +37,7 @@
 #include "wifi-utils-private.h"
 #include "wifi-utils-nl80211.h"
 #include "nm-platform.h"
+#include "nmp-netns.h"
 #include "nm-utils.h"
 
 
@@ -139,6 +142,42 @@ genlmsg_parse (struct nlmsghdr *nlh, int hdrlen, struct nlattr *tb[],
  * Reimplementation of libnl3/genl functions:
  *****************************************************************************/
 
+typedef struct {
+	gint32 family_id;
+
+	/* %NULL terminated list of multicast groups to resolve. */
+	const char *const*mcast_names;
+	int *mcast_ids;
+} ProbeResponseData;
+
+static void
+probe_response_mcast_groups (struct nlattr *groups, ProbeResponseData *data)
+{
+	static struct nla_policy mcast_policy[CTRL_ATTR_MCAST_GRP_MAX+1] = {
+		[CTRL_ATTR_MCAST_GRP_NAME] = { .type = NLA_STRING },
+		[CTRL_ATTR_MCAST_GRP_ID]   = { .type = NLA_U32 },
+	};
+	struct nlattr *group;
+	int rem;
+	guint i;
+
+	nla_for_each_nested (group, groups, rem) {
+		struct nlattr *tb[CTRL_ATTR_MCAST_GRP_MAX+1];
+		const char *name;
+
+		if (nla_parse_nested (tb, CTRL_ATTR_MCAST_GRP_MAX, group, mcast_policy) < 0)
+			continue;
+		if (!tb[CTRL_ATTR_MCAST_GRP_NAME] || !tb[CTRL_ATTR_MCAST_GRP_ID])
+			continue;
+
+		name = nla_get_string (tb[CTRL_ATTR_MCAST_GRP_NAME]);
+		for (i = 0; data->mcast_names[i]; i++) {
+			if (strcmp (data->mcast_names[i], name) == 0)
+				data->mcast_ids[i] = nla_get_u32 (tb[CTRL_ATTR_MCAST_GRP_ID]);
+		}
+	}
+}
+
 static int
 probe_response (struct nl_msg *msg, void *arg)
 {
@@ -154,25 +193,41 @@ probe_response (struct nl_msg *msg, void *arg)
 	};
 	struct nlattr *tb[CTRL_ATTR_MAX+1];
 	struct nlmsghdr *nlh = nlmsg_hdr (msg);
-	gint32 *response_data = arg;
+	ProbeResponseData *response_data = arg;
 
 	if (genlmsg_parse (nlh, 0, tb, CTRL_ATTR_MAX, ctrl_policy))
 		return NL_SKIP;
 
 	if (tb[CTRL_ATTR_FAMILY_ID])
-		*response_data = nla_get_u16 (tb[CTRL_ATTR_FAMILY_ID]);
+		response_data->family_id = nla_get_u16 (tb[CTRL_ATTR_FAMILY_ID]);
+
+	if (   tb[CTRL_ATTR_MCAST_GROUPS]
+	    && response_data->mcast_names)
+		probe_response_mcast_groups (tb[CTRL_ATTR_MCAST_GROUPS], response_data);
 
 	return NL_STOP;
 }
 
+/* Resolves the family id of @name. If @mcast_names is given, also resolves
+ * the ids of these multicast groups into @mcast_ids (groups that are not
+ * found are set to -1). */
 static int
-genl_ctrl_resolve (struct nl_sock *sk, const char *name)
+genl_ctrl_resolve (struct nl_sock *sk, const char *name,
+                   const char *const*mcast_names, int *mcast_ids)
 {
 	struct nl_msg *msg;
 	struct nl_cb *cb, *orig;
 	int rc;
 	int result = -NLE_OBJ_NOTFOUND;
-	gint32 response_data = -1;
+	ProbeResponseData response_data = {
+		.family_id = -1,
+		.mcast_names = mcast_names,
+		.mcast_ids = mcast_ids,
+	};
+	guint i;
+
+	for (i = 0; mcast_names && mcast_names[i]; i++)
+		mcast_ids[i] = -1;
 
 	if (!(orig = nl_socket_get_cb (sk)))
 		goto out;
@@ -210,8 +265,8 @@ genl_ctrl_resolve (struct nl_sock *sk, const char *name)
 	if (rc < 0)
 		goto out_msg_free;
 
-	if (response_data > 0)
-		result = response_data;
+	if (response_data.family_id > 0)
+		result = response_data.family_id;
 
 out_msg_free:
 	nlmsg_free (msg);
@@ -229,16 +284,258 @@ out:
  * </libn-genl-3>
  *****************************************************************************/
 
+struct nl80211_bss_info {
+	guint32 freq;
+	guint8 bssid[ETH_ALEN];
+	guint8 ssid[32];
+	guint32 ssid_len;
+	guint32 beacon_signal;
+	gboolean valid;
+};
+
+struct nl80211_station_info {
+	guint32 txrate;
+	gboolean txrate_valid;
+	guint8 signal;
+	gboolean signal_valid;
+};
+
+/* Station info is requested for both the rate and the signal quality,
+ * which are usually read one after the other. Reuse the result
+ * for that long. */
+#define STATION_INFO_MAX_AGE_USEC (1 * G_USEC_PER_SEC)
+
+typedef struct _Nl80211Shared Nl80211Shared;
+
 typedef struct {
 	WifiData parent;
-	struct nl_sock *nl_sock;
-	int id;
-	struct nl_cb *nl_cb;
+	Nl80211Shared *shared;
 	guint32 *freqs;
 	int num_freqs;
 	int phy;
+
+	/* information about the associated BSS. It only changes with
+	 * events of the mlme and scan multicast groups, which invalidate
+	 * the cached value. See nl80211_shared_process_events(). */
+	struct nl80211_bss_info bss_info;
+	gboolean bss_info_cached;
+
+	struct nl80211_station_info sta_info;
+	gint64 sta_info_timestamp;
 } WifiDataNl80211;
 
+/*****************************************************************************/
+
+/* All WifiDataNl80211 instances of one network namespace share a generic
+ * netlink socket for requests, and a socket subscribed to the nl80211
+ * multicast groups. The events on the latter are not processed on the
+ * main loop, instead the pending events are read before using
+ * cached information. If nobody asks, the events just pile up
+ * until the socket buffer overflows, which invalidates everything. */
+struct _Nl80211Shared {
+	int refcount;
+	NMPNetns *netns;
+	struct nl_sock *nl_sock;
+	struct nl_cb *nl_cb;
+	int id;
+	struct nl_sock *nl_event;
+
+	/* ifindex -> WifiDataNl80211 */
+	GHashTable *by_ifindex;
+};
+
+static GHashTable *nl80211_shared_by_netns;
+
+static void
+nl80211_invalidate (WifiDataNl80211 *nl80211)
+{
+	nl80211->bss_info_cached = FALSE;
+	nl80211->sta_info_timestamp = 0;
+}
+
+static void
+nl80211_shared_invalidate_all (Nl80211Shared *shared)
+{
+	GHashTableIter iter;
+	WifiDataNl80211 *nl80211;
+
+	g_hash_table_iter_init (&iter, shared->by_ifindex);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &nl80211))
+		nl80211_invalidate (nl80211);
+}
+
+static int
+nl80211_shared_event_handler (struct nl_msg *msg, void *arg)
+{
+	Nl80211Shared *shared = arg;
+	struct genlmsghdr *gnlh = nlmsg_data (nlmsg_hdr (msg));
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	WifiDataNl80211 *nl80211;
+
+	if (   nla_parse (tb, NL80211_ATTR_MAX, genlmsg_attrdata (gnlh, 0),
+	                  genlmsg_attrlen (gnlh, 0), NULL) < 0
+	    || !tb[NL80211_ATTR_IFINDEX]) {
+		/* for example regulatory changes, which are not specific to one
+		 * interface. */
+		nl80211_shared_invalidate_all (shared);
+		return NL_SKIP;
+	}
+
+	nl80211 = g_hash_table_lookup (shared->by_ifindex,
+	                               GINT_TO_POINTER (nla_get_u32 (tb[NL80211_ATTR_IFINDEX])));
+	if (nl80211)
+		nl80211_invalidate (nl80211);
+	return NL_SKIP;
+}
+
+/* Returns: %FALSE if there are no events, and nothing can be cached. */
+static gboolean
+nl80211_shared_process_events (Nl80211Shared *shared)
+{
+	struct pollfd pfd = { .events = POLLIN, };
+	int err;
+
+	if (!shared->nl_event)
+		return FALSE;
+
+	pfd.fd = nl_socket_get_fd (shared->nl_event);
+
+	while (poll (&pfd, 1, 0) > 0) {
+		if (NM_FLAGS_HAS (pfd.revents, POLLERR)) {
+			int errsv = 0;
+			socklen_t errlen = sizeof (errsv);
+
+			/* the socket buffer overflowed. Reading SO_ERROR clears
+			 * the error, otherwise poll() reports it again and again. */
+			getsockopt (pfd.fd, SOL_SOCKET, SO_ERROR, &errsv, &errlen);
+			nm_log_dbg (LOGD_WIFI, "nl80211: lost events: (%d) %s",
+			            errsv, g_strerror (errsv));
+			nl80211_shared_invalidate_all (shared);
+			continue;
+		}
+		if (!NM_FLAGS_HAS (pfd.revents, POLLIN)) {
+			nl80211_shared_invalidate_all (shared);
+			break;
+		}
+
+		err = nl_recvmsgs_default (shared->nl_event);
+		if (err < 0) {
+			if (err != -NLE_AGAIN) {
+				/* most likely the socket buffer overflowed and we lost
+				 * events. */
+				nm_log_dbg (LOGD_WIFI, "nl80211: error reading events: (%d) %s",
+				            err, nl_geterror (err));
+				nl80211_shared_invalidate_all (shared);
+			}
+			break;
+		}
+	}
+	return TRUE;
+}
+
+static void
+nl80211_shared_unref (Nl80211Shared *shared)
+{
+	g_return_if_fail (shared && shared->refcount > 0);
+
+	if (--shared->refcount > 0)
+		return;
+
+	g_hash_table_remove (nl80211_shared_by_netns, shared->netns);
+	if (g_hash_table_size (nl80211_shared_by_netns) == 0)
+		g_clear_pointer (&nl80211_shared_by_netns, g_hash_table_unref);
+
+	if (shared->nl_sock)
+		nl_socket_free (shared->nl_sock);
+	if (shared->nl_event)
+		nl_socket_free (shared->nl_event);
+	if (shared->nl_cb)
+		nl_cb_put (shared->nl_cb);
+	g_hash_table_unref (shared->by_ifindex);
+	if (shared->netns)
+		g_object_unref (shared->netns);
+	g_slice_free (Nl80211Shared, shared);
+}
+
+static Nl80211Shared *
+nl80211_shared_get (void)
+{
+	static const char *const mcast_names[] = { "mlme", "scan", "regulatory", NULL };
+	int mcast_ids[G_N_ELEMENTS (mcast_names)];
+	Nl80211Shared *shared;
+	NMPNetns *netns;
+	guint i;
+
+	/* the sockets are bound to the netns in which they are created. */
+	netns = nmp_netns_get_current ();
+
+	if (nl80211_shared_by_netns) {
+		shared = g_hash_table_lookup (nl80211_shared_by_netns, netns);
+		if (shared) {
+			shared->refcount++;
+			return shared;
+		}
+	} else
+		nl80211_shared_by_netns = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	shared = g_slice_new0 (Nl80211Shared);
+	shared->refcount = 1;
+	shared->netns = netns ? g_object_ref (netns) : NULL;
+	shared->by_ifindex = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_hash_table_insert (nl80211_shared_by_netns, netns, shared);
+
+	shared->nl_sock = nl_socket_alloc ();
+	if (shared->nl_sock == NULL)
+		goto error;
+
+	if (nl_connect (shared->nl_sock, NETLINK_GENERIC))
+		goto error;
+
+	shared->id = genl_ctrl_resolve (shared->nl_sock, "nl80211", mcast_names, mcast_ids);
+	if (shared->id < 0)
+		goto error;
+
+	shared->nl_cb = nl_cb_alloc (NL_CB_DEFAULT);
+	if (shared->nl_cb == NULL)
+		goto error;
+
+	/* without the events, we cannot cache anything. That is not fatal,
+	 * every request then goes to the kernel. */
+	shared->nl_event = nl_socket_alloc ();
+	if (shared->nl_event == NULL)
+		return shared;
+
+	nl_socket_disable_seq_check (shared->nl_event);
+	nl_socket_modify_cb (shared->nl_event, NL_CB_VALID, NL_CB_CUSTOM,
+	                     nl80211_shared_event_handler, shared);
+
+	if (   nl_connect (shared->nl_event, NETLINK_GENERIC)
+	    || nl_socket_set_nonblocking (shared->nl_event))
+		goto error_event;
+
+	for (i = 0; mcast_names[i]; i++) {
+		if (mcast_ids[i] < 0) {
+			nm_log_dbg (LOGD_WIFI, "nl80211: multicast group \"%s\" not found", mcast_names[i]);
+			goto error_event;
+		}
+		if (nl_socket_add_membership (shared->nl_event, mcast_ids[i]))
+			goto error_event;
+	}
+
+	return shared;
+
+error_event:
+	nl_socket_free (shared->nl_event);
+	shared->nl_event = NULL;
+	return shared;
+
+error:
+	nl80211_shared_unref (shared);
+	return NULL;
+}
+
+/*****************************************************************************/
+
 static int
 ack_handler (struct nl_msg *msg, void *arg)
 {
@@ -285,7 +582,7 @@ _nl80211_alloc_msg (int id, int ifindex, int phy, guint32 cmd, guint32 flags)
 static struct nl_msg *
 nl80211_alloc_msg (WifiDataNl80211 *nl80211, guint32 cmd, guint32 flags)
 {
-	return _nl80211_alloc_msg (nl80211->id, nl80211->parent.ifindex, nl80211->phy, cmd, flags);
+	return _nl80211_alloc_msg (nl80211->shared->id, nl80211->parent.ifindex, nl80211->phy, cmd, flags);
 }
 
 /* NOTE: this function consumes 'msg' */
@@ -353,7 +650,7 @@ nl80211_send_and_recv (WifiDataNl80211 *nl80211,
                        int (*valid_handler) (struct nl_msg *, void *),
                        void *valid_data)
 {
-	return _nl80211_send_and_recv (nl80211->nl_sock, nl80211->nl_cb, msg,
+	return _nl80211_send_and_recv (nl80211->shared->nl_sock, nl80211->shared->nl_cb, msg,
 	                               valid_handler, valid_data);
 }
 
@@ -362,10 +659,11 @@ wifi_nl80211_deinit (WifiData *parent)
 {
 	WifiDataNl80211 *nl80211 = (WifiDataNl80211 *) parent;
 
-	if (nl80211->nl_sock)
-		nl_socket_free (nl80211->nl_sock);
-	if (nl80211->nl_cb)
-		nl_cb_put (nl80211->nl_cb);
+	if (nl80211->shared) {
+		if (g_hash_table_lookup (nl80211->shared->by_ifindex, GINT_TO_POINTER (parent->ifindex)) == nl80211)
+			g_hash_table_remove (nl80211->shared->by_ifindex, GINT_TO_POINTER (parent->ifindex));
+		nl80211_shared_unref (nl80211->shared);
+	}
 	g_free (nl80211->freqs);
 }
 
@@ -443,6 +741,7 @@ wifi_nl80211_set_mode (WifiData *data, const NM80211Mode mode)
 		g_assert_not_reached ();
 	}
 
+	nl80211_invalidate (nl80211);
 	err = nl80211_send_and_recv (nl80211, msg, NULL, NULL);
 	return err ? FALSE : TRUE;
 
@@ -483,15 +782,6 @@ nl80211_xbm_to_percent (gint32 xbm, guint32 divisor)
 			   ((float) SIGNAL_MAX_DBM - (float) NOISE_FLOOR_DBM));
 }
 
-struct nl80211_bss_info {
-	guint32 freq;
-	guint8 bssid[ETH_ALEN];
-	guint8 ssid[32];
-	guint32 ssid_len;
-	guint32 beacon_signal;
-	gboolean valid;
-};
-
 #define WLAN_EID_SSID	0
 
 static void
@@ -562,6 +852,8 @@ nl80211_bss_dump_handler (struct nl_msg *msg, void *arg)
 	if (bss[NL80211_BSS_FREQUENCY])
 		info->freq = nla_get_u32 (bss[NL80211_BSS_FREQUENCY]);
 
+	/* don't keep the signal of another BSS from the same dump */
+	info->beacon_signal = 0;
 	if (bss[NL80211_BSS_SIGNAL_UNSPEC])
 		info->beacon_signal =
 			nla_get_u8 (bss[NL80211_BSS_SIGNAL_UNSPEC]);
@@ -593,12 +885,23 @@ nl80211_get_bss_info (WifiDataNl80211 *nl80211,
                       struct nl80211_bss_info *bss_info)
 {
 	struct nl_msg *msg;
+	gboolean can_cache;
+
+	can_cache = nl80211_shared_process_events (nl80211->shared);
+	if (can_cache && nl80211->bss_info_cached) {
+		*bss_info = nl80211->bss_info;
+		return;
+	}
 
 	memset (bss_info, 0, sizeof (*bss_info));
 
 	msg = nl80211_alloc_msg (nl80211, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
 
-	nl80211_send_and_recv (nl80211, msg, nl80211_bss_dump_handler, bss_info);
+	if (   nl80211_send_and_recv (nl80211, msg, nl80211_bss_dump_handler, bss_info) >= 0
+	    && can_cache) {
+		nl80211->bss_info = *bss_info;
+		nl80211->bss_info_cached = TRUE;
+	}
 }
 
 static guint32
@@ -642,13 +945,6 @@ wifi_nl80211_get_bssid (WifiData *data, guint8 *out_bssid)
 	return bss_info.valid;
 }
 
-struct nl80211_station_info {
-	guint32 txrate;
-	gboolean txrate_valid;
-	guint8 signal;
-	gboolean signal_valid;
-};
-
 static int
 nl80211_station_handler (struct nl_msg *msg, void *arg)
 {
@@ -718,6 +1014,7 @@ nl80211_get_ap_info (WifiDataNl80211 *nl80211,
 {
 	struct nl_msg *msg;
 	struct nl80211_bss_info bss_info;
+	gint64 now;
 
 	memset (sta_info, 0, sizeof (*sta_info));
 
@@ -725,15 +1022,27 @@ nl80211_get_ap_info (WifiDataNl80211 *nl80211,
 	if (!bss_info.valid)
 		return;
 
+	now = g_get_monotonic_time ();
+	if (   nl80211->sta_info_timestamp
+	    && now - nl80211->sta_info_timestamp < STATION_INFO_MAX_AGE_USEC) {
+		*sta_info = nl80211->sta_info;
+		if (!sta_info->signal_valid)
+			sta_info->signal = bss_info.beacon_signal;
+		return;
+	}
+
 	msg = nl80211_alloc_msg (nl80211, NL80211_CMD_GET_STATION, 0);
 	if (msg) {
 		NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bss_info.bssid);
 
-		nl80211_send_and_recv (nl80211, msg, nl80211_station_handler, sta_info);
+		if (nl80211_send_and_recv (nl80211, msg, nl80211_station_handler, sta_info) < 0)
+			return;
 		if (!sta_info->signal_valid) {
 			/* Fall back to bss_info signal quality (both are in percent) */
 			sta_info->signal = bss_info.beacon_signal;
 		}
+		nl80211->sta_info = *sta_info;
+		nl80211->sta_info_timestamp = now;
 	}
 
 	return;
@@ -1050,19 +1359,8 @@ wifi_nl80211_init (const char *iface, int ifindex)
 #endif
 	nl80211->parent.deinit = wifi_nl80211_deinit;
 
-	nl80211->nl_sock = nl_socket_alloc ();
-	if (nl80211->nl_sock == NULL)
-		goto error;
-
-	if (nl_connect (nl80211->nl_sock, NETLINK_GENERIC))
-		goto error;
-
-	nl80211->id = genl_ctrl_resolve (nl80211->nl_sock, "nl80211");
-	if (nl80211->id < 0)
-		goto error;
-
-	nl80211->nl_cb = nl_cb_alloc (NL_CB_DEFAULT);
-	if (nl80211->nl_cb == NULL)
+	nl80211->shared = nl80211_shared_get ();
+	if (nl80211->shared == NULL)
 		goto error;
 
 	nl80211->phy = -1;
@@ -1120,6 +1418,8 @@ wifi_nl80211_init (const char *iface, int ifindex)
 	if (device_info.can_wowlan)
 		nl80211->parent.get_wowlan = wifi_nl80211_get_wowlan;
 
+	g_hash_table_insert (nl80211->shared->by_ifindex, GINT_TO_POINTER (ifindex), nl80211);
+
 	nm_log_info (LOGD_HW | LOGD_WIFI,
 	             "(%s): using nl80211 for WiFi device control",
 	             nl80211->parent.iface);
@@ -80,8 +80,7 @@ typedef struct {
 
 	/* Monitoring */
 	char *ip_iface;
-	int monitor_fd;
-	guint monitor_id;
+	gboolean monitoring;
 } NMPPPManagerPrivate;
 
 #define NM_PPP_MANAGER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_PPP_MANAGER, NMPPPManagerPrivate))
@@ -105,10 +104,21 @@ enum {
 	LAST_PROP
 };
 
+/* Statistics of all sessions are polled with one socket and one timer,
+ * so that many concurrent sessions don't cost a descriptor and a wakeup
+ * each.
+ */
+static struct {
+	int fd;
+	guint timeout_id;
+	GSList *managers;
+} monitor = {
+	.fd = -1,
+};
+
 static void
 nm_ppp_manager_init (NMPPPManager *manager)
 {
-	NM_PPP_MANAGER_GET_PRIVATE (manager)->monitor_fd = -1;
 }
 
 static void
@@ -180,10 +190,9 @@ nm_ppp_manager_new (const char *iface)
 
 /*******************************************/
 
-static gboolean
-monitor_cb (gpointer user_data)
+static void
+monitor_read (NMPPPManager *manager)
 {
-	NMPPPManager *manager = NM_PPP_MANAGER (user_data);
 	NMPPPManagerPrivate *priv = NM_PPP_MANAGER_GET_PRIVATE (manager);
 	struct ifreq req;
 	struct ppp_stats stats;
@@ -193,7 +202,7 @@ monitor_cb (gpointer user_data)
 	req.ifr_data = (caddr_t) &stats;
 
 	strncpy (req.ifr_name, priv->ip_iface, sizeof (req.ifr_name));
-	if (ioctl (priv->monitor_fd, SIOCGPPPSTATS, &req) < 0) {
+	if (ioctl (monitor.fd, SIOCGPPPSTATS, &req) < 0) {
 		if (errno != ENODEV)
 			_LOGW ("could not read ppp stats: %s", strerror (errno));
 	} else {
@@ -201,8 +210,22 @@ monitor_cb (gpointer user_data)
 		               stats.p.ppp_ibytes,
 		               stats.p.ppp_obytes);
 	}
+}
+
+static gboolean
+monitor_cb (gpointer user_data)
+{
+	GSList *managers, *iter;
+
+	/* A stats handler might stop a session */
+	managers = g_slist_copy (monitor.managers);
+	for (iter = managers; iter; iter = iter->next) {
+		if (g_slist_find (monitor.managers, iter->data))
+			monitor_read (iter->data);
+	}
+	g_slist_free (managers);
 
-	return TRUE;
+	return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -211,17 +234,41 @@ monitor_stats (NMPPPManager *manager)
 	NMPPPManagerPrivate *priv = NM_PPP_MANAGER_GET_PRIVATE (manager);
 
 	/* already monitoring */
-	if (priv->monitor_fd >= 0)
+	if (priv->monitoring)
 		return;
 
-	priv->monitor_fd = socket (AF_INET, SOCK_DGRAM, 0);
-	if (priv->monitor_fd >= 0) {
-		g_warn_if_fail (priv->monitor_id == 0);
-		if (priv->monitor_id)
-			g_source_remove (priv->monitor_id);
-		priv->monitor_id = g_timeout_add_seconds (5, monitor_cb, manager);
-	} else
-		_LOGW ("could not monitor PPP stats: %s", strerror (errno));
+	if (monitor.fd < 0) {
+		monitor.fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (monitor.fd < 0) {
+			_LOGW ("could not monitor PPP stats: %s", strerror (errno));
+			return;
+		}
+	}
+
+	priv->monitoring = TRUE;
+	monitor.managers = g_slist_prepend (monitor.managers, manager);
+	if (!monitor.timeout_id)
+		monitor.timeout_id = g_timeout_add_seconds (5, monitor_cb, NULL);
+}
+
+static void
+monitor_stop (NMPPPManager *manager)
+{
+	NMPPPManagerPrivate *priv = NM_PPP_MANAGER_GET_PRIVATE (manager);
+
+	if (!priv->monitoring)
+		return;
+
+	/* Get the stats one last time */
+	monitor_read (manager);
+
+	priv->monitoring = FALSE;
+	monitor.managers = g_slist_remove (monitor.managers, manager);
+	if (!monitor.managers) {
+		nm_clear_g_source (&monitor.timeout_id);
+		close (monitor.fd);
+		monitor.fd = -1;
+	}
 }
 
 /*******************************************/
@@ -1135,14 +1182,7 @@ _ppp_cleanup (NMPPPManager *manager)
 
 	cancel_get_secrets (manager);
 
-	nm_clear_g_source (&priv->monitor_id);
-
-	if (priv->monitor_fd >= 0) {
-		/* Get the stats one last time */
-		monitor_cb (manager);
-		close (priv->monitor_fd);
-		priv->monitor_fd = -1;
-	}
+	monitor_stop (manager);
 
 	nm_clear_g_source (&priv->ppp_timeout_handler);
 	nm_clear_g_source (&priv->ppp_watch_id);
@@ -35,12 +35,22 @@
 
 #define _NMLOG_PREFIX_NAME                "rdisc-lndp"
 
+/* One libndp instance (and thus one ICMPv6 socket) is shared by all the
+ * rdisc instances of a network namespace. libndp reads the incoming
+ * interface from IPV6_PKTINFO and dispatches each RA only to the handler
+ * registered for that ifindex. */
 typedef struct {
+	int refcount;
+	NMPNetns *netns;
 	struct ndp *ndp;
 
 	GIOChannel *event_channel;
 	guint event_id;
-	guint ra_timeout_id;  /* first RA timeout */
+} SharedNdp;
+
+typedef struct {
+	SharedNdp *shared;
+	gboolean handler_registered;
 } NMLNDPRDiscPrivate;
 
 #define NM_LNDP_RDISC_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_LNDP_RDISC, NMLNDPRDiscPrivate))
@@ -65,7 +75,7 @@ send_rs (NMRDisc *rdisc, GError **error)
 	}
 	ndp_msg_ifindex_set (msg, rdisc->ifindex);
 
-	errsv = ndp_msg_send (priv->ndp, msg);
+	errsv = ndp_msg_send (priv->shared->ndp, msg);
 	ndp_msg_destroy (msg);
 	if (errsv) {
 		errsv = errsv > 0 ? errsv : -errsv;
@@ -279,34 +289,99 @@ receive_ra (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
 	return 0;
 }
 
+/******************************************************************/
+
+static GSList *shared_ndps;
+
 static gboolean
-event_ready (GIOChannel *source, GIOCondition condition, NMRDisc *rdisc)
+shared_ndp_event_ready (GIOChannel *source, GIOCondition condition, SharedNdp *shared)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
-	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
 
-	_LOGD ("processing libndp events");
+	nm_log_dbg (LOGD_IP6, "rdisc-lndp: processing libndp events");
 
-	if (!nm_rdisc_netns_push (rdisc, &netns))
-		return G_SOURCE_CONTINUE;
+	if (shared->netns) {
+		if (!nmp_netns_push (shared->netns))
+			return G_SOURCE_CONTINUE;
+		netns = shared->netns;
+	}
 
-	ndp_callall_eventfd_handler (priv->ndp);
+	ndp_callall_eventfd_handler (shared->ndp);
 	return G_SOURCE_CONTINUE;
 }
 
+/* Must be called with @netns being the current namespace. */
+static SharedNdp *
+shared_ndp_acquire (NMPNetns *netns, GError **error)
+{
+	SharedNdp *shared;
+	struct ndp *ndp;
+	GSList *iter;
+	int errsv;
+
+	for (iter = shared_ndps; iter; iter = iter->next) {
+		shared = iter->data;
+		if (shared->netns == netns) {
+			shared->refcount++;
+			return shared;
+		}
+	}
+
+	errsv = ndp_open (&ndp);
+	if (errsv != 0) {
+		errsv = errsv > 0 ? errsv : -errsv;
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "failure creating libndp socket: %s (%d)",
+		             g_strerror (errsv), errsv);
+		return NULL;
+	}
+
+	shared = g_slice_new0 (SharedNdp);
+	shared->refcount = 1;
+	shared->netns = netns ? g_object_ref (netns) : NULL;
+	shared->ndp = ndp;
+	shared->event_channel = g_io_channel_unix_new (ndp_get_eventfd (ndp));
+	shared->event_id = g_io_add_watch (shared->event_channel, G_IO_IN,
+	                                   (GIOFunc) shared_ndp_event_ready, shared);
+
+	shared_ndps = g_slist_prepend (shared_ndps, shared);
+	nm_log_dbg (LOGD_IP6, "rdisc-lndp: opened shared libndp socket %d", ndp_get_eventfd (ndp));
+	return shared;
+}
+
+static void
+shared_ndp_release (SharedNdp *shared)
+{
+	g_return_if_fail (shared->refcount > 0);
+
+	if (--shared->refcount > 0)
+		return;
+
+	shared_ndps = g_slist_remove (shared_ndps, shared);
+
+	nm_clear_g_source (&shared->event_id);
+	g_clear_pointer (&shared->event_channel, g_io_channel_unref);
+
+	nm_log_dbg (LOGD_IP6, "rdisc-lndp: closing shared libndp socket %d", ndp_get_eventfd (shared->ndp));
+	ndp_close (shared->ndp);
+
+	g_clear_object (&shared->netns);
+	g_slice_free (SharedNdp, shared);
+}
+
+/******************************************************************/
+
 static void
 start (NMRDisc *rdisc)
 {
 	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
-	int fd = ndp_get_eventfd (priv->ndp);
-
-	priv->event_channel = g_io_channel_unix_new (fd);
-	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, (GIOFunc) event_ready, rdisc);
 
-	/* Flush any pending messages to avoid using obsolete information */
-	event_ready (priv->event_channel, 0, rdisc);
+	/* Flush any pending messages to avoid using obsolete information.
+	 * Messages for other interfaces are dispatched to their handlers. */
+	shared_ndp_event_ready (priv->shared->event_channel, 0, priv->shared);
 
-	ndp_msgrcv_handler_register (priv->ndp, receive_ra, NDP_MSG_RA, rdisc->ifindex, rdisc);
+	ndp_msgrcv_handler_register (priv->shared->ndp, receive_ra, NDP_MSG_RA, rdisc->ifindex, rdisc);
+	priv->handler_registered = TRUE;
 }
 
 /******************************************************************/
@@ -328,7 +403,6 @@ nm_lndp_rdisc_new (NMPlatform *platform,
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMRDisc *rdisc;
 	NMLNDPRDiscPrivate *priv;
-	int errsv;
 
 	g_return_val_if_fail (NM_IS_PLATFORM (platform), NULL);
 	g_return_val_if_fail (!error || !*error, NULL);
@@ -354,13 +428,8 @@ nm_lndp_rdisc_new (NMPlatform *platform,
 
 	priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
 
-	errsv = ndp_open (&priv->ndp);
-
-	if (errsv != 0) {
-		errsv = errsv > 0 ? errsv : -errsv;
-		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
-		             "failure creating libndp socket: %s (%d)",
-		             g_strerror (errsv), errsv);
+	priv->shared = shared_ndp_acquire (nm_rdisc_netns_get (rdisc), error);
+	if (!priv->shared) {
 		g_object_unref (rdisc);
 		return NULL;
 	}
@@ -378,13 +447,12 @@ dispose (GObject *object)
 	NMLNDPRDisc *rdisc = NM_LNDP_RDISC (object);
 	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
 
-	nm_clear_g_source (&priv->event_id);
-	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
-
-	if (priv->ndp) {
-		ndp_msgrcv_handler_unregister (priv->ndp, receive_ra, NDP_MSG_RA, NM_RDISC (rdisc)->ifindex, rdisc);
-		ndp_close (priv->ndp);
-		priv->ndp = NULL;
+	if (priv->shared) {
+		if (priv->handler_registered) {
+			ndp_msgrcv_handler_unregister (priv->shared->ndp, receive_ra, NDP_MSG_RA, NM_RDISC (rdisc)->ifindex, rdisc);
+			priv->handler_registered = FALSE;
+		}
+		g_clear_pointer (&priv->shared, shared_ndp_release);
 	}
 
 	G_OBJECT_CLASS (nm_lndp_rdisc_parent_class)->dispose (object);
@@ -43,7 +43,7 @@ gboolean nm_rdisc_add_dns_domain           (NMRDisc *rdisc, const NMRDiscDNSDoma
         const NMLogLevel __level = (level); \
         const NMLogDomain __domain = (domain); \
         \
-        if (nm_logging_enabled (__level, __domain)) { \
+        if (_nm_logging_wanted (__level, __domain)) { \
             char __prefix[64]; \
             const char *__p_prefix = _NMLOG_PREFIX_NAME; \
             const NMRDisc *const __self = (self); \
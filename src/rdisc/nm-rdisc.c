@@ -30,6 +30,7 @@
 #include "nm-utils.h"
 #include "nm-platform.h"
 #include "nmp-netns.h"
+#include "nm-statistics.h"
 
 #include <nm-setting-ip6-config.h>
 
@@ -42,8 +43,22 @@ typedef struct {
 	guint ra_timeout_id;  /* first RA timeout */
 	guint timeout_id;   /* prefix/dns/etc lifetime timeout */
 	char *last_send_rs_error;
+
+	/* min-heap of ExpiryEntry, ordered by the time of the next event */
+	GPtrArray *expiry_heap;
+	/* ExpiryEntry indexed by kind and item identity */
+	GHashTable *expiry_entries;
+
+	/* received router advertisements */
+	guint64 ra_received;
+	gint32 ra_window_start;
+	guint ra_window_count;
+	guint ra_rate;
 } NMRDiscPrivate;
 
+/* length of the window over which the RA rate is computed, in seconds */
+#define RA_RATE_WINDOW 60
+
 #define NM_RDISC_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_RDISC, NMRDiscPrivate))
 
 G_DEFINE_TYPE (NMRDisc, nm_rdisc, G_TYPE_OBJECT)
@@ -87,11 +102,336 @@ nm_rdisc_netns_push (NMRDisc *self, NMPNetns **netns)
 
 /******************************************************************/
 
+/* Every item with a finite lifetime has one ExpiryEntry for the time of its
+ * next event: its expiry or, for DNS servers and domains, the time to
+ * solicit a refresh. The entries form a min-heap, so that check_timestamps()
+ * only looks at what is due instead of walking all the items. */
+
+typedef enum {
+	EXPIRY_GATEWAY,
+	EXPIRY_ADDRESS,
+	EXPIRY_ROUTE,
+	EXPIRY_DNS_SERVER,
+	EXPIRY_DNS_DOMAIN,
+} ExpiryKind;
+
+typedef struct {
+	ExpiryKind kind;
+	union {
+		struct in6_addr address;
+		struct {
+			struct in6_addr network;
+			int plen;
+		} route;
+		char *domain;
+	} key;
+
+	guint64 when;
+	/* whether @when is the refresh time of a DNS item rather than its expiry */
+	gboolean refresh;
+	guint heap_idx;
+} ExpiryEntry;
+
+#define EXPIRY_NEVER G_MAXUINT64
+
+static guint
+expiry_entry_hash (gconstpointer data)
+{
+	const ExpiryEntry *entry = data;
+	guint h = entry->kind;
+
+	switch (entry->kind) {
+	case EXPIRY_DNS_DOMAIN:
+		return h ^ g_str_hash (entry->key.domain);
+	case EXPIRY_ROUTE:
+		h ^= entry->key.route.plen;
+		/* fall through */
+	default:
+		/* the network of a route is at the same offset as the address */
+		return h ^ entry->key.address.s6_addr32[0]
+		         ^ entry->key.address.s6_addr32[1]
+		         ^ entry->key.address.s6_addr32[2]
+		         ^ entry->key.address.s6_addr32[3];
+	}
+}
+
+static gboolean
+expiry_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const ExpiryEntry *ea = a, *eb = b;
+
+	if (ea->kind != eb->kind)
+		return FALSE;
+
+	switch (ea->kind) {
+	case EXPIRY_DNS_DOMAIN:
+		return !g_strcmp0 (ea->key.domain, eb->key.domain);
+	case EXPIRY_ROUTE:
+		return    ea->key.route.plen == eb->key.route.plen
+		       && IN6_ARE_ADDR_EQUAL (&ea->key.route.network, &eb->key.route.network);
+	default:
+		return IN6_ARE_ADDR_EQUAL (&ea->key.address, &eb->key.address);
+	}
+}
+
+static void
+expiry_entry_free (gpointer data)
+{
+	ExpiryEntry *entry = data;
+
+	if (entry->kind == EXPIRY_DNS_DOMAIN)
+		g_free (entry->key.domain);
+	g_slice_free (ExpiryEntry, entry);
+}
+
+static void
+expiry_key_init (ExpiryEntry *key, ExpiryKind kind, gconstpointer item)
+{
+	memset (key, 0, sizeof (*key));
+	key->kind = kind;
+
+	switch (kind) {
+	case EXPIRY_GATEWAY:
+		key->key.address = ((const NMRDiscGateway *) item)->address;
+		break;
+	case EXPIRY_ADDRESS:
+		key->key.address = ((const NMRDiscAddress *) item)->address;
+		break;
+	case EXPIRY_ROUTE:
+		key->key.route.network = ((const NMRDiscRoute *) item)->network;
+		key->key.route.plen = ((const NMRDiscRoute *) item)->plen;
+		break;
+	case EXPIRY_DNS_SERVER:
+		key->key.address = ((const NMRDiscDNSServer *) item)->address;
+		break;
+	case EXPIRY_DNS_DOMAIN:
+		key->key.domain = ((const NMRDiscDNSDomain *) item)->domain;
+		break;
+	}
+}
+
+static guint64
+expiry_compute (ExpiryKind kind, gconstpointer item, gboolean refresh)
+{
+	guint32 timestamp, lifetime;
+
+	switch (kind) {
+	case EXPIRY_GATEWAY:
+		timestamp = ((const NMRDiscGateway *) item)->timestamp;
+		lifetime = ((const NMRDiscGateway *) item)->lifetime;
+		break;
+	case EXPIRY_ADDRESS:
+		timestamp = ((const NMRDiscAddress *) item)->timestamp;
+		lifetime = ((const NMRDiscAddress *) item)->lifetime;
+		break;
+	case EXPIRY_ROUTE:
+		timestamp = ((const NMRDiscRoute *) item)->timestamp;
+		lifetime = ((const NMRDiscRoute *) item)->lifetime;
+		break;
+	case EXPIRY_DNS_SERVER:
+		timestamp = ((const NMRDiscDNSServer *) item)->timestamp;
+		lifetime = ((const NMRDiscDNSServer *) item)->lifetime;
+		break;
+	case EXPIRY_DNS_DOMAIN:
+		timestamp = ((const NMRDiscDNSDomain *) item)->timestamp;
+		lifetime = ((const NMRDiscDNSDomain *) item)->lifetime;
+		break;
+	default:
+		g_return_val_if_reached (EXPIRY_NEVER);
+	}
+
+	if (lifetime == 0 || lifetime == G_MAXUINT32)
+		return EXPIRY_NEVER;
+
+	if (refresh)
+		return (guint64) timestamp + lifetime / 2;
+	return (guint64) timestamp + lifetime;
+}
+
+static void
+heap_swap (GPtrArray *heap, guint a, guint b)
+{
+	ExpiryEntry *ea = heap->pdata[a], *eb = heap->pdata[b];
+
+	heap->pdata[a] = eb;
+	heap->pdata[b] = ea;
+	eb->heap_idx = a;
+	ea->heap_idx = b;
+}
+
+static void
+heap_fix (GPtrArray *heap, guint idx)
+{
+	/* sift up */
+	while (idx > 0) {
+		guint parent = (idx - 1) / 2;
+
+		if (((ExpiryEntry *) heap->pdata[parent])->when <= ((ExpiryEntry *) heap->pdata[idx])->when)
+			break;
+		heap_swap (heap, parent, idx);
+		idx = parent;
+	}
+
+	/* sift down */
+	for (;;) {
+		guint child = 2 * idx + 1, smallest = idx;
+
+		if (   child < heap->len
+		    && ((ExpiryEntry *) heap->pdata[child])->when < ((ExpiryEntry *) heap->pdata[smallest])->when)
+			smallest = child;
+		child++;
+		if (   child < heap->len
+		    && ((ExpiryEntry *) heap->pdata[child])->when < ((ExpiryEntry *) heap->pdata[smallest])->when)
+			smallest = child;
+		if (smallest == idx)
+			break;
+		heap_swap (heap, smallest, idx);
+		idx = smallest;
+	}
+}
+
+static void
+expiry_remove (NMRDisc *rdisc, ExpiryEntry *entry)
+{
+	NMRDiscPrivate *priv = NM_RDISC_GET_PRIVATE (rdisc);
+	GPtrArray *heap = priv->expiry_heap;
+	guint idx = entry->heap_idx, last = heap->len - 1;
+
+	if (idx != last)
+		heap_swap (heap, idx, last);
+	g_ptr_array_set_size (heap, last);
+	if (idx < heap->len)
+		heap_fix (heap, idx);
+
+	/* frees @entry */
+	g_hash_table_remove (priv->expiry_entries, entry);
+}
+
+/**
+ * expiry_update:
+ * @rdisc: the #NMRDisc
+ * @kind: the kind of @item
+ * @item: the item that was added or changed, or an item with zero lifetime
+ *   to forget about the expiry of a removed item
+ *
+ * Schedules the next event for @item.
+ */
+static void
+expiry_update (NMRDisc *rdisc, ExpiryKind kind, gconstpointer item)
+{
+	NMRDiscPrivate *priv = NM_RDISC_GET_PRIVATE (rdisc);
+	ExpiryEntry key, *entry;
+	gboolean refresh = (kind == EXPIRY_DNS_SERVER || kind == EXPIRY_DNS_DOMAIN);
+	guint64 when;
+
+	expiry_key_init (&key, kind, item);
+	entry = g_hash_table_lookup (priv->expiry_entries, &key);
+
+	when = expiry_compute (kind, item, refresh);
+	if (when == EXPIRY_NEVER) {
+		if (entry)
+			expiry_remove (rdisc, entry);
+		return;
+	}
+
+	if (!entry) {
+		entry = g_slice_new (ExpiryEntry);
+		*entry = key;
+		if (kind == EXPIRY_DNS_DOMAIN)
+			entry->key.domain = g_strdup (key.key.domain);
+		entry->heap_idx = priv->expiry_heap->len;
+		g_ptr_array_add (priv->expiry_heap, entry);
+		g_hash_table_add (priv->expiry_entries, entry);
+	}
+
+	entry->when = when;
+	entry->refresh = refresh;
+	heap_fix (priv->expiry_heap, entry->heap_idx);
+}
+
+static GArray *
+expiry_get_array (NMRDisc *rdisc, ExpiryKind kind)
+{
+	switch (kind) {
+	case EXPIRY_GATEWAY:
+		return rdisc->gateways;
+	case EXPIRY_ADDRESS:
+		return rdisc->addresses;
+	case EXPIRY_ROUTE:
+		return rdisc->routes;
+	case EXPIRY_DNS_SERVER:
+		return rdisc->dns_servers;
+	case EXPIRY_DNS_DOMAIN:
+		return rdisc->dns_domains;
+	}
+	g_return_val_if_reached (NULL);
+}
+
+static const NMRDiscConfigMap expiry_config_map[] = {
+	[EXPIRY_GATEWAY]    = NM_RDISC_CONFIG_GATEWAYS,
+	[EXPIRY_ADDRESS]    = NM_RDISC_CONFIG_ADDRESSES,
+	[EXPIRY_ROUTE]      = NM_RDISC_CONFIG_ROUTES,
+	[EXPIRY_DNS_SERVER] = NM_RDISC_CONFIG_DNS_SERVERS,
+	[EXPIRY_DNS_DOMAIN] = NM_RDISC_CONFIG_DNS_DOMAINS,
+};
+
+/* Handles the event of @entry, which is due. */
+static void
+expiry_handle (NMRDisc *rdisc,
+               ExpiryEntry *entry,
+               NMRDiscConfigMap *changed,
+               gboolean *need_solicit)
+{
+	NMRDiscPrivate *priv = NM_RDISC_GET_PRIVATE (rdisc);
+	GArray *array = expiry_get_array (rdisc, entry->kind);
+	gpointer item = NULL;
+	guint64 when;
+	guint i;
+
+	for (i = 0; i < array->len; i++) {
+		ExpiryEntry key;
+
+		item = array->data + i * g_array_get_element_size (array);
+		expiry_key_init (&key, entry->kind, item);
+		if (expiry_entry_equal (&key, entry))
+			break;
+	}
+
+	if (i == array->len) {
+		/* the item was removed */
+		expiry_remove (rdisc, entry);
+		return;
+	}
+
+	when = expiry_compute (entry->kind, item, entry->refresh);
+	if (when != entry->when) {
+		/* the item changed without expiry_update() */
+		expiry_update (rdisc, entry->kind, item);
+		return;
+	}
+
+	if (entry->refresh) {
+		*need_solicit = TRUE;
+		entry->refresh = FALSE;
+		entry->when = expiry_compute (entry->kind, item, FALSE);
+		heap_fix (priv->expiry_heap, entry->heap_idx);
+		return;
+	}
+
+	*changed |= expiry_config_map[entry->kind];
+	expiry_remove (rdisc, entry);
+	g_array_remove_index (array, i);
+}
+
+/******************************************************************/
+
 gboolean
 nm_rdisc_add_gateway (NMRDisc *rdisc, const NMRDiscGateway *new)
 {
 	int i, insert_idx = -1;
 
+	expiry_update (rdisc, EXPIRY_GATEWAY, new);
+
 	for (i = 0; i < rdisc->gateways->len; i++) {
 		NMRDiscGateway *item = &g_array_index (rdisc->gateways, NMRDiscGateway, i);
 
@@ -177,6 +517,8 @@ nm_rdisc_complete_and_add_address (NMRDisc *rdisc, NMRDiscAddress *new)
 	if (!complete_address (rdisc, new))
 		return FALSE;
 
+	expiry_update (rdisc, EXPIRY_ADDRESS, new);
+
 	for (i = 0; i < rdisc->addresses->len; i++) {
 		NMRDiscAddress *item = &g_array_index (rdisc->addresses, NMRDiscAddress, i);
 
@@ -215,6 +557,8 @@ nm_rdisc_add_route (NMRDisc *rdisc, const NMRDiscRoute *new)
 	if (new->plen == 0 || new->plen > 128)
 		return FALSE;
 
+	expiry_update (rdisc, EXPIRY_ROUTE, new);
+
 	for (i = 0; i < rdisc->routes->len; i++) {
 		NMRDiscRoute *item = &g_array_index (rdisc->routes, NMRDiscRoute, i);
 
@@ -248,6 +592,8 @@ nm_rdisc_add_dns_server (NMRDisc *rdisc, const NMRDiscDNSServer *new)
 {
 	int i;
 
+	expiry_update (rdisc, EXPIRY_DNS_SERVER, new);
+
 	for (i = 0; i < rdisc->dns_servers->len; i++) {
 		NMRDiscDNSServer *item = &g_array_index (rdisc->dns_servers, NMRDiscDNSServer, i);
 
@@ -276,6 +622,8 @@ nm_rdisc_add_dns_domain (NMRDisc *rdisc, const NMRDiscDNSDomain *new)
 	NMRDiscDNSDomain *item;
 	int i;
 
+	expiry_update (rdisc, EXPIRY_DNS_DOMAIN, new);
+
 	for (i = 0; i < rdisc->dns_domains->len; i++) {
 		item = &g_array_index (rdisc->dns_domains, NMRDiscDNSDomain, i);
 
@@ -459,6 +807,8 @@ nm_rdisc_dad_failed (NMRDisc *rdisc, struct in6_addr *address)
 		_LOGD ("DAD failed for discovered address %s", nm_utils_inet6_ntop (address, NULL));
 		if (!complete_address (rdisc, item))
 			g_array_remove_index (rdisc->addresses, i--);
+		else
+			expiry_update (rdisc, EXPIRY_ADDRESS, item);
 		changed = TRUE;
 	}
 
@@ -548,138 +898,34 @@ config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed)
 	}
 }
 
-static void
-clean_gateways (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->gateways->len; i++) {
-		NMRDiscGateway *item = &g_array_index (rdisc->gateways, NMRDiscGateway, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->gateways, i--);
-			*changed |= NM_RDISC_CONFIG_GATEWAYS;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_addresses (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->addresses->len; i++) {
-		NMRDiscAddress *item = &g_array_index (rdisc->addresses, NMRDiscAddress, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->addresses, i--);
-			*changed |= NM_RDISC_CONFIG_ADDRESSES;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_routes (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->routes->len; i++) {
-		NMRDiscRoute *item = &g_array_index (rdisc->routes, NMRDiscRoute, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->routes, i--);
-			*changed |= NM_RDISC_CONFIG_ROUTES;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_dns_servers (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->dns_servers->len; i++) {
-		NMRDiscDNSServer *item = &g_array_index (rdisc->dns_servers, NMRDiscDNSServer, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-		guint64 refresh = (guint64) item->timestamp + item->lifetime / 2;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->dns_servers, i--);
-			*changed |= NM_RDISC_CONFIG_DNS_SERVERS;
-		} else if (now >= refresh)
-			solicit (rdisc);
-		else if (*nextevent > refresh)
-			*nextevent = refresh;
-	}
-}
-
-static void
-clean_dns_domains (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->dns_domains->len; i++) {
-		NMRDiscDNSDomain *item = &g_array_index (rdisc->dns_domains, NMRDiscDNSDomain, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-		guint64 refresh = (guint64) item->timestamp + item->lifetime / 2;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->dns_domains, i--);
-			*changed |= NM_RDISC_CONFIG_DNS_DOMAINS;
-		} else if (now >= refresh)
-			solicit (rdisc);
-		else if (*nextevent > refresh)
-			*nextevent = refresh;
-	}
-}
-
 static gboolean timeout_cb (gpointer user_data);
 
 static void
 check_timestamps (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap changed)
 {
 	NMRDiscPrivate *priv = NM_RDISC_GET_PRIVATE (rdisc);
-	/* Use a magic date in the distant future (~68 years) */
-	guint32 never = G_MAXINT32;
-	guint32 nextevent = never;
+	GPtrArray *heap = priv->expiry_heap;
+	gboolean need_solicit = FALSE;
+	guint64 nextevent;
 
 	nm_clear_g_source (&priv->timeout_id);
 
-	clean_gateways (rdisc, now, &changed, &nextevent);
-	clean_addresses (rdisc, now, &changed, &nextevent);
-	clean_routes (rdisc, now, &changed, &nextevent);
-	clean_dns_servers (rdisc, now, &changed, &nextevent);
-	clean_dns_domains (rdisc, now, &changed, &nextevent);
+	while (heap->len && ((ExpiryEntry *) heap->pdata[0])->when <= now)
+		expiry_handle (rdisc, heap->pdata[0], &changed, &need_solicit);
+
+	if (need_solicit)
+		solicit (rdisc);
 
 	if (changed)
 		g_signal_emit_by_name (rdisc, NM_RDISC_CONFIG_CHANGED, changed);
 
-	if (nextevent != never) {
-		g_return_if_fail (nextevent > now);
+	if (heap->len) {
+		nextevent = ((ExpiryEntry *) heap->pdata[0])->when;
+		/* Don't schedule further than a magic date in the distant future (~68 years) */
+		nextevent = MIN (nextevent - now, G_MAXINT32);
 		_LOGD ("scheduling next now/lifetime check: %u seconds",
-		       nextevent - now);
-		priv->timeout_id = g_timeout_add_seconds (nextevent - now, timeout_cb, rdisc);
+		       (guint) nextevent);
+		priv->timeout_id = g_timeout_add_seconds (nextevent, timeout_cb, rdisc);
 	}
 }
 
@@ -699,6 +945,19 @@ nm_rdisc_ra_received (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap changed)
 	nm_clear_g_source (&priv->ra_timeout_id);
 	nm_clear_g_source (&priv->send_rs_id);
 	g_clear_pointer (&priv->last_send_rs_error, g_free);
+
+	priv->ra_received++;
+	if ((gint64) now - priv->ra_window_start >= RA_RATE_WINDOW) {
+		/* a window without any RA counts as zero */
+		priv->ra_rate = ((gint64) now - priv->ra_window_start < 2 * RA_RATE_WINDOW)
+		                ? priv->ra_window_count : 0;
+		priv->ra_window_start = now;
+		priv->ra_window_count = 0;
+		_LOGD ("router advertisements: %"G_GUINT64_FORMAT" received, %u in the last %d seconds",
+		       priv->ra_received, priv->ra_rate, RA_RATE_WINDOW);
+	}
+	priv->ra_window_count++;
+
 	check_timestamps (rdisc, now, changed);
 }
 
@@ -754,6 +1013,14 @@ nm_rdisc_init (NMRDisc *rdisc)
 	 * is much lower than nm_utils_get_monotonic_timestamp_s() at startup.
 	 */
 	priv->last_rs = G_MININT32;
+	priv->ra_window_start = G_MININT32;
+
+	priv->expiry_heap = g_ptr_array_new ();
+	priv->expiry_entries = g_hash_table_new_full (expiry_entry_hash, expiry_entry_equal,
+	                                              expiry_entry_free, NULL);
+
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_RDISC,
+	                          sizeof (NMRDisc) + sizeof (NMRDiscPrivate));
 }
 
 static void
@@ -775,6 +1042,7 @@ static void
 finalize (GObject *object)
 {
 	NMRDisc *rdisc = NM_RDISC (object);
+	NMRDiscPrivate *priv = NM_RDISC_GET_PRIVATE (rdisc);
 
 	g_free (rdisc->ifname);
 	g_free (rdisc->uuid);
@@ -784,9 +1052,15 @@ finalize (GObject *object)
 	g_array_unref (rdisc->dns_servers);
 	g_array_unref (rdisc->dns_domains);
 
+	g_ptr_array_unref (priv->expiry_heap);
+	g_hash_table_unref (priv->expiry_entries);
+
 	g_clear_object (&rdisc->_netns);
 	g_clear_object (&rdisc->_platform);
 
+	nm_statistics_memory_remove (NM_STATISTICS_MEMORY_RDISC,
+	                             sizeof (NMRDisc) + sizeof (NMRDiscPrivate));
+
 	G_OBJECT_CLASS (nm_rdisc_parent_class)->finalize (object);
 }
 
@@ -35,6 +35,7 @@
 #include "nm-simple-connection.h"
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "nm-config.h"
 
 #include "nmdbus-agent-manager.h"
 
@@ -44,7 +45,7 @@ NM_DEFINE_SINGLETON_INSTANCE (NMAgentManager);
 #define _NMLOG_DOMAIN         LOGD_AGENTS
 #define _NMLOG(level, agent, ...) \
     G_STMT_START { \
-        if (nm_logging_enabled ((level), (_NMLOG_DOMAIN))) { \
+        if (_nm_logging_wanted ((level), (_NMLOG_DOMAIN))) { \
             char __prefix1[32]; \
             char __prefix2[128]; \
             NMSecretAgent *__agent = (agent); \
@@ -116,6 +117,7 @@ typedef struct {
 
 enum {
         AGENT_REGISTERED,
+        AGENT_UNREGISTERED,
 
         LAST_SIGNAL
 };
@@ -124,6 +126,14 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 typedef struct _NMAgentManagerCallId Request;
 
+/* An agent asked in parallel with others, see _con_get_race() */
+typedef struct {
+	Request *req;
+	NMSecretAgent *agent;
+	NMSecretAgentCallId call_id;
+	guint timeout_id;
+} RaceAgent;
+
 static void request_add_agent (Request *req, NMSecretAgent *agent);
 
 static void request_remove_agent (Request *req, NMSecretAgent *agent, GSList **pending_reqs);
@@ -131,6 +141,9 @@ static void request_remove_agent (Request *req, NMSecretAgent *agent, GSList **p
 static void request_next_agent (Request *req);
 
 static void _con_get_request_start (Request *req);
+static void _con_get_race (Request *req);
+static void _con_get_racer_free (gpointer data);
+static void _con_get_promote_follower (Request *req);
 static void _con_save_request_start (Request *req);
 static void _con_del_request_start (Request *req);
 
@@ -168,6 +181,8 @@ remove_agent (NMAgentManager *self, const char *owner)
 	 */
 	g_slist_free_full (pending_reqs, (GDestroyNotify) request_next_agent);
 
+	g_signal_emit (self, signals[AGENT_UNREGISTERED], 0, agent);
+
 	/* And dispose of the agent */
 	g_hash_table_remove (priv->agents, owner);
 	return TRUE;
@@ -473,6 +488,17 @@ struct _NMAgentManagerCallId {
 
 					NMAgentSecretsResultFunc callback;
 					gpointer callback_data;
+
+					/* The number of agents asked at the same time. If > 1,
+					 * the agents in @racers are asked instead of @current. */
+					guint parallel;
+					guint agent_timeout_ms;
+					GSList *racers;
+
+					/* An identical request is already in progress. This one
+					 * just waits for its result. */
+					Request *leader;
+					GSList *followers;
 				} get;
 			};
 		} con;
@@ -507,6 +533,13 @@ request_free (Request *req)
 		if (req->con.chain)
 			nm_auth_chain_unref (req->con.chain);
 		if (req->request_type == REQUEST_TYPE_CON_GET) {
+			nm_assert (!req->con.get.followers);
+			if (req->con.get.leader) {
+				req->con.get.leader->con.get.followers = g_slist_remove (req->con.get.leader->con.get.followers, req);
+				req->con.get.leader = NULL;
+			}
+			g_slist_free_full (req->con.get.racers, _con_get_racer_free);
+			req->con.get.racers = NULL;
 			g_free (req->con.get.setting_name);
 			g_strfreev (req->con.get.hints);
 			if (req->con.get.existing_secrets)
@@ -563,6 +596,18 @@ req_complete_release (Request *req,
 		                       error,
 		                       req->con.get.callback_data);
 
+		/* the identical requests get the same result */
+		while (req->con.get.followers) {
+			NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+			Request *follower = req->con.get.followers->data;
+
+			req->con.get.followers = g_slist_delete_link (req->con.get.followers, req->con.get.followers);
+			follower->con.get.leader = NULL;
+			if (!g_hash_table_remove (priv->requests, follower))
+				g_return_if_reached ();
+			follower->con.current_has_modify = req->con.current_has_modify;
+			req_complete_release (follower, secrets, agent_dbus_owner, agent_username, error);
+		}
 		break;
 	case REQUEST_TYPE_CON_SAVE:
 	case REQUEST_TYPE_CON_DEL:
@@ -582,6 +627,10 @@ req_complete_cancel (Request *req, gboolean is_disposing)
 	nm_assert (req && req->self);
 	nm_assert (!g_hash_table_contains (NM_AGENT_MANAGER_GET_PRIVATE (req->self)->requests, req));
 
+	if (   req->request_type == REQUEST_TYPE_CON_GET
+	    && req->con.get.followers)
+		_con_get_promote_follower (req);
+
 	nm_utils_error_set_cancelled (&error, is_disposing, "NMAgentManager");
 	req_complete_release (req, NULL, NULL, NULL, error);
 }
@@ -656,6 +705,10 @@ request_add_agent (Request *req, NMSecretAgent *agent)
 	if (req->request_type == REQUEST_TYPE_CON_GET) {
 		NMAuthSubject *subject = nm_secret_agent_get_subject (agent);
 
+		/* the leader asks the agents */
+		if (req->con.get.leader)
+			return;
+
 		/* Ensure the caller's username exists in the connection's permissions,
 		 * or that the permissions is empty (ie, visible by everyone).
 		 */
@@ -712,6 +765,12 @@ request_next_agent (Request *req)
 
 	self = req->self;
 
+	if (   req->request_type == REQUEST_TYPE_CON_GET
+	    && req->con.get.parallel > 1) {
+		_con_get_race (req);
+		return;
+	}
+
 	if (req->current) {
 		if (req->current_call_id)
 			nm_secret_agent_cancel_secrets (req->current, req->current_call_id);
@@ -782,7 +841,26 @@ request_remove_agent (Request *req, NMSecretAgent *agent, GSList **pending_reqs)
 		}
 
 		*pending_reqs = g_slist_prepend (*pending_reqs, req);
-	} else if (g_slist_find (req->pending, agent)) {
+	} else if (   req->request_type == REQUEST_TYPE_CON_GET
+	           && req->con.get.racers) {
+		GSList *iter;
+
+		for (iter = req->con.get.racers; iter; iter = iter->next) {
+			RaceAgent *racer = iter->data;
+
+			if (racer->agent == agent) {
+				_LOGD (agent, "agent removed from secrets request "LOG_REQ_FMT,
+				       LOG_REQ_ARG (req));
+				req->con.get.racers = g_slist_delete_link (req->con.get.racers, iter);
+				_con_get_racer_free (racer);
+				/* ask the next one instead */
+				*pending_reqs = g_slist_prepend (*pending_reqs, req);
+				break;
+			}
+		}
+	}
+
+	if (g_slist_find (req->pending, agent)) {
 		req->pending = g_slist_remove (req->pending, agent);
 
 		_LOGD (agent, "agent removed from secrets request "LOG_REQ_FMT,
@@ -815,6 +893,23 @@ out:
 
 /*************************************************************/
 
+static void
+_con_get_complete_with_agent (Request *req, NMSecretAgent *agent, GVariant *secrets)
+{
+	struct passwd *pw;
+	gs_free char *agent_uname = NULL;
+
+	/* Get the agent's username */
+	pw = getpwuid (nm_secret_agent_get_owner_uid (agent));
+	if (pw && strlen (pw->pw_name)) {
+		/* Needs to be UTF-8 valid since it may be pushed through D-Bus */
+		if (g_utf8_validate (pw->pw_name, -1, NULL))
+			agent_uname = g_strdup (pw->pw_name);
+	}
+
+	req_complete (req, secrets, nm_secret_agent_get_dbus_owner (agent), agent_uname, NULL);
+}
+
 static void
 _con_get_request_done (NMSecretAgent *agent,
                        NMSecretAgentCallId call_id,
@@ -824,10 +919,7 @@ _con_get_request_done (NMSecretAgent *agent,
 {
 	NMAgentManager *self;
 	Request *req = user_data;
-	GVariant *setting_secrets;
-	const char *agent_dbus_owner;
-	struct passwd *pw;
-	char *agent_uname = NULL;
+	gs_unref_variant GVariant *setting_secrets = NULL;
 
 	g_return_if_fail (call_id == req->current_call_id);
 	g_return_if_fail (agent == req->current);
@@ -880,17 +972,7 @@ _con_get_request_done (NMSecretAgent *agent,
 	_LOGD (agent, "agent returned secrets for request "LOG_REQ_FMT,
 	       LOG_REQ_ARG (req));
 
-	/* Get the agent's username */
-	pw = getpwuid (nm_secret_agent_get_owner_uid (agent));
-	if (pw && strlen (pw->pw_name)) {
-		/* Needs to be UTF-8 valid since it may be pushed through D-Bus */
-		if (g_utf8_validate (pw->pw_name, -1, NULL))
-			agent_uname = g_strdup (pw->pw_name);
-	}
-
-	agent_dbus_owner = nm_secret_agent_get_dbus_owner (agent);
-	req_complete (req, secrets, agent_dbus_owner, agent_uname, NULL);
-	g_free (agent_uname);
+	_con_get_complete_with_agent (req, agent, secrets);
 }
 
 static void
@@ -1107,6 +1189,273 @@ _con_get_request_start (Request *req)
 	}
 }
 
+static void
+_con_get_racer_free (gpointer data)
+{
+	RaceAgent *racer = data;
+	NMSecretAgentCallId call_id;
+
+	nm_clear_g_source (&racer->timeout_id);
+	call_id = racer->call_id;
+	if (call_id) {
+		/* invokes _con_get_race_done() synchronously, which ignores the
+		 * cancellation. */
+		racer->call_id = NULL;
+		nm_secret_agent_cancel_secrets (racer->agent, call_id);
+	}
+	g_object_unref (racer->agent);
+	g_slice_free (RaceAgent, racer);
+}
+
+static void
+_con_get_race_done (NMSecretAgent *agent,
+                    NMSecretAgentCallId call_id,
+                    GVariant *secrets,
+                    GError *error,
+                    gpointer user_data)
+{
+	NMAgentManager *self;
+	RaceAgent *racer = user_data;
+	Request *req;
+	gs_unref_object NMSecretAgent *agent_ref = NULL;
+	gs_unref_variant GVariant *setting_secrets = NULL;
+
+	if (!racer->call_id) {
+		/* cancelled by _con_get_racer_free() */
+		return;
+	}
+
+	req = racer->req;
+	self = req->self;
+	g_return_if_fail (call_id == racer->call_id);
+
+	racer->call_id = NULL;
+	req->con.get.racers = g_slist_remove (req->con.get.racers, racer);
+	agent_ref = g_object_ref (agent);
+	_con_get_racer_free (racer);
+
+	if (error) {
+		_LOGD (agent, "agent failed secrets request "LOG_REQ_FMT": %s",
+		       LOG_REQ_ARG (req),
+		       error->message);
+
+		if (g_error_matches (error, NM_SECRET_AGENT_ERROR, NM_SECRET_AGENT_ERROR_USER_CANCELED)) {
+			gs_free_error GError *local = NULL;
+
+			local = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
+			                             NM_AGENT_MANAGER_ERROR_USER_CANCELED,
+			                             "User canceled the secrets request.");
+			req_complete_error (req, local);
+		} else {
+			_con_get_race (req);
+			maybe_remove_agent_on_error (agent, error);
+		}
+		return;
+	}
+
+	setting_secrets = g_variant_lookup_value (secrets, req->con.get.setting_name, NM_VARIANT_TYPE_SETTING);
+	if (!setting_secrets || !g_variant_n_children (setting_secrets)) {
+		_LOGD (agent, "agent returned no secrets for request "LOG_REQ_FMT,
+		       LOG_REQ_ARG (req));
+		_con_get_race (req);
+		return;
+	}
+
+	_LOGD (agent, "agent returned secrets for request "LOG_REQ_FMT" first",
+	       LOG_REQ_ARG (req));
+
+	/* frees the other racers, which cancels their calls */
+	_con_get_complete_with_agent (req, agent, secrets);
+}
+
+static gboolean
+_con_get_race_timeout_cb (gpointer user_data)
+{
+	RaceAgent *racer = user_data;
+	Request *req = racer->req;
+	NMAgentManager *self = req->self;
+
+	racer->timeout_id = 0;
+
+	_LOGD (racer->agent, "agent didn't answer secrets request "LOG_REQ_FMT" within %u msec",
+	       LOG_REQ_ARG (req), req->con.get.agent_timeout_ms);
+
+	req->con.get.racers = g_slist_remove (req->con.get.racers, racer);
+	_con_get_racer_free (racer);
+	_con_get_race (req);
+	return G_SOURCE_REMOVE;
+}
+
+/* Asks up to req->con.get.parallel agents at the same time and takes the
+ * first answer with secrets. It is only used for requests without flags,
+ * that is, without user interaction and without sending system secrets
+ * to the agents. An agent that doesn't answer within
+ * req->con.get.agent_timeout_ms is skipped, so that it can't delay the
+ * others by the full D-Bus timeout. */
+static void
+_con_get_race (Request *req)
+{
+	NMAgentManager *self = req->self;
+	gs_unref_object NMConnection *tmp = NULL;
+
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+	nm_assert (req->con.get.flags == NM_SECRET_AGENT_GET_SECRETS_FLAG_NONE);
+
+	while (   req->pending
+	       && g_slist_length (req->con.get.racers) < req->con.get.parallel) {
+		RaceAgent *racer;
+
+		if (!tmp) {
+			tmp = nm_simple_connection_new_clone (req->con.connection);
+			nm_connection_clear_secrets (tmp);
+			if (req->con.get.existing_secrets)
+				set_secrets_not_required (tmp, req->con.get.existing_secrets);
+		}
+
+		racer = g_slice_new0 (RaceAgent);
+		racer->req = req;
+		/* takes the reference of the pending list */
+		racer->agent = req->pending->data;
+		req->pending = g_slist_delete_link (req->pending, req->pending);
+
+		_LOGD (racer->agent, "agent %s secrets for request "LOG_REQ_FMT" (in parallel)",
+		       _request_type_to_string (req->request_type, TRUE),
+		       LOG_REQ_ARG (req));
+
+		racer->call_id = nm_secret_agent_get_secrets (racer->agent,
+		                                              req->con.path,
+		                                              tmp,
+		                                              req->con.get.setting_name,
+		                                              (const char **) req->con.get.hints,
+		                                              req->con.get.flags,
+		                                              _con_get_race_done,
+		                                              racer);
+		if (!racer->call_id) {
+			g_warn_if_reached ();
+			_con_get_racer_free (racer);
+			continue;
+		}
+		if (req->con.get.agent_timeout_ms)
+			racer->timeout_id = g_timeout_add (req->con.get.agent_timeout_ms, _con_get_race_timeout_cb, racer);
+		req->con.get.racers = g_slist_prepend (req->con.get.racers, racer);
+	}
+
+	if (!req->con.get.racers) {
+		gs_free_error GError *error = NULL;
+
+		/* No more secret agents are available to fulfill this secrets request */
+		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
+		                             NM_AGENT_MANAGER_ERROR_NO_SECRETS,
+		                             "No agents were available for this request.");
+		req_complete_error (req, error);
+	}
+}
+
+/*************************************************************/
+
+#define SECRET_AGENTS_PARALLEL_DEFAULT 1
+#define SECRET_AGENT_TIMEOUT_DEFAULT   3000
+
+static void
+_con_get_setup_parallel (Request *req)
+{
+	NMConfigData *config_data = NM_CONFIG_GET_DATA;
+	const char *value;
+
+	req->con.get.parallel = 1;
+
+	/* Requests with flags may interact with the user or send system
+	 * secrets; they always ask one agent after the other. */
+	if (req->con.get.flags != NM_SECRET_AGENT_GET_SECRETS_FLAG_NONE)
+		return;
+
+	value = nm_config_data_get_value_cached (config_data,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_SECRET_AGENTS_PARALLEL,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	req->con.get.parallel = _nm_utils_ascii_str_to_int64 (value, 10, 1, 16,
+	                                                      SECRET_AGENTS_PARALLEL_DEFAULT);
+
+	value = nm_config_data_get_value_cached (config_data,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_SECRET_AGENT_TIMEOUT,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	req->con.get.agent_timeout_ms = _nm_utils_ascii_str_to_int64 (value, 10, 0, 120000,
+	                                                              SECRET_AGENT_TIMEOUT_DEFAULT);
+}
+
+static gboolean
+_auth_subject_equal (NMAuthSubject *a, NMAuthSubject *b)
+{
+	if (a == b)
+		return TRUE;
+	if (nm_auth_subject_get_subject_type (a) != nm_auth_subject_get_subject_type (b))
+		return FALSE;
+	if (!nm_auth_subject_is_unix_process (a))
+		return TRUE;
+	return    nm_auth_subject_get_unix_process_pid (a) == nm_auth_subject_get_unix_process_pid (b)
+	       && nm_auth_subject_get_unix_process_uid (a) == nm_auth_subject_get_unix_process_uid (b)
+	       && nm_streq0 (nm_auth_subject_get_unix_process_dbus_sender (a),
+	                     nm_auth_subject_get_unix_process_dbus_sender (b));
+}
+
+/* Finds a request in progress that asks for the same secrets on behalf of
+ * the same subject, e.g. when several devices activate the same connection. */
+static Request *
+_con_get_find_leader (NMAgentManager *self, Request *req)
+{
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	Request *other;
+
+	g_hash_table_iter_init (&iter, priv->requests);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &other, NULL)) {
+		if (   other == req
+		    || other->request_type != REQUEST_TYPE_CON_GET
+		    || other->con.get.leader)
+			continue;
+		if (   !nm_streq (other->con.path, req->con.path)
+		    || !nm_streq0 (other->con.get.setting_name, req->con.get.setting_name)
+		    || other->con.get.flags != req->con.get.flags
+		    || !_nm_utils_strv_equal (other->con.get.hints, req->con.get.hints))
+			continue;
+		if (!other->con.get.existing_secrets != !req->con.get.existing_secrets)
+			continue;
+		if (   other->con.get.existing_secrets
+		    && !g_variant_equal (other->con.get.existing_secrets, req->con.get.existing_secrets))
+			continue;
+		if (!_auth_subject_equal (other->subject, req->subject))
+			continue;
+		return other;
+	}
+	return NULL;
+}
+
+/* @req, the leader of identical requests, was cancelled. The first
+ * follower takes over and starts asking the agents again. */
+static void
+_con_get_promote_follower (Request *req)
+{
+	NMAgentManager *self = req->self;
+	Request *leader;
+	GSList *iter;
+
+	leader = req->con.get.followers->data;
+	req->con.get.followers = g_slist_delete_link (req->con.get.followers, req->con.get.followers);
+
+	leader->con.get.leader = NULL;
+	leader->con.get.followers = req->con.get.followers;
+	req->con.get.followers = NULL;
+	for (iter = leader->con.get.followers; iter; iter = iter->next)
+		((Request *) iter->data)->con.get.leader = leader;
+
+	_LOGD (NULL, "("LOG_REQ_FMT") takes over cancelled request %p",
+	       LOG_REQ_ARG (leader), req);
+
+	request_add_agents (self, leader);
+	leader->idle_id = g_idle_add (request_start, leader);
+}
+
 static gboolean
 _con_get_try_complete_early (Request *req)
 {
@@ -1235,10 +1584,20 @@ nm_agent_manager_get_secrets (NMAgentManager *self,
 	req->con.get.flags = flags;
 	req->con.get.callback = callback;
 	req->con.get.callback_data = callback_data;
+	_con_get_setup_parallel (req);
+
+	req->con.get.leader = _con_get_find_leader (self, req);
 
 	if (!nm_g_hash_table_add (priv->requests, req))
 		g_assert_not_reached ();
 
+	if (req->con.get.leader) {
+		_LOGD (NULL, "("LOG_REQ_FMT") waits for the identical request %p",
+		       LOG_REQ_ARG (req), req->con.get.leader);
+		req->con.get.leader->con.get.followers = g_slist_append (req->con.get.leader->con.get.followers, req);
+		return req;
+	}
+
 	/* Kick off the request */
 	if (!(req->con.get.flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ONLY_SYSTEM))
 		request_add_agents (self, req);
@@ -1643,6 +2002,16 @@ nm_agent_manager_class_init (NMAgentManagerClass *agent_manager_class)
 		              G_TYPE_NONE, 1,
 		              G_TYPE_OBJECT);
 
+	signals[AGENT_UNREGISTERED] =
+		g_signal_new ("agent-unregistered",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_FIRST,
+		              G_STRUCT_OFFSET (NMAgentManagerClass, agent_unregistered),
+		              NULL, NULL,
+		              g_cclosure_marshal_VOID__OBJECT,
+		              G_TYPE_NONE, 1,
+		              G_TYPE_OBJECT);
+
 	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (agent_manager_class),
 	                                        NMDBUS_TYPE_AGENT_MANAGER_SKELETON,
 	                                        "Register", impl_agent_manager_register,
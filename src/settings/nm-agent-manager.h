@@ -45,6 +45,7 @@ typedef struct {
 
 	/* Signals */
 	void (*agent_registered)   (NMAgentManager *agent_mgr, NMSecretAgent *agent);
+	void (*agent_unregistered) (NMAgentManager *agent_mgr, NMSecretAgent *agent);
 } NMAgentManagerClass;
 
 GType nm_agent_manager_get_type (void);
@@ -36,7 +36,7 @@
 #define _NMLOG_DOMAIN         LOGD_AGENTS
 #define _NMLOG(level, ...) \
     G_STMT_START { \
-        if (nm_logging_enabled ((level), (_NMLOG_DOMAIN))) { \
+        if (_nm_logging_wanted ((level), (_NMLOG_DOMAIN))) { \
             char __prefix[32]; \
             \
             if ((self)) \
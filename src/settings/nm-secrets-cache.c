@@ -0,0 +1,240 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-secrets-cache.h"
+
+#include <string.h>
+
+/* The secrets that agents returned for one connection, kept for
+ * NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED requests. There is at most one
+ * entry per setting and requester. The requester is the user the secrets
+ * were requested for, or NetworkManager itself; the secrets of one user's
+ * agent are never returned for the request of another. There are only a
+ * few entries, so a list does. */
+struct _NMSecretsCache {
+	GSList *entries;
+};
+
+NMSecretsCacheEntry *
+nm_secrets_cache_entry_dup (const NMSecretsCacheEntry *entry)
+{
+	NMSecretsCacheEntry *dup;
+
+	dup = g_slice_dup (NMSecretsCacheEntry, entry);
+	dup->setting_name = g_strdup (entry->setting_name);
+	dup->secrets = g_variant_ref (entry->secrets);
+	dup->agent_dbus_owner = g_strdup (entry->agent_dbus_owner);
+	dup->agent_username = g_strdup (entry->agent_username);
+	return dup;
+}
+
+void
+nm_secrets_cache_entry_free (NMSecretsCacheEntry *entry)
+{
+	g_free (entry->setting_name);
+	g_variant_unref (entry->secrets);
+	g_free (entry->agent_dbus_owner);
+	g_free (entry->agent_username);
+	g_slice_free (NMSecretsCacheEntry, entry);
+}
+
+NMSecretsCache *
+nm_secrets_cache_new (void)
+{
+	return g_slice_new0 (NMSecretsCache);
+}
+
+void
+nm_secrets_cache_free (NMSecretsCache *cache)
+{
+	if (!cache)
+		return;
+	nm_secrets_cache_clear (cache);
+	g_slice_free (NMSecretsCache, cache);
+}
+
+static gboolean
+_entry_matches (const NMSecretsCacheEntry *entry,
+                NMAuthSubject *subject,
+                const char *setting_name)
+{
+	NMAuthSubjectType subject_type = nm_auth_subject_get_subject_type (subject);
+
+	if (!nm_streq (entry->setting_name, setting_name))
+		return FALSE;
+	if (entry->subject_type != subject_type)
+		return FALSE;
+	if (   subject_type == NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS
+	    && entry->subject_uid != nm_auth_subject_get_unix_process_uid (subject))
+		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+_entry_matches_cb (const NMSecretsCacheEntry *entry, gpointer user_data)
+{
+	const NMSecretsCacheEntry *key = user_data;
+
+	return    nm_streq (entry->setting_name, key->setting_name)
+	       && entry->subject_type == key->subject_type
+	       && entry->subject_uid == key->subject_uid;
+}
+
+/**
+ * nm_secrets_cache_set:
+ * @cache: the #NMSecretsCache
+ * @subject: the requester the agent returned the secrets for
+ * @setting_name: the setting of the secrets
+ * @agent_dbus_owner: the agent that returned the secrets
+ * @agent_username: the user of the agent
+ * @secrets: the secrets
+ * @expires_at: when the entry expires, in monotonic seconds
+ *
+ * Remembers @secrets, replacing the entry of the same requester
+ * and setting.
+ */
+void
+nm_secrets_cache_set (NMSecretsCache *cache,
+                      NMAuthSubject *subject,
+                      const char *setting_name,
+                      const char *agent_dbus_owner,
+                      const char *agent_username,
+                      GVariant *secrets,
+                      gint32 expires_at)
+{
+	NMSecretsCacheEntry *entry;
+
+	g_return_if_fail (cache);
+	g_return_if_fail (NM_IS_AUTH_SUBJECT (subject));
+	g_return_if_fail (setting_name);
+	g_return_if_fail (agent_dbus_owner);
+	g_return_if_fail (secrets);
+
+	entry = g_slice_new0 (NMSecretsCacheEntry);
+	entry->setting_name = g_strdup (setting_name);
+	entry->subject_type = nm_auth_subject_get_subject_type (subject);
+	if (entry->subject_type == NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS)
+		entry->subject_uid = nm_auth_subject_get_unix_process_uid (subject);
+
+	nm_secrets_cache_remove_if (cache, _entry_matches_cb, entry);
+
+	entry->secrets = g_variant_ref (secrets);
+	entry->agent_dbus_owner = g_strdup (agent_dbus_owner);
+	entry->agent_username = g_strdup (agent_username);
+	entry->expires_at = expires_at;
+	cache->entries = g_slist_prepend (cache->entries, entry);
+}
+
+/**
+ * nm_secrets_cache_lookup:
+ * @cache: the #NMSecretsCache
+ * @subject: the requester
+ * @setting_name: the setting the secrets are requested for
+ * @now: the current time, in monotonic seconds
+ *
+ * Returns: the entry that an agent returned for the same requester
+ *   and setting, if it didn't expire yet. Expired entries are removed.
+ */
+const NMSecretsCacheEntry *
+nm_secrets_cache_lookup (NMSecretsCache *cache,
+                         NMAuthSubject *subject,
+                         const char *setting_name,
+                         gint32 now)
+{
+	GSList *iter;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (NM_IS_AUTH_SUBJECT (subject), NULL);
+	g_return_val_if_fail (setting_name, NULL);
+
+	for (iter = cache->entries; iter; iter = iter->next) {
+		NMSecretsCacheEntry *entry = iter->data;
+
+		if (!_entry_matches (entry, subject, setting_name))
+			continue;
+		if (entry->expires_at <= now) {
+			cache->entries = g_slist_delete_link (cache->entries, iter);
+			nm_secrets_cache_entry_free (entry);
+			return NULL;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+/**
+ * nm_secrets_cache_remove_if:
+ * @cache: the #NMSecretsCache
+ * @predicate: returns %TRUE for the entries to remove
+ * @user_data: data for @predicate
+ *
+ * Returns: the number of removed entries.
+ */
+guint
+nm_secrets_cache_remove_if (NMSecretsCache *cache,
+                            NMSecretsCacheEntryFunc predicate,
+                            gpointer user_data)
+{
+	GSList *iter, *next;
+	guint n = 0;
+
+	g_return_val_if_fail (cache, 0);
+
+	for (iter = cache->entries; iter; iter = next) {
+		NMSecretsCacheEntry *entry = iter->data;
+
+		next = iter->next;
+		if (predicate && !predicate (entry, user_data))
+			continue;
+		cache->entries = g_slist_delete_link (cache->entries, iter);
+		nm_secrets_cache_entry_free (entry);
+		n++;
+	}
+	return n;
+}
+
+static gboolean
+_entry_has_agent_cb (const NMSecretsCacheEntry *entry, gpointer user_data)
+{
+	return nm_streq (entry->agent_dbus_owner, user_data);
+}
+
+/**
+ * nm_secrets_cache_remove_agent:
+ * @cache: the #NMSecretsCache
+ * @agent_dbus_owner: the agent that unregistered
+ *
+ * Returns: the number of removed entries.
+ */
+guint
+nm_secrets_cache_remove_agent (NMSecretsCache *cache, const char *agent_dbus_owner)
+{
+	g_return_val_if_fail (agent_dbus_owner, 0);
+
+	return nm_secrets_cache_remove_if (cache, _entry_has_agent_cb, (gpointer) agent_dbus_owner);
+}
+
+guint
+nm_secrets_cache_clear (NMSecretsCache *cache)
+{
+	return nm_secrets_cache_remove_if (cache, NULL, NULL);
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_SECRETS_CACHE_H__
+#define __NETWORKMANAGER_SECRETS_CACHE_H__
+
+#include "nm-auth-subject.h"
+
+typedef struct {
+	char *setting_name;
+	GVariant *secrets;
+	char *agent_dbus_owner;
+	char *agent_username;
+
+	/* who the secrets were requested for. They are only
+	 * returned to the same requester again. */
+	NMAuthSubjectType subject_type;
+	gulong subject_uid;
+
+	gint32 expires_at;
+} NMSecretsCacheEntry;
+
+NMSecretsCacheEntry *nm_secrets_cache_entry_dup (const NMSecretsCacheEntry *entry);
+void nm_secrets_cache_entry_free (NMSecretsCacheEntry *entry);
+
+typedef struct _NMSecretsCache NMSecretsCache;
+
+NMSecretsCache *nm_secrets_cache_new (void);
+void nm_secrets_cache_free (NMSecretsCache *cache);
+
+void nm_secrets_cache_set (NMSecretsCache *cache,
+                           NMAuthSubject *subject,
+                           const char *setting_name,
+                           const char *agent_dbus_owner,
+                           const char *agent_username,
+                           GVariant *secrets,
+                           gint32 expires_at);
+
+const NMSecretsCacheEntry *nm_secrets_cache_lookup (NMSecretsCache *cache,
+                                                    NMAuthSubject *subject,
+                                                    const char *setting_name,
+                                                    gint32 now);
+
+typedef gboolean (*NMSecretsCacheEntryFunc) (const NMSecretsCacheEntry *entry, gpointer user_data);
+
+guint nm_secrets_cache_remove_if (NMSecretsCache *cache,
+                                  NMSecretsCacheEntryFunc predicate,
+                                  gpointer user_data);
+
+guint nm_secrets_cache_remove_agent (NMSecretsCache *cache, const char *agent_dbus_owner);
+
+guint nm_secrets_cache_clear (NMSecretsCache *cache);
+
+#endif  /* __NETWORKMANAGER_SECRETS_CACHE_H__ */
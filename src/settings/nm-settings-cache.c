@@ -0,0 +1,287 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-settings-cache.h"
+
+#include <string.h>
+
+#include "nm-core-internal.h"
+#include "nm-simple-connection.h"
+
+/* The cache stores connections exactly as a plugin produced them from
+ * its files, serialized to the D-Bus format, so that unchanged files need
+ * not be read and parsed again on the next start.
+ *
+ * The file is a single serialized GVariant which is mmap()ed on open:
+ *
+ *   (version, NetworkManager version, [(path, mtime, ctime, inode, size, settings)])
+ *
+ * An entry is only used if mtime, ctime (both in nanoseconds), inode and
+ * size of the file still match. Checking ctime also catches changes of
+ * ownership and permissions, which plugins may refuse to load. Any other change to the format or to the daemon
+ * discards the whole cache. */
+#define CACHE_VARIANT_TYPE G_VARIANT_TYPE ("(usa(stttta{sa{sv}}))")
+
+struct _NMSettingsCache {
+	char *filename;
+
+	/* the mmap()ed cache of the previous run, or %NULL */
+	GVariant *old;
+	/* path -> entry of @old */
+	GHashTable *old_entries;
+
+	/* entries for the files seen during this run */
+	GVariantBuilder new_entries;
+	guint n_hit;
+	guint n_miss;
+};
+
+static guint64
+_timespec_ns (const struct timespec *ts)
+{
+	return ((guint64) ts->tv_sec * 1000000000) + ts->tv_nsec;
+}
+
+static void
+_load (NMSettingsCache *cache)
+{
+	GMappedFile *mapped;
+	GError *error = NULL;
+	gs_unref_variant GVariant *entries = NULL;
+	GVariant *entry;
+	GVariantIter iter;
+	const char *nm_version;
+	guint32 version;
+
+	mapped = g_mapped_file_new (cache->filename, FALSE, &error);
+	if (!mapped) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+			nm_log_dbg (LOGD_SETTINGS, "settings-cache: cannot open %s: %s", cache->filename, error->message);
+		g_error_free (error);
+		return;
+	}
+
+	/* Not trusted: a damaged file only yields default values instead
+	 * of invalid accesses. */
+	cache->old = g_variant_new_from_data (CACHE_VARIANT_TYPE,
+	                                      g_mapped_file_get_contents (mapped),
+	                                      g_mapped_file_get_length (mapped),
+	                                      FALSE,
+	                                      (GDestroyNotify) g_mapped_file_unref,
+	                                      mapped);
+	g_variant_ref_sink (cache->old);
+
+	g_variant_get (cache->old, "(u&s@a(stttta{sa{sv}}))", &version, &nm_version, &entries);
+	if (version != NM_SETTINGS_CACHE_VERSION || strcmp (nm_version, VERSION) != 0) {
+		nm_log_dbg (LOGD_SETTINGS, "settings-cache: discard %s of version %u/%s",
+		            cache->filename, (guint) version, nm_version);
+		g_clear_pointer (&cache->old, g_variant_unref);
+		return;
+	}
+
+	cache->old_entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_variant_unref);
+	g_variant_iter_init (&iter, entries);
+	while ((entry = g_variant_iter_next_value (&iter))) {
+		const char *path;
+
+		g_variant_get_child (entry, 0, "&s", &path);
+		g_hash_table_insert (cache->old_entries, (gpointer) path, entry);
+	}
+}
+
+/**
+ * nm_settings_cache_open:
+ * @plugin: name of the settings plugin owning the cache
+ *
+ * Opens the connection cache of @plugin. A missing, outdated or
+ * unreadable cache file is not an error; all lookups just miss.
+ *
+ * Returns: the new cache, free with nm_settings_cache_free().
+ */
+NMSettingsCache *
+nm_settings_cache_open (const char *plugin)
+{
+	gs_free char *filename = NULL;
+
+	g_return_val_if_fail (plugin, NULL);
+
+	filename = g_strdup_printf (NMSTATEDIR "/connections-%s.cache", plugin);
+	return _nm_settings_cache_open_file (filename);
+}
+
+NMSettingsCache *
+_nm_settings_cache_open_file (const char *filename)
+{
+	NMSettingsCache *cache;
+
+	g_return_val_if_fail (filename, NULL);
+
+	cache = g_slice_new0 (NMSettingsCache);
+	cache->filename = g_strdup (filename);
+	g_variant_builder_init (&cache->new_entries, G_VARIANT_TYPE ("a(stttta{sa{sv}})"));
+	_load (cache);
+	return cache;
+}
+
+void
+nm_settings_cache_free (NMSettingsCache *cache)
+{
+	if (!cache)
+		return;
+
+	g_variant_builder_clear (&cache->new_entries);
+	g_clear_pointer (&cache->old_entries, g_hash_table_unref);
+	g_clear_pointer (&cache->old, g_variant_unref);
+	g_free (cache->filename);
+	g_slice_free (NMSettingsCache, cache);
+}
+
+/**
+ * nm_settings_cache_lookup:
+ * @cache: the cache
+ * @path: the file a connection is to be loaded from
+ * @st: the current stat() of @path
+ *
+ * On a hit, the entry is also kept for the cache written by
+ * nm_settings_cache_write(). On a miss, the caller is expected to parse
+ * @path and pass the result to nm_settings_cache_add().
+ *
+ * Returns: (transfer full): a new #NMSimpleConnection for @path if
+ * the cache holds an entry for the unchanged file, or %NULL.
+ */
+NMConnection *
+nm_settings_cache_lookup (NMSettingsCache *cache,
+                          const char *path,
+                          const struct stat *st)
+{
+	GVariant *entry;
+	gs_unref_variant GVariant *settings = NULL;
+	guint64 mtime_ns, ctime_ns, ino, size;
+	NMConnection *connection;
+	GError *error = NULL;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (path, NULL);
+	g_return_val_if_fail (st, NULL);
+
+	if (   !cache->old_entries
+	    || !(entry = g_hash_table_lookup (cache->old_entries, path)))
+		goto miss;
+
+	g_variant_get (entry, "(&stttt@a{sa{sv}})", NULL, &mtime_ns, &ctime_ns, &ino, &size, &settings);
+	if (   mtime_ns != _timespec_ns (&st->st_mtim)
+	    || ctime_ns != _timespec_ns (&st->st_ctim)
+	    || ino != (guint64) st->st_ino
+	    || size != (guint64) st->st_size)
+		goto miss;
+
+	/* The connection was normalized before it went into the cache. */
+	connection = _nm_simple_connection_new_from_dbus (settings, NM_SETTING_PARSE_FLAGS_NONE, &error);
+	if (!connection) {
+		nm_log_dbg (LOGD_SETTINGS, "settings-cache: invalid entry for %s: %s", path, error->message);
+		g_error_free (error);
+		goto miss;
+	}
+
+	g_variant_builder_add_value (&cache->new_entries, entry);
+	cache->n_hit++;
+	return connection;
+
+miss:
+	cache->n_miss++;
+	return NULL;
+}
+
+/**
+ * nm_settings_cache_add:
+ * @cache: the cache
+ * @path: the file @connection was loaded from
+ * @st: the stat() of @path taken before it was read
+ * @connection: the connection as parsed from @path
+ *
+ * Records @connection for the cache written by nm_settings_cache_write().
+ */
+void
+nm_settings_cache_add (NMSettingsCache *cache,
+                       const char *path,
+                       const struct stat *st,
+                       NMConnection *connection)
+{
+	GVariant *settings;
+
+	g_return_if_fail (cache);
+	g_return_if_fail (path);
+	g_return_if_fail (st);
+	g_return_if_fail (NM_IS_CONNECTION (connection));
+
+	settings = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+	g_variant_builder_add (&cache->new_entries, "(stttt@a{sa{sv}})",
+	                       path,
+	                       _timespec_ns (&st->st_mtim),
+	                       _timespec_ns (&st->st_ctim),
+	                       (guint64) st->st_ino,
+	                       (guint64) st->st_size,
+	                       settings);
+}
+
+/**
+ * nm_settings_cache_write:
+ * @cache: the cache
+ * @error: location for an error
+ *
+ * Atomically replaces the cache file with the entries that were
+ * looked up or added since nm_settings_cache_open(). Entries for files
+ * that were not seen are dropped. The cache holds secrets, so it is
+ * only readable by root.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_settings_cache_write (NMSettingsCache *cache, GError **error)
+{
+	gs_unref_variant GVariant *variant = NULL;
+	mode_t saved_umask;
+	gboolean success;
+
+	g_return_val_if_fail (cache, FALSE);
+
+	variant = g_variant_new ("(usa(stttta{sa{sv}}))",
+	                         (guint32) NM_SETTINGS_CACHE_VERSION,
+	                         VERSION,
+	                         &cache->new_entries);
+	g_variant_ref_sink (variant);
+	/* the builder is consumed by g_variant_new() */
+	g_variant_builder_init (&cache->new_entries, G_VARIANT_TYPE ("a(stttta{sa{sv}})"));
+
+	saved_umask = umask (0077);
+	success = g_file_set_contents (cache->filename,
+	                               g_variant_get_data (variant),
+	                               g_variant_get_size (variant),
+	                               error);
+	umask (saved_umask);
+
+	if (success) {
+		nm_log_dbg (LOGD_SETTINGS, "settings-cache: wrote %s (%u hits, %u misses)",
+		            cache->filename, cache->n_hit, cache->n_miss);
+	}
+	return success;
+}
@@ -0,0 +1,50 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_SETTINGS_CACHE_H__
+#define __NETWORKMANAGER_SETTINGS_CACHE_H__
+
+#include <sys/stat.h>
+
+#include "nm-default.h"
+
+/* Bump whenever the layout of the cache file changes. */
+#define NM_SETTINGS_CACHE_VERSION 1
+
+typedef struct _NMSettingsCache NMSettingsCache;
+
+NMSettingsCache *nm_settings_cache_open (const char *plugin);
+void nm_settings_cache_free (NMSettingsCache *cache);
+
+NMConnection *nm_settings_cache_lookup (NMSettingsCache *cache,
+                                        const char *path,
+                                        const struct stat *st);
+
+void nm_settings_cache_add (NMSettingsCache *cache,
+                            const char *path,
+                            const struct stat *st,
+                            NMConnection *connection);
+
+gboolean nm_settings_cache_write (NMSettingsCache *cache, GError **error);
+
+/* exposed for the unit tests */
+NMSettingsCache *_nm_settings_cache_open_file (const char *filename);
+
+#endif  /* __NETWORKMANAGER_SETTINGS_CACHE_H__ */
@@ -32,6 +32,9 @@
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
 #include "nm-audit-manager.h"
+#include "nm-statistics.h"
+#include "nm-config.h"
+#include "nm-secrets-cache.h"
 
 #include "nmdbus-settings-connection.h"
 
@@ -44,7 +47,7 @@
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             char __prefix[128]; \
             const char *__p_prefix = _NMLOG_PREFIX_NAME; \
             \
@@ -76,6 +79,7 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMSettingsConnection,
 	PROP_READY,
 	PROP_FLAGS,
 	PROP_FILENAME,
+	PROP_TIMESTAMP,
 );
 
 enum {
@@ -116,10 +120,17 @@ typedef struct {
 	 */
 	NMConnection *agent_secrets;
 
+	/* The last secrets agents returned, for the requests with
+	 * NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED. See secrets_cache_set(). */
+	NMSecretsCache *secrets_cache;
+
 	guint64 timestamp;   /* Up-to-date timestamp of connection use */
 	gboolean timestamp_set;
 	GHashTable *seen_bssids; /* Up-to-date BSSIDs that's been seen for the connection */
 
+	/* Cached result of nm_settings_connection_get_settings_variant() */
+	GVariant *settings_variant;
+
 	int autoconnect_retries;
 	gint32 autoconnect_retry_time;
 	NMDeviceStateReason autoconnect_blocked_reason;
@@ -349,10 +360,29 @@ nm_settings_connection_recheck_visibility (NMSettingsConnection *self)
 	set_visible (self, FALSE);
 }
 
+static gboolean
+secrets_cache_entry_without_session_cb (const NMSecretsCacheEntry *entry, gpointer user_data)
+{
+	uid_t uid;
+
+	if (!entry->agent_username)
+		return FALSE;
+	return    !nm_session_monitor_user_to_uid (entry->agent_username, &uid)
+	       || !nm_session_monitor_session_exists (user_data, uid, FALSE);
+}
+
 static void
 session_changed_cb (NMSessionMonitor *self, gpointer user_data)
 {
-	nm_settings_connection_recheck_visibility (NM_SETTINGS_CONNECTION (user_data));
+	NMSettingsConnection *connection = NM_SETTINGS_CONNECTION (user_data);
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (connection);
+
+	/* forget the secrets of users that logged out */
+	if (   priv->secrets_cache
+	    && nm_secrets_cache_remove_if (priv->secrets_cache, secrets_cache_entry_without_session_cb, self))
+		_LOGD ("forget cached agent secrets of users without a session");
+
+	nm_settings_connection_recheck_visibility (connection);
 }
 
 /**************************************************************/
@@ -458,6 +488,81 @@ update_agent_secrets_cache (NMSettingsConnection *self, NMConnection *new)
 	                                        GUINT_TO_POINTER (filter_flags));
 }
 
+/*****************************************************************************/
+
+/**
+ * nm_settings_connection_clear_secrets_cache:
+ * @self: the #NMSettingsConnection
+ *
+ * Forgets the secrets cached for requests with
+ * %NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED, e.g. before suspending.
+ */
+void
+nm_settings_connection_clear_secrets_cache (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
+	if (   priv->secrets_cache
+	    && nm_secrets_cache_clear (priv->secrets_cache))
+		_LOGD ("forget cached agent secrets");
+}
+
+/**
+ * nm_settings_connection_clear_secrets_cache_for_agent:
+ * @self: the #NMSettingsConnection
+ * @agent_dbus_owner: the agent that unregistered
+ *
+ * Forgets the cached secrets that came from @agent_dbus_owner.
+ */
+void
+nm_settings_connection_clear_secrets_cache_for_agent (NMSettingsConnection *self,
+                                                      const char *agent_dbus_owner)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
+	if (   priv->secrets_cache
+	    && nm_secrets_cache_remove_agent (priv->secrets_cache, agent_dbus_owner))
+		_LOGD ("forget cached agent secrets of agent %s", agent_dbus_owner);
+}
+
+/* The cache is disabled unless [main].agent-secrets-cache-timeout is set. Then
+ * the last secrets that an agent returned are kept for that many seconds, so
+ * that retries within an activation, like the reconnects of a VPN, don't need
+ * to ask the agents (and maybe the user) again. The entries are per requester,
+ * see nm_secrets_cache_lookup(). */
+static void
+secrets_cache_set (NMSettingsConnection *self,
+                   NMAuthSubject *subject,
+                   const char *setting_name,
+                   GVariant *secrets,
+                   const char *agent_dbus_owner,
+                   const char *agent_username)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	const char *value;
+	gint64 timeout;
+
+	value = nm_config_data_get_value_cached (NM_CONFIG_GET_DATA,
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_AGENT_SECRETS_CACHE_TIMEOUT,
+	                                         NM_CONFIG_GET_VALUE_STRIP);
+	timeout = _nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXINT32 / 2, 0);
+	if (!timeout)
+		return;
+
+	if (!priv->secrets_cache)
+		priv->secrets_cache = nm_secrets_cache_new ();
+	nm_secrets_cache_set (priv->secrets_cache,
+	                      subject,
+	                      setting_name,
+	                      agent_dbus_owner,
+	                      agent_username,
+	                      secrets,
+	                      nm_utils_get_monotonic_timestamp_s () + timeout);
+}
+
+/*****************************************************************************/
+
 static void
 secrets_cleared_cb (NMSettingsConnection *self)
 {
@@ -488,6 +593,20 @@ set_unsaved (NMSettingsConnection *self, gboolean now_unsaved)
 	}
 }
 
+static void
+_settings_variant_clear (NMSettingsConnection *self)
+{
+	g_clear_pointer (&NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->settings_variant, g_variant_unref);
+}
+
+static void
+settings_variant_changed_cb (NMSettingsConnection *self, gpointer unused)
+{
+	/* Connected separately from connection_changed_cb(), which gets
+	 * blocked while the settings are replaced. */
+	_settings_variant_clear (self);
+}
+
 static void
 connection_changed_cb (NMSettingsConnection *self, gpointer unused)
 {
@@ -532,6 +651,13 @@ nm_settings_connection_replace_settings (NMSettingsConnection *self,
 		return TRUE;
 	}
 
+	/* Cached secrets might not fit the new settings. Re-reading the connection
+	 * after saving new secrets doesn't change the other settings. */
+	if (!nm_connection_compare (NM_CONNECTION (self),
+	                            new_connection,
+	                            NM_SETTING_COMPARE_FLAG_IGNORE_SECRETS))
+		nm_settings_connection_clear_secrets_cache (self);
+
 	/* Disconnect the changed signal to ensure we don't set Unsaved when
 	 * it's not required.
 	 */
@@ -689,40 +815,114 @@ nm_settings_connection_delete (NMSettingsConnection *self,
 	}
 }
 
-static void
-remove_entry_from_db (NMSettingsConnection *self, const char* db_name)
-{
+/*****************************************************************************/
+
+/* The timestamps and seen-bssids databases are read from disk once and
+ * then served from memory. Changes only mark a database dirty; it is
+ * written out atomically at most once per DB_FLUSH_INTERVAL_SEC, and on
+ * sleep and shutdown by nm_settings_connection_flush_databases(). */
+
+#define DB_FLUSH_INTERVAL_SEC 60
+
+typedef struct {
+	const char *name;     /* also the group in the file */
+	const char *filename;
+	char list_separator;
 	GKeyFile *key_file;
-	const char *db_file;
+	gboolean dirty;
+	guint flush_id;
+} SettingsDb;
 
-	if (strcmp (db_name, "timestamps") == 0)
-		db_file = SETTINGS_TIMESTAMPS_FILE;
-	else if (strcmp (db_name, "seen-bssids") == 0)
-		db_file = SETTINGS_SEEN_BSSIDS_FILE;
-	else
-		return;
+static SettingsDb db_timestamps = {
+	.name = "timestamps",
+	.filename = SETTINGS_TIMESTAMPS_FILE,
+};
+
+static SettingsDb db_seen_bssids = {
+	.name = "seen-bssids",
+	.filename = SETTINGS_SEEN_BSSIDS_FILE,
+	.list_separator = ',',
+};
 
-	key_file = g_key_file_new ();
-	if (g_key_file_load_from_file (key_file, db_file, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		const char *connection_uuid;
-		char *data;
-		gsize len;
-		GError *error = NULL;
+static GKeyFile *
+_db_get (SettingsDb *db)
+{
+	GError *error = NULL;
 
-		connection_uuid = nm_settings_connection_get_uuid (self);
+	if (db->key_file)
+		return db->key_file;
 
-		g_key_file_remove_key (key_file, db_name, connection_uuid, NULL);
-		data = g_key_file_to_data (key_file, &len, &error);
-		if (data) {
-			g_file_set_contents (db_file, data, len, &error);
-			g_free (data);
-		}
-		if (error) {
-			_LOGW ("error writing %s file '%s': %s", db_name, db_file, error->message);
-			g_error_free (error);
+	db->key_file = g_key_file_new ();
+	if (db->list_separator)
+		g_key_file_set_list_separator (db->key_file, db->list_separator);
+	if (!g_key_file_load_from_file (db->key_file, db->filename, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			nm_log_warn (LOGD_SETTINGS, "error parsing %s file '%s': %s",
+			             db->name, db->filename, error->message);
 		}
+		g_clear_error (&error);
+	}
+	return db->key_file;
+}
+
+static void
+_db_flush (SettingsDb *db)
+{
+	gs_free char *data = NULL;
+	GError *error = NULL;
+	gsize len;
+
+	nm_clear_g_source (&db->flush_id);
+	if (!db->dirty)
+		return;
+	db->dirty = FALSE;
+
+	data = g_key_file_to_data (db->key_file, &len, &error);
+	if (data)
+		g_file_set_contents (db->filename, data, len, &error);
+	if (error) {
+		nm_log_warn (LOGD_SETTINGS, "error writing %s file '%s': %s",
+		             db->name, db->filename, error->message);
+		g_error_free (error);
 	}
-	g_key_file_free (key_file);
+}
+
+static gboolean
+_db_flush_cb (gpointer user_data)
+{
+	SettingsDb *db = user_data;
+
+	db->flush_id = 0;
+	_db_flush (db);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_db_changed (SettingsDb *db)
+{
+	db->dirty = TRUE;
+	if (!db->flush_id)
+		db->flush_id = g_timeout_add_seconds (DB_FLUSH_INTERVAL_SEC, _db_flush_cb, db);
+}
+
+/**
+ * nm_settings_connection_flush_databases:
+ *
+ * Writes pending changes of the timestamps and seen-bssids databases
+ * to disk now.
+ */
+void
+nm_settings_connection_flush_databases (void)
+{
+	_db_flush (&db_timestamps);
+	_db_flush (&db_seen_bssids);
+}
+
+static void
+remove_entry_from_db (NMSettingsConnection *self, SettingsDb *db)
+{
+	if (g_key_file_remove_key (_db_get (db), db->name, nm_settings_connection_get_uuid (self), NULL))
+		_db_changed (db);
 }
 
 static void
@@ -745,10 +945,10 @@ do_delete (NMSettingsConnection *self,
 	g_object_unref (for_agents);
 
 	/* Remove timestamp from timestamps database file */
-	remove_entry_from_db (self, "timestamps");
+	remove_entry_from_db (self, &db_timestamps);
 
 	/* Remove connection from seen-bssids database file */
-	remove_entry_from_db (self, "seen-bssids");
+	remove_entry_from_db (self, &db_seen_bssids);
 
 	nm_settings_connection_signal_remove (self);
 
@@ -780,8 +980,15 @@ struct _NMSettingsConnectionCallId {
 		struct {
 			guint32 id;
 			GError *error;
+			/* complete with these secrets instead of @error */
+			NMSecretsCacheEntry *cache;
 		} idle;
 	} t;
+
+	/* the requester, and the flags of the request without
+	 * NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED */
+	NMAuthSubject *subject;
+	NMSecretAgentGetSecretsFlags flags;
 };
 
 typedef struct _NMSettingsConnectionCallId GetSecretsInfo;
@@ -832,8 +1039,11 @@ _get_secrets_info_free (GetSecretsInfo *info)
 	if (info->applied_connection)
 		g_object_remove_weak_pointer (G_OBJECT (info->applied_connection), (gpointer *) &info->applied_connection);
 
-	if (info->type == GET_SECRETS_INFO_TYPE_IDLE)
+	if (info->type == GET_SECRETS_INFO_TYPE_IDLE) {
 		g_clear_error (&info->t.idle.error);
+		g_clear_pointer (&info->t.idle.cache, nm_secrets_cache_entry_free);
+	}
+	g_clear_object (&info->subject);
 
 	memset (info, 0, sizeof (*info));
 	g_slice_free (GetSecretsInfo, info);
@@ -1059,6 +1269,19 @@ get_secrets_done_cb (NMAgentManager *manager,
 			update_system_secrets_cache (self);
 			update_agent_secrets_cache (self, NULL);
 
+			/* Remember what the agent returned, unless these are already
+			 * replayed from the cache. */
+			if (   agent_dbus_owner
+			    && info->subject
+			    && info->type == GET_SECRETS_INFO_TYPE_REQ) {
+				secrets_cache_set (self,
+				                   info->subject,
+				                   setting_name,
+				                   secrets,
+				                   agent_dbus_owner,
+				                   agent_username);
+			}
+
 			/* Only save secrets to backing storage if the agent returned any
 			 * new system secrets.  If it didn't, then the secrets are agent-
 			 * owned and there's no point to writing out the connection when
@@ -1134,6 +1357,27 @@ get_secrets_idle_cb (GetSecretsInfo *info)
 
 	g_return_val_if_fail (g_slist_find (priv->get_secret_requests, info), G_SOURCE_REMOVE);
 
+	if (info->t.idle.cache) {
+		const NMSecretsCacheEntry *cache = info->t.idle.cache;
+
+		/* handle the cached secrets as if the agent just returned them for
+		 * this request. That also frees @info. Whether the agent was allowed
+		 * to modify the connection back then doesn't matter now: system-owned
+		 * secrets were already saved when the agent returned them, and are
+		 * never accepted from the cache. */
+		get_secrets_done_cb (priv->agent_mgr,
+		                     NULL,
+		                     cache->agent_dbus_owner,
+		                     cache->agent_username,
+		                     FALSE,
+		                     cache->setting_name,
+		                     info->flags,
+		                     cache->secrets,
+		                     NULL,
+		                     info);
+		return G_SOURCE_REMOVE;
+	}
+
 	priv->get_secret_requests = g_slist_remove (priv->get_secret_requests, info);
 
 	_get_secrets_info_callback (info, NULL, NULL, info->t.idle.error);
@@ -1150,7 +1394,9 @@ get_secrets_idle_cb (GetSecretsInfo *info)
  *   in the @applied_connection.
  * @subject: the #NMAuthSubject originating the request
  * @setting_name: the setting to return secrets for
- * @flags: flags to modify the secrets request
+ * @flags: flags to modify the secrets request. With
+ *   %NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED, the secrets that an agent
+ *   returned recently for @setting_name are used again, if there are any.
  * @hints: key names in @setting_name for which secrets may be required, or some
  *   other information about the request
  * @callback: the function to call with returned secrets
@@ -1193,6 +1439,9 @@ nm_settings_connection_get_secrets (NMSettingsConnection *self,
 	                              applied_connection,
 	                              callback,
 	                              callback_data);
+	info->subject = subject ? g_object_ref (subject) : NULL;
+	/* the agent manager doesn't know about the cache */
+	info->flags = flags & ~NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED;
 
 	priv->get_secret_requests = g_slist_append (priv->get_secret_requests, info);
 
@@ -1220,6 +1469,30 @@ nm_settings_connection_get_secrets (NMSettingsConnection *self,
 		goto schedule_dummy;
 	}
 
+	if (NM_FLAGS_HAS (flags, NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW))
+		nm_settings_connection_clear_secrets_cache (self);
+	else if (   NM_FLAGS_HAS (flags, NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED)
+	         && priv->secrets_cache
+	         && subject) {
+		const NMSecretsCacheEntry *cache;
+
+		cache = nm_secrets_cache_lookup (priv->secrets_cache,
+		                                 subject,
+		                                 setting_name,
+		                                 nm_utils_get_monotonic_timestamp_s ());
+		if (cache) {
+			_LOGD ("(%s:%p) secrets requested, use cached secrets of agent %s",
+			       setting_name,
+			       info,
+			       cache->agent_dbus_owner);
+			info->type = GET_SECRETS_INFO_TYPE_IDLE;
+			info->t.idle.cache = nm_secrets_cache_entry_dup (cache);
+			info->t.idle.id = g_idle_add ((GSourceFunc) get_secrets_idle_cb, info);
+			return info;
+		}
+	}
+	flags = info->flags;
+
 	existing_secrets = nm_connection_to_dbus (priv->system_secrets, NM_CONNECTION_SERIALIZE_ONLY_SECRETS);
 	if (existing_secrets)
 		g_variant_ref_sink (existing_secrets);
@@ -1452,6 +1725,69 @@ check_writable (NMConnection *self, GError **error)
 	return TRUE;
 }
 
+/**
+ * nm_settings_connection_get_settings_variant:
+ * @self: the #NMSettingsConnection
+ *
+ * Serializes the connection as returned to D-Bus clients by GetSettings():
+ * without secrets, but with the timestamp and seen BSSIDs that are tracked
+ * outside the settings.
+ *
+ * The result is cached until the connection changes, so that repeated
+ * requests share the same variant.
+ *
+ * Returns: (transfer none): the settings
+ */
+GVariant *
+nm_settings_connection_get_settings_variant (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv;
+	gs_unref_object NMConnection *dupl_con = NULL;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	guint64 timestamp = 0;
+	char **bssids;
+
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), NULL);
+
+	priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	if (priv->settings_variant)
+		return priv->settings_variant;
+
+	dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
+	g_assert (dupl_con);
+
+	/* Timestamp is not updated in connection's 'timestamp' property,
+	 * because it would force updating the connection and in turn
+	 * writing to /etc periodically, which we want to avoid. Rather real
+	 * timestamps are kept track of in a private variable. So, substitute
+	 * timestamp property with the real one here before returning the settings.
+	 */
+	nm_settings_connection_get_timestamp (self, &timestamp);
+	if (timestamp) {
+		s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
+		g_assert (s_con);
+		g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
+	}
+	/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
+	 * from the same reason as timestamp. Thus we put it here to GetSettings()
+	 * return settings too.
+	 */
+	bssids = nm_settings_connection_get_seen_bssids (self);
+	s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
+	if (bssids && bssids[0] && s_wifi)
+		g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
+	g_free (bssids);
+
+	/* Secrets should *never* be returned by the GetSettings method, they
+	 * get returned by the GetSecrets method which can be better
+	 * protected against leakage of secrets to unprivileged callers.
+	 */
+	priv->settings_variant = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_variant_ref_sink (priv->settings_variant);
+	return priv->settings_variant;
+}
+
 static void
 get_settings_auth_cb (NMSettingsConnection *self, 
                       GDBusMethodInvocation *context,
@@ -1463,46 +1799,11 @@ get_settings_auth_cb (NMSettingsConnection *self,
 		g_dbus_method_invocation_return_gerror (context, error);
 	else {
 		GVariant *settings;
-		NMConnection *dupl_con;
-		NMSettingConnection *s_con;
-		NMSettingWireless *s_wifi;
-		guint64 timestamp = 0;
-		char **bssids;
-
-		dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
-		g_assert (dupl_con);
-
-		/* Timestamp is not updated in connection's 'timestamp' property,
-		 * because it would force updating the connection and in turn
-		 * writing to /etc periodically, which we want to avoid. Rather real
-		 * timestamps are kept track of in a private variable. So, substitute
-		 * timestamp property with the real one here before returning the settings.
-		 */
-		nm_settings_connection_get_timestamp (self, &timestamp);
-		if (timestamp) {
-			s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
-			g_assert (s_con);
-			g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
-		}
-		/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
-		 * from the same reason as timestamp. Thus we put it here to GetSettings()
-		 * return settings too.
-		 */
-		bssids = nm_settings_connection_get_seen_bssids (self);
-		s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
-		if (bssids && bssids[0] && s_wifi)
-			g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
-		g_free (bssids);
-
-		/* Secrets should *never* be returned by the GetSettings method, they
-		 * get returned by the GetSecrets method which can be better
-		 * protected against leakage of secrets to unprivileged callers.
-		 */
-		settings = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
+
+		settings = nm_settings_connection_get_settings_variant (self);
 		g_assert (settings);
 		g_dbus_method_invocation_return_value (context,
 		                                       g_variant_new ("(@a{sa{sv}})", settings));
-		g_object_unref (dupl_con);
 	}
 }
 
@@ -2045,6 +2346,7 @@ dbus_clear_secrets_auth_cb (NMSettingsConnection *self,
 			nm_connection_clear_secrets (priv->system_secrets);
 		if (priv->agent_secrets)
 			nm_connection_clear_secrets (priv->agent_secrets);
+		nm_settings_connection_clear_secrets_cache (self);
 
 		/* Tell agents to remove secrets for this connection */
 		nm_agent_manager_delete_secrets (priv->agent_mgr,
@@ -2175,9 +2477,11 @@ nm_settings_connection_get_timestamp (NMSettingsConnection *self,
  * @self: the #NMSettingsConnection
  * @timestamp: timestamp to set into the connection and to store into
  * the timestamps database
- * @flush_to_disk: if %TRUE, commit timestamp update to persistent storage
+ * @flush_to_disk: if %TRUE, also store the timestamp into the timestamps database
  *
  * Updates the connection and timestamps database with the provided timestamp.
+ * The database is written to disk with a delay, see
+ * nm_settings_connection_flush_databases().
  **/
 void
 nm_settings_connection_update_timestamp (NMSettingsConnection *self,
@@ -2187,50 +2491,39 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 	const char *connection_uuid;
 	GKeyFile *timestamps_file;
-	char *data, *tmp;
-	gsize len;
-	GError *error = NULL;
+	gs_free char *old = NULL;
+	char tmp[30];
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
 	/* Update timestamp in private storage */
-	priv->timestamp = timestamp;
-	priv->timestamp_set = TRUE;
+	if (priv->timestamp != timestamp || !priv->timestamp_set) {
+		priv->timestamp = timestamp;
+		priv->timestamp_set = TRUE;
+		_settings_variant_clear (self);
+		_notify (self, PROP_TIMESTAMP);
+	}
 
 	if (flush_to_disk == FALSE)
 		return;
 
-	/* Save timestamp to timestamps database file */
-	timestamps_file = g_key_file_new ();
-	if (!g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
-			_LOGW ("error parsing timestamps file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_clear_error (&error);
-	}
-
+	/* Save timestamp to timestamps database */
+	timestamps_file = _db_get (&db_timestamps);
 	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp = g_strdup_printf ("%" G_GUINT64_FORMAT, timestamp);
-	g_key_file_set_value (timestamps_file, "timestamps", connection_uuid, tmp);
-	g_free (tmp);
-
-	data = g_key_file_to_data (timestamps_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_TIMESTAMPS_FILE, data, len, &error);
-		g_free (data);
-	}
-	if (error) {
-		_LOGW ("error saving timestamp to file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_error_free (error);
+	nm_sprintf_buf (tmp, "%" G_GUINT64_FORMAT, timestamp);
+	old = g_key_file_get_value (timestamps_file, db_timestamps.name, connection_uuid, NULL);
+	if (g_strcmp0 (old, tmp) != 0) {
+		g_key_file_set_value (timestamps_file, db_timestamps.name, connection_uuid, tmp);
+		_db_changed (&db_timestamps);
 	}
-	g_key_file_free (timestamps_file);
 }
 
 /**
  * nm_settings_connection_read_and_fill_timestamp:
  * @self: the #NMSettingsConnection
  *
- * Retrieves timestamp of the connection's last usage from database file and
- * stores it into the connection private data.
+ * Retrieves timestamp of the connection's last usage from the timestamps
+ * database and stores it into the connection private data.
  **/
 void
 nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
@@ -2244,11 +2537,10 @@ nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
-	/* Get timestamp from database file */
-	timestamps_file = g_key_file_new ();
-	g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL);
+	/* Get timestamp from database */
+	timestamps_file = _db_get (&db_timestamps);
 	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp_str = g_key_file_get_value (timestamps_file, "timestamps", connection_uuid, &err);
+	tmp_str = g_key_file_get_value (timestamps_file, db_timestamps.name, connection_uuid, &err);
 	if (tmp_str) {
 		timestamp = g_ascii_strtoull (tmp_str, NULL, 10);
 		g_free (tmp_str);
@@ -2256,13 +2548,16 @@ nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 
 	/* Update connection's timestamp */
 	if (!err) {
-		priv->timestamp = timestamp;
-		priv->timestamp_set = TRUE;
+		if (priv->timestamp != timestamp || !priv->timestamp_set) {
+			priv->timestamp = timestamp;
+			priv->timestamp_set = TRUE;
+			_settings_variant_clear (self);
+			_notify (self, PROP_TIMESTAMP);
+		}
 	} else {
 		_LOGD ("failed to read connection timestamp: %s", err->message);
 		g_clear_error (&err);
 	}
-	g_key_file_free (timestamps_file);
 }
 
 /**
@@ -2326,11 +2621,8 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
-	char *data, *bssid_str;
+	char *bssid_str;
 	const char **list;
-	gsize len;
-	GError *error = NULL;
 	GHashTableIter iter;
 	guint n;
 
@@ -2342,6 +2634,7 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	/* Add the new BSSID; let the hash take ownership of the allocated BSSID string */
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
+	_settings_variant_clear (self);
 
 	/* Build up a list of all the BSSIDs in string form */
 	n = 0;
@@ -2350,60 +2643,34 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &bssid_str))
 		list[n++] = bssid_str;
 
-	/* Save BSSID to seen-bssids file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (!g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
-			_LOGW ("error parsing seen-bssids file '%s': %s",
-			       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		}
-		g_clear_error (&error);
-	}
-
+	/* Save BSSID to seen-bssids database */
 	connection_uuid = nm_settings_connection_get_uuid (self);
-	g_key_file_set_string_list (seen_bssids_file, "seen-bssids", connection_uuid, list, n);
+	g_key_file_set_string_list (_db_get (&db_seen_bssids), db_seen_bssids.name, connection_uuid, list, n);
 	g_free (list);
-
-	data = g_key_file_to_data (seen_bssids_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_SEEN_BSSIDS_FILE, data, len, &error);
-		g_free (data);
-	}
-	g_key_file_free (seen_bssids_file);
-
-	if (error) {
-		_LOGW ("error saving seen-bssids to file '%s': %s",
-		       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		g_error_free (error);
-	}
+	_db_changed (&db_seen_bssids);
 }
 
 /**
  * nm_settings_connection_read_and_fill_seen_bssids:
  * @self: the #NMSettingsConnection
  *
- * Retrieves seen BSSIDs of the connection from database file and stores then into the
- * connection private data.
+ * Retrieves seen BSSIDs of the connection from the seen-bssids database and stores
+ * them into the connection private data.
  **/
 void
 nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
-	char **tmp_strv = NULL;
+	char **tmp_strv;
 	gsize i, len = 0;
 	NMSettingWireless *s_wifi;
 
-	/* Get seen BSSIDs from database file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		connection_uuid = nm_settings_connection_get_uuid (self);
-		tmp_strv = g_key_file_get_string_list (seen_bssids_file, "seen-bssids", connection_uuid, &len, NULL);
-	}
-	g_key_file_free (seen_bssids_file);
+	_settings_variant_clear (self);
+
+	/* Get seen BSSIDs from database */
+	connection_uuid = nm_settings_connection_get_uuid (self);
+	tmp_strv = g_key_file_get_string_list (_db_get (&db_seen_bssids), db_seen_bssids.name, connection_uuid, &len, NULL);
 
 	/* Update connection's seen-bssids */
 	if (tmp_strv) {
@@ -2612,6 +2879,9 @@ nm_settings_connection_init (NMSettingsConnection *self)
 	priv->visible = FALSE;
 	priv->ready = TRUE;
 
+	nm_statistics_memory_add (NM_STATISTICS_MEMORY_SETTINGS_CONNECTIONS,
+	                          sizeof (NMSettingsConnection) + sizeof (NMSettingsConnectionPrivate));
+
 	priv->session_monitor = g_object_ref (nm_session_monitor_get ());
 	priv->session_changed_id = g_signal_connect (priv->session_monitor,
 	                                             NM_SESSION_MONITOR_CHANGED,
@@ -2626,6 +2896,7 @@ nm_settings_connection_init (NMSettingsConnection *self)
 
 	g_signal_connect (self, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), NULL);
 	g_signal_connect (self, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_cb), NULL);
+	g_signal_connect (self, NM_CONNECTION_CHANGED, G_CALLBACK (settings_variant_changed_cb), NULL);
 }
 
 static void
@@ -2662,16 +2933,19 @@ dispose (GObject *object)
 	 */
 	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (secrets_cleared_cb), NULL);
 	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (connection_changed_cb), NULL);
+	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (settings_variant_changed_cb), NULL);
 
 	nm_connection_clear_secrets (NM_CONNECTION (self));
 	g_clear_object (&priv->system_secrets);
 	g_clear_object (&priv->agent_secrets);
+	g_clear_pointer (&priv->secrets_cache, nm_secrets_cache_free);
 
 	/* Cancel PolicyKit requests */
 	g_slist_free_full (priv->pending_auths, (GDestroyNotify) nm_auth_chain_unref);
 	priv->pending_auths = NULL;
 
 	g_clear_pointer (&priv->seen_bssids, (GDestroyNotify) g_hash_table_destroy);
+	_settings_variant_clear (self);
 
 	set_visible (self, FALSE);
 
@@ -2685,6 +2959,15 @@ dispose (GObject *object)
 	G_OBJECT_CLASS (nm_settings_connection_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+	nm_statistics_memory_remove (NM_STATISTICS_MEMORY_SETTINGS_CONNECTIONS,
+	                             sizeof (NMSettingsConnection) + sizeof (NMSettingsConnectionPrivate));
+
+	G_OBJECT_CLASS (nm_settings_connection_parent_class)->finalize (object);
+}
+
 static void
 get_property (GObject *object, guint prop_id,
               GValue *value, GParamSpec *pspec)
@@ -2708,6 +2991,9 @@ get_property (GObject *object, guint prop_id,
 	case PROP_FILENAME:
 		g_value_set_string (value, nm_settings_connection_get_filename (self));
 		break;
+	case PROP_TIMESTAMP:
+		g_value_set_uint64 (value, priv->timestamp);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -2749,6 +3035,7 @@ nm_settings_connection_class_init (NMSettingsConnectionClass *class)
 	/* Virtual methods */
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
+	object_class->finalize = finalize;
 	object_class->get_property = get_property;
 	object_class->set_property = set_property;
 
@@ -2790,6 +3077,12 @@ nm_settings_connection_class_init (NMSettingsConnectionClass *class)
 	                          G_PARAM_READWRITE |
 	                          G_PARAM_STATIC_STRINGS);
 
+	obj_properties[PROP_TIMESTAMP] =
+	     g_param_spec_uint64 (NM_SETTINGS_CONNECTION_TIMESTAMP, "", "",
+	                          0, G_MAXUINT64, 0,
+	                          G_PARAM_READABLE |
+	                          G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	/* Signals */
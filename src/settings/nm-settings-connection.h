@@ -53,6 +53,9 @@ G_BEGIN_DECLS
 #define NM_SETTINGS_CONNECTION_FLAGS    "flags"
 #define NM_SETTINGS_CONNECTION_FILENAME "filename"
 
+/* Internal properties */
+#define NM_SETTINGS_CONNECTION_TIMESTAMP "timestamp"
+
 
 /**
  * NMSettingsConnectionFlags:
@@ -169,6 +172,10 @@ NMSettingsConnectionCallId nm_settings_connection_get_secrets (NMSettingsConnect
 void nm_settings_connection_cancel_secrets (NMSettingsConnection *self,
                                             NMSettingsConnectionCallId call_id);
 
+void nm_settings_connection_clear_secrets_cache (NMSettingsConnection *self);
+void nm_settings_connection_clear_secrets_cache_for_agent (NMSettingsConnection *self,
+                                                           const char *agent_dbus_owner);
+
 gboolean nm_settings_connection_is_visible (NMSettingsConnection *self);
 
 void nm_settings_connection_recheck_visibility (NMSettingsConnection *self);
@@ -203,6 +210,10 @@ void nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 
 void nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self);
 
+void nm_settings_connection_flush_databases (void);
+
+GVariant *nm_settings_connection_get_settings_variant (NMSettingsConnection *self);
+
 int nm_settings_connection_get_autoconnect_retries (NMSettingsConnection *self);
 void nm_settings_connection_set_autoconnect_retries (NMSettingsConnection *self,
                                                      int retries);
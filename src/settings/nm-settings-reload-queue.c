@@ -0,0 +1,189 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-settings-reload-queue.h"
+
+#include "nm-core-internal.h"
+
+/* Collects the paths reported by a plugin's directory monitor and hands
+ * them back in one batch, NM_SETTINGS_RELOAD_QUEUE_DELAY_MS after the
+ * first change. Tools that rewrite many files at once thus cause a
+ * single reload, and every file is read at most once per batch.
+ *
+ * For each path the checksum of the content seen by the last batch
+ * is remembered. Rewrites that leave the content unchanged are dropped,
+ * unless the connection in memory has unsaved changes: reloading the
+ * file reverts those, as it always did. The first change of a file is
+ * always passed on, since there is no checksum for it yet. */
+
+struct _NMSettingsReloadQueue {
+	NMSettingsReloadQueueFunc func;
+	NMSettingsReloadQueueUnsavedFunc unsaved_func;
+	gpointer user_data;
+
+	/* queued paths in order, and the same as a set */
+	GPtrArray *pending;
+	GHashTable *pending_set;
+	guint timeout_id;
+
+	/* path -> checksum of the content at the last batch */
+	GHashTable *checksums;
+};
+
+static char *
+_file_checksum (const char *path)
+{
+	gs_free char *contents = NULL;
+	gsize len;
+
+	if (!g_file_get_contents (path, &contents, &len, NULL))
+		return NULL;
+	return g_compute_checksum_for_data (G_CHECKSUM_SHA256, (const guchar *) contents, len);
+}
+
+static gboolean
+_flush_cb (gpointer user_data)
+{
+	NMSettingsReloadQueue *queue = user_data;
+
+	queue->timeout_id = 0;
+	nm_settings_reload_queue_flush (queue);
+	return G_SOURCE_REMOVE;
+}
+
+NMSettingsReloadQueue *
+nm_settings_reload_queue_new (NMSettingsReloadQueueFunc func,
+                              NMSettingsReloadQueueUnsavedFunc unsaved_func,
+                              gpointer user_data)
+{
+	NMSettingsReloadQueue *queue;
+
+	g_return_val_if_fail (func, NULL);
+
+	queue = g_slice_new0 (NMSettingsReloadQueue);
+	queue->func = func;
+	queue->unsaved_func = unsaved_func;
+	queue->user_data = user_data;
+	queue->pending = g_ptr_array_new_with_free_func (g_free);
+	queue->pending_set = g_hash_table_new (g_str_hash, g_str_equal);
+	queue->checksums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	return queue;
+}
+
+/* Pending changes are dropped, not applied. */
+void
+nm_settings_reload_queue_free (NMSettingsReloadQueue *queue)
+{
+	if (!queue)
+		return;
+
+	nm_clear_g_source (&queue->timeout_id);
+	g_hash_table_unref (queue->pending_set);
+	g_ptr_array_unref (queue->pending);
+	g_hash_table_unref (queue->checksums);
+	g_slice_free (NMSettingsReloadQueue, queue);
+}
+
+/**
+ * nm_settings_reload_queue_add:
+ * @queue: the queue
+ * @path: a file that was created, changed or deleted
+ *
+ * Queues @path for the next batch, which is started unless one is
+ * already scheduled. The schedule is not extended by later changes,
+ * so a constant stream of events still gets applied.
+ */
+void
+nm_settings_reload_queue_add (NMSettingsReloadQueue *queue, const char *path)
+{
+	char *p;
+
+	g_return_if_fail (queue);
+	g_return_if_fail (path);
+
+	if (!g_hash_table_contains (queue->pending_set, path)) {
+		p = g_strdup (path);
+		g_ptr_array_add (queue->pending, p);
+		g_hash_table_add (queue->pending_set, p);
+	}
+
+	if (!queue->timeout_id)
+		queue->timeout_id = g_timeout_add (NM_SETTINGS_RELOAD_QUEUE_DELAY_MS, _flush_cb, queue);
+}
+
+/**
+ * nm_settings_reload_queue_flush:
+ * @queue: the queue
+ *
+ * Applies the pending changes now. Paths whose content is unchanged since
+ * the previous batch are skipped, unless their connection has unsaved
+ * changes; the rest is passed to the callback in one call.
+ */
+void
+nm_settings_reload_queue_flush (NMSettingsReloadQueue *queue)
+{
+	gs_unref_ptrarray GPtrArray *pending = NULL;
+	gs_unref_ptrarray GPtrArray *changed = NULL;
+	guint i;
+
+	g_return_if_fail (queue);
+
+	nm_clear_g_source (&queue->timeout_id);
+	if (!queue->pending->len)
+		return;
+
+	/* take the batch, the callback might queue new paths */
+	pending = queue->pending;
+	queue->pending = g_ptr_array_new_with_free_func (g_free);
+	g_hash_table_remove_all (queue->pending_set);
+
+	changed = g_ptr_array_sized_new (pending->len);
+	for (i = 0; i < pending->len; i++) {
+		const char *path = pending->pdata[i];
+		char *checksum;
+
+		checksum = _file_checksum (path);
+		if (!checksum) {
+			g_hash_table_remove (queue->checksums, path);
+			g_ptr_array_add (changed, (gpointer) path);
+			continue;
+		}
+
+		if (g_strcmp0 (checksum, g_hash_table_lookup (queue->checksums, path)) == 0) {
+			if (   !queue->unsaved_func
+			    || !queue->unsaved_func (path, queue->user_data)) {
+				nm_log_dbg (LOGD_SETTINGS, "reload-queue: %s unchanged", path);
+				g_free (checksum);
+				continue;
+			}
+			nm_log_dbg (LOGD_SETTINGS, "reload-queue: %s unchanged, but its connection has unsaved changes", path);
+		}
+
+		g_hash_table_insert (queue->checksums, g_strdup (path), checksum);
+		g_ptr_array_add (changed, (gpointer) path);
+	}
+
+	nm_log_dbg (LOGD_SETTINGS, "reload-queue: %u of %u queued files changed",
+	            changed->len, pending->len);
+	if (changed->len)
+		queue->func (changed, queue->user_data);
+}
@@ -0,0 +1,60 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_SETTINGS_RELOAD_QUEUE_H__
+#define __NETWORKMANAGER_SETTINGS_RELOAD_QUEUE_H__
+
+#include "nm-default.h"
+
+/* how long changes of files are collected before they are applied */
+#define NM_SETTINGS_RELOAD_QUEUE_DELAY_MS 200
+
+typedef struct _NMSettingsReloadQueue NMSettingsReloadQueue;
+
+/**
+ * NMSettingsReloadQueueFunc:
+ * @paths: the changed files, in the order they were first queued.
+ *   Deleted files are included.
+ * @user_data: user data
+ *
+ * Called once per batch with all files whose content changed.
+ */
+typedef void (*NMSettingsReloadQueueFunc) (const GPtrArray *paths, gpointer user_data);
+
+/**
+ * NMSettingsReloadQueueUnsavedFunc:
+ * @path: a queued file whose content did not change
+ * @user_data: user data
+ *
+ * Returns: whether the connection read from @path has unsaved changes
+ *   in memory. Such files are reloaded anyway, which reverts the
+ *   connection to the content of the file.
+ */
+typedef gboolean (*NMSettingsReloadQueueUnsavedFunc) (const char *path, gpointer user_data);
+
+NMSettingsReloadQueue *nm_settings_reload_queue_new (NMSettingsReloadQueueFunc func,
+                                                     NMSettingsReloadQueueUnsavedFunc unsaved_func,
+                                                     gpointer user_data);
+void nm_settings_reload_queue_free (NMSettingsReloadQueue *queue);
+
+void nm_settings_reload_queue_add (NMSettingsReloadQueue *queue, const char *path);
+void nm_settings_reload_queue_flush (NMSettingsReloadQueue *queue);
+
+#endif  /* __NETWORKMANAGER_SETTINGS_RELOAD_QUEUE_H__ */
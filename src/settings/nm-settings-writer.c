@@ -0,0 +1,297 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-settings-writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "nm-core-internal.h"
+
+/* Writes the files of the settings plugins.
+ *
+ * A file whose content would not change is not written at all. For
+ * each written path the checksum of the content and the stat data of
+ * the file are remembered, so that an unchanged file is recognized
+ * without reading it again. When the file was modified by somebody
+ * else since, its content is compared instead.
+ *
+ * Files are replaced atomically by renaming a temporary file, which is
+ * synced before the rename, like g_file_set_contents() does. Only the
+ * renames are synced lazily: the directories of all files written within
+ * NM_SETTINGS_WRITER_SYNC_DELAY_MS are synced together afterwards, so
+ * that bulk edits of many profiles sync each directory just once. */
+
+typedef struct {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	char *checksum;
+} FileState;
+
+static struct {
+	/* path -> FileState of the last write */
+	GHashTable *states;
+	/* directories with files that were not yet synced */
+	GHashTable *pending_dirs;
+	guint sync_id;
+} writer;
+
+/*****************************************************************************/
+
+static void
+_file_state_free (gpointer data)
+{
+	FileState *state = data;
+
+	g_free (state->checksum);
+	g_slice_free (FileState, state);
+}
+
+static gboolean
+_file_state_matches (const FileState *state, const struct stat *st)
+{
+	return    state->dev == st->st_dev
+	       && state->ino == st->st_ino
+	       && state->size == st->st_size
+	       && state->mtime.tv_sec == st->st_mtim.tv_sec
+	       && state->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void
+_file_state_set (const char *filename, const struct stat *st, char *checksum)
+{
+	FileState *state;
+
+	if (!writer.states)
+		writer.states = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _file_state_free);
+
+	state = g_slice_new (FileState);
+	state->dev = st->st_dev;
+	state->ino = st->st_ino;
+	state->size = st->st_size;
+	state->mtime = st->st_mtim;
+	state->checksum = checksum;
+	g_hash_table_insert (writer.states, g_strdup (filename), state);
+}
+
+static gboolean
+_file_has_contents (const char *filename, const char *contents, gsize length)
+{
+	gs_free char *old_contents = NULL;
+	gsize old_length;
+
+	return    g_file_get_contents (filename, &old_contents, &old_length, NULL)
+	       && old_length == length
+	       && !memcmp (old_contents, contents, length);
+}
+
+/*****************************************************************************/
+
+static void
+_sync_dir (const char *dirname)
+{
+	int fd;
+	int errsv;
+
+	fd = open (dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		errsv = errno;
+		nm_log_warn (LOGD_SETTINGS, "settings: cannot open directory '%s' for syncing: %s",
+		             dirname, g_strerror (errsv));
+		return;
+	}
+
+	if (fsync (fd) < 0) {
+		errsv = errno;
+		nm_log_warn (LOGD_SETTINGS, "settings: cannot sync directory '%s': %s",
+		             dirname, g_strerror (errsv));
+	}
+	close (fd);
+}
+
+/**
+ * nm_settings_write_sync:
+ *
+ * Syncs the files written by nm_settings_write_file() right away,
+ * instead of waiting for NM_SETTINGS_WRITER_SYNC_DELAY_MS.
+ */
+void
+nm_settings_write_sync (void)
+{
+	GHashTableIter iter;
+	const char *dirname;
+
+	nm_clear_g_source (&writer.sync_id);
+
+	if (!writer.pending_dirs)
+		return;
+
+	g_hash_table_iter_init (&iter, writer.pending_dirs);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &dirname, NULL)) {
+		_sync_dir (dirname);
+		g_hash_table_iter_remove (&iter);
+	}
+}
+
+static gboolean
+_sync_cb (gpointer user_data)
+{
+	writer.sync_id = 0;
+	nm_settings_write_sync ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_sync_schedule (const char *filename)
+{
+	if (!writer.pending_dirs)
+		writer.pending_dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_add (writer.pending_dirs, g_path_get_dirname (filename));
+
+	if (!writer.sync_id)
+		writer.sync_id = g_timeout_add (NM_SETTINGS_WRITER_SYNC_DELAY_MS, _sync_cb, NULL);
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_settings_write_file:
+ * @filename: the file to write
+ * @contents: the new content
+ * @length: the length of @contents
+ * @out_unchanged: (allow-none): set to %TRUE, if @filename already had
+ *   the content and was not written
+ * @error: location for a #GError, or %NULL
+ *
+ * Replaces the content of @filename like g_file_set_contents(), unless
+ * it already has the same content. The file is created with mode 0666,
+ * modified by the umask.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_settings_write_file (const char *filename,
+                        const char *contents,
+                        gsize length,
+                        gboolean *out_unchanged,
+                        GError **error)
+{
+	gs_free char *checksum = NULL;
+	gs_free char *tmp_name = NULL;
+	const FileState *state;
+	struct stat st;
+	gsize written = 0;
+	int fd;
+	int errsv;
+
+	g_return_val_if_fail (filename, FALSE);
+	g_return_val_if_fail (contents || !length, FALSE);
+
+	NM_SET_OUT (out_unchanged, FALSE);
+
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256, (const guchar *) contents, length);
+
+	if (   stat (filename, &st) == 0
+	    && S_ISREG (st.st_mode)
+	    && st.st_size == length) {
+		state = writer.states ? g_hash_table_lookup (writer.states, filename) : NULL;
+
+		if (  state && _file_state_matches (state, &st)
+		    ? nm_streq (state->checksum, checksum)
+		    : _file_has_contents (filename, contents, length)) {
+			_file_state_set (filename, &st, g_steal_pointer (&checksum));
+			NM_SET_OUT (out_unchanged, TRUE);
+			return TRUE;
+		}
+	}
+
+	tmp_name = g_strdup_printf ("%s.XXXXXX", filename);
+	fd = g_mkstemp_full (tmp_name, O_WRONLY | O_CLOEXEC, 0666);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to create file '%s': %s",
+		             tmp_name, g_strerror (errsv));
+		return FALSE;
+	}
+
+	while (written < length) {
+		ssize_t n;
+
+		n = write (fd, contents + written, length - written);
+		if (n < 0) {
+			errsv = errno;
+			if (errsv == EINTR)
+				continue;
+			g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+			             "Failed to write file '%s': %s",
+			             tmp_name, g_strerror (errsv));
+			close (fd);
+			goto out_unlink;
+		}
+		written += n;
+	}
+
+	/* without it, the file might be empty after a crash, once the
+	 * rename made it to the disk. */
+	if (fsync (fd) < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to sync file '%s': %s",
+		             tmp_name, g_strerror (errsv));
+		close (fd);
+		goto out_unlink;
+	}
+
+	if (close (fd) < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to close file '%s': %s",
+		             tmp_name, g_strerror (errsv));
+		goto out_unlink;
+	}
+
+	if (rename (tmp_name, filename) < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to rename file '%s' to '%s': %s",
+		             tmp_name, filename, g_strerror (errsv));
+		goto out_unlink;
+	}
+
+	if (stat (filename, &st) == 0)
+		_file_state_set (filename, &st, g_steal_pointer (&checksum));
+	else if (writer.states)
+		g_hash_table_remove (writer.states, filename);
+
+	_sync_schedule (filename);
+	return TRUE;
+
+out_unlink:
+	unlink (tmp_name);
+	return FALSE;
+}
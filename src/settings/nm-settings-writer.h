@@ -0,0 +1,37 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_SETTINGS_WRITER_H__
+#define __NETWORKMANAGER_SETTINGS_WRITER_H__
+
+#include "nm-default.h"
+
+/* how long written files are collected before they are synced to disk */
+#define NM_SETTINGS_WRITER_SYNC_DELAY_MS 100
+
+gboolean nm_settings_write_file (const char *filename,
+                                 const char *contents,
+                                 gsize length,
+                                 gboolean *out_unchanged,
+                                 GError **error);
+
+void nm_settings_write_sync (void);
+
+#endif  /* __NETWORKMANAGER_SETTINGS_WRITER_H__ */
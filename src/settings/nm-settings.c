@@ -73,6 +73,8 @@
 #include "nm-audit-manager.h"
 #include "NetworkManagerUtils.h"
 #include "nm-dispatcher.h"
+#include "nm-executor.h"
+#include "nm-startup-profile.h"
 
 #include "nmdbus-settings.h"
 
@@ -149,6 +151,30 @@ typedef struct {
 	gboolean connections_loaded;
 	GHashTable *connections;
 	NMSettingsConnection **connections_cached_list;
+
+	/* connection.uuid -> connection. The UUID cannot change once
+	 * a connection is exported. The keys are interned and hashed
+	 * by pointer. */
+	GHashTable *connections_by_uuid;
+
+	/* connection.interface-name -> set of connections with that name */
+	GHashTable *connections_by_iface;
+	/* connection -> the interface-name it is indexed by */
+	GHashTable *connections_iface_keys;
+	/* connections without interface-name */
+	GHashTable *connections_unbound;
+	/* connection.master -> set of slave connections with that master */
+	GHashTable *connections_by_master;
+	/* slave connection -> the master it is indexed by */
+	GHashTable *connections_master_keys;
+	/* connections in the order autoconnect will try them */
+	GSequence *autoconnect_order;
+	/* connection -> its GSequenceIter in autoconnect_order */
+	GHashTable *autoconnect_order_iters;
+	/* hidden Wi-Fi connections, most recently used first */
+	GSequence *hidden_wifi;
+	/* connection -> its GSequenceIter in hidden_wifi */
+	GHashTable *hidden_wifi_iters;
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
 
@@ -175,6 +201,7 @@ enum {
 	AGENT_REGISTERED,
 
 	NEW_CONNECTION, /* exported, not used internally */
+	CONNECTIONS_ADDED, /* exported, not used internally */
 	LAST_SIGNAL
 };
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -241,6 +268,7 @@ load_connections (NMSettings *self)
 		NMSettingsPlugin *plugin = NM_SETTINGS_PLUGIN (iter->data);
 		GSList *plugin_connections;
 		GSList *elt;
+		gint64 ts = nm_startup_profile_begin ();
 
 		plugin_connections = nm_settings_plugin_get_connections (plugin);
 
@@ -253,6 +281,13 @@ load_connections (NMSettings *self)
 
 		g_slist_free (plugin_connections);
 
+		if (ts) {
+			gs_free char *pname = NULL;
+
+			g_object_get (plugin, NM_SETTINGS_PLUGIN_NAME, &pname, NULL);
+			nm_startup_profile_end (ts, "connections-load", pname);
+		}
+
 		g_signal_connect (plugin, NM_SETTINGS_PLUGIN_CONNECTION_ADDED,
 		                  G_CALLBACK (plugin_connection_added), self);
 		g_signal_connect (plugin, NM_SETTINGS_PLUGIN_UNMANAGED_SPECS_CHANGED,
@@ -307,25 +342,181 @@ impl_settings_list_connections (NMSettings *self,
 	g_ptr_array_unref (connections);
 }
 
+static int
+_cmp_connection_path (gconstpointer a, gconstpointer b)
+{
+	const char *path_a = nm_connection_get_path (*((NMConnection **) a));
+	const char *path_b = nm_connection_get_path (*((NMConnection **) b));
+	gsize len_a = strlen (path_a);
+	gsize len_b = strlen (path_b);
+
+	/* the paths only differ in the trailing number, order by it */
+	if (len_a != len_b)
+		return len_a < len_b ? -1 : 1;
+	return strcmp (path_a, path_b);
+}
+
+/**
+ * _nm_settings_get_all_settings_filter:
+ * @connections: (element-type NMConnection): the candidates
+ * @filter_type: (allow-none): the connection type to return
+ * @subject: the caller
+ * @offset: the number of matches to skip
+ * @limit: the maximum number of matches to return, or 0
+ *
+ * Drops the connections that are not of @filter_type or that @subject may
+ * not see, like GetSettings() would refuse them. The rest is sorted by
+ * D-Bus path and cut down to the requested page.
+ *
+ * Returns: the number of matches before paging.
+ */
+guint
+_nm_settings_get_all_settings_filter (GPtrArray *connections,
+                                      const char *filter_type,
+                                      NMAuthSubject *subject,
+                                      guint32 offset,
+                                      guint32 limit)
+{
+	NMConnection *connection;
+	guint i, n_matches;
+
+	for (i = 0; i < connections->len; ) {
+		connection = connections->pdata[i];
+		if (   (   filter_type
+		        && g_strcmp0 (nm_connection_get_connection_type (connection), filter_type) != 0)
+		    || !nm_auth_is_subject_in_acl (connection, subject, NULL))
+			g_ptr_array_remove_index_fast (connections, i);
+		else
+			i++;
+	}
+	n_matches = connections->len;
+
+	/* a stable order, for paging */
+	g_ptr_array_sort (connections, _cmp_connection_path);
+
+	if (offset >= connections->len)
+		g_ptr_array_set_size (connections, 0);
+	else {
+		if (limit && limit < connections->len - offset)
+			g_ptr_array_set_size (connections, offset + limit);
+		g_ptr_array_remove_range (connections, 0, offset);
+	}
+	return n_matches;
+}
+
+static void
+impl_settings_get_all_settings (NMSettings *self,
+                                GDBusMethodInvocation *context,
+                                GVariant *filter,
+                                guint32 flags)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_unref_object NMAuthSubject *subject = NULL;
+	gs_unref_ptrarray GPtrArray *matches = NULL;
+	const char *filter_type = NULL, *filter_iface = NULL;
+	guint32 offset = 0, limit = 0;
+	GVariantBuilder builder;
+	GVariantIter iter;
+	GHashTableIter h_iter;
+	GHashTable *candidates;
+	const char *key;
+	GVariant *value;
+	NMSettingsConnection *connection;
+	guint i, n_matches;
+
+	if (flags) {
+		g_dbus_method_invocation_return_error (context,
+		                                       NM_SETTINGS_ERROR,
+		                                       NM_SETTINGS_ERROR_NOT_SUPPORTED,
+		                                       "Unsupported flags 0x%x", (guint) flags);
+		return;
+	}
+
+	g_variant_iter_init (&iter, filter);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		const GVariantType *expected = NULL;
+
+		if (NM_IN_STRSET (key, "type", "interface-name"))
+			expected = G_VARIANT_TYPE_STRING;
+		else if (NM_IN_STRSET (key, "offset", "limit"))
+			expected = G_VARIANT_TYPE_UINT32;
+
+		if (!expected || !g_variant_is_of_type (value, expected)) {
+			g_dbus_method_invocation_return_error (context,
+			                                       NM_SETTINGS_ERROR,
+			                                       NM_SETTINGS_ERROR_FAILED,
+			                                       "Invalid filter '%s'", key);
+			g_variant_unref (value);
+			return;
+		}
+		g_variant_unref (value);
+	}
+	g_variant_lookup (filter, "type", "&s", &filter_type);
+	g_variant_lookup (filter, "interface-name", "&s", &filter_iface);
+	g_variant_lookup (filter, "offset", "u", &offset);
+	g_variant_lookup (filter, "limit", "u", &limit);
+
+	subject = nm_auth_subject_new_unix_process_from_context (context);
+	if (!subject) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               "Unable to determine UID of request.");
+		return;
+	}
+
+	/* an interface name filter only needs the connections bound to it */
+	if (filter_iface)
+		candidates = g_hash_table_lookup (priv->connections_by_iface, filter_iface);
+	else
+		candidates = priv->connections_unbound;
+
+	matches = g_ptr_array_new ();
+	if (candidates) {
+		g_hash_table_iter_init (&h_iter, candidates);
+		while (g_hash_table_iter_next (&h_iter, (gpointer *) &connection, NULL))
+			g_ptr_array_add (matches, connection);
+	}
+	if (!filter_iface) {
+		GHashTable *set;
+
+		g_hash_table_iter_init (&h_iter, priv->connections_by_iface);
+		while (g_hash_table_iter_next (&h_iter, NULL, (gpointer *) &set)) {
+			GHashTableIter s_iter;
+
+			g_hash_table_iter_init (&s_iter, set);
+			while (g_hash_table_iter_next (&s_iter, (gpointer *) &connection, NULL))
+				g_ptr_array_add (matches, connection);
+		}
+	}
+
+	n_matches = _nm_settings_get_all_settings_filter (matches, filter_type, subject, offset, limit);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(oa{sa{sv}})"));
+	for (i = 0; i < matches->len; i++) {
+		connection = matches->pdata[i];
+		g_variant_builder_add (&builder, "(o@a{sa{sv}})",
+		                       nm_connection_get_path (NM_CONNECTION (connection)),
+		                       nm_settings_connection_get_settings_variant (connection));
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(a(oa{sa{sv}})u)",
+	                                                      &builder,
+	                                                      n_matches));
+}
+
 NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
 	NMSettingsPrivate *priv;
-	NMSettingsConnection *candidate;
-	GHashTableIter iter;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 	g_return_val_if_fail (uuid != NULL, NULL);
 
 	priv = NM_SETTINGS_GET_PRIVATE (self);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &candidate)) {
-		if (g_strcmp0 (uuid, nm_settings_connection_get_uuid (candidate)) == 0)
-			return candidate;
-	}
-
-	return NULL;
+	return g_hash_table_lookup (priv->connections_by_uuid, nm_intern_str_lookup (uuid));
 }
 
 static void
@@ -405,6 +596,341 @@ connection_sort (gconstpointer pa, gconstpointer pb)
 	return 1;
 }
 
+static int
+_autoconnect_order_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	NMConnection *a = (NMConnection *) pa;
+	NMConnection *b = (NMConnection *) pb;
+	int c;
+
+	c = nm_utils_cmp_connection_by_autoconnect_priority (&a, &b);
+	if (c)
+		return c;
+	c = connection_sort (pa, pb);
+	if (c)
+		return c;
+
+	/* the sequence needs a total order */
+	if (pa < pb)
+		return -1;
+	return pa > pb;
+}
+
+static void
+_autoconnect_order_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup (priv->autoconnect_order_iters, connection);
+	if (iter)
+		g_sequence_sort_changed (iter, _autoconnect_order_cmp, NULL);
+	else {
+		iter = g_sequence_insert_sorted (priv->autoconnect_order, connection,
+		                                 _autoconnect_order_cmp, NULL);
+		g_hash_table_insert (priv->autoconnect_order_iters, connection, iter);
+	}
+}
+
+static void
+_autoconnect_order_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup (priv->autoconnect_order_iters, connection);
+	if (iter) {
+		g_sequence_remove (iter);
+		g_hash_table_remove (priv->autoconnect_order_iters, connection);
+	}
+}
+
+static int
+_hidden_wifi_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	guint64 ts_a = 0, ts_b = 0;
+
+	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pa), &ts_a);
+	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pb), &ts_b);
+	if (ts_a != ts_b)
+		return ts_a > ts_b ? -1 : 1;
+
+	/* the sequence needs a total order */
+	if (pa < pb)
+		return -1;
+	return pa > pb;
+}
+
+static void
+_hidden_wifi_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup (priv->hidden_wifi_iters, connection);
+	if (iter) {
+		g_sequence_remove (iter);
+		g_hash_table_remove (priv->hidden_wifi_iters, connection);
+	}
+}
+
+static void
+_hidden_wifi_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMSettingWireless *s_wifi;
+	GSequenceIter *iter;
+
+	s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (connection));
+	if (!s_wifi || !nm_setting_wireless_get_hidden (s_wifi)) {
+		_hidden_wifi_remove (self, connection);
+		return;
+	}
+
+	iter = g_hash_table_lookup (priv->hidden_wifi_iters, connection);
+	if (iter)
+		g_sequence_sort_changed (iter, _hidden_wifi_cmp, NULL);
+	else {
+		iter = g_sequence_insert_sorted (priv->hidden_wifi, connection,
+		                                 _hidden_wifi_cmp, NULL);
+		g_hash_table_insert (priv->hidden_wifi_iters, connection, iter);
+	}
+}
+
+/**
+ * nm_settings_get_hidden_wifi_connections:
+ * @self: the #NMSettings
+ * @max_requested: if non-zero, the maximum number of connections to return
+ *
+ * Returns the Wi-Fi connections with the hidden property set, most
+ * recently used first. The list is maintained as connections are
+ * added, changed and removed, so no sorting is done here.
+ *
+ * Returns: a #GSList of #NMSettingsConnection. Caller is responsible for
+ *   freeing the returned #GSList, but not its contents.
+ */
+GSList *
+nm_settings_get_hidden_wifi_connections (NMSettings *self, guint max_requested)
+{
+	NMSettingsPrivate *priv;
+	GSequenceIter *iter;
+	GSList *list = NULL;
+	guint n = 0;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	for (iter = g_sequence_get_begin_iter (priv->hidden_wifi);
+	     !g_sequence_iter_is_end (iter) && (!max_requested || n < max_requested);
+	     iter = g_sequence_iter_next (iter), n++)
+		list = g_slist_prepend (list, g_sequence_get (iter));
+
+	return g_slist_reverse (list);
+}
+
+/**
+ * nm_settings_find_autoconnect_connection:
+ * @self: the #NMSettings
+ * @func: (allow-none): filter for the candidates
+ * @func_data: user data for @func
+ *
+ * Walks the connections in the order autoconnect tries them: by
+ * autoconnect-priority, then by the time they were last used. The
+ * order is maintained as connections change, so no sorting is done
+ * here. Connections that have autoconnect disabled sort last and end
+ * the walk.
+ *
+ * Returns: (transfer none): the first connection accepted by @func,
+ *   or %NULL.
+ */
+NMSettingsConnection *
+nm_settings_find_autoconnect_connection (NMSettings *self,
+                                         NMConnectionFilterFunc func,
+                                         gpointer func_data)
+{
+	NMSettingsPrivate *priv;
+	GSequenceIter *iter;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	for (iter = g_sequence_get_begin_iter (priv->autoconnect_order);
+	     !g_sequence_iter_is_end (iter);
+	     iter = g_sequence_iter_next (iter)) {
+		NMConnection *connection = g_sequence_get (iter);
+
+		if (!nm_setting_connection_get_autoconnect (nm_connection_get_setting_connection (connection)))
+			break;
+		if (!func || func (self, connection, func_data))
+			return NM_SETTINGS_CONNECTION (connection);
+	}
+	return NULL;
+}
+
+static void
+_master_index_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const char *master;
+	GHashTable *set;
+
+	master = g_hash_table_lookup (priv->connections_master_keys, connection);
+	if (!master)
+		return;
+
+	set = g_hash_table_lookup (priv->connections_by_master, master);
+	if (set) {
+		g_hash_table_remove (set, connection);
+		if (!g_hash_table_size (set))
+			g_hash_table_remove (priv->connections_by_master, master);
+	}
+	g_hash_table_remove (priv->connections_master_keys, connection);
+}
+
+static void
+_master_index_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMSettingConnection *s_con;
+	const char *master;
+	GHashTable *set;
+
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
+	master = s_con ? nm_setting_connection_get_master (s_con) : NULL;
+	if (!g_strcmp0 (master, g_hash_table_lookup (priv->connections_master_keys, connection)))
+		return;
+
+	_master_index_remove (self, connection);
+	if (!master)
+		return;
+
+	set = g_hash_table_lookup (priv->connections_by_master, master);
+	if (!set) {
+		set = g_hash_table_new (g_direct_hash, g_direct_equal);
+		g_hash_table_insert (priv->connections_by_master, g_strdup (master), set);
+	}
+	g_hash_table_add (set, connection);
+	g_hash_table_insert (priv->connections_master_keys, connection, g_strdup (master));
+}
+
+static void
+_iface_index_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const char *iface;
+	GHashTable *set;
+
+	iface = g_hash_table_lookup (priv->connections_iface_keys, connection);
+	if (!iface) {
+		g_hash_table_remove (priv->connections_unbound, connection);
+		return;
+	}
+
+	set = g_hash_table_lookup (priv->connections_by_iface, iface);
+	if (set) {
+		g_hash_table_remove (set, connection);
+		if (!g_hash_table_size (set))
+			g_hash_table_remove (priv->connections_by_iface, iface);
+	}
+	g_hash_table_remove (priv->connections_iface_keys, connection);
+}
+
+static void
+_iface_index_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const char *iface;
+	GHashTable *set;
+
+	iface = nm_connection_get_interface_name (NM_CONNECTION (connection));
+	if (!g_strcmp0 (iface, g_hash_table_lookup (priv->connections_iface_keys, connection))) {
+		if (iface || g_hash_table_contains (priv->connections_unbound, connection))
+			return;
+	}
+
+	_iface_index_remove (self, connection);
+
+	if (!iface) {
+		g_hash_table_add (priv->connections_unbound, connection);
+		return;
+	}
+
+	set = g_hash_table_lookup (priv->connections_by_iface, iface);
+	if (!set) {
+		set = g_hash_table_new (g_direct_hash, g_direct_equal);
+		g_hash_table_insert (priv->connections_by_iface, g_strdup (iface), set);
+	}
+	g_hash_table_add (set, connection);
+	g_hash_table_insert (priv->connections_iface_keys, connection, g_strdup (iface));
+}
+
+static void
+_connection_index_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	_iface_index_remove (self, connection);
+	_master_index_remove (self, connection);
+}
+
+static void
+_connection_index_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	_iface_index_update (self, connection);
+	_master_index_update (self, connection);
+}
+
+/**
+ * nm_settings_get_connections_for_iface:
+ * @self: the #NMSettings
+ * @iface: the interface name of a device
+ * @out_len: (out): (allow-none): returns the number of returned
+ *   connections.
+ *
+ * A connection that sets an interface-name can only be compatible with
+ * the device of that name. This returns the candidates for a device named
+ * @iface: the connections bound to @iface, and those that are not bound
+ * to any interface. Whether they are actually compatible is up to the device.
+ *
+ * Returns: (transfer container): a %NULL terminated list of
+ *   #NMSettingsConnection. Free it with g_free().
+ */
+NMSettingsConnection **
+nm_settings_get_connections_for_iface (NMSettings *self, const char *iface, guint *out_len)
+{
+	NMSettingsPrivate *priv;
+	GHashTable *set;
+	GHashTableIter iter;
+	NMSettingsConnection **v;
+	NMSettingsConnection *con;
+	guint l, i;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	set = iface ? g_hash_table_lookup (priv->connections_by_iface, iface) : NULL;
+
+	l = g_hash_table_size (priv->connections_unbound) + (set ? g_hash_table_size (set) : 0);
+	v = g_new (NMSettingsConnection *, l + 1);
+
+	i = 0;
+	g_hash_table_iter_init (&iter, priv->connections_unbound);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &con, NULL))
+		v[i++] = con;
+	if (set) {
+		g_hash_table_iter_init (&iter, set);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &con, NULL))
+			v[i++] = con;
+	}
+	v[i] = NULL;
+
+	nm_assert (i == l);
+
+	NM_SET_OUT (out_len, l);
+	return v;
+}
+
 /**
  * nm_settings_get_connections:
  * @self: the #NMSettings
@@ -452,6 +978,51 @@ nm_settings_get_connections (NMSettings *self, guint *out_len)
 	return v;
 }
 
+/**
+ * nm_settings_get_connections_for_master:
+ * @self: the #NMSettings
+ * @masters: a %NULL terminated list of values of the
+ *   #NMSettingConnection:master property
+ *
+ * A slave connection refers to its master by the UUID of the master
+ * connection or by the interface name of the master device. Given all
+ * names a master is known by, this returns the candidates for its slaves.
+ * Whether the master of a candidate really resolves to the master is up
+ * to the caller.
+ *
+ * Returns: (transfer container): the connections whose master is one of
+ *   @masters, in the order of nm_settings_get_connections_sorted().
+ */
+GSList *
+nm_settings_get_connections_for_master (NMSettings *self, const char *const*masters)
+{
+	NMSettingsPrivate *priv;
+	GHashTableIter iter;
+	NMSettingsConnection *con;
+	GSList *list = NULL;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	for (i = 0; masters && masters[i]; i++) {
+		GHashTable *set;
+
+		if (_nm_utils_strv_find_first ((char **) masters, i, masters[i]) >= 0)
+			continue;
+
+		set = g_hash_table_lookup (priv->connections_by_master, masters[i]);
+		if (!set)
+			continue;
+
+		g_hash_table_iter_init (&iter, set);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &con, NULL))
+			list = g_slist_insert_sorted (list, con, connection_sort);
+	}
+	return list;
+}
+
 /* Returns a list of NMSettingsConnections.
  * The list is sorted in the order suitable for auto-connecting, i.e.
  * first go connections with autoconnect=yes and most recent timestamp.
@@ -489,15 +1060,13 @@ gboolean
 nm_settings_has_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
-	GHashTableIter iter;
-	gpointer data;
+	const char *path;
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data))
-		if (data == connection)
-			return TRUE;
+	path = nm_connection_get_path (NM_CONNECTION (connection));
+	if (!path)
+		return FALSE;
 
-	return FALSE;
+	return g_hash_table_lookup (priv->connections, path) == connection;
 }
 
 const GSList *
@@ -932,6 +1501,10 @@ next:
 static void
 connection_updated (NMSettingsConnection *connection, gboolean by_user, gpointer user_data)
 {
+	_connection_index_update (NM_SETTINGS (user_data), connection);
+	_autoconnect_order_update (NM_SETTINGS (user_data), connection);
+	_hidden_wifi_update (NM_SETTINGS (user_data), connection);
+
 	g_signal_emit (NM_SETTINGS (user_data),
 	               signals[CONNECTION_UPDATED],
 	               0,
@@ -951,12 +1524,25 @@ connection_visibility_changed (NMSettingsConnection *connection,
 	               connection);
 }
 
+static void
+connection_timestamp_changed (NMSettingsConnection *connection,
+                              GParamSpec *pspec,
+                              gpointer user_data)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (user_data);
+
+	_autoconnect_order_update (NM_SETTINGS (user_data), connection);
+	if (g_hash_table_contains (priv->hidden_wifi_iters, connection))
+		_hidden_wifi_update (NM_SETTINGS (user_data), connection);
+}
+
 static void
 connection_removed (NMSettingsConnection *connection, gpointer user_data)
 {
 	NMSettings *self = NM_SETTINGS (user_data);
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	const char *cpath = nm_connection_get_path (NM_CONNECTION (connection));
+	const char *uuid;
 
 	if (!g_hash_table_lookup (priv->connections, cpath))
 		g_return_if_reached ();
@@ -970,11 +1556,18 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_removed), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_updated), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_visibility_changed), self);
+	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_timestamp_changed), self);
 	if (!priv->startup_complete)
 		g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_ready_changed), self);
 	g_object_unref (self);
 
 	/* Forget about the connection internally */
+	_connection_index_remove (self, connection);
+	_autoconnect_order_remove (self, connection);
+	_hidden_wifi_remove (self, connection);
+	uuid = nm_intern_str_lookup (nm_settings_connection_get_uuid (connection));
+	if (uuid && g_hash_table_lookup (priv->connections_by_uuid, uuid) == connection)
+		g_hash_table_remove (priv->connections_by_uuid, uuid);
 	g_hash_table_remove (priv->connections, (gpointer) cpath);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
 
@@ -1003,6 +1596,22 @@ secret_agent_registered (NMAgentManager *agent_mgr,
 	               agent);
 }
 
+static void
+secret_agent_unregistered (NMAgentManager *agent_mgr,
+                           NMSecretAgent *agent,
+                           gpointer user_data)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (user_data);
+	const char *owner = nm_secret_agent_get_dbus_owner (agent);
+	GHashTableIter iter;
+	NMSettingsConnection *conn;
+
+	/* the secrets it returned are only replayed while it is around */
+	g_hash_table_iter_init (&iter, priv->connections);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &conn))
+		nm_settings_connection_clear_secrets_cache_for_agent (conn, owner);
+}
+
 #define NM_DBUS_SERVICE_OPENCONNECT    "org.freedesktop.NetworkManager.openconnect"
 #define NM_OPENCONNECT_KEY_GATEWAY "gateway"
 #define NM_OPENCONNECT_KEY_COOKIE "cookie"
@@ -1048,20 +1657,15 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GError *error = NULL;
-	GHashTableIter iter;
-	gpointer data;
 	const char *path;
 	NMSettingsConnection *existing;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 	g_return_if_fail (nm_connection_get_path (NM_CONNECTION (connection)) == NULL);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		/* prevent duplicates */
-		if (data == connection)
-			return;
-	}
+	/* prevent duplicates */
+	if (g_hash_table_contains (priv->autoconnect_order_iters, connection))
+		return;
 
 	if (!nm_connection_normalize (NM_CONNECTION (connection), NULL, NULL, &error)) {
 		_LOGW ("plugin provided invalid connection: %s", error->message);
@@ -1106,6 +1710,9 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	g_signal_connect (connection, "notify::" NM_SETTINGS_CONNECTION_VISIBLE,
 	                  G_CALLBACK (connection_visibility_changed),
 	                  self);
+	g_signal_connect (connection, "notify::" NM_SETTINGS_CONNECTION_TIMESTAMP,
+	                  G_CALLBACK (connection_timestamp_changed),
+	                  self);
 	if (!priv->startup_complete) {
 		g_signal_connect (connection, "notify::" NM_SETTINGS_CONNECTION_READY,
 		                  G_CALLBACK (connection_ready_changed),
@@ -1120,7 +1727,13 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	g_hash_table_insert (priv->connections,
 	                     (gpointer) nm_connection_get_path (NM_CONNECTION (connection)),
 	                     g_object_ref (connection));
+	g_hash_table_insert (priv->connections_by_uuid,
+	                     (gpointer) nm_intern_str_ref (nm_settings_connection_get_uuid (connection)),
+	                     connection);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
+	_connection_index_update (self, connection);
+	_autoconnect_order_update (self, connection);
+	_hidden_wifi_update (self, connection);
 
 	nm_utils_log_connection_diff (NM_CONNECTION (connection), NULL, LOGL_DEBUG, LOGD_CORE, "new connection", "++ ");
 
@@ -1336,6 +1949,71 @@ is_adhoc_wpa (NMConnection *connection)
 	return TRUE;
 }
 
+static gboolean
+check_added_connection (NMConnection *connection, GError **error)
+{
+	GError *tmp_error = NULL;
+
+	/* Connection must be valid, of course */
+	if (!nm_connection_verify (connection, &tmp_error)) {
+		g_set_error (error,
+		             NM_SETTINGS_ERROR,
+		             NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		             "The connection was invalid: %s",
+		             tmp_error->message);
+		g_error_free (tmp_error);
+		return FALSE;
+	}
+
+	/* The kernel doesn't support Ad-Hoc WPA connections well at this time,
+	 * and turns them into open networks.  It's been this way since at least
+	 * 2.6.30 or so; until that's fixed, disable WPA-protected Ad-Hoc networks.
+	 */
+	if (is_adhoc_wpa (connection)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		                     "WPA Ad-Hoc disabled due to kernel bugs");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static const char *
+get_add_permission (NMConnection *connection,
+                    NMAuthSubject *subject,
+                    GError **error)
+{
+	NMSettingConnection *s_con;
+	char *error_desc = NULL;
+
+	/* Ensure the caller's username exists in the connection's permissions,
+	 * or that the permissions is empty (ie, visible by everyone).
+	 */
+	if (!nm_auth_is_subject_in_acl (connection,
+	                                subject,
+	                                &error_desc)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                     error_desc);
+		g_free (error_desc);
+		return NULL;
+	}
+
+	/* If the caller is the only user in the connection's permissions, then
+	 * we use the 'modify.own' permission instead of 'modify.system'.  If the
+	 * request affects more than just the caller, require 'modify.system'.
+	 */
+	s_con = nm_connection_get_setting_connection (connection);
+	g_assert (s_con);
+	if (nm_setting_connection_get_num_permissions (s_con) == 1)
+		return NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
+	else
+		return NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
+}
+
 void
 nm_settings_add_connection_dbus (NMSettings *self,
                                  NMConnection *connection,
@@ -1345,36 +2023,16 @@ nm_settings_add_connection_dbus (NMSettings *self,
                                  gpointer user_data)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
-	NMSettingConnection *s_con;
 	NMAuthSubject *subject = NULL;
 	NMAuthChain *chain;
-	GError *error = NULL, *tmp_error = NULL;
-	char *error_desc = NULL;
+	GError *error = NULL;
 	const char *perm;
 
 	g_return_if_fail (connection != NULL);
 	g_return_if_fail (context != NULL);
 
-	/* Connection must be valid, of course */
-	if (!nm_connection_verify (connection, &tmp_error)) {
-		error = g_error_new (NM_SETTINGS_ERROR,
-		                     NM_SETTINGS_ERROR_INVALID_CONNECTION,
-		                     "The connection was invalid: %s",
-		                     tmp_error->message);
-		g_error_free (tmp_error);
-		goto done;
-	}
-
-	/* The kernel doesn't support Ad-Hoc WPA connections well at this time,
-	 * and turns them into open networks.  It's been this way since at least
-	 * 2.6.30 or so; until that's fixed, disable WPA-protected Ad-Hoc networks.
-	 */
-	if (is_adhoc_wpa (connection)) {
-		error = g_error_new_literal (NM_SETTINGS_ERROR,
-		                             NM_SETTINGS_ERROR_INVALID_CONNECTION,
-		                             "WPA Ad-Hoc disabled due to kernel bugs");
+	if (!check_added_connection (connection, &error))
 		goto done;
-	}
 
 	/* Do any of the plugins support adding? */
 	if (!get_plugin (self, NM_SETTINGS_PLUGIN_CAP_MODIFY_CONNECTIONS)) {
@@ -1392,29 +2050,9 @@ nm_settings_add_connection_dbus (NMSettings *self,
 		goto done;
 	}
 
-	/* Ensure the caller's username exists in the connection's permissions,
-	 * or that the permissions is empty (ie, visible by everyone).
-	 */
-	if (!nm_auth_is_subject_in_acl (connection,
-	                                subject,
-	                                &error_desc)) {
-		error = g_error_new_literal (NM_SETTINGS_ERROR,
-		                             NM_SETTINGS_ERROR_PERMISSION_DENIED,
-		                             error_desc);
-		g_free (error_desc);
+	perm = get_add_permission (connection, subject, &error);
+	if (!perm)
 		goto done;
-	}
-
-	/* If the caller is the only user in the connection's permissions, then
-	 * we use the 'modify.own' permission instead of 'modify.system'.  If the
-	 * request affects more than just the caller, require 'modify.system'.
-	 */
-	s_con = nm_connection_get_setting_connection (connection);
-	g_assert (s_con);
-	if (nm_setting_connection_get_num_permissions (s_con) == 1)
-		perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
-	else
-		perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
 
 	/* Validate the user request */
 	chain = nm_auth_chain_new_subject (subject, context, pk_add_cb, self);
@@ -1511,6 +2149,244 @@ impl_settings_add_connection_unsaved (NMSettings *self,
 	impl_settings_add_connection_helper (self, context, settings, FALSE);
 }
 
+typedef struct {
+	NMConnection *connection;
+	/* the permission needed to add @connection, or %NULL
+	 * if @error is set. */
+	const char *perm;
+	char *error;
+} AddManyEntry;
+
+typedef struct {
+	GArray *entries;
+	gboolean save_to_disk;
+} AddManyData;
+
+static void
+add_many_data_free (gpointer user_data)
+{
+	AddManyData *data = user_data;
+	guint i;
+
+	for (i = 0; i < data->entries->len; i++) {
+		AddManyEntry *entry = &g_array_index (data->entries, AddManyEntry, i);
+
+		g_clear_object (&entry->connection);
+		g_free (entry->error);
+	}
+	g_array_unref (data->entries);
+	g_slice_free (AddManyData, data);
+}
+
+/* @chain may only be %NULL if all entries already failed */
+static void
+add_many_finish (NMSettings *self,
+                 GDBusMethodInvocation *context,
+                 NMAuthSubject *subject,
+                 AddManyData *data,
+                 NMAuthChain *chain)
+{
+	GVariantBuilder builder;
+	gs_unref_ptrarray GPtrArray *added_paths = NULL;
+	guint i;
+
+	added_paths = g_ptr_array_new ();
+
+	/* The connections are written one after the other; the writer syncs
+	 * the files of the whole batch together afterwards. */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(os)"));
+	for (i = 0; i < data->entries->len; i++) {
+		AddManyEntry *entry = &g_array_index (data->entries, AddManyEntry, i);
+		NMSettingsConnection *added = NULL;
+		GError *error = NULL;
+
+		if (entry->error)
+			goto next;
+
+		g_assert (chain);
+		if (nm_auth_chain_get_result (chain, entry->perm) != NM_AUTH_CALL_RESULT_YES) {
+			entry->error = g_strdup ("Insufficient privileges.");
+			goto next;
+		}
+
+		added = nm_settings_add_connection (self, entry->connection, data->save_to_disk, &error);
+		if (!added) {
+			entry->error = g_strdup (error->message);
+			g_error_free (error);
+		}
+
+next:
+		if (entry->error) {
+			g_variant_builder_add (&builder, "(os)", "/", entry->error);
+			nm_audit_log_connection_op (NM_AUDIT_OP_CONN_ADD, NULL, FALSE, NULL,
+			                            subject, entry->error);
+		} else {
+			g_variant_builder_add (&builder, "(os)",
+			                       nm_connection_get_path (NM_CONNECTION (added)), "");
+			g_ptr_array_add (added_paths, (gpointer) nm_connection_get_path (NM_CONNECTION (added)));
+			nm_audit_log_connection_op (NM_AUDIT_OP_CONN_ADD, added, TRUE, NULL,
+			                            subject, NULL);
+
+			/* Send agent-owned secrets to the agents */
+			if (nm_settings_has_connection (self, added))
+				send_agent_owned_secrets (self, added, subject);
+		}
+	}
+
+	g_dbus_method_invocation_return_value (context, g_variant_new ("(a(os))", &builder));
+
+	/* one signal for the whole batch, in addition to the NewConnection
+	 * signals emitted for each connection */
+	if (added_paths->len) {
+		g_ptr_array_add (added_paths, NULL);
+		g_signal_emit (self, signals[CONNECTIONS_ADDED], 0, (char **) added_paths->pdata);
+	}
+}
+
+static void
+pk_add_many_cb (NMAuthChain *chain,
+                GError *chain_error,
+                GDBusMethodInvocation *context,
+                gpointer user_data)
+{
+	NMSettings *self = NM_SETTINGS (user_data);
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	AddManyData *data;
+	NMAuthSubject *subject;
+	guint i;
+
+	g_assert (context);
+
+	priv->auths = g_slist_remove (priv->auths, chain);
+
+	data = nm_auth_chain_get_data (chain, "data");
+	subject = nm_auth_chain_get_data (chain, "subject");
+
+	if (chain_error) {
+		g_dbus_method_invocation_return_error (context,
+		                                       NM_SETTINGS_ERROR,
+		                                       NM_SETTINGS_ERROR_FAILED,
+		                                       "Error checking authorization: %s",
+		                                       chain_error->message);
+		for (i = 0; i < data->entries->len; i++) {
+			nm_audit_log_connection_op (NM_AUDIT_OP_CONN_ADD, NULL, FALSE, NULL,
+			                            subject, chain_error->message);
+		}
+	} else
+		add_many_finish (self, context, subject, data, chain);
+
+	nm_auth_chain_unref (chain);
+}
+
+static void
+impl_settings_add_connections (NMSettings *self,
+                               GDBusMethodInvocation *context,
+                               GVariant *settings,
+                               guint32 flags)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_unref_object NMAuthSubject *subject = NULL;
+	AddManyData *data;
+	NMAuthChain *chain;
+	GVariantIter iter;
+	GVariant *value;
+	gboolean need_own = FALSE, need_system = FALSE;
+	guint i;
+
+	if (flags & ~NM_SETTINGS_ADD_CONNECTIONS_FLAG_UNSAVED) {
+		g_dbus_method_invocation_return_error (context,
+		                                       NM_SETTINGS_ERROR,
+		                                       NM_SETTINGS_ERROR_NOT_SUPPORTED,
+		                                       "Unsupported flags 0x%x", (guint) flags);
+		return;
+	}
+
+	/* Do any of the plugins support adding? */
+	if (!get_plugin (self, NM_SETTINGS_PLUGIN_CAP_MODIFY_CONNECTIONS)) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_NOT_SUPPORTED,
+		                                               "None of the registered plugins support add.");
+		return;
+	}
+
+	subject = nm_auth_subject_new_unix_process_from_context (context);
+	if (!subject) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               "Unable to determine UID of request.");
+		return;
+	}
+
+	data = g_slice_new0 (AddManyData);
+	data->save_to_disk = !NM_FLAGS_HAS (flags, NM_SETTINGS_ADD_CONNECTIONS_FLAG_UNSAVED);
+	data->entries = g_array_sized_new (FALSE, TRUE, sizeof (AddManyEntry),
+	                                   g_variant_n_children (settings));
+
+	/* Validate everything up front, so that a single authorization
+	 * covers all connections that need the same permission. */
+	g_variant_iter_init (&iter, settings);
+	while ((value = g_variant_iter_next_value (&iter))) {
+		AddManyEntry entry = { NULL };
+		GError *error = NULL;
+
+		entry.connection = _nm_simple_connection_new_from_dbus (value,
+		                                                          NM_SETTING_PARSE_FLAGS_STRICT
+		                                                        | NM_SETTING_PARSE_FLAGS_NORMALIZE,
+		                                                        &error);
+		if (   entry.connection
+		    && nm_connection_verify_secrets (entry.connection, &error)
+		    && check_added_connection (entry.connection, &error))
+			entry.perm = get_add_permission (entry.connection, subject, &error);
+
+		if (entry.perm) {
+			if (nm_streq (entry.perm, NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN))
+				need_own = TRUE;
+			else
+				need_system = TRUE;
+		} else {
+			g_assert (error);
+			entry.error = g_strdup (error->message);
+			g_error_free (error);
+		}
+
+		g_array_append_val (data->entries, entry);
+		g_variant_unref (value);
+	}
+
+	/* nothing to authorize */
+	if (!need_own && !need_system) {
+		add_many_finish (self, context, subject, data, NULL);
+		add_many_data_free (data);
+		return;
+	}
+
+	chain = nm_auth_chain_new_subject (subject, context, pk_add_many_cb, self);
+	if (!chain) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               "Unable to authenticate the request.");
+		for (i = 0; i < data->entries->len; i++) {
+			nm_audit_log_connection_op (NM_AUDIT_OP_CONN_ADD, NULL, FALSE, NULL,
+			                            subject, "Unable to authenticate the request.");
+		}
+		add_many_data_free (data);
+		return;
+	}
+
+	priv->auths = g_slist_append (priv->auths, chain);
+	nm_auth_chain_set_data (chain, "data", data, add_many_data_free);
+	nm_auth_chain_set_data (chain, "subject", g_object_ref (subject), g_object_unref);
+
+	/* one polkit check per distinct permission */
+	if (need_own)
+		nm_auth_chain_add_call (chain, NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN, TRUE);
+	if (need_system)
+		nm_auth_chain_add_call (chain, NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM, TRUE);
+}
+
 static gboolean
 ensure_root (NMBusManager          *dbus_mgr,
              GDBusMethodInvocation *context)
@@ -1653,35 +2529,28 @@ nm_settings_set_transient_hostname (NMSettings *self,
 	                   info);
 }
 
+typedef struct {
+	NMSettings *self;
+	GDBusMethodInvocation *context;
+	char *hostname;
+	char *file;
+} WriteHostnameInfo;
+
+/* Runs on the executor thread; it must not log. */
 static gboolean
-write_hostname (NMSettingsPrivate *priv, const char *hostname)
+write_hostname_file (gpointer user_data, GError **error)
 {
-	char *hostname_eol;
-	gboolean ret;
-	gs_free_error GError *error = NULL;
-	const char *file = HOSTNAME_FILE;
+	WriteHostnameInfo *info = user_data;
+	gs_free char *hostname_eol = NULL;
 	gs_free char *link_path = NULL;
-	gs_unref_variant GVariant *var = NULL;
+	const char *file = HOSTNAME_FILE;
+	gboolean ret;
 	struct stat file_stat;
 #if HAVE_SELINUX
 	security_context_t se_ctx_prev = NULL, se_ctx = NULL;
 	mode_t st_mode = 0;
 #endif
 
-	if (priv->hostname.hostnamed_proxy) {
-		var = g_dbus_proxy_call_sync (priv->hostname.hostnamed_proxy,
-		                              "SetStaticHostname",
-		                              g_variant_new ("(sb)", hostname, FALSE),
-		                              G_DBUS_CALL_FLAGS_NONE,
-		                              -1,
-		                              NULL,
-		                              &error);
-		if (error)
-			_LOGW ("could not set hostname: %s", error->message);
-
-		return !error;
-	}
-
 	/* If the hostname file is a symbolic link, follow it to find where the
 	 * real file is located, otherwise g_file_set_contents will attempt to
 	 * replace the link with a plain file.
@@ -1690,9 +2559,12 @@ write_hostname (NMSettingsPrivate *priv, const char *hostname)
 	    && S_ISLNK (file_stat.st_mode)
 	    && (link_path = nm_utils_read_link_absolute (file, NULL)))
 		file = link_path;
+	info->file = g_strdup (file);
 
 #if HAVE_SELINUX
-	/* Get default context for hostname file and set it for fscreate */
+	/* Get default context for hostname file and set it for fscreate.
+	 * The fscreate context is per thread, so this doesn't affect the
+	 * main thread. */
 	if (stat (file, &file_stat) == 0)
 		st_mode = file_stat.st_mode;
 	matchpathcon (file, st_mode, &se_ctx);
@@ -1703,15 +2575,15 @@ write_hostname (NMSettingsPrivate *priv, const char *hostname)
 
 #if defined (HOSTNAME_PERSIST_GENTOO)
 	hostname_eol = g_strdup_printf ("#Generated by NetworkManager\n"
-	                                "hostname=\"%s\"\n", hostname);
+	                                "hostname=\"%s\"\n", info->hostname);
 #else
-	hostname_eol = g_strdup_printf ("%s\n", hostname);
+	hostname_eol = g_strdup_printf ("%s\n", info->hostname);
 #endif
 
 	/* FIXME: g_file_set_contents() writes first to a temporary file
 	 * and renames it atomically. We should hack g_file_set_contents()
 	 * to set the SELINUX labels before renaming the file. */
-	ret = g_file_set_contents (file, hostname_eol, -1, &error);
+	ret = g_file_set_contents (file, hostname_eol, -1, error);
 
 #if HAVE_SELINUX
 	/* Restore previous context and cleanup */
@@ -1720,14 +2592,64 @@ write_hostname (NMSettingsPrivate *priv, const char *hostname)
 	freecon (se_ctx_prev);
 #endif
 
-	g_free (hostname_eol);
+	return ret;
+}
 
-	if (!ret) {
-		_LOGW ("could not save hostname to %s: %s", file, error->message);
-		return FALSE;
+static void
+write_hostname_done (GError *error, gpointer user_data)
+{
+	WriteHostnameInfo *info = user_data;
+	NMSettings *self = info->self;
+
+	if (error) {
+		_LOGW ("could not save hostname to %s: %s", info->file, error->message);
+		g_dbus_method_invocation_return_error_literal (info->context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_FAILED,
+		                                               "Saving the hostname failed.");
+	} else
+		g_dbus_method_invocation_return_value (info->context, NULL);
+
+	g_object_unref (info->self);
+	g_free (info->hostname);
+	g_free (info->file);
+	g_slice_free (WriteHostnameInfo, info);
+}
+
+/* Saves the hostname and returns the result of @context. */
+static void
+write_hostname (NMSettings *self, const char *hostname, GDBusMethodInvocation *context)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	WriteHostnameInfo *info;
+
+	if (priv->hostname.hostnamed_proxy) {
+		gs_unref_variant GVariant *var = NULL;
+		gs_free_error GError *error = NULL;
+
+		var = g_dbus_proxy_call_sync (priv->hostname.hostnamed_proxy,
+		                              "SetStaticHostname",
+		                              g_variant_new ("(sb)", hostname, FALSE),
+		                              G_DBUS_CALL_FLAGS_NONE,
+		                              -1,
+		                              NULL,
+		                              &error);
+		if (error) {
+			_LOGW ("could not set hostname: %s", error->message);
+			g_dbus_method_invocation_return_error_literal (context,
+			                                               NM_SETTINGS_ERROR,
+			                                               NM_SETTINGS_ERROR_FAILED,
+			                                               "Saving the hostname failed.");
+		} else
+			g_dbus_method_invocation_return_value (context, NULL);
+		return;
 	}
 
-	return TRUE;
+	info = g_slice_new0 (WriteHostnameInfo);
+	info->self = g_object_ref (self);
+	info->context = context;
+	info->hostname = g_strdup (hostname);
+	nm_executor_run (write_hostname_file, write_hostname_done, info);
 }
 
 static void
@@ -1740,7 +2662,6 @@ pk_hostname_cb (NMAuthChain *chain,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	NMAuthCallResult result;
 	GError *error = NULL;
-	const char *hostname;
 
 	g_assert (context);
 
@@ -1758,20 +2679,11 @@ pk_hostname_cb (NMAuthChain *chain,
 		error = g_error_new_literal (NM_SETTINGS_ERROR,
 		                             NM_SETTINGS_ERROR_PERMISSION_DENIED,
 		                             "Insufficient privileges.");
-	} else {
-		hostname = nm_auth_chain_get_data (chain, "hostname");
-
-		if (!write_hostname (priv, hostname)) {
-			error = g_error_new_literal (NM_SETTINGS_ERROR,
-			                             NM_SETTINGS_ERROR_FAILED,
-			                             "Saving the hostname failed.");
-		}
-	}
+	} else
+		write_hostname (self, nm_auth_chain_get_data (chain, "hostname"), context);
 
 	if (error)
 		g_dbus_method_invocation_take_error (context, error);
-	else
-		g_dbus_method_invocation_return_value (context, NULL);
 
 	nm_auth_chain_unref (chain);
 }
@@ -2299,14 +3211,17 @@ nm_settings_start (NMSettings *self, GError **error)
 	GDBusProxy *proxy;
 	GVariant *variant;
 	GError *local_error = NULL;
+	gint64 ts;
 
 	priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	/* Load the plugins; fail if a plugin is not found. */
+	ts = nm_startup_profile_begin ();
 	if (!load_plugins (self, nm_config_get_plugins (priv->config), error)) {
 		g_object_unref (self);
 		return FALSE;
 	}
+	nm_startup_profile_end (ts, "settings-plugins-load", NULL);
 
 	load_connections (self);
 	check_startup_complete (self);
@@ -2347,6 +3262,16 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->connections_by_uuid = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) nm_intern_str_unref, NULL);
+	priv->connections_by_iface = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_iface_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	priv->connections_unbound = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->connections_by_master = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_master_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	priv->autoconnect_order = g_sequence_new (NULL);
+	priv->autoconnect_order_iters = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->hidden_wifi = g_sequence_new (NULL);
+	priv->hidden_wifi_iters = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	/* Hold a reference to the agent manager so it stays alive; the only
 	 * other holders are NMSettingsConnection objects which are often
@@ -2356,6 +3281,7 @@ nm_settings_init (NMSettings *self)
 	priv->agent_mgr = g_object_ref (nm_agent_manager_get ());
 
 	g_signal_connect (priv->agent_mgr, "agent-registered", G_CALLBACK (secret_agent_registered), self);
+	g_signal_connect (priv->agent_mgr, "agent-unregistered", G_CALLBACK (secret_agent_unregistered), self);
 }
 
 static void
@@ -2367,6 +3293,7 @@ dispose (GObject *object)
 	g_slist_free_full (priv->auths, (GDestroyNotify) nm_auth_chain_unref);
 	priv->auths = NULL;
 
+	g_signal_handlers_disconnect_by_func (priv->agent_mgr, G_CALLBACK (secret_agent_unregistered), self);
 	g_object_unref (priv->agent_mgr);
 
 	if (priv->hostname.hostnamed_proxy) {
@@ -2405,7 +3332,17 @@ finalize (GObject *object)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	g_hash_table_destroy (priv->connections);
+	g_hash_table_destroy (priv->connections_by_uuid);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
+	g_hash_table_destroy (priv->connections_by_iface);
+	g_hash_table_destroy (priv->connections_iface_keys);
+	g_hash_table_destroy (priv->connections_unbound);
+	g_hash_table_destroy (priv->connections_by_master);
+	g_hash_table_destroy (priv->connections_master_keys);
+	g_hash_table_destroy (priv->autoconnect_order_iters);
+	g_sequence_free (priv->autoconnect_order);
+	g_hash_table_destroy (priv->hidden_wifi_iters);
+	g_sequence_free (priv->hidden_wifi);
 
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
@@ -2560,12 +3497,21 @@ nm_settings_class_init (NMSettingsClass *class)
 	                  g_cclosure_marshal_VOID__OBJECT,
 	                  G_TYPE_NONE, 1, NM_TYPE_SETTINGS_CONNECTION);
 
+	signals[CONNECTIONS_ADDED] =
+	    g_signal_new ("connections-added",
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_FIRST, 0, NULL, NULL,
+	                  g_cclosure_marshal_VOID__BOXED,
+	                  G_TYPE_NONE, 1, G_TYPE_STRV);
+
 	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (class),
 	                                        NMDBUS_TYPE_SETTINGS_SKELETON,
 	                                        "ListConnections", impl_settings_list_connections,
+	                                        "GetAllSettings", impl_settings_get_all_settings,
 	                                        "GetConnectionByUuid", impl_settings_get_connection_by_uuid,
 	                                        "AddConnection", impl_settings_add_connection,
 	                                        "AddConnectionUnsaved", impl_settings_add_connection_unsaved,
+	                                        "AddConnections", impl_settings_add_connections,
 	                                        "LoadConnections", impl_settings_load_connections,
 	                                        "ReloadConnections", impl_settings_reload_connections,
 	                                        "SaveHostname", impl_settings_save_hostname,
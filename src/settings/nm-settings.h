@@ -102,8 +102,12 @@ void nm_settings_add_connection_dbus (NMSettings *self,
                                       gpointer user_data);
 
 NMSettingsConnection *const* nm_settings_get_connections (NMSettings *settings, guint *out_len);
+NMSettingsConnection **nm_settings_get_connections_for_iface (NMSettings *settings, const char *iface, guint *out_len);
 
 GSList *nm_settings_get_connections_sorted (NMSettings *settings);
+GSList *nm_settings_get_connections_for_master (NMSettings *self, const char *const*masters);
+
+GSList *nm_settings_get_hidden_wifi_connections (NMSettings *self, guint max_requested);
 
 GSList *nm_settings_get_best_connections (NMSettings *self,
                                           guint max_requested,
@@ -112,6 +116,10 @@ GSList *nm_settings_get_best_connections (NMSettings *self,
                                           NMConnectionFilterFunc func,
                                           gpointer func_data);
 
+NMSettingsConnection *nm_settings_find_autoconnect_connection (NMSettings *self,
+                                                               NMConnectionFilterFunc func,
+                                                               gpointer func_data);
+
 NMSettingsConnection *nm_settings_add_connection (NMSettings *settings,
                                                   NMConnection *connection,
                                                   gboolean save_to_disk,
@@ -141,4 +149,11 @@ void nm_settings_set_transient_hostname (NMSettings *self,
                                          NMSettingsSetHostnameCb cb,
                                          gpointer user_data);
 
+/* exposed for the unit tests */
+guint _nm_settings_get_all_settings_filter (GPtrArray *connections,
+                                            const char *filter_type,
+                                            NMAuthSubject *subject,
+                                            guint32 offset,
+                                            guint32 limit);
+
 #endif  /* __NM_SETTINGS_H__ */
@@ -37,6 +37,7 @@
 #include "nm-setting-connection.h"
 
 #include "nm-settings-plugin.h"
+#include "nm-settings-reload-queue.h"
 #include "nm-config.h"
 #include "NetworkManagerUtils.h"
 
@@ -95,6 +96,7 @@ typedef struct {
 
 	GFileMonitor *ifcfg_monitor;
 	gulong ifcfg_monitor_id;
+	NMSettingsReloadQueue *reload_queue;
 } SettingsPluginIfcfgPrivate;
 
 static SettingsPluginIfcfg *settings_plugin_ifcfg_get (void);
@@ -395,6 +397,72 @@ update_connection (SettingsPluginIfcfg *self,
 	}
 }
 
+static void
+reload_paths_cb (const GPtrArray *paths, gpointer user_data)
+{
+	SettingsPluginIfcfg *plugin = SETTINGS_PLUGIN_IFCFG (user_data);
+	SettingsPluginIfcfgPrivate *priv = SETTINGS_PLUGIN_IFCFG_GET_PRIVATE (plugin);
+	gs_unref_hashtable GHashTable *by_path = NULL;
+	gs_unref_hashtable GHashTable *seen = NULL;
+	GHashTableIter iter;
+	NMIfcfgConnection *connection;
+	guint i;
+
+	/* Look the connections up once per batch instead of scanning all of them
+	 * for every path. Updates may remove or rename connections, so an entry
+	 * is only used while it still belongs to the plugin and the path. */
+	by_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	g_hash_table_iter_init (&iter, priv->connections);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
+		const char *path = nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection));
+
+		if (path)
+			g_hash_table_insert (by_path, g_strdup (path), g_object_ref (connection));
+	}
+
+	/* several changed files (ifcfg-, keys-, route-) can belong to one connection */
+	seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (i = 0; i < paths->len; i++) {
+		char *ifcfg_path;
+
+		ifcfg_path = utils_detect_ifcfg_path (paths->pdata[i], FALSE);
+		if (!ifcfg_path)
+			continue;
+		if (g_hash_table_contains (seen, ifcfg_path)) {
+			g_free (ifcfg_path);
+			continue;
+		}
+		g_hash_table_add (seen, ifcfg_path);
+
+		connection = g_hash_table_lookup (by_path, ifcfg_path);
+		if (   connection
+		    && (   g_hash_table_lookup (priv->connections, nm_connection_get_uuid (NM_CONNECTION (connection))) != connection
+		        || g_strcmp0 (nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection)), ifcfg_path) != 0))
+			connection = find_by_path (plugin, ifcfg_path);
+
+		if (g_file_test (ifcfg_path, G_FILE_TEST_EXISTS)) {
+			/* Update or new */
+			update_connection (plugin, NULL, ifcfg_path, connection, TRUE, NULL, NULL);
+		} else if (connection)
+			remove_connection (plugin, connection);
+	}
+}
+
+static gboolean
+reload_path_unsaved_cb (const char *path, gpointer user_data)
+{
+	gs_free char *ifcfg_path = NULL;
+	NMIfcfgConnection *connection;
+
+	ifcfg_path = utils_detect_ifcfg_path (path, FALSE);
+	if (!ifcfg_path)
+		return FALSE;
+	connection = find_by_path (SETTINGS_PLUGIN_IFCFG (user_data), ifcfg_path);
+	return    connection
+	       && nm_settings_connection_get_unsaved (NM_SETTINGS_CONNECTION (connection));
+}
+
 static void
 ifcfg_dir_changed (GFileMonitor *monitor,
                    GFile *file,
@@ -402,32 +470,22 @@ ifcfg_dir_changed (GFileMonitor *monitor,
                    GFileMonitorEvent event_type,
                    gpointer user_data)
 {
-	SettingsPluginIfcfg *plugin = SETTINGS_PLUGIN_IFCFG (user_data);
-	char *path, *ifcfg_path;
-	NMIfcfgConnection *connection;
+	SettingsPluginIfcfgPrivate *priv = SETTINGS_PLUGIN_IFCFG_GET_PRIVATE (user_data);
+	gs_free char *path = NULL;
 
 	path = g_file_get_path (file);
 
-	ifcfg_path = utils_detect_ifcfg_path (path, FALSE);
-	_LOGD ("ifcfg_dir_changed(%s) = %d // %s", path, event_type, ifcfg_path ? ifcfg_path : "(none)");
-	if (ifcfg_path) {
-		connection = find_by_path (plugin, ifcfg_path);
-		switch (event_type) {
-		case G_FILE_MONITOR_EVENT_DELETED:
-			if (connection)
-				remove_connection (plugin, connection);
-			break;
-		case G_FILE_MONITOR_EVENT_CREATED:
-		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
-			/* Update or new */
-			update_connection (plugin, NULL, ifcfg_path, connection, TRUE, NULL, NULL);
-			break;
-		default:
-			break;
-		}
-		g_free (ifcfg_path);
+	_LOGD ("ifcfg_dir_changed(%s) = %d", path, event_type);
+	switch (event_type) {
+	case G_FILE_MONITOR_EVENT_DELETED:
+	case G_FILE_MONITOR_EVENT_CREATED:
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		if (!utils_should_ignore_file (path, FALSE))
+			nm_settings_reload_queue_add (priv->reload_queue, path);
+		break;
+	default:
+		break;
 	}
-	g_free (path);
 }
 
 static void
@@ -442,6 +500,7 @@ setup_ifcfg_monitoring (SettingsPluginIfcfg *plugin)
 	g_object_unref (file);
 
 	if (monitor) {
+		priv->reload_queue = nm_settings_reload_queue_new (reload_paths_cb, reload_path_unsaved_cb, plugin);
 		priv->ifcfg_monitor_id = g_signal_connect (monitor, "changed",
 		                                           G_CALLBACK (ifcfg_dir_changed), plugin);
 		priv->ifcfg_monitor = monitor;
@@ -1008,6 +1067,7 @@ dispose (GObject *object)
 		g_file_monitor_cancel (priv->ifcfg_monitor);
 		g_object_unref (priv->ifcfg_monitor);
 	}
+	g_clear_pointer (&priv->reload_queue, nm_settings_reload_queue_free);
 
 	G_OBJECT_CLASS (settings_plugin_ifcfg_parent_class)->dispose (object);
 }
@@ -38,6 +38,57 @@
 
 #include "nm-core-internal.h"
 
+/* The key a line assigns to, or %NULL for comments and other lines
+ * without an assignment. */
+static char *
+_line_get_key (const char *line)
+{
+	const char *eq;
+
+	eq = strchr (line, '=');
+	return eq ? g_strndup (line, eq - line) : NULL;
+}
+
+/* Index @link unless an earlier line already sets the same key. */
+static void
+_line_index_add (shvarFile *s, GList *link)
+{
+	char *key;
+
+	key = _line_get_key (link->data);
+	if (!key)
+		return;
+	if (g_hash_table_contains (s->lineIndex, key))
+		g_free (key);
+	else
+		g_hash_table_insert (s->lineIndex, key, link);
+}
+
+/* Drop @link, which is about to be removed from the list, from the
+ * index. If a later line sets the same key, that one takes over. */
+static void
+_line_index_remove (shvarFile *s, GList *link)
+{
+	gs_free char *key = NULL;
+	GList *iter;
+	guint len;
+
+	key = _line_get_key (link->data);
+	if (!key || g_hash_table_lookup (s->lineIndex, key) != link)
+		return;
+
+	len = strlen (key);
+	for (iter = link->next; iter; iter = iter->next) {
+		const char *line = iter->data;
+
+		if (!strncmp (key, line, len) && line[len] == '=') {
+			g_hash_table_insert (s->lineIndex, g_strdup (key), iter);
+			return;
+		}
+	}
+	g_hash_table_remove (s->lineIndex, key);
+}
+
 /* Open the file <name>, returning a shvarFile on success and NULL on failure.
  * Add a wrinkle to let the caller specify whether or not to create the file
  * (actually, return a structure anyway) if it doesn't exist.
@@ -50,6 +101,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	int errsv = 0;
 
 	s = g_slice_new0 (shvarFile);
+	s->lineIndex = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 	s->fd = -1;
 	if (create)
@@ -68,6 +120,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	if (s->fd != -1) {
 		struct stat buf;
 		char *arena, *p, *q;
+		GList *iter;
 		ssize_t nread, total = 0;
 
 		if (fstat (s->fd, &buf) < 0) {
@@ -91,9 +144,13 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 
 		/* we'd use g_strsplit() here, but we want a list, not an array */
 		for (p = arena; (q = strchr (p, '\n')) != NULL; p = q + 1)
-			s->lineList = g_list_append (s->lineList, g_strndup (p, q - p));
+			s->lineList = g_list_prepend (s->lineList, g_strndup (p, q - p));
+		s->lineList = g_list_reverse (s->lineList);
 		g_free (arena);
 
+		for (iter = s->lineList; iter; iter = iter->next)
+			_line_index_add (s, iter);
+
 		/* closefd is set if we opened the file read-only, so go ahead and
 		 * close it, because we can't write to it anyway
 		 */
@@ -111,6 +168,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
  bail:
 	if (s->fd != -1)
 		close (s->fd);
+	g_hash_table_unref (s->lineIndex);
 	g_free (s->fileName);
 	g_slice_free (shvarFile, s);
 
@@ -269,26 +327,21 @@ svGetValue (shvarFile *s, const char *key, gboolean verbatim)
 char *
 svGetValueFull (shvarFile *s, const char *key, gboolean verbatim)
 {
-	char *value = NULL;
-	char *line;
-	guint len;
+	char *value;
+	const char *line;
 
 	g_return_val_if_fail (s != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 
-	len = strlen (key);
-
-	for (s->current = s->lineList; s->current; s->current = s->current->next) {
-		line = s->current->data;
-		if (!strncmp (key, line, len) && line[len] == '=') {
-			/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
-			value = g_strchomp (g_strdup (line + len + 1));
-			if (!verbatim)
-				svUnescape (value);
-			break;
-		}
-	}
+	s->current = g_hash_table_lookup (s->lineIndex, key);
+	if (!s->current)
+		return NULL;
 
+	line = s->current->data;
+	/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
+	value = g_strchomp (g_strdup (line + strlen (key) + 1));
+	if (!verbatim)
+		svUnescape (value);
 	return value;
 }
 
@@ -386,6 +439,16 @@ svSetValue (shvarFile *s, const char *key, const char *value, gboolean verbatim)
 	svSetValueFull (s, key, value && value[0] ? value : NULL, verbatim);
 }
 
+static void
+_line_append (shvarFile *s, const char *key, char *keyValue)
+{
+	GList *link;
+
+	link = g_list_append (NULL, keyValue);
+	s->lineList = g_list_concat (s->lineList, link);
+	g_hash_table_insert (s->lineIndex, g_strdup (key), link);
+}
+
 /* Same as svSetValue() but it preserves empty @value -- contrary to
  * svSetValue() for which "" effectively means to remove the value. */
 void
@@ -410,6 +473,7 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 		/* delete value */
 		if (oldval) {
 			/* delete line */
+			_line_index_remove (s, s->current);
 			s->lineList = g_list_remove_link (s->lineList, s->current);
 			g_free (s->current->data);
 			g_list_free_1 (s->current);
@@ -421,7 +485,7 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 	keyValue = g_strdup_printf ("%s=%s", key, newval);
 	if (!oldval) {
 		/* append line */
-		s->lineList = g_list_append (s->lineList, keyValue);
+		_line_append (s, key, keyValue);
 		s->modified = TRUE;
 		return;
 	}
@@ -432,7 +496,7 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 			g_free (s->current->data);
 			s->current->data = keyValue;
 		} else
-			s->lineList = g_list_append (s->lineList, keyValue);
+			_line_append (s, key, keyValue);
 		s->modified = TRUE;
 	} else
 		g_free (keyValue);
@@ -511,6 +575,7 @@ svCloseFile (shvarFile *s)
 		close (s->fd);
 
 	g_free (s->fileName);
+	g_hash_table_unref (s->lineIndex);
 	g_list_free_full (s->lineList, g_free); /* implicitly frees s->current */
 	g_slice_free (shvarFile, s);
 }
@@ -38,6 +38,7 @@ struct _shvarFile {
 	GList     *lineList;    /* read-only */
 	GList     *current;     /* set implicitly or explicitly, points to element of lineList */
 	gboolean   modified;    /* ignore */
+	GHashTable *lineIndex;  /* ignore; key -> first element of lineList setting it */
 };
 
 
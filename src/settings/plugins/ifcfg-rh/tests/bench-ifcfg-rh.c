@@ -0,0 +1,236 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager ifcfg-rh reader benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Writes a directory of generated ifcfg files and measures shvar and the
+ * ifcfg reader on it.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "nm-core-internal.h"
+
+#include "common.h"
+#include "reader.h"
+#include "shvar.h"
+
+#include "nm-test-utils-core.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int files;
+	int addresses;
+	int lines;
+} global_opt = {
+	.files = 1000,
+	.addresses = 4,
+	.lines = 50,
+};
+
+static char **filenames;
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "files", 'n', 0, G_OPTION_ARG_INT, &global_opt.files, "Number of ifcfg files to generate", "N" },
+		{ "addresses", 'm', 0, G_OPTION_ARG_INT, &global_opt.addresses, "Number of IPADDRn/PREFIXn pairs per file", "M" },
+		{ "lines", 'l', 0, G_OPTION_ARG_INT, &global_opt.lines, "Number of additional comment and unknown key lines per file", "L" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark shvar and the ifcfg-rh reader on a generated ifcfg directory.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.files <= 0
+	    || global_opt.addresses < 0
+	    || global_opt.addresses > 256
+	    || global_opt.lines < 0) {
+		g_warning ("Invalid arguments: counts must not be negative and at most 256 addresses");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+bench_generate (const char *dir)
+{
+	NMBenchTimer timer;
+	GString *str;
+	int i, j;
+
+	str = g_string_sized_new (4096);
+
+	nm_bench_timer_start (&timer, "generate");
+	for (i = 0; i < global_opt.files; i++) {
+		gs_free char *uuid = nm_utils_uuid_generate ();
+
+		g_string_truncate (str, 0);
+		g_string_append (str, "TYPE=Ethernet\n");
+		g_string_append_printf (str, "NAME=bench%d\n", i);
+		g_string_append_printf (str, "UUID=%s\n", uuid);
+		g_string_append_printf (str, "HWADDR=02:00:00:%02x:%02x:%02x\n",
+		                        (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF);
+		g_string_append (str, "ONBOOT=yes\n");
+		/* lines that the reader never looks up, but a linear
+		 * search has to skip */
+		for (j = 0; j < global_opt.lines; j++) {
+			if (j % 2)
+				g_string_append_printf (str, "# comment %d\n", j);
+			else
+				g_string_append_printf (str, "X_BENCH_%d=\"unused value %d\"\n", j, j);
+		}
+		g_string_append (str, global_opt.addresses ? "BOOTPROTO=none\n" : "BOOTPROTO=dhcp\n");
+		for (j = 0; j < global_opt.addresses; j++) {
+			g_string_append_printf (str, "IPADDR%d=100.%d.%d.%d\n", j,
+			                        64 + (j & 0x3F), (i >> 8) & 0xFF, i & 0xFF);
+			g_string_append_printf (str, "PREFIX%d=24\n", j);
+		}
+
+		filenames[i] = g_strdup_printf ("%s/" IFCFG_TAG "bench%d", dir, i);
+		g_assert (g_file_set_contents (filenames[i], str->str, str->len, NULL));
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	g_string_free (str, TRUE);
+}
+
+static void
+bench_shvar (void)
+{
+	NMBenchTimer timer;
+	int i, j;
+
+	nm_bench_timer_start (&timer, "shvar-open");
+	for (i = 0; i < global_opt.files; i++) {
+		shvarFile *f;
+
+		f = svOpenFile (filenames[i], NULL);
+		g_assert (f);
+		svCloseFile (f);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	/* the reader probes all 256 IPADDRn/PREFIXn/GATEWAYn indexes */
+	nm_bench_timer_start (&timer, "shvar-lookup");
+	for (i = 0; i < global_opt.files; i++) {
+		shvarFile *f;
+
+		f = svOpenFile (filenames[i], NULL);
+		g_assert (f);
+		for (j = 0; j < 256; j++) {
+			char key[32];
+
+			nm_sprintf_buf (key, "IPADDR%d", j);
+			g_free (svGetValue (f, key, FALSE));
+			nm_sprintf_buf (key, "PREFIX%d", j);
+			g_free (svGetValue (f, key, FALSE));
+			nm_sprintf_buf (key, "GATEWAY%d", j);
+			g_free (svGetValue (f, key, FALSE));
+			timer.ops += 3;
+		}
+		svCloseFile (f);
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "shvar-set");
+	for (i = 0; i < global_opt.files; i++) {
+		shvarFile *f;
+
+		f = svOpenFile (filenames[i], NULL);
+		g_assert (f);
+		for (j = 0; j < global_opt.addresses; j++) {
+			char key[32];
+
+			nm_sprintf_buf (key, "PREFIX%d", j);
+			svSetValue (f, key, "16", FALSE);
+			nm_sprintf_buf (key, "GATEWAY%d", j);
+			svSetValue (f, key, "100.64.0.1", FALSE);
+			timer.ops += 2;
+		}
+		svCloseFile (f);
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_reader (void)
+{
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, "reader");
+	for (i = 0; i < global_opt.files; i++) {
+		gs_unref_object NMConnection *connection = NULL;
+		GError *error = NULL;
+
+		connection = connection_from_file_test (filenames[i], NULL, TYPE_ETHERNET, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (connection);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	gs_free char *dir = NULL;
+	int i;
+
+	nmtst_init_with_logging (&argc, &argv, "ERR", "ALL");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	dir = g_strdup (TEST_SCRATCH_DIR "bench-ifcfg-XXXXXX");
+	g_assert (g_mkdtemp (dir));
+
+	filenames = g_new0 (char *, global_opt.files + 1);
+
+	g_print ("# files=%d addresses=%d lines=%d\n",
+	         global_opt.files, global_opt.addresses, global_opt.lines);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	bench_generate (dir);
+	bench_shvar ();
+	bench_reader ();
+
+	for (i = 0; i < global_opt.files; i++)
+		unlink (filenames[i]);
+	rmdir (dir);
+	g_strfreev (filenames);
+
+	return EXIT_SUCCESS;
+}
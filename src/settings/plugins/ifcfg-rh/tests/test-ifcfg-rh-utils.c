@@ -27,6 +27,7 @@
 
 #include "common.h"
 #include "utils.h"
+#include "shvar.h"
 
 #include "nm-test-utils-core.h"
 
@@ -139,6 +140,59 @@ test_ignore (void)
 	test_ignored ("ignored-augtmp", "ifcfg-FooBar" AUGTMP_TAG, TRUE);
 }
 
+#define TEST_SHVAR_FILE TEST_SCRATCH_DIR "ifcfg-test-shvar-index"
+
+static void
+test_shvar_index (void)
+{
+	shvarFile *f;
+	GError *error = NULL;
+	gs_free char *contents = NULL;
+	char *value;
+
+	g_assert (g_file_set_contents (TEST_SHVAR_FILE,
+	                               "# A=0\n"
+	                               "A=1\n"
+	                               "B=2\n"
+	                               "A=3\n",
+	                               -1, NULL));
+
+	f = svOpenFile (TEST_SHVAR_FILE, &error);
+	g_assert_no_error (error);
+	g_assert (f);
+
+	/* the first assignment wins */
+	value = svGetValue (f, "A", FALSE);
+	g_assert_cmpstr (value, ==, "1");
+	g_free (value);
+
+	/* removing it uncovers the next one */
+	svSetValue (f, "A", NULL, FALSE);
+	value = svGetValue (f, "A", FALSE);
+	g_assert_cmpstr (value, ==, "3");
+	g_free (value);
+
+	svSetValue (f, "B", "4", FALSE);
+	svSetValue (f, "C", "5", FALSE);
+	value = svGetValue (f, "C", FALSE);
+	g_assert_cmpstr (value, ==, "5");
+	g_free (value);
+	g_assert (!svGetValue (f, "D", FALSE));
+
+	g_assert (svWriteFile (f, 0644, &error));
+	g_assert_no_error (error);
+	svCloseFile (f);
+
+	/* changed lines stay in place, new ones are appended */
+	g_assert (g_file_get_contents (TEST_SHVAR_FILE, &contents, NULL, NULL));
+	g_assert_cmpstr (contents, ==,
+	                 "# A=0\n"
+	                 "B=4\n"
+	                 "A=3\n"
+	                 "C=5\n");
+	unlink (TEST_SHVAR_FILE);
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -149,6 +203,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/settings/plugins/ifcfg-rh/name", test_name);
 	g_test_add_func ("/settings/plugins/ifcfg-rh/path", test_path);
 	g_test_add_func ("/settings/plugins/ifcfg-rh/ignore", test_ignore);
+	g_test_add_func ("/settings/plugins/ifcfg-rh/shvar-index", test_shvar_index);
 
 	return g_test_run ();
 }
@@ -45,6 +45,7 @@
 #include "nm-utils.h"
 #include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
+#include "nm-settings-writer.h"
 
 #include "common.h"
 #include "shvar.h"
@@ -1957,7 +1958,7 @@ write_route_file_legacy (const char *filename, NMSettingIPConfig *s_ip4, GError
 	route_contents = g_strjoinv (NULL, route_items);
 	g_strfreev (route_items);
 
-	if (!g_file_set_contents (filename, route_contents, -1, NULL)) {
+	if (!nm_settings_write_file (filename, route_contents, strlen (route_contents), NULL, NULL)) {
 		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_FAILED,
 		             "Writing route file '%s' failed", filename);
 		goto error;
@@ -2436,7 +2437,7 @@ write_route6_file (const char *filename, NMSettingIPConfig *s_ip6, GError **erro
 	route_contents = g_strjoinv (NULL, route_items);
 	g_strfreev (route_items);
 
-	if (!g_file_set_contents (filename, route_contents, -1, NULL)) {
+	if (!nm_settings_write_file (filename, route_contents, strlen (route_contents), NULL, NULL)) {
 		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_FAILED,
 		             "Writing route6 file '%s' failed", filename);
 		goto error;
@@ -29,36 +29,107 @@
 #include <string.h>
 #include <wordexp.h>
 #include <libgen.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include "nm-utils.h"
 
-if_block* first;
-if_block* last;
+/* The parser keeps every file it read, the main interfaces file and the
+ * sourced ones, as the list of its blocks and source lines. The list of
+ * all blocks is assembled from them by following the source lines, and is
+ * assembled again by ifparser_reparse(), which reads only the files that
+ * changed since. There is no global state: a parser may be used from any
+ * thread, as long as it is used from one at a time. */
 
-if_data* last_data;
+/* the depth at which source lines are ignored, to stop on loops */
+#define SOURCE_DEPTH_MAX 32
 
-void add_block(const char *type, const char* name)
+typedef struct {
+	/* the block, or NULL for a source line */
+	if_block *block;
+	/* the absolute path of a source line, before the word expansion */
+	char *source;
+} IfItem;
+
+typedef struct {
+	char *path;
+
+	/* what the file was read from */
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+
+	GPtrArray *items;
+
+	/* the generation of the parser when the file was last assembled */
+	guint generation;
+} IfFile;
+
+struct _if_parser {
+	char *eni_file;
+	int quiet;
+
+	/* path :: IfFile */
+	GHashTable *files;
+
+	if_block *first;
+	if_block *last;
+	int num_blocks;
+
+	/* name :: the first "iface" block of that name */
+	GHashTable *ifaces;
+
+	/* the blocks of files that are sourced more than once are copied */
+	GSList *copies;
+
+	guint generation;
+	gboolean changed;
+};
+
+/* the state while reading one file */
+typedef struct {
+	IfFile *file;
+	if_block *last;
+	if_data *last_data;
+} ParseState;
+
+static void _destroy_block (if_block *ifb);
+
+static void
+add_block (ParseState *state, const char *type, const char *name)
 {
 	if_block *ret = g_slice_new0 (struct _if_block);
-	ret->name = g_strdup(name);
-	ret->type = g_strdup(type);
-	if (first == NULL)
-		first = last = ret;
-	else
-	{
-		last->next = ret;
-		last = ret;
-	}
-	last_data = NULL;
+	IfItem *item = g_slice_new0 (IfItem);
+
+	ret->name = g_strdup (name);
+	ret->type = g_strdup (type);
+	item->block = ret;
+	g_ptr_array_add (state->file->items, item);
+	state->last = ret;
+	state->last_data = NULL;
+}
+
+static void
+add_source (ParseState *state, const char *abs_path)
+{
+	IfItem *item = g_slice_new0 (IfItem);
+
+	item->source = g_strdup (abs_path);
+	g_ptr_array_add (state->file->items, item);
+	/* the data after a source line has no block in this file to go to */
+	state->last = NULL;
+	state->last_data = NULL;
 }
 
-void add_data(const char *key,const char *data)
+static void
+add_data (ParseState *state, const char *key, const char *data)
 {
 	if_data *ret;
 	char *idx;
 
 	/* Check if there is a block where we can attach our data */
-	if (first == NULL)
+	if (state->last == NULL)
 		return;
 
 	ret = g_slice_new0 (struct _if_data);
@@ -71,16 +142,32 @@ void add_data(const char *key,const char *data)
 	}
 	ret->data = g_strdup(data);
 
-	if (last->info == NULL)
-	{
-		last->info = ret;
-		last_data = ret;
-	}
+	if (state->last->info == NULL)
+		state->last->info = ret;
 	else
-	{
-		last_data->next = ret;
-		last_data = last_data->next;
-	}
+		state->last_data->next = ret;
+	state->last_data = ret;
+}
+
+static void
+_item_free (gpointer data)
+{
+	IfItem *item = data;
+
+	if (item->block)
+		_destroy_block (item->block);
+	g_free (item->source);
+	g_slice_free (IfItem, item);
+}
+
+static void
+_file_free (gpointer data)
+{
+	IfFile *file = data;
+
+	g_ptr_array_unref (file->items);
+	g_free (file->path);
+	g_slice_free (IfFile, file);
 }
 
 /* join values in src with spaces into dst;  dst needs to be large enough */
@@ -100,32 +187,35 @@ static char *join_values_with_spaces(char *dst, char **src)
 	return(dst);
 }
 
-static void _ifparser_source (const char *path, const char *en_dir, int quiet);
-
-static void
-_recursive_ifparser (const char *eni_file, int quiet)
+static IfFile *
+_parse_file (const char *eni_file, const struct stat *st, int quiet)
 {
 	FILE *inp;
 	char line[255];
 	int skip_to_block = 1;
 	int skip_long_line = 0;
 	int offs = 0;
+	IfFile *file;
+	ParseState state = { NULL };
 
-	/* Check if interfaces file exists and open it */
-	if (!g_file_test (eni_file, G_FILE_TEST_EXISTS)) {
-		if (!quiet)
-			nm_log_warn (LOGD_SETTINGS, "interfaces file %s doesn't exist\n", eni_file);
-		return;
-	}
 	inp = fopen (eni_file, "r");
 	if (inp == NULL) {
 		if (!quiet)
 			nm_log_warn (LOGD_SETTINGS, "Can't open %s\n", eni_file);
-		return;
+		return NULL;
 	}
 	if (!quiet)
 		nm_log_info (LOGD_SETTINGS, "      interface-parser: parsing file %s\n", eni_file);
 
+	file = g_slice_new0 (IfFile);
+	file->path = g_strdup (eni_file);
+	file->dev = st->st_dev;
+	file->ino = st->st_ino;
+	file->size = st->st_size;
+	file->mtime = st->st_mtim;
+	file->items = g_ptr_array_new_with_free_func (_item_free);
+	state.file = file;
+
 
 	while (!feof(inp))
 	{
@@ -202,9 +292,9 @@ _recursive_ifparser (const char *eni_file, int quiet)
 				}
 				continue;
 			}
-			add_block(token[0], token[1]);
+			add_block(&state, token[0], token[1]);
 			skip_to_block = 0;
-			add_data(token[2], join_values_with_spaces(value, token + 3));
+			add_data(&state, token[2], join_values_with_spaces(value, token + 3));
 		}
 		/* auto and allow-auto stanzas are equivalent,
 		 * both can take multiple interfaces as parameters: add one block for each */
@@ -212,18 +302,18 @@ _recursive_ifparser (const char *eni_file, int quiet)
 			 strcmp(token[0], "allow-auto") == 0) {
 			int i;
 			for (i = 1; i < toknum; i++)
-				add_block("auto", token[i]);
+				add_block(&state, "auto", token[i]);
 			skip_to_block = 0;
 		}
 		else if (strcmp(token[0], "mapping") == 0) {
-			add_block(token[0], join_values_with_spaces(value, token + 1));
+			add_block(&state, token[0], join_values_with_spaces(value, token + 1));
 			skip_to_block = 0;
 		}
 		/* allow-* can take multiple interfaces as parameters: add one block for each */
 		else if (strncmp(token[0],"allow-",6) == 0) {
 			int i;
 			for (i = 1; i < toknum; i++)
-				add_block(token[0], token[i]);
+				add_block(&state, token[0], token[i]);
 			skip_to_block = 0;
 		}
 		/* source stanza takes one or more filepaths as parameters */
@@ -240,8 +330,16 @@ _recursive_ifparser (const char *eni_file, int quiet)
 			}
 
 			en_dir = g_path_get_dirname (eni_file);
-			for (i = 1; i < toknum; ++i)
-				_ifparser_source (token[i], en_dir, quiet);
+			for (i = 1; i < toknum; ++i) {
+				char *abs_path;
+
+				if (g_path_is_absolute (token[i]))
+					abs_path = g_strdup (token[i]);
+				else
+					abs_path = g_build_filename (en_dir, token[i], NULL);
+				add_source (&state, abs_path);
+				g_free (abs_path);
+			}
 			g_free (en_dir);
 		}
 		else {
@@ -251,106 +349,289 @@ _recursive_ifparser (const char *eni_file, int quiet)
 					             join_values_with_spaces(value, token));
 				}
 			} else
-				add_data(token[0], join_values_with_spaces(value, token + 1));
+				add_data(&state, token[0], join_values_with_spaces(value, token + 1));
 		}
 	}
 	fclose(inp);
 
 	if (!quiet)
 		nm_log_info (LOGD_SETTINGS, "      interface-parser: finished parsing file %s\n", eni_file);
+	return file;
+}
+
+static void
+_destroy_data (if_data *ifd)
+{
+	while (ifd) {
+		if_data *next = ifd->next;
+
+		g_free (ifd->key);
+		g_free (ifd->data);
+		g_slice_free (struct _if_data, ifd);
+		ifd = next;
+	}
+}
+
+/* frees @ifb, but not the blocks following it */
+static void
+_destroy_block (if_block *ifb)
+{
+	_destroy_data (ifb->info);
+	g_free (ifb->name);
+	g_free (ifb->type);
+	g_slice_free (struct _if_block, ifb);
+}
+
+static if_block *
+_copy_block (const if_block *ifb)
+{
+	if_block *ret = g_slice_new0 (struct _if_block);
+	const if_data *d;
+	if_data *last_data = NULL;
+
+	ret->name = g_strdup (ifb->name);
+	ret->type = g_strdup (ifb->type);
+	for (d = ifb->info; d; d = d->next) {
+		if_data *c = g_slice_new0 (struct _if_data);
+
+		c->key = g_strdup (d->key);
+		c->data = g_strdup (d->data);
+		if (last_data)
+			last_data->next = c;
+		else
+			ret->info = c;
+		last_data = c;
+	}
+	return ret;
+}
+
+/*****************************************************************************/
+
+static void
+_append_block (if_parser *parser, if_block *ifb)
+{
+	ifb->next = NULL;
+	if (parser->last)
+		parser->last->next = ifb;
+	else
+		parser->first = ifb;
+	parser->last = ifb;
+	parser->num_blocks++;
+
+	if (   strcmp (ifb->type, "iface") == 0
+	    && !g_hash_table_contains (parser->ifaces, ifb->name))
+		g_hash_table_insert (parser->ifaces, ifb->name, ifb);
+}
+
+/* Returns the file at @path, read again if it changed since the last
+ * time. A file that already is part of the current assembly isn't
+ * checked again. */
+static IfFile *
+_get_file (if_parser *parser, const char *path)
+{
+	IfFile *file;
+	struct stat st;
+
+	file = g_hash_table_lookup (parser->files, path);
+	if (file && file->generation == parser->generation)
+		return file;
+
+	if (stat (path, &st) != 0) {
+		if (!parser->quiet) {
+			if (errno == ENOENT)
+				nm_log_warn (LOGD_SETTINGS, "interfaces file %s doesn't exist\n", path);
+			else
+				nm_log_warn (LOGD_SETTINGS, "Can't open %s\n", path);
+		}
+		if (file) {
+			g_hash_table_remove (parser->files, path);
+			parser->changed = TRUE;
+		}
+		return NULL;
+	}
+
+	if (   file
+	    && file->dev == st.st_dev
+	    && file->ino == st.st_ino
+	    && file->size == st.st_size
+	    && file->mtime.tv_sec == st.st_mtim.tv_sec
+	    && file->mtime.tv_nsec == st.st_mtim.tv_nsec)
+		return file;
+
+	parser->changed = TRUE;
+	file = _parse_file (path, &st, parser->quiet);
+	if (!file) {
+		g_hash_table_remove (parser->files, path);
+		return NULL;
+	}
+	g_hash_table_replace (parser->files, file->path, file);
+	return file;
 }
 
+static void _assemble_source (if_parser *parser, const char *abs_path, guint depth);
+
 static void
-_ifparser_source (const char *path, const char *en_dir, int quiet)
+_assemble_file (if_parser *parser, const char *path, guint depth)
+{
+	IfFile *file;
+	gboolean copy;
+	guint i;
+
+	file = _get_file (parser, path);
+	if (!file)
+		return;
+
+	/* a file sourced a second time contributes its blocks again, like
+	 * ifupdown does. They are copies, because a block has one next. */
+	copy = (file->generation == parser->generation);
+	file->generation = parser->generation;
+
+	for (i = 0; i < file->items->len; i++) {
+		IfItem *item = file->items->pdata[i];
+
+		if (item->block) {
+			if_block *ifb = item->block;
+
+			if (copy) {
+				ifb = _copy_block (ifb);
+				parser->copies = g_slist_prepend (parser->copies, ifb);
+			}
+			_append_block (parser, ifb);
+		} else
+			_assemble_source (parser, item->source, depth + 1);
+	}
+}
+
+static void
+_assemble_source (if_parser *parser, const char *abs_path, guint depth)
 {
-	char *abs_path;
 	wordexp_t we;
 	uint i;
 
-	if (g_path_is_absolute (path))
-		abs_path = g_strdup (path);
-	else
-		abs_path = g_build_filename (en_dir, path, NULL);
+	if (depth > SOURCE_DEPTH_MAX) {
+		if (!parser->quiet)
+			nm_log_warn (LOGD_SETTINGS, "ignoring source line for %s nested too deeply\n", abs_path);
+		return;
+	}
 
-	if (!quiet)
+	if (!parser->quiet)
 		nm_log_info (LOGD_SETTINGS, "      interface-parser: source line includes interfaces file(s) %s\n", abs_path);
 
-	/* ifupdown uses WRDE_NOCMD for wordexp. */
+	/* The expansion is done each time, to find the files that were added
+	 * to a sourced directory. ifupdown uses WRDE_NOCMD for wordexp. */
 	if (wordexp (abs_path, &we, WRDE_NOCMD)) {
-		if (!quiet)
+		if (!parser->quiet)
 			nm_log_warn (LOGD_SETTINGS, "word expansion for %s failed\n", abs_path);
 	} else {
 		for (i = 0; i < we.we_wordc; i++)
-			_recursive_ifparser (we.we_wordv[i], quiet);
+			_assemble_file (parser, we.we_wordv[i], depth);
 		wordfree (&we);
 	}
-	g_free (abs_path);
 }
 
-void ifparser_init (const char *eni_file, int quiet)
+static void
+_assemble (if_parser *parser)
 {
-	first = last = NULL;
-	_recursive_ifparser (eni_file, quiet);
+	GHashTableIter iter;
+	IfFile *file;
+
+	parser->first = parser->last = NULL;
+	parser->num_blocks = 0;
+	g_hash_table_remove_all (parser->ifaces);
+	g_slist_free_full (parser->copies, (GDestroyNotify) _destroy_block);
+	parser->copies = NULL;
+
+	parser->generation++;
+	_assemble_file (parser, parser->eni_file, 0);
+
+	/* forget the files that aren't sourced anymore */
+	g_hash_table_iter_init (&iter, parser->files);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &file)) {
+		if (file->generation != parser->generation) {
+			g_hash_table_iter_remove (&iter);
+			parser->changed = TRUE;
+		}
+	}
 }
 
-void _destroy_data(if_data *ifd)
+/*****************************************************************************/
+
+/**
+ * ifparser_parse:
+ * @eni_file: the path of the interfaces file
+ * @quiet: whether not to log
+ *
+ * Reads @eni_file and the files it sources.
+ *
+ * Returns: the parser, to be freed with ifparser_destroy(). It's
+ *   never %NULL: a missing file has no blocks.
+ */
+if_parser *
+ifparser_parse (const char *eni_file, int quiet)
 {
-	if (ifd == NULL)
-		return;
-	_destroy_data(ifd->next);
-	g_free(ifd->key);
-	g_free(ifd->data);
-	g_slice_free(struct _if_data, ifd);
-	return;
+	if_parser *parser;
+
+	parser = g_slice_new0 (if_parser);
+	parser->eni_file = g_strdup (eni_file);
+	parser->quiet = quiet;
+	parser->files = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, _file_free);
+	parser->ifaces = g_hash_table_new (g_str_hash, g_str_equal);
+
+	_assemble (parser);
+	return parser;
 }
 
-void _destroy_block(if_block* ifb)
+/**
+ * ifparser_reparse:
+ * @parser: the parser
+ *
+ * Reads again the files that changed since the last time, judged by
+ * their size and modification time, and assembles the blocks again.
+ * The blocks of the files that changed or aren't sourced anymore are
+ * freed, the ones of the other files are kept.
+ *
+ * Returns: %TRUE if a file was added, changed or removed.
+ */
+gboolean
+ifparser_reparse (if_parser *parser)
 {
-	if (ifb == NULL)
-		return;
-	_destroy_block(ifb->next);
-	_destroy_data(ifb->info);
-	g_free(ifb->name);
-	g_free(ifb->type);
-	g_slice_free(struct _if_block, ifb);
-	return;
+	g_return_val_if_fail (parser, FALSE);
+
+	parser->changed = FALSE;
+	_assemble (parser);
+	return parser->changed;
 }
 
-void ifparser_destroy(void)
+void
+ifparser_destroy (if_parser *parser)
 {
-	_destroy_block(first);
-	first = last = NULL;
+	if (!parser)
+		return;
+
+	g_slist_free_full (parser->copies, (GDestroyNotify) _destroy_block);
+	g_hash_table_destroy (parser->ifaces);
+	g_hash_table_destroy (parser->files);
+	g_free (parser->eni_file);
+	g_slice_free (if_parser, parser);
 }
 
-if_block *ifparser_getfirst(void)
+if_block *
+ifparser_getfirst (if_parser *parser)
 {
-	return first;
+	return parser->first;
 }
 
-int ifparser_get_num_blocks(void)
+int
+ifparser_get_num_blocks (if_parser *parser)
 {
-	int i = 0;
-	if_block *iter = first;
-
-	while (iter) {
-		i++;
-		iter = iter->next;
-	}
-	return i;
+	return parser->num_blocks;
 }
 
-if_block *ifparser_getif(const char* iface)
+if_block *
+ifparser_getif (if_parser *parser, const char *iface)
 {
-	if_block *curr = first;
-	while(curr!=NULL)
-	{
-		if (strcmp(curr->type,"iface")==0 && strcmp(curr->name,iface)==0)
-			return curr;
-		curr = curr->next;
-	}
-	return NULL;
+	return g_hash_table_lookup (parser->ifaces, iface);
 }
-
 const char *ifparser_getkey(if_block* iface, const char *key)
 {
 	if_data *curr = iface->info;
@@ -64,6 +64,9 @@
 typedef struct {
 	GUdevClient *client;
 
+	/* the parsed /e/n/i. It owns the blocks, whose names are used as keys */
+	if_parser *eni;
+
 	GHashTable *connections;  /* /e/n/i block name :: NMIfupdownConnection */
 
 	/* Stores all blocks/interfaces read from /e/n/i regardless of whether
@@ -324,8 +327,9 @@ init (NMSettingsPlugin *config)
 		g_signal_connect (priv->client, "uevent", G_CALLBACK (handle_uevent), self);
 
 	/* Read in all the interfaces */
-	ifparser_init (ENI_INTERFACES_FILE, 0);
-	block = ifparser_getfirst ();
+	if (!priv->eni)
+		priv->eni = ifparser_parse (ENI_INTERFACES_FILE, 0);
+	block = ifparser_getfirst (priv->eni);
 	while (block) {
 		if(!strcmp ("auto", block->type) || !strcmp ("allow-hotplug", block->type))
 			g_hash_table_insert (auto_ifaces, block->name, GUINT_TO_POINTER (1));
@@ -549,6 +553,8 @@ dispose (GObject *object)
 	if (priv->client)
 		g_object_unref (priv->client);
 
+	g_clear_pointer (&priv->connections, g_hash_table_destroy);
+	g_clear_pointer (&priv->eni, ifparser_destroy);
 
 	G_OBJECT_CLASS (settings_plugin_ifupdown_parent_class)->dispose (object);
 }
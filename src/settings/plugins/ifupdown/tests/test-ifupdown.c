@@ -21,6 +21,8 @@
 #include "nm-default.h"
 
 #include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 
 #include "nm-core-internal.h"
 #include "interface_parser.h"
@@ -125,14 +127,14 @@ expected_free (Expected *e)
 }
 
 static void
-compare_expected_to_ifparser (Expected *e)
+compare_expected_to_ifparser (if_parser *parser, Expected *e)
 {
 	if_block *n;
 	GSList *biter, *kiter;
 
-	g_assert_cmpint (g_slist_length (e->blocks), ==, ifparser_get_num_blocks ());
+	g_assert_cmpint (g_slist_length (e->blocks), ==, ifparser_get_num_blocks (parser));
 
-	for (n = ifparser_getfirst (), biter = e->blocks;
+	for (n = ifparser_getfirst (parser), biter = e->blocks;
 	     n && biter;
 	     n = n->next, biter = g_slist_next (biter)) {
 		if_data *m;
@@ -159,12 +161,12 @@ compare_expected_to_ifparser (Expected *e)
 }
 
 static void
-dump_blocks (void)
+dump_blocks (if_parser *parser)
 {
 	if_block *n;
 
 	g_message ("\n***************************************************");
-	for (n = ifparser_getfirst (); n != NULL; n = n->next) {
+	for (n = ifparser_getfirst (parser); n != NULL; n = n->next) {
 		if_data *m;
 
 		// each block start with its type & name 
@@ -182,19 +184,22 @@ dump_blocks (void)
 	g_message ("##################################################\n");
 }
 
-static void
+static if_parser *
 init_ifparser_with_file (const char *path, const char *file)
 {
+	if_parser *parser;
 	char *tmp;
 
 	tmp = g_strdup_printf ("%s/%s", path, file);
-	ifparser_init (tmp, 1);
+	parser = ifparser_parse (tmp, 1);
 	g_free (tmp);
+	return parser;
 }
 
 static void
 test1_ignore_line_before_first_block (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -205,16 +210,17 @@ test1_ignore_line_before_first_block (const char *path)
 	expected_add_block (e, b);
 	expected_block_add_key (b, expected_key_new ("inet", "dhcp"));
 
-	init_ifparser_with_file (path, "test1");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test1");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test2_wrapped_line (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -222,16 +228,17 @@ test2_wrapped_line (const char *path)
 	b = expected_block_new ("auto", "lo");
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test2");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test2");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test3_wrapped_multiline_multiarg (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -243,16 +250,17 @@ test3_wrapped_multiline_multiarg (const char *path)
 	b = expected_block_new ("allow-hotplug", "bnep0");
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test3");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test3");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test4_allow_auto_is_auto (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -260,16 +268,17 @@ test4_allow_auto_is_auto (const char *path)
 	b = expected_block_new ("auto", "eth0");
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test4");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test4");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test5_allow_auto_multiarg (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -279,16 +288,17 @@ test5_allow_auto_multiarg (const char *path)
 	b = expected_block_new ("allow-hotplug", "wlan0");
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test5");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test5");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test6_mixed_whitespace (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -297,32 +307,35 @@ test6_mixed_whitespace (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "loopback"));
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test6");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test6");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test7_long_line (const char *path)
 {
-	init_ifparser_with_file (path, "test7");
-	g_assert_cmpint (ifparser_get_num_blocks (), ==, 0);
-	ifparser_destroy ();
+	if_parser *parser;
+	parser = init_ifparser_with_file (path, "test7");
+	g_assert_cmpint (ifparser_get_num_blocks (parser), ==, 0);
+	ifparser_destroy (parser);
 }
 
 static void
 test8_long_line_wrapped (const char *path)
 {
-	init_ifparser_with_file (path, "test8");
-	g_assert_cmpint (ifparser_get_num_blocks (), ==, 0);
-	ifparser_destroy ();
+	if_parser *parser;
+	parser = init_ifparser_with_file (path, "test8");
+	g_assert_cmpint (ifparser_get_num_blocks (parser), ==, 0);
+	ifparser_destroy (parser);
 }
 
 static void
 test9_wrapped_lines_in_block (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -335,16 +348,17 @@ test9_wrapped_lines_in_block (const char *path)
 	expected_block_add_key (b, expected_key_new ("broadcast", "10.250.2.63"));
 	expected_block_add_key (b, expected_key_new ("gateway", "10.250.2.50"));
 
-	init_ifparser_with_file (path, "test9");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test9");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test11_complex_wrap (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -354,16 +368,17 @@ test11_complex_wrap (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "manual"));
 	expected_block_add_key (b, expected_key_new ("pre-up", "/sbin/ifconfig eth0 up"));
 
-	init_ifparser_with_file (path, "test11");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test11");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test12_complex_wrap_split_word (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -373,16 +388,17 @@ test12_complex_wrap_split_word (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "manual"));
 	expected_block_add_key (b, expected_key_new ("up", "ifup ppp0=dsl"));
 
-	init_ifparser_with_file (path, "test12");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test12");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test13_more_mixed_whitespace (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -391,16 +407,17 @@ test13_more_mixed_whitespace (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "ppp"));
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test13");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test13");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test14_mixed_whitespace_block_start (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -415,16 +432,17 @@ test14_mixed_whitespace_block_start (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "dhcp"));
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test14");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test14");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test15_trailing_space (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -433,30 +451,32 @@ test15_trailing_space (const char *path)
 	expected_block_add_key (b, expected_key_new ("inet", "static"));
 	expected_add_block (e, b);
 
-	init_ifparser_with_file (path, "test15");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test15");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
 static void
 test16_missing_newline (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 
 	e = expected_new ();
 	expected_add_block (e, expected_block_new ("mapping", "eth0"));
 
-	init_ifparser_with_file (path, "test16");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test16");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 static void
 test17_read_static_ipv4 (const char *path)
 {
+	if_parser *parser;
 	NMConnection *connection;
 	NMSettingConnection *s_con;
 	NMSettingIPConfig *s_ip4;
@@ -466,8 +486,8 @@ test17_read_static_ipv4 (const char *path)
 	NMIPAddress *ip4_addr;
 	if_block *block = NULL;
 
-	init_ifparser_with_file (path, "test17-wired-static-verify-ip4");
-	block = ifparser_getfirst ();
+	parser = init_ifparser_with_file (path, "test17-wired-static-verify-ip4");
+	block = ifparser_getfirst (parser);
 	connection = nm_simple_connection_new();
 	g_assert (connection);
 
@@ -507,11 +527,13 @@ test17_read_static_ipv4 (const char *path)
 	g_assert_cmpstr (nm_setting_ip_config_get_dns_search (s_ip4, 1), ==, "foo.example.com");
 
 	g_object_unref (connection);
+	ifparser_destroy (parser);
 }
 
 static void
 test18_read_static_ipv6 (const char *path)
 {
+	if_parser *parser;
 	NMConnection *connection;
 	NMSettingConnection *s_con;
 	NMSettingIPConfig *s_ip6;
@@ -521,8 +543,8 @@ test18_read_static_ipv6 (const char *path)
 	NMIPAddress *ip6_addr;
 	if_block *block = NULL;
 
-	init_ifparser_with_file (path, "test18-wired-static-verify-ip6");
-	block = ifparser_getfirst ();
+	parser = init_ifparser_with_file (path, "test18-wired-static-verify-ip6");
+	block = ifparser_getfirst (parser);
 	connection = nm_simple_connection_new();
 	g_assert (connection);
 	ifupdown_update_connection_from_if_block(connection, block, &error);
@@ -561,11 +583,13 @@ test18_read_static_ipv6 (const char *path)
 	g_assert_cmpstr (nm_setting_ip_config_get_dns_search (s_ip6, 1), ==, "foo.example.com");
 
 	g_object_unref (connection);
+	ifparser_destroy (parser);
 }
 
 static void
 test19_read_static_ipv4_plen (const char *path)
 {
+	if_parser *parser;
 	NMConnection *connection;
 	NMSettingIPConfig *s_ip4;
 	GError *error = NULL;
@@ -573,8 +597,8 @@ test19_read_static_ipv4_plen (const char *path)
 	if_block *block = NULL;
 	gboolean success;
 
-	init_ifparser_with_file (path, "test19-wired-static-verify-ip4-plen");
-	block = ifparser_getfirst ();
+	parser = init_ifparser_with_file (path, "test19-wired-static-verify-ip4-plen");
+	block = ifparser_getfirst (parser);
 	connection = nm_simple_connection_new();
 	g_assert (connection);
 	ifupdown_update_connection_from_if_block(connection, block, &error);
@@ -595,11 +619,13 @@ test19_read_static_ipv4_plen (const char *path)
 	g_assert_cmpint (nm_ip_address_get_prefix (ip4_addr), ==, 8);
 
 	g_object_unref (connection);
+	ifparser_destroy (parser);
 }
 
 static void
 test20_source_stanza (const char *path)
 {
+	if_parser *parser;
 	Expected *e;
 	ExpectedBlock *b;
 
@@ -617,13 +643,77 @@ test20_source_stanza (const char *path)
 	expected_add_block (e, b);
 	expected_block_add_key (b, expected_key_new ("inet", "dhcp"));
 
-	init_ifparser_with_file (path, "test20-source-stanza");
-	compare_expected_to_ifparser (e);
+	parser = init_ifparser_with_file (path, "test20-source-stanza");
+	compare_expected_to_ifparser (parser, e);
 
-	ifparser_destroy ();
+	ifparser_destroy (parser);
 	expected_free (e);
 }
 
+static void
+test21_reparse (void)
+{
+	if_parser *parser;
+	gs_free char *dir = NULL;
+	gs_free char *eni = NULL, *sub = NULL, *eth0 = NULL, *eth1 = NULL, *eth2 = NULL;
+	gs_free char *content = NULL;
+	if_block *block, *block_eth1;
+
+	dir = g_dir_make_tmp ("test-ifupdown-XXXXXX", NULL);
+	g_assert (dir);
+	eni = g_build_filename (dir, "interfaces", NULL);
+	sub = g_build_filename (dir, "interfaces.d", NULL);
+	eth0 = g_build_filename (sub, "eth0", NULL);
+	eth1 = g_build_filename (sub, "eth1", NULL);
+	eth2 = g_build_filename (sub, "eth2", NULL);
+	g_assert_cmpint (g_mkdir (sub, 0755), ==, 0);
+
+	content = g_strdup_printf ("auto lo\niface lo inet loopback\nsource %s/*\n", sub);
+	g_assert (g_file_set_contents (eni, content, -1, NULL));
+	g_assert (g_file_set_contents (eth0, "iface eth0 inet dhcp\n", -1, NULL));
+	g_assert (g_file_set_contents (eth1, "iface eth1 inet dhcp\n", -1, NULL));
+
+	parser = ifparser_parse (eni, 1);
+	g_assert_cmpint (ifparser_get_num_blocks (parser), ==, 4);
+	block = ifparser_getif (parser, "eth0");
+	g_assert (block);
+	g_assert_cmpstr (ifparser_getkey (block, "inet"), ==, "dhcp");
+	block_eth1 = ifparser_getif (parser, "eth1");
+	g_assert (block_eth1);
+	g_assert (!ifparser_getif (parser, "eth2"));
+
+	/* nothing changed */
+	g_assert (!ifparser_reparse (parser));
+	g_assert (ifparser_getif (parser, "eth1") == block_eth1);
+
+	/* a changed and an added file are read, the others are kept */
+	g_assert (g_file_set_contents (eth0, "iface eth0 inet static\naddress 192.168.1.2\n", -1, NULL));
+	g_assert (g_file_set_contents (eth2, "iface eth2 inet manual\n", -1, NULL));
+	g_assert (ifparser_reparse (parser));
+	g_assert_cmpint (ifparser_get_num_blocks (parser), ==, 5);
+	block = ifparser_getif (parser, "eth0");
+	g_assert (block);
+	g_assert_cmpstr (ifparser_getkey (block, "inet"), ==, "static");
+	g_assert_cmpstr (ifparser_getkey (block, "address"), ==, "192.168.1.2");
+	g_assert (ifparser_getif (parser, "eth1") == block_eth1);
+	g_assert (ifparser_getif (parser, "eth2"));
+
+	/* a removed file */
+	g_assert_cmpint (unlink (eth2), ==, 0);
+	g_assert (ifparser_reparse (parser));
+	g_assert_cmpint (ifparser_get_num_blocks (parser), ==, 4);
+	g_assert (!ifparser_getif (parser, "eth2"));
+	g_assert (ifparser_getif (parser, "eth1") == block_eth1);
+
+	ifparser_destroy (parser);
+
+	unlink (eth0);
+	unlink (eth1);
+	unlink (eni);
+	rmdir (sub);
+	rmdir (dir);
+}
+
 NMTST_DEFINE ();
 
 int
@@ -632,7 +722,7 @@ main (int argc, char **argv)
 	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
 
 	if (0)
-		dump_blocks ();
+		dump_blocks (NULL);
 
 	g_test_add_data_func ("/ifupdate/ignore_line_before_first_block", TEST_ENI_DIR,
 	                      (GTestDataFunc) test1_ignore_line_before_first_block);
@@ -672,6 +762,7 @@ main (int argc, char **argv)
 	                      (GTestDataFunc) test19_read_static_ipv4_plen);
 	g_test_add_data_func ("/ifupdate/source_stanza", TEST_ENI_DIR,
 	                      (GTestDataFunc) test20_source_stanza);
+	g_test_add_func ("/ifupdate/reparse", test21_reparse);
 
 	return g_test_run ();
 }
@@ -36,37 +36,13 @@
 
 G_DEFINE_TYPE (NMKeyfileConnection, nm_keyfile_connection, NM_TYPE_SETTINGS_CONNECTION)
 
-NMKeyfileConnection *
-nm_keyfile_connection_new (NMConnection *source,
-                           const char *full_path,
-                           GError **error)
+static NMKeyfileConnection *
+_connection_new (NMConnection *source,
+                 const char *full_path,
+                 gboolean update_unsaved,
+                 GError **error)
 {
 	GObject *object;
-	NMConnection *tmp;
-	const char *uuid;
-	gboolean update_unsaved = TRUE;
-
-	g_assert (source || full_path);
-
-	/* If we're given a connection already, prefer that instead of re-reading */
-	if (source)
-		tmp = g_object_ref (source);
-	else {
-		tmp = nm_keyfile_plugin_connection_from_file (full_path, error);
-		if (!tmp)
-			return NULL;
-
-		uuid = nm_connection_get_uuid (NM_CONNECTION (tmp));
-		if (!uuid) {
-			g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
-			             "Connection in file %s had no UUID", full_path);
-			g_object_unref (tmp);
-			return NULL;
-		}
-
-		/* If we just read the connection from disk, it's clearly not Unsaved */
-		update_unsaved = FALSE;
-	}
 
 	object = (GObject *) g_object_new (NM_TYPE_KEYFILE_CONNECTION,
 	                                   NM_SETTINGS_CONNECTION_FILENAME, full_path,
@@ -74,7 +50,7 @@ nm_keyfile_connection_new (NMConnection *source,
 
 	/* Update our settings with what was read from the file */
 	if (!nm_settings_connection_replace_settings (NM_SETTINGS_CONNECTION (object),
-	                                              tmp,
+	                                              source,
 	                                              update_unsaved,
 	                                              NULL,
 	                                              error)) {
@@ -82,10 +58,58 @@ nm_keyfile_connection_new (NMConnection *source,
 		object = NULL;
 	}
 
-	g_object_unref (tmp);
 	return (NMKeyfileConnection *) object;
 }
 
+NMKeyfileConnection *
+nm_keyfile_connection_new (NMConnection *source,
+                           const char *full_path,
+                           GError **error)
+{
+	gs_unref_object NMConnection *parsed = NULL;
+
+	g_assert (source || full_path);
+
+	/* If we're given a connection already, prefer that instead of re-reading */
+	if (!source) {
+		parsed = nm_keyfile_plugin_connection_from_file (full_path, error);
+		if (!parsed)
+			return NULL;
+		return nm_keyfile_connection_new_parsed (parsed, full_path, error);
+	}
+
+	return _connection_new (source, full_path, TRUE, error);
+}
+
+/**
+ * nm_keyfile_connection_new_parsed:
+ * @parsed: the connection, as returned by nm_keyfile_plugin_connection_from_file()
+ * @full_path: the file @parsed was read from
+ * @error: location for an error
+ *
+ * Like nm_keyfile_connection_new() without @source, for a file that was
+ * already read and parsed, possibly on another thread.
+ *
+ * Returns: the new connection or %NULL on error.
+ */
+NMKeyfileConnection *
+nm_keyfile_connection_new_parsed (NMConnection *parsed,
+                                  const char *full_path,
+                                  GError **error)
+{
+	g_return_val_if_fail (NM_IS_CONNECTION (parsed), NULL);
+	g_return_val_if_fail (full_path, NULL);
+
+	if (!nm_connection_get_uuid (parsed)) {
+		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		             "Connection in file %s had no UUID", full_path);
+		return NULL;
+	}
+
+	/* If we just read the connection from disk, it's clearly not Unsaved */
+	return _connection_new (parsed, full_path, FALSE, error);
+}
+
 static void
 commit_changes (NMSettingsConnection *connection,
                 NMSettingsConnectionCommitReason commit_reason,
@@ -47,6 +47,10 @@ NMKeyfileConnection *nm_keyfile_connection_new (NMConnection *source,
                                                 const char *filename,
                                                 GError **error);
 
+NMKeyfileConnection *nm_keyfile_connection_new_parsed (NMConnection *parsed,
+                                                       const char *filename,
+                                                       GError **error);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_KEYFILE_CONNECTION_H__ */
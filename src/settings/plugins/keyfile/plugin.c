@@ -37,7 +37,10 @@
 
 #include "plugin.h"
 #include "nm-settings-plugin.h"
+#include "nm-settings-cache.h"
+#include "nm-settings-reload-queue.h"
 #include "nm-keyfile-connection.h"
+#include "reader.h"
 #include "writer.h"
 #include "utils.h"
 
@@ -55,10 +58,22 @@ typedef struct {
 	gboolean initialized;
 	GFileMonitor *monitor;
 	gulong monitor_id;
+	NMSettingsReloadQueue *reload_queue;
 
 	NMConfig *config;
+
+	/* full path -> ParseData, while read_connections() runs */
+	GHashTable *parsed;
 } SettingsPluginKeyfilePrivate;
 
+typedef struct {
+	const char *full_path;
+	struct stat st;
+	gboolean has_st;
+	NMConnection *connection;
+	GError *error;
+} ParseData;
+
 static void
 connection_removed_cb (NMSettingsConnection *obj, gpointer user_data)
 {
@@ -148,6 +163,7 @@ update_connection (SettingsPluginKeyfile *self,
 	SettingsPluginKeyfilePrivate *priv = SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (self);
 	NMKeyfileConnection *connection_new;
 	NMKeyfileConnection *connection_by_uuid;
+	ParseData *parse_data;
 	GError *local = NULL;
 	const char *uuid;
 
@@ -157,7 +173,15 @@ update_connection (SettingsPluginKeyfile *self,
 	if (full_path)
 		nm_log_dbg (LOGD_SETTINGS, "keyfile: loading from file \"%s\"...", full_path);
 
-	connection_new = nm_keyfile_connection_new (source, full_path, &local);
+	if (!source && priv->parsed && (parse_data = g_hash_table_lookup (priv->parsed, full_path))) {
+		if (parse_data->connection)
+			connection_new = nm_keyfile_connection_new_parsed (parse_data->connection, full_path, &local);
+		else {
+			connection_new = NULL;
+			local = g_error_copy (parse_data->error);
+		}
+	} else
+		connection_new = nm_keyfile_connection_new (source, full_path, &local);
 	if (!connection_new) {
 		/* Error; remove the connection */
 		if (source)
@@ -267,6 +291,58 @@ update_connection (SettingsPluginKeyfile *self,
 	}
 }
 
+static void
+reload_paths_cb (const GPtrArray *paths, gpointer user_data)
+{
+	SettingsPluginKeyfile *self = SETTINGS_PLUGIN_KEYFILE (user_data);
+	SettingsPluginKeyfilePrivate *priv = SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *by_path = NULL;
+	GHashTableIter iter;
+	NMKeyfileConnection *connection;
+	guint i;
+
+	/* Look the connections up once per batch instead of scanning all of them
+	 * for every path. Updates may remove or rename connections, so an entry
+	 * is only used while it still belongs to the plugin and the path. */
+	by_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	g_hash_table_iter_init (&iter, priv->connections);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
+		const char *path = nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection));
+
+		if (path)
+			g_hash_table_insert (by_path, g_strdup (path), g_object_ref (connection));
+	}
+
+	for (i = 0; i < paths->len; i++) {
+		const char *full_path = paths->pdata[i];
+		gboolean exists;
+
+		exists = g_file_test (full_path, G_FILE_TEST_EXISTS);
+		connection = g_hash_table_lookup (by_path, full_path);
+		if (   connection
+		    && (   g_hash_table_lookup (priv->connections, nm_connection_get_uuid (NM_CONNECTION (connection))) != connection
+		        || g_strcmp0 (nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection)), full_path) != 0))
+			connection = find_by_path (self, full_path);
+
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: reload %s; file %s", full_path, exists ? "exists" : "does not exist");
+
+		if (exists)
+			update_connection (self, NULL, full_path, connection, TRUE, NULL, NULL);
+		else if (connection)
+			remove_connection (self, connection);
+	}
+}
+
+static gboolean
+reload_path_unsaved_cb (const char *path, gpointer user_data)
+{
+	NMKeyfileConnection *connection;
+
+	connection = find_by_path (SETTINGS_PLUGIN_KEYFILE (user_data), path);
+	return    connection
+	       && nm_settings_connection_get_unsaved (NM_SETTINGS_CONNECTION (connection));
+}
+
 static void
 dir_changed (GFileMonitor *monitor,
              GFile *file,
@@ -274,38 +350,25 @@ dir_changed (GFileMonitor *monitor,
              GFileMonitorEvent event_type,
              gpointer user_data)
 {
-	NMSettingsPlugin *config = NM_SETTINGS_PLUGIN (user_data);
-	SettingsPluginKeyfile *self = SETTINGS_PLUGIN_KEYFILE (config);
-	NMKeyfileConnection *connection;
-	char *full_path;
-	gboolean exists;
+	SettingsPluginKeyfilePrivate *priv = SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (user_data);
+	gs_free char *full_path = NULL;
 
 	full_path = g_file_get_path (file);
-	if (nm_keyfile_plugin_utils_should_ignore_file (full_path)) {
-		g_free (full_path);
+	if (nm_keyfile_plugin_utils_should_ignore_file (full_path))
 		return;
-	}
-	exists = g_file_test (full_path, G_FILE_TEST_EXISTS);
 
-	nm_log_dbg (LOGD_SETTINGS, "dir_changed(%s) = %d; file %s", full_path, event_type, exists ? "exists" : "does not exist");
-
-	connection = find_by_path (self, full_path);
+	nm_log_dbg (LOGD_SETTINGS, "dir_changed(%s) = %d", full_path, event_type);
 
 	switch (event_type) {
 	case G_FILE_MONITOR_EVENT_DELETED:
-		if (!exists && connection)
-			remove_connection (SETTINGS_PLUGIN_KEYFILE (config), connection);
-		break;
 	case G_FILE_MONITOR_EVENT_CREATED:
 	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
-		if (exists)
-			update_connection (SETTINGS_PLUGIN_KEYFILE (config), NULL, full_path, connection, TRUE, NULL, NULL);
+		/* whether the file exists is checked when the batch is applied */
+		nm_settings_reload_queue_add (priv->reload_queue, full_path);
 		break;
 	default:
 		break;
 	}
-
-	g_free (full_path);
 }
 
 static void
@@ -337,6 +400,7 @@ setup_monitoring (NMSettingsPlugin *config)
 		g_object_unref (file);
 
 		if (monitor) {
+			priv->reload_queue = nm_settings_reload_queue_new (reload_paths_cb, reload_path_unsaved_cb, config);
 			priv->monitor_id = g_signal_connect (monitor, "changed", G_CALLBACK (dir_changed), config);
 			priv->monitor = monitor;
 		}
@@ -385,6 +449,103 @@ _sort_paths (const char **f1, const char **f2, GHashTable *paths)
 	return strcmp (*f1, *f2);
 }
 
+/* Each thread parses at least this many files, for fewer starting it
+ * costs more than it saves. As a pool needs two threads to be of any use,
+ * files are only parsed in parallel from 2 * PARSE_FILES_PER_THREAD on. */
+#define PARSE_FILES_PER_THREAD 32
+
+static void
+_parse_data_free (gpointer data)
+{
+	ParseData *parse_data = data;
+
+	g_clear_object (&parse_data->connection);
+	g_clear_error (&parse_data->error);
+	g_slice_free (ParseData, parse_data);
+}
+
+static void
+_parse_file_job (gpointer data, gpointer user_data)
+{
+	ParseData *parse_data = data;
+
+	parse_data->connection = nm_keyfile_plugin_connection_from_file (parse_data->full_path,
+	                                                                 &parse_data->error);
+}
+
+/* Looks the files up in the connection cache and reads, parses and
+ * normalizes the remaining ones, on a thread pool if there are many.
+ * The results are plain NMSimpleConnection objects; turning them into
+ * settings connections and claiming them stays on the main thread.
+ * Afterwards the cache is rewritten to hold exactly these files. */
+static GHashTable *
+_parse_files (GPtrArray *filenames)
+{
+	NMSettingsCache *cache;
+	GHashTable *parsed;
+	GPtrArray *pending;
+	GThreadPool *pool = NULL;
+	GError *error = NULL;
+	guint i, n_threads;
+	long n_cpus;
+
+	cache = nm_settings_cache_open ("keyfile");
+
+	parsed = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, _parse_data_free);
+	pending = g_ptr_array_new ();
+	for (i = 0; i < filenames->len; i++) {
+		ParseData *parse_data;
+
+		parse_data = g_slice_new0 (ParseData);
+		parse_data->full_path = filenames->pdata[i];
+		g_hash_table_insert (parsed, (gpointer) parse_data->full_path, parse_data);
+
+		/* stat() before reading, so that a concurrent change of the
+		 * file at worst causes a cache miss on the next load. */
+		if (stat (parse_data->full_path, &parse_data->st) == 0) {
+			parse_data->has_st = TRUE;
+			parse_data->connection = nm_settings_cache_lookup (cache, parse_data->full_path, &parse_data->st);
+		}
+		if (!parse_data->connection)
+			g_ptr_array_add (pending, parse_data);
+	}
+
+	n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	n_threads = MIN (n_cpus > 0 ? (guint) n_cpus : 1u, pending->len / PARSE_FILES_PER_THREAD);
+	if (n_threads >= 2)
+		pool = g_thread_pool_new (_parse_file_job, NULL, n_threads, TRUE, NULL);
+
+	if (pool) {
+		for (i = 0; i < pending->len; i++)
+			g_thread_pool_push (pool, pending->pdata[i], NULL);
+
+		/* waits for all queued files */
+		g_thread_pool_free (pool, FALSE, TRUE);
+	} else {
+		for (i = 0; i < pending->len; i++)
+			_parse_file_job (pending->pdata[i], NULL);
+		n_threads = 1;
+	}
+
+	for (i = 0; i < pending->len; i++) {
+		ParseData *parse_data = pending->pdata[i];
+
+		if (parse_data->connection && parse_data->has_st)
+			nm_settings_cache_add (cache, parse_data->full_path, &parse_data->st, parse_data->connection);
+	}
+
+	if (!nm_settings_cache_write (cache, &error)) {
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: cannot write connection cache: %s", error->message);
+		g_clear_error (&error);
+	}
+	nm_settings_cache_free (cache);
+
+	nm_log_dbg (LOGD_SETTINGS, "keyfile: loaded %u files, parsed %u on %u threads",
+	            filenames->len, pending->len, n_threads);
+	g_ptr_array_free (pending, TRUE);
+	return parsed;
+}
+
 static void
 read_connections (NMSettingsPlugin *config)
 {
@@ -430,11 +591,14 @@ read_connections (NMSettingsPlugin *config)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	priv->parsed = _parse_files (filenames);
+
 	for (i = 0; i < filenames->len; i++) {
 		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
 	}
+	g_clear_pointer (&priv->parsed, g_hash_table_unref);
 	g_ptr_array_free (filenames, TRUE);
 
 	g_hash_table_iter_init (&iter, priv->connections);
@@ -591,6 +755,7 @@ dispose (GObject *object)
 		g_file_monitor_cancel (priv->monitor);
 		g_clear_object (&priv->monitor);
 	}
+	g_clear_pointer (&priv->reload_queue, nm_settings_reload_queue_free);
 
 	if (priv->connections) {
 		g_hash_table_destroy (priv->connections);
@@ -88,7 +88,7 @@ _handler_read (GKeyFile *keyfile,
 NMConnection *
 nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
 {
-	GKeyFile *key_file;
+	GMappedFile *mapped;
 	struct stat statbuf;
 	NMConnection *connection = NULL;
 	GError *verify_error = NULL;
@@ -115,13 +115,16 @@ nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
 		}
 	}
 
-	key_file = g_key_file_new ();
-	if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, error))
-		goto out;
+	mapped = g_mapped_file_new (filename, FALSE, error);
+	if (!mapped)
+		return NULL;
 
-	connection = nm_keyfile_read (key_file, filename, NULL, _handler_read, NULL, error);
+	connection = nm_keyfile_read_data (g_mapped_file_get_contents (mapped),
+	                                   g_mapped_file_get_length (mapped),
+	                                   filename, NULL, _handler_read, NULL, error);
+	g_mapped_file_unref (mapped);
 	if (!connection)
-		goto out;
+		return NULL;
 
 	/* Normalize and verify the connection */
 	if (!nm_connection_normalize (connection, NULL, NULL, &verify_error)) {
@@ -133,8 +136,6 @@ nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
 		connection = NULL;
 	}
 
-out:
-	g_key_file_free (key_file);
 	return connection;
 }
 
@@ -0,0 +1,239 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager keyfile plugin benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Writes a directory of generated connection profiles with the keyfile
+ * writer and reads them back with the reader.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "nm-core-internal.h"
+#include "nm-keyfile-internal.h"
+
+#include "reader.h"
+#include "writer.h"
+
+#include "nm-test-utils-core.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int files;
+	int addresses;
+} global_opt = {
+	.files = 10000,
+	.addresses = 4,
+};
+
+static char **filenames;
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "files", 'n', 0, G_OPTION_ARG_INT, &global_opt.files, "Number of connection profiles to write and read", "N" },
+		{ "addresses", 'm', 0, G_OPTION_ARG_INT, &global_opt.addresses, "Number of IPv4 addresses per profile", "M" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark the keyfile writer and reader on generated profiles.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.files <= 0
+	    || global_opt.files > 0x1000000
+	    || global_opt.addresses < 0
+	    || global_opt.addresses > 256) {
+		g_warning ("Invalid arguments: files must be positive and at most 256 addresses");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static NMConnection *
+create_connection (int n)
+{
+	NMConnection *connection;
+	NMSettingWired *s_wired;
+	NMSettingIPConfig *s_ip4;
+	NMSettingIPConfig *s_ip6;
+	char id[32], mac[32];
+	int j;
+
+	nm_sprintf_buf (id, "bench%d", n);
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+
+	s_wired = nm_connection_get_setting_wired (connection);
+	nm_sprintf_buf (mac, "02:00:00:%02x:%02x:%02x", (n >> 16) & 0xFF, (n >> 8) & 0xFF, n & 0xFF);
+	g_object_set (s_wired,
+	              NM_SETTING_WIRED_MAC_ADDRESS, mac,
+	              NM_SETTING_WIRED_MTU, 1400,
+	              NULL);
+
+	s_ip4 = (NMSettingIPConfig *) nm_setting_ip4_config_new ();
+	g_object_set (s_ip4,
+	              NM_SETTING_IP_CONFIG_METHOD,
+	              global_opt.addresses
+	                  ? NM_SETTING_IP4_CONFIG_METHOD_MANUAL
+	                  : NM_SETTING_IP4_CONFIG_METHOD_AUTO,
+	              NULL);
+	for (j = 0; j < global_opt.addresses; j++) {
+		char addr[NM_UTILS_INET_ADDRSTRLEN];
+		NMIPAddress *address;
+
+		nm_sprintf_buf (addr, "100.%d.%d.%d", 64 + (j & 0x3F), (n >> 8) & 0xFF, n & 0xFF);
+		address = nm_ip_address_new (AF_INET, addr, 24, NULL);
+		g_assert (address);
+		nm_setting_ip_config_add_address (s_ip4, address);
+		nm_ip_address_unref (address);
+	}
+	nm_setting_ip_config_add_dns (s_ip4, "192.168.0.1");
+	nm_setting_ip_config_add_dns_search (s_ip4, "example.com");
+	nm_connection_add_setting (connection, NM_SETTING (s_ip4));
+
+	s_ip6 = (NMSettingIPConfig *) nm_setting_ip6_config_new ();
+	g_object_set (s_ip6,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_AUTO,
+	              NULL);
+	nm_connection_add_setting (connection, NM_SETTING (s_ip6));
+
+	nmtst_assert_connection_verifies_without_normalization (connection);
+	return connection;
+}
+
+static void
+bench_write (const char *dir, NMConnection **connections)
+{
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, "write");
+	for (i = 0; i < global_opt.files; i++) {
+		GError *error = NULL;
+
+		if (!nm_keyfile_plugin_write_test_connection (connections[i], dir,
+		                                              geteuid (), getegid (),
+		                                              &filenames[i], &error))
+			g_assert_no_error (error);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+static void
+bench_read (NMConnection **connections)
+{
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, "read");
+	for (i = 0; i < global_opt.files; i++) {
+		gs_unref_object NMConnection *connection = NULL;
+		GError *error = NULL;
+
+		connection = nm_keyfile_plugin_connection_from_file (filenames[i], &error);
+		g_assert_no_error (error);
+		g_assert (connection);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	/* check outside of the timed loop that the profiles survived */
+	for (i = 0; i < global_opt.files; i++) {
+		gs_unref_object NMConnection *connection = NULL;
+
+		connection = nm_keyfile_plugin_connection_from_file (filenames[i], NULL);
+		g_assert (nm_connection_compare (connection, connections[i], NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+}
+
+/* the reader before nm_keyfile_read_data(), for comparison */
+static void
+bench_read_gkeyfile (void)
+{
+	NMBenchTimer timer;
+	int i;
+
+	nm_bench_timer_start (&timer, "read-gkeyfile");
+	for (i = 0; i < global_opt.files; i++) {
+		gs_unref_keyfile GKeyFile *keyfile = NULL;
+		gs_unref_object NMConnection *connection = NULL;
+		GError *error = NULL;
+
+		keyfile = g_key_file_new ();
+		if (!g_key_file_load_from_file (keyfile, filenames[i], G_KEY_FILE_NONE, &error))
+			g_assert_no_error (error);
+		connection = nm_keyfile_read (keyfile, filenames[i], NULL, NULL, NULL, &error);
+		g_assert_no_error (error);
+		if (!nm_connection_normalize (connection, NULL, NULL, &error))
+			g_assert_no_error (error);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	gs_free char *dir = NULL;
+	NMConnection **connections;
+	int i;
+
+	nmtst_init_with_logging (&argc, &argv, "ERR", "ALL");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	dir = g_strdup (TEST_SCRATCH_DIR "/bench-keyfile-XXXXXX");
+	g_assert (g_mkdtemp (dir));
+
+	filenames = g_new0 (char *, global_opt.files + 1);
+	connections = g_new0 (NMConnection *, global_opt.files);
+	for (i = 0; i < global_opt.files; i++)
+		connections[i] = create_connection (i);
+
+	g_print ("# files=%d addresses=%d\n", global_opt.files, global_opt.addresses);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	bench_write (dir, connections);
+	bench_read (connections);
+	bench_read_gkeyfile ();
+
+	for (i = 0; i < global_opt.files; i++) {
+		unlink (filenames[i]);
+		g_object_unref (connections[i]);
+	}
+	rmdir (dir);
+	g_strfreev (filenames);
+	g_free (connections);
+
+	return EXIT_SUCCESS;
+}
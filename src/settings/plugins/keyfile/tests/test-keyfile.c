@@ -27,12 +27,14 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 
 #include "nm-core-internal.h"
 
 #include "reader.h"
 #include "writer.h"
 #include "utils.h"
+#include "nm-settings-writer.h"
 
 #include "nm-test-utils-core.h"
 
@@ -2966,6 +2968,41 @@ _escape_filename (const char *filename, gboolean would_be_ignored)
 		g_error ("Escaping filename \"%s\" yielded \"%s\", but this is ignored", filename, esc);
 }
 
+static void
+test_write_file_unchanged (void)
+{
+	gs_free char *path = NULL;
+	gs_free char *contents = NULL;
+	GError *error = NULL;
+	gboolean unchanged;
+	struct stat st1, st2;
+
+	path = g_build_filename (TEST_SCRATCH_DIR, "Test Write File Unchanged", NULL);
+
+	g_assert (nm_settings_write_file (path, "a=1\n", 4, &unchanged, &error));
+	g_assert_no_error (error);
+	g_assert (!unchanged);
+	g_assert (stat (path, &st1) == 0);
+
+	/* the same content again is not written, the file is not replaced */
+	g_assert (nm_settings_write_file (path, "a=1\n", 4, &unchanged, &error));
+	g_assert_no_error (error);
+	g_assert (unchanged);
+	g_assert (stat (path, &st2) == 0);
+	g_assert_cmpint (st1.st_ino, ==, st2.st_ino);
+
+	/* modified by somebody else, with the same size */
+	g_assert (g_file_set_contents (path, "a=2\n", 4, NULL));
+	g_assert (nm_settings_write_file (path, "a=1\n", 4, &unchanged, &error));
+	g_assert_no_error (error);
+	g_assert (!unchanged);
+	g_assert (g_file_get_contents (path, &contents, NULL, NULL));
+	g_assert_cmpstr (contents, ==, "a=1\n");
+
+	nm_settings_write_sync ();
+	unlink (path);
+}
+
 static void
 test_nm_keyfile_plugin_utils_escape_filename (void)
 {
@@ -3064,6 +3101,8 @@ int main (int argc, char **argv)
 	g_test_add_func ("/keyfile/test_read_flags_property", test_read_flags_property);
 	g_test_add_func ("/keyfile/test_write_flags_property", test_write_flags_property);
 
+	g_test_add_func ("/keyfile/test_write_file_unchanged", test_write_file_unchanged);
+
 	g_test_add_func ("/keyfile/test_nm_keyfile_plugin_utils_escape_filename", test_nm_keyfile_plugin_utils_escape_filename);
 
 	return g_test_run ();
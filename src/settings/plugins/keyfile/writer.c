@@ -30,6 +30,7 @@
 #include "writer.h"
 #include "utils.h"
 #include "nm-keyfile-internal.h"
+#include "nm-settings-writer.h"
 
 typedef struct {
 	const char *keyfile_dir;
@@ -235,6 +236,7 @@ _internal_write_connection (NMConnection *connection,
 	GError *local_err = NULL;
 	int errsv;
 	gboolean success = FALSE;
+	gboolean unchanged;
 	mode_t saved_umask;
 
 	g_return_val_if_fail (!out_path || !*out_path, FALSE);
@@ -321,14 +323,15 @@ _internal_write_connection (NMConnection *connection,
 
 	saved_umask = umask (S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
 
-	g_file_set_contents (path, data, len, &local_err);
-	if (local_err) {
+	if (!nm_settings_write_file (path, data, len, &unchanged, &local_err)) {
 		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_FAILED,
 		             "error writing to file '%s': %s",
 		             path, local_err->message);
 		g_error_free (local_err);
 		goto out;
 	}
+	if (unchanged)
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: %s: content unchanged, not written", path);
 
 	if (chown (path, owner_uid, owner_grp) < 0) {
 		errsv = errno;
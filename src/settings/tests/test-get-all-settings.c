@@ -0,0 +1,196 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <pwd.h>
+
+#include "nm-settings.h"
+#include "nm-auth-subject.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static NMAuthSubject *
+_subject_new (gulong uid)
+{
+	return g_object_new (NM_TYPE_AUTH_SUBJECT,
+	                     NM_AUTH_SUBJECT_SUBJECT_TYPE, NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS,
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_DBUS_SENDER, ":1.42",
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_PID, (gulong) getpid (),
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_UID, uid,
+	                     NULL);
+}
+
+/* A user other than root, whose name the ACLs can refer to. */
+static gboolean
+_get_user (uid_t *out_uid, const char **out_name)
+{
+	struct passwd *pw;
+
+	pw = getpwuid (getuid ());
+	if (!pw || pw->pw_uid == 0)
+		pw = getpwnam ("nobody");
+	if (!pw || pw->pw_uid == 0)
+		return FALSE;
+
+	*out_uid = pw->pw_uid;
+	*out_name = pw->pw_name;
+	return TRUE;
+}
+
+static void
+_add_connection (GPtrArray *connections, guint num, const char *type, const char *user)
+{
+	gs_free char *id = g_strdup_printf ("con-%u", num);
+	gs_free char *path = g_strdup_printf (NM_DBUS_PATH_SETTINGS "/%u", num);
+	NMSettingConnection *s_con;
+	NMConnection *connection;
+
+	connection = nmtst_create_minimal_connection (id, NULL, type, &s_con);
+	nm_connection_set_path (connection, path);
+	if (user)
+		g_assert (nm_setting_connection_add_permission (s_con, "user", user, NULL));
+	g_ptr_array_add (connections, connection);
+}
+
+static GPtrArray *
+_connections_new (const char *user)
+{
+	GPtrArray *connections;
+
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	_add_connection (connections, 10, NM_SETTING_WIRED_SETTING_NAME, "nm-test-nonexistent-user");
+	_add_connection (connections, 3, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	_add_connection (connections, 1, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	_add_connection (connections, 2, NM_SETTING_WIRELESS_SETTING_NAME, user);
+	return connections;
+}
+
+/* Runs the filter on a copy of @connections and returns the numbers of
+ * the remaining connections, like "1 2 3". */
+static char *
+_filter (GPtrArray *connections,
+         const char *filter_type,
+         NMAuthSubject *subject,
+         guint32 offset,
+         guint32 limit,
+         guint expected_matches)
+{
+	gs_unref_ptrarray GPtrArray *matches = NULL;
+	GString *str;
+	guint i;
+
+	matches = g_ptr_array_new ();
+	for (i = 0; i < connections->len; i++)
+		g_ptr_array_add (matches, connections->pdata[i]);
+
+	g_assert_cmpuint (_nm_settings_get_all_settings_filter (matches, filter_type, subject, offset, limit),
+	                  ==,
+	                  expected_matches);
+
+	str = g_string_new (NULL);
+	for (i = 0; i < matches->len; i++) {
+		const char *path = nm_connection_get_path (matches->pdata[i]);
+
+		g_string_append_printf (str, "%s%s", i ? " " : "", strrchr (path, '/') + 1);
+	}
+	return g_string_free (str, FALSE);
+}
+
+#define _assert_filter(connections, filter_type, subject, offset, limit, expected_matches, expected) \
+	G_STMT_START { \
+		gs_free char *_result = _filter ((connections), (filter_type), (subject), (offset), (limit), (expected_matches)); \
+		\
+		g_assert_cmpstr (_result, ==, (expected)); \
+	} G_STMT_END
+
+/*****************************************************************************/
+
+static void
+test_permissions (void)
+{
+	gs_unref_ptrarray GPtrArray *connections = NULL;
+	gs_unref_object NMAuthSubject *root = _subject_new (0);
+	gs_unref_object NMAuthSubject *internal = nm_auth_subject_new_internal ();
+	gs_unref_object NMAuthSubject *user = NULL;
+	const char *user_name;
+	uid_t uid;
+
+	if (!_get_user (&uid, &user_name)) {
+		g_test_skip ("no unprivileged user");
+		return;
+	}
+	user = _subject_new (uid);
+	connections = _connections_new (user_name);
+
+	/* sorted by the number of the path, not the string */
+	_assert_filter (connections, NULL, root, 0, 0, 4, "1 2 3 10");
+	_assert_filter (connections, NULL, internal, 0, 0, 4, "1 2 3 10");
+
+	/* hidden like GetSettings() refuses it */
+	_assert_filter (connections, NULL, user, 0, 0, 3, "1 2 3");
+
+	_assert_filter (connections, NM_SETTING_WIRED_SETTING_NAME, user, 0, 0, 2, "1 3");
+	_assert_filter (connections, NM_SETTING_WIRED_SETTING_NAME, root, 0, 0, 3, "1 3 10");
+	_assert_filter (connections, NM_SETTING_VPN_SETTING_NAME, root, 0, 0, 0, "");
+}
+
+static void
+test_paging (void)
+{
+	gs_unref_ptrarray GPtrArray *connections = NULL;
+	gs_unref_object NMAuthSubject *user = NULL;
+	const char *user_name;
+	uid_t uid;
+
+	if (!_get_user (&uid, &user_name)) {
+		g_test_skip ("no unprivileged user");
+		return;
+	}
+	user = _subject_new (uid);
+	connections = _connections_new (user_name);
+
+	/* pages are taken from the visible connections; the total is
+	 * the number of all of them */
+	_assert_filter (connections, NULL, user, 0, 2, 3, "1 2");
+	_assert_filter (connections, NULL, user, 2, 2, 3, "3");
+	_assert_filter (connections, NULL, user, 1, 0, 3, "2 3");
+	_assert_filter (connections, NULL, user, 3, 2, 3, "");
+	_assert_filter (connections, NULL, user, 10, 0, 3, "");
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/settings/get-all-settings/permissions", test_permissions);
+	g_test_add_func ("/settings/get-all-settings/paging", test_paging);
+
+	return g_test_run ();
+}
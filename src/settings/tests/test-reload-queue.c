@@ -0,0 +1,260 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "nm-settings-reload-queue.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+typedef struct {
+	char *dir;
+	NMSettingsReloadQueue *queue;
+
+	/* the paths of all batches, relative to @dir; batches are
+	 * separated by "|" */
+	GString *batches;
+	guint num_batches;
+
+	/* the paths whose connection has unsaved changes */
+	GHashTable *unsaved;
+	guint num_unsaved_calls;
+
+	GMainLoop *loop;
+} TestData;
+
+static void
+_reload_cb (const GPtrArray *paths, gpointer user_data)
+{
+	TestData *data = user_data;
+	guint i;
+
+	g_assert_cmpuint (paths->len, >, 0);
+	if (data->num_batches++)
+		g_string_append_c (data->batches, '|');
+	for (i = 0; i < paths->len; i++) {
+		const char *path = paths->pdata[i];
+
+		g_assert (g_str_has_prefix (path, data->dir));
+		g_string_append_printf (data->batches, "%s%s", i ? " " : "", path + strlen (data->dir) + 1);
+	}
+
+	if (data->loop)
+		g_main_loop_quit (data->loop);
+}
+
+static gboolean
+_unsaved_cb (const char *path, gpointer user_data)
+{
+	TestData *data = user_data;
+
+	data->num_unsaved_calls++;
+	return g_hash_table_contains (data->unsaved, path + strlen (data->dir) + 1);
+}
+
+static char *
+_path (TestData *data, const char *name)
+{
+	return g_build_filename (data->dir, name, NULL);
+}
+
+static void
+_write (TestData *data, const char *name, const char *content)
+{
+	gs_free char *path = _path (data, name);
+	GError *error = NULL;
+
+	g_file_set_contents (path, content, -1, &error);
+	g_assert_no_error (error);
+}
+
+static void
+_delete (TestData *data, const char *name)
+{
+	gs_free char *path = _path (data, name);
+
+	g_assert_cmpint (unlink (path), ==, 0);
+}
+
+static void
+_add (TestData *data, const char *name)
+{
+	gs_free char *path = _path (data, name);
+
+	nm_settings_reload_queue_add (data->queue, path);
+}
+
+static void
+_setup (TestData *data, gboolean with_unsaved)
+{
+	memset (data, 0, sizeof (*data));
+	data->dir = g_strdup ("/tmp/test-reload-queue-XXXXXX");
+	g_assert (g_mkdtemp (data->dir));
+	data->batches = g_string_new (NULL);
+	data->unsaved = g_hash_table_new (g_str_hash, g_str_equal);
+	data->queue = nm_settings_reload_queue_new (_reload_cb,
+	                                            with_unsaved ? _unsaved_cb : NULL,
+	                                            data);
+}
+
+static void
+_teardown (TestData *data)
+{
+	const char *name;
+	GDir *dir;
+
+	nm_settings_reload_queue_free (data->queue);
+
+	dir = g_dir_open (data->dir, 0, NULL);
+	g_assert (dir);
+	while ((name = g_dir_read_name (dir)))
+		_delete (data, name);
+	g_dir_close (dir);
+	g_assert_cmpint (rmdir (data->dir), ==, 0);
+
+	g_hash_table_unref (data->unsaved);
+	g_string_free (data->batches, TRUE);
+	g_clear_pointer (&data->loop, g_main_loop_unref);
+	g_free (data->dir);
+}
+
+/*****************************************************************************/
+
+static void
+test_batch (void)
+{
+	TestData data;
+
+	_setup (&data, FALSE);
+
+	_write (&data, "a", "1");
+	_write (&data, "b", "1");
+
+	/* every path once, in the order it was first queued */
+	_add (&data, "b");
+	_add (&data, "a");
+	_add (&data, "b");
+	_add (&data, "deleted");
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	if (!nmtst_main_loop_run (data.loop, NM_SETTINGS_RELOAD_QUEUE_DELAY_MS * 10))
+		g_assert_not_reached ();
+	g_assert_cmpstr (data.batches->str, ==, "b a deleted");
+
+	/* nothing left */
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpuint (data.num_batches, ==, 1);
+
+	_teardown (&data);
+}
+
+static void
+test_unchanged (void)
+{
+	TestData data;
+
+	_setup (&data, FALSE);
+
+	/* the first change is always passed on */
+	_write (&data, "a", "1");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpstr (data.batches->str, ==, "a");
+
+	/* a rewrite with the same content is dropped */
+	_write (&data, "a", "1");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpuint (data.num_batches, ==, 1);
+
+	_write (&data, "a", "2");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpstr (data.batches->str, ==, "a|a");
+
+	/* deleting and recreating it with the same content is a change */
+	_delete (&data, "a");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	_write (&data, "a", "2");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpstr (data.batches->str, ==, "a|a|a|a");
+
+	_teardown (&data);
+}
+
+static void
+test_unsaved (void)
+{
+	TestData data;
+
+	_setup (&data, TRUE);
+
+	_write (&data, "a", "1");
+	_write (&data, "b", "1");
+	_add (&data, "a");
+	_add (&data, "b");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpstr (data.batches->str, ==, "a b");
+
+	/* only asked for files whose content did not change */
+	g_assert_cmpuint (data.num_unsaved_calls, ==, 0);
+
+	/* the connection of "a" was modified in memory; rewriting the same
+	 * file reverts it, like "nmcli connection reload" */
+	g_hash_table_add (data.unsaved, "a");
+	_write (&data, "a", "1");
+	_write (&data, "b", "1");
+	_add (&data, "a");
+	_add (&data, "b");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpstr (data.batches->str, ==, "a b|a");
+	g_assert_cmpuint (data.num_unsaved_calls, ==, 2);
+
+	/* reverted */
+	g_hash_table_remove (data.unsaved, "a");
+	_add (&data, "a");
+	nm_settings_reload_queue_flush (data.queue);
+	g_assert_cmpuint (data.num_batches, ==, 2);
+
+	_teardown (&data);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/settings/reload-queue/batch", test_batch);
+	g_test_add_func ("/settings/reload-queue/unchanged", test_unchanged);
+	g_test_add_func ("/settings/reload-queue/unsaved", test_unsaved);
+
+	return g_test_run ();
+}
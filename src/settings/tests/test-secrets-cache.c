@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <unistd.h>
+
+#include "nm-secrets-cache.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static NMAuthSubject *
+_subject_new (gulong uid)
+{
+	return g_object_new (NM_TYPE_AUTH_SUBJECT,
+	                     NM_AUTH_SUBJECT_SUBJECT_TYPE, NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS,
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_DBUS_SENDER, ":1.42",
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_PID, (gulong) getpid (),
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_UID, uid,
+	                     NULL);
+}
+
+static GVariant *
+_secrets_new (const char *psk)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&builder, "{sv}", "psk", g_variant_new_string (psk));
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+_assert_psk (const NMSecretsCacheEntry *entry, const char *psk)
+{
+	const char *value = NULL;
+
+	g_assert (entry);
+	g_assert (g_variant_lookup (entry->secrets, "psk", "&s", &value));
+	g_assert_cmpstr (value, ==, psk);
+}
+
+/*****************************************************************************/
+
+static void
+test_per_requester (void)
+{
+	gs_unref_object NMAuthSubject *user_a = _subject_new (1000);
+	gs_unref_object NMAuthSubject *user_a2 = _subject_new (1000);
+	gs_unref_object NMAuthSubject *user_b = _subject_new (1001);
+	gs_unref_object NMAuthSubject *internal = nm_auth_subject_new_internal ();
+	gs_unref_variant GVariant *secrets_a = _secrets_new ("secret-a");
+	gs_unref_variant GVariant *secrets_b = _secrets_new ("secret-b");
+	NMSecretsCache *cache;
+
+	cache = nm_secrets_cache_new ();
+
+	nm_secrets_cache_set (cache, user_a, "802-11-wireless-security", ":1.10", "a", secrets_a, 100);
+
+	/* the secrets of user A's agent are only returned to user A */
+	_assert_psk (nm_secrets_cache_lookup (cache, user_a, "802-11-wireless-security", 10), "secret-a");
+	_assert_psk (nm_secrets_cache_lookup (cache, user_a2, "802-11-wireless-security", 10), "secret-a");
+	g_assert (!nm_secrets_cache_lookup (cache, user_b, "802-11-wireless-security", 10));
+	g_assert (!nm_secrets_cache_lookup (cache, internal, "802-11-wireless-security", 10));
+	g_assert (!nm_secrets_cache_lookup (cache, user_a, "802-1x", 10));
+
+	nm_secrets_cache_set (cache, user_b, "802-11-wireless-security", ":1.11", "b", secrets_b, 100);
+	_assert_psk (nm_secrets_cache_lookup (cache, user_a, "802-11-wireless-security", 10), "secret-a");
+	_assert_psk (nm_secrets_cache_lookup (cache, user_b, "802-11-wireless-security", 10), "secret-b");
+	g_assert_cmpstr (nm_secrets_cache_lookup (cache, user_b, "802-11-wireless-security", 10)->agent_dbus_owner, ==, ":1.11");
+
+	/* new secrets for the same requester replace the old ones */
+	nm_secrets_cache_set (cache, user_a, "802-11-wireless-security", ":1.12", "a", secrets_b, 100);
+	_assert_psk (nm_secrets_cache_lookup (cache, user_a, "802-11-wireless-security", 10), "secret-b");
+	g_assert_cmpstr (nm_secrets_cache_lookup (cache, user_a, "802-11-wireless-security", 10)->agent_dbus_owner, ==, ":1.12");
+
+	g_assert_cmpint (nm_secrets_cache_clear (cache), ==, 2);
+	g_assert (!nm_secrets_cache_lookup (cache, user_a, "802-11-wireless-security", 10));
+
+	nm_secrets_cache_free (cache);
+}
+
+static void
+test_remove_agent (void)
+{
+	gs_unref_object NMAuthSubject *user_a = _subject_new (1000);
+	gs_unref_object NMAuthSubject *user_b = _subject_new (1001);
+	gs_unref_variant GVariant *secrets = _secrets_new ("secret");
+	NMSecretsCache *cache;
+
+	cache = nm_secrets_cache_new ();
+
+	nm_secrets_cache_set (cache, user_a, "vpn", ":1.10", "a", secrets, 100);
+	nm_secrets_cache_set (cache, user_a, "802-1x", ":1.10", "a", secrets, 100);
+	nm_secrets_cache_set (cache, user_b, "vpn", ":1.11", "b", secrets, 100);
+
+	/* the agent of user A unregisters */
+	g_assert_cmpint (nm_secrets_cache_remove_agent (cache, ":1.10"), ==, 2);
+	g_assert (!nm_secrets_cache_lookup (cache, user_a, "vpn", 10));
+	g_assert (!nm_secrets_cache_lookup (cache, user_a, "802-1x", 10));
+	_assert_psk (nm_secrets_cache_lookup (cache, user_b, "vpn", 10), "secret");
+
+	g_assert_cmpint (nm_secrets_cache_remove_agent (cache, ":1.10"), ==, 0);
+
+	nm_secrets_cache_free (cache);
+}
+
+static void
+test_expiry (void)
+{
+	gs_unref_object NMAuthSubject *internal = nm_auth_subject_new_internal ();
+	gs_unref_variant GVariant *secrets = _secrets_new ("secret");
+	NMSecretsCache *cache;
+
+	cache = nm_secrets_cache_new ();
+
+	nm_secrets_cache_set (cache, internal, "vpn", ":1.10", "a", secrets, 100);
+	_assert_psk (nm_secrets_cache_lookup (cache, internal, "vpn", 99), "secret");
+
+	/* an expired entry is removed on lookup */
+	g_assert (!nm_secrets_cache_lookup (cache, internal, "vpn", 100));
+	g_assert_cmpint (nm_secrets_cache_clear (cache), ==, 0);
+
+	nm_secrets_cache_free (cache);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/secrets-cache/per-requester", test_per_requester);
+	g_test_add_func ("/secrets-cache/remove-agent", test_remove_agent);
+	g_test_add_func ("/secrets-cache/expiry", test_expiry);
+
+	return g_test_run ();
+}
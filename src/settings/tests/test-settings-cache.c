@@ -0,0 +1,210 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "nm-settings-cache.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static char *
+_cache_filename (void)
+{
+	char *filename;
+	int fd;
+
+	filename = g_strdup ("/tmp/test-settings-cache-XXXXXX");
+	fd = g_mkstemp (filename);
+	g_assert (fd >= 0);
+	close (fd);
+	g_assert_cmpint (unlink (filename), ==, 0);
+	return filename;
+}
+
+static NMConnection *
+_connection_new (const char *id)
+{
+	NMConnection *connection;
+	GError *error = NULL;
+
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	nm_connection_normalize (connection, NULL, NULL, &error);
+	g_assert_no_error (error);
+	return connection;
+}
+
+static void
+_stat_init (struct stat *st, guint64 ino)
+{
+	memset (st, 0, sizeof (*st));
+	st->st_ino = ino;
+	st->st_size = 100 + ino;
+	st->st_mtim.tv_sec = 1000;
+	st->st_mtim.tv_nsec = 1;
+	st->st_ctim.tv_sec = 1000;
+	st->st_ctim.tv_nsec = 2;
+}
+
+/* Writes a cache holding @connection for "/a" and reopens it. */
+static NMSettingsCache *
+_cache_with_entry (const char *filename, NMConnection *connection, const struct stat *st)
+{
+	NMSettingsCache *cache;
+	GError *error = NULL;
+
+	cache = _nm_settings_cache_open_file (filename);
+	nm_settings_cache_add (cache, "/a", st, connection);
+	nm_settings_cache_write (cache, &error);
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	return _nm_settings_cache_open_file (filename);
+}
+
+/*****************************************************************************/
+
+static void
+test_hit (void)
+{
+	gs_free char *filename = _cache_filename ();
+	gs_unref_object NMConnection *connection = _connection_new ("con-a");
+	gs_unref_object NMConnection *cached = NULL;
+	NMSettingsCache *cache;
+	struct stat st;
+
+	_stat_init (&st, 1);
+
+	/* no cache file yet */
+	cache = _nm_settings_cache_open_file (filename);
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st));
+	nm_settings_cache_free (cache);
+
+	cache = _cache_with_entry (filename, connection, &st);
+	cached = nm_settings_cache_lookup (cache, "/a", &st);
+	g_assert (NM_IS_CONNECTION (cached));
+	nmtst_assert_connection_equals (cached, FALSE, connection, FALSE);
+
+	g_assert (!nm_settings_cache_lookup (cache, "/b", &st));
+	nm_settings_cache_free (cache);
+
+	unlink (filename);
+}
+
+static void
+test_invalidate (void)
+{
+	gs_free char *filename = _cache_filename ();
+	gs_unref_object NMConnection *connection = _connection_new ("con-a");
+	NMSettingsCache *cache;
+	struct stat st, st2;
+
+	_stat_init (&st, 1);
+	cache = _cache_with_entry (filename, connection, &st);
+
+	/* any change of the file misses */
+	st2 = st;
+	st2.st_mtim.tv_nsec++;
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st2));
+
+	st2 = st;
+	st2.st_ctim.tv_sec++;
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st2));
+
+	st2 = st;
+	st2.st_ino++;
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st2));
+
+	st2 = st;
+	st2.st_size--;
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st2));
+
+	nm_settings_cache_free (cache);
+
+	/* a damaged cache file is ignored */
+	g_assert (g_file_set_contents (filename, "not a cache", -1, NULL));
+	cache = _nm_settings_cache_open_file (filename);
+	g_assert (!nm_settings_cache_lookup (cache, "/a", &st));
+	nm_settings_cache_free (cache);
+
+	unlink (filename);
+}
+
+static void
+test_delete (void)
+{
+	gs_free char *filename = _cache_filename ();
+	gs_unref_object NMConnection *con_a = _connection_new ("con-a");
+	gs_unref_object NMConnection *con_b = _connection_new ("con-b");
+	NMConnection *cached;
+	NMSettingsCache *cache;
+	struct stat st_a, st_b;
+	GError *error = NULL;
+
+	_stat_init (&st_a, 1);
+	_stat_init (&st_b, 2);
+
+	cache = _nm_settings_cache_open_file (filename);
+	nm_settings_cache_add (cache, "/a", &st_a, con_a);
+	nm_settings_cache_add (cache, "/b", &st_b, con_b);
+	nm_settings_cache_write (cache, &error);
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	/* "/b" was deleted: it is not looked up again, and the next cache
+	 * drops it. The entry of "/a" is kept by the hit. */
+	cache = _nm_settings_cache_open_file (filename);
+	cached = nm_settings_cache_lookup (cache, "/a", &st_a);
+	g_assert (cached);
+	g_object_unref (cached);
+	nm_settings_cache_write (cache, &error);
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	cache = _nm_settings_cache_open_file (filename);
+	g_assert (!nm_settings_cache_lookup (cache, "/b", &st_b));
+	cached = nm_settings_cache_lookup (cache, "/a", &st_a);
+	g_assert (cached);
+	nmtst_assert_connection_equals (cached, FALSE, con_a, FALSE);
+	g_object_unref (cached);
+	nm_settings_cache_free (cache);
+
+	unlink (filename);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/settings/cache/hit", test_hit);
+	g_test_add_func ("/settings/cache/invalidate", test_invalidate);
+	g_test_add_func ("/settings/cache/delete", test_delete);
+
+	return g_test_run ();
+}
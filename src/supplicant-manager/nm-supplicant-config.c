@@ -49,6 +49,7 @@ typedef struct
 	guint32    ap_scan;
 	NMSettingMacRandomization mac_randomization;
 	gboolean   fast_required;
+	gboolean   fast_transition;
 	gboolean   dispose_has_run;
 } NMSupplicantConfigPrivate;
 
@@ -354,6 +355,79 @@ nm_supplicant_config_get_blobs (NMSupplicantConfig * self)
 	return NM_SUPPLICANT_CONFIG_GET_PRIVATE (self)->blobs;
 }
 
+static gboolean
+_options_equal (GHashTable *a, GHashTable *b)
+{
+	GHashTableIter iter;
+	const char *key;
+	ConfigOption *opt_a, *opt_b;
+
+	if (g_hash_table_size (a) != g_hash_table_size (b))
+		return FALSE;
+
+	g_hash_table_iter_init (&iter, a);
+	while (g_hash_table_iter_next (&iter, (gpointer) &key, (gpointer) &opt_a)) {
+		opt_b = g_hash_table_lookup (b, key);
+		if (   !opt_b
+		    || opt_a->type != opt_b->type
+		    || opt_a->len != opt_b->len
+		    || memcmp (opt_a->value, opt_b->value, opt_a->len) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+_blobs_equal (GHashTable *a, GHashTable *b)
+{
+	GHashTableIter iter;
+	const char *name;
+	GByteArray *blob_a, *blob_b;
+
+	if (g_hash_table_size (a) != g_hash_table_size (b))
+		return FALSE;
+
+	g_hash_table_iter_init (&iter, a);
+	while (g_hash_table_iter_next (&iter, (gpointer) &name, (gpointer) &blob_a)) {
+		blob_b = g_hash_table_lookup (b, name);
+		if (   !blob_b
+		    || blob_a->len != blob_b->len
+		    || memcmp (blob_a->data, blob_b->data, blob_a->len) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * nm_supplicant_config_equal:
+ * @a: a #NMSupplicantConfig
+ * @b: another #NMSupplicantConfig
+ *
+ * Returns: %TRUE if both configurations would result in the same network
+ * block, blobs and interface settings in the supplicant, so that a network
+ * added for @a can be selected again for @b.
+ */
+gboolean
+nm_supplicant_config_equal (NMSupplicantConfig *a, NMSupplicantConfig *b)
+{
+	NMSupplicantConfigPrivate *priv_a, *priv_b;
+
+	g_return_val_if_fail (NM_IS_SUPPLICANT_CONFIG (a), FALSE);
+	g_return_val_if_fail (NM_IS_SUPPLICANT_CONFIG (b), FALSE);
+
+	if (a == b)
+		return TRUE;
+
+	priv_a = NM_SUPPLICANT_CONFIG_GET_PRIVATE (a);
+	priv_b = NM_SUPPLICANT_CONFIG_GET_PRIVATE (b);
+
+	return    priv_a->ap_scan == priv_b->ap_scan
+	       && priv_a->mac_randomization == priv_b->mac_randomization
+	       && priv_a->fast_required == priv_b->fast_required
+	       && _options_equal (priv_a->config, priv_b->config)
+	       && _blobs_equal (priv_a->blobs, priv_b->blobs);
+}
+
 static const char *
 wifi_freqs_to_string (gboolean bg_band)
 {
@@ -477,6 +551,16 @@ nm_supplicant_config_add_setting_wireless (NMSupplicantConfig * self,
 		}
 	}
 
+	if (!(is_adhoc || is_ap)) {
+		const char *bgscan = nm_setting_wireless_get_bgscan (setting);
+
+		if (bgscan && !nm_supplicant_config_add_option (self, "bgscan", bgscan, -1, FALSE, error))
+			return FALSE;
+
+		/* picked up by nm_supplicant_config_add_setting_wireless_security() */
+		priv->fast_transition = nm_setting_wireless_get_fast_transition (setting);
+	}
+
 	priv->mac_randomization = nm_setting_wireless_get_mac_address_randomization (setting);
 	if (priv->mac_randomization == NM_SETTING_MAC_RANDOMIZATION_DEFAULT) {
 		priv->mac_randomization = mac_randomization_fallback;
@@ -646,6 +730,7 @@ nm_supplicant_config_add_setting_wireless_security (NMSupplicantConfig *self,
                                                     guint32 mtu,
                                                     GError **error)
 {
+	NMSupplicantConfigPrivate *priv;
 	const char *key_mgmt, *auth_alg;
 	const char *psk;
 
@@ -654,8 +739,16 @@ nm_supplicant_config_add_setting_wireless_security (NMSupplicantConfig *self,
 	g_return_val_if_fail (con_uuid != NULL, FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
 
+	priv = NM_SUPPLICANT_CONFIG_GET_PRIVATE (self);
+
 	key_mgmt = nm_setting_wireless_security_get_key_mgmt (setting);
-	if (!add_string_val (self, key_mgmt, "key_mgmt", TRUE, FALSE, error))
+	if (priv->fast_transition && !strcmp (key_mgmt, "wpa-psk")) {
+		if (!add_string_val (self, "wpa-psk ft-psk", "key_mgmt", TRUE, FALSE, error))
+			return FALSE;
+	} else if (priv->fast_transition && !strcmp (key_mgmt, "wpa-eap")) {
+		if (!add_string_val (self, "wpa-eap ft-eap", "key_mgmt", TRUE, FALSE, error))
+			return FALSE;
+	} else if (!add_string_val (self, key_mgmt, "key_mgmt", TRUE, FALSE, error))
 		return FALSE;
 
 	auth_alg = nm_setting_wireless_security_get_auth_alg (setting);
@@ -772,9 +865,11 @@ nm_supplicant_config_add_setting_wireless_security (NMSupplicantConfig *self,
 
 		if (!strcmp (key_mgmt, "wpa-eap")) {
 			/* If using WPA Enterprise, enable optimized background scanning
-			 * to ensure roaming within an ESS works well.
+			 * to ensure roaming within an ESS works well, unless the
+			 * connection configures it.
 			 */
-			if (!nm_supplicant_config_add_option (self, "bgscan", "simple:30:-65:300", -1, FALSE, error))
+			if (   !g_hash_table_contains (priv->config, "bgscan")
+			    && !nm_supplicant_config_add_option (self, "bgscan", "simple:30:-65:300", -1, FALSE, error))
 				return FALSE;
 
 			/* When using WPA-Enterprise, we want to use Proactive Key Caching (also
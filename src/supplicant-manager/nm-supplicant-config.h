@@ -62,6 +62,8 @@ GVariant *nm_supplicant_config_to_variant (NMSupplicantConfig *self);
 
 GHashTable *nm_supplicant_config_get_blobs (NMSupplicantConfig *self);
 
+gboolean nm_supplicant_config_equal (NMSupplicantConfig *a, NMSupplicantConfig *b);
+
 gboolean nm_supplicant_config_add_setting_wireless (NMSupplicantConfig *self,
                                                     NMSettingWireless *setting,
                                                     guint32 fixed_freq,
@@ -29,6 +29,7 @@
 #include "nm-supplicant-config.h"
 #include "nm-core-internal.h"
 #include "nm-dbus-compat.h"
+#include "nm-supplicant-manager.h"
 
 #define WPAS_DBUS_IFACE_INTERFACE   WPAS_DBUS_INTERFACE ".Interface"
 #define WPAS_DBUS_IFACE_BSS         WPAS_DBUS_INTERFACE ".BSS"
@@ -78,6 +79,8 @@ typedef struct {
 	guint32        ready_count;
 
 	char *         object_path;
+	/* whether CreateInterface was called for this start */
+	gboolean       created;
 	guint32        state;
 	int            disconnect_reason;
 
@@ -90,7 +93,8 @@ typedef struct {
 	GCancellable * assoc_cancellable;
 	char *         net_path;
 	guint32        blobs_left;
-	GHashTable *   bss_proxies;
+	GHashTable *   bss_props; /* BSS path => properties, NULL while being fetched */
+	guint          bss_props_signal_id;
 	char *         current_bss;
 
 	gint32         last_scan; /* timestamp as returned by nm_utils_get_monotonic_timestamp_s() */
@@ -132,103 +136,189 @@ emit_error_helper (NMSupplicantInterface *self, GError *error)
 	g_free (name);
 }
 
+/* Merges @changed into the cached properties @old of a BSS and returns
+ * the new (floating) dictionary. */
+static GVariant *
+_bss_props_merge (GVariant *old, GVariant *changed)
+{
+	GVariantBuilder builder;
+	GVariantIter iter;
+	const char *name;
+	GVariant *value;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+
+	g_variant_iter_init (&iter, changed);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		g_variant_builder_add (&builder, "{sv}", name, value);
+		g_variant_unref (value);
+	}
+
+	g_variant_iter_init (&iter, old);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		GVariant *v;
+
+		v = g_variant_lookup_value (changed, name, NULL);
+		if (v)
+			g_variant_unref (v);
+		else
+			g_variant_builder_add (&builder, "{sv}", name, value);
+		g_variant_unref (value);
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
 static void
-bss_props_changed_cb (GDBusProxy *proxy,
-                      GVariant *changed_properties,
-                      char **invalidated_properties,
+bss_props_changed_cb (GDBusConnection *connection,
+                      const char *sender_name,
+                      const char *object_path,
+                      const char *interface_name,
+                      const char *signal_name,
+                      GVariant *parameters,
                       gpointer user_data)
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *changed_properties = NULL;
+	const char *iface;
+	GVariant *props;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
+
+	g_variant_get (parameters, "(&s@a{sv}^a&s)", &iface, &changed_properties, NULL);
+	if (strcmp (iface, WPAS_DBUS_IFACE_BSS) != 0)
+		return;
+
+	/* the subscription is not filtered by path, ignore BSSes of other
+	 * interfaces and BSSes whose properties are still being fetched. */
+	props = g_hash_table_lookup (priv->bss_props, object_path);
+	if (!props)
+		return;
 
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
 
+	g_hash_table_insert (priv->bss_props,
+	                     g_strdup (object_path),
+	                     g_variant_ref_sink (_bss_props_merge (props, changed_properties)));
+
 	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
+	               object_path,
 	               changed_properties);
 }
 
-static GVariant *
-_get_bss_proxy_properties (NMSupplicantInterface *self, GDBusProxy *proxy)
+static void
+_bss_props_free (gpointer props)
 {
-	gs_strfreev char **properties = NULL;
-	GVariantBuilder builder;
-	char **iter;
-
-	iter = properties = g_dbus_proxy_get_cached_property_names (proxy);
-	if (!iter)
-		return NULL;
-
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-	while (*iter) {
-		GVariant *copy = g_dbus_proxy_get_cached_property (proxy, *iter);
+	if (props)
+		g_variant_unref (props);
+}
 
-		g_variant_builder_add (&builder, "{sv}", *iter++, copy);
-		g_variant_unref (copy);
-	}
+static void
+bss_add_with_properties (NMSupplicantInterface *self, const char *object_path, GVariant *props)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	return g_variant_builder_end (&builder);
+	g_variant_ref_sink (props);
+	g_hash_table_insert (priv->bss_props, g_strdup (object_path), props);
+	g_signal_emit (self, signals[NEW_BSS], 0, object_path, props);
 }
 
-#define BSS_PROXY_INITED "bss-proxy-inited"
+typedef struct {
+	NMSupplicantInterface *self;
+	char *object_path;
+} BssGetAllData;
 
 static void
-on_bss_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+bss_get_all_cb (GObject *source, GAsyncResult *result, gpointer user_data)
 {
+	BssGetAllData *data = user_data;
 	NMSupplicantInterface *self;
+	NMSupplicantInterfacePrivate *priv;
 	gs_free_error GError *error = NULL;
-	gs_unref_variant GVariant *props = NULL;
+	gs_unref_variant GVariant *ret = NULL;
+	GVariant *props;
 
-	if (!g_async_initable_init_finish (G_ASYNC_INITABLE (proxy), result, &error)) {
-		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-			self = NM_SUPPLICANT_INTERFACE (user_data);
-			_LOGD ("failed to acquire BSS proxy: (%s)", error->message);
-			g_hash_table_remove (NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self)->bss_proxies,
-			                     g_dbus_proxy_get_object_path (proxy));
-		}
-		return;
-	}
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (!ret && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		goto out;
 
-	self = NM_SUPPLICANT_INTERFACE (user_data);
-	props = _get_bss_proxy_properties (self, proxy);
-	if (!props)
-		return;
+	self = data->self;
+	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	/* disposed, removed or already added by BSSAdded in the meantime */
+	if (   !priv->bss_props
+	    || !g_hash_table_contains (priv->bss_props, data->object_path)
+	    || g_hash_table_lookup (priv->bss_props, data->object_path))
+		goto out;
 
-	g_object_set_data (G_OBJECT (proxy), BSS_PROXY_INITED, GUINT_TO_POINTER (TRUE));
+	if (!ret) {
+		_LOGD ("failed to get BSS properties: (%s)", error->message);
+		g_hash_table_remove (priv->bss_props, data->object_path);
+		goto out;
+	}
+
+	g_variant_get (ret, "(@a{sv})", &props);
+	bss_add_with_properties (self, data->object_path, props);
+	g_variant_unref (props);
 
-	g_signal_emit (self, signals[NEW_BSS], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               g_variant_ref_sink (props));
+out:
+	g_object_unref (data->self);
+	g_free (data->object_path);
+	g_slice_free (BssGetAllData, data);
 }
 
 static void
-handle_new_bss (NMSupplicantInterface *self, const char *object_path)
+handle_new_bss (NMSupplicantInterface *self, const char *object_path, GVariant *props)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GDBusProxy *bss_proxy;
+	BssGetAllData *data;
 
 	g_return_if_fail (object_path != NULL);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	/* BSSAdded carries all properties of the BSS. Only fetch them
+	 * when we learned about the BSS otherwise. */
+	if (props && g_variant_n_children (props) > 0) {
+		if (!g_hash_table_lookup (priv->bss_props, object_path))
+			bss_add_with_properties (self, object_path, props);
 		return;
+	}
 
-	bss_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                          "g-bus-type", G_BUS_TYPE_SYSTEM,
-	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                          "g-name", WPAS_DBUS_SERVICE,
-	                          "g-object-path", object_path,
-	                          "g-interface-name", WPAS_DBUS_IFACE_BSS,
-	                          NULL);
-	g_hash_table_insert (priv->bss_proxies,
-	                     (char *) g_dbus_proxy_get_object_path (bss_proxy),
-	                     bss_proxy);
-	g_signal_connect (bss_proxy, "g-properties-changed", G_CALLBACK (bss_props_changed_cb), self);
-	g_async_initable_init_async (G_ASYNC_INITABLE (bss_proxy),
-	                             G_PRIORITY_DEFAULT,
-	                             priv->other_cancellable,
-	                             (GAsyncReadyCallback) on_bss_proxy_acquired,
-	                             self);
+	if (   !priv->iface_proxy
+	    || g_hash_table_contains (priv->bss_props, object_path))
+		return;
+
+	g_hash_table_insert (priv->bss_props, g_strdup (object_path), NULL);
+
+	data = g_slice_new (BssGetAllData);
+	data->self = g_object_ref (self);
+	data->object_path = g_strdup (object_path);
+	g_dbus_connection_call (g_dbus_proxy_get_connection (priv->iface_proxy),
+	                        WPAS_DBUS_SERVICE,
+	                        object_path,
+	                        DBUS_INTERFACE_PROPERTIES,
+	                        "GetAll",
+	                        g_variant_new ("(s)", WPAS_DBUS_IFACE_BSS),
+	                        G_VARIANT_TYPE ("(a{sv})"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        priv->other_cancellable,
+	                        bss_get_all_cb,
+	                        data);
+}
+
+static void
+bss_props_unsubscribe (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_props_signal_id) {
+		g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (priv->iface_proxy),
+		                                      priv->bss_props_signal_id);
+		priv->bss_props_signal_id = 0;
+	}
 }
 
 static void
@@ -265,8 +355,14 @@ set_state (NMSupplicantInterface *self, guint32 new_state)
 			g_cancellable_cancel (priv->other_cancellable);
 		g_clear_object (&priv->other_cancellable);
 
-		if (priv->iface_proxy)
+		if (priv->iface_proxy) {
 			g_signal_handlers_disconnect_by_data (priv->iface_proxy, self);
+			bss_props_unsubscribe (self);
+		}
+
+		/* The supplicant dropped the interface along with its networks */
+		g_clear_pointer (&priv->net_path, g_free);
+		g_clear_object (&priv->cfg);
 	}
 
 	priv->state = new_state;
@@ -528,47 +624,32 @@ set_preassoc_scan_mac_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user
 }
 
 static void
-iface_introspect_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+iface_introspect_cb (NMSupplicantFeature ap_support,
+                     NMSupplicantFeature mac_randomization_support,
+                     gpointer user_data)
 {
-	NMSupplicantInterface *self;
-	NMSupplicantInterfacePrivate *priv;
-	gs_unref_variant GVariant *variant = NULL;
-	gs_free_error GError *error = NULL;
-	const char *data;
-
-	variant = _nm_dbus_proxy_call_finish (proxy, result,
-	                                      G_VARIANT_TYPE ("(s)"),
-	                                      &error);
-	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-		return;
-
-	self = NM_SUPPLICANT_INTERFACE (user_data);
-	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-
-	if (variant) {
-		g_variant_get (variant, "(&s)", &data);
+	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-		/* The ProbeRequest method only exists if AP mode has been enabled */
-		if (strstr (data, "ProbeRequest"))
-			priv->ap_support = NM_SUPPLICANT_FEATURE_YES;
+	if (ap_support == NM_SUPPLICANT_FEATURE_YES)
+		priv->ap_support = NM_SUPPLICANT_FEATURE_YES;
 
-		if (strstr (data, "PreassocMacAddr")) {
-			priv->mac_randomization_support = NM_SUPPLICANT_FEATURE_YES;
+	if (mac_randomization_support == NM_SUPPLICANT_FEATURE_YES) {
+		priv->mac_randomization_support = NM_SUPPLICANT_FEATURE_YES;
 
-			/* Turn on MAC randomization during scans by default */
-			priv->ready_count++;
-			g_dbus_proxy_call (priv->iface_proxy,
-			                   DBUS_INTERFACE_PROPERTIES ".Set",
-			                   g_variant_new ("(ssv)",
-			                                  WPAS_DBUS_IFACE_INTERFACE,
-			                                  "PreassocMacAddr",
-			                                  g_variant_new_string ("1")),
-			                   G_DBUS_CALL_FLAGS_NONE,
-			                   -1,
-			                   priv->init_cancellable,
-			                   (GAsyncReadyCallback) set_preassoc_scan_mac_cb,
-			                   self);
-		}
+		/* Turn on MAC randomization during scans by default */
+		priv->ready_count++;
+		g_dbus_proxy_call (priv->iface_proxy,
+		                   DBUS_INTERFACE_PROPERTIES ".Set",
+		                   g_variant_new ("(ssv)",
+		                                  WPAS_DBUS_IFACE_INTERFACE,
+		                                  "PreassocMacAddr",
+		                                  g_variant_new_string ("1")),
+		                   G_DBUS_CALL_FLAGS_NONE,
+		                   -1,
+		                   priv->init_cancellable,
+		                   (GAsyncReadyCallback) set_preassoc_scan_mac_cb,
+		                   self);
 	}
 
 	iface_check_ready (self);
@@ -581,10 +662,9 @@ wpas_iface_scan_done (GDBusProxy *proxy,
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GVariant *props;
 	GHashTableIter iter;
-	char *bss_path;
-	GDBusProxy *bss_proxy;
+	const char *bss_path;
+	GVariant *props;
 
 	/* Cache last scan completed time */
 	priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
@@ -592,17 +672,10 @@ wpas_iface_scan_done (GDBusProxy *proxy,
 	g_signal_emit (self, signals[SCAN_DONE], 0, success);
 
 	/* Emit NEW_BSS so that wifi device has the APs (in case it removed them) */
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
-	while (g_hash_table_iter_next (&iter, (gpointer) &bss_path, (gpointer) &bss_proxy)) {
-		if (g_object_get_data (G_OBJECT (bss_proxy), BSS_PROXY_INITED)) {
-			props = _get_bss_proxy_properties (self, bss_proxy);
-			if (props) {
-				g_signal_emit (self, signals[NEW_BSS], 0,
-				               bss_path,
-				               g_variant_ref_sink (props));
-				g_variant_unref (props);
-			}
-		}
+	g_hash_table_iter_init (&iter, priv->bss_props);
+	while (g_hash_table_iter_next (&iter, (gpointer) &bss_path, (gpointer) &props)) {
+		if (props)
+			g_signal_emit (self, signals[NEW_BSS], 0, bss_path, props);
 	}
 }
 
@@ -618,7 +691,7 @@ wpas_iface_bss_added (GDBusProxy *proxy,
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
 
-	handle_new_bss (self, path);
+	handle_new_bss (self, path, props);
 }
 
 static void
@@ -630,7 +703,7 @@ wpas_iface_bss_removed (GDBusProxy *proxy,
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	g_signal_emit (self, signals[BSS_REMOVED], 0, path);
-	g_hash_table_remove (priv->bss_proxies, path);
+	g_hash_table_remove (priv->bss_props, path);
 }
 
 static void
@@ -678,7 +751,7 @@ props_changed_cb (GDBusProxy *proxy,
 	if (g_variant_lookup (changed_properties, "BSSs", "^a&o", &array)) {
 		iter = array;
 		while (*iter)
-			handle_new_bss (self, *iter++);
+			handle_new_bss (self, *iter++, NULL);
 		g_free (array);
 	}
 
@@ -741,6 +814,19 @@ on_iface_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_
 	_nm_dbus_signal_connect (priv->iface_proxy, "NetworkRequest", G_VARIANT_TYPE ("(oss)"),
 	                         G_CALLBACK (wpas_iface_network_request), self);
 
+	/* One subscription for the property changes of all BSSes, instead
+	 * of a proxy per BSS. */
+	priv->bss_props_signal_id = g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (priv->iface_proxy),
+	                                                                WPAS_DBUS_SERVICE,
+	                                                                DBUS_INTERFACE_PROPERTIES,
+	                                                                "PropertiesChanged",
+	                                                                NULL,
+	                                                                WPAS_DBUS_IFACE_BSS,
+	                                                                G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                                bss_props_changed_cb,
+	                                                                self,
+	                                                                NULL);
+
 	/* Scan result aging parameters */
 	g_dbus_proxy_call (priv->iface_proxy,
 	                   "org.freedesktop.DBus.Properties.Set",
@@ -785,16 +871,16 @@ on_iface_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_
 		 * fall back to checking whether the ProbeRequest method is supported.  If
 		 * neither of these works we have no way of determining if AP mode is
 		 * supported or not.  hostap 1.0 and earlier don't support either of these.
+		 *
+		 * The introspection data is the same for all interfaces of the
+		 * supplicant, the manager asks only once.
 		 */
 		priv->ready_count++;
-		g_dbus_proxy_call (priv->iface_proxy,
-		                   DBUS_INTERFACE_INTROSPECTABLE ".Introspect",
-		                   NULL,
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1,
-		                   priv->init_cancellable,
-		                   (GAsyncReadyCallback) iface_introspect_cb,
-		                   self);
+		nm_supplicant_manager_introspect_interface (nm_supplicant_manager_get (),
+		                                            priv->object_path,
+		                                            priv->init_cancellable,
+		                                            iface_introspect_cb,
+		                                            self);
 	}
 }
 
@@ -807,7 +893,7 @@ interface_add_done (NMSupplicantInterface *self, const char *path)
 
 	priv->object_path = g_strdup (path);
 	priv->iface_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                                  "g-bus-type", G_BUS_TYPE_SYSTEM,
+	                                  "g-connection", g_dbus_proxy_get_connection (priv->wpas_proxy),
 	                                  "g-flags", G_DBUS_PROXY_FLAGS_NONE,
 	                                  "g-name", WPAS_DBUS_SERVICE,
 	                                  "g-object-path", priv->object_path,
@@ -821,6 +907,9 @@ interface_add_done (NMSupplicantInterface *self, const char *path)
 	                             self);
 }
 
+static void interface_create (NMSupplicantInterface *self);
+static void interface_get (NMSupplicantInterface *self);
+
 static void
 interface_get_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 {
@@ -842,6 +931,10 @@ interface_get_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 	if (variant) {
 		g_variant_get (variant, "(&o)", &path);
 		interface_add_done (self, path);
+	} else if (   !priv->created
+	           && _nm_dbus_error_has_name (error, WPAS_ERROR_INVALID_IFACE)) {
+		/* It wasn't there after all */
+		interface_create (self);
 	} else {
 		g_dbus_error_strip_remote_error (error);
 		_LOGE ("error getting interface: %s", error->message);
@@ -872,14 +965,7 @@ interface_add_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 		interface_add_done (self, path);
 	} else if (_nm_dbus_error_has_name (error, WPAS_ERROR_EXISTS_ERROR)) {
 		/* Interface already added, just get its object path */
-		g_dbus_proxy_call (priv->wpas_proxy,
-		                   "GetInterface",
-		                   g_variant_new ("(s)", priv->dev),
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1,
-		                   priv->init_cancellable,
-		                   (GAsyncReadyCallback) interface_get_cb,
-		                   self);
+		interface_get (self);
 	} else if (   g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN)
 	           || g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SPAWN_EXEC_FAILED)
 	           || g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SPAWN_FORK_FAILED)
@@ -909,33 +995,16 @@ interface_add_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 #endif
 
 static void
-on_wpas_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+interface_create (NMSupplicantInterface *self)
 {
-	NMSupplicantInterface *self;
-	NMSupplicantInterfacePrivate *priv;
-	gs_free_error GError *error = NULL;
-	GDBusProxy *wpas_proxy;
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 	GVariantBuilder props;
 
-	wpas_proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
-	if (!wpas_proxy) {
-		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-			self = NM_SUPPLICANT_INTERFACE (user_data);
-			_LOGW ("failed to acquire wpa_supplicant proxy: (%s)", error->message);
-			set_state (self, NM_SUPPLICANT_INTERFACE_STATE_DOWN);
-		}
-		return;
-	}
-
-	self = NM_SUPPLICANT_INTERFACE (user_data);
-	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-
-	priv->wpas_proxy = wpas_proxy;
-
 	/* Try to add the interface to the supplicant.  If the supplicant isn't
 	 * running, this will start it via D-Bus activation and return the response
 	 * when the supplicant has started.
 	 */
+	priv->created = TRUE;
 
 	g_variant_builder_init (&props, G_VARIANT_TYPE_VARDICT);
 	g_variant_builder_add (&props, "{sv}",
@@ -955,6 +1024,71 @@ on_wpas_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_d
 	                   self);
 }
 
+static void
+interface_get (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	g_dbus_proxy_call (priv->wpas_proxy,
+	                   "GetInterface",
+	                   g_variant_new ("(s)", priv->dev),
+	                   G_DBUS_CALL_FLAGS_NONE,
+	                   -1,
+	                   priv->init_cancellable,
+	                   (GAsyncReadyCallback) interface_get_cb,
+	                   self);
+}
+
+static gboolean
+supplicant_has_interfaces (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *value = NULL;
+
+	/* only the proxy of the manager loads the properties */
+	value = g_dbus_proxy_get_cached_property (priv->wpas_proxy, "Interfaces");
+	return    value
+	       && g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY)
+	       && g_variant_n_children (value) > 0;
+}
+
+static void
+interface_start (NMSupplicantInterface *self)
+{
+	/* The interfaces of a supplicant that was running before, like
+	 * when NetworkManager restarts, are reused as they are. Asking for
+	 * them first saves the failing CreateInterface call. */
+	if (supplicant_has_interfaces (self))
+		interface_get (self);
+	else
+		interface_create (self);
+}
+
+static void
+on_wpas_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+{
+	NMSupplicantInterface *self;
+	NMSupplicantInterfacePrivate *priv;
+	gs_free_error GError *error = NULL;
+	GDBusProxy *wpas_proxy;
+
+	wpas_proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
+	if (!wpas_proxy) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			self = NM_SUPPLICANT_INTERFACE (user_data);
+			_LOGW ("failed to acquire wpa_supplicant proxy: (%s)", error->message);
+			set_state (self, NM_SUPPLICANT_INTERFACE_STATE_DOWN);
+		}
+		return;
+	}
+
+	self = NM_SUPPLICANT_INTERFACE (user_data);
+	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	priv->wpas_proxy = wpas_proxy;
+	interface_start (self);
+}
+
 static void
 interface_add (NMSupplicantInterface *self)
 {
@@ -971,6 +1105,12 @@ interface_add (NMSupplicantInterface *self)
 	g_warn_if_fail (priv->init_cancellable == NULL);
 	g_clear_object (&priv->init_cancellable);
 	priv->init_cancellable = g_cancellable_new ();
+	priv->created = FALSE;
+
+	if (priv->wpas_proxy) {
+		interface_start (self);
+		return;
+	}
 
 	g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
 	                          G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
@@ -1022,14 +1162,32 @@ log_result_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 	}
 }
 
-void
-nm_supplicant_interface_disconnect (NMSupplicantInterface * self)
+static void
+remove_network (NMSupplicantInterface *self)
 {
-	NMSupplicantInterfacePrivate *priv;
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	g_return_if_fail (NM_IS_SUPPLICANT_INTERFACE (self));
+	/* Remove any network that was added by NetworkManager */
+	if (priv->net_path) {
+		if (priv->iface_proxy) {
+			g_dbus_proxy_call (priv->iface_proxy,
+			                   "RemoveNetwork",
+			                   g_variant_new ("(o)", priv->net_path),
+			                   G_DBUS_CALL_FLAGS_NONE,
+			                   -1,
+			                   priv->other_cancellable,
+			                   (GAsyncReadyCallback) log_result_cb,
+			                   "remove network");
+		}
+		g_free (priv->net_path);
+		priv->net_path = NULL;
+	}
+}
 
-	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+static void
+disconnect_internal (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	/* Cancel all pending calls related to a prior connection attempt */
 	if (priv->assoc_cancellable) {
@@ -1053,20 +1211,18 @@ nm_supplicant_interface_disconnect (NMSupplicantInterface * self)
 		                   (GAsyncReadyCallback) log_result_cb,
 		                   "disconnect");
 	}
+}
 
-	/* Remove any network that was added by NetworkManager */
-	if (priv->net_path) {
-		g_dbus_proxy_call (priv->iface_proxy,
-		                   "RemoveNetwork",
-		                   g_variant_new ("(o)", priv->net_path),
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1,
-		                   priv->other_cancellable,
-		                   (GAsyncReadyCallback) log_result_cb,
-		                   "remove network");
-		g_free (priv->net_path);
-		priv->net_path = NULL;
-	}
+void
+nm_supplicant_interface_disconnect (NMSupplicantInterface * self)
+{
+	g_return_if_fail (NM_IS_SUPPLICANT_INTERFACE (self));
+
+	disconnect_internal (self);
+
+	/* A real disconnect: don't leave the network, and with it the
+	 * secrets and blobs, loaded in the supplicant. */
+	remove_network (self);
 }
 
 static void
@@ -1285,12 +1441,33 @@ nm_supplicant_interface_set_config (NMSupplicantInterface *self,
 
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	nm_supplicant_interface_disconnect (self);
+	/* Unlike nm_supplicant_interface_disconnect(), keep the network of the
+	 * previous attempt: when the device retries with the same configuration
+	 * without disconnecting first, only SelectNetwork is needed, and its
+	 * blobs are still there too. Any other configuration removes it.
+	 */
+	disconnect_internal (self);
+
+	if (   cfg
+	    && priv->net_path
+	    && priv->cfg
+	    && nm_supplicant_config_equal (priv->cfg, cfg)) {
+		g_object_ref (cfg);
+		g_object_unref (priv->cfg);
+		priv->cfg = cfg;
+
+		_LOGD ("config: reusing network %s", priv->net_path);
+		priv->blobs_left = 0;
+		call_select_network (self);
+		return TRUE;
+	}
+
+	remove_network (self);
 
 	/* Make sure the supplicant supports EAP-FAST before trying to send
 	 * it an EAP-FAST configuration.
 	 */
-	if (nm_supplicant_config_fast_required (cfg) && !priv->fast_supported) {
+	if (cfg && nm_supplicant_config_fast_required (cfg) && !priv->fast_supported) {
 		g_set_error (error, NM_SUPPLICANT_ERROR, NM_SUPPLICANT_ERROR_CONFIG,
 		             "EAP-FAST is not supported by the supplicant");
 		return FALSE;
@@ -1338,8 +1515,19 @@ scan_request_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 	g_signal_emit (self, signals[SCAN_DONE], 0, error ? FALSE : TRUE);
 }
 
+/**
+ * nm_supplicant_interface_request_scan:
+ * @self: the supplicant interface
+ * @ssids: (allow-none): SSIDs to probe for
+ * @freqs: (allow-none): #guint32 frequencies in MHz to restrict the scan
+ *   to, or %NULL to scan all channels
+ *
+ * Returns: %TRUE if the scan was requested
+ */
 gboolean
-nm_supplicant_interface_request_scan (NMSupplicantInterface *self, const GPtrArray *ssids)
+nm_supplicant_interface_request_scan (NMSupplicantInterface *self,
+                                      const GPtrArray *ssids,
+                                      const GArray *freqs)
 {
 	NMSupplicantInterfacePrivate *priv;
 	GVariantBuilder builder;
@@ -1364,6 +1552,16 @@ nm_supplicant_interface_request_scan (NMSupplicantInterface *self, const GPtrArr
 		}
 		g_variant_builder_add (&builder, "{sv}", "SSIDs", g_variant_builder_end (&ssids_builder));
 	}
+	if (freqs && freqs->len) {
+		GVariantBuilder channels_builder;
+
+		/* (center frequency, width) tuples; 20 MHz channels suffice to
+		 * find BSSes of any width. */
+		g_variant_builder_init (&channels_builder, G_VARIANT_TYPE ("a(uu)"));
+		for (i = 0; i < freqs->len; i++)
+			g_variant_builder_add (&channels_builder, "(uu)", g_array_index (freqs, guint32, i), (guint32) 20);
+		g_variant_builder_add (&builder, "{sv}", "Channels", g_variant_builder_end (&channels_builder));
+	}
 
 	g_dbus_proxy_call (priv->iface_proxy,
 	                   "Scan",
@@ -1452,16 +1650,23 @@ NMSupplicantInterface *
 nm_supplicant_interface_new (const char *ifname,
                              gboolean is_wireless,
                              gboolean fast_supported,
-                             NMSupplicantFeature ap_support)
+                             NMSupplicantFeature ap_support,
+                             GDBusProxy *wpas_proxy)
 {
+	NMSupplicantInterface *self;
+
 	g_return_val_if_fail (ifname != NULL, NULL);
+	g_return_val_if_fail (!wpas_proxy || G_IS_DBUS_PROXY (wpas_proxy), NULL);
 
-	return g_object_new (NM_TYPE_SUPPLICANT_INTERFACE,
+	self = g_object_new (NM_TYPE_SUPPLICANT_INTERFACE,
 	                     NM_SUPPLICANT_INTERFACE_IFACE, ifname,
 	                     NM_SUPPLICANT_INTERFACE_IS_WIRELESS, is_wireless,
 	                     NM_SUPPLICANT_INTERFACE_FAST_SUPPORTED, fast_supported,
 	                     NM_SUPPLICANT_INTERFACE_AP_SUPPORT, (int) ap_support,
 	                     NULL);
+	if (wpas_proxy)
+		NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self)->wpas_proxy = g_object_ref (wpas_proxy);
+	return self;
 }
 
 static void
@@ -1470,7 +1675,7 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	priv->state = NM_SUPPLICANT_INTERFACE_STATE_INIT;
-	priv->bss_proxies = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->bss_props = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _bss_props_free);
 }
 
 static void
@@ -1531,8 +1736,10 @@ dispose (GObject *object)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (object);
 
-	if (priv->iface_proxy)
+	if (priv->iface_proxy) {
 		g_signal_handlers_disconnect_by_data (priv->iface_proxy, NM_SUPPLICANT_INTERFACE (object));
+		bss_props_unsubscribe (NM_SUPPLICANT_INTERFACE (object));
+	}
 	g_clear_object (&priv->iface_proxy);
 
 	if (priv->init_cancellable)
@@ -1544,7 +1751,7 @@ dispose (GObject *object)
 	g_clear_object (&priv->other_cancellable);
 
 	g_clear_object (&priv->wpas_proxy);
-	g_clear_pointer (&priv->bss_proxies, (GDestroyNotify) g_hash_table_destroy);
+	g_clear_pointer (&priv->bss_props, (GDestroyNotify) g_hash_table_destroy);
 
 	g_clear_pointer (&priv->net_path, g_free);
 	g_clear_pointer (&priv->dev, g_free);
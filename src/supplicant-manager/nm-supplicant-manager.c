@@ -27,6 +27,7 @@
 #include "nm-supplicant-interface.h"
 #include "nm-supplicant-types.h"
 #include "nm-core-internal.h"
+#include "nm-dbus-compat.h"
 
 #define NM_SUPPLICANT_MANAGER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), \
                                               NM_TYPE_SUPPLICANT_MANAGER, \
@@ -54,8 +55,26 @@ typedef struct {
 	NMSupplicantFeature ap_support;
 	guint             die_count_reset_id;
 	guint             die_count;
+
+	/* The introspection data of a supplicant interface tells the
+	 * features of the supplicant, which are the same for all its
+	 * interfaces. It's fetched once per supplicant instance, and
+	 * interfaces asking meanwhile wait for the result. */
+	struct {
+		gboolean done;
+		NMSupplicantFeature ap_support;
+		NMSupplicantFeature mac_randomization_support;
+		GSList *waiters;
+		GCancellable *cancellable;
+	} introspect;
 } NMSupplicantManagerPrivate;
 
+typedef struct {
+	NMSupplicantManagerIntrospectCallback callback;
+	gpointer user_data;
+	GCancellable *cancellable;
+} IntrospectWaiter;
+
 /********************************************************************/
 
 G_DEFINE_QUARK (nm-supplicant-error-quark, nm_supplicant_error);
@@ -116,6 +135,143 @@ _sup_iface_last_ref (gpointer data,
 	g_object_remove_toggle_ref ((GObject *) sup_iface, _sup_iface_last_ref, self);
 }
 
+static void
+introspect_waiter_free (gpointer data)
+{
+	IntrospectWaiter *waiter = data;
+
+	g_clear_object (&waiter->cancellable);
+	g_slice_free (IntrospectWaiter, waiter);
+}
+
+static void
+introspect_reset (NMSupplicantManager *self)
+{
+	NMSupplicantManagerPrivate *priv = NM_SUPPLICANT_MANAGER_GET_PRIVATE (self);
+
+	/* the interfaces waiting go down with the supplicant, and don't
+	 * need the result anymore. */
+	if (priv->introspect.cancellable) {
+		g_cancellable_cancel (priv->introspect.cancellable);
+		g_clear_object (&priv->introspect.cancellable);
+	}
+	g_slist_free_full (priv->introspect.waiters, introspect_waiter_free);
+	priv->introspect.waiters = NULL;
+	priv->introspect.done = FALSE;
+	priv->introspect.ap_support = NM_SUPPLICANT_FEATURE_UNKNOWN;
+	priv->introspect.mac_randomization_support = NM_SUPPLICANT_FEATURE_UNKNOWN;
+}
+
+static void
+introspect_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	NMSupplicantManager *self;
+	NMSupplicantManagerPrivate *priv;
+	gs_unref_variant GVariant *variant = NULL;
+	gs_free_error GError *error = NULL;
+	GSList *waiters, *iter;
+	const char *data;
+
+	variant = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	self = NM_SUPPLICANT_MANAGER (user_data);
+	priv = NM_SUPPLICANT_MANAGER_GET_PRIVATE (self);
+
+	g_clear_object (&priv->introspect.cancellable);
+
+	if (variant) {
+		g_variant_get (variant, "(&s)", &data);
+
+		/* The ProbeRequest method only exists if AP mode has been enabled */
+		if (strstr (data, "ProbeRequest"))
+			priv->introspect.ap_support = NM_SUPPLICANT_FEATURE_YES;
+		if (strstr (data, "PreassocMacAddr"))
+			priv->introspect.mac_randomization_support = NM_SUPPLICANT_FEATURE_YES;
+		priv->introspect.done = TRUE;
+	} else {
+		/* the next interface asking tries again */
+		g_dbus_error_strip_remote_error (error);
+		_LOGD ("failed to introspect interface: %s", error->message);
+	}
+
+	waiters = priv->introspect.waiters;
+	priv->introspect.waiters = NULL;
+	for (iter = waiters; iter; iter = iter->next) {
+		IntrospectWaiter *waiter = iter->data;
+
+		if (!g_cancellable_is_cancelled (waiter->cancellable)) {
+			waiter->callback (priv->introspect.ap_support,
+			                  priv->introspect.mac_randomization_support,
+			                  waiter->user_data);
+		}
+	}
+	g_slist_free_full (waiters, introspect_waiter_free);
+}
+
+/**
+ * nm_supplicant_manager_introspect_interface:
+ * @self: the #NMSupplicantManager
+ * @object_path: the path of a supplicant interface
+ * @cancellable: the #GCancellable of the caller
+ * @callback: called with the features found in the introspection data.
+ *   It isn't called if @cancellable gets cancelled.
+ * @user_data: the argument of @callback
+ *
+ * Gets the features that are only visible in the introspection data of
+ * a supplicant interface. Only the first interface is introspected:
+ * the result is shared by all interfaces of the same supplicant. If it
+ * is already known, @callback is called synchronously.
+ */
+void
+nm_supplicant_manager_introspect_interface (NMSupplicantManager *self,
+                                            const char *object_path,
+                                            GCancellable *cancellable,
+                                            NMSupplicantManagerIntrospectCallback callback,
+                                            gpointer user_data)
+{
+	NMSupplicantManagerPrivate *priv;
+	IntrospectWaiter *waiter;
+
+	g_return_if_fail (NM_IS_SUPPLICANT_MANAGER (self));
+	g_return_if_fail (object_path);
+	g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (callback);
+
+	priv = NM_SUPPLICANT_MANAGER_GET_PRIVATE (self);
+
+	if (priv->introspect.done || !priv->proxy) {
+		callback (priv->introspect.ap_support,
+		          priv->introspect.mac_randomization_support,
+		          user_data);
+		return;
+	}
+
+	waiter = g_slice_new0 (IntrospectWaiter);
+	waiter->callback = callback;
+	waiter->user_data = user_data;
+	waiter->cancellable = g_object_ref (cancellable);
+	priv->introspect.waiters = g_slist_append (priv->introspect.waiters, waiter);
+
+	if (priv->introspect.cancellable)
+		return;
+
+	priv->introspect.cancellable = g_cancellable_new ();
+	g_dbus_connection_call (g_dbus_proxy_get_connection (priv->proxy),
+	                        WPAS_DBUS_SERVICE,
+	                        object_path,
+	                        DBUS_INTERFACE_INTROSPECTABLE,
+	                        "Introspect",
+	                        NULL,
+	                        G_VARIANT_TYPE ("(s)"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        priv->introspect.cancellable,
+	                        introspect_cb,
+	                        self);
+}
+
 /**
  * nm_supplicant_manager_create_interface:
  * @self: the #NMSupplicantManager
@@ -151,10 +307,13 @@ nm_supplicant_manager_create_interface (NMSupplicantManager *self,
 			g_return_val_if_reached (NULL);
 	}
 
+	/* The interfaces call the supplicant through the proxy of the
+	 * manager, so that they don't need to set up one each. */
 	iface = nm_supplicant_interface_new (ifname,
 	                                     is_wireless,
 	                                     priv->fast_supported,
-	                                     priv->ap_support);
+	                                     priv->ap_support,
+	                                     priv->proxy);
 
 	priv->ifaces = g_slist_prepend (priv->ifaces, iface);
 	g_object_add_toggle_ref ((GObject *) iface, _sup_iface_last_ref, self);
@@ -223,6 +382,9 @@ update_capabilities (NMSupplicantManager *self)
 	}
 
 	_LOGD ("EAP-FAST is %ssupported", priv->fast_supported ? "" : "not ");
+
+	/* a new supplicant instance might have other features */
+	introspect_reset (self);
 }
 
 static void
@@ -318,6 +480,7 @@ name_owner_cb (GDBusProxy *proxy, GParamSpec *pspec, gpointer user_data)
 		set_running (self, FALSE);
 
 		priv->fast_supported = FALSE;
+		introspect_reset (self);
 	}
 
 	g_free (owner);
@@ -376,6 +539,7 @@ dispose (GObject *object)
 	GSList *ifaces;
 
 	nm_clear_g_source (&priv->die_count_reset_id);
+	introspect_reset (self);
 
 	if (priv->cancellable) {
 		g_cancellable_cancel (priv->cancellable);
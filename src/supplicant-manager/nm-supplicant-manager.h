@@ -49,6 +49,16 @@ GType nm_supplicant_manager_get_type (void);
 
 NMSupplicantManager *nm_supplicant_manager_get (void);
 
+typedef void (*NMSupplicantManagerIntrospectCallback) (NMSupplicantFeature ap_support,
+                                                       NMSupplicantFeature mac_randomization_support,
+                                                       gpointer user_data);
+
+void nm_supplicant_manager_introspect_interface (NMSupplicantManager *self,
+                                                 const char *object_path,
+                                                 GCancellable *cancellable,
+                                                 NMSupplicantManagerIntrospectCallback callback,
+                                                 gpointer user_data);
+
 NMSupplicantInterface *nm_supplicant_manager_create_interface (NMSupplicantManager *mgr,
                                                                const char *ifname,
                                                                gboolean is_wireless);
@@ -462,6 +462,108 @@ test_wifi_wpa_psk_types (void)
 	test_wifi_wpa_psk ("wifi-wep-psk-passphrase", TYPE_STRING, key2, (gconstpointer) key2, strlen (key2));
 }
 
+static void
+test_wifi_wpa_psk_roaming (void)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_object NMSupplicantConfig *config = NULL;
+	gs_unref_variant GVariant *config_dict = NULL;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	NMSettingWirelessSecurity *s_wsec;
+	NMSettingIPConfig *s_ip4;
+	char *uuid;
+	gboolean success;
+	GError *error = NULL;
+	GBytes *ssid;
+	const unsigned char ssid_data[] = { 0x54, 0x65, 0x73, 0x74, 0x20, 0x53, 0x53, 0x49, 0x44 };
+
+	connection = nm_simple_connection_new ();
+
+	/* Connection setting */
+	s_con = (NMSettingConnection *) nm_setting_connection_new ();
+	nm_connection_add_setting (connection, NM_SETTING (s_con));
+
+	uuid = nm_utils_uuid_generate ();
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, "Test Wifi Roaming",
+	              NM_SETTING_CONNECTION_UUID, uuid,
+	              NM_SETTING_CONNECTION_AUTOCONNECT, TRUE,
+	              NM_SETTING_CONNECTION_TYPE, NM_SETTING_WIRELESS_SETTING_NAME,
+	              NULL);
+	g_free (uuid);
+
+	/* Wifi setting */
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+	nm_connection_add_setting (connection, NM_SETTING (s_wifi));
+
+	ssid = g_bytes_new (ssid_data, sizeof (ssid_data));
+
+	g_object_set (s_wifi,
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NM_SETTING_WIRELESS_MODE, "infrastructure",
+	              NM_SETTING_WIRELESS_FAST_TRANSITION, TRUE,
+	              NM_SETTING_WIRELESS_BGSCAN, "simple:30:-70:86400",
+	              NULL);
+
+	g_bytes_unref (ssid);
+
+	/* Wifi Security setting */
+	s_wsec = (NMSettingWirelessSecurity *) nm_setting_wireless_security_new ();
+	nm_connection_add_setting (connection, NM_SETTING (s_wsec));
+
+	g_object_set (s_wsec,
+	              NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+	              NM_SETTING_WIRELESS_SECURITY_PSK, "r34lly l33t wp4 p4ssphr4s3 for t3st1ng",
+	              NULL);
+
+	/* IP4 setting */
+	s_ip4 = (NMSettingIPConfig *) nm_setting_ip4_config_new ();
+	nm_connection_add_setting (connection, NM_SETTING (s_ip4));
+
+	g_object_set (s_ip4, NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_AUTO, NULL);
+
+	success = nm_connection_verify (connection, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+
+	config = nm_supplicant_config_new ();
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO,
+	                       "*added 'ssid' value 'Test SSID'*");
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO,
+	                       "*added 'scan_ssid' value '1'*");
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO,
+	                       "*added 'bgscan' value 'simple:30:-70:86400'");
+	g_assert (nm_supplicant_config_add_setting_wireless (config,
+	                                                     s_wifi,
+	                                                     0,
+	                                                     NM_SUPPLICANT_FEATURE_UNKNOWN,
+	                                                     NM_SETTING_MAC_RANDOMIZATION_DEFAULT,
+	                                                     &error));
+	g_assert_no_error (error);
+	g_test_assert_expected_messages ();
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO,
+	                       "*added 'key_mgmt' value 'WPA-PSK FT-PSK'");
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO,
+	                       "*added 'psk' value *");
+	g_assert (nm_supplicant_config_add_setting_wireless_security (config,
+	                                                              s_wsec,
+	                                                              NULL,
+	                                                              "376aced7-b28c-46be-9a62-fcdf072571da",
+	                                                              1500,
+	                                                              &error));
+	g_assert_no_error (error);
+	g_test_assert_expected_messages ();
+
+	config_dict = nm_supplicant_config_to_variant (config);
+	g_assert (config_dict);
+
+	validate_opt ("wifi-wpa-psk-roaming", config_dict, "key_mgmt", TYPE_KEYWORD, "WPA-PSK FT-PSK", -1);
+	validate_opt ("wifi-wpa-psk-roaming", config_dict, "bgscan", TYPE_BYTES, "simple:30:-70:86400", strlen ("simple:30:-70:86400"));
+}
+
 static void
 test_wifi_eap (void)
 {
@@ -606,6 +708,86 @@ test_wifi_eap (void)
 	validate_opt ("wifi-eap", config_dict, "fragment_size", TYPE_INT, GINT_TO_POINTER(mtu-14), -1);
 }
 
+static NMSupplicantConfig *
+_psk_config (const char *bssid, const char *psk)
+{
+	NMSupplicantConfig *config;
+	gs_unref_object NMSettingWireless *s_wifi = NULL;
+	gs_unref_object NMSettingWirelessSecurity *s_wsec = NULL;
+	GError *error = NULL;
+	GBytes *ssid;
+	guint i;
+
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+	ssid = g_bytes_new ("Test SSID", 9);
+	g_object_set (s_wifi,
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NM_SETTING_WIRELESS_BSSID, bssid,
+	              NM_SETTING_WIRELESS_MODE, "infrastructure",
+	              NULL);
+	g_bytes_unref (ssid);
+
+	s_wsec = (NMSettingWirelessSecurity *) nm_setting_wireless_security_new ();
+	g_object_set (s_wsec,
+	              NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+	              NM_SETTING_WIRELESS_SECURITY_PSK, psk,
+	              NULL);
+
+	config = nm_supplicant_config_new ();
+
+	/* ssid, scan_ssid, bssid */
+	for (i = 0; i < 3; i++)
+		g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO, "*added *");
+	g_assert (nm_supplicant_config_add_setting_wireless (config,
+	                                                     s_wifi,
+	                                                     0,
+	                                                     NM_SUPPLICANT_FEATURE_UNKNOWN,
+	                                                     NM_SETTING_MAC_RANDOMIZATION_DEFAULT,
+	                                                     &error));
+	g_assert_no_error (error);
+	g_test_assert_expected_messages ();
+
+	/* key_mgmt, psk */
+	for (i = 0; i < 2; i++)
+		g_test_expect_message ("NetworkManager", G_LOG_LEVEL_INFO, "*added *");
+	g_assert (nm_supplicant_config_add_setting_wireless_security (config,
+	                                                              s_wsec,
+	                                                              NULL,
+	                                                              "376aced7-b28c-46be-9a62-fcdf072571da",
+	                                                              1500,
+	                                                              &error));
+	g_assert_no_error (error);
+	g_test_assert_expected_messages ();
+
+	return config;
+}
+
+static void
+test_config_equal (void)
+{
+	gs_unref_object NMSupplicantConfig *a = NULL;
+	gs_unref_object NMSupplicantConfig *b = NULL;
+	gs_unref_object NMSupplicantConfig *other_psk = NULL;
+	gs_unref_object NMSupplicantConfig *other_bssid = NULL;
+	gs_unref_object NMSupplicantConfig *empty = NULL;
+
+	a = _psk_config ("11:22:33:44:55:66", "r34lly l33t wp4 p4ssphr4s3");
+	b = _psk_config ("11:22:33:44:55:66", "r34lly l33t wp4 p4ssphr4s3");
+	other_psk = _psk_config ("11:22:33:44:55:66", "an0th3r wp4 p4ssphr4s3");
+	other_bssid = _psk_config ("11:22:33:44:55:77", "r34lly l33t wp4 p4ssphr4s3");
+	empty = nm_supplicant_config_new ();
+
+	g_assert (nm_supplicant_config_equal (a, a));
+	g_assert (nm_supplicant_config_equal (a, b));
+	g_assert (nm_supplicant_config_equal (b, a));
+
+	/* changed secrets must not reuse the old network */
+	g_assert (!nm_supplicant_config_equal (a, other_psk));
+	g_assert (!nm_supplicant_config_equal (a, other_bssid));
+	g_assert (!nm_supplicant_config_equal (a, empty));
+	g_assert (!nm_supplicant_config_equal (empty, a));
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -615,7 +797,9 @@ int main (int argc, char **argv)
 	g_test_add_func ("/supplicant-config/wifi-open", test_wifi_open);
 	g_test_add_func ("/supplicant-config/wifi-wep", test_wifi_wep);
 	g_test_add_func ("/supplicant-config/wifi-wpa-psk-types", test_wifi_wpa_psk_types);
+	g_test_add_func ("/supplicant-config/wifi-wpa-psk-roaming", test_wifi_wpa_psk_roaming);
 	g_test_add_func ("/supplicant-config/wifi-eap", test_wifi_eap);
+	g_test_add_func ("/supplicant-config/equal", test_config_equal);
 
 	return g_test_run ();
 }
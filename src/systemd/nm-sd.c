@@ -46,10 +46,28 @@ event_check (GSource *source)
 	return sd_event_wait (((SDEventSource *) source)->event, 0) > 0;
 }
 
+/* sd_event_dispatch() only dispatches one event source. When many of them
+ * are ready at the same time, like the timers of many DHCP clients, going
+ * through a full iteration of the GLib main loop for each of them is
+ * expensive. Dispatch up to that many of them at once. */
+#define EVENT_DISPATCH_MAX 64
+
 static gboolean
 event_dispatch (GSource *source, GSourceFunc callback, gpointer user_data)
 {
-	return sd_event_dispatch (((SDEventSource *)source)->event) > 0;
+	sd_event *event = ((SDEventSource *) source)->event;
+	guint i;
+
+	if (sd_event_dispatch (event) <= 0)
+		return G_SOURCE_REMOVE;
+
+	/* sd_event_run() with a zero timeout doesn't block. It
+	 * returns 0 when no other source is ready. */
+	for (i = 1; i < EVENT_DISPATCH_MAX; i++) {
+		if (sd_event_run (event, 0) <= 0)
+			break;
+	}
+	return G_SOURCE_CONTINUE;
 }
 
 static void
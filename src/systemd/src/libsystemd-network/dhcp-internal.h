@@ -39,6 +39,24 @@ int dhcp_network_send_raw_socket(int s, const union sockaddr_union *link,
 int dhcp_network_send_udp_socket(int s, be32_t address, uint16_t port,
                                  const void *packet, size_t len);
 
+/* NM: one packet socket shared by all clients, see dhcp-network.c */
+typedef struct DHCPSharedRawListener DHCPSharedRawListener;
+typedef int (*dhcp_shared_raw_handler_t)(DHCPMessage *message, size_t len, void *userdata);
+
+int dhcp_network_shared_raw_register(sd_event *event, int64_t priority,
+                                     int ifindex, union sockaddr_union *link,
+                                     uint32_t xid, const uint8_t *mac_addr,
+                                     size_t mac_addr_len, uint16_t arp_type,
+                                     dhcp_shared_raw_handler_t handler,
+                                     void *userdata,
+                                     DHCPSharedRawListener **ret);
+DHCPSharedRawListener *dhcp_network_shared_raw_unregister(DHCPSharedRawListener *listener);
+int dhcp_network_shared_raw_get_fd(DHCPSharedRawListener *listener);
+
+/* NM: exposed for the unit tests */
+void dhcp_network_shared_raw_set_open_func(int (*open_func)(void));
+int dhcp_network_shared_raw_deliver(int ifindex, DHCPPacket *packet, size_t len);
+
 int dhcp_option_append(DHCPMessage *message, size_t size, size_t *offset, uint8_t overload,
                        uint8_t code, size_t optlen, const void *optval);
 
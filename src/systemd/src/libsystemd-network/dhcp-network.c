@@ -29,10 +29,53 @@
 #include <linux/if_infiniband.h>
 #include <linux/if_packet.h>
 
+#include "sd-event.h"
+
 #include "dhcp-internal.h"
 #include "fd-util.h"
+#include "hashmap.h"
 #include "socket-util.h"
 
+static void _fill_link(union sockaddr_union *link, int ifindex, uint16_t arp_type,
+                       const uint8_t *bcast_addr, size_t mac_addr_len) {
+        link->ll.sll_family = AF_PACKET;
+        link->ll.sll_protocol = htons(ETH_P_IP);
+        link->ll.sll_ifindex = ifindex;
+        link->ll.sll_hatype = htons(arp_type);
+        link->ll.sll_halen = mac_addr_len;
+        memcpy(link->ll.sll_addr, bcast_addr, mac_addr_len);
+}
+
+static int _get_link_params(const uint8_t *mac_addr, size_t mac_addr_len,
+                            uint16_t arp_type, struct ether_addr *eth_mac,
+                            const uint8_t **bcast_addr, uint8_t *dhcp_hlen) {
+        static const uint8_t eth_bcast[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+        /* Default broadcast address for IPoIB */
+        static const uint8_t ib_bcast[] = {
+                0x00, 0xff, 0xff, 0xff, 0xff, 0x12, 0x40, 0x1b,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0xff, 0xff, 0xff, 0xff
+          };
+
+        assert_return(mac_addr_len > 0, -EINVAL);
+
+        memset(eth_mac, 0, sizeof(*eth_mac));
+
+        if (arp_type == ARPHRD_ETHER) {
+                assert_return(mac_addr_len == ETH_ALEN, -EINVAL);
+                memcpy(eth_mac, mac_addr, ETH_ALEN);
+                *bcast_addr = eth_bcast;
+                *dhcp_hlen = ETH_ALEN;
+        } else if (arp_type == ARPHRD_INFINIBAND) {
+                assert_return(mac_addr_len == INFINIBAND_ALEN, -EINVAL);
+                *bcast_addr = ib_bcast;
+                *dhcp_hlen = 0;
+        } else
+                return -EINVAL;
+
+        return 0;
+}
+
 static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
                             uint32_t xid, const uint8_t *mac_addr,
                             size_t mac_addr_len,
@@ -108,12 +151,7 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
         if (r < 0)
                 return -errno;
 
-        link->ll.sll_family = AF_PACKET;
-        link->ll.sll_protocol = htons(ETH_P_IP);
-        link->ll.sll_ifindex = ifindex;
-        link->ll.sll_hatype = htons(arp_type);
-        link->ll.sll_halen = mac_addr_len;
-        memcpy(link->ll.sll_addr, bcast_addr, mac_addr_len);
+        _fill_link(link, ifindex, arp_type, bcast_addr, mac_addr_len);
 
         r = bind(s, &link->sa, sizeof(link->ll));
         if (r < 0)
@@ -128,34 +166,376 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
 int dhcp_network_bind_raw_socket(int ifindex, union sockaddr_union *link,
                                  uint32_t xid, const uint8_t *mac_addr,
                                  size_t mac_addr_len, uint16_t arp_type) {
-        static const uint8_t eth_bcast[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
-        /* Default broadcast address for IPoIB */
-        static const uint8_t ib_bcast[] = {
-                0x00, 0xff, 0xff, 0xff, 0xff, 0x12, 0x40, 0x1b,
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0xff, 0xff, 0xff, 0xff
-          };
-        struct ether_addr eth_mac = { { 0, 0, 0, 0, 0, 0 } };
+        struct ether_addr eth_mac;
         const uint8_t *bcast_addr = NULL;
         uint8_t dhcp_hlen = 0;
+        int r;
 
-        assert_return(mac_addr_len > 0, -EINVAL);
-
-        if (arp_type == ARPHRD_ETHER) {
-                assert_return(mac_addr_len == ETH_ALEN, -EINVAL);
-                memcpy(&eth_mac, mac_addr, ETH_ALEN);
-                bcast_addr = eth_bcast;
-                dhcp_hlen = ETH_ALEN;
-        } else if (arp_type == ARPHRD_INFINIBAND) {
-                assert_return(mac_addr_len == INFINIBAND_ALEN, -EINVAL);
-                bcast_addr = ib_bcast;
-        } else
-                return -EINVAL;
+        r = _get_link_params(mac_addr, mac_addr_len, arp_type,
+                             &eth_mac, &bcast_addr, &dhcp_hlen);
+        if (r < 0)
+                return r;
 
         return _bind_raw_socket(ifindex, link, xid, mac_addr, mac_addr_len,
                                 bcast_addr, &eth_mac, arp_type, dhcp_hlen);
 }
 
+/* NM: instead of one packet socket per client, all clients can share a
+ * single packet socket that is not bound to an interface. Its kernel filter
+ * only accepts DHCP replies; they are demultiplexed in userspace by the
+ * receiving interface and the transaction id, and the checks that the
+ * per-client filter does on the hardware address are repeated there. */
+
+#define SHARED_RAW_BATCH_MAX 32
+
+struct DHCPSharedRawListener {
+        uint64_t key;
+        uint16_t arp_type;
+        uint8_t dhcp_hlen;
+        struct ether_addr eth_mac;
+        dhcp_shared_raw_handler_t handler;
+        void *userdata;
+};
+
+typedef struct DHCPSharedRaw {
+        unsigned n_ref;
+        int fd;
+        sd_event *event;
+        sd_event_source *receive_message;
+        Hashmap *listeners;
+
+        uint64_t n_received;
+        uint64_t n_delivered;
+        uint64_t n_unmatched;
+} DHCPSharedRaw;
+
+static DHCPSharedRaw *shared_raw;
+
+static uint64_t _shared_raw_key(int ifindex, uint32_t xid) {
+        return ((uint64_t) (uint32_t) ifindex << 32) | xid;
+}
+
+static void _shared_raw_unref(DHCPSharedRaw *shared) {
+        assert(shared);
+        assert(shared->n_ref > 0);
+
+        if (--shared->n_ref > 0)
+                return;
+
+        log_debug("DHCP shared raw socket: closed after %" PRIu64 " packets, "
+                  "%" PRIu64 " delivered, %" PRIu64 " unmatched",
+                  shared->n_received, shared->n_delivered, shared->n_unmatched);
+
+        sd_event_source_unref(shared->receive_message);
+        safe_close(shared->fd);
+        hashmap_free(shared->listeners);
+        sd_event_unref(shared->event);
+        if (shared_raw == shared)
+                shared_raw = NULL;
+        free(shared);
+}
+
+static int _shared_raw_deliver(DHCPSharedRaw *shared, int ifindex,
+                               DHCPPacket *packet, size_t len, bool checksum) {
+        DHCPSharedRawListener *listener;
+        uint64_t key;
+
+        if (len < sizeof(DHCPPacket))
+                return 0;
+
+        key = _shared_raw_key(ifindex, be32toh(packet->dhcp.xid));
+        listener = hashmap_get(shared->listeners, &key);
+        if (!listener ||
+            packet->dhcp.htype != listener->arp_type ||
+            packet->dhcp.hlen != listener->dhcp_hlen ||
+            memcmp(packet->dhcp.chaddr, &listener->eth_mac, ETH_ALEN) != 0) {
+                shared->n_unmatched++;
+                return 0;
+        }
+
+        if (dhcp_packet_verify_headers(packet, len, checksum) < 0)
+                return 0;
+
+        shared->n_delivered++;
+        listener->handler(&packet->dhcp, len - DHCP_IP_UDP_SIZE, listener->userdata);
+        return 1;
+}
+
+static int _shared_raw_receive_one(DHCPSharedRaw *shared) {
+        _cleanup_free_ DHCPPacket *packet = NULL;
+        uint8_t cmsgbuf[CMSG_LEN(sizeof(struct tpacket_auxdata))];
+        union sockaddr_union sa = {};
+        struct iovec iov = {};
+        struct msghdr msg = {
+                .msg_name = &sa,
+                .msg_namelen = sizeof(sa),
+                .msg_iov = &iov,
+                .msg_iovlen = 1,
+                .msg_control = cmsgbuf,
+                .msg_controllen = sizeof(cmsgbuf),
+        };
+        struct cmsghdr *cmsg;
+        bool checksum = true;
+        ssize_t buflen, len;
+
+        buflen = next_datagram_size_fd(shared->fd);
+        if (buflen < 0)
+                return buflen == -EAGAIN ? 0 : (int) buflen;
+
+        packet = malloc0(buflen);
+        if (!packet)
+                return -ENOMEM;
+
+        iov.iov_base = packet;
+        iov.iov_len = buflen;
+
+        len = recvmsg(shared->fd, &msg, 0);
+        if (len < 0) {
+                if (errno == EAGAIN || errno == EINTR)
+                        return 0;
+                return -errno;
+        }
+
+        shared->n_received++;
+
+        CMSG_FOREACH(cmsg, &msg) {
+                if (cmsg->cmsg_level == SOL_PACKET &&
+                    cmsg->cmsg_type == PACKET_AUXDATA &&
+                    cmsg->cmsg_len == CMSG_LEN(sizeof(struct tpacket_auxdata))) {
+                        struct tpacket_auxdata *aux = (struct tpacket_auxdata*)CMSG_DATA(cmsg);
+
+                        checksum = !(aux->tp_status & TP_STATUS_CSUMNOTREADY);
+                        break;
+                }
+        }
+
+        _shared_raw_deliver(shared, sa.ll.sll_ifindex, packet, len, checksum);
+        return 1;
+}
+
+static int _shared_raw_receive(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        DHCPSharedRaw *shared = userdata;
+        unsigned i;
+        int r;
+
+        /* a handler may unregister the last listener */
+        shared->n_ref++;
+
+        for (i = 0; i < SHARED_RAW_BATCH_MAX; i++) {
+                r = _shared_raw_receive_one(shared);
+                if (r < 0)
+                        log_debug_errno(r, "DHCP shared raw socket: could not receive message: %m");
+                if (r <= 0 || shared->n_ref == 1)
+                        break;
+        }
+
+        _shared_raw_unref(shared);
+        return 0;
+}
+
+static int _shared_raw_open_socket(void) {
+        /* like the per-client filter in _bind_raw_socket(), without the
+         * hardware type, transaction id and hardware address checks */
+        struct sock_filter filter[] = {
+                BPF_STMT(BPF_LD + BPF_W + BPF_LEN, 0),                                 /* A <- packet length */
+                BPF_JUMP(BPF_JMP + BPF_JGE + BPF_K, sizeof(DHCPPacket), 1, 0),         /* packet >= DHCPPacket ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, ip.protocol)), /* A <- IP protocol */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, IPPROTO_UDP, 1, 0),                /* IP protocol == UDP ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, ip.frag_off)), /* A <- Flags */
+                BPF_STMT(BPF_ALU + BPF_AND + BPF_K, 0x20),                             /* A <- A & 0x20 (More Fragments bit) */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, 0, 1, 0),                          /* A == 0 ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_H + BPF_ABS, offsetof(DHCPPacket, ip.frag_off)), /* A <- Flags + Fragment offset */
+                BPF_STMT(BPF_ALU + BPF_AND + BPF_K, 0x1fff),                           /* A <- A & 0x1fff (Fragment offset) */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, 0, 1, 0),                          /* A == 0 ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_H + BPF_ABS, offsetof(DHCPPacket, udp.dest)),    /* A <- UDP destination port */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, DHCP_PORT_CLIENT, 1, 0),           /* UDP destination port == DHCP client port ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, dhcp.op)),     /* A <- DHCP op */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, BOOTREPLY, 1, 0),                  /* op == BOOTREPLY ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_W + BPF_ABS, offsetof(DHCPPacket, dhcp.magic)),  /* A <- DHCP magic cookie */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, DHCP_MAGIC_COOKIE, 1, 0),          /* cookie == DHCP magic cookie ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_RET + BPF_K, 65535),                                      /* return all */
+        };
+        struct sock_fprog fprog = {
+                .len = ELEMENTSOF(filter),
+                .filter = filter
+        };
+        union sockaddr_union link = {
+                .ll.sll_family = AF_PACKET,
+                .ll.sll_protocol = htons(ETH_P_IP),
+                /* sll_ifindex 0: receive from all interfaces */
+        };
+        _cleanup_close_ int s = -1;
+        int r, on = 1;
+
+        s = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (s < 0)
+                return -errno;
+
+        r = setsockopt(s, SOL_PACKET, PACKET_AUXDATA, &on, sizeof(on));
+        if (r < 0)
+                return -errno;
+
+        r = setsockopt(s, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+        if (r < 0)
+                return -errno;
+
+        r = bind(s, &link.sa, sizeof(link.ll));
+        if (r < 0)
+                return -errno;
+
+        r = s;
+        s = -1;
+        return r;
+}
+
+static int (*shared_raw_open)(void) = _shared_raw_open_socket;
+
+static int _shared_raw_new(sd_event *event, int64_t priority, DHCPSharedRaw **ret) {
+        _cleanup_close_ int s = -1;
+        DHCPSharedRaw *shared;
+        int r;
+
+        s = shared_raw_open();
+        if (s < 0)
+                return s;
+
+        shared = new0(DHCPSharedRaw, 1);
+        if (!shared)
+                return -ENOMEM;
+
+        shared->fd = -1;
+        shared->listeners = hashmap_new(&uint64_hash_ops);
+        if (!shared->listeners) {
+                free(shared);
+                return -ENOMEM;
+        }
+
+        r = sd_event_add_io(event, &shared->receive_message, s, EPOLLIN,
+                            _shared_raw_receive, shared);
+        if (r >= 0)
+                r = sd_event_source_set_priority(shared->receive_message, priority);
+        if (r >= 0)
+                r = sd_event_source_set_description(shared->receive_message, "dhcp4-shared-receive-message");
+        if (r < 0) {
+                sd_event_source_unref(shared->receive_message);
+                hashmap_free(shared->listeners);
+                free(shared);
+                return r;
+        }
+
+        shared->event = sd_event_ref(event);
+        shared->fd = s;
+        s = -1;
+
+        log_debug("DHCP shared raw socket: opened");
+
+        *ret = shared;
+        return 0;
+}
+
+int dhcp_network_shared_raw_register(sd_event *event, int64_t priority,
+                                     int ifindex, union sockaddr_union *link,
+                                     uint32_t xid, const uint8_t *mac_addr,
+                                     size_t mac_addr_len, uint16_t arp_type,
+                                     dhcp_shared_raw_handler_t handler,
+                                     void *userdata,
+                                     DHCPSharedRawListener **ret) {
+        _cleanup_free_ DHCPSharedRawListener *listener = NULL;
+        const uint8_t *bcast_addr = NULL;
+        int r;
+
+        assert_return(event, -EINVAL);
+        assert_return(ifindex > 0, -EINVAL);
+        assert_return(link, -EINVAL);
+        assert_return(handler, -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        /* the socket is dispatched from a single event loop */
+        if (shared_raw && shared_raw->event != event)
+                return -EBUSY;
+
+        listener = new0(DHCPSharedRawListener, 1);
+        if (!listener)
+                return -ENOMEM;
+
+        r = _get_link_params(mac_addr, mac_addr_len, arp_type, &listener->eth_mac,
+                             &bcast_addr, &listener->dhcp_hlen);
+        if (r < 0)
+                return r;
+
+        listener->key = _shared_raw_key(ifindex, xid);
+        listener->arp_type = arp_type;
+        listener->handler = handler;
+        listener->userdata = userdata;
+
+        if (!shared_raw) {
+                r = _shared_raw_new(event, priority, &shared_raw);
+                if (r < 0)
+                        return r;
+        }
+
+        r = hashmap_put(shared_raw->listeners, &listener->key, listener);
+        if (r < 0) {
+                if (shared_raw->n_ref == 0) {
+                        shared_raw->n_ref++;
+                        _shared_raw_unref(shared_raw);
+                }
+                return r;
+        }
+        shared_raw->n_ref++;
+
+        _fill_link(link, ifindex, arp_type, bcast_addr, mac_addr_len);
+
+        *ret = listener;
+        listener = NULL;
+
+        return 0;
+}
+
+DHCPSharedRawListener *dhcp_network_shared_raw_unregister(DHCPSharedRawListener *listener) {
+        if (!listener)
+                return NULL;
+
+        assert(shared_raw);
+
+        hashmap_remove(shared_raw->listeners, &listener->key);
+        free(listener);
+        _shared_raw_unref(shared_raw);
+
+        return NULL;
+}
+
+int dhcp_network_shared_raw_get_fd(DHCPSharedRawListener *listener) {
+        assert(listener);
+        assert(shared_raw);
+
+        return shared_raw->fd;
+}
+
+/* NM: for the unit tests, which cannot open packet sockets. @open_func
+ * returns a pollable file descriptor that stands in for the shared socket;
+ * packets are then passed in with dhcp_network_shared_raw_deliver(). */
+void dhcp_network_shared_raw_set_open_func(int (*open_func)(void)) {
+        shared_raw_open = open_func ? open_func : _shared_raw_open_socket;
+}
+
+int dhcp_network_shared_raw_deliver(int ifindex, DHCPPacket *packet, size_t len) {
+        assert_return(packet, -EINVAL);
+
+        if (!shared_raw)
+                return -ENOENT;
+
+        shared_raw->n_received++;
+        return _shared_raw_deliver(shared_raw, ifindex, packet, len, true);
+}
+
 int dhcp_network_bind_udp_socket(be32_t address, uint16_t port) {
         union sockaddr_union src = {
                 .in.sin_family = AF_INET,
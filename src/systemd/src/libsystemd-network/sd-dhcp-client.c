@@ -107,6 +107,12 @@ struct sd_dhcp_client {
         void *userdata;
         sd_dhcp_lease *lease;
         usec_t start_delay;
+        /* NM: receive over the shared packet socket instead of client->fd */
+        bool shared_raw;
+        DHCPSharedRawListener *shared_raw_listener;
+        /* NM: delay T1 and T2 by up to this percentage of the time to the
+         * next timeout, so that clients don't renew in sync */
+        unsigned renewal_jitter;
 };
 
 static const uint8_t default_req_opts[] = {
@@ -127,6 +133,10 @@ static int client_receive_message_udp(
                 int fd,
                 uint32_t revents,
                 void *userdata);
+static int client_receive_message_shared(
+                DHCPMessage *message,
+                size_t len,
+                void *userdata);
 static void client_stop(sd_dhcp_client *client, int error);
 
 int sd_dhcp_client_set_callback(
@@ -428,6 +438,25 @@ int sd_dhcp_client_set_vendor_class_identifier(
         return 0;
 }
 
+int sd_dhcp_client_set_shared_raw_socket(sd_dhcp_client *client, int b) {
+        assert_return(client, -EINVAL);
+        assert_return(IN_SET(client->state, DHCP_STATE_INIT,
+                             DHCP_STATE_STOPPED), -EBUSY);
+
+        client->shared_raw = b;
+
+        return 0;
+}
+
+int sd_dhcp_client_set_renewal_jitter(sd_dhcp_client *client, unsigned percent) {
+        assert_return(client, -EINVAL);
+        assert_return(percent <= 50, -EINVAL);
+
+        client->renewal_jitter = percent;
+
+        return 0;
+}
+
 int sd_dhcp_client_set_mtu(sd_dhcp_client *client, uint32_t mtu) {
         assert_return(client, -EINVAL);
         assert_return(mtu >= DHCP_DEFAULT_MIN_SIZE, -ERANGE);
@@ -463,6 +492,7 @@ static int client_initialize(sd_dhcp_client *client) {
                 sd_event_source_unref(client->receive_message);
 
         client->fd = asynchronous_close(client->fd);
+        client->shared_raw_listener = dhcp_network_shared_raw_unregister(client->shared_raw_listener);
 
         client->timeout_resend = sd_event_source_unref(client->timeout_resend);
 
@@ -672,8 +702,10 @@ static int dhcp_client_send_raw(
         dhcp_packet_append_ip_headers(packet, INADDR_ANY, DHCP_PORT_CLIENT,
                                       INADDR_BROADCAST, DHCP_PORT_SERVER, len);
 
-        return dhcp_network_send_raw_socket(client->fd, &client->link,
-                                            packet, len);
+        return dhcp_network_send_raw_socket(client->shared_raw_listener
+                                            ? dhcp_network_shared_raw_get_fd(client->shared_raw_listener)
+                                            : client->fd,
+                                            &client->link, packet, len);
 }
 
 static int client_send_discover(sd_dhcp_client *client) {
@@ -1094,12 +1126,41 @@ error:
 }
 
 static int client_initialize_events(sd_dhcp_client *client, sd_event_io_handler_t io_callback) {
-        client_initialize_io_events(client, io_callback);
+        /* with the shared packet socket, there is no client->fd to watch */
+        if (client->fd >= 0)
+                client_initialize_io_events(client, io_callback);
         client_initialize_time_events(client);
 
         return 0;
 }
 
+static int client_bind_raw(sd_dhcp_client *client) {
+        int r;
+
+        if (client->shared_raw) {
+                r = dhcp_network_shared_raw_register(client->event, client->event_priority,
+                                                     client->index, &client->link,
+                                                     client->xid, client->mac_addr,
+                                                     client->mac_addr_len, client->arp_type,
+                                                     client_receive_message_shared, client,
+                                                     &client->shared_raw_listener);
+                if (r >= 0)
+                        return 0;
+
+                log_dhcp_client(client, "could not use shared raw socket, open a private one: %s",
+                                strerror(-r));
+        }
+
+        r = dhcp_network_bind_raw_socket(client->index, &client->link,
+                                         client->xid, client->mac_addr,
+                                         client->mac_addr_len, client->arp_type);
+        if (r < 0)
+                return r;
+        client->fd = r;
+
+        return 0;
+}
+
 static int client_start_delayed(sd_dhcp_client *client) {
         int r;
 
@@ -1107,20 +1168,18 @@ static int client_start_delayed(sd_dhcp_client *client) {
         assert_return(client->event, -EINVAL);
         assert_return(client->index > 0, -EINVAL);
         assert_return(client->fd < 0, -EBUSY);
+        assert_return(!client->shared_raw_listener, -EBUSY);
         assert_return(client->xid == 0, -EINVAL);
         assert_return(client->state == DHCP_STATE_INIT ||
                       client->state == DHCP_STATE_INIT_REBOOT, -EBUSY);
 
         client->xid = random_u32();
 
-        r = dhcp_network_bind_raw_socket(client->index, &client->link,
-                                         client->xid, client->mac_addr,
-                                         client->mac_addr_len, client->arp_type);
+        r = client_bind_raw(client);
         if (r < 0) {
                 client_stop(client, r);
                 return r;
         }
-        client->fd = r;
 
         if (client->state == DHCP_STATE_INIT || client->state == DHCP_STATE_INIT_REBOOT)
                 client->start_time = now(clock_boottime_or_monotonic());
@@ -1161,14 +1220,11 @@ static int client_timeout_t2(sd_event_source *s, uint64_t usec, void *userdata)
         client->state = DHCP_STATE_REBINDING;
         client->attempt = 1;
 
-        r = dhcp_network_bind_raw_socket(client->index, &client->link,
-                                         client->xid, client->mac_addr,
-                                         client->mac_addr_len, client->arp_type);
+        r = client_bind_raw(client);
         if (r < 0) {
                 client_stop(client, r);
                 return 0;
         }
-        client->fd = r;
 
         return client_initialize_events(client, client_receive_message_raw);
 }
@@ -1330,6 +1386,19 @@ static uint64_t client_compute_timeout(sd_dhcp_client *client, uint32_t lifetime
                 + (random_u32() & 0x1fffff);
 }
 
+static uint64_t client_jitter_timeout(uint64_t timeout, uint64_t next, unsigned percent) {
+        uint64_t window;
+
+        if (next <= timeout)
+                return timeout;
+
+        window = (next - timeout) / 100 * percent;
+        if (window == 0)
+                return timeout;
+
+        return timeout + random_u64() % window;
+}
+
 static int client_set_lease_timeouts(sd_dhcp_client *client) {
         usec_t time_now;
         uint64_t lifetime_timeout;
@@ -1400,6 +1469,11 @@ static int client_set_lease_timeouts(sd_dhcp_client *client) {
                 client->lease->t2 = (client->lease->lifetime * 7) / 8;
         }
 
+        if (client->renewal_jitter > 0) {
+                t1_timeout = client_jitter_timeout(t1_timeout, t2_timeout, client->renewal_jitter);
+                t2_timeout = client_jitter_timeout(t2_timeout, lifetime_timeout, client->renewal_jitter);
+        }
+
         /* arm lifetime timeout */
         r = sd_event_add_time(client->event, &client->timeout_expire,
                               clock_boottime_or_monotonic(),
@@ -1530,6 +1604,8 @@ static int client_handle_message(sd_dhcp_client *client, DHCPMessage *message, i
                         client->receive_message =
                                 sd_event_source_unref(client->receive_message);
                         client->fd = asynchronous_close(client->fd);
+                        client->shared_raw_listener =
+                                dhcp_network_shared_raw_unregister(client->shared_raw_listener);
 
                         if (IN_SET(client->state, DHCP_STATE_REQUESTING,
                                    DHCP_STATE_REBOOTING))
@@ -1702,6 +1778,18 @@ static int client_receive_message_udp(
         return client_handle_message(client, message, len);
 }
 
+static int client_receive_message_shared(
+                DHCPMessage *message,
+                size_t len,
+                void *userdata) {
+
+        sd_dhcp_client *client = userdata;
+
+        assert(client);
+
+        return client_handle_message(client, message, len);
+}
+
 static int client_receive_message_raw(
                 sd_event_source *s,
                 int fd,
@@ -123,6 +123,12 @@ int sd_dhcp_client_get_client_id(
                 uint8_t *type,
                 const uint8_t **data,
                 size_t *data_len);
+int sd_dhcp_client_set_shared_raw_socket(
+                sd_dhcp_client *client,
+                int b);
+int sd_dhcp_client_set_renewal_jitter(
+                sd_dhcp_client *client,
+                unsigned percent);
 int sd_dhcp_client_set_mtu(
                 sd_dhcp_client *client,
                 uint32_t mtu);
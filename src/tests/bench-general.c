@@ -0,0 +1,254 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager core utilities benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Measures nm_ip4_config_merge() and the nm_match_spec_*() functions on
+ * generated configurations and spec lists.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+#include <arpa/inet.h>
+
+#include "nm-ip4-config.h"
+#include "nm-platform.h"
+
+#include "nm-test-utils-core.h"
+#include "nm-bench-utils.h"
+
+static struct {
+	int iterations;
+	int items;
+	int specs;
+} global_opt = {
+	.iterations = 1000,
+	.items = 100,
+	.specs = 50,
+};
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &global_opt.iterations, "Number of times each operation is repeated", "N" },
+		{ "items", 'm', 0, G_OPTION_ARG_INT, &global_opt.items, "Number of addresses, routes and nameservers per IP configuration", "M" },
+		{ "specs", 's', 0, G_OPTION_ARG_INT, &global_opt.specs, "Number of entries per match spec list", "S" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark IP configuration merging and device match specs.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.iterations <= 0
+	    || global_opt.items < 0
+	    || global_opt.items > 0xFFFF
+	    || global_opt.specs < 0
+	    || global_opt.specs > 0xFFFF) {
+		g_warning ("Invalid arguments: iterations must be positive, items and specs within 0..65535");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static NMIP4Config *
+create_ip4_config (guint32 base)
+{
+	NMIP4Config *config;
+	int i;
+
+	config = nm_ip4_config_new (1);
+	for (i = 0; i < global_opt.items; i++) {
+		NMPlatformIP4Address addr = {
+			.address = htonl (base + (i << 8) + 2),
+			.peer_address = htonl (base + (i << 8) + 2),
+			.plen = 24,
+			.timestamp = 0,
+			.lifetime = NM_PLATFORM_LIFETIME_PERMANENT,
+			.preferred = NM_PLATFORM_LIFETIME_PERMANENT,
+			.addr_source = NM_IP_CONFIG_SOURCE_USER,
+		};
+		NMPlatformIP4Route route = {
+			.network = htonl (0xAC100000u + (i << 8)),
+			.plen = 24,
+			.gateway = htonl (base + 1),
+			.metric = 100,
+			.rt_source = NM_IP_CONFIG_SOURCE_USER,
+		};
+		char domain[64];
+
+		nm_ip4_config_add_address (config, &addr);
+		nm_ip4_config_add_route (config, &route);
+		nm_ip4_config_add_nameserver (config, htonl (0xC0A80001u + i));
+		nm_sprintf_buf (domain, "bench%d.example.com", i);
+		nm_ip4_config_add_domain (config, domain);
+		nm_ip4_config_add_search (config, domain);
+	}
+	nm_ip4_config_set_gateway (config, htonl (base + 1));
+	return config;
+}
+
+static void
+bench_ip4_config_merge (void)
+{
+	gs_unref_object NMIP4Config *src = NULL;
+	gs_unref_object NMIP4Config *other = NULL;
+	NMBenchTimer timer;
+	int i;
+
+	src = create_ip4_config (0x0A000000u);
+	other = create_ip4_config (0x0B000000u);
+
+	nm_bench_timer_start (&timer, "ip4-config-merge");
+	for (i = 0; i < global_opt.iterations; i++) {
+		gs_unref_object NMIP4Config *dst = nm_ip4_config_new (1);
+
+		nm_ip4_config_merge (dst, src, NM_IP_CONFIG_MERGE_DEFAULT);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	/* merging a config into one that has the same entries
+	 * already only finds duplicates. */
+	nm_bench_timer_start (&timer, "ip4-config-merge-duplicate");
+	for (i = 0; i < global_opt.iterations; i++) {
+		gs_unref_object NMIP4Config *dst = create_ip4_config (0x0A000000u);
+
+		nm_ip4_config_merge (dst, src, NM_IP_CONFIG_MERGE_DEFAULT);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "ip4-config-merge-disjoint");
+	for (i = 0; i < global_opt.iterations; i++) {
+		gs_unref_object NMIP4Config *dst = create_ip4_config (0x0A000000u);
+
+		nm_ip4_config_merge (dst, other, NM_IP_CONFIG_MERGE_DEFAULT);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+}
+
+/*****************************************************************************/
+
+static GSList *
+create_specs (void)
+{
+	GSList *specs = NULL;
+	int i;
+
+	for (i = 0; i < global_opt.specs; i++) {
+		switch (i % 4) {
+		case 0:
+			specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:eth%d", i));
+			break;
+		case 1:
+			specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:wlan%d*", i));
+			break;
+		case 2:
+			specs = g_slist_prepend (specs, g_strdup_printf ("mac:02:00:00:00:%02x:%02x", (i >> 8) & 0xFF, i & 0xFF));
+			break;
+		default:
+			specs = g_slist_prepend (specs, g_strdup_printf ("except:interface-name:veth%d", i));
+			break;
+		}
+	}
+	specs = g_slist_prepend (specs, g_strdup ("type:bond"));
+	return g_slist_reverse (specs);
+}
+
+static void
+bench_match_spec (void)
+{
+	GSList *specs;
+	NMMatchSpecCompiled *compiled;
+	NMBenchTimer timer;
+	int i;
+
+	specs = create_specs ();
+
+	/* the device doesn't match anything, so that every
+	 * entry of the list is looked at. */
+	nm_bench_timer_start (&timer, "match-spec-interface-name");
+	for (i = 0; i < global_opt.iterations; i++) {
+		nm_match_spec_interface_name (specs, "enp0s25");
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "match-spec-hwaddr");
+	for (i = 0; i < global_opt.iterations; i++) {
+		nm_match_spec_hwaddr (specs, "02:00:00:ff:ff:ff");
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "match-spec-device-type");
+	for (i = 0; i < global_opt.iterations; i++) {
+		nm_match_spec_device_type (specs, "ethernet");
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "match-spec-compile");
+	for (i = 0; i < global_opt.iterations; i++) {
+		compiled = nm_match_spec_compile (specs);
+		nm_match_spec_compiled_free (compiled);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	compiled = nm_match_spec_compile (specs);
+	nm_bench_timer_start (&timer, "match-spec-compiled");
+	for (i = 0; i < global_opt.iterations; i++) {
+		nm_match_spec_compiled_match (compiled, "enp0s25", "02:00:00:ff:ff:ff", "ethernet", NULL);
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+	nm_match_spec_compiled_free (compiled);
+
+	g_slist_free_full (specs, g_free);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, "ERR", "ALL");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	g_print ("# iterations=%d items=%d specs=%d\n", global_opt.iterations, global_opt.items, global_opt.specs);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	bench_ip4_config_merge ();
+	bench_match_spec ();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager multi-index benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Measures add, lookup, move and remove throughput of NMMultiIndex with
+ * a configurable number of values per id.
+ */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+
+#include "nm-multi-index.h"
+
+#include "nm-test-utils-core.h"
+#include "nm-bench-utils.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int iterations;
+	int ids;
+	int values;
+} global_opt = {
+	.iterations = 20,
+	.ids = 200,
+	.values = 20000,
+};
+
+typedef struct {
+	union {
+		NMMultiIndexId id_base;
+		guint bucket;
+	};
+} BenchId;
+
+/*****************************************************************************/
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionEntry options[] = {
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &global_opt.iterations, "Number of times each phase is repeated", "N" },
+		{ "ids", 'i', 0, G_OPTION_ARG_INT, &global_opt.ids, "Number of distinct ids", "I" },
+		{ "values", 'm', 0, G_OPTION_ARG_INT, &global_opt.values, "Number of values", "M" },
+		{ 0 },
+	};
+
+	if (!nm_bench_parse_options (argc, argv,
+	                             "Benchmark the add/remove/move throughput of NMMultiIndex.",
+	                             options))
+		return FALSE;
+
+	if (   global_opt.iterations <= 0
+	    || global_opt.ids <= 0
+	    || global_opt.values <= 0) {
+		g_warning ("Invalid arguments: iterations, ids and values must be positive");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static guint
+_id_hash (const BenchId *id)
+{
+	return id->bucket;
+}
+
+static gboolean
+_id_equal (const BenchId *a, const BenchId *b)
+{
+	return a->bucket == b->bucket;
+}
+
+static BenchId *
+_id_clone (const BenchId *id)
+{
+	return g_memdup (id, sizeof (*id));
+}
+
+static void
+_id_destroy (BenchId *id)
+{
+	g_free (id);
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+	NMMultiIndex *index;
+	gs_free guint *buckets = NULL;
+	NMBenchTimer timer;
+	BenchId id, id_new;
+	int i, j;
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	g_print ("# iterations=%d ids=%d values=%d\n", global_opt.iterations, global_opt.ids, global_opt.values);
+	g_print ("# phase\tops\tusec\tnsec/op\n");
+
+	index = nm_multi_index_new ((NMMultiIndexFuncHash) _id_hash,
+	                            (NMMultiIndexFuncEqual) _id_equal,
+	                            (NMMultiIndexFuncClone) _id_clone,
+	                            (NMMultiIndexFuncDestroy) _id_destroy);
+
+	/* the values are the (non-NULL) pointers 1..values. */
+	buckets = g_new (guint, global_opt.values);
+	for (j = 0; j < global_opt.values; j++)
+		buckets[j] = nmtst_get_rand_int () % global_opt.ids;
+
+	nm_bench_timer_start (&timer, "add");
+	for (i = 0; i < global_opt.iterations; i++) {
+		for (j = 0; j < global_opt.values; j++) {
+			id.bucket = buckets[j];
+			if (!nm_multi_index_add (index, &id.id_base, GUINT_TO_POINTER (j + 1)))
+				g_assert_not_reached ();
+			timer.ops++;
+		}
+		if (i + 1 == global_opt.iterations)
+			break;
+		for (j = 0; j < global_opt.values; j++) {
+			id.bucket = buckets[j];
+			nm_multi_index_remove (index, &id.id_base, GUINT_TO_POINTER (j + 1));
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "contains");
+	for (i = 0; i < global_opt.iterations; i++) {
+		for (j = 0; j < global_opt.values; j++) {
+			id.bucket = buckets[j];
+			if (!nm_multi_index_contains (index, &id.id_base, GUINT_TO_POINTER (j + 1)))
+				g_assert_not_reached ();
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "lookup");
+	for (i = 0; i < global_opt.iterations; i++) {
+		for (j = 0; j < global_opt.ids; j++) {
+			id.bucket = j;
+			nm_multi_index_lookup (index, &id.id_base, NULL);
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "move");
+	for (i = 0; i < global_opt.iterations; i++) {
+		for (j = 0; j < global_opt.values; j++) {
+			id.bucket = buckets[j];
+			id_new.bucket = (buckets[j] + 1) % global_opt.ids;
+			nm_multi_index_move (index, &id.id_base, &id_new.id_base, GUINT_TO_POINTER (j + 1));
+			buckets[j] = id_new.bucket;
+			timer.ops++;
+		}
+	}
+	nm_bench_timer_stop (&timer);
+
+	nm_bench_timer_start (&timer, "remove");
+	for (j = 0; j < global_opt.values; j++) {
+		id.bucket = buckets[j];
+		if (!nm_multi_index_remove (index, &id.id_base, GUINT_TO_POINTER (j + 1)))
+			g_assert_not_reached ();
+		timer.ops++;
+	}
+	nm_bench_timer_stop (&timer);
+
+	g_assert_cmpint (nm_multi_index_get_num_groups (index), ==, 0);
+	nm_multi_index_free (index);
+
+	return EXIT_SUCCESS;
+}
@@ -764,6 +764,21 @@ _set_values_intern_atomic_section_2_check (NMConfig *config, NMConfigData *confi
 	assert_config_value (config_data, NM_CONFIG_KEYFILE_GROUPPREFIX_INTERN"with-whitespace", "key2", " b c\\,  d  ");
 }
 
+static void
+_set_values_user_ignore_carrier_set (NMConfig *config, gboolean set_user, GKeyFile *keyfile, NMConfigChangeFlags *out_expected_changes)
+{
+	g_key_file_set_string (keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "ignore-carrier", "interface-name:eth*");
+	*out_expected_changes = NM_CONFIG_CHANGE_VALUES | NM_CONFIG_CHANGE_VALUES_USER | NM_CONFIG_CHANGE_IGNORE_CARRIER;
+}
+
+static void
+_set_values_user_ignore_carrier_check (NMConfig *config, NMConfigData *config_data, gboolean is_change_event, NMConfigChangeFlags changes, NMConfigData *old_data)
+{
+	if (is_change_event)
+		g_assert (changes == (NM_CONFIG_CHANGE_VALUES | NM_CONFIG_CHANGE_VALUES_USER | NM_CONFIG_CHANGE_IGNORE_CARRIER));
+	assert_config_value (config_data, NM_CONFIG_KEYFILE_GROUP_MAIN, "ignore-carrier", "interface-name:eth*");
+}
+
 static void
 test_config_set_values (void)
 {
@@ -809,6 +824,10 @@ test_config_set_values (void)
 	                    _set_values_intern_atomic_section_2_set,
 	                    _set_values_intern_atomic_section_2_check);
 
+	_set_values_user (config, CONFIG_USER,
+	                  _set_values_user_ignore_carrier_set,
+	                  _set_values_user_ignore_carrier_check);
+
 	g_assert (remove (CONFIG_USER) == 0);
 	g_assert (remove (CONFIG_INTERN) == 0);
 }
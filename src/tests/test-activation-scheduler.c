@@ -0,0 +1,226 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-activation-scheduler.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+/* the names of the started devices, separated by " " */
+static GString *started;
+
+static void
+_start_cb (NMDevice *device)
+{
+	if (started->len)
+		g_string_append_c (started, ' ');
+	g_string_append (started, g_object_get_data (G_OBJECT (device), "name"));
+}
+
+static GObject *
+_device_new (const char *name)
+{
+	GObject *obj;
+
+	obj = g_object_new (G_TYPE_OBJECT, NULL);
+	g_object_set_data_full (obj, "name", g_strdup (name), g_free);
+	return obj;
+}
+
+static void
+_request (NMActivationScheduler *sched, GObject *device, int priority)
+{
+	_nm_activation_scheduler_request (sched, device,
+	                                  g_object_get_data (device, "name"),
+	                                  priority, _start_cb);
+}
+
+static void
+_release (NMActivationScheduler *sched, GObject *device)
+{
+	nm_activation_scheduler_release (sched, (NMDevice *) device);
+}
+
+#define _assert_started(expected) \
+	G_STMT_START { \
+		g_assert_cmpstr (started->str, ==, (expected)); \
+		g_string_truncate (started, 0); \
+	} G_STMT_END
+
+static NMActivationScheduler *
+_setup (guint max_concurrent)
+{
+	NMActivationScheduler *sched;
+
+	started = g_string_new (NULL);
+	sched = g_object_new (NM_TYPE_ACTIVATION_SCHEDULER, NULL);
+	nm_activation_scheduler_set_max_concurrent (sched, max_concurrent);
+	return sched;
+}
+
+static void
+_teardown (NMActivationScheduler *sched)
+{
+	g_object_unref (sched);
+	g_string_free (started, TRUE);
+	started = NULL;
+}
+
+/*****************************************************************************/
+
+static void
+test_limit (void)
+{
+	NMActivationScheduler *sched;
+	GObject *a, *b, *c, *d;
+
+	sched = _setup (2);
+	a = _device_new ("a");
+	b = _device_new ("b");
+	c = _device_new ("c");
+	d = _device_new ("d");
+
+	_request (sched, a, 0);
+	_request (sched, b, 0);
+	_assert_started ("a b");
+
+	_request (sched, c, 0);
+	_request (sched, d, 5);
+	_assert_started ("");
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 2);
+
+	/* d has the higher priority, although it asked last */
+	_release (sched, a);
+	_assert_started ("d");
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 1);
+
+	_release (sched, b);
+	_assert_started ("c");
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 0);
+
+	/* releasing twice, or a device without a request, does nothing */
+	_release (sched, a);
+	_release (sched, c);
+	_release (sched, d);
+	_assert_started ("");
+
+	_teardown (sched);
+	g_object_unref (a);
+	g_object_unref (b);
+	g_object_unref (c);
+	g_object_unref (d);
+}
+
+static void
+test_repeat (void)
+{
+	NMActivationScheduler *sched;
+	GObject *a, *b, *c;
+
+	sched = _setup (1);
+	a = _device_new ("a");
+	b = _device_new ("b");
+	c = _device_new ("c");
+
+	_request (sched, a, 0);
+	_assert_started ("a");
+
+	/* a device that holds a slot proceeds right away */
+	_request (sched, a, 0);
+	_assert_started ("a");
+
+	_request (sched, b, 0);
+	_request (sched, c, 0);
+	_request (sched, b, 0);
+	_assert_started ("");
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 2);
+
+	/* a queued device gives up its place */
+	_release (sched, b);
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 1);
+
+	_release (sched, a);
+	_assert_started ("c");
+
+	_release (sched, c);
+	_assert_started ("");
+
+	_teardown (sched);
+	g_object_unref (a);
+	g_object_unref (b);
+	g_object_unref (c);
+}
+
+static void
+test_master_waiting (void)
+{
+	NMActivationScheduler *sched;
+	GObject *master, *slave;
+
+	sched = _setup (1);
+	master = _device_new ("master");
+	slave = _device_new ("slave");
+
+	_request (sched, master, 0);
+	_assert_started ("master");
+
+	/* the slave brings up the master's carrier, but has to wait */
+	_request (sched, slave, 0);
+	_assert_started ("");
+
+	/* the master has nothing to do before the slave is up,
+	 * it gives up its slot... */
+	_release (sched, master);
+	_assert_started ("slave");
+
+	/* ...and asks again once the slave is enslaved */
+	_request (sched, master, 0);
+	_assert_started ("");
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 1);
+
+	_release (sched, slave);
+	_assert_started ("master");
+
+	_release (sched, master);
+	g_assert_cmpuint (nm_activation_scheduler_get_queue_depth (sched), ==, 0);
+
+	_teardown (sched);
+	g_object_unref (master);
+	g_object_unref (slave);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/activation-scheduler/limit", test_limit);
+	g_test_add_func ("/activation-scheduler/repeat", test_repeat);
+	g_test_add_func ("/activation-scheduler/master-waiting", test_master_waiting);
+
+	return g_test_run ();
+}
@@ -334,6 +334,98 @@ test_fcoe_cleanup (void)
 	g_assert (success);
 }
 
+static void
+test_dcb_netlink_apps (void)
+{
+	NMPlatformDcbConfig config;
+	NMSettingDcb *s_dcb;
+
+	s_dcb = (NMSettingDcb *) nm_setting_dcb_new ();
+	g_object_set (G_OBJECT (s_dcb),
+	              NM_SETTING_DCB_APP_FCOE_FLAGS, NM_SETTING_DCB_FLAG_ENABLE,
+	              NM_SETTING_DCB_APP_FCOE_PRIORITY, 6,
+	              NM_SETTING_DCB_APP_ISCSI_FLAGS, (NM_SETTING_DCB_FLAG_ENABLE | NM_SETTING_DCB_FLAG_WILLING),
+	              NM_SETTING_DCB_APP_ISCSI_PRIORITY, 3,
+	              NM_SETTING_DCB_APP_FIP_FLAGS, (NM_SETTING_DCB_FLAG_ENABLE | NM_SETTING_DCB_FLAG_ADVERTISE),
+	              NM_SETTING_DCB_APP_FIP_PRIORITY, -1,
+	              NULL);
+
+	_dcb_to_platform_config (s_dcb, &config);
+
+	g_assert_cmpint (config.app_flags, ==, NM_PLATFORM_DCB_FEAT_ENABLE | NM_PLATFORM_DCB_FEAT_WILLING | NM_PLATFORM_DCB_FEAT_ADVERTISE);
+	g_assert_cmpint (config.pfc_flags, ==, 0);
+	g_assert_cmpint (config.pg_flags, ==, 0);
+
+	/* FIP has no priority */
+	g_assert_cmpint (config.n_apps, ==, 2);
+	g_assert_cmpint (config.apps[0].idtype, ==, NM_PLATFORM_DCB_APP_IDTYPE_ETHTYPE);
+	g_assert_cmpint (config.apps[0].id, ==, 0x8906);
+	g_assert_cmpint (config.apps[0].up_map, ==, 0x40);
+	g_assert_cmpint (config.apps[1].idtype, ==, NM_PLATFORM_DCB_APP_IDTYPE_PORTNUM);
+	g_assert_cmpint (config.apps[1].id, ==, 3260);
+	g_assert_cmpint (config.apps[1].up_map, ==, 0x08);
+
+	g_object_unref (s_dcb);
+}
+
+static void
+test_dcb_netlink_pfc_pg (void)
+{
+	static const guint8 pg_bw_pct[8] = { 10, 40, 5, 10, 5, 20, 7, 3 };
+	NMPlatformDcbConfig config;
+	NMSettingDcb *s_dcb;
+	guint i;
+
+	s_dcb = (NMSettingDcb *) nm_setting_dcb_new ();
+	g_object_set (G_OBJECT (s_dcb),
+	              NM_SETTING_DCB_PRIORITY_FLOW_CONTROL_FLAGS, DCB_FLAGS_ALL,
+	              NM_SETTING_DCB_PRIORITY_GROUP_FLAGS, DCB_FLAGS_ALL,
+	              NULL);
+
+	for (i = 0; i < 8; i++) {
+		nm_setting_dcb_set_priority_flow_control (s_dcb, i, NM_IN_SET (i, 1, 2, 4, 5));
+		nm_setting_dcb_set_priority_group_id (s_dcb, i, (i == 3) ? 15 : 7 - i);
+		nm_setting_dcb_set_priority_bandwidth (s_dcb, i, 100 / (i + 1));
+		nm_setting_dcb_set_priority_strict_bandwidth (s_dcb, i, i == 4);
+		nm_setting_dcb_set_priority_traffic_class (s_dcb, i, i % 3);
+		nm_setting_dcb_set_priority_group_bandwidth (s_dcb, i, pg_bw_pct[i]);
+	}
+
+	_dcb_to_platform_config (s_dcb, &config);
+
+	g_assert_cmpint (config.app_flags, ==, 0);
+	g_assert_cmpint (config.n_apps, ==, 0);
+
+	g_assert_cmpint (config.pfc_flags, ==, NM_PLATFORM_DCB_FEAT_ENABLE | NM_PLATFORM_DCB_FEAT_WILLING | NM_PLATFORM_DCB_FEAT_ADVERTISE);
+	g_assert_cmpint (config.pfc_up, ==, 0x36);
+
+	g_assert_cmpint (config.pg_flags, ==, NM_PLATFORM_DCB_FEAT_ENABLE | NM_PLATFORM_DCB_FEAT_WILLING | NM_PLATFORM_DCB_FEAT_ADVERTISE);
+	g_assert (memcmp (config.pg_bw_pct, pg_bw_pct, sizeof (pg_bw_pct)) == 0);
+
+	/* priorities 0, 3, 6; the bandwidth is capped */
+	g_assert_cmpint (config.pg_tc[0].up_mapping, ==, 0x49);
+	g_assert_cmpint (config.pg_tc[0].pgid, ==, 1);
+	g_assert_cmpint (config.pg_tc[0].bw_pct, ==, 100);
+	g_assert_cmpint (config.pg_tc[0].strict, ==, 0);
+
+	/* priorities 1, 4, 7 */
+	g_assert_cmpint (config.pg_tc[1].up_mapping, ==, 0x92);
+	g_assert_cmpint (config.pg_tc[1].pgid, ==, 0);
+	g_assert_cmpint (config.pg_tc[1].bw_pct, ==, 50 + 20 + 12);
+	g_assert_cmpint (config.pg_tc[1].strict, ==, 2);
+
+	/* priorities 2, 5 */
+	g_assert_cmpint (config.pg_tc[2].up_mapping, ==, 0x24);
+	g_assert_cmpint (config.pg_tc[2].pgid, ==, 2);
+	g_assert_cmpint (config.pg_tc[2].bw_pct, ==, 33 + 16);
+	g_assert_cmpint (config.pg_tc[2].strict, ==, 0);
+
+	for (i = 3; i < 8; i++)
+		g_assert_cmpint (config.pg_tc[i].up_mapping, ==, 0);
+
+	g_object_unref (s_dcb);
+}
+
 /*******************************************/
 
 NMTST_DEFINE ();
@@ -350,6 +442,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/dcb/pfc", test_dcb_pfc);
 	g_test_add_func ("/dcb/priority-groups", test_dcb_priority_groups);
 	g_test_add_func ("/dcb/cleanup", test_dcb_cleanup);
+	g_test_add_func ("/dcb/netlink/apps", test_dcb_netlink_apps);
+	g_test_add_func ("/dcb/netlink/pfc-pg", test_dcb_netlink_pfc_pg);
 	g_test_add_func ("/fcoe/create", test_fcoe_create);
 	g_test_add_func ("/fcoe/cleanup", test_fcoe_cleanup);
 
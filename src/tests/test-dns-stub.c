@@ -0,0 +1,231 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "nm-dns-stub.h"
+#include "nm-ip4-config.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static void
+_append_u16 (GByteArray *msg, guint16 v)
+{
+	guint8 b[2] = { v >> 8, v & 0xFF };
+
+	g_byte_array_append (msg, b, 2);
+}
+
+static void
+_append_u32 (GByteArray *msg, guint32 v)
+{
+	_append_u16 (msg, v >> 16);
+	_append_u16 (msg, v & 0xFFFF);
+}
+
+/* "example.com" */
+static void
+_append_name (GByteArray *msg)
+{
+	static const guint8 name[] = "\7example\3com";
+
+	g_byte_array_append (msg, name, sizeof (name));
+}
+
+/* Builds an answer for "example.com IN A" with @rcode, an A record with
+ * @a_ttl (none if 0) and a SOA record with @soa_ttl and @soa_minimum in
+ * the authority section (none if @soa_ttl is 0). */
+static GByteArray *
+_build_answer (guint rcode, guint32 a_ttl, guint32 soa_ttl, guint32 soa_minimum)
+{
+	GByteArray *msg = g_byte_array_new ();
+
+	_append_u16 (msg, 0x1234);
+	_append_u16 (msg, 0x8180 | rcode);
+	_append_u16 (msg, 1);
+	_append_u16 (msg, a_ttl ? 1 : 0);
+	_append_u16 (msg, soa_ttl ? 1 : 0);
+	_append_u16 (msg, 0);
+
+	_append_name (msg);
+	_append_u16 (msg, 1);
+	_append_u16 (msg, 1);
+
+	if (a_ttl) {
+		_append_name (msg);
+		_append_u16 (msg, 1);
+		_append_u16 (msg, 1);
+		_append_u32 (msg, a_ttl);
+		_append_u16 (msg, 4);
+		_append_u32 (msg, 0xC0000201);
+	}
+
+	if (soa_ttl) {
+		_append_name (msg);
+		_append_u16 (msg, 6);
+		_append_u16 (msg, 1);
+		_append_u32 (msg, soa_ttl);
+		/* two root names and five 32 bit fields */
+		_append_u16 (msg, 2 + 20);
+		g_byte_array_append (msg, (const guint8 *) "\0\0", 2);
+		_append_u32 (msg, 1);
+		_append_u32 (msg, 3600);
+		_append_u32 (msg, 600);
+		_append_u32 (msg, 86400);
+		_append_u32 (msg, soa_minimum);
+	}
+
+	return msg;
+}
+
+static guint32
+_cache_ttl (guint rcode, guint32 a_ttl, guint32 soa_ttl, guint32 soa_minimum)
+{
+	GByteArray *msg;
+	guint32 ttl;
+
+	msg = _build_answer (rcode, a_ttl, soa_ttl, soa_minimum);
+	ttl = _nm_dns_stub_msg_cache_ttl (msg->data, msg->len);
+	g_byte_array_unref (msg);
+	return ttl;
+}
+
+static void
+test_cache_ttl (void)
+{
+	/* positive answers use the lowest TTL */
+	g_assert_cmpint (_cache_ttl (0, 120, 0, 0), ==, 120);
+	g_assert_cmpint (_cache_ttl (0, 120, 60, 30), ==, 30);
+
+	/* negative answers use the lower of the SOA's TTL and MINIMUM */
+	g_assert_cmpint (_cache_ttl (3, 0, 200, 30), ==, 30);
+	g_assert_cmpint (_cache_ttl (3, 0, 20, 30), ==, 20);
+	g_assert_cmpint (_cache_ttl (0, 0, 200, 30), ==, 30);
+
+	/* ... capped at five minutes */
+	g_assert_cmpint (_cache_ttl (3, 0, 86400, 86400), ==, 300);
+
+	/* ... and not cached without SOA */
+	g_assert_cmpint (_cache_ttl (3, 0, 0, 0), ==, 0);
+
+	/* errors are not cached */
+	g_assert_cmpint (_cache_ttl (2, 0, 200, 30), ==, 0);
+}
+
+/*****************************************************************************/
+
+static NMIP4Config *
+_ip4_config (const char *nameserver, const char *domain)
+{
+	NMIP4Config *config;
+
+	config = nm_ip4_config_new (1);
+	nm_ip4_config_add_nameserver (config, nmtst_inet4_from_string (nameserver));
+	if (domain)
+		nm_ip4_config_add_domain (config, domain);
+	return config;
+}
+
+static guint
+_set_servers (NMDnsStub *stub, NMIP4Config *vpn, NMIP4Config *base)
+{
+	NMDnsIPConfigData data[2] = {
+		{ .config = vpn, .type = NM_DNS_IP_CONFIG_TYPE_VPN, .iface = "tun0" },
+		{ .config = base, .type = NM_DNS_IP_CONFIG_TYPE_DEFAULT, .iface = "eth0" },
+	};
+	const NMDnsIPConfigData *configs[3] = { 0 };
+	NMDnsStubStats stats;
+	guint n = 0;
+
+	if (vpn)
+		configs[n++] = &data[0];
+	if (base)
+		configs[n++] = &data[1];
+
+	_nm_dns_stub_set_servers (stub, configs, NULL);
+
+	nm_dns_stub_get_stats (stub, &stats);
+	return stats.cache_size;
+}
+
+static void
+_cache_fill (NMDnsStub *stub)
+{
+	GByteArray *msg;
+
+	msg = _build_answer (0, 120, 0, 0);
+	_nm_dns_stub_cache_add (stub, "example.com/1/1", msg->data, msg->len, 120);
+	g_byte_array_unref (msg);
+}
+
+static void
+test_servers_changed (void)
+{
+	gs_unref_object NMDnsStub *stub = NULL;
+	gs_unref_object NMIP4Config *base = NULL;
+	gs_unref_object NMIP4Config *base2 = NULL;
+	gs_unref_object NMIP4Config *vpn = NULL;
+
+	stub = NM_DNS_STUB (nm_dns_stub_new ());
+	base = _ip4_config ("192.0.2.1", NULL);
+	base2 = _ip4_config ("192.0.2.2", NULL);
+	vpn = _ip4_config ("198.51.100.1", "example.com");
+
+	g_assert_cmpint (_set_servers (stub, NULL, base), ==, 0);
+	_cache_fill (stub);
+
+	/* the same servers keep the cache */
+	g_assert_cmpint (_set_servers (stub, NULL, base), ==, 1);
+
+	/* a VPN taking over the domain clears it */
+	g_assert_cmpint (_set_servers (stub, vpn, base), ==, 0);
+	_cache_fill (stub);
+
+	/* and so does the VPN going away: its answers must not stay */
+	g_assert_cmpint (_set_servers (stub, NULL, base), ==, 0);
+	_cache_fill (stub);
+
+	/* a replaced server */
+	g_assert_cmpint (_set_servers (stub, NULL, base2), ==, 0);
+	_cache_fill (stub);
+
+	/* no servers at all */
+	g_assert_cmpint (_set_servers (stub, NULL, NULL), ==, 0);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	g_test_add_func ("/dns-stub/cache-ttl", test_cache_ttl);
+	g_test_add_func ("/dns-stub/servers-changed", test_servers_changed);
+
+	return g_test_run ();
+}
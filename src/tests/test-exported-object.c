@@ -0,0 +1,264 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-exported-object.h"
+#include "nm-bus-manager.h"
+
+#include "nmdbus-dhcp4-config.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+/* A minimal exported object implementing the DHCP4Config interface,
+ * whose only property is "Options". */
+
+#define TEST_TYPE_OBJECT (test_object_get_type ())
+#define TEST_OBJECT(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), TEST_TYPE_OBJECT, TestObject))
+
+typedef struct {
+	NMExportedObject parent;
+	GVariant *options;
+} TestObject;
+
+typedef struct {
+	NMExportedObjectClass parent;
+} TestObjectClass;
+
+GType test_object_get_type (void);
+
+G_DEFINE_TYPE (TestObject, test_object, NM_TYPE_EXPORTED_OBJECT)
+
+enum {
+	PROP_0,
+	PROP_OPTIONS,
+};
+
+static void
+test_object_set_options (TestObject *self, guint v)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "v", g_variant_new_uint32 (v));
+	g_clear_pointer (&self->options, g_variant_unref);
+	self->options = g_variant_ref_sink (g_variant_builder_end (&builder));
+	g_object_notify ((GObject *) self, "options");
+}
+
+static void
+test_object_init (TestObject *self)
+{
+}
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	switch (prop_id) {
+	case PROP_OPTIONS:
+		g_value_set_variant (value, TEST_OBJECT (object)->options);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+finalize (GObject *object)
+{
+	g_clear_pointer (&TEST_OBJECT (object)->options, g_variant_unref);
+
+	G_OBJECT_CLASS (test_object_parent_class)->finalize (object);
+}
+
+static void
+test_object_class_init (TestObjectClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	NMExportedObjectClass *exported_object_class = NM_EXPORTED_OBJECT_CLASS (klass);
+
+	exported_object_class->export_path = "/org/freedesktop/NetworkManager/TestObject/%u";
+
+	object_class->get_property = get_property;
+	object_class->finalize = finalize;
+
+	g_object_class_install_property
+	    (object_class, PROP_OPTIONS,
+	     g_param_spec_variant ("options", "", "",
+	                           G_VARIANT_TYPE_VARDICT,
+	                           NULL,
+	                           G_PARAM_READABLE |
+	                           G_PARAM_STATIC_STRINGS));
+
+	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (klass),
+	                                        NMDBUS_TYPE_DHCP4_CONFIG_SKELETON,
+	                                        NULL);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GPtrArray *emitted;
+} NotifyData;
+
+static void
+properties_changed_cb (GDBusInterfaceSkeleton *skeleton,
+                       GVariant *properties,
+                       NotifyData *data)
+{
+	GDBusObject *object;
+
+	object = g_dbus_interface_get_object ((GDBusInterface *) skeleton);
+	g_assert (object);
+	g_assert (g_variant_lookup_value (properties, "Options", NULL));
+
+	g_ptr_array_add (data->emitted, object);
+}
+
+static TestObject *
+_object_new (NotifyData *data)
+{
+	TestObject *obj;
+	GDBusInterface *skeleton;
+
+	obj = g_object_new (TEST_TYPE_OBJECT, NULL);
+	nm_exported_object_export ((NMExportedObject *) obj);
+	nm_exported_object_ensure_skeletons ((NMExportedObject *) obj);
+
+	skeleton = g_dbus_object_get_interface ((GDBusObject *) obj,
+	                                        "org.freedesktop.NetworkManager.DHCP4Config");
+	g_assert (skeleton);
+	g_signal_connect (skeleton, "properties-changed",
+	                  G_CALLBACK (properties_changed_cb), data);
+	g_object_unref (skeleton);
+
+	return obj;
+}
+
+static void
+_run_until_emitted (NotifyData *data, guint n)
+{
+	gint64 until = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+
+	while (data->emitted->len < n) {
+		g_assert (g_get_monotonic_time () < until);
+		g_main_context_iteration (NULL, TRUE);
+	}
+	/* and nothing else is pending */
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+	g_assert_cmpint (data->emitted->len, ==, n);
+}
+
+static void
+test_notify_order (gconstpointer test_data)
+{
+	guint budget = GPOINTER_TO_UINT (test_data);
+	NotifyData data = { .emitted = g_ptr_array_new () };
+	TestObject *obj[5];
+	guint order[] = { 3, 0, 4, 1, 2 };
+	guint i;
+
+	nm_exported_object_class_set_notify_limits (budget, 0);
+
+	/* objects are exported, thus sorted by path, in index order */
+	for (i = 0; i < G_N_ELEMENTS (obj); i++)
+		obj[i] = _object_new (&data);
+
+	/* change them in another order; the second change of obj[3] is
+	 * merged into its pending signal and doesn't move it back. */
+	for (i = 0; i < G_N_ELEMENTS (order); i++)
+		test_object_set_options (obj[order[i]], i);
+	test_object_set_options (obj[3], 42);
+
+	_run_until_emitted (&data, G_N_ELEMENTS (order));
+	for (i = 0; i < G_N_ELEMENTS (order); i++)
+		g_assert (data.emitted->pdata[i] == obj[order[i]]);
+
+	/* once emitted, an object queues up behind those changed before it */
+	g_ptr_array_set_size (data.emitted, 0);
+	test_object_set_options (obj[1], 1);
+	test_object_set_options (obj[0], 0);
+	test_object_set_options (obj[1], 2);
+	_run_until_emitted (&data, 2);
+	g_assert (data.emitted->pdata[0] == obj[1]);
+	g_assert (data.emitted->pdata[1] == obj[0]);
+
+	for (i = 0; i < G_N_ELEMENTS (obj); i++) {
+		nm_exported_object_unexport ((NMExportedObject *) obj[i]);
+		g_object_unref (obj[i]);
+	}
+	g_ptr_array_unref (data.emitted);
+
+	nm_exported_object_class_set_notify_limits (NM_EXPORTED_OBJECT_NOTIFY_BUDGET_DEFAULT,
+	                                            NM_EXPORTED_OBJECT_NOTIFY_MAX_LATENCY_DEFAULT);
+}
+
+static void
+test_notify_unexport (void)
+{
+	NotifyData data = { .emitted = g_ptr_array_new () };
+	TestObject *obj[3];
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (obj); i++)
+		obj[i] = _object_new (&data);
+
+	for (i = 0; i < G_N_ELEMENTS (obj); i++)
+		test_object_set_options (obj[i], i);
+
+	/* an unexported object drops its pending signal, the others keep
+	 * their order */
+	nm_exported_object_unexport ((NMExportedObject *) obj[1]);
+
+	_run_until_emitted (&data, 2);
+	g_assert (data.emitted->pdata[0] == obj[0]);
+	g_assert (data.emitted->pdata[1] == obj[2]);
+
+	for (i = 0; i < G_N_ELEMENTS (obj); i++) {
+		if (nm_exported_object_is_exported ((NMExportedObject *) obj[i]))
+			nm_exported_object_unexport ((NMExportedObject *) obj[i]);
+		g_object_unref (obj[i]);
+	}
+	g_ptr_array_unref (data.emitted);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* don't connect to the system bus */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+
+	g_test_add_data_func ("/exported-object/notify/order", GUINT_TO_POINTER (0), test_notify_order);
+	g_test_add_data_func ("/exported-object/notify/order-budget", GUINT_TO_POINTER (2), test_notify_order);
+	g_test_add_func ("/exported-object/notify/unexport", test_notify_unexport);
+
+	return g_test_run ();
+}
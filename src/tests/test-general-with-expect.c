@@ -29,6 +29,8 @@
 
 #include "NetworkManagerUtils.h"
 #include "nm-multi-index.h"
+#include "nm-lpm-trie.h"
+#include "nm-watchdog.h"
 
 #include "nm-test-utils-core.h"
 
@@ -854,6 +856,112 @@ test_nm_multi_index (void)
 
 /*******************************************/
 
+typedef struct {
+	guint32 network;
+	guint8 plen;
+	gboolean added;
+} LpmTestPrefix;
+
+typedef struct {
+	const LpmTestPrefix *prefixes;
+	int n_calls;
+	int best_plen;
+} LpmTestMatchData;
+
+static gboolean
+_lpm_match_cb (guint8 plen, void *const*values, guint len, gpointer user_data)
+{
+	LpmTestMatchData *data = user_data;
+	guint i;
+
+	g_assert (len > 0);
+	g_assert (!values[len]);
+	for (i = 0; i < len; i++)
+		g_assert_cmpint (data->prefixes[GPOINTER_TO_UINT (values[i]) - 1].plen, ==, plen);
+
+	/* the longest prefix is visited first, and only once. */
+	if (data->n_calls++ == 0)
+		data->best_plen = plen;
+	else
+		g_assert_cmpint (plen, <, data->best_plen);
+	return TRUE;
+}
+
+static gboolean
+_lpm_prefix_contains (const LpmTestPrefix *p, guint32 addr)
+{
+	return    p->plen == 0
+	       || ((p->network ^ addr) >> (32 - p->plen)) == 0;
+}
+
+static void
+_lpm_test_run (guint num_prefixes)
+{
+	NMLpmTrie *trie = nm_lpm_trie_new (4);
+	gs_free LpmTestPrefix *prefixes = g_new0 (LpmTestPrefix, num_prefixes);
+	GRand *rand = nmtst_get_rand ();
+	guint i, j, n_added = 0;
+
+	for (i = 0; i < num_prefixes; i++) {
+		/* use few distinct networks so that prefixes overlap a lot. */
+		prefixes[i].network = ((guint32) g_rand_int_range (rand, 0, 8)) << 29 | (g_rand_int (rand) & 0x0F0000FF);
+		prefixes[i].plen = g_rand_int_range (rand, 0, 33);
+	}
+
+	for (j = 0; j < num_prefixes * 4; j++) {
+		guint32 addr_be, addr;
+		LpmTestMatchData data = { .prefixes = prefixes, .best_plen = -1, };
+		int expected_plen = -1;
+
+		i = g_rand_int_range (rand, 0, num_prefixes);
+		addr_be = htonl (prefixes[i].network);
+		if (prefixes[i].added) {
+			g_assert (nm_lpm_trie_remove (trie, &addr_be, prefixes[i].plen, GUINT_TO_POINTER (i + 1)));
+			g_assert (!nm_lpm_trie_remove (trie, &addr_be, prefixes[i].plen, GUINT_TO_POINTER (i + 1)));
+			prefixes[i].added = FALSE;
+			n_added--;
+		} else {
+			g_assert (nm_lpm_trie_add (trie, &addr_be, prefixes[i].plen, GUINT_TO_POINTER (i + 1)));
+			g_assert (!nm_lpm_trie_add (trie, &addr_be, prefixes[i].plen, GUINT_TO_POINTER (i + 1)));
+			prefixes[i].added = TRUE;
+			n_added++;
+		}
+
+		addr = ((guint32) g_rand_int_range (rand, 0, 8)) << 29 | (g_rand_int (rand) & 0x0F0000FF);
+		for (i = 0; i < num_prefixes; i++) {
+			if (   prefixes[i].added
+			    && _lpm_prefix_contains (&prefixes[i], addr))
+				expected_plen = MAX (expected_plen, (int) prefixes[i].plen);
+		}
+
+		addr_be = htonl (addr);
+		nm_lpm_trie_foreach_match (trie, &addr_be, _lpm_match_cb, &data);
+		g_assert_cmpint (data.best_plen, ==, expected_plen);
+	}
+
+	for (i = 0; i < num_prefixes; i++) {
+		guint32 addr_be = htonl (prefixes[i].network);
+
+		if (prefixes[i].added) {
+			g_assert (nm_lpm_trie_lookup_exact (trie, &addr_be, prefixes[i].plen, NULL));
+			g_assert (nm_lpm_trie_remove (trie, &addr_be, prefixes[i].plen, GUINT_TO_POINTER (i + 1)));
+		}
+	}
+	g_assert_cmpint (nm_lpm_trie_get_num_prefixes (trie), ==, 0);
+
+	nm_lpm_trie_free (trie);
+}
+
+static void
+test_nm_lpm_trie (void)
+{
+	_lpm_test_run (1);
+	_lpm_test_run (10);
+	_lpm_test_run (200);
+}
+
+/*******************************************/
+
 static void
 test_nm_utils_new_vlan_name (void)
 {
@@ -897,6 +1005,61 @@ test_nm_utils_new_vlan_name (void)
 
 /*******************************************/
 
+static GPollFunc watchdog_orig_poll_func;
+static gint64 watchdog_poll_returned;
+
+static gint
+_watchdog_poll_func (GPollFD *ufds, guint nfsd, gint timeout)
+{
+	gint r;
+
+	nm_watchdog_poll_enter (watchdog_poll_returned ? g_get_monotonic_time () - watchdog_poll_returned : 0);
+	r = watchdog_orig_poll_func (ufds, nfsd, timeout);
+	watchdog_poll_returned = g_get_monotonic_time ();
+	nm_watchdog_poll_leave ();
+	return r;
+}
+
+static gboolean
+_watchdog_stall_cb (gpointer user_data)
+{
+	g_usleep (300 * 1000);
+	*((gboolean *) user_data) = TRUE;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+test_nm_watchdog (void)
+{
+	GMainContext *context = g_main_context_default ();
+	GSource *source;
+	gboolean done = FALSE;
+
+	watchdog_orig_poll_func = g_main_context_get_poll_func (context);
+	g_main_context_set_poll_func (context, _watchdog_poll_func);
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_DEBUG, "*watchdog: report main loop iterations longer than 50 msec*");
+	nm_watchdog_start (50, FALSE);
+
+	source = g_idle_source_new ();
+	g_source_set_name (source, "test-stall");
+	g_source_set_callback (source, _watchdog_stall_cb, &done, NULL);
+	g_source_attach (source, NULL);
+	g_source_unref (source);
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_MESSAGE, "*watchdog: main loop stalled for * msec in idle source \"test-stall\", callback *");
+	while (!done)
+		g_main_context_iteration (NULL, TRUE);
+	/* the stall is reported on the next poll */
+	g_main_context_iteration (NULL, FALSE);
+	g_test_assert_expected_messages ();
+
+	nm_watchdog_stop ();
+	g_main_context_set_poll_func (context, watchdog_orig_poll_func);
+}
+
+/*******************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -909,7 +1072,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/nm_utils_array_remove_at_indexes", test_nm_utils_array_remove_at_indexes);
 	g_test_add_func ("/general/nm_ethernet_address_is_valid", test_nm_ethernet_address_is_valid);
 	g_test_add_func ("/general/nm_multi_index", test_nm_multi_index);
+	g_test_add_func ("/general/nm_lpm_trie", test_nm_lpm_trie);
 	g_test_add_func ("/general/nm_utils_new_vlan_name", test_nm_utils_new_vlan_name);
+	g_test_add_func ("/general/nm_watchdog", test_nm_watchdog);
 
 	return g_test_run ();
 }
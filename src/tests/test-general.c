@@ -22,9 +22,13 @@
 
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "nm-executor.h"
+#include "nm-loop-sched.h"
+#include "dns-manager/nm-dns-manager.h"
 
 #include "nm-test-utils-core.h"
 
@@ -515,6 +519,62 @@ test_connection_match_interface_name (void)
 	g_object_unref (copy);
 }
 
+static void
+test_connection_match_prefilter (void)
+{
+	NMConnection *orig, *copy1, *copy2, *copy3, *matched;
+	GSList *connections = NULL;
+	NMSettingConnection *s_con;
+	NMSettingIPConfig *s_ip6;
+
+	orig = _match_connection_new ();
+	s_con = nm_connection_get_setting_connection (orig);
+	g_object_set (G_OBJECT (s_con),
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, "em1",
+	              NULL);
+	s_ip6 = nm_connection_get_setting_ip6_config (orig);
+	g_object_set (G_OBJECT (s_ip6),
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_LINK_LOCAL,
+	              NULL);
+
+	/* a different interface name is skipped before diffing */
+	copy1 = nm_simple_connection_new_clone (orig);
+	s_con = nm_connection_get_setting_connection (copy1);
+	g_object_set (G_OBJECT (s_con),
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, "em2",
+	              NULL);
+	connections = g_slist_append (connections, copy1);
+
+	/* so is an IPv6 method check_ip6_method() doesn't accept */
+	copy2 = nm_simple_connection_new_clone (orig);
+	s_ip6 = nm_connection_get_setting_ip6_config (copy2);
+	g_object_set (G_OBJECT (s_ip6),
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_DHCP,
+	              NULL);
+	connections = g_slist_append (connections, copy2);
+
+	/* while the accepted differences still pass the prefilter */
+	copy3 = nm_simple_connection_new_clone (orig);
+	s_con = nm_connection_get_setting_connection (copy3);
+	g_object_set (G_OBJECT (s_con),
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, NULL,
+	              NULL);
+	s_ip6 = nm_connection_get_setting_ip6_config (copy3);
+	g_object_set (G_OBJECT (s_ip6),
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_IGNORE,
+	              NULL);
+	connections = g_slist_append (connections, copy3);
+
+	matched = nm_utils_match_connection (connections, orig, TRUE, 0, 0, NULL, NULL);
+	g_assert (matched == copy3);
+
+	g_slist_free (connections);
+	g_object_unref (orig);
+	g_object_unref (copy1);
+	g_object_unref (copy2);
+	g_object_unref (copy3);
+}
+
 static void
 test_connection_match_wired (void)
 {
@@ -988,6 +1048,7 @@ test_match_spec_ifname (const char *spec_str, const char **matches, const char *
 {
 	const char *m;
 	GSList *specs, *specs_reverse = NULL, *specs_resplit, *specs_i, *specs_j;
+	NMMatchSpecCompiled *compiled;
 	guint i;
 	gs_free char *specs_joined = NULL;
 
@@ -1012,13 +1073,18 @@ test_match_spec_ifname (const char *spec_str, const char **matches, const char *
 	 * matches are inclusive -- except "except:" which always wins. */
 	specs_reverse = g_slist_reverse (g_slist_copy (specs));
 
+	/* the compiled specs must give the same results */
+	compiled = nm_match_spec_compile (specs);
+
 	for (i = 0; matches && matches[i]; i++) {
 		g_assert (nm_match_spec_interface_name (specs, matches[i]) == NM_MATCH_SPEC_MATCH);
 		g_assert (nm_match_spec_interface_name (specs_reverse, matches[i]) == NM_MATCH_SPEC_MATCH);
+		g_assert (nm_match_spec_compiled_match (compiled, matches[i], NULL, NULL, NULL) == NM_MATCH_SPEC_MATCH);
 	}
 	for (i = 0; neg_matches && neg_matches[i]; i++) {
 		g_assert (nm_match_spec_interface_name (specs, neg_matches[i]) == NM_MATCH_SPEC_NEG_MATCH);
 		g_assert (nm_match_spec_interface_name (specs_reverse, neg_matches[i]) == NM_MATCH_SPEC_NEG_MATCH);
+		g_assert (nm_match_spec_compiled_match (compiled, neg_matches[i], NULL, NULL, NULL) == NM_MATCH_SPEC_NEG_MATCH);
 	}
 	for (i = 0; (m = _test_match_spec_all[i]); i++) {
 		if (_test_match_spec_contains (matches, m))
@@ -1027,12 +1093,51 @@ test_match_spec_ifname (const char *spec_str, const char **matches, const char *
 			continue;
 		g_assert (nm_match_spec_interface_name (specs, m) == NM_MATCH_SPEC_NO_MATCH);
 		g_assert (nm_match_spec_interface_name (specs_reverse, m) == NM_MATCH_SPEC_NO_MATCH);
+		/* twice, the second time the result comes from the cache */
+		g_assert (nm_match_spec_compiled_match (compiled, m, NULL, NULL, NULL) == NM_MATCH_SPEC_NO_MATCH);
+		g_assert (nm_match_spec_compiled_match (compiled, m, NULL, NULL, NULL) == NM_MATCH_SPEC_NO_MATCH);
 	}
 
+	nm_match_spec_compiled_free (compiled);
 	g_slist_free (specs_reverse);
 	g_slist_free_full (specs, g_free);
 }
 
+static void
+test_nm_match_spec_compiled (void)
+{
+	GSList *specs;
+	NMMatchSpecCompiled *compiled;
+
+	specs = nm_match_spec_split ("*,except:mac:00:11:22:33:44:55,except:type:bond,except:s390-subchannels:0.0.abcd,except:interface-name:lo*");
+	compiled = nm_match_spec_compile (specs);
+
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:66", "ethernet", NULL) == NM_MATCH_SPEC_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:55", "ethernet", NULL) == NM_MATCH_SPEC_NEG_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:66", "ethernet", NULL) == NM_MATCH_SPEC_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:66", "ethernet", "0.0.abcd,0.0.abce") == NM_MATCH_SPEC_NEG_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "bond0", NULL, "bond", NULL) == NM_MATCH_SPEC_NEG_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "lo", NULL, "generic", NULL) == NM_MATCH_SPEC_NEG_MATCH);
+
+	nm_match_spec_compiled_free (compiled);
+	g_slist_free_full (specs, g_free);
+
+	specs = nm_match_spec_split ("00:11:22:33:44:55,mac:80:00:02:08:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65,em1");
+	compiled = nm_match_spec_compile (specs);
+
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:55", NULL, NULL) == NM_MATCH_SPEC_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "eth0", "00:11:22:33:44:56", NULL, NULL) == NM_MATCH_SPEC_NO_MATCH);
+	g_assert (nm_match_spec_compiled_match (compiled, "em1", NULL, NULL, NULL) == NM_MATCH_SPEC_MATCH);
+	/* InfiniBand addresses only compare the last 8 bytes */
+	g_assert (nm_match_spec_compiled_match (compiled, "ib0", "80:00:02:09:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65", NULL, NULL) == NM_MATCH_SPEC_MATCH);
+
+	nm_match_spec_compiled_free (compiled);
+	g_slist_free_full (specs, g_free);
+
+	g_assert (nm_match_spec_compile (NULL) == NULL);
+	g_assert (nm_match_spec_compiled_match (NULL, "eth0", NULL, NULL, NULL) == NM_MATCH_SPEC_NO_MATCH);
+}
+
 static void
 test_nm_match_spec_interface_name (void)
 {
@@ -1363,6 +1468,180 @@ test_duplicate_decl_specifier (void)
 
 /*****************************************************************************/
 
+static gboolean
+_executor_job (gpointer user_data, GError **error)
+{
+	GString *str = user_data;
+
+	/* jobs run one after another, so they don't need locking. */
+	g_string_append_c (str, 'j');
+	if (str->len == 3) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, "third");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_executor_done (GError *error, gpointer user_data)
+{
+	GString *str = user_data;
+
+	g_string_append_c (str, error ? 'e' : 'd');
+}
+
+static void
+_executor_write_done (GError *error, gpointer user_data)
+{
+	g_assert_no_error (error);
+	(*((int *) user_data))++;
+}
+
+static void
+test_executor (void)
+{
+	GString *str = g_string_new (NULL);
+	gs_free char *filename = g_strdup_printf ("/tmp/nm-test-executor.%d", (int) getpid ());
+	gs_free char *contents = NULL;
+	int n_written = 0;
+	guint i;
+
+	for (i = 0; i < 4; i++)
+		nm_executor_run (_executor_job, NULL, str);
+	nm_executor_flush ();
+	g_assert_cmpstr (str->str, ==, "jjjj");
+
+	/* the completions are invoked in order from the main loop. */
+	g_string_truncate (str, 0);
+	nm_executor_run (_executor_job, _executor_done, str);
+	nm_executor_flush ();
+	g_assert_cmpstr (str->str, ==, "jd");
+	nm_executor_run (_executor_job, _executor_done, str);
+	while (str->len < 4)
+		g_main_context_iteration (NULL, TRUE);
+	g_assert_cmpstr (str->str, ==, "jdje");
+
+	/* later writes win. */
+	nm_executor_write_file (filename, g_strdup ("1"), -1, _executor_write_done, &n_written);
+	nm_executor_write_file (filename, g_strdup ("22"), -1, _executor_write_done, &n_written);
+	nm_executor_flush ();
+	g_assert_cmpint (n_written, ==, 2);
+	g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+	g_assert_cmpstr (contents, ==, "22");
+
+	unlink (filename);
+	g_string_free (str, TRUE);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GString *str;
+	char c;
+	int n_again;
+	guint id;
+	gboolean remove_self;
+} LoopSchedData;
+
+static gboolean
+_loop_sched_cb (gpointer user_data)
+{
+	LoopSchedData *d = user_data;
+
+	g_string_append_c (d->str, d->c);
+	if (d->remove_self) {
+		g_assert (nm_loop_sched_remove (d->id));
+		return G_SOURCE_CONTINUE;
+	}
+	if (d->n_again-- > 0)
+		return G_SOURCE_CONTINUE;
+	d->id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_loop_sched_run (GString *str, guint len)
+{
+	while (str->len < len)
+		g_main_context_iteration (NULL, TRUE);
+	/* nothing else must run */
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+	g_assert_cmpint (str->len, ==, len);
+}
+
+static void
+test_loop_sched (void)
+{
+	GString *str = g_string_new (NULL);
+	LoopSchedData a = { .str = str, .c = 'a' };
+	LoopSchedData b = { .str = str, .c = 'b' };
+	LoopSchedData c = { .str = str, .c = 'c' };
+	NMLoopSchedStats stats;
+
+	/* callbacks run in order; removed ones not at all. */
+	a.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, _loop_sched_cb, &a);
+	b.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, _loop_sched_cb, &b);
+	c.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, _loop_sched_cb, &c);
+	g_assert (a.id && b.id && c.id);
+	g_assert (nm_loop_sched_remove (b.id));
+	g_assert (!nm_loop_sched_remove (b.id));
+	_loop_sched_run (str, 2);
+	g_assert_cmpstr (str->str, ==, "ac");
+	g_assert (!nm_loop_sched_remove (a.id));
+
+	/* a callback that continues gets requeued behind the others. */
+	g_string_truncate (str, 0);
+	a.n_again = 2;
+	a.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, _loop_sched_cb, &a);
+	b.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_DEVICE, _loop_sched_cb, &b);
+	_loop_sched_run (str, 4);
+	g_assert_cmpstr (str->str, ==, "abaa");
+
+	/* removing itself from within the callback stops it. */
+	g_string_truncate (str, 0);
+	c.remove_self = TRUE;
+	c.id = nm_loop_sched_add (NM_LOOP_SCHED_CLASS_BACKGROUND, _loop_sched_cb, &c);
+	_loop_sched_run (str, 1);
+	g_assert_cmpstr (str->str, ==, "c");
+
+	nm_loop_sched_get_stats (NM_LOOP_SCHED_CLASS_DEVICE, &stats);
+	g_assert_cmpint (stats.depth, ==, 0);
+	g_assert_cmpint (stats.depth_max, ==, 3);
+	g_assert_cmpint (stats.dispatched, >=, 4);
+	nm_loop_sched_get_stats (NM_LOOP_SCHED_CLASS_BACKGROUND, &stats);
+	g_assert_cmpint (stats.depth, ==, 0);
+
+	g_string_free (str, TRUE);
+}
+
+/*****************************************************************************/
+
+static void
+test_dns_update_delay (void)
+{
+	/* a change on its own waits for the whole window... */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 1000, 20), ==, 20);
+	/* ...counted from the first change */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 1015, 20), ==, 5);
+
+	/* NMPolicy opens a DNS batch with its first trigger and closes it
+	 * main.routing-dns-max-latency (50 ms) later; the DNS window has
+	 * passed by then and the update is not delayed any further. */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 1050, 20), ==, 0);
+
+	/* with a longer DNS window, only the rest of it is waited for */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 1050, 80), ==, 30);
+
+	/* 0 disables the window */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 1000, 0), ==, 0);
+
+	/* never more than the window, even if the clock went back */
+	g_assert_cmpint (_nm_dns_manager_update_delay (1000, 900, 20), ==, 20);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1382,6 +1661,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/connection-match/ip6-method-ignore-auto", test_connection_match_ip6_method_ignore_auto);
 	g_test_add_func ("/general/connection-match/ip4-method", test_connection_match_ip4_method);
 	g_test_add_func ("/general/connection-match/con-interface-name", test_connection_match_interface_name);
+	g_test_add_func ("/general/connection-match/prefilter", test_connection_match_prefilter);
 	g_test_add_func ("/general/connection-match/wired", test_connection_match_wired);
 	g_test_add_func ("/general/connection-match/wired2", test_connection_match_wired2);
 	g_test_add_func ("/general/connection-match/cloned_mac", test_connection_match_cloned_mac);
@@ -1395,7 +1675,11 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/general/nm_match_spec_interface_name", test_nm_match_spec_interface_name);
 	g_test_add_func ("/general/nm_match_spec_match_config", test_nm_match_spec_match_config);
+	g_test_add_func ("/general/nm_match_spec_compiled", test_nm_match_spec_compiled);
 	g_test_add_func ("/general/duplicate_decl_specifier", test_duplicate_decl_specifier);
+	g_test_add_func ("/general/executor", test_executor);
+	g_test_add_func ("/general/loop-sched", test_loop_sched);
+	g_test_add_func ("/general/dns-update-delay", test_dns_update_delay);
 
 	return g_test_run ();
 }
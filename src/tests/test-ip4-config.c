@@ -301,6 +301,277 @@ test_merge_subtract_mss_mtu (void)
 	g_object_unref (cfg3);
 }
 
+static void
+_count_notify (GObject *object, GParamSpec *pspec, guint *counter)
+{
+	(*counter)++;
+}
+
+static void
+test_add_routes_bulk (void)
+{
+	NMIP4Config *bulk, *single;
+	gs_unref_array GArray *routes = NULL;
+	NMPlatformIP4Route route;
+	guint n = nmtst_test_quick () ? 1000 : 20000;
+	guint n_notify = 0;
+	guint i;
+
+	routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route), n + 1);
+	for (i = 0; i < n; i++) {
+		route = *nmtst_platform_ip4_route ("0.0.0.0", 24, "192.168.1.1");
+		route.network = htonl (0x0b000000u + (i << 8));
+		route.metric = 50;
+		route.rt_source = NM_IP_CONFIG_SOURCE_VPN;
+		g_array_append_val (routes, route);
+	}
+	/* a duplicate, pushed with another gateway */
+	route = g_array_index (routes, NMPlatformIP4Route, 0);
+	route.gateway = nmtst_inet4_from_string ("192.168.1.2");
+	g_array_append_val (routes, route);
+
+	bulk = nm_ip4_config_new (1);
+	g_signal_connect (bulk, "notify::" NM_IP4_CONFIG_ROUTE_DATA, G_CALLBACK (_count_notify), &n_notify);
+	nm_ip4_config_add_routes (bulk, (const NMPlatformIP4Route *) routes->data, routes->len);
+	g_assert_cmpuint (n_notify, ==, 1);
+
+	single = nm_ip4_config_new (1);
+	for (i = 0; i < routes->len; i++)
+		nm_ip4_config_add_route (single, &g_array_index (routes, NMPlatformIP4Route, i));
+
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (bulk), ==, n);
+	g_assert (nm_ip4_config_equal (bulk, single));
+	g_assert_cmpuint (nm_ip4_config_get_route (bulk, 0)->gateway, ==, nmtst_inet4_from_string ("192.168.1.2"));
+
+	/* adding nothing notifies nothing */
+	nm_ip4_config_add_routes (bulk, NULL, 0);
+	g_assert_cmpuint (n_notify, ==, 1);
+
+	g_object_unref (bulk);
+	g_object_unref (single);
+}
+
+static void
+test_merge_many_routes (void)
+{
+	NMIP4Config *dev, *vpn, *cfg;
+	NMPlatformIP4Route route;
+	const NMPlatformIP4Route *test_route;
+	guint n = nmtst_test_quick () ? 1000 : 20000;
+	guint i;
+
+	dev = build_test_config ();
+	vpn = nm_ip4_config_new (1);
+	for (i = 0; i < n; i++) {
+		route = *nmtst_platform_ip4_route ("0.0.0.0", 24, "192.168.1.1");
+		route.network = htonl (0x0b000000u + (i << 8));
+		route.metric = 50;
+		route.rt_source = NM_IP_CONFIG_SOURCE_VPN;
+		nm_ip4_config_add_route (vpn, &route);
+	}
+	/* adding the same route again updates it in place */
+	nm_ip4_config_add_route (vpn, nm_ip4_config_get_route (vpn, n / 2));
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (vpn), ==, n);
+
+	nm_ip4_config_merge (dev, vpn, NM_IP_CONFIG_MERGE_DEFAULT);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dev), ==, n + 2);
+	nm_ip4_config_merge (dev, vpn, NM_IP_CONFIG_MERGE_DEFAULT);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dev), ==, n + 2);
+
+	/* the order of the merged routes is preserved */
+	for (i = 0; i < n; i++) {
+		test_route = nm_ip4_config_get_route (dev, i + 2);
+		g_assert_cmpuint (test_route->network, ==, htonl (0x0b000000u + (i << 8)));
+	}
+
+	cfg = nm_ip4_config_new (1);
+	nm_ip4_config_merge (cfg, dev, NM_IP_CONFIG_MERGE_DEFAULT);
+	nm_ip4_config_intersect (cfg, vpn);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (cfg), ==, n);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg), ==, 0);
+
+	nm_ip4_config_subtract (dev, vpn);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dev), ==, 2);
+	test_route = nm_ip4_config_get_route (dev, 0);
+	g_assert_cmpuint (test_route->network, ==, nmtst_inet4_from_string ("10.0.0.0"));
+	test_route = nm_ip4_config_get_route (dev, 1);
+	g_assert_cmpuint (test_route->network, ==, nmtst_inet4_from_string ("172.16.0.0"));
+
+	/* looking up after removal doesn't use a stale index */
+	route = *nmtst_platform_ip4_route ("172.16.0.0", 16, "192.168.1.2");
+	nm_ip4_config_add_route (dev, &route);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dev), ==, 2);
+	g_assert_cmpuint (nm_ip4_config_get_route (dev, 1)->gateway, ==, nmtst_inet4_from_string ("192.168.1.2"));
+
+	g_object_unref (dev);
+	g_object_unref (vpn);
+	g_object_unref (cfg);
+}
+
+static void
+_notify_count_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	(*((guint *) user_data))++;
+}
+
+static void
+test_replace_changes (void)
+{
+	NMIP4Config *dst, *src;
+	NMPlatformIP4Address addr;
+	NMIPConfigChangeFlags changes;
+	gboolean relevant_changes;
+	guint n_notify = 0;
+
+	dst = build_test_config ();
+	src = build_test_config ();
+
+	g_signal_connect (dst, "notify::" NM_IP4_CONFIG_ADDRESS_DATA, G_CALLBACK (_notify_count_cb), &n_notify);
+	g_signal_connect (dst, "notify::" NM_IP4_CONFIG_ROUTE_DATA, G_CALLBACK (_notify_count_cb), &n_notify);
+	g_signal_connect (dst, "notify::" NM_IP4_CONFIG_NAMESERVERS, G_CALLBACK (_notify_count_cb), &n_notify);
+
+	g_assert (!nm_ip4_config_replace (dst, src, &relevant_changes, &changes));
+	g_assert (!relevant_changes);
+	g_assert_cmpint (changes, ==, NM_IP_CONFIG_CHANGE_NONE);
+
+	/* a renewal that only extends the lifetime */
+	addr = *nm_ip4_config_get_address (src, 0);
+	addr.lifetime = 3600;
+	addr.preferred = 3600;
+	nm_ip4_config_reset_addresses (src);
+	nm_ip4_config_add_address (src, &addr);
+
+	g_assert (nm_ip4_config_replace (dst, src, &relevant_changes, &changes));
+	g_assert (!relevant_changes);
+	g_assert_cmpint (changes, ==, NM_IP_CONFIG_CHANGE_ADDRESS_ATTRIBUTES);
+	g_assert_cmpuint (nm_ip4_config_get_address (dst, 0)->lifetime, ==, 3600);
+	g_assert_cmpuint (n_notify, ==, 0);
+
+	/* the lookup index is still valid after the update in place */
+	g_assert (nm_ip4_config_address_exists (dst, &addr));
+
+	nm_ip4_config_add_nameserver (src, nmtst_inet4_from_string ("8.8.8.8"));
+	g_assert (nm_ip4_config_replace (dst, src, &relevant_changes, &changes));
+	g_assert (relevant_changes);
+	g_assert_cmpint (changes, ==, NM_IP_CONFIG_CHANGE_NAMESERVERS);
+	g_assert (NM_FLAGS_ANY (changes, NM_IP_CONFIG_CHANGE_DNS));
+	g_assert_cmpuint (n_notify, ==, 1);
+
+	g_object_unref (dst);
+	g_object_unref (src);
+}
+
+static void
+test_replace_shares_arrays (void)
+{
+	NMIP4Config *dst, *src, *clone;
+	NMPlatformIP4Route route;
+	NMPlatformIP4Address addr;
+
+	dst = nm_ip4_config_new (1);
+	src = build_test_config ();
+
+	g_assert (nm_ip4_config_replace (dst, src, NULL, NULL));
+	clone = nm_ip4_config_new_cloned (dst);
+	g_assert (nm_ip4_config_equal (dst, src));
+	g_assert (nm_ip4_config_equal (clone, src));
+
+	/* modifying one of the configs leaves the others alone */
+	route = *nmtst_platform_ip4_route ("192.168.3.0", 24, "192.168.1.1");
+	nm_ip4_config_add_route (dst, &route);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 3);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (src), ==, 2);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (clone), ==, 2);
+
+	nm_ip4_config_reset_addresses (src);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (src), ==, 0);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (dst), ==, 1);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (clone), ==, 1);
+
+	addr = *nm_ip4_config_get_address (clone, 0);
+	nm_ip4_config_del_address (clone, 0);
+	g_assert (nm_ip4_config_address_exists (dst, &addr));
+	g_assert (!nm_ip4_config_address_exists (clone, &addr));
+
+	nm_ip4_config_subtract (dst, clone);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 1);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (clone), ==, 2);
+
+	g_object_unref (dst);
+	g_object_unref (src);
+	g_object_unref (clone);
+}
+
+static void
+test_cached_variants (void)
+{
+	NMIP4Config *config;
+	NMPlatformIP4Address addr;
+	GVariant *v1, *v2;
+
+	config = build_test_config ();
+
+	g_object_get (config, NM_IP4_CONFIG_ADDRESS_DATA, &v1, NULL);
+	g_object_get (config, NM_IP4_CONFIG_ADDRESS_DATA, &v2, NULL);
+	g_assert (v1 == v2);
+	g_assert_cmpuint (g_variant_n_children (v1), ==, 1);
+	g_variant_unref (v2);
+
+	addr = *nmtst_platform_ip4_address ("192.168.2.10", NULL, 24);
+	nm_ip4_config_add_address (config, &addr);
+
+	g_object_get (config, NM_IP4_CONFIG_ADDRESS_DATA, &v2, NULL);
+	g_assert (v1 != v2);
+	g_assert_cmpuint (g_variant_n_children (v2), ==, 2);
+	g_variant_unref (v1);
+	g_variant_unref (v2);
+
+	/* the legacy addresses carry the gateway */
+	g_object_get (config, NM_IP4_CONFIG_ADDRESSES, &v1, NULL);
+	nm_ip4_config_set_gateway (config, nmtst_inet4_from_string ("192.168.1.254"));
+	g_object_get (config, NM_IP4_CONFIG_ADDRESSES, &v2, NULL);
+	g_assert (!g_variant_equal (v1, v2));
+	g_variant_unref (v1);
+	g_variant_unref (v2);
+
+	g_object_unref (config);
+}
+
+static void
+test_digest (void)
+{
+	NMIP4Config *a, *b;
+	guint64 full, dns;
+
+	a = build_test_config ();
+	b = build_test_config ();
+	g_assert (nm_ip4_config_equal (a, b));
+	g_assert (!nm_ip4_config_equal (a, NULL));
+
+	full = nm_ip4_config_get_digest (a, FALSE);
+	dns = nm_ip4_config_get_digest (a, TRUE);
+
+	/* the NIS servers are not exported but still covered */
+	nm_ip4_config_add_nis_server (a, nmtst_inet4_from_string ("1.2.3.4"));
+	g_assert_cmpuint (nm_ip4_config_get_digest (a, FALSE), !=, full);
+	g_assert_cmpuint (nm_ip4_config_get_digest (a, TRUE), ==, dns);
+	g_assert (!nm_ip4_config_equal (a, b));
+
+	nm_ip4_config_add_search (a, "foo.example.com");
+	g_assert_cmpuint (nm_ip4_config_get_digest (a, TRUE), !=, dns);
+
+	nm_ip4_config_add_nis_server (b, nmtst_inet4_from_string ("1.2.3.4"));
+	nm_ip4_config_add_search (b, "foo.example.com");
+	g_assert (nm_ip4_config_equal (a, b));
+
+	g_object_unref (a);
+	g_object_unref (b);
+
+	a = nm_ip4_config_new (1);
+	g_assert (nm_ip4_config_equal (a, NULL));
+	g_object_unref (a);
+}
+
 static void
 test_strip_search_trailing_dot (void)
 {
@@ -337,6 +608,12 @@ main (int argc, char **argv)
 	g_test_add_func ("/ip4-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip4-config/merge-subtract-mss-mtu", test_merge_subtract_mss_mtu);
 	g_test_add_func ("/ip4-config/strip-search-trailing-dot", test_strip_search_trailing_dot);
+	g_test_add_func ("/ip4-config/add-routes-bulk", test_add_routes_bulk);
+	g_test_add_func ("/ip4-config/merge-many-routes", test_merge_many_routes);
+	g_test_add_func ("/ip4-config/replace-changes", test_replace_changes);
+	g_test_add_func ("/ip4-config/replace-shares-arrays", test_replace_shares_arrays);
+	g_test_add_func ("/ip4-config/cached-variants", test_cached_variants);
+	g_test_add_func ("/ip4-config/digest", test_digest);
 
 	return g_test_run ();
 }
@@ -270,7 +270,7 @@ test_nm_ip6_config_addresses_sort_check (NMIP6Config *config, NMSettingIP6Config
 		}
 
 		/* also check equality using nm_ip6_config_replace() */
-		g_assert (nm_ip6_config_replace (copy2, copy, NULL) == FALSE);
+		g_assert (nm_ip6_config_replace (copy2, copy, NULL, NULL) == FALSE);
 	}
 
 	g_free (idx);
@@ -871,6 +871,83 @@ test_ip4_full_sync (test_fixture *fixture, gconstpointer user_data)
 	nm_log_dbg (LOGD_CORE, "TEST test_ip4_full_sync(): done");
 }
 
+static NMPlatformIP4Route
+_many_routes_route (int ifindex, guint i, guint32 metric)
+{
+	NMPlatformIP4Route route = { 0 };
+
+	route.ifindex = ifindex;
+	route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+	route.network = htonl (0x20000000u + (i << 8));
+	route.plen = 24;
+	route.metric = metric;
+	route.scope_inv = nm_platform_route_scope_inv (RT_SCOPE_LINK);
+	return route;
+}
+
+static guint
+_many_routes_count (int ifindex)
+{
+	gs_unref_array GArray *routes = NULL;
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	return routes->len;
+}
+
+static void
+test_ip4_many_routes (test_fixture *fixture, gconstpointer user_data)
+{
+	const NMPlatformVTableRoute *vtable = &nm_platform_vtable_route_v4;
+	const guint n_routes = nmtst_test_quick () ? 1000 : 100000;
+	gs_unref_array GArray *routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route), n_routes + 1);
+	NMPlatformIP4Route r_first, r_middle, r_last, r_new;
+	guint i;
+
+	nm_log_dbg (LOGD_CORE, "TEST start test_ip4_many_routes(): start");
+
+	for (i = 0; i < n_routes; i++) {
+		NMPlatformIP4Route route = _many_routes_route (fixture->ifindex0, i, 100);
+
+		g_array_append_val (routes, route);
+	}
+	r_first = g_array_index (routes, NMPlatformIP4Route, 0);
+	r_middle = g_array_index (routes, NMPlatformIP4Route, n_routes / 2);
+	r_last = g_array_index (routes, NMPlatformIP4Route, n_routes - 1);
+	r_new = _many_routes_route (fixture->ifindex0, n_routes, 100);
+
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+	g_assert_cmpint (_many_routes_count (fixture->ifindex0), ==, n_routes);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_first);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_middle);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_last);
+
+	/* syncing again changes nothing. */
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+	g_assert_cmpint (_many_routes_count (fixture->ifindex0), ==, n_routes);
+
+	/* replace a single route. */
+	g_array_remove_index_fast (routes, 0);
+	g_array_append_val (routes, r_new);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, FALSE));
+	g_assert_cmpint (_many_routes_count (fixture->ifindex0), ==, n_routes);
+	_assert_route_check (vtable, FALSE, (const NMPlatformIPXRoute *) &r_first);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_middle);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_last);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_new);
+
+	/* a route added outside of route-manager goes away on full sync. */
+	vtable->route_add (NM_PLATFORM_GET, 0, (const NMPlatformIPXRoute *) &r_first, -1);
+	_assert_route_check (vtable, TRUE, (const NMPlatformIPXRoute *) &r_first);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+	g_assert_cmpint (_many_routes_count (fixture->ifindex0), ==, n_routes);
+	_assert_route_check (vtable, FALSE, (const NMPlatformIPXRoute *) &r_first);
+
+	g_assert (nm_route_manager_route_flush (nm_route_manager_get (), fixture->ifindex0));
+	g_assert_cmpint (_many_routes_count (fixture->ifindex0), ==, 0);
+
+	nm_log_dbg (LOGD_CORE, "TEST test_ip4_many_routes(): done");
+}
+
 /*****************************************************************************/
 
 static void
@@ -925,4 +1002,5 @@ _nmtstp_setup_tests (void)
 	g_test_add ("/route-manager/ip6", test_fixture, NULL, fixture_setup, test_ip6, fixture_teardown);
 
 	g_test_add ("/route-manager/ip4-full-sync", test_fixture, NULL, fixture_setup, test_ip4_full_sync, fixture_teardown);
+	g_test_add ("/route-manager/ip4-many-routes", test_fixture, NULL, fixture_setup, test_ip4_many_routes, fixture_teardown);
 }
@@ -19,12 +19,17 @@
 
 #include "nm-default.h"
 
+#include <sys/eventfd.h>
+
 #include "nm-sd.h"
+#include "nm-sd-adapt.h"
 
 #include "sd-dhcp-client.h"
 #include "sd-lldp.h"
 #include "sd-event.h"
 
+#include "dhcp-internal.h"
+
 #include "nm-test-utils-core.h"
 
 /*****************************************************************************/
@@ -125,6 +130,212 @@ test_sd_event (void)
 
 /*****************************************************************************/
 
+static int
+_test_sd_event_defer_cb (sd_event_source *s, void *userdata)
+{
+	guint *counter = userdata;
+
+	(*counter)++;
+	return 0;
+}
+
+static void
+test_sd_event_batch (void)
+{
+	guint sd_id;
+	sd_event *event = NULL;
+	sd_event_source *sources[32];
+	guint counter = 0;
+	guint i;
+	int r;
+
+	sd_id = nm_sd_event_attach_default ();
+
+	r = sd_event_default (&event);
+	g_assert (r >= 0 && event);
+
+	for (i = 0; i < G_N_ELEMENTS (sources); i++) {
+		r = sd_event_add_defer (event, &sources[i], _test_sd_event_defer_cb, &counter);
+		g_assert (r >= 0 && sources[i]);
+	}
+
+	/* all of them are dispatched in one iteration of the main loop */
+	g_main_context_iteration (NULL, FALSE);
+	g_assert_cmpint (counter, ==, G_N_ELEMENTS (sources));
+
+	for (i = 0; i < G_N_ELEMENTS (sources); i++)
+		sources[i] = sd_event_source_unref (sources[i]);
+	event = sd_event_unref (event);
+	nm_clear_g_source (&sd_id);
+}
+
+/*****************************************************************************/
+
+static int
+_test_shared_raw_open (void)
+{
+	int fd;
+
+	/* pollable, but never readable: packets are passed in directly */
+	fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+	return fd < 0 ? -errno : fd;
+}
+
+typedef struct {
+	guint n_calls;
+	uint32_t xid;
+} TestSharedRawData;
+
+static int
+_test_shared_raw_handler (DHCPMessage *message, size_t len, void *userdata)
+{
+	TestSharedRawData *data = userdata;
+
+	data->n_calls++;
+	data->xid = be32toh (message->xid);
+	return 0;
+}
+
+static int
+_test_shared_raw_deliver (int ifindex, uint32_t xid, const uint8_t *mac)
+{
+	gs_free DHCPPacket *packet = NULL;
+	size_t optlen = 4, optoffset, len;
+	int r;
+
+	len = sizeof (DHCPPacket) + optlen;
+	packet = g_malloc0 (len);
+
+	r = dhcp_message_init (&packet->dhcp, BOOTREPLY, xid, DHCP_OFFER,
+	                       ARPHRD_ETHER, optlen, &optoffset);
+	g_assert_cmpint (r, ==, 0);
+	memcpy (packet->dhcp.chaddr, mac, ETH_ALEN);
+	dhcp_packet_append_ip_headers (packet, htobe32 (0x0a000001), DHCP_PORT_SERVER,
+	                               INADDR_BROADCAST, DHCP_PORT_CLIENT, len);
+
+	return dhcp_network_shared_raw_deliver (ifindex, packet, len);
+}
+
+static DHCPSharedRawListener *
+_test_shared_raw_register (sd_event *event, int ifindex, uint32_t xid,
+                           const uint8_t *mac, TestSharedRawData *data)
+{
+	DHCPSharedRawListener *listener = NULL;
+	union sockaddr_union link = { };
+	int r;
+
+	r = dhcp_network_shared_raw_register (event, 0, ifindex, &link, xid,
+	                                      mac, ETH_ALEN, ARPHRD_ETHER,
+	                                      _test_shared_raw_handler, data,
+	                                      &listener);
+	g_assert_cmpint (r, ==, 0);
+	g_assert (listener);
+
+	/* the clients send through the shared socket on their own interface */
+	g_assert_cmpint (link.ll.sll_ifindex, ==, ifindex);
+	g_assert_cmpint (link.ll.sll_family, ==, AF_PACKET);
+	return listener;
+}
+
+static void
+test_dhcp_shared_raw (void)
+{
+	static const uint8_t mac1[ETH_ALEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x01 };
+	static const uint8_t mac2[ETH_ALEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x02 };
+	DHCPSharedRawListener *l1, *l2, *l3, *dup = NULL;
+	TestSharedRawData d1 = { 0 }, d2 = { 0 }, d3 = { 0 };
+	union sockaddr_union link = { };
+	sd_event *event = NULL, *other = NULL;
+	int r;
+
+	dhcp_network_shared_raw_set_open_func (_test_shared_raw_open);
+
+	r = sd_event_new (&event);
+	g_assert (r >= 0 && event);
+
+	g_assert_cmpint (dhcp_network_shared_raw_deliver (1, NULL, 0), ==, -EINVAL);
+
+	/* two clients on one interface, and one on another interface */
+	l1 = _test_shared_raw_register (event, 10, 0x1001, mac1, &d1);
+	l2 = _test_shared_raw_register (event, 10, 0x1002, mac1, &d2);
+	l3 = _test_shared_raw_register (event, 11, 0x1001, mac2, &d3);
+
+	/* they all use the same socket */
+	g_assert_cmpint (dhcp_network_shared_raw_get_fd (l1), >=, 0);
+	g_assert_cmpint (dhcp_network_shared_raw_get_fd (l1), ==, dhcp_network_shared_raw_get_fd (l2));
+	g_assert_cmpint (dhcp_network_shared_raw_get_fd (l1), ==, dhcp_network_shared_raw_get_fd (l3));
+
+	/* one listener per interface and transaction id */
+	r = dhcp_network_shared_raw_register (event, 0, 10, &link, 0x1001, mac1, ETH_ALEN,
+	                                      ARPHRD_ETHER, _test_shared_raw_handler, &d1, &dup);
+	g_assert_cmpint (r, ==, -EEXIST);
+	g_assert (!dup);
+
+	/* the socket is dispatched from a single event loop */
+	r = sd_event_new (&other);
+	g_assert (r >= 0 && other);
+	r = dhcp_network_shared_raw_register (other, 0, 12, &link, 0x1003, mac1, ETH_ALEN,
+	                                      ARPHRD_ETHER, _test_shared_raw_handler, &d1, &dup);
+	g_assert_cmpint (r, ==, -EBUSY);
+	g_assert (!dup);
+	other = sd_event_unref (other);
+
+	/* replies are demultiplexed by interface and transaction id */
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1002, mac1), ==, 1);
+	g_assert_cmpint (d1.n_calls, ==, 0);
+	g_assert_cmpint (d2.n_calls, ==, 1);
+	g_assert_cmpint (d2.xid, ==, 0x1002);
+	g_assert_cmpint (d3.n_calls, ==, 0);
+
+	g_assert_cmpint (_test_shared_raw_deliver (11, 0x1001, mac2), ==, 1);
+	g_assert_cmpint (d1.n_calls, ==, 0);
+	g_assert_cmpint (d3.n_calls, ==, 1);
+
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1001, mac1), ==, 1);
+	g_assert_cmpint (d1.n_calls, ==, 1);
+	g_assert_cmpint (d1.xid, ==, 0x1001);
+
+	/* unknown interface or transaction id */
+	g_assert_cmpint (_test_shared_raw_deliver (12, 0x1001, mac1), ==, 0);
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1003, mac1), ==, 0);
+
+	/* the hardware address must match the client, like the per-client
+	 * filter requires */
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1001, mac2), ==, 0);
+	g_assert_cmpint (_test_shared_raw_deliver (11, 0x1001, mac1), ==, 0);
+
+	g_assert_cmpint (d1.n_calls, ==, 1);
+	g_assert_cmpint (d2.n_calls, ==, 1);
+	g_assert_cmpint (d3.n_calls, ==, 1);
+
+	/* an unregistered client gets no more replies */
+	l2 = dhcp_network_shared_raw_unregister (l2);
+	g_assert (!l2);
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1002, mac1), ==, 0);
+	g_assert_cmpint (d2.n_calls, ==, 1);
+
+	/* the socket is closed with the last client */
+	l1 = dhcp_network_shared_raw_unregister (l1);
+	g_assert_cmpint (_test_shared_raw_deliver (11, 0x1001, mac2), ==, 1);
+	l3 = dhcp_network_shared_raw_unregister (l3);
+	g_assert_cmpint (_test_shared_raw_deliver (11, 0x1001, mac2), ==, -ENOENT);
+	g_assert_cmpint (d3.n_calls, ==, 2);
+
+	/* and opened again for the next one, also from another event loop */
+	r = sd_event_new (&other);
+	g_assert (r >= 0 && other);
+	l1 = _test_shared_raw_register (other, 10, 0x1001, mac1, &d1);
+	g_assert_cmpint (_test_shared_raw_deliver (10, 0x1001, mac1), ==, 1);
+	g_assert_cmpint (d1.n_calls, ==, 2);
+	l1 = dhcp_network_shared_raw_unregister (l1);
+	other = sd_event_unref (other);
+
+	event = sd_event_unref (event);
+	dhcp_network_shared_raw_set_open_func (NULL);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -133,8 +344,10 @@ main (int argc, char **argv)
 	nmtst_init_assert_logging (&argc, &argv, "INFO", "ALL");
 
 	g_test_add_func ("/systemd/dhcp/create", test_dhcp_create);
+	g_test_add_func ("/systemd/dhcp/shared-raw", test_dhcp_shared_raw);
 	g_test_add_func ("/systemd/lldp/create", test_lldp_create);
 	g_test_add_func ("/systemd/sd-event", test_sd_event);
+	g_test_add_func ("/systemd/sd-event/batch", test_sd_event_batch);
 
 	return g_test_run ();
 }
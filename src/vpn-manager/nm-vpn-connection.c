@@ -95,6 +95,7 @@ typedef struct {
 	NMVpnServiceState service_state;
 	guint start_timeout;
 	gboolean service_running;
+	gboolean service_prewarmed;
 	NMVpnPluginInfo *plugin_info;
 	char *bus_name;
 
@@ -212,7 +213,7 @@ __LOG_create_prefix (char *buf, NMVpnConnection *self)
     G_STMT_START { \
         const NMLogLevel __level = (level); \
         \
-        if (nm_logging_enabled (__level, _NMLOG_DOMAIN)) { \
+        if (_nm_logging_wanted (__level, _NMLOG_DOMAIN)) { \
             char __prefix[__NMLOG_prefix_buf_len]; \
             \
             _nm_log (__level, _NMLOG_DOMAIN, 0, \
@@ -1427,22 +1428,33 @@ nm_vpn_connection_ip4_config_get (NMVpnConnection *self, GVariant *dict)
 	route_metric = nm_vpn_connection_get_ip4_route_metric (self);
 
 	if (g_variant_lookup (dict, NM_VPN_PLUGIN_IP4_CONFIG_ROUTES, "aau", &iter)) {
+		gs_unref_array GArray *routes = NULL;
+
+		/* split tunnels can push many thousands of routes. Collect them
+		 * and add them to the config at once. */
+		routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route),
+		                            g_variant_iter_n_children (iter));
+
 		while (g_variant_iter_next (iter, "@au", &v)) {
 			NMPlatformIP4Route route = { 0, };
+			const guint32 *fields;
+			gsize n_fields;
+
+			fields = g_variant_get_fixed_array (v, &n_fields, sizeof (guint32));
 
-			switch (g_variant_n_children (v)) {
+			switch (n_fields) {
 			case 5:
-				g_variant_get_child (v, 4, "u", &route.pref_src);
+				route.pref_src = fields[4];
 				/* fallthrough */
 			case 4:
-				g_variant_get_child (v, 0, "u", &route.network);
-				g_variant_get_child (v, 1, "u", &route.plen);
-				g_variant_get_child (v, 2, "u", &route.gateway);
+				route.network = fields[0];
+				route.plen = fields[1];
+				route.gateway = fields[2];
 				/* 4th item is unused route metric */
 				route.metric = route_metric;
 				route.rt_source = NM_IP_CONFIG_SOURCE_VPN;
 
-				if (route.plen > 32)
+				if (fields[1] > 32)
 					break;
 
 				/* Ignore host routes to the VPN gateway since NM adds one itself
@@ -1451,7 +1463,7 @@ nm_vpn_connection_ip4_config_get (NMVpnConnection *self, GVariant *dict)
 				 * whatever the server provides.
 				 */
 				if (!(priv->ip4_external_gw && route.network == priv->ip4_external_gw && route.plen == 32))
-					nm_ip4_config_add_route (config, &route);
+					g_array_append_val (routes, route);
 				break;
 			default:
 				break;
@@ -1459,6 +1471,8 @@ nm_vpn_connection_ip4_config_get (NMVpnConnection *self, GVariant *dict)
 			g_variant_unref (v);
 		}
 		g_variant_iter_free (iter);
+
+		nm_ip4_config_add_routes (config, (const NMPlatformIP4Route *) routes->data, routes->len);
 	}
 
 	if (g_variant_lookup (dict, NM_VPN_PLUGIN_IP4_CONFIG_NEVER_DEFAULT, "b", &b))
@@ -1564,9 +1578,13 @@ nm_vpn_connection_ip6_config_get (NMVpnConnection *self, GVariant *dict)
 	route_metric = nm_vpn_connection_get_ip6_route_metric (self);
 
 	if (g_variant_lookup (dict, NM_VPN_PLUGIN_IP6_CONFIG_ROUTES, "a(ayuayu)", &iter)) {
+		gs_unref_array GArray *routes = NULL;
 		GVariant *dest, *next_hop;
 		guint32 prefix, metric;
 
+		routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP6Route),
+		                            g_variant_iter_n_children (iter));
+
 		while (g_variant_iter_next (iter, "(@ayu@ayu)", &dest, &prefix, &next_hop, &metric)) {
 			NMPlatformIP6Route route;
 
@@ -1589,13 +1607,15 @@ nm_vpn_connection_ip6_config_get (NMVpnConnection *self, GVariant *dict)
 			 * the server provides.
 			 */
 			if (!(priv->ip6_external_gw && IN6_ARE_ADDR_EQUAL (&route.network, priv->ip6_external_gw) && route.plen == 128))
-				nm_ip6_config_add_route (config, &route);
+				g_array_append_val (routes, route);
 
 next:
 			g_variant_unref (dest);
 			g_variant_unref (next_hop);
 		}
 		g_variant_iter_free (iter);
+
+		nm_ip6_config_add_routes (config, (const NMPlatformIP6Route *) routes->data, routes->len);
 	}
 
 	if (g_variant_lookup (dict, NM_VPN_PLUGIN_IP6_CONFIG_NEVER_DEFAULT, "b", &b))
@@ -1960,10 +1980,25 @@ _get_log_level (void)
 	return LOG_EMERG;
 }
 
-static gboolean
-nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
+/**
+ * nm_vpn_service_spawn:
+ * @plugin_info: the VPN plugin
+ * @bus_name: the bus name the service shall claim. Only passed on to
+ *   plugins that support multiple connections, the others always claim
+ *   their service name.
+ * @out_pid: (allow-none): the PID of the started service
+ * @error: location for a #GError
+ *
+ * Starts the service daemon of @plugin_info.
+ *
+ * Returns: %TRUE if the daemon was spawned
+ */
+gboolean
+nm_vpn_service_spawn (NMVpnPluginInfo *plugin_info,
+                      const char *bus_name,
+                      GPid *out_pid,
+                      GError **error)
 {
-	NMVpnConnectionPrivate *priv;
 	GPid pid;
 	char *vpn_argv[4];
 	gboolean success = FALSE;
@@ -1975,16 +2010,15 @@ nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
 	const int N_ENVIRON_EXTRA = 3;
 	char **p_environ;
 
-	g_return_val_if_fail (NM_IS_VPN_CONNECTION (self), FALSE);
-
-	priv = NM_VPN_CONNECTION_GET_PRIVATE (self);
+	g_return_val_if_fail (NM_IS_VPN_PLUGIN_INFO (plugin_info), FALSE);
 
 	i = 0;
-	vpn_argv[i++] = (char *) nm_vpn_plugin_info_get_program (priv->plugin_info);
+	vpn_argv[i++] = (char *) nm_vpn_plugin_info_get_program (plugin_info);
 	g_return_val_if_fail (vpn_argv[0], FALSE);
-	if (nm_vpn_plugin_info_supports_multiple (priv->plugin_info)) {
+	if (nm_vpn_plugin_info_supports_multiple (plugin_info)) {
+		g_return_val_if_fail (bus_name, FALSE);
 		vpn_argv[i++] = "--bus-name";
-		vpn_argv[i++] = priv->bus_name;
+		vpn_argv[i++] = (char *) bus_name;
 	}
 	vpn_argv[i++] = NULL;
 
@@ -2013,10 +2047,9 @@ nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
 
 	success = g_spawn_async (NULL, vpn_argv, envp, 0, nm_utils_setpgid, NULL, &pid, &spawn_error);
 
-	if (success) {
-		_LOGI ("Started the VPN service, PID %ld", (long int) pid);
-		priv->start_timeout = g_timeout_add_seconds (5, _daemon_exec_timeout, self);
-	} else {
+	if (success)
+		NM_SET_OUT (out_pid, pid);
+	else {
 		g_set_error (error,
 		             NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
 		             "%s", spawn_error ? spawn_error->message : "unknown g_spawn_async() error");
@@ -2028,6 +2061,20 @@ nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
 	return success;
 }
 
+static gboolean
+nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
+{
+	NMVpnConnectionPrivate *priv = NM_VPN_CONNECTION_GET_PRIVATE (self);
+	GPid pid;
+
+	if (!nm_vpn_service_spawn (priv->plugin_info, priv->bus_name, &pid, error))
+		return FALSE;
+
+	_LOGI ("Started the VPN service, PID %ld", (long int) pid);
+	priv->start_timeout = g_timeout_add_seconds (5, _daemon_exec_timeout, self);
+	return TRUE;
+}
+
 static void
 on_proxy_acquired (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -2062,6 +2109,14 @@ on_proxy_acquired (GObject *object, GAsyncResult *result, gpointer user_data)
 	if (priv->service_running)
 		return;
 
+	if (priv->service_prewarmed) {
+		/* the service was already started for us, and is still
+		 * claiming its bus name. */
+		_LOGD ("Waiting for the pre-warmed VPN service");
+		priv->start_timeout = g_timeout_add_seconds (5, _daemon_exec_timeout, self);
+		return;
+	}
+
 	if (!nm_vpn_service_daemon_exec (self, &error)) {
 		_LOGW ("Could not launch the VPN service. error: %s.",
 		       error->message);
@@ -2070,9 +2125,18 @@ on_proxy_acquired (GObject *object, GAsyncResult *result, gpointer user_data)
 	}
 }
 
+/**
+ * nm_vpn_connection_activate:
+ * @self: the #NMVpnConnection
+ * @plugin_info: the VPN plugin for the connection
+ * @prewarmed_bus_name: (allow-none): the bus name of an idle service
+ *   daemon that was started ahead of time for this connection. If %NULL,
+ *   the connection starts its own daemon.
+ */
 void
 nm_vpn_connection_activate (NMVpnConnection *self,
-                            NMVpnPluginInfo *plugin_info)
+                            NMVpnPluginInfo *plugin_info,
+                            const char *prewarmed_bus_name)
 {
 	NMVpnConnectionPrivate *priv;
 	NMSettingVpn *s_vpn;
@@ -2090,7 +2154,10 @@ nm_vpn_connection_activate (NMVpnConnection *self,
 	service = nm_vpn_plugin_info_get_service (plugin_info);
 	nm_assert (service);
 
-	if (nm_vpn_plugin_info_supports_multiple (plugin_info)) {
+	if (prewarmed_bus_name) {
+		priv->bus_name = g_strdup (prewarmed_bus_name);
+		priv->service_prewarmed = TRUE;
+	} else if (nm_vpn_plugin_info_supports_multiple (plugin_info)) {
 		const char *path;
 
 		path = nm_exported_object_get_path (NM_EXPORTED_OBJECT (self));
@@ -2415,7 +2482,8 @@ get_secrets (NMVpnConnection *self,
 		flags = NM_SECRET_AGENT_GET_SECRETS_FLAG_ONLY_SYSTEM;
 		break;
 	case SECRETS_REQ_EXISTING:
-		flags = NM_SECRET_AGENT_GET_SECRETS_FLAG_NONE;
+		/* on a reconnect, the agent doesn't need to be asked again */
+		flags = NM_SECRET_AGENT_GET_SECRETS_FLAG_CACHED;
 		break;
 	case SECRETS_REQ_NEW:
 	case SECRETS_REQ_INTERACTIVE:
@@ -71,13 +71,19 @@ typedef struct {
 
 GType nm_vpn_connection_get_type (void);
 
+gboolean nm_vpn_service_spawn (NMVpnPluginInfo *plugin_info,
+                               const char *bus_name,
+                               GPid *out_pid,
+                               GError **error);
+
 NMVpnConnection * nm_vpn_connection_new (NMSettingsConnection *settings_connection,
                                          NMDevice *parent_device,
                                          const char *specific_object,
                                          NMAuthSubject *subject);
 
 void                 nm_vpn_connection_activate        (NMVpnConnection *self,
-                                                        NMVpnPluginInfo *plugin_info);
+                                                        NMVpnPluginInfo *plugin_info,
+                                                        const char *prewarmed_bus_name);
 NMVpnConnectionState nm_vpn_connection_get_vpn_state   (NMVpnConnection *self);
 const char *         nm_vpn_connection_get_banner      (NMVpnConnection *self);
 const gchar *        nm_vpn_connection_get_service     (NMVpnConnection *self);
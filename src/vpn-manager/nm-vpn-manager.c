@@ -30,6 +30,11 @@
 #include "nm-vpn-dbus-interface.h"
 #include "nm-core-internal.h"
 #include "nm-enum-types.h"
+#include "nm-config.h"
+#include "nm-core-utils.h"
+
+/* minimal interval between two starts of a pre-warmed service */
+#define PREWARM_RETRY_SECS 30
 
 G_DEFINE_TYPE (NMVpnManager, nm_vpn_manager, G_TYPE_OBJECT)
 
@@ -45,8 +50,28 @@ typedef struct {
 	/* This is only used for services that don't support multiple
 	 * connections, to guard access to them. */
 	GHashTable *active_services;
+
+	/* PrewarmEntry by service name, for the services listed in the
+	 * main.vpn-prewarm configuration option. */
+	GHashTable *prewarm;
+	guint prewarm_counter;
 } NMVpnManagerPrivate;
 
+/* One idle service daemon that is kept running, so that activating a
+ * connection doesn't wait for the process to start and claim its name. */
+typedef struct {
+	NMVpnManager *self;
+	NMVpnPluginInfo *plugin_info;
+	char *bus_name;
+	guint watch_id;
+	gboolean running;
+	guint spawn_id;
+	gint64 last_spawn_ms;
+} PrewarmEntry;
+
+static void prewarm_schedule (PrewarmEntry *entry, gboolean now);
+static char *prewarm_take (NMVpnManager *self, NMVpnPluginInfo *plugin_info);
+
 /******************************************************************************/
 
 static void
@@ -59,7 +84,15 @@ vpn_state_changed (NMVpnConnection *vpn,
 	const char *service_name = nm_vpn_connection_get_service (vpn);
 
 	if (state == NM_ACTIVE_CONNECTION_STATE_DEACTIVATED) {
+		PrewarmEntry *entry;
+
 		g_hash_table_remove (priv->active_services, service_name);
+
+		/* the single-connection service is free to be kept warm again */
+		entry = g_hash_table_lookup (priv->prewarm, service_name);
+		if (entry)
+			prewarm_schedule (entry, TRUE);
+
 		g_signal_handlers_disconnect_by_func (vpn, vpn_state_changed, manager);
 		g_object_unref (manager);
 	}
@@ -74,6 +107,7 @@ nm_vpn_manager_activate_connection (NMVpnManager *manager,
 	NMVpnPluginInfo *plugin_info;
 	const char *service_name;
 	NMDevice *device;
+	gs_free char *prewarmed_bus_name = NULL;
 
 	g_return_val_if_fail (NM_IS_VPN_MANAGER (manager), FALSE);
 	g_return_val_if_fail (NM_IS_VPN_CONNECTION (vpn), FALSE);
@@ -107,7 +141,9 @@ nm_vpn_manager_activate_connection (NMVpnManager *manager,
 		return FALSE;
 	}
 
-	nm_vpn_connection_activate (vpn, plugin_info);
+	prewarmed_bus_name = prewarm_take (manager, plugin_info);
+
+	nm_vpn_connection_activate (vpn, plugin_info, prewarmed_bus_name);
 
 	if (!nm_vpn_plugin_info_supports_multiple (plugin_info)) {
 		/* Block activations of the connections of the same service type. */
@@ -204,6 +240,199 @@ vpn_dir_changed (GFileMonitor *monitor,
 
 /******************************************************************************/
 
+static void
+prewarm_name_appeared (GDBusConnection *connection,
+                       const char *name,
+                       const char *name_owner,
+                       gpointer user_data)
+{
+	PrewarmEntry *entry = user_data;
+
+	nm_log_dbg (LOGD_VPN, "vpn: pre-warmed service %s is ready", name);
+	entry->running = TRUE;
+	nm_clear_g_source (&entry->spawn_id);
+}
+
+static void
+prewarm_name_vanished (GDBusConnection *connection,
+                       const char *name,
+                       gpointer user_data)
+{
+	PrewarmEntry *entry = user_data;
+
+	if (entry->running) {
+		/* the daemon quit, usually after its idle timeout */
+		nm_log_dbg (LOGD_VPN, "vpn: pre-warmed service %s went away", name);
+		entry->running = FALSE;
+	}
+	if (!entry->spawn_id)
+		prewarm_schedule (entry, FALSE);
+}
+
+static gboolean
+prewarm_spawn_cb (gpointer user_data)
+{
+	PrewarmEntry *entry = user_data;
+	NMVpnManagerPrivate *priv = NM_VPN_MANAGER_GET_PRIVATE (entry->self);
+	const char *service = nm_vpn_plugin_info_get_service (entry->plugin_info);
+	gs_free_error GError *error = NULL;
+
+	entry->spawn_id = 0;
+
+	if (entry->running)
+		return G_SOURCE_REMOVE;
+
+	/* a single-connection service that is in use can't be duplicated */
+	if (   !nm_vpn_plugin_info_supports_multiple (entry->plugin_info)
+	    && g_hash_table_contains (priv->active_services, service))
+		return G_SOURCE_REMOVE;
+
+	if (!entry->bus_name) {
+		if (nm_vpn_plugin_info_supports_multiple (entry->plugin_info))
+			entry->bus_name = g_strdup_printf ("%s.Connection_prewarm%u", service, ++priv->prewarm_counter);
+		else
+			entry->bus_name = g_strdup (service);
+	}
+
+	if (!entry->watch_id) {
+		/* the watch reports the current owner first. If the service already
+		 * runs, it gets reused without starting another daemon, otherwise
+		 * prewarm_name_vanished() schedules the start. */
+		entry->watch_id = g_bus_watch_name (G_BUS_TYPE_SYSTEM,
+		                                    entry->bus_name,
+		                                    G_BUS_NAME_WATCHER_FLAGS_NONE,
+		                                    prewarm_name_appeared,
+		                                    prewarm_name_vanished,
+		                                    entry,
+		                                    NULL);
+		return G_SOURCE_REMOVE;
+	}
+
+	/* retry if the name doesn't show up */
+	entry->spawn_id = g_timeout_add_seconds (PREWARM_RETRY_SECS, prewarm_spawn_cb, entry);
+
+	entry->last_spawn_ms = nm_utils_get_monotonic_timestamp_ms ();
+	if (!nm_vpn_service_spawn (entry->plugin_info, entry->bus_name, NULL, &error)) {
+		nm_log_warn (LOGD_VPN, "vpn: could not pre-warm the VPN service %s: %s",
+		             service, error->message);
+		return G_SOURCE_REMOVE;
+	}
+
+	nm_log_dbg (LOGD_VPN, "vpn: pre-warming VPN service %s as %s", service, entry->bus_name);
+	return G_SOURCE_REMOVE;
+}
+
+/* Starts the daemon for @entry, but not more often than every
+ * PREWARM_RETRY_SECS. */
+static void
+prewarm_schedule (PrewarmEntry *entry, gboolean now)
+{
+	gint64 delay_ms = 0;
+
+	nm_clear_g_source (&entry->spawn_id);
+
+	if (!now && entry->last_spawn_ms) {
+		delay_ms =   entry->last_spawn_ms + PREWARM_RETRY_SECS * 1000
+		           - nm_utils_get_monotonic_timestamp_ms ();
+	}
+	if (delay_ms > 0)
+		entry->spawn_id = g_timeout_add (delay_ms, prewarm_spawn_cb, entry);
+	else
+		entry->spawn_id = g_idle_add (prewarm_spawn_cb, entry);
+}
+
+/* Hands out the bus name of the idle daemon for @plugin_info, if there is
+ * one running, and starts another one for the next activation. */
+static char *
+prewarm_take (NMVpnManager *self, NMVpnPluginInfo *plugin_info)
+{
+	NMVpnManagerPrivate *priv = NM_VPN_MANAGER_GET_PRIVATE (self);
+	PrewarmEntry *entry;
+	char *bus_name;
+
+	entry = g_hash_table_lookup (priv->prewarm, nm_vpn_plugin_info_get_service (plugin_info));
+	if (!entry || !entry->running)
+		return NULL;
+
+	/* the connection watches the name from now on */
+	if (entry->watch_id) {
+		g_bus_unwatch_name (entry->watch_id);
+		entry->watch_id = 0;
+	}
+	entry->running = FALSE;
+	bus_name = entry->bus_name;
+	entry->bus_name = NULL;
+
+	nm_log_dbg (LOGD_VPN, "vpn: using pre-warmed VPN service %s", bus_name);
+
+	/* single-connection services are warmed up again once the
+	 * connection is done, see vpn_state_changed(). */
+	if (nm_vpn_plugin_info_supports_multiple (plugin_info))
+		prewarm_schedule (entry, TRUE);
+	else
+		nm_clear_g_source (&entry->spawn_id);
+
+	return bus_name;
+}
+
+static void
+prewarm_entry_free (gpointer data)
+{
+	PrewarmEntry *entry = data;
+
+	nm_clear_g_source (&entry->spawn_id);
+	if (entry->watch_id)
+		g_bus_unwatch_name (entry->watch_id);
+	g_object_unref (entry->plugin_info);
+	g_free (entry->bus_name);
+	g_slice_free (PrewarmEntry, entry);
+}
+
+static void
+prewarm_setup (NMVpnManager *self)
+{
+	NMVpnManagerPrivate *priv = NM_VPN_MANAGER_GET_PRIVATE (self);
+	gs_free char *value = NULL;
+	gs_strfreev char **services = NULL;
+	guint i;
+
+	value = nm_config_data_get_value (NM_CONFIG_GET_DATA,
+	                                  NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                  NM_CONFIG_KEYFILE_KEY_MAIN_VPN_PREWARM,
+	                                  NM_CONFIG_GET_VALUE_STRIP);
+	if (!value || !value[0])
+		return;
+
+	services = g_strsplit_set (value, ",; ", -1);
+	for (i = 0; services[i]; i++) {
+		NMVpnPluginInfo *plugin_info;
+		PrewarmEntry *entry;
+		const char *service;
+
+		if (!services[i][0])
+			continue;
+
+		plugin_info = nm_vpn_plugin_info_list_find_by_service (priv->plugins, services[i]);
+		if (!plugin_info) {
+			nm_log_warn (LOGD_VPN, "vpn: cannot pre-warm unknown VPN service '%s'", services[i]);
+			continue;
+		}
+
+		service = nm_vpn_plugin_info_get_service (plugin_info);
+		if (g_hash_table_contains (priv->prewarm, service))
+			continue;
+
+		entry = g_slice_new0 (PrewarmEntry);
+		entry->self = self;
+		entry->plugin_info = g_object_ref (plugin_info);
+		g_hash_table_insert (priv->prewarm, g_strdup (service), entry);
+
+		prewarm_schedule (entry, TRUE);
+	}
+}
+
+/******************************************************************************/
+
 NM_DEFINE_SINGLETON_GETTER (NMVpnManager, nm_vpn_manager_get, NM_TYPE_VPN_MANAGER);
 
 static void
@@ -247,6 +476,9 @@ nm_vpn_manager_init (NMVpnManager *self)
 	g_slist_free_full (infos, g_object_unref);
 
 	priv->active_services = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	priv->prewarm = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, prewarm_entry_free);
+	prewarm_setup (self);
 }
 
 static void
@@ -272,6 +504,7 @@ dispose (GObject *object)
 		nm_vpn_plugin_info_list_remove (&priv->plugins, priv->plugins->data);
 
 	g_hash_table_unref (priv->active_services);
+	g_clear_pointer (&priv->prewarm, g_hash_table_unref);
 
 	G_OBJECT_CLASS (nm_vpn_manager_parent_class)->dispose (object);
 }
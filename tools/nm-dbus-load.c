@@ -0,0 +1,572 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager D-Bus load generator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/* Puts client load on a running NetworkManager. Each simulated client has
+ * its own connection to the bus and keeps a number of method calls in
+ * flight: as soon as a reply arrives, it issues the next call, picked at
+ * random according to the weights of the mix. Optionally, every client
+ * subscribes to the PropertiesChanged signals, like libnm does.
+ *
+ * The methods are:
+ *
+ *   get-all           Properties.GetAll() of the manager or of a device
+ *   list-connections  Settings.ListConnections()
+ *   get-settings      Settings.Connection.GetSettings() of a connection
+ *   activate          ActivateConnection() of the --connection profile
+ *   update            Settings.Connection.Update() of the --connection
+ *                     profile, with its own settings
+ *
+ * activate and update change the state of the daemon and are only issued
+ * for a profile given with --connection, which should be one made for the
+ * test. The results use the format of the benchmark programs:
+ *
+ *   <method> <calls> <total usec> <nsec per call>
+ *
+ * followed by the latencies per method as comment lines. Calls still in
+ * flight when the time is up are waited for, but not counted. */
+
+#include "nm-default.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nm-dbus-interface.h"
+
+typedef enum {
+	METHOD_GET_ALL,
+	METHOD_LIST_CONNECTIONS,
+	METHOD_GET_SETTINGS,
+	METHOD_ACTIVATE,
+	METHOD_UPDATE,
+
+	_METHOD_NUM,
+} Method;
+
+static const char *const method_names[_METHOD_NUM] = {
+	[METHOD_GET_ALL]          = "get-all",
+	[METHOD_LIST_CONNECTIONS] = "list-connections",
+	[METHOD_GET_SETTINGS]     = "get-settings",
+	[METHOD_ACTIVATE]         = "activate",
+	[METHOD_UPDATE]           = "update",
+};
+
+static struct {
+	int clients;
+	int outstanding;
+	int duration;
+	char *mix;
+	char *connection;
+	char *address;
+	gboolean subscribe;
+} global_opt = {
+	.clients = 10,
+	.outstanding = 1,
+	.duration = 10,
+};
+
+typedef struct {
+	GDBusConnection *bus;
+	guint signal_id;
+	guint in_flight;
+} Client;
+
+typedef struct {
+	Client *client;
+	Method method;
+	gint64 start;
+} Call;
+
+static struct {
+	guint weights[_METHOD_NUM];
+	guint weight_sum;
+
+	/* pairs of object path and interface for get-all */
+	GPtrArray *objects;
+	GPtrArray *connections;
+	char *connection_path;
+	GVariant *connection_settings;
+
+	Client *clients;
+	GMainLoop *loop;
+	gboolean stopping;
+	guint in_flight;
+	gint64 start;
+	gint64 end;
+
+	/* latencies in usec */
+	GArray *latencies[_METHOD_NUM];
+	guint errors[_METHOD_NUM];
+	guint64 signals;
+} load;
+
+/*****************************************************************************/
+
+static gboolean
+parse_mix (const char *str)
+{
+	gs_strfreev char **items = NULL;
+	guint i;
+	Method m;
+
+	memset (load.weights, 0, sizeof (load.weights));
+	if (!str) {
+		load.weights[METHOD_GET_ALL] = 50;
+		load.weights[METHOD_LIST_CONNECTIONS] = 20;
+		load.weights[METHOD_GET_SETTINGS] = 30;
+		if (global_opt.connection) {
+			load.weights[METHOD_ACTIVATE] = 2;
+			load.weights[METHOD_UPDATE] = 5;
+		}
+		goto out;
+	}
+
+	items = g_strsplit (str, ",", -1);
+	for (i = 0; items[i]; i++) {
+		char *eq = strchr (items[i], '=');
+		char *end = NULL;
+		gint64 weight;
+
+		if (!eq) {
+			g_printerr ("Invalid mix entry \"%s\", expected METHOD=WEIGHT\n", items[i]);
+			return FALSE;
+		}
+		*eq = '\0';
+		for (m = 0; m < _METHOD_NUM; m++) {
+			if (nm_streq (items[i], method_names[m]))
+				break;
+		}
+		weight = g_ascii_strtoll (eq + 1, &end, 10);
+		if (m == _METHOD_NUM || end == eq + 1 || *end || weight < 0 || weight > 1000) {
+			g_printerr ("Invalid mix entry \"%s=%s\"\n", items[i], eq + 1);
+			return FALSE;
+		}
+		load.weights[m] = weight;
+	}
+
+	if (   !global_opt.connection
+	    && (load.weights[METHOD_ACTIVATE] || load.weights[METHOD_UPDATE])) {
+		g_printerr ("activate and update need a profile given with --connection\n");
+		return FALSE;
+	}
+
+out:
+	load.weight_sum = 0;
+	for (m = 0; m < _METHOD_NUM; m++)
+		load.weight_sum += load.weights[m];
+	if (!load.weight_sum) {
+		g_printerr ("The mix has no method with a weight\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "clients", 'c', 0, G_OPTION_ARG_INT, &global_opt.clients, "Number of clients, each with its own bus connection", "N" },
+		{ "outstanding", 'o', 0, G_OPTION_ARG_INT, &global_opt.outstanding, "Number of calls each client keeps in flight", "K" },
+		{ "duration", 'd', 0, G_OPTION_ARG_INT, &global_opt.duration, "Seconds to run", "SEC" },
+		{ "mix", 'm', 0, G_OPTION_ARG_STRING, &global_opt.mix, "Weights of the methods, like \"get-all=50,get-settings=30,list-connections=20\"", "MIX" },
+		{ "connection", 0, 0, G_OPTION_ARG_STRING, &global_opt.connection, "The profile to activate and update, by UUID or D-Bus path", "UUID|PATH" },
+		{ "subscribe", 's', 0, G_OPTION_ARG_NONE, &global_opt.subscribe, "Let the clients subscribe to PropertiesChanged", NULL },
+		{ "address", 'a', 0, G_OPTION_ARG_STRING, &global_opt.address, "The bus to connect to, instead of the system bus", "ADDRESS" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Put D-Bus client load on a running NetworkManager.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_printerr ("Error parsing command line arguments: %s\n", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+
+	if (   global_opt.clients <= 0
+	    || global_opt.clients > 10000
+	    || global_opt.outstanding <= 0
+	    || global_opt.outstanding > 1000
+	    || global_opt.duration <= 0) {
+		g_printerr ("Invalid arguments: clients must be within 1..10000, outstanding within 1..1000 and duration positive\n");
+		return FALSE;
+	}
+
+	return parse_mix (global_opt.mix);
+}
+
+/*****************************************************************************/
+
+static GVariant *
+call_sync (GDBusConnection *bus,
+           const char *path,
+           const char *interface,
+           const char *method,
+           GVariant *parameters,
+           const char *reply_type)
+{
+	gs_free_error GError *error = NULL;
+	GVariant *ret;
+
+	ret = g_dbus_connection_call_sync (bus, NM_DBUS_SERVICE, path, interface, method,
+	                                   parameters, G_VARIANT_TYPE (reply_type),
+	                                   G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	if (!ret)
+		g_printerr ("%s.%s() on %s failed: %s\n", interface, method, path, error->message);
+	return ret;
+}
+
+/* Looks up the objects the calls are made on. */
+static gboolean
+discover (GDBusConnection *bus)
+{
+	gs_unref_variant GVariant *devices = NULL;
+	gs_unref_variant GVariant *connections = NULL;
+	GVariantIter *iter;
+	const char *path;
+
+	load.objects = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (load.objects, g_strdup (NM_DBUS_PATH));
+	g_ptr_array_add (load.objects, g_strdup (NM_DBUS_INTERFACE));
+
+	devices = call_sync (bus, NM_DBUS_PATH, NM_DBUS_INTERFACE, "GetDevices", NULL, "(ao)");
+	if (!devices)
+		return FALSE;
+	g_variant_get (devices, "(ao)", &iter);
+	while (g_variant_iter_next (iter, "&o", &path)) {
+		g_ptr_array_add (load.objects, g_strdup (path));
+		g_ptr_array_add (load.objects, g_strdup (NM_DBUS_INTERFACE_DEVICE));
+	}
+	g_variant_iter_free (iter);
+
+	connections = call_sync (bus, NM_DBUS_PATH_SETTINGS, NM_DBUS_INTERFACE_SETTINGS, "ListConnections", NULL, "(ao)");
+	if (!connections)
+		return FALSE;
+	load.connections = g_ptr_array_new_with_free_func (g_free);
+	g_variant_get (connections, "(ao)", &iter);
+	while (g_variant_iter_next (iter, "&o", &path))
+		g_ptr_array_add (load.connections, g_strdup (path));
+	g_variant_iter_free (iter);
+
+	if (!load.connections->len && load.weights[METHOD_GET_SETTINGS]) {
+		g_printerr ("There are no connections for get-settings\n");
+		return FALSE;
+	}
+
+	if (global_opt.connection) {
+		gs_unref_variant GVariant *settings = NULL;
+
+		if (global_opt.connection[0] == '/')
+			load.connection_path = g_strdup (global_opt.connection);
+		else {
+			gs_unref_variant GVariant *ret = NULL;
+
+			ret = call_sync (bus, NM_DBUS_PATH_SETTINGS, NM_DBUS_INTERFACE_SETTINGS, "GetConnectionByUuid",
+			                 g_variant_new ("(s)", global_opt.connection), "(o)");
+			if (!ret)
+				return FALSE;
+			g_variant_get (ret, "(o)", &load.connection_path);
+		}
+
+		settings = call_sync (bus, load.connection_path, NM_DBUS_INTERFACE_SETTINGS_CONNECTION, "GetSettings",
+		                      NULL, "(a{sa{sv}})");
+		if (!settings)
+			return FALSE;
+		load.connection_settings = g_variant_get_child_value (settings, 0);
+	}
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void issue_call (Client *client);
+
+static void
+call_done (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	Call *call = user_data;
+	Client *client = call->client;
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+	gint64 now;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	now = g_get_monotonic_time ();
+
+	if (!load.stopping) {
+		if (ret) {
+			gint64 latency = now - call->start;
+
+			g_array_append_val (load.latencies[call->method], latency);
+		} else {
+			if (!load.errors[call->method])
+				g_printerr ("%s failed: %s\n", method_names[call->method], error->message);
+			load.errors[call->method]++;
+		}
+	}
+
+	g_slice_free (Call, call);
+	client->in_flight--;
+	load.in_flight--;
+
+	if (!load.stopping)
+		issue_call (client);
+	else if (!load.in_flight)
+		g_main_loop_quit (load.loop);
+}
+
+static Method
+pick_method (void)
+{
+	guint r = g_random_int_range (0, load.weight_sum);
+	Method m;
+
+	for (m = 0; m < _METHOD_NUM; m++) {
+		if (r < load.weights[m])
+			return m;
+		r -= load.weights[m];
+	}
+	g_return_val_if_reached (METHOD_GET_ALL);
+}
+
+static void
+issue_call (Client *client)
+{
+	Call *call;
+	const char *path, *interface, *method;
+	GVariant *parameters = NULL;
+	guint i;
+
+	call = g_slice_new (Call);
+	call->client = client;
+	call->method = pick_method ();
+
+	switch (call->method) {
+	case METHOD_GET_ALL:
+		i = g_random_int_range (0, load.objects->len / 2);
+		path = load.objects->pdata[2 * i];
+		interface = "org.freedesktop.DBus.Properties";
+		method = "GetAll";
+		parameters = g_variant_new ("(s)", (const char *) load.objects->pdata[2 * i + 1]);
+		break;
+	case METHOD_LIST_CONNECTIONS:
+		path = NM_DBUS_PATH_SETTINGS;
+		interface = NM_DBUS_INTERFACE_SETTINGS;
+		method = "ListConnections";
+		break;
+	case METHOD_GET_SETTINGS:
+		path = load.connections->pdata[g_random_int_range (0, load.connections->len)];
+		interface = NM_DBUS_INTERFACE_SETTINGS_CONNECTION;
+		method = "GetSettings";
+		break;
+	case METHOD_ACTIVATE:
+		path = NM_DBUS_PATH;
+		interface = NM_DBUS_INTERFACE;
+		method = "ActivateConnection";
+		parameters = g_variant_new ("(ooo)", load.connection_path, "/", "/");
+		break;
+	case METHOD_UPDATE:
+		path = load.connection_path;
+		interface = NM_DBUS_INTERFACE_SETTINGS_CONNECTION;
+		method = "Update";
+		parameters = g_variant_new ("(@a{sa{sv}})", load.connection_settings);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+
+	client->in_flight++;
+	load.in_flight++;
+	call->start = g_get_monotonic_time ();
+	g_dbus_connection_call (client->bus, NM_DBUS_SERVICE, path, interface, method,
+	                        parameters, NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+	                        NULL, call_done, call);
+}
+
+static void
+signal_cb (GDBusConnection *connection,
+           const char *sender_name,
+           const char *object_path,
+           const char *interface_name,
+           const char *signal_name,
+           GVariant *parameters,
+           gpointer user_data)
+{
+	if (!load.stopping)
+		load.signals++;
+}
+
+static gboolean
+stop_cb (gpointer user_data)
+{
+	load.stopping = TRUE;
+	load.end = g_get_monotonic_time ();
+	if (!load.in_flight)
+		g_main_loop_quit (load.loop);
+	return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************/
+
+static int
+cmp_gint64 (gconstpointer a, gconstpointer b)
+{
+	gint64 x = *((const gint64 *) a);
+	gint64 y = *((const gint64 *) b);
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static gint64
+percentile (GArray *sorted, guint p)
+{
+	guint idx;
+
+	if (!sorted->len)
+		return 0;
+	idx = ((guint64) sorted->len * p + 99) / 100;
+	return g_array_index (sorted, gint64, CLAMP (idx, 1, sorted->len) - 1);
+}
+
+static void
+print_results (void)
+{
+	gint64 usec = load.end - load.start;
+	Method m;
+
+	g_print ("# clients=%d outstanding=%d duration=%d subscribe=%d signals=%"G_GUINT64_FORMAT"\n",
+	         global_opt.clients, global_opt.outstanding, global_opt.duration,
+	         global_opt.subscribe ? 1 : 0, load.signals);
+	g_print ("# method\tcalls\tusec\tnsec/call\n");
+	for (m = 0; m < _METHOD_NUM; m++) {
+		guint n = load.latencies[m]->len;
+
+		if (!load.weights[m])
+			continue;
+		g_print ("%s\t%u\t%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\n",
+		         method_names[m], n, usec, n ? usec * 1000 / n : 0);
+	}
+
+	g_print ("# method\tcalls/s\tp50_usec\tp99_usec\tmax_usec\terrors\n");
+	for (m = 0; m < _METHOD_NUM; m++) {
+		GArray *l = load.latencies[m];
+
+		if (!load.weights[m])
+			continue;
+		g_array_sort (l, cmp_gint64);
+		g_print ("# %s\t%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\t%u\n",
+		         method_names[m],
+		         usec ? (gint64) l->len * G_USEC_PER_SEC / usec : 0,
+		         percentile (l, 50),
+		         percentile (l, 99),
+		         l->len ? g_array_index (l, gint64, l->len - 1) : 0,
+		         load.errors[m]);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	gs_free char *address = NULL;
+	gs_free_error GError *error = NULL;
+	Method m;
+	int i, j;
+
+	nm_g_type_init ();
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.address)
+		address = g_strdup (global_opt.address);
+	else {
+		address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+		if (!address) {
+			g_printerr ("Cannot get the address of the system bus: %s\n", error->message);
+			return 1;
+		}
+	}
+
+	load.clients = g_new0 (Client, global_opt.clients);
+	for (i = 0; i < global_opt.clients; i++) {
+		Client *client = &load.clients[i];
+
+		client->bus = g_dbus_connection_new_for_address_sync (address,
+		                                                      G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+		                                                      | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+		                                                      NULL, NULL, &error);
+		if (!client->bus) {
+			g_printerr ("Cannot connect client %d to %s: %s\n", i, address, error->message);
+			return 1;
+		}
+		if (global_opt.subscribe) {
+			client->signal_id = g_dbus_connection_signal_subscribe (client->bus,
+			                                                        NM_DBUS_SERVICE,
+			                                                        NULL,
+			                                                        "PropertiesChanged",
+			                                                        NULL,
+			                                                        NULL,
+			                                                        G_DBUS_SIGNAL_FLAGS_NONE,
+			                                                        signal_cb,
+			                                                        NULL,
+			                                                        NULL);
+		}
+	}
+
+	if (!discover (load.clients[0].bus))
+		return 1;
+
+	for (m = 0; m < _METHOD_NUM; m++)
+		load.latencies[m] = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+	load.loop = g_main_loop_new (NULL, FALSE);
+	load.start = g_get_monotonic_time ();
+	g_timeout_add_seconds (global_opt.duration, stop_cb, NULL);
+	for (i = 0; i < global_opt.clients; i++) {
+		for (j = 0; j < global_opt.outstanding; j++)
+			issue_call (&load.clients[i]);
+	}
+	g_main_loop_run (load.loop);
+
+	print_results ();
+
+	for (i = 0; i < global_opt.clients; i++) {
+		if (load.clients[i].signal_id)
+			g_dbus_connection_signal_unsubscribe (load.clients[i].bus, load.clients[i].signal_id);
+		g_object_unref (load.clients[i].bus);
+	}
+	g_free (load.clients);
+	for (m = 0; m < _METHOD_NUM; m++)
+		g_array_unref (load.latencies[m]);
+	g_ptr_array_unref (load.objects);
+	g_ptr_array_unref (load.connections);
+	g_free (load.connection_path);
+	if (load.connection_settings)
+		g_variant_unref (load.connection_settings);
+	g_main_loop_unref (load.loop);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#!/bin/bash
+
+# Runs the benchmark programs of the build tree and prints their results
+# as one JSON document to stdout:
+#
+#   {
+#     "version": "...",
+#     "seed": 0,
+#     "benchmarks": [
+#       {
+#         "name": "platform-routes-1k",
+#         "program": "src/platform/tests/bench-platform",
+#         "args": "--links 1 --routes 1000",
+#         "parameters": { "links": 1, ... },
+#         "phases": [
+#           { "phase": "route-add", "ops": 1000, "usec": 1234, "nsec_per_op": 1234000 },
+#           ...
+#         ]
+#       },
+#       ...
+#     ]
+#   }
+#
+# Usage: run-benchmarks.sh [--version VERSION] BUILDDIR [NAME...]
+#
+# When NAMEs are given, only these benchmarks are run. Programs that are
+# not built (configure with --enable-tests) are skipped. The random seed
+# is fixed (override with NMTST_SEED_RAND) so that runs are comparable.
+
+die() {
+    echo "$@" >&2
+    exit 5
+}
+
+VERSION=
+if [ "$1" == "--version" ]; then
+    VERSION="$2"
+    shift 2
+fi
+
+BUILDDIR="$1"
+shift
+[ -d "$BUILDDIR" ] || die "usage: $0 [--version VERSION] BUILDDIR [NAME...]"
+
+export NMTST_SEED_RAND="${NMTST_SEED_RAND:-0}"
+export LC_ALL=C
+
+# name, program relative to BUILDDIR, arguments
+BENCHMARKS=(
+    "platform"              "src/platform/tests/bench-platform"                  ""
+    "platform-routes-1k"    "src/platform/tests/bench-platform"                  "--links 1 --addresses 0 --handlers 0 --routes 1000"
+    "platform-routes-10k"   "src/platform/tests/bench-platform"                  "--links 1 --addresses 0 --handlers 0 --routes 10000"
+    "platform-routes-100k"  "src/platform/tests/bench-platform"                  "--links 1 --addresses 0 --handlers 0 --routes 100000"
+    "multi-index"           "src/tests/bench-multi-index"                        ""
+    "general"               "src/tests/bench-general"                            ""
+    "setting"               "libnm-core/tests/bench-setting"                     ""
+    "keyfile-10k"           "src/settings/plugins/keyfile/tests/bench-keyfile"   "--files 10000"
+    "ifcfg-rh"              "src/settings/plugins/ifcfg-rh/tests/bench-ifcfg-rh" ""
+    "dispatcher-envp"       "callouts/tests/bench-dispatcher-envp"               ""
+)
+
+selected() {
+    local n
+    [ $# -eq 1 ] && return 0
+    for n in "${@:2}"; do
+        [ "$n" == "$1" ] && return 0
+    done
+    return 1
+}
+
+# converts the output of a benchmark program to the "parameters"
+# and "phases" members of its JSON object.
+to_json() {
+    awk -F '\t' '
+        function num(s) {
+            return s ~ /^-?[0-9]+$/ ? s : "\"" s "\""
+        }
+        /^# [a-z_-]+=/ && !have_params {
+            n = split(substr($0, 3), kv, " ")
+            printf "      \"parameters\": {"
+            for (i = 1; i <= n; i++) {
+                split(kv[i], p, "=")
+                printf "%s \"%s\": %s", (i > 1 ? "," : ""), p[1], num(p[2])
+            }
+            printf " },\n"
+            have_params = 1
+            next
+        }
+        NF == 4 && $1 ~ /^[a-z0-9_-]+$/ && $2 ~ /^[0-9]+$/ && $3 ~ /^[0-9]+$/ && $4 ~ /^[0-9]+$/ {
+            phases[n_phases++] = sprintf("        { \"phase\": \"%s\", \"ops\": %s, \"usec\": %s, \"nsec_per_op\": %s }", $1, $2, $3, $4)
+        }
+        END {
+            if (!have_params)
+                printf "      \"parameters\": { },\n"
+            printf "      \"phases\": [\n"
+            for (i = 0; i < n_phases; i++)
+                printf "%s%s\n", phases[i], (i + 1 < n_phases ? "," : "")
+            printf "      ]\n"
+        }'
+}
+
+printf '{\n'
+printf '  "version": "%s",\n' "$VERSION"
+printf '  "seed": %s,\n' "$NMTST_SEED_RAND"
+printf '  "benchmarks": ['
+
+FIRST=1
+for ((i = 0; i < ${#BENCHMARKS[@]}; i += 3)); do
+    NAME="${BENCHMARKS[$i]}"
+    PROGRAM="${BENCHMARKS[$((i + 1))]}"
+    ARGS="${BENCHMARKS[$((i + 2))]}"
+
+    selected "$NAME" "$@" || continue
+
+    if [ ! -x "$BUILDDIR/$PROGRAM" ]; then
+        # e.g. the ifcfg-rh plugin is not enabled
+        echo "skip benchmark $NAME: $PROGRAM not built" >&2
+        continue
+    fi
+
+    echo "running benchmark $NAME..." >&2
+    OUTPUT="$("$BUILDDIR/$PROGRAM" $ARGS)" || die "benchmark $NAME: $PROGRAM $ARGS failed"
+
+    [ $FIRST -eq 1 ] || printf ','
+    FIRST=0
+    printf '\n    {\n'
+    printf '      "name": "%s",\n' "$NAME"
+    printf '      "program": "%s",\n' "$PROGRAM"
+    printf '      "args": "%s",\n' "$ARGS"
+    printf '%s\n' "$OUTPUT" | to_json
+    printf '    }'
+done
+
+printf '\n  ]\n'
+printf '}\n'
@@ -0,0 +1,308 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+# Runs the NetworkManager daemon of the build tree against a fake platform
+# ("NetworkManager --fake-platform=N") and measures how long it takes to
+# activate a profile on each of the N simulated ethernet links, how long
+# the same takes after a restart, and the memory the daemon uses.
+#
+# Everything runs in a private mount namespace with a private D-Bus
+# daemon, so the NetworkManager of the host is not disturbed. A stub of
+# the dispatcher service answers the dispatcher calls, optionally with a
+# delay or an error. The profiles use static IPv4 addresses and ignore
+# IPv6, so no DHCP client is needed.
+#
+# Must be run as root. The output uses the format of the benchmark
+# programs (see run-benchmarks.sh):
+#
+#   activate            1000  1234567  1234567
+#   restart-activate    1000  1234567  1234567
+#   # links=1000 profiles=1000 dispatcher_delay_ms=0 rss_kb=... hwm_kb=...
+#
+# Usage: run-simulation.py [--nm PATH] [--links N] [--profiles N]
+#            [--dispatcher-delay MS] [--dispatcher-fail] [--timeout SEC]
+#            [--keep-log FILE]
+
+from __future__ import print_function
+
+from gi.repository import GLib
+import argparse
+import os
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+import uuid
+import dbus
+import dbus.service
+import dbus.mainloop.glib
+
+NM_RUNDIR = '/var/run/NetworkManager'
+
+NM_DEVICE_STATE_ACTIVATED = 100
+
+IFACE_DEVICE = 'org.freedesktop.NetworkManager.Device'
+
+DBUS_CONFIG = '''<!DOCTYPE busconfig PUBLIC "-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN"
+ "http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd">
+<busconfig>
+  <type>system</type>
+  <listen>unix:dir=%s</listen>
+  <auth>EXTERNAL</auth>
+  <policy context="default">
+    <allow user="*"/>
+    <allow own="*"/>
+    <allow send_destination="*" eavesdrop="true"/>
+    <allow receive_sender="*"/>
+  </policy>
+</busconfig>
+'''
+
+NM_CONFIG = '''[main]
+plugins=keyfile
+no-auto-default=*
+auth-polkit=false
+dns=none
+rc-manager=unmanaged
+
+[keyfile]
+path=%s
+
+[logging]
+level=WARN
+
+[connectivity]
+interval=0
+'''
+
+PROFILE = '''[connection]
+id=sim%(i)d
+uuid=%(uuid)s
+type=ethernet
+interface-name=sim%(i)d
+
+[ipv4]
+method=manual
+address1=10.%(a)d.%(b)d.1/24
+
+[ipv6]
+method=ignore
+'''
+
+def die(msg):
+    print(msg, file=sys.stderr)
+    sys.exit(5)
+
+###############################################################################
+
+class Dispatcher(dbus.service.Object):
+    def __init__(self, bus, delay_ms, fail):
+        dbus.service.Object.__init__(self, bus, '/org/freedesktop/nm_dispatcher')
+        self.delay_ms = delay_ms
+        self.fail = fail
+        self.calls = 0
+
+    @dbus.service.method(dbus_interface='org.freedesktop.nm_dispatcher',
+                         in_signature='sa{sa{sv}}a{sv}a{sv}a{sv}a{sv}a{sv}a{sv}sa{sv}a{sv}b',
+                         out_signature='a(sus)',
+                         async_callbacks=('reply_cb', 'error_cb'))
+    def Action(self, action, connection, connection_props, device_props,
+               ip4, ip6, dhcp4, dhcp6, vpn_ip_iface, vpn_ip4, vpn_ip6, debug,
+               reply_cb, error_cb):
+        self.calls += 1
+
+        def reply():
+            if self.fail:
+                error_cb(dbus.exceptions.DBusException('simulated failure',
+                                                       name='org.freedesktop.nm_dispatcher.Failed'))
+            else:
+                reply_cb(dbus.Array([], signature='(sus)'))
+            return False
+
+        if self.delay_ms:
+            GLib.timeout_add(self.delay_ms, reply)
+        else:
+            reply()
+
+###############################################################################
+
+class Simulation(object):
+    def __init__(self, args):
+        self.args = args
+        self.tmpdir = tempfile.mkdtemp(prefix='nm-simulation-')
+        self.dbus_daemon = None
+        self.nm = None
+        self.bus = None
+        self.log = open(os.path.join(self.tmpdir, 'NetworkManager.log'), 'w')
+
+    def setup(self):
+        subprocess.check_call(['mount', '-t', 'tmpfs', '-o', 'mode=0755', 'tmpfs', NM_RUNDIR])
+
+        conf = os.path.join(self.tmpdir, 'dbus.conf')
+        with open(conf, 'w') as f:
+            f.write(DBUS_CONFIG % self.tmpdir)
+        self.dbus_daemon = subprocess.Popen(['dbus-daemon', '--nofork', '--print-address',
+                                             '--config-file=' + conf],
+                                            stdout=subprocess.PIPE)
+        address = self.dbus_daemon.stdout.readline().strip().decode('utf-8')
+        if not address:
+            die('failed to start dbus-daemon')
+        os.environ['DBUS_SYSTEM_BUS_ADDRESS'] = address
+
+        dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+        self.bus = dbus.bus.BusConnection(address)
+        self.dispatcher = Dispatcher(self.bus, self.args.dispatcher_delay, self.args.dispatcher_fail)
+        self.dispatcher_name = dbus.service.BusName('org.freedesktop.nm_dispatcher', self.bus)
+
+        keyfile_dir = os.path.join(self.tmpdir, 'system-connections')
+        os.mkdir(keyfile_dir)
+        for i in range(self.args.profiles):
+            path = os.path.join(keyfile_dir, 'sim%d' % i)
+            with open(path, 'w') as f:
+                f.write(PROFILE % { 'i': i,
+                                    'uuid': uuid.uuid4(),
+                                    'a': i // 256,
+                                    'b': i % 256 })
+            os.chmod(path, 0o600)
+
+        # keep the configuration snippets of the host out
+        self.conf_dir = os.path.join(self.tmpdir, 'conf.d')
+        os.mkdir(self.conf_dir)
+
+        self.nm_conf = os.path.join(self.tmpdir, 'NetworkManager.conf')
+        with open(self.nm_conf, 'w') as f:
+            f.write(NM_CONFIG % keyfile_dir)
+
+    def start_nm(self):
+        self.nm = subprocess.Popen([self.args.nm,
+                                    '--debug',
+                                    '--fake-platform=%d' % self.args.links,
+                                    '--config=' + self.nm_conf,
+                                    '--config-dir=' + self.conf_dir,
+                                    '--state-file=' + os.path.join(self.tmpdir, 'NetworkManager.state')],
+                                   stdout=self.log, stderr=subprocess.STDOUT)
+
+    def stop_nm(self):
+        self.nm.send_signal(signal.SIGTERM)
+        self.nm.wait()
+        self.nm = None
+
+    def count_activated(self):
+        try:
+            manager = self.bus.get_object('org.freedesktop.NetworkManager',
+                                          '/org/freedesktop/NetworkManager')
+            objects = manager.GetStateSnapshot(dbus.UInt32(0),
+                                               dbus_interface='org.freedesktop.NetworkManager')
+        except dbus.exceptions.DBusException:
+            # not yet on the bus
+            return 0
+
+        n = 0
+        for path, ifaces in objects.items():
+            device = ifaces.get(IFACE_DEVICE)
+            if (    device
+                and device.get('State') == NM_DEVICE_STATE_ACTIVATED
+                and device.get('Interface', '').startswith('sim')):
+                n += 1
+        return n
+
+    def wait_activated(self, begin):
+        expected = min(self.args.links, self.args.profiles)
+        context = GLib.MainContext.default()
+
+        while True:
+            if self.nm.poll() is not None:
+                die('NetworkManager exited with %d, see %s' % (self.nm.returncode, self.log.name))
+            if self.count_activated() >= expected:
+                return int((time.time() - begin) * 1000000), expected
+            if time.time() - begin > self.args.timeout:
+                die('timeout waiting for %d activated devices' % expected)
+
+            # serve the dispatcher stub while waiting
+            end = time.time() + 0.1
+            while time.time() < end:
+                if not context.iteration(False):
+                    time.sleep(0.005)
+
+    def memory(self):
+        values = { }
+        with open('/proc/%d/status' % self.nm.pid) as f:
+            for line in f:
+                key, value = line.split(':', 1)
+                if key in ('VmRSS', 'VmHWM'):
+                    values[key] = int(value.split()[0])
+        return values.get('VmRSS', 0), values.get('VmHWM', 0)
+
+    def run(self):
+        self.setup()
+
+        results = []
+        for phase in ('activate', 'restart-activate'):
+            if self.nm:
+                self.stop_nm()
+            begin = time.time()
+            self.start_nm()
+            usec, ops = self.wait_activated(begin)
+            results.append((phase, ops, usec))
+            if phase == 'activate':
+                rss, hwm = self.memory()
+
+        for phase, ops, usec in results:
+            print('%s\t%d\t%d\t%d' % (phase, ops, usec, usec * 1000 // max(ops, 1)))
+        print('# links=%d profiles=%d dispatcher_delay_ms=%d dispatcher_calls=%d rss_kb=%d hwm_kb=%d' %
+              (self.args.links, self.args.profiles, self.args.dispatcher_delay,
+               self.dispatcher.calls, rss, hwm))
+
+    def cleanup(self):
+        if self.nm:
+            self.stop_nm()
+        if self.dbus_daemon:
+            self.dbus_daemon.terminate()
+            self.dbus_daemon.wait()
+        self.log.close()
+        if self.args.keep_log:
+            shutil.copy(self.log.name, self.args.keep_log)
+        shutil.rmtree(self.tmpdir)
+        subprocess.call(['umount', NM_RUNDIR])
+
+###############################################################################
+
+def main():
+    parser = argparse.ArgumentParser(description='Run NetworkManager against a fake platform')
+    parser.add_argument('--nm', default='src/NetworkManager', help='the daemon to run')
+    parser.add_argument('--links', type=int, default=1000, help='number of simulated ethernet links')
+    parser.add_argument('--profiles', type=int, default=None, help='number of profiles (default: one per link)')
+    parser.add_argument('--dispatcher-delay', type=int, default=0, help='delay of the dispatcher stub replies in msec')
+    parser.add_argument('--dispatcher-fail', action='store_true', help='let the dispatcher stub fail all calls')
+    parser.add_argument('--timeout', type=int, default=600, help='seconds to wait for the activations')
+    parser.add_argument('--keep-log', default=None, help='copy the log of the daemon to this file')
+    args = parser.parse_args()
+
+    if args.profiles is None:
+        args.profiles = args.links
+    if args.links <= 0 or args.links > 65536:
+        die('--links must be between 1 and 65536')
+
+    if os.geteuid() != 0:
+        die('must be run as root')
+
+    # re-run in a private mount namespace, so that the tmpfs over the
+    # run directory is not visible outside.
+    if not os.environ.get('NM_SIMULATION_UNSHARED'):
+        os.environ['NM_SIMULATION_UNSHARED'] = '1'
+        os.execvp('unshare', ['unshare', '--mount', '--propagation', 'private',
+                              sys.executable] + sys.argv)
+
+    if not os.access(args.nm, os.X_OK):
+        die('%s is not executable' % args.nm)
+
+    sim = Simulation(args)
+    try:
+        sim.run()
+    finally:
+        sim.cleanup()
+
+if __name__ == '__main__':
+    main()
@@ -88,15 +88,26 @@ class ExportedObj(dbus.service.Object):
 
     DBusInterface = collections.namedtuple('DBusInterface', ['dbus_iface', 'get_props_func', 'prop_changed_func'])
 
+    # all exported objects by path, for GetManagedObjects()
+    objects = {}
+
     def __init__(self, bus, object_path):
         dbus.service.Object.__init__(self, bus, object_path)
         self._bus = bus
         self.path = object_path
         self.__dbus_ifaces = {}
+        ExportedObj.objects[object_path] = self
+
+    def remove_from_connection(self, *args, **kwargs):
+        ExportedObj.objects.pop(self.path, None)
+        dbus.service.Object.remove_from_connection(self, *args, **kwargs)
 
     def add_dbus_interface(self, dbus_iface, get_props_func, prop_changed_func):
         self.__dbus_ifaces[dbus_iface] = ExportedObj.DBusInterface(dbus_iface, get_props_func, prop_changed_func)
 
+    def get_managed_ifaces(self):
+        return dict((i.dbus_iface, i.get_props_func()) for i in self.__dbus_ifaces.values())
+
     def __dbus_interface_get(self, dbus_iface):
         if dbus_iface not in self.__dbus_ifaces:
             raise UnknownInterfaceException()
@@ -1203,6 +1214,22 @@ class AgentManager(dbus.service.Object):
                 continue
         return secrets
 
+###################################################################
+IFACE_OBJECT_MANAGER = 'org.freedesktop.DBus.ObjectManager'
+
+class ObjectManager(dbus.service.Object):
+    def __init__(self, bus, object_path):
+        dbus.service.Object.__init__(self, bus, object_path)
+
+    @dbus.service.method(dbus_interface=IFACE_OBJECT_MANAGER, in_signature='', out_signature='a{oa{sa{sv}}}')
+    def GetManagedObjects(self):
+        objects = {}
+        for path, obj in ExportedObj.objects.items():
+            ifaces = obj.get_managed_ifaces()
+            if ifaces:
+                objects[dbus.ObjectPath(path)] = ifaces
+        return objects
+
 ###################################################################
 
 def stdin_cb(io, condition):
@@ -1218,7 +1245,8 @@ def main():
 
     bus = dbus.SessionBus()
 
-    global manager, settings, agent_manager
+    global manager, settings, agent_manager, object_manager
+    object_manager = ObjectManager(bus, "/org/freedesktop")
     manager = NetworkManager(bus, "/org/freedesktop/NetworkManager")
     settings = Settings(bus, "/org/freedesktop/NetworkManager/Settings")
     agent_manager = AgentManager(bus, "/org/freedesktop/NetworkManager/AgentManager")